@@ -0,0 +1,338 @@
+/*********************************************************
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*********************************************************/
+
+
+#ifndef __ctpl_coro_H__
+#define __ctpl_coro_H__
+
+#include "ctpl_ws.h"
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "ctpl_coro.h requires c++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <optional>
+
+
+// c++20 coroutine tasks executed on a ctpl::ws_thread_pool
+//
+//      ctpl::task<int> fib(ctpl::ws_thread_pool & pool, int n) {
+//          if (n < 2)
+//              co_return n;
+//          ctpl::spawned<int> a = ctpl::spawn(pool, fib(pool, n - 1));
+//          int b = co_await fib(pool, n - 2);
+//          co_return co_await a + b;
+//      }
+//      int r = ctpl::sync_wait(pool, fib(pool, 30));
+//
+// a task<T> is lazy, it starts when it is awaited and then runs on the awaiting thread.
+// spawn() starts it on the pool instead and returns a handle that can be awaited later.
+// awaiting a spawned task that is not finished yet suspends the awaiting coroutine rather than
+// blocking its worker, the worker goes on with other functors and the awaiting coroutine is resumed
+// by the worker that finishes the spawned task. nested parallelism therefore never leaves a worker
+// blocked on a future, unlike push(...).get() from inside the pool.
+//
+// coroutine frames are taken from the slab allocator of ctpl_ws.h.
+
+
+namespace ctpl {
+
+    template <typename T = void> class task;
+    template <typename T = void> class spawned;
+
+    // awaitable that continues the awaiting coroutine on a worker of the pool,
+    // called from a worker it requeues the coroutine, e.g. to let other functors run
+    class schedule_awaiter {
+
+    public:
+
+        explicit schedule_awaiter(ws_thread_pool & pool) : pool(pool) { }
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) {
+            this->pool.post([h](int) { h.resume(); });
+        }
+        void await_resume() const noexcept { }
+
+    private:
+
+        ws_thread_pool & pool;
+    };
+
+    inline schedule_awaiter schedule(ws_thread_pool & pool) { return schedule_awaiter(pool); }
+
+    namespace detail {
+
+        // coroutine frames from the slabs, no calls to operator new in steady state
+        struct slab_frame {
+            static void * operator new(size_t bytes) { return slab_allocate(bytes); }
+            static void operator delete(void * p, size_t bytes) { slab_deallocate(p, bytes); }
+        };
+
+        // continues with the awaiting coroutine when a task is finished, without growing the stack
+        struct task_final_awaiter {
+            bool await_ready() const noexcept { return false; }
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+                std::coroutine_handle<> c = h.promise().continuation;
+                return c ? c : std::noop_coroutine();
+            }
+            void await_resume() const noexcept { }
+        };
+
+        struct task_promise_base : slab_frame {
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            task_final_awaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() { this->error = std::current_exception(); }
+
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+        };
+
+        template <typename T>
+        struct task_promise : task_promise_base {
+            ctpl::task<T> get_return_object();
+            template <typename U>
+            void return_value(U && v) { this->value.emplace(std::forward<U>(v)); }
+            T result() {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+                return std::move(*this->value);
+            }
+
+            std::optional<T> value;
+        };
+
+        template <>
+        struct task_promise<void> : task_promise_base {
+            ctpl::task<void> get_return_object();
+            void return_void() const noexcept { }
+            void result() {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+            }
+        };
+
+    }
+
+    // lazy coroutine returning T, started by co_await, spawn() or sync_wait()
+    template <typename T>
+    class task {
+
+    public:
+
+        typedef detail::task_promise<T> promise_type;
+
+        task() : h(nullptr) { }
+        explicit task(std::coroutine_handle<promise_type> h) : h(h) { }
+        task(task && other) noexcept : h(other.h) { other.h = nullptr; }
+        task & operator=(task && other) noexcept {
+            if (this != &other) {
+                if (this->h)
+                    this->h.destroy();
+                this->h = other.h;
+                other.h = nullptr;
+            }
+            return *this;
+        }
+        task(const task &) = delete;
+        task & operator=(const task &) = delete;
+        ~task() {
+            if (this->h)
+                this->h.destroy();
+        }
+
+        bool valid() const { return this->h != nullptr; }
+
+        // run the task on the awaiting thread, the awaiting coroutine continues when it is finished
+        auto operator co_await() && noexcept {
+            struct awaiter {
+                std::coroutine_handle<promise_type> h;
+                bool await_ready() const noexcept { return !this->h || this->h.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> c) noexcept {
+                    this->h.promise().continuation = c;
+                    return this->h;
+                }
+                T await_resume() { return this->h.promise().result(); }
+            };
+            return awaiter{ this->h };
+        }
+
+    private:
+
+        std::coroutine_handle<promise_type> h;
+    };
+
+    namespace detail {
+
+        template <typename T>
+        ctpl::task<T> task_promise<T>::get_return_object() {
+            return ctpl::task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+        }
+
+        inline ctpl::task<void> task_promise<void>::get_return_object() {
+            return ctpl::task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+        }
+
+        // the result of a spawned task and the coroutine waiting for it
+        // waiter is nullptr while nobody waits, the awaiting coroutine, or finished() once the task is done
+        template <typename T>
+        struct spawn_state {
+            static void * finished() { return reinterpret_cast<void *>(static_cast<uintptr_t>(1)); }
+
+            std::atomic<void *> waiter{ nullptr };
+            std::optional<T> value;
+            std::exception_ptr error;
+            latch done{ 1 };
+        };
+
+        template <>
+        struct spawn_state<void> {
+            static void * finished() { return reinterpret_cast<void *>(static_cast<uintptr_t>(1)); }
+
+            std::atomic<void *> waiter{ nullptr };
+            std::exception_ptr error;
+            latch done{ 1 };
+        };
+
+        // fire and forget coroutine running a spawned task, its frame destroys itself
+        struct spawn_driver {
+            struct promise_type : slab_frame {
+                spawn_driver get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                // the frame is destroyed before the waiting coroutine is resumed on this thread
+                struct final_awaiter {
+                    bool await_ready() const noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                        std::coroutine_handle<> c = h.promise().continuation;
+                        h.destroy();
+                        return c ? c : std::noop_coroutine();
+                    }
+                    void await_resume() const noexcept { }
+                };
+                final_awaiter final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept { }
+                void unhandled_exception() const noexcept { std::terminate(); }
+
+                std::coroutine_handle<> continuation;
+            };
+        };
+
+        // the awaiting coroutine to resume after the task, nullptr if nobody waits yet
+        template <typename T>
+        std::coroutine_handle<> finish_spawn(spawn_state<T> & s) {
+            void * w = s.waiter.exchange(spawn_state<T>::finished(), std::memory_order_acq_rel);
+            s.done.count_down();
+            return w ? std::coroutine_handle<>::from_address(w) : std::coroutine_handle<>();
+        }
+
+        // let the frame of the driver continue with c once it is finished
+        struct continue_with {
+            std::coroutine_handle<> c;
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<spawn_driver::promise_type> h) const noexcept {
+                h.promise().continuation = this->c;
+                return false;
+            }
+            void await_resume() const noexcept { }
+        };
+
+        template <typename T>
+        spawn_driver run_spawned(ws_thread_pool & pool, ctpl::task<T> t, std::shared_ptr<spawn_state<T>> s) {
+            co_await schedule(pool);
+            try {
+                if constexpr (std::is_void<T>::value)
+                    co_await std::move(t);
+                else
+                    s->value.emplace(co_await std::move(t));
+            } catch (...) {
+                s->error = std::current_exception();
+            }
+            t = ctpl::task<T>();  // free the frame of the task before the waiter continues
+            co_await continue_with{ finish_spawn(*s) };
+        }
+
+    }
+
+    // handle of a task running on the pool, awaiting it gives the result of the task or rethrows its exception
+    // it may be awaited once, by a coroutine or with wait() / get() from a thread
+    template <typename T>
+    class spawned {
+
+    public:
+
+        spawned() { }
+        explicit spawned(std::shared_ptr<detail::spawn_state<T>> s) : state(std::move(s)) { }
+
+        bool valid() const { return this->state != nullptr; }
+        bool is_ready() const { return this->state->done.try_wait(); }
+
+        // block until the task is finished, a worker of the pool runs other functors meanwhile
+        void wait(ws_thread_pool & pool) { pool.wait(this->state->done); }
+
+        T get(ws_thread_pool & pool) {
+            this->wait(pool);
+            return this->result();
+        }
+
+        auto operator co_await() noexcept {
+            struct awaiter {
+                spawned & self;
+                bool await_ready() const noexcept { return self.is_ready(); }
+                bool await_suspend(std::coroutine_handle<> c) noexcept {
+                    void * expected = nullptr;
+                    // fails if the task finished in the meantime, then continue right away
+                    return self.state->waiter.compare_exchange_strong(expected, c.address(), std::memory_order_acq_rel);
+                }
+                T await_resume() { return self.result(); }
+            };
+            return awaiter{ *this };
+        }
+
+    private:
+
+        T result() {
+            std::shared_ptr<detail::spawn_state<T>> s = std::move(this->state);
+            if (s->error)
+                std::rethrow_exception(s->error);
+            if constexpr (std::is_void<T>::value)
+                return;
+            else
+                return std::move(*s->value);
+        }
+
+        std::shared_ptr<detail::spawn_state<T>> state;
+    };
+
+    // start the task on a worker of the pool
+    template <typename T>
+    spawned<T> spawn(ws_thread_pool & pool, task<T> t) {
+        std::shared_ptr<detail::spawn_state<T>> s = std::allocate_shared<detail::spawn_state<T>>(detail::slab_allocator<detail::spawn_state<T>>());
+        detail::run_spawned(pool, std::move(t), s);
+        return spawned<T>(std::move(s));
+    }
+
+    // run the task on the pool and block until it is finished, the entry point from ordinary code
+    // called from a worker of the pool, the worker runs other functors while waiting
+    template <typename T>
+    T sync_wait(ws_thread_pool & pool, task<T> t) {
+        return spawn(pool, std::move(t)).get(pool);
+    }
+
+}
+
+#endif // __ctpl_coro_H__
@@ -0,0 +1,468 @@
+/*********************************************************
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*********************************************************/
+
+
+#ifndef __ctpl_pool_future_H__
+#define __ctpl_pool_future_H__
+
+#include "ctpl_ws.h"
+
+
+// futures of a ctpl::ws_thread_pool that take continuations instead of being waited for
+//
+//      ctpl::pool_future<double> a = ctpl::async(pool, [](int id) { return 1.0; });
+//      ctpl::pool_future<double> b = a.then([](int id, double x) { return 2 * x; });
+//      std::vector<ctpl::pool_future<double>> parts = ...;
+//      ctpl::pool_future<void> step = ctpl::when_all(pool, parts).then([](int id, std::vector<double> x) { ... });
+//
+// a continuation is queued on the pool by the thread that finishes its input, so no worker blocks
+// on a future for a fan-out / fan-in. the state of a future is an atomic word that holds either
+// the continuation or the mark of a finished future, attaching a continuation and finishing are
+// a single compare-and-swap or exchange each, there is no mutex or condition variable unless
+// a thread calls wait() or get().
+//
+// a pool_future is move-only and may be consumed once, by get(), then(), when_all() or when_any().
+// if the input of then() failed, the continuation is not called and the exception is passed on.
+
+
+namespace ctpl {
+
+    template <typename T> class pool_future;
+
+    namespace detail {
+
+        // the part of the shared state of a pool_future that does not depend on the value
+        class future_state_base {
+
+        public:
+
+            explicit future_state_base(ws_thread_pool & pool) : pool(&pool), continuation(nullptr) { }
+            ~future_state_base() {
+                task * c = this->continuation.load(std::memory_order_relaxed);
+                if (c && c != finished())
+                    delete_task(c);
+            }
+
+            bool is_ready() const { return this->continuation.load(std::memory_order_acquire) == finished(); }
+
+            // c(id) is called by the thread that finishes the state, or right away if it is finished already
+            void on_finish(task * c) {
+                task * expected = nullptr;
+                if (!this->continuation.compare_exchange_strong(expected, c, std::memory_order_acq_rel, std::memory_order_acquire))
+                    run(c, this->pool->current_id());
+            }
+
+            // called once after the value or the exception is set
+            void finish(int id) {
+                task * c = this->continuation.exchange(finished(), std::memory_order_acq_rel);
+                if (c)
+                    run(c, id);
+            }
+
+            ws_thread_pool * pool;
+            std::exception_ptr error;
+
+        private:
+
+            static task * finished() { return reinterpret_cast<task *>(static_cast<uintptr_t>(1)); }
+
+            static void run(task * c, int id) {
+                TaskGuard guard(c);
+                (*c)(id);
+            }
+
+            std::atomic<task *> continuation;
+        };
+
+        template <typename T>
+        class future_state : public future_state_base {
+
+        public:
+
+            explicit future_state(ws_thread_pool & pool) : future_state_base(pool), hasValue(false) { }
+            ~future_state() {
+                if (this->hasValue)
+                    reinterpret_cast<T *>(this->buffer)->~T();
+            }
+
+            template <typename U>
+            void set_value(U && v) {
+                new (this->buffer) T(std::forward<U>(v));
+                this->hasValue = true;
+            }
+
+            // the value or the exception, once
+            T take() {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+                return std::move(*reinterpret_cast<T *>(this->buffer));
+            }
+
+        private:
+
+            alignas(T) unsigned char buffer[sizeof(T)];
+            bool hasValue;
+        };
+
+        template <>
+        class future_state<void> : public future_state_base {
+
+        public:
+
+            explicit future_state(ws_thread_pool & pool) : future_state_base(pool) { }
+
+            void set_value() { }
+
+            void take() {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+            }
+        };
+
+        template <typename T>
+        std::shared_ptr<future_state<T>> new_future_state(ws_thread_pool & pool) {
+            return std::allocate_shared<future_state<T>>(slab_allocator<future_state<T>>(), pool);
+        }
+
+        // out = g(), or the exception of g
+        template <typename R>
+        struct state_setter {
+            template <typename G>
+            static void set(future_state<R> & out, G & g) { out.set_value(g()); }
+        };
+
+        template <>
+        struct state_setter<void> {
+            template <typename G>
+            static void set(future_state<void> &, G & g) { g(); }
+        };
+
+        template <typename R, typename G>
+        void set_state(future_state<R> & out, G & g) {
+            try {
+                state_setter<R>::set(out, g);
+            }
+            catch (...) {
+                out.error = std::current_exception();
+            }
+        }
+
+        // f(id, value) of then(), f(id) for a pool_future<void>
+        template <typename T>
+        struct then_invoker {
+            template <typename F>
+            static auto call(F & f, int id, future_state<T> & in) ->decltype(f(id, std::declval<T>())) { return f(id, in.take()); }
+        };
+
+        template <>
+        struct then_invoker<void> {
+            template <typename F>
+            static auto call(F & f, int id, future_state<void> & in) ->decltype(f(id)) {
+                in.take();
+                return f(id);
+            }
+        };
+
+        template <typename T, typename F>
+        struct then_result {
+            typedef decltype(then_invoker<T>::call(std::declval<F &>(), 0, std::declval<future_state<T> &>())) type;
+        };
+
+        // the functor of async()
+        template <typename R, typename Fn>
+        struct AsyncCall {
+            AsyncCall(const std::shared_ptr<future_state<R>> & out, Fn && f) : out(out), f(std::move(f)) { }
+            AsyncCall(AsyncCall && other) : out(std::move(other.out)), f(std::move(other.f)) { }
+            void operator()(int id) {
+                struct Call {
+                    Fn & f;
+                    int id;
+                    R operator()() { return this->f(this->id); }
+                } g = { this->f, id };
+                set_state(*this->out, g);
+                this->out->finish(id);
+            }
+            std::shared_ptr<future_state<R>> out;
+            Fn f;
+        };
+
+        // the functor of then(), queued once the input is finished
+        template <typename T, typename R, typename Fn>
+        struct ThenCall {
+            ThenCall(const std::shared_ptr<future_state<T>> & in, const std::shared_ptr<future_state<R>> & out, Fn && f)
+                : in(in), out(out), f(std::move(f)) { }
+            ThenCall(ThenCall && other) : in(std::move(other.in)), out(std::move(other.out)), f(std::move(other.f)) { }
+            void operator()(int id) {
+                struct Call {
+                    ThenCall & c;
+                    int id;
+                    R operator()() { return then_invoker<T>::call(this->c.f, this->id, *this->c.in); }
+                } g = { *this, id };
+                set_state(*this->out, g);
+                this->in.reset();
+                this->out->finish(id);
+            }
+            std::shared_ptr<future_state<T>> in;
+            std::shared_ptr<future_state<R>> out;
+            Fn f;
+        };
+
+        // runs on the thread that finishes the input, passes a failure on or queues the ThenCall
+        template <typename T, typename R, typename Fn>
+        struct ThenSchedule {
+            explicit ThenSchedule(ThenCall<T, R, Fn> && call) : call(std::move(call)) { }
+            ThenSchedule(ThenSchedule && other) : call(std::move(other.call)) { }
+            void operator()(int id) {
+                if (this->call.in->error) {
+                    this->call.out->error = this->call.in->error;
+                    this->call.out->finish(id);
+                }
+                else
+                    this->call.out->pool->post(std::move(this->call));
+            }
+            ThenCall<T, R, Fn> call;
+        };
+
+        struct LatchCountDown {
+            void operator()(int) { this->l->count_down(); }
+            latch * l;
+        };
+
+        struct future_access;
+
+    }
+
+    // future of a functor run by a ctpl::ws_thread_pool, see async()
+    template <typename T>
+    class pool_future {
+
+    public:
+
+        pool_future() { }
+        explicit pool_future(const std::shared_ptr<detail::future_state<T>> & s) : state(s) { }
+        pool_future(pool_future && other) : state(std::move(other.state)) { }
+        pool_future & operator=(pool_future && other) {
+            this->state = std::move(other.state);
+            return *this;
+        }
+
+        bool valid() const { return this->state != nullptr; }
+        bool is_ready() const { return this->state->is_ready(); }
+
+        // block until the value is set, a worker of the pool runs other functors meanwhile
+        void wait() {
+            if (this->state->is_ready())
+                return;
+            latch l(1);
+            detail::LatchCountDown c = { &l };
+            this->state->on_finish(detail::new_task(c));
+            this->state->pool->wait(l);
+        }
+
+        // the value, rethrows the exception of the functor
+        T get() {
+            this->wait();
+            std::shared_ptr<detail::future_state<T>> s = std::move(this->state);
+            return s->take();
+        }
+
+        // f(int id, T value), or f(int id) for pool_future<void>, runs on the pool once this future is finished
+        template <typename F>
+        pool_future<typename detail::then_result<T, typename std::decay<F>::type>::type> then(F && f) {
+            typedef typename std::decay<F>::type Fn;
+            typedef typename detail::then_result<T, Fn>::type R;
+            std::shared_ptr<detail::future_state<R>> out = detail::new_future_state<R>(*this->state->pool);
+            std::shared_ptr<detail::future_state<T>> in = std::move(this->state);
+            detail::ThenCall<T, R, Fn> call(in, out, Fn(std::forward<F>(f)));
+            in->on_finish(detail::new_task(detail::ThenSchedule<T, R, Fn>(std::move(call))));
+            return pool_future<R>(out);
+        }
+
+    private:
+
+        friend struct detail::future_access;
+
+        // deleted
+        pool_future(const pool_future &);// = delete;
+        pool_future & operator=(const pool_future &);// = delete;
+
+        std::shared_ptr<detail::future_state<T>> state;
+    };
+
+    // run f(int id) on the pool
+    template <typename F>
+    pool_future<decltype(std::declval<typename std::decay<F>::type &>()(0))> async(ws_thread_pool & pool, F && f) {
+        typedef typename std::decay<F>::type Fn;
+        typedef decltype(std::declval<Fn &>()(0)) R;
+        std::shared_ptr<detail::future_state<R>> out = detail::new_future_state<R>(pool);
+        pool.post(detail::AsyncCall<R, Fn>(out, Fn(std::forward<F>(f))));
+        return pool_future<R>(out);
+    }
+
+    // index of the first finished input of when_any() and its value
+    template <typename T>
+    struct when_any_result {
+        size_t index;
+        T value;
+    };
+
+    template <>
+    struct when_any_result<void> {
+        size_t index;
+    };
+
+    namespace detail {
+
+        struct future_access {
+            template <typename T>
+            static std::shared_ptr<future_state<T>> release(pool_future<T> & f) { return std::move(f.state); }
+        };
+
+        // shared by the callbacks of when_all(), the last one to count down finishes out
+        template <typename T>
+        struct all_context {
+            all_context(size_t n, const std::shared_ptr<future_state<std::vector<T>>> & out) : values(n), remaining(n), failed(false), out(out) { }
+            void store(size_t i, future_state<T> & in) { this->values[i] = in.take(); }
+            void set_out() { this->out->set_value(std::move(this->values)); }
+            std::vector<T> values;
+            std::atomic<size_t> remaining;
+            std::atomic<bool> failed;
+            std::shared_ptr<future_state<std::vector<T>>> out;
+        };
+
+        template <>
+        struct all_context<void> {
+            all_context(size_t n, const std::shared_ptr<future_state<void>> & out) : remaining(n), failed(false), out(out) { }
+            void store(size_t, future_state<void> &) { }
+            void set_out() { }
+            std::atomic<size_t> remaining;
+            std::atomic<bool> failed;
+            std::shared_ptr<future_state<void>> out;
+        };
+
+        template <typename T>
+        struct AllCallback {
+            void operator()(int id) {
+                if (this->in->error) {
+                    if (!this->ctx->failed.exchange(true, std::memory_order_relaxed))
+                        this->ctx->out->error = this->in->error;
+                }
+                else
+                    this->ctx->store(this->i, *this->in);
+                this->in.reset();
+                if (this->ctx->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (!this->ctx->failed.load(std::memory_order_relaxed))
+                        this->ctx->set_out();
+                    this->ctx->out->finish(id);
+                }
+            }
+            std::shared_ptr<all_context<T>> ctx;
+            std::shared_ptr<future_state<T>> in;
+            size_t i;
+        };
+
+        template <typename T>
+        struct any_setter {
+            static void set(future_state<when_any_result<T>> & out, size_t i, future_state<T> & in) {
+                when_any_result<T> r = { i, in.take() };
+                out.set_value(std::move(r));
+            }
+        };
+
+        template <>
+        struct any_setter<void> {
+            static void set(future_state<when_any_result<void>> & out, size_t i, future_state<void> & in) {
+                in.take();
+                when_any_result<void> r = { i };
+                out.set_value(r);
+            }
+        };
+
+        // shared by the callbacks of when_any(), the first one to arrive finishes out
+        template <typename T>
+        struct any_context {
+            explicit any_context(const std::shared_ptr<future_state<when_any_result<T>>> & out) : done(false), out(out) { }
+            std::atomic<bool> done;
+            std::shared_ptr<future_state<when_any_result<T>>> out;
+        };
+
+        template <typename T>
+        struct AnyCallback {
+            void operator()(int id) {
+                if (!this->ctx->done.exchange(true, std::memory_order_acq_rel)) {
+                    try {
+                        any_setter<T>::set(*this->ctx->out, this->i, *this->in);
+                    }
+                    catch (...) {
+                        this->ctx->out->error = std::current_exception();
+                    }
+                    this->ctx->out->finish(id);
+                }
+                this->in.reset();
+            }
+            std::shared_ptr<any_context<T>> ctx;
+            std::shared_ptr<future_state<T>> in;
+            size_t i;
+        };
+
+        template <typename T>
+        struct when_all_type { typedef std::vector<T> type; };
+
+        template <>
+        struct when_all_type<void> { typedef void type; };
+
+    }
+
+    // finished when all inputs are, with their values in input order, or the first exception of an input
+    // T must be default constructible, pool_future<void> inputs give a pool_future<void>
+    template <typename T>
+    pool_future<typename detail::when_all_type<T>::type> when_all(ws_thread_pool & pool, std::vector<pool_future<T>> & inputs) {
+        typedef typename detail::when_all_type<T>::type R;
+        std::shared_ptr<detail::future_state<R>> out = detail::new_future_state<R>(pool);
+        std::shared_ptr<detail::all_context<T>> ctx = std::allocate_shared<detail::all_context<T>>(
+            detail::slab_allocator<detail::all_context<T>>(), inputs.size(), out);
+        if (inputs.empty()) {
+            ctx->set_out();
+            out->finish(pool.current_id());
+        }
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            detail::AllCallback<T> c = { ctx, detail::future_access::release(inputs[i]), i };
+            std::shared_ptr<detail::future_state<T>> in = c.in;
+            in->on_finish(detail::new_task(std::move(c)));
+        }
+        inputs.clear();
+        return pool_future<R>(out);
+    }
+
+    // finished with the first input that is, its index and value or exception, the other values are discarded
+    // inputs must not be empty
+    template <typename T>
+    pool_future<when_any_result<T>> when_any(ws_thread_pool & pool, std::vector<pool_future<T>> & inputs) {
+        std::shared_ptr<detail::future_state<when_any_result<T>>> out = detail::new_future_state<when_any_result<T>>(pool);
+        std::shared_ptr<detail::any_context<T>> ctx = std::allocate_shared<detail::any_context<T>>(
+            detail::slab_allocator<detail::any_context<T>>(), out);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            detail::AnyCallback<T> c = { ctx, detail::future_access::release(inputs[i]), i };
+            std::shared_ptr<detail::future_state<T>> in = c.in;
+            in->on_finish(detail::new_task(std::move(c)));
+        }
+        inputs.clear();
+        return pool_future<when_any_result<T>>(out);
+    }
+
+}
+
+#endif // __ctpl_pool_future_H__
@@ -0,0 +1,179 @@
+/*********************************************************
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*********************************************************/
+
+
+#ifndef __ctpl_task_graph_H__
+#define __ctpl_task_graph_H__
+
+#include "ctpl_ws.h"
+
+#include <stdexcept>
+
+
+// dependency graph of functors with signature
+//      void func(int id)
+// executed on a ctpl::ws_thread_pool, where id is the index of the thread that runs the functor
+//
+// the nodes and edges are registered once and run() executes the whole graph as often as needed,
+// e.g. once per macro step. a node is queued as soon as all of its predecessors are finished,
+// there are no barriers between the levels of the graph. a worker that finishes a node continues
+// directly with one of the successors it released and queues the others.
+
+
+namespace ctpl {
+
+    class task_graph {
+
+    public:
+
+        task_graph() : pool(nullptr), isDirty(false), isFailed(false) { }
+
+        // add a node and return its index, key >= 0 always runs the node on worker key % pool.size(), see ws_thread_pool::push_to()
+        template<typename F>
+        int add_node(F && f, int key = -1) {
+            this->nodes.push_back(Node());
+            this->nodes.back().fn = detail::task(std::forward<F>(f));
+            this->nodes.back().key = key;
+            this->isDirty = true;
+            return static_cast<int>(this->nodes.size()) - 1;
+        }
+
+        // node to only runs after node from is finished
+        void add_edge(int from, int to) {
+            if (from < 0 || from >= this->size() || to < 0 || to >= this->size())
+                throw std::out_of_range("ctpl::task_graph::add_edge: invalid node");
+            this->nodes[from].successors.push_back(to);
+            this->isDirty = true;
+        }
+
+        int size() const { return static_cast<int>(this->nodes.size()); }
+
+        // execute all nodes once and wait for them, must not be called for the same graph concurrently
+        // after the first exception of a node the nodes that have not started yet are skipped, the exception is rethrown
+        // called from a worker of the pool, the worker runs other functors while waiting
+        void run(ws_thread_pool & pool) {
+            if (this->isDirty)
+                this->compile();
+            int n = this->size();
+            if (n == 0)
+                return;
+            this->pool = &pool;
+            this->isFailed = false;
+            this->done.reset(n);
+            for (int i = 0; i < n; ++i)
+                this->pending[i].store(this->indegree[i], std::memory_order_relaxed);
+            for (int i = 0; i < n; ++i) {
+                if (this->indegree[i] == 0)
+                    this->release(i);
+            }
+            pool.wait(this->done);
+        }
+
+    private:
+
+        // deleted
+        task_graph(const task_graph &);// = delete;
+        task_graph & operator=(const task_graph &);// = delete;
+
+        struct Node {
+            detail::task fn;
+            int key;
+            std::vector<int> successors;
+        };
+
+        // queued for a released node, small enough for the inline storage of the task
+        struct Runner {
+            task_graph * graph;
+            int node;
+            void operator()(int id) { this->graph->execute(this->node, id); }
+        };
+
+        // count the predecessors and reject cycles (Kahn's algorithm)
+        void compile() {
+            int n = this->size();
+            this->indegree.assign(n, 0);
+            for (const Node & node : this->nodes) {
+                for (int to : node.successors)
+                    ++this->indegree[to];
+            }
+            std::vector<int> remaining(this->indegree);
+            std::vector<int> ready;
+            for (int i = 0; i < n; ++i) {
+                if (remaining[i] == 0)
+                    ready.push_back(i);
+            }
+            int visited = 0;
+            while (!ready.empty()) {
+                int i = ready.back();
+                ready.pop_back();
+                ++visited;
+                for (int to : this->nodes[i].successors) {
+                    if (--remaining[to] == 0)
+                        ready.push_back(to);
+                }
+            }
+            if (visited != n)
+                throw std::logic_error("ctpl::task_graph: the graph contains a cycle");
+            this->pending.reset(new std::atomic<int>[n]);
+            this->isDirty = false;
+        }
+
+        void release(int node) {
+            Runner runner = { this, node };
+            if (this->nodes[node].key >= 0)
+                this->pool->post_to(this->nodes[node].key, runner);
+            else
+                this->pool->post(runner);
+        }
+
+        void execute(int node, int id) {
+            while (node >= 0) {
+                if (!this->isFailed) {
+                    try {
+                        this->nodes[node].fn(id);
+                    }
+                    catch (...) {
+                        this->isFailed = true;
+                        this->done.set_exception(std::current_exception());
+                    }
+                }
+                int next = -1;
+                for (int to : this->nodes[node].successors) {
+                    if (this->pending[to].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        if (next < 0 && this->nodes[to].key < 0)
+                            next = to;  // continue here instead of going through the queues
+                        else
+                            this->release(to);
+                    }
+                }
+                // last access to the graph for this node, run() may return once all nodes counted down
+                this->done.count_down();
+                node = next;
+            }
+        }
+
+        std::vector<Node> nodes;
+        std::vector<int> indegree;
+        std::unique_ptr<std::atomic<int>[]> pending;  // predecessors still running in the current run()
+        ws_thread_pool * pool;
+        latch done;
+        bool isDirty;
+        std::atomic<bool> isFailed;
+    };
+
+}
+
+#endif // __ctpl_task_graph_H__
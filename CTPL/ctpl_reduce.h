@@ -0,0 +1,185 @@
+/*********************************************************
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*********************************************************/
+
+
+#ifndef __ctpl_reduce_H__
+#define __ctpl_reduce_H__
+
+#include "ctpl_ws.h"
+
+#include <iterator>
+
+
+// reductions and scans over an index range on a ctpl::ws_thread_pool
+//
+//      double norm2 = ctpl::parallel_transform_reduce(pool, 0, n, 0.0,
+//          [&](int id, int i) { return err[i] * err[i]; }, std::plus<double>());
+//      bool converged = ctpl::parallel_transform_reduce(pool, 0, n, true,
+//          [&](int id, int i) { return fmus[i].converged(); }, std::logical_and<bool>());
+//      ctpl::parallel_inclusive_scan(pool, sizes.begin(), sizes.end(), offsets.begin(), std::plus<size_t>());
+//
+// the range is cut into chunks of grain indices, every chunk is folded into its own partial
+// result, which has a cache line to itself, and the caller combines the partials in chunk order
+// once all chunks are finished. which worker runs a chunk does not matter, so as long as the
+// grain is the same the result is the same in every run, also with a non-associative combine
+// such as a floating point sum. grain <= 0 cuts the range into at most _ctplReduceChunks_
+// chunks, which does not depend on the number of threads either.
+//
+// called from a worker of the pool, the worker runs other functors while waiting, as with
+// ws_thread_pool::parallel_for. the first exception of a functor is rethrown to the caller.
+
+// number of chunks when no grain is given
+#ifndef _ctplReduceChunks_
+#define _ctplReduceChunks_  256
+#endif
+
+
+namespace ctpl {
+
+    namespace detail {
+
+        // one partial result per chunk, each on its own cache lines
+        template <typename T>
+        class padded_partials {
+
+        public:
+
+            enum { cache_line = 64 };
+
+            padded_partials(size_t n, const T & init) : n(0) {
+                this->stride = (sizeof(T) + cache_line - 1) & ~size_t(cache_line - 1);
+                this->raw = static_cast<char *>(::operator new(n * this->stride + cache_line));
+                this->data = this->raw + (cache_line - reinterpret_cast<uintptr_t>(this->raw) % cache_line) % cache_line;
+                try {
+                    for (; this->n < n; ++this->n)
+                        new (this->data + this->n * this->stride) T(init);
+                }
+                catch (...) {
+                    this->destroy();
+                    throw;
+                }
+            }
+            ~padded_partials() { this->destroy(); }
+
+            T & operator[](size_t k) { return *reinterpret_cast<T *>(this->data + k * this->stride); }
+
+        private:
+
+            // deleted
+            padded_partials(const padded_partials &);// = delete;
+            padded_partials & operator=(const padded_partials &);// = delete;
+
+            void destroy() {
+                for (size_t k = 0; k < this->n; ++k)
+                    (*this)[k].~T();
+                ::operator delete(this->raw);
+            }
+
+            char * raw;
+            char * data;  // raw aligned to a cache line
+            size_t stride;
+            size_t n;  // constructed
+        };
+
+        template <typename Index>
+        inline Index reduce_grain(Index n, Index grain) {
+            if (grain <= 0) {
+                Index nChunks = static_cast<Index>(_ctplReduceChunks_);
+                grain = (n + nChunks - 1) / nChunks;
+            }
+            return grain > 0 ? grain : Index(1);
+        }
+
+    }
+
+    // fold the chunks of [begin, end) with body(id, lo, hi, identity), which returns the result of
+    // the indices [lo, hi), and combine these results in order, starting with identity
+    template <typename Index, typename T, typename Body, typename Combine>
+    T parallel_reduce(ws_thread_pool & pool, Index begin, Index end, T identity, Body body, Combine combine, Index grain = 0) {
+        if (!(begin < end))
+            return identity;
+        grain = detail::reduce_grain(static_cast<Index>(end - begin), grain);
+        Index nChunks = (end - begin + grain - 1) / grain;
+        detail::padded_partials<T> partials(static_cast<size_t>(nChunks), identity);
+        pool.parallel_for(Index(0), nChunks, Index(1), [&](int id, Index c) {
+            Index lo = begin + c * grain;
+            Index hi = (end - lo > grain) ? lo + grain : end;
+            T & partial = partials[static_cast<size_t>(c)];
+            partial = body(id, lo, hi, std::move(partial));
+        });
+        T result = std::move(identity);
+        for (Index c = 0; c < nChunks; ++c)
+            result = combine(std::move(result), std::move(partials[static_cast<size_t>(c)]));
+        return result;
+    }
+
+    // combine transform(id, i) of every i in [begin, end), in index order within a chunk
+    template <typename Index, typename T, typename Transform, typename Combine>
+    T parallel_transform_reduce(ws_thread_pool & pool, Index begin, Index end, T identity, Transform transform, Combine combine, Index grain = 0) {
+        return parallel_reduce(pool, begin, end, identity, [&](int id, Index lo, Index hi, T partial) {
+            for (Index i = lo; i < hi; ++i)
+                partial = combine(std::move(partial), transform(id, i));
+            return partial;
+        }, combine, grain);
+    }
+
+    // out[i] = first[0] combined with first[1] ... first[i], for random access iterators.
+    // the chunks are folded in parallel, their prefixes are combined by the caller and then
+    // the chunks are scanned in parallel again. out may be first for a scan in place
+    template <typename InputIt, typename OutputIt, typename Combine>
+    void parallel_inclusive_scan(ws_thread_pool & pool, InputIt first, InputIt last, OutputIt out, Combine combine,
+                                 typename std::iterator_traits<InputIt>::difference_type grain = 0) {
+        typedef typename std::iterator_traits<InputIt>::difference_type Index;
+        typedef typename std::iterator_traits<InputIt>::value_type T;
+        Index n = last - first;
+        if (n <= 0)
+            return;
+        grain = detail::reduce_grain(n, grain);
+        Index nChunks = (n + grain - 1) / grain;
+        detail::padded_partials<T> partials(static_cast<size_t>(nChunks), first[0]);
+        // the totals of all chunks but the last
+        pool.parallel_for(Index(0), nChunks - 1, Index(1), [&](int, Index c) {
+            Index lo = c * grain;
+            T total = first[lo];
+            for (Index i = lo + 1; i < lo + grain; ++i)
+                total = combine(std::move(total), first[i]);
+            partials[static_cast<size_t>(c)] = std::move(total);
+        });
+        // partials[c] becomes the combination of the chunks before c
+        if (nChunks > 1) {
+            T prefix = std::move(partials[0]);
+            for (Index c = 1; c < nChunks; ++c) {
+                T total = std::move(partials[static_cast<size_t>(c)]);
+                partials[static_cast<size_t>(c)] = prefix;
+                if (c + 1 < nChunks)
+                    prefix = combine(std::move(prefix), std::move(total));
+            }
+        }
+        pool.parallel_for(Index(0), nChunks, Index(1), [&](int, Index c) {
+            Index lo = c * grain;
+            Index hi = (n - lo > grain) ? lo + grain : n;
+            T acc = (c == 0) ? T(first[lo]) : combine(partials[static_cast<size_t>(c)], first[lo]);
+            out[lo] = acc;
+            for (Index i = lo + 1; i < hi; ++i) {
+                acc = combine(std::move(acc), first[i]);
+                out[i] = acc;
+            }
+        });
+    }
+
+}
+
+#endif // __ctpl_reduce_H__
@@ -0,0 +1,184 @@
+/*********************************************************
+*
+*  Copyright (C) 2014 by Vitaliy Vitsentiy
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*********************************************************/
+
+
+#ifndef __ctpl_scratch_H__
+#define __ctpl_scratch_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+// size of the first block of a scratch arena, allocated by its worker on first use
+#ifndef _ctplScratchSize_
+#define _ctplScratchSize_  65536
+#endif
+
+
+// per-worker scratch memory of ctpl::thread_pool and ctpl::ws_thread_pool
+//
+// every worker owns a scratch_arena, which its functors reach with pool.scratch(id) using the id
+// they are called with. it hands out temporary buffers, e.g. for value transfers or Jacobian
+// columns, by bumping a pointer. when a functor returns, also by an exception, the pool rewinds the
+// arena to where it was when the functor started, so the memory must not outlive the functor, and
+// the functors a worker runs while waiting inside another one leave the arena as they found it.
+// a coroutine of ctpl_coro.h must not keep scratch memory across a co_await.
+//
+// the blocks of an arena start on a cache line and are a multiple of its size, so the scratch
+// memory of different workers never shares a cache line. an arena that grew into several blocks
+// is replaced by a single block of their total size the next time it is empty, so in steady
+// state functors make no allocations.
+
+
+namespace ctpl {
+
+    class scratch_arena {
+
+    public:
+
+        enum { cache_line = 64 };
+
+        // position in the arena, see mark() and rewind()
+        struct marker {
+            size_t block;
+            size_t offset;
+        };
+
+        scratch_arena() : current(0), offset(0), highWater(0) { }
+        ~scratch_arena() { this->release(); }
+
+        // uninitialized memory for bytes, align must be a power of two
+        void * allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+            while (true) {
+                if (this->current < this->blocks.size()) {
+                    Block & b = this->blocks[this->current];
+                    uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+                    size_t start = ((base + this->offset + align - 1) & ~(uintptr_t(align) - 1)) - base;
+                    if (start + bytes <= b.size) {
+                        this->offset = start + bytes;
+                        if (this->size() > this->highWater)
+                            this->highWater = this->size();
+                        return b.data + start;
+                    }
+                }
+                if (this->current + 1 < this->blocks.size()) {  // kept from before a rewind
+                    ++this->current;
+                    this->offset = 0;
+                    continue;
+                }
+                size_t blockSize = this->blocks.empty() ? size_t(_ctplScratchSize_) : 2 * this->blocks.back().size;
+                if (blockSize < bytes + align)
+                    blockSize = bytes + align;
+                this->add_block(blockSize);
+                this->current = this->blocks.size() - 1;
+                this->offset = 0;
+            }
+        }
+
+        // uninitialized array of n elements, which are never destroyed
+        template <typename T>
+        T * allocate_array(size_t n) {
+            static_assert(std::is_trivially_destructible<T>::value, "scratch arrays are not destroyed");
+            return static_cast<T *>(this->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        marker mark() const {
+            marker m = { this->current, this->offset };
+            return m;
+        }
+
+        // free everything allocated since m was taken
+        void rewind(const marker & m) {
+            this->current = m.block;
+            this->offset = m.offset;
+            if (m.block == 0 && m.offset == 0 && this->blocks.size() > 1) {
+                size_t total = this->capacity();
+                this->release();
+                this->add_block(total);
+            }
+        }
+
+        // bytes up to the current position, including those skipped for alignment or at the end of a block
+        size_t size() const {
+            size_t n = this->offset;
+            for (size_t k = 0; k < this->current && k < this->blocks.size(); ++k)
+                n += this->blocks[k].size;
+            return n;
+        }
+
+        // largest size() so far, e.g. for choosing _ctplScratchSize_
+        size_t high_water() const { return this->highWater; }
+
+        size_t capacity() const {
+            size_t n = 0;
+            for (const Block & b : this->blocks)
+                n += b.size;
+            return n;
+        }
+
+    private:
+
+        struct Block {
+            char * raw;
+            char * data;  // raw aligned to a cache line
+            size_t size;
+        };
+
+        void add_block(size_t bytes) {
+            Block b;
+            b.size = (bytes + cache_line - 1) & ~size_t(cache_line - 1);
+            b.raw = static_cast<char *>(::operator new(b.size + cache_line));
+            b.data = b.raw + (cache_line - reinterpret_cast<uintptr_t>(b.raw) % cache_line) % cache_line;
+            this->blocks.push_back(b);
+        }
+
+        void release() {
+            for (const Block & b : this->blocks)
+                ::operator delete(b.raw);
+            this->blocks.clear();
+            this->current = 0;
+            this->offset = 0;
+        }
+
+        // deleted
+        scratch_arena(const scratch_arena &);// = delete;
+        scratch_arena & operator=(const scratch_arena &);// = delete;
+
+        std::vector<Block> blocks;
+        size_t current;  // block allocated from
+        size_t offset;  // in that block
+        size_t highWater;
+    };
+
+    // rewinds an arena at the end of a scope, e.g. in a functor that uses its scratch memory in phases
+    class scratch_scope {
+    public:
+        explicit scratch_scope(scratch_arena & arena) : arena(arena), m(arena.mark()) { }
+        ~scratch_scope() { this->arena.rewind(this->m); }
+    private:
+        scratch_scope(const scratch_scope &);// = delete;
+        scratch_scope & operator=(const scratch_scope &);// = delete;
+        scratch_arena & arena;
+        scratch_arena::marker m;
+    };
+
+}
+
+#endif // __ctpl_scratch_H__
@@ -28,7 +28,19 @@
 #include <exception>
 #include <future>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
 #include <queue>
+#include "ctpl_scratch.h"
+
+// Chrome trace events of the enclosing build, recorded with OMS_TRACE
+#ifdef OMS_TRACE
+#include <omstrace.h>
+#else
+#define OMS_TRACE_INSTANT(category, name)
+#define OMS_TRACE_SCOPE(category, name)
+#endif
 
 
 
@@ -81,54 +93,89 @@ namespace ctpl {
         }
 
         // get the number of running threads in the pool
-        int size() { return static_cast<int>(this->threads.size()); }
+        int size() { return this->nThreads; }
 
         // number of idle threads
         int n_idle() { return this->nWaiting; }
+
+        // number of functors waiting in the queue
+        int n_queued() { return this->nQueued; }
+
         std::thread & get_thread(int i) { return *this->threads[i]; }
 
+        // scratch memory of thread i for the functor running on it, rewound when the functor returns, see ctpl_scratch.h
+        scratch_arena & scratch(int i) {
+            const ScratchSlot & slot = current_scratch();
+            if (slot.pool == this)
+                return *slot.arena;  // the calling thread is a worker, also safe while the pool is resized
+            return *this->arenas[i];
+        }
+
         // change the number of threads in the pool
-        // should be called from one thread, otherwise be careful to not interleave, also with this->stop()
+        // may be called from any thread, also while the pool is scaled automatically, see set_autoscale()
+        // when the pool shrinks, the removed threads finish their current functor and resize() waits for them
         // nThreads must be >= 0
-        void resize(int nThreads) {
-            if (!this->isStop && !this->isDone) {
-                int oldNThreads = static_cast<int>(this->threads.size());
-                if (oldNThreads <= nThreads) {  // if the number of threads is increased
-                    this->threads.resize(nThreads);
-                    this->flags.resize(nThreads);
+        void resize(int nThreads) { this->resize_pool(nThreads, false); }
 
-                    for (int i = oldNThreads; i < nThreads; ++i) {
-                        this->flags[i] = std::make_shared<std::atomic<bool>>(false);
-                        this->set_thread(i);
-                    }
-                }
-                else {  // the number of threads is decreased
-                    for (int i = oldNThreads - 1; i >= nThreads; --i) {
-                        *this->flags[i] = true;  // this thread will finish
-                        this->threads[i]->detach();
-                    }
-                    {
-                        // stop the detached threads that were waiting
-                        std::unique_lock<std::mutex> lock(this->mutex);
-                        this->cv.notify_all();
-                    }
-                    this->threads.resize(nThreads);  // safe to delete because the threads are detached
-                    this->flags.resize(nThreads);  // safe to delete because the threads have copies of shared_ptr of the flags, not originals
-                }
+        // limits and timing of the automatic scaling, see set_autoscale()
+        struct autoscale_policy {
+            autoscale_policy(int minThreads = 1, int maxThreads = 1)
+                : min_threads(minThreads), max_threads(maxThreads), interval_ms(10), grow_samples(2), shrink_delay_ms(1000) { }
+            int min_threads;
+            int max_threads;
+            int interval_ms;  // how often the controller looks at the queue and the idle threads
+            int grow_samples;  // samples in a row with queued functors and no idle thread before threads are added
+            int shrink_delay_ms;  // how long threads must have been idle before they are removed
+        };
+
+        // let a controller thread resize the pool between min_threads and max_threads. when functors
+        // wait in the queue and no thread is idle for grow_samples samples in a row, it adds a thread per
+        // queued functor, at most doubling the pool. when threads were idle all through shrink_delay_ms,
+        // as many are removed, but only from the waiting threads at the end of the pool, so that no functor
+        // is held up. a manual resize() is moved back into the limits on the next sample.
+        // calling it again replaces the policy
+        void set_autoscale(const autoscale_policy & policy) {
+            std::unique_lock<std::mutex> lock(this->autoscaleMutex);
+            this->autoscalePolicy = policy;
+            autoscale_policy & p = this->autoscalePolicy;
+            p.min_threads = std::max(p.min_threads, 0);
+            p.max_threads = std::max(p.max_threads, std::max(p.min_threads, 1));
+            p.interval_ms = std::max(p.interval_ms, 1);
+            p.grow_samples = std::max(p.grow_samples, 1);
+            p.shrink_delay_ms = std::max(p.shrink_delay_ms, 0);
+            if (!this->autoscaler && !this->isStop && !this->isDone) {
+                this->autoscaleStop = false;
+                this->autoscaler.reset(new std::thread([this]() { this->autoscale(); }));
+            }
+            this->autoscaleCv.notify_all();
+        }
+
+        void set_autoscale(int minThreads, int maxThreads) { this->set_autoscale(autoscale_policy(minThreads, maxThreads)); }
+
+        // stop the automatic scaling, the pool keeps its current size
+        void stop_autoscale() {
+            std::unique_ptr<std::thread> controller;
+            {
+                std::unique_lock<std::mutex> lock(this->autoscaleMutex);
+                this->autoscaleStop = true;
+                this->autoscaleCv.notify_all();
+                controller.swap(this->autoscaler);
             }
+            if (controller && controller->joinable())
+                controller->join();
         }
 
         // empty the queue
         void clear_queue() {
             std::function<void(int id)> * _f;
-            while (this->q.pop(_f))
+            while (this->pop_queued(_f))
                 delete _f; // empty the queue
         }
 
         // pops a functional wrapper to the original function
         std::function<void(int)> pop() {
             std::function<void(int id)> * _f = nullptr;
-            this->q.pop(_f);
+            this->pop_queued(_f);
             std::unique_ptr<std::function<void(int id)>> func(_f); // at return, delete the function even if an exception occurred
             std::function<void(int)> f;
             if (_f)
@@ -140,6 +187,8 @@ namespace ctpl {
         // may be called asynchronously to not pause the calling thread while waiting
         // if isWait == true, all the functions in the queue are run, otherwise the queue is cleared without running the functions
         void stop(bool isWait = false) {
+            this->stop_autoscale();
+            std::unique_lock<std::mutex> resizeLock(this->resizeMutex);
             if (!isWait) {
                 if (this->isStop)
                     return;
@@ -162,11 +211,17 @@ namespace ctpl {
                     if (this->threads[i]->joinable())
                         this->threads[i]->join();
             }
+            for (size_t i = 0; i < this->retired.size(); ++i)  // and for those that removed themselves with resize()
+                this->retired[i]->join();
             // if there were no threads in the pool but some functors in the queue, the functors are not deleted by the threads
             // therefore delete them here
             this->clear_queue();
             this->threads.clear();
             this->flags.clear();
+            this->waiting.clear();
+            this->arenas.clear();
+            this->retired.clear();
+            this->nThreads = 0;
         }
 
         template<typename F, typename... Rest>
@@ -177,7 +232,9 @@ namespace ctpl {
             auto _f = new std::function<void(int id)>([pck](int id) {
                 (*pck)(id);
             });
+            ++this->nQueued;  // before the push, so that it is never negative
             this->q.push(_f);
+            OMS_TRACE_INSTANT("ctpl", "thread_pool::push");
             std::unique_lock<std::mutex> lock(this->mutex);
             this->cv.notify_one();
             return pck->get_future();
@@ -191,7 +248,9 @@ namespace ctpl {
             auto _f = new std::function<void(int id)>([pck](int id) {
                 (*pck)(id);
             });
+            ++this->nQueued;  // before the push, so that it is never negative
             this->q.push(_f);
+            OMS_TRACE_INSTANT("ctpl", "thread_pool::push");
             std::unique_lock<std::mutex> lock(this->mutex);
             this->cv.notify_one();
             return pck->get_future();
@@ -206,25 +265,152 @@ namespace ctpl {
         thread_pool & operator=(const thread_pool &);// = delete;
         thread_pool & operator=(thread_pool &&);// = delete;
 
+        // resize() and the controller of set_autoscale(), which removes only waiting threads
+        void resize_pool(int nThreads, bool idleOnly) {
+            std::vector<std::unique_ptr<std::thread>> removed;
+            {
+                std::unique_lock<std::mutex> resizeLock(this->resizeMutex);
+                if (this->isStop || this->isDone)
+                    return;
+                int oldNThreads = static_cast<int>(this->threads.size());
+                if (oldNThreads <= nThreads) {  // if the number of threads is increased
+                    this->threads.resize(nThreads);
+                    this->flags.resize(nThreads);
+                    this->waiting.resize(nThreads);
+                    this->arenas.resize(nThreads);
+
+                    for (int i = oldNThreads; i < nThreads; ++i) {
+                        this->flags[i] = std::make_shared<std::atomic<bool>>(false);
+                        this->waiting[i] = std::make_shared<std::atomic<bool>>(false);
+                        this->arenas[i] = std::make_shared<scratch_arena>();
+                        this->set_thread(i);
+                    }
+                }
+                else {  // the number of threads is decreased, from the end
+                    {
+                        // flagged under the mutex, where a waiting thread cannot take a functor any more
+                        std::unique_lock<std::mutex> lock(this->mutex);
+                        int n = oldNThreads;
+                        while (n > nThreads && (!idleOnly || *this->waiting[n - 1])) {
+                            --n;
+                            *this->flags[n] = true;  // this thread will finish
+                        }
+                        nThreads = n;
+                        this->cv.notify_all();  // stop the flagged threads that were waiting
+                    }
+                    for (int i = nThreads; i < oldNThreads; ++i) {
+                        if (this->threads[i]->get_id() == std::this_thread::get_id())
+                            this->retired.push_back(std::move(this->threads[i]));  // resize() called by a functor of this thread, joined by stop()
+                        else
+                            removed.push_back(std::move(this->threads[i]));
+                    }
+                    this->threads.resize(nThreads);
+                    this->flags.resize(nThreads);  // safe to delete because the threads have copies of shared_ptr of the flags, not originals
+                    this->waiting.resize(nThreads);
+                    this->arenas.resize(nThreads);  // likewise for the scratch arenas
+                }
+                this->nThreads = nThreads;
+            }
+            // the pool does not wait for them with the lock held, so that size() and stop() are not blocked by a long functor
+            for (size_t i = 0; i < removed.size(); ++i)
+                removed[i]->join();
+        }
+
+        // the pool and scratch arena of the calling worker
+        struct ScratchSlot {
+            const thread_pool * pool;
+            scratch_arena * arena;
+        };
+
+        static ScratchSlot & current_scratch() {
+            static thread_local ScratchSlot slot = { nullptr, nullptr };
+            return slot;
+        }
+
+        bool pop_queued(std::function<void(int id)> * & f) {
+            if (!this->q.pop(f))
+                return false;
+            --this->nQueued;
+            return true;
+        }
+
+        // the controller thread of set_autoscale()
+        void autoscale() {
+            typedef std::chrono::steady_clock clock;
+            int busySamples = 0;  // in a row with queued functors and no idle thread
+            int minIdle = -1;  // fewest idle threads since idleSince, -1 unless all samples since then had idle threads and an empty queue
+            clock::time_point idleSince = clock::now();
+            std::unique_lock<std::mutex> lock(this->autoscaleMutex);
+            while (!this->autoscaleStop) {
+                this->autoscaleCv.wait_for(lock, std::chrono::milliseconds(this->autoscalePolicy.interval_ms));
+                if (this->autoscaleStop)
+                    break;
+                autoscale_policy p = this->autoscalePolicy;
+                lock.unlock();
+
+                int n = this->size(), idle = this->n_idle(), queued = this->n_queued();
+                clock::time_point now = clock::now();
+                int target = n;
+                if (queued > 0 && idle == 0) {
+                    if (++busySamples >= p.grow_samples)
+                        target = n + std::min(queued, std::max(n, 1));
+                }
+                else
+                    busySamples = 0;
+                if (queued == 0 && idle > 0) {
+                    if (minIdle < 0) {
+                        minIdle = idle;
+                        idleSince = now;
+                    }
+                    minIdle = std::min(minIdle, idle);
+                    if (now - idleSince >= std::chrono::milliseconds(p.shrink_delay_ms))
+                        target = n - minIdle;
+                }
+                else
+                    minIdle = -1;
+                target = std::max(p.min_threads, std::min(p.max_threads, target));
+                if (target != n) {
+                    this->resize_pool(target, target < n);  // only the threads that still wait are removed
+                    if (this->size() != n) {
+                        busySamples = 0;
+                        minIdle = -1;
+                    }
+                }
+                lock.lock();
+            }
+        }
+
         void set_thread(int i) {
             std::shared_ptr<std::atomic<bool>> flag(this->flags[i]); // a copy of the shared ptr to the flag
-            auto f = [this, i, flag/* a copy of the shared ptr to the flag */]() {
+            std::shared_ptr<scratch_arena> arena(this->arenas[i]); // and to the scratch arena
+            std::shared_ptr<std::atomic<bool>> waiting(this->waiting[i]);  // and to the waiting state
+            auto f = [this, i, flag/* a copy of the shared ptr to the flag */, arena, waiting]() {
                 std::atomic<bool> & _flag = *flag;
+                ScratchSlot & slot = current_scratch();
+                slot.pool = this;
+                slot.arena = arena.get();
                 std::function<void(int id)> * _f;
-                bool isPop = this->q.pop(_f);
+                bool isPop = this->pop_queued(_f);
                 while (true) {
                     while (isPop) {  // if there is anything in the queue
                         std::unique_ptr<std::function<void(int id)>> func(_f); // at return, delete the function even if an exception occurred
-                        (*_f)(i);
+                        {
+                            OMS_TRACE_SCOPE("ctpl", "thread_pool task");
+                            scratch_scope scope(*arena);  // rewound also when the function throws
+                            (*_f)(i);
+                        }
                         if (_flag)
                             return;  // the thread is wanted to stop, return even if the queue is not empty yet
                         else
-                            isPop = this->q.pop(_f);
+                            isPop = this->pop_queued(_f);
                     }
                     // the queue is empty here, wait for the next command
                     std::unique_lock<std::mutex> lock(this->mutex);
                     ++this->nWaiting;
-                    this->cv.wait(lock, [this, &_f, &isPop, &_flag](){ isPop = this->q.pop(_f); return isPop || this->isDone || _flag; });
+                    *waiting = true;
+                    // a flagged thread takes no functor, so that the pool can remove waiting threads without delaying a functor
+                    this->cv.wait(lock, [this, &_f, &isPop, &_flag](){ isPop = !_flag && this->pop_queued(_f); return isPop || this->isDone || _flag; });
+                    *waiting = false;
                     --this->nWaiting;
                     if (!isPop)
                         return;  // if the queue is empty and this->isDone == true or *flag then return
@@ -233,17 +419,29 @@ namespace ctpl {
             this->threads[i].reset(new std::thread(f)); // compiler may not support std::make_unique()
         }
 
-        void init() { this->nWaiting = 0; this->isStop = false; this->isDone = false; }
+        void init() { this->nWaiting = 0; this->nThreads = 0; this->nQueued = 0; this->isStop = false; this->isDone = false; this->autoscaleStop = false; }
 
         std::vector<std::unique_ptr<std::thread>> threads;
         std::vector<std::shared_ptr<std::atomic<bool>>> flags;
+        std::vector<std::shared_ptr<std::atomic<bool>>> waiting;  // whether thread i waits for a functor, changed under mutex
+        std::vector<std::shared_ptr<scratch_arena>> arenas;
+        std::vector<std::unique_ptr<std::thread>> retired;  // removed by a resize() on their own thread
         detail::Queue<std::function<void(int id)> *> q;
         std::atomic<bool> isDone;
         std::atomic<bool> isStop;
         std::atomic<int> nWaiting;  // how many threads are waiting
+        std::atomic<int> nThreads;  // threads.size(), also readable while the pool is resized
+        std::atomic<int> nQueued;  // functors in the queue
+        std::mutex resizeMutex;  // taken by resize() and stop()
 
         std::mutex mutex;
         std::condition_variable cv;
+
+        autoscale_policy autoscalePolicy;  // guarded by autoscaleMutex, like autoscaleStop and autoscaler
+        bool autoscaleStop;
+        std::unique_ptr<std::thread> autoscaler;
+        std::mutex autoscaleMutex;
+        std::condition_variable autoscaleCv;
     };
 
 }
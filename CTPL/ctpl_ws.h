@@ -0,0 +1,1612 @@
+/*********************************************************
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*********************************************************/
+
+
+#ifndef __ctpl_ws_thread_pool_H__
+#define __ctpl_ws_thread_pool_H__
+
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+
+#include "ctpl_scratch.h"
+
+// Chrome trace events of the enclosing build, recorded with OMS_TRACE
+#ifdef OMS_TRACE
+#include <omstrace.h>
+#else
+#define OMS_TRACE_INSTANT(category, name)
+#define OMS_TRACE_SCOPE(category, name)
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifndef _ctplDequeLogCapacity_
+#define _ctplDequeLogCapacity_  8
+#endif
+
+// initial capacity of the injection queue, same default as the queue of ctpl::thread_pool
+#ifndef _ctplThreadPoolLength_
+#define _ctplThreadPoolLength_  100
+#endif
+
+// idle workers spin this many times with a cpu pause and then yield this many times before parking
+#ifndef _ctplIdleSpinCount_
+#define _ctplIdleSpinCount_  256
+#endif
+
+#ifndef _ctplIdleYieldCount_
+#define _ctplIdleYieldCount_  16
+#endif
+
+// bytes of a task stored inline, larger functors go to the slab allocator
+#ifndef _ctplTaskInlineSize_
+#define _ctplTaskInlineSize_  48
+#endif
+
+// number of priority lanes served before the ordinary queues, see ws_thread_pool::push_priority()
+#ifndef _ctplPriorityLanes_
+#define _ctplPriorityLanes_  3
+#endif
+
+// functors taken in a row from the highest busy lane before a lower level gets one turn
+#ifndef _ctplPriorityBurst_
+#define _ctplPriorityBurst_  16
+#endif
+
+// define _ctplEnableStats_ to count tasks, steals, busy and queue-wait times, see ws_thread_pool::get_stats()
+// without it the counters are compiled out and get_stats() returns zeros
+
+
+// work-stealing thread pool to run user's functors with signature
+//      ret func(int id, other_params)
+// where id is the index of the thread that runs the functor
+// ret is some return type
+//
+// every worker owns a Chase-Lev deque. functors pushed from a worker thread of the pool
+// (nested tasks) go to the bottom of that worker's deque and are popped LIFO by the owner,
+// functors pushed from any other thread go to a shared injection queue, a lock-free queue that grows
+// by adding segments instead of allocating nodes on the fly. idle workers take
+// work from the injection queue first and then steal from the top of randomly chosen victims.
+// unlike ctpl::thread_pool, the number of threads is fixed at construction.
+//
+// queued functors are move-only tasks with inline storage, the tasks, larger functors and the
+// shared states of the returned futures come from a slab allocator with per-thread caches,
+// so in steady state pushing does not call the global operator new.
+//
+// a worker without work first spins, then yields and only then parks on the condition variable,
+// see set_idle_strategy(). within a ws_thread_pool::hot_session the workers do not park at all.
+//
+// the workers are split into groups by NUMA node, set_numa_affinity() pins every group to the
+// cpus of its node and set_affinity() pins the workers to a list of cpus. push_to() queues a
+// functor for one worker and push_to_node() for the workers of one node, these are never stolen.
+// post() and post_to() queue functors without futures, see also ctpl::task_graph in ctpl_graph.h.
+//
+// push_priority() and push_deadline() queue a functor in one of _ctplPriorityLanes_ priority lanes,
+// which the workers serve before their own deques and the shared queues, lane 0 first. within a
+// lane the functors with the earliest deadline run first, those without a deadline follow in
+// FIFO order. to keep the lower lanes and the ordinary functors from starving, a worker that took
+// set_priority_burst() functors in a row from the highest busy lane gives one turn to the levels
+// below it, in rotation.
+
+
+namespace ctpl {
+
+    // counter to wait on for a group of functors, e.g. the chunks of ws_thread_pool::push_bulk
+    // the first exception thrown by one of the functors is rethrown by wait()
+    class latch {
+
+    public:
+
+        explicit latch(int64_t count = 0) : counter(count), data(nullptr), deleter(nullptr) { }
+        ~latch() {
+            if (this->deleter)
+                this->deleter(this->data);
+        }
+
+        void add(int64_t n = 1) { this->counter.fetch_add(n, std::memory_order_relaxed); }
+
+        void count_down(int64_t n = 1) {
+            int64_t c = this->counter.load(std::memory_order_relaxed);
+            while (c > n) {
+                if (this->counter.compare_exchange_weak(c, c - n, std::memory_order_acq_rel, std::memory_order_relaxed))
+                    return;
+            }
+            // the last count is taken under the mutex, wait() locks it too before returning,
+            // so the latch may be destroyed as soon as wait() returns
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->counter.fetch_sub(n, std::memory_order_acq_rel);
+            this->cv.notify_all();
+        }
+
+        // store the exception of a failed functor, only the first one is kept
+        void set_exception(std::exception_ptr e) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (!this->error)
+                this->error = e;
+        }
+
+        // start over with a new count and no exception, nobody may wait on the latch meanwhile
+        void reset(int64_t count) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->error = nullptr;
+            this->counter.store(count, std::memory_order_release);
+        }
+
+        bool try_wait() const { return this->counter.load(std::memory_order_acquire) <= 0; }
+
+        void wait() {
+            if (!this->try_wait()) {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cv.wait(lock, [this](){ return this->try_wait(); });
+            }
+            this->rethrow();
+        }
+
+        void rethrow() {
+            std::exception_ptr e;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                e = this->error;
+            }
+            if (e)
+                std::rethrow_exception(e);
+        }
+
+    private:
+
+        // deleted
+        latch(const latch &);// = delete;
+        latch & operator=(const latch &);// = delete;
+
+        friend class ws_thread_pool;
+
+        std::atomic<int64_t> counter;
+        void * data;  // functor shared by the chunks of push_bulk
+        void (*deleter)(void *);
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    namespace detail {
+
+        // single-producer (the owning worker) / multi-consumer deque of pointers,
+        // see Chase and Lev, "Dynamic circular work-stealing deque", SPAA 2005, and
+        // Le et al., "Correct and efficient work-stealing for weak memory models", PPoPP 2013
+        template <typename T>
+        class WorkStealingDeque {
+        public:
+            explicit WorkStealingDeque(int logCapacity = _ctplDequeLogCapacity_) : top(0), bottom(0) {
+                this->array.store(new Array(logCapacity), std::memory_order_relaxed);
+            }
+            ~WorkStealingDeque() {
+                delete this->array.load(std::memory_order_relaxed);
+                for (Array * a : this->garbage)
+                    delete a;
+            }
+
+            // owner only
+            void push(T value) {
+                int64_t b = this->bottom.load(std::memory_order_relaxed);
+                int64_t t = this->top.load(std::memory_order_acquire);
+                Array * a = this->array.load(std::memory_order_relaxed);
+                if (b - t > a->capacity() - 1)
+                    a = this->grow(a, b, t);
+                a->put(b, value);
+                this->bottom.store(b + 1, std::memory_order_release);
+            }
+
+            // owner only, takes the most recently pushed element
+            bool pop(T & v) {
+                int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+                Array * a = this->array.load(std::memory_order_relaxed);
+                this->bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                int64_t t = this->top.load(std::memory_order_relaxed);
+                if (t > b) {  // empty
+                    this->bottom.store(b + 1, std::memory_order_relaxed);
+                    return false;
+                }
+                v = a->get(b);
+                if (t == b) {  // last element, race against the thieves
+                    bool won = this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    this->bottom.store(b + 1, std::memory_order_relaxed);
+                    return won;
+                }
+                return true;
+            }
+
+            // any thread, takes the oldest element
+            // may fail spuriously if another thread stole at the same time
+            bool steal(T & v) {
+                int64_t t = this->top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                int64_t b = this->bottom.load(std::memory_order_acquire);
+                if (t >= b)
+                    return false;
+                Array * a = this->array.load(std::memory_order_acquire);
+                T x = a->get(t);
+                if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return false;
+                v = x;
+                return true;
+            }
+
+            // approximate, exact only when called by the owner with no concurrent thieves
+            int64_t size() const {
+                int64_t n = this->bottom.load(std::memory_order_relaxed) - this->top.load(std::memory_order_relaxed);
+                return n > 0 ? n : 0;
+            }
+
+            bool empty() const {
+                return this->bottom.load(std::memory_order_relaxed) <= this->top.load(std::memory_order_relaxed);
+            }
+
+        private:
+            class Array {
+            public:
+                explicit Array(int logCapacity) : mask((int64_t(1) << logCapacity) - 1), logSize(logCapacity),
+                    buffer(new std::atomic<T>[size_t(1) << logCapacity]) { }
+                ~Array() { delete[] this->buffer; }
+                int64_t capacity() const { return this->mask + 1; }
+                T get(int64_t i) const { return this->buffer[i & this->mask].load(std::memory_order_relaxed); }
+                void put(int64_t i, T v) { this->buffer[i & this->mask].store(v, std::memory_order_relaxed); }
+                const int64_t mask;
+                const int logSize;
+            private:
+                std::atomic<T> * buffer;
+            };
+
+            // the old array is kept alive until destruction, thieves may still read from it
+            Array * grow(Array * a, int64_t b, int64_t t) {
+                Array * bigger = new Array(a->logSize + 1);
+                for (int64_t i = t; i < b; ++i)
+                    bigger->put(i, a->get(i));
+                this->garbage.push_back(a);
+                this->array.store(bigger, std::memory_order_release);
+                return bigger;
+            }
+
+            // top and bottom on separate cache lines, thieves only write top
+            std::atomic<int64_t> top;
+            char pad[64];
+            std::atomic<int64_t> bottom;
+            std::atomic<Array *> array;
+            std::vector<Array *> garbage;
+        };
+
+        // bounded multi-producer / multi-consumer ring with a sequence number per cell,
+        // see Vyukov, "Bounded MPMC queue", 1024cores.net
+        template <typename T>
+        class BoundedQueue {
+        public:
+            explicit BoundedQueue(size_t capacity) : mask(capacity - 1), cells(new Cell[capacity]), enqueuePos(0), dequeuePos(0) {
+                for (size_t i = 0; i < capacity; ++i)
+                    this->cells[i].seq.store(i, std::memory_order_relaxed);
+            }
+            ~BoundedQueue() { delete[] this->cells; }
+
+            size_t capacity() const { return this->mask + 1; }
+
+            // returns false if full
+            bool push(T const & value) {
+                size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+                while (true) {
+                    Cell & c = this->cells[pos & this->mask];
+                    size_t seq = c.seq.load(std::memory_order_acquire);
+                    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                    if (dif == 0) {
+                        if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            c.data = value;
+                            c.seq.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (dif < 0)
+                        return false;
+                    else
+                        pos = this->enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            // returns false if empty, or if the oldest element is still being written
+            bool pop(T & v) {
+                size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+                while (true) {
+                    Cell & c = this->cells[pos & this->mask];
+                    size_t seq = c.seq.load(std::memory_order_acquire);
+                    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                    if (dif == 0) {
+                        if (this->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            v = c.data;
+                            c.seq.store(pos + this->mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (dif < 0)
+                        return false;
+                    else
+                        pos = this->dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+        private:
+            BoundedQueue(const BoundedQueue &);// = delete;
+            BoundedQueue & operator=(const BoundedQueue &);// = delete;
+
+            struct Cell {
+                std::atomic<size_t> seq;
+                T data;
+            };
+
+            const size_t mask;
+            Cell * const cells;
+            char pad0[64];
+            std::atomic<size_t> enqueuePos;
+            char pad1[64];
+            std::atomic<size_t> dequeuePos;
+            char pad2[64];
+        };
+
+        // unbounded multi-producer / multi-consumer queue made of bounded segments
+        // a full queue gets a new segment of twice the size of the last one, segments are
+        // kept until destruction, so the memory is bounded by the peak number of elements.
+        // elements are taken from the oldest segment first, the order between segments is not strictly FIFO
+        template <typename T>
+        class SegmentedQueue {
+        public:
+            explicit SegmentedQueue(size_t capacity = _ctplThreadPoolLength_) : nSegments(0), count(0), highWater(0) {
+                size_t c = 2;
+                while (c < capacity)
+                    c <<= 1;
+                this->segments[0] = new BoundedQueue<T>(c);
+                this->nSegments.store(1, std::memory_order_release);
+            }
+            ~SegmentedQueue() {
+                for (int k = 0, n = this->nSegments.load(std::memory_order_relaxed); k < n; ++k)
+                    delete this->segments[k];
+            }
+
+            bool push(T const & value) {
+                while (true) {
+                    int n = this->nSegments.load(std::memory_order_acquire);
+                    for (int k = 0; k < n; ++k) {
+                        if (this->segments[k]->push(value)) {
+                            int64_t s = this->count.fetch_add(1, std::memory_order_relaxed) + 1;
+                            int64_t hw = this->highWater.load(std::memory_order_relaxed);
+                            while (s > hw && !this->highWater.compare_exchange_weak(hw, s, std::memory_order_relaxed))
+                                ;
+                            return true;
+                        }
+                    }
+                    this->grow(n);
+                }
+            }
+
+            bool pop(T & v) {
+                int n = this->nSegments.load(std::memory_order_acquire);
+                for (int k = 0; k < n; ++k) {
+                    if (this->segments[k]->pop(v)) {
+                        this->count.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool empty() const { return this->count.load(std::memory_order_relaxed) <= 0; }
+
+            // the counters are approximate while other threads push or pop
+            int64_t size() const { return this->count.load(std::memory_order_relaxed); }
+            int64_t high_water() const { return this->highWater.load(std::memory_order_relaxed); }
+            void reset_high_water() { this->highWater.store(this->size(), std::memory_order_relaxed); }
+            int segment_count() const { return this->nSegments.load(std::memory_order_acquire); }
+            size_t capacity() const {
+                size_t c = 0;
+                for (int k = 0, n = this->segment_count(); k < n; ++k)
+                    c += this->segments[k]->capacity();
+                return c;
+            }
+
+        private:
+            SegmentedQueue(const SegmentedQueue &);// = delete;
+            SegmentedQueue & operator=(const SegmentedQueue &);// = delete;
+
+            enum { maxSegments = 48 };
+
+            // n is the number of segments the caller found full
+            void grow(int n) {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                if (this->nSegments.load(std::memory_order_relaxed) != n)
+                    return;  // another thread was faster
+                if (n == maxSegments) {
+                    lock.unlock();
+                    std::this_thread::yield();  // wait for the consumers
+                    return;
+                }
+                this->segments[n] = new BoundedQueue<T>(2 * this->segments[n - 1]->capacity());
+                this->nSegments.store(n + 1, std::memory_order_release);
+            }
+
+            BoundedQueue<T> * segments[maxSegments];  // published by nSegments
+            std::atomic<int> nSegments;
+            std::atomic<int64_t> count;
+            std::atomic<int64_t> highWater;
+            std::mutex mutex;  // only taken to add a segment
+        };
+
+        // size classes of the slab allocator, 64 to 1024 bytes
+        enum { slabClasses = 5, slabMinLog = 6, slabBatch = 32, slabBlocksPerChunk = 64 };
+
+        inline int slab_class(size_t bytes) {
+            int c = 0;
+            while (c < slabClasses && (size_t(1) << (slabMinLog + c)) < bytes)
+                ++c;
+            return c;  // slabClasses if too big
+        }
+
+        // process wide free lists, memory is never returned to the system
+        class SlabDepot {
+        public:
+            SlabDepot() : head(nullptr) { }
+            static SlabDepot & get(int c) {
+                static SlabDepot * depots = new SlabDepot[slabClasses];  // intentionally not destroyed, threads may exit after main
+                return depots[c];
+            }
+            // moves up to slabBatch blocks to out, allocates a new chunk if the list is empty
+            int take(int c, void ** out) {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                if (!this->head) {
+                    size_t blockSize = size_t(1) << (slabMinLog + c);
+                    char * chunk = static_cast<char *>(::operator new(blockSize * slabBlocksPerChunk));
+                    for (int k = 0; k < slabBlocksPerChunk; ++k)
+                        this->release_locked(chunk + k * blockSize);
+                }
+                int n = 0;
+                while (n < slabBatch && this->head) {
+                    out[n++] = this->head;
+                    this->head = *static_cast<void **>(this->head);
+                }
+                return n;
+            }
+            void give(void ** blocks, int n) {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                for (int k = 0; k < n; ++k)
+                    this->release_locked(blocks[k]);
+            }
+        private:
+            void release_locked(void * block) {
+                *static_cast<void **>(block) = this->head;
+                this->head = block;
+            }
+            void * head;  // intrusive list through the first word of the free blocks
+            std::mutex mutex;
+        };
+
+        // per-thread cache in front of the depots, exchanges blocks in batches
+        class SlabCache {
+        public:
+            SlabCache() { for (int c = 0; c < slabClasses; ++c) this->n[c] = 0; }
+            ~SlabCache() {
+                for (int c = 0; c < slabClasses; ++c)
+                    SlabDepot::get(c).give(this->blocks[c], this->n[c]);
+            }
+            void * allocate(int c) {
+                if (this->n[c] == 0)
+                    this->n[c] = SlabDepot::get(c).take(c, this->blocks[c]);
+                return this->blocks[c][--this->n[c]];
+            }
+            void deallocate(int c, void * block) {
+                if (this->n[c] == 2 * slabBatch) {
+                    this->n[c] -= slabBatch;
+                    SlabDepot::get(c).give(this->blocks[c] + this->n[c], slabBatch);
+                }
+                this->blocks[c][this->n[c]++] = block;
+            }
+        private:
+            void * blocks[slabClasses][2 * slabBatch];
+            int n[slabClasses];
+        };
+
+        inline SlabCache & slab_cache() {
+            static thread_local SlabCache cache;
+            return cache;
+        }
+
+        inline void * slab_allocate(size_t bytes) {
+            int c = slab_class(bytes);
+            if (c == slabClasses)
+                return ::operator new(bytes);
+            return slab_cache().allocate(c);
+        }
+
+        // bytes must be the size given to slab_allocate
+        inline void slab_deallocate(void * p, size_t bytes) {
+            int c = slab_class(bytes);
+            if (c == slabClasses)
+                ::operator delete(p);
+            else
+                slab_cache().deallocate(c, p);
+        }
+
+        // stateless allocator on top of the slabs, e.g. for the shared states of std::promise
+        template <typename T>
+        class slab_allocator {
+        public:
+            typedef T value_type;
+            slab_allocator() { }
+            template <typename U> slab_allocator(const slab_allocator<U> &) { }
+            T * allocate(size_t n) { return static_cast<T *>(slab_allocate(n * sizeof(T))); }
+            void deallocate(T * p, size_t n) { slab_deallocate(p, n * sizeof(T)); }
+            template <typename U> struct rebind { typedef slab_allocator<U> other; };
+            template <typename U> bool operator==(const slab_allocator<U> &) const { return true; }
+            template <typename U> bool operator!=(const slab_allocator<U> &) const { return false; }
+        };
+
+        // move-only void(int id) function with _ctplTaskInlineSize_ bytes of inline storage,
+        // larger functors are kept in a slab block
+        class task {
+        public:
+            task() : ops(nullptr) { }
+
+            template <typename F, typename Fn = typename std::decay<F>::type,
+                      typename = typename std::enable_if<!std::is_same<Fn, task>::value>::type>
+            task(F && f) {
+                static_assert(alignof(Fn) <= alignof(std::max_align_t), "over-aligned functors are not supported");
+                this->construct<Fn>(std::forward<F>(f), std::integral_constant<bool,
+                    sizeof(Fn) <= _ctplTaskInlineSize_ && std::is_nothrow_move_constructible<Fn>::value>());
+            }
+
+            task(task && other) : ops(other.ops) {
+                if (this->ops) {
+                    this->ops->move(this->buffer, other.buffer);
+                    other.ops = nullptr;
+                }
+            }
+
+            task & operator=(task && other) {
+                if (this != &other) {
+                    this->reset();
+                    this->ops = other.ops;
+                    if (this->ops) {
+                        this->ops->move(this->buffer, other.buffer);
+                        other.ops = nullptr;
+                    }
+                }
+                return *this;
+            }
+
+            ~task() { this->reset(); }
+
+            void operator()(int id) { this->ops->invoke(this->buffer, id); }
+            explicit operator bool() const { return this->ops != nullptr; }
+
+            void reset() {
+                if (this->ops) {
+                    this->ops->destroy(this->buffer);
+                    this->ops = nullptr;
+                }
+            }
+
+        private:
+            task(const task &);// = delete;
+            task & operator=(const task &);// = delete;
+
+            template <typename Fn, typename F>
+            void construct(F && f, std::true_type /* inline */) {
+                new (this->buffer) Fn(std::forward<F>(f));
+                this->ops = &inline_ops<Fn>::ops;
+            }
+
+            template <typename Fn, typename F>
+            void construct(F && f, std::false_type /* slab */) {
+                void * p = slab_allocate(sizeof(Fn));
+                try {
+                    new (p) Fn(std::forward<F>(f));
+                }
+                catch (...) {
+                    slab_deallocate(p, sizeof(Fn));
+                    throw;
+                }
+                *reinterpret_cast<void **>(this->buffer) = p;
+                this->ops = &slab_ops<Fn>::ops;
+            }
+
+            struct Ops {
+                void (*invoke)(void * buffer, int id);
+                void (*move)(void * dst, void * src);  // also destroys src
+                void (*destroy)(void * buffer);
+            };
+
+            template <typename Fn>
+            struct inline_ops {
+                static void invoke(void * b, int id) { (*static_cast<Fn *>(b))(id); }
+                static void move(void * dst, void * src) {
+                    new (dst) Fn(std::move(*static_cast<Fn *>(src)));
+                    static_cast<Fn *>(src)->~Fn();
+                }
+                static void destroy(void * b) { static_cast<Fn *>(b)->~Fn(); }
+                static const Ops ops;
+            };
+
+            template <typename Fn>
+            struct slab_ops {
+                static Fn * get(void * b) { return *static_cast<Fn **>(b); }
+                static void invoke(void * b, int id) { (*get(b))(id); }
+                static void move(void * dst, void * src) { *static_cast<void **>(dst) = *static_cast<void **>(src); }
+                static void destroy(void * b) {
+                    Fn * f = get(b);
+                    f->~Fn();
+                    slab_deallocate(f, sizeof(Fn));
+                }
+                static const Ops ops;
+            };
+
+            const Ops * ops;
+            alignas(std::max_align_t) unsigned char buffer[_ctplTaskInlineSize_];
+
+#ifdef _ctplEnableStats_
+        public:
+            int64_t queued;  // steady clock time in ns when the task was created
+#endif
+        };
+
+        inline int64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        template <typename Fn>
+        const task::Ops task::inline_ops<Fn>::ops = { &task::inline_ops<Fn>::invoke, &task::inline_ops<Fn>::move, &task::inline_ops<Fn>::destroy };
+
+        template <typename Fn>
+        const task::Ops task::slab_ops<Fn>::ops = { &task::slab_ops<Fn>::invoke, &task::slab_ops<Fn>::move, &task::slab_ops<Fn>::destroy };
+
+        // queued tasks live in slab blocks, the queues only hold the pointers
+        template <typename F>
+        task * new_task(F && f) {
+            void * p = slab_allocate(sizeof(task));
+            try {
+                task * t = new (p) task(std::forward<F>(f));
+#ifdef _ctplEnableStats_
+                t->queued = now_ns();
+#endif
+                return t;
+            }
+            catch (...) {
+                slab_deallocate(p, sizeof(task));
+                throw;
+            }
+        }
+
+        inline void delete_task(task * t) {
+            t->~task();
+            slab_deallocate(t, sizeof(task));
+        }
+
+        // deletes a task at the end of the scope, even if it threw
+        struct TaskGuard {
+            explicit TaskGuard(task * t) : t(t) { }
+            ~TaskGuard() { delete_task(this->t); }
+            task * t;
+        };
+
+        // runs the functor and fulfils the promise, replaces the std::packaged_task of ctpl::thread_pool
+        // because its shared state can be allocated with the slab allocator
+        template <typename R, typename Fn>
+        struct PromiseCall {
+            PromiseCall(std::promise<R> && p, Fn && f) : p(std::move(p)), f(std::move(f)) { }
+            PromiseCall(PromiseCall && other) : p(std::move(other.p)), f(std::move(other.f)) { }
+            void operator()(int id) {
+                try {
+                    this->p.set_value(this->f(id));
+                }
+                catch (...) {
+                    this->p.set_exception(std::current_exception());
+                }
+            }
+            std::promise<R> p;
+            Fn f;
+        };
+
+        template <typename Fn>
+        struct PromiseCall<void, Fn> {
+            PromiseCall(std::promise<void> && p, Fn && f) : p(std::move(p)), f(std::move(f)) { }
+            PromiseCall(PromiseCall && other) : p(std::move(other.p)), f(std::move(other.f)) { }
+            void operator()(int id) {
+                try {
+                    this->f(id);
+                    this->p.set_value();
+                }
+                catch (...) {
+                    this->p.set_exception(std::current_exception());
+                }
+            }
+            std::promise<void> p;
+            Fn f;
+        };
+
+        // one chunk of ws_thread_pool::push_bulk
+        template <typename Index, typename Body>
+        struct BulkChunk {
+            void operator()(int id) {
+                try {
+                    for (Index i = this->lo; i < this->hi; ++i)
+                        (*this->body)(id, i);
+                }
+                catch (...) {
+                    this->l->set_exception(std::current_exception());
+                }
+                this->l->count_down();
+            }
+            std::shared_ptr<latch> l;
+            Body * body;  // owned by the latch
+            Index lo;
+            Index hi;
+        };
+
+        // hint to the cpu that this is a spin-wait loop
+        inline void cpu_relax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_pause();
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            __builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+            __asm__ __volatile__("yield");
+#endif
+        }
+
+        // cpus of every NUMA node, read from /sys/devices/system/node on linux and from the
+        // processor groups on windows. one node with all cpus if there is no information
+        inline std::vector<std::vector<int>> numa_nodes() {
+            std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+            for (int node = 0; ; ++node) {
+                std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                if (!file)
+                    break;
+                std::string list;
+                std::getline(file, list);
+                std::vector<int> cpus;
+                std::stringstream ranges(list);
+                std::string range;
+                while (std::getline(ranges, range, ',')) {  // e.g. 0-3,8-11
+                    if (range.empty())
+                        continue;
+                    size_t dash = range.find('-');
+                    int first = std::atoi(range.substr(0, dash).c_str());
+                    int last = dash == std::string::npos ? first : std::atoi(range.substr(dash + 1).c_str());
+                    for (int cpu = first; cpu <= last; ++cpu)
+                        cpus.push_back(cpu);
+                }
+                if (!cpus.empty())
+                    nodes.push_back(cpus);
+            }
+#elif defined(_WIN32)
+            ULONG highest = 0;
+            if (GetNumaHighestNodeNumber(&highest)) {
+                for (USHORT node = 0; node <= highest; ++node) {
+                    ULONGLONG mask = 0;
+                    if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask) || mask == 0)
+                        continue;
+                    std::vector<int> cpus;
+                    for (int cpu = 0; cpu < 64; ++cpu)
+                        if (mask & (ULONGLONG(1) << cpu))
+                            cpus.push_back(cpu);
+                    nodes.push_back(cpus);
+                }
+            }
+#endif
+            if (nodes.empty()) {
+                std::vector<int> cpus;
+                for (int cpu = 0, n = static_cast<int>(std::thread::hardware_concurrency()); cpu < n; ++cpu)
+                    cpus.push_back(cpu);
+                nodes.push_back(cpus);
+            }
+            return nodes;
+        }
+
+        // restrict a thread to a set of cpus, returns false if not supported on this platform
+        inline bool set_thread_affinity(std::thread & t, const std::vector<int> & cpus) {
+            if (cpus.empty())
+                return false;
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                    CPU_SET(cpu, &set);
+            }
+            return pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+            DWORD_PTR mask = 0;
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < static_cast<int>(8 * sizeof(DWORD_PTR)))
+                    mask |= DWORD_PTR(1) << cpu;
+            }
+            return mask != 0 && SetThreadAffinityMask(static_cast<HANDLE>(t.native_handle()), mask) != 0;
+#else
+            (void)t;
+            return false;
+#endif
+        }
+
+        // identifies the pool and worker index of the calling thread
+        struct WorkerSlot {
+            const void * pool;
+            int id;
+            uint32_t seed;  // victim selection
+        };
+
+        inline WorkerSlot & current_worker() {
+            static thread_local WorkerSlot slot = { nullptr, -1, 0 };
+            return slot;
+        }
+    }
+
+    class ws_thread_pool {
+
+    public:
+
+        ws_thread_pool() : q(_ctplThreadPoolLength_) { this->init(static_cast<int>(std::thread::hardware_concurrency())); }
+        ws_thread_pool(int nThreads, size_t queueSize = _ctplThreadPoolLength_) : q(queueSize) { this->init(nThreads); }
+
+        // the destructor waits for all the functions in the queues to be finished
+        ~ws_thread_pool() {
+            this->stop(true);
+        }
+
+        // get the number of running threads in the pool
+        int size() { return static_cast<int>(this->threads.size()); }
+
+        // number of idle threads
+        int n_idle() { return this->nWaiting + this->nSpinning; }
+        std::thread & get_thread(int i) { return *this->threads[i]; }
+
+        // number of NUMA nodes the workers are grouped by, and the node of a worker
+        // worker i belongs to node i * n_nodes() / size(), so each node gets a contiguous block of workers
+        int n_nodes() const { return static_cast<int>(this->nodes.size()); }
+        int node_of(int id) const { return this->workers[id]->node; }
+
+        // scratch memory of worker id for the functor running on it, rewound when the functor returns,
+        // also when the worker runs it while waiting inside another functor, see ctpl_scratch.h
+        scratch_arena & scratch(int id) { return this->workers[id]->scratch; }
+
+        // pin worker i to cpus[i % cpus.size()], returns false if pinning is not supported or failed
+        bool set_affinity(const std::vector<int> & cpus) {
+            if (cpus.empty())
+                return false;
+            bool ok = true;
+            for (int i = 0; i < static_cast<int>(this->threads.size()); ++i)
+                ok = detail::set_thread_affinity(*this->threads[i], std::vector<int>(1, cpus[i % cpus.size()])) && ok;
+            return ok;
+        }
+
+        // pin every worker to the cpus of its NUMA node, memory first touched by a functor then stays on that node
+        bool set_numa_affinity() {
+            bool ok = true;
+            for (int i = 0; i < static_cast<int>(this->threads.size()); ++i)
+                ok = detail::set_thread_affinity(*this->threads[i], this->nodes[this->workers[i]->node].cpus) && ok;
+            return ok;
+        }
+
+        // how long a worker without work stays awake: spinCount rounds of a cpu pause, then
+        // yieldCount rounds of std::this_thread::yield(), then it parks until the next push
+        // 0, 0 parks immediately like ctpl::thread_pool, which costs a futex wake-up for the next push
+        void set_idle_strategy(int spinCount, int yieldCount) {
+            this->spinCount = spinCount < 0 ? 0 : spinCount;
+            this->yieldCount = yieldCount < 0 ? 0 : yieldCount;
+        }
+
+        // number of functors taken in a row from the highest busy priority lane before a lower lane
+        // or the ordinary queues get one turn, 0 serves the lanes strictly by priority
+        void set_priority_burst(int n) { this->priorityBurst = n < 0 ? 0 : n; }
+
+        int n_priority_lanes() const { return _ctplPriorityLanes_; }
+
+        // while at least one session is open the idle workers keep spinning and yielding instead of
+        // parking, e.g. for the duration of a simulation with short macro steps
+        void begin_hot_session() { ++this->hotSessions; }
+        void end_hot_session() { --this->hotSessions; }
+
+        // scope of begin_hot_session() / end_hot_session()
+        class hot_session {
+        public:
+            explicit hot_session(ws_thread_pool & pool) : pool(pool) { this->pool.begin_hot_session(); }
+            ~hot_session() { this->pool.end_hot_session(); }
+        private:
+            hot_session(const hot_session &);// = delete;
+            hot_session & operator=(const hot_session &);// = delete;
+            ws_thread_pool & pool;
+        };
+
+        // state of the injection queue, high_water tells how large queueSize should be to never add segments
+        struct queue_stats {
+            int64_t size;
+            int64_t high_water;
+            size_t capacity;
+            int segments;
+        };
+
+        queue_stats get_queue_stats() const {
+            queue_stats stats;
+            stats.size = this->q.size();
+            stats.high_water = this->q.high_water();
+            stats.capacity = this->q.capacity();
+            stats.segments = this->q.segment_count();
+            return stats;
+        }
+
+        void reset_queue_high_water() { this->q.reset_high_water(); }
+
+        // counters since construction, all zero unless _ctplEnableStats_ is defined
+        // wait_histogram[k] counts the tasks that waited between 2^k and 2^(k+1) ns from push to start
+        struct stats {
+            bool enabled;
+            uint64_t submitted;
+            uint64_t completed;
+            uint64_t steals;
+            int64_t max_queue_depth;  // injection queue
+            int64_t max_deque_depth;  // largest worker deque
+            std::vector<double> busy_time;  // seconds spent running tasks, per worker
+            std::vector<uint64_t> wait_histogram;
+        };
+
+        stats get_stats() const {
+            stats st;
+            st.submitted = st.completed = st.steals = 0;
+            st.max_queue_depth = st.max_deque_depth = 0;
+            st.busy_time.assign(this->workers.size(), 0.0);
+            st.wait_histogram.assign(waitBuckets, 0);
+#ifdef _ctplEnableStats_
+            st.enabled = true;
+            st.submitted = this->submitted.load(std::memory_order_relaxed);
+            st.max_queue_depth = this->q.high_water();
+            for (size_t i = 0; i < this->workers.size(); ++i) {
+                const Worker & w = *this->workers[i];
+                st.completed += w.completed.load(std::memory_order_relaxed);
+                st.steals += w.steals.load(std::memory_order_relaxed);
+                st.max_deque_depth = std::max(st.max_deque_depth, w.maxDequeDepth.load(std::memory_order_relaxed));
+                st.busy_time[i] = 1e-9 * static_cast<double>(w.busyTime.load(std::memory_order_relaxed));
+                for (int k = 0; k < waitBuckets; ++k)
+                    st.wait_histogram[k] += w.waitHistogram[k].load(std::memory_order_relaxed);
+            }
+#else
+            st.enabled = false;
+#endif
+            return st;
+        }
+
+        // index of the calling thread if it is a worker of this pool, otherwise -1
+        int current_id() const {
+            const detail::WorkerSlot & slot = detail::current_worker();
+            return slot.pool == this ? slot.id : -1;
+        }
+
+        // empty the queues, must not be called while the workers are running
+        void clear_queue() {
+            detail::task * _f;
+            while (this->q.pop(_f))
+                detail::delete_task(_f);
+            for (auto & w : this->workers) {
+                while (w->deque.pop(_f))
+                    detail::delete_task(_f);
+                while (w->inbox.pop(_f))
+                    detail::delete_task(_f);
+            }
+            for (auto & n : this->nodes) {
+                while (n.queue->pop(_f))
+                    detail::delete_task(_f);
+            }
+            while (this->pop_lanes(0, _f))
+                detail::delete_task(_f);
+        }
+
+        // wait for all computing threads to finish and stop all threads
+        // may be called asynchronously to not pause the calling thread while waiting
+        // if isWait == true, all the functions in the queues are run, otherwise the queues are cleared without running the functions
+        void stop(bool isWait = false) {
+            if (!isWait) {
+                if (this->isStop)
+                    return;
+                this->isStop = true;
+            }
+            else {
+                if (this->isDone || this->isStop)
+                    return;
+                this->isDone = true;  // give the waiting threads a command to finish
+            }
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                for (auto & w : this->workers)
+                    w->cv.notify_one();  // stop all waiting threads
+            }
+            for (int i = 0; i < static_cast<int>(this->threads.size()); ++i) {  // wait for the computing threads to finish
+                if (this->threads[i]->joinable())
+                    this->threads[i]->join();
+            }
+            // the remaining functors are not run by anyone, delete them here
+            this->clear_queue();
+            this->threads.clear();
+        }
+
+        template<typename F, typename... Rest>
+        auto push(F && f, Rest&&... rest) ->std::future<decltype(f(0, rest...))> {
+            return this->push(std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...));
+        }
+
+        // run the user's function that excepts argument int - id of the running thread. returned value is templatized
+        // operator returns std::future, where the user can get the result and rethrow the catched exceptins
+        // called from a worker of this pool the function is pushed to that worker's own deque
+        template<typename F>
+        auto push(F && f) ->std::future<decltype(f(0))> {
+            typedef decltype(f(0)) R;
+            typedef typename std::decay<F>::type Fn;
+            std::promise<R> p(std::allocator_arg, detail::slab_allocator<char>());
+            std::future<R> future = p.get_future();
+            this->enqueue(detail::new_task(detail::PromiseCall<R, Fn>(std::move(p), Fn(std::forward<F>(f)))));
+            return future;
+        }
+
+        // run the functor on worker key % size(), e.g. with the index of an FMU as key so that all
+        // of its steps run on the same thread. the functor is never stolen, it waits if that worker is busy
+        template<typename F, typename... Rest>
+        auto push_to(int key, F && f, Rest&&... rest) ->std::future<decltype(f(0, rest...))> {
+            return this->push_to(key, std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...));
+        }
+
+        template<typename F>
+        auto push_to(int key, F && f) ->std::future<decltype(f(0))> {
+            typedef decltype(f(0)) R;
+            typedef typename std::decay<F>::type Fn;
+            std::promise<R> p(std::allocator_arg, detail::slab_allocator<char>());
+            std::future<R> future = p.get_future();
+            this->post_to(key, detail::PromiseCall<R, Fn>(std::move(p), Fn(std::forward<F>(f))));
+            return future;
+        }
+
+        // run the functor on any worker of NUMA node key % n_nodes()
+        template<typename F, typename... Rest>
+        auto push_to_node(int key, F && f, Rest&&... rest) ->std::future<decltype(f(0, rest...))> {
+            return this->push_to_node(key, std::bind(std::forward<F>(f), std::placeholders::_1, std::forward<Rest>(rest)...));
+        }
+
+        template<typename F>
+        auto push_to_node(int key, F && f) ->std::future<decltype(f(0))> {
+            typedef decltype(f(0)) R;
+            typedef typename std::decay<F>::type Fn;
+            std::promise<R> p(std::allocator_arg, detail::slab_allocator<char>());
+            std::future<R> future = p.get_future();
+            int node = static_cast<int>(static_cast<unsigned>(key) % this->nodes.size());
+            this->count_submitted(1);
+            this->nodes[node].queue->push(detail::new_task(detail::PromiseCall<R, Fn>(std::move(p), Fn(std::forward<F>(f)))));
+            this->wake_node(node);
+            return future;
+        }
+
+        // run the functor before the ordinary ones, lane 0 is served first, lanes outside
+        // [0, n_priority_lanes()) are clamped. functors of a lane run in FIFO order after those with a deadline
+        template<typename F>
+        auto push_priority(int lane, F && f) ->std::future<decltype(f(0))> {
+            return this->push_deadline(lane, std::chrono::steady_clock::time_point::max(), std::forward<F>(f));
+        }
+
+        // push_priority() with earliest-deadline-first order within the lane
+        // a missed deadline does not drop the functor, it only stays first in its lane
+        template<typename F>
+        auto push_deadline(int lane, std::chrono::steady_clock::time_point deadline, F && f) ->std::future<decltype(f(0))> {
+            typedef decltype(f(0)) R;
+            typedef typename std::decay<F>::type Fn;
+            std::promise<R> p(std::allocator_arg, detail::slab_allocator<char>());
+            std::future<R> future = p.get_future();
+            this->push_lane(lane, deadline, detail::new_task(detail::PromiseCall<R, Fn>(std::move(p), Fn(std::forward<F>(f)))));
+            return future;
+        }
+
+        // post() to a priority lane, see push_deadline()
+        template<typename F>
+        void post_priority(int lane, F && f, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+            this->push_lane(lane, deadline, detail::new_task(std::forward<F>(f)));
+        }
+
+        // queue a functor with signature void func(int id) without creating a future
+        // f must not throw, an exception leaving f terminates the worker thread
+        template<typename F>
+        void post(F && f) {
+            this->enqueue(detail::new_task(std::forward<F>(f)));
+        }
+
+        // post() for worker key % size(), see push_to()
+        template<typename F>
+        void post_to(int key, F && f) {
+            int id = static_cast<int>(static_cast<unsigned>(key) % this->workers.size());
+            this->count_submitted(1);
+            this->workers[id]->inbox.push(detail::new_task(std::forward<F>(f)));
+            this->wake_worker(id);
+        }
+
+        // run fn(id, i) for every i in [begin, end) with one queued functor per chunk of grain indices
+        // no futures are created, the returned latch reaches zero when all chunks are finished
+        // grain <= 0 picks a chunk size giving about four chunks per thread
+        template<typename Index, typename F>
+        std::shared_ptr<latch> push_bulk(Index begin, Index end, Index grain, F && fn) {
+            typedef typename std::decay<F>::type Body;
+            std::shared_ptr<latch> l = std::allocate_shared<latch>(detail::slab_allocator<latch>());
+            if (!(begin < end))
+                return l;
+            Index n = end - begin;
+            if (grain <= 0) {
+                Index nChunks = static_cast<Index>(4 * this->size());
+                grain = (n + nChunks - 1) / nChunks;
+                if (grain <= 0)
+                    grain = 1;
+            }
+            Index nChunks = (n + grain - 1) / grain;
+            l->add(static_cast<int64_t>(nChunks));
+            Body * body = new (detail::slab_allocate(sizeof(Body))) Body(std::forward<F>(fn));
+            l->data = body;
+            l->deleter = [](void * b) {
+                static_cast<Body *>(b)->~Body();
+                detail::slab_deallocate(b, sizeof(Body));
+            };
+            int id = this->current_id();
+            for (Index c = 0; c < nChunks; ++c) {
+                detail::BulkChunk<Index, Body> chunk;
+                chunk.l = l;
+                chunk.body = body;
+                chunk.lo = begin + c * grain;
+                chunk.hi = (end - chunk.lo > grain) ? chunk.lo + grain : end;
+                this->push_task(id, detail::new_task(std::move(chunk)));
+            }
+            this->count_submitted(static_cast<size_t>(nChunks));
+            this->wake(static_cast<size_t>(nChunks));
+            return l;
+        }
+
+        // push_bulk and wait for all chunks, rethrows the first exception of fn
+        // called from a worker of this pool, the worker runs other functors while waiting
+        template<typename Index, typename F>
+        void parallel_for(Index begin, Index end, Index grain, F && fn) {
+            std::shared_ptr<latch> l = this->push_bulk(begin, end, grain, std::forward<F>(fn));
+            this->wait(*l);
+        }
+
+        // wait for the latch, helping with the queued functors if called from a worker of this pool
+        // avoids the deadlock of nested waits when all workers are blocked
+        void wait(latch & l) {
+            int id = this->current_id();
+            if (id >= 0) {
+                detail::task * _f;
+                while (!l.try_wait()) {
+                    if (this->next(id, detail::current_worker().seed, _f))
+                        this->run_task(id, _f);
+                    else
+                        std::this_thread::yield();
+                }
+            }
+            l.wait();
+        }
+
+
+    private:
+
+        enum { waitBuckets = 40 };
+
+        struct Worker {
+            Worker() : inbox(16), parked(false), node(0), laneStreak(0), agingTurn(0) {
+#ifdef _ctplEnableStats_
+                this->completed = 0; this->steals = 0; this->busyTime = 0; this->maxDequeDepth = 0;
+                for (int k = 0; k < waitBuckets; ++k)
+                    this->waitHistogram[k] = 0;
+#endif
+            }
+            detail::WorkStealingDeque<detail::task *> deque;
+            detail::SegmentedQueue<detail::task *> inbox;  // push_to(), only this worker pops
+            std::condition_variable cv;
+            bool parked;  // guarded by this->mutex
+            int node;
+            int laneStreak;  // functors taken in a row from the highest busy lane
+            int agingTurn;  // level below that lane to get the next turn
+            scratch_arena scratch;  // only used by the worker itself
+#ifdef _ctplEnableStats_
+            // only written by the worker itself
+            std::atomic<uint64_t> completed;
+            std::atomic<uint64_t> steals;
+            std::atomic<int64_t> busyTime;  // ns
+            std::atomic<int64_t> maxDequeDepth;
+            std::atomic<uint64_t> waitHistogram[waitBuckets];
+#endif
+        };
+
+        // at the end, delete the task even if an exception occurred
+        void run_task(int id, detail::task * _f) {
+            detail::TaskGuard guard(_f);
+#ifdef _ctplEnableStats_
+            Worker & w = *this->workers[id];
+            int64_t start = detail::now_ns();
+            int64_t waited = start - _f->queued;
+            int bucket = 0;
+            while (bucket < waitBuckets - 1 && (int64_t(2) << bucket) <= waited)
+                ++bucket;
+            w.waitHistogram[bucket].store(w.waitHistogram[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            struct Account {  // also when the task throws
+                Worker & w;
+                int64_t start;
+                ~Account() {
+                    this->w.busyTime.store(this->w.busyTime.load(std::memory_order_relaxed) + detail::now_ns() - this->start, std::memory_order_relaxed);
+                    this->w.completed.store(this->w.completed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                }
+            } account = { w, start };
+#endif
+            OMS_TRACE_SCOPE("ctpl", "ws_thread_pool task");
+            scratch_scope scope(this->workers[id]->scratch);
+            (*_f)(id);
+        }
+
+        void count_submitted(size_t n) {
+#ifdef _ctplEnableStats_
+            this->submitted.fetch_add(n, std::memory_order_relaxed);
+#else
+            (void)n;
+#endif
+        }
+
+        // functors of a priority lane, a heap ordered by deadline and then by push order
+        struct LaneEntry {
+            int64_t deadline;  // steady clock ns
+            uint64_t seq;
+            detail::task * f;
+            bool operator<(const LaneEntry & other) const {  // std::push_heap builds a max-heap
+                return this->deadline > other.deadline || (this->deadline == other.deadline && this->seq > other.seq);
+            }
+        };
+
+        struct Lane {
+            Lane() : seq(0), size(0) { }
+            std::mutex mutex;
+            std::vector<LaneEntry> heap;  // guarded by mutex
+            uint64_t seq;  // guarded by mutex
+            std::atomic<int64_t> size;
+        };
+
+        void push_lane(int lane, std::chrono::steady_clock::time_point deadline, detail::task * _f) {
+            lane = std::min(std::max(lane, 0), _ctplPriorityLanes_ - 1);
+            int64_t d = deadline == std::chrono::steady_clock::time_point::max() ? INT64_MAX :
+                std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+            Lane & l = this->lanes[lane];
+            this->count_submitted(1);
+            {
+                std::unique_lock<std::mutex> lock(l.mutex);
+                LaneEntry e = { d, l.seq++, _f };
+                l.heap.push_back(e);
+                std::push_heap(l.heap.begin(), l.heap.end());
+                l.size.fetch_add(1, std::memory_order_release);
+            }
+            this->nLaneTasks.fetch_add(1, std::memory_order_release);
+            this->wake(1);
+        }
+
+        bool pop_lane(int lane, detail::task * & _f) {
+            Lane & l = this->lanes[lane];
+            if (l.size.load(std::memory_order_acquire) <= 0)
+                return false;
+            std::unique_lock<std::mutex> lock(l.mutex);
+            if (l.heap.empty())
+                return false;
+            std::pop_heap(l.heap.begin(), l.heap.end());
+            _f = l.heap.back().f;
+            l.heap.pop_back();
+            l.size.fetch_sub(1, std::memory_order_relaxed);
+            this->nLaneTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // the first functor of the highest busy lane from first on
+        bool pop_lanes(int first, detail::task * & _f) {
+            for (int k = first; k < _ctplPriorityLanes_; ++k) {
+                if (this->pop_lane(k, _f))
+                    return true;
+            }
+            return false;
+        }
+
+        // false if the lanes are empty or the ordinary queues have their turn
+        bool next_prioritized(Worker & w, detail::task * & _f) {
+            int top = 0;
+            while (top < _ctplPriorityLanes_ && this->lanes[top].size.load(std::memory_order_acquire) <= 0)
+                ++top;
+            if (top == _ctplPriorityLanes_)
+                return false;
+            int burst = this->priorityBurst.load(std::memory_order_relaxed);
+            if (burst == 0 || w.laneStreak < burst) {
+                if (!this->pop_lanes(top, _f))
+                    return false;
+                ++w.laneStreak;
+                return true;
+            }
+            // starvation protection, the lanes below top and the ordinary queues take turns
+            w.laneStreak = 0;
+            int levels = _ctplPriorityLanes_ - top;
+            for (int k = 0; k < levels; ++k) {
+                int level = top + 1 + w.agingTurn++ % levels;
+                if (level == _ctplPriorityLanes_)
+                    return false;
+                if (this->pop_lane(level, _f))
+                    return true;
+            }
+            return false;
+        }
+
+        struct Node {
+            std::vector<int> cpus;
+            std::unique_ptr<detail::SegmentedQueue<detail::task *>> queue;  // push_to_node()
+        };
+
+        // deleted
+        ws_thread_pool(const ws_thread_pool &);// = delete;
+        ws_thread_pool(ws_thread_pool &&);// = delete;
+        ws_thread_pool & operator=(const ws_thread_pool &);// = delete;
+        ws_thread_pool & operator=(ws_thread_pool &&);// = delete;
+
+        void enqueue(detail::task * _f) {
+            this->count_submitted(1);
+            this->push_task(this->current_id(), _f);
+            this->wake(1);
+        }
+
+        // id is the worker pushing, or -1 from outside the pool
+        void push_task(int id, detail::task * _f) {
+            OMS_TRACE_INSTANT("ctpl", "ws_thread_pool::push");
+            if (id >= 0) {
+                Worker & w = *this->workers[id];
+                w.deque.push(_f);
+#ifdef _ctplEnableStats_
+                int64_t depth = w.deque.size();
+                if (depth > w.maxDequeDepth.load(std::memory_order_relaxed))
+                    w.maxDequeDepth.store(depth, std::memory_order_relaxed);
+#endif
+            }
+            else
+                this->q.push(_f);
+        }
+
+        // the caller holds this->mutex and the worker is parked
+        void notify_locked(Worker & w) {
+            w.parked = false;  // the next wake-up goes to another worker
+            w.cv.notify_one();
+        }
+
+        // wake up to n waiting workers after pushing n tasks
+        void wake(size_t n) {
+            // pairs with the fence in the worker after announcing that it waits:
+            // either the worker sees the new task or this thread sees the waiting worker
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int nWaiting = this->nWaiting.load(std::memory_order_relaxed);
+            if (nWaiting > 0) {
+                // spinning workers find the new tasks themselves, only wake up parked ones for the rest
+                // the workers recheck for work after announcing that they park, so none is missed
+                size_t nSpinning = static_cast<size_t>(this->nSpinning.load(std::memory_order_relaxed));
+                if (n <= nSpinning)
+                    return;
+                n -= nSpinning;
+                std::unique_lock<std::mutex> lock(this->mutex);
+                for (size_t k = 0; k < this->workers.size() && n > 0; ++k) {
+                    if (this->workers[k]->parked) {
+                        this->notify_locked(*this->workers[k]);
+                        --n;
+                    }
+                }
+            }
+        }
+
+        // after push_to(), only worker id can run the task
+        void wake_worker(int id) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->nWaiting.load(std::memory_order_relaxed) > 0) {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                if (this->workers[id]->parked)
+                    this->notify_locked(*this->workers[id]);
+            }
+        }
+
+        // after push_to_node(), one parked worker of the node if none of them is awake
+        void wake_node(int node) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->nWaiting.load(std::memory_order_relaxed) > 0) {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                for (auto & w : this->workers) {
+                    if (w->node == node && w->parked) {
+                        this->notify_locked(*w);
+                        break;
+                    }
+                }
+            }
+        }
+
+        // own deque first, then the functors queued for this worker and its node, then the injection queue,
+        // then the other workers starting at a random victim
+        bool next(int i, uint32_t & seed, detail::task * & _f) {
+            if (this->nLaneTasks.load(std::memory_order_acquire) > 0) {
+                if (this->next_prioritized(*this->workers[i], _f))
+                    return true;
+                if (this->next_ordinary(i, seed, _f))
+                    return true;
+                return this->pop_lanes(0, _f);
+            }
+            return this->next_ordinary(i, seed, _f);
+        }
+
+        bool next_ordinary(int i, uint32_t & seed, detail::task * & _f) {
+            Worker & w = *this->workers[i];
+            if (w.deque.pop(_f))
+                return true;
+            if (w.inbox.pop(_f))
+                return true;
+            if (this->nodes[w.node].queue->pop(_f))
+                return true;
+            if (this->q.pop(_f))
+                return true;
+            int n = static_cast<int>(this->workers.size());
+            if (n > 1) {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                int start = static_cast<int>(seed % static_cast<uint32_t>(n));
+                for (int k = 0; k < n; ++k) {
+                    int victim = (start + k) % n;
+                    if (victim != i && this->workers[victim]->deque.steal(_f)) {
+#ifdef _ctplEnableStats_
+                        w.steals.store(w.steals.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+#endif
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        void set_thread(int i) {
+            auto f = [this, i]() {
+                detail::WorkerSlot & slot = detail::current_worker();
+                slot.pool = this;
+                slot.id = i;
+                slot.seed = 2463534242u + 2654435761u * static_cast<uint32_t>(i + 1);
+                uint32_t & seed = slot.seed;
+                detail::task * _f;
+                bool isPop = this->next(i, seed, _f);
+                while (true) {
+                    while (isPop) {  // if there is anything to run
+                        this->run_task(i, _f);
+                        if (this->isStop)
+                            return;  // the thread is wanted to stop, return even if the queues are not empty yet
+                        else
+                            isPop = this->next(i, seed, _f);
+                    }
+                    // nothing to run or to steal here, stay awake for a while
+                    ++this->nSpinning;
+                    for (int k = 0; !isPop && !this->isDone && !this->isStop; ) {
+                        if (k < this->spinCount)
+                            detail::cpu_relax();
+                        else if (k < this->spinCount + this->yieldCount || this->hotSessions > 0)
+                            std::this_thread::yield();
+                        else
+                            break;
+                        if (k < this->spinCount + this->yieldCount)
+                            ++k;
+                        isPop = this->next(i, seed, _f);
+                    }
+                    --this->nSpinning;
+                    if (isPop)
+                        continue;
+                    // wait for the next command
+                    Worker & w = *this->workers[i];
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    ++this->nWaiting;
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    while (true) {
+                        isPop = this->next(i, seed, _f);
+                        if (isPop || this->isDone || this->isStop)
+                            break;
+                        w.parked = true;  // cleared by whoever notifies
+                        w.cv.wait(lock);
+                        w.parked = false;
+                    }
+                    --this->nWaiting;
+                    if (!isPop)
+                        return;  // if there is no work and this->isDone == true or this->isStop then return
+                }
+            };
+            this->threads[i].reset(new std::thread(f)); // compiler may not support std::make_unique()
+        }
+
+        void init(int nThreads) {
+            this->nWaiting = 0; this->isStop = false; this->isDone = false;
+            this->nSpinning = 0; this->hotSessions = 0;
+            this->nLaneTasks = 0; this->priorityBurst = _ctplPriorityBurst_;
+            this->spinCount = _ctplIdleSpinCount_; this->yieldCount = _ctplIdleYieldCount_;
+#ifdef _ctplEnableStats_
+            this->submitted = 0;
+#endif
+            if (nThreads < 1)
+                nThreads = 1;
+            // all queues exist before the first worker starts stealing
+            std::vector<std::vector<int>> numa = detail::numa_nodes();
+            int nNodes = std::min(static_cast<int>(numa.size()), nThreads);
+            this->nodes.resize(nNodes);
+            for (int k = 0; k < nNodes; ++k) {
+                this->nodes[k].cpus = numa[k];
+                this->nodes[k].queue.reset(new detail::SegmentedQueue<detail::task *>(16));
+            }
+            this->workers.resize(nThreads);
+            for (int i = 0; i < nThreads; ++i) {
+                this->workers[i].reset(new Worker());
+                this->workers[i]->node = static_cast<int>(static_cast<int64_t>(i) * nNodes / nThreads);
+            }
+            this->threads.resize(nThreads);
+            for (int i = 0; i < nThreads; ++i)
+                this->set_thread(i);
+        }
+
+        std::vector<std::unique_ptr<std::thread>> threads;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<Node> nodes;
+        detail::SegmentedQueue<detail::task *> q;
+        std::atomic<bool> isDone;
+        std::atomic<bool> isStop;
+        std::atomic<int> nWaiting;  // how many threads are waiting
+        std::atomic<int> nSpinning;  // how many threads look for work before parking
+        std::atomic<int> hotSessions;
+        std::atomic<int> spinCount;
+        std::atomic<int> yieldCount;
+        Lane lanes[_ctplPriorityLanes_];
+        std::atomic<int64_t> nLaneTasks;  // functors in all lanes, the workers skip the lanes while it is 0
+        std::atomic<int> priorityBurst;
+#ifdef _ctplEnableStats_
+        std::atomic<uint64_t> submitted;
+#endif
+
+        std::mutex mutex;
+    };
+
+}
+
+#endif // __ctpl_ws_thread_pool_H__
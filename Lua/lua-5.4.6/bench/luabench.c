@@ -0,0 +1,468 @@
+/*
+** $Id: luabench.c $
+** Benchmarks of the embedded interpreter
+** See Copyright Notice in lua.h
+*/
+
+/*
+** usage: luabench [-r reps] [-s scale] [workload...]
+**
+** Every workload is a function run with a count 'n' of operations, in a
+** new state with the standard libraries. Most are written in Lua; the
+** C API workloads are C functions. For each workload it prints the
+** operations per second and the time per operation (both the best of
+** 'reps' runs), the allocator calls per operation and the peak memory
+** in use by the state, so that changes to the VM, the collector or the
+** allocator can be compared. '-s' multiplies every 'n'; the names given
+** select the workloads to run.
+*/
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE	200809L  /* for 'clock_gettime' */
+#endif
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+static double now (void) {
+#if defined(_WIN32)
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+
+/*
+** {======================================================
+** Allocator that counts its calls
+** =======================================================
+*/
+
+typedef struct Counter {
+  size_t calls;  /* allocations and reallocations */
+  size_t inuse;  /* bytes in use */
+  size_t peak;  /* largest 'inuse' */
+} Counter;
+
+
+static void *countalloc (void *ud, void *ptr, size_t osize, size_t nsize) {
+  Counter *c = (Counter *)ud;
+  if (ptr == NULL)
+    osize = 0;  /* 'osize' is a type tag for new blocks */
+  c->inuse = c->inuse - osize + nsize;
+  if (c->inuse > c->peak)
+    c->peak = c->inuse;
+  if (nsize == 0) {
+    free(ptr);
+    return NULL;
+  }
+  c->calls++;
+  return realloc(ptr, nsize);
+}
+
+/* }====================================================== */
+
+
+/*
+** {======================================================
+** C API workloads
+** =======================================================
+*/
+
+/* one push of each basic type, then pops them */
+static int capi_stack (lua_State *L) {
+  lua_Integer i, n = luaL_checkinteger(L, 1);
+  int top = lua_gettop(L);
+  for (i = 0; i < n; i++) {
+    lua_pushinteger(L, i);
+    lua_pushnumber(L, (lua_Number)i);
+    lua_pushboolean(L, 1);
+    lua_pushnil(L);
+    lua_pushliteral(L, "field");
+    lua_pushvalue(L, top);
+    lua_settop(L, top);
+  }
+  return 0;
+}
+
+
+/* a protected call of the Lua function given (argument 2) */
+static int capi_pcall (lua_State *L) {
+  lua_Integer i, n = luaL_checkinteger(L, 1);
+  lua_Number sum = 0;
+  for (i = 0; i < n; i++) {
+    lua_pushvalue(L, 2);
+    lua_pushinteger(L, i);
+    if (lua_pcall(L, 1, 1, 0) != LUA_OK)
+      return lua_error(L);
+    sum += lua_tonumber(L, -1);
+    lua_pop(L, 1);
+  }
+  lua_pushnumber(L, sum);
+  return 1;
+}
+
+
+/* cheapest C function, called from Lua by 'ccall' */
+static int nop (lua_State *L) {
+  lua_pushinteger(L, luaL_checkinteger(L, 1) + 1);
+  return 1;
+}
+
+/* }====================================================== */
+
+
+/*
+** {======================================================
+** Model binding
+** =======================================================
+*/
+
+/*
+** A stand-in for a simulation model behind a scripting binding: named
+** real signals, set and read one at a time through their full names,
+** and a step function, as in the 'oms_setReal', 'oms_getReal' and
+** 'oms_stepUntil' functions of OMSimulator. Signal names are resolved
+** on every call through a table from names to indices, like a binding
+** that looks up component references.
+*/
+
+#define NSIGNALS	64
+
+typedef struct Model {
+  double value[NSIGNALS];
+  double time;
+} Model;
+
+
+#define getmodel(L)	((Model *)lua_touserdata(L, lua_upvalueindex(1)))
+
+
+/* index of the signal named by argument 1 */
+static int checksignal (lua_State *L) {
+  int idx;
+  luaL_checkstring(L, 1);
+  lua_pushvalue(L, 1);
+  if (lua_rawget(L, lua_upvalueindex(2)) != LUA_TNUMBER)
+    return luaL_error(L, "unknown signal '%s'", lua_tostring(L, 1));
+  idx = (int)lua_tointeger(L, -1);
+  lua_pop(L, 1);
+  return idx;
+}
+
+
+static int oms_setReal (lua_State *L) {
+  int idx = checksignal(L);
+  getmodel(L)->value[idx] = luaL_checknumber(L, 2);
+  lua_pushinteger(L, 0);  /* status */
+  return 1;
+}
+
+
+static int oms_getReal (lua_State *L) {
+  int idx = checksignal(L);
+  lua_pushnumber(L, getmodel(L)->value[idx]);
+  lua_pushinteger(L, 0);  /* status */
+  return 2;
+}
+
+
+/* y[i] = x[i] + u[i] * h, for the second half of the signals */
+static int oms_stepUntil (lua_State *L) {
+  Model *m = getmodel(L);
+  double t = luaL_checknumber(L, 2);
+  double h = t - m->time;
+  int i;
+  luaL_checkstring(L, 1);
+  for (i = 0; i < NSIGNALS / 2; i++)
+    m->value[NSIGNALS / 2 + i] += m->value[i] * h;
+  m->time = t;
+  lua_pushinteger(L, 0);  /* status */
+  return 1;
+}
+
+
+static const luaL_Reg model_funcs[] = {
+  {"oms_setReal", oms_setReal},
+  {"oms_getReal", oms_getReal},
+  {"oms_stepUntil", oms_stepUntil},
+  {NULL, NULL}
+};
+
+
+/* sets the binding functions as globals, with the model as upvalue */
+static void openmodel (lua_State *L) {
+  Model *m = (Model *)lua_newuserdatauv(L, sizeof(Model), 0);
+  int i;
+  memset(m, 0, sizeof(Model));
+  lua_createtable(L, 0, NSIGNALS);  /* names to indices */
+  for (i = 0; i < NSIGNALS; i++) {
+    lua_pushfstring(L, "model.root.plant.%c%d", (i < NSIGNALS / 2) ? 'u' : 'y',
+                       i % (NSIGNALS / 2));
+    lua_pushinteger(L, i);
+    lua_rawset(L, -3);
+  }
+  lua_pushglobaltable(L);
+  lua_insert(L, -3);
+  luaL_setfuncs(L, model_funcs, 2);
+  lua_pop(L, 1);
+  lua_pushcfunction(L, nop);
+  lua_setglobal(L, "nop");
+}
+
+/* }====================================================== */
+
+
+/*
+** {======================================================
+** Workloads
+** =======================================================
+*/
+
+/*
+** A workload is a Lua chunk returning a function, run as 'f(n)', or a
+** C function 'cf' run as 'cf(n, f)'.
+*/
+typedef struct Workload {
+  const char *name;
+  const char *what;  /* one operation */
+  lua_Integer n;  /* operations per run */
+  const char *code;
+  lua_CFunction cf;
+} Workload;
+
+
+static const Workload workloads[] = {
+  {"table", "new table with 3 fields, then read them", 2000000,
+   "local ring = {}\n"
+   "return function (n)\n"
+   "  local s = 0\n"
+   "  for i = 1, n do\n"
+   "    local p = {x = i, y = i + 1, name = 'point'}\n"
+   "    ring[i % 1024] = p\n"
+   "    s = s + p.x * p.y\n"
+   "  end\n"
+   "  return s\n"
+   "end\n", NULL},
+  {"array", "append, then sum with ipairs, per element", 5000000,
+   "return function (n)\n"
+   "  local t, s = {}, 0\n"
+   "  for i = 1, n do t[#t + 1] = i end\n"
+   "  for _, v in ipairs(t) do s = s + v end\n"
+   "  return s\n"
+   "end\n", NULL},
+  {"hash", "string-keyed insert and lookup", 1000000,
+   "local keys = {}\n"
+   "for i = 1, 4096 do keys[i] = 'key' .. i end\n"
+   "return function (n)\n"
+   "  local t, s = {}, 0\n"
+   "  for i = 1, n do\n"
+   "    local k = keys[i % 4096 + 1]\n"
+   "    t[k] = (t[k] or 0) + 1\n"
+   "    s = s + (t[keys[(i * 7) % 4096 + 1]] or 0)\n"
+   "  end\n"
+   "  return s\n"
+   "end\n", NULL},
+  {"string", "format a line, buffer it, concat every 100", 1000000,
+   "local format, concat = string.format, table.concat\n"
+   "return function (n)\n"
+   "  local buf, len = {}, 0\n"
+   "  for i = 1, n do\n"
+   "    buf[#buf + 1] = format('%d: %g', i, i * 0.5) .. '\\n'\n"
+   "    if #buf == 100 then len = len + #concat(buf); buf = {} end\n"
+   "  end\n"
+   "  return len\n"
+   "end\n", NULL},
+  {"closure", "create a closure with an upvalue and call it", 2000000,
+   "local function counter (c)\n"
+   "  return function (d) c = c + d; return c end\n"
+   "end\n"
+   "return function (n)\n"
+   "  local s = 0\n"
+   "  for i = 1, n do s = s + counter(i)(1) end\n"
+   "  return s\n"
+   "end\n", NULL},
+  {"coroutine", "resume and yield", 2000000,
+   "return function (n)\n"
+   "  local gen = coroutine.wrap(function ()\n"
+   "    local i = 0\n"
+   "    while true do i = i + 1; coroutine.yield(i) end\n"
+   "  end)\n"
+   "  local s = 0\n"
+   "  for i = 1, n do s = s + gen() end\n"
+   "  return s\n"
+   "end\n", NULL},
+  {"capi_stack", "push 6 values and pop them", 10000000, NULL, capi_stack},
+  {"capi_pcall", "lua_pcall of a Lua function", 5000000,
+   "return function (x) return x + 1 end\n", capi_pcall},
+  {"ccall", "call of a C function from Lua", 10000000,
+   "return function (n)\n"
+   "  local nop, s = nop, 0\n"
+   "  for i = 1, n do s = s + nop(i) end\n"
+   "  return s\n"
+   "end\n", NULL},
+  {"binding", "set 2 inputs, step, get 2 outputs", 1000000,
+   "local setReal, getReal, stepUntil = oms_setReal, oms_getReal, "
+   "oms_stepUntil\n"
+   "return function (n)\n"
+   "  local t, s = 0, 0\n"
+   "  for i = 1, n do\n"
+   "    setReal('model.root.plant.u0', i * 0.5)\n"
+   "    setReal('model.root.plant.u1', -i)\n"
+   "    t = t + 1e-3\n"
+   "    stepUntil('model.root', t)\n"
+   "    local y0 = getReal('model.root.plant.y0')\n"
+   "    local y1, status = getReal('model.root.plant.y1')\n"
+   "    s = s + y0 + y1 + status\n"
+   "  end\n"
+   "  return s\n"
+   "end\n", NULL},
+  {NULL, NULL, 0, NULL, NULL}
+};
+
+
+static int setup (lua_State *L, const Workload *w, lua_Integer n) {
+  luaL_openlibs(L);
+  openmodel(L);
+  if (w->code != NULL) {
+    if (luaL_loadbuffer(L, w->code, strlen(w->code), w->name) != LUA_OK ||
+        lua_pcall(L, 0, 1, 0) != LUA_OK)
+      return 0;
+  }
+  else
+    lua_pushnil(L);
+  if (w->cf != NULL) {
+    lua_pushcfunction(L, w->cf);
+    lua_insert(L, -2);
+  }
+  lua_pushinteger(L, n);
+  if (w->cf != NULL)
+    lua_insert(L, -2);  /* 'cf(n, f)' */
+  return 1;
+}
+
+
+/*
+** Runs 'w' once in a new state; returns its time in seconds, or a
+** negative value on errors.
+*/
+static double run (const Workload *w, lua_Integer n, Counter *c) {
+  lua_State *L;
+  double t;
+  memset(c, 0, sizeof(Counter));
+  L = lua_newstate(countalloc, c);
+  if (L == NULL)
+    return -1;
+  if (!setup(L, w, n)) {
+    fprintf(stderr, "luabench: %s: %s\n", w->name, lua_tostring(L, -1));
+    lua_close(L);
+    return -1;
+  }
+  c->calls = 0;  /* count only the run */
+  c->peak = c->inuse;
+  t = now();
+  if (lua_pcall(L, (w->cf != NULL) ? 2 : 1, 0, 0) != LUA_OK) {
+    fprintf(stderr, "luabench: %s: %s\n", w->name, lua_tostring(L, -1));
+    lua_close(L);
+    return -1;
+  }
+  t = now() - t;
+  lua_close(L);
+  return t;
+}
+
+/* }====================================================== */
+
+
+static void usage (void) {
+  const Workload *w;
+  fprintf(stderr, "usage: luabench [-r reps] [-s scale] [workload...]\n"
+                  "workloads:\n");
+  for (w = workloads; w->name != NULL; w++)
+    fprintf(stderr, "  %-12s %s\n", w->name, w->what);
+}
+
+
+static int selected (const Workload *w, int argc, char **argv, int first) {
+  int i;
+  if (first == argc)
+    return 1;  /* no names: run all */
+  for (i = first; i < argc; i++)
+    if (strcmp(argv[i], w->name) == 0)
+      return 1;
+  return 0;
+}
+
+
+int main (int argc, char **argv) {
+  const Workload *w;
+  int reps = 3;
+  double scale = 1;
+  int i, first, status = EXIT_SUCCESS;
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      reps = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+      scale = atof(argv[++i]);
+    else {
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+  first = i;
+  if (reps < 1) reps = 1;
+  if (!(scale > 0)) scale = 1;
+  printf("%s, best of %d\n\n", LUA_RELEASE, reps);
+  printf("%-12s %14s %10s %12s %10s\n",
+         "workload", "ops/s", "ns/op", "allocs/op", "peak KB");
+  for (w = workloads; w->name != NULL; w++) {
+    lua_Integer n = (lua_Integer)(w->n * scale);
+    double best = -1;
+    size_t calls = 0, peak = 0;
+    int r;
+    if (!selected(w, argc, argv, first))
+      continue;
+    if (n < 1) n = 1;
+    for (r = 0; r < reps; r++) {
+      Counter c;
+      double t = run(w, n, &c);
+      if (t < 0) {
+        status = EXIT_FAILURE;
+        break;
+      }
+      if (best < 0 || t < best) {
+        best = t;
+        calls = c.calls;
+        peak = c.peak;
+      }
+    }
+    if (best < 0)
+      continue;
+    if (best <= 0) best = 1e-9;
+    printf("%-12s %14.0f %10.1f %12.2f %10.0f\n", w->name,
+           (double)n / best, best * 1e9 / (double)n,
+           (double)calls / (double)n, (double)peak / 1024.0);
+    fflush(stdout);
+  }
+  return status;
+}
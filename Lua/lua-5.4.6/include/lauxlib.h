@@ -97,8 +97,11 @@ LUALIB_API int (luaL_loadfilex) (lua_State *L, const char *filename,
 LUALIB_API int (luaL_loadbufferx) (lua_State *L, const char *buff, size_t sz,
                                    const char *name, const char *mode);
 LUALIB_API int (luaL_loadstring) (lua_State *L, const char *s);
+LUALIB_API int (luaL_loadfilecached) (lua_State *L, const char *filename,
+                                     const char *cachedir);
 
 LUALIB_API lua_State *(luaL_newstate) (void);
+LUALIB_API lua_State *(luaL_newpoolstate) (void);
 
 LUALIB_API lua_Integer (luaL_len) (lua_State *L, int idx);
 
@@ -227,6 +230,50 @@ LUALIB_API char *(luaL_buffinitsize) (lua_State *L, luaL_Buffer *B, size_t sz);
 
 
 
+/*
+** {======================================================
+** Pooled allocator
+** =======================================================
+*/
+
+/*
+** Statistics of a state created by 'luaL_newpoolstate'. Index 'i' of
+** the arrays is the size class of blocks up to (i + 1) * LUAL_POOLSTEP
+** bytes; the last index counts the larger blocks.
+*/
+typedef struct luaL_PoolStats {
+  size_t live;  /* bytes in use */
+  size_t peak;  /* maximum of 'live' */
+  size_t held;  /* bytes taken from the system, used or free */
+  size_t nlive[LUAL_POOLCLASSES + 1];  /* blocks in use */
+  size_t nalloc[LUAL_POOLCLASSES + 1];  /* blocks allocated so far */
+} luaL_PoolStats;
+
+LUALIB_API int (luaL_poolstats) (lua_State *L, luaL_PoolStats *stats);
+
+/* }====================================================== */
+
+
+
+/*
+** {======================================================
+** Lazy proxies of host objects
+** =======================================================
+*/
+
+LUALIB_API int (luaL_newproxytype) (lua_State *L, const char *tname,
+                                       lua_CFunction resolve);
+LUALIB_API void (luaL_pushproxy) (lua_State *L, void *obj, const char *tname);
+LUALIB_API void *(luaL_toproxy) (lua_State *L, int idx, const char *tname);
+LUALIB_API void *(luaL_checkproxy) (lua_State *L, int arg, const char *tname);
+LUALIB_API void (luaL_resetproxy) (lua_State *L, void *obj, const char *tname);
+LUALIB_API void (luaL_releaseproxy) (lua_State *L, void *obj,
+                                        const char *tname);
+
+/* }====================================================== */
+
+
+
 /*
 ** {======================================================
 ** File handles for IO library
@@ -245,6 +245,8 @@ LUA_API void        (lua_pushnil) (lua_State *L);
 LUA_API void        (lua_pushnumber) (lua_State *L, lua_Number n);
 LUA_API void        (lua_pushinteger) (lua_State *L, lua_Integer n);
 LUA_API const char *(lua_pushlstring) (lua_State *L, const char *s, size_t len);
+LUA_API const char *(lua_pushexternalstring) (lua_State *L,
+                      const char *s, size_t len, lua_Alloc falloc, void *ud);
 LUA_API const char *(lua_pushstring) (lua_State *L, const char *s);
 LUA_API const char *(lua_pushvfstring) (lua_State *L, const char *fmt,
                                                       va_list argp);
@@ -282,6 +284,10 @@ LUA_API void  (lua_seti) (lua_State *L, int idx, lua_Integer n);
 LUA_API void  (lua_rawset) (lua_State *L, int idx);
 LUA_API void  (lua_rawseti) (lua_State *L, int idx, lua_Integer n);
 LUA_API void  (lua_rawsetp) (lua_State *L, int idx, const void *p);
+LUA_API void  (lua_appendnumbers) (lua_State *L, int idx,
+                                   const lua_Number *v, int n);
+LUA_API void  (lua_appendintegers) (lua_State *L, int idx,
+                                    const lua_Integer *v, int n);
 LUA_API int   (lua_setmetatable) (lua_State *L, int objindex);
 LUA_API int   (lua_setiuservalue) (lua_State *L, int idx, int n);
 
@@ -338,9 +344,21 @@ LUA_API void (lua_warning)  (lua_State *L, const char *msg, int tocont);
 #define LUA_GCISRUNNING		9
 #define LUA_GCGEN		10
 #define LUA_GCINC		11
+#define LUA_GCBUDGET		12
+#define LUA_GCHOLD		13
+#define LUA_GCPAUSES		14
 
 LUA_API int (lua_gc) (lua_State *L, int what, ...);
 
+/*
+** Automatic collector steps, reported by LUA_GCPAUSES
+*/
+typedef struct lua_GCPauses {
+  lua_Integer steps;  /* number of steps */
+  double total;  /* time spent in them, in seconds */
+  double max;  /* longest of them, in seconds */
+} lua_GCPauses;
+
 
 /*
 ** miscellaneous functions
@@ -358,6 +376,8 @@ LUA_API size_t   (lua_stringtonumber) (lua_State *L, const char *s);
 LUA_API lua_Alloc (lua_getallocf) (lua_State *L, void **ud);
 LUA_API void      (lua_setallocf) (lua_State *L, lua_Alloc f, void *ud);
 
+LUA_API int  (lua_setstrcache) (lua_State *L, int nsets);
+
 LUA_API void (lua_toclose) (lua_State *L, int idx);
 LUA_API void (lua_closeslot) (lua_State *L, int idx);
 
@@ -766,6 +766,16 @@
 #define LUAL_BUFFERSIZE   ((int)(16 * sizeof(void*) * sizeof(lua_Number)))
 
 
+/*
+@@ LUAL_POOLSTEP is the step between the size classes of the pooled
+** allocator of 'luaL_newpoolstate', and LUAL_POOLCLASSES their number.
+** Blocks larger than LUAL_POOLSTEP * LUAL_POOLCLASSES use 'realloc'.
+** CHANGE them to fit the sizes of small objects on your platform.
+*/
+#define LUAL_POOLSTEP		16
+#define LUAL_POOLCLASSES	16
+
+
 /*
 @@ LUAI_MAXALIGN defines fields that, when used in a union, ensure
 ** maximum alignment for the other items in that union.
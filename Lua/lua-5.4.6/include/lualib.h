@@ -35,6 +35,18 @@ LUAMOD_API int (luaopen_string) (lua_State *L);
 #define LUA_UTF8LIBNAME	"utf8"
 LUAMOD_API int (luaopen_utf8) (lua_State *L);
 
+#define LUA_ARRAYLIBNAME	"array"
+LUAMOD_API int (luaopen_array) (lua_State *L);
+
+#define LUA_PROFLIBNAME	"profiler"
+LUAMOD_API int (luaopen_profiler) (lua_State *L);
+
+#define LUA_WORKLIBNAME	"worker"
+LUAMOD_API int (luaopen_worker) (lua_State *L);
+
+#define LUA_SERIALLIBNAME	"serial"
+LUAMOD_API int (luaopen_serial) (lua_State *L);
+
 #define LUA_MATHLIBNAME	"math"
 LUAMOD_API int (luaopen_math) (lua_State *L);
 
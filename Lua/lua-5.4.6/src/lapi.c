@@ -535,6 +535,27 @@ LUA_API const char *lua_pushlstring (lua_State *L, const char *s, size_t len) {
 }
 
 
+/*
+** Pushes a string that uses the memory 's[0..len]' (with s[len] == '\0')
+** without copying it, if it is long; 'falloc(ud, s, len + 1, 0)'
+** releases that memory when the string is collected (or right away,
+** for a short string, which is copied as usual, or if the string
+** cannot be created because of a memory error).
+*/
+LUA_API const char *lua_pushexternalstring (lua_State *L,
+                const char *s, size_t len, lua_Alloc falloc, void *ud) {
+  TString *ts;
+  lua_lock(L);
+  api_check(L, s[len] == '\0', "string not ending with zero");
+  ts = luaS_newextlstr(L, s, len, falloc, ud);
+  setsvalue2s(L, L->top.p, ts);
+  api_incr_top(L);
+  luaC_checkGC(L);
+  lua_unlock(L);
+  return getstr(ts);
+}
+
+
 LUA_API const char *lua_pushstring (lua_State *L, const char *s) {
   lua_lock(L);
   if (s == NULL)
@@ -930,6 +951,53 @@ LUA_API void lua_rawseti (lua_State *L, int idx, lua_Integer n) {
 }
 
 
+/*
+** Make room for 'n' values after the border of table 'idx', growing its
+** array part at most once, and return the first of those slots.
+*/
+static TValue *appendslots (lua_State *L, int idx, int n) {
+  Table *t = gettable(L, idx);
+  lua_Unsigned len = luaH_getn(t);
+  api_check(L, n >= 0, "negative count");
+  if (len + n > luaH_realasize(t)) {
+    if (l_unlikely(len > (lua_Unsigned)(MAX_INT - n)))
+      luaG_runerror(L, "table overflow");
+    luaH_resizearray(L, t, cast_uint(len + n));
+  }
+  return &t->array[len];
+}
+
+
+/*
+** Raw-append the C arrays 'v[0..n-1]' to the sequence in table 'idx';
+** numbers are not collectable, so no barrier is needed.
+*/
+LUA_API void lua_appendnumbers (lua_State *L, int idx,
+                                const lua_Number *v, int n) {
+  TValue *slot;
+  int i;
+  lua_lock(L);
+  slot = appendslots(L, idx, n);
+  for (i = 0; i < n; i++)
+    setfltvalue(slot + i, v[i]);
+  luaC_checkGC(L);
+  lua_unlock(L);
+}
+
+
+LUA_API void lua_appendintegers (lua_State *L, int idx,
+                                 const lua_Integer *v, int n) {
+  TValue *slot;
+  int i;
+  lua_lock(L);
+  slot = appendslots(L, idx, n);
+  for (i = 0; i < n; i++)
+    setivalue(slot + i, v[i]);
+  luaC_checkGC(L);
+  lua_unlock(L);
+}
+
+
 LUA_API int lua_setmetatable (lua_State *L, int objindex) {
   TValue *obj;
   Table *mt;
@@ -1180,6 +1248,40 @@ LUA_API int lua_gc (lua_State *L, int what, ...) {
         res = 1;  /* signal it */
       break;
     }
+    case LUA_GCBUDGET: {
+      int usec = va_arg(argp, int);
+      lu_byte oldstp = g->gcstp;
+      g->gcstp = 0;  /* allow GC to run (GCSTPGC must be zero here) */
+      res = luaC_budget(L, usec);
+      g->gcstp = oldstp;  /* restore previous state */
+      break;
+    }
+    case LUA_GCHOLD: {
+      int data = va_arg(argp, int);  /* Kbytes allowed to grow; 0 ends */
+      res = (g->gchold != 0);
+      if (data > 0) {
+        g->gchold = gettotalbytes(g) + cast(lu_mem, data) * 1024;
+        if (g->gchold > MAX_LMEM)  /* overflow? */
+          g->gchold = MAX_LMEM;
+      }
+      else if (g->gchold != 0) {
+        g->gchold = 0;
+        if (g->GCdebt < 0)
+          luaE_setdebt(g, 0);  /* resume with a step */
+      }
+      break;
+    }
+    case LUA_GCPAUSES: {
+      lua_GCPauses *p = va_arg(argp, lua_GCPauses *);
+      int reset = va_arg(argp, int);
+      if (p != NULL)
+        *p = g->gcpauses;
+      if (reset) {
+        g->gcpauses.steps = 0;
+        g->gcpauses.total = g->gcpauses.max = 0;
+      }
+      break;
+    }
     case LUA_GCSETPAUSE: {
       int data = va_arg(argp, int);
       res = getgcparam(g->gcpause);
@@ -1267,6 +1369,23 @@ LUA_API int lua_next (lua_State *L, int idx) {
 }
 
 
+/*
+** Set the number of sets in the cache for strings in the API (see
+** 'luaS_new'); 'nsets' <= 0 only queries it. Returns the old number.
+*/
+LUA_API int lua_setstrcache (lua_State *L, int nsets) {
+  int res;
+  lua_lock(L);
+  res = cast_int(G(L)->strcachesize);
+  if (nsets > 0) {
+    api_check(L, nsets <= MAX_INT / STRCACHE_M, "string cache too large");
+    luaS_resizecache(L, cast_uint(nsets));
+  }
+  lua_unlock(L);
+  return res;
+}
+
+
 LUA_API void lua_toclose (lua_State *L, int idx) {
   int nresults;
   StkId o;
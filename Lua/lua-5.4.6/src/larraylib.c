@@ -0,0 +1,417 @@
+/*
+** $Id: larraylib.c $
+** Typed numeric arrays
+** See Copyright Notice in lua.h
+*/
+
+#define larraylib_c
+#define LUA_LIB
+
+#include "lprefix.h"
+
+
+#include <limits.h>
+#include <string.h>
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+/*
+** An array is a userdata with a contiguous buffer of C doubles or of
+** lua_Integers, indexed from 1. A new array keeps its elements in the
+** same block as its header. A slice is a header pointing into the
+** elements of another array, which it keeps alive in its user value, so
+** that slicing never copies.
+*/
+
+#define ARRAY_MT	"array"
+
+#define MAX_SIZET	((size_t)(~(size_t)0))
+
+#define ARR_DOUBLE	0
+#define ARR_INT		1
+
+typedef struct Array {
+  void *data;  /* first element */
+  lua_Integer n;  /* number of elements */
+  int type;  /* ARR_DOUBLE or ARR_INT */
+} Array;
+
+
+#define dbl(a)		((double *)(a)->data)
+#define itg(a)		((lua_Integer *)(a)->data)
+
+#define elemsize(t)	((t) == ARR_DOUBLE ? sizeof(double) : sizeof(lua_Integer))
+
+static const char *const typenames[] = {"double", "int", NULL};
+
+
+#define checkarray(L,i)	((Array *)luaL_checkudata(L, i, ARRAY_MT))
+
+
+static Array *newarray (lua_State *L, int type, lua_Integer n) {
+  Array *a;
+  luaL_argcheck(L, n >= 0 &&
+                   (size_t)n <= (MAX_SIZET - sizeof(Array)) / elemsize(type),
+                   1, "invalid array size");
+  a = (Array *)lua_newuserdatauv(L, sizeof(Array) + (size_t)n * elemsize(type), 1);
+  a->data = a + 1;
+  a->n = n;
+  a->type = type;
+  memset(a->data, 0, (size_t)n * elemsize(type));
+  luaL_setmetatable(L, ARRAY_MT);
+  return a;
+}
+
+
+/*
+** array.double(n|t) and array.int(n|t): a new array of 'n' zeros or
+** with the elements of the sequence 't'
+*/
+static int newtyped (lua_State *L, int type) {
+  Array *a;
+  lua_Integer i;
+  if (lua_type(L, 1) == LUA_TTABLE) {
+    a = newarray(L, type, luaL_len(L, 1));
+    for (i = 0; i < a->n; i++) {
+      lua_geti(L, 1, i + 1);
+      if (type == ARR_DOUBLE)
+        dbl(a)[i] = (double)luaL_checknumber(L, -1);
+      else
+        itg(a)[i] = luaL_checkinteger(L, -1);
+      lua_pop(L, 1);
+    }
+  }
+  else
+    newarray(L, type, luaL_checkinteger(L, 1));
+  return 1;
+}
+
+
+static int arr_double (lua_State *L) {
+  return newtyped(L, ARR_DOUBLE);
+}
+
+
+static int arr_int (lua_State *L) {
+  return newtyped(L, ARR_INT);
+}
+
+
+/* index of element 'i' (1-based) of 'a', or error */
+static lua_Integer checkindex (lua_State *L, Array *a, lua_Integer i, int arg) {
+  luaL_argcheck(L, 1 <= i && i <= a->n, arg, "index out of range");
+  return i - 1;
+}
+
+
+static void pushelem (lua_State *L, Array *a, lua_Integer i) {
+  if (a->type == ARR_DOUBLE)
+    lua_pushnumber(L, (lua_Number)dbl(a)[i]);
+  else
+    lua_pushinteger(L, itg(a)[i]);
+}
+
+
+/* __index: elements for integer keys, methods for other keys */
+static int arr_index (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  int isnum;
+  lua_Integer i = lua_tointegerx(L, 2, &isnum);
+  if (isnum) {
+    pushelem(L, a, checkindex(L, a, i, 2));
+    return 1;
+  }
+  lua_settop(L, 2);
+  lua_gettable(L, lua_upvalueindex(1));  /* method table */
+  return 1;
+}
+
+
+static int arr_newindex (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  lua_Integer i = checkindex(L, a, luaL_checkinteger(L, 2), 2);
+  if (a->type == ARR_DOUBLE)
+    dbl(a)[i] = (double)luaL_checknumber(L, 3);
+  else
+    itg(a)[i] = luaL_checkinteger(L, 3);
+  return 0;
+}
+
+
+static int arr_len (lua_State *L) {
+  lua_pushinteger(L, checkarray(L, 1)->n);
+  return 1;
+}
+
+
+static int arr_tostring (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  lua_pushfstring(L, "array.%s(%I): %p", typenames[a->type],
+                     (LUAI_UACINT)a->n, (void *)a);
+  return 1;
+}
+
+
+static int arr_type (lua_State *L) {
+  lua_pushstring(L, typenames[checkarray(L, 1)->type]);
+  return 1;
+}
+
+
+/* translate a relative position, negative means from the end */
+static lua_Integer posrelat (lua_Integer pos, lua_Integer n) {
+  if (pos >= 0) return pos;
+  else if (0u - (lua_Unsigned)pos > (lua_Unsigned)n) return 0;
+  else return n + pos + 1;
+}
+
+
+/*
+** a:slice(i [, j]): the elements 'i' to 'j' of 'a', sharing its memory;
+** 'i' and 'j' as in 'string.sub'
+*/
+static int arr_slice (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  lua_Integer i = posrelat(luaL_checkinteger(L, 2), a->n);
+  lua_Integer j = posrelat(luaL_optinteger(L, 3, -1), a->n);
+  Array *s;
+  if (i < 1) i = 1;
+  if (j > a->n) j = a->n;
+  s = (Array *)lua_newuserdatauv(L, sizeof(Array), 1);
+  s->type = a->type;
+  s->n = (i > j) ? 0 : j - i + 1;
+  s->data = (char *)a->data + (size_t)(i - 1) * elemsize(a->type);
+  lua_pushvalue(L, 1);
+  lua_setiuservalue(L, -2, 1);  /* keep the elements alive */
+  luaL_setmetatable(L, ARRAY_MT);
+  return 1;
+}
+
+
+static int arr_copy (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  Array *c = newarray(L, a->type, a->n);
+  memcpy(c->data, a->data, (size_t)a->n * elemsize(a->type));
+  return 1;
+}
+
+
+static int arr_totable (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  lua_Integer i;
+  lua_createtable(L, (a->n <= INT_MAX) ? (int)a->n : 0, 0);
+  for (i = 0; i < a->n; i++) {
+    pushelem(L, a, i);
+    lua_seti(L, -2, i + 1);
+  }
+  return 1;
+}
+
+
+static int arr_fill (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  lua_Integer i;
+  if (a->type == ARR_DOUBLE) {
+    double v = (double)luaL_checknumber(L, 2);
+    double *d = dbl(a);
+    for (i = 0; i < a->n; i++) d[i] = v;
+  }
+  else {
+    lua_Integer v = luaL_checkinteger(L, 2);
+    lua_Integer *d = itg(a);
+    for (i = 0; i < a->n; i++) d[i] = v;
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+
+/* integer sums wrap around, as integer additions in Lua */
+static int arr_sum (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  lua_Integer i;
+  if (a->type == ARR_DOUBLE) {
+    const double *d = dbl(a);
+    double s = 0;
+    for (i = 0; i < a->n; i++) s += d[i];
+    lua_pushnumber(L, (lua_Number)s);
+  }
+  else {
+    const lua_Integer *d = itg(a);
+    lua_Unsigned s = 0;
+    for (i = 0; i < a->n; i++) s += (lua_Unsigned)d[i];
+    lua_pushinteger(L, (lua_Integer)s);
+  }
+  return 1;
+}
+
+
+/* a:min() and a:max(): the value and its index, nil for an empty array */
+static int minmax (lua_State *L, int max) {
+  Array *a = checkarray(L, 1);
+  lua_Integer i, k = 0;
+  if (a->n == 0) {
+    luaL_pushfail(L);
+    return 1;
+  }
+  if (a->type == ARR_DOUBLE) {
+    const double *d = dbl(a);
+    for (i = 1; i < a->n; i++)
+      if (max ? d[i] > d[k] : d[i] < d[k]) k = i;
+  }
+  else {
+    const lua_Integer *d = itg(a);
+    for (i = 1; i < a->n; i++)
+      if (max ? d[i] > d[k] : d[i] < d[k]) k = i;
+  }
+  pushelem(L, a, k);
+  lua_pushinteger(L, k + 1);
+  return 2;
+}
+
+
+static int arr_min (lua_State *L) {
+  return minmax(L, 0);
+}
+
+
+static int arr_max (lua_State *L) {
+  return minmax(L, 1);
+}
+
+
+/* y:axpy(alpha, x): y = alpha * x + y, in place; returns y */
+static int arr_axpy (lua_State *L) {
+  Array *y = checkarray(L, 1);
+  Array *x = checkarray(L, 3);
+  lua_Integer i;
+  luaL_argcheck(L, x->n == y->n, 3, "arrays of different lengths");
+  if (y->type == ARR_DOUBLE) {
+    double alpha = (double)luaL_checknumber(L, 2);
+    double *yd = dbl(y);
+    if (x->type == ARR_DOUBLE) {
+      const double *xd = dbl(x);
+      for (i = 0; i < y->n; i++) yd[i] += alpha * xd[i];
+    }
+    else {
+      const lua_Integer *xd = itg(x);
+      for (i = 0; i < y->n; i++) yd[i] += alpha * (double)xd[i];
+    }
+  }
+  else {
+    lua_Unsigned alpha = (lua_Unsigned)luaL_checkinteger(L, 2);
+    lua_Integer *yd = itg(y);
+    const lua_Integer *xd = itg(x);
+    luaL_argcheck(L, x->type == ARR_INT, 3, "int array expected");
+    for (i = 0; i < y->n; i++)
+      yd[i] = (lua_Integer)((lua_Unsigned)yd[i] + alpha * (lua_Unsigned)xd[i]);
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+
+/* a:scale(alpha): a = alpha * a, in place; returns a */
+static int arr_scale (lua_State *L) {
+  Array *a = checkarray(L, 1);
+  lua_Integer i;
+  if (a->type == ARR_DOUBLE) {
+    double alpha = (double)luaL_checknumber(L, 2);
+    double *d = dbl(a);
+    for (i = 0; i < a->n; i++) d[i] *= alpha;
+  }
+  else {
+    lua_Unsigned alpha = (lua_Unsigned)luaL_checkinteger(L, 2);
+    lua_Integer *d = itg(a);
+    for (i = 0; i < a->n; i++)
+      d[i] = (lua_Integer)((lua_Unsigned)d[i] * alpha);
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+
+/* x:dot(y): the sum of the products of the elements, as a float */
+static int arr_dot (lua_State *L) {
+  Array *x = checkarray(L, 1);
+  Array *y = checkarray(L, 2);
+  lua_Integer i;
+  double s = 0;
+  luaL_argcheck(L, x->n == y->n, 2, "arrays of different lengths");
+  if (x->type == ARR_DOUBLE && y->type == ARR_DOUBLE) {
+    const double *xd = dbl(x), *yd = dbl(y);
+    for (i = 0; i < x->n; i++) s += xd[i] * yd[i];
+  }
+  else {
+    for (i = 0; i < x->n; i++)
+      s += (x->type == ARR_DOUBLE ? dbl(x)[i] : (double)itg(x)[i]) *
+           (y->type == ARR_DOUBLE ? dbl(y)[i] : (double)itg(y)[i]);
+  }
+  lua_pushnumber(L, (lua_Number)s);
+  return 1;
+}
+
+
+static const luaL_Reg arr_methods[] = {
+  {"type", arr_type},
+  {"slice", arr_slice},
+  {"copy", arr_copy},
+  {"totable", arr_totable},
+  {"fill", arr_fill},
+  {"sum", arr_sum},
+  {"min", arr_min},
+  {"max", arr_max},
+  {"axpy", arr_axpy},
+  {"scale", arr_scale},
+  {"dot", arr_dot},
+  {NULL, NULL}
+};
+
+
+static const luaL_Reg arr_metamethods[] = {
+  {"__newindex", arr_newindex},
+  {"__len", arr_len},
+  {"__tostring", arr_tostring},
+  {"__index", NULL},  /* place holder */
+  {NULL, NULL}
+};
+
+
+static const luaL_Reg arr_funcs[] = {
+  {"double", arr_double},
+  {"int", arr_int},
+  {"type", arr_type},
+  {"slice", arr_slice},
+  {"copy", arr_copy},
+  {"totable", arr_totable},
+  {"fill", arr_fill},
+  {"sum", arr_sum},
+  {"min", arr_min},
+  {"max", arr_max},
+  {"axpy", arr_axpy},
+  {"scale", arr_scale},
+  {"dot", arr_dot},
+  {NULL, NULL}
+};
+
+
+static void createmeta (lua_State *L) {
+  luaL_newmetatable(L, ARRAY_MT);  /* metatable for arrays */
+  luaL_setfuncs(L, arr_metamethods, 0);  /* add metamethods to new metatable */
+  luaL_newlibtable(L, arr_methods);  /* create method table */
+  luaL_setfuncs(L, arr_methods, 0);  /* add array methods to method table */
+  lua_pushcclosure(L, arr_index, 1);  /* __index looks up methods there */
+  lua_setfield(L, -2, "__index");  /* metatable.__index = arr_index */
+  lua_pop(L, 1);  /* pop metatable */
+}
+
+
+LUAMOD_API int luaopen_array (lua_State *L) {
+  luaL_newlib(L, arr_funcs);  /* new module */
+  createmeta(L);
+  return 1;
+}
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 
 /*
@@ -706,9 +707,69 @@ LUALIB_API void luaL_unref (lua_State *L, int t, int ref) {
 ** =======================================================
 */
 
+/*
+** {======================================================
+** Memory-mapped files
+** =======================================================
+*/
+
+/*
+** Where 'mmap' is available, the rest of a regular file larger than
+** LUA_MAPFILEMIN bytes is mapped into memory and given to 'lua_load'
+** as a single block, which the lexer and 'luaU_undump' then read in
+** place, without the copies and calls of reading it with 'fread' in
+** BUFSIZ pieces. (The file must not be truncated while it loads.)
+*/
+
+#if !defined(LUA_MAPFILEMIN)
+#define LUA_MAPFILEMIN		(64 * 1024)
+#endif
+
+
+#if !defined(l_mapfile)		/* { */
+
+#if defined(LUA_USE_POSIX)	/* { */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+** Maps the whole file 'f', if it is a regular file of at least
+** LUA_MAPFILEMIN bytes; returns NULL otherwise.
+*/
+static void *l_mapfile (FILE *f, size_t *size) {
+  struct stat st;
+  void *p;
+  if (fstat(fileno(f), &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size < LUA_MAPFILEMIN || (lua_Unsigned)st.st_size > MAX_SIZET)
+    return NULL;
+  p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+  if (p == MAP_FAILED)
+    return NULL;
+  *size = (size_t)st.st_size;
+  return p;
+}
+
+#define l_unmapfile(p,size)	munmap(p, size)
+
+#else				/* }{ */
+
+#define l_mapfile(f,size)	((void)f, (void)size, (void *)NULL)
+#define l_unmapfile(p,size)	((void)p, (void)size)
+
+#endif				/* } */
+
+#endif				/* } */
+
+/* }====================================================== */
+
+
 typedef struct LoadF {
   int n;  /* number of pre-read characters */
   FILE *f;  /* file being read */
+  char *map;  /* file mapped in memory, or NULL */
+  size_t mapsize;  /* size of 'map' */
+  size_t mappos;  /* next position to read in 'map' */
   char buff[BUFSIZ];  /* area for reading file */
 } LoadF;
 
@@ -720,6 +781,12 @@ static const char *getF (lua_State *L, void *ud, size_t *size) {
     *size = lf->n;  /* return them (chars already in buffer) */
     lf->n = 0;  /* no more pre-read characters */
   }
+  else if (lf->map != NULL) {  /* file is mapped? */
+    const char *p = lf->map + lf->mappos;
+    *size = lf->mapsize - lf->mappos;  /* return all of it at once */
+    lf->mappos = lf->mapsize;
+    return (*size > 0) ? p : NULL;
+  }
   else {  /* read a block from file */
     /* 'fread' can return > 0 *and* set the EOF flag. If next call to
        'getF' called 'fread', it might still wait for user input.
@@ -803,8 +870,22 @@ LUALIB_API int luaL_loadfilex (lua_State *L, const char *filename,
   }
   if (c != EOF)
     lf.buff[lf.n++] = c;  /* 'c' is the first character of the stream */
+  lf.map = NULL;
+  if (filename && c != EOF) {  /* try to map the rest of the file */
+    long pos = ftell(lf.f);
+    lf.map = (char *)l_mapfile(lf.f, &lf.mapsize);
+    if (lf.map != NULL) {
+      if (pos >= 0 && (size_t)pos <= lf.mapsize)
+        lf.mappos = (size_t)pos;  /* continue after the pre-read part */
+      else {  /* position unknown; read the file */
+        l_unmapfile(lf.map, lf.mapsize);
+        lf.map = NULL;
+      }
+    }
+  }
   status = lua_load(L, getF, &lf, lua_tostring(L, -1), mode);
   readstatus = ferror(lf.f);
+  if (lf.map != NULL) l_unmapfile(lf.map, lf.mapsize);
   if (filename) fclose(lf.f);  /* close file (even in case of errors) */
   if (readstatus) {
     lua_settop(L, fnameindex);  /* ignore results from 'lua_load' */
@@ -815,6 +896,131 @@ LUALIB_API int luaL_loadfilex (lua_State *L, const char *filename,
 }
 
 
+/*
+** Bytecode cache: 'luaL_loadfilecached' keeps the dump of each chunk it
+** compiles in a file of 'cachedir' named after a hash of the chunk name
+** and the source, and loads that dump instead of compiling the source
+** the next times. A changed source gets a new name; stale files are not
+** removed. Cache files that fail to load (e.g., from another Lua
+** version) are compiled again and overwritten. Errors writing the
+** cache are ignored.
+*/
+
+/* 32-bit FNV-1a hash of 'n' bytes of 's' continuing from 'h' */
+static unsigned long fnv1a (unsigned long h, const char *s, size_t n) {
+  while (n-- > 0)
+    h = ((h ^ (unsigned char)*s++) * 16777619UL) & 0xffffffffUL;
+  return h;
+}
+
+
+static void tohex (char *buff, unsigned long h) {
+  int i;
+  for (i = 0; i < 8; i++)
+    buff[i] = "0123456789abcdef"[(h >> (28 - 4 * i)) & 0xf];
+}
+
+
+static int writeF (lua_State *L, const void *p, size_t sz, void *ud) {
+  (void)L;  /* not used */
+  return fwrite(p, 1, sz, (FILE *)ud) != sz;
+}
+
+
+/*
+** Dump the function on the top of the stack into cache file 'cname'.
+** The dump goes to a temporary file first, renamed when complete, so
+** that concurrent loaders never read a partial file.
+*/
+static void savecache (lua_State *L, const char *cname) {
+  const char *tname = lua_pushfstring(L, "%s.%p.%I.tmp", cname, (void *)L,
+                                      (LUAI_UACINT)time(NULL));
+  FILE *f = fopen(tname, "wb");
+  if (f != NULL) {
+    int err;
+    lua_pushvalue(L, -2);  /* function to dump */
+    err = lua_dump(L, writeF, f, 0);
+    lua_pop(L, 1);
+    err |= ferror(f);
+    err |= (fclose(f) != 0);
+    if (!err && rename(tname, cname) != 0) {
+      remove(cname);  /* 'rename' may not replace an existing file */
+      err = (rename(tname, cname) != 0);
+    }
+    if (err)
+      remove(tname);
+  }
+  lua_pop(L, 1);  /* temporary name */
+}
+
+
+LUALIB_API int luaL_loadfilecached (lua_State *L, const char *filename,
+                                                  const char *cachedir) {
+  luaL_Buffer b;
+  FILE *f;
+  int c, status;
+  int fnameindex = lua_gettop(L) + 1;  /* index of chunk name */
+  const char *chunkname, *src, *cname;
+  size_t len;
+  unsigned long h1, h2;
+  char hex[16];
+  if (filename == NULL || cachedir == NULL)
+    return luaL_loadfilex(L, filename, NULL);
+  chunkname = lua_pushfstring(L, "@%s", filename);
+  f = fopen(filename, "r");
+  if (f == NULL) return errfile(L, "open", fnameindex);
+  luaL_buffinit(L, &b);
+  if (skipcomment(f, &c))  /* read initial portion */
+    luaL_addchar(&b, '\n');  /* add newline to correct line numbers */
+  if (c == LUA_SIGNATURE[0]) {  /* binary file? nothing to cache */
+    fclose(f);
+    luaL_pushresult(&b);
+    lua_settop(L, fnameindex - 1);
+    return luaL_loadfilex(L, filename, NULL);
+  }
+  if (c != EOF)
+    luaL_addchar(&b, c);
+  while ((len = fread(luaL_prepbuffer(&b), 1, LUAL_BUFFERSIZE, f)) > 0)
+    luaL_addsize(&b, len);
+  luaL_pushresult(&b);  /* source */
+  if (ferror(f)) {
+    fclose(f);
+    lua_settop(L, fnameindex);
+    return errfile(L, "read", fnameindex);
+  }
+  fclose(f);
+  src = lua_tolstring(L, -1, &len);
+  /* two hashes with different bases make a 64-bit key */
+  h1 = fnv1a(fnv1a(2166136261UL, chunkname, strlen(chunkname) + 1), src, len);
+  h2 = fnv1a(fnv1a(2654435769UL, src, len), chunkname, strlen(chunkname));
+  tohex(hex, h1);
+  tohex(hex + 8, h2);
+  cname = lua_pushfstring(L, "%s" LUA_DIRSEP "%s.luac", cachedir,
+                             lua_pushlstring(L, hex, sizeof(hex)));
+  lua_remove(L, -2);  /* hex string */
+  f = fopen(cname, "rb");
+  if (f != NULL) {  /* cached? */
+    LoadF lf;
+    lf.f = f;
+    lf.n = 0;
+    status = lua_load(L, getF, &lf, chunkname, "b");
+    fclose(f);
+    if (status == LUA_OK) {
+      lua_replace(L, fnameindex);
+      lua_settop(L, fnameindex);
+      return LUA_OK;
+    }
+    lua_pop(L, 1);  /* error message; compile the source */
+  }
+  status = luaL_loadbufferx(L, src, len, chunkname, "t");
+  if (status == LUA_OK)
+    savecache(L, cname);
+  lua_replace(L, fnameindex);  /* function or error message */
+  lua_settop(L, fnameindex);
+  return status;
+}
+
+
 typedef struct LoadS {
   const char *s;
   size_t size;
@@ -1101,6 +1307,374 @@ LUALIB_API lua_State *luaL_newstate (void) {
 }
 
 
+
+/*
+** {======================================================
+** Pooled allocator
+** =======================================================
+*/
+
+/*
+** Small blocks come from chunks of POOLCHUNK bytes, each carved into
+** blocks of one size class. A freed small block goes to the free list
+** of its class, to be reused by the next allocation of that class;
+** chunks are only given back when the state is closed. Lua passes the
+** size of a block when it frees or resizes it, so the class of a block
+** is known without a header.
+*/
+#define POOLCHUNK	(16 * 1024)
+
+#define POOLMAX		(LUAL_POOLSTEP * LUAL_POOLCLASSES)
+#define poolclass(sz)	(((sz) - 1) / LUAL_POOLSTEP)
+#define issmall(sz)	((sz) <= POOLMAX)
+
+typedef union PoolChunk {
+  union PoolChunk *next;  /* list of all chunks of the pool */
+  LUAI_MAXALIGN;  /* ensure maximum alignment for the blocks after it */
+} PoolChunk;
+
+typedef struct PoolFree {
+  struct PoolFree *next;
+} PoolFree;
+
+typedef struct Pool {
+  PoolFree *free[LUAL_POOLCLASSES];  /* free blocks of each class */
+  PoolChunk *chunks;
+  int *closed;  /* set when the pool goes with a state failing to open */
+  luaL_PoolStats stats;
+} Pool;
+
+
+static void freepool (Pool *p) {
+  while (p->chunks != NULL) {
+    PoolChunk *c = p->chunks;
+    p->chunks = c->next;
+    free(c);
+  }
+  if (p->closed != NULL)
+    *p->closed = 1;
+  free(p);
+}
+
+
+/*
+** Take a block of class 'c', carving a new chunk into the free list of
+** the class when it is empty.
+*/
+static void *poolget (Pool *p, int c) {
+  PoolFree *b = p->free[c];
+  if (b == NULL) {
+    size_t size = (size_t)(c + 1) * LUAL_POOLSTEP;
+    size_t n = (POOLCHUNK - sizeof(PoolChunk)) / size;
+    char *block;
+    PoolChunk *chunk = (PoolChunk *)malloc(POOLCHUNK);
+    if (chunk == NULL)
+      return NULL;
+    chunk->next = p->chunks;
+    p->chunks = chunk;
+    p->stats.held += POOLCHUNK;
+    block = (char *)(chunk + 1);
+    while (n-- > 0) {  /* push the blocks, the first one last */
+      b = (PoolFree *)(block + n * size);
+      b->next = p->free[c];
+      p->free[c] = b;
+    }
+    b = p->free[c];
+  }
+  p->free[c] = b->next;
+  return b;
+}
+
+
+static void poolput (Pool *p, void *block, int c) {
+  PoolFree *b = (PoolFree *)block;
+  b->next = p->free[c];
+  p->free[c] = b;
+}
+
+
+static void *pool_alloc (void *ud, void *ptr, size_t osize, size_t nsize) {
+  Pool *p = (Pool *)ud;
+  luaL_PoolStats *st = &p->stats;
+  int oc, nc;
+  void *nptr;
+  if (ptr == NULL) {
+    if (nsize == 0)
+      return NULL;
+    osize = 0;  /* 'osize' is the kind of object being created */
+    oc = 0;  /* not used */
+  }
+  else
+    oc = issmall(osize) ? poolclass(osize) : LUAL_POOLCLASSES;
+  nc = issmall(nsize) ? poolclass(nsize) : LUAL_POOLCLASSES;
+  if (nsize == 0) {  /* free the block */
+    if (issmall(osize))
+      poolput(p, ptr, oc);
+    else {
+      free(ptr);
+      st->held -= osize;
+    }
+    st->nlive[oc]--;
+    st->live -= osize;
+    if (st->live == 0)  /* freed the state itself, by 'lua_close'? */
+      freepool(p);
+    return NULL;
+  }
+  if (ptr != NULL && oc == nc && issmall(nsize))
+    nptr = ptr;  /* same class, nothing to move */
+  else if (!issmall(nsize) && (ptr == NULL || !issmall(osize))) {
+    nptr = realloc(ptr, nsize);  /* large blocks are left to the system */
+    if (nptr == NULL)
+      return NULL;
+    st->held += nsize - osize;
+    if (ptr == NULL) {
+      st->nlive[nc]++;
+      st->nalloc[nc]++;
+    }
+  }
+  else {  /* between a small and a large block, or new, or other class */
+    nptr = issmall(nsize) ? poolget(p, nc) : malloc(nsize);
+    if (nptr == NULL)
+      return NULL;
+    if (!issmall(nsize))
+      st->held += nsize;
+    st->nlive[nc]++;
+    st->nalloc[nc]++;
+    if (ptr != NULL) {
+      memcpy(nptr, ptr, (osize < nsize) ? osize : nsize);
+      if (issmall(osize))
+        poolput(p, ptr, oc);
+      else {
+        free(ptr);
+        st->held -= osize;
+      }
+      st->nlive[oc]--;
+    }
+  }
+  st->live += nsize - osize;
+  if (st->live > st->peak)
+    st->peak = st->live;
+  return nptr;
+}
+
+
+/*
+** Like 'luaL_newstate', with the pooled allocator. The pool is freed
+** with the last block it holds, which is the state itself, freed by
+** 'lua_close'.
+*/
+LUALIB_API lua_State *luaL_newpoolstate (void) {
+  int closed = 0;
+  lua_State *L;
+  Pool *p = (Pool *)malloc(sizeof(Pool));
+  if (l_unlikely(p == NULL))
+    return NULL;
+  memset(p, 0, sizeof(Pool));
+  p->closed = &closed;
+  L = lua_newstate(pool_alloc, p);
+  if (l_unlikely(L == NULL)) {
+    if (!closed)  /* state not allocated at all? */
+      freepool(p);
+    return NULL;
+  }
+  p->closed = NULL;
+  lua_atpanic(L, &panic);
+  lua_setwarnf(L, warnfoff, L);  /* default is warnings off */
+  return L;
+}
+
+
+/*
+** Copy the statistics of a state created by 'luaL_newpoolstate' into
+** 'stats' and return 1, or return 0 for other states.
+*/
+LUALIB_API int luaL_poolstats (lua_State *L, luaL_PoolStats *stats) {
+  void *ud;
+  if (lua_getallocf(L, &ud) != pool_alloc)
+    return 0;
+  *stats = ((Pool *)ud)->stats;
+  return 1;
+}
+
+/* }====================================================== */
+
+
+
+/*
+** {======================================================
+** Lazy proxies
+** =======================================================
+*/
+
+/*
+** A proxy is a userdata standing for an object of the host. Its type,
+** created by 'luaL_newproxytype', resolves a field of a proxy the first
+** time it is read, calling the resolver of the type with the proxy and
+** the key, and keeps the non-nil results in a cache, the user value of
+** the proxy, created by the first read. So, scripts only pay for the
+** parts of a large host tree that they touch. The cache has weak values:
+** the proxies of children that scripts no longer hold can be collected,
+** and are resolved again if needed. Each type keeps its live proxies in
+** a weak table indexed by host object (field PROXY_LIVE of the
+** metatable), so that an object has a single proxy at a time.
+*/
+
+#define PROXY_LIVE	1
+
+typedef struct Proxy {
+  void *obj;  /* host object, or NULL after 'luaL_releaseproxy' */
+} Proxy;
+
+
+/*
+** __index metamethod of proxies; upvalues are the resolver and the
+** metatable of the type.
+*/
+static int proxy_index (lua_State *L) {
+  Proxy *p = (Proxy *)lua_touserdata(L, 1);
+  int ismt = lua_getmetatable(L, 1) &&
+             lua_rawequal(L, -1, lua_upvalueindex(2));
+  luaL_argcheck(L, p != NULL && ismt, 1, "not a proxy of this type");
+  if (l_unlikely(p->obj == NULL)) {
+    lua_getfield(L, lua_upvalueindex(2), "__name");
+    return luaL_error(L, "attempt to index a released %s",
+                         lua_tostring(L, -1));
+  }
+  lua_settop(L, 2);
+  if (lua_getiuservalue(L, 1, 1) == LUA_TTABLE) {  /* has a cache? */
+    lua_pushvalue(L, 2);
+    if (lua_rawget(L, 3) != LUA_TNIL)
+      return 1;  /* cached value */
+    lua_pop(L, 1);
+  }
+  lua_pushvalue(L, lua_upvalueindex(1));
+  lua_pushvalue(L, 1);
+  lua_pushvalue(L, 2);
+  lua_call(L, 2, 1);  /* resolve the key */
+  if (!lua_isnil(L, 4) && !lua_isnil(L, 2) && lua_rawequal(L, 2, 2)) {
+    if (!lua_istable(L, 3)) {  /* no cache yet? */
+      lua_createtable(L, 0, 4);
+      lua_rawgeti(L, lua_upvalueindex(2), PROXY_LIVE);
+      lua_getmetatable(L, -1);  /* weak-value mode of the live table */
+      lua_setmetatable(L, -3);
+      lua_pop(L, 1);
+      lua_pushvalue(L, -1);
+      lua_setiuservalue(L, 1, 1);
+      lua_replace(L, 3);
+    }
+    lua_pushvalue(L, 2);
+    lua_pushvalue(L, 4);
+    lua_rawset(L, 3);
+  }
+  return 1;
+}
+
+
+/*
+** Create the proxy type 'tname', whose fields are resolved by
+** 'resolve'. Like 'luaL_newmetatable', leaves the metatable of the type
+** on the stack and returns 0 if 'tname' is already in use.
+*/
+LUALIB_API int luaL_newproxytype (lua_State *L, const char *tname,
+                                     lua_CFunction resolve) {
+  if (!luaL_newmetatable(L, tname))
+    return 0;
+  lua_createtable(L, 0, 0);  /* live proxies */
+  lua_createtable(L, 0, 1);
+  lua_pushliteral(L, "v");
+  lua_setfield(L, -2, "__mode");  /* weak values */
+  lua_setmetatable(L, -2);
+  lua_rawseti(L, -2, PROXY_LIVE);
+  lua_pushcfunction(L, resolve);
+  lua_pushvalue(L, -2);
+  lua_pushcclosure(L, proxy_index, 2);
+  lua_setfield(L, -2, "__index");
+  return 1;
+}
+
+
+/*
+** Push the proxy of 'obj' of type 'tname', creating it if it does not
+** exist; pushes nil if 'obj' is NULL.
+*/
+LUALIB_API void luaL_pushproxy (lua_State *L, void *obj, const char *tname) {
+  if (obj == NULL) {
+    lua_pushnil(L);
+    return;
+  }
+  luaL_getmetatable(L, tname);
+  lua_rawgeti(L, -1, PROXY_LIVE);
+  if (lua_rawgetp(L, -1, obj) == LUA_TNIL) {  /* no live proxy? */
+    Proxy *p;
+    lua_pop(L, 1);
+    p = (Proxy *)lua_newuserdatauv(L, sizeof(Proxy), 1);
+    p->obj = obj;
+    lua_pushvalue(L, -3);
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_rawsetp(L, -3, obj);  /* live[obj] = proxy */
+  }
+  lua_replace(L, -3);
+  lua_pop(L, 1);
+}
+
+
+/*
+** Return the host object of the proxy at index 'idx' if it has type
+** 'tname' and was not released, or NULL otherwise.
+*/
+LUALIB_API void *luaL_toproxy (lua_State *L, int idx, const char *tname) {
+  Proxy *p = (Proxy *)luaL_testudata(L, idx, tname);
+  return (p != NULL) ? p->obj : NULL;
+}
+
+
+LUALIB_API void *luaL_checkproxy (lua_State *L, int arg, const char *tname) {
+  Proxy *p = (Proxy *)luaL_checkudata(L, arg, tname);
+  luaL_argcheck(L, p->obj != NULL, arg, "released proxy");
+  return p->obj;
+}
+
+
+static void dropproxy (lua_State *L, void *obj, const char *tname,
+                       int release) {
+  luaL_getmetatable(L, tname);
+  lua_rawgeti(L, -1, PROXY_LIVE);
+  if (lua_rawgetp(L, -1, obj) == LUA_TUSERDATA) {  /* has a live proxy? */
+    lua_pushnil(L);
+    lua_setiuservalue(L, -2, 1);  /* drop its cache */
+    if (release) {
+      ((Proxy *)lua_touserdata(L, -1))->obj = NULL;
+      lua_pushnil(L);
+      lua_rawsetp(L, -3, obj);  /* live[obj] = nil */
+    }
+  }
+  lua_pop(L, 3);
+}
+
+
+/*
+** Drop the cached fields of the proxy of 'obj', to be resolved again
+** after the host object changed.
+*/
+LUALIB_API void luaL_resetproxy (lua_State *L, void *obj, const char *tname) {
+  dropproxy(L, obj, tname, 0);
+}
+
+
+/*
+** Detach the proxy of 'obj' from it, before the host object is deleted;
+** indexing the proxy afterwards raises an error. The caches of its
+** parents still hold it until they are reset.
+*/
+LUALIB_API void luaL_releaseproxy (lua_State *L, void *obj,
+                                      const char *tname) {
+  dropproxy(L, obj, tname, 1);
+}
+
+/* }====================================================== */
+
+
 LUALIB_API void luaL_checkversion_ (lua_State *L, lua_Number ver, size_t sz) {
   lua_Number v = lua_version(L);
   if (sz != LUAL_NUMSIZES)  /* check numeric types */
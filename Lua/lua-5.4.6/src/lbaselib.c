@@ -11,6 +11,7 @@
 
 
 #include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -199,10 +200,12 @@ static int pushmode (lua_State *L, int oldmode) {
 static int luaB_collectgarbage (lua_State *L) {
   static const char *const opts[] = {"stop", "restart", "collect",
     "count", "step", "setpause", "setstepmul",
-    "isrunning", "generational", "incremental", NULL};
+    "isrunning", "generational", "incremental", "budget", "hold", "pauses",
+    NULL};
   static const int optsnum[] = {LUA_GCSTOP, LUA_GCRESTART, LUA_GCCOLLECT,
     LUA_GCCOUNT, LUA_GCSTEP, LUA_GCSETPAUSE, LUA_GCSETSTEPMUL,
-    LUA_GCISRUNNING, LUA_GCGEN, LUA_GCINC};
+    LUA_GCISRUNNING, LUA_GCGEN, LUA_GCINC, LUA_GCBUDGET, LUA_GCHOLD,
+    LUA_GCPAUSES};
   int o = optsnum[luaL_checkoption(L, 1, "collect", opts)];
   switch (o) {
     case LUA_GCCOUNT: {
@@ -233,6 +236,32 @@ static int luaB_collectgarbage (lua_State *L) {
       lua_pushboolean(L, res);
       return 1;
     }
+    case LUA_GCBUDGET: {  /* budget in milliseconds */
+      lua_Number ms = luaL_checknumber(L, 2);
+      int usec = (ms <= 0) ? 0
+               : (ms >= (lua_Number)(INT_MAX / 1000)) ? INT_MAX
+               : (int)(ms * 1000);
+      int res = lua_gc(L, o, usec);
+      checkvalres(res);
+      lua_pushboolean(L, res);
+      return 1;
+    }
+    case LUA_GCHOLD: {  /* limit in Kbytes; none or 0 ends the hold */
+      lua_Integer kb = luaL_optinteger(L, 2, 0);
+      int res = lua_gc(L, o, (kb < 0) ? 0 : (kb > INT_MAX) ? INT_MAX : (int)kb);
+      checkvalres(res);
+      lua_pushboolean(L, res);
+      return 1;
+    }
+    case LUA_GCPAUSES: {
+      lua_GCPauses p;
+      int res = lua_gc(L, o, &p, lua_toboolean(L, 2));
+      checkvalres(res);
+      lua_pushinteger(L, p.steps);
+      lua_pushnumber(L, (lua_Number)p.total);
+      lua_pushnumber(L, (lua_Number)p.max);
+      return 3;
+    }
     case LUA_GCGEN: {
       int minormul = (int)luaL_optinteger(L, 2, 0);
       int majormul = (int)luaL_optinteger(L, 3, 0);
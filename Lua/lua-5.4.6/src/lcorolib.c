@@ -92,10 +92,63 @@ static int luaB_auxwrap (lua_State *L) {
 }
 
 
+/*
+** {======================================================
+** Pool of coroutines
+** =======================================================
+*/
+
+/*
+** Coroutines given to 'coroutine.recycle' are reset and kept in a pool
+** (a sequence in the upvalue of the library functions), up to
+** LUAI_MAXCOPOOL of them. 'coroutine.create' and 'coroutine.wrap' take
+** a coroutine from the pool when there is one, which saves the
+** allocation of a new thread and its stack, and the work of collecting
+** them later. A recycled coroutine must not be used after that call,
+** as it will come back as another coroutine.
+*/
+
+#if !defined(LUAI_MAXCOPOOL)
+#define LUAI_MAXCOPOOL		64
+#endif
+
+#define POOL	lua_upvalueindex(1)
+
+
+/*
+** Pushes a new coroutine, from the pool if possible. A coroutine from
+** the pool gets the hook of 'L', as 'lua_newthread' does.
+*/
+static lua_State *newco (lua_State *L) {
+  lua_State *NL;
+  lua_Integer n = (lua_Integer)lua_rawlen(L, POOL);
+  if (n == 0)
+    return lua_newthread(L);
+  lua_rawgeti(L, POOL, n);
+  lua_pushnil(L);
+  lua_rawseti(L, POOL, n);
+  NL = lua_tothread(L, -1);
+  lua_sethook(NL, lua_gethook(L), lua_gethookmask(L), lua_gethookcount(L));
+  return NL;
+}
+
+
+/* puts the (already reset) coroutine at index 1 in the pool */
+static void poolco (lua_State *L) {
+  lua_Unsigned n = lua_rawlen(L, POOL);
+  if (n < LUAI_MAXCOPOOL) {
+    lua_pushvalue(L, 1);
+    lua_rawseti(L, POOL, (lua_Integer)n + 1);
+  }
+}
+
+/* }====================================================== */
+
+
 static int luaB_cocreate (lua_State *L) {
   lua_State *NL;
   luaL_checktype(L, 1, LUA_TFUNCTION);
-  NL = lua_newthread(L);
+  NL = newco(L);
   lua_pushvalue(L, 1);  /* move function to top */
   lua_xmove(L, NL, 1);  /* move function from L to NL */
   return 1;
@@ -167,13 +220,19 @@ static int luaB_corunning (lua_State *L) {
 }
 
 
-static int luaB_close (lua_State *L) {
+/*
+** Closes the coroutine at index 1 (see 'coroutine.close'); if 'recycle'
+** is true and there were no errors, it then goes to the pool.
+*/
+static int auxclose (lua_State *L, int recycle) {
   lua_State *co = getco(L);
   int status = auxstatus(L, co);
   switch (status) {
     case COS_DEAD: case COS_YIELD: {
       status = lua_closethread(co, L);
       if (status == LUA_OK) {
+        if (recycle)
+          poolco(L);
         lua_pushboolean(L, 1);
         return 1;
       }
@@ -189,6 +248,16 @@ static int luaB_close (lua_State *L) {
 }
 
 
+static int luaB_close (lua_State *L) {
+  return auxclose(L, 0);
+}
+
+
+static int luaB_recycle (lua_State *L) {
+  return auxclose(L, 1);
+}
+
+
 static const luaL_Reg co_funcs[] = {
   {"create", luaB_cocreate},
   {"resume", luaB_coresume},
@@ -198,13 +267,16 @@ static const luaL_Reg co_funcs[] = {
   {"yield", luaB_yield},
   {"isyieldable", luaB_yieldable},
   {"close", luaB_close},
+  {"recycle", luaB_recycle},
   {NULL, NULL}
 };
 
 
 
 LUAMOD_API int luaopen_coroutine (lua_State *L) {
-  luaL_newlib(L, co_funcs);
+  luaL_newlibtable(L, co_funcs);
+  lua_newtable(L);  /* pool of coroutines */
+  luaL_setfuncs(L, co_funcs, 1);
   return 1;
 }
 
@@ -57,6 +57,9 @@
 	luaD_checkstackaux(L, (fsize), luaC_checkGC(L), (void)0)
 
 
+#define next_ci(L)  (L->ci->next ? L->ci->next : luaE_extendCI(L))
+
+
 /* type of protected functions, to be ran by 'runprotected' */
 typedef void (*Pfunc) (lua_State *L, void *ud);
 
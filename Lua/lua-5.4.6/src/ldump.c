@@ -16,6 +16,7 @@
 #include "lua.h"
 
 #include "lobject.h"
+#include "lopcodes.h"
 #include "lstate.h"
 #include "lundump.h"
 
@@ -101,9 +102,26 @@ static void dumpString (DumpState *D, const TString *s) {
 }
 
 
+/*
+** Dump the code of 'f' as the compiler generated it, undoing the
+** quickening of its instructions by the interpreter (see lvm.c). The
+** instructions go through a buffer to keep the writes in large blocks.
+*/
 static void dumpCode (DumpState *D, const Proto *f) {
+  Instruction buff[64];
+  int i, n;
   dumpInt(D, f->sizecode);
-  dumpVector(D, f->code, f->sizecode);
+  for (i = 0; i < f->sizecode; i += n) {
+    int j;
+    n = f->sizecode - i;
+    if (n > cast_int(sizeof(buff) / sizeof(buff[0])))
+      n = cast_int(sizeof(buff) / sizeof(buff[0]));
+    for (j = 0; j < n; j++) {
+      buff[j] = f->code[i + j];
+      SET_OPCODE(buff[j], unquickop(GET_OPCODE(buff[j])));
+    }
+    dumpVector(D, buff, n);
+  }
 }
 
 
@@ -246,6 +246,7 @@ Proto *luaF_newproto (lua_State *L) {
   f->sizep = 0;
   f->code = NULL;
   f->sizecode = 0;
+  f->icache = NULL;
   f->lineinfo = NULL;
   f->sizelineinfo = 0;
   f->abslineinfo = NULL;
@@ -264,8 +265,21 @@ Proto *luaF_newproto (lua_State *L) {
 }
 
 
+/*
+** Create the inline caches of a complete function
+*/
+void luaF_initcache (lua_State *L, Proto *f) {
+  int i;
+  f->icache = luaM_newvectorchecked(L, f->sizecode, unsigned int);
+  for (i = 0; i < f->sizecode; i++)
+    f->icache[i] = 0;
+}
+
+
 void luaF_freeproto (lua_State *L, Proto *f) {
   luaM_freearray(L, f->code, f->sizecode);
+  if (f->icache != NULL)  /* function was completed? */
+    luaM_freearray(L, f->icache, f->sizecode);
   luaM_freearray(L, f->p, f->sizep);
   luaM_freearray(L, f->k, f->sizek);
   luaM_freearray(L, f->lineinfo, f->sizelineinfo);
@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 
 #include "lua.h"
@@ -803,8 +804,7 @@ static void freeobj (lua_State *L, GCObject *o) {
       break;
     }
     case LUA_VLNGSTR: {
-      TString *ts = gco2ts(o);
-      luaM_freemem(L, ts, sizelstring(ts->u.lnglen));
+      luaS_freelngstr(L, gco2ts(o));
       break;
     }
     default: lua_assert(0);
@@ -1685,15 +1685,78 @@ static void incstep (lua_State *L, global_State *g) {
 ** not running, set a reasonable debt to avoid it being called at
 ** every single check.)
 */
+/*
+** Clock (in seconds) used to time collector steps; a monotonic wall
+** clock where available, as the process CPU time also counts other
+** threads
+*/
+#if !defined(l_gcclock)
+
+#if defined(LUA_USE_POSIX) && defined(CLOCK_MONOTONIC)
+static double l_gcclock (void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#else
+#define l_gcclock()	((double)clock() / (double)CLOCKS_PER_SEC)
+#endif
+
+#endif
+
+
+/*
+** Performs a basic GC step if collector is running. Inside a hold
+** (see LUA_GCHOLD), instead, postpones the step until the total memory
+** reaches the hold limit. Steps are timed for LUA_GCPAUSES.
+*/
 void luaC_step (lua_State *L) {
   global_State *g = G(L);
   if (!gcrunning(g))  /* not running? */
     luaE_setdebt(g, -2000);
+  else if (g->gchold != 0 && gettotalbytes(g) < g->gchold)
+    luaE_setdebt(g, -l_castU2S(g->gchold - gettotalbytes(g)));  /* wait */
   else {
+    double t = l_gcclock();
     if(isdecGCmodegen(g))
       genstep(L, g);
     else
       incstep(L, g);
+    t = l_gcclock() - t;
+    g->gcpauses.steps++;
+    g->gcpauses.total += t;
+    if (t > g->gcpauses.max)
+      g->gcpauses.max = t;
+  }
+}
+
+
+/*
+** Performs collector work for about 'usec' microseconds or until the
+** end of the current cycle, ahead of the automatic steps, which get
+** credit for the work done. In generational mode, performs one minor
+** (or major) collection. Returns true if a cycle was completed.
+*/
+int luaC_budget (lua_State *L, int usec) {
+  global_State *g = G(L);
+  if (isdecGCmodegen(g)) {
+    genstep(L, g);
+    return 1;
+  }
+  else {
+    int stepmul = (getgcparam(g->gcstepmul) | 1);  /* avoid division by 0 */
+    l_mem debt = (g->GCdebt / WORK2MEM) * stepmul;
+    double limit = l_gcclock() + (double)usec * 1e-6;
+    if (g->gcstate == GCSpause)  /* start a new cycle */
+      debt -= singlestep(L);
+    while (g->gcstate != GCSpause && l_gcclock() < limit)
+      debt -= singlestep(L);
+    if (g->gcstate == GCSpause) {
+      setpause(g);  /* pause until next cycle */
+      return 1;
+    }
+    luaE_setdebt(g, (debt / stepmul) * WORK2MEM);
+    return 0;
   }
 }
 
@@ -229,9 +229,9 @@ typedef l_uint32 Instruction;
 
 
 /*
-** Size of cache for strings in the API. 'N' is the number of
-** sets (better be a prime) and "M" is the size of each set (M == 1
-** makes a direct cache.)
+** Size of cache for strings in the API. 'N' is the initial number of
+** sets (better be a prime; 'lua_setstrcache' changes it per state) and
+** "M" is the size of each set (M == 1 makes a direct cache.)
 */
 #if !defined(STRCACHE_N)
 #define STRCACHE_N		53
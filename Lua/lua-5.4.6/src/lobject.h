@@ -386,7 +386,7 @@ typedef struct GCObject {
 typedef struct TString {
   CommonHeader;
   lu_byte extra;  /* reserved words for short strings; "has hash" for longs */
-  lu_byte shrlen;  /* length for short strings */
+  lu_byte shrlen;  /* length for short strings; kind for long strings */
   unsigned int hash;
   union {
     size_t lnglen;  /* length for long strings */
@@ -396,11 +396,28 @@ typedef struct TString {
 } TString;
 
 
+/* kinds of long strings */
+#define LSTRREG		0  /* regular: contents follow the header */
+#define LSTREXT		1  /* external: contents in memory owned by the host */
+
+/*
+** An external string keeps, in place of its contents, where they are
+** and how to release them (see 'lua_pushexternalstring')
+*/
+typedef struct ExtString {
+  char *contents;
+  lua_Alloc falloc;  /* to release 'contents' (NULL for no release) */
+  void *ud;  /* user data for 'falloc' */
+} ExtString;
+
+#define isextstr(ts)	((ts)->tt == LUA_VLNGSTR && (ts)->shrlen == LSTREXT)
+#define extstr(ts)	check_exp(isextstr(ts), cast(ExtString *, (ts)->contents))
+
 
 /*
 ** Get the actual string (array of bytes) from a 'TString'.
 */
-#define getstr(ts)  ((ts)->contents)
+#define getstr(ts)  (isextstr(ts) ? extstr(ts)->contents : (ts)->contents)
 
 
 /* get the actual string (array of bytes) from a Lua value */
@@ -565,6 +582,7 @@ typedef struct Proto {
   int lastlinedefined;  /* debug information  */
   TValue *k;  /* constants used by the function */
   Instruction *code;  /* opcodes */
+  unsigned int *icache;  /* inline caches, one per instruction (see lvm.c) */
   struct Proto **p;  /* functions defined inside the function */
   Upvaldesc *upvalues;  /* upvalue information */
   ls_byte *lineinfo;  /* information about source lines (debug information) */
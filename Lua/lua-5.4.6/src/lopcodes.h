@@ -306,11 +306,23 @@ OP_VARARG,/*	A C	R[A], R[A+1], ..., R[A+C-2] = vararg		*/
 
 OP_VARARGPREP,/*A	(adjust vararg parameters)			*/
 
-OP_EXTRAARG/*	Ax	extra (larger) argument for previous opcode	*/
+OP_EXTRAARG,/*	Ax	extra (larger) argument for previous opcode	*/
+
+/* quickened opcodes (see lvm.c), never generated by the compiler */
+OP_ADDII,/*	A B C	R[A] := R[B] + R[C] (integers)			*/
+OP_ADDFF,/*	A B C	R[A] := R[B] + R[C] (floats)			*/
+OP_SUBII,/*	A B C	R[A] := R[B] - R[C] (integers)			*/
+OP_SUBFF,/*	A B C	R[A] := R[B] - R[C] (floats)			*/
+OP_MULII,/*	A B C	R[A] := R[B] * R[C] (integers)			*/
+OP_MULFF/*	A B C	R[A] := R[B] * R[C] (floats)			*/
 } OpCode;
 
 
-#define NUM_OPCODES	((int)(OP_EXTRAARG) + 1)
+#define NUM_OPCODES	((int)(OP_MULFF) + 1)
+
+/* generic opcode of a (possibly quickened) opcode */
+#define unquickop(o)  \
+	((o) >= OP_ADDII ? cast(OpCode, OP_ADD + ((o) - OP_ADDII) / 2) : (o))
 
 
 
@@ -0,0 +1,590 @@
+/*
+** $Id: lproflib.c $
+** Sampling profiler
+** See Copyright Notice in lua.h
+*/
+
+#define lproflib_c
+#define LUA_LIB
+
+#include "lprefix.h"
+
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+/*
+** The profiler takes a sample of the call stack of the main thread
+** every 'interval' VM instructions (a count hook), or, where
+** LUA_USE_POSIX is defined, on every SIGPROF of a CPU-time interval
+** timer. Each sample is the list of active frames from the outermost
+** to the innermost, every frame named by its function and current line,
+** joined by ';'. Equal samples are counted together in a table, which
+** 'profiler.report' writes in the "collapsed stack" format read by
+** flame graph tools ("frame;frame;frame count" per line).
+**
+** Timer sampling is the cheaper mode: between samples no hook is set and
+** the VM runs at full speed, while a count hook, even a sparse one,
+** makes the VM check the hook at every instruction. So, where the timer
+** is available it is the default.
+**
+** The profiler uses the debug hook of the main thread (and of the
+** coroutines it creates while running), so it replaces any hook set
+** with 'debug.sethook'.
+**
+** The allocation profiler ('profiler.allocstart') wraps the allocator
+** of the state. The wrapper counts the allocations and the bytes
+** allocated, and every 'rate' bytes it arms a one-shot hook, as the
+** SIGPROF handler does, since the allocator can neither know the
+** running thread nor inspect a stack it may be in the middle of moving.
+** The hook then charges the allocations counted since the previous
+** sample to the innermost Lua function and line of the main thread (an
+** allocation inside a coroutine is charged to its 'resume'). So the
+** totals are exact and their split among the sites is a sample, which
+** is exact with a rate of 1.
+*/
+
+
+#define PROF_KEY	"_PROFILER"
+
+#define PROF_DEFINTERVAL	1000
+#define PROF_DEFTIMER		1000
+#define PROF_DEFDEPTH		64
+#define PROF_MAXDEPTH		256
+#define PROF_DEFRATE		4096
+
+
+typedef struct Profiler {
+  lua_Integer nsamples;  /* samples taken since the last reset */
+  int maxdepth;  /* frames recorded per sample */
+  int running;
+  int timer;  /* true if sampling on SIGPROF */
+  /* allocation profiling */
+  lua_Alloc allocf;  /* allocator wrapped by 'profalloc' */
+  void *allocud;
+  lua_State *mainL;  /* thread whose hook takes the samples */
+  lua_Integer rate;  /* bytes allocated between samples */
+  lua_Integer left;  /* bytes until the next sample */
+  lua_Integer pcount, pbytes;  /* allocations not charged to a site yet */
+  lua_Integer nallocs;  /* allocation samples since the last reset */
+  int allocating;  /* true if 'profalloc' is the allocator */
+  int armed;  /* true if the hook is set for an allocation sample */
+  int inhook;  /* true while the hook charges a site */
+} Profiler;
+
+
+/*
+** Returns the profiler state, and pushes its sample table, or returns
+** NULL (pushing nothing) if the library was not opened in this state.
+*/
+static Profiler *getprofiler (lua_State *L) {
+  Profiler *p;
+  if (lua_getfield(L, LUA_REGISTRYINDEX, PROF_KEY) != LUA_TUSERDATA) {
+    lua_pop(L, 1);
+    return NULL;
+  }
+  p = (Profiler *)lua_touserdata(L, -1);
+  lua_getiuservalue(L, -1, 1);
+  lua_remove(L, -2);
+  return p;
+}
+
+
+/* adds the name and current line of frame 'ar' to 'b' */
+static void addframe (lua_State *L, luaL_Buffer *b, lua_Debug *ar) {
+  if (*ar->namewhat != '\0')
+    luaL_addstring(b, ar->name);
+  else if (*ar->what == 'm')
+    luaL_addstring(b, "main chunk");
+  else if (*ar->what != 'C') {
+    lua_pushfstring(L, "function <%s:%d>", ar->short_src, ar->linedefined);
+    luaL_addvalue(b);
+  }
+  else
+    luaL_addchar(b, '?');
+  if (ar->currentline > 0)
+    lua_pushfstring(L, " (%s:%d)", ar->short_src, ar->currentline);
+  else
+    lua_pushliteral(L, " [C]");
+  luaL_addvalue(b);
+}
+
+
+/* adds 'n' to the integer at the key on the top in table 't'; pops the key */
+static void addcount (lua_State *L, int t, lua_Integer n) {
+  t = lua_absindex(L, t);
+  lua_pushvalue(L, -1);
+  lua_rawget(L, t);  /* current value */
+  lua_pushinteger(L, lua_tointeger(L, -1) + n);
+  lua_remove(L, -2);
+  lua_rawset(L, t);
+}
+
+
+static void sample (lua_State *L, Profiler *p) {
+  lua_Debug ar[PROF_MAXDEPTH];
+  luaL_Buffer b;
+  int depth = 0;
+  int i;
+  while (depth < p->maxdepth && lua_getstack(L, depth, &ar[depth]))
+    depth++;
+  if (depth == 0)
+    return;
+  luaL_buffinit(L, &b);
+  for (i = depth - 1; i >= 0; i--) {  /* outermost frame first */
+    lua_getinfo(L, "Sln", &ar[i]);
+    if (i < depth - 1)
+      luaL_addchar(&b, ';');
+    addframe(L, &b, &ar[i]);
+  }
+  luaL_pushresult(&b);  /* sample key */
+  lua_pushvalue(L, -1);
+  lua_rawget(L, -3);  /* current count */
+  lua_pushinteger(L, lua_tointeger(L, -1) + 1);
+  lua_remove(L, -2);
+  lua_rawset(L, -3);
+  p->nsamples++;
+}
+
+
+/*
+** Charges the allocations counted since the last allocation sample to
+** the innermost Lua frame, in the site tables (uservalues 2 and 3).
+*/
+static void allocsample (lua_State *L, Profiler *p) {
+  lua_Debug ar;
+  luaL_Buffer b;
+  int level = 0;
+  int found;
+  while ((found = lua_getstack(L, level, &ar)) != 0) {
+    lua_getinfo(L, "Sln", &ar);
+    if (ar.currentline > 0)  /* a Lua function? */
+      break;
+    level++;
+  }
+  lua_getfield(L, LUA_REGISTRYINDEX, PROF_KEY);
+  lua_getiuservalue(L, -1, 2);  /* counts */
+  lua_getiuservalue(L, -2, 3);  /* bytes */
+  luaL_buffinit(L, &b);
+  if (found)
+    addframe(L, &b, &ar);
+  else
+    luaL_addstring(&b, "? [C]");
+  luaL_pushresult(&b);  /* site key */
+  lua_pushvalue(L, -1);
+  addcount(L, -3, p->pbytes);
+  addcount(L, -3, p->pcount);
+  lua_pop(L, 3);
+  p->pcount = p->pbytes = 0;
+  p->left = p->rate;
+  p->nallocs++;
+}
+
+
+static void profhook (lua_State *L, lua_Debug *ar) {
+  Profiler *p = getprofiler(L);
+  (void)ar;
+  if (p == NULL)
+    return;
+  if (p->armed) {  /* allocation sample? */
+    p->inhook = 1;
+    allocsample(L, p);
+    p->inhook = p->armed = 0;
+    if (L != p->mainL)  /* hook inherited by a coroutine? */
+      lua_sethook(p->mainL, NULL, 0, 0);
+  }
+  else if (p->running)
+    sample(L, p);
+  if (p->timer || !p->running)  /* one-shot hook? */
+    lua_sethook(L, NULL, 0, 0);  /* wait for the next one */
+  lua_pop(L, 1);  /* sample table */
+}
+
+
+/*
+** {======================================================
+** SIGPROF timer
+** =======================================================
+*/
+
+#if defined(LUA_USE_POSIX)
+
+#include <signal.h>
+#include <sys/time.h>
+
+#define l_timersupported	1
+
+/* the thread sampled on SIGPROF; only one state can use the timer */
+static lua_State *volatile timerL = NULL;
+
+
+/*
+** Like 'laction' in lua.c: 'lua_sethook' is the only API function that
+** may be called from a signal handler; the hook then takes the sample
+** at the next instruction.
+*/
+static void sigprof (int i) {
+  lua_State *L = timerL;
+  (void)i;
+  if (L != NULL)
+    lua_sethook(L, profhook, LUA_MASKCALL | LUA_MASKRET | LUA_MASKCOUNT, 1);
+}
+
+
+/*
+** Starts (usec > 0) or stops the timer. Uses 'sigaction', as 'signal'
+** may reset the handler after its first call.
+*/
+static int settimer (lua_State *L, int usec) {
+  struct itimerval it;
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  if (usec > 0) {
+    if (timerL != NULL && timerL != L)
+      return 0;  /* timer in use by another state */
+    timerL = L;
+    sa.sa_handler = sigprof;
+    sigaction(SIGPROF, &sa, NULL);
+  }
+  else
+    timerL = NULL;
+  it.it_interval.tv_sec = it.it_value.tv_sec = usec / 1000000;
+  it.it_interval.tv_usec = it.it_value.tv_usec = usec % 1000000;
+  setitimer(ITIMER_PROF, &it, NULL);
+  if (usec <= 0) {
+    sa.sa_handler = SIG_IGN;  /* drop a signal still pending */
+    sigaction(SIGPROF, &sa, NULL);
+  }
+  return 1;
+}
+
+#else
+
+#define l_timersupported	0
+
+static int settimer (lua_State *L, int usec) {
+  (void)L; (void)usec;
+  return 0;
+}
+
+#endif
+
+/* }====================================================== */
+
+
+static lua_State *getmainthread (lua_State *L) {
+  lua_State *L1;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+  L1 = lua_tothread(L, -1);
+  lua_pop(L, 1);
+  return L1;
+}
+
+
+static Profiler *checkprofiler (lua_State *L) {
+  Profiler *p = getprofiler(L);
+  if (p == NULL)
+    luaL_error(L, "profiler not initialized");
+  lua_pop(L, 1);  /* sample table */
+  return p;
+}
+
+
+/*
+** profiler.start([opts]): 'opts' is a table with optional fields
+** 'interval' (VM instructions between samples), 'timer' (microseconds
+** of CPU time between samples) and 'depth' (maximum frames per sample).
+** Without 'interval' or 'timer', samples every PROF_DEFTIMER
+** microseconds if the timer is supported, or else every
+** PROF_DEFINTERVAL instructions.
+*/
+static int prof_start (lua_State *L) {
+  Profiler *p = checkprofiler(L);
+  lua_State *L1 = getmainthread(L);
+  lua_Integer interval = PROF_DEFINTERVAL;
+  lua_Integer usec = l_timersupported ? PROF_DEFTIMER : 0;
+  lua_Integer depth = PROF_DEFDEPTH;
+  if (!lua_isnoneornil(L, 1)) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    if (lua_getfield(L, 1, "interval") != LUA_TNIL) {
+      interval = luaL_checkinteger(L, -1);
+      usec = 0;
+    }
+    if (lua_getfield(L, 1, "timer") != LUA_TNIL)
+      usec = luaL_checkinteger(L, -1);
+    if (lua_getfield(L, 1, "depth") != LUA_TNIL)
+      depth = luaL_checkinteger(L, -1);
+    lua_pop(L, 3);
+  }
+  luaL_argcheck(L, 0 < interval && interval <= INT_MAX, 1,
+                   "invalid interval");
+  luaL_argcheck(L, 0 <= usec && usec <= INT_MAX, 1, "invalid timer");
+  luaL_argcheck(L, 0 < depth && depth <= PROF_MAXDEPTH, 1, "invalid depth");
+  if (p->running || p->allocating)
+    return luaL_error(L, "profiler already running");
+  p->maxdepth = (int)depth;
+  p->timer = (usec > 0);
+  if (p->timer) {
+    if (!l_timersupported)
+      return luaL_error(L, "timer sampling not supported");
+    if (!settimer(L1, (int)usec))
+      return luaL_error(L, "profiler timer used by another state");
+  }
+  else {
+    lua_sethook(L1, profhook, LUA_MASKCOUNT, (int)interval);
+    if (L != L1)  /* started inside a coroutine? */
+      lua_sethook(L, profhook, LUA_MASKCOUNT, (int)interval);
+  }
+  p->running = 1;
+  return 0;
+}
+
+
+static void stopprofiler (lua_State *L, Profiler *p) {
+  lua_State *L1 = getmainthread(L);
+  if (p->timer)
+    settimer(L1, 0);
+  p->running = p->timer = 0;
+  lua_sethook(L1, NULL, 0, 0);
+  if (L != L1)
+    lua_sethook(L, NULL, 0, 0);
+}
+
+
+static int prof_stop (lua_State *L) {
+  Profiler *p = checkprofiler(L);
+  if (p->running)
+    stopprofiler(L, p);
+  lua_pushinteger(L, p->nsamples);
+  return 1;
+}
+
+
+static int prof_reset (lua_State *L) {
+  Profiler *p = checkprofiler(L);
+  int i;
+  lua_getfield(L, LUA_REGISTRYINDEX, PROF_KEY);
+  for (i = 1; i <= 3; i++) {
+    lua_newtable(L);
+    lua_setiuservalue(L, -2, i);
+  }
+  p->nsamples = p->nallocs = 0;
+  p->pcount = p->pbytes = 0;
+  return 0;
+}
+
+
+/* profiler.report(): the samples in collapsed stack format */
+static int prof_report (lua_State *L) {
+  luaL_Buffer b;
+  lua_Integer i, n = 0;
+  int lines;
+  if (getprofiler(L) == NULL)
+    return luaL_error(L, "profiler not initialized");
+  lua_newtable(L);
+  lines = lua_gettop(L);
+  lua_pushnil(L);
+  while (lua_next(L, lines - 1)) {
+    lua_pushfstring(L, "%s %I\n", lua_tostring(L, -2),
+                       (LUAI_UACINT)lua_tointeger(L, -1));
+    lua_rawseti(L, lines, ++n);
+    lua_pop(L, 1);  /* count */
+  }
+  luaL_buffinit(L, &b);
+  for (i = 1; i <= n; i++) {
+    lua_rawgeti(L, lines, i);
+    luaL_addvalue(&b);
+  }
+  luaL_pushresult(&b);
+  return 1;
+}
+
+
+static int prof_samples (lua_State *L) {
+  lua_pushinteger(L, checkprofiler(L)->nsamples);
+  return 1;
+}
+
+
+/*
+** {======================================================
+** Allocation sites
+** =======================================================
+*/
+
+/*
+** The allocator of a state being profiled. When 'ptr' is NULL, 'osize'
+** is the type of the new object, not a size.
+*/
+static void *profalloc (void *ud, void *ptr, size_t osize, size_t nsize) {
+  Profiler *p = (Profiler *)ud;
+  if (!p->inhook && nsize > 0 && (ptr == NULL || nsize > osize)) {
+    size_t grown = (ptr == NULL) ? nsize : nsize - osize;
+    p->pcount += (ptr == NULL);
+    p->pbytes += (lua_Integer)grown;
+    p->left -= (lua_Integer)grown;
+    if (p->left <= 0 && !p->armed) {
+      p->armed = 1;
+      lua_sethook(p->mainL, profhook,
+                  LUA_MASKCALL | LUA_MASKRET | LUA_MASKCOUNT, 1);
+    }
+  }
+  return p->allocf(p->allocud, ptr, osize, nsize);
+}
+
+
+static void stopalloc (lua_State *L, Profiler *p) {
+  lua_setallocf(L, p->allocf, p->allocud);
+  p->allocating = 0;
+  if (p->armed) {
+    p->armed = 0;
+    lua_sethook(p->mainL, NULL, 0, 0);
+  }
+}
+
+
+/*
+** profiler.allocstart([opts]): 'opts' is a table with an optional field
+** 'rate', the bytes allocated between samples.
+*/
+static int prof_allocstart (lua_State *L) {
+  Profiler *p = checkprofiler(L);
+  lua_Integer rate = PROF_DEFRATE;
+  if (!lua_isnoneornil(L, 1)) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    if (lua_getfield(L, 1, "rate") != LUA_TNIL)
+      rate = luaL_checkinteger(L, -1);
+    lua_pop(L, 1);
+  }
+  luaL_argcheck(L, 0 < rate, 1, "invalid rate");
+  if (p->running || p->allocating)
+    return luaL_error(L, "profiler already running");
+  p->mainL = getmainthread(L);
+  p->rate = p->left = rate;
+  p->pcount = p->pbytes = 0;
+  p->allocf = lua_getallocf(L, &p->allocud);
+  p->allocating = 1;
+  lua_setallocf(L, profalloc, p);
+  return 0;
+}
+
+
+static int prof_allocstop (lua_State *L) {
+  Profiler *p = checkprofiler(L);
+  if (p->allocating)
+    stopalloc(L, p);
+  lua_pushinteger(L, p->nallocs);
+  return 1;
+}
+
+
+typedef struct Site {
+  const char *name;
+  lua_Integer count, bytes;
+} Site;
+
+
+static int cmpsite (const void *a, const void *b) {
+  lua_Integer x = ((const Site *)a)->bytes, y = ((const Site *)b)->bytes;
+  return (x < y) - (x > y);  /* most bytes first */
+}
+
+
+/*
+** profiler.allocreport(): a line "site count bytes" per site, by
+** decreasing bytes
+*/
+static int prof_allocreport (lua_State *L) {
+  luaL_Buffer b;
+  Site *sites;
+  size_t i, n = 0;
+  int counts;
+  checkprofiler(L);
+  lua_getfield(L, LUA_REGISTRYINDEX, PROF_KEY);
+  lua_getiuservalue(L, -1, 2);
+  counts = lua_gettop(L);
+  lua_getiuservalue(L, -2, 3);
+  lua_pushnil(L);
+  while (lua_next(L, counts + 1)) {
+    n++;
+    lua_pop(L, 1);
+  }
+  sites = (Site *)lua_newuserdatauv(L, (n > 0 ? n : 1) * sizeof(Site), 0);
+  n = 0;
+  lua_pushnil(L);
+  while (lua_next(L, counts + 1)) {  /* keys stay in the table */
+    sites[n].name = lua_tostring(L, -2);
+    sites[n].bytes = lua_tointeger(L, -1);
+    lua_pushvalue(L, -2);
+    lua_rawget(L, counts);
+    sites[n++].count = lua_tointeger(L, -1);
+    lua_pop(L, 2);
+  }
+  qsort(sites, n, sizeof(Site), cmpsite);
+  luaL_buffinit(L, &b);
+  for (i = 0; i < n; i++) {
+    lua_pushfstring(L, "%s %I %I\n", sites[i].name,
+                       (LUAI_UACINT)sites[i].count,
+                       (LUAI_UACINT)sites[i].bytes);
+    luaL_addvalue(&b);
+  }
+  luaL_pushresult(&b);
+  return 1;
+}
+
+/* }====================================================== */
+
+
+static const luaL_Reg prof_funcs[] = {
+  {"start", prof_start},
+  {"stop", prof_stop},
+  {"reset", prof_reset},
+  {"report", prof_report},
+  {"samples", prof_samples},
+  {"allocstart", prof_allocstart},
+  {"allocstop", prof_allocstop},
+  {"allocreport", prof_allocreport},
+  {NULL, NULL}
+};
+
+
+static int prof_gc (lua_State *L) {
+  Profiler *p = (Profiler *)lua_touserdata(L, 1);
+  if (p->timer)
+    settimer(L, 0);
+  if (p->allocating)  /* the state outlives the profiler */
+    lua_setallocf(L, p->allocf, p->allocud);
+  return 0;
+}
+
+
+LUAMOD_API int luaopen_profiler (lua_State *L) {
+  Profiler *p;
+  luaL_newlib(L, prof_funcs);
+  if (lua_getfield(L, LUA_REGISTRYINDEX, PROF_KEY) == LUA_TNIL) {
+    p = (Profiler *)lua_newuserdatauv(L, sizeof(Profiler), 3);
+    memset(p, 0, sizeof(Profiler));
+    lua_newtable(L);  /* sample table */
+    lua_setiuservalue(L, -2, 1);
+    lua_newtable(L);  /* allocations per site */
+    lua_setiuservalue(L, -2, 2);
+    lua_newtable(L);  /* bytes per site */
+    lua_setiuservalue(L, -2, 3);
+    lua_newtable(L);  /* metatable to stop the timer when the state closes */
+    lua_pushcfunction(L, prof_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_setmetatable(L, -2);
+    lua_setfield(L, LUA_REGISTRYINDEX, PROF_KEY);
+  }
+  lua_pop(L, 1);
+  return 1;
+}
@@ -0,0 +1,456 @@
+/*
+** $Id: lserlib.c $
+** Binary serialization of Lua values
+** See Copyright Notice in lua.h
+*/
+
+#define lserlib_c
+#define LUA_LIB
+
+#include "lprefix.h"
+
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+/*
+** 'serial.encode(...)' turns nil, booleans, numbers, strings and tables
+** (of these values) into a compact binary string, which
+** 'serial.decode' turns back into equal values, in this or in another
+** state (e.g., one of a worker). Tables are encoded with their sizes,
+** so that decoding creates them presized. A table or a string (longer
+** than 2 bytes) found again is encoded as a reference to its first
+** occurrence: shared subtables stay shared, cycles are kept, and
+** repeated keys take a few bytes each. Metatables are not encoded.
+**
+** Format: a header (signature, version, size of integers and byte
+** order), then the values, each one a tag byte followed by its data.
+** Integers and lengths are variable-length (7 bits per byte, lowest
+** first; signed integers zigzag-encoded); floats are 8 bytes in the
+** byte order of the header. A table is its array size, the number of
+** its other pairs (4 bytes, little endian), the values of its array
+** part and then the other pairs. Decoding checks the header and the
+** bounds of every item, so corrupted data raises an error.
+*/
+
+
+#define SER_SIGNATURE	"\x1bLsr"
+#define SER_VERSION	1
+#define SER_HEADERSIZE	(sizeof(SER_SIGNATURE) - 1 + 3)
+
+#define SER_MAXNESTING	200
+
+/* strings longer than this can be references */
+#define SER_MINREFSTR	2
+
+
+/* value tags */
+#define T_NIL		0
+#define T_FALSE		1
+#define T_TRUE		2
+#define T_INT		3
+#define T_FLT		4
+#define T_STR		5
+#define T_TABLE		6
+#define T_REF		7
+
+
+/* byte order of this machine (1 for little endian) */
+static int littleendian (void) {
+  const union { int dummy; char little; } nativeendian = {1};
+  return nativeendian.little;
+}
+
+
+/*
+** {======================================================
+** Encoding
+** =======================================================
+*/
+
+/*
+** Output buffer. It lives in a userdata box, which frees the block if
+** an error interrupts the encoding. (A 'luaL_Buffer' cannot be used,
+** as encoding tables uses the stack.)
+*/
+typedef struct SerBuffer {
+  char *b;
+  size_t n;  /* bytes in use */
+  size_t size;  /* bytes allocated */
+} SerBuffer;
+
+
+typedef struct Encoder {
+  lua_State *L;
+  SerBuffer *B;
+  int seen;  /* index of table from objects already encoded to their ids */
+  lua_Integer nids;  /* ids given */
+} Encoder;
+
+
+static int serbuf_gc (lua_State *L) {
+  SerBuffer *B = (SerBuffer *)lua_touserdata(L, 1);
+  free(B->b);
+  B->b = NULL;
+  return 0;
+}
+
+
+static SerBuffer *newserbuffer (lua_State *L) {
+  SerBuffer *B = (SerBuffer *)lua_newuserdatauv(L, sizeof(SerBuffer), 0);
+  B->b = NULL;
+  B->n = B->size = 0;
+  if (luaL_newmetatable(L, "serial.Buffer")) {
+    lua_pushcfunction(L, serbuf_gc);
+    lua_setfield(L, -2, "__gc");
+  }
+  lua_setmetatable(L, -2);
+  return B;
+}
+
+
+/* reserves 'l' bytes at the end of the buffer; returns them */
+static char *reserve (Encoder *E, size_t l) {
+  SerBuffer *B = E->B;
+  char *p;
+  if (B->size - B->n < l) {
+    size_t newsize = (B->size < 256) ? 256 : B->size * 2;
+    char *nb;
+    while (newsize - B->n < l)
+      newsize *= 2;
+    nb = (char *)realloc(B->b, newsize);
+    if (nb == NULL)
+      luaL_error(E->L, "not enough memory");
+    B->b = nb;
+    B->size = newsize;
+  }
+  p = B->b + B->n;
+  B->n += l;
+  return p;
+}
+
+
+static void addbyte (Encoder *E, int c) {
+  *reserve(E, 1) = (char)c;
+}
+
+
+static void adduint (Encoder *E, lua_Unsigned u) {
+  char buff[(sizeof(lua_Unsigned) * CHAR_BIT + 6) / 7];
+  int n = 0;
+  do {
+    buff[n++] = (char)((u & 0x7f) | (u > 0x7f ? 0x80 : 0));
+    u >>= 7;
+  } while (u != 0);
+  memcpy(reserve(E, n), buff, n);
+}
+
+
+static void addint (Encoder *E, lua_Integer i) {
+  lua_Unsigned u = (lua_Unsigned)i;
+  adduint(E, (i < 0) ? ~(u << 1) : (u << 1));  /* zigzag */
+}
+
+
+static void addfloat (Encoder *E, lua_Number x) {
+  double d = (double)x;
+  memcpy(reserve(E, sizeof(d)), &d, sizeof(d));
+}
+
+
+/*
+** If the object at 'idx' was already encoded, encodes a reference to
+** it and returns 1; otherwise gives it the next id and returns 0.
+*/
+static int addref (Encoder *E, int idx) {
+  lua_State *L = E->L;
+  lua_pushvalue(L, idx);
+  if (lua_rawget(L, E->seen) == LUA_TNUMBER) {
+    addbyte(E, T_REF);
+    adduint(E, (lua_Unsigned)lua_tointeger(L, -1));
+    lua_pop(L, 1);
+    return 1;
+  }
+  lua_pop(L, 1);
+  lua_pushvalue(L, idx);
+  lua_pushinteger(L, ++E->nids);
+  lua_rawset(L, E->seen);
+  return 0;
+}
+
+
+static void encode (Encoder *E, int idx, int level);
+
+static void encodetable (Encoder *E, int idx, int level) {
+  lua_State *L = E->L;
+  lua_Unsigned narr = lua_rawlen(L, idx);
+  lua_Unsigned i, nhash = 0;
+  size_t counter;
+  if (level >= SER_MAXNESTING)
+    luaL_error(L, "table too deep to serialize");
+  luaL_checkstack(L, 4, "table too deep to serialize");
+  addbyte(E, T_TABLE);
+  adduint(E, narr);
+  counter = E->B->n;  /* room for the number of other pairs */
+  reserve(E, 4);
+  for (i = 1; i <= narr; i++) {  /* array part */
+    lua_rawgeti(L, idx, (lua_Integer)i);
+    encode(E, lua_gettop(L), level + 1);
+    lua_pop(L, 1);
+  }
+  lua_pushnil(L);
+  while (lua_next(L, idx)) {  /* other pairs */
+    int top = lua_gettop(L);
+    if (lua_isinteger(L, top - 1)) {
+      lua_Integer k = lua_tointeger(L, top - 1);
+      if (1 <= k && (lua_Unsigned)k <= narr) {  /* in the array part? */
+        lua_pop(L, 1);
+        continue;
+      }
+    }
+    encode(E, top - 1, level + 1);  /* key */
+    encode(E, top, level + 1);  /* value */
+    lua_pop(L, 1);
+    nhash++;
+  }
+  if (nhash > 0xffffffffu)
+    luaL_error(L, "table too large to serialize");
+  for (i = 0; i < 4; i++)  /* store count (little endian) */
+    E->B->b[counter + i] = (char)((nhash >> (8 * i)) & 0xff);
+}
+
+
+static void encode (Encoder *E, int idx, int level) {
+  lua_State *L = E->L;
+  switch (lua_type(L, idx)) {
+    case LUA_TNIL: addbyte(E, T_NIL); break;
+    case LUA_TBOOLEAN:
+      addbyte(E, lua_toboolean(L, idx) ? T_TRUE : T_FALSE);
+      break;
+    case LUA_TNUMBER: {
+      if (lua_isinteger(L, idx)) {
+        addbyte(E, T_INT);
+        addint(E, lua_tointeger(L, idx));
+      }
+      else {
+        addbyte(E, T_FLT);
+        addfloat(E, lua_tonumber(L, idx));
+      }
+      break;
+    }
+    case LUA_TSTRING: {
+      size_t l;
+      const char *s = lua_tolstring(L, idx, &l);
+      if (l > SER_MINREFSTR && addref(E, idx))
+        break;
+      addbyte(E, T_STR);
+      adduint(E, (lua_Unsigned)l);
+      memcpy(reserve(E, l), s, l);
+      break;
+    }
+    case LUA_TTABLE: {
+      if (!addref(E, idx))
+        encodetable(E, idx, level);
+      break;
+    }
+    default:
+      luaL_error(L, "cannot serialize a %s", luaL_typename(L, idx));
+  }
+}
+
+
+static int ser_encode (lua_State *L) {
+  Encoder E;
+  int i, n = lua_gettop(L);
+  char *h;
+  luaL_checkstack(L, 4, "too many values to serialize");
+  lua_newtable(L);  /* ids of encoded tables and strings */
+  E.seen = lua_gettop(L);
+  E.L = L;
+  E.B = newserbuffer(L);
+  E.nids = 0;
+  h = reserve(&E, SER_HEADERSIZE);
+  memcpy(h, SER_SIGNATURE, sizeof(SER_SIGNATURE) - 1);
+  h += sizeof(SER_SIGNATURE) - 1;
+  h[0] = SER_VERSION;
+  h[1] = (char)sizeof(lua_Integer);
+  h[2] = (char)littleendian();
+  for (i = 1; i <= n; i++)
+    encode(&E, i, 0);
+  lua_pushlstring(L, E.B->b, E.B->n);
+  return 1;
+}
+
+/* }====================================================== */
+
+
+/*
+** {======================================================
+** Decoding
+** =======================================================
+*/
+
+typedef struct Decoder {
+  lua_State *L;
+  const char *p;  /* next byte to read */
+  const char *end;
+  int refs;  /* index of table from ids to decoded objects */
+  lua_Integer nids;  /* ids given */
+} Decoder;
+
+
+static int corrupted (Decoder *D) {
+  return luaL_error(D->L, "corrupted serialized data");
+}
+
+
+static int getbyte (Decoder *D) {
+  if (D->p >= D->end)
+    corrupted(D);
+  return (unsigned char)*D->p++;
+}
+
+
+static const char *getbytes (Decoder *D, size_t l) {
+  const char *p = D->p;
+  if ((size_t)(D->end - D->p) < l)
+    corrupted(D);
+  D->p += l;
+  return p;
+}
+
+
+static lua_Unsigned getuint (Decoder *D) {
+  lua_Unsigned u = 0;
+  int shift = 0;
+  int c;
+  do {
+    if (shift >= (int)(sizeof(lua_Unsigned) * CHAR_BIT))
+      corrupted(D);  /* too many bytes */
+    c = getbyte(D);
+    u |= (lua_Unsigned)(c & 0x7f) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  return u;
+}
+
+
+/* gives the next id to the object on the top */
+static void newref (Decoder *D) {
+  lua_pushvalue(D->L, -1);
+  lua_rawseti(D->L, D->refs, ++D->nids);
+}
+
+
+static void decode (Decoder *D, int level) {
+  lua_State *L = D->L;
+  luaL_checkstack(L, 3, "serialized data too deep");
+  switch (getbyte(D)) {
+    case T_NIL: lua_pushnil(L); break;
+    case T_FALSE: lua_pushboolean(L, 0); break;
+    case T_TRUE: lua_pushboolean(L, 1); break;
+    case T_INT: {
+      lua_Unsigned u = getuint(D);
+      lua_pushinteger(L, (lua_Integer)((u & 1) ? ~(u >> 1) : (u >> 1)));
+      break;
+    }
+    case T_FLT: {
+      double d;
+      memcpy(&d, getbytes(D, sizeof(d)), sizeof(d));
+      lua_pushnumber(L, (lua_Number)d);
+      break;
+    }
+    case T_STR: {
+      lua_Unsigned l = getuint(D);
+      if (l > (lua_Unsigned)(D->end - D->p))
+        corrupted(D);
+      lua_pushlstring(L, getbytes(D, (size_t)l), (size_t)l);
+      if (l > SER_MINREFSTR)
+        newref(D);
+      break;
+    }
+    case T_TABLE: {
+      lua_Unsigned narr = getuint(D);
+      lua_Unsigned i, nhash = 0;
+      const unsigned char *c = (const unsigned char *)getbytes(D, 4);
+      for (i = 0; i < 4; i++)
+        nhash |= (lua_Unsigned)c[i] << (8 * i);
+      /* each element takes at least one byte, each pair two */
+      if (level >= SER_MAXNESTING || narr > (lua_Unsigned)(D->end - D->p) ||
+          nhash > (lua_Unsigned)(D->end - D->p) / 2 ||
+          narr > INT_MAX || nhash > INT_MAX)
+        corrupted(D);
+      lua_createtable(L, (int)narr, (int)nhash);
+      newref(D);
+      for (i = 1; i <= narr; i++) {
+        decode(D, level + 1);
+        lua_rawseti(L, -2, (lua_Integer)i);
+      }
+      for (i = 0; i < nhash; i++) {
+        decode(D, level + 1);  /* key */
+        decode(D, level + 1);  /* value */
+        lua_rawset(L, -3);  /* (raises an error for nil or NaN keys) */
+      }
+      break;
+    }
+    case T_REF: {
+      lua_Unsigned id = getuint(D);
+      if (id < 1 || id > (lua_Unsigned)D->nids)
+        corrupted(D);
+      lua_rawgeti(L, D->refs, (lua_Integer)id);
+      break;
+    }
+    default: corrupted(D);
+  }
+}
+
+
+static int ser_decode (lua_State *L) {
+  Decoder D;
+  size_t l;
+  const char *s = luaL_checklstring(L, 1, &l);
+  int n;
+  D.L = L;
+  D.p = s;
+  D.end = s + l;
+  if ((size_t)(D.end - D.p) < SER_HEADERSIZE ||
+      memcmp(D.p, SER_SIGNATURE, sizeof(SER_SIGNATURE) - 1) != 0)
+    return luaL_error(L, "not serialized data");
+  D.p += sizeof(SER_SIGNATURE) - 1;
+  if (D.p[0] != SER_VERSION || D.p[1] != (char)sizeof(lua_Integer) ||
+      D.p[2] != (char)littleendian())
+    return luaL_error(L, "serialized data from an incompatible version "
+                         "or machine");
+  D.p += 3;
+  lua_settop(L, 1);
+  lua_newtable(L);  /* decoded tables and strings by id */
+  D.refs = 2;
+  D.nids = 0;
+  for (n = 0; D.p < D.end; n++) {
+    luaL_checkstack(L, 1, "too many serialized values");
+    decode(&D, 0);
+  }
+  return n;
+}
+
+/* }====================================================== */
+
+
+static const luaL_Reg ser_funcs[] = {
+  {"encode", ser_encode},
+  {"decode", ser_decode},
+  {NULL, NULL}
+};
+
+
+LUAMOD_API int luaopen_serial (lua_State *L) {
+  luaL_newlib(L, ser_funcs);
+  return 1;
+}
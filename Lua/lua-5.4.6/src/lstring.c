@@ -40,6 +40,41 @@ int luaS_eqlngstr (TString *a, TString *b) {
 }
 
 
+#if !defined(LUA_USE_C89)
+
+/*
+** Multiply-xorshift hash over 8-byte words, in the style of wyhash.
+** Each word is mixed with a full 64-bit multiply, so every byte affects
+** all bits of the result and long names that differ only near their
+** ends still spread well; the seed keeps the hash randomized per state.
+*/
+typedef unsigned long long l_hword;
+
+#define HASHMUL1	0x9E3779B97F4A7C15ULL
+#define HASHMUL2	0xBF58476D1CE4E5B9ULL
+
+#define mixword(h,w)	((h) = ((h) ^ (w)) * HASHMUL2, (h) ^= (h) >> 29)
+
+unsigned int luaS_hash (const char *str, size_t l, unsigned int seed) {
+  l_hword h = ((l_hword)seed ^ (l_hword)l) * HASHMUL1;
+  l_hword w;
+  for (; l >= sizeof(w); l -= sizeof(w), str += sizeof(w)) {
+    memcpy(&w, str, sizeof(w));
+    mixword(h, w);
+  }
+  if (l > 0) {  /* last partial word */
+    w = 0;
+    memcpy(&w, str, l);
+    mixword(h, w);
+  }
+  h ^= h >> 32;
+  h *= HASHMUL1;
+  h ^= h >> 29;
+  return cast_uint(h);
+}
+
+#else
+
 unsigned int luaS_hash (const char *str, size_t l, unsigned int seed) {
   unsigned int h = seed ^ cast_uint(l);
   for (; l > 0; l--)
@@ -47,6 +82,8 @@ unsigned int luaS_hash (const char *str, size_t l, unsigned int seed) {
   return h;
 }
 
+#endif
+
 
 unsigned int luaS_hashlongstr (TString *ts) {
   lua_assert(ts->tt == LUA_VLNGSTR);
@@ -108,12 +145,26 @@ void luaS_resize (lua_State *L, int nsize) {
 ** a non-collectable string.)
 */
 void luaS_clearcache (global_State *g) {
-  int i, j;
-  for (i = 0; i < STRCACHE_N; i++)
-    for (j = 0; j < STRCACHE_M; j++) {
-      if (iswhite(g->strcache[i][j]))  /* will entry be collected? */
-        g->strcache[i][j] = g->memerrmsg;  /* replace it with something fixed */
-    }
+  unsigned int i;
+  for (i = 0; i < g->strcachesize * STRCACHE_M; i++) {
+    if (iswhite(g->strcache[i]))  /* will entry be collected? */
+      g->strcache[i] = g->memerrmsg;  /* replace it with something fixed */
+  }
+}
+
+
+/*
+** Resize the API string cache to 'nsets' sets of STRCACHE_M entries
+*/
+void luaS_resizecache (lua_State *L, unsigned int nsets) {
+  global_State *g = G(L);
+  TString **newcache = luaM_newvector(L, nsets * STRCACHE_M, TString*);
+  unsigned int i;
+  for (i = 0; i < nsets * STRCACHE_M; i++)  /* fill cache with valid strings */
+    newcache[i] = g->memerrmsg;
+  luaM_freearray(L, g->strcache, g->strcachesize * STRCACHE_M);
+  g->strcache = newcache;
+  g->strcachesize = nsets;
 }
 
 
@@ -122,7 +173,6 @@ void luaS_clearcache (global_State *g) {
 */
 void luaS_init (lua_State *L) {
   global_State *g = G(L);
-  int i, j;
   stringtable *tb = &G(L)->strt;
   tb->hash = luaM_newvector(L, MINSTRTABSIZE, TString*);
   tablerehash(tb->hash, 0, MINSTRTABSIZE);  /* clear array */
@@ -130,9 +180,7 @@ void luaS_init (lua_State *L) {
   /* pre-create memory-error message */
   g->memerrmsg = luaS_newliteral(L, MEMERRMSG);
   luaC_fix(L, obj2gco(g->memerrmsg));  /* it should never be collected */
-  for (i = 0; i < STRCACHE_N; i++)  /* fill cache with valid strings */
-    for (j = 0; j < STRCACHE_M; j++)
-      g->strcache[i][j] = g->memerrmsg;
+  luaS_resizecache(L, STRCACHE_N);
 }
 
 
@@ -149,18 +197,86 @@ static TString *createstrobj (lua_State *L, size_t l, int tag, unsigned int h) {
   ts = gco2ts(o);
   ts->hash = h;
   ts->extra = 0;
-  getstr(ts)[l] = '\0';  /* ending 0 */
+  ts->contents[l] = '\0';  /* ending 0 ('shrlen' is not set yet) */
   return ts;
 }
 
 
 TString *luaS_createlngstrobj (lua_State *L, size_t l) {
   TString *ts = createstrobj(L, l, LUA_VLNGSTR, G(L)->seed);
+  ts->shrlen = LSTRREG;
   ts->u.lnglen = l;
   return ts;
 }
 
 
+/*
+** Arguments and result of 'newextlstr'.
+*/
+typedef struct ExtArgs {
+  const char *s;
+  size_t l;
+  lua_Alloc falloc;
+  void *ud;
+  TString *ts;
+} ExtArgs;
+
+
+static void newextlstr (lua_State *L, void *ud) {
+  ExtArgs *a = cast(ExtArgs *, ud);
+  if (a->l <= LUAI_MAXSHORTLEN)
+    a->ts = luaS_newlstr(L, a->s, a->l);
+  else {
+    TString *ts = gco2ts(luaC_newobj(L, LUA_VLNGSTR, sizeextstr));
+    ExtString *e;
+    ts->hash = G(L)->seed;
+    ts->extra = 0;
+    ts->shrlen = LSTREXT;
+    ts->u.lnglen = a->l;
+    e = extstr(ts);
+    e->contents = cast_charp(a->s);
+    e->falloc = a->falloc;
+    e->ud = a->ud;
+    a->ts = ts;
+  }
+}
+
+
+/*
+** Create a string with the contents 's[0..l-1]', which must be followed
+** by a '\0'. A long string refers to 's' until it is collected, when
+** 'falloc' (if not NULL) releases it; a short one is a copy, and 's' is
+** released right away. 's' is also released when the string cannot be
+** created, before the error is propagated.
+*/
+TString *luaS_newextlstr (lua_State *L, const char *s, size_t l,
+                          lua_Alloc falloc, void *ud) {
+  ExtArgs a;
+  int status;
+  a.s = s; a.l = l; a.falloc = falloc; a.ud = ud; a.ts = NULL;
+  status = luaD_rawrunprotected(L, newextlstr, &a);
+  if (l_unlikely(status != LUA_OK) || l <= LUAI_MAXSHORTLEN) {
+    if (falloc != NULL)  /* 's' not kept by a string? */
+      (*falloc)(ud, cast_voidp(s), l + 1, 0);
+    if (status != LUA_OK)
+      luaD_throw(L, status);
+  }
+  return a.ts;
+}
+
+
+void luaS_freelngstr (lua_State *L, TString *ts) {
+  if (isextstr(ts)) {
+    ExtString *e = extstr(ts);
+    if (e->falloc != NULL)
+      (*e->falloc)(e->ud, e->contents, ts->u.lnglen + 1, 0);
+    luaM_freemem(L, ts, sizeextstr);
+  }
+  else
+    luaM_freemem(L, ts, sizelstring(ts->u.lnglen));
+}
+
+
 void luaS_remove (lua_State *L, TString *ts) {
   stringtable *tb = &G(L)->strt;
   TString **p = &tb->hash[lmod(ts->hash, tb->size)];
@@ -239,9 +355,10 @@ TString *luaS_newlstr (lua_State *L, const char *str, size_t l) {
 ** check hits.
 */
 TString *luaS_new (lua_State *L, const char *str) {
-  unsigned int i = point2uint(str) % STRCACHE_N;  /* hash */
+  global_State *g = G(L);
+  unsigned int i = point2uint(str) % g->strcachesize;  /* hash */
   int j;
-  TString **p = G(L)->strcache[i];
+  TString **p = &g->strcache[i * STRCACHE_M];
   for (j = 0; j < STRCACHE_M; j++) {
     if (strcmp(str, getstr(p[j])) == 0)  /* hit? */
       return p[j];  /* that is it */
@@ -178,6 +178,16 @@ static int tconcat (lua_State *L) {
 ** =======================================================
 */
 
+static int tcreate (lua_State *L) {
+  lua_Integer narr = luaL_checkinteger(L, 1);
+  lua_Integer nrec = luaL_optinteger(L, 2, 0);
+  luaL_argcheck(L, 0 <= narr && narr <= INT_MAX, 1, "out of range");
+  luaL_argcheck(L, 0 <= nrec && nrec <= INT_MAX, 2, "out of range");
+  lua_createtable(L, (int)narr, (int)nrec);
+  return 1;
+}
+
+
 static int tpack (lua_State *L) {
   int i;
   int n = lua_gettop(L);  /* number of elements to pack */
@@ -413,6 +423,7 @@ static int sort (lua_State *L) {
 
 static const luaL_Reg tab_funcs[] = {
   {"concat", tconcat},
+  {"create", tcreate},
   {"insert", tinsert},
   {"pack", tpack},
   {"unpack", tunpack},
@@ -31,6 +31,11 @@
 
 #define LUA_INITVARVERSION	LUA_INIT_VAR LUA_VERSUFFIX
 
+/* directory of the bytecode cache of scripts, see 'luaL_loadfilecached' */
+#if !defined(LUA_CACHEDIR_VAR)
+#define LUA_CACHEDIR_VAR	"LUA_CACHEDIR"
+#endif
+
 
 static lua_State *globalL = NULL;
 
@@ -250,7 +255,7 @@ static int handle_script (lua_State *L, char **argv) {
   const char *fname = argv[0];
   if (strcmp(fname, "-") == 0 && strcmp(argv[-1], "--") != 0)
     fname = NULL;  /* stdin */
-  status = luaL_loadfile(L, fname);
+  status = luaL_loadfilecached(L, fname, getenv(LUA_CACHEDIR_VAR));
   if (status == LUA_OK) {
     int n = pushargs(L);  /* push arguments to script */
     status = docall(L, n, LUA_MULTRET);
@@ -964,6 +964,49 @@ void luaV_finishOp (lua_State *L) {
   op_arith_aux(L, v1, v2, iop, fop); }
 
 
+/*
+** Arithmetic operations with register operands that may be quickened
+** into 'opii' or 'opff'.
+*/
+#define op_arithQ(L,iop,fop,opii,opff) {  \
+  TValue *v1 = vRB(i);  \
+  TValue *v2 = vRC(i);  \
+  quicken(v1, v2, opii, opff);  \
+  op_arith_aux(L, v1, v2, iop, fop); }
+
+
+/*
+** Quickened arithmetic operations over two integers; with other
+** operands, undo the quickening into 'op'.
+*/
+#define op_arithII(L,iop,fop,op) {  \
+  TValue *v1 = vRB(i);  \
+  TValue *v2 = vRC(i);  \
+  if (l_likely(ttisinteger(v1) && ttisinteger(v2))) {  \
+    StkId ra = RA(i); \
+    pc++; setivalue(s2v(ra), iop(L, ivalue(v1), ivalue(v2)));  \
+  }  \
+  else {  \
+    unquicken(op);  \
+    op_arith_aux(L, v1, v2, iop, fop); }}
+
+
+/*
+** Quickened arithmetic operations over two floats; with other
+** operands, undo the quickening into 'op'.
+*/
+#define op_arithFF(L,iop,fop,op) {  \
+  TValue *v1 = vRB(i);  \
+  TValue *v2 = vRC(i);  \
+  if (l_likely(ttisfloat(v1) && ttisfloat(v2))) {  \
+    StkId ra = RA(i); \
+    pc++; setfltvalue(s2v(ra), fop(L, fltvalue(v1), fltvalue(v2)));  \
+  }  \
+  else {  \
+    unquicken(op);  \
+    op_arith_aux(L, v1, v2, iop, fop); }}
+
+
 /*
 ** Arithmetic operations with K operands.
 */
@@ -1045,6 +1088,160 @@ void luaV_finishOp (lua_State *L) {
 /* }================================================================== */
 
 
+/*
+** {==================================================================
+** Inline caches
+** ===================================================================
+*/
+
+/*
+** Each instruction of a function has an inline cache ('Proto.icache'),
+** used by the instructions that index a table with a constant short
+** string (OP_GETTABUP, OP_GETFIELD, OP_SELF, OP_SETTABUP, OP_SETFIELD).
+** It keeps the index of the node where the key was found the last time
+** the instruction ran. As Lua tables have no shapes, a hit is checked
+** directly: the node at that index must hold the same (interned) key.
+** Tables filled with the same keys in the same order, such as the
+** objects built by one constructor, place each key at the same node,
+** so the cache also hits across them. On a miss, the key is looked up
+** by its hash as usual, and the cache is updated.
+*/
+
+
+/* inline cache of the instruction being executed */
+#define icache()	(&cl->p->icache[pc - cl->p->code - 1])
+
+
+/*
+** Get the value of short string 'key' in table 't', using and updating
+** the inline cache '*ic'. Like 'luaH_getshortstr', returns the absent
+** key if 'key' is not in the table.
+*/
+l_sinline const TValue *getcached (Table *t, TString *key, unsigned int *ic) {
+  const TValue *slot;
+  if (*ic < cast_uint(sizenode(t))) {
+    Node *n = gnode(t, *ic);
+    if (keyisshrstr(n) && keystrval(n) == key)
+      return gval(n);  /* hit */
+  }
+  slot = luaH_getshortstr(t, key);
+  if (!isabstkey(slot))
+    *ic = cast_uint(nodefromval(slot) - gnode(t, 0));
+  return slot;
+}
+
+
+/*
+** 'luaV_fastget' for a short-string key with an inline cache.
+*/
+#define fastgetcached(t,k,slot,ic) \
+  (!ttistable(t)  \
+   ? (slot = NULL, 0)  /* not a table; 'slot' is NULL and result is 0 */  \
+   : (slot = getcached(hvalue(t), k, ic), !isempty(slot)))
+
+/* }================================================================== */
+
+
+/*
+** {==================================================================
+** Quickening
+** ===================================================================
+*/
+
+/*
+** OP_ADD, OP_SUB and OP_MUL over two registers rewrite themselves in
+** place, the first time they run over two integers or two floats, into
+** a variant for those types (e.g. OP_ADDII, OP_ADDFF), which checks
+** only their tags. When a variant meets other operands, it goes back
+** to the generic opcode and counts the miss in the inline cache of the
+** instruction (unused by arithmetic); after QUICKLIMIT misses the
+** instruction is left generic. Quickened opcodes are never generated
+** by the compiler and are not saved by 'lua_dump'.
+*/
+
+#if !defined(QUICKLIMIT)
+#define QUICKLIMIT	4
+#endif
+
+
+/* the instruction being executed, writable */
+#define curinst()	(cast(Instruction *, pc) - 1)
+
+
+/*
+** Quicken the instruction being executed into 'opii' or 'opff' if its
+** operands 'v1' and 'v2' are two integers or two floats.
+*/
+#define quicken(v1,v2,opii,opff) {  \
+  if (*icache() < QUICKLIMIT) {  \
+    if (ttisinteger(v1) && ttisinteger(v2))  \
+      SET_OPCODE(*curinst(), opii);  \
+    else if (ttisfloat(v1) && ttisfloat(v2))  \
+      SET_OPCODE(*curinst(), opff);  \
+  }}
+
+
+/*
+** Undo the quickening of the instruction being executed into generic
+** opcode 'op'.
+*/
+#define unquicken(op) {  \
+  SET_OPCODE(*curinst(), op); (*icache())++; }
+
+/* }================================================================== */
+
+
+/*
+** Call of C function 'ra' by OP_CALL, without going through
+** 'luaD_precall' and 'luaD_poscall'. When no hook is active and the
+** stack has room for the call, the frame of the function is set up
+** and its results are moved here directly, which saves a good part
+** of the cost of calling small C functions (such as the functions of
+** a binding called in a loop). A function that sets a hook or has
+** to-be-closed variables still returns through 'luaD_poscall'.
+** Returns 0, doing nothing, when the general path must be used.
+*/
+l_sinline int fastcallC (lua_State *L, CallInfo *ci, StkId ra, int nresults) {
+  lua_CFunction f;
+  CallInfo *nci;
+  StkId res;
+  int n, i;
+  if (ttislcf(s2v(ra)))
+    f = fvalue(s2v(ra));
+  else if (ttisCclosure(s2v(ra)))
+    f = clCvalue(s2v(ra))->f;
+  else
+    return 0;
+  if (l_unlikely(L->hookmask) || L->stack_last.p - L->top.p <= LUA_MINSTACK)
+    return 0;
+  L->ci = nci = next_ci(L);
+  nci->func.p = ra;
+  nci->nresults = nresults;
+  nci->callstatus = CIST_C;
+  nci->top.p = L->top.p + LUA_MINSTACK;
+  lua_unlock(L);
+  n = (*f)(L);
+  lua_lock(L);
+  lua_assert(n < L->top.p - nci->func.p);
+  if (l_unlikely(L->hookmask || nci->nresults != nresults)) {
+    /* function set a hook or has to-be-closed variables ('lua_toclose') */
+    luaD_poscall(L, nci, n);  /* call the return hook, close variables */
+    return 1;
+  }
+  ra = nci->func.p;  /* stack may have been reallocated */
+  res = L->top.p - n;
+  if (nresults == LUA_MULTRET)
+    nresults = n;  /* all results */
+  for (i = 0; i < n && i < nresults; i++)
+    setobjs2s(L, ra + i, res + i);
+  for (; i < nresults; i++)
+    setnilvalue(s2v(ra + i));  /* complete wanted number of results */
+  L->top.p = ra + nresults;
+  L->ci = ci;
+  return 1;
+}
+
+
 /*
 ** {==================================================================
 ** Function 'luaV_execute': main interpreter loop
@@ -1254,7 +1451,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         TValue *upval = cl->upvals[GETARG_B(i)]->v.p;
         TValue *rc = KC(i);
         TString *key = tsvalue(rc);  /* key must be a string */
-        if (luaV_fastget(L, upval, key, slot, luaH_getshortstr)) {
+        if (fastgetcached(upval, key, slot, icache())) {
           setobj2s(L, ra, slot);
         }
         else
@@ -1297,7 +1494,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         TValue *rb = vRB(i);
         TValue *rc = KC(i);
         TString *key = tsvalue(rc);  /* key must be a string */
-        if (luaV_fastget(L, rb, key, slot, luaH_getshortstr)) {
+        if (fastgetcached(rb, key, slot, icache())) {
           setobj2s(L, ra, slot);
         }
         else
@@ -1310,7 +1507,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         TValue *rb = KB(i);
         TValue *rc = RKC(i);
         TString *key = tsvalue(rb);  /* key must be a string */
-        if (luaV_fastget(L, upval, key, slot, luaH_getshortstr)) {
+        if (fastgetcached(upval, key, slot, icache())) {
           luaV_finishfastset(L, upval, slot, rc);
         }
         else
@@ -1353,7 +1550,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         TValue *rb = KB(i);
         TValue *rc = RKC(i);
         TString *key = tsvalue(rb);  /* key must be a string */
-        if (luaV_fastget(L, s2v(ra), key, slot, luaH_getshortstr)) {
+        if (fastgetcached(s2v(ra), key, slot, icache())) {
           luaV_finishfastset(L, s2v(ra), slot, rc);
         }
         else
@@ -1385,10 +1582,16 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         TValue *rb = vRB(i);
         TValue *rc = RKC(i);
         TString *key = tsvalue(rc);  /* key must be a string */
+        const TValue *tm, *mslot;
         setobj2s(L, ra + 1, rb);
         if (luaV_fastget(L, rb, key, slot, luaH_getstr)) {
           setobj2s(L, ra, slot);
         }
+        else if (slot != NULL && key->tt == LUA_VSHRSTR &&
+                 (tm = fasttm(L, hvalue(rb)->metatable, TM_INDEX)) != NULL &&
+                 fastgetcached(tm, key, mslot, icache())) {
+          setobj2s(L, ra, mslot);  /* method from the '__index' table */
+        }
         else
           Protect(luaV_finishget(L, rb, rc, ra, slot));
         vmbreak;
@@ -1460,15 +1663,15 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         vmbreak;
       }
       vmcase(OP_ADD) {
-        op_arith(L, l_addi, luai_numadd);
+        op_arithQ(L, l_addi, luai_numadd, OP_ADDII, OP_ADDFF);
         vmbreak;
       }
       vmcase(OP_SUB) {
-        op_arith(L, l_subi, luai_numsub);
+        op_arithQ(L, l_subi, luai_numsub, OP_SUBII, OP_SUBFF);
         vmbreak;
       }
       vmcase(OP_MUL) {
-        op_arith(L, l_muli, luai_nummul);
+        op_arithQ(L, l_muli, luai_nummul, OP_MULII, OP_MULFF);
         vmbreak;
       }
       vmcase(OP_MOD) {
@@ -1681,7 +1884,9 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
           L->top.p = ra + b;  /* top signals number of arguments */
         /* else previous instruction set top */
         savepc(L);  /* in case of errors */
-        if ((newci = luaD_precall(L, ra, nresults)) == NULL)
+        if (fastcallC(L, ci, ra, nresults))
+          updatetrap(ci);  /* C call done */
+        else if ((newci = luaD_precall(L, ra, nresults)) == NULL)
           updatetrap(ci);  /* C call; nothing else to be done */
         else {  /* Lua call: run function in this same C frame */
           ci = newci;
@@ -1894,6 +2099,30 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         lua_assert(0);
         vmbreak;
       }
+      vmcase(OP_ADDII) {
+        op_arithII(L, l_addi, luai_numadd, OP_ADD);
+        vmbreak;
+      }
+      vmcase(OP_ADDFF) {
+        op_arithFF(L, l_addi, luai_numadd, OP_ADD);
+        vmbreak;
+      }
+      vmcase(OP_SUBII) {
+        op_arithII(L, l_subi, luai_numsub, OP_SUB);
+        vmbreak;
+      }
+      vmcase(OP_SUBFF) {
+        op_arithFF(L, l_subi, luai_numsub, OP_SUB);
+        vmbreak;
+      }
+      vmcase(OP_MULII) {
+        op_arithII(L, l_muli, luai_nummul, OP_MUL);
+        vmbreak;
+      }
+      vmcase(OP_MULFF) {
+        op_arithFF(L, l_muli, luai_nummul, OP_MUL);
+        vmbreak;
+      }
     }
   }
 }
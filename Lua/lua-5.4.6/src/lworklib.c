@@ -0,0 +1,987 @@
+/*
+** $Id: lworklib.c $
+** Workers: independent Lua states running in parallel
+** See Copyright Notice in lua.h
+*/
+
+#define lworklib_c
+#define LUA_LIB
+
+#include "lprefix.h"
+
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+/*
+** A worker is a new Lua state, with the standard libraries, running a
+** function in a thread of its own. States share nothing, so everything
+** that goes into or out of a worker (the function, its arguments, its
+** results, and values sent through channels) travels as a message:
+** a C block with a serialized copy of the values. Messages can hold
+** nil, booleans, numbers, strings, tables (without metatables or
+** cycles), Lua functions (as bytecode; upvalues other than _ENV are
+** not kept), channels, and code.
+**
+** 'worker.compile' turns a chunk into code: a read-only message with the
+** bytecode of the chunk, shared (with reference counts) by all workers
+** spawned from it, so that the chunk is parsed only once.
+*/
+
+
+#define WORKER_MT	"worker.Worker"
+#define CHANNEL_MT	"worker.Channel"
+#define CODE_MT		"worker.Code"
+
+/* maximum nesting of tables in a message (also catches cycles) */
+#define MAXNESTING	200
+
+
+/*
+** {======================================================
+** Threads
+** =======================================================
+*/
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+#define l_threadsupported	1
+
+typedef HANDLE l_thread;
+typedef CRITICAL_SECTION l_mutex;
+typedef CONDITION_VARIABLE l_cond;
+
+#define l_mutexinit(m)		InitializeCriticalSection(m)
+#define l_mutexfree(m)		DeleteCriticalSection(m)
+#define l_mutexlock(m)		EnterCriticalSection(m)
+#define l_mutexunlock(m)	LeaveCriticalSection(m)
+#define l_condinit(c)		InitializeConditionVariable(c)
+#define l_condfree(c)		((void)(c))
+#define l_condwait(c,m)		SleepConditionVariableCS(c, m, INFINITE)
+#define l_condbroadcast(c)	WakeAllConditionVariable(c)
+
+/* lock for all reference counts */
+static SRWLOCK reflock = SRWLOCK_INIT;
+#define l_reflock()		AcquireSRWLockExclusive(&reflock)
+#define l_refunlock()		ReleaseSRWLockExclusive(&reflock)
+
+/* current time, in seconds */
+static double l_now (void) {
+  return (double)GetTickCount64() / 1000.0;
+}
+
+/* waits on 'c' until signaled or until time 'deadline' */
+static void l_condwaituntil (l_cond *c, l_mutex *m, double deadline) {
+  double left = deadline - l_now();
+  if (left > 0)
+    SleepConditionVariableCS(c, m, (DWORD)(left * 1000.0) + 1);
+}
+
+static DWORD WINAPI threadmain (LPVOID arg);
+
+#define l_threadcreate(t,arg) \
+	((*(t) = CreateThread(NULL, 0, threadmain, arg, 0, NULL)) != NULL)
+#define l_threadjoin(t)  \
+	(WaitForSingleObject(t, INFINITE), CloseHandle(t))
+
+#define THREADMAIN(arg)		static DWORD WINAPI threadmain (LPVOID arg)
+#define THREADRETURN		return 0
+
+
+#elif defined(LUA_USE_POSIX)
+
+#include <pthread.h>
+#include <time.h>
+
+#define l_threadsupported	1
+
+typedef pthread_t l_thread;
+typedef pthread_mutex_t l_mutex;
+typedef pthread_cond_t l_cond;
+
+#define l_mutexinit(m)		pthread_mutex_init(m, NULL)
+#define l_mutexfree(m)		pthread_mutex_destroy(m)
+#define l_mutexlock(m)		pthread_mutex_lock(m)
+#define l_mutexunlock(m)	pthread_mutex_unlock(m)
+#define l_condinit(c)		pthread_cond_init(c, NULL)
+#define l_condfree(c)		pthread_cond_destroy(c)
+#define l_condwait(c,m)		pthread_cond_wait(c, m)
+#define l_condbroadcast(c)	pthread_cond_broadcast(c)
+
+/* lock for all reference counts */
+static pthread_mutex_t reflock = PTHREAD_MUTEX_INITIALIZER;
+#define l_reflock()		pthread_mutex_lock(&reflock)
+#define l_refunlock()		pthread_mutex_unlock(&reflock)
+
+/* current time, in seconds (the clock of 'pthread_cond_timedwait') */
+static double l_now (void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* waits on 'c' until signaled or until time 'deadline' */
+static void l_condwaituntil (l_cond *c, l_mutex *m, double deadline) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)deadline;
+  ts.tv_nsec = (long)((deadline - (double)ts.tv_sec) * 1e9);
+  pthread_cond_timedwait(c, m, &ts);
+}
+
+static void *threadmain (void *arg);
+
+#define l_threadcreate(t,arg)	(pthread_create(t, NULL, threadmain, arg) == 0)
+#define l_threadjoin(t)		pthread_join(t, NULL)
+
+#define THREADMAIN(arg)		static void *threadmain (void *arg)
+#define THREADRETURN		return NULL
+
+
+#else
+
+#define l_threadsupported	0
+
+#endif
+
+/* }====================================================== */
+
+
+#if l_threadsupported
+
+/*
+** {======================================================
+** Messages
+** =======================================================
+*/
+
+typedef struct Message {
+  struct Message *next;  /* next message in a channel queue */
+  int refs;  /* references to a shared message (code) */
+  int n;  /* number of values */
+  size_t size;  /* size of 'data' */
+  char data[1];  /* serialized values */
+} Message;
+
+
+/* value tags */
+#define T_NIL		'n'
+#define T_FALSE		'f'
+#define T_TRUE		't'
+#define T_INT		'i'
+#define T_FLT		'd'
+#define T_STR		's'
+#define T_TABLE		'T'
+#define T_END		'e'  /* end of table */
+#define T_FUNC		'F'
+#define T_CHANNEL	'C'
+#define T_CODE		'K'
+
+
+/*
+** Message being built. It lives in a userdata box, which frees the
+** block if an error interrupts the building.
+*/
+typedef struct MsgBuffer {
+  char *b;  /* block, starting with the header of a message */
+  size_t n;  /* bytes in use */
+  size_t size;  /* bytes allocated */
+} MsgBuffer;
+
+
+static int msgbuf_gc (lua_State *L) {
+  MsgBuffer *B = (MsgBuffer *)lua_touserdata(L, 1);
+  free(B->b);
+  B->b = NULL;
+  return 0;
+}
+
+
+static MsgBuffer *newmsgbuffer (lua_State *L) {
+  MsgBuffer *B = (MsgBuffer *)lua_newuserdatauv(L, sizeof(MsgBuffer), 0);
+  B->b = NULL;
+  B->n = B->size = 0;
+  if (luaL_newmetatable(L, "worker.MsgBuffer")) {
+    lua_pushcfunction(L, msgbuf_gc);
+    lua_setfield(L, -2, "__gc");
+  }
+  lua_setmetatable(L, -2);
+  return B;
+}
+
+
+/* reserves 'l' bytes at the end of the message; returns them */
+static char *reserve (lua_State *L, MsgBuffer *B, size_t l) {
+  char *p;
+  if (B->size - B->n < l) {
+    size_t newsize = (B->size < 64) ? 64 : B->size * 2;
+    char *nb;
+    while (newsize - B->n < l)
+      newsize *= 2;
+    nb = (char *)realloc(B->b, newsize);
+    if (nb == NULL)
+      luaL_error(L, "not enough memory");
+    B->b = nb;
+    B->size = newsize;
+  }
+  p = B->b + B->n;
+  B->n += l;
+  return p;
+}
+
+
+static void addbytes (lua_State *L, MsgBuffer *B, const void *p, size_t l) {
+  memcpy(reserve(L, B, l), p, l);
+}
+
+
+static void addtag (lua_State *L, MsgBuffer *B, char tag) {
+  addbytes(L, B, &tag, 1);
+}
+
+
+static int writer (lua_State *L, const void *b, size_t size, void *ud) {
+  addbytes(L, (MsgBuffer *)ud, b, size);
+  return 0;
+}
+
+
+static void encode (lua_State *L, MsgBuffer *B, int idx, int level) {
+  switch (lua_type(L, idx)) {
+    case LUA_TNIL: addtag(L, B, T_NIL); break;
+    case LUA_TBOOLEAN:
+      addtag(L, B, lua_toboolean(L, idx) ? T_TRUE : T_FALSE);
+      break;
+    case LUA_TNUMBER: {
+      if (lua_isinteger(L, idx)) {
+        lua_Integer i = lua_tointeger(L, idx);
+        addtag(L, B, T_INT);
+        addbytes(L, B, &i, sizeof(i));
+      }
+      else {
+        lua_Number x = lua_tonumber(L, idx);
+        addtag(L, B, T_FLT);
+        addbytes(L, B, &x, sizeof(x));
+      }
+      break;
+    }
+    case LUA_TSTRING: {
+      size_t l;
+      const char *s = lua_tolstring(L, idx, &l);
+      addtag(L, B, T_STR);
+      addbytes(L, B, &l, sizeof(l));
+      addbytes(L, B, s, l);
+      break;
+    }
+    case LUA_TTABLE: {
+      if (level >= MAXNESTING)
+        luaL_error(L, "table too deep (or recursive) to send");
+      luaL_checkstack(L, 3, "table too deep to send");
+      addtag(L, B, T_TABLE);
+      lua_pushnil(L);
+      while (lua_next(L, idx)) {
+        int top = lua_gettop(L);
+        encode(L, B, top - 1, level + 1);  /* key */
+        encode(L, B, top, level + 1);  /* value */
+        lua_pop(L, 1);
+      }
+      addtag(L, B, T_END);
+      break;
+    }
+    case LUA_TFUNCTION: {
+      size_t start, l;
+      if (lua_iscfunction(L, idx))
+        luaL_error(L, "cannot send a C function");
+      addtag(L, B, T_FUNC);
+      l = 0;
+      start = B->n;
+      addbytes(L, B, &l, sizeof(l));  /* room for size */
+      lua_pushvalue(L, idx);
+      lua_dump(L, writer, B, 0);
+      lua_pop(L, 1);
+      l = B->n - start - sizeof(l);
+      memcpy(B->b + start, &l, sizeof(l));
+      break;
+    }
+    case LUA_TUSERDATA: {
+      void **p;
+      if ((p = (void **)luaL_testudata(L, idx, CHANNEL_MT)) != NULL)
+        addtag(L, B, T_CHANNEL);
+      else if ((p = (void **)luaL_testudata(L, idx, CODE_MT)) != NULL)
+        addtag(L, B, T_CODE);
+      else
+        luaL_error(L, "cannot send a userdata");
+      addbytes(L, B, p, sizeof(void *));
+      break;
+    }
+    default:
+      luaL_error(L, "cannot send a %s", luaL_typename(L, idx));
+  }
+}
+
+
+static void addrefs (const char *p, const char *end, int delta);
+
+/*
+** Serializes the values at stack positions 'first'..'last' into a new
+** message.
+*/
+static Message *tomessage (lua_State *L, int first, int last) {
+  MsgBuffer *B;
+  Message *m;
+  int i;
+  luaL_checkstack(L, 4, "too many values to send");
+  B = newmsgbuffer(L);
+  reserve(L, B, offsetof(Message, data));  /* room for header */
+  for (i = first; i <= last; i++)
+    encode(L, B, i, 0);
+  m = (Message *)B->b;
+  B->b = NULL;  /* message now belongs to the caller */
+  lua_pop(L, 1);  /* box */
+  m->next = NULL;
+  m->refs = 1;
+  m->n = last - first + 1;
+  m->size = B->n - offsetof(Message, data);
+  addrefs(m->data, m->data + m->size, 1);  /* references inside message */
+  return m;
+}
+
+
+static void releasechannel (void *ch);
+static void releasecode (Message *m);
+
+/*
+** Adds 'delta' (+1 or -1) to the reference counts of the channels and
+** code in a serialized message.
+*/
+static void addrefs (const char *p, const char *end, int delta) {
+  while (p < end) {
+    size_t l;
+    void *ref;
+    switch (*p++) {
+      case T_INT: p += sizeof(lua_Integer); break;
+      case T_FLT: p += sizeof(lua_Number); break;
+      case T_STR: case T_FUNC:
+        memcpy(&l, p, sizeof(l));
+        p += sizeof(l) + l;
+        break;
+      case T_CHANNEL: case T_CODE: {
+        char tag = p[-1];
+        memcpy(&ref, p, sizeof(ref));
+        p += sizeof(ref);
+        if (delta > 0) {
+          l_reflock();
+          if (tag == T_CHANNEL)
+            (*(int *)ref)++;  /* 'refs' is the first field of a channel */
+          else
+            ((Message *)ref)->refs++;
+          l_refunlock();
+        }
+        else if (tag == T_CHANNEL)
+          releasechannel(ref);
+        else
+          releasecode((Message *)ref);
+        break;
+      }
+      default: break;  /* single-byte values */
+    }
+  }
+}
+
+
+static void freemessage (Message *m) {
+  if (m != NULL) {
+    addrefs(m->data, m->data + m->size, -1);
+    free(m);
+  }
+}
+
+
+static void pushchannel (lua_State *L, void *ch);
+static void pushcode (lua_State *L, Message *m);
+
+static const char *decode (lua_State *L, const char *p) {
+  size_t l;
+  char tag = *p++;
+  luaL_checkstack(L, 2, "message too deep");
+  switch (tag) {
+    case T_NIL: lua_pushnil(L); break;
+    case T_FALSE: lua_pushboolean(L, 0); break;
+    case T_TRUE: lua_pushboolean(L, 1); break;
+    case T_INT: {
+      lua_Integer i;
+      memcpy(&i, p, sizeof(i));
+      lua_pushinteger(L, i);
+      p += sizeof(i);
+      break;
+    }
+    case T_FLT: {
+      lua_Number x;
+      memcpy(&x, p, sizeof(x));
+      lua_pushnumber(L, x);
+      p += sizeof(x);
+      break;
+    }
+    case T_STR: {
+      memcpy(&l, p, sizeof(l));
+      p += sizeof(l);
+      lua_pushlstring(L, p, l);
+      p += l;
+      break;
+    }
+    case T_TABLE: {
+      lua_newtable(L);
+      while (*p != T_END) {
+        p = decode(L, p);  /* key */
+        p = decode(L, p);  /* value */
+        lua_rawset(L, -3);
+      }
+      p++;  /* skip T_END */
+      break;
+    }
+    case T_FUNC: {
+      memcpy(&l, p, sizeof(l));
+      p += sizeof(l);
+      if (luaL_loadbufferx(L, p, l, "=(worker)", "b") != LUA_OK)
+        lua_error(L);
+      p += l;
+      break;
+    }
+    case T_CHANNEL: case T_CODE: {
+      void *ref;
+      memcpy(&ref, p, sizeof(ref));
+      p += sizeof(ref);
+      if (tag == T_CHANNEL)
+        pushchannel(L, ref);
+      else
+        pushcode(L, (Message *)ref);
+      break;
+    }
+    default: break;  /* corrupted message */
+  }
+  return p;
+}
+
+
+/* pushes the values of a message; returns their number */
+static int pushmessage (lua_State *L, const Message *m) {
+  const char *p = m->data;
+  int i;
+  luaL_checkstack(L, m->n, "too many values in message");
+  for (i = 0; i < m->n; i++)
+    p = decode(L, p);
+  return m->n;
+}
+
+
+static int msgbox_gc (lua_State *L) {
+  Message **pm = (Message **)lua_touserdata(L, 1);
+  freemessage(*pm);
+  *pm = NULL;
+  return 0;
+}
+
+
+/*
+** Pushes the values of message 'm' and frees it (also if the pushing
+** raises an error); returns the number of values
+*/
+static int takemessage (lua_State *L, Message *m) {
+  Message **pm = (Message **)lua_newuserdatauv(L, sizeof(Message *), 0);
+  int n;
+  *pm = m;
+  if (luaL_newmetatable(L, "worker.MsgBox")) {
+    lua_pushcfunction(L, msgbox_gc);
+    lua_setfield(L, -2, "__gc");
+  }
+  lua_setmetatable(L, -2);
+  n = pushmessage(L, m);
+  *pm = NULL;
+  lua_rotate(L, -(n + 1), -1);
+  lua_pop(L, 1);  /* box */
+  freemessage(m);
+  return n;
+}
+
+/* }====================================================== */
+
+
+/*
+** {======================================================
+** Code
+** =======================================================
+*/
+
+static void releasecode (Message *m) {
+  int refs;
+  l_reflock();
+  refs = --m->refs;
+  l_refunlock();
+  if (refs == 0)
+    freemessage(m);
+}
+
+
+/* pushes a new reference to code 'm' */
+static void pushcode (lua_State *L, Message *m) {
+  Message **pm = (Message **)lua_newuserdatauv(L, sizeof(Message *), 0);
+  *pm = NULL;
+  luaL_setmetatable(L, CODE_MT);
+  l_reflock();
+  m->refs++;
+  l_refunlock();
+  *pm = m;
+}
+
+
+static int code_gc (lua_State *L) {
+  Message **pm = (Message **)luaL_checkudata(L, 1, CODE_MT);
+  if (*pm != NULL) {
+    releasecode(*pm);
+    *pm = NULL;
+  }
+  return 0;
+}
+
+
+/*
+** Returns a new message with the function at 'idx', or with the chunk
+** in string 'idx' (named 'chunkname')
+*/
+static Message *tocode (lua_State *L, int idx, const char *chunkname) {
+  Message *m;
+  if (lua_type(L, idx) == LUA_TSTRING) {
+    size_t l;
+    const char *s = lua_tolstring(L, idx, &l);
+    if (luaL_loadbufferx(L, s, l, chunkname ? chunkname : s, "t") != LUA_OK)
+      lua_error(L);
+  }
+  else {
+    luaL_argexpected(L, lua_type(L, idx) == LUA_TFUNCTION &&
+                        !lua_iscfunction(L, idx), idx, "Lua function");
+    lua_pushvalue(L, idx);
+  }
+  m = tomessage(L, lua_gettop(L), lua_gettop(L));
+  lua_pop(L, 1);
+  return m;
+}
+
+
+/* worker.compile(chunk [, chunkname]) */
+static int w_compile (lua_State *L) {
+  const char *chunkname = luaL_optstring(L, 2, NULL);
+  Message *m = tocode(L, 1, chunkname);
+  pushcode(L, m);
+  releasecode(m);  /* now owned by the userdata */
+  return 1;
+}
+
+/* }====================================================== */
+
+
+/*
+** {======================================================
+** Channels
+** =======================================================
+*/
+
+typedef struct Channel {
+  int refs;  /* must be the first field (see 'addrefs') */
+  int count;  /* number of queued messages */
+  int capacity;  /* maximum queued messages (0 for no limit) */
+  Message *first, *last;  /* queue */
+  l_mutex mutex;
+  l_cond cond;  /* broadcast on every change of the queue */
+} Channel;
+
+
+static void releasechannel (void *ref) {
+  Channel *ch = (Channel *)ref;
+  int refs;
+  l_reflock();
+  refs = --ch->refs;
+  l_refunlock();
+  if (refs == 0) {
+    Message *m = ch->first;
+    while (m != NULL) {  /* free undelivered messages */
+      Message *next = m->next;
+      freemessage(m);
+      m = next;
+    }
+    l_condfree(&ch->cond);
+    l_mutexfree(&ch->mutex);
+    free(ch);
+  }
+}
+
+
+/* pushes a new reference to channel 'ref' */
+static void pushchannel (lua_State *L, void *ref) {
+  Channel **pch = (Channel **)lua_newuserdatauv(L, sizeof(Channel *), 0);
+  *pch = NULL;
+  luaL_setmetatable(L, CHANNEL_MT);
+  l_reflock();
+  ((Channel *)ref)->refs++;
+  l_refunlock();
+  *pch = (Channel *)ref;
+}
+
+
+static Channel *checkchannel (lua_State *L) {
+  return *(Channel **)luaL_checkudata(L, 1, CHANNEL_MT);
+}
+
+
+/* worker.channel([capacity]) */
+static int w_channel (lua_State *L) {
+  lua_Integer capacity = luaL_optinteger(L, 1, 0);
+  Channel **pch;
+  Channel *ch;
+  luaL_argcheck(L, 0 <= capacity && capacity <= INT_MAX, 1,
+                   "invalid capacity");
+  pch = (Channel **)lua_newuserdatauv(L, sizeof(Channel *), 0);
+  *pch = NULL;
+  luaL_setmetatable(L, CHANNEL_MT);
+  ch = (Channel *)malloc(sizeof(Channel));
+  if (ch == NULL)
+    return luaL_error(L, "not enough memory");
+  ch->refs = 1;
+  ch->count = 0;
+  ch->capacity = (int)capacity;
+  ch->first = ch->last = NULL;
+  l_mutexinit(&ch->mutex);
+  l_condinit(&ch->cond);
+  *pch = ch;
+  return 1;
+}
+
+
+/* ch:send(v1, ...): waits while the channel is full */
+static int ch_send (lua_State *L) {
+  Channel *ch = checkchannel(L);
+  Message *m;
+  luaL_checkany(L, 2);
+  m = tomessage(L, 2, lua_gettop(L));
+  l_mutexlock(&ch->mutex);
+  while (ch->capacity > 0 && ch->count >= ch->capacity)
+    l_condwait(&ch->cond, &ch->mutex);
+  if (ch->last != NULL)
+    ch->last->next = m;
+  else
+    ch->first = m;
+  ch->last = m;
+  ch->count++;
+  l_condbroadcast(&ch->cond);
+  l_mutexunlock(&ch->mutex);
+  return 0;
+}
+
+
+/*
+** ch:receive([timeout]): the values of the next message, waiting at
+** most 'timeout' seconds for it (for ever by default); fail on timeout
+*/
+static int ch_receive (lua_State *L) {
+  Channel *ch = checkchannel(L);
+  lua_Number timeout = luaL_optnumber(L, 2, -1);
+  double deadline = (timeout >= 0) ? l_now() + (double)timeout : 0;
+  Message *m;
+  l_mutexlock(&ch->mutex);
+  while (ch->first == NULL) {
+    if (timeout < 0)
+      l_condwait(&ch->cond, &ch->mutex);
+    else if (l_now() < deadline)
+      l_condwaituntil(&ch->cond, &ch->mutex, deadline);
+    else
+      break;
+  }
+  m = ch->first;
+  if (m != NULL) {
+    ch->first = m->next;
+    if (ch->first == NULL)
+      ch->last = NULL;
+    ch->count--;
+    l_condbroadcast(&ch->cond);
+  }
+  l_mutexunlock(&ch->mutex);
+  if (m == NULL) {
+    luaL_pushfail(L);
+    return 1;
+  }
+  return takemessage(L, m);
+}
+
+
+static int ch_len (lua_State *L) {
+  Channel *ch = checkchannel(L);
+  int count;
+  l_mutexlock(&ch->mutex);
+  count = ch->count;
+  l_mutexunlock(&ch->mutex);
+  lua_pushinteger(L, count);
+  return 1;
+}
+
+
+static int ch_gc (lua_State *L) {
+  Channel **pch = (Channel **)luaL_checkudata(L, 1, CHANNEL_MT);
+  if (*pch != NULL) {
+    releasechannel(*pch);
+    *pch = NULL;
+  }
+  return 0;
+}
+
+
+static int ch_tostring (lua_State *L) {
+  lua_pushfstring(L, "channel (%p)", (void *)checkchannel(L));
+  return 1;
+}
+
+/* }====================================================== */
+
+
+/*
+** {======================================================
+** Workers
+** =======================================================
+*/
+
+typedef struct Worker {
+  l_thread thread;
+  Message *code;  /* function to run */
+  Message *args;  /* its arguments */
+  Message *results;  /* its results, if it succeeded */
+  char *error;  /* its error message, if it failed */
+  int status;  /* LUA_OK or error status */
+  int running;  /* true while the thread was not joined */
+} Worker;
+
+
+static int msghandler (lua_State *L) {
+  const char *msg = lua_tostring(L, 1);
+  if (msg == NULL)  /* error object is not a string? */
+    msg = lua_pushfstring(L, "(error object is a %s value)",
+                             luaL_typename(L, 1));
+  luaL_traceback(L, L, msg, 1);
+  return 1;
+}
+
+
+/* body of a worker, in protected mode in the new state */
+static int runworker (lua_State *L) {
+  Worker *w = (Worker *)lua_touserdata(L, 1);
+  int n;
+  luaL_openlibs(L);
+  luaL_requiref(L, LUA_WORKLIBNAME, luaopen_worker, 0);  /* metatables */
+  lua_settop(L, 0);
+  pushmessage(L, w->code);
+  n = pushmessage(L, w->args);
+  lua_call(L, n, LUA_MULTRET);
+  w->results = tomessage(L, 1, lua_gettop(L));
+  return 0;
+}
+
+
+THREADMAIN(arg) {
+  Worker *w = (Worker *)arg;
+  lua_State *L = luaL_newstate();
+  if (L == NULL)
+    w->status = LUA_ERRMEM;
+  else {
+    lua_pushcfunction(L, msghandler);
+    lua_pushcfunction(L, runworker);
+    lua_pushlightuserdata(L, w);
+    w->status = lua_pcall(L, 1, 0, 1);
+    if (w->status != LUA_OK) {
+      const char *msg = lua_tostring(L, -1);
+      if (msg == NULL) msg = "(no error message)";
+      w->error = (char *)malloc(strlen(msg) + 1);
+      if (w->error != NULL)
+        strcpy(w->error, msg);
+    }
+    lua_close(L);
+  }
+  freemessage(w->args);  /* worker is done with its input */
+  w->args = NULL;
+  releasecode(w->code);
+  w->code = NULL;
+  THREADRETURN;
+}
+
+
+static Worker *checkworker (lua_State *L) {
+  return (Worker *)luaL_checkudata(L, 1, WORKER_MT);
+}
+
+
+static void joinworker (Worker *w) {
+  if (w->running) {
+    l_threadjoin(w->thread);
+    w->running = 0;
+  }
+}
+
+
+/*
+** worker.spawn(f, ...): runs 'f' (a Lua function, code, or a string with
+** a chunk) in a new state, in a new thread, with the given arguments
+*/
+static int w_spawn (lua_State *L) {
+  Worker *w;
+  Message *code, *args;
+  int top = lua_gettop(L);
+  Message **pm = (Message **)luaL_testudata(L, 1, CODE_MT);
+  if (pm != NULL) {
+    code = *pm;
+    l_reflock();
+    code->refs++;
+    l_refunlock();
+  }
+  else
+    code = tocode(L, 1, NULL);
+  w = (Worker *)lua_newuserdatauv(L, sizeof(Worker), 0);
+  memset(w, 0, sizeof(Worker));
+  w->code = code;  /* the userdata frees it if something fails */
+  luaL_setmetatable(L, WORKER_MT);
+  args = tomessage(L, 2, top);
+  w->args = args;
+  if (!l_threadcreate(&w->thread, w))
+    return luaL_error(L, "cannot create thread");
+  w->running = 1;
+  return 1;
+}
+
+
+/*
+** w:join(): waits for the worker to finish; returns true plus its
+** results, or false plus an error message
+*/
+static int wk_join (lua_State *L) {
+  Worker *w = checkworker(L);
+  joinworker(w);
+  if (w->status != LUA_OK) {
+    lua_pushboolean(L, 0);
+    if (w->error != NULL)
+      lua_pushstring(L, w->error);
+    else
+      lua_pushliteral(L, "not enough memory");
+    return 2;
+  }
+  else if (w->results == NULL)
+    return luaL_error(L, "worker results already taken");
+  else {
+    Message *m = w->results;
+    w->results = NULL;
+    lua_pushboolean(L, 1);
+    return takemessage(L, m) + 1;
+  }
+}
+
+
+static int wk_gc (lua_State *L) {
+  Worker *w = checkworker(L);
+  joinworker(w);
+  if (w->code != NULL) {  /* thread never started? */
+    releasecode(w->code);
+    w->code = NULL;
+  }
+  freemessage(w->args);
+  w->args = NULL;
+  freemessage(w->results);
+  w->results = NULL;
+  free(w->error);
+  w->error = NULL;
+  return 0;
+}
+
+
+static int wk_tostring (lua_State *L) {
+  lua_pushfstring(L, "worker (%p)", (void *)checkworker(L));
+  return 1;
+}
+
+/* }====================================================== */
+
+
+static const luaL_Reg w_funcs[] = {
+  {"spawn", w_spawn},
+  {"compile", w_compile},
+  {"channel", w_channel},
+  {NULL, NULL}
+};
+
+
+static const luaL_Reg wk_meth[] = {
+  {"join", wk_join},
+  {NULL, NULL}
+};
+
+static const luaL_Reg wk_metameth[] = {
+  {"__index", NULL},  /* place holder */
+  {"__gc", wk_gc},
+  {"__close", wk_gc},
+  {"__tostring", wk_tostring},
+  {NULL, NULL}
+};
+
+
+static const luaL_Reg ch_meth[] = {
+  {"send", ch_send},
+  {"receive", ch_receive},
+  {NULL, NULL}
+};
+
+static const luaL_Reg ch_metameth[] = {
+  {"__index", NULL},  /* place holder */
+  {"__gc", ch_gc},
+  {"__len", ch_len},
+  {"__tostring", ch_tostring},
+  {NULL, NULL}
+};
+
+
+static void createmeta (lua_State *L, const char *tname,
+                        const luaL_Reg *metameth, const luaL_Reg *meth) {
+  luaL_newmetatable(L, tname);
+  luaL_setfuncs(L, metameth, 0);
+  if (meth != NULL) {
+    lua_newtable(L);
+    luaL_setfuncs(L, meth, 0);
+    lua_setfield(L, -2, "__index");  /* metatable.__index = method table */
+  }
+  lua_pop(L, 1);
+}
+
+
+LUAMOD_API int luaopen_worker (lua_State *L) {
+  static const luaL_Reg code_metameth[] = {
+    {"__gc", code_gc},
+    {NULL, NULL}
+  };
+  luaL_newlib(L, w_funcs);
+  createmeta(L, WORKER_MT, wk_metameth, wk_meth);
+  createmeta(L, CHANNEL_MT, ch_metameth, ch_meth);
+  createmeta(L, CODE_MT, code_metameth, NULL);
+  return 1;
+}
+
+
+#else
+
+
+LUAMOD_API int luaopen_worker (lua_State *L) {
+  return luaL_error(L, "workers not supported in this build");
+}
+
+
+#endif
@@ -0,0 +1,61 @@
+/*
+** Calls of C functions from Lua code (OP_CALL), including C functions
+** with to-be-closed variables. Exits with a non-zero status on failure.
+*/
+
+#include <stdio.h>
+
+#include "lua.h"
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+/* returns its arguments plus one */
+static int addone (lua_State *L) {
+  int n = lua_gettop(L);
+  int i;
+  for (i = 1; i <= n; i++)
+    lua_pushinteger(L, luaL_checkinteger(L, i) + 1);
+  return n;
+}
+
+
+/* marks its first argument, a table with a '__close' metamethod, to be
+** closed and returns the remaining arguments */
+static int withclose (lua_State *L) {
+  lua_toclose(L, 1);
+  return lua_gettop(L) - 1;
+}
+
+
+static const char *const script =
+  "local closed = 0\n"
+  "local mt = {__close = function () closed = closed + 1 end}\n"
+  "for i = 1, 3 do\n"
+  "  withclose(setmetatable({}, mt))\n"
+  "end\n"
+  "assert(closed == 3, 'closed ' .. closed .. ' times, expected 3')\n"
+  "local a, b = withclose(setmetatable({}, mt), 10, 20)\n"
+  "assert(closed == 4 and a == 10 and b == 20)\n"
+  "local t = {withclose(setmetatable({}, mt), 1, 2, 3)}\n"
+  "assert(closed == 5 and #t == 3 and t[3] == 3)\n"
+  "local x, y, z = addone(1, 2)\n"
+  "assert(x == 2 and y == 3 and z == nil)\n"
+  "assert(select('#', addone(1, 2, 3)) == 3)\n"
+  "local s = 0\n"
+  "for i = 1, 1000 do s = s + addone(i) end\n"
+  "assert(s == 501500)\n";
+
+
+int main (void) {
+  lua_State *L = luaL_newstate();
+  int status;
+  luaL_openlibs(L);
+  lua_register(L, "addone", addone);
+  lua_register(L, "withclose", withclose);
+  status = luaL_dostring(L, script);
+  if (status != LUA_OK)
+    fprintf(stderr, "ccall: %s\n", lua_tostring(L, -1));
+  lua_close(L);
+  return status == LUA_OK ? 0 : 1;
+}
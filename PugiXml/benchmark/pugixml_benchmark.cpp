@@ -0,0 +1,465 @@
+/**
+ * pugixml benchmark
+ *
+ * Measures load_buffer, load_buffer_inplace, traversal, select_nodes and save on
+ * FMI modelDescription.xml and SSP SystemStructure.ssd documents. Generated
+ * documents of typical shape are always included; files given on the command
+ * line are added to the corpus.
+ *
+ * Usage: pugixml_benchmark [--time seconds] [file...]
+ *
+ * Reports throughput in MB/s of input (best of the runs) and the number of
+ * allocations and allocated bytes per operation.
+ */
+
+#include "pugixml.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace
+{
+	size_t allocation_count = 0;
+	size_t allocation_bytes = 0;
+
+	void* counting_allocate(size_t size)
+	{
+		allocation_count++;
+		allocation_bytes += size;
+
+		return malloc(size);
+	}
+
+	void counting_deallocate(void* ptr)
+	{
+		free(ptr);
+	}
+
+	struct document
+	{
+		std::string name;
+		std::string contents;
+	};
+
+	struct null_writer: pugi::xml_writer
+	{
+		size_t size;
+
+		null_writer(): size(0)
+		{
+		}
+
+		virtual void write(const void*, size_t length)
+		{
+			size += length;
+		}
+	};
+
+	// FMI 2.0 model description with the given number of variables, about half of them with a start value
+	std::string generate_model_description(size_t variables)
+	{
+		static const char* causalities[] = {"parameter", "input", "output", "local"};
+
+		std::string result = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<fmiModelDescription fmiVersion=\"2.0\" modelName=\"Benchmark.Model\" guid=\"{8c4e810f-3df3-4a00-8276-176fa3c9f000}\" "
+			"generationTool=\"benchmark\" variableNamingConvention=\"structured\" numberOfEventIndicators=\"4\">\n"
+			"  <CoSimulation modelIdentifier=\"Benchmark_Model\" canHandleVariableCommunicationStepSize=\"true\" canGetAndSetFMUstate=\"true\"/>\n"
+			"  <DefaultExperiment startTime=\"0.0\" stopTime=\"10.0\" tolerance=\"1e-06\"/>\n"
+			"  <ModelVariables>\n";
+
+		char buffer[512];
+		std::string outputs;
+
+		for (size_t i = 0; i < variables; ++i)
+		{
+			const char* causality = causalities[i % 4];
+
+			snprintf(buffer, sizeof(buffer),
+				"    <!-- Index %u -->\n"
+				"    <ScalarVariable name=\"system.component%u.flange.phi[%u]\" valueReference=\"%u\" causality=\"%s\" variability=\"%s\" description=\"Absolute rotation angle of flange %u\">\n",
+				unsigned(i + 1), unsigned(i / 16), unsigned(i % 16), unsigned(i), causality, i % 4 == 0 ? "fixed" : "continuous", unsigned(i));
+			result += buffer;
+
+			if (i % 2 == 0)
+				snprintf(buffer, sizeof(buffer), "      <Real unit=\"rad\" start=\"%.17g\"/>\n", 0.1 * double(i) + 1e-3);
+			else
+				snprintf(buffer, sizeof(buffer), "      <Real unit=\"rad\" derivative=\"%u\"/>\n", unsigned(i));
+			result += buffer;
+
+			result += "    </ScalarVariable>\n";
+
+			if (i % 4 == 2)
+			{
+				snprintf(buffer, sizeof(buffer), "      <Unknown index=\"%u\" dependencies=\"%u %u\"/>\n", unsigned(i + 1), unsigned(i > 0 ? i : 1), unsigned(i + 2));
+				outputs += buffer;
+			}
+		}
+
+		result += "  </ModelVariables>\n  <ModelStructure>\n    <Outputs>\n";
+		result += outputs;
+		result += "    </Outputs>\n  </ModelStructure>\n</fmiModelDescription>\n";
+
+		return result;
+	}
+
+	// SSP 1.0 system structure with the given number of components, connected in a chain
+	std::string generate_system_structure(size_t components)
+	{
+		std::string result = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<ssd:SystemStructureDescription xmlns:ssc=\"http://ssp-standard.org/SSP1/SystemStructureCommon\" "
+			"xmlns:ssd=\"http://ssp-standard.org/SSP1/SystemStructureDescription\" "
+			"xmlns:ssv=\"http://ssp-standard.org/SSP1/SystemStructureParameterValues\" "
+			"xmlns:oms=\"https://raw.githubusercontent.com/OpenModelica/OMSimulator/master/schema/oms\" name=\"benchmark\" version=\"1.0\">\n"
+			"  <ssd:System name=\"root\">\n    <ssd:Elements>\n";
+
+		char buffer[512];
+
+		for (size_t i = 0; i < components; ++i)
+		{
+			snprintf(buffer, sizeof(buffer),
+				"      <ssd:Component name=\"C%u\" type=\"application/x-fmu-sharedlibrary\" source=\"resources/C%u.fmu\">\n"
+				"        <ssd:Connectors>\n", unsigned(i), unsigned(i % 8));
+			result += buffer;
+
+			for (size_t c = 0; c < 6; ++c)
+			{
+				snprintf(buffer, sizeof(buffer),
+					"          <ssd:Connector name=\"%s%u\" kind=\"%s\">\n"
+					"            <ssc:Real unit=\"m\"/>\n"
+					"            <ssd:ConnectorGeometry x=\"%.6f\" y=\"%.6f\"/>\n"
+					"          </ssd:Connector>\n",
+					c < 3 ? "u" : "y", unsigned(c % 3), c < 3 ? "input" : "output", 0.0, double(c) / 6);
+				result += buffer;
+			}
+
+			snprintf(buffer, sizeof(buffer),
+				"        </ssd:Connectors>\n"
+				"        <ssd:ElementGeometry x1=\"%u\" y1=\"%u\" x2=\"%u\" y2=\"%u\"/>\n"
+				"        <ssd:ParameterBindings>\n"
+				"          <ssd:ParameterBinding>\n"
+				"            <ssd:ParameterValues>\n"
+				"              <ssv:ParameterSet version=\"1.0\" name=\"parameters\">\n"
+				"                <ssv:Parameters>\n",
+				unsigned(i * 20), unsigned(i * 10), unsigned(i * 20 + 10), unsigned(i * 10 + 10));
+			result += buffer;
+
+			snprintf(buffer, sizeof(buffer),
+				"                  <ssv:Parameter name=\"k\"><ssv:Real value=\"%.17g\"/></ssv:Parameter>\n"
+				"                  <ssv:Parameter name=\"d\"><ssv:Real value=\"%.17g\"/></ssv:Parameter>\n",
+				1.0 + double(i) / 3, 0.5 / double(i + 1));
+			result += buffer;
+
+			result +=
+				"                </ssv:Parameters>\n"
+				"              </ssv:ParameterSet>\n"
+				"            </ssd:ParameterValues>\n"
+				"          </ssd:ParameterBinding>\n"
+				"        </ssd:ParameterBindings>\n"
+				"      </ssd:Component>\n";
+		}
+
+		result += "    </ssd:Elements>\n    <ssd:Connections>\n";
+
+		for (size_t i = 0; i + 1 < components; ++i)
+		{
+			for (size_t c = 0; c < 3; ++c)
+			{
+				snprintf(buffer, sizeof(buffer), "      <ssd:Connection startElement=\"C%u\" startConnector=\"y%u\" endElement=\"C%u\" endConnector=\"u%u\"/>\n",
+					unsigned(i), unsigned(c), unsigned(i + 1), unsigned(c));
+				result += buffer;
+			}
+		}
+
+		result += "    </ssd:Connections>\n  </ssd:System>\n"
+			"  <ssd:DefaultExperiment startTime=\"0\" stopTime=\"1\">\n"
+			"    <ssd:Annotations>\n"
+			"      <ssc:Annotation type=\"org.openmodelica\">\n"
+			"        <oms:Annotations><oms:SimulationInformation><oms:FixedStepMaster description=\"oms-ma\" stepSize=\"1e-3\"/></oms:SimulationInformation></oms:Annotations>\n"
+			"      </ssc:Annotation>\n"
+			"    </ssd:Annotations>\n"
+			"  </ssd:DefaultExperiment>\n"
+			"</ssd:SystemStructureDescription>\n";
+
+		return result;
+	}
+
+	bool read_file(const char* path, std::string& contents)
+	{
+		FILE* file = fopen(path, "rb");
+		if (!file) return false;
+
+		char buffer[65536];
+		size_t size;
+
+		while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			contents.append(buffer, size);
+
+		bool ok = ferror(file) == 0;
+		fclose(file);
+
+		return ok;
+	}
+
+	size_t count_nodes(pugi::xml_node node)
+	{
+		size_t result = 1;
+
+		for (pugi::xml_attribute a = node.first_attribute(); a; a = a.next_attribute())
+			result += 1;
+
+		for (pugi::xml_node child = node.first_child(); child; child = child.next_sibling())
+			result += count_nodes(child);
+
+		return result;
+	}
+
+	struct measurement
+	{
+		double seconds; // best time of one operation
+		size_t allocations; // per operation
+		size_t bytes;
+	};
+
+	// Runs the operation repeatedly for at least the given time and keeps the best run
+	template <typename Op> measurement measure(Op& op, double min_time)
+	{
+		measurement result = {1e30, 0, 0};
+		double total = 0;
+		size_t runs = 0;
+
+		while (total < min_time || runs < 3)
+		{
+			size_t count = allocation_count;
+			size_t bytes = allocation_bytes;
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			op();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (seconds < result.seconds) result.seconds = seconds;
+
+			result.allocations = allocation_count - count;
+			result.bytes = allocation_bytes - bytes;
+
+			total += seconds;
+			runs++;
+		}
+
+		return result;
+	}
+
+	void report(const document& doc, const char* operation, const measurement& m)
+	{
+		printf("%-32s %-22s %10.1f MB/s %10.3f ms %8u allocs %10u bytes\n", doc.name.c_str(), operation,
+			double(doc.contents.size()) / m.seconds / 1e6, m.seconds * 1e3, unsigned(m.allocations), unsigned(m.bytes));
+	}
+
+	struct load_op
+	{
+		const document* doc;
+		pugi::xml_document* result;
+
+		void operator()()
+		{
+			result->load_buffer(doc->contents.data(), doc->contents.size());
+		}
+	};
+
+	struct load_inplace_op
+	{
+		const document* doc;
+		pugi::xml_document* result;
+		std::vector<char>* buffer;
+
+		void operator()()
+		{
+			// the copy is part of every in-situ use, so it is included in the time
+			buffer->assign(doc->contents.begin(), doc->contents.end());
+			result->load_buffer_inplace(&(*buffer)[0], buffer->size());
+		}
+	};
+
+	struct reader_op
+	{
+		const document* doc;
+		size_t events;
+
+		void operator()()
+		{
+			pugi::xml_reader reader;
+			reader.open_buffer(doc->contents.data(), doc->contents.size());
+
+			events = 0;
+
+			while (reader.next() != pugi::reader_event_end_document && reader.event() != pugi::reader_event_error)
+				events++;
+		}
+	};
+
+	struct traverse_op
+	{
+		pugi::xml_document* source;
+		size_t nodes;
+
+		void operator()()
+		{
+			nodes = count_nodes(*source);
+		}
+	};
+
+	struct select_op
+	{
+		pugi::xml_document* source;
+		const pugi::xpath_query* queries;
+		size_t query_count;
+		size_t nodes;
+
+		void operator()()
+		{
+			nodes = 0;
+
+			for (size_t i = 0; i < query_count; ++i)
+				nodes += queries[i].evaluate_node_set(*source).size();
+		}
+	};
+
+	struct clone_op
+	{
+		pugi::xml_document* source;
+		pugi::xml_document* result;
+		bool shared;
+
+		void operator()()
+		{
+			if (shared)
+				result->reset_shared(*source);
+			else
+				result->reset(*source);
+		}
+	};
+
+	struct save_op
+	{
+		pugi::xml_document* source;
+		size_t size;
+
+		void operator()()
+		{
+			null_writer writer;
+			source->save(writer, PUGIXML_TEXT("  "));
+
+			size = writer.size;
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	double min_time = 0.5;
+
+	std::vector<document> corpus;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+		{
+			min_time = atof(argv[++i]);
+			continue;
+		}
+
+		document doc;
+		doc.name = argv[i];
+
+		if (!read_file(argv[i], doc.contents))
+		{
+			fprintf(stderr, "Can't read %s\n", argv[i]);
+			return 1;
+		}
+
+		corpus.push_back(doc);
+	}
+
+	// generated documents of typical size: small and large model descriptions and system structures
+	document doc;
+
+	doc.name = "modelDescription-100.xml";
+	doc.contents = generate_model_description(100);
+	corpus.push_back(doc);
+
+	doc.name = "modelDescription-20000.xml";
+	doc.contents = generate_model_description(20000);
+	corpus.push_back(doc);
+
+	doc.name = "SystemStructure-10.ssd";
+	doc.contents = generate_system_structure(10);
+	corpus.push_back(doc);
+
+	doc.name = "SystemStructure-1000.ssd";
+	doc.contents = generate_system_structure(1000);
+	corpus.push_back(doc);
+
+	pugi::set_memory_management_functions(counting_allocate, counting_deallocate);
+
+	// queries in the style of the FMI and SSP importers; those that don't apply to a document select nothing
+	const pugi::xpath_query queries[] =
+	{
+		pugi::xpath_query(PUGIXML_TEXT("/fmiModelDescription/ModelVariables/ScalarVariable[@causality='output']")),
+		pugi::xpath_query(PUGIXML_TEXT("/fmiModelDescription/ModelStructure/Outputs/Unknown")),
+		pugi::xpath_query(PUGIXML_TEXT("//ssd:Component[@type='application/x-fmu-sharedlibrary']")),
+		pugi::xpath_query(PUGIXML_TEXT("//ssd:Connection[@startElement='C1']")),
+	};
+
+#ifdef PUGIXML_COMPACT
+	printf("pugixml benchmark, compact mode\n");
+#else
+	printf("pugixml benchmark, normal mode\n");
+#endif
+
+	for (size_t i = 0; i < corpus.size(); ++i)
+	{
+		const document& current = corpus[i];
+
+		pugi::xml_document result;
+		std::vector<char> buffer;
+
+		load_op load = {&current, &result};
+		report(current, "load_buffer", measure(load, min_time));
+
+		load_inplace_op load_inplace = {&current, &result, &buffer};
+		report(current, "load_buffer_inplace", measure(load_inplace, min_time));
+
+		reader_op read = {&current, 0};
+		report(current, "xml_reader", measure(read, min_time));
+
+		pugi::xml_document source;
+		pugi::xml_parse_result parsed = source.load_buffer(current.contents.data(), current.contents.size());
+
+		if (!parsed)
+		{
+			fprintf(stderr, "%s: %s at offset %u\n", current.name.c_str(), parsed.description(), unsigned(parsed.offset));
+			continue;
+		}
+
+		traverse_op traverse = {&source, 0};
+		report(current, "traversal", measure(traverse, min_time));
+
+		select_op select = {&source, queries, sizeof(queries) / sizeof(queries[0]), 0};
+		report(current, "select_nodes", measure(select, min_time));
+
+		clone_op clone = {&source, &result, false};
+		report(current, "reset(proto)", measure(clone, min_time));
+
+		clone_op clone_shared = {&source, &result, true};
+		report(current, "reset_shared", measure(clone_shared, min_time));
+
+		save_op save = {&source, 0};
+		report(current, "save", measure(save, min_time));
+	}
+
+	return 0;
+}
@@ -29,6 +29,15 @@
 // Uncomment this to disable exceptions
 // #define PUGIXML_NO_EXCEPTIONS
 
+// Uncomment this to make xml_document::load_file_mapped read files into a buffer instead of memory-mapping them
+// #define PUGIXML_NO_MMAP
+
+// Uncomment this to disable the SSE2/AVX2/NEON fast paths for scanning text and attribute values
+// #define PUGIXML_NO_SIMD
+
+// Uncomment this to disable threads (xml_document::load_buffer_parallel parses serially, xpath_query_cache is not synchronized)
+// #define PUGIXML_NO_THREADS
+
 // Set this to control attributes for public classes/functions, i.e.:
 // #define PUGIXML_API __declspec(dllexport) // to export all public symbols from DLL
 // #define PUGIXML_CLASS __declspec(dllimport) // to import all classes from DLL
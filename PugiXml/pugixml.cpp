@@ -28,9 +28,10 @@
 
 #ifndef PUGIXML_NO_XPATH
 #	include <math.h>
-#	include <float.h>
 #endif
 
+#include <float.h>
+
 #ifndef PUGIXML_NO_STL
 #	include <istream>
 #	include <ostream>
@@ -40,6 +41,65 @@
 // For placement new
 #include <new>
 
+// For xpath_query_cache synchronization, parallel parsing and shared string reference counts
+#if !defined(PUGIXML_NO_THREADS) && !defined(PUGIXML_NO_STL) && (__cplusplus >= 201103 || (defined(_MSC_VER) && _MSC_VER >= 1700))
+#	define PUGI__HAS_THREADS
+#	include <atomic>
+#	include <mutex>
+#	include <thread>
+#endif
+
+// For memory-mapped file loading
+#if !defined(PUGIXML_NO_MMAP) && defined(_WIN32) && !defined(_WIN32_WCE)
+#	define PUGI__MMAP_WIN32
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#		define PUGI__UNDEF_WIN32_LEAN_AND_MEAN
+#	endif
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#		define PUGI__UNDEF_NOMINMAX
+#	endif
+#	include <windows.h>
+#	ifdef PUGI__UNDEF_WIN32_LEAN_AND_MEAN
+#		undef WIN32_LEAN_AND_MEAN
+#		undef PUGI__UNDEF_WIN32_LEAN_AND_MEAN
+#	endif
+#	ifdef PUGI__UNDEF_NOMINMAX
+#		undef NOMINMAX
+#		undef PUGI__UNDEF_NOMINMAX
+#	endif
+#elif !defined(PUGIXML_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#	define PUGI__MMAP_POSIX
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#	include <sys/mman.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+// For vectorized text scanning; the scans read past the end of the string within the current page, which address sanitizer reports
+#if defined(__SANITIZE_ADDRESS__)
+#	define PUGI__NO_SIMD
+#elif defined(__has_feature)
+#	if __has_feature(address_sanitizer)
+#		define PUGI__NO_SIMD
+#	endif
+#endif
+
+#if !defined(PUGIXML_NO_SIMD) && !defined(PUGI__NO_SIMD) && !defined(PUGIXML_WCHAR_MODE)
+#	if defined(__AVX2__)
+#		define PUGI__SIMD_AVX2
+#		include <immintrin.h>
+#	elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define PUGI__SIMD_SSE2
+#		include <emmintrin.h>
+#	elif defined(__ARM_NEON) && defined(__aarch64__)
+#		define PUGI__SIMD_NEON
+#		include <arm_neon.h>
+#	endif
+#endif
+
 #ifdef _MSC_VER
 #	pragma warning(push)
 #	pragma warning(disable: 4127) // conditional expression is constant
@@ -501,6 +561,110 @@ PUGI__NS_BEGIN
 	#endif
 		- sizeof(xml_memory_page);
 
+	// string headers encode offsets up to this size, so it limits the page sizes of page pools
+	static const size_t xml_memory_page_size_max = (1 << 16) * xml_memory_block_alignment;
+
+	// Page pool (see xml_page_pool): free pages of the pool size are linked through xml_memory_page::next; pages for larger allocations
+	// are allocated and freed directly, they are told apart by busy_size which is larger than the pool page size only for them
+	struct xml_page_pool_impl
+	{
+		size_t page_size;
+		size_t max_free_pages;
+
+		allocation_function allocate;
+		deallocation_function deallocate;
+
+		xml_memory_page* free_pages;
+		size_t free_count;
+
+	#ifdef PUGI__HAS_THREADS
+		std::mutex mutex;
+	#endif
+	};
+
+	struct xml_page_pool_lock
+	{
+	#ifdef PUGI__HAS_THREADS
+		xml_page_pool_lock(xml_page_pool_impl* impl): mutex(impl->mutex)
+		{
+			mutex.lock();
+		}
+
+		~xml_page_pool_lock()
+		{
+			mutex.unlock();
+		}
+
+		std::mutex& mutex;
+	#else
+		xml_page_pool_lock(xml_page_pool_impl*)
+		{
+		}
+	#endif
+	};
+
+	PUGI__FN void* page_pool_allocate(xml_page_pool_impl* pool, size_t data_size)
+	{
+		if (data_size > pool->page_size)
+			return pool->allocate(sizeof(xml_memory_page) + data_size);
+
+		{
+			xml_page_pool_lock lock(pool);
+
+			if (xml_memory_page* page = pool->free_pages)
+			{
+				pool->free_pages = page->next;
+				pool->free_count--;
+
+				return page;
+			}
+		}
+
+		return pool->allocate(sizeof(xml_memory_page) + pool->page_size);
+	}
+
+	PUGI__FN void page_pool_deallocate(xml_page_pool_impl* pool, xml_memory_page* page)
+	{
+		if (page->busy_size <= pool->page_size)
+		{
+			xml_page_pool_lock lock(pool);
+
+			if (pool->max_free_pages == 0 || pool->free_count < pool->max_free_pages)
+			{
+				page->next = pool->free_pages;
+				pool->free_pages = page;
+				pool->free_count++;
+
+				return;
+			}
+		}
+
+		pool->deallocate(page);
+	}
+
+	PUGI__FN void page_pool_trim(xml_page_pool_impl* pool)
+	{
+		xml_memory_page* pages;
+
+		{
+			xml_page_pool_lock lock(pool);
+
+			pages = pool->free_pages;
+
+			pool->free_pages = 0;
+			pool->free_count = 0;
+		}
+
+		while (pages)
+		{
+			xml_memory_page* next = pages->next;
+
+			pool->deallocate(pages);
+
+			pages = next;
+		}
+	}
+
 	struct xml_memory_string_header
 	{
 		uint16_t page_offset; // offset from page->data
@@ -509,7 +673,7 @@ PUGI__NS_BEGIN
 
 	struct xml_allocator
 	{
-		xml_allocator(xml_memory_page* root): _root(root), _busy_size(root->busy_size)
+		xml_allocator(xml_memory_page* root): _root(root), _busy_size(root->busy_size), _pool(0), _page_size(xml_memory_page_size)
 		{
 		#ifdef PUGIXML_COMPACT
 			_hash = 0;
@@ -521,7 +685,7 @@ PUGI__NS_BEGIN
 			size_t size = sizeof(xml_memory_page) + data_size;
 
 			// allocate block with some alignment, leaving memory for worst-case padding
-			void* memory = xml_memory::allocate(size);
+			void* memory = _pool ? page_pool_allocate(_pool, data_size) : xml_memory::allocate(size);
 			if (!memory) return 0;
 
 			// prepare page structure
@@ -536,14 +700,23 @@ PUGI__NS_BEGIN
 
 		static void deallocate_page(xml_memory_page* page)
 		{
-			xml_memory::deallocate(page);
+			if (xml_page_pool_impl* pool = page->allocator->_pool)
+				page_pool_deallocate(pool, page);
+			else
+				xml_memory::deallocate(page);
+		}
+
+		void set_pool(xml_page_pool_impl* pool)
+		{
+			_pool = pool;
+			_page_size = pool ? pool->page_size : xml_memory_page_size;
 		}
 
 		void* allocate_memory_oob(size_t size, xml_memory_page*& out_page);
 
 		void* allocate_memory(size_t size, xml_memory_page*& out_page)
 		{
-			if (PUGI__UNLIKELY(_busy_size + size > xml_memory_page_size))
+			if (PUGI__UNLIKELY(_busy_size + size > _page_size))
 				return allocate_memory_oob(size, out_page);
 
 			void* buf = reinterpret_cast<char*>(_root) + sizeof(xml_memory_page) + _busy_size;
@@ -702,6 +875,10 @@ PUGI__NS_BEGIN
 		xml_memory_page* _root;
 		size_t _busy_size;
 
+		// pages come from the pool if there is one, with its page size
+		xml_page_pool_impl* _pool;
+		size_t _page_size;
+
 	#ifdef PUGIXML_COMPACT
 		compact_hash_table* _hash;
 	#endif
@@ -709,9 +886,9 @@ PUGI__NS_BEGIN
 
 	PUGI__FN_NO_INLINE void* xml_allocator::allocate_memory_oob(size_t size, xml_memory_page*& out_page)
 	{
-		const size_t large_allocation_threshold = xml_memory_page_size / 4;
+		const size_t large_allocation_threshold = _page_size / 4;
 
-		xml_memory_page* page = allocate_page(size <= large_allocation_threshold ? xml_memory_page_size : size);
+		xml_memory_page* page = allocate_page(size <= large_allocation_threshold ? _page_size : size);
 		out_page = page;
 
 		if (!page) return 0;
@@ -1141,9 +1318,60 @@ PUGI__NS_BEGIN
 		xml_extra_buffer* next;
 	};
 
+	// read-only string storage shared by the documents cloned with xml_document::reset_shared; the strings follow the header
+	struct xml_shared_strings
+	{
+	#ifdef PUGI__HAS_THREADS
+		std::atomic<size_t> refcount;
+	#else
+		size_t refcount;
+	#endif
+
+		size_t size;
+
+		xml_shared_strings(size_t size_): refcount(1), size(size_)
+		{
+		}
+
+		char_t* data()
+		{
+			return reinterpret_cast<char_t*>(this + 1);
+		}
+
+		bool contains(const char_t* string)
+		{
+			return string >= data() && string < data() + size;
+		}
+
+		static xml_shared_strings* create(size_t size)
+		{
+			void* memory = xml_memory::allocate(sizeof(xml_shared_strings) + size * sizeof(char_t));
+			if (!memory) return 0;
+
+			return new (memory) xml_shared_strings(size);
+		}
+
+		static void release(xml_shared_strings* strings)
+		{
+			if (--strings->refcount == 0)
+			{
+				strings->~xml_shared_strings();
+				xml_memory::deallocate(strings);
+			}
+		}
+	};
+
+	struct xml_shared_strings_ref
+	{
+		xml_shared_strings* strings;
+		xml_shared_strings_ref* next;
+	};
+
+	struct xml_lookup_index;
+
 	struct xml_document_struct: public xml_node_struct, public xml_allocator
 	{
-		xml_document_struct(xml_memory_page* page): xml_node_struct(page, node_document), xml_allocator(page), buffer(0), extra_buffers(0)
+		xml_document_struct(xml_memory_page* page): xml_node_struct(page, node_document), xml_allocator(page), buffer(0), extra_buffers(0), shared_strings(0), mapped(0), mapped_size(0), index(0)
 		{
 		}
 
@@ -1151,6 +1379,16 @@ PUGI__NS_BEGIN
 
 		xml_extra_buffer* extra_buffers;
 
+		// shared string storage referenced by the document, see xml_document::reset_shared
+		xml_shared_strings_ref* shared_strings;
+
+		// file mapping used as the parse buffer by load_file_mapped
+		void* mapped;
+		size_t mapped_size;
+
+		// name lookup tables, see xml_document::enable_lookup_index
+		xml_lookup_index* index;
+
 	#ifdef PUGIXML_COMPACT
 		compact_hash_table hash;
 	#endif
@@ -1171,6 +1409,267 @@ PUGI__NS_BEGIN
 	}
 PUGI__NS_END
 
+// Name lookup index
+PUGI__NS_BEGIN
+	// hash table from names to the first child or attribute with that name, for one node
+	struct xml_lookup_table
+	{
+		xml_node_struct* node;
+		bool attributes;
+
+		// document generation the table was checked against; the table is only built on the second lookup in one generation
+		size_t generation;
+		bool built;
+
+		// zero if the node has too few items to be worth hashing
+		size_t capacity;
+		void** items;
+
+		xml_lookup_table* next;
+	};
+
+	struct xml_lookup_index
+	{
+		size_t min_size;
+
+		// incremented on every modification of the document; tables of older generations are stale
+		size_t generation;
+
+		xml_lookup_table** buckets;
+		size_t bucket_count;
+		size_t table_count;
+	};
+
+	PUGI__FN unsigned int lookup_hash(const char_t* name)
+	{
+		// FNV-1a
+		unsigned int h = 2166136261u;
+
+		for (; *name; ++name)
+			h = (h ^ static_cast<unsigned int>(*name)) * 16777619u;
+
+		return h;
+	}
+
+	PUGI__FN unsigned int lookup_hash(const xml_node_struct* node, bool attributes)
+	{
+		// MurmurHash3 32-bit finalizer
+		unsigned int h = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(node) & 0xffffffff) ^ (attributes ? 0x9e3779b9u : 0);
+
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+
+		return h;
+	}
+
+	inline xml_node_struct* lookup_first(xml_node_struct* node, xml_node_struct*) { return node->first_child; }
+	inline xml_attribute_struct* lookup_first(xml_node_struct* node, xml_attribute_struct*) { return node->first_attribute; }
+	inline xml_node_struct* lookup_next(xml_node_struct* item) { return item->next_sibling; }
+	inline xml_attribute_struct* lookup_next(xml_attribute_struct* item) { return item->next_attribute; }
+	inline bool lookup_attributes(xml_node_struct*) { return false; }
+	inline bool lookup_attributes(xml_attribute_struct*) { return true; }
+
+	PUGI__FN void index_free_table(xml_lookup_table* table)
+	{
+		if (table->items) xml_memory::deallocate(table->items);
+		xml_memory::deallocate(table);
+	}
+
+	PUGI__FN void index_clear(xml_lookup_index* index)
+	{
+		for (size_t i = 0; i < index->bucket_count; ++i)
+		{
+			for (xml_lookup_table* table = index->buckets[i]; table; )
+			{
+				xml_lookup_table* next = table->next;
+				index_free_table(table);
+				table = next;
+			}
+
+			index->buckets[i] = 0;
+		}
+
+		index->table_count = 0;
+	}
+
+	PUGI__FN void index_destroy(xml_lookup_index* index)
+	{
+		index_clear(index);
+
+		if (index->buckets) xml_memory::deallocate(index->buckets);
+		xml_memory::deallocate(index);
+	}
+
+	PUGI__FN bool index_rehash(xml_lookup_index* index)
+	{
+		size_t bucket_count = index->bucket_count ? index->bucket_count * 2 : 64;
+
+		xml_lookup_table** buckets = static_cast<xml_lookup_table**>(xml_memory::allocate(sizeof(xml_lookup_table*) * bucket_count));
+		if (!buckets) return false;
+
+		memset(buckets, 0, sizeof(xml_lookup_table*) * bucket_count);
+
+		size_t table_count = 0;
+
+		for (size_t i = 0; i < index->bucket_count; ++i)
+		{
+			for (xml_lookup_table* table = index->buckets[i]; table; )
+			{
+				xml_lookup_table* next = table->next;
+
+				// tables of removed nodes would otherwise accumulate; stale ones are cheap to rebuild
+				if (table->generation != index->generation)
+					index_free_table(table);
+				else
+				{
+					size_t bucket = lookup_hash(table->node, table->attributes) & (bucket_count - 1);
+
+					table->next = buckets[bucket];
+					buckets[bucket] = table;
+					table_count++;
+				}
+
+				table = next;
+			}
+		}
+
+		if (index->buckets) xml_memory::deallocate(index->buckets);
+
+		index->buckets = buckets;
+		index->bucket_count = bucket_count;
+		index->table_count = table_count;
+
+		return true;
+	}
+
+	PUGI__FN xml_lookup_table* index_table(xml_lookup_index* index, xml_node_struct* node, bool attributes)
+	{
+		if (index->bucket_count)
+		{
+			for (xml_lookup_table* table = index->buckets[lookup_hash(node, attributes) & (index->bucket_count - 1)]; table; table = table->next)
+				if (table->node == node && table->attributes == attributes)
+					return table;
+		}
+
+		// keep load factor below 1
+		if (index->table_count >= index->bucket_count && !index_rehash(index)) return 0;
+
+		xml_lookup_table* table = static_cast<xml_lookup_table*>(xml_memory::allocate(sizeof(xml_lookup_table)));
+		if (!table) return 0;
+
+		table->node = node;
+		table->attributes = attributes;
+		table->generation = index->generation;
+		table->built = false;
+		table->capacity = 0;
+		table->items = 0;
+
+		size_t bucket = lookup_hash(node, attributes) & (index->bucket_count - 1);
+
+		table->next = index->buckets[bucket];
+		index->buckets[bucket] = table;
+		index->table_count++;
+
+		return table;
+	}
+
+	template <typename T> PUGI__FN bool index_build(xml_lookup_index* index, xml_lookup_table* table)
+	{
+		size_t count = 0;
+
+		for (T* i = lookup_first(table->node, static_cast<T*>(0)); i; i = lookup_next(i))
+			count++;
+
+		if (table->items)
+		{
+			xml_memory::deallocate(table->items);
+			table->items = 0;
+		}
+
+		table->capacity = 0;
+
+		if (count >= index->min_size)
+		{
+			// power of two, at least twice the item count
+			size_t capacity = 16;
+			while (capacity < count * 2) capacity *= 2;
+
+			void** items = static_cast<void**>(xml_memory::allocate(sizeof(void*) * capacity));
+			if (!items) return false;
+
+			memset(items, 0, sizeof(void*) * capacity);
+
+			for (T* i = lookup_first(table->node, static_cast<T*>(0)); i; i = lookup_next(i))
+			{
+				if (!i->name) continue;
+
+				size_t bucket = lookup_hash(i->name) & (capacity - 1);
+
+				// the first item with a given name wins, as with the linear search
+				while (items[bucket] && !strequal(static_cast<T*>(items[bucket])->name, i->name))
+					bucket = (bucket + 1) & (capacity - 1);
+
+				if (!items[bucket]) items[bucket] = i;
+			}
+
+			table->capacity = capacity;
+			table->items = items;
+		}
+
+		table->built = true;
+
+		return true;
+	}
+
+	// returns false if the caller has to search linearly, otherwise sets result to the first item with the given name or to null
+	template <typename T> PUGI__FN bool index_find(xml_lookup_index* index, xml_node_struct* node, const char_t* name, T*& result)
+	{
+		xml_lookup_table* table = index_table(index, node, lookup_attributes(static_cast<T*>(0)));
+		if (!table) return false;
+
+		if (table->generation != index->generation)
+		{
+			// the document changed since the table was built; building right away would cost a full scan per lookup for documents that are modified in between lookups
+			table->generation = index->generation;
+			table->built = false;
+
+			return false;
+		}
+
+		if (!table->built && !index_build<T>(index, table)) return false;
+
+		if (!table->capacity) return false;
+
+		size_t bucket = lookup_hash(name) & (table->capacity - 1);
+
+		while (T* item = static_cast<T*>(table->items[bucket]))
+		{
+			if (strequal(item->name, name))
+			{
+				result = item;
+				return true;
+			}
+
+			bucket = (bucket + 1) & (table->capacity - 1);
+		}
+
+		result = 0;
+		return true;
+	}
+
+	template <typename Object> inline void index_invalidate(const Object* object)
+	{
+		if (!object) return;
+
+		xml_document_struct& doc = get_document(object);
+
+		if (doc.index) doc.index->generation++;
+	}
+PUGI__NS_END
+
 // Low-level DOM operations
 PUGI__NS_BEGIN
 	inline xml_attribute_struct* allocate_attribute(xml_allocator& alloc)
@@ -2599,23 +3098,97 @@ PUGI__NS_BEGIN
 	#define PUGI__THROW_ERROR(err, m)   return error_offset = m, error_status = err, static_cast<char_t*>(0)
 	#define PUGI__CHECK_ERROR(err, m)   { if (*s == 0) PUGI__THROW_ERROR(err, m); }
 
-	PUGI__FN char_t* strconv_comment(char_t* s, char_t endch)
-	{
-		gap g;
+#if defined(PUGI__SIMD_AVX2) || defined(PUGI__SIMD_SSE2) || defined(PUGI__SIMD_NEON)
+	#define PUGI__SIMD_SCAN(C0, C1, C2, C3, C4, C5, C6) { s = simd_scan<C0, C1, C2, C3, C4, C5, C6>(s); }
 
-		while (true)
-		{
-			PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_comment));
+#ifdef PUGI__SIMD_AVX2
+	static const size_t simd_width = 32;
+#else
+	static const size_t simd_width = 16;
+#endif
 
-			if (*s == '\r') // Either a single 0x0d or 0x0d 0x0a pair
-			{
-				*s++ = '\n'; // replace first one with 0x0a
+	// Loads may extend past the terminating zero, but never into the next page (4096 is the smallest page size)
+	PUGI__FN bool simd_safe(const char_t* s)
+	{
+		return (reinterpret_cast<uintptr_t>(s) & 4095) <= 4096 - simd_width;
+	}
 
-				if (*s == '\n') g.push(s, 1);
-			}
-			else if (s[0] == '-' && s[1] == '-' && PUGI__ENDSWITH(s[2], '>')) // comment ends here
-			{
-				*g.flush(s) = 0;
+#ifndef PUGI__SIMD_NEON
+	PUGI__FN unsigned int simd_ctz(unsigned int mask)
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+
+		return static_cast<unsigned int>(index);
+	#else
+		return static_cast<unsigned int>(__builtin_ctz(mask));
+	#endif
+	}
+#endif
+
+	// Skips characters that are none of C0..C6 (repeat a character to test fewer) a block at a time; stops at the first
+	// match or before a block that could cross a page boundary, the scalar loop that follows handles the rest
+	template <char C0, char C1, char C2, char C3, char C4, char C5, char C6> PUGI__FN char_t* simd_scan(char_t* s)
+	{
+		while (simd_safe(s))
+		{
+		#if defined(PUGI__SIMD_AVX2)
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+
+			__m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(C0)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(C1))),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(C2)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(C3))));
+			m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(C4)), _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(C5)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(C6)))));
+
+			unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(m));
+			if (mask) return s + simd_ctz(mask);
+		#elif defined(PUGI__SIMD_SSE2)
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+
+			__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(C0)), _mm_cmpeq_epi8(v, _mm_set1_epi8(C1))),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(C2)), _mm_cmpeq_epi8(v, _mm_set1_epi8(C3))));
+			m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(C4)), _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(C5)), _mm_cmpeq_epi8(v, _mm_set1_epi8(C6)))));
+
+			unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(m));
+			if (mask) return s + simd_ctz(mask);
+		#else
+			uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+
+			uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(C0))), vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(C1)))),
+				vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(C2))), vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(C3)))));
+			m = vorrq_u8(m, vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(C4))), vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(C5))), vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(C6))))));
+
+			// The scalar loop finds the exact position within the block
+			if (vmaxvq_u8(m)) return s;
+		#endif
+
+			s += simd_width;
+		}
+
+		return s;
+	}
+#else
+	#define PUGI__SIMD_SCAN(C0, C1, C2, C3, C4, C5, C6) { }
+#endif
+
+	PUGI__FN char_t* strconv_comment(char_t* s, char_t endch)
+	{
+		gap g;
+
+		while (true)
+		{
+			PUGI__SIMD_SCAN(0, '-', '>', '\r', 0, 0, 0);
+			PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_comment));
+
+			if (*s == '\r') // Either a single 0x0d or 0x0d 0x0a pair
+			{
+				*s++ = '\n'; // replace first one with 0x0a
+
+				if (*s == '\n') g.push(s, 1);
+			}
+			else if (s[0] == '-' && s[1] == '-' && PUGI__ENDSWITH(s[2], '>')) // comment ends here
+			{
+				*g.flush(s) = 0;
 
 				return s + (s[2] == '>' ? 3 : 2);
 			}
@@ -2633,6 +3206,7 @@ PUGI__NS_BEGIN
 
 		while (true)
 		{
+			PUGI__SIMD_SCAN(0, ']', '>', '\r', 0, 0, 0);
 			PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_cdata));
 
 			if (*s == '\r') // Either a single 0x0d or 0x0d 0x0a pair
@@ -2667,6 +3241,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
+				PUGI__SIMD_SCAN(0, '<', '&', '\r', 0, 0, 0);
 				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_pcdata));
 
 				if (*s == '<') // PCDATA ends here
@@ -2788,6 +3363,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
+				PUGI__SIMD_SCAN(0, '&', '\r', '\'', '"', '\n', '\t');
 				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr_ws));
 
 				if (*s == end_quote)
@@ -2824,6 +3400,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
+				PUGI__SIMD_SCAN(0, '&', '\r', '\'', '"', 0, 0);
 				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr));
 
 				if (*s == end_quote)
@@ -2856,6 +3433,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
+				PUGI__SIMD_SCAN(0, '&', '\r', '\'', '"', 0, 0);
 				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr));
 
 				if (*s == end_quote)
@@ -3242,13 +3820,14 @@ PUGI__NS_BEGIN
 			return s;
 		}
 
-		char_t* parse_tree(char_t* s, xml_node_struct* root, unsigned int optmsk, char_t endch)
+		// if open is specified, parsing starts inside *open (if set) and the innermost element left open is stored there instead of being an error
+		char_t* parse_tree(char_t* s, xml_node_struct* root, unsigned int optmsk, char_t endch, xml_node_struct** open = 0)
 		{
 			strconv_attribute_t strconv_attribute = get_strconv_attribute(optmsk);
 			strconv_pcdata_t strconv_pcdata = get_strconv_pcdata(optmsk);
 
 			char_t ch = 0;
-			xml_node_struct* cursor = root;
+			xml_node_struct* cursor = (open && *open) ? *open : root;
 			char_t* mark = s;
 
 			while (*s != 0)
@@ -3474,6 +4053,12 @@ PUGI__NS_BEGIN
 				}
 			}
 
+			if (open)
+			{
+				*open = cursor;
+				return s;
+			}
+
 			// check that last tag is closed
 			if (cursor != root) PUGI__THROW_ERROR(status_end_element_mismatch, s);
 
@@ -4342,6 +4927,28 @@ PUGI__NS_BEGIN
 		return false;
 	}
 
+	PUGI__FN void document_output_prolog(xml_buffered_writer& writer, unsigned int flags, xml_encoding encoding, bool declaration)
+	{
+		if ((flags & format_write_bom) && encoding != encoding_latin1)
+		{
+			// BOM always represents the codepoint U+FEFF, so just write it in native encoding
+		#ifdef PUGIXML_WCHAR_MODE
+			unsigned int bom = 0xfeff;
+			writer.write(static_cast<wchar_t>(bom));
+		#else
+			writer.write('\xef', '\xbb', '\xbf');
+		#endif
+		}
+
+		if (!(flags & format_no_declaration) && declaration)
+		{
+			writer.write_string(PUGIXML_TEXT("<?xml version=\"1.0\""));
+			if (encoding == encoding_latin1) writer.write_string(PUGIXML_TEXT(" encoding=\"ISO-8859-1\""));
+			writer.write('?', '>');
+			if (!(flags & format_raw)) writer.write('\n');
+		}
+	}
+
 	PUGI__FN bool is_attribute_of(xml_attribute_struct* attr, xml_node_struct* node)
 	{
 		for (xml_attribute_struct* a = node->first_attribute; a; a = a->next_attribute)
@@ -4401,8 +5008,9 @@ PUGI__NS_BEGIN
 				dest = source;
 
 				// since strcpy_insitu can reuse document buffer memory we need to mark both source and dest as shared
+				// source is only written if needed, so that the shared strings of one document can be copied from several threads
 				header |= xml_memory_page_contents_shared_mask;
-				source_header |= xml_memory_page_contents_shared_mask;
+				if ((source_header & xml_memory_page_contents_shared_mask) == 0) source_header |= xml_memory_page_contents_shared_mask;
 			}
 			else
 				strcpy_insitu(dest, header, header_mask, source, strlength(source));
@@ -4426,10 +5034,10 @@ PUGI__NS_BEGIN
 		}
 	}
 
-	PUGI__FN void node_copy_tree(xml_node_struct* dn, xml_node_struct* sn)
+	PUGI__FN void node_copy_tree(xml_node_struct* dn, xml_node_struct* sn, bool share_strings = false)
 	{
 		xml_allocator& alloc = get_allocator(dn);
-		xml_allocator* shared_alloc = (&alloc == &get_allocator(sn)) ? &alloc : 0;
+		xml_allocator* shared_alloc = (share_strings || &alloc == &get_allocator(sn)) ? &alloc : 0;
 
 		node_copy_contents(dn, sn, shared_alloc);
 
@@ -4489,6 +5097,131 @@ PUGI__NS_BEGIN
 		node_copy_string(da->value, da->header, xml_memory_page_value_allocated_mask, sa->value, sa->header, shared_alloc);
 	}
 
+	PUGI__FN xml_node_struct* next_in_document(xml_node_struct* node, xml_node_struct* root)
+	{
+		if (node->first_child) return node->first_child;
+
+		for (; node != root; node = node->parent)
+			if (node->next_sibling) return node->next_sibling;
+
+		return 0;
+	}
+
+	PUGI__FN bool is_shared_string(xml_document_struct* doc, const char_t* string)
+	{
+		for (xml_shared_strings_ref* ref = doc->shared_strings; ref; ref = ref->next)
+			if (ref->strings->contains(string)) return true;
+
+		return false;
+	}
+
+	PUGI__FN size_t unshared_string_size(xml_document_struct* doc, const char_t* string)
+	{
+		return (string && !is_shared_string(doc, string)) ? strlength(string) + 1 : 0;
+	}
+
+	template <typename String, typename Header>
+	PUGI__FN void move_to_shared_strings(String& string, Header& header, uintptr_t header_mask, xml_document_struct* doc, char_t*& cursor)
+	{
+		char_t* source = string;
+		if (!source || is_shared_string(doc, source)) return;
+
+		size_t length = strlength(source);
+
+		memcpy(cursor, source, (length + 1) * sizeof(char_t));
+		string = cursor;
+		cursor += length + 1;
+
+		if (header & header_mask) doc->deallocate_string(source);
+
+		// shared strings are never modified in place
+		header &= ~header_mask;
+		header |= xml_memory_page_contents_shared_mask;
+	}
+
+	PUGI__FN xml_shared_strings_ref* add_shared_strings_ref(xml_document_struct* doc, xml_shared_strings* strings)
+	{
+		xml_memory_page* page = 0;
+		xml_shared_strings_ref* ref = static_cast<xml_shared_strings_ref*>(doc->allocate_memory(sizeof(xml_shared_strings_ref) + sizeof(void*), page));
+		(void)page;
+
+		if (!ref) return 0;
+
+	#ifdef PUGIXML_COMPACT
+		// align the memory block to a pointer boundary, see xml_node::append_buffer
+		ref = reinterpret_cast<xml_shared_strings_ref*>((reinterpret_cast<uintptr_t>(ref) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	#endif
+
+		ref->strings = strings;
+		ref->next = doc->shared_strings;
+		doc->shared_strings = ref;
+
+		return ref;
+	}
+
+	// moves all strings of the document that are not in shared storage yet to a new shared storage block
+	PUGI__FN bool share_document_strings(xml_document_struct* doc)
+	{
+		size_t size = 0;
+
+		for (xml_node_struct* node = doc; node; node = next_in_document(node, doc))
+		{
+			size += unshared_string_size(doc, node->name) + unshared_string_size(doc, node->value);
+
+			for (xml_attribute_struct* attr = node->first_attribute; attr; attr = attr->next_attribute)
+				size += unshared_string_size(doc, attr->name) + unshared_string_size(doc, attr->value);
+		}
+
+		if (size == 0) return true;
+
+		xml_shared_strings* strings = xml_shared_strings::create(size);
+		if (!strings) return false;
+
+		if (!add_shared_strings_ref(doc, strings))
+		{
+			xml_shared_strings::release(strings);
+			return false;
+		}
+
+		char_t* cursor = strings->data();
+
+		for (xml_node_struct* node = doc; node; node = next_in_document(node, doc))
+		{
+			// in compact mode, each string assignment could result in a hash table request
+			if (!doc->reserve()) return false;
+
+			move_to_shared_strings(node->name, node->header, xml_memory_page_name_allocated_mask, doc, cursor);
+			move_to_shared_strings(node->value, node->header, xml_memory_page_value_allocated_mask, doc, cursor);
+
+			for (xml_attribute_struct* attr = node->first_attribute; attr; attr = attr->next_attribute)
+			{
+				if (!doc->reserve()) return false;
+
+				move_to_shared_strings(attr->name, attr->header, xml_memory_page_name_allocated_mask, doc, cursor);
+				move_to_shared_strings(attr->value, attr->header, xml_memory_page_value_allocated_mask, doc, cursor);
+			}
+		}
+
+		assert(cursor == strings->data() + size);
+
+		// disable document_buffer_order optimization since the strings are no longer in the document buffer
+		doc->header |= xml_memory_page_contents_shared_mask;
+
+		return true;
+	}
+
+	PUGI__FN bool copy_shared_strings_refs(xml_document_struct* doc, xml_document_struct* source)
+	{
+		for (xml_shared_strings_ref* ref = source->shared_strings; ref; ref = ref->next)
+		{
+			if (!add_shared_strings_ref(doc, ref->strings)) return false;
+
+			ref->strings->refcount++;
+		}
+
+		return true;
+	}
+
 	inline bool is_text_node(xml_node_struct* node)
 	{
 		xml_node_type type = PUGI__NODETYPE(node);
@@ -4628,6 +5361,145 @@ PUGI__NS_BEGIN
 	}
 #endif
 
+	// Locale-independent fast path for plain decimal numbers: a mantissa of at most 15 significant digits and a power of ten up to 1e22
+	// are both exact in a double, so one multiplication or division gives the correctly rounded result (Clinger's fast path).
+	// Everything else (more digits, larger exponents, hex, inf/nan, surrounding whitespace) goes to get_value_double.
+	PUGI__FN double get_value_double_fast(const char_t* value)
+	{
+	#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0
+		static const double powers[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		const char_t* s = value;
+
+		bool negative = (*s == '-');
+		if (*s == '-' || *s == '+') ++s;
+
+		double mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool any = false;
+
+		for (; static_cast<unsigned int>(*s - '0') < 10; ++s)
+		{
+			if (mantissa != 0 || *s != '0')
+			{
+				if (++digits > 15) return get_value_double(value);
+
+				mantissa = mantissa * 10 + (*s - '0');
+			}
+
+			any = true;
+		}
+
+		if (*s == '.')
+		{
+			for (++s; static_cast<unsigned int>(*s - '0') < 10; ++s)
+			{
+				if (mantissa != 0 || *s != '0')
+				{
+					if (++digits > 15) return get_value_double(value);
+
+					mantissa = mantissa * 10 + (*s - '0');
+				}
+
+				exponent--;
+				any = true;
+			}
+		}
+
+		if (!any) return get_value_double(value);
+
+		if (*s == 'e' || *s == 'E')
+		{
+			++s;
+
+			bool exponent_negative = (*s == '-');
+			if (*s == '-' || *s == '+') ++s;
+
+			if (static_cast<unsigned int>(*s - '0') >= 10) return get_value_double(value);
+
+			int e = 0;
+
+			for (; static_cast<unsigned int>(*s - '0') < 10; ++s)
+			{
+				if (e > 1000) return get_value_double(value);
+
+				e = e * 10 + (*s - '0');
+			}
+
+			exponent += exponent_negative ? -e : e;
+		}
+
+		if (*s || exponent < -22 || exponent > 22) return get_value_double(value);
+
+		double result = exponent < 0 ? mantissa / powers[-exponent] : mantissa * powers[exponent];
+
+		return negative ? -result : result;
+	#else
+		// excess precision would round twice
+		return get_value_double(value);
+	#endif
+	}
+
+	struct attribute_value_double
+	{
+		typedef double value_type;
+
+		static double convert(const char_t* value) { return get_value_double_fast(value); }
+	};
+
+	struct attribute_value_int
+	{
+		typedef int value_type;
+
+		static int convert(const char_t* value) { return get_value_int(value); }
+	};
+
+#ifdef PUGIXML_HAS_LONG_LONG
+	struct attribute_value_llong
+	{
+		typedef long long value_type;
+
+		static long long convert(const char_t* value) { return get_value_llong(value); }
+	};
+#endif
+
+	template <typename T> PUGI__FN typename T::value_type attribute_value(xml_attribute_struct* attr, typename T::value_type def)
+	{
+		return (attr && attr->value) ? T::convert(attr->value) : def;
+	}
+
+	PUGI__FN xml_attribute_struct* find_attribute(xml_node_struct* node, const char_t* attr_name)
+	{
+		for (xml_attribute_struct* a = node->first_attribute; a; a = a->next_attribute)
+			if (a->name && strequal(attr_name, a->name))
+				return a;
+
+		return 0;
+	}
+
+	template <typename T> PUGI__FN size_t children_attribute_values(xml_node_struct* node, const char_t* name, const char_t* attr_name, typename T::value_type* result, size_t capacity, typename T::value_type def)
+	{
+		size_t count = 0;
+
+		for (xml_node_struct* i = node->first_child; i; i = i->next_sibling)
+		{
+			if (PUGI__NODETYPE(i) != node_element) continue;
+			if (name && !(i->name && strequal(name, i->name))) continue;
+
+			if (count < capacity)
+				result[count] = attribute_value<T>(find_attribute(i, attr_name), def);
+
+			count++;
+		}
+
+		return count;
+	}
+
 	template <typename U> PUGI__FN PUGI__UNSIGNED_OVERFLOW char_t* integer_to_string(char_t* begin, char_t* end, U value, bool negative)
 	{
 		char_t* result = end - 1;
@@ -4699,52 +5571,406 @@ PUGI__NS_BEGIN
 		return strcpy_insitu(dest, header, header_mask, value ? PUGIXML_TEXT("true") : PUGIXML_TEXT("false"), value ? 4 : 5);
 	}
 
-	PUGI__FN xml_parse_result load_buffer_impl(xml_document_struct* doc, xml_node_struct* root, void* contents, size_t size, unsigned int options, xml_encoding encoding, bool is_mutable, bool own, char_t** out_buffer)
+#if defined(PUGI__HAS_THREADS) && !defined(PUGIXML_COMPACT)
+	// Parallel parsing: the children of the document element are split into chunks of complete top-level nodes (each chunk ends with
+	// the '>' of a child element), the chunks are parsed on worker threads into detached nodes with private allocators, and the
+	// prolog, the tail after the last chunk and the epilogue are parsed on the calling thread around them. Any failure is reported to
+	// the caller, which then parses the document serially, so errors and unusual documents behave exactly like load_buffer.
+	static const size_t parallel_min_chunk = 64 * 1024;
+
+	PUGI__FN const char_t* parallel_find(const char_t* s, const char_t* end, char_t ch)
 	{
-		// check input buffer
-		if (!contents && size) return make_parse_result(status_io_error);
+	#ifdef PUGIXML_WCHAR_MODE
+		while (s < end && *s != ch) ++s;
 
-		// get actual encoding
-		xml_encoding buffer_encoding = impl::get_buffer_encoding(encoding, contents, size);
+		return s < end ? s : 0;
+	#else
+		return s < end ? static_cast<const char_t*>(memchr(s, ch, static_cast<size_t>(end - s))) : 0;
+	#endif
+	}
 
-		// get private buffer
-		char_t* buffer = 0;
-		size_t length = 0;
+	// returns pointer past the terminator that starts with ch (e.g. "?>", "-->", "]]>") or null
+	PUGI__FN const char_t* parallel_skip_until(const char_t* s, const char_t* end, const char_t* terminator)
+	{
+		size_t length = strlength(terminator);
 
-		// coverity[var_deref_model]
-		if (!impl::convert_buffer(buffer, length, buffer_encoding, contents, size, is_mutable)) return impl::make_parse_result(status_out_of_memory);
+		while ((s = parallel_find(s, end, terminator[0])) != 0)
+		{
+			if (static_cast<size_t>(end - s) >= length && strequalrange(terminator, s, length)) return s + length;
 
-		// delete original buffer if we performed a conversion
-		if (own && buffer != contents && contents) impl::xml_memory::deallocate(contents);
+			++s;
+		}
 
-		// grab onto buffer if it's our buffer, user is responsible for deallocating contents himself
-		if (own || buffer != contents) *out_buffer = buffer;
+		return 0;
+	}
 
-		// store buffer for offset_debug
-		doc->buffer = buffer;
+	// returns pointer to the '>' that ends a tag body, skipping quoted attribute values, or null
+	PUGI__FN const char_t* parallel_skip_tag(const char_t* s, const char_t* end)
+	{
+		for (; s < end; ++s)
+		{
+			if (*s == '>') return s;
 
-		// parse
-		xml_parse_result res = impl::xml_parser::parse(buffer, length, doc, root, options);
+			if (*s == '"' || *s == '\'')
+			{
+				s = parallel_find(s + 1, end, *s);
+				if (!s) return 0;
+			}
+		}
 
-		// remember encoding
-		res.encoding = buffer_encoding;
+		return 0;
+	}
 
-		return res;
+	PUGI__FN bool parallel_starts(const char_t* s, const char_t* end, const char_t* prefix)
+	{
+		size_t length = strlength(prefix);
+
+		return static_cast<size_t>(end - s) >= length && strequalrange(prefix, s, length);
 	}
 
-	// we need to get length of entire file to load it in memory; the only (relatively) sane way to do it is via seek/tell trick
-	PUGI__FN xml_parse_status get_file_size(FILE* file, size_t& out_result)
+	// splits the content of the document element after top-level child elements into at most count chunks of similar size
+	// splits[0] is the start of the content, splits[i] the end of chunk i; returns the number of chunks or 0 if the structure isn't simple enough
+	PUGI__FN size_t parallel_split(const char_t* buffer, size_t length, size_t count, size_t* splits)
 	{
-	#if defined(PUGI__MSVC_CRT_VERSION) && PUGI__MSVC_CRT_VERSION >= 1400
-		// there are 64-bit versions of fseek/ftell, let's use them
-		typedef __int64 length_type;
+		const char_t* end = buffer + length;
+		const char_t* s = xml_parser::parse_skip_bom(const_cast<char_t*>(buffer));
 
-		_fseeki64(file, 0, SEEK_END);
-		length_type length = _ftelli64(file);
-		_fseeki64(file, 0, SEEK_SET);
-	#elif defined(__MINGW32__) && !defined(__NO_MINGW_LFS) && (!defined(__STRICT_ANSI__) || defined(__MINGW64_VERSION_MAJOR))
-		// there are 64-bit versions of fseek/ftell, let's use them
-		typedef off64_t length_type;
+		// prolog: declaration, processing instructions, comments and DOCTYPE without internal subset
+		while (true)
+		{
+			while (s < end && PUGI__IS_CHARTYPE(*s, ct_space)) ++s;
+
+			if (end - s < 2 || *s != '<') return 0;
+
+			if (s[1] == '?')
+				s = parallel_skip_until(s + 2, end, PUGIXML_TEXT("?>"));
+			else if (parallel_starts(s, end, PUGIXML_TEXT("<!--")))
+				s = parallel_skip_until(s + 4, end, PUGIXML_TEXT("-->"));
+			else if (s[1] == '!')
+			{
+				const char_t* tag_end = parallel_skip_tag(s + 2, end);
+				if (!tag_end || parallel_find(s, tag_end, '[')) return 0;
+
+				s = tag_end + 1;
+			}
+			else break;
+
+			if (!s) return 0;
+		}
+
+		// document element start tag; empty elements have nothing to split
+		const char_t* tag_end = parallel_skip_tag(s + 1, end);
+		if (!tag_end || tag_end[-1] == '/') return 0;
+
+		const char_t* last = tag_end + 1;
+		const char_t* boundary = 0;
+
+		size_t chunk = static_cast<size_t>(end - last) / count;
+		size_t result = 0;
+		size_t depth = 1;
+
+		splits[0] = static_cast<size_t>(last - buffer);
+
+		for (s = last; ; )
+		{
+			s = parallel_find(s, end, '<');
+			if (!s || end - s < 2) return 0;
+
+			if (s[1] == '/')
+			{
+				tag_end = parallel_find(s + 2, end, '>');
+				if (!tag_end) return 0;
+
+				// document element end tag
+				if (--depth == 0) break;
+
+				s = tag_end + 1;
+			}
+			else if (s[1] == '?')
+			{
+				s = parallel_skip_until(s + 2, end, PUGIXML_TEXT("?>"));
+				if (!s) return 0;
+
+				continue;
+			}
+			else if (s[1] == '!')
+			{
+				if (parallel_starts(s, end, PUGIXML_TEXT("<!--")))
+					s = parallel_skip_until(s + 4, end, PUGIXML_TEXT("-->"));
+				else if (parallel_starts(s, end, PUGIXML_TEXT("<![CDATA[")))
+					s = parallel_skip_until(s + 9, end, PUGIXML_TEXT("]]>"));
+				else
+					return 0;
+
+				if (!s) return 0;
+
+				continue;
+			}
+			else
+			{
+				tag_end = parallel_skip_tag(s + 1, end);
+				if (!tag_end) return 0;
+
+				s = tag_end + 1;
+
+				if (tag_end[-1] != '/') depth++;
+			}
+
+			// s is right after a child element of the document element
+			if (depth == 1)
+			{
+				boundary = s;
+
+				if (result + 1 < count && static_cast<size_t>(s - last) >= chunk)
+				{
+					splits[++result] = static_cast<size_t>(s - buffer);
+					last = s;
+				}
+			}
+		}
+
+		// the last chunk extends to the last child element; the remaining tail is parsed with the document element end tag
+		if (boundary && boundary > last)
+			splits[++result] = static_cast<size_t>(boundary - buffer);
+
+		return result;
+	}
+
+	struct parallel_task
+	{
+		char_t* begin;
+		size_t length;
+		unsigned int optmsk;
+		xml_node_struct* parent;
+		xml_page_pool_impl* pool;
+
+		// results
+		bool ok;
+		xml_node_struct* holder;
+		xml_memory_page* first_page;
+		xml_memory_page* last_page;
+
+		// allocation starts with a sentinel page that never holds data, like the embedded page of xml_document
+		xml_memory_page sentinel;
+
+		std::thread thread;
+
+		static void run(parallel_task* task)
+		{
+			xml_memory_page* sentinel = xml_memory_page::construct(&task->sentinel);
+			sentinel->busy_size = xml_memory_page_size_max;
+
+			xml_allocator alloc(sentinel);
+			alloc.set_pool(task->pool);
+			sentinel->allocator = &alloc;
+
+			task->ok = false;
+			task->holder = allocate_node(alloc, node_element);
+
+			if (task->holder)
+			{
+				// pretend to be inside an element for the checks that depend on the parent
+				task->holder->parent = task->parent;
+
+				xml_parser parser(&alloc);
+
+				char_t* last = task->begin + task->length - 1;
+				char_t endch = *last;
+				*last = 0;
+
+				char_t* s = parser.parse_tree(task->begin, task->holder, task->optmsk, endch);
+
+				// parsing stops early on embedded null characters, where the serial parse would have failed
+				task->ok = parser.error_status == status_ok && s == last;
+			}
+
+			// hand the pages over to the document
+			alloc._root->busy_size = alloc._busy_size;
+
+			task->first_page = sentinel->next;
+			task->last_page = sentinel->next ? alloc._root : 0;
+		}
+	};
+
+	PUGI__FN bool parse_parallel(xml_document_struct* doc, char_t* buffer, size_t length, unsigned int optmsk, unsigned int threads)
+	{
+		size_t* splits = static_cast<size_t*>(xml_memory::allocate((threads + 1) * sizeof(size_t)));
+		if (!splits) return false;
+
+		size_t count = parallel_split(buffer, length, threads, splits);
+
+		parallel_task* tasks = count >= 2 ? static_cast<parallel_task*>(xml_memory::allocate(count * sizeof(parallel_task))) : 0;
+
+		if (!tasks)
+		{
+			xml_memory::deallocate(splits);
+			return false;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			parallel_task* task = new (&tasks[i]) parallel_task();
+
+			task->begin = buffer + splits[i];
+			task->length = splits[i + 1] - splits[i];
+			task->optmsk = optmsk;
+			task->parent = doc;
+			task->pool = doc->_pool;
+		}
+
+		// all but the last chunk are parsed on worker threads; if threads can't be created, the chunks are parsed here
+		for (size_t i = 0; i + 1 < count; ++i)
+		{
+		#ifndef PUGIXML_NO_EXCEPTIONS
+			try
+			{
+				tasks[i].thread = std::thread(parallel_task::run, &tasks[i]);
+			}
+			catch (...)
+			{
+				parallel_task::run(&tasks[i]);
+			}
+		#else
+			tasks[i].thread = std::thread(parallel_task::run, &tasks[i]);
+		#endif
+		}
+
+		// prolog and document element start tag
+		xml_parser parser(doc);
+		xml_node_struct* element = 0;
+
+		char_t* prolog_end = buffer + splits[0] - 1;
+		char_t prolog_endch = *prolog_end;
+		*prolog_end = 0;
+
+		bool ok = parser.parse_tree(xml_parser::parse_skip_bom(buffer), doc, optmsk, prolog_endch, &element) == prolog_end && parser.error_status == status_ok && element && element->parent == doc;
+
+		parallel_task::run(&tasks[count - 1]);
+
+		xml_memory_page* root_page = PUGI__GETPAGE(doc);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			parallel_task& task = tasks[i];
+
+			if (task.thread.joinable()) task.thread.join();
+
+			ok &= task.ok;
+
+			// splice pages after the embedded document page so that the last page of the document stays the allocation page
+			if (task.first_page)
+			{
+				for (xml_memory_page* page = task.first_page; page; page = page->next)
+					page->allocator = doc;
+
+				task.first_page->prev = root_page;
+				task.last_page->next = root_page->next;
+				if (root_page->next) root_page->next->prev = task.last_page;
+				root_page->next = task.first_page;
+			}
+		}
+
+		if (ok)
+		{
+			// move the chunk nodes to the document element in order
+			for (size_t i = 0; i < count; ++i)
+			{
+				xml_node_struct* holder = tasks[i].holder;
+
+				if (xml_node_struct* head = holder->first_child)
+				{
+					xml_node_struct* tail = head->prev_sibling_c;
+
+					for (xml_node_struct* child = head; child; child = child->next_sibling)
+						child->parent = element;
+
+					if (xml_node_struct* first = element->first_child)
+					{
+						xml_node_struct* last = first->prev_sibling_c;
+
+						last->next_sibling = head;
+						head->prev_sibling_c = last;
+						first->prev_sibling_c = tail;
+					}
+					else
+						element->first_child = head;
+
+					holder->first_child = 0;
+				}
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				doc->deallocate_memory(tasks[i].holder, sizeof(xml_node_struct), PUGI__GETPAGE(tasks[i].holder));
+
+			// tail of the document element content, its end tag and epilogue, finished like xml_parser::parse
+			char_t* tail = buffer + splits[count];
+			char_t* last = buffer + length - 1;
+
+			char_t endch = *last;
+			*last = 0;
+
+			xml_node_struct* open = element;
+			parser.parse_tree(tail, doc, optmsk, endch, &open);
+
+			ok = parser.error_status == status_ok && open == doc && endch != '<';
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			tasks[i].~parallel_task();
+
+		xml_memory::deallocate(tasks);
+		xml_memory::deallocate(splits);
+
+		return ok;
+	}
+#endif
+
+	PUGI__FN xml_parse_result load_buffer_impl(xml_document_struct* doc, xml_node_struct* root, void* contents, size_t size, unsigned int options, xml_encoding encoding, bool is_mutable, bool own, char_t** out_buffer)
+	{
+		// check input buffer
+		if (!contents && size) return make_parse_result(status_io_error);
+
+		// get actual encoding
+		xml_encoding buffer_encoding = impl::get_buffer_encoding(encoding, contents, size);
+
+		// get private buffer
+		char_t* buffer = 0;
+		size_t length = 0;
+
+		// coverity[var_deref_model]
+		if (!impl::convert_buffer(buffer, length, buffer_encoding, contents, size, is_mutable)) return impl::make_parse_result(status_out_of_memory);
+
+		// delete original buffer if we performed a conversion
+		if (own && buffer != contents && contents) impl::xml_memory::deallocate(contents);
+
+		// grab onto buffer if it's our buffer, user is responsible for deallocating contents himself
+		if (own || buffer != contents) *out_buffer = buffer;
+
+		// store buffer for offset_debug
+		doc->buffer = buffer;
+
+		// parse
+		xml_parse_result res = impl::xml_parser::parse(buffer, length, doc, root, options);
+
+		// remember encoding
+		res.encoding = buffer_encoding;
+
+		return res;
+	}
+
+	// we need to get length of entire file to load it in memory; the only (relatively) sane way to do it is via seek/tell trick
+	PUGI__FN xml_parse_status get_file_size(FILE* file, size_t& out_result)
+	{
+	#if defined(PUGI__MSVC_CRT_VERSION) && PUGI__MSVC_CRT_VERSION >= 1400
+		// there are 64-bit versions of fseek/ftell, let's use them
+		typedef __int64 length_type;
+
+		_fseeki64(file, 0, SEEK_END);
+		length_type length = _ftelli64(file);
+		_fseeki64(file, 0, SEEK_SET);
+	#elif defined(__MINGW32__) && !defined(__NO_MINGW_LFS) && (!defined(__STRICT_ANSI__) || defined(__MINGW64_VERSION_MAJOR))
+		// there are 64-bit versions of fseek/ftell, let's use them
+		typedef off64_t length_type;
 
 		fseeko64(file, 0, SEEK_END);
 		length_type length = ftello64(file);
@@ -4949,164 +6175,1548 @@ PUGI__NS_BEGIN
 		size_t actual_length = static_cast<size_t>(stream.gcount());
 		assert(actual_length <= read_length);
 
-		*out_buffer = buffer.release();
-		*out_size = actual_length * sizeof(T);
+		*out_buffer = buffer.release();
+		*out_size = actual_length * sizeof(T);
+
+		return status_ok;
+	}
+
+	template <typename T> PUGI__FN xml_parse_result load_stream_impl(xml_document_struct* doc, std::basic_istream<T>& stream, unsigned int options, xml_encoding encoding, char_t** out_buffer)
+	{
+		void* buffer = 0;
+		size_t size = 0;
+		xml_parse_status status = status_ok;
+
+		// if stream has an error bit set, bail out (otherwise tellg() can fail and we'll clear error bits)
+		if (stream.fail()) return make_parse_result(status_io_error);
+
+		// load stream to memory (using seek-based implementation if possible, since it's faster and takes less memory)
+		if (stream.tellg() < 0)
+		{
+			stream.clear(); // clear error flags that could be set by a failing tellg
+			status = load_stream_data_noseek(stream, &buffer, &size);
+		}
+		else
+			status = load_stream_data_seek(stream, &buffer, &size);
+
+		if (status != status_ok) return make_parse_result(status);
+
+		xml_encoding real_encoding = get_buffer_encoding(encoding, buffer, size);
+
+		return load_buffer_impl(doc, doc, buffer, zero_terminate_buffer(buffer, size, real_encoding), options, real_encoding, true, true, out_buffer);
+	}
+#endif
+
+#if defined(PUGI__MSVC_CRT_VERSION) || defined(__BORLANDC__) || (defined(__MINGW32__) && (!defined(__STRICT_ANSI__) || defined(__MINGW64_VERSION_MAJOR)))
+	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
+	{
+#if defined(PUGI__MSVC_CRT_VERSION) && PUGI__MSVC_CRT_VERSION >= 1400
+		FILE* file = 0;
+		return _wfopen_s(&file, path, mode) == 0 ? file : 0;
+#else
+		return _wfopen(path, mode);
+#endif
+	}
+#else
+	PUGI__FN char* convert_path_heap(const wchar_t* str)
+	{
+		assert(str);
+
+		// first pass: get length in utf8 characters
+		size_t length = strlength_wide(str);
+		size_t size = as_utf8_begin(str, length);
+
+		// allocate resulting string
+		char* result = static_cast<char*>(xml_memory::allocate(size + 1));
+		if (!result) return 0;
+
+		// second pass: convert to utf8
+		as_utf8_end(result, size, str, length);
+
+		// zero-terminate
+		result[size] = 0;
+
+		return result;
+	}
+
+	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
+	{
+		// there is no standard function to open wide paths, so our best bet is to try utf8 path
+		char* path_utf8 = convert_path_heap(path);
+		if (!path_utf8) return 0;
+
+		// convert mode to ASCII (we mirror _wfopen interface)
+		char mode_ascii[4] = {0};
+		for (size_t i = 0; mode[i]; ++i) mode_ascii[i] = static_cast<char>(mode[i]);
+
+		// try to open the utf8 path
+		FILE* result = fopen(path_utf8, mode_ascii);
+
+		// free dummy buffer
+		xml_memory::deallocate(path_utf8);
+
+		return result;
+	}
+#endif
+
+	PUGI__FN FILE* open_file(const char* path, const char* mode)
+	{
+#if defined(PUGI__MSVC_CRT_VERSION) && PUGI__MSVC_CRT_VERSION >= 1400
+		FILE* file = 0;
+		return fopen_s(&file, path, mode) == 0 ? file : 0;
+#else
+		return fopen(path, mode);
+#endif
+	}
+
+#if defined(PUGI__MMAP_WIN32)
+	PUGI__FN void* map_file_handle(HANDLE file, size_t& out_size)
+	{
+		if (file == INVALID_HANDLE_VALUE) return 0;
+
+		void* result = 0;
+		LARGE_INTEGER length;
+
+		// empty files can't be mapped, and files that don't fit into the address space are left to the regular loader
+		if (GetFileSizeEx(file, &length) && length.QuadPart > 0 && static_cast<LONGLONG>(static_cast<size_t>(length.QuadPart)) == length.QuadPart)
+		{
+			// copy-on-write mapping: in-place parsing modifies the pages of the view, never the file
+			if (HANDLE mapping = CreateFileMappingW(file, 0, PAGE_WRITECOPY, 0, 0, 0))
+			{
+				result = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				out_size = static_cast<size_t>(length.QuadPart);
+
+				// the view keeps the mapping object alive
+				CloseHandle(mapping);
+			}
+		}
+
+		CloseHandle(file);
+
+		return result;
+	}
+
+	PUGI__FN void* map_file(const char* path, size_t& out_size)
+	{
+		return map_file_handle(CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0), out_size);
+	}
+
+	PUGI__FN void* map_file_wide(const wchar_t* path, size_t& out_size)
+	{
+		return map_file_handle(CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0), out_size);
+	}
+
+	PUGI__FN void unmap_file(void* data, size_t)
+	{
+		UnmapViewOfFile(data);
+	}
+#elif defined(PUGI__MMAP_POSIX)
+	PUGI__FN void* map_file(const char* path, size_t& out_size)
+	{
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) return 0;
+
+		void* result = 0;
+		struct stat st;
+
+		// only regular files can be mapped; empty files and files that don't fit into the address space are left to the regular loader
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && static_cast<off_t>(static_cast<size_t>(st.st_size)) == st.st_size)
+		{
+			size_t size = static_cast<size_t>(st.st_size);
+
+			// copy-on-write mapping: in-place parsing modifies the pages of the mapping, never the file
+			void* data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+			if (data != MAP_FAILED)
+			{
+				result = data;
+				out_size = size;
+			}
+		}
+
+		// the mapping stays valid after the descriptor is closed
+		close(fd);
+
+		return result;
+	}
+
+	PUGI__FN void* map_file_wide(const wchar_t* path, size_t& out_size)
+	{
+		char* path_utf8 = convert_path_heap(path);
+		if (!path_utf8) return 0;
+
+		void* result = map_file(path_utf8, out_size);
+
+		xml_memory::deallocate(path_utf8);
+
+		return result;
+	}
+
+	PUGI__FN void unmap_file(void* data, size_t size)
+	{
+		munmap(data, size);
+	}
+#endif
+
+#if defined(PUGI__MMAP_WIN32) || defined(PUGI__MMAP_POSIX)
+	PUGI__FN xml_parse_result load_mapped_impl(xml_document_struct* doc, void* data, size_t size, unsigned int options, xml_encoding encoding, char_t** out_buffer)
+	{
+		// the document unmaps the file when it's destroyed
+		doc->mapped = data;
+		doc->mapped_size = size;
+
+		xml_parse_result res = load_buffer_impl(doc, doc, data, size, options, encoding, true, false, out_buffer);
+
+		// if the contents had to be converted, the document data lives in the converted buffer and the mapping is no longer needed
+		if (doc->buffer != data)
+		{
+			unmap_file(data, size);
+
+			doc->mapped = 0;
+			doc->mapped_size = 0;
+		}
+
+		return res;
+	}
+#endif
+
+	PUGI__FN bool save_file_impl(const xml_document& doc, FILE* file, const char_t* indent, unsigned int flags, xml_encoding encoding)
+	{
+		if (!file) return false;
+
+		xml_writer_file writer(file);
+		doc.save(writer, indent, flags, encoding);
+
+		return ferror(file) == 0;
+	}
+
+	struct name_null_sentry
+	{
+		xml_node_struct* node;
+		char_t* name;
+
+		name_null_sentry(xml_node_struct* node_): node(node_), name(node_->name)
+		{
+			node->name = 0;
+		}
+
+		~name_null_sentry()
+		{
+			node->name = name;
+		}
+	};
+PUGI__NS_END
+
+PUGI__NS_BEGIN
+	// Serializer state; the output follows node_output for the equivalent tree, the names of the open elements are kept as a stack
+	// of zero-terminated strings for the closing tags, and the indentation string is stored after the structure
+	struct xml_serializer_impl
+	{
+		xml_serializer_impl(xml_writer& writer_, unsigned int flags_, xml_encoding encoding): writer(writer_, encoding), flags(flags_), indent(0), indent_length(0), indent_flags(indent_indent), depth(0), open(false), closed(false), names(0), names_size(0), names_capacity(0)
+		{
+		}
+
+		xml_buffered_writer writer;
+
+		unsigned int flags;
+		const char_t* indent;
+		size_t indent_length;
+		unsigned int indent_flags;
+		size_t depth;
+
+		bool open; // the start tag of the innermost element is not finished yet
+		bool closed;
+
+		char_t* names;
+		size_t names_size;
+		size_t names_capacity;
+
+		static xml_serializer_impl* create(xml_writer& writer, const char_t* indent, unsigned int flags, xml_encoding encoding)
+		{
+			size_t indent_length = ((flags & (format_indent | format_indent_attributes)) && (flags & format_raw) == 0) ? strlength(indent) : 0;
+
+			void* memory = xml_memory::allocate(sizeof(xml_serializer_impl) + (indent_length + 1) * sizeof(char_t));
+			if (!memory) return 0;
+
+			xml_serializer_impl* result = new (memory) xml_serializer_impl(writer, flags, encoding);
+
+			char_t* indent_copy = reinterpret_cast<char_t*>(result + 1);
+			memcpy(indent_copy, indent, indent_length * sizeof(char_t));
+			indent_copy[indent_length] = 0;
+
+			result->indent = indent_copy;
+			result->indent_length = indent_length;
+
+			return result;
+		}
+
+		static void destroy(xml_serializer_impl* impl)
+		{
+			if (impl->names) xml_memory::deallocate(impl->names);
+
+			impl->~xml_serializer_impl();
+			xml_memory::deallocate(impl);
+		}
+
+		bool push_name(const char_t* name)
+		{
+			size_t length = strlength(name) + 1;
+
+			if (names_size + length > names_capacity)
+			{
+				size_t capacity = names_capacity ? names_capacity * 2 : 64;
+				if (capacity < names_size + length) capacity = names_size + length;
+
+				char_t* storage = static_cast<char_t*>(xml_memory::allocate(capacity * sizeof(char_t)));
+				if (!storage) return false;
+
+				if (names)
+				{
+					memcpy(storage, names, names_size * sizeof(char_t));
+					xml_memory::deallocate(names);
+				}
+
+				names = storage;
+				names_capacity = capacity;
+			}
+
+			memcpy(names + names_size, name, length * sizeof(char_t));
+			names_size += length;
+
+			return true;
+		}
+
+		const char_t* top_name() const
+		{
+			assert(names_size > 0 && names[names_size - 1] == 0);
+
+			size_t start = names_size - 1;
+			while (start > 0 && names[start - 1] != 0) --start;
+
+			return names + start;
+		}
+
+		// finishes the start tag once the element gets content
+		void close_start_tag()
+		{
+			if (open)
+			{
+				writer.write('>');
+				open = false;
+			}
+		}
+
+		// line break and indentation before elements, comments and processing instructions
+		void begin_node()
+		{
+			if ((indent_flags & indent_newline) && (flags & format_raw) == 0)
+				writer.write('\n');
+
+			if ((indent_flags & indent_indent) && indent_length)
+				text_output_indent(writer, indent, indent_length, static_cast<unsigned int>(depth));
+		}
+
+		bool start_element(const char_t* name)
+		{
+			if (closed || !push_name(name)) return false;
+
+			close_start_tag();
+			begin_node();
+
+			writer.write('<');
+			writer.write_string(name);
+
+			open = true;
+			depth++;
+			indent_flags = indent_newline | indent_indent;
+
+			return true;
+		}
+
+		bool attribute(const char_t* name, const char_t* value)
+		{
+			if (!open) return false;
+
+			const char_t enquotation_char = (flags & format_attribute_single_quote) ? '\'' : '"';
+
+			if ((flags & (format_indent_attributes | format_raw)) == format_indent_attributes)
+			{
+				writer.write('\n');
+
+				text_output_indent(writer, indent, indent_length, static_cast<unsigned int>(depth));
+			}
+			else
+			{
+				writer.write(' ');
+			}
+
+			writer.write_string(name);
+			writer.write('=', enquotation_char);
+
+			text_output(writer, value, ctx_special_attr, flags);
+
+			writer.write(enquotation_char);
+
+			return true;
+		}
+
+		template <typename U> bool attribute_integer(const char_t* name, U value, bool negative)
+		{
+			char_t buf[64];
+			char_t* end = buf + sizeof(buf) / sizeof(buf[0]) - 1;
+			char_t* begin = integer_to_string(buf, end, value, negative);
+			*end = 0;
+
+			return attribute(name, begin);
+		}
+
+		bool attribute_ascii(const char_t* name, const char* buf)
+		{
+		#ifdef PUGIXML_WCHAR_MODE
+			char_t wbuf[128];
+			assert(strlen(buf) < sizeof(wbuf) / sizeof(wbuf[0]));
+
+			size_t offset = 0;
+			for (; buf[offset]; ++offset) wbuf[offset] = buf[offset];
+			wbuf[offset] = 0;
+
+			return attribute(name, wbuf);
+		#else
+			return attribute(name, buf);
+		#endif
+		}
+
+		bool attribute_double(const char_t* name, double value, int precision)
+		{
+			char buf[128];
+			PUGI__SNPRINTF(buf, "%.*g", precision, value);
+
+			return attribute_ascii(name, buf);
+		}
+
+		bool end_element()
+		{
+			if (closed || depth == 0) return false;
+
+			const char_t* name = top_name();
+
+			depth--;
+
+			if (open)
+			{
+				if (flags & format_no_empty_element_tags)
+				{
+					writer.write('>', '<', '/');
+					writer.write_string(name);
+					writer.write('>');
+				}
+				else
+				{
+					if ((flags & format_raw) == 0)
+						writer.write(' ');
+
+					writer.write('/', '>');
+				}
+
+				open = false;
+			}
+			else
+			{
+				begin_node();
+
+				writer.write('<', '/');
+				writer.write_string(name);
+				writer.write('>');
+			}
+
+			names_size = static_cast<size_t>(name - names);
+			indent_flags = indent_newline | indent_indent;
+
+			return true;
+		}
+
+		void close()
+		{
+			if (closed) return;
+
+			while (depth) end_element();
+
+			if ((indent_flags & indent_newline) && (flags & format_raw) == 0)
+				writer.write('\n');
+
+			writer.flush();
+
+			closed = true;
+		}
+	};
+PUGI__NS_END
+
+PUGI__NS_BEGIN
+	// Pull reader state; the input is read in blocks into buffer, where [begin, end) is not consumed yet. A complete tag or run of
+	// character data is decoded into token and converted there by the strconv functions of the parser. The names of the open
+	// elements are kept as a stack of zero-terminated strings for the end tags.
+	struct xml_reader_impl
+	{
+		xml_reader_impl(unsigned int options_, size_t block_size_): options(options_), block_size(block_size_ ? block_size_ : 1), file(0), own_file(false), memory(0), memory_size(0),
+		#ifndef PUGIXML_NO_STL
+			stream(0),
+		#endif
+			opened(false), eof(false), encoding(encoding_utf8), buffer(0), buffer_capacity(0), buffer_offset(0), begin(0), end(0), token(0), token_capacity(0), token_offset(0),
+			names(0), names_size(0), names_capacity(0), depth(0), event(reader_event_none), name(PUGIXML_TEXT("")), value(PUGIXML_TEXT("")), tag(0), pending_end(false), pop_pending(false),
+			seen_element(false), status(status_ok), error_offset(0)
+		{
+			strconv_attribute = get_strconv_attribute(options);
+			strconv_pcdata = get_strconv_pcdata(options);
+		}
+
+		unsigned int options;
+		size_t block_size;
+
+		FILE* file;
+		bool own_file;
+		const char* memory;
+		size_t memory_size;
+	#ifndef PUGIXML_NO_STL
+		std::basic_istream<char, std::char_traits<char> >* stream;
+	#endif
+		bool opened;
+		bool eof;
+		xml_encoding encoding;
+
+		char* buffer;
+		size_t buffer_capacity;
+		size_t buffer_offset; // input offset of buffer[0]
+		size_t begin;
+		size_t end;
+
+		char_t* token;
+		size_t token_capacity;
+		size_t token_offset; // input offset of the token
+
+		char_t* names;
+		size_t names_size;
+		size_t names_capacity;
+		size_t depth;
+
+		xml_reader_event event;
+		const char_t* name;
+		const char_t* value;
+		char_t* tag; // attributes of the current start tag not read yet
+		bool pending_end; // empty element tag, end_element follows
+		bool pop_pending; // end_element was returned, pop the name on the next call
+		bool seen_element;
+
+		xml_parse_status status;
+		size_t error_offset;
+
+		strconv_attribute_t strconv_attribute;
+		strconv_pcdata_t strconv_pcdata;
+
+		static xml_reader_impl* create(unsigned int options, size_t block_size)
+		{
+			void* memory = xml_memory::allocate(sizeof(xml_reader_impl));
+			if (!memory) return 0;
+
+			return new (memory) xml_reader_impl(options, block_size);
+		}
+
+		static void destroy(xml_reader_impl* impl)
+		{
+			impl->close();
+
+			if (impl->buffer) xml_memory::deallocate(impl->buffer);
+			if (impl->token) xml_memory::deallocate(impl->token);
+			if (impl->names) xml_memory::deallocate(impl->names);
+
+			impl->~xml_reader_impl();
+			xml_memory::deallocate(impl);
+		}
+
+		void close()
+		{
+			if (file && own_file) fclose(file);
+
+			file = 0;
+			own_file = false;
+			memory = 0;
+			memory_size = 0;
+		#ifndef PUGIXML_NO_STL
+			stream = 0;
+		#endif
+			opened = false;
+			eof = false;
+			encoding = encoding_utf8;
+			buffer_offset = begin = end = 0;
+			token_offset = 0;
+			names_size = 0;
+			depth = 0;
+			event = reader_event_none;
+			name = value = PUGIXML_TEXT("");
+			tag = 0;
+			pending_end = pop_pending = seen_element = false;
+			status = status_ok;
+			error_offset = 0;
+		}
+
+		// reads the first block and checks the encoding; only encodings in which markup is ASCII can be split into tokens as bytes
+		bool start()
+		{
+			opened = true;
+
+			// the encoding may be given in the declaration, which has to be read completely
+			while (!eof && (end < 4 || (memcmp(buffer, "<?xm", 4) == 0 && !declaration_complete())))
+				if (!fill()) return false;
+
+			encoding = get_buffer_encoding(encoding_auto, buffer, end);
+
+			if (encoding != encoding_utf8 && encoding != encoding_latin1)
+			{
+				fail(status_unrecognized_tag, 0);
+				return false;
+			}
+
+			if (end - begin >= 3 && static_cast<uint8_t>(buffer[0]) == 0xef && static_cast<uint8_t>(buffer[1]) == 0xbb && static_cast<uint8_t>(buffer[2]) == 0xbf)
+				begin = 3;
+
+			return true;
+		}
+
+		bool declaration_complete() const
+		{
+			for (size_t i = 1; i < end; ++i)
+				if (buffer[i - 1] == '?' && buffer[i] == '>') return true;
+
+			return false;
+		}
+
+		size_t read(char* data, size_t size)
+		{
+			if (file)
+			{
+				size_t result = fread(data, 1, size, file);
+				if (result < size && ferror(file)) status = status_io_error;
+
+				return result;
+			}
+
+		#ifndef PUGIXML_NO_STL
+			if (stream)
+			{
+				stream->read(data, static_cast<std::streamsize>(size));
+				if (stream->bad()) status = status_io_error;
+
+				return static_cast<size_t>(stream->gcount());
+			}
+		#endif
+
+			size_t result = size < memory_size ? size : memory_size;
+
+			memcpy(data, memory, result);
+			memory += result;
+			memory_size -= result;
+
+			return result;
+		}
+
+		// moves the unconsumed input to the front of the buffer and appends the next block, growing the buffer if it is full
+		bool fill()
+		{
+			if (eof) return true;
+
+			if (begin > 0)
+			{
+				memmove(buffer, buffer + begin, end - begin);
+				buffer_offset += begin;
+				end -= begin;
+				begin = 0;
+			}
+
+			if (end == buffer_capacity)
+			{
+				size_t capacity = buffer_capacity ? buffer_capacity * 2 : block_size;
+
+				char* storage = static_cast<char*>(xml_memory::allocate(capacity));
+				if (!storage) { fail(status_out_of_memory, buffer_offset + end); return false; }
+
+				if (buffer)
+				{
+					memcpy(storage, buffer, end);
+					xml_memory::deallocate(buffer);
+				}
+
+				buffer = storage;
+				buffer_capacity = capacity;
+			}
+
+			size_t request = buffer_capacity - end;
+			size_t size = read(buffer + end, request);
+
+			if (status != status_ok) { fail(status, buffer_offset + end); return false; }
+
+			end += size;
+			eof = (size < request);
+
+			return true;
+		}
+
+		bool reserve_token(size_t length)
+		{
+			if (length + 1 <= token_capacity) return true;
+
+			size_t capacity = token_capacity ? token_capacity * 2 : 256;
+			if (capacity < length + 1) capacity = length + 1;
+
+			char_t* storage = static_cast<char_t*>(xml_memory::allocate(capacity * sizeof(char_t)));
+			if (!storage) return false;
+
+			if (token) xml_memory::deallocate(token);
+
+			token = storage;
+			token_capacity = capacity;
+
+			return true;
+		}
+
+		template <typename D> bool decode_token(const uint8_t* data, size_t size)
+		{
+		#ifdef PUGIXML_WCHAR_MODE
+			size_t length = D::process(data, size, 0, wchar_counter());
+			if (!reserve_token(length)) return false;
+
+			D::process(data, size, reinterpret_cast<wchar_writer::value_type>(token), wchar_writer());
+		#else
+			size_t length = D::process(data, size, 0, utf8_counter());
+			if (!reserve_token(length)) return false;
+
+			D::process(data, size, reinterpret_cast<uint8_t*>(token), utf8_writer());
+		#endif
+
+			token[length] = 0;
+
+			return true;
+		}
+
+		// decodes size bytes at the front of the unconsumed input into token and consumes them
+		bool load_token(size_t offset, size_t size)
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer + begin + offset);
+
+			token_offset = buffer_offset + begin;
+
+			bool result;
+
+			if (encoding == encoding_latin1)
+				result = decode_token<latin1_decoder>(data, size);
+			else
+			{
+			#ifdef PUGIXML_WCHAR_MODE
+				result = decode_token<utf8_decoder>(data, size);
+			#else
+				result = reserve_token(size);
+
+				if (result)
+				{
+					memcpy(token, data, size);
+					token[size] = 0;
+				}
+			#endif
+			}
+
+			if (!result) { fail(status_out_of_memory, token_offset); return false; }
+
+			return true;
+		}
+
+		xml_reader_event fail(xml_parse_status error, size_t offset)
+		{
+			status = error;
+			error_offset = offset;
+			name = value = PUGIXML_TEXT("");
+			tag = 0;
+
+			return event = reader_event_error;
+		}
+
+		// error inside the token; the offset is exact for UTF-8 input in char mode and the offset of the token otherwise
+		xml_reader_event fail_at(xml_parse_status error, const char_t* s)
+		{
+		#ifdef PUGIXML_WCHAR_MODE
+			(void)s;
+			return fail(error, token_offset);
+		#else
+			return fail(error, token_offset + (encoding == encoding_utf8 ? static_cast<size_t>(s - token) : 0));
+		#endif
+		}
+
+		xml_reader_event emit(xml_reader_event type, const char_t* name_, const char_t* value_)
+		{
+			name = name_;
+			value = value_;
+
+			return event = type;
+		}
+
+		bool push_name(const char_t* element)
+		{
+			size_t length = strlength(element) + 1;
+
+			if (names_size + length > names_capacity)
+			{
+				size_t capacity = names_capacity ? names_capacity * 2 : 64;
+				if (capacity < names_size + length) capacity = names_size + length;
+
+				char_t* storage = static_cast<char_t*>(xml_memory::allocate(capacity * sizeof(char_t)));
+				if (!storage) return false;
+
+				if (names)
+				{
+					memcpy(storage, names, names_size * sizeof(char_t));
+					xml_memory::deallocate(names);
+				}
+
+				names = storage;
+				names_capacity = capacity;
+			}
+
+			memcpy(names + names_size, element, length * sizeof(char_t));
+			names_size += length;
+			++depth;
+
+			return true;
+		}
+
+		const char_t* top_name() const
+		{
+			assert(names_size > 0 && names[names_size - 1] == 0);
+
+			size_t start = names_size - 1;
+			while (start > 0 && names[start - 1] != 0) --start;
+
+			return names + start;
+		}
+
+		void pop_name()
+		{
+			names_size = static_cast<size_t>(top_name() - names);
+			--depth;
+		}
+
+		// length of the markup at s (s[0] == '<') if it is complete in [s, e), 0 if more input is needed and size_t(-1) if it
+		// can't be a tag; kind is the error status if the input ends before the markup does
+		static size_t markup_length(const char* s, const char* e, xml_parse_status& kind)
+		{
+			size_t size = static_cast<size_t>(e - s);
+			const char* p;
+
+			kind = status_unrecognized_tag;
+
+			if (size < 2) return 0;
+
+			if (s[1] == '?')
+			{
+				kind = status_bad_pi;
+
+				for (p = s + 2; p + 1 < e; ++p)
+					if (p[0] == '?' && p[1] == '>') return static_cast<size_t>(p + 2 - s);
+
+				return 0;
+			}
+
+			if (s[1] == '!')
+			{
+				if (size < 3) return 0;
+
+				if (s[2] == '-')
+				{
+					kind = status_bad_comment;
+					if (size < 4) return 0;
+					if (s[3] != '-') return static_cast<size_t>(-1);
+
+					for (p = s + 4; p + 2 < e; ++p)
+						if (p[0] == '-' && p[1] == '-' && p[2] == '>') return static_cast<size_t>(p + 3 - s);
+
+					return 0;
+				}
+
+				if (s[2] == '[')
+				{
+					kind = status_bad_cdata;
+					if (size < 9) return 0;
+					if (memcmp(s + 3, "CDATA[", 6) != 0) return static_cast<size_t>(-1);
+
+					for (p = s + 9; p + 2 < e; ++p)
+						if (p[0] == ']' && p[1] == ']' && p[2] == '>') return static_cast<size_t>(p + 3 - s);
+
+					return 0;
+				}
+
+				if (s[2] == 'D')
+				{
+					// the internal subset may contain '>' in brackets and quotes
+					kind = status_bad_doctype;
+
+					int brackets = 0;
+					char quote = 0;
+
+					for (p = s + 3; p < e; ++p)
+					{
+						if (quote) { if (*p == quote) quote = 0; }
+						else if (*p == '"' || *p == '\'') quote = *p;
+						else if (*p == '[') ++brackets;
+						else if (*p == ']') --brackets;
+						else if (*p == '>' && brackets <= 0) return static_cast<size_t>(p + 1 - s);
+					}
+
+					return 0;
+				}
+
+				return static_cast<size_t>(-1);
+			}
+
+			// start or end tag; attribute values may contain '>'
+			kind = (s[1] == '/') ? status_bad_end_element : status_bad_start_element;
+
+			char quote = 0;
+
+			for (p = s + 1; p < e; ++p)
+			{
+				if (quote) { if (*p == quote) quote = 0; }
+				else if (*p == '"' || *p == '\'') quote = *p;
+				else if (*p == '>') return static_cast<size_t>(p + 1 - s);
+			}
+
+			return 0;
+		}
+
+		xml_reader_event next()
+		{
+			if (!opened || event == reader_event_error || event == reader_event_end_document) return event;
+
+			if (tag) return next_attribute();
+
+			if (pending_end)
+			{
+				pending_end = false;
+				pop_pending = true;
+
+				return emit(reader_event_end_element, top_name(), PUGIXML_TEXT(""));
+			}
+
+			if (pop_pending)
+			{
+				pop_name();
+				pop_pending = false;
+			}
+
+			while (true)
+			{
+				if (begin == end)
+				{
+					if (!fill()) return event;
+
+					if (begin == end)
+					{
+						if (depth > 0) return fail(status_end_element_mismatch, buffer_offset + end);
+						if (!seen_element) return fail(status_no_document_element, buffer_offset + end);
+
+						return emit(reader_event_end_document, PUGIXML_TEXT(""), PUGIXML_TEXT(""));
+					}
+				}
+
+				if (buffer[begin] == '<')
+				{
+					xml_parse_status kind;
+					size_t length;
+
+					while ((length = markup_length(buffer + begin, buffer + end, kind)) == 0)
+					{
+						if (eof) return fail(kind, buffer_offset + end);
+						if (!fill()) return event;
+					}
+
+					if (length == static_cast<size_t>(-1)) return fail(kind, buffer_offset + begin);
+
+					const char* s = buffer + begin;
+
+					if (s[1] == '?' || (s[1] == '!' && s[2] != '['))
+					{
+						// declaration, processing instruction, comment or document type
+						begin += length;
+					}
+					else if (s[1] == '!')
+					{
+						if (depth == 0 || !(options & parse_cdata))
+						{
+							begin += length;
+							continue;
+						}
+
+						if (!load_token(9, length - 12)) return event;
+						begin += length;
+
+						if (options & parse_eol) convert_eol(token);
+
+						return emit(reader_event_text, PUGIXML_TEXT(""), token);
+					}
+					else if (s[1] == '/')
+					{
+						if (!load_token(0, length)) return event;
+						begin += length;
+
+						return end_tag();
+					}
+					else
+					{
+						if (!load_token(0, length)) return event;
+						begin += length;
+
+						return start_tag();
+					}
+				}
+				else
+				{
+					size_t scanned = 0;
+					const void* lt;
+
+					while ((lt = memchr(buffer + begin + scanned, '<', end - begin - scanned)) == 0 && !eof)
+					{
+						scanned = end - begin;
+						if (!fill()) return event;
+					}
+
+					size_t length = lt ? static_cast<size_t>(static_cast<const char*>(lt) - (buffer + begin)) : end - begin;
+
+					// character data outside of the document element is skipped, as is whitespace unless requested
+					bool skip = (depth == 0);
+
+					if (!skip && (!(options & parse_ws_pcdata) || (options & parse_trim_pcdata)))
+					{
+						skip = true;
+
+						for (size_t i = 0; i < length && skip; ++i)
+							skip = PUGI__IS_CHARTYPE(static_cast<unsigned char>(buffer[begin + i]), ct_space);
+					}
+
+					if (skip)
+					{
+						begin += length;
+						continue;
+					}
+
+					if (!load_token(0, length)) return event;
+					begin += length;
+
+					strconv_pcdata(token);
+
+					return emit(reader_event_text, PUGIXML_TEXT(""), token);
+				}
+			}
+		}
+
+		static void convert_eol(char_t* s)
+		{
+			char_t* out = s;
+
+			for (; *s; ++s)
+			{
+				if (*s == '\r')
+				{
+					*out++ = '\n';
+					if (s[1] == '\n') ++s;
+				}
+				else *out++ = *s;
+			}
+
+			*out = 0;
+		}
+
+		xml_reader_event start_tag()
+		{
+			char_t* s = token + 1;
+
+			if (!PUGI__IS_CHARTYPE(*s, ct_start_symbol)) return fail_at(status_unrecognized_tag, s);
+
+			char_t* element = s;
+
+			PUGI__SCANWHILE_UNROLL(PUGI__IS_CHARTYPE(ss, ct_symbol));
+
+			char_t ch = *s;
+			*s++ = 0;
+
+			if (ch == '/')
+			{
+				if (*s != '>') return fail_at(status_bad_start_element, s);
+
+				pending_end = true;
+			}
+			else if (PUGI__IS_CHARTYPE(ch, ct_space))
+			{
+				tag = s;
+			}
+			else if (ch != '>') return fail_at(status_bad_start_element, s - 1);
+
+			if (!push_name(element)) return fail_at(status_out_of_memory, element);
+
+			seen_element = true;
+
+			return emit(reader_event_start_element, top_name(), PUGIXML_TEXT(""));
+		}
+
+		xml_reader_event next_attribute()
+		{
+			char_t* s = tag;
+
+			PUGI__SKIPWS();
+
+			if (PUGI__IS_CHARTYPE(*s, ct_start_symbol))
+			{
+				char_t* attribute = s;
+
+				PUGI__SCANWHILE_UNROLL(PUGI__IS_CHARTYPE(ss, ct_symbol));
+
+				char_t ch = *s;
+				*s++ = 0;
+
+				if (PUGI__IS_CHARTYPE(ch, ct_space))
+				{
+					PUGI__SKIPWS();
+
+					ch = *s;
+					++s;
+				}
+
+				if (ch != '=') return fail_at(status_bad_attribute, s);
+
+				PUGI__SKIPWS();
+
+				if (*s != '"' && *s != '\'') return fail_at(status_bad_attribute, s);
+
+				ch = *s++;
+				char_t* attribute_value = s;
+
+				s = strconv_attribute(s, ch);
+
+				if (!s) return fail_at(status_bad_attribute, attribute_value);
+				if (PUGI__IS_CHARTYPE(*s, ct_start_symbol)) return fail_at(status_bad_attribute, s);
+
+				tag = s;
+
+				return emit(reader_event_attribute, attribute, attribute_value);
+			}
+
+			tag = 0;
+
+			if (*s == '/')
+			{
+				if (s[1] != '>') return fail_at(status_bad_start_element, s + 1);
+
+				pop_pending = true;
+
+				return emit(reader_event_end_element, top_name(), PUGIXML_TEXT(""));
+			}
+
+			if (*s != '>') return fail_at(status_bad_start_element, s);
+
+			return next();
+		}
+
+		xml_reader_event end_tag()
+		{
+			char_t* s = token + 2;
+
+			if (depth == 0) return fail_at(status_end_element_mismatch, s);
+
+			const char_t* element = top_name();
+
+			while (PUGI__IS_CHARTYPE(*s, ct_symbol))
+			{
+				if (*s++ != *element++) return fail_at(status_end_element_mismatch, token + 2);
+			}
+
+			if (*element) return fail_at(status_end_element_mismatch, token + 2);
+
+			PUGI__SKIPWS();
+
+			if (*s != '>') return fail_at(status_bad_end_element, s);
+
+			pop_pending = true;
+
+			return emit(reader_event_end_element, top_name(), PUGIXML_TEXT(""));
+		}
+
+		bool skip_element()
+		{
+			if (event != reader_event_start_element && event != reader_event_attribute) return false;
+
+			size_t target = depth;
+
+			while (true)
+			{
+				xml_reader_event type = next();
+
+				if (type == reader_event_end_element && depth == target) return true;
+				if (type == reader_event_error || type == reader_event_end_document) return false;
+			}
+		}
+	};
+PUGI__NS_END
+
+namespace pugi
+{
+	PUGI__FN xml_writer_file::xml_writer_file(void* file_): file(file_)
+	{
+	}
+
+	PUGI__FN void xml_writer_file::write(const void* data, size_t size)
+	{
+		size_t result = fwrite(data, 1, size, static_cast<FILE*>(file));
+		(void)!result; // unfortunately we can't do proper error handling here
+	}
+
+#ifndef PUGIXML_NO_STL
+	PUGI__FN xml_writer_stream::xml_writer_stream(std::basic_ostream<char, std::char_traits<char> >& stream): narrow_stream(&stream), wide_stream(0)
+	{
+	}
+
+	PUGI__FN xml_writer_stream::xml_writer_stream(std::basic_ostream<wchar_t, std::char_traits<wchar_t> >& stream): narrow_stream(0), wide_stream(&stream)
+	{
+	}
+
+	PUGI__FN void xml_writer_stream::write(const void* data, size_t size)
+	{
+		if (narrow_stream)
+		{
+			assert(!wide_stream);
+			narrow_stream->write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+		}
+		else
+		{
+			assert(wide_stream);
+			assert(size % sizeof(wchar_t) == 0);
+
+			wide_stream->write(reinterpret_cast<const wchar_t*>(data), static_cast<std::streamsize>(size / sizeof(wchar_t)));
+		}
+	}
+#endif
+
+	PUGI__FN xml_serializer::xml_serializer(xml_writer& writer, const char_t* indent, unsigned int flags, xml_encoding encoding): _impl(0)
+	{
+		impl::xml_serializer_impl* ser = impl::xml_serializer_impl::create(writer, indent, flags, encoding);
+
+	#ifndef PUGIXML_NO_EXCEPTIONS
+		if (!ser) throw std::bad_alloc();
+	#else
+		if (!ser) return;
+	#endif
+
+		impl::document_output_prolog(ser->writer, flags, encoding, true);
+
+		_impl = ser;
+	}
+
+	PUGI__FN xml_serializer::~xml_serializer()
+	{
+		if (_impl)
+		{
+			impl::xml_serializer_impl* ser = static_cast<impl::xml_serializer_impl*>(_impl);
+
+			ser->close();
+
+			impl::xml_serializer_impl::destroy(ser);
+		}
+	}
+
+	PUGI__FN bool xml_serializer::start_element(const char_t* name)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->start_element(name);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, const char_t* value)
+	{
+		return _impl && name && value && static_cast<impl::xml_serializer_impl*>(_impl)->attribute(name, value);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, int value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_integer<unsigned int>(name, value, value < 0);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, unsigned int value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_integer<unsigned int>(name, value, false);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, long value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_integer<unsigned long>(name, value, value < 0);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, unsigned long value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_integer<unsigned long>(name, value, false);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, double value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_double(name, value, default_double_precision);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, double value, int precision)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_double(name, value, precision);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, float value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_double(name, double(value), default_float_precision);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, float value, int precision)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_double(name, double(value), precision);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, bool value)
+	{
+		return attribute(name, value ? PUGIXML_TEXT("true") : PUGIXML_TEXT("false"));
+	}
+
+#ifdef PUGIXML_HAS_LONG_LONG
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, long long value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_integer<unsigned long long>(name, value, value < 0);
+	}
+
+	PUGI__FN bool xml_serializer::attribute(const char_t* name, unsigned long long value)
+	{
+		return _impl && name && static_cast<impl::xml_serializer_impl*>(_impl)->attribute_integer<unsigned long long>(name, value, false);
+	}
+#endif
+
+	PUGI__FN bool xml_serializer::text(const char_t* value)
+	{
+		impl::xml_serializer_impl* ser = static_cast<impl::xml_serializer_impl*>(_impl);
+		if (!ser || ser->closed || !value) return false;
+
+		ser->close_start_tag();
+
+		impl::text_output(ser->writer, value, impl::ctx_special_pcdata, ser->flags);
+
+		ser->indent_flags = 0;
+
+		return true;
+	}
+
+	PUGI__FN bool xml_serializer::cdata(const char_t* value)
+	{
+		impl::xml_serializer_impl* ser = static_cast<impl::xml_serializer_impl*>(_impl);
+		if (!ser || ser->closed || !value) return false;
+
+		ser->close_start_tag();
+
+		impl::text_output_cdata(ser->writer, value);
+
+		ser->indent_flags = 0;
+
+		return true;
+	}
+
+	PUGI__FN bool xml_serializer::comment(const char_t* value)
+	{
+		impl::xml_serializer_impl* ser = static_cast<impl::xml_serializer_impl*>(_impl);
+		if (!ser || ser->closed || !value) return false;
+
+		ser->close_start_tag();
+		ser->begin_node();
+
+		impl::node_output_comment(ser->writer, value);
+
+		ser->indent_flags = impl::indent_newline | impl::indent_indent;
 
-		return status_ok;
+		return true;
 	}
 
-	template <typename T> PUGI__FN xml_parse_result load_stream_impl(xml_document_struct* doc, std::basic_istream<T>& stream, unsigned int options, xml_encoding encoding, char_t** out_buffer)
+	PUGI__FN bool xml_serializer::pi(const char_t* name, const char_t* value)
 	{
-		void* buffer = 0;
-		size_t size = 0;
-		xml_parse_status status = status_ok;
+		impl::xml_serializer_impl* ser = static_cast<impl::xml_serializer_impl*>(_impl);
+		if (!ser || ser->closed || !name) return false;
 
-		// if stream has an error bit set, bail out (otherwise tellg() can fail and we'll clear error bits)
-		if (stream.fail()) return make_parse_result(status_io_error);
+		ser->close_start_tag();
+		ser->begin_node();
 
-		// load stream to memory (using seek-based implementation if possible, since it's faster and takes less memory)
-		if (stream.tellg() < 0)
+		ser->writer.write('<', '?');
+		ser->writer.write_string(name);
+
+		if (value && *value)
 		{
-			stream.clear(); // clear error flags that could be set by a failing tellg
-			status = load_stream_data_noseek(stream, &buffer, &size);
+			ser->writer.write(' ');
+			impl::node_output_pi_value(ser->writer, value);
 		}
-		else
-			status = load_stream_data_seek(stream, &buffer, &size);
 
-		if (status != status_ok) return make_parse_result(status);
+		ser->writer.write('?', '>');
 
-		xml_encoding real_encoding = get_buffer_encoding(encoding, buffer, size);
+		ser->indent_flags = impl::indent_newline | impl::indent_indent;
 
-		return load_buffer_impl(doc, doc, buffer, zero_terminate_buffer(buffer, size, real_encoding), options, real_encoding, true, true, out_buffer);
+		return true;
 	}
-#endif
 
-#if defined(PUGI__MSVC_CRT_VERSION) || defined(__BORLANDC__) || (defined(__MINGW32__) && (!defined(__STRICT_ANSI__) || defined(__MINGW64_VERSION_MAJOR)))
-	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
+	PUGI__FN bool xml_serializer::end_element()
 	{
-#if defined(PUGI__MSVC_CRT_VERSION) && PUGI__MSVC_CRT_VERSION >= 1400
-		FILE* file = 0;
-		return _wfopen_s(&file, path, mode) == 0 ? file : 0;
-#else
-		return _wfopen(path, mode);
-#endif
+		return _impl && static_cast<impl::xml_serializer_impl*>(_impl)->end_element();
 	}
-#else
-	PUGI__FN char* convert_path_heap(const wchar_t* str)
+
+	PUGI__FN size_t xml_serializer::depth() const
 	{
-		assert(str);
+		return _impl ? static_cast<impl::xml_serializer_impl*>(_impl)->depth : 0;
+	}
 
-		// first pass: get length in utf8 characters
-		size_t length = strlength_wide(str);
-		size_t size = as_utf8_begin(str, length);
+	PUGI__FN void xml_serializer::flush()
+	{
+		if (_impl && !static_cast<impl::xml_serializer_impl*>(_impl)->closed)
+			static_cast<impl::xml_serializer_impl*>(_impl)->writer.flush();
+	}
 
-		// allocate resulting string
-		char* result = static_cast<char*>(xml_memory::allocate(size + 1));
-		if (!result) return 0;
+	PUGI__FN void xml_serializer::close()
+	{
+		if (_impl) static_cast<impl::xml_serializer_impl*>(_impl)->close();
+	}
 
-		// second pass: convert to utf8
-		as_utf8_end(result, size, str, length);
+	PUGI__FN xml_reader::xml_reader(unsigned int options, size_t buffer_size): _impl(0)
+	{
+		impl::xml_reader_impl* reader = impl::xml_reader_impl::create(options, buffer_size);
 
-		// zero-terminate
-		result[size] = 0;
+	#ifndef PUGIXML_NO_EXCEPTIONS
+		if (!reader) throw std::bad_alloc();
+	#endif
 
-		return result;
+		_impl = reader;
 	}
 
-	PUGI__FN FILE* open_file_wide(const wchar_t* path, const wchar_t* mode)
+	PUGI__FN xml_reader::~xml_reader()
 	{
-		// there is no standard function to open wide paths, so our best bet is to try utf8 path
-		char* path_utf8 = convert_path_heap(path);
-		if (!path_utf8) return 0;
+		if (_impl) impl::xml_reader_impl::destroy(static_cast<impl::xml_reader_impl*>(_impl));
+	}
 
-		// convert mode to ASCII (we mirror _wfopen interface)
-		char mode_ascii[4] = {0};
-		for (size_t i = 0; mode[i]; ++i) mode_ascii[i] = static_cast<char>(mode[i]);
+	PUGI__FN bool xml_reader::open_file(const char* path_)
+	{
+		if (!_impl) return false;
 
-		// try to open the utf8 path
-		FILE* result = fopen(path_utf8, mode_ascii);
+		impl::xml_reader_impl* reader = static_cast<impl::xml_reader_impl*>(_impl);
+		reader->close();
 
-		// free dummy buffer
-		xml_memory::deallocate(path_utf8);
+		FILE* file = impl::open_file(path_, "rb");
+		if (!file)
+		{
+			reader->fail(status_file_not_found, 0);
+			return false;
+		}
 
-		return result;
+		reader->file = file;
+		reader->own_file = true;
+
+		return reader->start();
 	}
-#endif
 
-	PUGI__FN FILE* open_file(const char* path, const char* mode)
+	PUGI__FN bool xml_reader::open_file(const wchar_t* path_)
 	{
-#if defined(PUGI__MSVC_CRT_VERSION) && PUGI__MSVC_CRT_VERSION >= 1400
-		FILE* file = 0;
-		return fopen_s(&file, path, mode) == 0 ? file : 0;
-#else
-		return fopen(path, mode);
-#endif
+		if (!_impl) return false;
+
+		impl::xml_reader_impl* reader = static_cast<impl::xml_reader_impl*>(_impl);
+		reader->close();
+
+		FILE* file = impl::open_file_wide(path_, L"rb");
+		if (!file)
+		{
+			reader->fail(status_file_not_found, 0);
+			return false;
+		}
+
+		reader->file = file;
+		reader->own_file = true;
+
+		return reader->start();
 	}
 
-	PUGI__FN bool save_file_impl(const xml_document& doc, FILE* file, const char_t* indent, unsigned int flags, xml_encoding encoding)
+	PUGI__FN bool xml_reader::open_buffer(const void* contents, size_t size)
 	{
-		if (!file) return false;
+		if (!_impl) return false;
 
-		xml_writer_file writer(file);
-		doc.save(writer, indent, flags, encoding);
+		impl::xml_reader_impl* reader = static_cast<impl::xml_reader_impl*>(_impl);
+		reader->close();
 
-		return ferror(file) == 0;
+		reader->memory = static_cast<const char*>(contents);
+		reader->memory_size = contents ? size : 0;
+
+		return reader->start();
 	}
 
-	struct name_null_sentry
+#ifndef PUGIXML_NO_STL
+	PUGI__FN bool xml_reader::open(std::basic_istream<char, std::char_traits<char> >& stream)
 	{
-		xml_node_struct* node;
-		char_t* name;
+		if (!_impl) return false;
 
-		name_null_sentry(xml_node_struct* node_): node(node_), name(node_->name)
-		{
-			node->name = 0;
-		}
+		impl::xml_reader_impl* reader = static_cast<impl::xml_reader_impl*>(_impl);
+		reader->close();
 
-		~name_null_sentry()
-		{
-			node->name = name;
-		}
-	};
-PUGI__NS_END
+		reader->stream = &stream;
 
-namespace pugi
-{
-	PUGI__FN xml_writer_file::xml_writer_file(void* file_): file(file_)
+		return reader->start();
+	}
+#endif
+
+	PUGI__FN xml_reader_event xml_reader::next()
 	{
+		return _impl ? static_cast<impl::xml_reader_impl*>(_impl)->next() : reader_event_none;
 	}
 
-	PUGI__FN void xml_writer_file::write(const void* data, size_t size)
+	PUGI__FN bool xml_reader::skip_element()
 	{
-		size_t result = fwrite(data, 1, size, static_cast<FILE*>(file));
-		(void)!result; // unfortunately we can't do proper error handling here
+		return _impl && static_cast<impl::xml_reader_impl*>(_impl)->skip_element();
 	}
 
-#ifndef PUGIXML_NO_STL
-	PUGI__FN xml_writer_stream::xml_writer_stream(std::basic_ostream<char, std::char_traits<char> >& stream): narrow_stream(&stream), wide_stream(0)
+	PUGI__FN xml_reader_event xml_reader::event() const
 	{
+		return _impl ? static_cast<impl::xml_reader_impl*>(_impl)->event : reader_event_none;
 	}
 
-	PUGI__FN xml_writer_stream::xml_writer_stream(std::basic_ostream<wchar_t, std::char_traits<wchar_t> >& stream): narrow_stream(0), wide_stream(&stream)
+	PUGI__FN const char_t* xml_reader::name() const
 	{
+		return _impl ? static_cast<impl::xml_reader_impl*>(_impl)->name : PUGIXML_TEXT("");
 	}
 
-	PUGI__FN void xml_writer_stream::write(const void* data, size_t size)
+	PUGI__FN const char_t* xml_reader::value() const
 	{
-		if (narrow_stream)
+		return _impl ? static_cast<impl::xml_reader_impl*>(_impl)->value : PUGIXML_TEXT("");
+	}
+
+	PUGI__FN size_t xml_reader::depth() const
+	{
+		return _impl ? static_cast<impl::xml_reader_impl*>(_impl)->depth : 0;
+	}
+
+	PUGI__FN xml_parse_result xml_reader::result() const
+	{
+		xml_parse_result result;
+
+		if (!_impl)
 		{
-			assert(!wide_stream);
-			narrow_stream->write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+			result.status = status_out_of_memory;
+			return result;
 		}
-		else
-		{
-			assert(wide_stream);
-			assert(size % sizeof(wchar_t) == 0);
 
-			wide_stream->write(reinterpret_cast<const wchar_t*>(data), static_cast<std::streamsize>(size / sizeof(wchar_t)));
-		}
+		impl::xml_reader_impl* reader = static_cast<impl::xml_reader_impl*>(_impl);
+
+		result.status = reader->status;
+		result.offset = static_cast<ptrdiff_t>(reader->error_offset);
+		result.encoding = reader->encoding;
+
+		return result;
+	}
+
+	PUGI__FN void xml_reader::close()
+	{
+		if (_impl) static_cast<impl::xml_reader_impl*>(_impl)->close();
 	}
-#endif
 
 	PUGI__FN xml_tree_walker::xml_tree_walker(): _depth(0)
 	{
@@ -5324,6 +7934,8 @@ namespace pugi
 
 	PUGI__FN bool xml_attribute::set_name(const char_t* rhs)
 	{
+		impl::index_invalidate(_attr);
+
 		if (!_attr) return false;
 
 		return impl::strcpy_insitu(_attr->name, _attr->header, impl::xml_memory_page_name_allocated_mask, rhs, impl::strlength(rhs));
@@ -5538,6 +8150,12 @@ namespace pugi
 	{
 		if (!_root) return xml_node();
 
+		if (impl::xml_lookup_index* index = impl::get_document(_root).index)
+		{
+			xml_node_struct* result;
+			if (impl::index_find(index, _root, name_, result)) return xml_node(result);
+		}
+
 		for (xml_node_struct* i = _root->first_child; i; i = i->next_sibling)
 			if (i->name && impl::strequal(name_, i->name)) return xml_node(i);
 
@@ -5548,6 +8166,12 @@ namespace pugi
 	{
 		if (!_root) return xml_attribute();
 
+		if (impl::xml_lookup_index* index = impl::get_document(_root).index)
+		{
+			xml_attribute_struct* result;
+			if (impl::index_find(index, _root, name_, result)) return xml_attribute(result);
+		}
+
 		for (xml_attribute_struct* i = _root->first_attribute; i; i = i->next_attribute)
 			if (i->name && impl::strequal(name_, i->name))
 				return xml_attribute(i);
@@ -5678,6 +8302,8 @@ namespace pugi
 
 	PUGI__FN bool xml_node::set_name(const char_t* rhs)
 	{
+		impl::index_invalidate(_root);
+
 		xml_node_type type_ = _root ? PUGI__NODETYPE(_root) : node_null;
 
 		if (type_ != node_element && type_ != node_pi && type_ != node_declaration)
@@ -5698,6 +8324,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::append_attribute(const char_t* name_)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -5715,6 +8343,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::prepend_attribute(const char_t* name_)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -5732,6 +8362,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::insert_attribute_after(const char_t* name_, const xml_attribute& attr)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 		if (!attr || !impl::is_attribute_of(attr._attr, _root)) return xml_attribute();
 
@@ -5750,6 +8382,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::insert_attribute_before(const char_t* name_, const xml_attribute& attr)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 		if (!attr || !impl::is_attribute_of(attr._attr, _root)) return xml_attribute();
 
@@ -5768,6 +8402,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::append_copy(const xml_attribute& proto)
 	{
+		impl::index_invalidate(_root);
+
 		if (!proto) return xml_attribute();
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 
@@ -5785,6 +8421,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::prepend_copy(const xml_attribute& proto)
 	{
+		impl::index_invalidate(_root);
+
 		if (!proto) return xml_attribute();
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 
@@ -5802,6 +8440,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::insert_copy_after(const xml_attribute& proto, const xml_attribute& attr)
 	{
+		impl::index_invalidate(_root);
+
 		if (!proto) return xml_attribute();
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 		if (!attr || !impl::is_attribute_of(attr._attr, _root)) return xml_attribute();
@@ -5820,6 +8460,8 @@ namespace pugi
 
 	PUGI__FN xml_attribute xml_node::insert_copy_before(const xml_attribute& proto, const xml_attribute& attr)
 	{
+		impl::index_invalidate(_root);
+
 		if (!proto) return xml_attribute();
 		if (!impl::allow_insert_attribute(type())) return xml_attribute();
 		if (!attr || !impl::is_attribute_of(attr._attr, _root)) return xml_attribute();
@@ -5838,6 +8480,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::append_child(xml_node_type type_)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -5855,6 +8499,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::prepend_child(xml_node_type type_)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -5872,6 +8518,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::insert_child_before(xml_node_type type_, const xml_node& node)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 		if (!node._root || node._root->parent != _root) return xml_node();
 
@@ -5890,6 +8538,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::insert_child_after(xml_node_type type_, const xml_node& node)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 		if (!node._root || node._root->parent != _root) return xml_node();
 
@@ -5944,6 +8594,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::append_copy(const xml_node& proto)
 	{
+		impl::index_invalidate(_root);
+
 		xml_node_type type_ = proto.type();
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 
@@ -5961,6 +8613,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::prepend_copy(const xml_node& proto)
 	{
+		impl::index_invalidate(_root);
+
 		xml_node_type type_ = proto.type();
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 
@@ -5978,6 +8632,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::insert_copy_after(const xml_node& proto, const xml_node& node)
 	{
+		impl::index_invalidate(_root);
+
 		xml_node_type type_ = proto.type();
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 		if (!node._root || node._root->parent != _root) return xml_node();
@@ -5996,6 +8652,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::insert_copy_before(const xml_node& proto, const xml_node& node)
 	{
+		impl::index_invalidate(_root);
+
 		xml_node_type type_ = proto.type();
 		if (!impl::allow_insert_child(type(), type_)) return xml_node();
 		if (!node._root || node._root->parent != _root) return xml_node();
@@ -6014,6 +8672,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::append_move(const xml_node& moved)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_move(*this, moved)) return xml_node();
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -6030,6 +8690,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::prepend_move(const xml_node& moved)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_move(*this, moved)) return xml_node();
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -6046,6 +8708,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::insert_move_after(const xml_node& moved, const xml_node& node)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_move(*this, moved)) return xml_node();
 		if (!node._root || node._root->parent != _root) return xml_node();
 		if (moved._root == node._root) return xml_node();
@@ -6064,6 +8728,8 @@ namespace pugi
 
 	PUGI__FN xml_node xml_node::insert_move_before(const xml_node& moved, const xml_node& node)
 	{
+		impl::index_invalidate(_root);
+
 		if (!impl::allow_move(*this, moved)) return xml_node();
 		if (!node._root || node._root->parent != _root) return xml_node();
 		if (moved._root == node._root) return xml_node();
@@ -6087,6 +8753,8 @@ namespace pugi
 
 	PUGI__FN bool xml_node::remove_attribute(const xml_attribute& a)
 	{
+		impl::index_invalidate(_root);
+
 		if (!_root || !a._attr) return false;
 		if (!impl::is_attribute_of(a._attr, _root)) return false;
 
@@ -6101,6 +8769,8 @@ namespace pugi
 
 	PUGI__FN bool xml_node::remove_attributes()
 	{
+		impl::index_invalidate(_root);
+
 		if (!_root) return false;
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -6127,6 +8797,8 @@ namespace pugi
 
 	PUGI__FN bool xml_node::remove_child(const xml_node& n)
 	{
+		impl::index_invalidate(_root);
+
 		if (!_root || !n._root || n._root->parent != _root) return false;
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -6140,6 +8812,8 @@ namespace pugi
 
 	PUGI__FN bool xml_node::remove_children()
 	{
+		impl::index_invalidate(_root);
+
 		if (!_root) return false;
 
 		impl::xml_allocator& alloc = impl::get_allocator(_root);
@@ -6161,6 +8835,8 @@ namespace pugi
 
 	PUGI__FN xml_parse_result xml_node::append_buffer(const void* contents, size_t size, unsigned int options, xml_encoding encoding)
 	{
+		impl::index_invalidate(_root);
+
 		// append_buffer is only valid for elements/documents
 		if (!impl::allow_insert_child(type(), node_element)) return impl::make_parse_result(status_append_invalid_root);
 
@@ -6221,6 +8897,23 @@ namespace pugi
 		return xml_node();
 	}
 
+	PUGI__FN size_t xml_node::attribute_values(const char_t* name_, const char_t* attr_name, double* result, size_t capacity, double def) const
+	{
+		return _root ? impl::children_attribute_values<impl::attribute_value_double>(_root, name_, attr_name, result, capacity, def) : 0;
+	}
+
+	PUGI__FN size_t xml_node::attribute_values(const char_t* name_, const char_t* attr_name, int* result, size_t capacity, int def) const
+	{
+		return _root ? impl::children_attribute_values<impl::attribute_value_int>(_root, name_, attr_name, result, capacity, def) : 0;
+	}
+
+#ifdef PUGIXML_HAS_LONG_LONG
+	PUGI__FN size_t xml_node::attribute_values(const char_t* name_, const char_t* attr_name, long long* result, size_t capacity, long long def) const
+	{
+		return _root ? impl::children_attribute_values<impl::attribute_value_llong>(_root, name_, attr_name, result, capacity, def) : 0;
+	}
+#endif
+
 #ifndef PUGIXML_NO_STL
 	PUGI__FN string_t xml_node::path(char_t delimiter) const
 	{
@@ -6967,8 +9660,65 @@ namespace pugi
 
 	PUGI__FN void xml_document::reset()
 	{
+		// lookup index settings survive the reset, the tables don't
+		impl::xml_lookup_index* index = static_cast<impl::xml_document_struct*>(_root)->index;
+		static_cast<impl::xml_document_struct*>(_root)->index = 0;
+
+		// so does the page pool
+		impl::xml_page_pool_impl* pool = static_cast<impl::xml_document_struct*>(_root)->_pool;
+
 		_destroy();
 		_create();
+
+		static_cast<impl::xml_document_struct*>(_root)->set_pool(pool);
+
+		if (index)
+		{
+			impl::index_clear(index);
+			static_cast<impl::xml_document_struct*>(_root)->index = index;
+		}
+	}
+
+	PUGI__FN void xml_document::set_page_pool(xml_page_pool* pool)
+	{
+		impl::xml_page_pool_impl* pool_impl = pool ? static_cast<impl::xml_page_pool_impl*>(pool->_impl) : 0;
+
+		// the pages go back to the pool they came from first
+		reset();
+
+		static_cast<impl::xml_document_struct*>(_root)->set_pool(pool_impl);
+	}
+
+	PUGI__FN bool xml_document::enable_lookup_index(size_t min_size)
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		if (!doc->index)
+		{
+			impl::xml_lookup_index* index = static_cast<impl::xml_lookup_index*>(impl::xml_memory::allocate(sizeof(impl::xml_lookup_index)));
+			if (!index) return false;
+
+			memset(index, 0, sizeof(impl::xml_lookup_index));
+
+			doc->index = index;
+		}
+
+		// tables that were built for a different size threshold are rebuilt
+		doc->index->min_size = min_size;
+		doc->index->generation++;
+
+		return true;
+	}
+
+	PUGI__FN void xml_document::disable_lookup_index()
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		if (doc->index)
+		{
+			impl::index_destroy(doc->index);
+			doc->index = 0;
+		}
 	}
 
 	PUGI__FN void xml_document::reset(const xml_document& proto)
@@ -6978,6 +9728,20 @@ namespace pugi
 		impl::node_copy_tree(_root, proto._root);
 	}
 
+	PUGI__FN void xml_document::reset_shared(const xml_document& proto)
+	{
+		reset();
+
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+		impl::xml_document_struct* source = static_cast<impl::xml_document_struct*>(proto._root);
+
+		// moving the strings of proto to shared storage doesn't change its contents; if it fails, the strings are copied
+		if (impl::share_document_strings(source) && impl::copy_shared_strings_refs(doc, source))
+			impl::node_copy_tree(_root, proto._root, true);
+		else
+			impl::node_copy_tree(_root, proto._root);
+	}
+
 	PUGI__FN void xml_document::_create()
 	{
 		assert(!_root);
@@ -6996,7 +9760,8 @@ namespace pugi
 		impl::xml_memory_page* page = impl::xml_memory_page::construct(_memory);
 		assert(page);
 
-		page->busy_size = impl::xml_memory_page_size;
+		// the embedded page is full for any page size (see xml_page_pool)
+		page->busy_size = impl::xml_memory_page_size_max;
 
 		// setup first page marker
 	#ifdef PUGIXML_COMPACT
@@ -7038,6 +9803,20 @@ namespace pugi
 			if (extra->buffer) impl::xml_memory::deallocate(extra->buffer);
 		}
 
+		// release shared strings (note: no need to destroy linked list nodes, they're allocated using document allocator)
+		for (impl::xml_shared_strings_ref* ref = static_cast<impl::xml_document_struct*>(_root)->shared_strings; ref; ref = ref->next)
+			impl::xml_shared_strings::release(ref->strings);
+
+		// destroy lookup index
+		if (impl::xml_lookup_index* index = static_cast<impl::xml_document_struct*>(_root)->index)
+			impl::index_destroy(index);
+
+	#if defined(PUGI__MMAP_WIN32) || defined(PUGI__MMAP_POSIX)
+		// destroy file mapping
+		if (void* mapped = static_cast<impl::xml_document_struct*>(_root)->mapped)
+			impl::unmap_file(mapped, static_cast<impl::xml_document_struct*>(_root)->mapped_size);
+	#endif
+
 		// destroy dynamic storage, leave sentinel page (it's in static memory)
 		impl::xml_memory_page* root_page = PUGI__GETPAGE(_root);
 		assert(root_page && !root_page->prev);
@@ -7104,8 +9883,18 @@ namespace pugi
 		// move buffer state
 		doc->buffer = other->buffer;
 		doc->extra_buffers = other->extra_buffers;
+		doc->shared_strings = other->shared_strings;
+		doc->mapped = other->mapped;
+		doc->mapped_size = other->mapped_size;
 		_buffer = rhs._buffer;
 
+		// move lookup index settings; the tables are keyed by node and other's document node is not moved
+		if ((doc->index = other->index) != 0) impl::index_clear(doc->index);
+
+		// the pages are returned to the pool they came from, so the pool moves with them
+		impl::xml_page_pool_impl* pool = other->_pool;
+		doc->set_pool(pool);
+
 	#ifdef PUGIXML_COMPACT
 		// move compact hash; note that the hash table can have pointers to other but they will be "inactive", similarly to nodes removed with remove_child
 		doc->hash = other->hash;
@@ -7167,6 +9956,7 @@ namespace pugi
 
 		// reset other document
 		new (other) impl::xml_document_struct(PUGI__GETPAGE(other));
+		other->set_pool(pool);
 		rhs._buffer = 0;
 	}
 #endif
@@ -7204,24 +9994,54 @@ namespace pugi
 		return load_string(contents, options);
 	}
 
-	PUGI__FN xml_parse_result xml_document::load_file(const char* path_, unsigned int options, xml_encoding encoding)
+	PUGI__FN xml_parse_result xml_document::load_file(const char* path_, unsigned int options, xml_encoding encoding)
+	{
+		reset();
+
+		using impl::auto_deleter; // MSVC7 workaround
+		auto_deleter<FILE> file(impl::open_file(path_, "rb"), impl::close_file);
+
+		return impl::load_file_impl(static_cast<impl::xml_document_struct*>(_root), file.data, options, encoding, &_buffer);
+	}
+
+	PUGI__FN xml_parse_result xml_document::load_file(const wchar_t* path_, unsigned int options, xml_encoding encoding)
+	{
+		reset();
+
+		using impl::auto_deleter; // MSVC7 workaround
+		auto_deleter<FILE> file(impl::open_file_wide(path_, L"rb"), impl::close_file);
+
+		return impl::load_file_impl(static_cast<impl::xml_document_struct*>(_root), file.data, options, encoding, &_buffer);
+	}
+
+	PUGI__FN xml_parse_result xml_document::load_file_mapped(const char* path_, unsigned int options, xml_encoding encoding)
 	{
+	#if defined(PUGI__MMAP_WIN32) || defined(PUGI__MMAP_POSIX)
 		reset();
 
-		using impl::auto_deleter; // MSVC7 workaround
-		auto_deleter<FILE> file(impl::open_file(path_, "rb"), impl::close_file);
+		size_t size = 0;
 
-		return impl::load_file_impl(static_cast<impl::xml_document_struct*>(_root), file.data, options, encoding, &_buffer);
+		if (void* data = impl::map_file(path_, size))
+			return impl::load_mapped_impl(static_cast<impl::xml_document_struct*>(_root), data, size, options, encoding, &_buffer);
+	#endif
+
+		// files that can't be mapped are read into a buffer, which also reports the errors
+		return load_file(path_, options, encoding);
 	}
 
-	PUGI__FN xml_parse_result xml_document::load_file(const wchar_t* path_, unsigned int options, xml_encoding encoding)
+	PUGI__FN xml_parse_result xml_document::load_file_mapped(const wchar_t* path_, unsigned int options, xml_encoding encoding)
 	{
+	#if defined(PUGI__MMAP_WIN32) || defined(PUGI__MMAP_POSIX)
 		reset();
 
-		using impl::auto_deleter; // MSVC7 workaround
-		auto_deleter<FILE> file(impl::open_file_wide(path_, L"rb"), impl::close_file);
+		size_t size = 0;
 
-		return impl::load_file_impl(static_cast<impl::xml_document_struct*>(_root), file.data, options, encoding, &_buffer);
+		if (void* data = impl::map_file_wide(path_, size))
+			return impl::load_mapped_impl(static_cast<impl::xml_document_struct*>(_root), data, size, options, encoding, &_buffer);
+	#endif
+
+		// files that can't be mapped are read into a buffer, which also reports the errors
+		return load_file(path_, options, encoding);
 	}
 
 	PUGI__FN xml_parse_result xml_document::load_buffer(const void* contents, size_t size, unsigned int options, xml_encoding encoding)
@@ -7231,6 +10051,46 @@ namespace pugi
 		return impl::load_buffer_impl(static_cast<impl::xml_document_struct*>(_root), _root, const_cast<void*>(contents), size, options, encoding, false, false, &_buffer);
 	}
 
+	PUGI__FN xml_parse_result xml_document::load_buffer_parallel(const void* contents, size_t size, unsigned int threads, unsigned int options, xml_encoding encoding)
+	{
+	#if defined(PUGI__HAS_THREADS) && !defined(PUGIXML_COMPACT)
+		if (threads == 0) threads = std::thread::hardware_concurrency();
+
+		// small chunks don't pay for the threads
+		if (threads > size / impl::parallel_min_chunk) threads = static_cast<unsigned int>(size / impl::parallel_min_chunk);
+
+		// these options depend on siblings that chunks can't see
+		if (threads > 1 && !(options & (parse_fragment | parse_embed_pcdata | parse_ws_pcdata_single)))
+		{
+			reset();
+
+			impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+			xml_encoding buffer_encoding = impl::get_buffer_encoding(encoding, contents, size);
+
+			char_t* buffer = 0;
+			size_t length = 0;
+
+			if (!impl::convert_buffer(buffer, length, buffer_encoding, contents, size, false)) return impl::make_parse_result(status_out_of_memory);
+
+			_buffer = buffer;
+			doc->buffer = buffer;
+
+			if (length && impl::parse_parallel(doc, buffer, length, options, threads))
+			{
+				xml_parse_result result = impl::make_parse_result(status_ok);
+				result.encoding = buffer_encoding;
+
+				return result;
+			}
+		}
+	#else
+		(void)threads;
+	#endif
+
+		return load_buffer(contents, size, options, encoding);
+	}
+
 	PUGI__FN xml_parse_result xml_document::load_buffer_inplace(void* contents, size_t size, unsigned int options, xml_encoding encoding)
 	{
 		reset();
@@ -7249,24 +10109,7 @@ namespace pugi
 	{
 		impl::xml_buffered_writer buffered_writer(writer, encoding);
 
-		if ((flags & format_write_bom) && encoding != encoding_latin1)
-		{
-			// BOM always represents the codepoint U+FEFF, so just write it in native encoding
-		#ifdef PUGIXML_WCHAR_MODE
-			unsigned int bom = 0xfeff;
-			buffered_writer.write(static_cast<wchar_t>(bom));
-		#else
-			buffered_writer.write('\xef', '\xbb', '\xbf');
-		#endif
-		}
-
-		if (!(flags & format_no_declaration) && !impl::has_declaration(_root))
-		{
-			buffered_writer.write_string(PUGIXML_TEXT("<?xml version=\"1.0\""));
-			if (encoding == encoding_latin1) buffered_writer.write_string(PUGIXML_TEXT(" encoding=\"ISO-8859-1\""));
-			buffered_writer.write('?', '>');
-			if (!(flags & format_raw)) buffered_writer.write('\n');
-		}
+		impl::document_output_prolog(buffered_writer, flags, encoding, !impl::has_declaration(_root));
 
 		impl::node_output(buffered_writer, _root, indent, flags, 0);
 
@@ -7357,6 +10200,66 @@ namespace pugi
 	{
 		return impl::xml_memory::deallocate;
 	}
+
+	PUGI__FN xml_page_pool::xml_page_pool(size_t page_size, size_t max_free_pages, allocation_function allocate, deallocation_function deallocate): _impl(0)
+	{
+		void* memory = impl::xml_memory::allocate(sizeof(impl::xml_page_pool_impl));
+
+	#ifndef PUGIXML_NO_EXCEPTIONS
+		if (!memory) throw std::bad_alloc();
+	#else
+		if (!memory) return;
+	#endif
+
+		impl::xml_page_pool_impl* pool = new (memory) impl::xml_page_pool_impl();
+
+		// page size includes the page header, like PUGIXML_MEMORY_PAGE_SIZE
+		size_t data_size = page_size == 0 ? impl::xml_memory_page_size : page_size > sizeof(impl::xml_memory_page) ? page_size - sizeof(impl::xml_memory_page) : 0;
+
+		pool->page_size = data_size < 1024 ? 1024 : data_size > impl::xml_memory_page_size_max ? impl::xml_memory_page_size_max : data_size;
+		pool->max_free_pages = max_free_pages;
+
+		// custom functions are only used as a pair
+		pool->allocate = (allocate && deallocate) ? allocate : impl::xml_memory::allocate;
+		pool->deallocate = (allocate && deallocate) ? deallocate : impl::xml_memory::deallocate;
+		pool->free_pages = 0;
+		pool->free_count = 0;
+
+		_impl = pool;
+	}
+
+	PUGI__FN xml_page_pool::~xml_page_pool()
+	{
+		if (_impl)
+		{
+			impl::xml_page_pool_impl* pool = static_cast<impl::xml_page_pool_impl*>(_impl);
+
+			impl::page_pool_trim(pool);
+
+			pool->~xml_page_pool_impl();
+			impl::xml_memory::deallocate(pool);
+		}
+	}
+
+	PUGI__FN size_t xml_page_pool::page_size() const
+	{
+		return _impl ? static_cast<impl::xml_page_pool_impl*>(_impl)->page_size + sizeof(impl::xml_memory_page) : 0;
+	}
+
+	PUGI__FN size_t xml_page_pool::free_pages() const
+	{
+		if (!_impl) return 0;
+
+		impl::xml_page_pool_impl* pool = static_cast<impl::xml_page_pool_impl*>(_impl);
+		impl::xml_page_pool_lock lock(pool);
+
+		return pool->free_count;
+	}
+
+	PUGI__FN void xml_page_pool::trim()
+	{
+		if (_impl) impl::page_pool_trim(static_cast<impl::xml_page_pool_impl*>(_impl));
+	}
 }
 
 #if !defined(PUGIXML_NO_STL) && (defined(_MSC_VER) || defined(__ICC))
@@ -8902,6 +11805,29 @@ PUGI__NS_BEGIN
 		}
 	}
 
+	template <typename T> PUGI__FN size_t xpath_attribute_values(const xpath_node* begin, const xpath_node* end, const char_t* attr_name, typename T::value_type* result, size_t capacity, typename T::value_type def)
+	{
+		size_t count = 0;
+
+		for (const xpath_node* it = begin; it != end; ++it, ++count)
+		{
+			if (count >= capacity) continue;
+
+			// attribute nodes are converted directly, element nodes through their attr_name attribute
+			xml_attribute_struct* attr = it->attribute().internal_object();
+
+			if (!attr)
+			{
+				xml_node_struct* node = it->node().internal_object();
+				attr = (node && PUGI__NODETYPE(node) == node_element) ? find_attribute(node, attr_name) : 0;
+			}
+
+			result[count] = attribute_value<T>(attr, def);
+		}
+
+		return count;
+	}
+
 	class xpath_node_set_raw
 	{
 		xpath_node_set::type_t _type;
@@ -12169,6 +15095,164 @@ PUGI__NS_BEGIN
 
 		return impl->root;
 	}
+
+	struct xpath_query_cache_entry
+	{
+		xpath_query query;
+		xpath_variable_set* variables;
+		unsigned int hash;
+		xpath_query_cache_entry* next;
+
+		// expression text follows
+		char_t* text()
+		{
+			return reinterpret_cast<char_t*>(this + 1);
+		}
+	};
+
+	struct xpath_query_cache_impl
+	{
+		static xpath_query_cache_impl* create()
+		{
+			void* memory = xml_memory::allocate(sizeof(xpath_query_cache_impl));
+			if (!memory) return 0;
+
+			return new (memory) xpath_query_cache_impl();
+		}
+
+		static void destroy(xpath_query_cache_impl* impl)
+		{
+			impl->clear();
+
+			if (impl->buckets) xml_memory::deallocate(impl->buckets);
+
+			impl->~xpath_query_cache_impl();
+			xml_memory::deallocate(impl);
+		}
+
+		xpath_query_cache_impl(): buckets(0), bucket_count(0), count(0)
+		{
+		}
+
+		xpath_query_cache_entry* find(const char_t* query, xpath_variable_set* variables, unsigned int hash) const
+		{
+			if (!bucket_count) return 0;
+
+			for (xpath_query_cache_entry* entry = buckets[hash & (bucket_count - 1)]; entry; entry = entry->next)
+				if (entry->hash == hash && entry->variables == variables && strequal(entry->text(), query))
+					return entry;
+
+			return 0;
+		}
+
+		bool rehash()
+		{
+			size_t new_count = bucket_count ? bucket_count * 2 : 32;
+
+			xpath_query_cache_entry** new_buckets = static_cast<xpath_query_cache_entry**>(xml_memory::allocate(sizeof(xpath_query_cache_entry*) * new_count));
+			if (!new_buckets) return false;
+
+			memset(new_buckets, 0, sizeof(xpath_query_cache_entry*) * new_count);
+
+			for (size_t i = 0; i < bucket_count; ++i)
+			{
+				for (xpath_query_cache_entry* entry = buckets[i]; entry; )
+				{
+					xpath_query_cache_entry* next = entry->next;
+
+					entry->next = new_buckets[entry->hash & (new_count - 1)];
+					new_buckets[entry->hash & (new_count - 1)] = entry;
+
+					entry = next;
+				}
+			}
+
+			if (buckets) xml_memory::deallocate(buckets);
+
+			buckets = new_buckets;
+			bucket_count = new_count;
+
+			return true;
+		}
+
+		xpath_query_cache_entry* insert(const char_t* query, xpath_variable_set* variables, unsigned int hash)
+		{
+			// keep load factor below 1
+			if (count >= bucket_count && !rehash()) return 0;
+
+			size_t length = strlength(query);
+
+			void* memory = xml_memory::allocate(sizeof(xpath_query_cache_entry) + (length + 1) * sizeof(char_t));
+			if (!memory) return 0;
+
+			// compilation errors throw, in which case the memory has to be released
+			auto_deleter<void> guard(memory, xml_memory::deallocate);
+
+			xpath_query_cache_entry* entry = static_cast<xpath_query_cache_entry*>(memory);
+
+			new (&entry->query) xpath_query(query, variables);
+			guard.release();
+
+			entry->variables = variables;
+			entry->hash = hash;
+			memcpy(entry->text(), query, (length + 1) * sizeof(char_t));
+
+			entry->next = buckets[hash & (bucket_count - 1)];
+			buckets[hash & (bucket_count - 1)] = entry;
+			count++;
+
+			return entry;
+		}
+
+		void clear()
+		{
+			for (size_t i = 0; i < bucket_count; ++i)
+			{
+				for (xpath_query_cache_entry* entry = buckets[i]; entry; )
+				{
+					xpath_query_cache_entry* next = entry->next;
+
+					entry->query.~xpath_query();
+					xml_memory::deallocate(entry);
+
+					entry = next;
+				}
+
+				buckets[i] = 0;
+			}
+
+			count = 0;
+		}
+
+		xpath_query_cache_entry** buckets;
+		size_t bucket_count;
+		size_t count;
+
+	#ifdef PUGI__HAS_THREADS
+		std::mutex mutex;
+	#endif
+	};
+
+	struct xpath_query_cache_lock
+	{
+	#ifdef PUGI__HAS_THREADS
+		xpath_query_cache_lock(xpath_query_cache_impl* impl): mutex(impl->mutex)
+		{
+			mutex.lock();
+		}
+
+		~xpath_query_cache_lock()
+		{
+			mutex.unlock();
+		}
+
+		std::mutex& mutex;
+	#else
+		xpath_query_cache_lock(xpath_query_cache_impl*)
+		{
+		}
+	#endif
+	};
 PUGI__NS_END
 
 namespace pugi
@@ -12281,6 +15365,27 @@ namespace pugi
 
 		_begin = storage;
 		_end = storage + size_;
+		_eos = (size_ <= 1) ? _storage + 1 : _end;
+		_type = type_;
+	}
+
+	PUGI__FN void xpath_node_set::_assign_reuse(const_iterator begin_, const_iterator end_, type_t type_)
+	{
+		assert(begin_ <= end_);
+
+		size_t size_ = static_cast<size_t>(end_ - begin_);
+
+		// keep the current buffer if the new contents fit, so that repeated evaluation into one set doesn't allocate
+		if (size_ > static_cast<size_t>(_eos - _begin))
+		{
+			_assign(begin_, end_, type_);
+			return;
+		}
+
+		if (size_)
+			memcpy(_begin, begin_, size_ * sizeof(xpath_node));
+
+		_end = _begin + size_;
 		_type = type_;
 	}
 
@@ -12291,18 +15396,20 @@ namespace pugi
 		_storage[0] = rhs._storage[0];
 		_begin = (rhs._begin == rhs._storage) ? _storage : rhs._begin;
 		_end = _begin + (rhs._end - rhs._begin);
+		_eos = _begin + (rhs._eos - rhs._begin);
 
 		rhs._type = type_unsorted;
 		rhs._begin = rhs._storage;
 		rhs._end = rhs._storage;
+		rhs._eos = rhs._storage + 1;
 	}
 #endif
 
-	PUGI__FN xpath_node_set::xpath_node_set(): _type(type_unsorted), _begin(_storage), _end(_storage)
+	PUGI__FN xpath_node_set::xpath_node_set(): _type(type_unsorted), _begin(_storage), _end(_storage), _eos(_storage + 1)
 	{
 	}
 
-	PUGI__FN xpath_node_set::xpath_node_set(const_iterator begin_, const_iterator end_, type_t type_): _type(type_unsorted), _begin(_storage), _end(_storage)
+	PUGI__FN xpath_node_set::xpath_node_set(const_iterator begin_, const_iterator end_, type_t type_): _type(type_unsorted), _begin(_storage), _end(_storage), _eos(_storage + 1)
 	{
 		_assign(begin_, end_, type_);
 	}
@@ -12313,7 +15420,7 @@ namespace pugi
 			impl::xml_memory::deallocate(_begin);
 	}
 
-	PUGI__FN xpath_node_set::xpath_node_set(const xpath_node_set& ns): _type(type_unsorted), _begin(_storage), _end(_storage)
+	PUGI__FN xpath_node_set::xpath_node_set(const xpath_node_set& ns): _type(type_unsorted), _begin(_storage), _end(_storage), _eos(_storage + 1)
 	{
 		_assign(ns._begin, ns._end, ns._type);
 	}
@@ -12328,7 +15435,7 @@ namespace pugi
 	}
 
 #ifdef PUGIXML_HAS_MOVE
-	PUGI__FN xpath_node_set::xpath_node_set(xpath_node_set&& rhs) PUGIXML_NOEXCEPT: _type(type_unsorted), _begin(_storage), _end(_storage)
+	PUGI__FN xpath_node_set::xpath_node_set(xpath_node_set&& rhs) PUGIXML_NOEXCEPT: _type(type_unsorted), _begin(_storage), _end(_storage), _eos(_storage + 1)
 	{
 		_move(rhs);
 	}
@@ -12387,6 +15494,23 @@ namespace pugi
 		return impl::xpath_first(_begin, _end, _type);
 	}
 
+	PUGI__FN size_t xpath_node_set::attribute_values(const char_t* attr_name, double* result, size_t capacity, double def) const
+	{
+		return impl::xpath_attribute_values<impl::attribute_value_double>(_begin, _end, attr_name, result, capacity, def);
+	}
+
+	PUGI__FN size_t xpath_node_set::attribute_values(const char_t* attr_name, int* result, size_t capacity, int def) const
+	{
+		return impl::xpath_attribute_values<impl::attribute_value_int>(_begin, _end, attr_name, result, capacity, def);
+	}
+
+#ifdef PUGIXML_HAS_LONG_LONG
+	PUGI__FN size_t xpath_node_set::attribute_values(const char_t* attr_name, long long* result, size_t capacity, long long def) const
+	{
+		return impl::xpath_attribute_values<impl::attribute_value_llong>(_begin, _end, attr_name, result, capacity, def);
+	}
+#endif
+
 	PUGI__FN xpath_parse_result::xpath_parse_result(): error("Internal error"), offset(0)
 	{
 	}
@@ -12879,6 +16003,33 @@ namespace pugi
 		return xpath_node_set(r.begin(), r.end(), r.type());
 	}
 
+	PUGI__FN void xpath_query::evaluate_node_set(const xpath_node& n, xpath_node_set& result) const
+	{
+		impl::xpath_ast_node* root = impl::evaluate_node_set_prepare(static_cast<impl::xpath_query_impl*>(_impl));
+		if (!root)
+		{
+			result._assign_reuse(0, 0, xpath_node_set::type_unsorted);
+			return;
+		}
+
+		impl::xpath_context c(n, 1, 1);
+		impl::xpath_stack_data sd;
+
+		impl::xpath_node_set_raw r = root->eval_node_set(c, sd.stack, impl::nodeset_eval_all);
+
+		if (sd.oom)
+		{
+		#ifdef PUGIXML_NO_EXCEPTIONS
+			result._assign_reuse(0, 0, xpath_node_set::type_unsorted);
+			return;
+		#else
+			throw std::bad_alloc();
+		#endif
+		}
+
+		result._assign_reuse(r.begin(), r.end(), r.type());
+	}
+
 	PUGI__FN xpath_node xpath_query::evaluate_node(const xpath_node& n) const
 	{
 		impl::xpath_ast_node* root = impl::evaluate_node_set_prepare(static_cast<impl::xpath_query_impl*>(_impl));
@@ -12920,6 +16071,68 @@ namespace pugi
 		return !_impl;
 	}
 
+	PUGI__FN xpath_query_cache::xpath_query_cache(): _impl(0)
+	{
+		_impl = impl::xpath_query_cache_impl::create();
+
+	#ifndef PUGIXML_NO_EXCEPTIONS
+		if (!_impl) throw std::bad_alloc();
+	#endif
+	}
+
+	PUGI__FN xpath_query_cache::~xpath_query_cache()
+	{
+		if (_impl)
+			impl::xpath_query_cache_impl::destroy(static_cast<impl::xpath_query_cache_impl*>(_impl));
+	}
+
+	PUGI__FN const xpath_query& xpath_query_cache::get(const char_t* query, xpath_variable_set* variables)
+	{
+		// returned when the cache runs out of memory in PUGIXML_NO_EXCEPTIONS mode
+		static const xpath_query empty;
+
+		impl::xpath_query_cache_impl* cache = static_cast<impl::xpath_query_cache_impl*>(_impl);
+		if (!cache) return empty;
+
+		impl::xpath_query_cache_lock lock(cache);
+
+		unsigned int hash = impl::lookup_hash(query);
+
+		impl::xpath_query_cache_entry* entry = cache->find(query, variables, hash);
+		if (!entry) entry = cache->insert(query, variables, hash);
+
+		if (!entry)
+		{
+		#ifdef PUGIXML_NO_EXCEPTIONS
+			return empty;
+		#else
+			throw std::bad_alloc();
+		#endif
+		}
+
+		return entry->query;
+	}
+
+	PUGI__FN size_t xpath_query_cache::size() const
+	{
+		impl::xpath_query_cache_impl* cache = static_cast<impl::xpath_query_cache_impl*>(_impl);
+		if (!cache) return 0;
+
+		impl::xpath_query_cache_lock lock(cache);
+
+		return cache->count;
+	}
+
+	PUGI__FN void xpath_query_cache::clear()
+	{
+		impl::xpath_query_cache_impl* cache = static_cast<impl::xpath_query_cache_impl*>(_impl);
+		if (!cache) return;
+
+		impl::xpath_query_cache_lock lock(cache);
+
+		cache->clear();
+	}
+
 	PUGI__FN xpath_node xml_node::select_node(const char_t* query, xpath_variable_set* variables) const
 	{
 		xpath_query q(query, variables);
@@ -12942,6 +16155,11 @@ namespace pugi
 		return query.evaluate_node_set(*this);
 	}
 
+	PUGI__FN void xml_node::select_nodes(const xpath_query& query, xpath_node_set& result) const
+	{
+		query.evaluate_node_set(*this, result);
+	}
+
 	PUGI__FN xpath_node xml_node::select_single_node(const char_t* query, xpath_variable_set* variables) const
 	{
 		xpath_query q(query, variables);
@@ -12997,6 +16215,7 @@ namespace pugi
 #undef PUGI__SCANFOR
 #undef PUGI__SCANWHILE
 #undef PUGI__SCANWHILE_UNROLL
+#undef PUGI__SIMD_SCAN
 #undef PUGI__ENDSEG
 #undef PUGI__THROW_ERROR
 #undef PUGI__CHECK_ERROR
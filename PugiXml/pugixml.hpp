@@ -291,6 +291,8 @@ namespace pugi
 
 	class xml_text;
 
+	class xml_page_pool;
+
 	#ifndef PUGIXML_NO_XPATH
 	class xpath_node;
 	class xpath_node_set;
@@ -358,6 +360,64 @@ namespace pugi
 	};
 	#endif
 
+	// Push-style serializer: writes XML to the writer as the calls come, without building a document. Memory use is bounded by the
+	// output buffer and the names of the open elements; the output is the same as xml_document::save would produce for the equivalent tree.
+	class PUGIXML_CLASS xml_serializer
+	{
+	private:
+		void* _impl;
+
+		// Non-copyable semantics
+		xml_serializer(const xml_serializer&);
+		xml_serializer& operator=(const xml_serializer&);
+
+	public:
+		// Construct serializer and write the BOM and declaration according to the flags (see xml_document::save).
+		// If PUGIXML_NO_EXCEPTIONS is not defined, throws std::bad_alloc on out of memory errors; otherwise all functions fail.
+		xml_serializer(xml_writer& writer, const char_t* indent = PUGIXML_TEXT("\t"), unsigned int flags = format_default, xml_encoding encoding = encoding_auto);
+
+		// Destructor, calls close()
+		~xml_serializer();
+
+		// Start element; attributes can be written until the element gets content. Returns false after close() or on out of memory errors.
+		bool start_element(const char_t* name);
+
+		// Write attribute of the element that was just started. Returns false if the element already has content or none is open.
+		bool attribute(const char_t* name, const char_t* value);
+		bool attribute(const char_t* name, int value);
+		bool attribute(const char_t* name, unsigned int value);
+		bool attribute(const char_t* name, long value);
+		bool attribute(const char_t* name, unsigned long value);
+		bool attribute(const char_t* name, double value);
+		bool attribute(const char_t* name, double value, int precision);
+		bool attribute(const char_t* name, float value);
+		bool attribute(const char_t* name, float value, int precision);
+		bool attribute(const char_t* name, bool value);
+
+	#ifdef PUGIXML_HAS_LONG_LONG
+		bool attribute(const char_t* name, long long value);
+		bool attribute(const char_t* name, unsigned long long value);
+	#endif
+
+		// Write character data, CDATA section, comment or processing instruction
+		bool text(const char_t* value);
+		bool cdata(const char_t* value);
+		bool comment(const char_t* value);
+		bool pi(const char_t* name, const char_t* value = PUGIXML_NULL);
+
+		// End the innermost open element. Returns false if there is none.
+		bool end_element();
+
+		// Get the number of open elements
+		size_t depth() const;
+
+		// Pass the buffered output to the writer
+		void flush();
+
+		// End all open elements and flush; nothing can be written afterwards
+		void close();
+	};
+
 	// A light-weight handle for manipulating attributes in DOM tree
 	class PUGIXML_CLASS xml_attribute
 	{
@@ -659,6 +719,15 @@ namespace pugi
 		xml_node find_child_by_attribute(const char_t* name, const char_t* attr_name, const char_t* attr_value) const;
 		xml_node find_child_by_attribute(const char_t* attr_name, const char_t* attr_value) const;
 
+		// Convert attribute attr_name of the element children named name (of all element children if name is null) in document order, using a
+		// locale-independent number parser; children without the attribute get def. Stores up to capacity values, returns the number of children.
+		size_t attribute_values(const char_t* name, const char_t* attr_name, double* result, size_t capacity, double def = 0) const;
+		size_t attribute_values(const char_t* name, const char_t* attr_name, int* result, size_t capacity, int def = 0) const;
+
+	#ifdef PUGIXML_HAS_LONG_LONG
+		size_t attribute_values(const char_t* name, const char_t* attr_name, long long* result, size_t capacity, long long def = 0) const;
+	#endif
+
 	#ifndef PUGIXML_NO_STL
 		// Get the absolute node path from root as a text string.
 		string_t path(char_t delimiter = '/') const;
@@ -679,6 +748,9 @@ namespace pugi
 		xpath_node_set select_nodes(const char_t* query, xpath_variable_set* variables = PUGIXML_NULL) const;
 		xpath_node_set select_nodes(const xpath_query& query) const;
 
+		// Select node set by evaluating XPath query into an existing set, reusing its storage
+		void select_nodes(const xpath_query& query, xpath_node_set& result) const;
+
 		// (deprecated: use select_node instead) Select single node by evaluating XPath query.
 		PUGIXML_DEPRECATED xpath_node select_single_node(const char_t* query, xpath_variable_set* variables = PUGIXML_NULL) const;
 		PUGIXML_DEPRECATED xpath_node select_single_node(const xpath_query& query) const;
@@ -1026,7 +1098,7 @@ namespace pugi
 	private:
 		char_t* _buffer;
 
-		char _memory[192];
+		char _memory[200];
 
 		// Non-copyable semantics
 		xml_document(const xml_document&);
@@ -1055,6 +1127,21 @@ namespace pugi
 		// Removes all nodes, then copies the entire contents of the specified document
 		void reset(const xml_document& proto);
 
+		// Removes all nodes, then copies the entire contents of the specified document, sharing its strings instead of copying them.
+		// The strings of proto are moved to reference counted read-only storage on first use, so later clones only copy the nodes; strings modified in
+		// either document are copied on write. Clones of a document that was not modified since its last clone can be made from several threads at once.
+		void reset_shared(const xml_document& proto);
+
+		// Enable hashed lookup for xml_node::child(name) and xml_node::attribute(name) on nodes with at least min_size children/attributes.
+		// Tables are built on the first lookup of a node and invalidated by any modification of the document; the setting survives reset() and loading.
+		// Note that with the index enabled, lookups modify the document's tables, so they must not run concurrently from several threads.
+		bool enable_lookup_index(size_t min_size = 32);
+		void disable_lookup_index();
+
+		// Removes all nodes and takes memory pages from the pool from now on (from the global memory management functions if pool is null).
+		// The setting survives reset() and loading and moves with the contents on move construction/assignment; the pool must outlive the document.
+		void set_page_pool(xml_page_pool* pool);
+
 	#ifndef PUGIXML_NO_STL
 		// Load document from stream.
 		xml_parse_result load(std::basic_istream<char, std::char_traits<char> >& stream, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
@@ -1071,9 +1158,20 @@ namespace pugi
 		xml_parse_result load_file(const char* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
 		xml_parse_result load_file(const wchar_t* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
 
+		// Load document from file, using a copy-on-write memory mapping of the file for in-place parsing (load_buffer_inplace semantics).
+		// The mapping is released when the document is destroyed; the file must not be truncated or rewritten while the document is alive.
+		// Falls back to load_file if the file can't be mapped (empty files, non-regular files, platforms without mmap or PUGIXML_NO_MMAP).
+		xml_parse_result load_file_mapped(const char* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+		xml_parse_result load_file_mapped(const wchar_t* path, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+
 		// Load document from buffer. Copies/converts the buffer, so it may be deleted or changed after the function returns.
 		xml_parse_result load_buffer(const void* contents, size_t size, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
 
+		// Load document from buffer like load_buffer, parsing the children of the document element on several threads (0 = hardware concurrency).
+		// The resulting tree is identical to the one load_buffer produces; documents that can't be split, have errors or are too small are parsed serially.
+		// Requires C++11 threads; in compact mode and with PUGIXML_NO_THREADS or PUGIXML_NO_STL the document is always parsed serially.
+		xml_parse_result load_buffer_parallel(const void* contents, size_t size, unsigned int threads = 0, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+
 		// Load document from buffer, using the buffer for in-place parsing (the buffer is modified and used for storage of document data).
 		// You should ensure that buffer data will persist throughout the document's lifetime, and free the buffer memory manually once document is destroyed.
 		xml_parse_result load_buffer_inplace(void* contents, size_t size, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
@@ -1099,6 +1197,74 @@ namespace pugi
 		xml_node document_element() const;
 	};
 
+	// Events returned by xml_reader
+	enum xml_reader_event
+	{
+		reader_event_none,			// Not opened or nothing read yet
+		reader_event_start_element,	// Start of element; name() is the element name
+		reader_event_attribute,		// Attribute of the element that was just started; name() and value()
+		reader_event_text,			// Character data or CDATA section inside an element; value()
+		reader_event_end_element,	// End of element, also after an empty-element tag; name() is the element name
+		reader_event_end_document,	// End of the document
+		reader_event_error			// Parsing or reading error, see result()
+	};
+
+	// Pull-style reader: returns a document as a sequence of events front to back, without building a tree. The input is read in
+	// blocks into a buffer that only grows for tags or character data longer than it, so memory use doesn't depend on the document
+	// size. Names, attribute values and character data are converted by the parser code of xml_document::load; the options
+	// parse_cdata, parse_escapes, parse_eol, parse_wconv_attribute, parse_wnorm_attribute, parse_ws_pcdata and parse_trim_pcdata
+	// apply, while declarations, processing instructions, comments and the document type are always skipped.
+	// The input must be UTF-8 or Latin-1 (as declared in the document declaration).
+	class PUGIXML_CLASS xml_reader
+	{
+	private:
+		void* _impl;
+
+		// Non-copyable semantics
+		xml_reader(const xml_reader&);
+		xml_reader& operator=(const xml_reader&);
+
+	public:
+		// Construct reader that reads blocks of buffer_size bytes.
+		// If PUGIXML_NO_EXCEPTIONS is not defined, throws std::bad_alloc on out of memory errors; otherwise all functions fail.
+		explicit xml_reader(unsigned int options = parse_default, size_t buffer_size = 65536);
+
+		// Destructor, closes the document
+		~xml_reader();
+
+		// Open document from file, from buffer (not copied, it has to stay valid until the document is closed) or from stream.
+		// Returns false if the document can't be read, see result().
+		bool open_file(const char* path);
+		bool open_file(const wchar_t* path);
+		bool open_buffer(const void* contents, size_t size);
+
+	#ifndef PUGIXML_NO_STL
+		bool open(std::basic_istream<char, std::char_traits<char> >& stream);
+	#endif
+
+		// Read next event; after end_document and error the same event is returned again.
+		// Names and values are valid until the next call.
+		xml_reader_event next();
+
+		// Skip the rest of the element of the last start_element or attribute event, up to and including its end_element event.
+		// Returns false on errors or if there is no such element.
+		bool skip_element();
+
+		// Get last event, its name and value (empty strings if the event has none)
+		xml_reader_event event() const;
+		const char_t* name() const;
+		const char_t* value() const;
+
+		// Get the number of open elements, including the element of a start_element, attribute or end_element event
+		size_t depth() const;
+
+		// Get status of the reader; for errors, offset is the position in bytes in the input
+		xml_parse_result result() const;
+
+		// Close the document; the reader can open another one
+		void close();
+	};
+
 #ifndef PUGIXML_NO_XPATH
 	// XPath query return type
 	enum xpath_value_type
@@ -1265,6 +1431,12 @@ namespace pugi
 		// If PUGIXML_NO_EXCEPTIONS is defined, returns empty node set instead.
 		xpath_node_set evaluate_node_set(const xpath_node& n) const;
 
+		// Evaluate expression as node set in the specified context, replacing the contents of result.
+		// The storage of result is reused if it is large enough, so evaluating into the same set over and over doesn't allocate.
+		// If PUGIXML_NO_EXCEPTIONS is not defined, throws xpath_exception on type mismatch and std::bad_alloc on out of memory errors.
+		// If PUGIXML_NO_EXCEPTIONS is defined, result is emptied instead.
+		void evaluate_node_set(const xpath_node& n, xpath_node_set& result) const;
+
 		// Evaluate expression as node set in the specified context.
 		// Return first node in document order, or empty node if node set is empty.
 		// If PUGIXML_NO_EXCEPTIONS is not defined, throws xpath_exception on type mismatch and std::bad_alloc on out of memory errors.
@@ -1281,6 +1453,36 @@ namespace pugi
 		bool operator!() const;
 	};
 
+	// A cache of compiled XPath queries, keyed by expression text and variable set.
+	// Access is synchronized when pugixml is compiled as C++11 with STL; compiled queries can be evaluated from several threads at once.
+	class PUGIXML_CLASS xpath_query_cache
+	{
+	private:
+		void* _impl;
+
+		// Non-copyable semantics
+		xpath_query_cache(const xpath_query_cache&);
+		xpath_query_cache& operator=(const xpath_query_cache&);
+
+	public:
+		// Default constructor. Constructs empty cache.
+		xpath_query_cache();
+
+		// Destructor
+		~xpath_query_cache();
+
+		// Get the compiled query for the expression, compiling it on first use; the reference stays valid until clear() or destruction.
+		// If PUGIXML_NO_EXCEPTIONS is not defined, throws xpath_exception on compilation errors (the expression is not cached) and std::bad_alloc on out of memory errors.
+		// If PUGIXML_NO_EXCEPTIONS is defined, queries that failed to compile are cached as well; check them with xpath_query::result().
+		const xpath_query& get(const char_t* query, xpath_variable_set* variables = PUGIXML_NULL);
+
+		// Get the number of cached queries
+		size_t size() const;
+
+		// Remove all cached queries; no query obtained from the cache may be in use
+		void clear();
+	};
+
 	#ifndef PUGIXML_NO_EXCEPTIONS
         #if defined(_MSC_VER)
           // C4275 can be ignored in Visual C++ if you are deriving
@@ -1406,6 +1608,15 @@ namespace pugi
 		// Get first node in the collection by document order
 		xpath_node first() const;
 
+		// Convert attribute attr_name of each element node (the value of each attribute node) in collection order, see xml_node::attribute_values.
+		// Stores up to capacity values, returns the collection size.
+		size_t attribute_values(const char_t* attr_name, double* result, size_t capacity, double def = 0) const;
+		size_t attribute_values(const char_t* attr_name, int* result, size_t capacity, int def = 0) const;
+
+	#ifdef PUGIXML_HAS_LONG_LONG
+		size_t attribute_values(const char_t* attr_name, long long* result, size_t capacity, long long def = 0) const;
+	#endif
+
 		// Check if collection is empty
 		bool empty() const;
 
@@ -1416,9 +1627,13 @@ namespace pugi
 
 		xpath_node* _begin;
 		xpath_node* _end;
+		xpath_node* _eos;
 
 		void _assign(const_iterator begin, const_iterator end, type_t type);
+		void _assign_reuse(const_iterator begin, const_iterator end, type_t type);
 		void _move(xpath_node_set& rhs) PUGIXML_NOEXCEPT;
+
+		friend class xpath_query;
 	};
 #endif
 
@@ -1444,6 +1659,38 @@ namespace pugi
 	// Get current memory management functions
 	allocation_function PUGIXML_FUNCTION get_memory_allocation_function();
 	deallocation_function PUGIXML_FUNCTION get_memory_deallocation_function();
+
+	// Pool of document memory pages (see xml_document::set_page_pool). Pages that documents release on reset() or destruction are kept
+	// for reuse, so documents parsed back to back stop going to the heap once the pool is warm. Thread-safe unless PUGIXML_NO_THREADS is defined.
+	class PUGIXML_CLASS xml_page_pool
+	{
+		friend class xml_document;
+
+	private:
+		void* _impl;
+
+		// Non-copyable semantics
+		xml_page_pool(const xml_page_pool&);
+		xml_page_pool& operator=(const xml_page_pool&);
+
+	public:
+		// Construct pool with the page size in bytes (0 for PUGIXML_MEMORY_PAGE_SIZE), the number of free pages to keep at most (0 for no limit)
+		// and the functions to get memory from (unless both are given, the global memory management functions at construction time).
+		// If PUGIXML_NO_EXCEPTIONS is not defined, throws std::bad_alloc on out of memory errors; otherwise documents fall back to the global functions.
+		explicit xml_page_pool(size_t page_size = 0, size_t max_free_pages = 0, allocation_function allocate = PUGIXML_NULL, deallocation_function deallocate = PUGIXML_NULL);
+
+		// Destructor, releases the free pages; all documents using the pool must be destroyed or switched to another pool first
+		~xml_page_pool();
+
+		// Get the page size in bytes, after rounding to the supported range
+		size_t page_size() const;
+
+		// Get the number of free pages kept for reuse
+		size_t free_pages() const;
+
+		// Release the free pages
+		void trim();
+	};
 }
 
 #if !defined(PUGIXML_NO_STL) && (defined(_MSC_VER) || defined(__ICC))
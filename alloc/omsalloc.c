@@ -0,0 +1,523 @@
+/* omsalloc.c -- one allocator for the 3rd-party components
+ *
+ * Every block starts with a header naming its pool (NULL for the system
+ * allocator) and its size class, or a marker for large blocks, which are
+ * taken from the system one by one and linked into the pool. Small blocks
+ * never change their class: they are carved from chunks once and afterwards
+ * only move between the free lists of the thread caches and the shared free
+ * lists of the pool.
+ *
+ * A thread finds its cache of a pool through a thread-local one-entry memo,
+ * checked against the serial number of the pool so that a new pool at the
+ * address of a destroyed one is not mistaken for it, and otherwise by
+ * searching the caches of the pool under its lock. The caches belong to the
+ * pool and are released with it.
+ */
+
+#include "omsalloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#define FETCH_ADD(p, v)         InterlockedExchangeAdd((volatile LONG *)(p), (v))
+#else
+#define THREAD_LOCAL __thread
+#define FETCH_ADD(p, v)         __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#endif
+
+#ifdef _WIN32
+typedef SRWLOCK lock_t;
+#define lockInit(l)             InitializeSRWLock(l)
+#define lockDestroy(l)
+#define lockAcquire(l)          AcquireSRWLockExclusive(l)
+#define lockRelease(l)          ReleaseSRWLockExclusive(l)
+#else
+typedef pthread_mutex_t lock_t;
+#define lockInit(l)             pthread_mutex_init((l), NULL)
+#define lockDestroy(l)          pthread_mutex_destroy(l)
+#define lockAcquire(l)          pthread_mutex_lock(l)
+#define lockRelease(l)          pthread_mutex_unlock(l)
+#endif
+
+#define ALIGNMENT       16
+#define ALIGN(n)        (((n) + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1))
+#define HEADER_SIZE     ALIGN(sizeof(header))
+#define NUM_CLASSES     44                  /* 16..256 in steps of 16, then 4 classes per power of two up to 32 KiB */
+#define MAX_SMALL       32768
+#define LARGE           ((size_t)-1)        /* class of large blocks and system blocks */
+#define CHUNK_SIZE      (256 * 1024)
+#define BATCH_BYTES     (32 * 1024)         /* moved between a thread cache and the pool at once */
+
+typedef struct header {
+    struct omsalloc_pool *pool;             /* NULL for the system allocator */
+    size_t cls;                             /* size class, or LARGE */
+} header;
+
+typedef struct large {                      /* precedes the header of a large block of a pool */
+    struct large *prev;
+    struct large *next;
+    size_t size;
+} large;
+#define LARGE_SIZE      ALIGN(sizeof(large))
+
+typedef struct chunk {
+    struct chunk *next;
+} chunk;
+#define CHUNK_HEADER_SIZE ALIGN(sizeof(chunk))
+
+typedef struct cache {
+    struct cache *next;                     /* in the caches of the pool */
+    const void *thread;                     /* address of the memo of the owning thread */
+    void *free[NUM_CLASSES];                /* linked through their first word */
+    unsigned count[NUM_CLASSES];
+    unsigned long long allocations;         /* only written by the owning thread */
+    unsigned long long deallocations;
+    long long bytesInUse;                   /* may be negative, blocks are freed by other threads */
+} cache;
+
+struct omsalloc_pool {
+    omsalloc_allocator allocator;
+    long serial;
+    lock_t lock;                            /* guards everything below */
+    void *free[NUM_CLASSES];
+    unsigned count[NUM_CLASSES];
+    char *cursor;                           /* free part of the current chunk */
+    char *end;
+    chunk *chunks;
+    large *large;
+    cache *caches;
+    unsigned long long largeAllocations;
+    unsigned long long largeDeallocations;
+    unsigned long long largeBytesInUse;
+    unsigned long long bytesReserved;
+};
+
+typedef struct {
+    const omsalloc_pool *pool;
+    long serial;
+    cache *cache;
+} memo_t;
+
+static THREAD_LOCAL memo_t memo;
+
+static long nextSerial = 0;
+static THREAD_LOCAL const omsalloc_allocator *current = NULL;
+
+static size_t classSize(size_t cls)
+{
+    if (cls < 16)
+        return (cls + 1) * 16;
+    return ((cls - 16) % 4 + 5) << ((cls - 16) / 4 + 6);
+}
+
+static size_t sizeClass(size_t size)
+{
+    size_t bits = 8;
+    if (size <= 256)
+        return size == 0 ? 0 : (size - 1) / 16;
+    while (((size - 1) >> (bits + 1)) != 0)
+        bits++;
+    /* 2^bits < size <= 2^(bits+1), in quarters of 2^bits */
+    return 16 + (bits - 8) * 4 + (((size - 1) >> (bits - 2)) - 4);
+}
+
+/* Blocks moved at once, and twice that many kept by a thread cache */
+static unsigned batchSize(size_t cls)
+{
+    size_t n = BATCH_BYTES / classSize(cls);
+    return n < 4 ? 4 : n > 64 ? 64 : (unsigned)n;
+}
+
+static void *headerToPtr(header *h)
+{
+    return (char *)h + HEADER_SIZE;
+}
+
+static header *ptrToHeader(void *ptr)
+{
+    return (header *)((char *)ptr - HEADER_SIZE);
+}
+
+/* ----------------------------------------------------------------- system */
+
+static void *systemAllocate(void *context, size_t size)
+{
+    header *h;
+    (void)context;
+    if (size > (size_t)-1 - HEADER_SIZE)
+        return NULL;
+    h = (header *)malloc(HEADER_SIZE + size);
+    if (h == NULL)
+        return NULL;
+    h->pool = NULL;
+    h->cls = LARGE;
+    return headerToPtr(h);
+}
+
+static void *systemReallocate(void *context, void *ptr, size_t size)
+{
+    header *h;
+    (void)context;
+    if (ptr == NULL)
+        return systemAllocate(context, size);
+    if (size > (size_t)-1 - HEADER_SIZE)
+        return NULL;
+    h = (header *)realloc(ptrToHeader(ptr), HEADER_SIZE + size);
+    return h != NULL ? headerToPtr(h) : NULL;
+}
+
+static void deallocate(void *context, void *ptr)
+{
+    (void)context;
+    omsalloc_free(ptr);
+}
+
+static const omsalloc_allocator systemAllocator = { systemAllocate, systemReallocate, deallocate, NULL };
+
+const omsalloc_allocator *omsalloc_system(void)
+{
+    return &systemAllocator;
+}
+
+/* ------------------------------------------------------------------- pool */
+
+static void *poolAllocate(void *context, size_t size);
+static void *poolReallocate(void *context, void *ptr, size_t size);
+
+omsalloc_pool *omsalloc_pool_create(void)
+{
+    omsalloc_pool *pool = (omsalloc_pool *)calloc(1, sizeof(omsalloc_pool));
+    if (pool == NULL)
+        return NULL;
+    pool->allocator.allocate = poolAllocate;
+    pool->allocator.reallocate = poolReallocate;
+    pool->allocator.deallocate = deallocate;
+    pool->allocator.context = pool;
+    pool->serial = FETCH_ADD(&nextSerial, 1) + 1;
+    lockInit(&pool->lock);
+    return pool;
+}
+
+void omsalloc_pool_destroy(omsalloc_pool *pool)
+{
+    if (pool == NULL)
+        return;
+    while (pool->chunks != NULL) {
+        chunk *next = pool->chunks->next;
+        free(pool->chunks);
+        pool->chunks = next;
+    }
+    while (pool->large != NULL) {
+        large *next = pool->large->next;
+        free(pool->large);
+        pool->large = next;
+    }
+    while (pool->caches != NULL) {
+        cache *next = pool->caches->next;
+        free(pool->caches);
+        pool->caches = next;
+    }
+    if (memo.pool == pool)
+        memo.pool = NULL;
+    lockDestroy(&pool->lock);
+    free(pool);
+}
+
+/* The cache of the calling thread, NULL if out of memory */
+static cache *threadCache(omsalloc_pool *pool)
+{
+    cache *c;
+
+    if (memo.pool == pool && memo.serial == pool->serial)
+        return memo.cache;
+    lockAcquire(&pool->lock);
+    for (c = pool->caches; c != NULL && c->thread != (const void *)&memo; c = c->next)
+        ;
+    if (c == NULL) {
+        c = (cache *)calloc(1, sizeof(cache));
+        if (c != NULL) {
+            c->thread = &memo;
+            c->next = pool->caches;
+            pool->caches = c;
+        }
+    }
+    lockRelease(&pool->lock);
+    if (c != NULL) {
+        memo.pool = pool;
+        memo.serial = pool->serial;
+        memo.cache = c;
+    }
+    return c;
+}
+
+/* Moves a batch of blocks of the class to the cache, from the free list of
+   the pool or carved from its chunks; returns false if out of memory */
+static int refill(omsalloc_pool *pool, cache *c, size_t cls)
+{
+    const size_t blockSize = HEADER_SIZE + classSize(cls);
+    unsigned n = batchSize(cls);
+
+    lockAcquire(&pool->lock);
+    while (n > 0 && pool->free[cls] != NULL) {
+        void *block = pool->free[cls];
+        pool->free[cls] = *(void **)block;
+        pool->count[cls]--;
+        *(void **)block = c->free[cls];
+        c->free[cls] = block;
+        c->count[cls]++;
+        n--;
+    }
+    while (n > 0) {
+        header *h;
+        if ((size_t)(pool->end - pool->cursor) < blockSize) {
+            if (c->free[cls] != NULL)
+                break;
+            chunk *k = (chunk *)malloc(CHUNK_SIZE);
+            if (k == NULL)
+                break;
+            k->next = pool->chunks;
+            pool->chunks = k;
+            pool->bytesReserved += CHUNK_SIZE;
+            pool->cursor = (char *)k + CHUNK_HEADER_SIZE;
+            pool->end = (char *)k + CHUNK_SIZE;
+        }
+        h = (header *)pool->cursor;
+        pool->cursor += blockSize;
+        h->pool = pool;
+        h->cls = cls;
+        *(void **)headerToPtr(h) = c->free[cls];
+        c->free[cls] = headerToPtr(h);
+        c->count[cls]++;
+        n--;
+    }
+    lockRelease(&pool->lock);
+    return c->free[cls] != NULL;
+}
+
+/* Moves a batch of blocks of the class from the cache to the pool */
+static void flush(omsalloc_pool *pool, cache *c, size_t cls)
+{
+    unsigned n = batchSize(cls);
+
+    lockAcquire(&pool->lock);
+    while (n-- > 0 && c->free[cls] != NULL) {
+        void *block = c->free[cls];
+        c->free[cls] = *(void **)block;
+        c->count[cls]--;
+        *(void **)block = pool->free[cls];
+        pool->free[cls] = block;
+        pool->count[cls]++;
+    }
+    lockRelease(&pool->lock);
+}
+
+static void *allocateLarge(omsalloc_pool *pool, size_t size)
+{
+    large *l;
+    header *h;
+
+    if (size > (size_t)-1 - LARGE_SIZE - HEADER_SIZE)
+        return NULL;
+    l = (large *)malloc(LARGE_SIZE + HEADER_SIZE + size);
+    if (l == NULL)
+        return NULL;
+    h = (header *)((char *)l + LARGE_SIZE);
+    h->pool = pool;
+    h->cls = LARGE;
+    l->size = size;
+    lockAcquire(&pool->lock);
+    l->prev = NULL;
+    l->next = pool->large;
+    if (pool->large != NULL)
+        pool->large->prev = l;
+    pool->large = l;
+    pool->largeAllocations++;
+    pool->largeBytesInUse += size;
+    pool->bytesReserved += LARGE_SIZE + HEADER_SIZE + size;
+    lockRelease(&pool->lock);
+    return headerToPtr(h);
+}
+
+static void freeLarge(omsalloc_pool *pool, header *h)
+{
+    large *l = (large *)((char *)h - LARGE_SIZE);
+
+    lockAcquire(&pool->lock);
+    if (l->prev != NULL)
+        l->prev->next = l->next;
+    else
+        pool->large = l->next;
+    if (l->next != NULL)
+        l->next->prev = l->prev;
+    pool->largeDeallocations++;
+    pool->largeBytesInUse -= l->size;
+    pool->bytesReserved -= LARGE_SIZE + HEADER_SIZE + l->size;
+    lockRelease(&pool->lock);
+    free(l);
+}
+
+static void *poolAllocate(void *context, size_t size)
+{
+    omsalloc_pool *pool = (omsalloc_pool *)context;
+    size_t cls;
+    cache *c;
+    void *block;
+
+    if (size > MAX_SMALL)
+        return allocateLarge(pool, size);
+    cls = sizeClass(size);
+    c = threadCache(pool);
+    if (c == NULL || (c->free[cls] == NULL && !refill(pool, c, cls)))
+        return NULL;
+    block = c->free[cls];
+    c->free[cls] = *(void **)block;
+    c->count[cls]--;
+    c->allocations++;
+    c->bytesInUse += (long long)classSize(cls);
+    return block;
+}
+
+static void poolFree(omsalloc_pool *pool, header *h)
+{
+    void *block = headerToPtr(h);
+    cache *c;
+
+    if (h->cls == LARGE) {
+        freeLarge(pool, h);
+        return;
+    }
+    c = threadCache(pool);
+    if (c == NULL) {
+        /* out of memory for a cache, give the block back directly */
+        lockAcquire(&pool->lock);
+        *(void **)block = pool->free[h->cls];
+        pool->free[h->cls] = block;
+        pool->count[h->cls]++;
+        lockRelease(&pool->lock);
+        return;
+    }
+    *(void **)block = c->free[h->cls];
+    c->free[h->cls] = block;
+    c->deallocations++;
+    c->bytesInUse -= (long long)classSize(h->cls);
+    if (++c->count[h->cls] > 2 * batchSize(h->cls))
+        flush(pool, c, h->cls);
+}
+
+void omsalloc_free(void *ptr)
+{
+    header *h;
+
+    if (ptr == NULL)
+        return;
+    h = ptrToHeader(ptr);
+    if (h->pool == NULL)
+        free(h);
+    else
+        poolFree(h->pool, h);
+}
+
+/* Grows within the capacity of the block, otherwise moves it to a new block
+   of its own pool; shrinking never moves, so it never fails */
+static void *poolReallocate(void *context, void *ptr, size_t size)
+{
+    header *h;
+    size_t capacity;
+    void *moved;
+
+    if (ptr == NULL)
+        return poolAllocate(context, size);
+    h = ptrToHeader(ptr);
+    if (h->pool == NULL)
+        return systemReallocate(NULL, ptr, size);
+    capacity = h->cls == LARGE ? ((large *)((char *)h - LARGE_SIZE))->size : classSize(h->cls);
+    if (size <= capacity)
+        return ptr;
+    moved = poolAllocate(h->pool, size);
+    if (moved == NULL)
+        return NULL;
+    memcpy(moved, ptr, capacity);
+    poolFree(h->pool, h);
+    return moved;
+}
+
+const omsalloc_allocator *omsalloc_pool_allocator(omsalloc_pool *pool)
+{
+    return &pool->allocator;
+}
+
+void omsalloc_pool_stats(omsalloc_pool *pool, omsalloc_stats *stats)
+{
+    long long bytesInUse;
+    const cache *c;
+
+    lockAcquire(&pool->lock);
+    stats->allocations = pool->largeAllocations;
+    stats->deallocations = pool->largeDeallocations;
+    bytesInUse = (long long)pool->largeBytesInUse;
+    for (c = pool->caches; c != NULL; c = c->next) {
+        stats->allocations += c->allocations;
+        stats->deallocations += c->deallocations;
+        bytesInUse += c->bytesInUse;
+    }
+    stats->bytesInUse = bytesInUse > 0 ? (unsigned long long)bytesInUse : 0;
+    stats->bytesReserved = pool->bytesReserved;
+    lockRelease(&pool->lock);
+}
+
+/* --------------------------------------------------------------- adapters */
+
+void omsalloc_set_current(const omsalloc_allocator *allocator)
+{
+    current = allocator;
+}
+
+const omsalloc_allocator *omsalloc_current(void)
+{
+    return current != NULL ? current : &systemAllocator;
+}
+
+void *omsalloc_lua_alloc(void *allocator, void *ptr, size_t osize, size_t nsize)
+{
+    const omsalloc_allocator *a = (const omsalloc_allocator *)allocator;
+    (void)osize;
+    if (nsize == 0) {
+        a->deallocate(a->context, ptr);
+        return NULL;
+    }
+    return a->reallocate(a->context, ptr, nsize);
+}
+
+void *omsalloc_zalloc(void *allocator, unsigned items, unsigned size)
+{
+    const omsalloc_allocator *a = (const omsalloc_allocator *)allocator;
+    if (size != 0 && items > (size_t)-1 / size)
+        return NULL;
+    return a->allocate(a->context, (size_t)items * size);
+}
+
+void omsalloc_zfree(void *allocator, void *address)
+{
+    const omsalloc_allocator *a = (const omsalloc_allocator *)allocator;
+    a->deallocate(a->context, address);
+}
+
+void *omsalloc_pugixml_allocate(size_t size)
+{
+    const omsalloc_allocator *a = omsalloc_current();
+    return a->allocate(a->context, size);
+}
+
+void omsalloc_pugixml_deallocate(void *ptr)
+{
+    const omsalloc_allocator *a = omsalloc_current();
+    a->deallocate(a->context, ptr);
+}
@@ -0,0 +1,89 @@
+/* omsalloc.h -- one allocator for the 3rd-party components
+ *
+ * omsalloc_allocator is the allocation interface shared by the adapters
+ * below, which plug it into the allocation hooks of the components: the
+ * lua_Alloc of Lua, the zalloc/zfree of zlib streams, the memory management
+ * functions of pugixml, the MemoryManager of xerces (omsalloc_xerces.hpp)
+ * and fmi4c_setAllocator() of fmi4c.
+ *
+ * omsalloc_pool is its implementation for jobs: small blocks are served from
+ * per-thread caches of size-segregated free lists, refilled in batches from
+ * chunks shared by all threads under a lock, and the whole pool, including
+ * what was not freed, is released at once by omsalloc_pool_destroy(). The
+ * statistics of a pool cover all the components allocating from it.
+ *
+ * All memory of the omsalloc allocators, the system allocator included,
+ * records where it came from, so omsalloc_free() frees memory of any of
+ * them, whichever allocator or thread it is called with.
+ */
+
+#ifndef OMSALLOC_H
+#define OMSALLOC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct omsalloc_allocator {
+    void *(*allocate)(void *context, size_t size);
+    void *(*reallocate)(void *context, void *ptr, size_t size);   /* ptr NULL allocates */
+    void (*deallocate)(void *context, void *ptr);               /* ptr may be NULL */
+    void *context;
+} omsalloc_allocator;
+
+typedef struct omsalloc_stats {
+    unsigned long long allocations;     /* blocks allocated, moving reallocations included */
+    unsigned long long deallocations;
+    unsigned long long bytesInUse;      /* of the blocks in use, rounded up to their size class */
+    unsigned long long bytesReserved;   /* taken from the system, chunks and large blocks */
+} omsalloc_stats;
+
+/* malloc() and free(), with the header that omsalloc_free() needs */
+const omsalloc_allocator *omsalloc_system(void);
+
+/* Frees memory of any omsalloc allocator, NULL is ignored */
+void omsalloc_free(void *ptr);
+
+typedef struct omsalloc_pool omsalloc_pool;
+
+/* A new pool, NULL if out of memory */
+omsalloc_pool *omsalloc_pool_create(void);
+/* Releases all memory of the pool, which must no longer be used by any thread */
+void omsalloc_pool_destroy(omsalloc_pool *pool);
+/* The allocator of the pool, valid until it is destroyed */
+const omsalloc_allocator *omsalloc_pool_allocator(omsalloc_pool *pool);
+/* Statistics of the pool, exact when no thread is allocating from it */
+void omsalloc_pool_stats(omsalloc_pool *pool, omsalloc_stats *stats);
+
+/* The allocator of the calling thread for the adapters without a context,
+   NULL restores omsalloc_system() */
+void omsalloc_set_current(const omsalloc_allocator *allocator);
+const omsalloc_allocator *omsalloc_current(void);
+
+/* Adapters. Lua: lua_newstate(omsalloc_lua_alloc, allocator) */
+void *omsalloc_lua_alloc(void *allocator, void *ptr, size_t osize, size_t nsize);
+
+/* zlib: stream.zalloc = omsalloc_zalloc, stream.zfree = omsalloc_zfree,
+   stream.opaque = allocator */
+void *omsalloc_zalloc(void *allocator, unsigned items, unsigned size);
+void omsalloc_zfree(void *allocator, void *address);
+
+/* pugixml: pugi::set_memory_management_functions(omsalloc_pugixml_allocate,
+   omsalloc_pugixml_deallocate), before any document is created. Allocates
+   from the current allocator of the calling thread; frees with it, which
+   for omsalloc's own allocators works whichever of them is current. */
+void *omsalloc_pugixml_allocate(size_t size);
+void omsalloc_pugixml_deallocate(void *ptr);
+
+/* fmi4c: fmi4cAllocator has the members of omsalloc_allocator, so
+     fmi4cAllocator a = { al->allocate, al->reallocate, al->deallocate, al->context };
+     fmi4c_setAllocator(&a);
+   while no memory of fmi4c is in use. */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OMSALLOC_H */
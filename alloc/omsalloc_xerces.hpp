@@ -0,0 +1,46 @@
+/* omsalloc_xerces.hpp -- xerces MemoryManager on an omsalloc allocator
+ *
+ * Pass it to a parser, e.g. XMLReaderFactory::createXMLReader(&manager) or
+ * new XercesDOMParser(0, &manager), or to XMLPlatformUtils::Initialize() for
+ * all of xerces. Exceptions are allocated by the memory manager of xerces,
+ * since they may outlive a pool.
+ */
+
+#ifndef OMSALLOC_XERCES_HPP
+#define OMSALLOC_XERCES_HPP
+
+#include "omsalloc.h"
+
+#include <xercesc/framework/MemoryManager.hpp>
+#include <xercesc/util/OutOfMemoryException.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+
+namespace omsalloc {
+    class XercesMemoryManager : public XERCES_CPP_NAMESPACE::MemoryManager {
+    public:
+        explicit XercesMemoryManager(const omsalloc_allocator *allocator) : allocator(allocator) {}
+
+        XERCES_CPP_NAMESPACE::MemoryManager *getExceptionMemoryManager() {
+            return XERCES_CPP_NAMESPACE::XMLPlatformUtils::fgMemoryManager;
+        }
+
+        void *allocate(XMLSize_t size) {
+            void *p = this->allocator->allocate(this->allocator->context, size);
+            if (p == NULL)
+                throw XERCES_CPP_NAMESPACE::OutOfMemoryException();
+            return p;
+        }
+
+        void deallocate(void *p) {
+            this->allocator->deallocate(this->allocator->context, p);
+        }
+
+    private:
+        XercesMemoryManager(const XercesMemoryManager &);  // = delete;
+        XercesMemoryManager & operator=(const XercesMemoryManager &);  // = delete;
+
+        const omsalloc_allocator *allocator;
+    };
+}
+
+#endif /* OMSALLOC_XERCES_HPP */
@@ -0,0 +1,708 @@
+/*
+ * ssp_benchmark.cpp
+ * End-to-end benchmark of importing an SSP with the 3rd-party components.
+ *
+ * usage: ssp_benchmark [-f fmus] [-v variables] [-c connections] [-b binary-kb]
+ *                      [-r reps] [-t threads] [-a allocator] [-w workdir] [-o result.json]
+ *
+ *   -f  FMUs (components) in the SSP, default 50
+ *   -v  variables per FMU, default 1000
+ *   -c  connections between the components, default 2 per FMU
+ *   -b  size of the dummy shared library in each FMU in KiB, default 256
+ *   -r  repetitions of the import, the median time is reported, default 3
+ *   -t  threads extracting the SSP, <= 0 for one per processor, default 1
+ *   -a  allocator of the import: system (default), or pool for an omsalloc
+ *       pool per import that xerces, pugixml and fmi4c allocate from
+ *   -w  work directory, default ssp_benchmark.tmp
+ *   -o  also write the results as JSON to this file
+ *
+ * A synthetic SSP is generated first: FMI 2.0 co-simulation FMUs with the
+ * given number of variables, and a SystemStructure.ssd instantiating one
+ * component per FMU, chained by the connections. The import then runs the
+ * stages an importer goes through, each timed on its own:
+ *
+ *   extract   the SSP into a directory (minizip, miniunz_extract_parallel)
+ *   validate  SystemStructure.ssd against its schema (xerces, SAX2)
+ *   parse     SystemStructure.ssd and resolve the connections (pugixml)
+ *   load      every FMU: extraction and modelDescription.xml (fmi4c)
+ *
+ * The SSP schemas are not part of this repository, so a schema for the
+ * subset of the SSD that is generated is written to the work directory.
+ *
+ * For each stage the growth of the resident set size while it runs, with
+ * its results still held, is reported (Linux and Windows), and at the end
+ * the peak resident set size of the process. With the pool, its allocation
+ * statistics at the end of the import, before it is released, are reported.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#include "zip.h"
+#include "unzip.h"
+#include "miniunz.h"
+
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUni.hpp>
+
+#include "pugixml.hpp"
+
+#include "fmi4c.h"
+
+#include "omsalloc.h"
+#include "omsalloc_xerces.hpp"
+
+namespace fs = std::filesystem;
+
+XERCES_CPP_NAMESPACE_USE
+
+namespace
+{
+    const char* const SSD_NAMESPACE = "http://ssp-standard.org/SSP1/SystemStructureDescription";
+    const char* const SSC_NAMESPACE = "http://ssp-standard.org/SSP1/SystemStructureCommon";
+
+    enum Stage { Extract, Validate, Parse, Load, NumberOfStages };
+    const char* const stageNames[NumberOfStages] = { "extract", "validate", "parse", "load" };
+
+    struct Options
+    {
+        int fmus = 50;
+        int variables = 1000;
+        int connections = -1;
+        int binaryKiB = 256;
+        int repetitions = 3;
+        int threads = 1;
+        bool pool = false;
+        std::string workdir = "ssp_benchmark.tmp";
+        const char* output = nullptr;
+    };
+
+    struct StageResult
+    {
+        std::vector<double> seconds;
+        double rssGrowth = 0;       // largest of the repetitions [bytes], negative if not measured
+    };
+
+    double now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Resident set size of the process [bytes], negative where it is not available
+    double currentRss()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+            return -1;
+        return (double)pmc.WorkingSetSize;
+#elif defined(__linux__)
+        FILE* file = fopen("/proc/self/statm", "r");
+        long pages = 0, resident = 0;
+        if (!file)
+            return -1;
+        int n = fscanf(file, "%ld %ld", &pages, &resident);
+        fclose(file);
+        return n == 2 ? (double)resident * (double)sysconf(_SC_PAGESIZE) : -1;
+#else
+        return -1;
+#endif
+    }
+
+    // Peak resident set size of the process so far [bytes]
+    double peakRss()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+            return -1;
+        return (double)pmc.PeakWorkingSetSize;
+#else
+        struct rusage ru;
+        if (getrusage(RUSAGE_SELF, &ru) != 0)
+            return -1;
+#ifdef __APPLE__
+        return (double)ru.ru_maxrss;            // bytes
+#else
+        return (double)ru.ru_maxrss * 1024;     // kilobytes
+#endif
+#endif
+    }
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        size_t n = values.size();
+        return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+    }
+
+    // Connectors per direction of each component, so that every connection has its own end connector
+    int connectorsPerComponent(const Options& options)
+    {
+        return std::max(1, (options.connections + options.fmus - 1) / options.fmus);
+    }
+
+    // FMI 2.0 co-simulation model description, the inputs u* and outputs y* first
+    std::string generateModelDescription(int index, int variables, int connectors)
+    {
+        std::string result;
+        std::string outputs;
+        char buffer[512];
+
+        snprintf(buffer, sizeof(buffer),
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<fmiModelDescription fmiVersion=\"2.0\" modelName=\"Benchmark.C%d\" guid=\"{8c4e810f-3df3-4a00-8276-%012d}\" "
+            "generationTool=\"ssp_benchmark\" variableNamingConvention=\"structured\" numberOfEventIndicators=\"0\">\n"
+            "  <CoSimulation modelIdentifier=\"C%d\" canHandleVariableCommunicationStepSize=\"true\"/>\n"
+            "  <DefaultExperiment startTime=\"0.0\" stopTime=\"1.0\"/>\n"
+            "  <ModelVariables>\n", index, index, index);
+        result += buffer;
+
+        for (int i = 0; i < variables; ++i)
+        {
+            if (i < connectors)
+                snprintf(buffer, sizeof(buffer),
+                    "    <ScalarVariable name=\"u%d\" valueReference=\"%d\" causality=\"input\" variability=\"continuous\">\n"
+                    "      <Real start=\"0\"/>\n", i, i);
+            else if (i < 2 * connectors)
+                snprintf(buffer, sizeof(buffer),
+                    "    <ScalarVariable name=\"y%d\" valueReference=\"%d\" causality=\"output\" variability=\"continuous\" initial=\"calculated\">\n"
+                    "      <Real/>\n", i - connectors, i);
+            else if (i % 4 == 0)
+                snprintf(buffer, sizeof(buffer),
+                    "    <ScalarVariable name=\"p[%d]\" valueReference=\"%d\" causality=\"parameter\" variability=\"fixed\" description=\"Parameter %d\">\n"
+                    "      <Real unit=\"m\" start=\"%.17g\"/>\n", i, i, i, 0.1 * i + 1e-3);
+            else
+                snprintf(buffer, sizeof(buffer),
+                    "    <ScalarVariable name=\"body%d.x[%d]\" valueReference=\"%d\" causality=\"local\" variability=\"continuous\" description=\"Position %d\">\n"
+                    "      <Real unit=\"m\"/>\n", i / 16, i % 16, i, i);
+            result += buffer;
+            result += "    </ScalarVariable>\n";
+
+            if (i >= connectors && i < 2 * connectors)
+            {
+                snprintf(buffer, sizeof(buffer), "      <Unknown index=\"%d\"/>\n", i + 1);
+                outputs += buffer;
+            }
+        }
+
+        result += "  </ModelVariables>\n  <ModelStructure>\n    <Outputs>\n";
+        result += outputs;
+        result += "    </Outputs>\n  </ModelStructure>\n</fmiModelDescription>\n";
+        return result;
+    }
+
+    // SystemStructure.ssd with one component per FMU, connection i from C(i mod n) to C(i+1 mod n)
+    std::string generateSystemStructure(const Options& options)
+    {
+        const int connectors = connectorsPerComponent(options);
+        std::string result = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<ssd:SystemStructureDescription xmlns:ssc=\"http://ssp-standard.org/SSP1/SystemStructureCommon\" "
+            "xmlns:ssd=\"http://ssp-standard.org/SSP1/SystemStructureDescription\" name=\"benchmark\" version=\"1.0\">\n"
+            "  <ssd:System name=\"root\">\n    <ssd:Elements>\n";
+        char buffer[512];
+
+        for (int i = 0; i < options.fmus; ++i)
+        {
+            snprintf(buffer, sizeof(buffer),
+                "      <ssd:Component name=\"C%d\" type=\"application/x-fmu-sharedlibrary\" source=\"resources/C%d.fmu\">\n"
+                "        <ssd:Connectors>\n", i, i);
+            result += buffer;
+            for (int c = 0; c < 2 * connectors; ++c)
+            {
+                snprintf(buffer, sizeof(buffer),
+                    "          <ssd:Connector name=\"%s%d\" kind=\"%s\">\n"
+                    "            <ssc:Real unit=\"m\"/>\n"
+                    "            <ssd:ConnectorGeometry x=\"%d\" y=\"%.6f\"/>\n"
+                    "          </ssd:Connector>\n",
+                    c < connectors ? "u" : "y", c % connectors, c < connectors ? "input" : "output",
+                    c < connectors ? 0 : 1, (double)(c % connectors) / connectors);
+                result += buffer;
+            }
+            snprintf(buffer, sizeof(buffer),
+                "        </ssd:Connectors>\n"
+                "        <ssd:ElementGeometry x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\"/>\n"
+                "      </ssd:Component>\n", i * 20, i * 10, i * 20 + 10, i * 10 + 10);
+            result += buffer;
+        }
+
+        result += "    </ssd:Elements>\n    <ssd:Connections>\n";
+        for (int i = 0; i < options.connections; ++i)
+        {
+            snprintf(buffer, sizeof(buffer),
+                "      <ssd:Connection startElement=\"C%d\" startConnector=\"y%d\" endElement=\"C%d\" endConnector=\"u%d\"/>\n",
+                i % options.fmus, i / options.fmus, (i + 1) % options.fmus, i / options.fmus);
+            result += buffer;
+        }
+        result += "    </ssd:Connections>\n  </ssd:System>\n"
+            "  <ssd:DefaultExperiment startTime=\"0\" stopTime=\"1\"/>\n"
+            "</ssd:SystemStructureDescription>\n";
+        return result;
+    }
+
+    // Schemas of the generated subset of SystemStructureCommon and SystemStructureDescription
+    const char* const commonSchema =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<xs:schema xmlns:xs=\"http://www.w3.org/2001/XMLSchema\" targetNamespace=\"http://ssp-standard.org/SSP1/SystemStructureCommon\" elementFormDefault=\"qualified\">\n"
+        "  <xs:element name=\"Real\">\n"
+        "    <xs:complexType><xs:attribute name=\"unit\" type=\"xs:string\"/></xs:complexType>\n"
+        "  </xs:element>\n"
+        "</xs:schema>\n";
+
+    const char* const descriptionSchema =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<xs:schema xmlns:xs=\"http://www.w3.org/2001/XMLSchema\" xmlns:ssd=\"http://ssp-standard.org/SSP1/SystemStructureDescription\"\n"
+        "           xmlns:ssc=\"http://ssp-standard.org/SSP1/SystemStructureCommon\" targetNamespace=\"http://ssp-standard.org/SSP1/SystemStructureDescription\" elementFormDefault=\"qualified\">\n"
+        "  <xs:import namespace=\"http://ssp-standard.org/SSP1/SystemStructureCommon\" schemaLocation=\"SystemStructureCommon.xsd\"/>\n"
+        "  <xs:element name=\"SystemStructureDescription\">\n"
+        "    <xs:complexType>\n"
+        "      <xs:sequence>\n"
+        "        <xs:element name=\"System\" type=\"ssd:TSystem\"/>\n"
+        "        <xs:element name=\"DefaultExperiment\" minOccurs=\"0\">\n"
+        "          <xs:complexType>\n"
+        "            <xs:attribute name=\"startTime\" type=\"xs:double\"/>\n"
+        "            <xs:attribute name=\"stopTime\" type=\"xs:double\"/>\n"
+        "          </xs:complexType>\n"
+        "        </xs:element>\n"
+        "      </xs:sequence>\n"
+        "      <xs:attribute name=\"name\" type=\"xs:string\" use=\"required\"/>\n"
+        "      <xs:attribute name=\"version\" type=\"xs:string\" use=\"required\"/>\n"
+        "    </xs:complexType>\n"
+        "  </xs:element>\n"
+        "  <xs:complexType name=\"TSystem\">\n"
+        "    <xs:sequence>\n"
+        "      <xs:element name=\"Elements\" minOccurs=\"0\">\n"
+        "        <xs:complexType><xs:sequence>\n"
+        "          <xs:element name=\"Component\" type=\"ssd:TComponent\" minOccurs=\"0\" maxOccurs=\"unbounded\"/>\n"
+        "        </xs:sequence></xs:complexType>\n"
+        "      </xs:element>\n"
+        "      <xs:element name=\"Connections\" minOccurs=\"0\">\n"
+        "        <xs:complexType><xs:sequence>\n"
+        "          <xs:element name=\"Connection\" minOccurs=\"0\" maxOccurs=\"unbounded\">\n"
+        "            <xs:complexType>\n"
+        "              <xs:attribute name=\"startElement\" type=\"xs:string\"/>\n"
+        "              <xs:attribute name=\"startConnector\" type=\"xs:string\" use=\"required\"/>\n"
+        "              <xs:attribute name=\"endElement\" type=\"xs:string\"/>\n"
+        "              <xs:attribute name=\"endConnector\" type=\"xs:string\" use=\"required\"/>\n"
+        "            </xs:complexType>\n"
+        "          </xs:element>\n"
+        "        </xs:sequence></xs:complexType>\n"
+        "      </xs:element>\n"
+        "    </xs:sequence>\n"
+        "    <xs:attribute name=\"name\" type=\"xs:string\" use=\"required\"/>\n"
+        "  </xs:complexType>\n"
+        "  <xs:complexType name=\"TComponent\">\n"
+        "    <xs:sequence>\n"
+        "      <xs:element name=\"Connectors\" minOccurs=\"0\">\n"
+        "        <xs:complexType><xs:sequence>\n"
+        "          <xs:element name=\"Connector\" minOccurs=\"0\" maxOccurs=\"unbounded\">\n"
+        "            <xs:complexType>\n"
+        "              <xs:sequence>\n"
+        "                <xs:element ref=\"ssc:Real\" minOccurs=\"0\"/>\n"
+        "                <xs:element name=\"ConnectorGeometry\" minOccurs=\"0\">\n"
+        "                  <xs:complexType>\n"
+        "                    <xs:attribute name=\"x\" type=\"xs:double\" use=\"required\"/>\n"
+        "                    <xs:attribute name=\"y\" type=\"xs:double\" use=\"required\"/>\n"
+        "                  </xs:complexType>\n"
+        "                </xs:element>\n"
+        "              </xs:sequence>\n"
+        "              <xs:attribute name=\"name\" type=\"xs:string\" use=\"required\"/>\n"
+        "              <xs:attribute name=\"kind\" use=\"required\">\n"
+        "                <xs:simpleType>\n"
+        "                  <xs:restriction base=\"xs:string\">\n"
+        "                    <xs:enumeration value=\"input\"/><xs:enumeration value=\"output\"/><xs:enumeration value=\"inout\"/>\n"
+        "                    <xs:enumeration value=\"parameter\"/><xs:enumeration value=\"calculatedParameter\"/>\n"
+        "                  </xs:restriction>\n"
+        "                </xs:simpleType>\n"
+        "              </xs:attribute>\n"
+        "            </xs:complexType>\n"
+        "          </xs:element>\n"
+        "        </xs:sequence></xs:complexType>\n"
+        "      </xs:element>\n"
+        "      <xs:element name=\"ElementGeometry\" minOccurs=\"0\">\n"
+        "        <xs:complexType>\n"
+        "          <xs:attribute name=\"x1\" type=\"xs:double\"/><xs:attribute name=\"y1\" type=\"xs:double\"/>\n"
+        "          <xs:attribute name=\"x2\" type=\"xs:double\"/><xs:attribute name=\"y2\" type=\"xs:double\"/>\n"
+        "        </xs:complexType>\n"
+        "      </xs:element>\n"
+        "    </xs:sequence>\n"
+        "    <xs:attribute name=\"name\" type=\"xs:string\" use=\"required\"/>\n"
+        "    <xs:attribute name=\"type\" type=\"xs:string\"/>\n"
+        "    <xs:attribute name=\"source\" type=\"xs:anyURI\" use=\"required\"/>\n"
+        "  </xs:complexType>\n"
+        "</xs:schema>\n";
+
+    bool writeFile(const fs::path& path, const std::string& contents)
+    {
+        FILE* file = fopen(path.string().c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    bool addToZip(zipFile zf, const char* name, const std::string& contents)
+    {
+        zip_fileinfo info;
+        memset(&info, 0, sizeof(info));
+        if (zipOpenNewFileInZip64(zf, name, &info, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION, contents.size() >= 0xffffffff) != ZIP_OK)
+            return false;
+        bool ok = zipWriteInFileInZip(zf, contents.data(), (unsigned)contents.size()) == ZIP_OK;
+        return zipCloseFileInZip(zf) == ZIP_OK && ok;
+    }
+
+    // Stand-in for the shared library of an FMU, compressible about as well as machine code
+    std::string generateBinary(int index, int kib)
+    {
+        std::string result((size_t)kib * 1024, '\0');
+        unsigned state = 2463534242u + (unsigned)index;
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+            result[i] = (char)(i % 4 == 3 ? state : state & 0x0f);
+        }
+        return result;
+    }
+
+    // Writes model.ssp and the schemas to the work directory
+    bool generate(const Options& options, const fs::path& workdir)
+    {
+        const int connectors = connectorsPerComponent(options);
+        const int variables = std::max(options.variables, 2 * connectors);
+        fs::path fmuPath = workdir / "fmu.tmp";
+        char name[64];
+
+        if (!writeFile(workdir / "SystemStructureCommon.xsd", commonSchema) ||
+            !writeFile(workdir / "SystemStructureDescription.xsd", descriptionSchema))
+            return false;
+
+        zipFile ssp = zipOpen64((workdir / "model.ssp").string().c_str(), APPEND_STATUS_CREATE);
+        if (!ssp)
+            return false;
+        bool ok = addToZip(ssp, "SystemStructure.ssd", generateSystemStructure(options));
+
+        for (int i = 0; ok && i < options.fmus; ++i)
+        {
+            zipFile fmu = zipOpen64(fmuPath.string().c_str(), APPEND_STATUS_CREATE);
+            ok = fmu != NULL;
+            if (ok)
+            {
+                ok = addToZip(fmu, "modelDescription.xml", generateModelDescription(i, variables, connectors));
+                snprintf(name, sizeof(name), "binaries/linux64/C%d.so", i);
+                ok = ok && addToZip(fmu, name, generateBinary(i, options.binaryKiB));
+                ok = zipClose(fmu, NULL) == ZIP_OK && ok;
+            }
+
+            // FMUs are stored in the SSP as they are, already compressed
+            FILE* file = ok ? fopen(fmuPath.string().c_str(), "rb") : NULL;
+            std::string contents;
+            char buffer[65536];
+            size_t size;
+            ok = file != NULL;
+            while (ok && (size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+                contents.append(buffer, size);
+            if (file)
+                fclose(file);
+            snprintf(name, sizeof(name), "resources/C%d.fmu", i);
+            ok = ok && addToZip(ssp, name, contents);
+        }
+
+        ok = zipClose(ssp, NULL) == ZIP_OK && ok;
+        fs::remove(fmuPath);
+        return ok;
+    }
+
+    class ErrorCounter : public DefaultHandler
+    {
+    public:
+        int errors = 0;
+
+        void error(const SAXParseException& e) override { report(e); }
+        void fatalError(const SAXParseException& e) override { report(e); }
+
+    private:
+        void report(const SAXParseException& e)
+        {
+            if (errors++ == 0)
+            {
+                char* message = XMLString::transcode(e.getMessage());
+                fprintf(stderr, "validate: line %llu: %s\n", (unsigned long long)e.getLineNumber(), message);
+                XMLString::release(&message);
+            }
+        }
+    };
+
+    // Validates the SSD against the generated schemas, returns the number of errors
+    int validate(const fs::path& ssd, const fs::path& workdir, MemoryManager* manager)
+    {
+        std::string locations = std::string(SSD_NAMESPACE) + " " + (workdir / "SystemStructureDescription.xsd").string() +
+            " " + SSC_NAMESPACE + " " + (workdir / "SystemStructureCommon.xsd").string();
+        XMLCh* schemaLocation = XMLString::transcode(locations.c_str(), manager);
+        ErrorCounter handler;
+
+        SAX2XMLReader* reader = XMLReaderFactory::createXMLReader(manager);
+        reader->setFeature(XMLUni::fgSAX2CoreNameSpaces, true);
+        reader->setFeature(XMLUni::fgSAX2CoreValidation, true);
+        reader->setFeature(XMLUni::fgXercesDynamic, false);
+        reader->setFeature(XMLUni::fgXercesSchema, true);
+        reader->setProperty(XMLUni::fgXercesSchemaExternalSchemaLocation, schemaLocation);
+        reader->setContentHandler(&handler);
+        reader->setErrorHandler(&handler);
+        reader->parse(ssd.string().c_str());
+        delete reader;
+
+        XMLString::release(&schemaLocation, manager);
+        return handler.errors;
+    }
+
+    struct Component
+    {
+        std::string name;
+        std::string source;
+    };
+
+    struct Connection
+    {
+        int startComponent;
+        int endComponent;
+        std::string startConnector;
+        std::string endConnector;
+    };
+
+    // Reads the components and connections of the SSD, returns false if a connection does not resolve
+    bool parse(const fs::path& ssd, pugi::xml_document& doc, std::vector<Component>& components, std::vector<Connection>& connections)
+    {
+        if (!doc.load_file(ssd.string().c_str()))
+            return false;
+
+        pugi::xml_node system = doc.child("ssd:SystemStructureDescription").child("ssd:System");
+        std::unordered_map<std::string, int> index;
+        for (pugi::xml_node node : system.child("ssd:Elements").children("ssd:Component"))
+        {
+            index[node.attribute("name").value()] = (int)components.size();
+            components.push_back(Component{ node.attribute("name").value(), node.attribute("source").value() });
+        }
+
+        for (pugi::xml_node node : system.child("ssd:Connections").children("ssd:Connection"))
+        {
+            auto start = index.find(node.attribute("startElement").value());
+            auto end = index.find(node.attribute("endElement").value());
+            if (start == index.end() || end == index.end())
+                return false;
+            connections.push_back(Connection{ start->second, end->second,
+                node.attribute("startConnector").value(), node.attribute("endConnector").value() });
+        }
+        return true;
+    }
+
+    // Runs the stages once in a fresh directory, adding the times to the results
+    bool import(const Options& options, const fs::path& workdir, const fs::path& rundir, StageResult* results, omsalloc_stats* stats)
+    {
+        const fs::path ssd = rundir / "SystemStructure.ssd";
+        omsalloc_pool* pool = options.pool ? omsalloc_pool_create() : NULL;
+        const omsalloc_allocator* allocator = pool ? omsalloc_pool_allocator(pool) : omsalloc_system();
+        omsalloc::XercesMemoryManager xercesManager(allocator);
+        MemoryManager* manager = pool ? &xercesManager : XMLPlatformUtils::fgMemoryManager;
+        if (pool)
+        {
+            const fmi4cAllocator fmi4cPool = { allocator->allocate, allocator->reallocate, allocator->deallocate, allocator->context };
+            fmi4c_setAllocator(&fmi4cPool);
+            omsalloc_set_current(allocator);
+        }
+
+        pugi::xml_document* doc = new pugi::xml_document();
+        std::vector<Component> components;
+        std::vector<Connection> connections;
+        std::vector<fmiHandle*> fmus;
+        double start, rss;
+        bool ok = true;
+
+        fs::remove_all(rundir);
+        fs::create_directories(rundir / "fmus");
+
+        for (int stage = 0; ok && stage < NumberOfStages; ++stage)
+        {
+            rss = currentRss();
+            start = now();
+            switch (stage)
+            {
+            case Extract:
+                ok = miniunz_extract_parallel((workdir / "model.ssp").string().c_str(), rundir.string().c_str(), options.threads, NULL) == UNZ_OK;
+                break;
+            case Validate:
+                ok = validate(ssd, workdir, manager) == 0;
+                break;
+            case Parse:
+                ok = parse(ssd, *doc, components, connections) &&
+                     (int)components.size() == options.fmus && (int)connections.size() == options.connections;
+                break;
+            case Load:
+            {
+                // fmi4c extracts an FMU into the directory named by its instance, below the working directory
+                fs::path cwd = fs::current_path();
+                fs::current_path(rundir / "fmus");
+                for (const Component& component : components)
+                {
+                    fmiHandle* fmu = fmi4c_loadFmu((rundir / component.source).string().c_str(), component.name.c_str());
+                    if (!fmu)
+                    {
+                        ok = false;
+                        break;
+                    }
+                    fmus.push_back(fmu);
+                }
+                fs::current_path(cwd);
+                break;
+            }
+            }
+            results[stage].seconds.push_back(now() - start);
+            if (rss >= 0 && results[stage].rssGrowth >= 0)
+                results[stage].rssGrowth = std::max(results[stage].rssGrowth, currentRss() - rss);
+            else
+                results[stage].rssGrowth = -1;
+            if (!ok)
+                fprintf(stderr, "ssp_benchmark: %s failed\n", stageNames[stage]);
+        }
+
+        for (fmiHandle* fmu : fmus)
+            fmi4c_freeFmu(fmu);
+        delete doc;
+        if (pool)
+        {
+            omsalloc_pool_stats(pool, stats);
+            omsalloc_set_current(NULL);
+            fmi4c_setAllocator(NULL);
+            omsalloc_pool_destroy(pool);
+        }
+        return ok;
+    }
+
+    int usage()
+    {
+        fprintf(stderr, "usage: ssp_benchmark [-f fmus] [-v variables] [-c connections] [-b binary-kb]\n"
+                        "                     [-r reps] [-t threads] [-a system|pool] [-w workdir] [-o result.json]\n");
+        return 1;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= argc)
+            return usage();
+        const char* value = argv[++i];
+        switch (argv[i - 1][1])
+        {
+        case 'f': options.fmus = atoi(value); break;
+        case 'v': options.variables = atoi(value); break;
+        case 'c': options.connections = atoi(value); break;
+        case 'b': options.binaryKiB = atoi(value); break;
+        case 'r': options.repetitions = atoi(value); break;
+        case 't': options.threads = atoi(value); break;
+        case 'a':
+            if (strcmp(value, "pool") != 0 && strcmp(value, "system") != 0)
+                return usage();
+            options.pool = strcmp(value, "pool") == 0;
+            break;
+        case 'w': options.workdir = value; break;
+        case 'o': options.output = value; break;
+        default: return usage();
+        }
+    }
+    if (options.connections < 0)
+        options.connections = 2 * options.fmus;
+    if (options.fmus < 1 || options.variables < 0 || options.binaryKiB < 0 || options.repetitions < 1)
+        return usage();
+
+    std::error_code error;
+    fs::create_directories(options.workdir, error);
+    const fs::path workdir = fs::absolute(options.workdir);
+
+    XMLPlatformUtils::Initialize();
+    // Before any document, pugixml then allocates from the current allocator of the thread
+    if (options.pool)
+        pugi::set_memory_management_functions(omsalloc_pugixml_allocate, omsalloc_pugixml_deallocate);
+
+    double start = now();
+    if (!generate(options, workdir))
+    {
+        fprintf(stderr, "ssp_benchmark: can not generate the SSP in %s\n", workdir.string().c_str());
+        return 1;
+    }
+    const double generateTime = now() - start;
+
+    StageResult results[NumberOfStages];
+    omsalloc_stats stats = { 0, 0, 0, 0 };
+    bool ok = true;
+    for (int r = 0; ok && r < options.repetitions; ++r)
+        ok = import(options, workdir, workdir / "run", results, &stats);
+
+    XMLPlatformUtils::Terminate();
+    if (!ok)
+        return 1;
+
+    printf("%d FMUs, %d variables each, %d connections, %.1f MB SSP, generated in %.1f s\n\n",
+           options.fmus, std::max(options.variables, 2 * connectorsPerComponent(options)), options.connections,
+           (double)fs::file_size(workdir / "model.ssp") / 1e6, generateTime);
+    printf("stage          ms (median)   RSS growth MB\n");
+    double total = 0;
+    for (int stage = 0; stage < NumberOfStages; ++stage)
+    {
+        double t = median(results[stage].seconds);
+        total += t;
+        if (results[stage].rssGrowth >= 0)
+            printf("%-10s %15.2f %15.1f\n", stageNames[stage], t * 1e3, results[stage].rssGrowth / 1e6);
+        else
+            printf("%-10s %15.2f %15s\n", stageNames[stage], t * 1e3, "-");
+    }
+    printf("%-10s %15.2f\n\npeak RSS MB %14.1f\n", "total", total * 1e3, peakRss() / 1e6);
+    if (options.pool)
+        printf("pool: %llu allocations, %llu deallocations, %.1f MB in use and %.1f MB reserved at the release\n",
+               stats.allocations, stats.deallocations, (double)stats.bytesInUse / 1e6, (double)stats.bytesReserved / 1e6);
+
+    if (options.output)
+    {
+        FILE* file = fopen(options.output, "w");
+        if (!file)
+        {
+            fprintf(stderr, "ssp_benchmark: can not write %s\n", options.output);
+            return 1;
+        }
+        fprintf(file, "{\n  \"fmus\": %d,\n  \"variables\": %d,\n  \"connections\": %d,\n  \"repetitions\": %d,\n  \"allocator\": \"%s\",\n  \"stages\": {\n",
+                options.fmus, options.variables, options.connections, options.repetitions, options.pool ? "pool" : "system");
+        for (int stage = 0; stage < NumberOfStages; ++stage)
+            fprintf(file, "    \"%s\": { \"seconds\": %.6g, \"rssGrowthBytes\": %.0f }%s\n", stageNames[stage],
+                    median(results[stage].seconds), results[stage].rssGrowth, stage + 1 < NumberOfStages ? "," : "");
+        fprintf(file, "  },\n  \"totalSeconds\": %.6g,\n  \"peakRssBytes\": %.0f\n}\n", total, peakRss());
+        fclose(file);
+    }
+    return 0;
+}
@@ -37,6 +37,15 @@
 #include <sys/stat.h>
 #include "ezxml.h"
 
+// MODIFICATION: Allocate through fmi4c, which passes its own buffers to ezxml_parse_mem()
+// and may use another allocator, see fmi4c_setAllocator()
+#include "fmi4c_memory.h"
+#define malloc(size) fmi4cMalloc(size)
+#define calloc(count, size) fmi4cCalloc(count, size)
+#define realloc(ptr, size) fmi4cRealloc(ptr, size)
+#define free(ptr) fmi4cFree(ptr)
+#define strdup(str) fmi4cStrdup(str)
+
 #define EZXML_WS   "\t\r\n "  // whitespace
 #define EZXML_ERRL 128        // maximum error string length
 
@@ -622,6 +631,18 @@ ezxml_t ezxml_parse_fp(FILE *fp)
     return &root->xml;
 }
 
+// Same as ezxml_parse_str(), but takes ownership of the malloc'ed buffer s,
+// which is released by ezxml_free(). Returns NULL on failure.
+ezxml_t ezxml_parse_mem(char *s, size_t len)
+{
+    ezxml_root_t root;
+
+    if (! s) return NULL;
+    root = (ezxml_root_t)ezxml_parse_str(s, len);
+    root->len = -1; // so we know to free s in ezxml_free()
+    return &root->xml;
+}
+
 // A wrapper for ezxml_parse_str() that accepts a file descriptor. First
 // attempts to mem map the file. Failing that, reads the file into memory.
 // Returns NULL on failure.
@@ -59,6 +59,10 @@ struct ezxml {
 // pass in the copy. Returns NULL on failure.
 ezxml_t ezxml_parse_str(char *s, size_t len);
 
+// Same as ezxml_parse_str(), but takes ownership of the malloc'ed buffer s,
+// which is released by ezxml_free(). Returns NULL on failure.
+ezxml_t ezxml_parse_mem(char *s, size_t len);
+
 // A wrapper for ezxml_parse_str() that accepts a file descriptor. First
 // attempts to mem map the file. Failing that, reads the file into memory.
 // Returns NULL on failure.
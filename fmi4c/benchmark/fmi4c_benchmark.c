@@ -0,0 +1,528 @@
+//! @file fmi4c_benchmark.c
+//! @brief Measures load, variable lookup, get/set and doStep throughput of fmi4c for a set of FMUs
+//!
+//! Usage: fmi4c_benchmark [options] fmu1.fmu [fmu2.fmu ...]
+//!   -o <file>         Output file for results (JSON), default fmi4c_benchmark.json
+//!   -r <count>        Number of load repetitions, the median is reported (default 5)
+//!   -s <count>        Number of doStep calls (default 1000)
+//!   -h <size>         Communication step size (default from the FMU, otherwise 0.001)
+//!   -v <n1,n2,...>    Value reference counts for get/set latency (default 1,10,100,1000)
+//!   -c <directory>    Load through the shared extraction cache in this directory
+//!
+//! Co-simulation FMUs for FMI 2 and 3 are instantiated, other FMUs are only loaded.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "fmi4c.h"
+
+#define MAX_VR_COUNTS 16
+#define MIN_LOOKUPS 200000
+#define MIN_VALUES_TRANSFERRED 1000000
+
+typedef struct {
+    const char *output;
+    int repetitions;
+    int steps;
+    double stepSize;
+    int vrCounts[MAX_VR_COUNTS];
+    int numberOfVrCounts;
+    const char *cacheDirectory;
+} options_t;
+
+typedef struct {
+    int numberOfValueReferences;
+    double getTime;         // Seconds per call, negative if not measured
+    double setTime;
+} getSetResult_t;
+
+typedef struct {
+    const char *fmu;
+    fmiVersion_t version;
+    bool loaded;
+    int numberOfVariables;
+    double loadTime;
+    double parseTime;
+    double unzipTime;
+    bool instantiated;
+    double libraryLoadTime;
+    double instantiateTime;
+    double lookupsByNamePerSecond;
+    double lookupsByValueReferencePerSecond;
+    getSetResult_t getSet[MAX_VR_COUNTS];
+    int numberOfGetSetResults;
+    int steps;
+    double stepsPerSecond;
+} result_t;
+
+
+//! @brief Returns monotonic wall clock time
+//! @returns Time in seconds
+static double getTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart/(double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec+(double)now.tv_nsec*1e-9;
+#endif
+}
+
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+//! @brief Returns the median of an array (the array is sorted)
+static double median(double *values, int n)
+{
+    qsort(values, n, sizeof(double), compareDoubles);
+    return (n % 2) ? values[n/2] : 0.5*(values[n/2-1]+values[n/2]);
+}
+
+
+//! @brief Discards log messages from FMI 2 FMUs
+static void logFmi2(fmi2ComponentEnvironment environment, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+    (void)environment; (void)instanceName; (void)status; (void)category; (void)message;
+}
+
+
+//! @brief Discards log messages from FMI 3 FMUs
+static void logFmi3(fmi3InstanceEnvironment environment, fmi3Status status, fmi3String category, fmi3String message)
+{
+    (void)environment; (void)status; (void)category; (void)message;
+}
+
+
+//! @brief Loads an FMU with the selected loading method
+static fmiHandle *loadFmu(const options_t *options, const char *fmuFile, const char *instanceName)
+{
+    fmi4c_setCacheDirectory(options->cacheDirectory);
+    return fmi4c_loadFmu(fmuFile, instanceName);
+}
+
+
+//! @brief Measures load time, split into unzip (everything except parsing) and parse time
+static bool measureLoad(const options_t *options, result_t *result)
+{
+    double *loadTimes = malloc(options->repetitions*sizeof(double));
+    double *parseTimes = malloc(options->repetitions*sizeof(double));
+    bool ok = true;
+    for(int i=0; ok && i<options->repetitions; ++i) {
+        double startTime = getTime();
+        fmiHandle *fmu = loadFmu(options, result->fmu, "benchmark");
+        loadTimes[i] = getTime()-startTime;
+        ok = (fmu != NULL);
+        if(ok) {
+            parseTimes[i] = fmi4c_getParseTime(fmu);
+            fmi4c_freeFmu(fmu);
+        }
+    }
+    if(ok) {
+        result->loadTime = median(loadTimes, options->repetitions);
+        result->parseTime = median(parseTimes, options->repetitions);
+        result->unzipTime = result->loadTime-result->parseTime;
+    }
+    free(loadTimes);
+    free(parseTimes);
+    return ok;
+}
+
+
+//! @brief Measures lookup of all variables by name and by value reference
+static void measureLookup(fmiHandle *fmu, result_t *result)
+{
+    int n = result->numberOfVariables;
+    if(n == 0) {
+        return;
+    }
+    const char **names = malloc(n*sizeof(char*));
+    unsigned int *valueReferences = malloc(n*sizeof(unsigned int));
+    for(int i=0; i<n; ++i) {
+        if(result->version == fmiVersion1) {
+            fmi1VariableHandle *var = fmi1_getVariableByIndex(fmu, i);
+            names[i] = fmi1_getVariableName(var);
+            valueReferences[i] = 0;
+        }
+        else if(result->version == fmiVersion2) {
+            fmi2VariableHandle *var = fmi2_getVariableByIndex(fmu, i);
+            names[i] = fmi2_getVariableName(var);
+            valueReferences[i] = (unsigned int)fmi2_getVariableValueReference(var);
+        }
+        else {
+            fmi3VariableHandle *var = fmi3_getVariableByIndex(fmu, i);
+            names[i] = fmi3_getVariableName(var);
+            valueReferences[i] = (unsigned int)fmi3_getVariableValueReference(var);
+        }
+    }
+
+    int rounds = (MIN_LOOKUPS+n-1)/n;
+    size_t found = 0;
+    double startTime = getTime();
+    for(int r=0; r<rounds; ++r) {
+        for(int i=0; i<n; ++i) {
+            if(result->version == fmiVersion1) {
+                found += (fmi1_getVariableByName(fmu, names[i]) != NULL);
+            }
+            else if(result->version == fmiVersion2) {
+                found += (fmi2_getVariableByName(fmu, names[i]) != NULL);
+            }
+            else {
+                found += (fmi3_getVariableByName(fmu, names[i]) != NULL);
+            }
+        }
+    }
+    double time = getTime()-startTime;
+    result->lookupsByNamePerSecond = (time > 0) ? (double)rounds*n/time : 0;
+
+    if(result->version != fmiVersion1) {
+        startTime = getTime();
+        for(int r=0; r<rounds; ++r) {
+            for(int i=0; i<n; ++i) {
+                if(result->version == fmiVersion2) {
+                    found += (fmi2_getVariableByValueReference(fmu, valueReferences[i]) != NULL);
+                }
+                else {
+                    found += (fmi3_getVariableByValueReference(fmu, valueReferences[i]) != NULL);
+                }
+            }
+        }
+        time = getTime()-startTime;
+        result->lookupsByValueReferencePerSecond = (time > 0) ? (double)rounds*n/time : 0;
+    }
+    if(found == 0) {
+        printf("No variables found by lookup in %s\n", result->fmu);
+    }
+    free(names);
+    free(valueReferences);
+}
+
+
+//! @brief Instantiates and initializes a co-simulation FMU
+static bool instantiate(fmiHandle *fmu, result_t *result)
+{
+    double startTime = getTime();
+    bool ok = false;
+    if(result->version == fmiVersion2 && fmi2_getSupportsCoSimulation(fmu)) {
+        ok = fmi2_instantiate(fmu, fmi2CoSimulation, logFmi2, calloc, free, NULL, NULL, false, false) &&
+             fmi2_setupExperiment(fmu, false, 0, 0, false, 0) == fmi2OK &&
+             fmi2_enterInitializationMode(fmu) == fmi2OK &&
+             fmi2_exitInitializationMode(fmu) == fmi2OK;
+    }
+    else if(result->version == fmiVersion3 && fmi3_supportsCoSimulation(fmu)) {
+        ok = fmi3_instantiateCoSimulation(fmu, false, false, false, false, NULL, 0, NULL, logFmi3, NULL) &&
+             fmi3_enterInitializationMode(fmu, false, 0, 0, false, 0) == fmi3OK &&
+             fmi3_exitInitializationMode(fmu) == fmi3OK;
+    }
+    result->instantiateTime = getTime()-startTime;
+    result->libraryLoadTime = fmi4c_getLibraryLoadTime(fmu);
+    return ok;
+}
+
+
+//! @brief Measures get and set latency of floating point variables for each value reference count
+static void measureGetSet(fmiHandle *fmu, const options_t *options, result_t *result)
+{
+    int n = result->numberOfVariables;
+    unsigned int *readable = malloc(n*sizeof(unsigned int));
+    unsigned int *settable = malloc(n*sizeof(unsigned int));
+    int numberOfReadable = 0;
+    int numberOfSettable = 0;
+    for(int i=0; i<n; ++i) {
+        bool isReal, isInput;
+        unsigned int vr;
+        if(result->version == fmiVersion2) {
+            fmi2VariableHandle *var = fmi2_getVariableByIndex(fmu, i);
+            isReal = (fmi2_getVariableDataType(var) == fmi2DataTypeReal);
+            isInput = (fmi2_getVariableCausality(var) == fmi2CausalityInput);
+            vr = (unsigned int)fmi2_getVariableValueReference(var);
+        }
+        else {
+            fmi3VariableHandle *var = fmi3_getVariableByIndex(fmu, i);
+            isReal = (fmi3_getVariableDataType(var) == fmi3DataTypeFloat64);
+            isInput = (fmi3_getVariableCausality(var) == fmi3CausalityInput);
+            vr = (unsigned int)fmi3_getVariableValueReference(var);
+        }
+        if(isReal) {
+            readable[numberOfReadable++] = vr;
+            if(isInput) {
+                settable[numberOfSettable++] = vr;
+            }
+        }
+    }
+
+    for(int c=0; c<options->numberOfVrCounts && numberOfReadable > 0; ++c) {
+        int count = options->vrCounts[c];
+        unsigned int *vrs = malloc(count*sizeof(unsigned int));
+        double *values = calloc(count, sizeof(double));
+        int calls = MIN_VALUES_TRANSFERRED/count > 10 ? MIN_VALUES_TRANSFERRED/count : 10;
+        getSetResult_t *getSet = &result->getSet[result->numberOfGetSetResults++];
+        getSet->numberOfValueReferences = count;
+
+        //Value references are repeated if the FMU has fewer variables than requested
+        for(int i=0; i<count; ++i) {
+            vrs[i] = readable[i % numberOfReadable];
+        }
+        double startTime = getTime();
+        for(int i=0; i<calls; ++i) {
+            if(result->version == fmiVersion2) {
+                fmi2_getReal(fmu, vrs, count, values);
+            }
+            else {
+                fmi3_getFloat64(fmu, vrs, count, values, count);
+            }
+        }
+        getSet->getTime = (getTime()-startTime)/calls;
+
+        getSet->setTime = -1;
+        if(numberOfSettable > 0) {
+            for(int i=0; i<count; ++i) {
+                vrs[i] = settable[i % numberOfSettable];
+            }
+            startTime = getTime();
+            for(int i=0; i<calls; ++i) {
+                if(result->version == fmiVersion2) {
+                    fmi2_setReal(fmu, vrs, count, values);
+                }
+                else {
+                    fmi3_setFloat64(fmu, vrs, count, values, count);
+                }
+            }
+            getSet->setTime = (getTime()-startTime)/calls;
+        }
+        free(vrs);
+        free(values);
+    }
+    free(readable);
+    free(settable);
+}
+
+
+//! @brief Measures doStep throughput
+static void measureDoStep(fmiHandle *fmu, const options_t *options, result_t *result)
+{
+    double stepSize = options->stepSize;
+    if(stepSize <= 0 && result->version == fmiVersion2 && fmi2_defaultStepSizeDefined(fmu)) {
+        stepSize = fmi2_getDefaultStepSize(fmu);
+    }
+    else if(stepSize <= 0 && result->version == fmiVersion3 && fmi3_defaultStepSizeDefined(fmu)) {
+        stepSize = fmi3_getDefaultStepSize(fmu);
+    }
+    if(stepSize <= 0) {
+        stepSize = 0.001;
+    }
+
+    double time = 0;
+    int steps = 0;
+    double startTime = getTime();
+    for(; steps<options->steps; ++steps) {
+        bool ok;
+        if(result->version == fmiVersion2) {
+            ok = (fmi2_doStep(fmu, time, stepSize, true) == fmi2OK);
+        }
+        else {
+            fmi3Boolean eventEncountered, terminateSimulation, earlyReturn;
+            fmi3Float64 lastSuccessfulTime;
+            ok = (fmi3_doStep(fmu, time, stepSize, true, &eventEncountered, &terminateSimulation, &earlyReturn, &lastSuccessfulTime) == fmi3OK) &&
+                 !terminateSimulation;
+        }
+        if(!ok) {
+            break;
+        }
+        time += stepSize;
+    }
+    double elapsed = getTime()-startTime;
+    result->steps = steps;
+    result->stepsPerSecond = (elapsed > 0) ? steps/elapsed : 0;
+}
+
+
+//! @brief Runs all measurements for one FMU
+static void benchmarkFmu(const options_t *options, result_t *result)
+{
+    result->loaded = measureLoad(options, result);
+    if(!result->loaded) {
+        return;
+    }
+
+    fmiHandle *fmu = loadFmu(options, result->fmu, "benchmark");
+    if(fmu == NULL) {
+        result->loaded = false;
+        return;
+    }
+    result->version = fmi4c_getFmiVersion(fmu);
+    if(result->version == fmiVersion1) {
+        result->numberOfVariables = fmi1_getNumberOfVariables(fmu);
+    }
+    else if(result->version == fmiVersion2) {
+        result->numberOfVariables = fmi2_getNumberOfVariables(fmu);
+    }
+    else {
+        result->numberOfVariables = fmi3_getNumberOfVariables(fmu);
+    }
+    measureLookup(fmu, result);
+
+    if(result->version != fmiVersion1) {
+        result->instantiated = instantiate(fmu, result);
+        if(result->instantiated) {
+            measureGetSet(fmu, options, result);
+            measureDoStep(fmu, options, result);
+            if(result->version == fmiVersion2) {
+                fmi2_terminate(fmu);
+                fmi2_freeInstance(fmu);
+            }
+            else {
+                fmi3_terminate(fmu);
+                fmi3_freeInstance(fmu);
+            }
+        }
+    }
+    fmi4c_freeFmu(fmu);
+}
+
+
+//! @brief Writes a JSON string literal
+static void writeJsonString(FILE *file, const char *str)
+{
+    fputc('"', file);
+    for(const char *c=str; *c; ++c) {
+        if(*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+
+//! @brief Writes all results as a JSON array, with one object per FMU
+static bool writeResults(const char *path, const result_t *results, int numberOfResults)
+{
+    FILE *file = fopen(path, "w");
+    if(file == NULL) {
+        printf("Cannot open output file: %s\n", path);
+        return false;
+    }
+    fprintf(file, "[\n");
+    for(int i=0; i<numberOfResults; ++i) {
+        const result_t *r = &results[i];
+        fprintf(file, "  {\n    \"fmu\": ");
+        writeJsonString(file, r->fmu);
+        fprintf(file, ",\n    \"loaded\": %s", r->loaded ? "true" : "false");
+        if(r->loaded) {
+            fprintf(file, ",\n    \"fmiVersion\": %d,\n    \"variables\": %d", r->version == fmiVersion1 ? 1 : (r->version == fmiVersion2 ? 2 : 3), r->numberOfVariables);
+            fprintf(file, ",\n    \"load\": { \"total\": %.9g, \"unzip\": %.9g, \"parse\": %.9g }", r->loadTime, r->unzipTime, r->parseTime);
+            fprintf(file, ",\n    \"lookup\": { \"byNamePerSecond\": %.9g, \"byValueReferencePerSecond\": %.9g }", r->lookupsByNamePerSecond, r->lookupsByValueReferencePerSecond);
+            fprintf(file, ",\n    \"instantiated\": %s", r->instantiated ? "true" : "false");
+        }
+        if(r->instantiated) {
+            fprintf(file, ",\n    \"instantiate\": { \"total\": %.9g, \"dlopen\": %.9g }", r->instantiateTime, r->libraryLoadTime);
+            fprintf(file, ",\n    \"getSet\": [");
+            for(int j=0; j<r->numberOfGetSetResults; ++j) {
+                fprintf(file, "%s\n      { \"valueReferences\": %d, \"get\": %.9g, \"set\": ", j ? "," : "", r->getSet[j].numberOfValueReferences, r->getSet[j].getTime);
+                if(r->getSet[j].setTime < 0) {
+                    fprintf(file, "null }");
+                }
+                else {
+                    fprintf(file, "%.9g }", r->getSet[j].setTime);
+                }
+            }
+            fprintf(file, "%s]", r->numberOfGetSetResults ? "\n    " : "");
+            fprintf(file, ",\n    \"doStep\": { \"steps\": %d, \"stepsPerSecond\": %.9g }", r->steps, r->stepsPerSecond);
+        }
+        fprintf(file, "\n  }%s\n", i < numberOfResults-1 ? "," : "");
+    }
+    fprintf(file, "]\n");
+    return fclose(file) == 0;
+}
+
+
+//! @brief Parses a comma-separated list of value reference counts
+static bool parseVrCounts(const char *str, options_t *options)
+{
+    options->numberOfVrCounts = 0;
+    while(*str && options->numberOfVrCounts < MAX_VR_COUNTS) {
+        char *end;
+        long count = strtol(str, &end, 10);
+        if(end == str || count <= 0) {
+            return false;
+        }
+        options->vrCounts[options->numberOfVrCounts++] = (int)count;
+        str = (*end == ',') ? end+1 : end;
+    }
+    return options->numberOfVrCounts > 0;
+}
+
+
+static void printUsage()
+{
+    printf("Usage: fmi4c_benchmark [-o output.json] [-r repetitions] [-s steps] [-h stepsize] [-v 1,10,100] [-c cachedir] fmu1.fmu [fmu2.fmu ...]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    options_t options;
+    options.output = "fmi4c_benchmark.json";
+    options.repetitions = 5;
+    options.steps = 1000;
+    options.stepSize = 0;
+    options.cacheDirectory = NULL;
+    parseVrCounts("1,10,100,1000", &options);
+
+    int first = 1;
+    for(; first<argc && argv[first][0] == '-' && argv[first][1] != '\0'; first += 2) {
+        if(first+1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        const char *value = argv[first+1];
+        bool ok = true;
+        switch(argv[first][1]) {
+        case 'o': options.output = value; break;
+        case 'r': options.repetitions = atoi(value); ok = (options.repetitions > 0); break;
+        case 's': options.steps = atoi(value); ok = (options.steps >= 0); break;
+        case 'h': options.stepSize = atof(value); ok = (options.stepSize > 0); break;
+        case 'v': ok = parseVrCounts(value, &options); break;
+        case 'c': options.cacheDirectory = value; break;
+        default: ok = false;
+        }
+        if(!ok) {
+            printUsage();
+            return 1;
+        }
+    }
+    if(first >= argc) {
+        printUsage();
+        return 1;
+    }
+
+    int numberOfResults = argc-first;
+    result_t *results = calloc(numberOfResults, sizeof(result_t));
+    for(int i=0; i<numberOfResults; ++i) {
+        results[i].fmu = argv[first+i];
+        benchmarkFmu(&options, &results[i]);
+        if(!results[i].loaded) {
+            printf("Failed to load FMU: %s\n", results[i].fmu);
+        }
+    }
+
+    bool ok = writeResults(options.output, results, numberOfResults);
+    free(results);
+    return ok ? 0 : 1;
+}
@@ -40,12 +40,102 @@
 extern "C" {
 #endif
 
+// Options for parsing modelDescription.xml, see fmi4c_setParseOptions()
+#define FMI4C_PARSE_STREAMING 1             // Parse FMI 3 variables one at a time, instead of building a tree for the whole file (ignored when built with FMI4C_USE_PUGIXML)
+#define FMI4C_PARSE_SKIP_DESCRIPTIONS 2     // Do not store variable and enumeration item descriptions
+#define FMI4C_PARSE_SKIP_UNITS 4            // Do not parse unit definitions and display units
+#define FMI4C_PARSE_BINARY_CACHE 8          // Keep a memory-mapped binary copy of FMI 2 and 3 model descriptions in the extraction cache directory
+
+// Stages of fmi4c_loadFmusPipelined(), as indices of its stage times
+#define FMI4C_LOAD_STAGE_EXTRACT 0          // Extraction of binaries
+#define FMI4C_LOAD_STAGE_PARSE 1            // Parsing of modelDescription.xml
+#define FMI4C_LOAD_STAGE_LIBRARY 2          // Loading of the shared library
+#define FMI4C_LOAD_STAGE_RESOURCES 3        // Extraction of resources
+#define FMI4C_LOAD_STAGES 4
+
+// File formats of fmi4c_createResultRecorder()
+#define FMI4C_RECORD_COLUMNAR 0             // Chunks of columns, in the binary layout described at fmi4c_createResultRecorder()
+#define FMI4C_RECORD_COLUMNAR_ZLIB 1        // Chunks of columns, each chunk compressed with zlib
+#define FMI4C_RECORD_MAT4 2                 // MAT v4 result file, as written by Dymola and OpenModelica
+
+// Receives log messages from the background thread of an fmiLogger, see fmi4c_createLogger()
+typedef void (*fmi4cLogSink)(void *userData, const char *instanceName, int status, const char *category, const char *message);
+
+// Allocation functions for all memory of fmi4c, see fmi4c_setAllocator(). reallocate() with ptr NULL allocates.
+typedef struct {
+    void *(*allocate)(void *userData, size_t size);
+    void *(*reallocate)(void *userData, void *ptr, size_t size);
+    void (*deallocate)(void *userData, void *ptr);
+    void *userData;
+} fmi4cAllocator;
+
 // FMU access functions
 
 FMI4C_DLLAPI fmiVersion_t fmi4c_getFmiVersion(fmiHandle *fmu);
 FMI4C_DLLAPI fmiHandle* fmi4c_loadFmu(const char *fmufile, const char* instanceName);
+FMI4C_DLLAPI fmiHandle* fmi4c_loadFmuInMemory(const char *fmufile, const char* instanceName);
+FMI4C_DLLAPI int fmi4c_loadFmus(int numberOfFmus, const char **fmufiles, const char **instanceNames, bool inMemory, int numberOfThreads, fmiHandle **fmus);
+FMI4C_DLLAPI int fmi4c_loadFmusPipelined(int numberOfFmus, const char **fmufiles, const char **instanceNames, int threadsPerStage, int queueCapacity, fmiHandle **fmus, double *stageTimes);
+FMI4C_DLLAPI fmiHandle* fmi4c_createInstanceHandle(fmiHandle* fmu, const char* instanceName);
+FMI4C_DLLAPI bool fmi4c_supportsMultipleInstantiation(fmiHandle* fmu);
+FMI4C_DLLAPI bool fmi4c_setOutOfProcess(fmiHandle* fmu, const char* hostExecutable);
+FMI4C_DLLAPI void fmi4c_setCacheDirectory(const char* path);
+FMI4C_DLLAPI void fmi4c_setAllocator(const fmi4cAllocator* allocator);
 FMI4C_DLLAPI void fmi4c_freeFmu(fmiHandle* fmu);
+FMI4C_DLLAPI double fmi4c_getParseTime(fmiHandle* fmu);
+FMI4C_DLLAPI double fmi4c_getLibraryLoadTime(fmiHandle* fmu);
 FMI4C_DLLAPI const char* fmi4c_getErrorMessages();
+FMI4C_DLLAPI void fmi4c_setParseOptions(int options);
+FMI4C_DLLAPI fmiTransferPlan* fmi4c_createTransferPlan(fmiHandle* source, fmiHandle* destination);
+FMI4C_DLLAPI void fmi4c_freeTransferPlan(fmiTransferPlan* plan);
+FMI4C_DLLAPI fmiParameterSet* fmi4c_createParameterSet(fmiHandle* fmu);
+FMI4C_DLLAPI void fmi4c_freeParameterSet(fmiParameterSet* set);
+FMI4C_DLLAPI void fmi4c_setProfilingEnabled(fmiHandle* fmu, bool enabled);
+FMI4C_DLLAPI void fmi4c_resetProfiling(fmiHandle* fmu);
+FMI4C_DLLAPI int fmi4c_getNumberOfProfiledFunctions(fmiHandle* fmu);
+FMI4C_DLLAPI bool fmi4c_getProfiledFunction(fmiHandle* fmu, int i, const char** name, uint64_t* numberOfCalls, uint64_t* numberOfValueReferences, double* totalTime, double* maxTime);
+FMI4C_DLLAPI bool fmi4c_writeProfileToJson(fmiHandle* fmu, const char* path);
+FMI4C_DLLAPI fmiSnapshotPool* fmi4c_createSnapshotPool(fmiHandle* fmu, int numberOfSlots, bool serialize);
+FMI4C_DLLAPI void fmi4c_freeSnapshotPool(fmiSnapshotPool* pool);
+FMI4C_DLLAPI int64_t fmi4c_saveSnapshot(fmiSnapshotPool* pool);
+FMI4C_DLLAPI bool fmi4c_restoreSnapshot(fmiSnapshotPool* pool, int64_t checkpoint);
+FMI4C_DLLAPI fmiStepPool* fmi4c_createStepPool(int numberOfThreads, bool pinThreads);
+FMI4C_DLLAPI void fmi4c_freeStepPool(fmiStepPool* pool);
+FMI4C_DLLAPI fmiStepBatch* fmi4c_doStepsAsync(fmiStepPool* pool, int numberOfFmus, fmiHandle** fmus, double currentCommunicationPoint, double communicationStepSize);
+FMI4C_DLLAPI bool fmi4c_isStepBatchFinished(fmiStepBatch* batch);
+FMI4C_DLLAPI int fmi4c_waitForSteps(fmiStepBatch* batch);
+FMI4C_DLLAPI int fmi4c_getStepStatus(fmiStepBatch* batch, int i);
+FMI4C_DLLAPI void fmi4c_getStepResultFmi3(fmiStepBatch* batch, int i, bool* eventHandlingNeeded, bool* terminateSimulation, bool* earlyReturn, double* lastSuccessfulTime);
+FMI4C_DLLAPI void fmi4c_freeStepBatch(fmiStepBatch* batch);
+FMI4C_DLLAPI fmiLogger* fmi4c_createLogger(int numberOfRecords, int minimumStatus, fmi4cLogSink sink, void* userData);
+FMI4C_DLLAPI void fmi4c_freeLogger(fmiLogger* logger);
+FMI4C_DLLAPI void fmi4c_setLoggerMinimumStatus(fmiLogger* logger, int minimumStatus);
+FMI4C_DLLAPI void fmi4c_setLoggerCategories(fmiLogger* logger, int numberOfCategories, const char** categories);
+FMI4C_DLLAPI int64_t fmi4c_getNumberOfDroppedLogMessages(fmiLogger* logger);
+FMI4C_DLLAPI fmiResultRecorder* fmi4c_createResultRecorder(fmiHandle* fmu, const char* path, int format, int samplesPerChunk, int numberOfChunks);
+FMI4C_DLLAPI bool fmi4c_addRecordedVariable(fmiResultRecorder* recorder, const char* name);
+FMI4C_DLLAPI bool fmi4c_addRecordedValueReferences(fmiResultRecorder* recorder, int dataType, const fmi3ValueReference* valueReferences, size_t nValueReferences);
+FMI4C_DLLAPI bool fmi4c_addRecordedTransferPlan(fmiResultRecorder* recorder, const fmiTransferPlan* plan);
+FMI4C_DLLAPI bool fmi4c_freeResultRecorder(fmiResultRecorder* recorder);
+FMI4C_DLLAPI void fmi4c_logMessageFmi2(fmi2ComponentEnvironment componentEnvironment, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...);
+FMI4C_DLLAPI void fmi4c_logMessageFmi3(fmi3InstanceEnvironment instanceEnvironment, fmi3Status status, fmi3String category, fmi3String message);
+FMI4C_DLLAPI fmiStateVector* fmi4c_createStateVector(fmiHandle* fmu);
+FMI4C_DLLAPI void fmi4c_freeStateVector(fmiStateVector* vector);
+FMI4C_DLLAPI int fmi4c_getStateVectorSize(fmiStateVector* vector);
+FMI4C_DLLAPI double* fmi4c_getStateBuffer(fmiStateVector* vector);
+FMI4C_DLLAPI double* fmi4c_getDerivativeBuffer(fmiStateVector* vector);
+FMI4C_DLLAPI int fmi4c_setTimeAndContinuousStates(fmiStateVector* vector, double time, const double* states);
+FMI4C_DLLAPI int fmi4c_getContinuousStateDerivatives(fmiStateVector* vector, double* derivatives);
+FMI4C_DLLAPI int fmi4c_updateContinuousStates(fmiStateVector* vector);
+FMI4C_DLLAPI void fmi4c_invalidateStateVector(fmiStateVector* vector);
+FMI4C_DLLAPI void fmi4c_getStateVectorStatistics(fmiStateVector* vector, long* numberOfSetCalls, long* numberOfSkippedSetCalls, long* numberOfGetCalls, long* numberOfSkippedGetCalls);
+#ifdef FMI4C_WITH_KINSOL
+FMI4C_DLLAPI fmiAlgebraicLoop* fmi4c_createAlgebraicLoop(int numberOfConnections, fmiHandle** outputFmus, const fmi3ValueReference* outputValueReferences, fmiHandle** inputFmus, const fmi3ValueReference* inputValueReferences);
+FMI4C_DLLAPI void fmi4c_freeAlgebraicLoop(fmiAlgebraicLoop* loop);
+FMI4C_DLLAPI int fmi4c_solveAlgebraicLoop(fmiAlgebraicLoop* loop, double tolerance);
+FMI4C_DLLAPI void fmi4c_getAlgebraicLoopSolution(fmiAlgebraicLoop* loop, double values[]);
+FMI4C_DLLAPI void fmi4c_getAlgebraicLoopStatistics(fmiAlgebraicLoop* loop, long* numberOfIterations, long* numberOfResidualEvaluations, long* numberOfJacobianProducts, bool* directionalDerivatives);
+#endif
 
 // FMI 1 wrapper functions
 FMI4C_DLLAPI fmi1Type fmi1_getType(fmiHandle *fmu);
@@ -134,7 +224,18 @@ FMI4C_DLLAPI double fmi2_getDefaultStopTime(fmiHandle *fmu);
 FMI4C_DLLAPI double fmi2_getDefaultTolerance(fmiHandle *fmu);
 FMI4C_DLLAPI double fmi2_getDefaultStepSize(fmiHandle *fmu);
 
+FMI4C_DLLAPI bool fmi2_addTransfer(fmiTransferPlan *plan, fmi2DataType dataType, fmi2ValueReference sourceValueReference, fmi2ValueReference destinationValueReference);
+FMI4C_DLLAPI fmi2Status fmi2_executeTransferPlan(fmiTransferPlan *plan);
+FMI4C_DLLAPI fmi2Status fmi2_recordSample(fmiResultRecorder *recorder, fmi2Real time);
+FMI4C_DLLAPI bool fmi2_addParameter(fmiParameterSet *set, fmi2String name, const void *value);
+FMI4C_DLLAPI fmi2Status fmi2_applyParameterSet(fmiHandle *fmu, const fmiParameterSet *set);
 FMI4C_DLLAPI int fmi2_getNumberOfVariables(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi2ValueReference* fmi2_getVariableValueReferences(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi2Causality* fmi2_getVariableCausalities(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi2Variability* fmi2_getVariableVariabilities(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi2DataType* fmi2_getVariableDataTypes(fmiHandle *fmu);
+FMI4C_DLLAPI int fmi2_getValueReferencesByCausality(fmiHandle *fmu, fmi2Causality causality, fmi2DataType dataType, fmi2ValueReference *valueReferences, int maxNumberOfValueReferences);
+FMI4C_DLLAPI int fmi2_getValueReferencesByVariability(fmiHandle *fmu, fmi2Variability variability, fmi2DataType dataType, fmi2ValueReference *valueReferences, int maxNumberOfValueReferences);
 FMI4C_DLLAPI fmi2VariableHandle* fmi2_getVariableByIndex(fmiHandle *fmu, int i);
 FMI4C_DLLAPI fmi2VariableHandle* fmi2_getVariableByValueReference(fmiHandle *fmu, fmi3ValueReference vr);
 FMI4C_DLLAPI fmi2VariableHandle* fmi2_getVariableByName(fmiHandle *fmu, fmi2String name);
@@ -289,7 +390,34 @@ FMI4C_DLLAPI fmi2Status fmi2_getBooleanStatus(fmiHandle* fmu, const fmi2StatusKi
 FMI4C_DLLAPI fmi2Status fmi2_getStringStatus(fmiHandle* fmu, const fmi2StatusKind, fmi2String* );
 
 
+FMI4C_DLLAPI bool fmi3_addTransfer(fmiTransferPlan *plan, fmi3DataType dataType, fmi3ValueReference sourceValueReference, fmi3ValueReference destinationValueReference);
+FMI4C_DLLAPI fmi3Status fmi3_executeTransferPlan(fmiTransferPlan *plan);
+FMI4C_DLLAPI fmi3Status fmi3_recordSample(fmiResultRecorder *recorder, fmi3Float64 time);
+FMI4C_DLLAPI bool fmi3_addParameter(fmiParameterSet *set, fmi3String name, const void *value, size_t nValues);
+FMI4C_DLLAPI fmi3Status fmi3_applyParameterSet(fmiHandle *fmu, const fmiParameterSet *set);
+FMI4C_DLLAPI fmiArrayLayout* fmi3_createArrayLayout(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences);
+FMI4C_DLLAPI void fmi3_freeArrayLayout(fmiArrayLayout *layout);
+FMI4C_DLLAPI size_t fmi3_getArrayLayoutNumberOfValues(fmiArrayLayout *layout);
+FMI4C_DLLAPI fmi3DataType fmi3_getArrayLayoutDataType(fmiArrayLayout *layout);
+FMI4C_DLLAPI bool fmi3_getArrayLayoutEntry(fmiArrayLayout *layout, fmi3ValueReference valueReference, size_t *offset, size_t *size);
+FMI4C_DLLAPI fmi3Status fmi3_getArrayValues(fmiArrayLayout *layout, void *values);
+FMI4C_DLLAPI fmi3Status fmi3_setArrayValues(fmiArrayLayout *layout, const void *values);
+FMI4C_DLLAPI fmiIntermediateRecorder* fmi3_createIntermediateRecorder(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, int capacity);
+FMI4C_DLLAPI void fmi3_freeIntermediateRecorder(fmiIntermediateRecorder *recorder);
+FMI4C_DLLAPI void fmi3_recordIntermediateUpdate(fmi3InstanceEnvironment instanceEnvironment, fmi3Float64 intermediateUpdateTime, fmi3Boolean intermediateVariableSetRequested, fmi3Boolean intermediateVariableGetAllowed, fmi3Boolean intermediateStepFinished, fmi3Boolean canReturnEarly, fmi3Boolean *earlyReturnRequested, fmi3Float64 *earlyReturnTime);
+FMI4C_DLLAPI int fmi3_getNumberOfIntermediateSamples(fmiIntermediateRecorder *recorder);
+FMI4C_DLLAPI const void* fmi3_getIntermediateSample(fmiIntermediateRecorder *recorder, int i, fmi3DataType dataType, double *time, bool *stepFinished);
+FMI4C_DLLAPI fmiArrayLayout* fmi3_getIntermediateRecorderLayout(fmiIntermediateRecorder *recorder, fmi3DataType dataType);
+FMI4C_DLLAPI void fmi3_removeIntermediateSamples(fmiIntermediateRecorder *recorder, int numberOfSamples);
+FMI4C_DLLAPI int64_t fmi3_getNumberOfDroppedIntermediateSamples(fmiIntermediateRecorder *recorder);
+FMI4C_DLLAPI fmi3Status fmi3_getIntermediateRecorderStatus(fmiIntermediateRecorder *recorder);
 FMI4C_DLLAPI int fmi3_getNumberOfVariables(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi3ValueReference* fmi3_getVariableValueReferences(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi3Causality* fmi3_getVariableCausalities(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi3Variability* fmi3_getVariableVariabilities(fmiHandle *fmu);
+FMI4C_DLLAPI const fmi3DataType* fmi3_getVariableDataTypes(fmiHandle *fmu);
+FMI4C_DLLAPI int fmi3_getValueReferencesByCausality(fmiHandle *fmu, fmi3Causality causality, fmi3DataType dataType, fmi3ValueReference *valueReferences, int maxNumberOfValueReferences);
+FMI4C_DLLAPI int fmi3_getValueReferencesByVariability(fmiHandle *fmu, fmi3Variability variability, fmi3DataType dataType, fmi3ValueReference *valueReferences, int maxNumberOfValueReferences);
 FMI4C_DLLAPI fmi3VariableHandle* fmi3_getVariableByName(fmiHandle *fmu, fmi3String name);
 FMI4C_DLLAPI fmi3VariableHandle* fmi3_getVariableByIndex(fmiHandle *fmu, int i);
 FMI4C_DLLAPI fmi3VariableHandle* fmi3_getVariableByValueReference(fmiHandle *fmu, fmi3ValueReference vr);
@@ -317,6 +445,9 @@ FMI4C_DLLAPI fmi3Boolean fmi3_getVariableStartBoolean(fmi3VariableHandle *var);
 FMI4C_DLLAPI fmi3String fmi3_getVariableStartString(fmi3VariableHandle *var);
 FMI4C_DLLAPI fmi3Binary fmi3_getVariableStartBinary(fmi3VariableHandle *var);
 FMI4C_DLLAPI fmi3ValueReference fmi3_getVariableValueReference(fmi3VariableHandle* var);
+FMI4C_DLLAPI int fmi3_getVariableNumberOfDimensions(fmi3VariableHandle* var);
+FMI4C_DLLAPI bool fmi3_getVariableDimension(fmi3VariableHandle* var, int i, uint64_t* start, fmi3ValueReference* valueReference);
+FMI4C_DLLAPI bool fmi3_getVariableNumberOfValues(fmiHandle *fmu, fmi3VariableHandle* var, size_t* numberOfValues);
 
 FMI4C_DLLAPI const char* fmi3_modelName(fmiHandle *fmu);
 FMI4C_DLLAPI const char* fmi3_instantiationToken(fmiHandle *fmu);
@@ -584,6 +715,15 @@ FMI4C_DLLAPI bool fmi3_iInstantiateModelExchange(fmiHandle *fmu,
                                                fmi3InstanceEnvironment    instanceEnvironment,
                                                fmi3LogMessageCallback     logMessage);
 
+FMI4C_DLLAPI bool fmi3_instantiateScheduledExecution(fmiHandle *fmu,
+                                                    fmi3Boolean                  visible,
+                                                    fmi3Boolean                  loggingOn,
+                                                    fmi3InstanceEnvironment      instanceEnvironment,
+                                                    fmi3LogMessageCallback       logMessage,
+                                                    fmi3ClockUpdateCallback      clockUpdate,
+                                                    fmi3CallbackLockPreemption   lockPreemption,
+                                                    fmi3CallbackUnlockPreemption unlockPreemption);
+
 FMI4C_DLLAPI const char* fmi3_getVersion(fmiHandle *fmu);
 
 FMI4C_DLLAPI fmi3Status fmi3_setDebugLogging(fmiHandle *fmu,
@@ -817,6 +957,22 @@ FMI4C_DLLAPI fmi3Status fmi3_deserializeFMUState(fmiHandle *fmu,
                                                 size_t size,
                                                 fmi3FMUState* FMUState);
 
+FMI4C_DLLAPI fmiSparseJacobian* fmi3_createSparseJacobian(fmiHandle* fmu);
+FMI4C_DLLAPI void fmi3_freeSparseJacobian(fmiSparseJacobian* jacobian);
+FMI4C_DLLAPI void fmi3_getSparseJacobianDimensions(fmiSparseJacobian* jacobian, int* numberOfStates, int* numberOfNonZeros, int* numberOfColors);
+FMI4C_DLLAPI void fmi3_getSparseJacobianPattern(fmiSparseJacobian* jacobian, int64_t columnPointers[], int64_t rowIndices[]);
+FMI4C_DLLAPI fmi3Status fmi3_evaluateSparseJacobian(fmiSparseJacobian* jacobian, fmi3Float64 values[]);
+FMI4C_DLLAPI fmiClockScheduler* fmi3_createClockScheduler(fmiHandle* fmu, double startTime, int numberOfThreads, bool pinThreads);
+FMI4C_DLLAPI void fmi3_freeClockScheduler(fmiClockScheduler* scheduler);
+FMI4C_DLLAPI bool fmi3_scheduleClock(fmiClockScheduler* scheduler, fmi3ValueReference clockReference, double activationTime);
+FMI4C_DLLAPI fmi3Status fmi3_runClockSchedulerUntil(fmiClockScheduler* scheduler, double stopTime);
+#ifdef FMI4C_WITH_CVODE
+FMI4C_DLLAPI fmiModelExchangeSolver* fmi3_createModelExchangeSolver(fmiHandle* fmu, double startTime, double relativeTolerance, double absoluteTolerance);
+FMI4C_DLLAPI void fmi3_freeModelExchangeSolver(fmiModelExchangeSolver* solver);
+FMI4C_DLLAPI fmi3Status fmi3_solveModelExchangeUntil(fmiModelExchangeSolver* solver, double stopTime, bool* terminateSimulation);
+FMI4C_DLLAPI double fmi3_getModelExchangeSolverTime(fmiModelExchangeSolver* solver);
+FMI4C_DLLAPI void fmi3_getModelExchangeSolverStatistics(fmiModelExchangeSolver* solver, long* numberOfSteps, long* numberOfRhsEvaluations, long* numberOfJacobianEvaluations, long* numberOfEvents);
+#endif
 FMI4C_DLLAPI fmi3Status fmi3_getDirectionalDerivative(fmiHandle *fmu,
                                                      const fmi3ValueReference unknowns[],
                                                      size_t nUnknowns,
@@ -7,4 +7,10 @@
 
 #define UNUSED(x) (void)(x);
 
+#if defined(_MSC_VER)
+#define FMI4C_THREAD_LOCAL __declspec(thread)
+#else
+#define FMI4C_THREAD_LOCAL __thread
+#endif
+
 #endif // FMI4C_COMMON_H
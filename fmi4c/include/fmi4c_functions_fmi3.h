@@ -25,6 +25,8 @@ typedef void (*fmi3IntermediateUpdateCallback)(fmi3InstanceEnvironment instanceE
                                                fmi3Boolean* earlyReturnRequested,
                                                fmi3Float64* earlyReturnTime);
 
+typedef void (*fmi3ClockUpdateCallback)(fmi3InstanceEnvironment instanceEnvironment);
+
 typedef void (*fmi3CallbackLockPreemption)();
 typedef void (*fmi3CallbackUnlockPreemption)();
 
@@ -40,7 +42,7 @@ typedef fmi3Instance (STDCALL *fmi3InstantiateCoSimulation_t)(fmi3String, fmi3St
 typedef fmi3Instance (STDCALL *fmi3InstantiateScheduledExecution_t)(fmi3String, fmi3String, fmi3String, fmi3Boolean,
                                                                       fmi3Boolean,
                                                                       fmi3InstanceEnvironment, fmi3LogMessageCallback,
-                                                                      fmi3IntermediateUpdateCallback,
+                                                                      fmi3ClockUpdateCallback,
                                                                       fmi3CallbackLockPreemption,
                                                                       fmi3CallbackUnlockPreemption);
 typedef void (STDCALL *fmi3FreeInstance_t)(fmi3Instance);
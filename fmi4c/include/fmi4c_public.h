@@ -6,5 +6,19 @@ typedef struct fmi1VariableHandle fmi1VariableHandle;
 typedef struct fmi2VariableHandle fmi2VariableHandle;
 typedef struct fmi3VariableHandle fmi3VariableHandle;
 typedef struct fmi3UnitHandle fmi3UnitHandle;
+typedef struct fmiTransferPlan fmiTransferPlan;
+typedef struct fmiParameterSet fmiParameterSet;
+typedef struct fmiArrayLayout fmiArrayLayout;
+typedef struct fmiIntermediateRecorder fmiIntermediateRecorder;
+typedef struct fmiSnapshotPool fmiSnapshotPool;
+typedef struct fmiStepPool fmiStepPool;
+typedef struct fmiStepBatch fmiStepBatch;
+typedef struct fmiSparseJacobian fmiSparseJacobian;
+typedef struct fmiModelExchangeSolver fmiModelExchangeSolver;
+typedef struct fmiClockScheduler fmiClockScheduler;
+typedef struct fmiLogger fmiLogger;
+typedef struct fmiResultRecorder fmiResultRecorder;
+typedef struct fmiAlgebraicLoop fmiAlgebraicLoop;
+typedef struct fmiStateVector fmiStateVector;
 
 #endif // FMIC_PUBLIC_H
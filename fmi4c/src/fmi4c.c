@@ -5,10 +5,8 @@
 #include "fmi4c_utils.h"
 #include "fmi4c_common.h"
 
-#include "minizip/miniunz.h"
-#include "ezxml/ezxml.h"
-
 #include <sys/stat.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 #include <float.h>
@@ -16,9 +14,27 @@
 #ifndef _WIN32
 #include <dlfcn.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #endif
 
+// Chrome trace events, recorded when built with OMS_TRACE
+#ifdef OMS_TRACE
+#include "omstrace.h"
+#else
+#define OMS_TRACE_BEGIN(category, name)
+#define OMS_TRACE_END(category, name)
+#endif
+
+// Platform specific binary directories inside the FMU archive
+#if defined(_WIN32) || defined(__CYGWIN__)
+#define FMI2_BINARIES_DIRECTORY "binaries/win64/"
+#define FMI3_BINARIES_DIRECTORY "binaries/x86_64-windows/"
+#else
+#define FMI2_BINARIES_DIRECTORY "binaries/linux64/"
+#define FMI3_BINARIES_DIRECTORY "binaries/x86_64-linux/"
+#endif
+
 #ifdef _WIN32
 FARPROC loadDllFunction(HINSTANCE dll, const char *name, bool *ok) {
     FARPROC fnc = GetProcAddress(dll, name);
@@ -39,18 +55,296 @@ void *loadDllFunction(void *dll, const char *name, bool *ok) {
 }
 #endif
 
-const char* fmi4cErrorMessage = "";
+#ifdef _WIN32
+//! @brief Loads a shared library by absolute path. Dependencies are searched for in the
+//! directory of the library, without changing the process-wide DLL search path.
+//! @param dllPath Absolute path to shared library
+//! @returns Library handle, or NULL on failure
+static HINSTANCE loadSharedLibrary(const char *dllPath)
+{
+    HINSTANCE dll = LoadLibraryExA(dllPath, NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
+    if(NULL == dll) {
+        DWORD error = GetLastError();
+        LPSTR message = NULL;
+        FormatMessageA(
+            FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+            NULL, error, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&message, 0, NULL);
+        fprintf(stderr, "Failed to load DLL %s:\n%s", dllPath, message);
+        LocalFree(message);
+    }
+    return dll;
+}
+#else
+//! @brief Loads a shared library by absolute path, making sure it is executable first
+//! @param dllPath Absolute path to shared library
+//! @returns Library handle, or NULL on failure
+static void *loadSharedLibrary(const char *dllPath)
+{
+    struct stat st;
+    if(stat(dllPath, &st) == 0 && (st.st_mode & S_IXUSR) == 0) {
+        chmod(dllPath, st.st_mode | S_IXUSR | S_IXGRP | S_IXOTH);
+    }
+
+    void* dll = dlopen(dllPath, RTLD_NOW|RTLD_LOCAL);
+    if(NULL == dll) {
+        printf("Loading shared object failed: %s (%s)\n", dllPath, dlerror());
+    }
+    return dll;
+}
+#endif
+
+
+static fmiSharedLibrary *libraryCache = NULL;
+static fmiMutex libraryCacheMutex = FMI4C_MUTEX_INITIALIZER;
+static int numberOfLibraryCopies = 0;
+
+
+//! @brief Identifies a file independently of the path used to reach it
+//! @param path Path to file
+//! @param library Returns file identity in device, file, size and modified
+//! @returns True if the file exists
+static bool getFileIdentity(const char *path, fmiSharedLibrary *library)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(file, &info);
+    CloseHandle(file);
+    library->device = info.dwVolumeSerialNumber;
+    library->file = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    library->size = ((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    library->modified = (long long)(((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime);
+    return ok;
+#else
+    struct stat st;
+    if(stat(path, &st) != 0) {
+        return false;
+    }
+    library->device = (unsigned long long)st.st_dev;
+    library->file = (unsigned long long)st.st_ino;
+    library->size = (unsigned long long)st.st_size;
+    library->modified = (long long)st.st_mtime;
+    return true;
+#endif
+}
+
+
+//! @brief Loads an FMU shared library, or acquires another reference to it if it is already loaded
+//! Libraries are identified by file, not by path, so FMUs loaded from the extraction cache or through
+//! several handles share one loaded library. FMUs that can only be instantiated once per process get
+//! a separate library image for each handle, loaded from a private copy of the library file if the
+//! library is already in use.
+//! @param dllPath Absolute path to shared library
+//! @param separateImage True if the library must not be shared with other handles
+//! @returns Library handle (release with releaseSharedLibrary()), or NULL on failure
+#ifdef _WIN32
+static HINSTANCE acquireSharedLibrary(const char *dllPath, bool separateImage)
+#else
+static void *acquireSharedLibrary(const char *dllPath, bool separateImage)
+#endif
+{
+    fmiSharedLibrary identity;
+    if(!getFileIdentity(dllPath, &identity)) {
+        printf("Shared library not found: %s\n", dllPath);
+        return NULL;
+    }
+
+    fmiMutexLock(&libraryCacheMutex);
+    fmiSharedLibrary *library = libraryCache;
+    while(library != NULL && (library->copyPath != NULL || library->device != identity.device || library->file != identity.file ||
+                              library->size != identity.size || library->modified != identity.modified)) {
+        library = library->next;
+    }
+    if(library != NULL && !separateImage && !library->separateImage) {
+        ++library->referenceCount;
+        fmiMutexUnlock(&libraryCacheMutex);
+        return library->dll;
+    }
+
+    //Libraries are loaded while holding the lock, so that concurrent loads of the same library cannot both load it
+    char *copyPath = NULL;
+    if(library != NULL) {
+        //Loading the same file again would return the same image, so load a copy next to it (where its dependencies are)
+        const char *extension = strrchr(dllPath, '.');
+        size_t stemLength = (extension != NULL) ? (size_t)(extension-dllPath) : strlen(dllPath);
+        size_t copyPathSize = strlen(dllPath)+32;
+        copyPath = fmi4cMalloc(copyPathSize);
+        do {
+            snprintf(copyPath, copyPathSize, "%.*s.fmi4c%d%s", (int)stemLength, dllPath, ++numberOfLibraryCopies, extension != NULL ? extension : "");
+        } while(getFileIdentity(copyPath, &identity));
+        if(!copyFile(dllPath, copyPath)) {
+            printf("Failed to copy shared library: %s\n", dllPath);
+            fmiMutexUnlock(&libraryCacheMutex);
+            fmi4cFree(copyPath);
+            return NULL;
+        }
+    }
+
+    identity.dll = loadSharedLibrary(copyPath != NULL ? copyPath : dllPath);
+    if(identity.dll == NULL) {
+        fmiMutexUnlock(&libraryCacheMutex);
+        if(copyPath != NULL) {
+            remove(copyPath);
+            fmi4cFree(copyPath);
+        }
+        return NULL;    //Error message should already have been printed
+    }
+
+    library = fmi4cMalloc(sizeof(fmiSharedLibrary));
+    memcpy(library, &identity, sizeof(fmiSharedLibrary));
+    library->copyPath = copyPath;
+    library->separateImage = separateImage;
+    library->referenceCount = 1;
+    library->next = libraryCache;
+    libraryCache = library;
+    fmiMutexUnlock(&libraryCacheMutex);
+    return library->dll;
+}
+
+
+//! @brief Releases one reference to a library from acquireSharedLibrary(), unloading it when the last reference is released
+//! @param dll Library handle
+#ifdef _WIN32
+static void releaseSharedLibrary(HINSTANCE dll)
+#else
+static void releaseSharedLibrary(void *dll)
+#endif
+{
+    fmiMutexLock(&libraryCacheMutex);
+    fmiSharedLibrary **link = &libraryCache;
+    while(*link != NULL && (*link)->dll != dll) {
+        link = &(*link)->next;
+    }
+    fmiSharedLibrary *library = *link;
+    if(library == NULL || --library->referenceCount > 0) {
+        fmiMutexUnlock(&libraryCacheMutex);
+        return;
+    }
+    *link = library->next;
+    fmiMutexUnlock(&libraryCacheMutex);
+
+#ifdef _WIN32
+    FreeLibrary(library->dll);
+#else
+    dlclose(library->dll);
+#endif
+    if(library->copyPath != NULL) {
+        remove(library->copyPath);
+        fmi4cFree(library->copyPath);
+    }
+    fmi4cFree(library);
+}
+
+
+//! @brief Releases the library preloaded by fmi4c_loadFmusPipelined(), if it has not been used
+//! @param fmu FMU handle
+static void releasePreloadedLibrary(fmiHandle *fmu)
+{
+    if(fmu->preloadedDll != NULL) {
+        releaseSharedLibrary(fmu->preloadedDll);
+        fmu->preloadedDll = NULL;
+    }
+    fmi4cFree(fmu->preloadedDllPath);
+    fmu->preloadedDllPath = NULL;
+}
+
+
+//! @brief Acquires the library of an FMU, taking over the preloaded library if it is the same file
+//! @param fmu FMU handle
+//! @param dllPath Absolute path to shared library
+//! @returns Library handle, or NULL on failure
+#ifdef _WIN32
+static HINSTANCE acquireFmuLibrary(fmiHandle *fmu, const char *dllPath)
+#else
+static void *acquireFmuLibrary(fmiHandle *fmu, const char *dllPath)
+#endif
+{
+    if(fmu->preloadedDll != NULL && !strcmp(fmu->preloadedDllPath, dllPath)) {
+#ifdef _WIN32
+        HINSTANCE dll = fmu->preloadedDll;
+#else
+        void *dll = fmu->preloadedDll;
+#endif
+        fmu->preloadedDll = NULL;
+        releasePreloadedLibrary(fmu);
+        return dll;
+    }
+    releasePreloadedLibrary(fmu);   //Another interface was instantiated
+    return acquireSharedLibrary(dllPath, !fmi4c_supportsMultipleInstantiation(fmu));
+}
+
+FMI4C_THREAD_LOCAL const char* fmi4cErrorMessage = "";
 
 const char* fmi4c_getErrorMessages()
 {
     return fmi4cErrorMessage;
 }
 
+static int parseOptions = 0;
+
+//! @brief Sets options for parsing modelDescription.xml in subsequently loaded FMUs
+//! Should be set before loading FMUs, it is not synchronized with concurrent loading.
+//! @param options Combination of FMI4C_PARSE_STREAMING, FMI4C_PARSE_SKIP_DESCRIPTIONS, FMI4C_PARSE_SKIP_UNITS and FMI4C_PARSE_BINARY_CACHE
+void fmi4c_setParseOptions(int options)
+{
+    parseOptions = options;
+}
+
+
+//! @brief Reads modelDescription.xml, from the FMU archive if extraction is deferred, otherwise from the unzipped location
+//! @param fmu FMU handle
+//! @param size Returns size of file
+//! @returns Null-terminated file contents, or NULL on failure
+static char *readModelDescriptionXml(fmiHandle *fmu, size_t *size)
+{
+    if(fmu->fmuFile != NULL) {
+        return readFileFromArchive(fmu->fmuFile, "modelDescription.xml", size);
+    }
+
+    char path[FILENAME_MAX];
+    snprintf(path, sizeof(path), "%s/modelDescription.xml", fmu->unzippedLocation);
+    return readFile(path, size);
+}
+
+
+//! @brief Extracts binaries for the current platform and resources from the FMU archive, if extraction was deferred
+//! @param fmu FMU handle
+//! @param binariesDirectory Platform directory in the archive, e.g. "binaries/linux64/"
+//! @returns True if files are available in the unzipped location
+static bool extractDeferredFiles(fmiHandle *fmu, const char *binariesDirectory)
+{
+    if(fmu->sharedModel != NULL) {
+        //Extract only once for all handles sharing the files
+        fmiMutexLock(&fmu->sharedModel->mutex);
+        bool ok = extractDeferredFiles(fmu->sharedModel->model, binariesDirectory);
+        fmiMutexUnlock(&fmu->sharedModel->mutex);
+        return ok;
+    }
+
+    if(fmu->fmuFile == NULL || fmu->extracted) {
+        return true;
+    }
+
+    if(!makeDirectories(fmu->unzippedLocation) ||
+       !extractFilesFromArchive(fmu->fmuFile, binariesDirectory, fmu->unzippedLocation) ||
+       !extractFilesFromArchive(fmu->fmuFile, "resources/", fmu->unzippedLocation)) {
+        printf("Failed to extract FMU: %s\n", fmu->fmuFile);
+        return false;
+    }
+    fmu->extracted = true;
+    return true;
+}
+
+
 
 //! @brief Parses modelDescription.xml for FMI 1
 //! @param fmu FMU handle
+//! @param rootElement Root element of the already parsed modelDescription.xml
 //! @returns True if parsing was successful
-bool parseModelDescriptionFmi1(fmiHandle *fmu)
+bool parseModelDescriptionFmi1(fmiHandle *fmu, fmiXmlElement rootElement)
 {
     fmu->fmi1.modelName = NULL;
     fmu->fmi1.modelIdentifier = NULL;
@@ -80,69 +374,56 @@ bool parseModelDescriptionFmi1(fmiHandle *fmu)
 
     fmu->fmi1.type = fmi1ModelExchange;
 
-    char cwd[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
-    chdir(fmu->unzippedLocation);
-
-    ezxml_t rootElement = ezxml_parse_file("modelDescription.xml");
-    if(strcmp(rootElement->name, "fmiModelDescription")) {
-        printf("Wrong root tag name: %s\n", rootElement->name);
-        return false;
-    }
 
     //Parse attributes in <fmiModelDescription>
-    parseStringAttributeEzXml(rootElement, "modelName",                 &fmu->fmi1.modelName);
-    parseStringAttributeEzXml(rootElement, "modelIdentifier",           &fmu->fmi1.modelIdentifier);
-    parseStringAttributeEzXml(rootElement, "guid",                      &fmu->fmi1.guid);
-    parseStringAttributeEzXml(rootElement, "description",               &fmu->fmi1.description);
-    parseStringAttributeEzXml(rootElement, "author",                    &fmu->fmi1.author);
-    parseStringAttributeEzXml(rootElement, "version",                   &fmu->fmi1.version);
-    parseStringAttributeEzXml(rootElement, "generationtool",            &fmu->fmi1.generationTool);
-    parseStringAttributeEzXml(rootElement, "generationDateAndTime",     &fmu->fmi1.generationDateAndTime);
-    parseStringAttributeEzXml(rootElement, "variableNamingConvention",  &fmu->fmi1.variableNamingConvention);
-    parseInt32AttributeEzXml(rootElement, "numberOfContinuousStates",   &fmu->fmi1.numberOfContinuousStates);
-    parseInt32AttributeEzXml(rootElement, "numberOfEventIndicators",    &fmu->fmi1.numberOfEventIndicators);
-
-    ezxml_t implementationElement = ezxml_child(rootElement, "Implementation");
+    parseStringAttributeXml(rootElement, "modelName",                 &fmu->fmi1.modelName, &fmu->arena);
+    parseStringAttributeXml(rootElement, "modelIdentifier",           &fmu->fmi1.modelIdentifier, &fmu->arena);
+    parseStringAttributeXml(rootElement, "guid",                      &fmu->fmi1.guid, &fmu->arena);
+    parseStringAttributeXml(rootElement, "description",               &fmu->fmi1.description, &fmu->arena);
+    parseStringAttributeXml(rootElement, "author",                    &fmu->fmi1.author, &fmu->arena);
+    parseStringAttributeXml(rootElement, "version",                   &fmu->fmi1.version, &fmu->arena);
+    parseStringAttributeXml(rootElement, "generationtool",            &fmu->fmi1.generationTool, &fmu->arena);
+    parseStringAttributeXml(rootElement, "generationDateAndTime",     &fmu->fmi1.generationDateAndTime, &fmu->arena);
+    parseStringAttributeXml(rootElement, "variableNamingConvention",  &fmu->fmi1.variableNamingConvention, &fmu->arena);
+    parseInt32AttributeXml(rootElement, "numberOfContinuousStates",   &fmu->fmi1.numberOfContinuousStates);
+    parseInt32AttributeXml(rootElement, "numberOfEventIndicators",    &fmu->fmi1.numberOfEventIndicators);
+
+    fmiXmlElement implementationElement = xmlChild(rootElement, "Implementation");
     if(implementationElement) {
-        ezxml_t capabilitiesElement = NULL;
-        ezxml_t cosimToolElement = ezxml_child(implementationElement, "CoSimulation_Tool");
+        fmiXmlElement capabilitiesElement = NULL;
+        fmiXmlElement cosimToolElement = xmlChild(implementationElement, "CoSimulation_Tool");
         if(cosimToolElement) {
             fmu->fmi1.type = fmi1CoSimulationTool;
-            capabilitiesElement = ezxml_child(cosimToolElement, "Capabilities");
+            capabilitiesElement = xmlChild(cosimToolElement, "Capabilities");
         }
-        ezxml_t cosimStandAloneElement = ezxml_child(implementationElement, "CoSimulation_StandAlone");
+        fmiXmlElement cosimStandAloneElement = xmlChild(implementationElement, "CoSimulation_StandAlone");
         if(cosimStandAloneElement) {
             fmu->fmi1.type = fmi1CoSimulationStandAlone;
-            capabilitiesElement = ezxml_child(cosimStandAloneElement, "Capabilities");
+            capabilitiesElement = xmlChild(cosimStandAloneElement, "Capabilities");
         }
         if(capabilitiesElement) {
-            parseBooleanAttributeEzXml(capabilitiesElement, "canHandleVariableCommunicationStepSize",   &fmu->fmi1.canHandleVariableCommunicationStepSize);
-            parseBooleanAttributeEzXml(capabilitiesElement, "canHandleEvents",                          &fmu->fmi1.canHandleEvents);
-            parseBooleanAttributeEzXml(capabilitiesElement, "canRejectSteps",                           &fmu->fmi1.canRejectSteps);
-            parseBooleanAttributeEzXml(capabilitiesElement, "canInterpolateInputs",                     &fmu->fmi1.canInterpolateInputs);
-            parseInt32AttributeEzXml(capabilitiesElement, "maxOutputDerivativeOrder",                   &fmu->fmi1.maxOutputDerivativeOrder);
-            parseBooleanAttributeEzXml(capabilitiesElement, "canRunAsynchronuously",                    &fmu->fmi1.canRunAsynchronuously);
-            parseBooleanAttributeEzXml(capabilitiesElement, "canSignalEvents",                          &fmu->fmi1.canSignalEvents);
-            parseBooleanAttributeEzXml(capabilitiesElement, "canBeInstantiatedOnlyOncePerProcess",      &fmu->fmi1.canBeInstantiatedOnlyOncePerProcess);
-            parseBooleanAttributeEzXml(capabilitiesElement, "canNotUseMemoryManagementFunctions",       &fmu->fmi1.canNotUseMemoryManagementFunctions);
+            parseBooleanAttributeXml(capabilitiesElement, "canHandleVariableCommunicationStepSize",   &fmu->fmi1.canHandleVariableCommunicationStepSize);
+            parseBooleanAttributeXml(capabilitiesElement, "canHandleEvents",                          &fmu->fmi1.canHandleEvents);
+            parseBooleanAttributeXml(capabilitiesElement, "canRejectSteps",                           &fmu->fmi1.canRejectSteps);
+            parseBooleanAttributeXml(capabilitiesElement, "canInterpolateInputs",                     &fmu->fmi1.canInterpolateInputs);
+            parseInt32AttributeXml(capabilitiesElement, "maxOutputDerivativeOrder",                   &fmu->fmi1.maxOutputDerivativeOrder);
+            parseBooleanAttributeXml(capabilitiesElement, "canRunAsynchronuously",                    &fmu->fmi1.canRunAsynchronuously);
+            parseBooleanAttributeXml(capabilitiesElement, "canSignalEvents",                          &fmu->fmi1.canSignalEvents);
+            parseBooleanAttributeXml(capabilitiesElement, "canBeInstantiatedOnlyOncePerProcess",      &fmu->fmi1.canBeInstantiatedOnlyOncePerProcess);
+            parseBooleanAttributeXml(capabilitiesElement, "canNotUseMemoryManagementFunctions",       &fmu->fmi1.canNotUseMemoryManagementFunctions);
         }
     }
 
-    ezxml_t defaultExperimentElement = ezxml_child(rootElement, "DefaultExperiment");
+    fmiXmlElement defaultExperimentElement = xmlChild(rootElement, "DefaultExperiment");
     if(defaultExperimentElement) {
-        fmu->fmi1.defaultStartTimeDefined = parseFloat64AttributeEzXml(defaultExperimentElement, "startTime", &fmu->fmi1.defaultStartTime);
-        fmu->fmi1.defaultStopTimeDefined =  parseFloat64AttributeEzXml(defaultExperimentElement, "stopTime",  &fmu->fmi1.defaultStopTime);
-        fmu->fmi1.defaultToleranceDefined = parseFloat64AttributeEzXml(defaultExperimentElement, "tolerance", &fmu->fmi1.defaultTolerance);
+        fmu->fmi1.defaultStartTimeDefined = parseFloat64AttributeXml(defaultExperimentElement, "startTime", &fmu->fmi1.defaultStartTime);
+        fmu->fmi1.defaultStopTimeDefined =  parseFloat64AttributeXml(defaultExperimentElement, "stopTime",  &fmu->fmi1.defaultStopTime);
+        fmu->fmi1.defaultToleranceDefined = parseFloat64AttributeXml(defaultExperimentElement, "tolerance", &fmu->fmi1.defaultTolerance);
     }
 
-    ezxml_t modelVariablesElement = ezxml_child(rootElement, "ModelVariables");
+    fmiXmlElement modelVariablesElement = xmlChild(rootElement, "ModelVariables");
     if(modelVariablesElement) {
-        for(ezxml_t varElement = ezxml_child(modelVariablesElement, "ScalarVariable"); varElement; varElement = varElement->next) {
+        for(fmiXmlElement varElement = xmlChild(modelVariablesElement, "ScalarVariable"); varElement; varElement = xmlNext(varElement)) {
 
             fmi1VariableHandle var;
             var.name = NULL;
@@ -152,12 +433,14 @@ bool parseModelDescriptionFmi1(fmiHandle *fmu)
             var.startBoolean = 0;
             var.startString = "";
 
-            parseStringAttributeEzXml(varElement, "name", &var.name);
-            parseInt64AttributeEzXml(varElement, "valueReference", &var.valueReference);
-            parseStringAttributeEzXml(varElement, "description", &var.description);
+            parseStringAttributeXml(varElement, "name", &var.name, &fmu->arena);
+            parseInt64AttributeXml(varElement, "valueReference", &var.valueReference);
+            if(!(parseOptions & FMI4C_PARSE_SKIP_DESCRIPTIONS)) {
+                parseStringAttributeXml(varElement, "description", &var.description, &fmu->arena);
+            }
 
             const char* causality = "internal";
-            parseStringAttributeEzXml(varElement, "causality", &causality);
+            parseStringAttributeXml(varElement, "causality", &causality, &fmu->arena);
             if(!strcmp(causality, "input")) {
                 var.causality = fmi1CausalityInput;
             }
@@ -172,14 +455,12 @@ bool parseModelDescriptionFmi1(fmiHandle *fmu)
             }
             else {
                 printf("Unknown causality: %s\n", causality);
-                free((char*)causality);
                 return false;
             }
-            free((char*)causality);
 
             var.variability = fmi1VariabilityContinuous;
             const char* variability;
-            if(parseStringAttributeEzXml(varElement, "variability", &variability)) {
+            if(parseStringAttributeXml(varElement, "variability", &variability, &fmu->arena)) {
                 if(!strcmp(variability, "parameter")) {
                     var.variability = fmi1VariabilityParameter;
                 }
@@ -194,14 +475,12 @@ bool parseModelDescriptionFmi1(fmiHandle *fmu)
                 }
                 else {
                     printf("Unknown variability: %s\n", variability);
-                    free((char*)variability);
                     return false;
                 }
-                free((char*)variability);
             }
 
             const char* alias = "noAlias";
-            parseStringAttributeEzXml(varElement, "alias", &alias);
+            parseStringAttributeXml(varElement, "alias", &alias, &fmu->arena);
             if(!strcmp(alias, "alias")) {
                 var.alias = fmi1AliasAlias;
             }
@@ -212,43 +491,43 @@ bool parseModelDescriptionFmi1(fmiHandle *fmu)
                 var.alias = fmi1AliasNoAlias;
             }
 
-            ezxml_t realElement = ezxml_child(varElement, "Real");
+            fmiXmlElement realElement = xmlChild(varElement, "Real");
             if(realElement) {
                 fmu->fmi1.hasRealVariables = true;
                 var.datatype = fmi1DataTypeReal;
-                parseFloat64AttributeEzXml(realElement, "start", &var.startReal);
-                parseBooleanAttributeEzXml(realElement, "fixed", &var.fixed);
+                parseFloat64AttributeXml(realElement, "start", &var.startReal);
+                parseBooleanAttributeXml(realElement, "fixed", &var.fixed);
             }
 
-            ezxml_t integerElement = ezxml_child(varElement, "Integer");
+            fmiXmlElement integerElement = xmlChild(varElement, "Integer");
             if(integerElement) {
                 fmu->fmi1.hasIntegerVariables = true;
                 var.datatype = fmi1DataTypeInteger;
-                parseInt32AttributeEzXml(integerElement, "start", &var.startInteger);
-                parseBooleanAttributeEzXml(integerElement, "fixed", &var.fixed);
+                parseInt32AttributeXml(integerElement, "start", &var.startInteger);
+                parseBooleanAttributeXml(integerElement, "fixed", &var.fixed);
             }
 
-            ezxml_t booleanElement = ezxml_child(varElement, "Boolean");
+            fmiXmlElement booleanElement = xmlChild(varElement, "Boolean");
             if(booleanElement) {
                 fmu->fmi1.hasBooleanVariables = true;
                 var.datatype = fmi1DataTypeBoolean;
                 bool startBoolean;
-                parseBooleanAttributeEzXml(booleanElement, "start", &startBoolean);
+                parseBooleanAttributeXml(booleanElement, "start", &startBoolean);
                 var.startBoolean = startBoolean;
-                parseBooleanAttributeEzXml(booleanElement, "fixed", &var.fixed);
+                parseBooleanAttributeXml(booleanElement, "fixed", &var.fixed);
             }
 
-            ezxml_t stringElement = ezxml_child(varElement, "String");
+            fmiXmlElement stringElement = xmlChild(varElement, "String");
             if(stringElement) {
                 fmu->fmi1.hasStringVariables = true;
                 var.datatype = fmi1DataTypeString;
-                parseStringAttributeEzXml(stringElement, "start", &var.startString);
-                parseBooleanAttributeEzXml(stringElement, "fixed", &var.fixed);
+                parseStringAttributeXml(stringElement, "start", &var.startString, &fmu->arena);
+                parseBooleanAttributeXml(stringElement, "fixed", &var.fixed);
             }
 
             if(fmu->fmi1.numberOfVariables >= fmu->fmi1.variablesSize) {
                 fmu->fmi1.variablesSize *= 2;
-                fmu->fmi1.variables = realloc(fmu->fmi1.variables, fmu->fmi1.variablesSize*sizeof(fmi1VariableHandle));
+                fmu->fmi1.variables = arenaRealloc(&fmu->arena, fmu->fmi1.variables, fmu->fmi1.numberOfVariables*sizeof(fmi1VariableHandle), fmu->fmi1.variablesSize*sizeof(fmi1VariableHandle));
             }
 
             fmu->fmi1.variables[fmu->fmi1.numberOfVariables] = var;
@@ -256,10 +535,6 @@ bool parseModelDescriptionFmi1(fmiHandle *fmu)
         }
     }
 
-    ezxml_free(rootElement);
-
-    chdir(cwd);
-
     return true;
 }
 
@@ -281,8 +556,9 @@ fmi2Causality mapCausalityIndex[6] = {fmi2CausalityParameter, fmi2CausalityCalcu
 
 //! @brief Parses modelDescription.xml for FMI 2
 //! @param fmu FMU handle
+//! @param rootElement Root element of the already parsed modelDescription.xml
 //! @returns True if parsing was successful
-bool parseModelDescriptionFmi2(fmiHandle *fmu)
+bool parseModelDescriptionFmi2(fmiHandle *fmu, fmiXmlElement rootElement)
 {
     fmu->fmi2.fmiVersion_ = NULL;
     fmu->fmi2.modelName = NULL;
@@ -331,76 +607,63 @@ bool parseModelDescriptionFmi2(fmiHandle *fmu)
     fmu->fmi2.hasBooleanVariables = false;
 
 
-    char cwd[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
-    chdir(fmu->unzippedLocation);
-    chdir(fmu->instanceName);
-
-    ezxml_t rootElement = ezxml_parse_file("modelDescription.xml");
-    if(strcmp(rootElement->name, "fmiModelDescription")) {
-        printf("Wrong root tag name: %s\n", rootElement->name);
-        return false;
-    }
 
     //Parse attributes in <fmiModelDescription>
-    parseStringAttributeEzXml(rootElement, "fmiVersion",                &fmu->fmi2.fmiVersion_);
-    parseStringAttributeEzXml(rootElement, "modelName",                 &fmu->fmi2.modelName);
-    parseStringAttributeEzXml(rootElement, "guid",                      &fmu->fmi2.guid);
-    parseStringAttributeEzXml(rootElement, "description",               &fmu->fmi2.description);
-    parseStringAttributeEzXml(rootElement, "author",                    &fmu->fmi2.author);
-    parseStringAttributeEzXml(rootElement, "version",                   &fmu->fmi2.version);
-    parseStringAttributeEzXml(rootElement, "copyright",                 &fmu->fmi2.copyright);
-    parseStringAttributeEzXml(rootElement, "license",                   &fmu->fmi2.license);
-    parseStringAttributeEzXml(rootElement, "generationtool",            &fmu->fmi2.generationTool);
-    parseStringAttributeEzXml(rootElement, "generationDateAndTime",     &fmu->fmi2.generationDateAndTime);
-    parseStringAttributeEzXml(rootElement, "variableNamingConvention",  &fmu->fmi2.variableNamingConvention);
-    parseInt32AttributeEzXml(rootElement, "numberOfEventIndicators",    &fmu->fmi2.numberOfEventIndicators);
-
-    ezxml_t cosimElement = ezxml_child(rootElement, "CoSimulation");
+    parseStringAttributeXml(rootElement, "fmiVersion",                &fmu->fmi2.fmiVersion_, &fmu->arena);
+    parseStringAttributeXml(rootElement, "modelName",                 &fmu->fmi2.modelName, &fmu->arena);
+    parseStringAttributeXml(rootElement, "guid",                      &fmu->fmi2.guid, &fmu->arena);
+    parseStringAttributeXml(rootElement, "description",               &fmu->fmi2.description, &fmu->arena);
+    parseStringAttributeXml(rootElement, "author",                    &fmu->fmi2.author, &fmu->arena);
+    parseStringAttributeXml(rootElement, "version",                   &fmu->fmi2.version, &fmu->arena);
+    parseStringAttributeXml(rootElement, "copyright",                 &fmu->fmi2.copyright, &fmu->arena);
+    parseStringAttributeXml(rootElement, "license",                   &fmu->fmi2.license, &fmu->arena);
+    parseStringAttributeXml(rootElement, "generationtool",            &fmu->fmi2.generationTool, &fmu->arena);
+    parseStringAttributeXml(rootElement, "generationDateAndTime",     &fmu->fmi2.generationDateAndTime, &fmu->arena);
+    parseStringAttributeXml(rootElement, "variableNamingConvention",  &fmu->fmi2.variableNamingConvention, &fmu->arena);
+    parseInt32AttributeXml(rootElement, "numberOfEventIndicators",    &fmu->fmi2.numberOfEventIndicators);
+
+    fmiXmlElement cosimElement = xmlChild(rootElement, "CoSimulation");
     if(cosimElement) {
         fmu->fmi2.supportsCoSimulation = true;
-        parseStringAttributeEzXml(cosimElement, "modelIdentifier",                          &fmu->fmi2.cs.modelIdentifier);
-        parseBooleanAttributeEzXml(cosimElement, "needsExecutionTool",                      &fmu->fmi2.cs.needsExecutionTool);
-        parseBooleanAttributeEzXml(cosimElement, "canHandleVariableCommunicationStepSize",  &fmu->fmi2.cs.canHandleVariableCommunicationStepSize);
-        parseBooleanAttributeEzXml(cosimElement, "canInterpolateInputs",                    &fmu->fmi2.cs.canInterpolateInputs);
-        parseInt32AttributeEzXml(cosimElement, "maxOutputDerivativeOrder",                  &fmu->fmi2.cs.maxOutputDerivativeOrder);
-        parseBooleanAttributeEzXml(cosimElement, "canRunAsynchronuously",                   &fmu->fmi2.cs.canRunAsynchronuously);
-        parseBooleanAttributeEzXml(cosimElement, "canBeInstantiatedOnlyOncePerProcess",     &fmu->fmi2.cs.canBeInstantiatedOnlyOncePerProcess);
-        parseBooleanAttributeEzXml(cosimElement, "canNotUseMemoryManagementFunctions",      &fmu->fmi2.cs.canNotUseMemoryManagementFunctions);
-        parseBooleanAttributeEzXml(cosimElement, "canGetAndSetFMUstate",                    &fmu->fmi2.cs.canGetAndSetFMUState);
-        parseBooleanAttributeEzXml(cosimElement, "canSerializeFMUstate",                    &fmu->fmi2.cs.canSerializeFMUState);
-        parseBooleanAttributeEzXml(cosimElement, "providesDirectionalDerivative",           &fmu->fmi2.cs.providesDirectionalDerivative);
-    }
-
-    ezxml_t modelExchangeElement = ezxml_child(rootElement, "ModelExchange");
+        parseStringAttributeXml(cosimElement, "modelIdentifier",                          &fmu->fmi2.cs.modelIdentifier, &fmu->arena);
+        parseBooleanAttributeXml(cosimElement, "needsExecutionTool",                      &fmu->fmi2.cs.needsExecutionTool);
+        parseBooleanAttributeXml(cosimElement, "canHandleVariableCommunicationStepSize",  &fmu->fmi2.cs.canHandleVariableCommunicationStepSize);
+        parseBooleanAttributeXml(cosimElement, "canInterpolateInputs",                    &fmu->fmi2.cs.canInterpolateInputs);
+        parseInt32AttributeXml(cosimElement, "maxOutputDerivativeOrder",                  &fmu->fmi2.cs.maxOutputDerivativeOrder);
+        parseBooleanAttributeXml(cosimElement, "canRunAsynchronuously",                   &fmu->fmi2.cs.canRunAsynchronuously);
+        parseBooleanAttributeXml(cosimElement, "canBeInstantiatedOnlyOncePerProcess",     &fmu->fmi2.cs.canBeInstantiatedOnlyOncePerProcess);
+        parseBooleanAttributeXml(cosimElement, "canNotUseMemoryManagementFunctions",      &fmu->fmi2.cs.canNotUseMemoryManagementFunctions);
+        parseBooleanAttributeXml(cosimElement, "canGetAndSetFMUstate",                    &fmu->fmi2.cs.canGetAndSetFMUState);
+        parseBooleanAttributeXml(cosimElement, "canSerializeFMUstate",                    &fmu->fmi2.cs.canSerializeFMUState);
+        parseBooleanAttributeXml(cosimElement, "providesDirectionalDerivative",           &fmu->fmi2.cs.providesDirectionalDerivative);
+    }
+
+    fmiXmlElement modelExchangeElement = xmlChild(rootElement, "ModelExchange");
     if(modelExchangeElement) {
         fmu->fmi2.supportsModelExchange = true;
-        parseStringAttributeEzXml(modelExchangeElement, "modelIdentifier",                          &fmu->fmi2.me.modelIdentifier);
-        parseBooleanAttributeEzXml(modelExchangeElement, "needsExecutionTool",                      &fmu->fmi2.me.needsExecutionTool);
-        parseBooleanAttributeEzXml(modelExchangeElement, "completedIntegratorStepNotNeeded",        &fmu->fmi2.me.completedIntegratorStepNotNeeded);
-        parseBooleanAttributeEzXml(modelExchangeElement, "canBeInstantiatedOnlyOncePerProcess",     &fmu->fmi2.me.canBeInstantiatedOnlyOncePerProcess);
-        parseBooleanAttributeEzXml(modelExchangeElement, "canNotUseMemoryManagementFunctions",      &fmu->fmi2.me.canNotUseMemoryManagementFunctions);
-        parseBooleanAttributeEzXml(modelExchangeElement, "canGetAndSetFMUstate",                    &fmu->fmi2.me.canGetAndSetFMUState);
-        parseBooleanAttributeEzXml(modelExchangeElement, "canSerializeFMUstate",                    &fmu->fmi2.me.canSerializeFMUState);
-        parseBooleanAttributeEzXml(modelExchangeElement, "providesDirectionalDerivative",           &fmu->fmi2.me.providesDirectionalDerivative);
+        parseStringAttributeXml(modelExchangeElement, "modelIdentifier",                          &fmu->fmi2.me.modelIdentifier, &fmu->arena);
+        parseBooleanAttributeXml(modelExchangeElement, "needsExecutionTool",                      &fmu->fmi2.me.needsExecutionTool);
+        parseBooleanAttributeXml(modelExchangeElement, "completedIntegratorStepNotNeeded",        &fmu->fmi2.me.completedIntegratorStepNotNeeded);
+        parseBooleanAttributeXml(modelExchangeElement, "canBeInstantiatedOnlyOncePerProcess",     &fmu->fmi2.me.canBeInstantiatedOnlyOncePerProcess);
+        parseBooleanAttributeXml(modelExchangeElement, "canNotUseMemoryManagementFunctions",      &fmu->fmi2.me.canNotUseMemoryManagementFunctions);
+        parseBooleanAttributeXml(modelExchangeElement, "canGetAndSetFMUstate",                    &fmu->fmi2.me.canGetAndSetFMUState);
+        parseBooleanAttributeXml(modelExchangeElement, "canSerializeFMUstate",                    &fmu->fmi2.me.canSerializeFMUState);
+        parseBooleanAttributeXml(modelExchangeElement, "providesDirectionalDerivative",           &fmu->fmi2.me.providesDirectionalDerivative);
     }
 
-    ezxml_t defaultExperimentElement = ezxml_child(rootElement, "DefaultExperiment");
+    fmiXmlElement defaultExperimentElement = xmlChild(rootElement, "DefaultExperiment");
     if(defaultExperimentElement) {
-        fmu->fmi2.defaultStartTimeDefined = parseFloat64AttributeEzXml(defaultExperimentElement, "startTime", &fmu->fmi2.defaultStartTime);
-        fmu->fmi2.defaultStopTimeDefined =  parseFloat64AttributeEzXml(defaultExperimentElement, "stopTime",  &fmu->fmi2.defaultStopTime);
-        fmu->fmi2.defaultToleranceDefined = parseFloat64AttributeEzXml(defaultExperimentElement, "tolerance", &fmu->fmi2.defaultTolerance);
-        fmu->fmi2.defaultStepSizeDefined =  parseFloat64AttributeEzXml(defaultExperimentElement, "stepSize",  &fmu->fmi2.defaultStepSize);
+        fmu->fmi2.defaultStartTimeDefined = parseFloat64AttributeXml(defaultExperimentElement, "startTime", &fmu->fmi2.defaultStartTime);
+        fmu->fmi2.defaultStopTimeDefined =  parseFloat64AttributeXml(defaultExperimentElement, "stopTime",  &fmu->fmi2.defaultStopTime);
+        fmu->fmi2.defaultToleranceDefined = parseFloat64AttributeXml(defaultExperimentElement, "tolerance", &fmu->fmi2.defaultTolerance);
+        fmu->fmi2.defaultStepSizeDefined =  parseFloat64AttributeXml(defaultExperimentElement, "stepSize",  &fmu->fmi2.defaultStepSize);
     }
 
-    ezxml_t modelVariablesElement = ezxml_child(rootElement, "ModelVariables");
+    fmiXmlElement modelVariablesElement = xmlChild(rootElement, "ModelVariables");
     if(modelVariablesElement) {
-        for(ezxml_t varElement = ezxml_child(modelVariablesElement, "ScalarVariable"); varElement; varElement = varElement->next) {
+        for(fmiXmlElement varElement = xmlChild(modelVariablesElement, "ScalarVariable"); varElement; varElement = xmlNext(varElement)) {
             fmi2VariableHandle var;
+            memset(&var, 0, sizeof(var));
             var.canHandleMultipleSetPerTimeInstant = false; //Default value if attribute not defined
             var.name = NULL;
             var.description = NULL;
@@ -409,13 +672,15 @@ bool parseModelDescriptionFmi2(fmiHandle *fmu)
             var.displayUnit = NULL;
             var.derivative = 0;
 
-            parseStringAttributeEzXml(varElement, "name", &var.name);
-            parseInt64AttributeEzXml(varElement, "valueReference", &var.valueReference);
-            parseStringAttributeEzXml(varElement, "description", &var.description);
-            parseBooleanAttributeEzXml(varElement, "canHandleMultipleSetPerTimeInstant", &var.canHandleMultipleSetPerTimeInstant);
+            parseStringAttributeXml(varElement, "name", &var.name, &fmu->arena);
+            parseInt64AttributeXml(varElement, "valueReference", &var.valueReference);
+            if(!(parseOptions & FMI4C_PARSE_SKIP_DESCRIPTIONS)) {
+                parseStringAttributeXml(varElement, "description", &var.description, &fmu->arena);
+            }
+            parseBooleanAttributeXml(varElement, "canHandleMultipleSetPerTimeInstant", &var.canHandleMultipleSetPerTimeInstant);
 
             const char* causality = "local";
-            parseStringAttributeEzXml(varElement, "causality", &causality);
+            parseStringAttributeXml(varElement, "causality", &causality, &fmu->arena);
             if(!strcmp(causality, "input")) {
                 var.causality = fmi2CausalityInput;
             }
@@ -436,12 +701,11 @@ bool parseModelDescriptionFmi2(fmiHandle *fmu)
             }
             else {
                 printf("Unknown causality: %s\n", causality);
-                free((char*)causality);
                 return false;
             }
 
             const char* variability = "continuous";
-            parseStringAttributeEzXml(varElement, "variability", &variability);
+            parseStringAttributeXml(varElement, "variability", &variability, &fmu->arena);
             if(variability && !strcmp(variability, "fixed")) {
                 var.variability = fmi2VariabilityFixed;
             }
@@ -463,7 +727,7 @@ bool parseModelDescriptionFmi2(fmiHandle *fmu)
             }
 
             const char* initial = "unknown";
-            parseStringAttributeEzXml(varElement, "initial", &initial);
+            parseStringAttributeXml(varElement, "initial", &initial, &fmu->arena);
             if(initial && !strcmp(initial, "approx")) {
                 var.initial = fmi2InitialApprox;
             }
@@ -478,49 +742,49 @@ bool parseModelDescriptionFmi2(fmiHandle *fmu)
                 var.initial = initialDefaultTable[mapVariabilityIndex[var.variability]][mapCausalityIndex[var.causality]];
             }
 
-            ezxml_t realElement = ezxml_child(varElement, "Real");
+            fmiXmlElement realElement = xmlChild(varElement, "Real");
             if(realElement) {
                 fmu->fmi2.hasRealVariables = true;
                 var.datatype = fmi2DataTypeReal;
-                parseFloat64AttributeEzXml(realElement, "start", &var.startReal);
-                if(parseUInt32AttributeEzXml(realElement, "derivative", &var.derivative)) {
+                parseFloat64AttributeXml(realElement, "start", &var.startReal);
+                if(parseUInt32AttributeXml(realElement, "derivative", &var.derivative)) {
                     fmu->fmi2.numberOfContinuousStates++;
                 }
             }
 
-            ezxml_t integerElement = ezxml_child(varElement, "Integer");
+            fmiXmlElement integerElement = xmlChild(varElement, "Integer");
             if(integerElement) {
                 fmu->fmi2.hasIntegerVariables = true;
                 var.datatype = fmi2DataTypeInteger;
-                parseInt32AttributeEzXml(integerElement, "start", &var.startInteger);
+                parseInt32AttributeXml(integerElement, "start", &var.startInteger);
             }
 
-            ezxml_t booleanElement = ezxml_child(varElement, "Boolean");
+            fmiXmlElement booleanElement = xmlChild(varElement, "Boolean");
             if(booleanElement) {
                 fmu->fmi2.hasBooleanVariables = true;
                 var.datatype = fmi2DataTypeBoolean;
                 bool startBoolean;
-                parseBooleanAttributeEzXml(booleanElement, "start", &startBoolean);
+                parseBooleanAttributeXml(booleanElement, "start", &startBoolean);
                 var.startBoolean = startBoolean;
             }
 
-            ezxml_t stringElement = ezxml_child(varElement, "String");
+            fmiXmlElement stringElement = xmlChild(varElement, "String");
             if(stringElement) {
                 fmu->fmi2.hasStringVariables = true;
                 var.datatype = fmi2DataTypeString;
-                parseStringAttributeEzXml(stringElement, "start", &var.startString);
+                parseStringAttributeXml(stringElement, "start", &var.startString, &fmu->arena);
             }
 
-            ezxml_t enumerationElement = ezxml_child(varElement, "Enumeration");
+            fmiXmlElement enumerationElement = xmlChild(varElement, "Enumeration");
             if(enumerationElement) {
                 fmu->fmi2.hasEnumerationVariables = true;
                 var.datatype = fmi2DataTypeEnumeration;
-                parseInt32AttributeEzXml(enumerationElement, "start", &var.startEnumeration);
+                parseInt32AttributeXml(enumerationElement, "start", &var.startEnumeration);
             }
 
             if(fmu->fmi2.numberOfVariables >= fmu->fmi2.variablesSize) {
                 fmu->fmi2.variablesSize *= 2;
-                fmu->fmi2.variables = realloc(fmu->fmi2.variables, fmu->fmi2.variablesSize*sizeof(fmi2VariableHandle));
+                fmu->fmi2.variables = arenaRealloc(&fmu->arena, fmu->fmi2.variables, fmu->fmi2.numberOfVariables*sizeof(fmi2VariableHandle), fmu->fmi2.variablesSize*sizeof(fmi2VariableHandle));
             }
 
             fmu->fmi2.variables[fmu->fmi2.numberOfVariables] = var;
@@ -528,18 +792,410 @@ bool parseModelDescriptionFmi2(fmiHandle *fmu)
         }
     }
 
-    ezxml_free(rootElement);
+    return true;
+}
+
+
+//! @brief Parses one variable element in ModelVariables for FMI 3, and appends the variable
+//! @param fmu FMU handle
+//! @param varElement Variable element (Float64, Int32, ...)
+//! @returns True if parsing was successful
+static bool parseVariableFmi3(fmiHandle *fmu, fmiXmlElement varElement)
+{
+    fmi3VariableHandle var;
+    memset(&var, 0, sizeof(var));
+    var.name = NULL;
+    var.description = NULL;
+    var.quantity = NULL;
+    var.unit = NULL;
+    var.displayUnit = NULL;
+    var.canHandleMultipleSetPerTimeInstant = false; //Default value if attribute not defined
+    var.startBinary = NULL;
+
+    const char *attributes[fmiNumberOfAttributes];
+    decodeAttributesXml(varElement, attributes);
+
+    parseStringAttribute(attributes[fmiAttributeName], &var.name, &fmu->arena);
+    parseInt64Attribute(attributes[fmiAttributeValueReference], &var.valueReference);
+    if(!(parseOptions & FMI4C_PARSE_SKIP_DESCRIPTIONS)) {
+        parseStringAttribute(attributes[fmiAttributeDescription], &var.description, &fmu->arena);
+    }
+    parseBooleanAttribute(attributes[fmiAttributeCanHandleMultipleSetPerTimeInstant], &var.canHandleMultipleSetPerTimeInstant);
+    parseBooleanAttribute(attributes[fmiAttributeIntermediateUpdate], &var.intermediateUpdate);
+    parseUInt32Attribute(attributes[fmiAttributePrevious], &var.previous);
+    parseStringAttribute(attributes[fmiAttributeDeclaredType], &var.declaredType, &fmu->arena);
+    const char* clocks = "";
+    parseStringAttribute(attributes[fmiAttributeClocks], &clocks, &fmu->arena);
+    char* nonConstClocks = fmi4cStrdup(clocks);
+
+    //Count number of clocks
+    var.numberOfClocks = 0;
+    if(nonConstClocks[0]) {
+        var.numberOfClocks = 1;
+    }
+    for(int i=0; nonConstClocks[i]; ++i) {
+        if(nonConstClocks[i] == ' ') {
+            ++var.numberOfClocks;
+        }
+    }
+
+    //Allocate memory for clocks
+    if(var.numberOfClocks > 0) {
+        var.clocks = arenaAlloc(&fmu->arena, var.numberOfClocks*sizeof(int));
+    }
+
+    //Read clocks
+    const char* delim = " ";
+    for(int i=0; i<var.numberOfClocks; ++i) {
+        if(i == 0) {
+            var.clocks[i] = atoi(strtok(nonConstClocks, delim));
+        }
+        else {
+            var.clocks[i] = atoi(strtok(NULL, delim));
+        }
+    }
+
+    fmi4cFree(nonConstClocks);
+
+    //Read array dimensions
+    var.numberOfDimensions = 0;
+    for(fmiXmlElement dimElement = xmlChild(varElement, "Dimension"); dimElement; dimElement = xmlNext(dimElement)) {
+        ++var.numberOfDimensions;
+    }
+    if(var.numberOfDimensions > 0) {
+        var.dimensions = arenaAlloc(&fmu->arena, var.numberOfDimensions*sizeof(fmi3Dimension));
+        int i = 0;
+        for(fmiXmlElement dimElement = xmlChild(varElement, "Dimension"); dimElement; dimElement = xmlNext(dimElement)) {
+            const char *dimAttributes[fmiNumberOfAttributes];
+            decodeAttributesXml(dimElement, dimAttributes);
+            fmi3Dimension *dim = &var.dimensions[i++];
+            dim->start = 0;
+            dim->valueReference = 0;
+            dim->hasStart = parseUInt64Attribute(dimAttributes[fmiAttributeStart], &dim->start);
+            if(!dim->hasStart && !parseUInt32Attribute(dimAttributes[fmiAttributeValueReference], &dim->valueReference)) {
+                printf("Dimension of variable %s has neither start nor valueReference\n", var.name ? var.name : "");
+                return false;
+            }
+        }
+    }
+
+    //Figure out data type
+    if(!strcmp(xmlName(varElement), "Float64")) {
+        var.datatype = fmi3DataTypeFloat64;
+        fmu->fmi3.hasFloat64Variables = true;
+        parseFloat64Attribute(attributes[fmiAttributeStart], &var.startFloat64);
+    }
+    else if(!strcmp(xmlName(varElement), "Float32")) {
+        var.datatype = fmi3DataTypeFloat32;
+        fmu->fmi3.hasFloat32Variables = true;
+        parseFloat32Attribute(attributes[fmiAttributeStart], &var.startFloat32);
+    }
+    else if(!strcmp(xmlName(varElement), "Int64")) {
+        var.datatype = fmi3DataTypeInt64;
+        fmu->fmi3.hasInt64Variables = true;
+        parseInt64Attribute(attributes[fmiAttributeStart], &var.startInt64);
+    }
+    else if(!strcmp(xmlName(varElement), "Int32")) {
+        var.datatype = fmi3DataTypeInt32;
+        fmu->fmi3.hasInt32Variables = true;
+        parseInt32Attribute(attributes[fmiAttributeStart], &var.startInt32);
+    }
+    else if(!strcmp(xmlName(varElement), "Int16")) {
+        var.datatype = fmi3DataTypeInt16;
+        fmu->fmi3.hasInt16Variables = true;
+        parseInt16Attribute(attributes[fmiAttributeStart], &var.startInt16);
+    }
+    else if(!strcmp(xmlName(varElement), "Int8")) {
+        var.datatype = fmi3DataTypeInt8;
+        fmu->fmi3.hasInt8Variables = true;
+        parseInt8Attribute(attributes[fmiAttributeStart], &var.startInt8);
+    }
+    else if(!strcmp(xmlName(varElement), "UInt64")) {
+        var.datatype = fmi3DataTypeUInt64;
+        fmu->fmi3.hasUInt64Variables = true;
+        parseUInt64Attribute(attributes[fmiAttributeStart], &var.startUInt64);
+    }
+    else if(!strcmp(xmlName(varElement), "UInt32")) {
+        var.datatype = fmi3DataTypeUInt32;
+        fmu->fmi3.hasUInt32Variables = true;
+        parseUInt32Attribute(attributes[fmiAttributeStart], &var.startUInt32);
+    }
+    else if(!strcmp(xmlName(varElement), "UInt16")) {
+        var.datatype = fmi3DataTypeUInt16;
+        fmu->fmi3.hasUInt16Variables = true;
+        parseUInt16Attribute(attributes[fmiAttributeStart], &var.startUInt16);
+    }
+    else if(!strcmp(xmlName(varElement), "UInt8")) {
+        var.datatype = fmi3DataTypeUInt8;
+        fmu->fmi3.hasUInt8Variables = true;
+        parseUInt8Attribute(attributes[fmiAttributeStart], &var.startUInt8);
+    }
+    else if(!strcmp(xmlName(varElement), "Boolean")) {
+        var.datatype = fmi3DataTypeBoolean;
+        fmu->fmi3.hasBooleanVariables = true;
+        parseBooleanAttribute(attributes[fmiAttributeStart], &var.startBoolean);
+    }
+    else if(!strcmp(xmlName(varElement), "String")) {
+        var.datatype = fmi3DataTypeString;
+        fmu->fmi3.hasStringVariables = true;
+        parseStringAttribute(attributes[fmiAttributeStart], &var.startString, &fmu->arena);
+    }
+    else if(!strcmp(xmlName(varElement), "Binary")) {
+        var.datatype = fmi3DataTypeBinary;
+        fmu->fmi3.hasBinaryVariables = true;
+        parseUInt8Attribute(attributes[fmiAttributeStart], var.startBinary);
+    }
+    else if(!strcmp(xmlName(varElement), "Enumeration")) {
+        var.datatype = fmi3DataTypeEnumeration;
+        fmu->fmi3.hasEnumerationVariables = true;
+        parseInt64Attribute(attributes[fmiAttributeStart], &var.startEnumeration);
+    }
+    else if(!strcmp(xmlName(varElement), "Clock")) {
+        var.datatype = fmi3DataTypeClock;
+        fmu->fmi3.hasClockVariables = true;
+        parseBooleanAttribute(attributes[fmiAttributeStart], &var.startClock);
+    }
+
+    const char* causality = "local";
+    parseStringAttribute(attributes[fmiAttributeCausality], &causality, &fmu->arena);
+    if(!strcmp(causality, "parameter")) {
+        var.causality = fmi3CausalityParameter;
+    }
+    else if(!strcmp(causality, "calculatedParameter")) {
+        var.causality = fmi3CausalityCalculatedParameter;
+    }
+    else if(!strcmp(causality, "input")) {
+        var.causality = fmi3CausalityInput;
+    }
+    else if(!strcmp(causality, "output")) {
+        var.causality = fmi3CausalityOutput;
+    }
+    else if(!strcmp(causality, "local")) {
+        var.causality = fmi3CausalityLocal;
+    }
+    else if(!strcmp(causality, "independent")) {
+        var.causality = fmi3CausalityIndependent;
+    }
+    else if(!strcmp(causality, "structuralParameter")) {
+        var.causality = fmi3CausalityStructuralParameter;
+        fmu->fmi3.hasStructuralParameters = true;
+    }
+    else {
+        printf("Unknown causality: %s\n", causality);
+        return false;
+    }
+
+    const char* variability;
+    if(var.datatype == fmi3DataTypeFloat64 || var.datatype == fmi3DataTypeFloat32) {
+        variability = "continuous";
+    }
+    else {
+        variability = "discrete";
+    }
+    parseStringAttribute(attributes[fmiAttributeVariability], &variability, &fmu->arena);
+    if(variability && !strcmp(variability, "constant")) {
+        var.variability = fmi3VariabilityConstant;
+    }
+    else if(variability && !strcmp(variability, "fixed")) {
+        var.variability = fmi3VariabilityFixed;
+    }
+    else if(variability && !strcmp(variability, "tunable")) {
+        var.variability = fmi3VariabilityTunable;
+    }
+    else if(variability && !strcmp(variability, "discrete")) {
+        var.variability = fmi3VariabilityDiscrete;
+    }
+    else if(variability && !strcmp(variability, "continuous")) {
+        var.variability = fmi3VariabilityContinuous;
+    }
+    else if(variability) {
+        printf("Unknown variability: %s\n", variability);
+        return false;
+    }
+
+    //Parse arguments common to all except clock type
+    if(var.datatype == fmi3DataTypeFloat64 ||
+       var.datatype == fmi3DataTypeFloat32 ||
+       var.datatype == fmi3DataTypeInt64 ||
+       var.datatype == fmi3DataTypeInt32 ||
+       var.datatype == fmi3DataTypeInt16 ||
+       var.datatype == fmi3DataTypeInt8 ||
+       var.datatype == fmi3DataTypeUInt64 ||
+       var.datatype == fmi3DataTypeUInt32 ||
+       var.datatype == fmi3DataTypeUInt16 ||
+       var.datatype == fmi3DataTypeUInt8 ||
+       var.datatype == fmi3DataTypeBoolean ||
+       var.datatype == fmi3DataTypeBinary ||
+       var.datatype == fmi3DataTypeEnumeration) {
+        const char* initial = NULL;
+        parseStringAttribute(attributes[fmiAttributeInitial], &initial, &fmu->arena);
+        if(initial && !strcmp(initial, "approx")) {
+            var.initial = fmi3InitialApprox;
+        }
+        else if(initial && !strcmp(initial, "exact")) {
+            var.initial = fmi3InitialExact;
+        }
+        else if(initial && !strcmp(initial, "calculated")) {
+            var.initial = fmi3InitialCalculated;
+        }
+        else if(initial) {
+            printf("Unknown initial: %s\n", initial);
+            return false;
+        }
+    }
+
+    //Parse arguments common to float, int and enumeration
+    if(var.datatype == fmi3DataTypeFloat64 ||
+       var.datatype == fmi3DataTypeFloat32 ||
+       var.datatype == fmi3DataTypeInt64 ||
+       var.datatype == fmi3DataTypeInt32 ||
+       var.datatype == fmi3DataTypeInt16 ||
+       var.datatype == fmi3DataTypeInt8 ||
+       var.datatype == fmi3DataTypeUInt64 ||
+       var.datatype == fmi3DataTypeUInt32 ||
+       var.datatype == fmi3DataTypeUInt16 ||
+       var.datatype == fmi3DataTypeUInt8 ||
+       var.datatype == fmi3DataTypeEnumeration) {
+        parseStringAttribute(attributes[fmiAttributeQuantity], &var.quantity, &fmu->arena);
+        parseFloat64Attribute(attributes[fmiAttributeMin], &var.min);
+        parseFloat64Attribute(attributes[fmiAttributeMax], &var.max);
+    }
+
+    //Parse arguments only in float type
+    if(var.datatype == fmi3DataTypeFloat64 ||
+       var.datatype == fmi3DataTypeFloat32) {
+        parseStringAttribute(attributes[fmiAttributeUnit], &var.unit, &fmu->arena);
+        if(!(parseOptions & FMI4C_PARSE_SKIP_UNITS)) {
+            parseStringAttribute(attributes[fmiAttributeDisplayUnit], &var.displayUnit, &fmu->arena);
+        }
+        parseBooleanAttribute(attributes[fmiAttributeRelativeQuantity], &var.relativeQuantity);
+        parseBooleanAttribute(attributes[fmiAttributeUnbounded], &var.unbounded);
+        parseFloat64Attribute(attributes[fmiAttributeNominal], &var.nominal);
+        parseUInt32Attribute(attributes[fmiAttributeDerivative], &var.derivative);
+        parseBooleanAttribute(attributes[fmiAttributeReinit], &var.reInit);
+    }
+
+    //Parse arguments only in binary type
+    if(var.datatype == fmi3DataTypeBinary) {
+        parseStringAttribute(attributes[fmiAttributeMimeType], &var.mimeType, &fmu->arena);
+        parseInt32Attribute(attributes[fmiAttributeMaxSize], &var.maxSize);
+    }
+
+    if(var.datatype == fmi3DataTypeClock) {
+        parseBooleanAttribute(attributes[fmiAttributeCanBeDeactivated], &var.canBeDeactivated);
+        parseInt32Attribute(attributes[fmiAttributePriority], &var.priority);
+        parseFloat64Attribute(attributes[fmiAttributeIntervalDecimal], &var.intervalDecimal);
+        parseFloat64Attribute(attributes[fmiAttributeShiftDecimal], &var.shiftDecimal);
+        parseBooleanAttribute(attributes[fmiAttributeSupportsFraction], &var.supportsFraction);
+        parseInt64Attribute(attributes[fmiAttributeResolution], &var.resolution);
+        parseInt64Attribute(attributes[fmiAttributeIntervalCounter], &var.intervalCounter);
+        parseInt64Attribute(attributes[fmiAttributeShiftCounter], &var.shiftCounter);
+        const char* intervalVariability = NULL;
+        parseStringAttribute(attributes[fmiAttributeIntervalVariability], &intervalVariability, &fmu->arena);
+        if(intervalVariability && !strcmp(intervalVariability, "calculated")) {
+            var.intervalVariability = fmi3IntervalVariabilityCalculated;
+        }
+        else if(intervalVariability && !strcmp(intervalVariability, "changing")) {
+            var.intervalVariability = fmi3IntervalVariabilityChanging;
+        }
+        else if(intervalVariability && !strcmp(intervalVariability, "constant")) {
+            var.intervalVariability = fmi3IntervalVariabilityConstant;
+        }
+        else if(intervalVariability && !strcmp(intervalVariability, "countdown")) {
+            var.intervalVariability = fmi3IntervalVariabilityCountdown;
+        }
+        else if(intervalVariability && !strcmp(intervalVariability, "fixed")) {
+            var.intervalVariability = fmi3IntervalVariabilityFixed;
+        }
+        else if(intervalVariability && !strcmp(intervalVariability, "triggered")) {
+            var.intervalVariability = fmi3IntervalVariabilityTriggered;
+        }
+        else if(intervalVariability && !strcmp(intervalVariability, "tunable")) {
+            var.intervalVariability = fmi3IntervalVariabilityTunable;
+        }
+        else if(intervalVariability) {
+            printf("Unknown interval variability: %s\n", intervalVariability);
+            return false;
+        }
+    }
+
+    if(fmu->fmi3.numberOfVariables >= fmu->fmi3.variablesSize) {
+        fmu->fmi3.variablesSize *= 2;
+        fmu->fmi3.variables = arenaRealloc(&fmu->arena, fmu->fmi3.variables, fmu->fmi3.numberOfVariables*sizeof(fmi3VariableHandle), fmu->fmi3.variablesSize*sizeof(fmi3VariableHandle));
+    }
+
+    fmu->fmi3.variables[fmu->fmi3.numberOfVariables] = var;
+    fmu->fmi3.numberOfVariables++;
+
+    return true;
+}
+
+
+#ifndef FMI4C_WITH_PUGIXML
+// Streaming is only used with ezxml, the in-situ parser keeps the whole document anyway
+
+//! @brief Finds the contents of the ModelVariables element, for streaming parsing
+//! @param xml Null-terminated modelDescription.xml contents
+//! @param size Size of contents
+//! @param contentsStart Returns the start of the contents
+//! @param contentsEnd Returns the start of the ModelVariables end tag
+//! @returns True if a ModelVariables element with contents was found
+static bool findModelVariablesContents(char *xml, size_t size, char **contentsStart, char **contentsEnd)
+{
+    char *end = xml+size;
+    char *start = strstr(xml, "<ModelVariables");
+    if(start == NULL || strchr(" \t\r\n>", start[strlen("<ModelVariables")]) == NULL) {
+        return false;
+    }
+    char *elementEnd = findXmlElementEnd(start, end);
+    char *startTagEnd = strchr(start, '>');
+    if(elementEnd == NULL || startTagEnd == NULL || startTagEnd+1 == elementEnd) {
+        return false;   //Malformed or empty, leave it to the regular parser
+    }
+    (*contentsStart) = startTagEnd+1;
+    (*contentsEnd) = elementEnd;
+    while((*contentsEnd) > (*contentsStart) && (*contentsEnd)[0] != '<') {
+        --(*contentsEnd);
+    }
+    return true;
+}
 
-    chdir(cwd);
 
+//! @brief Parses variable elements for FMI 3 one at a time, without building a tree for all of ModelVariables
+//! @param fmu FMU handle
+//! @param contentsStart Start of the contents of the ModelVariables element (modified during parsing)
+//! @param contentsEnd End of the contents
+//! @returns True if parsing was successful
+static bool parseModelVariablesStreamingFmi3(fmiHandle *fmu, char *contentsStart, char *contentsEnd)
+{
+    for(char *p = findNextXmlElement(contentsStart, contentsEnd); p != NULL; p = findNextXmlElement(p, contentsEnd)) {
+        char *elementEnd = findXmlElementEnd(p, contentsEnd);
+        if(elementEnd == NULL) {
+            printf("Unterminated variable element in ModelVariables\n");
+            return false;
+        }
+        ezxml_t varElement = ezxml_parse_str(p, elementEnd-p);
+        bool ok = (varElement->name != NULL && !ezxml_error(varElement)[0]);
+        if(!ok) {
+            printf("Failed to parse variable element: %s\n", ezxml_error(varElement));
+        }
+        ok = ok && parseVariableFmi3(fmu, varElement);
+        ezxml_free(varElement);
+        if(!ok) {
+            return false;
+        }
+        p = elementEnd;
+    }
     return true;
 }
+#endif
 
 
 //! @brief Parses modelDescription.xml for FMI 3
 //! @param fmu FMU handle
+//! @param rootElement Root element of the already parsed modelDescription.xml
 //! @returns True if parsing was successful
-bool parseModelDescriptionFmi3(fmiHandle *fmu)
+bool parseModelDescriptionFmi3(fmiHandle *fmu, fmiXmlElement rootElement)
 {
     fmu->fmi3.modelName = NULL;
     fmu->fmi3.instantiationToken = NULL;
@@ -617,108 +1273,94 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
     fmu->fmi3.hasClockVariables = false;
     fmu->fmi3.hasStructuralParameters = false;
 
-    char cwd[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
-
-    chdir(fmu->unzippedLocation);
-    chdir(fmu->instanceName);
-
-    ezxml_t rootElement = ezxml_parse_file("modelDescription.xml");
-    if(strcmp(rootElement->name, "fmiModelDescription")) {
-        printf("Wrong root tag name: %s\n", rootElement->name);
-        return false;
-    }
 
-    parseStringAttributeEzXml(rootElement, "modelName",                 &fmu->fmi3.modelName);
-    parseStringAttributeEzXml(rootElement, "instantiationToken",        &fmu->fmi3.instantiationToken);
-    parseStringAttributeEzXml(rootElement, "description",               &fmu->fmi3.description);
-    parseStringAttributeEzXml(rootElement, "author",                    &fmu->fmi3.author);
-    parseStringAttributeEzXml(rootElement, "version",                   &fmu->fmi3.version);
-    parseStringAttributeEzXml(rootElement, "copyright",                 &fmu->fmi3.copyright);
-    parseStringAttributeEzXml(rootElement, "license",                   &fmu->fmi3.license);
-    parseStringAttributeEzXml(rootElement, "generationtool",            &fmu->fmi3.generationTool);
-    parseStringAttributeEzXml(rootElement, "generationDateAndTime",     &fmu->fmi3.generationDateAndTime);
-    parseStringAttributeEzXml(rootElement, "variableNamingConvention",  &fmu->fmi3.variableNamingConvention);
+    parseStringAttributeXml(rootElement, "modelName",                 &fmu->fmi3.modelName, &fmu->arena);
+    parseStringAttributeXml(rootElement, "instantiationToken",        &fmu->fmi3.instantiationToken, &fmu->arena);
+    parseStringAttributeXml(rootElement, "description",               &fmu->fmi3.description, &fmu->arena);
+    parseStringAttributeXml(rootElement, "author",                    &fmu->fmi3.author, &fmu->arena);
+    parseStringAttributeXml(rootElement, "version",                   &fmu->fmi3.version, &fmu->arena);
+    parseStringAttributeXml(rootElement, "copyright",                 &fmu->fmi3.copyright, &fmu->arena);
+    parseStringAttributeXml(rootElement, "license",                   &fmu->fmi3.license, &fmu->arena);
+    parseStringAttributeXml(rootElement, "generationtool",            &fmu->fmi3.generationTool, &fmu->arena);
+    parseStringAttributeXml(rootElement, "generationDateAndTime",     &fmu->fmi3.generationDateAndTime, &fmu->arena);
+    parseStringAttributeXml(rootElement, "variableNamingConvention",  &fmu->fmi3.variableNamingConvention, &fmu->arena);
 
-    ezxml_t cosimElement = ezxml_child(rootElement, "CoSimulation");
+    fmiXmlElement cosimElement = xmlChild(rootElement, "CoSimulation");
     if(cosimElement) {
         fmu->fmi3.supportsCoSimulation = true;
-        parseStringAttributeEzXml(cosimElement,  "modelIdentifier",                         &fmu->fmi3.cs.modelIdentifier);
-        parseBooleanAttributeEzXml(cosimElement, "needsExecutionTool",                      &fmu->fmi3.cs.needsExecutionTool);
-        parseBooleanAttributeEzXml(cosimElement, "canBeInstantiatedOnlyOncePerProcess",     &fmu->fmi3.cs.canBeInstantiatedOnlyOncePerProcess);
-        parseBooleanAttributeEzXml(cosimElement, "canGetAndSetFMUState",                    &fmu->fmi3.cs.canGetAndSetFMUState);
-        parseBooleanAttributeEzXml(cosimElement, "canSerializeFMUState",                    &fmu->fmi3.cs.canSerializeFMUState);
-        parseBooleanAttributeEzXml(cosimElement, "providesDirectionalDerivative",           &fmu->fmi3.cs.providesDirectionalDerivative);
-        parseBooleanAttributeEzXml(cosimElement, "providesAdjointDerivatives",              &fmu->fmi3.cs.providesAdjointDerivatives);
-        parseBooleanAttributeEzXml(cosimElement, "providesPerElementDependencies",          &fmu->fmi3.cs.providesPerElementDependencies);
-        parseInt32AttributeEzXml(cosimElement,   "maxOutputDerivativeOrder",                &fmu->fmi3.cs.maxOutputDerivativeOrder);
-        parseBooleanAttributeEzXml(cosimElement, "providesIntermediateUpdate",              &fmu->fmi3.cs.providesIntermediateUpdate);
-        parseBooleanAttributeEzXml(cosimElement, "mightReturnEarlyFromDoStep",              &fmu->fmi3.cs.mightReturnEarlyFromDoStep);
-        parseBooleanAttributeEzXml(cosimElement, "providesEvaluateDiscreteStates",          &fmu->fmi3.cs.providesEvaluateDiscreteStates);
-        parseInt32AttributeEzXml(cosimElement,   "recommendedIntermediateInputSmoothness",  &fmu->fmi3.cs.recommendedIntermediateInputSmoothness);
-        parseBooleanAttributeEzXml(cosimElement, "canHandleVariableCommunicationStepSize",  &fmu->fmi3.cs.canHandleVariableCommunicationStepSize);
-        parseBooleanAttributeEzXml(cosimElement, "canReturnEarlyAfterIntermediateUpdate",   &fmu->fmi3.cs.canReturnEarlyAfterIntermediateUpdate);
-        parseFloat64AttributeEzXml(cosimElement, "fixedInternalStepSize",                   &fmu->fmi3.cs.fixedInternalStepSize);
-        parseBooleanAttributeEzXml(cosimElement, "hasEventMode",                            &fmu->fmi3.cs.hasEventMode);
-    }
-
-    ezxml_t modelExchangeElement = ezxml_child(rootElement, "ModelExchange");
+        parseStringAttributeXml(cosimElement,  "modelIdentifier",                         &fmu->fmi3.cs.modelIdentifier, &fmu->arena);
+        parseBooleanAttributeXml(cosimElement, "needsExecutionTool",                      &fmu->fmi3.cs.needsExecutionTool);
+        parseBooleanAttributeXml(cosimElement, "canBeInstantiatedOnlyOncePerProcess",     &fmu->fmi3.cs.canBeInstantiatedOnlyOncePerProcess);
+        parseBooleanAttributeXml(cosimElement, "canGetAndSetFMUState",                    &fmu->fmi3.cs.canGetAndSetFMUState);
+        parseBooleanAttributeXml(cosimElement, "canSerializeFMUState",                    &fmu->fmi3.cs.canSerializeFMUState);
+        parseBooleanAttributeXml(cosimElement, "providesDirectionalDerivatives",          &fmu->fmi3.cs.providesDirectionalDerivative);
+        parseBooleanAttributeXml(cosimElement, "providesAdjointDerivatives",              &fmu->fmi3.cs.providesAdjointDerivatives);
+        parseBooleanAttributeXml(cosimElement, "providesPerElementDependencies",          &fmu->fmi3.cs.providesPerElementDependencies);
+        parseInt32AttributeXml(cosimElement,   "maxOutputDerivativeOrder",                &fmu->fmi3.cs.maxOutputDerivativeOrder);
+        parseBooleanAttributeXml(cosimElement, "providesIntermediateUpdate",              &fmu->fmi3.cs.providesIntermediateUpdate);
+        parseBooleanAttributeXml(cosimElement, "mightReturnEarlyFromDoStep",              &fmu->fmi3.cs.mightReturnEarlyFromDoStep);
+        parseBooleanAttributeXml(cosimElement, "providesEvaluateDiscreteStates",          &fmu->fmi3.cs.providesEvaluateDiscreteStates);
+        parseInt32AttributeXml(cosimElement,   "recommendedIntermediateInputSmoothness",  &fmu->fmi3.cs.recommendedIntermediateInputSmoothness);
+        parseBooleanAttributeXml(cosimElement, "canHandleVariableCommunicationStepSize",  &fmu->fmi3.cs.canHandleVariableCommunicationStepSize);
+        parseBooleanAttributeXml(cosimElement, "canReturnEarlyAfterIntermediateUpdate",   &fmu->fmi3.cs.canReturnEarlyAfterIntermediateUpdate);
+        parseFloat64AttributeXml(cosimElement, "fixedInternalStepSize",                   &fmu->fmi3.cs.fixedInternalStepSize);
+        parseBooleanAttributeXml(cosimElement, "hasEventMode",                            &fmu->fmi3.cs.hasEventMode);
+    }
+
+    fmiXmlElement modelExchangeElement = xmlChild(rootElement, "ModelExchange");
     if(modelExchangeElement) {
         fmu->fmi3.supportsModelExchange = true;
-        parseStringAttributeEzXml(modelExchangeElement,  "modelIdentifier",                     &fmu->fmi3.me.modelIdentifier);
-        parseBooleanAttributeEzXml(modelExchangeElement, "needsExecutionTool",                  &fmu->fmi3.me.needsExecutionTool);
-        parseBooleanAttributeEzXml(modelExchangeElement, "canBeInstantiatedOnlyOncePerProcess", &fmu->fmi3.me.canBeInstantiatedOnlyOncePerProcess);
-        parseBooleanAttributeEzXml(modelExchangeElement, "canGetAndSetFMUState",                &fmu->fmi3.me.canGetAndSetFMUState);
-        parseBooleanAttributeEzXml(modelExchangeElement, "canSerializeFMUState",                &fmu->fmi3.me.canSerializeFMUState);
-        parseBooleanAttributeEzXml(modelExchangeElement, "providesDirectionalDerivative",       &fmu->fmi3.me.providesDirectionalDerivative);
-        parseBooleanAttributeEzXml(modelExchangeElement, "providesAdjointDerivatives",          &fmu->fmi3.me.providesAdjointDerivatives);
-        parseBooleanAttributeEzXml(modelExchangeElement, "providesPerElementDependencies",      &fmu->fmi3.me.providesPerElementDependencies);
-        parseBooleanAttributeEzXml(modelExchangeElement, "needsCompletedIntegratorStep",        &fmu->fmi3.me.needsCompletedIntegratorStep);
-        parseBooleanAttributeEzXml(modelExchangeElement, "providesEvaluateDiscreteStates",      &fmu->fmi3.me.providesEvaluateDiscreteStates);
-    }
-
-    ezxml_t scheduledExecutionElement = ezxml_child(rootElement, "ScheduledExecution");
+        parseStringAttributeXml(modelExchangeElement,  "modelIdentifier",                     &fmu->fmi3.me.modelIdentifier, &fmu->arena);
+        parseBooleanAttributeXml(modelExchangeElement, "needsExecutionTool",                  &fmu->fmi3.me.needsExecutionTool);
+        parseBooleanAttributeXml(modelExchangeElement, "canBeInstantiatedOnlyOncePerProcess", &fmu->fmi3.me.canBeInstantiatedOnlyOncePerProcess);
+        parseBooleanAttributeXml(modelExchangeElement, "canGetAndSetFMUState",                &fmu->fmi3.me.canGetAndSetFMUState);
+        parseBooleanAttributeXml(modelExchangeElement, "canSerializeFMUState",                &fmu->fmi3.me.canSerializeFMUState);
+        parseBooleanAttributeXml(modelExchangeElement, "providesDirectionalDerivatives",      &fmu->fmi3.me.providesDirectionalDerivative);
+        parseBooleanAttributeXml(modelExchangeElement, "providesAdjointDerivatives",          &fmu->fmi3.me.providesAdjointDerivatives);
+        parseBooleanAttributeXml(modelExchangeElement, "providesPerElementDependencies",      &fmu->fmi3.me.providesPerElementDependencies);
+        parseBooleanAttributeXml(modelExchangeElement, "needsCompletedIntegratorStep",        &fmu->fmi3.me.needsCompletedIntegratorStep);
+        parseBooleanAttributeXml(modelExchangeElement, "providesEvaluateDiscreteStates",      &fmu->fmi3.me.providesEvaluateDiscreteStates);
+    }
+
+    fmiXmlElement scheduledExecutionElement = xmlChild(rootElement, "ScheduledExecution");
     if(scheduledExecutionElement) {
         fmu->fmi3.supportsScheduledExecution = true;
-        parseStringAttributeEzXml(scheduledExecutionElement,  "modelIdentifier",                        &fmu->fmi3.se.modelIdentifier);
-        parseBooleanAttributeEzXml(scheduledExecutionElement, "needsExecutionTool",                     &fmu->fmi3.se.needsExecutionTool);
-        parseBooleanAttributeEzXml(scheduledExecutionElement, "canBeInstantiatedOnlyOncePerProcess",    &fmu->fmi3.se.canBeInstantiatedOnlyOncePerProcess);
-        parseBooleanAttributeEzXml(scheduledExecutionElement, "canGetAndSetFMUState",                   &fmu->fmi3.se.canGetAndSetFMUState);
-        parseBooleanAttributeEzXml(scheduledExecutionElement, "canSerializeFMUState",                   &fmu->fmi3.se.canSerializeFMUState);
-        parseBooleanAttributeEzXml(scheduledExecutionElement, "providesDirectionalDerivative",          &fmu->fmi3.se.providesDirectionalDerivative);
-        parseBooleanAttributeEzXml(scheduledExecutionElement, "providesAdjointDerivatives",             &fmu->fmi3.se.providesAdjointDerivatives);
-        parseBooleanAttributeEzXml(scheduledExecutionElement, "providesPerElementDependencies",         &fmu->fmi3.se.providesPerElementDependencies);
-    }
-
-    ezxml_t unitDefinitionsElement = ezxml_child(rootElement, "UnitDefinitions");
-    if(unitDefinitionsElement) {
+        parseStringAttributeXml(scheduledExecutionElement,  "modelIdentifier",                        &fmu->fmi3.se.modelIdentifier, &fmu->arena);
+        parseBooleanAttributeXml(scheduledExecutionElement, "needsExecutionTool",                     &fmu->fmi3.se.needsExecutionTool);
+        parseBooleanAttributeXml(scheduledExecutionElement, "canBeInstantiatedOnlyOncePerProcess",    &fmu->fmi3.se.canBeInstantiatedOnlyOncePerProcess);
+        parseBooleanAttributeXml(scheduledExecutionElement, "canGetAndSetFMUState",                   &fmu->fmi3.se.canGetAndSetFMUState);
+        parseBooleanAttributeXml(scheduledExecutionElement, "canSerializeFMUState",                   &fmu->fmi3.se.canSerializeFMUState);
+        parseBooleanAttributeXml(scheduledExecutionElement, "providesDirectionalDerivatives",         &fmu->fmi3.se.providesDirectionalDerivative);
+        parseBooleanAttributeXml(scheduledExecutionElement, "providesAdjointDerivatives",             &fmu->fmi3.se.providesAdjointDerivatives);
+        parseBooleanAttributeXml(scheduledExecutionElement, "providesPerElementDependencies",         &fmu->fmi3.se.providesPerElementDependencies);
+    }
+
+    fmu->fmi3.numberOfUnits = 0;
+    fmiXmlElement unitDefinitionsElement = xmlChild(rootElement, "UnitDefinitions");
+    if(unitDefinitionsElement && !(parseOptions & FMI4C_PARSE_SKIP_UNITS)) {
         //First count number of units
-        fmu->fmi3.numberOfUnits = 0;
-        for(ezxml_t unitElement = unitDefinitionsElement->child; unitElement; unitElement = unitElement->next) {
-            if(!strcmp(unitElement->name, "Unit")) {
+        for(fmiXmlElement unitElement = xmlFirstChild(unitDefinitionsElement); unitElement; unitElement = xmlNext(unitElement)) {
+            if(!strcmp(xmlName(unitElement), "Unit")) {
                 ++fmu->fmi3.numberOfUnits;
             }
         }
         if(fmu->fmi3.numberOfUnits > 0) {
-            fmu->fmi3.units = malloc(fmu->fmi3.numberOfUnits*sizeof(fmi3UnitHandle));
+            fmu->fmi3.units = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfUnits*sizeof(fmi3UnitHandle));
         }
         int i=0;
-        for(ezxml_t unitElement = unitDefinitionsElement->child; unitElement; unitElement = unitElement->next) {
-            if(strcmp(unitElement->name, "Unit")) {
+        for(fmiXmlElement unitElement = xmlFirstChild(unitDefinitionsElement); unitElement; unitElement = xmlNext(unitElement)) {
+            if(strcmp(xmlName(unitElement), "Unit")) {
                 continue;   //Wrong element name
             }
             fmi3UnitHandle unit;
+            memset(&unit, 0, sizeof(unit));
             unit.baseUnit = NULL;
             unit.displayUnits = NULL;
-            parseStringAttributeEzXml(unitElement, "name", &unit.name);
+            parseStringAttributeXml(unitElement, "name", &unit.name, &fmu->arena);
             unit.numberOfDisplayUnits = 0;
-            for(ezxml_t unitSubElement = unitElement->child; unitSubElement; unitSubElement = unitSubElement->next) {
-                if(!strcmp(unitSubElement->name, "BaseUnit")) {
-                    unit.baseUnit = malloc(sizeof(fmi3BaseUnit));
+            for(fmiXmlElement unitSubElement = xmlFirstChild(unitElement); unitSubElement; unitSubElement = xmlNext(unitSubElement)) {
+                if(!strcmp(xmlName(unitSubElement), "BaseUnit")) {
+                    unit.baseUnit = arenaAlloc(&fmu->arena, sizeof(fmi3BaseUnit));
                     unit.baseUnit->kg = 0;
                     unit.baseUnit->m = 0;
                     unit.baseUnit->s = 0;
@@ -729,34 +1371,34 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
                     unit.baseUnit->rad = 0;
                     unit.baseUnit->factor = 1;
                     unit.baseUnit->offset = 0;
-                    parseInt32AttributeEzXml(unitSubElement,    "kg",       &unit.baseUnit->kg);
-                    parseInt32AttributeEzXml(unitSubElement,    "m",        &unit.baseUnit->m);
-                    parseInt32AttributeEzXml(unitSubElement,    "s",        &unit.baseUnit->s);
-                    parseInt32AttributeEzXml(unitSubElement,    "A",        &unit.baseUnit->A);
-                    parseInt32AttributeEzXml(unitSubElement,    "K",        &unit.baseUnit->K);
-                    parseInt32AttributeEzXml(unitSubElement,    "mol",      &unit.baseUnit->mol);
-                    parseInt32AttributeEzXml(unitSubElement,    "cd",       &unit.baseUnit->cd);
-                    parseInt32AttributeEzXml(unitSubElement,    "rad",      &unit.baseUnit->rad);
-                    parseFloat64AttributeEzXml(unitSubElement,  "factor",   &unit.baseUnit->factor);
-                    parseFloat64AttributeEzXml(unitSubElement,  "offset",   &unit.baseUnit->offset);
+                    parseInt32AttributeXml(unitSubElement,    "kg",       &unit.baseUnit->kg);
+                    parseInt32AttributeXml(unitSubElement,    "m",        &unit.baseUnit->m);
+                    parseInt32AttributeXml(unitSubElement,    "s",        &unit.baseUnit->s);
+                    parseInt32AttributeXml(unitSubElement,    "A",        &unit.baseUnit->A);
+                    parseInt32AttributeXml(unitSubElement,    "K",        &unit.baseUnit->K);
+                    parseInt32AttributeXml(unitSubElement,    "mol",      &unit.baseUnit->mol);
+                    parseInt32AttributeXml(unitSubElement,    "cd",       &unit.baseUnit->cd);
+                    parseInt32AttributeXml(unitSubElement,    "rad",      &unit.baseUnit->rad);
+                    parseFloat64AttributeXml(unitSubElement,  "factor",   &unit.baseUnit->factor);
+                    parseFloat64AttributeXml(unitSubElement,  "offset",   &unit.baseUnit->offset);
                 }
-                else if(!strcmp(unitSubElement->name, "DisplayUnit")) {
+                else if(!strcmp(xmlName(unitSubElement), "DisplayUnit")) {
                     ++unit.numberOfDisplayUnits;  //Just count them for now, so we can allocate memory before loading them
                 }
             }
             if(unit.numberOfDisplayUnits > 0) {
-                unit.displayUnits = malloc(unit.numberOfDisplayUnits*sizeof(fmi3DisplayUnitHandle));
+                unit.displayUnits = arenaAlloc(&fmu->arena, unit.numberOfDisplayUnits*sizeof(fmi3DisplayUnitHandle));
             }
             int j=0;
-            for(ezxml_t unitSubElement = unitElement->child; unitSubElement; unitSubElement = unitSubElement->next) {
-                if(!strcmp(unitSubElement->name, "DisplayUnit")) {
+            for(fmiXmlElement unitSubElement = xmlFirstChild(unitElement); unitSubElement; unitSubElement = xmlNext(unitSubElement)) {
+                if(!strcmp(xmlName(unitSubElement), "DisplayUnit")) {
                     unit.displayUnits[j].factor = 1;
                     unit.displayUnits[j].offset = 0;
                     unit.displayUnits[j].inverse = false;
-                    parseStringAttributeEzXml(unitSubElement,  "name",      &unit.displayUnits[j].name);
-                    parseFloat64AttributeEzXml(unitSubElement, "factor",    &unit.displayUnits[j].factor);
-                    parseFloat64AttributeEzXml(unitSubElement, "offset",    &unit.displayUnits[j].offset);
-                    parseBooleanAttributeEzXml(unitSubElement, "inverse",   &unit.displayUnits[j].inverse);
+                    parseStringAttributeXml(unitSubElement,  "name",      &unit.displayUnits[j].name, &fmu->arena);
+                    parseFloat64AttributeXml(unitSubElement, "factor",    &unit.displayUnits[j].factor);
+                    parseFloat64AttributeXml(unitSubElement, "offset",    &unit.displayUnits[j].offset);
+                    parseBooleanAttributeXml(unitSubElement, "inverse",   &unit.displayUnits[j].inverse);
                 }
                 ++j;
             }
@@ -765,7 +1407,7 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
         }
     }
 
-    ezxml_t typeDefinitionsElement = ezxml_child(rootElement, "TypeDefinitions");
+    fmiXmlElement typeDefinitionsElement = xmlChild(rootElement, "TypeDefinitions");
     if(typeDefinitionsElement) {
         //Count all elements by type
         fmu->fmi3.numberOfFloat64Types = 0;
@@ -783,99 +1425,99 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
         fmu->fmi3.numberOfBinaryTypes = 0;
         fmu->fmi3.numberOfEnumerationTypes = 0;
         fmu->fmi3.numberOfClockTypes = 0;
-        for(ezxml_t typeElement = typeDefinitionsElement->child; typeElement; typeElement = typeElement->next) {
-            if(!strcmp(typeElement->name, "Float64Type")) {
+        for(fmiXmlElement typeElement = xmlFirstChild(typeDefinitionsElement); typeElement; typeElement = xmlNext(typeElement)) {
+            if(!strcmp(xmlName(typeElement), "Float64Type")) {
                 ++fmu->fmi3.numberOfFloat64Types;
             }
-            else if(!strcmp(typeElement->name, "Float32Type")) {
+            else if(!strcmp(xmlName(typeElement), "Float32Type")) {
                 ++fmu->fmi3.numberOfFloat32Types;
             }
-            else if(!strcmp(typeElement->name, "Int64Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int64Type")) {
                 ++fmu->fmi3.numberOfInt64Types;
             }
-            else if(!strcmp(typeElement->name, "Int32Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int32Type")) {
                 ++fmu->fmi3.numberOfInt32Types;
             }
-            else if(!strcmp(typeElement->name, "Int16Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int16Type")) {
                 ++fmu->fmi3.numberOfInt16Types;
             }
-            else if(!strcmp(typeElement->name, "Int8Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int8Type")) {
                 ++fmu->fmi3.numberOfInt8Types;
             }
-            else if(!strcmp(typeElement->name, "UInt64Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt64Type")) {
                 ++fmu->fmi3.numberOfUInt64Types;
             }
-            else if(!strcmp(typeElement->name, "UInt32Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt32Type")) {
                 ++fmu->fmi3.numberOfUInt32Types;
             }
-            else if(!strcmp(typeElement->name, "UInt16Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt16Type")) {
                 ++fmu->fmi3.numberOfUInt16Types;
             }
-            else if(!strcmp(typeElement->name, "UInt8Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt8Type")) {
                 ++fmu->fmi3.numberOfUInt8Types;
             }
-            else if(!strcmp(typeElement->name, "BooleanType")) {
+            else if(!strcmp(xmlName(typeElement), "BooleanType")) {
                 ++fmu->fmi3.numberOfBooleanTypes;
             }
-            else if(!strcmp(typeElement->name, "StringType")) {
+            else if(!strcmp(xmlName(typeElement), "StringType")) {
                 ++fmu->fmi3.numberOfStringTypes;
             }
-            else if(!strcmp(typeElement->name, "BinaryType")) {
+            else if(!strcmp(xmlName(typeElement), "BinaryType")) {
                 ++fmu->fmi3.numberOfBinaryTypes;
             }
-            else if(!strcmp(typeElement->name, "EnumerationType")) {
+            else if(!strcmp(xmlName(typeElement), "EnumerationType")) {
                 ++fmu->fmi3.numberOfEnumerationTypes;
             }
-            else if(!strcmp(typeElement->name, "ClockType")) {
+            else if(!strcmp(xmlName(typeElement), "ClockType")) {
                 ++fmu->fmi3.numberOfClockTypes;
             }
         }
 
         //Allocate memory
         if(fmu->fmi3.numberOfFloat64Types > 0) {
-            fmu->fmi3.float64Types = malloc(fmu->fmi3.numberOfFloat64Types*sizeof(fmi3Float64Type));
+            fmu->fmi3.float64Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfFloat64Types*sizeof(fmi3Float64Type));
         }
         if(fmu->fmi3.numberOfFloat32Types > 0) {
-            fmu->fmi3.float32Types = malloc(fmu->fmi3.numberOfFloat32Types*sizeof(fmi3Float32Type));
+            fmu->fmi3.float32Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfFloat32Types*sizeof(fmi3Float32Type));
         }
         if(fmu->fmi3.numberOfInt64Types > 0) {
-            fmu->fmi3.int64Types = malloc(fmu->fmi3.numberOfInt64Types*sizeof(fmi3Int64Type));
+            fmu->fmi3.int64Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfInt64Types*sizeof(fmi3Int64Type));
         }
         if(fmu->fmi3.numberOfInt32Types > 0) {
-            fmu->fmi3.int32Types = malloc(fmu->fmi3.numberOfInt32Types*sizeof(fmi3Int32Type));
+            fmu->fmi3.int32Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfInt32Types*sizeof(fmi3Int32Type));
         }
         if(fmu->fmi3.numberOfInt16Types > 0) {
-            fmu->fmi3.int16Types = malloc(fmu->fmi3.numberOfInt16Types*sizeof(fmi3Int16Type));
+            fmu->fmi3.int16Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfInt16Types*sizeof(fmi3Int16Type));
         }
         if(fmu->fmi3.numberOfInt8Types > 0) {
-            fmu->fmi3.int8Types = malloc(fmu->fmi3.numberOfInt8Types*sizeof(fmi3Int8Type));
+            fmu->fmi3.int8Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfInt8Types*sizeof(fmi3Int8Type));
         }
         if(fmu->fmi3.numberOfUInt64Types > 0) {
-            fmu->fmi3.uint64Types = malloc(fmu->fmi3.numberOfUInt64Types*sizeof(fmi3UInt64Type));
+            fmu->fmi3.uint64Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfUInt64Types*sizeof(fmi3UInt64Type));
         }
         if(fmu->fmi3.numberOfUInt32Types > 0) {
-            fmu->fmi3.uint32Types = malloc(fmu->fmi3.numberOfUInt32Types*sizeof(fmi3UInt32Type));
+            fmu->fmi3.uint32Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfUInt32Types*sizeof(fmi3UInt32Type));
         }
         if(fmu->fmi3.numberOfUInt16Types > 0) {
-            fmu->fmi3.uint16Types = malloc(fmu->fmi3.numberOfUInt16Types*sizeof(fmi3UInt16Type));
+            fmu->fmi3.uint16Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfUInt16Types*sizeof(fmi3UInt16Type));
         }
         if(fmu->fmi3.numberOfUInt8Types > 0) {
-            fmu->fmi3.uint8Types = malloc(fmu->fmi3.numberOfUInt8Types*sizeof(fmi3UInt8Type));
+            fmu->fmi3.uint8Types = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfUInt8Types*sizeof(fmi3UInt8Type));
         }
         if(fmu->fmi3.numberOfBooleanTypes > 0) {
-            fmu->fmi3.booleanTypes = malloc(fmu->fmi3.numberOfBooleanTypes*sizeof(fmi3BooleanType));
+            fmu->fmi3.booleanTypes = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfBooleanTypes*sizeof(fmi3BooleanType));
         }
         if(fmu->fmi3.numberOfStringTypes > 0) {
-            fmu->fmi3.stringTypes = malloc(fmu->fmi3.numberOfStringTypes*sizeof(fmi3StringType));
+            fmu->fmi3.stringTypes = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfStringTypes*sizeof(fmi3StringType));
         }
         if(fmu->fmi3.numberOfBinaryTypes > 0) {
-            fmu->fmi3.binaryTypes = malloc(fmu->fmi3.numberOfBinaryTypes*sizeof(fmi3BinaryType));
+            fmu->fmi3.binaryTypes = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfBinaryTypes*sizeof(fmi3BinaryType));
         }
         if(fmu->fmi3.numberOfEnumerationTypes > 0) {
-            fmu->fmi3.enumTypes = malloc(fmu->fmi3.numberOfEnumerationTypes*sizeof(fmi3EnumerationType));
+            fmu->fmi3.enumTypes = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfEnumerationTypes*sizeof(fmi3EnumerationType));
         }
         if(fmu->fmi3.numberOfClockTypes > 0) {
-            fmu->fmi3.clockTypes = malloc(fmu->fmi3.numberOfClockTypes*sizeof(fmi3ClockType));
+            fmu->fmi3.clockTypes = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfClockTypes*sizeof(fmi3ClockType));
         }
 
         //Read all elements
@@ -894,8 +1536,8 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
         int iBinary = 0;
         int iEnum = 0;
         int iClock = 0;
-        for(ezxml_t typeElement = typeDefinitionsElement->child; typeElement; typeElement = typeElement->next) {
-            if(!strcmp(typeElement->name, "Float64Type")) {
+        for(fmiXmlElement typeElement = xmlFirstChild(typeDefinitionsElement); typeElement; typeElement = xmlNext(typeElement)) {
+            if(!strcmp(xmlName(typeElement), "Float64Type")) {
                 fmu->fmi3.float64Types[iFloat64].name = "";
                 fmu->fmi3.float64Types[iFloat64].description = "";
                 fmu->fmi3.float64Types[iFloat64].quantity = "";
@@ -906,19 +1548,19 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
                 fmu->fmi3.float64Types[iFloat64].min = -DBL_MAX;
                 fmu->fmi3.float64Types[iFloat64].max = DBL_MAX;
                 fmu->fmi3.float64Types[iFloat64].nominal = 1;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.float64Types[iFloat64].name);
-                parseStringAttributeEzXml(typeElement, "description", &fmu->fmi3.float64Types[iFloat64].description);
-                parseStringAttributeEzXml(typeElement, "quantity", &fmu->fmi3.float64Types[iFloat64].quantity);
-                parseStringAttributeEzXml(typeElement, "unit", &fmu->fmi3.float64Types[iFloat64].unit);
-                parseStringAttributeEzXml(typeElement, "displayUnit", &fmu->fmi3.float64Types[iFloat64].displayUnit);
-                parseBooleanAttributeEzXml(typeElement, "relativeQuantity", &fmu->fmi3.float64Types[iFloat64].relativeQuantity);
-                parseBooleanAttributeEzXml(typeElement, "unbounded", &fmu->fmi3.float64Types[iFloat64].unbounded);
-                parseFloat64AttributeEzXml(typeElement, "min", &fmu->fmi3.float64Types[iFloat64].min);
-                parseFloat64AttributeEzXml(typeElement, "max", &fmu->fmi3.float64Types[iFloat64].max);
-                parseFloat64AttributeEzXml(typeElement, "nominal", &fmu->fmi3.float64Types[iFloat64].nominal);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.float64Types[iFloat64].name, &fmu->arena);
+                parseStringAttributeXml(typeElement, "description", &fmu->fmi3.float64Types[iFloat64].description, &fmu->arena);
+                parseStringAttributeXml(typeElement, "quantity", &fmu->fmi3.float64Types[iFloat64].quantity, &fmu->arena);
+                parseStringAttributeXml(typeElement, "unit", &fmu->fmi3.float64Types[iFloat64].unit, &fmu->arena);
+                parseStringAttributeXml(typeElement, "displayUnit", &fmu->fmi3.float64Types[iFloat64].displayUnit, &fmu->arena);
+                parseBooleanAttributeXml(typeElement, "relativeQuantity", &fmu->fmi3.float64Types[iFloat64].relativeQuantity);
+                parseBooleanAttributeXml(typeElement, "unbounded", &fmu->fmi3.float64Types[iFloat64].unbounded);
+                parseFloat64AttributeXml(typeElement, "min", &fmu->fmi3.float64Types[iFloat64].min);
+                parseFloat64AttributeXml(typeElement, "max", &fmu->fmi3.float64Types[iFloat64].max);
+                parseFloat64AttributeXml(typeElement, "nominal", &fmu->fmi3.float64Types[iFloat64].nominal);
                 ++iFloat64;
             }
-            else if(!strcmp(typeElement->name, "Float32Type")) {
+            else if(!strcmp(xmlName(typeElement), "Float32Type")) {
                 fmu->fmi3.float32Types[iFloat32].name = "";
                 fmu->fmi3.float32Types[iFloat32].description = "";
                 fmu->fmi3.float32Types[iFloat32].quantity = "";
@@ -929,153 +1571,155 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
                 fmu->fmi3.float32Types[iFloat32].min = -FLT_MAX;
                 fmu->fmi3.float32Types[iFloat32].max = FLT_MAX;
                 fmu->fmi3.float32Types[iFloat32].nominal = 1;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.float32Types[iFloat32].name);
-                parseStringAttributeEzXml(typeElement, "description", &fmu->fmi3.float32Types[iFloat32].description);
-                parseStringAttributeEzXml(typeElement, "quantity", &fmu->fmi3.float32Types[iFloat32].quantity);
-                parseStringAttributeEzXml(typeElement, "unit", &fmu->fmi3.float32Types[iFloat32].unit);
-                parseStringAttributeEzXml(typeElement, "displayUnit", &fmu->fmi3.float32Types[iFloat32].displayUnit);
-                parseBooleanAttributeEzXml(typeElement, "relativeQuantity", &fmu->fmi3.float32Types[iFloat32].relativeQuantity);
-                parseBooleanAttributeEzXml(typeElement, "unbounded", &fmu->fmi3.float32Types[iFloat32].unbounded);
-                parseFloat32AttributeEzXml(typeElement, "min", &fmu->fmi3.float32Types[iFloat32].min);
-                parseFloat32AttributeEzXml(typeElement, "max", &fmu->fmi3.float32Types[iFloat32].max);
-                parseFloat32AttributeEzXml(typeElement, "nominal", &fmu->fmi3.float32Types[iFloat32].nominal);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.float32Types[iFloat32].name, &fmu->arena);
+                parseStringAttributeXml(typeElement, "description", &fmu->fmi3.float32Types[iFloat32].description, &fmu->arena);
+                parseStringAttributeXml(typeElement, "quantity", &fmu->fmi3.float32Types[iFloat32].quantity, &fmu->arena);
+                parseStringAttributeXml(typeElement, "unit", &fmu->fmi3.float32Types[iFloat32].unit, &fmu->arena);
+                parseStringAttributeXml(typeElement, "displayUnit", &fmu->fmi3.float32Types[iFloat32].displayUnit, &fmu->arena);
+                parseBooleanAttributeXml(typeElement, "relativeQuantity", &fmu->fmi3.float32Types[iFloat32].relativeQuantity);
+                parseBooleanAttributeXml(typeElement, "unbounded", &fmu->fmi3.float32Types[iFloat32].unbounded);
+                parseFloat32AttributeXml(typeElement, "min", &fmu->fmi3.float32Types[iFloat32].min);
+                parseFloat32AttributeXml(typeElement, "max", &fmu->fmi3.float32Types[iFloat32].max);
+                parseFloat32AttributeXml(typeElement, "nominal", &fmu->fmi3.float32Types[iFloat32].nominal);
                 ++iFloat32;
             }
-            else if(!strcmp(typeElement->name, "Int64Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int64Type")) {
                 fmu->fmi3.int64Types[iInt64].name = "";
                 fmu->fmi3.int64Types[iInt64].min = -INT64_MAX;
                 fmu->fmi3.int64Types[iInt64].max = INT64_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.int64Types[iInt64].name);
-                parseInt64AttributeEzXml(typeElement, "min", &fmu->fmi3.int64Types[iInt64].min);
-                parseInt64AttributeEzXml(typeElement, "max", &fmu->fmi3.int64Types[iInt64].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.int64Types[iInt64].name, &fmu->arena);
+                parseInt64AttributeXml(typeElement, "min", &fmu->fmi3.int64Types[iInt64].min);
+                parseInt64AttributeXml(typeElement, "max", &fmu->fmi3.int64Types[iInt64].max);
                 ++iInt64;
             }
-            else if(!strcmp(typeElement->name, "Int32Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int32Type")) {
                 fmu->fmi3.int32Types[iInt32].name = "";
                 fmu->fmi3.int32Types[iInt32].min = -INT32_MAX;
                 fmu->fmi3.int32Types[iInt32].max = INT32_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.int32Types[iInt32].name);
-                parseInt32AttributeEzXml(typeElement, "min", &fmu->fmi3.int32Types[iInt32].min);
-                parseInt32AttributeEzXml(typeElement, "max", &fmu->fmi3.int32Types[iInt32].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.int32Types[iInt32].name, &fmu->arena);
+                parseInt32AttributeXml(typeElement, "min", &fmu->fmi3.int32Types[iInt32].min);
+                parseInt32AttributeXml(typeElement, "max", &fmu->fmi3.int32Types[iInt32].max);
                 ++iInt32;
             }
-            else if(!strcmp(typeElement->name, "Int16Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int16Type")) {
                 fmu->fmi3.int16Types[iInt16].name = "";
                 fmu->fmi3.int16Types[iInt16].min = -INT16_MAX;
                 fmu->fmi3.int16Types[iInt16].max = INT16_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.int16Types[iInt16].name);
-                parseInt16AttributeEzXml(typeElement, "min", &fmu->fmi3.int16Types[iInt16].min);
-                parseInt16AttributeEzXml(typeElement, "max", &fmu->fmi3.int16Types[iInt16].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.int16Types[iInt16].name, &fmu->arena);
+                parseInt16AttributeXml(typeElement, "min", &fmu->fmi3.int16Types[iInt16].min);
+                parseInt16AttributeXml(typeElement, "max", &fmu->fmi3.int16Types[iInt16].max);
                 ++iInt16;
             }
-            else if(!strcmp(typeElement->name, "Int8Type")) {
+            else if(!strcmp(xmlName(typeElement), "Int8Type")) {
                 fmu->fmi3.int8Types[iInt8].name = "";
                 fmu->fmi3.int8Types[iInt8].min = -INT8_MAX;
                 fmu->fmi3.int8Types[iInt8].max = INT8_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.int8Types[iInt8].name);
-                parseInt8AttributeEzXml(typeElement, "min", &fmu->fmi3.int8Types[iInt8].min);
-                parseInt8AttributeEzXml(typeElement, "max", &fmu->fmi3.int8Types[iInt8].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.int8Types[iInt8].name, &fmu->arena);
+                parseInt8AttributeXml(typeElement, "min", &fmu->fmi3.int8Types[iInt8].min);
+                parseInt8AttributeXml(typeElement, "max", &fmu->fmi3.int8Types[iInt8].max);
                 ++iInt8;
             }
-            else if(!strcmp(typeElement->name, "UInt64Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt64Type")) {
                 fmu->fmi3.uint64Types[iUInt64].name = "";
                 fmu->fmi3.uint64Types[iUInt64].min = 0;
                 fmu->fmi3.uint64Types[iUInt64].max = UINT64_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.uint64Types[iUInt64].name);
-                parseUInt64AttributeEzXml(typeElement, "min", &fmu->fmi3.uint64Types[iUInt64].min);
-                parseUInt64AttributeEzXml(typeElement, "max", &fmu->fmi3.uint64Types[iUInt64].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.uint64Types[iUInt64].name, &fmu->arena);
+                parseUInt64AttributeXml(typeElement, "min", &fmu->fmi3.uint64Types[iUInt64].min);
+                parseUInt64AttributeXml(typeElement, "max", &fmu->fmi3.uint64Types[iUInt64].max);
                 ++iUInt64;
             }
-            else if(!strcmp(typeElement->name, "UInt32Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt32Type")) {
                 fmu->fmi3.uint32Types[iUInt32].name = "";
                 fmu->fmi3.uint32Types[iUInt32].min = 0;
                 fmu->fmi3.uint32Types[iUInt32].max = UINT32_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.uint32Types[iUInt32].name);
-                parseUInt32AttributeEzXml(typeElement, "min", &fmu->fmi3.uint32Types[iUInt32].min);
-                parseUInt32AttributeEzXml(typeElement, "max", &fmu->fmi3.uint32Types[iUInt32].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.uint32Types[iUInt32].name, &fmu->arena);
+                parseUInt32AttributeXml(typeElement, "min", &fmu->fmi3.uint32Types[iUInt32].min);
+                parseUInt32AttributeXml(typeElement, "max", &fmu->fmi3.uint32Types[iUInt32].max);
                 ++iUInt32;
             }
-            else if(!strcmp(typeElement->name, "UInt16Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt16Type")) {
                 fmu->fmi3.uint16Types[iUInt16].name = "";
                 fmu->fmi3.uint16Types[iUInt16].min = 0;
                 fmu->fmi3.uint16Types[iUInt16].max = UINT16_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.uint16Types[iUInt16].name);
-                parseUInt16AttributeEzXml(typeElement, "min", &fmu->fmi3.uint16Types[iUInt16].min);
-                parseUInt16AttributeEzXml(typeElement, "max", &fmu->fmi3.uint16Types[iUInt16].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.uint16Types[iUInt16].name, &fmu->arena);
+                parseUInt16AttributeXml(typeElement, "min", &fmu->fmi3.uint16Types[iUInt16].min);
+                parseUInt16AttributeXml(typeElement, "max", &fmu->fmi3.uint16Types[iUInt16].max);
                 ++iUInt16;
             }
-            else if(!strcmp(typeElement->name, "UInt8Type")) {
+            else if(!strcmp(xmlName(typeElement), "UInt8Type")) {
                 fmu->fmi3.uint8Types[iUInt8].name = "";
                 fmu->fmi3.uint8Types[iUInt8].min = 0;
                 fmu->fmi3.uint8Types[iUInt8].max = UINT8_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.uint8Types[iUInt8].name);
-                parseUInt8AttributeEzXml(typeElement, "min", &fmu->fmi3.uint8Types[iUInt8].min);
-                parseUInt8AttributeEzXml(typeElement, "max", &fmu->fmi3.uint8Types[iUInt8].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.uint8Types[iUInt8].name, &fmu->arena);
+                parseUInt8AttributeXml(typeElement, "min", &fmu->fmi3.uint8Types[iUInt8].min);
+                parseUInt8AttributeXml(typeElement, "max", &fmu->fmi3.uint8Types[iUInt8].max);
                 ++iUInt8;
             }
-            else if(!strcmp(typeElement->name, "BooleanType")) {
+            else if(!strcmp(xmlName(typeElement), "BooleanType")) {
                 fmu->fmi3.booleanTypes[iBoolean].name = "";
                 fmu->fmi3.booleanTypes[iBoolean].description = "";
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.booleanTypes[iBoolean].name);
-                parseStringAttributeEzXml(typeElement, "description", &fmu->fmi3.booleanTypes[iBoolean].description);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.booleanTypes[iBoolean].name, &fmu->arena);
+                parseStringAttributeXml(typeElement, "description", &fmu->fmi3.booleanTypes[iBoolean].description, &fmu->arena);
                 ++iBoolean;
             }
-            else if(!strcmp(typeElement->name, "StringType")) {
+            else if(!strcmp(xmlName(typeElement), "StringType")) {
                 fmu->fmi3.stringTypes[iString].name = "";
                 fmu->fmi3.stringTypes[iString].description = "";
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.stringTypes[iString].name);
-                parseStringAttributeEzXml(typeElement, "description", &fmu->fmi3.stringTypes[iString].description);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.stringTypes[iString].name, &fmu->arena);
+                parseStringAttributeXml(typeElement, "description", &fmu->fmi3.stringTypes[iString].description, &fmu->arena);
                 ++iString;
             }
-            else if(!strcmp(typeElement->name, "BinaryType")) {
+            else if(!strcmp(xmlName(typeElement), "BinaryType")) {
                 fmu->fmi3.binaryTypes[iBinary].name = "";
                 fmu->fmi3.binaryTypes[iBinary].description = "";
                 fmu->fmi3.binaryTypes[iBinary].mimeType = "application/octet-stream";
                 fmu->fmi3.binaryTypes[iBinary].maxSize = UINT32_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.binaryTypes[iBinary].name);
-                parseStringAttributeEzXml(typeElement, "description", &fmu->fmi3.binaryTypes[iBinary].description);
-                parseStringAttributeEzXml(typeElement, "mimeType", &fmu->fmi3.binaryTypes[iBinary].mimeType);
-                parseUInt32AttributeEzXml(typeElement, "maxSize", &fmu->fmi3.binaryTypes[iBinary].maxSize);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.binaryTypes[iBinary].name, &fmu->arena);
+                parseStringAttributeXml(typeElement, "description", &fmu->fmi3.binaryTypes[iBinary].description, &fmu->arena);
+                parseStringAttributeXml(typeElement, "mimeType", &fmu->fmi3.binaryTypes[iBinary].mimeType, &fmu->arena);
+                parseUInt32AttributeXml(typeElement, "maxSize", &fmu->fmi3.binaryTypes[iBinary].maxSize);
                 ++iBinary;
             }
-            else if(!strcmp(typeElement->name, "EnumerationType")) {
+            else if(!strcmp(xmlName(typeElement), "EnumerationType")) {
                 fmu->fmi3.enumTypes[iEnum].name = "";
                 fmu->fmi3.enumTypes[iEnum].description = "";
                 fmu->fmi3.enumTypes[iEnum].quantity = "";
                 fmu->fmi3.enumTypes[iEnum].min = -INT64_MAX;
                 fmu->fmi3.enumTypes[iEnum].max = INT64_MAX;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.enumTypes[iEnum].name);
-                parseStringAttributeEzXml(typeElement, "description", &fmu->fmi3.enumTypes[iEnum].description);
-                parseStringAttributeEzXml(typeElement, "quantity", &fmu->fmi3.enumTypes[iEnum].quantity);
-                parseInt64AttributeEzXml(typeElement, "min", &fmu->fmi3.enumTypes[iEnum].min);
-                parseInt64AttributeEzXml(typeElement, "max", &fmu->fmi3.enumTypes[iEnum].max);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.enumTypes[iEnum].name, &fmu->arena);
+                parseStringAttributeXml(typeElement, "description", &fmu->fmi3.enumTypes[iEnum].description, &fmu->arena);
+                parseStringAttributeXml(typeElement, "quantity", &fmu->fmi3.enumTypes[iEnum].quantity, &fmu->arena);
+                parseInt64AttributeXml(typeElement, "min", &fmu->fmi3.enumTypes[iEnum].min);
+                parseInt64AttributeXml(typeElement, "max", &fmu->fmi3.enumTypes[iEnum].max);
 
                 //Count number of enumeration items
                 fmu->fmi3.enumTypes[iEnum].numberOfItems = 0;
-                for(ezxml_t itemElement = typeElement->child; itemElement; itemElement = itemElement->next) {
-                    if(!strcmp(itemElement->name, "Item")) {
+                for(fmiXmlElement itemElement = xmlFirstChild(typeElement); itemElement; itemElement = xmlNext(itemElement)) {
+                    if(!strcmp(xmlName(itemElement), "Item")) {
                         ++fmu->fmi3.enumTypes[iEnum].numberOfItems;
                     }
                 }
 
                 //Allocate memory for enumeration items
                 if(fmu->fmi3.enumTypes[iEnum].numberOfItems > 0) {
-                    fmu->fmi3.enumTypes[iEnum].items = malloc(fmu->fmi3.enumTypes[iEnum].numberOfItems*sizeof(fmi3EnumerationItem));
+                    fmu->fmi3.enumTypes[iEnum].items = arenaAlloc(&fmu->arena, fmu->fmi3.enumTypes[iEnum].numberOfItems*sizeof(fmi3EnumerationItem));
                 }
 
                 //Read data for enumeration items
                 int iItem = 0;
-                for(ezxml_t itemElement = typeElement->child; itemElement; itemElement = itemElement->next) {
-                    if(!strcmp(itemElement->name, "Item")) {
-                        parseStringAttributeEzXml(itemElement, "name", &fmu->fmi3.enumTypes[iEnum].items[iItem].name);
-                        parseInt64AttributeEzXml(itemElement, "value", &fmu->fmi3.enumTypes[iEnum].items[iItem].value);
-                        parseStringAttributeEzXml(itemElement, "description", &fmu->fmi3.enumTypes[iEnum].items[iItem].description);
+                for(fmiXmlElement itemElement = xmlFirstChild(typeElement); itemElement; itemElement = xmlNext(itemElement)) {
+                    if(!strcmp(xmlName(itemElement), "Item")) {
+                        parseStringAttributeXml(itemElement, "name", &fmu->fmi3.enumTypes[iEnum].items[iItem].name, &fmu->arena);
+                        parseInt64AttributeXml(itemElement, "value", &fmu->fmi3.enumTypes[iEnum].items[iItem].value);
+                        if(!(parseOptions & FMI4C_PARSE_SKIP_DESCRIPTIONS)) {
+                            parseStringAttributeXml(itemElement, "description", &fmu->fmi3.enumTypes[iEnum].items[iItem].description, &fmu->arena);
+                        }
                     }
                     ++iItem;
                 }
                 ++iEnum;
             }
-            else if(!strcmp(typeElement->name, "ClockType")) {
+            else if(!strcmp(xmlName(typeElement), "ClockType")) {
                 fmu->fmi3.clockTypes[iClock].name = "";
                 fmu->fmi3.clockTypes[iClock].description = "";
                 fmu->fmi3.clockTypes[iClock].canBeDeactivated = false;
@@ -1087,12 +1731,12 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
                 fmu->fmi3.clockTypes[iClock].resolution = UINT64_MAX;
                 fmu->fmi3.clockTypes[iClock].intervalCounter = UINT64_MAX;
                 fmu->fmi3.clockTypes[iClock].shiftCounter = 0;
-                parseStringAttributeEzXml(typeElement, "name", &fmu->fmi3.clockTypes[iClock].name);
-                parseStringAttributeEzXml(typeElement, "description", &fmu->fmi3.clockTypes[iClock].description);
-                parseBooleanAttributeEzXml(typeElement, "canBeDeactivated", &fmu->fmi3.clockTypes[iClock].canBeDeactivated);
-                parseUInt32AttributeEzXml(typeElement, "priority", &fmu->fmi3.clockTypes[iClock].priority);
+                parseStringAttributeXml(typeElement, "name", &fmu->fmi3.clockTypes[iClock].name, &fmu->arena);
+                parseStringAttributeXml(typeElement, "description", &fmu->fmi3.clockTypes[iClock].description, &fmu->arena);
+                parseBooleanAttributeXml(typeElement, "canBeDeactivated", &fmu->fmi3.clockTypes[iClock].canBeDeactivated);
+                parseUInt32AttributeXml(typeElement, "priority", &fmu->fmi3.clockTypes[iClock].priority);
                 const char* intervalVariability;
-                parseStringAttributeEzXml(typeElement, "intervalVariability", &intervalVariability);
+                parseStringAttributeXml(typeElement, "intervalVariability", &intervalVariability, &fmu->arena);
                 if(intervalVariability && !strcmp(intervalVariability, "calculated")) {
                     fmu->fmi3.clockTypes[iClock].intervalVariability = fmi3IntervalVariabilityCalculated;
                 }
@@ -1118,402 +1762,105 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
                     printf("Unknown interval variability: %s\n", intervalVariability);
                     return false;
                 }
-                parseFloat32AttributeEzXml(typeElement, "intervalDecimal", &fmu->fmi3.clockTypes[iClock].intervalDecimal);
-                parseFloat32AttributeEzXml(typeElement, "shiftDecimal", &fmu->fmi3.clockTypes[iClock].shiftDecimal);
-                parseBooleanAttributeEzXml(typeElement, "supportsFraction", &fmu->fmi3.clockTypes[iClock].supportsFraction);
-                parseUInt64AttributeEzXml(typeElement, "resolution", &fmu->fmi3.clockTypes[iClock].resolution);
-                parseUInt64AttributeEzXml(typeElement, "intervalCounter", &fmu->fmi3.clockTypes[iClock].intervalCounter);
-                parseUInt64AttributeEzXml(typeElement, "shiftCounter", &fmu->fmi3.clockTypes[iClock].shiftCounter);
+                parseFloat32AttributeXml(typeElement, "intervalDecimal", &fmu->fmi3.clockTypes[iClock].intervalDecimal);
+                parseFloat32AttributeXml(typeElement, "shiftDecimal", &fmu->fmi3.clockTypes[iClock].shiftDecimal);
+                parseBooleanAttributeXml(typeElement, "supportsFraction", &fmu->fmi3.clockTypes[iClock].supportsFraction);
+                parseUInt64AttributeXml(typeElement, "resolution", &fmu->fmi3.clockTypes[iClock].resolution);
+                parseUInt64AttributeXml(typeElement, "intervalCounter", &fmu->fmi3.clockTypes[iClock].intervalCounter);
+                parseUInt64AttributeXml(typeElement, "shiftCounter", &fmu->fmi3.clockTypes[iClock].shiftCounter);
                 ++iClock;
             }
         }
     }
 
-    ezxml_t logCategoriesElement = ezxml_child(rootElement, "LogCategories");
+    fmiXmlElement logCategoriesElement = xmlChild(rootElement, "LogCategories");
     fmu->fmi3.numberOfLogCategories = 0;
     if(logCategoriesElement) {
         //Count log categories
-        for(ezxml_t logCategoryElement = logCategoriesElement->child; logCategoryElement; logCategoryElement = logCategoryElement->next) {
+        for(fmiXmlElement logCategoryElement = xmlFirstChild(logCategoriesElement); logCategoryElement; logCategoryElement = xmlNext(logCategoryElement)) {
             ++fmu->fmi3.numberOfLogCategories;
         }
 
         //Allocate memory for log categories
         if(fmu->fmi3.numberOfLogCategories > 0) {
-            fmu->fmi3.logCategories = malloc(fmu->fmi3.numberOfLogCategories*sizeof(fmi3LogCategory));
+            fmu->fmi3.logCategories = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfLogCategories*sizeof(fmi3LogCategory));
         }
 
         //Read log categories
         int i=0;
-        for(ezxml_t logCategoryElement = logCategoriesElement->child; logCategoryElement; logCategoryElement = logCategoryElement->next) {
-            parseStringAttributeEzXml(logCategoryElement, "name", &fmu->fmi3.logCategories[i].name);
-            parseStringAttributeEzXml(logCategoryElement, "description", &fmu->fmi3.logCategories[i].description);
+        for(fmiXmlElement logCategoryElement = xmlFirstChild(logCategoriesElement); logCategoryElement; logCategoryElement = xmlNext(logCategoryElement)) {
+            parseStringAttributeXml(logCategoryElement, "name", &fmu->fmi3.logCategories[i].name, &fmu->arena);
+            parseStringAttributeXml(logCategoryElement, "description", &fmu->fmi3.logCategories[i].description, &fmu->arena);
             ++i;
         }
     }
 
-    ezxml_t defaultExperimentElement = ezxml_child(rootElement, "DefaultExperiment");
+    fmiXmlElement defaultExperimentElement = xmlChild(rootElement, "DefaultExperiment");
     if(defaultExperimentElement) {
-        fmu->fmi3.defaultStartTimeDefined = parseFloat64AttributeEzXml(defaultExperimentElement, "startTime", &fmu->fmi3.defaultStartTime);
-        fmu->fmi3.defaultStopTimeDefined =  parseFloat64AttributeEzXml(defaultExperimentElement, "stopTime",  &fmu->fmi3.defaultStopTime);
-        fmu->fmi3.defaultToleranceDefined = parseFloat64AttributeEzXml(defaultExperimentElement, "tolerance", &fmu->fmi3.defaultTolerance);
-        fmu->fmi3.defaultStepSizeDefined =  parseFloat64AttributeEzXml(defaultExperimentElement, "stepSize",  &fmu->fmi3.defaultStepSize);
+        fmu->fmi3.defaultStartTimeDefined = parseFloat64AttributeXml(defaultExperimentElement, "startTime", &fmu->fmi3.defaultStartTime);
+        fmu->fmi3.defaultStopTimeDefined =  parseFloat64AttributeXml(defaultExperimentElement, "stopTime",  &fmu->fmi3.defaultStopTime);
+        fmu->fmi3.defaultToleranceDefined = parseFloat64AttributeXml(defaultExperimentElement, "tolerance", &fmu->fmi3.defaultTolerance);
+        fmu->fmi3.defaultStepSizeDefined =  parseFloat64AttributeXml(defaultExperimentElement, "stepSize",  &fmu->fmi3.defaultStepSize);
     }
 
-    ezxml_t modelVariablesElement = ezxml_child(rootElement, "ModelVariables");
+    fmiXmlElement modelVariablesElement = xmlChild(rootElement, "ModelVariables");
     if(modelVariablesElement) {
-        for(ezxml_t varElement = modelVariablesElement->child; varElement; varElement = varElement->next) {
-            fmi3VariableHandle var;
-            var.name = NULL;
-            var.description = NULL;
-            var.quantity = NULL;
-            var.unit = NULL;
-            var.displayUnit = NULL;
-            var.canHandleMultipleSetPerTimeInstant = false; //Default value if attribute not defined
-            var.startBinary = NULL;
-
-            parseStringAttributeEzXml(varElement, "name", &var.name);
-            parseInt64AttributeEzXml(varElement, "valueReference", &var.valueReference);
-            parseStringAttributeEzXml(varElement, "description", &var.description);
-            parseBooleanAttributeEzXml(varElement, "canHandleMultipleSetPerTimeInstant", &var.canHandleMultipleSetPerTimeInstant);
-            parseBooleanAttributeEzXml(varElement, "intermediateUpdate", &var.intermediateUpdate);
-            parseUInt32AttributeEzXml(varElement, "previous", &var.previous);
-            parseStringAttributeEzXml(varElement, "declaredType", &var.declaredType);
-            const char* clocks = "";
-            parseStringAttributeEzXml(varElement, "clocks", &clocks);
-            char* nonConstClocks = _strdup(clocks);
-
-            //Count number of clocks
-            var.numberOfClocks = 0;
-            if(nonConstClocks[0]) {
-                var.numberOfClocks = 1;
-            }
-            for(int i=0; nonConstClocks[i]; ++i) {
-                if(nonConstClocks[i] == ' ') {
-                    ++var.numberOfClocks;
-                }
-            }
-
-            //Allocate memory for clocks
-            if(var.numberOfClocks > 0) {
-                var.clocks = malloc(var.numberOfClocks*sizeof(int));
-            }
-
-            //Read clocks
-            const char* delim = " ";
-            for(int i=0; i<var.numberOfClocks; ++i) {
-                if(i == 0) {
-                    var.clocks[i] = atoi(strtok(nonConstClocks, delim));
-                }
-                else {
-                    var.clocks[i] = atoi(strtok(NULL, delim));
-                }
-            }
-
-            free(nonConstClocks);
-
-            //Figure out data type
-            if(!strcmp(varElement->name, "Float64")) {
-                var.datatype = fmi3DataTypeFloat64;
-                fmu->fmi3.hasFloat64Variables = true;
-                parseFloat64AttributeEzXml(varElement, "start", &var.startFloat64);
-            }
-            else if(!strcmp(varElement->name, "Float32")) {
-                var.datatype = fmi3DataTypeFloat32;
-                fmu->fmi3.hasFloat32Variables = true;
-                parseFloat32AttributeEzXml(varElement, "start", &var.startFloat32);
-            }
-            else if(!strcmp(varElement->name, "Int64")) {
-                var.datatype = fmi3DataTypeInt64;
-                fmu->fmi3.hasInt64Variables = true;
-                parseInt64AttributeEzXml(varElement, "start", &var.startInt64);
-            }
-            else if(!strcmp(varElement->name, "Int32")) {
-                var.datatype = fmi3DataTypeInt32;
-                fmu->fmi3.hasInt32Variables = true;
-                parseInt32AttributeEzXml(varElement, "start", &var.startInt32);
-            }
-            else if(!strcmp(varElement->name, "Int16")) {
-                var.datatype = fmi3DataTypeInt16;
-                fmu->fmi3.hasInt16Variables = true;
-                parseInt16AttributeEzXml(varElement, "start", &var.startInt16);
-            }
-            else if(!strcmp(varElement->name, "Int8")) {
-                var.datatype = fmi3DataTypeInt8;
-                fmu->fmi3.hasInt8Variables = true;
-                parseInt8AttributeEzXml(varElement, "start", &var.startInt8);
-            }
-            else if(!strcmp(varElement->name, "UInt64")) {
-                var.datatype = fmi3DataTypeUInt64;
-                fmu->fmi3.hasUInt64Variables = true;
-                parseUInt64AttributeEzXml(varElement, "start", &var.startUInt64);
-            }
-            else if(!strcmp(varElement->name, "UInt32")) {
-                var.datatype = fmi3DataTypeUInt32;
-                fmu->fmi3.hasUInt32Variables = true;
-                parseUInt32AttributeEzXml(varElement, "start", &var.startUInt32);
-            }
-            else if(!strcmp(varElement->name, "UInt16")) {
-                var.datatype = fmi3DataTypeUInt16;
-                fmu->fmi3.hasUInt16Variables = true;
-                parseUInt16AttributeEzXml(varElement, "start", &var.startUInt16);
-            }
-            else if(!strcmp(varElement->name, "UInt8")) {
-                var.datatype = fmi3DataTypeUInt8;
-                fmu->fmi3.hasUInt8Variables = true;
-                parseUInt8AttributeEzXml(varElement, "start", &var.startUInt8);
-            }
-            else if(!strcmp(varElement->name, "Boolean")) {
-                var.datatype = fmi3DataTypeBoolean;
-                fmu->fmi3.hasBooleanVariables = true;
-                parseBooleanAttributeEzXml(varElement, "start", &var.startBoolean);
-            }
-            else if(!strcmp(varElement->name, "String")) {
-                var.datatype = fmi3DataTypeString;
-                fmu->fmi3.hasStringVariables = true;
-                parseStringAttributeEzXml(varElement, "start", &var.startString);
-            }
-            else if(!strcmp(varElement->name, "Binary")) {
-                var.datatype = fmi3DataTypeBinary;
-                fmu->fmi3.hasBinaryVariables = true;
-                parseUInt8AttributeEzXml(varElement, "start", var.startBinary);
-            }
-            else if(!strcmp(varElement->name, "Enumeration")) {
-                var.datatype = fmi3DataTypeEnumeration;
-                fmu->fmi3.hasEnumerationVariables = true;
-                parseInt64AttributeEzXml(varElement, "start", &var.startEnumeration);
-            }
-            else if(!strcmp(varElement->name, "Clock")) {
-                var.datatype = fmi3DataTypeClock;
-                fmu->fmi3.hasClockVariables = true;
-                parseBooleanAttributeEzXml(varElement, "start", &var.startClock);
-            }
-
-            const char* causality = "local";
-            parseStringAttributeEzXml(varElement, "causality", &causality);
-            if(!strcmp(causality, "parameter")) {
-                var.causality = fmi3CausalityParameter;
-            }
-            else if(!strcmp(causality, "calculatedParameter")) {
-                var.causality = fmi3CausalityCalculatedParameter;
-            }
-            else if(!strcmp(causality, "input")) {
-                var.causality = fmi3CausalityInput;
-            }
-            else if(!strcmp(causality, "output")) {
-                var.causality = fmi3CausalityOutput;
-            }
-            else if(!strcmp(causality, "local")) {
-                var.causality = fmi3CausalityLocal;
-            }
-            else if(!strcmp(causality, "independent")) {
-                var.causality = fmi3CausalityIndependent;
-            }
-            else if(!strcmp(causality, "structuralParameter")) {
-                var.causality = fmi3CausalityStructuralParameter;
-            }
-            else {
-                printf("Unknown causality: %s\n", causality);
-                if(var.numberOfClocks > 0) {
-                    free(var.clocks);
-                }
-                free((char*)causality);
-                return false;
-            }
-            free((char*)causality);
-
-            const char* variability;
-            if(var.datatype == fmi3DataTypeFloat64 || var.datatype == fmi3DataTypeFloat32) {
-                variability = "continuous";
-            }
-            else {
-                variability = "discrete";
-            }
-            parseStringAttributeEzXml(varElement, "variability", &variability);
-            if(variability && !strcmp(variability, "constant")) {
-                var.variability = fmi3VariabilityConstant;
-            }
-            else if(variability && !strcmp(variability, "fixed")) {
-                var.variability = fmi3VariabilityFixed;
-            }
-            else if(variability && !strcmp(variability, "tunable")) {
-                var.variability = fmi3VariabilityTunable;
-            }
-            else if(variability && !strcmp(variability, "discrete")) {
-                var.variability = fmi3VariabilityDiscrete;
-            }
-            else if(variability && !strcmp(variability, "continuous")) {
-                var.variability = fmi3VariabilityContinuous;
-            }
-            else if(variability) {
-                printf("Unknown variability: %s\n", variability);
-                free((char*)variability);
+        //Variables of different types are only linked in document order
+        for(fmiXmlElement varElement = xmlFirstChild(modelVariablesElement); varElement; varElement = xmlNextSibling(varElement)) {
+            if(!parseVariableFmi3(fmu, varElement)) {
                 return false;
             }
-            free((char*)variability);
-
-            //Parse arguments common to all except clock type
-            if(var.datatype == fmi3DataTypeFloat64 ||
-               var.datatype == fmi3DataTypeFloat32 ||
-               var.datatype == fmi3DataTypeInt64 ||
-               var.datatype == fmi3DataTypeInt32 ||
-               var.datatype == fmi3DataTypeInt16 ||
-               var.datatype == fmi3DataTypeInt8 ||
-               var.datatype == fmi3DataTypeUInt64 ||
-               var.datatype == fmi3DataTypeUInt32 ||
-               var.datatype == fmi3DataTypeUInt16 ||
-               var.datatype == fmi3DataTypeUInt8 ||
-               var.datatype == fmi3DataTypeBoolean ||
-               var.datatype == fmi3DataTypeBinary ||
-               var.datatype == fmi3DataTypeEnumeration) {
-                const char* initial = NULL;
-                parseStringAttributeEzXml(varElement, "initial", &initial);
-                if(initial && !strcmp(initial, "approx")) {
-                    var.initial = fmi3InitialApprox;
-                }
-                else if(initial && !strcmp(initial, "exact")) {
-                    var.initial = fmi3InitialExact;
-                }
-                else if(initial && !strcmp(initial, "calculated")) {
-                    var.initial = fmi3InitialCalculated;
-                }
-                else if(initial) {
-                    printf("Unknown initial: %s\n", initial);
-                    return false;
-                }
-            }
-
-            //Parse arguments common to float, int and enumeration
-            if(var.datatype == fmi3DataTypeFloat64 ||
-               var.datatype == fmi3DataTypeFloat32 ||
-               var.datatype == fmi3DataTypeInt64 ||
-               var.datatype == fmi3DataTypeInt32 ||
-               var.datatype == fmi3DataTypeInt16 ||
-               var.datatype == fmi3DataTypeInt8 ||
-               var.datatype == fmi3DataTypeUInt64 ||
-               var.datatype == fmi3DataTypeUInt32 ||
-               var.datatype == fmi3DataTypeUInt16 ||
-               var.datatype == fmi3DataTypeUInt8 ||
-               var.datatype == fmi3DataTypeEnumeration) {
-                parseStringAttributeEzXml(varElement,  "quantity", &var.quantity);
-                parseFloat64AttributeEzXml(varElement,  "min", &var.min);
-                parseFloat64AttributeEzXml(varElement,  "max", &var.max);
-            }
-
-            //Parse arguments only in float type
-            if(var.datatype == fmi3DataTypeFloat64 ||
-               var.datatype == fmi3DataTypeFloat32) {
-                parseStringAttributeEzXml(varElement,  "unit", &var.unit);
-                parseStringAttributeEzXml(varElement,  "displayUnit", &var.displayUnit);
-                parseBooleanAttributeEzXml(varElement, "relativeQuantity", &var.relativeQuantity);
-                parseBooleanAttributeEzXml(varElement, "unbounded", &var.unbounded);
-                parseFloat64AttributeEzXml(varElement,  "nominal", &var.nominal);
-                parseUInt32AttributeEzXml(varElement, "derivative", &var.derivative);
-                parseBooleanAttributeEzXml(varElement, "reinit", &var.reInit);
-            }
-
-            //Parse arguments only in binary type
-            if(var.datatype == fmi3DataTypeBinary) {
-                parseStringAttributeEzXml(varElement, "mimeType", &var.mimeType);
-                parseInt32AttributeEzXml(varElement, "maxSize", &var.maxSize);
-            }
-
-            if(var.datatype == fmi3DataTypeClock) {
-                parseBooleanAttributeEzXml(varElement, "canBeDeactivated", &var.canBeDeactivated);
-                parseInt32AttributeEzXml(varElement, "priority", &var.priority);
-                parseFloat64AttributeEzXml(varElement, "intervalDecimal", &var.intervalDecimal);
-                parseFloat64AttributeEzXml(varElement, "shiftDecimal", &var.shiftDecimal);
-                parseBooleanAttributeEzXml(varElement, "supportsFraction", &var.supportsFraction);
-                parseInt64AttributeEzXml(varElement, "resolution", &var.resolution);
-                parseInt64AttributeEzXml(varElement, "intervalCounter", &var.intervalCounter);
-                parseInt64AttributeEzXml(varElement, "shiftCounter", &var.shiftCounter);
-                const char* intervalVariability;
-                parseStringAttributeEzXml(varElement, "intervalVariability", &intervalVariability);
-                if(intervalVariability && !strcmp(intervalVariability, "calculated")) {
-                    var.intervalVariability = fmi3IntervalVariabilityCalculated;
-                }
-                else if(intervalVariability && !strcmp(intervalVariability, "changing")) {
-                    var.intervalVariability = fmi3IntervalVariabilityChanging;
-                }
-                else if(intervalVariability && !strcmp(intervalVariability, "constant")) {
-                    var.intervalVariability = fmi3IntervalVariabilityConstant;
-                }
-                else if(intervalVariability && !strcmp(intervalVariability, "countdown")) {
-                    var.intervalVariability = fmi3IntervalVariabilityCountdown;
-                }
-                else if(intervalVariability && !strcmp(intervalVariability, "fixed")) {
-                    var.intervalVariability = fmi3IntervalVariabilityFixed;
-                }
-                else if(intervalVariability && !strcmp(intervalVariability, "triggered")) {
-                    var.intervalVariability = fmi3IntervalVariabilityTriggered;
-                }
-                else if(intervalVariability && !strcmp(intervalVariability, "tunable")) {
-                    var.intervalVariability = fmi3IntervalVariabilityTunable;
-                }
-                else if(intervalVariability) {
-                    printf("Unknown interval variability: %s\n", intervalVariability);
-                    return false;
-                }
-            }
-
-            if(fmu->fmi3.numberOfVariables >= fmu->fmi3.variablesSize) {
-                fmu->fmi3.variablesSize *= 2;
-                fmu->fmi3.variables = realloc(fmu->fmi3.variables, fmu->fmi3.variablesSize*sizeof(fmi3VariableHandle));
-            }
-
-
-
-            fmu->fmi3.variables[fmu->fmi3.numberOfVariables] = var;
-            fmu->fmi3.numberOfVariables++;
-            if(var.numberOfClocks > 0) {
-                free(var.clocks);
-            }
         }
     }
 
-    ezxml_t modelStructureElement = ezxml_child(rootElement, "ModelStructure");
+    fmiXmlElement modelStructureElement = xmlChild(rootElement, "ModelStructure");
     fmu->fmi3.numberOfOutputs = 0;
+    fmu->fmi3.numberOfContinuousStateDerivatives = 0;
+    fmu->fmi3.numberOfClockedStates = 0;
+    fmu->fmi3.numberOfInitialUnknowns = 0;
+    fmu->fmi3.numberOfEventIndicators = 0;
+    fmu->fmi3.outputs = NULL;
+    fmu->fmi3.continuousStateDerivatives = NULL;
+    fmu->fmi3.clockedStates = NULL;
+    fmu->fmi3.initialUnknowns = NULL;
+    fmu->fmi3.eventIndicators = NULL;
     if(modelStructureElement) {
         //Count each element type
-        ezxml_t outputElement = ezxml_child(modelStructureElement, "Output");
-        for(;outputElement;outputElement = outputElement->next) {
+        fmiXmlElement outputElement = xmlChild(modelStructureElement, "Output");
+        for(;outputElement;outputElement = xmlNext(outputElement)) {
             ++fmu->fmi3.numberOfOutputs;
         }
-        ezxml_t continuousStateDerElement = ezxml_child(modelStructureElement, "ContinuousStateDerivative");
-        for(;continuousStateDerElement;continuousStateDerElement = continuousStateDerElement->next) {
+        fmiXmlElement continuousStateDerElement = xmlChild(modelStructureElement, "ContinuousStateDerivative");
+        for(;continuousStateDerElement;continuousStateDerElement = xmlNext(continuousStateDerElement)) {
             ++fmu->fmi3.numberOfContinuousStateDerivatives;
         }
-        ezxml_t clockedStateElement = ezxml_child(modelStructureElement, "ClockedState");
-        for(;clockedStateElement;clockedStateElement = clockedStateElement->next) {
+        fmiXmlElement clockedStateElement = xmlChild(modelStructureElement, "ClockedState");
+        for(;clockedStateElement;clockedStateElement = xmlNext(clockedStateElement)) {
             ++fmu->fmi3.numberOfClockedStates;
         }
-        ezxml_t initialUnknownElement = ezxml_child(modelStructureElement, "InitialUnknown");
-        for(;initialUnknownElement;initialUnknownElement = initialUnknownElement->next) {
+        fmiXmlElement initialUnknownElement = xmlChild(modelStructureElement, "InitialUnknown");
+        for(;initialUnknownElement;initialUnknownElement = xmlNext(initialUnknownElement)) {
             ++fmu->fmi3.numberOfInitialUnknowns;
         }
-        ezxml_t eventIndicatorElement = ezxml_child(modelStructureElement, "EventIndicator");
-        for(;eventIndicatorElement;eventIndicatorElement = eventIndicatorElement->next) {
+        fmiXmlElement eventIndicatorElement = xmlChild(modelStructureElement, "EventIndicator");
+        for(;eventIndicatorElement;eventIndicatorElement = xmlNext(eventIndicatorElement)) {
             ++fmu->fmi3.numberOfEventIndicators;
         }
 
         //Allocate memory for each element type
-        fmu->fmi3.outputs = NULL;
-        fmu->fmi3.continuousStateDerivatives = NULL;
-        fmu->fmi3.clockedStates = NULL;
-        fmu->fmi3.initialUnknowns = NULL;
-        fmu->fmi3.eventIndicators = NULL;
         if(fmu->fmi3.numberOfOutputs > 0) {
-            fmu->fmi3.outputs = malloc(fmu->fmi3.numberOfOutputs*sizeof(fmi3ModelStructureElement));
+            fmu->fmi3.outputs = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfOutputs*sizeof(fmi3ModelStructureElement));
         }
-        fmu->fmi3.continuousStateDerivatives = malloc(fmu->fmi3.numberOfContinuousStateDerivatives*sizeof(fmi3ModelStructureElement));
-        fmu->fmi3.clockedStates = malloc(fmu->fmi3.numberOfClockedStates*sizeof(fmi3ModelStructureElement));
-        fmu->fmi3.initialUnknowns = malloc(fmu->fmi3.numberOfInitialUnknowns*sizeof(fmi3ModelStructureElement));
-        fmu->fmi3.eventIndicators = malloc(fmu->fmi3.numberOfEventIndicators*sizeof(fmi3ModelStructureElement));
+        fmu->fmi3.continuousStateDerivatives = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfContinuousStateDerivatives*sizeof(fmi3ModelStructureElement));
+        fmu->fmi3.clockedStates = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfClockedStates*sizeof(fmi3ModelStructureElement));
+        fmu->fmi3.initialUnknowns = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfInitialUnknowns*sizeof(fmi3ModelStructureElement));
+        fmu->fmi3.eventIndicators = arenaAlloc(&fmu->arena, fmu->fmi3.numberOfEventIndicators*sizeof(fmi3ModelStructureElement));
 
         //Read outputs
         int i=0;
-        outputElement = ezxml_child(modelStructureElement, "Output");
-        for(;outputElement;outputElement = outputElement->next) {
-            if(!parseModelStructureElement(&fmu->fmi3.outputs[i], &outputElement)) {
+        outputElement = xmlChild(modelStructureElement, "Output");
+        for(;outputElement;outputElement = xmlNext(outputElement)) {
+            if(!parseModelStructureElement(&fmu->fmi3.outputs[i], &outputElement, &fmu->arena)) {
                 return false;
             }
             ++i;
@@ -1521,9 +1868,9 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
 
         //Read continuous state derivatives
         i=0;
-        continuousStateDerElement = ezxml_child(modelStructureElement, "ContinuousStateDerivative");
-        for(;continuousStateDerElement;continuousStateDerElement = continuousStateDerElement->next) {
-            if(!parseModelStructureElement(&fmu->fmi3.continuousStateDerivatives[i], &continuousStateDerElement)) {
+        continuousStateDerElement = xmlChild(modelStructureElement, "ContinuousStateDerivative");
+        for(;continuousStateDerElement;continuousStateDerElement = xmlNext(continuousStateDerElement)) {
+            if(!parseModelStructureElement(&fmu->fmi3.continuousStateDerivatives[i], &continuousStateDerElement, &fmu->arena)) {
                 return false;
             }
             ++i;
@@ -1531,9 +1878,9 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
 
         //Read clocked states
         i=0;
-        clockedStateElement = ezxml_child(modelStructureElement, "ClockedState");
-        for(;clockedStateElement;clockedStateElement = clockedStateElement->next) {
-            if(!parseModelStructureElement(&fmu->fmi3.clockedStates[i], &clockedStateElement)) {
+        clockedStateElement = xmlChild(modelStructureElement, "ClockedState");
+        for(;clockedStateElement;clockedStateElement = xmlNext(clockedStateElement)) {
+            if(!parseModelStructureElement(&fmu->fmi3.clockedStates[i], &clockedStateElement, &fmu->arena)) {
                 return false;
             }
             ++i;
@@ -1541,9 +1888,9 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
 
         //Read initial unknowns
         i=0;
-        initialUnknownElement = ezxml_child(modelStructureElement, "IninitalUnknown");
-        for(;initialUnknownElement;initialUnknownElement = initialUnknownElement->next) {
-            if(!parseModelStructureElement(&fmu->fmi3.initialUnknowns[i], &initialUnknownElement)) {
+        initialUnknownElement = xmlChild(modelStructureElement, "IninitalUnknown");
+        for(;initialUnknownElement;initialUnknownElement = xmlNext(initialUnknownElement)) {
+            if(!parseModelStructureElement(&fmu->fmi3.initialUnknowns[i], &initialUnknownElement, &fmu->arena)) {
                 return false;
             }
             ++i;
@@ -1551,19 +1898,15 @@ bool parseModelDescriptionFmi3(fmiHandle *fmu)
 
         //Read event indicators
         i=0;
-        eventIndicatorElement = ezxml_child(modelStructureElement, "EventIndicator");
-        for(;eventIndicatorElement;eventIndicatorElement = eventIndicatorElement->next) {
-            if(!parseModelStructureElement(&fmu->fmi3.eventIndicators[i], &eventIndicatorElement)) {
+        eventIndicatorElement = xmlChild(modelStructureElement, "EventIndicator");
+        for(;eventIndicatorElement;eventIndicatorElement = xmlNext(eventIndicatorElement)) {
+            if(!parseModelStructureElement(&fmu->fmi3.eventIndicators[i], &eventIndicatorElement, &fmu->arena)) {
                 return false;
             }
             ++i;
         }
     }
 
-    ezxml_free(rootElement);
-
-    chdir(cwd);
-
     return true;
 }
 
@@ -1575,12 +1918,11 @@ bool loadFunctionsFmi1(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    char cwd[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
+    if(!extractDeferredFiles(fmu, FMI2_BINARIES_DIRECTORY)) {
+        return false;
+    }
+
+    double startTime = getWallTime();
 
     char dllPath[FILENAME_MAX];
     dllPath[0] = '\0';
@@ -1599,41 +1941,13 @@ bool loadFunctionsFmi1(fmiHandle *fmu)
     strncat(dllPath, ".so", sizeof(dllPath)-strlen(dllPath)-1);
 #endif
 #ifdef _WIN32
-    char dllDirectory[FILENAME_MAX];
-    dllDirectory[0] = '\0';
-    strncat(dllDirectory, fmu->unzippedLocation, sizeof(dllDirectory)-strlen(dllDirectory)-1);
-    strncat(dllDirectory, "\\binaries\\win64\\", sizeof(dllDirectory)-strlen(dllDirectory)-1);
-
-    BOOL success = SetDllDirectoryA(dllDirectory);
-    if (!success) {
-        fprintf(stderr, "Loading DLL %s failed:\nFailed to set DLL directory %s", dllPath, dllDirectory);
-        return false;
-    }
-
-    HINSTANCE dll = LoadLibraryA(dllPath);
-    if(NULL == dll) {
-        DWORD error = GetLastError();
-        LPSTR message = NULL;
-        FormatMessageA(
-            FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-            NULL, error, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&message, 0, NULL);
-        fprintf(stderr, "Failed to load DLL %s:\n%s", dllPath, message);
-        LocalFree(message);
-        return false;
-    }
+    HINSTANCE dll = acquireFmuLibrary(fmu, dllPath);
 #else
-    char cmd[FILENAME_MAX];
-    cmd[0] = '\0';
-    strcat(cmd, "chmod +x ");
-    strcat(cmd, dllPath);
-    system(cmd);
-
-    void* dll = dlopen(dllPath, RTLD_NOW|RTLD_LOCAL);
+    void *dll = acquireFmuLibrary(fmu, dllPath);
+#endif
     if(NULL == dll) {
-        printf("Loading shared object failed: %s (%s)\n",dllPath, dlerror());
-        return false;
+        return false;   //Error message should already have been printed
     }
-#endif
 
     fmu->dll = dll;
 
@@ -1688,8 +2002,7 @@ bool loadFunctionsFmi1(fmiHandle *fmu)
         fmu->fmi1.getStringStatus = (fmiGetStringStatus_t)loadDllFunction(dll, getFunctionName(fmu->fmi1.modelName, "fmiGetStringStatus"), &ok);
     }
 
-    chdir(cwd);
-
+    fmu->libraryLoadTime = getWallTime()-startTime;
     return ok;
 }
 
@@ -1701,12 +2014,11 @@ bool loadFunctionsFmi2(fmiHandle *fmu, fmi2Type fmuType)
 {
     TRACEFUNC
 
-    char cwd[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
+    if(!extractDeferredFiles(fmu, FMI2_BINARIES_DIRECTORY)) {
+        return false;
+    }
+
+    double startTime = getWallTime();
 
     char dllPath[FILENAME_MAX];
     dllPath[0] = '\0';
@@ -1732,41 +2044,13 @@ bool loadFunctionsFmi2(fmiHandle *fmu, fmi2Type fmuType)
     strncat(dllPath, ".so", sizeof(dllPath)-strlen(dllPath)-1);
 #endif
 #ifdef _WIN32
-    char dllDirectory[FILENAME_MAX];
-    dllDirectory[0] = '\0';
-    strncat(dllDirectory, fmu->unzippedLocation, sizeof(dllDirectory)-strlen(dllDirectory)-1);
-    strncat(dllDirectory, "\\binaries\\win64\\", sizeof(dllDirectory)-strlen(dllDirectory)-1);
-
-    BOOL success = SetDllDirectoryA(dllDirectory);
-    if (!success) {
-        fprintf(stderr, "Loading DLL %s failed:\nFailed to set DLL directory %s", dllPath, dllDirectory);
-        return false;
-    }
-
-    HINSTANCE dll = LoadLibraryA(dllPath);
-    if(NULL == dll) {
-        DWORD error = GetLastError();
-        LPSTR message = NULL;
-        FormatMessageA(
-            FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-            NULL, error, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&message, 0, NULL);
-        fprintf(stderr, "Failed to load DLL %s:\n%s", dllPath, message);
-        LocalFree(message);
-        return false;
-    }
+    HINSTANCE dll = acquireFmuLibrary(fmu, dllPath);
 #else
-    char cmd[FILENAME_MAX];
-    cmd[0] = '\0';
-    strcat(cmd, "chmod +x ");
-    strcat(cmd, dllPath);
-    system(cmd);
-
-    void *dll = dlopen(dllPath, RTLD_NOW | RTLD_LOCAL);
-    if (NULL == dll) {
-        printf("Loading shared object failed: %s (%s)\n", dllPath, dlerror());
-        return false;
-    }
+    void *dll = acquireFmuLibrary(fmu, dllPath);
 #endif
+    if(NULL == dll) {
+        return false;   //Error message should already have been printed
+    }
 
     fmu->dll = dll;
 
@@ -1791,13 +2075,24 @@ bool loadFunctionsFmi2(fmiHandle *fmu, fmi2Type fmuType)
     fmu->fmi2.setBoolean = (fmi2SetBoolean_t)loadDllFunction(dll, "fmi2SetBoolean", &ok);
     fmu->fmi2.getString = (fmi2GetString_t)loadDllFunction(dll, "fmi2GetString", &ok);
     fmu->fmi2.setString = (fmi2SetString_t)loadDllFunction(dll, "fmi2SetString", &ok);
-    fmu->fmi2.getFMUstate = (fmi2GetFMUstate_t)loadDllFunction(dll, "fmi2GetFMUstate", &ok);
-    fmu->fmi2.setFMUstate = (fmi2SetFMUstate_t)loadDllFunction(dll, "fmi2SetFMUstate", &ok);
-    fmu->fmi2.freeFMUstate = (fmi2FreeFMUstate_t)loadDllFunction(dll, "fmi2FreeFMUstate", &ok);
-    fmu->fmi2.serializedFMUstateSize = (fmi2SerializedFMUstateSize_t)loadDllFunction(dll, "fmi2SerializedFMUstateSize", &ok);
-    fmu->fmi2.serializeFMUstate = (fmi2SerializeFMUstate_t)loadDllFunction(dll, "fmi2SerializeFMUstate", &ok);
-    fmu->fmi2.deSerializeFMUstate = (fmi2DeSerializeFMUstate_t)loadDllFunction(dll, "fmi2DeSerializeFMUstate", &ok);
-    fmu->fmi2.getDirectionalDerivative = (fmi2GetDirectionalDerivative_t)loadDllFunction(dll, "fmi2GetDirectionalDerivative", &ok);
+
+    //Optional functions are only resolved if the interface declares the capability, otherwise they keep their placeholders
+    bool canGetAndSetFMUState = (fmuType == fmi2CoSimulation) ? fmu->fmi2.cs.canGetAndSetFMUState : fmu->fmi2.me.canGetAndSetFMUState;
+    bool canSerializeFMUState = (fmuType == fmi2CoSimulation) ? fmu->fmi2.cs.canSerializeFMUState : fmu->fmi2.me.canSerializeFMUState;
+    bool providesDirectionalDerivative = (fmuType == fmi2CoSimulation) ? fmu->fmi2.cs.providesDirectionalDerivative : fmu->fmi2.me.providesDirectionalDerivative;
+    if(canGetAndSetFMUState) {
+        fmu->fmi2.getFMUstate = (fmi2GetFMUstate_t)loadDllFunction(dll, "fmi2GetFMUstate", &ok);
+        fmu->fmi2.setFMUstate = (fmi2SetFMUstate_t)loadDllFunction(dll, "fmi2SetFMUstate", &ok);
+        fmu->fmi2.freeFMUstate = (fmi2FreeFMUstate_t)loadDllFunction(dll, "fmi2FreeFMUstate", &ok);
+    }
+    if(canSerializeFMUState) {
+        fmu->fmi2.serializedFMUstateSize = (fmi2SerializedFMUstateSize_t)loadDllFunction(dll, "fmi2SerializedFMUstateSize", &ok);
+        fmu->fmi2.serializeFMUstate = (fmi2SerializeFMUstate_t)loadDllFunction(dll, "fmi2SerializeFMUstate", &ok);
+        fmu->fmi2.deSerializeFMUstate = (fmi2DeSerializeFMUstate_t)loadDllFunction(dll, "fmi2DeSerializeFMUstate", &ok);
+    }
+    if(providesDirectionalDerivative) {
+        fmu->fmi2.getDirectionalDerivative = (fmi2GetDirectionalDerivative_t)loadDllFunction(dll, "fmi2GetDirectionalDerivative", &ok);
+    }
 
     if(fmuType == fmi2CoSimulation) {
         //Load co-simulation specific functions
@@ -1826,8 +2121,7 @@ bool loadFunctionsFmi2(fmiHandle *fmu, fmi2Type fmuType)
          fmu->fmi2.getNominalsOfContinuousStates = (fmi2GetNominalsOfContinuousStates_t)loadDllFunction(dll, "fmi2GetNominalsOfContinuousStates", &ok);
     }
 
-    chdir(cwd);
-
+    fmu->libraryLoadTime = getWallTime()-startTime;
     return ok;
 }
 
@@ -1839,12 +2133,12 @@ bool loadFunctionsFmi3(fmiHandle *fmu, fmi3Type fmuType)
 {
     TRACEFUNC
 
-    char cwd[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
+    if(!extractDeferredFiles(fmu, FMI3_BINARIES_DIRECTORY)) {
+        return false;
+    }
+
+    double startTime = getWallTime();
+
     char dllPath[FILENAME_MAX];
     dllPath[0] = '\0';
     strncat(dllPath, fmu->unzippedLocation, sizeof(dllPath)-strlen(dllPath)-1);
@@ -1872,126 +2166,148 @@ bool loadFunctionsFmi3(fmiHandle *fmu, fmi3Type fmuType)
     strncat(dllPath, ".so", sizeof(dllPath)-strlen(dllPath)-1);
 #endif
 
-#ifdef _WIN32
-    char dllDirectory[FILENAME_MAX];
-    dllDirectory[0] = '\0';
-    strncat(dllDirectory, fmu->unzippedLocation, sizeof(dllDirectory)-strlen(dllDirectory)-1);
-    strncat(dllDirectory, "\\binaries\\x86_64-windows\\", sizeof(dllDirectory)-strlen(dllDirectory)-1);
-
-    BOOL success = SetDllDirectoryA(dllDirectory);
-    if (!success) {
-        fprintf(stderr, "Loading DLL %s failed:\nFailed to set DLL directory %s", dllPath, dllDirectory);
-        return false;
+#ifdef FMI4C_WITH_HOST
+    if(fmu->hostExecutable != NULL) {
+        if(fmuType != fmi3CoSimulation) {
+            printf("Only FMI 3 Co-Simulation can be run out of process\n");
+            return false;
+        }
+        if(fmu->host == NULL) {
+            fmu->host = startHost(fmu->hostExecutable, dllPath);
+        }
+        if(fmu->host == NULL) {
+            return false;   //Error message should already have been printed
+        }
+        assignHostFunctionsFmi3(fmu);
+        fmu->libraryLoadTime = getWallTime()-startTime;
+        return true;
     }
+#endif
 
-    HINSTANCE dll = LoadLibraryA(dllPath);
-    if(NULL == dll) {
-        DWORD error = GetLastError();
-        LPSTR message = NULL;
-        FormatMessageA(
-            FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-            NULL, error, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&message, 0, NULL);
-        fprintf(stderr, "Failed to load DLL %s:\n%s", dllPath, message);
-        LocalFree(message);
-        return false;
-    }
+#ifdef _WIN32
+    HINSTANCE dll = acquireFmuLibrary(fmu, dllPath);
 #else
-    char cmd[FILENAME_MAX];
-    cmd[0] = '\0';
-    strcat(cmd, "chmod +x ");
-    strcat(cmd, dllPath);
-    system(cmd);
-
-    void *dll = dlopen(dllPath, RTLD_NOW | RTLD_LOCAL);
-    if (NULL == dll) {
-        printf("Loading shared object fejlade: %s (%s)\n", dllPath, dlerror());
-        return false;
-    }
+    void *dll = acquireFmuLibrary(fmu, dllPath);
 #endif
+    if(NULL == dll) {
+        return false;   //Error message should already have been printed
+    }
 
     fmu->dll = dll;
 
     printf("Loading FMI version 3...\n");
 
-    //Load all common functions
-
-
-
-
-//#define fmi3InstantiateModelExchange         fmi3FullName(fmi3InstantiateModelExchange)
-//#define fmi3InstantiateCoSimulation          fmi3FullName(fmi3InstantiateCoSimulation)
-//#define fmi3InstantiateScheduledExecution    fmi3FullName(fmi3InstantiateScheduledExecution)
-
-///* Getting and setting variable values */
-
-
-
-///* Getting Variable Dependency Information */
-//#define fmi3GetNumberOfVariableDependencies fmi3FullName(fmi3GetNumberOfVariableDependencies)
-//#define fmi3GetVariableDependencies         fmi3FullName(fmi3GetVariableDependencies)
+    //Optional functions are only resolved if the interface declares the capability, otherwise they keep their placeholders
+    bool canGetAndSetFMUState, canSerializeFMUState, providesDirectionalDerivative, providesAdjointDerivatives, providesPerElementDependencies;
+    bool providesEvaluateDiscreteStates = false;
+    if(fmuType == fmi3CoSimulation) {
+        canGetAndSetFMUState = fmu->fmi3.cs.canGetAndSetFMUState;
+        canSerializeFMUState = fmu->fmi3.cs.canSerializeFMUState;
+        providesDirectionalDerivative = fmu->fmi3.cs.providesDirectionalDerivative;
+        providesAdjointDerivatives = fmu->fmi3.cs.providesAdjointDerivatives;
+        providesPerElementDependencies = fmu->fmi3.cs.providesPerElementDependencies;
+        providesEvaluateDiscreteStates = fmu->fmi3.cs.providesEvaluateDiscreteStates;
+    }
+    else if(fmuType == fmi3ModelExchange) {
+        canGetAndSetFMUState = fmu->fmi3.me.canGetAndSetFMUState;
+        canSerializeFMUState = fmu->fmi3.me.canSerializeFMUState;
+        providesDirectionalDerivative = fmu->fmi3.me.providesDirectionalDerivative;
+        providesAdjointDerivatives = fmu->fmi3.me.providesAdjointDerivatives;
+        providesPerElementDependencies = fmu->fmi3.me.providesPerElementDependencies;
+        providesEvaluateDiscreteStates = fmu->fmi3.me.providesEvaluateDiscreteStates;
+    }
+    else {
+        canGetAndSetFMUState = fmu->fmi3.se.canGetAndSetFMUState;
+        canSerializeFMUState = fmu->fmi3.se.canSerializeFMUState;
+        providesDirectionalDerivative = fmu->fmi3.se.providesDirectionalDerivative;
+        providesAdjointDerivatives = fmu->fmi3.se.providesAdjointDerivatives;
+        providesPerElementDependencies = fmu->fmi3.se.providesPerElementDependencies;
+    }
 
     bool ok = true;
 
     //Load common functions
-    fmu->fmi3.getVersion = (fmi3GetVersion_t)loadDllFunction(dll,"fmi3GetVersion", &ok);
-    fmu->fmi3.setDebugLogging = (fmi3SetDebugLogging_t)loadDllFunction(dll,    "fmi3SetDebugLogging", &ok);
-    fmu->fmi3.instantiateModelExchange = (fmi3InstantiateModelExchange_t)loadDllFunction(dll,    "fmi3InstantiateModelExchange", &ok);
-    fmu->fmi3.instantiateCoSimulation = (fmi3InstantiateCoSimulation_t)loadDllFunction(dll,    "fmi3InstantiateCoSimulation", &ok);
-    fmu->fmi3.instantiateScheduledExecution = (fmi3InstantiateScheduledExecution_t)loadDllFunction(dll,    "fmi3InstantiateScheduledExecution", &ok);
-    fmu->fmi3.freeInstance = (fmi3FreeInstance_t)loadDllFunction(dll,"fmi3FreeInstance", &ok);
-    fmu->fmi3.enterInitializationMode = (fmi3EnterInitializationMode_t)loadDllFunction(dll,    "fmi3EnterInitializationMode", &ok);
-    fmu->fmi3.exitInitializationMode = (fmi3ExitInitializationMode_t)loadDllFunction(dll,    "fmi3ExitInitializationMode", &ok);
-    fmu->fmi3.enterEventMode = (fmi3EnterEventMode_t)loadDllFunction(dll,    "fmi3EnterEventMode", &ok);
-    fmu->fmi3.terminate = (fmi3Terminate_t)loadDllFunction(dll,"fmi3Terminate", &ok);
-    fmu->fmi3.reset = (fmi3Reset_t)loadDllFunction(dll,"fmi3Reset", &ok);
-    fmu->fmi3.setFloat64 = (fmi3SetFloat64_t)loadDllFunction(dll,"fmi3SetFloat64", &ok);
-    fmu->fmi3.getFloat64 = (fmi3GetFloat64_t)loadDllFunction(dll,"fmi3GetFloat64", &ok);
-    fmu->fmi3.getFloat32 = (fmi3GetFloat32_t)loadDllFunction(dll,"fmi3GetFloat32", &ok);
-    fmu->fmi3.setFloat32 = (fmi3SetFloat32_t)loadDllFunction(dll,"fmi3SetFloat32", &ok);
-    fmu->fmi3.setInt64 = (fmi3SetInt64_t)loadDllFunction(dll,"fmi3SetInt64", &ok);
-    fmu->fmi3.getInt64 = (fmi3GetInt64_t)loadDllFunction(dll,"fmi3GetInt64", &ok);
-    fmu->fmi3.setInt32 = (fmi3SetInt32_t)loadDllFunction(dll,"fmi3SetInt32", &ok);
-    fmu->fmi3.getInt32 = (fmi3GetInt32_t)loadDllFunction(dll,"fmi3GetInt32", &ok);
-    fmu->fmi3.setInt16 = (fmi3SetInt16_t)loadDllFunction(dll,"fmi3SetInt16", &ok);
-    fmu->fmi3.getInt16 = (fmi3GetInt16_t)loadDllFunction(dll,"fmi3GetInt16", &ok);
-    fmu->fmi3.getInt8 = (fmi3GetInt8_t)loadDllFunction(dll,"fmi3GetInt8", &ok);
-    fmu->fmi3.setInt8 = (fmi3SetInt8_t)loadDllFunction(dll,"fmi3SetInt8", &ok);
-    fmu->fmi3.getUInt64 = (fmi3GetUInt64_t)loadDllFunction(dll,"fmi3GetUInt64", &ok);
-    fmu->fmi3.setUInt64 = (fmi3SetUInt64_t)loadDllFunction(dll,"fmi3SetUInt64", &ok);
-    fmu->fmi3.getUInt32 = (fmi3GetUInt32_t)loadDllFunction(dll,"fmi3GetUInt32", &ok);
-    fmu->fmi3.setUInt32 = (fmi3SetUInt32_t)loadDllFunction(dll,"fmi3SetUInt32", &ok);
-    fmu->fmi3.getUInt16 = (fmi3GetUInt16_t)loadDllFunction(dll,"fmi3GetUInt16", &ok);
-    fmu->fmi3.setUInt16 = (fmi3SetUInt16_t)loadDllFunction(dll,"fmi3SetUInt16", &ok);
-    fmu->fmi3.setUInt8 = (fmi3SetUInt8_t)loadDllFunction(dll,"fmi3SetUInt8", &ok);
-    fmu->fmi3.getUInt8 = (fmi3GetUInt8_t)loadDllFunction(dll,"fmi3GetUInt8", &ok);
-    fmu->fmi3.setBoolean = (fmi3SetBoolean_t)loadDllFunction(dll,"fmi3SetBoolean", &ok);
-    fmu->fmi3.getBoolean = (fmi3GetBoolean_t)loadDllFunction(dll,"fmi3GetBoolean", &ok);
-    fmu->fmi3.getString = (fmi3GetString_t)loadDllFunction(dll,"fmi3GetString", &ok);
-    fmu->fmi3.setString = (fmi3SetString_t)loadDllFunction(dll,"fmi3SetString", &ok);
-    fmu->fmi3.getBinary = (fmi3GetBinary_t)loadDllFunction(dll,"fmi3GetBinary", &ok);
-    fmu->fmi3.setBinary = (fmi3SetBinary_t)loadDllFunction(dll,"fmi3SetBinary", &ok);
-    fmu->fmi3.getClock = (fmi3GetClock_t)loadDllFunction(dll,"fmi3GetClock", &ok);
-    fmu->fmi3.setClock = (fmi3SetClock_t)loadDllFunction(dll,"fmi3SetClock", &ok);
-    fmu->fmi3.getNumberOfVariableDependencies =(fmi3GetNumberOfVariableDependencies_t)loadDllFunction(dll,    "fmi3GetNumberOfVariableDependencies", &ok);
-    fmu->fmi3.getVariableDependencies = (fmi3GetVariableDependencies_t)loadDllFunction(dll,    "fmi3GetVariableDependencies", &ok);
-    fmu->fmi3.getFMUState = (fmi3GetFMUState_t)loadDllFunction(dll,"fmi3GetFMUState", &ok);
-    fmu->fmi3.setFMUState = (fmi3SetFMUState_t)loadDllFunction(dll,"fmi3SetFMUState", &ok);
-    fmu->fmi3.freeFMUState = (fmi3FreeFMUState_t)loadDllFunction(dll,"fmi3FreeFMUState", &ok);
-    fmu->fmi3.serializedFMUStateSize = (fmi3SerializedFMUStateSize_t)loadDllFunction(dll,    "fmi3SerializedFMUStateSize", &ok);
-    fmu->fmi3.serializeFMUState = (fmi3SerializeFMUState_t)loadDllFunction(dll,    "fmi3SerializeFMUState", &ok);
-    fmu->fmi3.deserializeFMUState = (fmi3DeserializeFMUState_t)loadDllFunction(dll,    "fmi3DeserializeFMUState", &ok);
-    fmu->fmi3.getDirectionalDerivative = (fmi3GetDirectionalDerivative_t)loadDllFunction(dll,    "fmi3GetDirectionalDerivative", &ok);
-    fmu->fmi3.getAdjointDerivative = (fmi3GetAdjointDerivative_t)loadDllFunction(dll,    "fmi3GetAdjointDerivative", &ok);
-    fmu->fmi3.enterConfigurationMode = (fmi3EnterConfigurationMode_t)loadDllFunction(dll,    "fmi3EnterConfigurationMode", &ok);
-    fmu->fmi3.exitConfigurationMode = (fmi3ExitConfigurationMode_t)loadDllFunction(dll,    "fmi3ExitConfigurationMode", &ok);
-    fmu->fmi3.getIntervalDecimal = (fmi3GetIntervalDecimal_t)loadDllFunction(dll,    "fmi3GetIntervalDecimal", &ok);
-    fmu->fmi3.getIntervalFraction = (fmi3GetIntervalFraction_t)loadDllFunction(dll,    "fmi3GetIntervalFraction", &ok);
-    fmu->fmi3.getShiftDecimal = (fmi3GetShiftDecimal_t)loadDllFunction(dll,    "fmi3GetShiftDecimal", &ok);
-    fmu->fmi3.getShiftFraction = (fmi3GetShiftFraction_t)loadDllFunction(dll,    "fmi3GetShiftFraction", &ok);
-    fmu->fmi3.setIntervalDecimal = (fmi3SetIntervalDecimal_t)loadDllFunction(dll,    "fmi3SetIntervalDecimal", &ok);
-    fmu->fmi3.setIntervalFraction = (fmi3SetIntervalFraction_t)loadDllFunction(dll,    "fmi3SetIntervalFraction", &ok);
-    fmu->fmi3.setShiftDecimal = (fmi3SetShiftDecimal_t)loadDllFunction(dll,    "fmi3SetShiftDecimal", &ok);
-    fmu->fmi3.setShiftFraction = (fmi3SetShiftFraction_t)loadDllFunction(dll,    "fmi3SetShiftFraction", &ok);
+    fmu->fmi3.getVersion = (fmi3GetVersion_t)loadDllFunction(dll, "fmi3GetVersion", &ok);
+    fmu->fmi3.setDebugLogging = (fmi3SetDebugLogging_t)loadDllFunction(dll, "fmi3SetDebugLogging", &ok);
+    fmu->fmi3.freeInstance = (fmi3FreeInstance_t)loadDllFunction(dll, "fmi3FreeInstance", &ok);
+    fmu->fmi3.enterInitializationMode = (fmi3EnterInitializationMode_t)loadDllFunction(dll, "fmi3EnterInitializationMode", &ok);
+    fmu->fmi3.exitInitializationMode = (fmi3ExitInitializationMode_t)loadDllFunction(dll, "fmi3ExitInitializationMode", &ok);
+    fmu->fmi3.enterEventMode = (fmi3EnterEventMode_t)loadDllFunction(dll, "fmi3EnterEventMode", &ok);
+    fmu->fmi3.terminate = (fmi3Terminate_t)loadDllFunction(dll, "fmi3Terminate", &ok);
+    fmu->fmi3.reset = (fmi3Reset_t)loadDllFunction(dll, "fmi3Reset", &ok);
+    fmu->fmi3.setFloat64 = (fmi3SetFloat64_t)loadDllFunction(dll, "fmi3SetFloat64", &ok);
+    fmu->fmi3.getFloat64 = (fmi3GetFloat64_t)loadDllFunction(dll, "fmi3GetFloat64", &ok);
+    fmu->fmi3.getFloat32 = (fmi3GetFloat32_t)loadDllFunction(dll, "fmi3GetFloat32", &ok);
+    fmu->fmi3.setFloat32 = (fmi3SetFloat32_t)loadDllFunction(dll, "fmi3SetFloat32", &ok);
+    fmu->fmi3.setInt64 = (fmi3SetInt64_t)loadDllFunction(dll, "fmi3SetInt64", &ok);
+    fmu->fmi3.getInt64 = (fmi3GetInt64_t)loadDllFunction(dll, "fmi3GetInt64", &ok);
+    fmu->fmi3.setInt32 = (fmi3SetInt32_t)loadDllFunction(dll, "fmi3SetInt32", &ok);
+    fmu->fmi3.getInt32 = (fmi3GetInt32_t)loadDllFunction(dll, "fmi3GetInt32", &ok);
+    fmu->fmi3.setInt16 = (fmi3SetInt16_t)loadDllFunction(dll, "fmi3SetInt16", &ok);
+    fmu->fmi3.getInt16 = (fmi3GetInt16_t)loadDllFunction(dll, "fmi3GetInt16", &ok);
+    fmu->fmi3.getInt8 = (fmi3GetInt8_t)loadDllFunction(dll, "fmi3GetInt8", &ok);
+    fmu->fmi3.setInt8 = (fmi3SetInt8_t)loadDllFunction(dll, "fmi3SetInt8", &ok);
+    fmu->fmi3.getUInt64 = (fmi3GetUInt64_t)loadDllFunction(dll, "fmi3GetUInt64", &ok);
+    fmu->fmi3.setUInt64 = (fmi3SetUInt64_t)loadDllFunction(dll, "fmi3SetUInt64", &ok);
+    fmu->fmi3.getUInt32 = (fmi3GetUInt32_t)loadDllFunction(dll, "fmi3GetUInt32", &ok);
+    fmu->fmi3.setUInt32 = (fmi3SetUInt32_t)loadDllFunction(dll, "fmi3SetUInt32", &ok);
+    fmu->fmi3.getUInt16 = (fmi3GetUInt16_t)loadDllFunction(dll, "fmi3GetUInt16", &ok);
+    fmu->fmi3.setUInt16 = (fmi3SetUInt16_t)loadDllFunction(dll, "fmi3SetUInt16", &ok);
+    fmu->fmi3.setUInt8 = (fmi3SetUInt8_t)loadDllFunction(dll, "fmi3SetUInt8", &ok);
+    fmu->fmi3.getUInt8 = (fmi3GetUInt8_t)loadDllFunction(dll, "fmi3GetUInt8", &ok);
+    fmu->fmi3.setBoolean = (fmi3SetBoolean_t)loadDllFunction(dll, "fmi3SetBoolean", &ok);
+    fmu->fmi3.getBoolean = (fmi3GetBoolean_t)loadDllFunction(dll, "fmi3GetBoolean", &ok);
+    fmu->fmi3.getString = (fmi3GetString_t)loadDllFunction(dll, "fmi3GetString", &ok);
+    fmu->fmi3.setString = (fmi3SetString_t)loadDllFunction(dll, "fmi3SetString", &ok);
+    fmu->fmi3.getBinary = (fmi3GetBinary_t)loadDllFunction(dll, "fmi3GetBinary", &ok);
+    fmu->fmi3.setBinary = (fmi3SetBinary_t)loadDllFunction(dll, "fmi3SetBinary", &ok);
+
+    if(fmuType == fmi3CoSimulation) {
+        fmu->fmi3.instantiateCoSimulation = (fmi3InstantiateCoSimulation_t)loadDllFunction(dll, "fmi3InstantiateCoSimulation", &ok);
+    }
+    else if(fmuType == fmi3ModelExchange) {
+        fmu->fmi3.instantiateModelExchange = (fmi3InstantiateModelExchange_t)loadDllFunction(dll, "fmi3InstantiateModelExchange", &ok);
+    }
+    else {
+        fmu->fmi3.instantiateScheduledExecution = (fmi3InstantiateScheduledExecution_t)loadDllFunction(dll, "fmi3InstantiateScheduledExecution", &ok);
+    }
+
+    if(canGetAndSetFMUState) {
+        fmu->fmi3.getFMUState = (fmi3GetFMUState_t)loadDllFunction(dll, "fmi3GetFMUState", &ok);
+        fmu->fmi3.setFMUState = (fmi3SetFMUState_t)loadDllFunction(dll, "fmi3SetFMUState", &ok);
+        fmu->fmi3.freeFMUState = (fmi3FreeFMUState_t)loadDllFunction(dll, "fmi3FreeFMUState", &ok);
+    }
+    if(canSerializeFMUState) {
+        fmu->fmi3.serializedFMUStateSize = (fmi3SerializedFMUStateSize_t)loadDllFunction(dll, "fmi3SerializedFMUStateSize", &ok);
+        fmu->fmi3.serializeFMUState = (fmi3SerializeFMUState_t)loadDllFunction(dll, "fmi3SerializeFMUState", &ok);
+        fmu->fmi3.deserializeFMUState = (fmi3DeserializeFMUState_t)loadDllFunction(dll, "fmi3DeserializeFMUState", &ok);
+    }
+    if(providesDirectionalDerivative) {
+        fmu->fmi3.getDirectionalDerivative = (fmi3GetDirectionalDerivative_t)loadDllFunction(dll, "fmi3GetDirectionalDerivative", &ok);
+    }
+    if(providesAdjointDerivatives) {
+        fmu->fmi3.getAdjointDerivative = (fmi3GetAdjointDerivative_t)loadDllFunction(dll, "fmi3GetAdjointDerivative", &ok);
+    }
+    if(providesPerElementDependencies) {
+        fmu->fmi3.getNumberOfVariableDependencies = (fmi3GetNumberOfVariableDependencies_t)loadDllFunction(dll, "fmi3GetNumberOfVariableDependencies", &ok);
+        fmu->fmi3.getVariableDependencies = (fmi3GetVariableDependencies_t)loadDllFunction(dll, "fmi3GetVariableDependencies", &ok);
+    }
+    if(fmu->fmi3.hasStructuralParameters) {
+        fmu->fmi3.enterConfigurationMode = (fmi3EnterConfigurationMode_t)loadDllFunction(dll, "fmi3EnterConfigurationMode", &ok);
+        fmu->fmi3.exitConfigurationMode = (fmi3ExitConfigurationMode_t)loadDllFunction(dll, "fmi3ExitConfigurationMode", &ok);
+    }
+    if(fmu->fmi3.hasClockVariables) {
+        fmu->fmi3.getClock = (fmi3GetClock_t)loadDllFunction(dll, "fmi3GetClock", &ok);
+        fmu->fmi3.setClock = (fmi3SetClock_t)loadDllFunction(dll, "fmi3SetClock", &ok);
+        fmu->fmi3.getIntervalDecimal = (fmi3GetIntervalDecimal_t)loadDllFunction(dll, "fmi3GetIntervalDecimal", &ok);
+        fmu->fmi3.getIntervalFraction = (fmi3GetIntervalFraction_t)loadDllFunction(dll, "fmi3GetIntervalFraction", &ok);
+        fmu->fmi3.getShiftDecimal = (fmi3GetShiftDecimal_t)loadDllFunction(dll, "fmi3GetShiftDecimal", &ok);
+        fmu->fmi3.getShiftFraction = (fmi3GetShiftFraction_t)loadDllFunction(dll, "fmi3GetShiftFraction", &ok);
+        fmu->fmi3.setIntervalDecimal = (fmi3SetIntervalDecimal_t)loadDllFunction(dll, "fmi3SetIntervalDecimal", &ok);
+        fmu->fmi3.setIntervalFraction = (fmi3SetIntervalFraction_t)loadDllFunction(dll, "fmi3SetIntervalFraction", &ok);
+        fmu->fmi3.setShiftDecimal = (fmi3SetShiftDecimal_t)loadDllFunction(dll, "fmi3SetShiftDecimal", &ok);
+        fmu->fmi3.setShiftFraction = (fmi3SetShiftFraction_t)loadDllFunction(dll, "fmi3SetShiftFraction", &ok);
+    }
 
     if(fmu->fmi3.supportsCoSimulation) {
         //Load co-simulation specific functions
@@ -2012,7 +2328,9 @@ bool loadFunctionsFmi3(fmiHandle *fmu, fmi3Type fmuType)
         fmu->fmi3.getNominalsOfContinuousStates = (fmi3GetNominalsOfContinuousStates_t)loadDllFunction(dll, "fmi3GetNominalsOfContinuousStates", &ok);
         fmu->fmi3.getNumberOfEventIndicators = (fmi3GetNumberOfEventIndicators_t)loadDllFunction(dll, "fmi3GetNumberOfEventIndicators", &ok);
         fmu->fmi3.getNumberOfContinuousStates = (fmi3GetNumberOfContinuousStates_t)loadDllFunction(dll, "fmi3GetNumberOfContinuousStates", &ok);
-        fmu->fmi3.evaluateDiscreteStates = (fmi3EvaluateDiscreteStates_t)loadDllFunction(dll, "fmi3EvaluateDiscreteStates", &ok);
+        if(providesEvaluateDiscreteStates) {
+            fmu->fmi3.evaluateDiscreteStates = (fmi3EvaluateDiscreteStates_t)loadDllFunction(dll, "fmi3EvaluateDiscreteStates", &ok);
+        }
         fmu->fmi3.updateDiscreteStates = (fmi3UpdateDiscreteStates_t)loadDllFunction(dll, "fmi3UpdateDiscreteStates", &ok);
     }
 
@@ -2021,8 +2339,7 @@ bool loadFunctionsFmi3(fmiHandle *fmu, fmi3Type fmuType)
         fmu->fmi3.activateModelPartition = (fmi3ActivateModelPartition_t)loadDllFunction(dll, "fmi3ActivateModelPartition", &ok);
     }
 
-    chdir(cwd);
-
+    fmu->libraryLoadTime = getWallTime()-startTime;
     return ok;
 }
 
@@ -2036,6 +2353,24 @@ fmiVersion_t fmi4c_getFmiVersion(fmiHandle *fmu)
 }
 
 
+//! @brief Returns time spent reading and parsing modelDescription.xml when the FMU was loaded
+//! @param fmu FMU handle
+//! @returns Parse time in seconds
+double fmi4c_getParseTime(fmiHandle *fmu)
+{
+    return fmu->parseTime;
+}
+
+
+//! @brief Returns time spent loading the shared library and resolving its functions when the FMU was instantiated
+//! @param fmu FMU handle
+//! @returns Library load time in seconds (0 if not instantiated)
+double fmi4c_getLibraryLoadTime(fmiHandle *fmu)
+{
+    return fmu->libraryLoadTime;
+}
+
+
 
 
 bool fmi3_instantiateCoSimulation(fmiHandle *fmu,
@@ -2054,6 +2389,22 @@ bool fmi3_instantiateCoSimulation(fmiHandle *fmu,
         return false;
     }
 
+#ifdef FMI4C_WITH_HOST
+    if(fmu->host != NULL) {
+        fmu->fmi3.fmi3Instance = instantiateHostCoSimulation(fmu->host,
+                                                             fmu->instanceName,
+                                                             fmu->fmi3.instantiationToken,
+                                                             fmu->resourcesLocation,
+                                                             visible,
+                                                             loggingOn,
+                                                             eventModeUsed,
+                                                             earlyReturnAllowed,
+                                                             requiredIntermediateVariables,
+                                                             nRequiredIntermediateVariables);
+        return (fmu->fmi3.fmi3Instance != NULL);
+    }
+#endif
+
     fmu->fmi3.fmi3Instance = fmu->fmi3.instantiateCoSimulation(fmu->instanceName,
                                                       fmu->fmi3.instantiationToken,
                                                       fmu->resourcesLocation,
@@ -2093,7 +2444,35 @@ bool fmi3_iInstantiateModelExchange(fmiHandle *fmu,
     return (fmu->fmi3.fmi3Instance != NULL);
 }
 
-const char* fmi3_getVersion(fmiHandle *fmu) {
+bool fmi3_instantiateScheduledExecution(fmiHandle *fmu,
+                                        fmi3Boolean                  visible,
+                                        fmi3Boolean                  loggingOn,
+                                        fmi3InstanceEnvironment      instanceEnvironment,
+                                        fmi3LogMessageCallback       logMessage,
+                                        fmi3ClockUpdateCallback      clockUpdate,
+                                        fmi3CallbackLockPreemption   lockPreemption,
+                                        fmi3CallbackUnlockPreemption unlockPreemption)
+{
+    if(!loadFunctionsFmi3(fmu, fmi3ScheduledExecution)) {
+        printf("Failed to load functions for FMI 3 SE.");
+        return false;
+    }
+
+    fmu->fmi3.fmi3Instance = fmu->fmi3.instantiateScheduledExecution(fmu->instanceName,
+                                                                fmu->fmi3.instantiationToken,
+                                                                fmu->resourcesLocation,
+                                                                visible,
+                                                                loggingOn,
+                                                                instanceEnvironment,
+                                                                logMessage,
+                                                                clockUpdate,
+                                                                lockPreemption,
+                                                                unlockPreemption);
+
+    return (fmu->fmi3.fmi3Instance != NULL);
+}
+
+const char* fmi3_getVersion(fmiHandle *fmu) {
 
     return fmu->fmi3.getVersion(fmu->fmi3.fmi3Instance);
 }
@@ -2104,7 +2483,7 @@ fmi3Status fmi3_setDebugLogging(fmiHandle *fmu,
                                 const fmi3String categories[])
 {
 
-    return fmu->fmi3.setDebugLogging(fmu->fmi3.fmi3Instance, loggingOn, nCategories, categories);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.setDebugLogging(fmu->fmi3.fmi3Instance, loggingOn, nCategories, categories));
 }
 
 fmi3Status fmi3_getFloat64(fmiHandle *fmu,
@@ -2113,11 +2492,11 @@ fmi3Status fmi3_getFloat64(fmiHandle *fmu,
                            fmi3Float64 values[],
                            size_t nValues) {
 
-    return fmu->fmi3.getFloat64(fmu->fmi3.fmi3Instance,
-                                valueReferences,
-                                nValueReferences,
-                                values,
-                                nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getFloat64(fmu->fmi3.fmi3Instance,
+                                                                     valueReferences,
+                                                                     nValueReferences,
+                                                                     values,
+                                                                     nValues));
 }
 
 
@@ -2127,11 +2506,11 @@ fmi3Status fmi3_setFloat64(fmiHandle *fmu,
                            fmi3Float64 values[],
                            size_t nValues) {
 
-    return fmu->fmi3.setFloat64(fmu->fmi3.fmi3Instance,
-                                valueReferences,
-                                nValueReferences,
-                                values,
-                                nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setFloat64(fmu->fmi3.fmi3Instance,
+                                                                     valueReferences,
+                                                                     nValueReferences,
+                                                                     values,
+                                                                     nValues));
 }
 
 fmi3Status fmi3_enterInitializationMode(fmiHandle *fmu,
@@ -2141,26 +2520,26 @@ fmi3Status fmi3_enterInitializationMode(fmiHandle *fmu,
                                        fmi3Boolean stopTimeDefined,
                                        fmi3Float64 stopTime)
 {
-    return fmu->fmi3.enterInitializationMode(fmu->fmi3.fmi3Instance,
-                                            toleranceDefined,
-                                            tolerance,
-                                            startTime,
-                                            stopTimeDefined,
-                                            stopTime);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.enterInitializationMode(fmu->fmi3.fmi3Instance,
+                                                                  toleranceDefined,
+                                                                  tolerance,
+                                                                  startTime,
+                                                                  stopTimeDefined,
+                                                                  stopTime));
 }
 
 fmi3Status fmi3_exitInitializationMode(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    return fmu->fmi3.exitInitializationMode(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.exitInitializationMode(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_terminate(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    return fmu->fmi3.terminate(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.terminate(fmu->fmi3.fmi3Instance));
 }
 
 void fmi3_freeInstance(fmiHandle *fmu)
@@ -2180,14 +2559,14 @@ fmi3Status fmi3_doStep(fmiHandle *fmu,
                        fmi3Float64 *lastSuccessfulTime)
 {
 
-    return fmu->fmi3.doStep(fmu->fmi3.fmi3Instance,
-                            currentCommunicationPoint,
-                            communicationStepSize,
-                            noSetFMUStatePriorToCurrentPoint,
-                            eventEncountered,
-                            terminateSimulation,
-                            earlyReturn,
-                            lastSuccessfulTime);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.doStep(fmu->fmi3.fmi3Instance,
+                                                  currentCommunicationPoint,
+                                                  communicationStepSize,
+                                                  noSetFMUStatePriorToCurrentPoint,
+                                                  eventEncountered,
+                                                  terminateSimulation,
+                                                  earlyReturn,
+                                                  lastSuccessfulTime));
 }
 
 const char *fmi3_modelName(fmiHandle *fmu)
@@ -2298,7 +2677,7 @@ fmi2Status fmi2_setDebugLogging(fmiHandle *fmu, fmi2Boolean loggingOn, size_t nC
 {
     TRACEFUNC
 
-    return fmu->fmi2.setDebugLogging(fmu->fmi2.component, loggingOn, nCategories, categories);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.setDebugLogging(fmu->fmi2.component, loggingOn, nCategories, categories));
 }
 
 bool fmi2_instantiate(fmiHandle *fmu, fmi2Type type, fmi2CallbackLogger logger, fmi2CallbackAllocateMemory allocateMemory, fmi2CallbackFreeMemory freeMemory, fmi2StepFinished stepFinished, fmi2ComponentEnvironment componentEnvironment, fmi2Boolean visible, fmi2Boolean loggingOn)
@@ -2345,35 +2724,35 @@ fmi2Status fmi2_setupExperiment(fmiHandle *fmu, fmi2Boolean toleranceDefined, fm
 {
     TRACEFUNC
 
-    return fmu->fmi2.setupExperiment(fmu->fmi2.component, toleranceDefined, tolerance, startTime, stopTimeDefined, stopTime);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.setupExperiment(fmu->fmi2.component, toleranceDefined, tolerance, startTime, stopTimeDefined, stopTime));
 }
 
 fmi2Status fmi2_enterInitializationMode(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    return fmu->fmi2.enterInitializationMode(fmu->fmi2.component);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.enterInitializationMode(fmu->fmi2.component));
 }
 
 fmi2Status fmi2_exitInitializationMode(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    return fmu->fmi2.exitInitializationMode(fmu->fmi2.component);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.exitInitializationMode(fmu->fmi2.component));
 }
 
 fmi2Status fmi2_terminate(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    return fmu->fmi2.terminate(fmu->fmi2.component);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.terminate(fmu->fmi2.component));
 }
 
 fmi2Status fmi2_reset(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    return fmu->fmi2.reset(fmu->fmi2.component);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.reset(fmu->fmi2.component));
 }
 
 int fmi3_getNumberOfVariables(fmiHandle *fmu)
@@ -2383,6 +2762,89 @@ int fmi3_getNumberOfVariables(fmiHandle *fmu)
     return fmu->fmi3.numberOfVariables;
 }
 
+//! @brief Returns value references of all variables, indexed like fmi3_getVariableByIndex()
+//! @param fmu FMU handle
+//! @returns Array of fmi3_getNumberOfVariables() value references, owned by the FMU
+const fmi3ValueReference *fmi3_getVariableValueReferences(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi3.variableArrays.valueReferences;
+}
+
+//! @brief Returns causalities of all variables, indexed like fmi3_getVariableByIndex()
+const fmi3Causality *fmi3_getVariableCausalities(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi3.variableArrays.causalities;
+}
+
+//! @brief Returns variabilities of all variables, indexed like fmi3_getVariableByIndex()
+const fmi3Variability *fmi3_getVariableVariabilities(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi3.variableArrays.variabilities;
+}
+
+//! @brief Returns data types of all variables, indexed like fmi3_getVariableByIndex()
+const fmi3DataType *fmi3_getVariableDataTypes(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi3.variableArrays.dataTypes;
+}
+
+//! @brief Collects value references of all variables with specified causality and data type
+//! Example: all Float64 outputs, for a single fmi3_getFloat64() call.
+//! @param fmu FMU handle
+//! @param causality Causality to match
+//! @param dataType Data type to match
+//! @param valueReferences Output array, may be NULL to only count matches
+//! @param maxNumberOfValueReferences Size of output array
+//! @returns Total number of matching variables (may be larger than maxNumberOfValueReferences)
+int fmi3_getValueReferencesByCausality(fmiHandle *fmu, fmi3Causality causality, fmi3DataType dataType, fmi3ValueReference *valueReferences, int maxNumberOfValueReferences)
+{
+    TRACEFUNC
+
+    const fmi3VariableArrays *arrays = &fmu->fmi3.variableArrays;
+    int numberOfMatches = 0;
+    for(int i=0; i<fmu->fmi3.numberOfVariables; ++i) {
+        if(arrays->causalities[i] == causality && arrays->dataTypes[i] == dataType) {
+            if(valueReferences != NULL && numberOfMatches < maxNumberOfValueReferences) {
+                valueReferences[numberOfMatches] = arrays->valueReferences[i];
+            }
+            ++numberOfMatches;
+        }
+    }
+    return numberOfMatches;
+}
+
+//! @brief Collects value references of all variables with specified variability and data type
+//! @param fmu FMU handle
+//! @param variability Variability to match
+//! @param dataType Data type to match
+//! @param valueReferences Output array, may be NULL to only count matches
+//! @param maxNumberOfValueReferences Size of output array
+//! @returns Total number of matching variables (may be larger than maxNumberOfValueReferences)
+int fmi3_getValueReferencesByVariability(fmiHandle *fmu, fmi3Variability variability, fmi3DataType dataType, fmi3ValueReference *valueReferences, int maxNumberOfValueReferences)
+{
+    TRACEFUNC
+
+    const fmi3VariableArrays *arrays = &fmu->fmi3.variableArrays;
+    int numberOfMatches = 0;
+    for(int i=0; i<fmu->fmi3.numberOfVariables; ++i) {
+        if(arrays->variabilities[i] == variability && arrays->dataTypes[i] == dataType) {
+            if(valueReferences != NULL && numberOfMatches < maxNumberOfValueReferences) {
+                valueReferences[numberOfMatches] = arrays->valueReferences[i];
+            }
+            ++numberOfMatches;
+        }
+    }
+    return numberOfMatches;
+}
+
 const char *fmi3_getVariableName(fmi3VariableHandle *var)
 {
     TRACEFUNC
@@ -2534,370 +2996,424 @@ fmi3ValueReference fmi3_getVariableValueReference(fmi3VariableHandle *var)
     return var->valueReference;
 }
 
+//! @brief Returns the number of dimensions of a variable
+//! @param var Variable handle
+//! @returns Number of Dimension elements, 0 for scalar variables
+int fmi3_getVariableNumberOfDimensions(fmi3VariableHandle *var)
+{
+    return var->numberOfDimensions;
+}
+
+//! @brief Returns the size of one dimension of an array variable, as declared in modelDescription.xml
+//! @param var Variable handle
+//! @param i Dimension index, from 0 to fmi3_getVariableNumberOfDimensions()-1
+//! @param start Returns the fixed size, if defined
+//! @param valueReference Returns the structural parameter holding the size, if there is no fixed size
+//! @returns True if the dimension has a fixed size, false if it is given by a structural parameter
+bool fmi3_getVariableDimension(fmi3VariableHandle *var, int i, uint64_t *start, fmi3ValueReference *valueReference)
+{
+    (*start) = var->dimensions[i].start;
+    (*valueReference) = var->dimensions[i].valueReference;
+    return var->dimensions[i].hasStart;
+}
+
+//! @brief Computes the flattened number of values of a variable, 1 for scalar variables
+//! Sizes given by structural parameters are read from the instance, or taken from their start values
+//! if the FMU is not instantiated.
+//! @param fmu FMU handle
+//! @param var Variable handle
+//! @param numberOfValues Returns the product of all dimension sizes
+//! @returns True if successful
+bool fmi3_getVariableNumberOfValues(fmiHandle *fmu, fmi3VariableHandle *var, size_t *numberOfValues)
+{
+    (*numberOfValues) = 1;
+    for(int i=0; i<var->numberOfDimensions; ++i) {
+        fmi3Dimension *dim = &var->dimensions[i];
+        fmi3UInt64 size = dim->start;
+        if(!dim->hasStart) {
+            if(fmu->fmi3.fmi3Instance != NULL) {
+                if(fmi3_getUInt64(fmu, &dim->valueReference, 1, &size, 1) >= fmi3Error) {
+                    printf("Failed to get size of dimension %i of variable %s\n", i, var->name);
+                    return false;
+                }
+            }
+            else {
+                fmi3VariableHandle *parameter = fmi3_getVariableByValueReference(fmu, dim->valueReference);
+                if(parameter == NULL) {
+                    return false;
+                }
+                size = parameter->startUInt64;
+            }
+        }
+        (*numberOfValues) *= (size_t)size;
+    }
+    return true;
+}
+
 fmi3Status fmi3_enterEventMode(fmiHandle *fmu)
 {
-    return fmu->fmi3.enterEventMode(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.enterEventMode(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_reset(fmiHandle *fmu)
 {
     TRACEFUNC
 
-    return fmu->fmi3.reset(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.reset(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_getFloat32(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Float32 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getFloat32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getFloat32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getInt8(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Int8 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getUInt8(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3UInt8 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getUInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getUInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getInt16(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Int16 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getUInt16(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3UInt16 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getUInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getUInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getInt32(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Int32 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getUInt32(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3UInt32 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getUInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getUInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getInt64(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Int64 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getUInt64(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3UInt64 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getUInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getUInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getBoolean(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Boolean values[], size_t nValues)
 {
 
-    return fmu->fmi3.getBoolean(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getBoolean(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getString(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3String values[], size_t nValues)
 {
 
-    return fmu->fmi3.getString(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getString(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_getBinary(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, size_t valueSizes[], fmi3Binary values[], size_t nValues)
 {
 
-    return fmu->fmi3.getBinary(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, valueSizes, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getBinary(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, valueSizes, values, nValues));
 }
 
 fmi3Status fmi3_getClock(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Clock values[])
 {
 
-    return fmu->fmi3.getClock(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getClock(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values));
 }
 
 fmi3Status fmi3_setFloat32(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Float32 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setFloat32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setFloat32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setInt8(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Int8 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setUInt8(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3UInt8 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setUInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setUInt8(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setInt16(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Int16 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setUInt16(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3UInt16 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setUInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setUInt16(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setInt32(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Int32 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setUInt32(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3UInt32 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setUInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setUInt32(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setInt64(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Int64 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setUInt64(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3UInt64 values[], size_t nValues)
 {
 
-    return fmu->fmi3.setUInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setUInt64(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setBoolean(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Boolean values[], size_t nValues)
 {
 
-    return fmu->fmi3.setBoolean(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setBoolean(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setString(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3String values[], size_t nValues)
 {
 
-    return fmu->fmi3.setString(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setString(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values, nValues));
 }
 
 fmi3Status fmi3_setBinary(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const size_t valueSizes[], const fmi3Binary values[], size_t nValues)
 {
 
-    return fmu->fmi3.setBinary(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, valueSizes, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setBinary(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, valueSizes, values, nValues));
 }
 
 fmi3Status fmi3_setClock(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Clock values[])
 {
 
-    return fmu->fmi3.setClock(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setClock(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, values));
 }
 
 fmi3Status fmi3_getNumberOfVariableDependencies(fmiHandle *fmu, fmi3ValueReference valueReference, size_t *nDependencies)
 {
 
-    return fmu->fmi3.getNumberOfVariableDependencies(fmu->fmi3.fmi3Instance, valueReference, nDependencies);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getNumberOfVariableDependencies(fmu->fmi3.fmi3Instance, valueReference, nDependencies));
 }
 
 fmi3Status fmi3_getVariableDependencies(fmiHandle *fmu, fmi3ValueReference dependent, size_t elementIndicesOfDependent[], fmi3ValueReference independents[], size_t elementIndicesOfIndependents[], fmi3DependencyKind dependencyKinds[], size_t nDependencies)
 {
 
-    return fmu->fmi3.getVariableDependencies(fmu->fmi3.fmi3Instance, dependent, elementIndicesOfDependent, independents, elementIndicesOfIndependents, dependencyKinds, nDependencies);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getVariableDependencies(fmu->fmi3.fmi3Instance, dependent, elementIndicesOfDependent, independents, elementIndicesOfIndependents, dependencyKinds, nDependencies));
 }
 
 fmi3Status fmi3_getFMUState(fmiHandle *fmu, fmi3FMUState *FMUState)
 {
 
-    return fmu->fmi3.getFMUState(fmu->fmi3.fmi3Instance, FMUState);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getFMUState(fmu->fmi3.fmi3Instance, FMUState));
 }
 
 fmi3Status fmi3_setFMUState(fmiHandle *fmu, fmi3FMUState FMUState)
 {
 
-    return fmu->fmi3.setFMUState(fmu->fmi3.fmi3Instance, FMUState);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.setFMUState(fmu->fmi3.fmi3Instance, FMUState));
 }
 
 fmi3Status fmi3_freeFMUState(fmiHandle *fmu, fmi3FMUState *FMUState)
 {
 
-    return fmu->fmi3.freeFMUState(fmu->fmi3.fmi3Instance, FMUState);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.freeFMUState(fmu->fmi3.fmi3Instance, FMUState));
 }
 
 fmi3Status fmi3_serializedFMUStateSize(fmiHandle *fmu, fmi3FMUState FMUState, size_t *size)
 {
 
-    return fmu->fmi3.serializedFMUStateSize(fmu->fmi3.fmi3Instance, FMUState, size);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.serializedFMUStateSize(fmu->fmi3.fmi3Instance, FMUState, size));
 }
 
 fmi3Status fmi3_serializeFMUState(fmiHandle *fmu, fmi3FMUState FMUState, fmi3Byte serializedState[], size_t size)
 {
 
-    return fmu->fmi3.serializeFMUState(fmu->fmi3.fmi3Instance, FMUState, serializedState, size);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.serializeFMUState(fmu->fmi3.fmi3Instance, FMUState, serializedState, size));
 }
 
 fmi3Status fmi3_deserializeFMUState(fmiHandle *fmu, const fmi3Byte serializedState[], size_t size, fmi3FMUState *FMUState)
 {
 
-    return fmu->fmi3.deserializeFMUState(fmu->fmi3.fmi3Instance, serializedState, size, FMUState);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.deserializeFMUState(fmu->fmi3.fmi3Instance, serializedState, size, FMUState));
 }
 
 fmi3Status fmi3_getDirectionalDerivative(fmiHandle *fmu, const fmi3ValueReference unknowns[], size_t nUnknowns, const fmi3ValueReference knowns[], size_t nKnowns, const fmi3Float64 seed[], size_t nSeed, fmi3Float64 sensitivity[], size_t nSensitivity)
 {
 
-    return fmu->fmi3.getDirectionalDerivative(fmu->fmi3.fmi3Instance, unknowns, nUnknowns, knowns, nKnowns, seed, nSeed, sensitivity, nSensitivity);
+    return PROFILED_CALL(fmu, nUnknowns+nKnowns, fmu->fmi3.getDirectionalDerivative(fmu->fmi3.fmi3Instance, unknowns, nUnknowns, knowns, nKnowns, seed, nSeed, sensitivity, nSensitivity));
 }
 
 fmi3Status fmi3_getAdjointDerivative(fmiHandle *fmu, const fmi3ValueReference unknowns[], size_t nUnknowns, const fmi3ValueReference knowns[], size_t nKnowns, const fmi3Float64 seed[], size_t nSeed, fmi3Float64 sensitivity[], size_t nSensitivity)
 {
 
-    return fmu->fmi3.getAdjointDerivative(fmu->fmi3.fmi3Instance, unknowns, nUnknowns, knowns, nKnowns, seed, nSeed, sensitivity, nSensitivity);
+    return PROFILED_CALL(fmu, nUnknowns+nKnowns, fmu->fmi3.getAdjointDerivative(fmu->fmi3.fmi3Instance, unknowns, nUnknowns, knowns, nKnowns, seed, nSeed, sensitivity, nSensitivity));
 }
 
 fmi3Status fmi3_enterConfigurationMode(fmiHandle *fmu)
 {
 
-    return fmu->fmi3.enterConfigurationMode(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.enterConfigurationMode(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_exitConfigurationMode(fmiHandle *fmu)
 {
 
-    return fmu->fmi3.exitConfigurationMode(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.exitConfigurationMode(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_getIntervalDecimal(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Float64 intervals[], fmi3IntervalQualifier qualifiers[])
 {
 
-    return fmu->fmi3.getIntervalDecimal(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervals, qualifiers);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getIntervalDecimal(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervals, qualifiers));
 }
 
 fmi3Status fmi3_getIntervalFraction(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3UInt64 intervalCounters[], fmi3UInt64 resolutions[], fmi3IntervalQualifier qualifiers[])
 {
 
-    return fmu->fmi3.getIntervalFraction(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervalCounters, resolutions, qualifiers);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getIntervalFraction(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervalCounters, resolutions, qualifiers));
 }
 
 fmi3Status fmi3_getShiftDecimal(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Float64 shifts[])
 {
 
-    return fmu->fmi3.getShiftDecimal(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, shifts);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getShiftDecimal(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, shifts));
 }
 
 fmi3Status fmi3_getShiftFraction(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3UInt64 shiftCounters[], fmi3UInt64 resolutions[])
 {
 
-    return fmu->fmi3.getShiftFraction(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, shiftCounters, resolutions);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getShiftFraction(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, shiftCounters, resolutions));
 }
 
 fmi3Status fmi3_setIntervalDecimal(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Float64 intervals[])
 {
 
-    return fmu->fmi3.setIntervalDecimal(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervals);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setIntervalDecimal(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervals));
 }
 
 fmi3Status fmi3_setIntervalFraction(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3UInt64 intervalCounters[], const fmi3UInt64 resolutions[])
 {
 
-    return fmu->fmi3.setIntervalFraction(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervalCounters, resolutions);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.setIntervalFraction(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, intervalCounters, resolutions));
 }
 
 fmi3Status fmi3_evaluateDiscreteStates(fmiHandle *fmu)
 {
 
-    return fmu->fmi3.evaluateDiscreteStates(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.evaluateDiscreteStates(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_updateDiscreteStates(fmiHandle *fmu, fmi3Boolean *discreteStatesNeedUpdate, fmi3Boolean *terminateSimulation, fmi3Boolean *nominalsOfContinuousStatesChanged, fmi3Boolean *valuesOfContinuousStatesChanged, fmi3Boolean *nextEventTimeDefined, fmi3Float64 *nextEventTime)
 {
 
-    return fmu->fmi3.updateDiscreteStates(fmu->fmi3.fmi3Instance, discreteStatesNeedUpdate, terminateSimulation, nominalsOfContinuousStatesChanged, valuesOfContinuousStatesChanged, nextEventTimeDefined, nextEventTime);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.updateDiscreteStates(fmu->fmi3.fmi3Instance, discreteStatesNeedUpdate, terminateSimulation, nominalsOfContinuousStatesChanged, valuesOfContinuousStatesChanged, nextEventTimeDefined, nextEventTime));
 }
 
 fmi3Status fmi3_enterContinuousTimeMode(fmiHandle *fmu)
 {
 
-    return fmu->fmi3.enterContinuousTimeMode(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.enterContinuousTimeMode(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_completedIntegratorStep(fmiHandle *fmu, fmi3Boolean noSetFMUStatePriorToCurrentPoint, fmi3Boolean *enterEventMode, fmi3Boolean *terminateSimulation)
 {
 
-    return fmu->fmi3.completedIntegratorStep(fmu->fmi3.fmi3Instance, noSetFMUStatePriorToCurrentPoint, enterEventMode, terminateSimulation);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.completedIntegratorStep(fmu->fmi3.fmi3Instance, noSetFMUStatePriorToCurrentPoint, enterEventMode, terminateSimulation));
 }
 
 fmi3Status fmi3_setTime(fmiHandle *fmu, fmi3Float64 time)
 {
 
-    return fmu->fmi3.setTime(fmu->fmi3.fmi3Instance, time);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.setTime(fmu->fmi3.fmi3Instance, time));
 }
 
 fmi3Status fmi3_setContinuousStates(fmiHandle *fmu, const fmi3Float64 continuousStates[], size_t nContinuousStates)
 {
 
-    return fmu->fmi3.setContinuousStates(fmu->fmi3.fmi3Instance, continuousStates, nContinuousStates);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.setContinuousStates(fmu->fmi3.fmi3Instance, continuousStates, nContinuousStates));
 }
 
 fmi3Status fmi3_getContinuousStateDerivatives(fmiHandle *fmu, fmi3Float64 derivatives[], size_t nContinuousStates)
 {
 
-    return fmu->fmi3.getContinuousStateDerivatives(fmu->fmi3.fmi3Instance, derivatives, nContinuousStates);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getContinuousStateDerivatives(fmu->fmi3.fmi3Instance, derivatives, nContinuousStates));
 }
 
 fmi3Status fmi3_getEventIndicators(fmiHandle *fmu, fmi3Float64 eventIndicators[], size_t nEventIndicators)
 {
 
-    return fmu->fmi3.getEventIndicators(fmu->fmi3.fmi3Instance, eventIndicators, nEventIndicators);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getEventIndicators(fmu->fmi3.fmi3Instance, eventIndicators, nEventIndicators));
 }
 
 fmi3Status fmi3_getContinuousStates(fmiHandle *fmu, fmi3Float64 continuousStates[], size_t nContinuousStates)
 {
 
-    return fmu->fmi3.getContinuousStates(fmu->fmi3.fmi3Instance, continuousStates, nContinuousStates);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getContinuousStates(fmu->fmi3.fmi3Instance, continuousStates, nContinuousStates));
 }
 
 fmi3Status fmi3_getNominalsOfContinuousStates(fmiHandle *fmu, fmi3Float64 nominals[], size_t nContinuousStates)
 {
 
-    return fmu->fmi3.getNominalsOfContinuousStates(fmu->fmi3.fmi3Instance, nominals, nContinuousStates);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getNominalsOfContinuousStates(fmu->fmi3.fmi3Instance, nominals, nContinuousStates));
 }
 
 fmi3Status fmi3_getNumberOfEventIndicators(fmiHandle *fmu, size_t *nEventIndicators)
 {
 
-    return fmu->fmi3.getNumberOfEventIndicators(fmu->fmi3.fmi3Instance, nEventIndicators);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getNumberOfEventIndicators(fmu->fmi3.fmi3Instance, nEventIndicators));
 }
 
 fmi3Status fmi3_getNumberOfContinuousStates(fmiHandle *fmu, size_t *nContinuousStates)
 {
 
-    return fmu->fmi3.getNumberOfContinuousStates(fmu->fmi3.fmi3Instance, nContinuousStates);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.getNumberOfContinuousStates(fmu->fmi3.fmi3Instance, nContinuousStates));
 }
 
 fmi3Status fmi3_enterStepMode(fmiHandle *fmu)
 {
 
-    return fmu->fmi3.enterStepMode(fmu->fmi3.fmi3Instance);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.enterStepMode(fmu->fmi3.fmi3Instance));
 }
 
 fmi3Status fmi3_getOutputDerivatives(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Int32 orders[], fmi3Float64 values[], size_t nValues)
 {
 
-    return fmu->fmi3.getOutputDerivatives(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, orders, values, nValues);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi3.getOutputDerivatives(fmu->fmi3.fmi3Instance, valueReferences, nValueReferences, orders, values, nValues));
 }
 
 fmi3Status fmi3_activateModelPartition(fmiHandle *fmu, fmi3ValueReference clockReference, fmi3Float64 activationTime)
 {
 
-    return fmu->fmi3.activateModelPartition(fmu->fmi3.fmi3Instance, clockReference, activationTime);
+    return PROFILED_CALL(fmu, 0, fmu->fmi3.activateModelPartition(fmu->fmi3.fmi3Instance, clockReference, activationTime));
 }
 
 bool fmi3_defaultStartTimeDefined(fmiHandle *fmu)
@@ -3006,10 +3522,9 @@ double fmi2_getDefaultStepSize(fmiHandle *fmu)
 
 fmi3VariableHandle *fmi3_getVariableByName(fmiHandle *fmu, fmi3String name)
 {
-    for(int i=0; i<fmu->fmi3.numberOfVariables; ++i) {
-        if(!strcmp(fmu->fmi3.variables[i].name, name)) {
-            return &fmu->fmi3.variables[i];
-        }
+    int i = findVariableIndexByName(&fmu->fmi3.variableIndex, name);
+    if(i >= 0) {
+        return &fmu->fmi3.variables[i];
     }
     printf("Variable with name %s not found.\n", name);
     return NULL;
@@ -3028,10 +3543,9 @@ fmi3VariableHandle *fmi3_getVariableByIndex(fmiHandle *fmu, int i)
 fmi3VariableHandle *fmi3_getVariableByValueReference(fmiHandle *fmu, fmi3ValueReference vr)
 {
 
-    for(int i=0; i<fmu->fmi3.numberOfVariables; ++i) {
-        if(fmu->fmi3.variables[i].valueReference == vr) {
-            return &fmu->fmi3.variables[i];
-        }
+    int i = findVariableIndexByValueReference(&fmu->fmi3.variableIndex, vr);
+    if(i >= 0) {
+        return &fmu->fmi3.variables[i];
     }
     printf("Variable with value reference %i not found.\n", vr);
     return NULL;
@@ -3044,6 +3558,89 @@ int fmi2_getNumberOfVariables(fmiHandle *fmu)
     return fmu->fmi2.numberOfVariables;
 }
 
+//! @brief Returns value references of all variables, indexed like fmi2_getVariableByIndex()
+//! @param fmu FMU handle
+//! @returns Array of fmi2_getNumberOfVariables() value references, owned by the FMU
+const fmi2ValueReference *fmi2_getVariableValueReferences(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi2.variableArrays.valueReferences;
+}
+
+//! @brief Returns causalities of all variables, indexed like fmi2_getVariableByIndex()
+const fmi2Causality *fmi2_getVariableCausalities(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi2.variableArrays.causalities;
+}
+
+//! @brief Returns variabilities of all variables, indexed like fmi2_getVariableByIndex()
+const fmi2Variability *fmi2_getVariableVariabilities(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi2.variableArrays.variabilities;
+}
+
+//! @brief Returns data types of all variables, indexed like fmi2_getVariableByIndex()
+const fmi2DataType *fmi2_getVariableDataTypes(fmiHandle *fmu)
+{
+    TRACEFUNC
+
+    return fmu->fmi2.variableArrays.dataTypes;
+}
+
+//! @brief Collects value references of all variables with specified causality and data type
+//! Example: all Real outputs, for a single fmi2_getReal() call.
+//! @param fmu FMU handle
+//! @param causality Causality to match
+//! @param dataType Data type to match
+//! @param valueReferences Output array, may be NULL to only count matches
+//! @param maxNumberOfValueReferences Size of output array
+//! @returns Total number of matching variables (may be larger than maxNumberOfValueReferences)
+int fmi2_getValueReferencesByCausality(fmiHandle *fmu, fmi2Causality causality, fmi2DataType dataType, fmi2ValueReference *valueReferences, int maxNumberOfValueReferences)
+{
+    TRACEFUNC
+
+    const fmi2VariableArrays *arrays = &fmu->fmi2.variableArrays;
+    int numberOfMatches = 0;
+    for(int i=0; i<fmu->fmi2.numberOfVariables; ++i) {
+        if(arrays->causalities[i] == causality && arrays->dataTypes[i] == dataType) {
+            if(valueReferences != NULL && numberOfMatches < maxNumberOfValueReferences) {
+                valueReferences[numberOfMatches] = arrays->valueReferences[i];
+            }
+            ++numberOfMatches;
+        }
+    }
+    return numberOfMatches;
+}
+
+//! @brief Collects value references of all variables with specified variability and data type
+//! @param fmu FMU handle
+//! @param variability Variability to match
+//! @param dataType Data type to match
+//! @param valueReferences Output array, may be NULL to only count matches
+//! @param maxNumberOfValueReferences Size of output array
+//! @returns Total number of matching variables (may be larger than maxNumberOfValueReferences)
+int fmi2_getValueReferencesByVariability(fmiHandle *fmu, fmi2Variability variability, fmi2DataType dataType, fmi2ValueReference *valueReferences, int maxNumberOfValueReferences)
+{
+    TRACEFUNC
+
+    const fmi2VariableArrays *arrays = &fmu->fmi2.variableArrays;
+    int numberOfMatches = 0;
+    for(int i=0; i<fmu->fmi2.numberOfVariables; ++i) {
+        if(arrays->variabilities[i] == variability && arrays->dataTypes[i] == dataType) {
+            if(valueReferences != NULL && numberOfMatches < maxNumberOfValueReferences) {
+                valueReferences[numberOfMatches] = arrays->valueReferences[i];
+            }
+            ++numberOfMatches;
+        }
+    }
+    return numberOfMatches;
+}
+
 fmi2VariableHandle *fmi2_getVariableByIndex(fmiHandle *fmu, int i)
 {
     TRACEFUNC
@@ -3059,10 +3656,9 @@ fmi2VariableHandle *fmi2_getVariableByValueReference(fmiHandle *fmu, fmi2ValueRe
 {
     TRACEFUNC
 
-    for(int i=0; i<fmu->fmi2.numberOfVariables; ++i) {
-        if(fmu->fmi2.variables[i].valueReference == vr) {
-            return &fmu->fmi2.variables[i];
-        }
+    int i = findVariableIndexByValueReference(&fmu->fmi2.variableIndex, vr);
+    if(i >= 0) {
+        return &fmu->fmi2.variables[i];
     }
     printf("Variable with value reference %i not found.\n", vr);
     return NULL;
@@ -3070,10 +3666,9 @@ fmi2VariableHandle *fmi2_getVariableByValueReference(fmiHandle *fmu, fmi2ValueRe
 
 fmi2VariableHandle *fmi2_getVariableByName(fmiHandle *fmu, fmi2String name)
 {
-    for(int i=0; i<fmu->fmi2.numberOfVariables; ++i) {
-        if(!strcmp(fmu->fmi2.variables[i].name, name)) {
-            return &fmu->fmi2.variables[i];
-        }
+    int i = findVariableIndexByName(&fmu->fmi2.variableIndex, name);
+    if(i >= 0) {
+        return &fmu->fmi2.variables[i];
     }
     printf("Variable with name %s not found.\n", name);
     return NULL;
@@ -3238,10 +3833,10 @@ fmi2Status fmi2_getReal(fmiHandle *fmu,
                        size_t nValueReferences,
                        fmi2Real values[])
 {
-    return fmu->fmi2.getReal(fmu->fmi2.component,
-                            valueReferences,
-                            nValueReferences,
-                            values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.getReal(fmu->fmi2.component,
+                                                                 valueReferences,
+                                                                 nValueReferences,
+                                                                 values));
 }
 
 fmi2Status fmi2_getInteger(fmiHandle *fmu,
@@ -3251,10 +3846,10 @@ fmi2Status fmi2_getInteger(fmiHandle *fmu,
 {
     TRACEFUNC
 
-    return fmu->fmi2.getInteger(fmu->fmi2.component,
-                                  valueReferences,
-                                  nValueReferences,
-                                  values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.getInteger(fmu->fmi2.component,
+                                                                       valueReferences,
+                                                                       nValueReferences,
+                                                                       values));
 }
 
 fmi2Status fmi2_getBoolean(fmiHandle *fmu,
@@ -3264,10 +3859,10 @@ fmi2Status fmi2_getBoolean(fmiHandle *fmu,
 {
     TRACEFUNC
 
-    return fmu->fmi2.getBoolean(fmu->fmi2.component,
-                                  valueReferences,
-                                  nValueReferences,
-                                  values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.getBoolean(fmu->fmi2.component,
+                                                                       valueReferences,
+                                                                       nValueReferences,
+                                                                       values));
 }
 
 fmi2Status fmi2_getString(fmiHandle *fmu,
@@ -3277,10 +3872,10 @@ fmi2Status fmi2_getString(fmiHandle *fmu,
 {
     TRACEFUNC
 
-    return fmu->fmi2.getString(fmu->fmi2.component,
-                                 valueReferences,
-                                 nValueReferences,
-                                 values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.getString(fmu->fmi2.component,
+                                                                      valueReferences,
+                                                                      nValueReferences,
+                                                                      values));
 }
 
 fmi2Status fmi2_setReal(fmiHandle *fmu,
@@ -3288,10 +3883,10 @@ fmi2Status fmi2_setReal(fmiHandle *fmu,
                        size_t nValueReferences,
                        const fmi2Real values[])
 {
-    return fmu->fmi2.setReal(fmu->fmi2.component,
-                               valueReferences,
-                               nValueReferences,
-                               values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.setReal(fmu->fmi2.component,
+                                                                    valueReferences,
+                                                                    nValueReferences,
+                                                                    values));
 }
 
 fmi2Status fmi2_setInteger(fmiHandle *fmu,
@@ -3301,10 +3896,10 @@ fmi2Status fmi2_setInteger(fmiHandle *fmu,
 {
     TRACEFUNC
 
-    return fmu->fmi2.setInteger(fmu->fmi2.component,
-                               valueReferences,
-                               nValueReferences,
-                               values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.setInteger(fmu->fmi2.component,
+                                                                    valueReferences,
+                                                                    nValueReferences,
+                                                                    values));
 }
 
 fmi2Status fmi2_setBoolean(fmiHandle *fmu,
@@ -3314,10 +3909,10 @@ fmi2Status fmi2_setBoolean(fmiHandle *fmu,
 {
     TRACEFUNC
 
-    return fmu->fmi2.setBoolean(fmu->fmi2.component,
-                               valueReferences,
-                               nValueReferences,
-                               values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.setBoolean(fmu->fmi2.component,
+                                                                    valueReferences,
+                                                                    nValueReferences,
+                                                                    values));
 }
 
 fmi2Status fmi2_setString(fmiHandle *fmu,
@@ -3327,46 +3922,46 @@ fmi2Status fmi2_setString(fmiHandle *fmu,
 {
     TRACEFUNC
 
-    return fmu->fmi2.setString(fmu->fmi2.component,
-                               valueReferences,
-                               nValueReferences,
-                               values);
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi2.setString(fmu->fmi2.component,
+                                                                    valueReferences,
+                                                                    nValueReferences,
+                                                                    values));
 }
 
 fmi2Status fmi2_getFMUstate(fmiHandle* fmu, fmi2FMUstate* FMUstate)
 {
     TRACEFUNC
-    return fmu->fmi2.getFMUstate(fmu->fmi2.component, FMUstate);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.getFMUstate(fmu->fmi2.component, FMUstate));
 }
 
 fmi2Status fmi2_setFMUstate(fmiHandle* fmu, fmi2FMUstate FMUstate)
 {
     TRACEFUNC
-    return fmu->fmi2.setFMUstate(fmu->fmi2.component, FMUstate);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.setFMUstate(fmu->fmi2.component, FMUstate));
 }
 
 fmi2Status fmi2_freeFMUstate(fmiHandle* fmu, fmi2FMUstate* FMUstate)
 {
     TRACEFUNC
-    return fmu->fmi2.freeFMUstate(fmu->fmi2.component, FMUstate);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.freeFMUstate(fmu->fmi2.component, FMUstate));
 }
 
 fmi2Status fmi2_serializedFMUstateSize(fmiHandle* fmu, fmi2FMUstate FMUstate, size_t* size)
 {
     TRACEFUNC
-    return fmu->fmi2.serializedFMUstateSize(fmu->fmi2.component, FMUstate, size);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.serializedFMUstateSize(fmu->fmi2.component, FMUstate, size));
 }
 
 fmi2Status fmi2_serializeFMUstate(fmiHandle* fmu, fmi2FMUstate FMUstate, fmi2Byte serializedState[], size_t size)
 {
     TRACEFUNC
-    return fmu->fmi2.serializeFMUstate(fmu->fmi2.component, FMUstate, serializedState, size);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.serializeFMUstate(fmu->fmi2.component, FMUstate, serializedState, size));
 }
 
 fmi2Status fmi2_deSerializeFMUstate(fmiHandle* fmu, const fmi2Byte serializedState[], size_t size, fmi2FMUstate* FMUstate)
 {
     TRACEFUNC
-    return fmu->fmi2.deSerializeFMUstate(fmu->fmi2.component, serializedState, size, FMUstate);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.deSerializeFMUstate(fmu->fmi2.component, serializedState, size, FMUstate));
 }
 
 fmi2Status fmi2_getDirectionalDerivative(fmiHandle* fmu,
@@ -3378,31 +3973,31 @@ fmi2Status fmi2_getDirectionalDerivative(fmiHandle* fmu,
                                         fmi2Real dvUnknown[])
 {
     TRACEFUNC
-    return fmu->fmi2.getDirectionalDerivative(fmu->fmi2.component,
-                                             unknownReferences,
-                                             nUnknown,
-                                             knownReferences,
-                                             nKnown,
-                                             dvKnown,
-                                             dvUnknown);
+    return PROFILED_CALL(fmu, nUnknown+nKnown, fmu->fmi2.getDirectionalDerivative(fmu->fmi2.component,
+                                                                                 unknownReferences,
+                                                                                 nUnknown,
+                                                                                 knownReferences,
+                                                                                 nKnown,
+                                                                                 dvKnown,
+                                                                                 dvUnknown));
 }
 
 fmi2Status fmi2_enterEventMode(fmiHandle* fmu)
 {
     TRACEFUNC
-    return fmu->fmi2.enterEventMode(fmu->fmi2.component);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.enterEventMode(fmu->fmi2.component));
 }
 
 fmi2Status fmi2_newDiscreteStates(fmiHandle* fmu, fmi2EventInfo* eventInfo)
 {
     TRACEFUNC
-            return fmu->fmi2.newDiscreteStates(fmu->fmi2.component, eventInfo);
+            return PROFILED_CALL(fmu, 0, fmu->fmi2.newDiscreteStates(fmu->fmi2.component, eventInfo));
 }
 
 fmi2Status fmi2_enterContinuousTimeMode(fmiHandle* fmu)
 {
     TRACEFUNC
-    return fmu->fmi2.enterContinuousTimeMode(fmu->fmi2.component);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.enterContinuousTimeMode(fmu->fmi2.component));
 }
 
 fmi2Status fmi2_completedIntegratorStep(fmiHandle* fmu,
@@ -3411,16 +4006,16 @@ fmi2Status fmi2_completedIntegratorStep(fmiHandle* fmu,
                                        fmi2Boolean* terminateSimulation)
 {
     TRACEFUNC
-    return fmu->fmi2.completedIntegratorStep(fmu->fmi2.component,
-                                            noSetFMUStatePriorToCurrentPoint,
-                                            enterEventMode,
-                                            terminateSimulation);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.completedIntegratorStep(fmu->fmi2.component,
+                                                                  noSetFMUStatePriorToCurrentPoint,
+                                                                  enterEventMode,
+                                                                  terminateSimulation));
 }
 
 fmi2Status fmi2_setTime(fmiHandle* fmu, fmi2Real time)
 {
     TRACEFUNC
-    return fmu->fmi2.setTime(fmu->fmi2.component, time);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.setTime(fmu->fmi2.component, time));
 }
 
 fmi2Status fmi2_setContinuousStates(fmiHandle* fmu,
@@ -3428,31 +4023,31 @@ fmi2Status fmi2_setContinuousStates(fmiHandle* fmu,
                                    size_t nx)
 {
     TRACEFUNC
-    return fmu->fmi2.setContinuousStates(fmu->fmi2.component, x, nx);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.setContinuousStates(fmu->fmi2.component, x, nx));
 }
 
 fmi2Status fmi2_getDerivatives(fmiHandle* fmu, fmi2Real derivatives[], size_t nx)
 {
     TRACEFUNC
-    return fmu->fmi2.getDerivatives(fmu->fmi2.component, derivatives, nx);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.getDerivatives(fmu->fmi2.component, derivatives, nx));
 }
 
 fmi2Status fmi2_getEventIndicators(fmiHandle* fmu, fmi2Real eventIndicators[], size_t ni)
 {
     TRACEFUNC
-    return fmu->fmi2.getEventIndicators(fmu->fmi2.component, eventIndicators, ni);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.getEventIndicators(fmu->fmi2.component, eventIndicators, ni));
 }
 
 fmi2Status fmi2_getContinuousStates(fmiHandle* fmu, fmi2Real x[], size_t nx)
 {
     TRACEFUNC
-    return fmu->fmi2.getContinuousStates(fmu->fmi2.component, x, nx);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.getContinuousStates(fmu->fmi2.component, x, nx));
 }
 
 fmi2Status fmi2_getNominalsOfContinuousStates(fmiHandle* fmu, fmi2Real x_nominal[], size_t nx)
 {
     TRACEFUNC
-    return fmu->fmi2.getNominalsOfContinuousStates(fmu->fmi2.component, x_nominal, nx);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.getNominalsOfContinuousStates(fmu->fmi2.component, x_nominal, nx));
 }
 
 fmi2Status fmi2_setRealInputDerivatives(fmiHandle* fmu, const fmi2ValueReference [], size_t, const fmi2Integer [], const fmi2Real []);
@@ -3465,7 +4060,7 @@ fmi2Status fmi2_setRealInputDerivatives(fmiHandle* fmu,
                                        const fmi2Real value[])
 {
     TRACEFUNC
-    return fmu->fmi2.setRealInputDerivatives(fmu->fmi2.component, vr, nvr, order, value);
+    return PROFILED_CALL(fmu, nvr, fmu->fmi2.setRealInputDerivatives(fmu->fmi2.component, vr, nvr, order, value));
 }
 
 fmi2Status fmi2_getRealOutputDerivatives (fmiHandle* fmu,
@@ -3475,15 +4070,15 @@ fmi2Status fmi2_getRealOutputDerivatives (fmiHandle* fmu,
                                          fmi2Real value[])
 {
     TRACEFUNC
-    return fmu->fmi2.getRealOutputDerivatives(fmu->fmi2.component, vr, nvr, order, value);
+    return PROFILED_CALL(fmu, nvr, fmu->fmi2.getRealOutputDerivatives(fmu->fmi2.component, vr, nvr, order, value));
 }
 
 fmi2Status fmi2_doStep(fmiHandle *fmu, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint)
 {
-    return fmu->fmi2.doStep(fmu->fmi2.component,
-                              currentCommunicationPoint,
-                              communicationStepSize,
-                              noSetFMUStatePriorToCurrentPoint);
+    return PROFILED_CALL(fmu, 0, fmu->fmi2.doStep(fmu->fmi2.component,
+                                                    currentCommunicationPoint,
+                                                    communicationStepSize,
+                                                    noSetFMUStatePriorToCurrentPoint));
 }
 
 const char *fmi2_getGuid(fmiHandle *fmu)
@@ -3835,846 +4430,2105 @@ bool fmi3me_getNeedsCompletedIntegratorStep(fmiHandle *fmu)
 }
 
 
-//! @brief Loads the FMU as version 1.
-//! First parses modelDescription.xml, then loads all required FMI functions.
-//! @param fmu FMU handle
-//! @returns Handle to FMU with FMI version 1
-fmiHandle *fmi4c_loadFmu(const char *fmufile, const char* instanceName)
+//! @brief Assigns placeholder functions to the FMI function pointers of the FMU's FMI version
+//! @param fmu FMU handle with known version
+static void setPlaceholderFunctions(fmiHandle *fmu)
 {
-   char cwd[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
-
-    int argc = 6;
-    const char *argv[6];
-
-#ifdef _WIN32
-    mkdir(instanceName);
-#else
-    mkdir(instanceName, S_IRWXU | S_IRWXG | S_IRWXO);
-#endif
+    if(fmu->version == fmiVersion1) {
+        fmu->fmi1.getVersion = placeholder_fmiGetVersion;
+        fmu->fmi1.getTypesPlatform = placeholder_fmiGetTypesPlatform;
+        fmu->fmi1.setDebugLogging = placeholder;
+        fmu->fmi1.getReal = placeholder_fmiGetReal;
+        fmu->fmi1.getInteger = placeholder_fmiGetInteger;
+        fmu->fmi1.getBoolean = placeholder_fmiGetBoolean;
+        fmu->fmi1.getString = placeholder_fmiGetString;
+        fmu->fmi1.setReal = placeholder_fmiSetReal;
+        fmu->fmi1.setInteger = placeholder_fmiSetInteger;
+        fmu->fmi1.setBoolean = placeholder_fmiSetBoolean;
+        fmu->fmi1.setString = placeholder_fmiSetString;
+        fmu->fmi1.instantiateSlave = placeholder_fmiInstantiateSlave;
+        fmu->fmi1.initializeSlave = placeholder_fmiInitializeSlave;
+        fmu->fmi1.terminateSlave = placeholder_fmiTerminateSlave;
+        fmu->fmi1.resetSlave = placeholder_fmiResetSlave;
+        fmu->fmi1.freeSlaveInstance = placeholder_fmiFreeSlaveInstance;
+        fmu->fmi1.setRealInputDerivatives = placeholder_fmiSetRealInputDerivatives;
+        fmu->fmi1.getRealOutputDerivatives = placeholder_fmiGetRealOutputDerivatives;
+        fmu->fmi1.cancelStep = placeholder_fmiCancelStep;
+        fmu->fmi1.doStep = placeholder_fmiDoStep;
+        fmu->fmi1.getStatus = placeholder_fmiGetStatus;
+        fmu->fmi1.getRealStatus = placeholder_fmiGetRealStatus;
+        fmu->fmi1.getIntegerStatus = placeholder_fmiGetIntegerStatus;
+        fmu->fmi1.getBooleanStatus = placeholder_fmiGetBooleanStatus;
+        fmu->fmi1.getStringStatus = placeholder_fmiGetStringStatus;
+        fmu->fmi1.getModelTypesPlatform = placeholder_fmiGetModelTypesPlatform;
+        fmu->fmi1.instantiateModel = placeholder_fmiInstantiateModel;
+        fmu->fmi1.freeModelInstance = placeholder_fmiFreeModelInstance;
+        fmu->fmi1.setTime = placeholder_fmiSetTime;
+        fmu->fmi1.setContinuousStates = placeholder_fmiSetContinuousStates;
+        fmu->fmi1.completedIntegratorStep = placeholder_fmiCompletedIntegratorStep;
+        fmu->fmi1.initialize = placeholder_fmiInitialize;
+        fmu->fmi1.getDerivatives = placeholder_fmiGetDerivatives;
+        fmu->fmi1.getEventIndicators = placeholder_fmiGetEventIndicators;
+        fmu->fmi1.eventUpdate = placeholder_fmiEventUpdate;
+        fmu->fmi1.getContinuousStates = placeholder_fmiGetContinuousStates;
+        fmu->fmi1.getNominalContinuousStates = placeholder_fmiGetNominalContinuousStates;
+        fmu->fmi1.getStateValueReferences = placeholder_fmiGetStateValueReferences;
+        fmu->fmi1.terminate = placeholder_fmiTerminate;
+    }
+    else if(fmu->version == fmiVersion2) {
+        fmu->fmi2.getTypesPlatform = placeholder_fmi2_getTypesPlatform;
+        fmu->fmi2.getVersion = placeholder_fmi2_getVersion;
+        fmu->fmi2.setDebugLogging = placeholder_fmi2_setDebugLogging;
+        fmu->fmi2.instantiate = placeholder_fmi2Instantiate;
+        fmu->fmi2.freeInstance = placeholder_fmi2FreeInstance;
+        fmu->fmi2.setupExperiment = placeholder_fmi2_setupExperiment;
+        fmu->fmi2.enterInitializationMode = placeholder_fmi2EnterInitializationMode;
+        fmu->fmi2.exitInitializationMode = placeholder_fmi2ExitInitializationMode;
+        fmu->fmi2.terminate = placeholder_fmi2Terminate;
+        fmu->fmi2.reset = placeholder_fmi2Reset;
+        fmu->fmi2.getReal = placeholder_fmi2_getReal;
+        fmu->fmi2.getInteger = placeholder_fmi2_getInteger;
+        fmu->fmi2.getBoolean = placeholder_fmi2_getBoolean;
+        fmu->fmi2.getString = placeholder_fmi2_getString;
+        fmu->fmi2.setReal = placeholder_fmi2_setReal;
+        fmu->fmi2.setInteger = placeholder_fmi2_setInteger;
+        fmu->fmi2.setBoolean = placeholder_fmi2_setBoolean;
+        fmu->fmi2.setString = placeholder_fmi2_setString;
+        fmu->fmi2.getFMUstate = placeholder_fmi2_getFMUstate;
+        fmu->fmi2.setFMUstate = placeholder_fmi2_setFMUstate;
+        fmu->fmi2.freeFMUstate = placeholder_fmi2FreeFMUstate;
+        fmu->fmi2.serializedFMUstateSize = placeholder_fmi2SerializedFMUstateSize;
+        fmu->fmi2.serializeFMUstate = placeholder_fmi2SerializeFMUstate;
+        fmu->fmi2.deSerializeFMUstate = placeholder_fmi2DeSerializeFMUstate;
+        fmu->fmi2.getDirectionalDerivative = placeholder_fmi2_getDirectionalDerivative;
+        fmu->fmi2.enterEventMode = placeholder_fmi2EnterEventMode;
+        fmu->fmi2.newDiscreteStates = placeholder_fmi2NewDiscreteStates;
+        fmu->fmi2.enterContinuousTimeMode = placeholder_fmi2EnterContinuousTimeMode;
+        fmu->fmi2.completedIntegratorStep = placeholder_fmi2CompletedIntegratorStep;
+        fmu->fmi2.setTime = placeholder_fmi2_setTime;
+        fmu->fmi2.setContinuousStates = placeholder_fmi2_setContinuousStates;
+        fmu->fmi2.getDerivatives = placeholder_fmi2_getDerivatives;
+        fmu->fmi2.getEventIndicators = placeholder_fmi2_getEventIndicators;
+        fmu->fmi2.getContinuousStates = placeholder_fmi2_getContinuousStates;
+        fmu->fmi2.getNominalsOfContinuousStates = placeholder_fmi2_getNominalsOfContinuousStates;
+        fmu->fmi2.setRealInputDerivatives = placeholder_fmi2_setRealInputDerivatives;
+        fmu->fmi2.getRealOutputDerivatives = placeholder_fmi2_getRealOutputDerivatives;
+        fmu->fmi2.doStep = placeholder_fmi2DoStep;
+        fmu->fmi2.cancelStep = placeholder_fmi2CancelStep;
+        fmu->fmi2.getStatus = placeholder_fmi2_getStatus;
+        fmu->fmi2.getRealStatus = placeholder_fmi2_getRealStatus;
+        fmu->fmi2.getIntegerStatus = placeholder_fmi2_getIntegerStatus;
+        fmu->fmi2.getBooleanStatus = placeholder_fmi2_getBooleanStatus;
+        fmu->fmi2.getStringStatus = placeholder_fmi2_getStringStatus;
+    }
+    else if(fmu->version == fmiVersion3) {
+        fmu->fmi3.getVersion = placeholder_fmi3GetVersion;
+        fmu->fmi3.setDebugLogging = placeholder_fmi3SetDebugLogging;
+        fmu->fmi3.instantiateModelExchange = placeholder_fmi3InstantiateModelExchange;
+        fmu->fmi3.instantiateCoSimulation = placeholder_fmi3InstantiateCoSimulation;
+        fmu->fmi3.instantiateScheduledExecution = placeholder_fmi3InstantiateScheduledExecution;
+        fmu->fmi3.freeInstance = placeholder_fmi3FreeInstance;
+        fmu->fmi3.enterInitializationMode = placeholder_fmi3EnterInitializationMode;
+        fmu->fmi3.exitInitializationMode = placeholder_fmi3ExitInitializationMode;
+        fmu->fmi3.terminate = placeholder_fmi3Terminate;
+        fmu->fmi3.setFloat64 = placeholder_fmi3SetFloat64;
+        fmu->fmi3.getFloat64 = placeholder_fmi3GetFloat64;
+        fmu->fmi3.doStep = placeholder_fmi3DoStep;
+        fmu->fmi3.enterEventMode = placeholder_fmi3EnterEventMode;
+        fmu->fmi3.reset = placeholder_fmi3Reset;
+        fmu->fmi3.getFloat32 = placeholder_fmi3GetFloat32;
+        fmu->fmi3.getInt8 = placeholder_fmi3GetInt8;
+        fmu->fmi3.getUInt8 = placeholder_fmi3GetUInt8;
+        fmu->fmi3.getInt16 = placeholder_fmi3GetInt16;
+        fmu->fmi3.getUInt16 = placeholder_fmi3GetUInt16;
+        fmu->fmi3.getInt32 = placeholder_fmi3GetInt32;
+        fmu->fmi3.getUInt32 = placeholder_fmi3GetUInt32;
+        fmu->fmi3.getInt64 = placeholder_fmi3GetInt64;
+        fmu->fmi3.getUInt64 = placeholder_fmi3GetUInt64;
+        fmu->fmi3.getBoolean = placeholder_fmi3GetBoolean;
+        fmu->fmi3.getString = placeholder_fmi3GetString;
+        fmu->fmi3.getBinary = placeholder_fmi3GetBinary;
+        fmu->fmi3.getClock = placeholder_fmi3GetClock;
+        fmu->fmi3.setFloat32 = placeholder_fmi3SetFloat32;
+        fmu->fmi3.setInt8 = placeholder_fmi3SetInt8;
+        fmu->fmi3.setUInt8 = placeholder_fmi3SetUInt8;
+        fmu->fmi3.setInt16 = placeholder_fmi3SetInt16;
+        fmu->fmi3.setUInt16 = placeholder_fmi3SetUInt16;
+        fmu->fmi3.setInt32 = placeholder_fmi3SetInt32;
+        fmu->fmi3.setUInt32 = placeholder_fmi3SetUInt32;
+        fmu->fmi3.setInt64 = placeholder_fmi3SetInt64;
+        fmu->fmi3.setUInt64 = placeholder_fmi3SetUInt64;
+        fmu->fmi3.setBoolean = placeholder_fmi3SetBoolean;
+        fmu->fmi3.setString = placeholder_fmi3SetString;
+        fmu->fmi3.setBinary = placeholder_fmi3SetBinary;
+        fmu->fmi3.setClock = placeholder_fmi3SetClock;
+        fmu->fmi3.getNumberOfVariableDependencies = placeholder_fmi3GetNumberOfVariableDependencies;
+        fmu->fmi3.getVariableDependencies = placeholder_fmi3GetVariableDependencies;
+        fmu->fmi3.getFMUState = placeholder_fmi3GetFMUState;
+        fmu->fmi3.setFMUState = placeholder_fmi3SetFMUState;
+        fmu->fmi3.freeFMUState = placeholder_fmi3FreeFMUState;
+        fmu->fmi3.serializedFMUStateSize = placeholder_fmi3SerializedFMUStateSize;
+        fmu->fmi3.serializeFMUState = placeholder_fmi3SerializeFMUState;
+        fmu->fmi3.deserializeFMUState = placeholder_fmi3DeserializeFMUState;
+        fmu->fmi3.getDirectionalDerivative = placeholder_fmi3GetDirectionalDerivative;
+        fmu->fmi3.getAdjointDerivative = placeholder_fmi3GetAdjointDerivative;
+        fmu->fmi3.enterConfigurationMode = placeholder_fmi3EnterConfigurationMode;
+        fmu->fmi3.exitConfigurationMode = placeholder_fmi3ExitConfigurationMode;
+        fmu->fmi3.getIntervalDecimal = placeholder_fmi3GetIntervalDecimal;
+        fmu->fmi3.getIntervalFraction = placeholder_fmi3GetIntervalFraction;
+        fmu->fmi3.getShiftDecimal = placeholder_fmi3GetShiftDecimal;
+        fmu->fmi3.getShiftFraction = placeholder_fmi3GetShiftFraction;
+        fmu->fmi3.setIntervalDecimal = placeholder_fmi3SetIntervalDecimal;
+        fmu->fmi3.setIntervalFraction = placeholder_fmi3SetIntervalFraction;
+        fmu->fmi3.setShiftDecimal = placeholder_fmi3SetShiftDecimal;
+        fmu->fmi3.setShiftFraction = placeholder_fmi3SetShiftFraction;
+        fmu->fmi3.evaluateDiscreteStates = placeholder_fmi3EvaluateDiscreteStates;
+        fmu->fmi3.updateDiscreteStates = placeholder_fmi3UpdateDiscreteStates;
+        fmu->fmi3.enterContinuousTimeMode = placeholder_fmi3EnterContinuousTimeMode;
+        fmu->fmi3.completedIntegratorStep = placeholder_fmi3CompletedIntegratorStep;
+        fmu->fmi3.setTime = placeholder_fmi3SetTime;
+        fmu->fmi3.setContinuousStates = placeholder_fmi3SetContinuousStates;
+        fmu->fmi3.getContinuousStateDerivatives = placeholder_fmi3GetContinuousStateDerivatives;
+        fmu->fmi3.getEventIndicators = placeholder_fmi3GetEventIndicators;
+        fmu->fmi3.getContinuousStates = placeholder_fmi3GetContinuousStates;
+        fmu->fmi3.getNominalsOfContinuousStates = placeholder_fmi3GetNominalsOfContinuousStates;
+        fmu->fmi3.getNumberOfEventIndicators = placeholder_fmi3GetNumberOfEventIndicators;
+        fmu->fmi3.getNumberOfContinuousStates = placeholder_fmi3GetNumberOfContinuousStates;
+        fmu->fmi3.enterStepMode = placeholder_fmi3EnterStepMode;
+        fmu->fmi3.getOutputDerivatives = placeholder_fmi3GetOutputDerivatives;
+        fmu->fmi3.activateModelPartition = placeholder_fmi3ActivateModelPartition;
+    }
+}
 
-    argv[0] = "miniunz";
-    argv[1] = "-x";
-    argv[2] = "-o";
-    argv[3] = fmufile;
-    argv[4] = "-d";
-    argv[5] = instanceName;
 
-    int status = miniunz(argc, (char**)argv);
+//! @brief Releases an FMU handle that failed to load
+//! @param fmu FMU handle
+//! @returns Always NULL
+static fmiHandle *abortLoadFmu(fmiHandle *fmu)
+{
+    freeArena(&fmu->arena);
+    fmi4cFree((char*)fmu->unzippedLocation);
+    fmi4cFree((char*)fmu->resourcesLocation);
+    fmi4cFree((char*)fmu->instanceName);
+    fmi4cFree((char*)fmu->fmuFile);
+    fmi4cFree(fmu);
+    return NULL;
+}
 
-    if (status != 0) {
-        printf("Failed to unzip FMU: status = %i\n",status);
-        return NULL;
-    }
 
-    fmiHandle *fmu = malloc(sizeof(fmiHandle));
+//! @brief Allocates a new FMU handle with all locations unset
+//! @returns New FMU handle
+static fmiHandle *allocateFmuHandle()
+{
+    fmiHandle *fmu = fmi4cCalloc(1, sizeof(fmiHandle));     //Zeroed, so that unset model description fields are well defined
     fmu->unzippedLocation = NULL;
     fmu->resourcesLocation = NULL;
     fmu->instanceName = NULL;
+    fmu->fmuFile = NULL;
+    fmu->extracted = true;
+    fmu->dll = NULL;
+    fmu->parseTime = 0;
+    fmu->libraryLoadTime = 0;
+    fmu->sharedModel = NULL;
+    fmu->arena.blocks = NULL;
+    fmu->arena.buffers = NULL;
+    fmu->profile = NULL;
+    fmu->mappedDescription = NULL;
+    fmu->mappedDescriptionSize = 0;
+    fmu->hostExecutable = NULL;
+    fmu->host = NULL;
+    fmu->preloadedDll = NULL;
+    fmu->preloadedDllPath = NULL;
+    return fmu;
+}
 
-    //Decide location for where to unzip
-    //! @todo Change to temp folder
-    char tempPath[FILENAME_MAX];
-#ifdef _WIN32
-    _getcwd(tempPath, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(tempPath, sizeof(char)*FILENAME_MAX);
-#endif
-    fmu->unzippedLocation = _strdup(tempPath);
 
-    strncat(tempPath, "/resources", sizeof(tempPath)-strlen(tempPath)-1);
+//! @brief Builds the structure-of-arrays copies of variable attributes for FMI 2
+//! @param fmu FMU handle with parsed variables
+static void buildVariableArraysFmi2(fmiHandle *fmu)
+{
+    int n = fmu->fmi2.numberOfVariables;
+    fmi2VariableArrays *arrays = &fmu->fmi2.variableArrays;
+    arrays->valueReferences = arenaAlloc(&fmu->arena, n*sizeof(fmi2ValueReference));
+    arrays->causalities = arenaAlloc(&fmu->arena, n*sizeof(fmi2Causality));
+    arrays->variabilities = arenaAlloc(&fmu->arena, n*sizeof(fmi2Variability));
+    arrays->dataTypes = arenaAlloc(&fmu->arena, n*sizeof(fmi2DataType));
+    for(int i=0; i<n; ++i) {
+        arrays->valueReferences[i] = (fmi2ValueReference)fmu->fmi2.variables[i].valueReference;
+        arrays->causalities[i] = fmu->fmi2.variables[i].causality;
+        arrays->variabilities[i] = fmu->fmi2.variables[i].variability;
+        arrays->dataTypes[i] = fmu->fmi2.variables[i].datatype;
+    }
+}
 
-    char uriPath[FILENAME_MAX] = "file:///";
-    strncat(uriPath, tempPath, sizeof(tempPath));
-    fmu->resourcesLocation = _strdup(uriPath);
 
-    fmu->instanceName = _strdup(instanceName);
-    chdir(cwd);
+//! @brief Builds the structure-of-arrays copies of variable attributes for FMI 3
+//! @param fmu FMU handle with parsed variables
+static void buildVariableArraysFmi3(fmiHandle *fmu)
+{
+    int n = fmu->fmi3.numberOfVariables;
+    fmi3VariableArrays *arrays = &fmu->fmi3.variableArrays;
+    arrays->valueReferences = arenaAlloc(&fmu->arena, n*sizeof(fmi3ValueReference));
+    arrays->causalities = arenaAlloc(&fmu->arena, n*sizeof(fmi3Causality));
+    arrays->variabilities = arenaAlloc(&fmu->arena, n*sizeof(fmi3Variability));
+    arrays->dataTypes = arenaAlloc(&fmu->arena, n*sizeof(fmi3DataType));
+    for(int i=0; i<n; ++i) {
+        arrays->valueReferences[i] = (fmi3ValueReference)fmu->fmi3.variables[i].valueReference;
+        arrays->causalities[i] = fmu->fmi3.variables[i].causality;
+        arrays->variabilities[i] = fmu->fmi3.variables[i].variability;
+        arrays->dataTypes[i] = fmu->fmi3.variables[i].datatype;
+    }
+}
 
-#ifdef _WIN32
-    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#else
-    getcwd(cwd, sizeof(char)*FILENAME_MAX);
-#endif
-    chdir(fmu->unzippedLocation);
 
-    ezxml_t rootElement = ezxml_parse_file("modelDescription.xml");
+//! @brief Figures out the FMI version and parses modelDescription.xml
+//! @param fmu FMU handle with locations set
+//! @returns True if successful
+static bool loadModelDescription(fmiHandle *fmu)
+{
+    double startTime = getWallTime();
 
-    if(strcmp(rootElement->name, "fmiModelDescription")) {
-        printf("Wrong root tag name: %s\n", rootElement->name);
-        free((char*)fmu->unzippedLocation);
-        free(fmu);
-        return NULL;
+    size_t size;
+    char *xml = readModelDescriptionXml(fmu, &size);
+    if(xml == NULL) {
+        printf("Failed to read modelDescription.xml\n");
+        return false;
+    }
+
+#ifdef FMI4C_WITH_PUGIXML
+    //Parsed in place, the arena owns the buffer, so that strings in the model description can point into it
+    if(!arenaAdopt(&fmu->arena, xml)) {
+        fmi4cFree(xml);
+        return false;
+    }
+    fmiXmlDocument *document = parseXmlDocument(xml, size);
+    xml = NULL;
+#else
+    //When streaming, the tree is built without the variables, which are parsed separately from the original buffer
+    char *variablesStart = NULL;
+    char *variablesEnd = NULL;
+    fmiXmlDocument *document;
+    if((parseOptions & FMI4C_PARSE_STREAMING) && findModelVariablesContents(xml, size, &variablesStart, &variablesEnd)) {
+        size_t headSize = variablesStart-xml;
+        size_t tailSize = size-(variablesEnd-xml);
+        char *xmlWithoutVariables = fmi4cMalloc(headSize+tailSize+1);
+        memcpy(xmlWithoutVariables, xml, headSize);
+        memcpy(xmlWithoutVariables+headSize, variablesEnd, tailSize+1);
+        document = parseXmlDocument(xmlWithoutVariables, headSize+tailSize);
     }
+    else {
+        document = parseXmlDocument(xml, size);
+        xml = NULL;     //Owned by the tree
+    }
+#endif
 
-    chdir(cwd);
+    if(document == NULL) {
+        printf("Failed to read modelDescription.xml\n");
+        fmi4cFree(xml);
+        return false;
+    }
+    fmiXmlElement rootElement = xmlDocumentElement(document);
+    if(rootElement == NULL || xmlName(rootElement) == NULL || strcmp(xmlName(rootElement), "fmiModelDescription")) {
+        printf("Wrong root tag name: %s\n", (rootElement && xmlName(rootElement)) ? xmlName(rootElement) : "");
+        freeXmlDocument(document);
+        fmi4cFree(xml);
+        return false;
+    }
 
     //Figure out FMI version
-    const char* version;
-    parseStringAttributeEzXml(rootElement, "fmiVersion", &version);
-    if(version[0] == '1') {
+    const char* version = NULL;
+    parseStringAttributeXml(rootElement, "fmiVersion", &version, &fmu->arena);
+    if(version != NULL && version[0] == '1') {
         fmu->version = fmiVersion1;
     }
-    else if(version[0] == '2') {
+    else if(version != NULL && version[0] == '2') {
         fmu->version = fmiVersion2;
     }
-    else if(version[0] == '3') {
+    else if(version != NULL && version[0] == '3') {
         fmu->version = fmiVersion3;
     }
     else {
-        printf("Unsupported FMI version: %s\n", version);
-        free((char*)version);
-        free(fmu);
-        return NULL;
+        printf("Unsupported FMI version: %s\n", version ? version : "");
+        freeXmlDocument(document);
+        fmi4cFree(xml);
+        return false;
+    }
+
+    //Streaming is only implemented for FMI 3, use the whole tree for older versions
+    if(xml != NULL && fmu->version != fmiVersion3) {
+        freeXmlDocument(document);
+        document = parseXmlDocument(xml, size);
+        rootElement = xmlDocumentElement(document);
+        xml = NULL;
     }
-    free((char*)version);
-
-    ezxml_free(rootElement);
-
-    fmu->fmi1.getVersion = placeholder_fmiGetVersion;
-    fmu->fmi1.getTypesPlatform = placeholder_fmiGetTypesPlatform;
-    fmu->fmi1.setDebugLogging = placeholder;
-    fmu->fmi1.getReal = placeholder_fmiGetReal;
-    fmu->fmi1.getInteger = placeholder_fmiGetInteger;
-    fmu->fmi1.getBoolean = placeholder_fmiGetBoolean;
-    fmu->fmi1.getString = placeholder_fmiGetString;
-    fmu->fmi1.setReal = placeholder_fmiSetReal;
-    fmu->fmi1.setInteger = placeholder_fmiSetInteger;
-    fmu->fmi1.setBoolean = placeholder_fmiSetBoolean;
-    fmu->fmi1.setString = placeholder_fmiSetString;
-    fmu->fmi1.instantiateSlave = placeholder_fmiInstantiateSlave;
-    fmu->fmi1.initializeSlave = placeholder_fmiInitializeSlave;
-    fmu->fmi1.terminateSlave = placeholder_fmiTerminateSlave;
-    fmu->fmi1.resetSlave = placeholder_fmiResetSlave;
-    fmu->fmi1.freeSlaveInstance = placeholder_fmiFreeSlaveInstance;
-    fmu->fmi1.setRealInputDerivatives = placeholder_fmiSetRealInputDerivatives;
-    fmu->fmi1.getRealOutputDerivatives = placeholder_fmiGetRealOutputDerivatives;
-    fmu->fmi1.cancelStep = placeholder_fmiCancelStep;
-    fmu->fmi1.doStep = placeholder_fmiDoStep;
-    fmu->fmi1.getStatus = placeholder_fmiGetStatus;
-    fmu->fmi1.getRealStatus = placeholder_fmiGetRealStatus;
-    fmu->fmi1.getIntegerStatus = placeholder_fmiGetIntegerStatus;
-    fmu->fmi1.getBooleanStatus = placeholder_fmiGetBooleanStatus;
-    fmu->fmi1.getStringStatus = placeholder_fmiGetStringStatus;
-    fmu->fmi1.getModelTypesPlatform = placeholder_fmiGetModelTypesPlatform;
-    fmu->fmi1.instantiateModel = placeholder_fmiInstantiateModel;
-    fmu->fmi1.freeModelInstance = placeholder_fmiFreeModelInstance;
-    fmu->fmi1.setTime = placeholder_fmiSetTime;
-    fmu->fmi1.setContinuousStates = placeholder_fmiSetContinuousStates;
-    fmu->fmi1.completedIntegratorStep = placeholder_fmiCompletedIntegratorStep;
-    fmu->fmi1.initialize = placeholder_fmiInitialize;
-    fmu->fmi1.getDerivatives = placeholder_fmiGetDerivatives;
-    fmu->fmi1.getEventIndicators = placeholder_fmiGetEventIndicators;
-    fmu->fmi1.eventUpdate = placeholder_fmiEventUpdate;
-    fmu->fmi1.getContinuousStates = placeholder_fmiGetContinuousStates;
-    fmu->fmi1.getNominalContinuousStates = placeholder_fmiGetNominalContinuousStates;
-    fmu->fmi1.getStateValueReferences = placeholder_fmiGetStateValueReferences;
-    fmu->fmi1.terminate = placeholder_fmiTerminate;
-
-    fmu->fmi2.getTypesPlatform = placeholder_fmi2_getTypesPlatform;
-    fmu->fmi2.getVersion = placeholder_fmi2_getVersion;
-    fmu->fmi2.setDebugLogging = placeholder_fmi2_setDebugLogging;
-    fmu->fmi2.instantiate = placeholder_fmi2Instantiate;
-    fmu->fmi2.freeInstance = placeholder_fmi2FreeInstance;
-    fmu->fmi2.setupExperiment = placeholder_fmi2_setupExperiment;
-    fmu->fmi2.enterInitializationMode = placeholder_fmi2EnterInitializationMode;
-    fmu->fmi2.exitInitializationMode = placeholder_fmi2ExitInitializationMode;
-    fmu->fmi2.terminate = placeholder_fmi2Terminate;
-    fmu->fmi2.reset = placeholder_fmi2Reset;
-    fmu->fmi2.getReal = placeholder_fmi2_getReal;
-    fmu->fmi2.getInteger = placeholder_fmi2_getInteger;
-    fmu->fmi2.getBoolean = placeholder_fmi2_getBoolean;
-    fmu->fmi2.getString = placeholder_fmi2_getString;
-    fmu->fmi2.setReal = placeholder_fmi2_setReal;
-    fmu->fmi2.setInteger = placeholder_fmi2_setInteger;
-    fmu->fmi2.setBoolean = placeholder_fmi2_setBoolean;
-    fmu->fmi2.setString = placeholder_fmi2_setString;
-    fmu->fmi2.getFMUstate = placeholder_fmi2_getFMUstate;
-    fmu->fmi2.setFMUstate = placeholder_fmi2_setFMUstate;
-    fmu->fmi2.freeFMUstate = placeholder_fmi2FreeFMUstate;
-    fmu->fmi2.serializedFMUstateSize = placeholder_fmi2SerializedFMUstateSize;
-    fmu->fmi2.serializeFMUstate = placeholder_fmi2SerializeFMUstate;
-    fmu->fmi2.deSerializeFMUstate = placeholder_fmi2DeSerializeFMUstate;
-    fmu->fmi2.getDirectionalDerivative = placeholder_fmi2_getDirectionalDerivative;
-    fmu->fmi2.enterEventMode = placeholder_fmi2EnterEventMode;
-    fmu->fmi2.newDiscreteStates = placeholder_fmi2NewDiscreteStates;
-    fmu->fmi2.enterContinuousTimeMode = placeholder_fmi2EnterContinuousTimeMode;
-    fmu->fmi2.completedIntegratorStep = placeholder_fmi2CompletedIntegratorStep;
-    fmu->fmi2.setTime = placeholder_fmi2_setTime;
-    fmu->fmi2.setContinuousStates = placeholder_fmi2_setContinuousStates;
-    fmu->fmi2.getDerivatives = placeholder_fmi2_getDerivatives;
-    fmu->fmi2.getEventIndicators = placeholder_fmi2_getEventIndicators;
-    fmu->fmi2.getContinuousStates = placeholder_fmi2_getContinuousStates;
-    fmu->fmi2.getNominalsOfContinuousStates = placeholder_fmi2_getNominalsOfContinuousStates;
-    fmu->fmi2.setRealInputDerivatives = placeholder_fmi2_setRealInputDerivatives;
-    fmu->fmi2.getRealOutputDerivatives = placeholder_fmi2_getRealOutputDerivatives;
-    fmu->fmi2.doStep = placeholder_fmi2DoStep;
-    fmu->fmi2.cancelStep = placeholder_fmi2CancelStep;
-    fmu->fmi2.getStatus = placeholder_fmi2_getStatus;
-    fmu->fmi2.getRealStatus = placeholder_fmi2_getRealStatus;
-    fmu->fmi2.getIntegerStatus = placeholder_fmi2_getIntegerStatus;
-    fmu->fmi2.getBooleanStatus = placeholder_fmi2_getBooleanStatus;
-    fmu->fmi2.getStringStatus = placeholder_fmi2_getStringStatus;
-
-    fmu->fmi3.getVersion = placeholder_fmi3GetVersion;
-    fmu->fmi3.setDebugLogging = placeholder_fmi3SetDebugLogging;
-    fmu->fmi3.instantiateModelExchange = placeholder_fmi3InstantiateModelExchange;
-    fmu->fmi3.instantiateCoSimulation = placeholder_fmi3InstantiateCoSimulation;
-    fmu->fmi3.instantiateScheduledExecution = placeholder_fmi3InstantiateScheduledExecution;
-    fmu->fmi3.freeInstance = placeholder_fmi3FreeInstance;
-    fmu->fmi3.enterInitializationMode = placeholder_fmi3EnterInitializationMode;
-    fmu->fmi3.exitInitializationMode = placeholder_fmi3ExitInitializationMode;
-    fmu->fmi3.terminate = placeholder_fmi3Terminate;
-    fmu->fmi3.setFloat64 = placeholder_fmi3SetFloat64;
-    fmu->fmi3.getFloat64 = placeholder_fmi3GetFloat64;
-    fmu->fmi3.doStep = placeholder_fmi3DoStep;
-    fmu->fmi3.enterEventMode = placeholder_fmi3EnterEventMode;
-    fmu->fmi3.reset = placeholder_fmi3Reset;
-    fmu->fmi3.getFloat32 = placeholder_fmi3GetFloat32;
-    fmu->fmi3.getInt8 = placeholder_fmi3GetInt8;
-    fmu->fmi3.getUInt8 = placeholder_fmi3GetUInt8;
-    fmu->fmi3.getInt16 = placeholder_fmi3GetInt16;
-    fmu->fmi3.getUInt16 = placeholder_fmi3GetUInt16;
-    fmu->fmi3.getInt32 = placeholder_fmi3GetInt32;
-    fmu->fmi3.getUInt32 = placeholder_fmi3GetUInt32;
-    fmu->fmi3.getInt64 = placeholder_fmi3GetInt64;
-    fmu->fmi3.getUInt64 = placeholder_fmi3GetUInt64;
-    fmu->fmi3.getBoolean = placeholder_fmi3GetBoolean;
-    fmu->fmi3.getString = placeholder_fmi3GetString;
-    fmu->fmi3.getBinary = placeholder_fmi3GetBinary;
-    fmu->fmi3.getClock = placeholder_fmi3GetClock;
-    fmu->fmi3.setFloat32 = placeholder_fmi3SetFloat32;
-    fmu->fmi3.setInt8 = placeholder_fmi3SetInt8;
-    fmu->fmi3.setUInt8 = placeholder_fmi3SetUInt8;
-    fmu->fmi3.setInt16 = placeholder_fmi3SetInt16;
-    fmu->fmi3.setUInt16 = placeholder_fmi3SetUInt16;
-    fmu->fmi3.setInt32 = placeholder_fmi3SetInt32;
-    fmu->fmi3.setUInt32 = placeholder_fmi3SetUInt32;
-    fmu->fmi3.setInt64 = placeholder_fmi3SetInt64;
-    fmu->fmi3.setUInt64 = placeholder_fmi3SetUInt64;
-    fmu->fmi3.setBoolean = placeholder_fmi3SetBoolean;
-    fmu->fmi3.setString = placeholder_fmi3SetString;
-    fmu->fmi3.setBinary = placeholder_fmi3SetBinary;
-    fmu->fmi3.setClock = placeholder_fmi3SetClock;
-    fmu->fmi3.getNumberOfVariableDependencies = placeholder_fmi3GetNumberOfVariableDependencies;
-    fmu->fmi3.getVariableDependencies = placeholder_fmi3GetVariableDependencies;
-    fmu->fmi3.getFMUState = placeholder_fmi3GetFMUState;
-    fmu->fmi3.setFMUState = placeholder_fmi3SetFMUState;
-    fmu->fmi3.freeFMUState = placeholder_fmi3FreeFMUState;
-    fmu->fmi3.serializedFMUStateSize = placeholder_fmi3SerializedFMUStateSize;
-    fmu->fmi3.serializeFMUState = placeholder_fmi3SerializeFMUState;
-    fmu->fmi3.deserializeFMUState = placeholder_fmi3DeserializeFMUState;
-    fmu->fmi3.getDirectionalDerivative = placeholder_fmi3GetDirectionalDerivative;
-    fmu->fmi3.getAdjointDerivative = placeholder_fmi3GetAdjointDerivative;
-    fmu->fmi3.enterConfigurationMode = placeholder_fmi3EnterConfigurationMode;
-    fmu->fmi3.exitConfigurationMode = placeholder_fmi3ExitConfigurationMode;
-    fmu->fmi3.getIntervalDecimal = placeholder_fmi3GetIntervalDecimal;
-    fmu->fmi3.getIntervalFraction = placeholder_fmi3GetIntervalFraction;
-    fmu->fmi3.getShiftDecimal = placeholder_fmi3GetShiftDecimal;
-    fmu->fmi3.getShiftFraction = placeholder_fmi3GetShiftFraction;
-    fmu->fmi3.setIntervalDecimal = placeholder_fmi3SetIntervalDecimal;
-    fmu->fmi3.setIntervalFraction = placeholder_fmi3SetIntervalFraction;
-    fmu->fmi3.setShiftDecimal = placeholder_fmi3SetShiftDecimal;
-    fmu->fmi3.setShiftFraction = placeholder_fmi3SetShiftFraction;
-    fmu->fmi3.evaluateDiscreteStates = placeholder_fmi3EvaluateDiscreteStates;
-    fmu->fmi3.updateDiscreteStates = placeholder_fmi3UpdateDiscreteStates;
-    fmu->fmi3.enterContinuousTimeMode = placeholder_fmi3EnterContinuousTimeMode;
-    fmu->fmi3.completedIntegratorStep = placeholder_fmi3CompletedIntegratorStep;
-    fmu->fmi3.setTime = placeholder_fmi3SetTime;
-    fmu->fmi3.setContinuousStates = placeholder_fmi3SetContinuousStates;
-    fmu->fmi3.getContinuousStateDerivatives = placeholder_fmi3GetContinuousStateDerivatives;
-    fmu->fmi3.getEventIndicators = placeholder_fmi3GetEventIndicators;
-    fmu->fmi3.getContinuousStates = placeholder_fmi3GetContinuousStates;
-    fmu->fmi3.getNominalsOfContinuousStates = placeholder_fmi3GetNominalsOfContinuousStates;
-    fmu->fmi3.getNumberOfEventIndicators = placeholder_fmi3GetNumberOfEventIndicators;
-    fmu->fmi3.getNumberOfContinuousStates = placeholder_fmi3GetNumberOfContinuousStates;
-    fmu->fmi3.enterStepMode = placeholder_fmi3EnterStepMode;
-    fmu->fmi3.getOutputDerivatives = placeholder_fmi3GetOutputDerivatives;
-    fmu->fmi3.activateModelPartition = placeholder_fmi3ActivateModelPartition;
+
+    setPlaceholderFunctions(fmu);
+
+    //Parse the version specific contents from the same XML tree
+    bool ok = true;
 
     if(fmu->version == fmiVersion1) {
-        fmu->fmi1.variables = malloc(100*sizeof(fmi1VariableHandle));
+        fmu->fmi1.variables = arenaAlloc(&fmu->arena, 100*sizeof(fmi1VariableHandle));
         fmu->fmi1.variablesSize = 100;
         fmu->fmi1.numberOfVariables = 0;
-        if(!parseModelDescriptionFmi1(fmu)) {
-            printf("Failed to parse modelDescription.xml\n");
-            free(fmu);
-            return NULL;
-        }
-        if(!loadFunctionsFmi1(fmu)) {
-            free(fmu);
-            return NULL;    //Error message should already have been printed
+        ok = parseModelDescriptionFmi1(fmu, rootElement);
+        if(ok) {
+            buildVariableIndex(&fmu->fmi1.variableIndex, fmu->fmi1.variables, fmu->fmi1.numberOfVariables,
+                               sizeof(fmi1VariableHandle), offsetof(fmi1VariableHandle, name), offsetof(fmi1VariableHandle, valueReference));
         }
     }
     else if(fmu->version == fmiVersion2) {
-        fmu->fmi2.variables = malloc(100*sizeof(fmi2VariableHandle));
+        fmu->fmi2.variables = arenaAlloc(&fmu->arena, 100*sizeof(fmi2VariableHandle));
         fmu->fmi2.variablesSize = 100;
         fmu->fmi2.numberOfVariables = 0;
-        if(!parseModelDescriptionFmi2(fmu)) {
-            printf("Failed to parse modelDescription.xml\n");
-            free(fmu);
-            return NULL;
+        ok = parseModelDescriptionFmi2(fmu, rootElement);
+        if(ok) {
+            buildVariableIndex(&fmu->fmi2.variableIndex, fmu->fmi2.variables, fmu->fmi2.numberOfVariables,
+                               sizeof(fmi2VariableHandle), offsetof(fmi2VariableHandle, name), offsetof(fmi2VariableHandle, valueReference));
+            buildVariableArraysFmi2(fmu);
         }
     }
     else if(fmu->version == fmiVersion3) {
-        fmu->fmi3.variables = malloc(100*sizeof(fmi3VariableHandle));
+        fmu->fmi3.variables = arenaAlloc(&fmu->arena, 100*sizeof(fmi3VariableHandle));
         fmu->fmi3.variablesSize = 100;
         fmu->fmi3.numberOfVariables = 0;
-        if(!parseModelDescriptionFmi3(fmu)) {
-            printf("Failed to parse modelDescription.xml\n");
-            free(fmu);
-            return NULL;
+        ok = parseModelDescriptionFmi3(fmu, rootElement);
+#ifndef FMI4C_WITH_PUGIXML
+        if(ok && xml != NULL) {
+            ok = parseModelVariablesStreamingFmi3(fmu, variablesStart, variablesEnd);
+        }
+#endif
+        if(ok) {
+            buildVariableIndex(&fmu->fmi3.variableIndex, fmu->fmi3.variables, fmu->fmi3.numberOfVariables,
+                               sizeof(fmi3VariableHandle), offsetof(fmi3VariableHandle, name), offsetof(fmi3VariableHandle, valueReference));
+            buildVariableArraysFmi3(fmu);
         }
     }
 
-    return fmu;
+    freeXmlDocument(document);
+    fmi4cFree(xml);
+    fmu->parseTime = getWallTime()-startTime;
+    if(!ok) {
+        printf("Failed to parse modelDescription.xml\n");
+        return false;
+    }
+
+    return true;
 }
 
 
-void freeIfNotNull(const char* ptr) {
-    if(ptr != NULL) {
-        free((char*)ptr);
+#define DESCRIPTION_CACHE_MAGIC "FMI4CDC"
+#define DESCRIPTION_CACHE_FORMAT 2
+
+// Header of a binary description cache file, followed by the image of the version specific data
+typedef struct {
+    char magic[8];
+    uint32_t format;
+    uint32_t standardVersion;
+    char build[32];                 // Build date and time of fmi4c, structure layouts may differ between builds
+    uint64_t archiveChecksum;
+    uint64_t archiveSize;
+    uint64_t imageSize;
+    uint32_t pointerSize;
+    uint32_t parseOptions;
+} fmiDescriptionCacheHeader;
+
+//! @brief Options that change the contents of parsed model descriptions
+#define DESCRIPTION_CACHE_OPTIONS (FMI4C_PARSE_SKIP_DESCRIPTIONS | FMI4C_PARSE_SKIP_UNITS)
+
+
+//! @brief Relocates all pointers in an FMI 2 model description (except the variable index, which is rebuilt)
+//! @param data Model description data
+//! @param image Image being written or read
+static void relocateModelDescriptionFmi2(fmi2Data_t *data, fmiImage *image)
+{
+    relocateString(image, &data->fmiVersion_);
+    relocateString(image, &data->modelName);
+    relocateString(image, &data->guid);
+    relocateString(image, &data->description);
+    relocateString(image, &data->author);
+    relocateString(image, &data->version);
+    relocateString(image, &data->copyright);
+    relocateString(image, &data->license);
+    relocateString(image, &data->generationTool);
+    relocateString(image, &data->generationDateAndTime);
+    relocateString(image, &data->variableNamingConvention);
+    relocateString(image, &data->cs.modelIdentifier);
+    relocateString(image, &data->me.modelIdentifier);
+
+    size_t n = (size_t)data->numberOfVariables;
+    fmi2VariableHandle *variables = relocatePointer(image, &data->variables, n, sizeof(fmi2VariableHandle));
+    for(size_t i=0; image->ok && i<n; ++i) {
+        relocateString(image, &variables[i].name);
+        relocateString(image, &variables[i].description);
+        relocateString(image, &variables[i].quantity);
+        relocateString(image, &variables[i].unit);
+        relocateString(image, &variables[i].displayUnit);
+        relocateString(image, &variables[i].startString);
     }
-}
-
-void freeVoidIfNotNull(void* ptr) {
-    if(ptr != NULL) {
-        free(ptr);
+    relocatePointer(image, &data->variableArrays.valueReferences, n, sizeof(fmi2ValueReference));
+    relocatePointer(image, &data->variableArrays.causalities, n, sizeof(fmi2Causality));
+    relocatePointer(image, &data->variableArrays.variabilities, n, sizeof(fmi2Variability));
+    relocatePointer(image, &data->variableArrays.dataTypes, n, sizeof(fmi2DataType));
+}
+
+
+//! @brief Relocates the name, description and quantity of one type definition array
+#define RELOCATE_TYPES(image, types, count, type) { \
+    type *t = relocatePointer(image, &types, count, sizeof(type)); \
+    for(size_t i=0; (image)->ok && i<(count); ++i) { \
+        relocateString(image, &t[i].name); \
+        relocateString(image, &t[i].description); \
+        relocateString(image, &t[i].quantity); \
+    } \
+}
+
+
+//! @brief Relocates all pointers in an FMI 3 model description (except the variable index, which is rebuilt)
+//! @param data Model description data
+//! @param image Image being written or read
+static void relocateModelDescriptionFmi3(fmi3Data_t *data, fmiImage *image)
+{
+    relocateString(image, &data->modelName);
+    relocateString(image, &data->instantiationToken);
+    relocateString(image, &data->description);
+    relocateString(image, &data->author);
+    relocateString(image, &data->version);
+    relocateString(image, &data->copyright);
+    relocateString(image, &data->license);
+    relocateString(image, &data->generationTool);
+    relocateString(image, &data->generationDateAndTime);
+    relocateString(image, &data->variableNamingConvention);
+    relocateString(image, &data->cs.modelIdentifier);
+    relocateString(image, &data->me.modelIdentifier);
+    relocateString(image, &data->se.modelIdentifier);
+
+    size_t n = (size_t)data->numberOfVariables;
+    fmi3VariableHandle *variables = relocatePointer(image, &data->variables, n, sizeof(fmi3VariableHandle));
+    for(size_t i=0; image->ok && i<n; ++i) {
+        relocateString(image, &variables[i].name);
+        relocateString(image, &variables[i].description);
+        relocateString(image, &variables[i].quantity);
+        relocateString(image, &variables[i].unit);
+        relocateString(image, &variables[i].displayUnit);
+        relocateString(image, &variables[i].startString);
+        relocateString(image, &variables[i].declaredType);
+        relocateString(image, &variables[i].mimeType);
+        relocatePointer(image, &variables[i].startBinary, 0, 1);
+        relocatePointer(image, &variables[i].clocks, (size_t)variables[i].numberOfClocks, sizeof(int));
+        relocatePointer(image, &variables[i].dimensions, (size_t)variables[i].numberOfDimensions, sizeof(fmi3Dimension));
+    }
+    relocatePointer(image, &data->variableArrays.valueReferences, n, sizeof(fmi3ValueReference));
+    relocatePointer(image, &data->variableArrays.causalities, n, sizeof(fmi3Causality));
+    relocatePointer(image, &data->variableArrays.variabilities, n, sizeof(fmi3Variability));
+    relocatePointer(image, &data->variableArrays.dataTypes, n, sizeof(fmi3DataType));
+
+    fmi3UnitHandle *units = relocatePointer(image, &data->units, data->numberOfUnits, sizeof(fmi3UnitHandle));
+    for(size_t i=0; image->ok && i<data->numberOfUnits; ++i) {
+        relocateString(image, &units[i].name);
+        relocatePointer(image, &units[i].baseUnit, 1, sizeof(fmi3BaseUnit));
+        fmi3DisplayUnitHandle *displayUnits = relocatePointer(image, &units[i].displayUnits, units[i].numberOfDisplayUnits, sizeof(fmi3DisplayUnitHandle));
+        for(size_t j=0; image->ok && j<units[i].numberOfDisplayUnits; ++j) {
+            relocateString(image, &displayUnits[j].name);
+        }
     }
-}
 
-//! @brief Free FMU dll
-//! @param fmu FMU handle
-void fmi4c_freeFmu(fmiHandle *fmu)
-{
-    TRACEFUNC
-#ifdef _WIN32
-    FreeLibrary(fmu->dll);
-#else
-    dlclose(fmu->dll);
-#endif
-    if(fmu->version == fmiVersion1) {
-        for(int i=0; i<fmu->fmi1.numberOfVariables; ++i) {
-            freeIfNotNull(fmu->fmi1.variables[i].name);
-            freeIfNotNull(fmu->fmi1.variables[i].description);
-        }
-        free(fmu->fmi1.variables);
-        freeIfNotNull(fmu->fmi1.modelName);
-        freeIfNotNull(fmu->fmi1.modelIdentifier);
-        freeIfNotNull(fmu->fmi1.guid);
-        freeIfNotNull(fmu->fmi1.description);
-        freeIfNotNull(fmu->fmi1.author);
-        freeIfNotNull(fmu->fmi1.version);
-        freeIfNotNull(fmu->fmi1.generationTool);
-        freeIfNotNull(fmu->fmi1.generationDateAndTime);
-        freeIfNotNull(fmu->fmi1.variableNamingConvention);
+    RELOCATE_TYPES(image, data->int64Types, data->numberOfInt64Types, fmi3Int64Type);
+    RELOCATE_TYPES(image, data->int32Types, data->numberOfInt32Types, fmi3Int32Type);
+    RELOCATE_TYPES(image, data->int16Types, data->numberOfInt16Types, fmi3Int16Type);
+    RELOCATE_TYPES(image, data->int8Types, data->numberOfInt8Types, fmi3Int8Type);
+    RELOCATE_TYPES(image, data->uint64Types, data->numberOfUInt64Types, fmi3UInt64Type);
+    RELOCATE_TYPES(image, data->uint32Types, data->numberOfUInt32Types, fmi3UInt32Type);
+    RELOCATE_TYPES(image, data->uint16Types, data->numberOfUInt16Types, fmi3UInt16Type);
+    RELOCATE_TYPES(image, data->uint8Types, data->numberOfUInt8Types, fmi3UInt8Type);
+
+    fmi3Float64Type *float64Types = relocatePointer(image, &data->float64Types, data->numberOfFloat64Types, sizeof(fmi3Float64Type));
+    for(size_t i=0; image->ok && i<data->numberOfFloat64Types; ++i) {
+        relocateString(image, &float64Types[i].name);
+        relocateString(image, &float64Types[i].description);
+        relocateString(image, &float64Types[i].quantity);
+        relocateString(image, &float64Types[i].unit);
+        relocateString(image, &float64Types[i].displayUnit);
     }
-    else if(fmu->version == fmiVersion2) {
-        for(int i=0; i<fmu->fmi2.numberOfVariables; ++i) {
-            freeIfNotNull(fmu->fmi2.variables[i].name);
-            freeIfNotNull(fmu->fmi2.variables[i].description);
-        }
-        free(fmu->fmi2.variables);
-        freeIfNotNull(fmu->fmi2.modelName);
-        freeIfNotNull(fmu->fmi2.guid);
-        freeIfNotNull(fmu->fmi2.description);
-        freeIfNotNull(fmu->fmi2.author);
-        freeIfNotNull(fmu->fmi2.version);
-        freeIfNotNull(fmu->fmi2.copyright);
-        freeIfNotNull(fmu->fmi2.license);
-        freeIfNotNull(fmu->fmi2.generationTool);
-        freeIfNotNull(fmu->fmi2.generationDateAndTime);
-        freeIfNotNull(fmu->fmi2.variableNamingConvention);
-        if(fmu->fmi2.supportsCoSimulation) {
-            freeIfNotNull(fmu->fmi2.cs.modelIdentifier);
-        }
-        if(fmu->fmi2.supportsModelExchange) {
-            freeIfNotNull(fmu->fmi2.me.modelIdentifier);
-        }
+    fmi3Float32Type *float32Types = relocatePointer(image, &data->float32Types, data->numberOfFloat32Types, sizeof(fmi3Float32Type));
+    for(size_t i=0; image->ok && i<data->numberOfFloat32Types; ++i) {
+        relocateString(image, &float32Types[i].name);
+        relocateString(image, &float32Types[i].description);
+        relocateString(image, &float32Types[i].quantity);
+        relocateString(image, &float32Types[i].unit);
+        relocateString(image, &float32Types[i].displayUnit);
     }
-    else if(fmu->version == fmiVersion3) {
-        freeVoidIfNotNull(fmu->fmi3.outputs);
-        freeVoidIfNotNull(fmu->fmi3.continuousStateDerivatives);
-        freeVoidIfNotNull(fmu->fmi3.clockedStates);
-        freeVoidIfNotNull(fmu->fmi3.initialUnknowns);
-        freeVoidIfNotNull(fmu->fmi3.eventIndicators);
-
-        for(int i=0; i<fmu->fmi3.numberOfVariables; ++i) {
-            freeIfNotNull(fmu->fmi3.variables[i].name);
-            freeIfNotNull(fmu->fmi3.variables[i].description);
-            freeIfNotNull(fmu->fmi3.variables[i].quantity);
-            freeIfNotNull(fmu->fmi3.variables[i].unit);
-            freeIfNotNull(fmu->fmi3.variables[i].displayUnit);
-        }
-        free(fmu->fmi3.variables);
-        freeIfNotNull(fmu->fmi3.modelName);
-        freeIfNotNull(fmu->fmi3.instantiationToken);
-        freeIfNotNull(fmu->fmi3.description);
-        freeIfNotNull(fmu->fmi3.author);
-        freeIfNotNull(fmu->fmi3.version);
-        freeIfNotNull(fmu->fmi3.copyright);
-        freeIfNotNull(fmu->fmi3.license);
-        freeIfNotNull(fmu->fmi3.generationTool);
-        freeIfNotNull(fmu->fmi3.generationDateAndTime);
-        //freeIfNotNull(fmu->fmi3.variableNamingConvention);
-        if(fmu->fmi3.supportsCoSimulation) {
-            freeIfNotNull(fmu->fmi3.cs.modelIdentifier);
-        }
-        if(fmu->fmi3.supportsModelExchange) {
-            freeIfNotNull(fmu->fmi3.me.modelIdentifier);
-        }
-        if(fmu->fmi3.supportsScheduledExecution) {
-            freeIfNotNull(fmu->fmi3.se.modelIdentifier);
+    fmi3BooleanType *booleanTypes = relocatePointer(image, &data->booleanTypes, data->numberOfBooleanTypes, sizeof(fmi3BooleanType));
+    for(size_t i=0; image->ok && i<data->numberOfBooleanTypes; ++i) {
+        relocateString(image, &booleanTypes[i].name);
+        relocateString(image, &booleanTypes[i].description);
+    }
+    fmi3StringType *stringTypes = relocatePointer(image, &data->stringTypes, data->numberOfStringTypes, sizeof(fmi3StringType));
+    for(size_t i=0; image->ok && i<data->numberOfStringTypes; ++i) {
+        relocateString(image, &stringTypes[i].name);
+        relocateString(image, &stringTypes[i].description);
+    }
+    fmi3BinaryType *binaryTypes = relocatePointer(image, &data->binaryTypes, data->numberOfBinaryTypes, sizeof(fmi3BinaryType));
+    for(size_t i=0; image->ok && i<data->numberOfBinaryTypes; ++i) {
+        relocateString(image, &binaryTypes[i].name);
+        relocateString(image, &binaryTypes[i].description);
+        relocateString(image, &binaryTypes[i].mimeType);
+    }
+    fmi3EnumerationType *enumTypes = relocatePointer(image, &data->enumTypes, data->numberOfEnumerationTypes, sizeof(fmi3EnumerationType));
+    for(size_t i=0; image->ok && i<data->numberOfEnumerationTypes; ++i) {
+        relocateString(image, &enumTypes[i].name);
+        relocateString(image, &enumTypes[i].description);
+        relocateString(image, &enumTypes[i].quantity);
+        fmi3EnumerationItem *items = relocatePointer(image, &enumTypes[i].items, (size_t)enumTypes[i].numberOfItems, sizeof(fmi3EnumerationItem));
+        for(size_t j=0; image->ok && j<(size_t)enumTypes[i].numberOfItems; ++j) {
+            relocateString(image, &items[j].name);
+            relocateString(image, &items[j].description);
         }
     }
-    freeIfNotNull(fmu->resourcesLocation);
-    freeIfNotNull(fmu->instanceName);
-    freeIfNotNull(fmu->unzippedLocation);
-    free(fmu);
-}
+    fmi3ClockType *clockTypes = relocatePointer(image, &data->clockTypes, data->numberOfClockTypes, sizeof(fmi3ClockType));
+    for(size_t i=0; image->ok && i<data->numberOfClockTypes; ++i) {
+        relocateString(image, &clockTypes[i].name);
+        relocateString(image, &clockTypes[i].description);
+    }
 
-fmi1Type fmi1_getType(fmiHandle *fmu)
-{
-    TRACEFUNC
+    fmi3LogCategory *logCategories = relocatePointer(image, &data->logCategories, (size_t)data->numberOfLogCategories, sizeof(fmi3LogCategory));
+    for(size_t i=0; image->ok && i<(size_t)data->numberOfLogCategories; ++i) {
+        relocateString(image, &logCategories[i].name);
+        relocateString(image, &logCategories[i].description);
+    }
 
-    return fmu->fmi1.type;
+    fmi3ModelStructureElement **elements[] = { &data->outputs, &data->continuousStateDerivatives, &data->clockedStates,
+                                               &data->initialUnknowns, &data->eventIndicators };
+    int counts[] = { data->numberOfOutputs, data->numberOfContinuousStateDerivatives, data->numberOfClockedStates,
+                     data->numberOfInitialUnknowns, data->numberOfEventIndicators };
+    for(int k=0; k<5; ++k) {
+        fmi3ModelStructureElement *element = relocatePointer(image, elements[k], (size_t)counts[k], sizeof(fmi3ModelStructureElement));
+        for(size_t i=0; image->ok && i<(size_t)counts[k]; ++i) {
+            size_t m = (size_t)element[i].numberOfDependencies;
+            relocatePointer(image, &element[i].dependencies, m, sizeof(fmi3ValueReference));
+            relocatePointer(image, &element[i].dependencyKinds, element[i].dependencyKindsDefined ? m : 0, sizeof(fmi3DependencyKind));
+        }
+    }
 }
 
-int fmi1_getNumberOfContinuousStates(fmiHandle *fmu)
-{
-    return fmu->fmi1.numberOfContinuousStates;
-}
 
-int fmi1_getNumberOfEventIndicators(fmiHandle *fmu)
+//! @brief Writes the parsed model description to a binary description cache file
+//! The file is first written to a temporary name and then renamed, so that readers never see partial files.
+//! @param fmu FMU handle with parsed model description (FMI 2 or 3)
+//! @param path Path to cache file
+//! @param checksum CRC32 checksum of FMU archive
+//! @param size Size of FMU archive
+//! @returns True if the cache file was written
+static bool writeDescriptionCache(fmiHandle *fmu, const char *path, unsigned long checksum, size_t size)
 {
-    return fmu->fmi1.numberOfEventIndicators;
-}
+    fmiImage image;
+    bool ok;
+    if(fmu->version == fmiVersion2) {
+        ok = beginImage(&image, &fmu->fmi2, sizeof(fmi2Data_t), &fmu->arena);
+        if(ok) {
+            relocateModelDescriptionFmi2(&fmu->fmi2, &image);
+        }
+    }
+    else if(fmu->version == fmiVersion3) {
+        ok = beginImage(&image, &fmu->fmi3, sizeof(fmi3Data_t), &fmu->arena);
+        if(ok) {
+            relocateModelDescriptionFmi3(&fmu->fmi3, &image);
+        }
+    }
+    else {
+        return false;   //Only FMI 2 and 3 are cached
+    }
+    if(!ok || !image.ok) {
+        if(ok) {
+            freeImage(&image);
+        }
+        printf("Failed to create model description cache for: %s\n", path);
+        return false;
+    }
 
-bool fmi1_defaultStartTimeDefined(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.defaultStartTimeDefined;
+    fmiDescriptionCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DESCRIPTION_CACHE_MAGIC, sizeof(DESCRIPTION_CACHE_MAGIC));
+    header.format = DESCRIPTION_CACHE_FORMAT;
+    header.standardVersion = (uint32_t)fmu->version;
+    snprintf(header.build, sizeof(header.build), "%s %s", __DATE__, __TIME__);
+    header.archiveChecksum = checksum;
+    header.archiveSize = size;
+    header.imageSize = image.size;
+    header.pointerSize = sizeof(void*);
+    header.parseOptions = (uint32_t)(parseOptions & DESCRIPTION_CACHE_OPTIONS);
+
+    char temporaryPath[FILENAME_MAX];
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+    FILE *file = fopen(temporaryPath, "wb");
+    ok = (file != NULL);
+    if(ok) {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(image.data, 1, image.size, file) == image.size;
+        ok = (fclose(file) == 0) && ok;
+    }
+    freeImage(&image);
+    if(ok) {
+        remove(path);   //Rename does not replace existing files on all platforms
+        ok = (rename(temporaryPath, path) == 0);
+    }
+    if(!ok) {
+        remove(temporaryPath);
+        printf("Failed to write model description cache: %s\n", path);
+    }
+    return ok;
 }
 
-bool fmi1_defaultStopTimeDefined(fmiHandle *fmu)
+
+//! @brief Loads a model description from a binary description cache file, if it is valid for the FMU archive
+//! The file is mapped into memory and its pointers are fixed in place, so nothing is parsed or copied.
+//! @param fmu FMU handle without a model description
+//! @param path Path to cache file
+//! @param checksum CRC32 checksum of FMU archive
+//! @param size Size of FMU archive
+//! @returns True if the model description was loaded, false if the file is missing or not valid
+static bool loadDescriptionCache(fmiHandle *fmu, const char *path, unsigned long checksum, size_t size)
 {
-    TRACEFUNC
-    return fmu->fmi1.defaultStopTimeDefined;
-}
+    double startTime = getWallTime();
+    size_t fileSize;
+    char *data = mapFile(path, &fileSize);
+    if(data == NULL) {
+        return false;
+    }
 
-bool fmi1_defaultToleranceDefined(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.defaultToleranceDefined;
-}
+    fmiDescriptionCacheHeader header;
+    char build[sizeof(header.build)];
+    memset(build, 0, sizeof(build));
+    snprintf(build, sizeof(build), "%s %s", __DATE__, __TIME__);
+    bool ok = fileSize > sizeof(header);
+    if(ok) {
+        memcpy(&header, data, sizeof(header));
+        ok = !memcmp(header.magic, DESCRIPTION_CACHE_MAGIC, sizeof(DESCRIPTION_CACHE_MAGIC)) &&
+             header.format == DESCRIPTION_CACHE_FORMAT &&
+             !memcmp(header.build, build, sizeof(build)) &&
+             header.archiveChecksum == checksum &&
+             header.archiveSize == size &&
+             header.imageSize == fileSize-sizeof(header) &&
+             header.pointerSize == sizeof(void*) &&
+             header.parseOptions == (uint32_t)(parseOptions & DESCRIPTION_CACHE_OPTIONS);
+    }
+    if(!ok) {
+        unmapFile(data, fileSize);  //Written by another build or for other parse options, will be replaced
+        return false;
+    }
 
-double fmi1_getDefaultStartTime(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.defaultStartTime;
-}
+    fmiImage image;
+    openImage(&image, data+sizeof(header), fileSize-sizeof(header));
+    size_t rootSize = (header.standardVersion == fmiVersion2) ? sizeof(fmi2Data_t) : sizeof(fmi3Data_t);
+    ok = image.ok && (header.standardVersion == fmiVersion2 || header.standardVersion == fmiVersion3) && image.size >= rootSize;
+    if(ok && header.standardVersion == fmiVersion2) {
+        memcpy(&fmu->fmi2, image.data, rootSize);
+        relocateModelDescriptionFmi2(&fmu->fmi2, &image);
+        ok = image.ok;
+        if(!ok) {
+            memset(&fmu->fmi2, 0, sizeof(fmi2Data_t));
+        }
+    }
+    else if(ok) {
+        memcpy(&fmu->fmi3, image.data, rootSize);
+        relocateModelDescriptionFmi3(&fmu->fmi3, &image);
+        ok = image.ok;
+        if(!ok) {
+            memset(&fmu->fmi3, 0, sizeof(fmi3Data_t));
+        }
+    }
+    if(!ok) {
+        printf("Ignoring invalid model description cache: %s\n", path);
+        unmapFile(data, fileSize);
+        return false;
+    }
 
-double fmi1_getDefaultStopTime(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.defaultStopTime;
+    //Runtime state in the image is from before instantiation, and function pointers are only valid in the writing process
+    fmu->version = (fmiVersion_t)header.standardVersion;
+    setPlaceholderFunctions(fmu);
+    if(fmu->version == fmiVersion2) {
+        memset(&fmu->fmi2.variableIndex, 0, sizeof(fmiVariableIndex));
+        memset(&fmu->fmi2.callbacks, 0, sizeof(fmi2CallbackFunctions));
+        fmu->fmi2.component = NULL;
+        buildVariableIndex(&fmu->fmi2.variableIndex, fmu->fmi2.variables, fmu->fmi2.numberOfVariables,
+                           sizeof(fmi2VariableHandle), offsetof(fmi2VariableHandle, name), offsetof(fmi2VariableHandle, valueReference));
+    }
+    else {
+        memset(&fmu->fmi3.variableIndex, 0, sizeof(fmiVariableIndex));
+        fmu->fmi3.fmi3Instance = NULL;
+        buildVariableIndex(&fmu->fmi3.variableIndex, fmu->fmi3.variables, fmu->fmi3.numberOfVariables,
+                           sizeof(fmi3VariableHandle), offsetof(fmi3VariableHandle, name), offsetof(fmi3VariableHandle, valueReference));
+    }
+    fmu->mappedDescription = data;
+    fmu->mappedDescriptionSize = fileSize;
+    fmu->parseTime = getWallTime()-startTime;
+    return true;
 }
 
-double fmi1_getDefaultTolerance(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.defaultTolerance;
-}
 
-int fmi1_getNumberOfVariables(fmiHandle *fmu)
+//! @brief Converts a path relative to the current working directory to an absolute path
+//! @param path Relative or absolute path
+//! @param absolutePath Returns the absolute path
+//! @param size Size of absolutePath buffer
+static void getAbsolutePath(const char *path, char *absolutePath, size_t size)
 {
-    TRACEFUNC
-    return fmu->fmi1.numberOfVariables;
+    if(path[0] == '/' || path[0] == '\\' || (path[0] != '\0' && path[1] == ':')) {
+        snprintf(absolutePath, size, "%s", path);
+        return;
+    }
+
+    char cwd[FILENAME_MAX];
+#ifdef _WIN32
+    _getcwd(cwd, sizeof(char)*FILENAME_MAX);
+#else
+    getcwd(cwd, sizeof(char)*FILENAME_MAX);
+#endif
+    snprintf(absolutePath, size, "%s/%s", cwd, path);
 }
 
-fmi1VariableHandle *fmi1_getVariableByIndex(fmiHandle *fmu, int i)
+
+//! @brief Initializes the locations of an FMU handle.
+//! Only absolute paths are stored, so that later operations do not depend on the working directory.
+//! @param fmu FMU handle
+//! @param fmufile Path to FMU archive
+//! @param instanceName Instance name
+//! @param directory Extraction directory
+static void setLocations(fmiHandle *fmu, const char *fmufile, const char *instanceName, const char *directory)
 {
-    TRACEFUNC
+    char path[FILENAME_MAX];
+    getAbsolutePath(fmufile, path, sizeof(path));
+    fmu->fmuFile = fmi4cStrdup(path);
 
-    if(i >= fmu->fmi1.numberOfVariables) {
-        printf("Variable index out of bounds: %i\n",i);
-        return NULL;
-    }
-    return &fmu->fmi1.variables[i];
+    //! @todo Change to temp folder
+    getAbsolutePath(directory, path, sizeof(path));
+    fmu->unzippedLocation = fmi4cStrdup(path);
+
+    snprintf(path, sizeof(path), "file:///%s/resources", fmu->unzippedLocation);
+    fmu->resourcesLocation = fmi4cStrdup(path);
+
+    fmu->instanceName = fmi4cStrdup(instanceName);
 }
 
-fmi1VariableHandle *fmi1_getVariableByValueReference(fmiHandle *fmu, fmi1ValueReference vr)
-{
-    TRACEFUNC
 
-    for(int i=0; i<fmu->fmi1.numberOfVariables; ++i) {
-        if(fmu->fmi1.variables[i].valueReference == vr) {
-            return &fmu->fmi1.variables[i];
-        }
+void freeIfNotNull(const char* ptr) {
+    if(ptr != NULL) {
+        fmi4cFree((char*)ptr);
     }
-    printf("Variable with value reference %i not found.\n", vr);
-    return NULL;
 }
 
-fmi1VariableHandle *fmi1_getVariableByName(fmiHandle *fmu, fmi1String name)
-{
-    for(int i=0; i<fmu->fmi1.numberOfVariables; ++i) {
-        if(!strcmp(fmu->fmi1.variables[i].name, name)) {
-            return &fmu->fmi1.variables[i];
-        }
+void freeVoidIfNotNull(void* ptr) {
+    if(ptr != NULL) {
+        fmi4cFree(ptr);
     }
-    printf("Variable with name %s not found.\n", name);
-    return NULL;
 }
 
-const char *fmi1_getVariableName(fmi1VariableHandle *var)
-{
-    TRACEFUNC
-    return var->name;
-}
 
-const char *fmi1_getVariableDescription(fmi1VariableHandle *var)
+//! @brief Frees everything parsed from modelDescription.xml
+//! @param fmu FMU handle
+static void freeModelDescription(fmiHandle *fmu)
 {
-    TRACEFUNC
-    return var->description;
+    if(fmu->version == fmiVersion1) {
+        freeVariableIndex(&fmu->fmi1.variableIndex);
+    }
+    else if(fmu->version == fmiVersion2) {
+        freeVariableIndex(&fmu->fmi2.variableIndex);
+    }
+    else if(fmu->version == fmiVersion3) {
+        freeVariableIndex(&fmu->fmi3.variableIndex);
+    }
+    freeArena(&fmu->arena);     //Everything else was allocated from the arena, or is in the mapped cache file
+    if(fmu->mappedDescription != NULL) {
+        unmapFile(fmu->mappedDescription, fmu->mappedDescriptionSize);
+        fmu->mappedDescription = NULL;
+    }
 }
 
-fmi1Real fmi1_getVariableStartReal(fmi1VariableHandle *var)
-{
-    TRACEFUNC
-    return var->startReal;
-}
 
-fmi1Integer fmi1_getVariableStartInteger(fmi1VariableHandle *var)
-{
-    TRACEFUNC
-    return var->startInteger;
-}
+static char *cacheDirectory = NULL;
+static fmiSharedModel *cacheEntries = NULL;
+static fmiMutex cacheMutex = FMI4C_MUTEX_INITIALIZER;
 
-fmi1Boolean fmi1_getVariableStartBoolean(fmi1VariableHandle *var)
-{
-    TRACEFUNC
-    return var->startBoolean;
-}
 
-fmi1String fmi1_getVariableStartString(fmi1VariableHandle *var)
+//! @brief Enables or disables the shared extraction cache.
+//! When enabled, each distinct FMU archive (identified by its CRC32 checksum and size) is extracted
+//! and parsed only once, and all instances of it share the extracted files and the model description.
+//! The extracted files are removed when the last handle using them is freed.
+//! Handles that are already loaded are not affected.
+//! @param path Cache directory (created if it does not exist), or NULL to disable the cache
+void fmi4c_setCacheDirectory(const char *path)
 {
-    TRACEFUNC
-    return var->startString;
-}
+    char absolutePath[FILENAME_MAX];
+    if(path != NULL) {
+        getAbsolutePath(path, absolutePath, sizeof(absolutePath));
+    }
 
-long fmi1_getVariableValueReference(fmi1VariableHandle *var)
-{
-    TRACEFUNC
-    return var->valueReference;
+    fmiMutexLock(&cacheMutex);
+    fmi4cFree(cacheDirectory);
+    cacheDirectory = (path != NULL) ? fmi4cStrdup(absolutePath) : NULL;
+    fmiMutexUnlock(&cacheMutex);
 }
 
-fmi1Causality fmi1_getVariableCausality(fmi1VariableHandle *var)
-{
-    TRACEFUNC
-    return var->causality;
-}
 
-fmi1Variability fmi1_getVariableVariability(fmi1VariableHandle *var)
+//! @brief Returns a copy of the current cache directory
+//! @returns Cache directory (must be freed by caller), or NULL if the cache is disabled
+static char *getCacheDirectory()
 {
-    TRACEFUNC
-    return var->variability;
+    fmiMutexLock(&cacheMutex);
+    char *directory = (cacheDirectory != NULL) ? fmi4cStrdup(cacheDirectory) : NULL;
+    fmiMutexUnlock(&cacheMutex);
+    return directory;
 }
 
-fmi1Alias fmi1_getAlias(fmi1VariableHandle *var)
-{
-    TRACEFUNC
-    return var->alias;
-}
 
-bool fmi1_getVariableIsFixed(fmi1VariableHandle *var)
+//! @brief Releases one reference to a shared model.
+//! When the last reference is released, the model description is freed, and for cache entries the extracted files are removed.
+//! @param shared Shared model
+static void releaseSharedModel(fmiSharedModel *shared)
 {
-    TRACEFUNC
-    return var->fixed;
-}
+    fmiMutexLock(&cacheMutex);
+    if(--shared->referenceCount > 0) {
+        fmiMutexUnlock(&cacheMutex);
+        return;
+    }
 
-const char *fmi1_getTypesPlatform(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.getTypesPlatform();
-}
+    if(shared->location != NULL) {
+        fmiSharedModel **link = &cacheEntries;
+        while(*link != shared) {
+            link = &(*link)->next;
+        }
+        *link = shared->next;
+    }
 
-const char *fmi1_getVersion(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.getVersion();
-}
+    //Remove files while still holding the lock, so that the directory cannot be reused by a concurrent load
+    if(shared->model != NULL) {
+        fmi4c_freeFmu(shared->model);
+    }
+    if(shared->location != NULL) {
+        removeDirectory(shared->location);
+    }
+    fmiMutexUnlock(&cacheMutex);
+
+    fmiMutexDestroy(&shared->mutex);
+    freeIfNotNull(shared->location);
+    fmi4cFree(shared);
+}
+
+
+//! @brief Creates a new handle for a shared model, with its own instance name and instance state
+//! The caller must already hold a reference to the shared model on behalf of the new handle.
+//! @param shared Shared model
+//! @param instanceName Instance name
+//! @returns Handle to FMU, or NULL on failure
+static fmiHandle *newSharedHandle(fmiSharedModel *shared, const char *instanceName)
+{
+    fmiHandle *fmu = fmi4cMalloc(sizeof(fmiHandle));
+    memcpy(fmu, shared->model, sizeof(fmiHandle));
+    fmu->unzippedLocation = fmi4cStrdup(shared->model->unzippedLocation);
+    fmu->resourcesLocation = fmi4cStrdup(shared->model->resourcesLocation);
+    fmu->instanceName = fmi4cStrdup(instanceName);
+    fmu->fmuFile = NULL;        //Deferred extraction is done by the shared model
+    fmu->dll = NULL;
+    fmu->sharedModel = shared;
+    fmu->profile = NULL;
+    fmu->hostExecutable = NULL;
+    fmu->host = NULL;
+    fmu->preloadedDll = NULL;
+    fmu->preloadedDllPath = NULL;
+
+    if(fmu->version == fmiVersion1 && !loadFunctionsFmi1(fmu)) {
+        fmi4c_freeFmu(fmu);
+        return NULL;    //Error message should already have been printed
+    }
 
-fmi1Status fmi1_setDebugLogging(fmiHandle *fmu, fmi1Boolean loggingOn)
-{
-    TRACEFUNC
-    return fmu->fmi1.setDebugLogging(fmu->fmi1.component, loggingOn);
+    return fmu;
 }
 
-fmi1Status fmi1_getReal(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1Real values[])
-{
-    TRACEFUNC
-    return fmu->fmi1.getReal(fmu->fmi1.component, valueReferences, nValueReferences, values);
-}
 
-fmi1Status fmi1_getInteger(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1Integer values[])
+//! @brief Acquires a reference to the cache entry for an FMU archive, extracting and parsing it if necessary
+//! @param fmufile Path to FMU archive
+//! @param cacheDirectory Cache directory
+//! @returns Cache entry with a parsed model description, or NULL on failure
+static fmiSharedModel *acquireCacheEntry(const char *fmufile, const char *cacheDirectory)
 {
-    TRACEFUNC
-    return fmu->fmi1.getInteger(fmu->fmi1.component, valueReferences, nValueReferences, values);
-}
+    unsigned long checksum;
+    size_t size;
+    if(!computeFileChecksum(fmufile, &checksum, &size)) {
+        printf("Failed to read FMU: %s\n", fmufile);
+        return NULL;
+    }
 
-fmi1Status fmi1_getBoolean(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1Boolean values[])
-{
-    TRACEFUNC
-    return fmu->fmi1.getBoolean(fmu->fmi1.component, valueReferences, nValueReferences, values);
-}
+    char location[FILENAME_MAX];
+    snprintf(location, sizeof(location), "%s/%08lx-%llx", cacheDirectory, checksum, (unsigned long long)size);
 
-fmi1Status fmi1_getString(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1String values[])
-{
-    TRACEFUNC
-    return fmu->fmi1.getString(fmu->fmi1.component, valueReferences, nValueReferences, values);
-}
+    fmiMutexLock(&cacheMutex);
+    fmiSharedModel *entry = cacheEntries;
+    while(entry != NULL && strcmp(entry->location, location)) {
+        entry = entry->next;
+    }
+    if(entry == NULL) {
+        entry = fmi4cMalloc(sizeof(fmiSharedModel));
+        entry->location = fmi4cStrdup(location);
+        entry->model = NULL;
+        entry->referenceCount = 0;
+        fmiMutexInit(&entry->mutex);
+        entry->next = cacheEntries;
+        cacheEntries = entry;
+    }
+    ++entry->referenceCount;
+    fmiMutexUnlock(&cacheMutex);
+
+    //Only the first user extracts and parses, concurrent users of the same FMU wait here
+    fmiMutexLock(&entry->mutex);
+    if(entry->model == NULL) {
+        fmiHandle *model = allocateFmuHandle();
+        setLocations(model, fmufile, entry->location, entry->location);
+        bool ok = makeDirectories(model->unzippedLocation) &&
+                  extractFilesFromArchive(model->fmuFile, "", model->unzippedLocation);
+        fmi4cFree((char*)model->fmuFile);
+        model->fmuFile = NULL;
+        if(!ok) {
+            printf("Failed to unzip FMU: %s\n", fmufile);
+            abortLoadFmu(model);
+        }
+        else if(parseOptions & FMI4C_PARSE_BINARY_CACHE) {
+            //The description cache file is kept next to the extracted files, and survives their removal
+            char descriptionCachePath[FILENAME_MAX];
+            snprintf(descriptionCachePath, sizeof(descriptionCachePath), "%s.fmi4c", entry->location);
+            if(loadDescriptionCache(model, descriptionCachePath, checksum, size)) {
+                entry->model = model;
+            }
+            else if(!loadModelDescription(model)) {
+                abortLoadFmu(model);
+            }
+            else {
+                writeDescriptionCache(model, descriptionCachePath, checksum, size);
+                entry->model = model;
+            }
+        }
+        else if(!loadModelDescription(model)) {
+            abortLoadFmu(model);
+        }
+        else {
+            entry->model = model;
+        }
+    }
+    bool loaded = (entry->model != NULL);
+    fmiMutexUnlock(&entry->mutex);
 
-fmi1Status fmi1_setReal(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Real values[])
-{
-    TRACEFUNC
-    return fmu->fmi1.setReal(fmu->fmi1.component, valueReferences, nValueReferences, values);
+    if(!loaded) {
+        releaseSharedModel(entry);
+        return NULL;
+    }
+    return entry;
 }
 
-fmi1Status fmi1_setInteger(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Integer values[])
+
+//! @brief Loads an FMU through the shared extraction cache
+//! The new handle is a shallow copy of the cached model, with its own instance name and FMI functions.
+//! @param fmufile Path to FMU archive
+//! @param instanceName Instance name
+//! @param cacheDirectory Cache directory
+//! @returns Handle to FMU, or NULL on failure
+static fmiHandle *loadFmuFromCache(const char *fmufile, const char *instanceName, const char *cacheDirectory)
 {
-    TRACEFUNC
-    return fmu->fmi1.setInteger(fmu->fmi1.component, valueReferences, nValueReferences, values);
+    fmiSharedModel *entry = acquireCacheEntry(fmufile, cacheDirectory);
+    if(entry == NULL) {
+        return NULL;
+    }
+    return newSharedHandle(entry, instanceName);
 }
 
-fmi1Status fmi1_setBoolean(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Boolean values[])
+
+//! @brief Tells if an FMU can be instantiated more than once in the same process
+//! FMUs that cannot (canBeInstantiatedOnlyOncePerProcess in any of its interfaces) still get one library image
+//! per handle, loaded from a private copy of the library when needed, so several handles can be used anyway.
+//! @param fmu FMU handle
+//! @returns True if instances can share one loaded library
+bool fmi4c_supportsMultipleInstantiation(fmiHandle *fmu)
 {
-    TRACEFUNC
-    return fmu->fmi1.setBoolean(fmu->fmi1.component, valueReferences, nValueReferences, values);
+    if(fmu->version == fmiVersion1) {
+        return !fmu->fmi1.canBeInstantiatedOnlyOncePerProcess;
+    }
+    else if(fmu->version == fmiVersion2) {
+        return !fmu->fmi2.cs.canBeInstantiatedOnlyOncePerProcess && !fmu->fmi2.me.canBeInstantiatedOnlyOncePerProcess;
+    }
+    return !fmu->fmi3.cs.canBeInstantiatedOnlyOncePerProcess && !fmu->fmi3.me.canBeInstantiatedOnlyOncePerProcess &&
+           !fmu->fmi3.se.canBeInstantiatedOnlyOncePerProcess;
 }
 
-fmi1Status fmi1_setString(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1String values[])
+
+//! @brief Runs an FMU in a separate host process, to isolate it from the simulator and from other FMUs
+//! Must be called before the FMU is instantiated. The host process is started when the FMU is instantiated,
+//! and stopped when the handle is freed. FMI functions are called through the same API as for FMUs loaded in
+//! process, and are forwarded to the host through shared memory. Set calls are not waited for, they are batched
+//! and run by the host before the next call that returns values, which also reports their status. If the host
+//! process crashes, all further calls return fmi3Fatal.
+//! Only available on Linux, for FMI 3 Co-Simulation. Callbacks (logging, intermediate update) are not forwarded,
+//! log messages are printed by the host, and FMU state, binary, clock and derivative functions are not available.
+//! @param fmu FMU handle
+//! @param hostExecutable Path to the fmi4c_host executable, or NULL to run the FMU in process again
+//! @returns True if the FMU will be run out of process
+bool fmi4c_setOutOfProcess(fmiHandle *fmu, const char *hostExecutable)
 {
-    TRACEFUNC
-    return fmu->fmi1.setString(fmu->fmi1.component, valueReferences, nValueReferences, values);
+#ifdef FMI4C_WITH_HOST
+    if(hostExecutable != NULL && (fmu->version != fmiVersion3 || !fmu->fmi3.supportsCoSimulation)) {
+        printf("Only FMI 3 Co-Simulation FMUs can be run out of process\n");
+        return false;
+    }
+    if(fmu->dll != NULL || fmu->host != NULL) {
+        printf("Out-of-process mode must be set before the FMU is instantiated\n");
+        return false;
+    }
+    if(hostExecutable != NULL) {
+        releasePreloadedLibrary(fmu);   //Must not run in this process
+    }
+    freeIfNotNull(fmu->hostExecutable);
+    fmu->hostExecutable = (hostExecutable != NULL) ? fmi4cStrdup(hostExecutable) : NULL;
+    return (hostExecutable != NULL);
+#else
+    UNUSED(fmu);
+    UNUSED(hostExecutable);
+    printf("Out-of-process FMUs are not supported on this platform\n");
+    return false;
+#endif
 }
 
-bool fmi1_instantiateSlave(fmiHandle *fmu, fmi1String mimeType, fmi1Real timeOut, fmi1Boolean visible, fmi1Boolean interactive, fmi1CallbackLogger_t logger, fmi1CallbackAllocateMemory_t allocateMemory, fmi1CallbackFreeMemory_t freeMemory, fmi1StepFinished_t stepFinished, fmi3Boolean loggingOn)
-{
-    TRACEFUNC
-    fmu->fmi1.callbacksCoSimulation.logger = logger;
-    fmu->fmi1.callbacksCoSimulation.allocateMemory = allocateMemory;
-    fmu->fmi1.callbacksCoSimulation.freeMemory = freeMemory;
-    fmu->fmi1.callbacksCoSimulation.stepFinished = stepFinished;
 
-    fmu->fmi1.component = fmu->fmi1.instantiateSlave(fmu->instanceName, fmu->fmi1.guid, fmu->unzippedLocation, mimeType, timeOut, visible, interactive, fmu->fmi1.callbacksCoSimulation, loggingOn);
+//! @brief Creates a handle for another instance of an already loaded FMU.
+//! The new handle shares the model description and the extracted files with the original handle, so nothing
+//! is extracted or parsed again. It has its own instance name and instance state, and is instantiated and
+//! freed like any other handle. The shared data is freed when the last handle using it is freed, in any order.
+//! @param fmu FMU handle to share model description with
+//! @param instanceName Instance name for the new handle
+//! @returns Handle to FMU, or NULL on failure
+fmiHandle *fmi4c_createInstanceHandle(fmiHandle *fmu, const char *instanceName)
+{
+    fmiMutexLock(&cacheMutex);
+    if(fmu->sharedModel == NULL) {
+        //Move the model description (and deferred extraction) from the original handle to a new shared model
+        fmiSharedModel *shared = fmi4cMalloc(sizeof(fmiSharedModel));
+        shared->model = fmi4cMalloc(sizeof(fmiHandle));
+        memcpy(shared->model, fmu, sizeof(fmiHandle));
+        shared->model->unzippedLocation = fmi4cStrdup(fmu->unzippedLocation);
+        shared->model->resourcesLocation = fmi4cStrdup(fmu->resourcesLocation);
+        shared->model->instanceName = fmi4cStrdup(fmu->instanceName);
+        shared->model->dll = NULL;
+        shared->model->profile = NULL;
+        shared->model->hostExecutable = NULL;
+        shared->model->host = NULL;
+        shared->model->preloadedDll = NULL;
+        shared->model->preloadedDllPath = NULL;
+        fmu->fmuFile = NULL;
+        shared->location = NULL;
+        shared->referenceCount = 1;
+        fmiMutexInit(&shared->mutex);
+        shared->next = NULL;
+        fmu->sharedModel = shared;
+    }
+    fmiSharedModel *shared = fmu->sharedModel;
+    ++shared->referenceCount;
+    fmiMutexUnlock(&cacheMutex);
 
-    return (fmu->fmi1.component != NULL);
+    return newSharedHandle(shared, instanceName);
 }
 
-fmi1Status fmi1_initializeSlave(fmiHandle *fmu, fmi1Real startTime, fmi1Boolean stopTimeDefined, fmi1Real stopTime)
-{
-    TRACEFUNC
-    return fmu->fmi1.initializeSlave(fmu->fmi1.component, startTime, stopTimeDefined, stopTime);
-}
 
-fmi1Status fmi1_terminateSlave(fmiHandle *fmu)
+//! @brief Implementation of fmi4c_loadFmu()
+static fmiHandle *loadFmu(const char *fmufile, const char* instanceName)
 {
-    TRACEFUNC
-    return fmu->fmi1.terminateSlave(fmu->fmi1.component);
-}
+    char *cacheDirectory = getCacheDirectory();
+    if(cacheDirectory != NULL) {
+        fmiHandle *fmu = loadFmuFromCache(fmufile, instanceName, cacheDirectory);
+        fmi4cFree(cacheDirectory);
+        return fmu;
+    }
 
-fmi1Status fmi1_resetSlave(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.resetSlave(fmu->fmi1.component);
-}
+    fmiHandle *fmu = allocateFmuHandle();
+    setLocations(fmu, fmufile, instanceName, instanceName);
 
-void fmi1_freeSlaveInstance(fmiHandle *fmu)
-{
-    TRACEFUNC
-    return fmu->fmi1.freeSlaveInstance(fmu->fmi1.component);
-}
+    if(!makeDirectories(fmu->unzippedLocation) ||
+       !extractFilesFromArchive(fmu->fmuFile, "", fmu->unzippedLocation)) {
+        printf("Failed to unzip FMU: %s\n", fmufile);
+        return abortLoadFmu(fmu);
+    }
 
-fmi1Status fmi1_setRealInputDerivatives(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Integer orders[], const fmi1Real values[])
-{
-    TRACEFUNC
-    return fmu->fmi1.setRealInputDerivatives(fmu->fmi1.component, valueReferences, nValueReferences, orders, values);
-}
+    //Everything is extracted, so read from the unzipped location from now on
+    fmi4cFree((char*)fmu->fmuFile);
+    fmu->fmuFile = NULL;
 
-fmi1Status fmi1_getRealOutputDerivatives(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Integer orders[], fmi1Real values[])
-{
-    TRACEFUNC
-    return fmu->fmi1.getRealOutputDerivatives(fmu->fmi1.component, valueReferences, nValueReferences, orders, values);
+    if(!loadModelDescription(fmu)) {
+        return abortLoadFmu(fmu);
+    }
+
+    if(fmu->version == fmiVersion1 && !loadFunctionsFmi1(fmu)) {
+        fmi4c_freeFmu(fmu);
+        return NULL;    //Error message should already have been printed
+    }
+
+    return fmu;
 }
 
-fmi1Status fmi1_cancelStep(fmiHandle *fmu)
+
+//! @brief Loads an FMU, by first extracting the whole archive to a directory named after the instance.
+//! Then parses modelDescription.xml, and for FMI 1 loads all required FMI functions.
+//! The function is re-entrant: it only uses absolute paths and does not change the working directory
+//! or any other global state, so different FMUs (with different instance names) can be loaded concurrently.
+//! If a cache directory is set (see fmi4c_setCacheDirectory()), the FMU is loaded from the cache instead.
+//! @param fmufile Path to FMU archive
+//! @param instanceName Instance name, also used as name of the extraction directory
+//! @returns Handle to FMU, or NULL on failure
+fmiHandle *fmi4c_loadFmu(const char *fmufile, const char* instanceName)
 {
-    TRACEFUNC
-    return fmu->fmi1.cancelStep(fmu->fmi1.component);
+    OMS_TRACE_BEGIN("fmi4c", "fmi4c_loadFmu");
+    fmiHandle *fmu = loadFmu(fmufile, instanceName);
+    OMS_TRACE_END("fmi4c", "fmi4c_loadFmu");
+    return fmu;
 }
 
-fmi1Status fmi1_doStep(fmiHandle *fmu, fmi1Real currentCommunicationPoint, fmi1Real communicationStepSize, fmi1Boolean newStep)
+
+//! @brief Loads an FMU without extracting the archive.
+//! modelDescription.xml is read directly from the archive into memory. Binaries for the current
+//! platform and resources are extracted to a directory named after the instance when first needed,
+//! i.e. when the FMU is instantiated (or immediately for FMI 1, which loads its functions at load time).
+//! Like fmi4c_loadFmu(), the function is re-entrant. If a cache directory is set, the FMU is loaded
+//! from the cache instead, which always extracts the whole archive (but only once).
+//! @param fmufile Path to FMU archive
+//! @param instanceName Instance name, also used as name of the extraction directory
+//! @returns Handle to FMU, or NULL on failure
+fmiHandle *fmi4c_loadFmuInMemory(const char *fmufile, const char *instanceName)
 {
-    TRACEFUNC
-    return fmu->fmi1.doStep(fmu->fmi1.component, currentCommunicationPoint, communicationStepSize, newStep);
+    char *cacheDirectory = getCacheDirectory();
+    if(cacheDirectory != NULL) {
+        fmiHandle *fmu = loadFmuFromCache(fmufile, instanceName, cacheDirectory);
+        fmi4cFree(cacheDirectory);
+        return fmu;
+    }
+
+    fmiHandle *fmu = allocateFmuHandle();
+    setLocations(fmu, fmufile, instanceName, instanceName);
+    fmu->extracted = false;
+
+    if(!loadModelDescription(fmu)) {
+        return abortLoadFmu(fmu);
+    }
+
+    if(fmu->version == fmiVersion1 && !loadFunctionsFmi1(fmu)) {
+        fmi4c_freeFmu(fmu);
+        return NULL;    //Error message should already have been printed
+    }
+
+    return fmu;
 }
 
-fmi1Status fmi1_getStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Status *value)
+
+typedef struct {
+    const char **fmufiles;
+    const char **instanceNames;
+    fmiHandle **fmus;
+    int numberOfFmus;
+    bool inMemory;
+    int next;
+    fmiMutex mutex;
+} fmiBatchLoader;
+
+//! @brief Worker for fmi4c_loadFmus(), loads FMUs from the batch until no FMUs remain
+#ifdef _WIN32
+static DWORD WINAPI batchLoadWorker(LPVOID data)
+#else
+static void *batchLoadWorker(void *data)
+#endif
 {
-    TRACEFUNC
-    return fmu->fmi1.getStatus(fmu->fmi1.component, statusKind, value);
+    fmiBatchLoader *loader = data;
+    while(true) {
+        fmiMutexLock(&loader->mutex);
+        int i = loader->next++;
+        fmiMutexUnlock(&loader->mutex);
+        if(i >= loader->numberOfFmus) {
+            break;
+        }
+        if(loader->inMemory) {
+            loader->fmus[i] = fmi4c_loadFmuInMemory(loader->fmufiles[i], loader->instanceNames[i]);
+        }
+        else {
+            loader->fmus[i] = fmi4c_loadFmu(loader->fmufiles[i], loader->instanceNames[i]);
+        }
+    }
+    return 0;
 }
 
-fmi1Status fmi1_getRealStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Real *value)
+//! @brief Loads several FMUs in parallel
+//! Instance names must be unique, since they determine the extraction directories.
+//! @param numberOfFmus Number of FMUs to load
+//! @param fmufiles Paths to FMU archives
+//! @param instanceNames Instance names
+//! @param inMemory Use fmi4c_loadFmuInMemory() instead of fmi4c_loadFmu()
+//! @param numberOfThreads Number of worker threads (at least one is used)
+//! @param fmus Returns the FMU handles, NULL for FMUs that failed to load
+//! @returns Number of successfully loaded FMUs
+int fmi4c_loadFmus(int numberOfFmus, const char **fmufiles, const char **instanceNames, bool inMemory, int numberOfThreads, fmiHandle **fmus)
+{
+    fmiBatchLoader loader;
+    loader.fmufiles = fmufiles;
+    loader.instanceNames = instanceNames;
+    loader.fmus = fmus;
+    loader.numberOfFmus = numberOfFmus;
+    loader.inMemory = inMemory;
+    loader.next = 0;
+
+    if(numberOfThreads > numberOfFmus) {
+        numberOfThreads = numberOfFmus;
+    }
+    if(numberOfThreads < 1) {
+        numberOfThreads = 1;
+    }
+
+    fmiMutexInit(&loader.mutex);
+    bool *started = fmi4cMalloc(numberOfThreads*sizeof(bool));
+    bool anyStarted = false;
+#ifdef _WIN32
+    HANDLE *threads = fmi4cMalloc(numberOfThreads*sizeof(HANDLE));
+    for(int i=0; i<numberOfThreads; ++i) {
+        threads[i] = CreateThread(NULL, 0, batchLoadWorker, &loader, 0, NULL);
+        started[i] = (threads[i] != NULL);
+        anyStarted = anyStarted || started[i];
+    }
+#else
+    pthread_t *threads = fmi4cMalloc(numberOfThreads*sizeof(pthread_t));
+    for(int i=0; i<numberOfThreads; ++i) {
+        started[i] = (pthread_create(&threads[i], NULL, batchLoadWorker, &loader) == 0);
+        anyStarted = anyStarted || started[i];
+    }
+#endif
+
+    //Load everything in this thread if no thread could be started
+    if(!anyStarted) {
+        batchLoadWorker(&loader);
+    }
+
+    for(int i=0; i<numberOfThreads; ++i) {
+        if(started[i]) {
+#ifdef _WIN32
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+#else
+            pthread_join(threads[i], NULL);
+#endif
+        }
+    }
+    fmi4cFree(threads);
+    fmi4cFree(started);
+    fmiMutexDestroy(&loader.mutex);
+
+    int numberOfLoadedFmus = 0;
+    for(int i=0; i<numberOfFmus; ++i) {
+        if(fmus[i] != NULL) {
+            ++numberOfLoadedFmus;
+        }
+    }
+    return numberOfLoadedFmus;
+}
+
+
+//! @brief Loads the library of an FMU in advance, for the interface that will most likely be instantiated
+//! The library is taken over by the first instantiation that uses the same library file (see acquireFmuLibrary()).
+//! @param fmu FMU handle with parsed model description and extracted binaries
+//! @returns True if successful
+static bool preloadLibrary(fmiHandle *fmu)
 {
-    TRACEFUNC
-    return fmu->fmi1.getRealStatus(fmu->fmi1.component, statusKind, value);
+    if(fmu->version == fmiVersion1) {
+        return loadFunctionsFmi1(fmu);
+    }
+
+    const char *modelIdentifier;
+    const char *platformDirectory;
+    if(fmu->version == fmiVersion2) {
+        modelIdentifier = fmu->fmi2.supportsCoSimulation ? fmu->fmi2.cs.modelIdentifier : fmu->fmi2.me.modelIdentifier;
+#if defined(_WIN32)
+        platformDirectory = "\\binaries\\win64\\";
+#elif defined(__CYGWIN__)
+        platformDirectory = "/binaries/win64/";
+#else
+        platformDirectory = "/binaries/linux64/";
+#endif
+    }
+    else {
+        modelIdentifier = fmu->fmi3.supportsCoSimulation ? fmu->fmi3.cs.modelIdentifier :
+                          fmu->fmi3.supportsModelExchange ? fmu->fmi3.me.modelIdentifier : fmu->fmi3.se.modelIdentifier;
+#if defined(_WIN32)
+        platformDirectory = "\\binaries\\x86_64-windows\\";
+#elif defined(__CYGWIN__)
+        platformDirectory = "/binaries/x86_64-windows/";
+#else
+        platformDirectory = "/binaries/x86_64-linux/";
+#endif
+    }
+    if(modelIdentifier == NULL) {
+        return false;
+    }
+
+    char dllPath[FILENAME_MAX];
+#if defined(_WIN32) || defined(__CYGWIN__)
+    snprintf(dllPath, sizeof(dllPath), "%s%s%s.dll", fmu->unzippedLocation, platformDirectory, modelIdentifier);
+#else
+    snprintf(dllPath, sizeof(dllPath), "%s%s%s.so", fmu->unzippedLocation, platformDirectory, modelIdentifier);
+#endif
+    double startTime = getWallTime();
+    fmu->preloadedDll = acquireSharedLibrary(dllPath, !fmi4c_supportsMultipleInstantiation(fmu));
+    if(fmu->preloadedDll == NULL) {
+        return false;   //Error message should already have been printed
+    }
+    fmu->preloadedDllPath = fmi4cStrdup(dllPath);
+    fmu->libraryLoadTime = getWallTime()-startTime;
+    return true;
 }
 
-fmi1Status fmi1_getIntegerStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Integer *value)
+
+// Bounded queue of FMU indices between two stages of a pipelined batch load
+typedef struct {
+    int *indices;
+    int capacity;
+    int first;
+    int count;
+    bool closed;                    // No more indices will be pushed
+    fmiCondition changed;
+} fmiLoadQueue;
+
+typedef struct {
+    const char **fmufiles;
+    const char **instanceNames;
+    fmiHandle **fmus;
+    int numberOfFmus;
+    char *cacheDirectory;           // If set, the first stage loads FMUs from the cache and the others only preload libraries
+    int next;                       // Next FMU for the first stage
+    fmiLoadQueue queues[FMI4C_LOAD_STAGES-1];   // Input of each stage after the first
+    int activeWorkers[FMI4C_LOAD_STAGES];
+    double stageTimes[FMI4C_LOAD_STAGES];
+    fmiMutex mutex;
+} fmiPipelineLoader;
+
+typedef struct {
+    fmiPipelineLoader *loader;
+    int stage;
+} fmiPipelineWorker;
+
+
+//! @brief Runs one stage of a pipelined batch load for one FMU
+//! @returns True if the FMU is to be passed to the next stage, false if it failed (and was freed)
+static bool runLoadStage(fmiPipelineLoader *loader, int stage, int i)
+{
+    fmiHandle *fmu = loader->fmus[i];
+    if(stage == FMI4C_LOAD_STAGE_EXTRACT) {
+        if(loader->cacheDirectory != NULL) {
+            loader->fmus[i] = loadFmuFromCache(loader->fmufiles[i], loader->instanceNames[i], loader->cacheDirectory);
+            return (loader->fmus[i] != NULL);
+        }
+
+        //Binaries first, so that the library can be loaded while the resources are being extracted
+        fmu = allocateFmuHandle();
+        setLocations(fmu, loader->fmufiles[i], loader->instanceNames[i], loader->instanceNames[i]);
+        if(!makeDirectories(fmu->unzippedLocation) ||
+           !extractFilesFromArchive(fmu->fmuFile, "binaries/", fmu->unzippedLocation)) {
+            printf("Failed to unzip FMU: %s\n", loader->fmufiles[i]);
+            abortLoadFmu(fmu);
+            return false;
+        }
+        loader->fmus[i] = fmu;
+        return true;
+    }
+    else if(stage == FMI4C_LOAD_STAGE_PARSE) {
+        if(loader->cacheDirectory == NULL && !loadModelDescription(fmu)) {  //Read from the archive
+            loader->fmus[i] = abortLoadFmu(fmu);
+            return false;
+        }
+        return true;
+    }
+    else if(stage == FMI4C_LOAD_STAGE_LIBRARY) {
+        //Failing to preload is not an error for FMI 2 and 3, instantiation will report it
+        if(fmu->dll == NULL && !preloadLibrary(fmu) && fmu->version == fmiVersion1) {
+            fmi4c_freeFmu(fmu);
+            loader->fmus[i] = NULL;
+            return false;
+        }
+        return true;
+    }
+    else {
+        if(loader->cacheDirectory == NULL) {
+            if(!extractFilesFromArchive(fmu->fmuFile, "resources/", fmu->unzippedLocation)) {
+                printf("Failed to unzip FMU: %s\n", loader->fmufiles[i]);
+                fmi4c_freeFmu(fmu);
+                loader->fmus[i] = NULL;
+                return false;
+            }
+            fmi4cFree((char*)fmu->fmuFile);
+            fmu->fmuFile = NULL;
+        }
+        return true;
+    }
+}
+
+
+//! @brief Worker for fmi4c_loadFmusPipelined(), runs one stage until its input queue is closed and empty
+#ifdef _WIN32
+static DWORD WINAPI pipelineLoadWorker(LPVOID data)
+#else
+static void *pipelineLoadWorker(void *data)
+#endif
 {
-    TRACEFUNC
-    return fmu->fmi1.getIntegerStatus(fmu->fmi1.component, statusKind, value);
+    fmiPipelineWorker *worker = data;
+    fmiPipelineLoader *loader = worker->loader;
+    int stage = worker->stage;
+    fmiLoadQueue *input = (stage > 0) ? &loader->queues[stage-1] : NULL;
+    fmiLoadQueue *output = (stage < FMI4C_LOAD_STAGES-1) ? &loader->queues[stage] : NULL;
+    while(true) {
+        int i;
+        fmiMutexLock(&loader->mutex);
+        if(input == NULL) {
+            i = (loader->next < loader->numberOfFmus) ? loader->next++ : -1;
+        }
+        else {
+            while(input->count == 0 && !input->closed) {
+                fmiConditionWait(&input->changed, &loader->mutex);
+            }
+            i = -1;
+            if(input->count > 0) {
+                i = input->indices[input->first];
+                input->first = (input->first+1) % input->capacity;
+                --input->count;
+                fmiConditionBroadcast(&input->changed);
+            }
+        }
+        fmiMutexUnlock(&loader->mutex);
+        if(i < 0) {
+            break;
+        }
+
+        double startTime = getWallTime();
+        bool ok = runLoadStage(loader, stage, i);
+        double time = getWallTime()-startTime;
+
+        fmiMutexLock(&loader->mutex);
+        loader->stageTimes[stage] += time;
+        if(ok && output != NULL) {
+            while(output->count == output->capacity) {
+                fmiConditionWait(&output->changed, &loader->mutex);
+            }
+            output->indices[(output->first+output->count) % output->capacity] = i;
+            ++output->count;
+            fmiConditionBroadcast(&output->changed);
+        }
+        fmiMutexUnlock(&loader->mutex);
+    }
+
+    //The last worker of a stage closes the input of the next stage
+    fmiMutexLock(&loader->mutex);
+    if(--loader->activeWorkers[stage] == 0 && output != NULL) {
+        output->closed = true;
+        fmiConditionBroadcast(&output->changed);
+    }
+    fmiMutexUnlock(&loader->mutex);
+    return 0;
 }
 
-fmi1Status fmi1_getBooleanStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Boolean *value)
+
+//! @brief Loads several FMUs with overlapping load stages
+//! Each FMU passes through four stages: extraction of binaries, parsing of modelDescription.xml (from the archive),
+//! loading of the shared library (for the Co-Simulation interface if available), and extraction of resources.
+//! Each stage has its own worker threads, connected by bounded queues, so that different FMUs are in different
+//! stages at the same time and the total load time approaches the time of the slowest stage. The preloaded
+//! library is used when the FMU is instantiated. Other files in the archive (e.g. documentation) are not extracted.
+//! Instance names must be unique, since they determine the extraction directories. If a cache directory is set,
+//! FMUs are extracted and parsed through the cache in the first stage instead.
+//! @param numberOfFmus Number of FMUs to load
+//! @param fmufiles Paths to FMU archives
+//! @param instanceNames Instance names
+//! @param threadsPerStage Number of worker threads for each stage (at least one is used)
+//! @param queueCapacity Maximum number of FMUs waiting between two stages (at least one)
+//! @param fmus Returns the FMU handles, NULL for FMUs that failed to load
+//! @param stageTimes Returns the total wall time spent in each stage by all its workers, indexed by FMI4C_LOAD_STAGE_*, or NULL
+//! @returns Number of successfully loaded FMUs
+int fmi4c_loadFmusPipelined(int numberOfFmus, const char **fmufiles, const char **instanceNames, int threadsPerStage, int queueCapacity, fmiHandle **fmus, double *stageTimes)
+{
+    fmiPipelineLoader loader;
+    loader.fmufiles = fmufiles;
+    loader.instanceNames = instanceNames;
+    loader.fmus = fmus;
+    loader.numberOfFmus = numberOfFmus;
+    loader.cacheDirectory = getCacheDirectory();
+    loader.next = 0;
+    fmiMutexInit(&loader.mutex);
+
+    if(threadsPerStage < 1) {
+        threadsPerStage = 1;
+    }
+    if(queueCapacity < 1) {
+        queueCapacity = 1;
+    }
+    if(queueCapacity > numberOfFmus) {
+        queueCapacity = numberOfFmus+1;
+    }
+    for(int i=0; i<numberOfFmus; ++i) {
+        fmus[i] = NULL;
+    }
+    for(int stage=0; stage<FMI4C_LOAD_STAGES; ++stage) {
+        loader.activeWorkers[stage] = threadsPerStage;
+        loader.stageTimes[stage] = 0;
+    }
+    for(int q=0; q<FMI4C_LOAD_STAGES-1; ++q) {
+        loader.queues[q].indices = fmi4cMalloc((numberOfFmus+1)*sizeof(int));
+        loader.queues[q].capacity = queueCapacity;
+        loader.queues[q].first = 0;
+        loader.queues[q].count = 0;
+        loader.queues[q].closed = false;
+        fmiConditionInit(&loader.queues[q].changed);
+    }
+
+    //Workers are started from the last stage, so that the input of a stage without workers can be made unbounded
+    //before anything is pushed to it, and that stage is then run by this thread
+    fmiPipelineWorker workers[FMI4C_LOAD_STAGES];
+    int numberOfThreads = FMI4C_LOAD_STAGES*threadsPerStage;
+    bool *started = fmi4cMalloc(numberOfThreads*sizeof(bool));
+#ifdef _WIN32
+    HANDLE *threads = fmi4cMalloc(numberOfThreads*sizeof(HANDLE));
+#else
+    pthread_t *threads = fmi4cMalloc(numberOfThreads*sizeof(pthread_t));
+#endif
+    for(int stage=FMI4C_LOAD_STAGES-1; stage>=0; --stage) {
+        workers[stage].loader = &loader;
+        workers[stage].stage = stage;
+        int numberOfStarted = 0;
+        for(int j=0; j<threadsPerStage; ++j) {
+            int t = stage*threadsPerStage+j;
+#ifdef _WIN32
+            threads[t] = CreateThread(NULL, 0, pipelineLoadWorker, &workers[stage], 0, NULL);
+            started[t] = (threads[t] != NULL);
+#else
+            started[t] = (pthread_create(&threads[t], NULL, pipelineLoadWorker, &workers[stage]) == 0);
+#endif
+            if(started[t]) {
+                ++numberOfStarted;
+            }
+        }
+        if(numberOfStarted == 0) {
+            loader.activeWorkers[stage] = 1;    //This thread
+            if(stage > 0) {
+                loader.queues[stage-1].capacity = numberOfFmus+1;
+            }
+        }
+        else {
+            fmiMutexLock(&loader.mutex);
+            loader.activeWorkers[stage] -= threadsPerStage-numberOfStarted;
+            fmiMutexUnlock(&loader.mutex);
+        }
+    }
+    for(int stage=0; stage<FMI4C_LOAD_STAGES; ++stage) {
+        bool anyStarted = false;
+        for(int j=0; j<threadsPerStage; ++j) {
+            anyStarted = anyStarted || started[stage*threadsPerStage+j];
+        }
+        if(!anyStarted) {
+            pipelineLoadWorker(&workers[stage]);
+        }
+    }
+    for(int t=0; t<numberOfThreads; ++t) {
+        if(started[t]) {
+#ifdef _WIN32
+            WaitForSingleObject(threads[t], INFINITE);
+            CloseHandle(threads[t]);
+#else
+            pthread_join(threads[t], NULL);
+#endif
+        }
+    }
+    fmi4cFree(threads);
+    fmi4cFree(started);
+
+    for(int q=0; q<FMI4C_LOAD_STAGES-1; ++q) {
+        fmi4cFree(loader.queues[q].indices);
+        fmiConditionDestroy(&loader.queues[q].changed);
+    }
+    fmiMutexDestroy(&loader.mutex);
+    fmi4cFree(loader.cacheDirectory);
+
+    if(stageTimes != NULL) {
+        memcpy(stageTimes, loader.stageTimes, sizeof(loader.stageTimes));
+    }
+    int numberOfLoadedFmus = 0;
+    for(int i=0; i<numberOfFmus; ++i) {
+        if(fmus[i] != NULL) {
+            ++numberOfLoadedFmus;
+        }
+    }
+    return numberOfLoadedFmus;
+}
+
+
+
+//! @brief Free FMU dll
+//! For FMUs loaded from the cache, the shared files and model description are released instead of freed.
+//! @param fmu FMU handle
+void fmi4c_freeFmu(fmiHandle *fmu)
 {
     TRACEFUNC
-    return fmu->fmi1.getBooleanStatus(fmu->fmi1.component, statusKind, value);
+    if(fmu->dll != NULL) {
+        releaseSharedLibrary(fmu->dll);
+    }
+    releasePreloadedLibrary(fmu);
+#ifdef FMI4C_WITH_HOST
+    if(fmu->host != NULL) {
+        stopHost(fmu->host);
+    }
+#endif
+    freeIfNotNull(fmu->hostExecutable);
+    if(fmu->sharedModel != NULL) {
+        releaseSharedModel(fmu->sharedModel);
+    }
+    else {
+        freeModelDescription(fmu);
+    }
+    freeIfNotNull(fmu->resourcesLocation);
+    freeIfNotNull(fmu->instanceName);
+    freeIfNotNull(fmu->unzippedLocation);
+    freeIfNotNull(fmu->fmuFile);
+    fmi4cFree(fmu->profile);
+    fmi4cFree(fmu);
 }
 
-fmi1Status fmi1_getStringStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1String *value)
+fmi1Type fmi1_getType(fmiHandle *fmu)
 {
     TRACEFUNC
-    return fmu->fmi1.getStringStatus(fmu->fmi1.component, statusKind, value);
+
+    return fmu->fmi1.type;
 }
 
-const char *fmi1_getModelTypesPlatform(fmiHandle *fmu)
+int fmi1_getNumberOfContinuousStates(fmiHandle *fmu)
 {
-    TRACEFUNC
-    return fmu->fmi1.getModelTypesPlatform();
+    return fmu->fmi1.numberOfContinuousStates;
 }
 
+int fmi1_getNumberOfEventIndicators(fmiHandle *fmu)
+{
+    return fmu->fmi1.numberOfEventIndicators;
+}
 
-bool fmi1_instantiateModel(fmiHandle *fmu, fmi1CallbackLogger_t logger, fmi1CallbackAllocateMemory_t allocateMemory, fmi1CallbackFreeMemory_t freeMemory, fmi1Boolean loggingOn)
+bool fmi1_defaultStartTimeDefined(fmiHandle *fmu)
 {
     TRACEFUNC
-    fmu->fmi1.callbacksModelExchange.logger = logger;
-    fmu->fmi1.callbacksModelExchange.allocateMemory = allocateMemory;
-    fmu->fmi1.callbacksModelExchange.freeMemory = freeMemory;
-    fmu->fmi1.component = fmu->fmi1.instantiateModel(fmu->instanceName, fmu->fmi1.guid, fmu->fmi1.callbacksModelExchange, loggingOn);
-
-    return (fmu->fmi1.component != NULL);
+    return fmu->fmi1.defaultStartTimeDefined;
 }
 
-void fmi1_freeModelInstance(fmiHandle *fmu)
+bool fmi1_defaultStopTimeDefined(fmiHandle *fmu)
 {
     TRACEFUNC
-    fmu->fmi1.freeModelInstance(fmu->fmi1.component);
+    return fmu->fmi1.defaultStopTimeDefined;
 }
 
-fmi1Status fmi1_setTime(fmiHandle *fmu, fmi1Real time)
+bool fmi1_defaultToleranceDefined(fmiHandle *fmu)
 {
     TRACEFUNC
-    return fmu->fmi1.setTime(fmu->fmi1.component, time);
+    return fmu->fmi1.defaultToleranceDefined;
 }
 
-fmi1Status fmi1_setContinuousStates(fmiHandle *fmu, const fmi1Real values[], size_t nStates)
+double fmi1_getDefaultStartTime(fmiHandle *fmu)
 {
     TRACEFUNC
-    return fmu->fmi1.setContinuousStates(fmu->fmi1.component, values, nStates);
+    return fmu->fmi1.defaultStartTime;
 }
 
-fmi1Status fmi1_completedIntegratorStep(fmiHandle *fmu, fmi1Boolean *callEventUpdate)
+double fmi1_getDefaultStopTime(fmiHandle *fmu)
 {
     TRACEFUNC
-    return fmu->fmi1.completedIntegratorStep(fmu->fmi1.component, callEventUpdate);
+    return fmu->fmi1.defaultStopTime;
 }
 
-fmi1Status fmi1_initialize(fmiHandle *fmu, fmi1Boolean toleranceControlled, fmi1Real relativeTolerance, fmi1EventInfo *eventInfo)
+double fmi1_getDefaultTolerance(fmiHandle *fmu)
 {
     TRACEFUNC
-    return fmu->fmi1.initialize(fmu->fmi1.component, toleranceControlled, relativeTolerance, eventInfo);
+    return fmu->fmi1.defaultTolerance;
 }
 
-fmi1Status fmi1_getDerivatives(fmiHandle *fmu, fmi1Real derivatives[], size_t nDerivatives)
+int fmi1_getNumberOfVariables(fmiHandle *fmu)
 {
     TRACEFUNC
-    return fmu->fmi1.getDerivatives(fmu->fmi1.component, derivatives, nDerivatives);
+    return fmu->fmi1.numberOfVariables;
 }
 
-fmi1Status fmi1_getEventIndicators(fmiHandle *fmu, fmi1Real indicators[], size_t nIndicators)
+fmi1VariableHandle *fmi1_getVariableByIndex(fmiHandle *fmu, int i)
 {
     TRACEFUNC
-    return fmu->fmi1.getEventIndicators(fmu->fmi1.component, indicators, nIndicators);
+
+    if(i >= fmu->fmi1.numberOfVariables) {
+        printf("Variable index out of bounds: %i\n",i);
+        return NULL;
+    }
+    return &fmu->fmi1.variables[i];
 }
 
-fmi1Status fmi1_eventUpdate(fmiHandle *fmu, fmi1Boolean intermediateResults, fmi1EventInfo *eventInfo)
+fmi1VariableHandle *fmi1_getVariableByValueReference(fmiHandle *fmu, fmi1ValueReference vr)
 {
     TRACEFUNC
-    return fmu->fmi1.eventUpdate(fmu->fmi1.component, intermediateResults, eventInfo);
+
+    int i = findVariableIndexByValueReference(&fmu->fmi1.variableIndex, vr);
+    if(i >= 0) {
+        return &fmu->fmi1.variables[i];
+    }
+    printf("Variable with value reference %i not found.\n", vr);
+    return NULL;
 }
 
-fmi1Status fmi1_getContinuousStates(fmiHandle *fmu, fmi1Real states[], size_t nStates)
+fmi1VariableHandle *fmi1_getVariableByName(fmiHandle *fmu, fmi1String name)
+{
+    int i = findVariableIndexByName(&fmu->fmi1.variableIndex, name);
+    if(i >= 0) {
+        return &fmu->fmi1.variables[i];
+    }
+    printf("Variable with name %s not found.\n", name);
+    return NULL;
+}
+
+const char *fmi1_getVariableName(fmi1VariableHandle *var)
 {
     TRACEFUNC
-    return fmu->fmi1.getContinuousStates(fmu->fmi1.component, states, nStates);
+    return var->name;
 }
 
-fmi1Status fmi1_getNominalContinuousStates(fmiHandle *fmu, fmi1Real nominals[], size_t nNominals)
+const char *fmi1_getVariableDescription(fmi1VariableHandle *var)
 {
     TRACEFUNC
-    return fmu->fmi1.getNominalContinuousStates(fmu->fmi1.component, nominals, nNominals);
+    return var->description;
 }
 
-fmi1Status fmi1_getStateValueReferences(fmiHandle *fmu, fmi1ValueReference valueReferences[], size_t nValueReferences)
+fmi1Real fmi1_getVariableStartReal(fmi1VariableHandle *var)
 {
     TRACEFUNC
-    return fmu->fmi1.getStateValueReferences(fmu->fmi1.component, valueReferences, nValueReferences);
+    return var->startReal;
 }
 
-fmi1Status fmi1_terminate(fmiHandle *fmu)
+fmi1Integer fmi1_getVariableStartInteger(fmi1VariableHandle *var)
 {
     TRACEFUNC
-    return fmu->fmi1.terminate(fmu->fmi1.component);
+    return var->startInteger;
 }
 
-fmi1DataType fmi1_getVariableDataType(fmi1VariableHandle *var)
+fmi1Boolean fmi1_getVariableStartBoolean(fmi1VariableHandle *var)
 {
     TRACEFUNC
-    return var->datatype;
+    return var->startBoolean;
 }
 
-int fmi3_getNumberOfUnits(fmiHandle *fmu)
+fmi1String fmi1_getVariableStartString(fmi1VariableHandle *var)
 {
-    return fmu->fmi3.numberOfUnits;
+    TRACEFUNC
+    return var->startString;
 }
 
-fmi3UnitHandle *fmi3_getUnitByIndex(fmiHandle *fmu, int i)
+long fmi1_getVariableValueReference(fmi1VariableHandle *var)
 {
-    return &fmu->fmi3.units[i];
+    TRACEFUNC
+    return var->valueReference;
 }
 
-const char *fmi3_getUnitName(fmi3UnitHandle *unit)
+fmi1Causality fmi1_getVariableCausality(fmi1VariableHandle *var)
 {
-    return unit->name;
+    TRACEFUNC
+    return var->causality;
 }
 
-bool fmi3_hasBaseUnit(fmi3UnitHandle *unit)
+fmi1Variability fmi1_getVariableVariability(fmi1VariableHandle *var)
 {
-    return (unit->baseUnit != NULL);
+    TRACEFUNC
+    return var->variability;
 }
 
-void fmi3_getBaseUnit(fmi3UnitHandle *unit, double *factor, double *offset,
-                     int *kg, int *m, int *s, int *A, int *K, int *mol, int *cd, int *rad)
+fmi1Alias fmi1_getAlias(fmi1VariableHandle *var)
 {
-    if(unit->baseUnit != NULL) {
-        *factor = unit->baseUnit->factor;
+    TRACEFUNC
+    return var->alias;
+}
+
+bool fmi1_getVariableIsFixed(fmi1VariableHandle *var)
+{
+    TRACEFUNC
+    return var->fixed;
+}
+
+const char *fmi1_getTypesPlatform(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return fmu->fmi1.getTypesPlatform();
+}
+
+const char *fmi1_getVersion(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return fmu->fmi1.getVersion();
+}
+
+fmi1Status fmi1_setDebugLogging(fmiHandle *fmu, fmi1Boolean loggingOn)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.setDebugLogging(fmu->fmi1.component, loggingOn));
+}
+
+fmi1Status fmi1_getReal(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1Real values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.getReal(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+fmi1Status fmi1_getInteger(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1Integer values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.getInteger(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+fmi1Status fmi1_getBoolean(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1Boolean values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.getBoolean(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+fmi1Status fmi1_getString(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, fmi1String values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.getString(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+fmi1Status fmi1_setReal(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Real values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.setReal(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+fmi1Status fmi1_setInteger(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Integer values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.setInteger(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+fmi1Status fmi1_setBoolean(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Boolean values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.setBoolean(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+fmi1Status fmi1_setString(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1String values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.setString(fmu->fmi1.component, valueReferences, nValueReferences, values));
+}
+
+bool fmi1_instantiateSlave(fmiHandle *fmu, fmi1String mimeType, fmi1Real timeOut, fmi1Boolean visible, fmi1Boolean interactive, fmi1CallbackLogger_t logger, fmi1CallbackAllocateMemory_t allocateMemory, fmi1CallbackFreeMemory_t freeMemory, fmi1StepFinished_t stepFinished, fmi3Boolean loggingOn)
+{
+    TRACEFUNC
+    fmu->fmi1.callbacksCoSimulation.logger = logger;
+    fmu->fmi1.callbacksCoSimulation.allocateMemory = allocateMemory;
+    fmu->fmi1.callbacksCoSimulation.freeMemory = freeMemory;
+    fmu->fmi1.callbacksCoSimulation.stepFinished = stepFinished;
+
+    fmu->fmi1.component = fmu->fmi1.instantiateSlave(fmu->instanceName, fmu->fmi1.guid, fmu->unzippedLocation, mimeType, timeOut, visible, interactive, fmu->fmi1.callbacksCoSimulation, loggingOn);
+
+    return (fmu->fmi1.component != NULL);
+}
+
+fmi1Status fmi1_initializeSlave(fmiHandle *fmu, fmi1Real startTime, fmi1Boolean stopTimeDefined, fmi1Real stopTime)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.initializeSlave(fmu->fmi1.component, startTime, stopTimeDefined, stopTime));
+}
+
+fmi1Status fmi1_terminateSlave(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.terminateSlave(fmu->fmi1.component));
+}
+
+fmi1Status fmi1_resetSlave(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.resetSlave(fmu->fmi1.component));
+}
+
+void fmi1_freeSlaveInstance(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return fmu->fmi1.freeSlaveInstance(fmu->fmi1.component);
+}
+
+fmi1Status fmi1_setRealInputDerivatives(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Integer orders[], const fmi1Real values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.setRealInputDerivatives(fmu->fmi1.component, valueReferences, nValueReferences, orders, values));
+}
+
+fmi1Status fmi1_getRealOutputDerivatives(fmiHandle *fmu, const fmi1ValueReference valueReferences[], size_t nValueReferences, const fmi1Integer orders[], fmi1Real values[])
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.getRealOutputDerivatives(fmu->fmi1.component, valueReferences, nValueReferences, orders, values));
+}
+
+fmi1Status fmi1_cancelStep(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.cancelStep(fmu->fmi1.component));
+}
+
+fmi1Status fmi1_doStep(fmiHandle *fmu, fmi1Real currentCommunicationPoint, fmi1Real communicationStepSize, fmi1Boolean newStep)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.doStep(fmu->fmi1.component, currentCommunicationPoint, communicationStepSize, newStep));
+}
+
+fmi1Status fmi1_getStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Status *value)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getStatus(fmu->fmi1.component, statusKind, value));
+}
+
+fmi1Status fmi1_getRealStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Real *value)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getRealStatus(fmu->fmi1.component, statusKind, value));
+}
+
+fmi1Status fmi1_getIntegerStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Integer *value)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getIntegerStatus(fmu->fmi1.component, statusKind, value));
+}
+
+fmi1Status fmi1_getBooleanStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1Boolean *value)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getBooleanStatus(fmu->fmi1.component, statusKind, value));
+}
+
+fmi1Status fmi1_getStringStatus(fmiHandle *fmu, const fmi1StatusKind statusKind, fmi1String *value)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getStringStatus(fmu->fmi1.component, statusKind, value));
+}
+
+const char *fmi1_getModelTypesPlatform(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return fmu->fmi1.getModelTypesPlatform();
+}
+
+
+bool fmi1_instantiateModel(fmiHandle *fmu, fmi1CallbackLogger_t logger, fmi1CallbackAllocateMemory_t allocateMemory, fmi1CallbackFreeMemory_t freeMemory, fmi1Boolean loggingOn)
+{
+    TRACEFUNC
+    fmu->fmi1.callbacksModelExchange.logger = logger;
+    fmu->fmi1.callbacksModelExchange.allocateMemory = allocateMemory;
+    fmu->fmi1.callbacksModelExchange.freeMemory = freeMemory;
+    fmu->fmi1.component = fmu->fmi1.instantiateModel(fmu->instanceName, fmu->fmi1.guid, fmu->fmi1.callbacksModelExchange, loggingOn);
+
+    return (fmu->fmi1.component != NULL);
+}
+
+void fmi1_freeModelInstance(fmiHandle *fmu)
+{
+    TRACEFUNC
+    fmu->fmi1.freeModelInstance(fmu->fmi1.component);
+}
+
+fmi1Status fmi1_setTime(fmiHandle *fmu, fmi1Real time)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.setTime(fmu->fmi1.component, time));
+}
+
+fmi1Status fmi1_setContinuousStates(fmiHandle *fmu, const fmi1Real values[], size_t nStates)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.setContinuousStates(fmu->fmi1.component, values, nStates));
+}
+
+fmi1Status fmi1_completedIntegratorStep(fmiHandle *fmu, fmi1Boolean *callEventUpdate)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.completedIntegratorStep(fmu->fmi1.component, callEventUpdate));
+}
+
+fmi1Status fmi1_initialize(fmiHandle *fmu, fmi1Boolean toleranceControlled, fmi1Real relativeTolerance, fmi1EventInfo *eventInfo)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.initialize(fmu->fmi1.component, toleranceControlled, relativeTolerance, eventInfo));
+}
+
+fmi1Status fmi1_getDerivatives(fmiHandle *fmu, fmi1Real derivatives[], size_t nDerivatives)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getDerivatives(fmu->fmi1.component, derivatives, nDerivatives));
+}
+
+fmi1Status fmi1_getEventIndicators(fmiHandle *fmu, fmi1Real indicators[], size_t nIndicators)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getEventIndicators(fmu->fmi1.component, indicators, nIndicators));
+}
+
+fmi1Status fmi1_eventUpdate(fmiHandle *fmu, fmi1Boolean intermediateResults, fmi1EventInfo *eventInfo)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.eventUpdate(fmu->fmi1.component, intermediateResults, eventInfo));
+}
+
+fmi1Status fmi1_getContinuousStates(fmiHandle *fmu, fmi1Real states[], size_t nStates)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getContinuousStates(fmu->fmi1.component, states, nStates));
+}
+
+fmi1Status fmi1_getNominalContinuousStates(fmiHandle *fmu, fmi1Real nominals[], size_t nNominals)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.getNominalContinuousStates(fmu->fmi1.component, nominals, nNominals));
+}
+
+fmi1Status fmi1_getStateValueReferences(fmiHandle *fmu, fmi1ValueReference valueReferences[], size_t nValueReferences)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, nValueReferences, fmu->fmi1.getStateValueReferences(fmu->fmi1.component, valueReferences, nValueReferences));
+}
+
+fmi1Status fmi1_terminate(fmiHandle *fmu)
+{
+    TRACEFUNC
+    return PROFILED_CALL(fmu, 0, fmu->fmi1.terminate(fmu->fmi1.component));
+}
+
+fmi1DataType fmi1_getVariableDataType(fmi1VariableHandle *var)
+{
+    TRACEFUNC
+    return var->datatype;
+}
+
+int fmi3_getNumberOfUnits(fmiHandle *fmu)
+{
+    return fmu->fmi3.numberOfUnits;
+}
+
+fmi3UnitHandle *fmi3_getUnitByIndex(fmiHandle *fmu, int i)
+{
+    return &fmu->fmi3.units[i];
+}
+
+const char *fmi3_getUnitName(fmi3UnitHandle *unit)
+{
+    return unit->name;
+}
+
+bool fmi3_hasBaseUnit(fmi3UnitHandle *unit)
+{
+    return (unit->baseUnit != NULL);
+}
+
+void fmi3_getBaseUnit(fmi3UnitHandle *unit, double *factor, double *offset,
+                     int *kg, int *m, int *s, int *A, int *K, int *mol, int *cd, int *rad)
+{
+    if(unit->baseUnit != NULL) {
+        *factor = unit->baseUnit->factor;
         *offset = unit->baseUnit->offset;
         *kg = unit->baseUnit->kg;
         *m= unit->baseUnit->m;
@@ -5331,3 +7185,2260 @@ fmi3ValueReference fmi3_getModelStructureEventIndicatorDependencyKind(fmiHandle
     return 0;
 }
 
+
+
+//! @brief Creates an empty transfer plan, for moving values from one FMU to another (or within one FMU)
+//! Register transfers with fmi2_addTransfer() or fmi3_addTransfer(), then execute the plan each step with
+//! fmi2_executeTransferPlan() or fmi3_executeTransferPlan(). Execution does one get and one set call per data type,
+//! into buffers that are allocated when transfers are added.
+//! @param source FMU to get values from
+//! @param destination FMU to set values in
+//! @returns Transfer plan, or NULL if the FMUs do not use the same FMI version (2 or 3)
+fmiTransferPlan *fmi4c_createTransferPlan(fmiHandle *source, fmiHandle *destination)
+{
+    if(source->version != destination->version ||
+       (source->version != fmiVersion2 && source->version != fmiVersion3)) {
+        printf("Transfer plans require two FMI 2 or two FMI 3 FMUs.\n");
+        return NULL;
+    }
+
+    fmiTransferPlan *plan = fmi4cMalloc(sizeof(fmiTransferPlan));
+    plan->source = source;
+    plan->destination = destination;
+    plan->numberOfGroups = 0;
+    plan->groups = NULL;
+    return plan;
+}
+
+
+//! @brief Frees a transfer plan and its buffers
+//! @param plan Transfer plan
+void fmi4c_freeTransferPlan(fmiTransferPlan *plan)
+{
+    for(int i=0; i<plan->numberOfGroups; ++i) {
+        fmiTransferGroup *group = &plan->groups[i];
+        fmi4cFree(group->sourceValueReferences);
+        fmi4cFree(group->destinationValueReferences);
+        fmi4cFree(group->sourceIndices);
+        fmi4cFree(group->sourceValues);
+        fmi4cFree(group->destinationValues);
+        fmi4cFree(group->sourceValueSizes);
+        fmi4cFree(group->destinationValueSizes);
+    }
+    fmi4cFree(plan->groups);
+    fmi4cFree(plan);
+}
+
+
+//! @brief Adds one transfer to the group of its data type, creating the group if needed
+//! Source value references transferred to several destinations are only read once.
+//! @param plan Transfer plan
+//! @param dataType Data type (fmi2DataType or fmi3DataType)
+//! @param valueSize Size of one value of the data type
+//! @param hasValueSizes True for binaries, which also transfer the size of each value
+//! @param sourceValueReference Value reference in source FMU
+//! @param destinationValueReference Value reference in destination FMU
+static void addTransfer(fmiTransferPlan *plan, int dataType, size_t valueSize, bool hasValueSizes,
+                        fmi3ValueReference sourceValueReference, fmi3ValueReference destinationValueReference)
+{
+    fmiTransferGroup *group = NULL;
+    for(int i=0; i<plan->numberOfGroups; ++i) {
+        if(plan->groups[i].dataType == dataType) {
+            group = &plan->groups[i];
+        }
+    }
+    if(group == NULL) {
+        plan->groups = fmi4cRealloc(plan->groups, (plan->numberOfGroups+1)*sizeof(fmiTransferGroup));
+        group = &plan->groups[plan->numberOfGroups++];
+        memset(group, 0, sizeof(fmiTransferGroup));
+        group->dataType = dataType;
+        group->valueSize = valueSize;
+        group->direct = true;
+    }
+
+    if(group->numberOfDestinations >= group->capacity) {
+        group->capacity = (group->capacity > 0) ? 2*group->capacity : 8;
+        group->sourceValueReferences = fmi4cRealloc(group->sourceValueReferences, group->capacity*sizeof(fmi3ValueReference));
+        group->destinationValueReferences = fmi4cRealloc(group->destinationValueReferences, group->capacity*sizeof(fmi3ValueReference));
+        group->sourceIndices = fmi4cRealloc(group->sourceIndices, group->capacity*sizeof(int));
+        group->sourceValues = fmi4cRealloc(group->sourceValues, group->capacity*valueSize);
+        group->destinationValues = fmi4cRealloc(group->destinationValues, group->capacity*valueSize);
+        if(hasValueSizes) {
+            group->sourceValueSizes = fmi4cRealloc(group->sourceValueSizes, group->capacity*sizeof(size_t));
+            group->destinationValueSizes = fmi4cRealloc(group->destinationValueSizes, group->capacity*sizeof(size_t));
+        }
+    }
+
+    int sourceIndex = 0;
+    while(sourceIndex < group->numberOfSources && group->sourceValueReferences[sourceIndex] != sourceValueReference) {
+        ++sourceIndex;
+    }
+    if(sourceIndex == group->numberOfSources) {
+        group->sourceValueReferences[group->numberOfSources++] = sourceValueReference;
+    }
+    if(sourceIndex != group->numberOfDestinations) {
+        group->direct = false;
+    }
+    group->destinationValueReferences[group->numberOfDestinations] = destinationValueReference;
+    group->sourceIndices[group->numberOfDestinations] = sourceIndex;
+    ++group->numberOfDestinations;
+}
+
+
+//! @brief Copies source values to the destination buffer, in destination order
+//! @param group Transfer group
+//! @returns Buffer with one value per destination
+static const void *gatherTransferValues(fmiTransferGroup *group)
+{
+    if(group->direct) {
+        return group->sourceValues;
+    }
+    for(int i=0; i<group->numberOfDestinations; ++i) {
+        memcpy(group->destinationValues+i*group->valueSize,
+               group->sourceValues+group->sourceIndices[i]*group->valueSize,
+               group->valueSize);
+        if(group->sourceValueSizes != NULL) {
+            group->destinationValueSizes[i] = group->sourceValueSizes[group->sourceIndices[i]];
+        }
+    }
+    return group->destinationValues;
+}
+
+
+//! @brief Adds a transfer of a scalar variable to an FMI 2 transfer plan
+//! @param plan Transfer plan
+//! @param dataType Data type of both variables (enumerations are transferred as integers)
+//! @param sourceValueReference Value reference in source FMU
+//! @param destinationValueReference Value reference in destination FMU
+//! @returns True if successful
+bool fmi2_addTransfer(fmiTransferPlan *plan, fmi2DataType dataType, fmi2ValueReference sourceValueReference, fmi2ValueReference destinationValueReference)
+{
+    if(plan->source->version != fmiVersion2) {
+        printf("Transfer plan is not for FMI 2.\n");
+        return false;
+    }
+
+    switch(dataType) {
+    case fmi2DataTypeReal:
+        addTransfer(plan, fmi2DataTypeReal, sizeof(fmi2Real), false, sourceValueReference, destinationValueReference);
+        return true;
+    case fmi2DataTypeInteger:
+    case fmi2DataTypeEnumeration:
+        addTransfer(plan, fmi2DataTypeInteger, sizeof(fmi2Integer), false, sourceValueReference, destinationValueReference);
+        return true;
+    case fmi2DataTypeBoolean:
+        addTransfer(plan, fmi2DataTypeBoolean, sizeof(fmi2Boolean), false, sourceValueReference, destinationValueReference);
+        return true;
+    case fmi2DataTypeString:
+        addTransfer(plan, fmi2DataTypeString, sizeof(fmi2String), false, sourceValueReference, destinationValueReference);
+        return true;
+    }
+    printf("Unknown data type for transfer: %i\n", dataType);
+    return false;
+}
+
+
+//! @brief Executes an FMI 2 transfer plan
+//! @param plan Transfer plan
+//! @returns Worst status of all get and set calls, execution stops at the first error
+fmi2Status fmi2_executeTransferPlan(fmiTransferPlan *plan)
+{
+    fmi2Status worstStatus = fmi2OK;
+    for(int i=0; i<plan->numberOfGroups; ++i) {
+        fmiTransferGroup *group = &plan->groups[i];
+        const fmi2ValueReference *sources = group->sourceValueReferences;
+        const fmi2ValueReference *destinations = group->destinationValueReferences;
+        size_t nSources = (size_t)group->numberOfSources;
+        size_t nDestinations = (size_t)group->numberOfDestinations;
+
+        fmi2Status status = fmi2Error;
+        switch(group->dataType) {
+        case fmi2DataTypeReal:
+            status = fmi2_getReal(plan->source, sources, nSources, (fmi2Real*)group->sourceValues);
+            break;
+        case fmi2DataTypeInteger:
+            status = fmi2_getInteger(plan->source, sources, nSources, (fmi2Integer*)group->sourceValues);
+            break;
+        case fmi2DataTypeBoolean:
+            status = fmi2_getBoolean(plan->source, sources, nSources, (fmi2Boolean*)group->sourceValues);
+            break;
+        case fmi2DataTypeString:
+            status = fmi2_getString(plan->source, sources, nSources, (fmi2String*)group->sourceValues);
+            break;
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi2Error) {
+            return worstStatus;
+        }
+
+        const void *values = gatherTransferValues(group);
+        switch(group->dataType) {
+        case fmi2DataTypeReal:
+            status = fmi2_setReal(plan->destination, destinations, nDestinations, values);
+            break;
+        case fmi2DataTypeInteger:
+            status = fmi2_setInteger(plan->destination, destinations, nDestinations, values);
+            break;
+        case fmi2DataTypeBoolean:
+            status = fmi2_setBoolean(plan->destination, destinations, nDestinations, values);
+            break;
+        case fmi2DataTypeString:
+            status = fmi2_setString(plan->destination, destinations, nDestinations, values);
+            break;
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi2Error) {
+            return worstStatus;
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief Adds a transfer of a scalar variable to an FMI 3 transfer plan
+//! @param plan Transfer plan
+//! @param dataType Data type of both variables (enumerations are transferred as Int64, clocks are not supported)
+//! @param sourceValueReference Value reference in source FMU
+//! @param destinationValueReference Value reference in destination FMU
+//! @returns True if successful
+bool fmi3_addTransfer(fmiTransferPlan *plan, fmi3DataType dataType, fmi3ValueReference sourceValueReference, fmi3ValueReference destinationValueReference)
+{
+    if(plan->source->version != fmiVersion3) {
+        printf("Transfer plan is not for FMI 3.\n");
+        return false;
+    }
+
+    size_t valueSize;
+    switch(dataType) {
+    case fmi3DataTypeFloat64:       valueSize = sizeof(fmi3Float64); break;
+    case fmi3DataTypeFloat32:       valueSize = sizeof(fmi3Float32); break;
+    case fmi3DataTypeInt64:         valueSize = sizeof(fmi3Int64); break;
+    case fmi3DataTypeEnumeration:   valueSize = sizeof(fmi3Int64); dataType = fmi3DataTypeInt64; break;
+    case fmi3DataTypeInt32:         valueSize = sizeof(fmi3Int32); break;
+    case fmi3DataTypeInt16:         valueSize = sizeof(fmi3Int16); break;
+    case fmi3DataTypeInt8:          valueSize = sizeof(fmi3Int8); break;
+    case fmi3DataTypeUInt64:        valueSize = sizeof(fmi3UInt64); break;
+    case fmi3DataTypeUInt32:        valueSize = sizeof(fmi3UInt32); break;
+    case fmi3DataTypeUInt16:        valueSize = sizeof(fmi3UInt16); break;
+    case fmi3DataTypeUInt8:         valueSize = sizeof(fmi3UInt8); break;
+    case fmi3DataTypeBoolean:       valueSize = sizeof(fmi3Boolean); break;
+    case fmi3DataTypeString:        valueSize = sizeof(fmi3String); break;
+    case fmi3DataTypeBinary:        valueSize = sizeof(fmi3Binary); break;
+    default:
+        printf("Data type cannot be transferred: %i\n", dataType);
+        return false;
+    }
+
+    addTransfer(plan, dataType, valueSize, dataType == fmi3DataTypeBinary, sourceValueReference, destinationValueReference);
+    return true;
+}
+
+
+//! @brief Gets all source values of an FMI 3 transfer group
+static fmi3Status getTransferValuesFmi3(fmiHandle *fmu, fmiTransferGroup *group)
+{
+    const fmi3ValueReference *vrs = group->sourceValueReferences;
+    size_t n = (size_t)group->numberOfSources;
+    void *values = group->sourceValues;
+    switch(group->dataType) {
+    case fmi3DataTypeFloat64:   return fmi3_getFloat64(fmu, vrs, n, values, n);
+    case fmi3DataTypeFloat32:   return fmi3_getFloat32(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt64:     return fmi3_getInt64(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt32:     return fmi3_getInt32(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt16:     return fmi3_getInt16(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt8:      return fmi3_getInt8(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt64:    return fmi3_getUInt64(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt32:    return fmi3_getUInt32(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt16:    return fmi3_getUInt16(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt8:     return fmi3_getUInt8(fmu, vrs, n, values, n);
+    case fmi3DataTypeBoolean:   return fmi3_getBoolean(fmu, vrs, n, values, n);
+    case fmi3DataTypeString:    return fmi3_getString(fmu, vrs, n, values, n);
+    case fmi3DataTypeBinary:    return fmi3_getBinary(fmu, vrs, n, group->sourceValueSizes, values, n);
+    default:                    return fmi3Error;
+    }
+}
+
+
+//! @brief Sets all destination values of an FMI 3 transfer group
+static fmi3Status setTransferValuesFmi3(fmiHandle *fmu, fmiTransferGroup *group, const void *values)
+{
+    const fmi3ValueReference *vrs = group->destinationValueReferences;
+    size_t n = (size_t)group->numberOfDestinations;
+    switch(group->dataType) {
+    case fmi3DataTypeFloat64:   return fmi3_setFloat64(fmu, vrs, n, (fmi3Float64*)values, n);
+    case fmi3DataTypeFloat32:   return fmi3_setFloat32(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt64:     return fmi3_setInt64(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt32:     return fmi3_setInt32(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt16:     return fmi3_setInt16(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt8:      return fmi3_setInt8(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt64:    return fmi3_setUInt64(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt32:    return fmi3_setUInt32(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt16:    return fmi3_setUInt16(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt8:     return fmi3_setUInt8(fmu, vrs, n, values, n);
+    case fmi3DataTypeBoolean:   return fmi3_setBoolean(fmu, vrs, n, values, n);
+    case fmi3DataTypeString:    return fmi3_setString(fmu, vrs, n, values, n);
+    case fmi3DataTypeBinary:    return fmi3_setBinary(fmu, vrs, n, group->direct ? group->sourceValueSizes : group->destinationValueSizes, values, n);
+    default:                    return fmi3Error;
+    }
+}
+
+
+//! @brief Executes an FMI 3 transfer plan
+//! @param plan Transfer plan
+//! @returns Worst status of all get and set calls, execution stops at the first error
+fmi3Status fmi3_executeTransferPlan(fmiTransferPlan *plan)
+{
+    fmi3Status worstStatus = fmi3OK;
+    for(int i=0; i<plan->numberOfGroups; ++i) {
+        fmiTransferGroup *group = &plan->groups[i];
+        fmi3Status status = getTransferValuesFmi3(plan->source, group);
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi3Error) {
+            return worstStatus;
+        }
+
+        status = setTransferValuesFmi3(plan->destination, group, gatherTransferValues(group));
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi3Error) {
+            return worstStatus;
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief Returns the GUID (FMI 2) or instantiation token (FMI 3) that identifies the model description of an FMU
+static const char *getModelToken(fmiHandle *fmu)
+{
+    const char *token = (fmu->version == fmiVersion2) ? fmu->fmi2.guid : fmu->fmi3.instantiationToken;
+    return token ? token : "";
+}
+
+
+//! @brief Creates an empty parameter set, for applying values to instances of an FMU in bulk (e.g. start values before each run)
+//! Add values by variable name with fmi2_addParameter() or fmi3_addParameter(), which resolve the names once. Then apply
+//! the set to any instance of the same model with fmi2_applyParameterSet() or fmi3_applyParameterSet(), which do one set
+//! call per data type with the value references in ascending order.
+//! @param fmu FMU whose model description resolves the names, it must not be freed while parameters are added
+//! @returns Parameter set, or NULL if the FMU is not an FMI 2 or 3 FMU
+fmiParameterSet *fmi4c_createParameterSet(fmiHandle *fmu)
+{
+    if(fmu->version != fmiVersion2 && fmu->version != fmiVersion3) {
+        printf("Parameter sets require an FMI 2 or FMI 3 FMU.\n");
+        return NULL;
+    }
+
+    fmiParameterSet *set = fmi4cMalloc(sizeof(fmiParameterSet));
+    set->fmu = fmu;
+    set->version = fmu->version;
+    set->token = fmi4cStrdup(getModelToken(fmu));
+    set->numberOfGroups = 0;
+    set->groups = NULL;
+    return set;
+}
+
+
+//! @brief Returns true for the groups of a parameter set that hold string values, which are owned by the set
+static bool isStringParameterGroup(const fmiParameterSet *set, const fmiParameterGroup *group)
+{
+    return (set->version == fmiVersion2) ? (group->dataType == fmi2DataTypeString) : (group->dataType == fmi3DataTypeString);
+}
+
+
+//! @brief Frees a parameter set and its values
+//! @param set Parameter set
+void fmi4c_freeParameterSet(fmiParameterSet *set)
+{
+    for(int i=0; i<set->numberOfGroups; ++i) {
+        fmiParameterGroup *group = &set->groups[i];
+        if(isStringParameterGroup(set, group)) {
+            for(size_t j=0; j<group->totalNumberOfValues; ++j) {
+                fmi4cFree(((char**)group->values)[j]);
+            }
+        }
+        fmi4cFree(group->valueReferences);
+        fmi4cFree(group->numberOfValues);
+        fmi4cFree(group->values);
+    }
+    fmi4cFree(set->groups);
+    fmi4cFree(set->token);
+    fmi4cFree(set);
+}
+
+
+//! @brief Copies values into the values of a parameter group, strings are duplicated
+static void copyParameterValues(char *target, const void *values, size_t nValues, size_t valueSize, bool strings)
+{
+    if(strings) {
+        for(size_t i=0; i<nValues; ++i) {
+            ((char**)target)[i] = fmi4cStrdup(((const char* const*)values)[i]);
+        }
+    }
+    else {
+        memcpy(target, values, nValues*valueSize);
+    }
+}
+
+
+//! @brief Adds the values of one variable to the group of its data type, keeping the group sorted by value reference
+//! Values of a variable that is already in the set are replaced.
+//! @param set Parameter set
+//! @param dataType Data type (fmi2DataType or fmi3DataType)
+//! @param valueSize Size of one value of the data type
+//! @param valueReference Value reference of the variable
+//! @param values Values of the variable
+//! @param nValues Number of values, more than one for FMI 3 arrays
+static void addParameter(fmiParameterSet *set, int dataType, size_t valueSize, fmi3ValueReference valueReference,
+                         const void *values, size_t nValues)
+{
+    fmiParameterGroup *group = NULL;
+    for(int i=0; i<set->numberOfGroups; ++i) {
+        if(set->groups[i].dataType == dataType) {
+            group = &set->groups[i];
+        }
+    }
+    if(group == NULL) {
+        set->groups = fmi4cRealloc(set->groups, (set->numberOfGroups+1)*sizeof(fmiParameterGroup));
+        group = &set->groups[set->numberOfGroups++];
+        memset(group, 0, sizeof(fmiParameterGroup));
+        group->dataType = dataType;
+        group->valueSize = valueSize;
+    }
+    bool strings = isStringParameterGroup(set, group);
+
+    //Find the position of the value reference
+    int low = 0;
+    int high = group->numberOfValueReferences;
+    while(low < high) {
+        int middle = (low+high)/2;
+        if(group->valueReferences[middle] < valueReference) {
+            low = middle+1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    int position = low;
+    size_t offset = 0;
+    for(int i=0; i<position; ++i) {
+        offset += group->numberOfValues[i];
+    }
+
+    if(position < group->numberOfValueReferences && group->valueReferences[position] == valueReference &&
+       group->numberOfValues[position] == nValues) {
+        char *target = group->values+offset*valueSize;
+        if(strings) {
+            for(size_t i=0; i<nValues; ++i) {
+                fmi4cFree(((char**)target)[i]);
+            }
+        }
+        copyParameterValues(target, values, nValues, valueSize, strings);
+        return;
+    }
+
+    if(group->numberOfValueReferences >= group->capacity) {
+        group->capacity = (group->capacity > 0) ? 2*group->capacity : 8;
+        group->valueReferences = fmi4cRealloc(group->valueReferences, group->capacity*sizeof(fmi3ValueReference));
+        group->numberOfValues = fmi4cRealloc(group->numberOfValues, group->capacity*sizeof(size_t));
+    }
+    if(group->totalNumberOfValues+nValues > group->valuesCapacity) {
+        group->valuesCapacity = 2*group->valuesCapacity+nValues;
+        group->values = fmi4cRealloc(group->values, group->valuesCapacity*valueSize);
+    }
+
+    //Make room for the new value reference and its values
+    int numberAfter = group->numberOfValueReferences-position;
+    memmove(group->valueReferences+position+1, group->valueReferences+position, numberAfter*sizeof(fmi3ValueReference));
+    memmove(group->numberOfValues+position+1, group->numberOfValues+position, numberAfter*sizeof(size_t));
+    memmove(group->values+(offset+nValues)*valueSize, group->values+offset*valueSize, (group->totalNumberOfValues-offset)*valueSize);
+    group->valueReferences[position] = valueReference;
+    group->numberOfValues[position] = nValues;
+    copyParameterValues(group->values+offset*valueSize, values, nValues, valueSize, strings);
+    ++group->numberOfValueReferences;
+    group->totalNumberOfValues += nValues;
+}
+
+
+//! @brief Adds the value of a scalar variable to an FMI 2 parameter set
+//! @param set Parameter set
+//! @param name Variable name
+//! @param value Pointer to the value, of the data type of the variable (fmi2Real, fmi2Integer for enumerations,
+//! fmi2Boolean or fmi2String, which is copied)
+//! @returns True if successful
+bool fmi2_addParameter(fmiParameterSet *set, fmi2String name, const void *value)
+{
+    if(set->version != fmiVersion2) {
+        printf("Parameter set is not for FMI 2.\n");
+        return false;
+    }
+    fmi2VariableHandle *var = fmi2_getVariableByName(set->fmu, name);
+    if(var == NULL) {
+        return false;
+    }
+
+    fmi3ValueReference valueReference = (fmi3ValueReference)var->valueReference;
+    switch(var->datatype) {
+    case fmi2DataTypeReal:
+        addParameter(set, fmi2DataTypeReal, sizeof(fmi2Real), valueReference, value, 1);
+        return true;
+    case fmi2DataTypeInteger:
+    case fmi2DataTypeEnumeration:
+        addParameter(set, fmi2DataTypeInteger, sizeof(fmi2Integer), valueReference, value, 1);
+        return true;
+    case fmi2DataTypeBoolean:
+        addParameter(set, fmi2DataTypeBoolean, sizeof(fmi2Boolean), valueReference, value, 1);
+        return true;
+    case fmi2DataTypeString:
+        addParameter(set, fmi2DataTypeString, sizeof(fmi2String), valueReference, value, 1);
+        return true;
+    }
+    printf("Unknown data type of variable %s\n", name);
+    return false;
+}
+
+
+//! @brief Applies an FMI 2 parameter set to an FMU, with one set call per data type
+//! @param fmu FMU handle, an instance of the model the set was created for
+//! @param set Parameter set, which is not modified, so it can be applied to several FMUs concurrently
+//! @returns Worst status of all set calls, applying stops at the first error
+fmi2Status fmi2_applyParameterSet(fmiHandle *fmu, const fmiParameterSet *set)
+{
+    if(fmu->version != fmiVersion2 || set->version != fmiVersion2 || strcmp(getModelToken(fmu), set->token)) {
+        printf("Parameter set is not for this model.\n");
+        return fmi2Error;
+    }
+
+    fmi2Status worstStatus = fmi2OK;
+    for(int i=0; i<set->numberOfGroups; ++i) {
+        const fmiParameterGroup *group = &set->groups[i];
+        const fmi2ValueReference *vrs = group->valueReferences;
+        size_t n = (size_t)group->numberOfValueReferences;
+        fmi2Status status = fmi2Error;
+        switch(group->dataType) {
+        case fmi2DataTypeReal:
+            status = fmi2_setReal(fmu, vrs, n, (const fmi2Real*)group->values);
+            break;
+        case fmi2DataTypeInteger:
+            status = fmi2_setInteger(fmu, vrs, n, (const fmi2Integer*)group->values);
+            break;
+        case fmi2DataTypeBoolean:
+            status = fmi2_setBoolean(fmu, vrs, n, (const fmi2Boolean*)group->values);
+            break;
+        case fmi2DataTypeString:
+            status = fmi2_setString(fmu, vrs, n, (const fmi2String*)group->values);
+            break;
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi2Error) {
+            return worstStatus;
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief Adds the values of a variable to an FMI 3 parameter set
+//! @param set Parameter set
+//! @param name Variable name
+//! @param values Values, of the data type of the variable (enumerations as fmi3Int64, strings are copied, binaries and
+//! clocks are not supported), with array variables in row-major order
+//! @param nValues Number of values, must match the current size of array variables
+//! @returns True if successful
+bool fmi3_addParameter(fmiParameterSet *set, fmi3String name, const void *values, size_t nValues)
+{
+    if(set->version != fmiVersion3) {
+        printf("Parameter set is not for FMI 3.\n");
+        return false;
+    }
+    fmi3VariableHandle *var = fmi3_getVariableByName(set->fmu, name);
+    size_t size;
+    if(var == NULL || !fmi3_getVariableNumberOfValues(set->fmu, var, &size)) {
+        return false;
+    }
+    if(size != nValues) {
+        printf("Variable %s has %zu values, not %zu\n", name, size, nValues);
+        return false;
+    }
+
+    fmi3DataType dataType = var->datatype;
+    size_t valueSize;
+    switch(dataType) {
+    case fmi3DataTypeFloat64:       valueSize = sizeof(fmi3Float64); break;
+    case fmi3DataTypeFloat32:       valueSize = sizeof(fmi3Float32); break;
+    case fmi3DataTypeInt64:         valueSize = sizeof(fmi3Int64); break;
+    case fmi3DataTypeEnumeration:   valueSize = sizeof(fmi3Int64); dataType = fmi3DataTypeInt64; break;
+    case fmi3DataTypeInt32:         valueSize = sizeof(fmi3Int32); break;
+    case fmi3DataTypeInt16:         valueSize = sizeof(fmi3Int16); break;
+    case fmi3DataTypeInt8:          valueSize = sizeof(fmi3Int8); break;
+    case fmi3DataTypeUInt64:        valueSize = sizeof(fmi3UInt64); break;
+    case fmi3DataTypeUInt32:        valueSize = sizeof(fmi3UInt32); break;
+    case fmi3DataTypeUInt16:        valueSize = sizeof(fmi3UInt16); break;
+    case fmi3DataTypeUInt8:         valueSize = sizeof(fmi3UInt8); break;
+    case fmi3DataTypeBoolean:       valueSize = sizeof(fmi3Boolean); break;
+    case fmi3DataTypeString:        valueSize = sizeof(fmi3String); break;
+    default:
+        printf("Data type of variable %s is not supported in parameter sets\n", name);
+        return false;
+    }
+
+    addParameter(set, dataType, valueSize, var->valueReference, values, nValues);
+    return true;
+}
+
+
+//! @brief Sets all values of an FMI 3 parameter group
+static fmi3Status setParameterValuesFmi3(fmiHandle *fmu, const fmiParameterGroup *group)
+{
+    const fmi3ValueReference *vrs = group->valueReferences;
+    size_t n = (size_t)group->numberOfValueReferences;
+    size_t nValues = group->totalNumberOfValues;
+    const void *values = group->values;
+    switch(group->dataType) {
+    case fmi3DataTypeFloat64:   return fmi3_setFloat64(fmu, vrs, n, (fmi3Float64*)values, nValues);
+    case fmi3DataTypeFloat32:   return fmi3_setFloat32(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeInt64:     return fmi3_setInt64(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeInt32:     return fmi3_setInt32(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeInt16:     return fmi3_setInt16(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeInt8:      return fmi3_setInt8(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeUInt64:    return fmi3_setUInt64(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeUInt32:    return fmi3_setUInt32(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeUInt16:    return fmi3_setUInt16(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeUInt8:     return fmi3_setUInt8(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeBoolean:   return fmi3_setBoolean(fmu, vrs, n, values, nValues);
+    case fmi3DataTypeString:    return fmi3_setString(fmu, vrs, n, values, nValues);
+    default:                    return fmi3Error;
+    }
+}
+
+
+//! @brief Applies an FMI 3 parameter set to an FMU, with one set call per data type
+//! @param fmu FMU handle, an instance of the model the set was created for
+//! @param set Parameter set, which is not modified, so it can be applied to several FMUs concurrently
+//! @returns Worst status of all set calls, applying stops at the first error
+fmi3Status fmi3_applyParameterSet(fmiHandle *fmu, const fmiParameterSet *set)
+{
+    if(fmu->version != fmiVersion3 || set->version != fmiVersion3 || strcmp(getModelToken(fmu), set->token)) {
+        printf("Parameter set is not for this model.\n");
+        return fmi3Error;
+    }
+
+    fmi3Status worstStatus = fmi3OK;
+    for(int i=0; i<set->numberOfGroups; ++i) {
+        fmi3Status status = setParameterValuesFmi3(fmu, &set->groups[i]);
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi3Error) {
+            return worstStatus;
+        }
+    }
+    return worstStatus;
+}
+
+
+static int compareArrayLayoutEntries(const void *a, const void *b)
+{
+    fmi3ValueReference vrA = ((const fmiArrayLayoutEntry*)a)->valueReference;
+    fmi3ValueReference vrB = ((const fmiArrayLayoutEntry*)b)->valueReference;
+    return (vrA > vrB) - (vrA < vrB);
+}
+
+
+//! @brief Creates a layout for reading and writing the flattened values of FMI 3 variables in one call
+//! The values of each variable are stored after each other in the order of the value references, with array
+//! variables in row-major order. Sizes given by structural parameters are resolved when the layout is
+//! created, so a new layout is needed if they are changed.
+//! @param fmu FMU handle
+//! @param valueReferences Value references of scalar or array variables with the same data type
+//! @param nValueReferences Number of value references
+//! @returns New layout, or NULL on failure
+fmiArrayLayout *fmi3_createArrayLayout(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences)
+{
+    if(fmu->version != fmiVersion3) {
+        printf("Array layouts require an FMI 3 FMU.\n");
+        return NULL;
+    }
+
+    fmiArrayLayout *layout = fmi4cMalloc(sizeof(fmiArrayLayout));
+    layout->fmu = fmu;
+    layout->dataType = fmi3DataTypeFloat64;
+    layout->numberOfValueReferences = nValueReferences;
+    layout->valueReferences = fmi4cMalloc(nValueReferences*sizeof(fmi3ValueReference));
+    layout->entries = fmi4cMalloc(nValueReferences*sizeof(fmiArrayLayoutEntry));
+    layout->numberOfValues = 0;
+    for(size_t i=0; i<nValueReferences; ++i) {
+        fmi3VariableHandle *var = fmi3_getVariableByValueReference(fmu, valueReferences[i]);
+        size_t size;
+        if(var == NULL || !fmi3_getVariableNumberOfValues(fmu, var, &size)) {
+            fmi3_freeArrayLayout(layout);
+            return NULL;
+        }
+        fmi3DataType dataType = (var->datatype == fmi3DataTypeEnumeration) ? fmi3DataTypeInt64 : var->datatype;
+        if(dataType == fmi3DataTypeBinary || dataType == fmi3DataTypeClock) {
+            printf("Data type of variable %s is not supported in array layouts\n", var->name);
+            fmi3_freeArrayLayout(layout);
+            return NULL;
+        }
+        if(i == 0) {
+            layout->dataType = dataType;
+        }
+        else if(dataType != layout->dataType) {
+            printf("Variable %s does not have the same data type as the other variables in the array layout\n", var->name);
+            fmi3_freeArrayLayout(layout);
+            return NULL;
+        }
+        layout->valueReferences[i] = valueReferences[i];
+        layout->entries[i].valueReference = valueReferences[i];
+        layout->entries[i].offset = layout->numberOfValues;
+        layout->entries[i].size = size;
+        layout->numberOfValues += size;
+    }
+    qsort(layout->entries, nValueReferences, sizeof(fmiArrayLayoutEntry), compareArrayLayoutEntries);
+    return layout;
+}
+
+
+//! @brief Frees an array layout
+//! @param layout Array layout
+void fmi3_freeArrayLayout(fmiArrayLayout *layout)
+{
+    fmi4cFree(layout->valueReferences);
+    fmi4cFree(layout->entries);
+    fmi4cFree(layout);
+}
+
+
+//! @brief Returns the total number of values in an array layout
+//! @param layout Array layout
+//! @returns Number of values to allocate for fmi3_getArrayValues() and fmi3_setArrayValues()
+size_t fmi3_getArrayLayoutNumberOfValues(fmiArrayLayout *layout)
+{
+    return layout->numberOfValues;
+}
+
+
+//! @brief Returns the data type of the values in an array layout
+//! @param layout Array layout
+//! @returns Data type, with enumerations as fmi3DataTypeInt64
+fmi3DataType fmi3_getArrayLayoutDataType(fmiArrayLayout *layout)
+{
+    return layout->dataType;
+}
+
+
+//! @brief Finds the values of one variable in an array layout
+//! @param layout Array layout
+//! @param valueReference Value reference of a variable in the layout
+//! @param offset Returns the index of the first value of the variable
+//! @param size Returns the number of values of the variable
+//! @returns True if the variable is in the layout
+bool fmi3_getArrayLayoutEntry(fmiArrayLayout *layout, fmi3ValueReference valueReference, size_t *offset, size_t *size)
+{
+    fmiArrayLayoutEntry key;
+    key.valueReference = valueReference;
+    fmiArrayLayoutEntry *entry = bsearch(&key, layout->entries, layout->numberOfValueReferences, sizeof(fmiArrayLayoutEntry), compareArrayLayoutEntries);
+    if(entry == NULL) {
+        return false;
+    }
+    (*offset) = entry->offset;
+    (*size) = entry->size;
+    return true;
+}
+
+
+//! @brief Gets the values of all variables in an array layout with one get call
+//! @param layout Array layout
+//! @param values Array of fmi3_getArrayLayoutNumberOfValues() values of the layout data type, filled in directly by the FMU
+//! @returns Status of the get call
+fmi3Status fmi3_getArrayValues(fmiArrayLayout *layout, void *values)
+{
+    fmiHandle *fmu = layout->fmu;
+    const fmi3ValueReference *vrs = layout->valueReferences;
+    size_t nvr = layout->numberOfValueReferences;
+    size_t n = layout->numberOfValues;
+    switch(layout->dataType) {
+    case fmi3DataTypeFloat64:   return fmi3_getFloat64(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeFloat32:   return fmi3_getFloat32(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt64:     return fmi3_getInt64(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt32:     return fmi3_getInt32(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt16:     return fmi3_getInt16(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt8:      return fmi3_getInt8(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt64:    return fmi3_getUInt64(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt32:    return fmi3_getUInt32(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt16:    return fmi3_getUInt16(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt8:     return fmi3_getUInt8(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeBoolean:   return fmi3_getBoolean(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeString:    return fmi3_getString(fmu, vrs, nvr, values, n);
+    default:                    return fmi3Error;
+    }
+}
+
+
+//! @brief Sets the values of all variables in an array layout with one set call
+//! @param layout Array layout
+//! @param values Array of fmi3_getArrayLayoutNumberOfValues() values of the layout data type
+//! @returns Status of the set call
+fmi3Status fmi3_setArrayValues(fmiArrayLayout *layout, const void *values)
+{
+    fmiHandle *fmu = layout->fmu;
+    const fmi3ValueReference *vrs = layout->valueReferences;
+    size_t nvr = layout->numberOfValueReferences;
+    size_t n = layout->numberOfValues;
+    switch(layout->dataType) {
+    case fmi3DataTypeFloat64:   return fmi3_setFloat64(fmu, vrs, nvr, (fmi3Float64*)values, n);
+    case fmi3DataTypeFloat32:   return fmi3_setFloat32(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt64:     return fmi3_setInt64(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt32:     return fmi3_setInt32(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt16:     return fmi3_setInt16(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeInt8:      return fmi3_setInt8(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt64:    return fmi3_setUInt64(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt32:    return fmi3_setUInt32(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt16:    return fmi3_setUInt16(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeUInt8:     return fmi3_setUInt8(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeBoolean:   return fmi3_setBoolean(fmu, vrs, nvr, values, n);
+    case fmi3DataTypeString:    return fmi3_setString(fmu, vrs, nvr, values, n);
+    default:                    return fmi3Error;
+    }
+}
+
+
+//! @brief Creates a recorder for intermediate values of an FMI 3 Co-Simulation FMU
+//! Pass the recorder as instance environment and fmi3_recordIntermediateUpdate() as intermediate update callback
+//! to fmi3_instantiateCoSimulation() (the log message callback then also gets the recorder as environment).
+//! Each time the FMU allows intermediate variables to be read during fmi3_doStep(), the values are read with one
+//! get call per data type directly into the next sample of a preallocated ring buffer. If the buffer is full, new
+//! samples are dropped, and early return is requested if the FMU allows it, so that the buffer can be emptied.
+//! @param fmu FMU handle (FMI 3)
+//! @param valueReferences Value references of scalar or array variables to record (not strings, binaries or clocks)
+//! @param nValueReferences Number of value references
+//! @param capacity Maximum number of samples in the buffer
+//! @returns New recorder, or NULL on failure
+fmiIntermediateRecorder *fmi3_createIntermediateRecorder(fmiHandle *fmu, const fmi3ValueReference valueReferences[], size_t nValueReferences, int capacity)
+{
+    if(fmu->version != fmiVersion3) {
+        printf("Intermediate recorders require an FMI 3 FMU.\n");
+        return NULL;
+    }
+
+    //Group value references by data type, keeping their order
+    fmi3ValueReference *groupValueReferences = fmi4cMalloc((nValueReferences+1)*sizeof(fmi3ValueReference));
+    fmi3DataType *dataTypes = fmi4cMalloc((nValueReferences+1)*sizeof(fmi3DataType));
+    for(size_t i=0; i<nValueReferences; ++i) {
+        fmi3VariableHandle *var = fmi3_getVariableByValueReference(fmu, valueReferences[i]);
+        if(var == NULL) {
+            fmi4cFree(groupValueReferences);
+            fmi4cFree(dataTypes);
+            return NULL;
+        }
+        dataTypes[i] = (var->datatype == fmi3DataTypeEnumeration) ? fmi3DataTypeInt64 : var->datatype;
+        if(dataTypes[i] == fmi3DataTypeString) {
+            printf("String variable %s cannot be recorded, its value is only valid during the callback\n", var->name);
+            fmi4cFree(groupValueReferences);
+            fmi4cFree(dataTypes);
+            return NULL;
+        }
+    }
+
+    fmiIntermediateRecorder *recorder = fmi4cCalloc(1, sizeof(fmiIntermediateRecorder));
+    recorder->fmu = fmu;
+    recorder->status = fmi3OK;
+    for(int type=0; type<FMI3_NUMBER_OF_DATA_TYPES; ++type) {
+        size_t n = 0;
+        for(size_t i=0; i<nValueReferences; ++i) {
+            if((int)dataTypes[i] == type) {
+                groupValueReferences[n++] = valueReferences[i];
+            }
+        }
+        if(n == 0) {
+            continue;
+        }
+        recorder->layouts[type] = fmi3_createArrayLayout(fmu, groupValueReferences, n);
+        if(recorder->layouts[type] == NULL) {
+            fmi4cFree(groupValueReferences);
+            fmi4cFree(dataTypes);
+            fmi3_freeIntermediateRecorder(recorder);
+            return NULL;
+        }
+        size_t valueSize;
+        switch(type) {
+        case fmi3DataTypeFloat64:   valueSize = sizeof(fmi3Float64); break;
+        case fmi3DataTypeFloat32:   valueSize = sizeof(fmi3Float32); break;
+        case fmi3DataTypeInt64:     valueSize = sizeof(fmi3Int64); break;
+        case fmi3DataTypeInt32:     valueSize = sizeof(fmi3Int32); break;
+        case fmi3DataTypeInt16:     valueSize = sizeof(fmi3Int16); break;
+        case fmi3DataTypeInt8:      valueSize = sizeof(fmi3Int8); break;
+        case fmi3DataTypeUInt64:    valueSize = sizeof(fmi3UInt64); break;
+        case fmi3DataTypeUInt32:    valueSize = sizeof(fmi3UInt32); break;
+        case fmi3DataTypeUInt16:    valueSize = sizeof(fmi3UInt16); break;
+        case fmi3DataTypeUInt8:     valueSize = sizeof(fmi3UInt8); break;
+        default:                    valueSize = sizeof(fmi3Boolean); break;
+        }
+        recorder->groupOffsets[type] = recorder->sampleSize;
+        recorder->sampleSize += (fmi3_getArrayLayoutNumberOfValues(recorder->layouts[type])*valueSize+7) & ~(size_t)7;
+    }
+    fmi4cFree(groupValueReferences);
+    fmi4cFree(dataTypes);
+
+    recorder->capacity = (capacity > 0) ? capacity : 1;
+    recorder->times = fmi4cMalloc(recorder->capacity*sizeof(double));
+    recorder->stepFinished = fmi4cMalloc(recorder->capacity*sizeof(bool));
+    recorder->values = fmi4cMalloc(recorder->capacity*recorder->sampleSize+1);
+    return recorder;
+}
+
+
+//! @brief Frees an intermediate recorder
+//! @param recorder Intermediate recorder
+void fmi3_freeIntermediateRecorder(fmiIntermediateRecorder *recorder)
+{
+    for(int type=0; type<FMI3_NUMBER_OF_DATA_TYPES; ++type) {
+        if(recorder->layouts[type] != NULL) {
+            fmi3_freeArrayLayout(recorder->layouts[type]);
+        }
+    }
+    fmi4cFree(recorder->times);
+    fmi4cFree(recorder->stepFinished);
+    fmi4cFree(recorder->values);
+    fmi4cFree(recorder);
+}
+
+
+//! @brief Intermediate update callback for FMUs instantiated with an intermediate recorder as instance environment
+void fmi3_recordIntermediateUpdate(fmi3InstanceEnvironment instanceEnvironment,
+                                   fmi3Float64 intermediateUpdateTime,
+                                   fmi3Boolean intermediateVariableSetRequested,
+                                   fmi3Boolean intermediateVariableGetAllowed,
+                                   fmi3Boolean intermediateStepFinished,
+                                   fmi3Boolean canReturnEarly,
+                                   fmi3Boolean *earlyReturnRequested,
+                                   fmi3Float64 *earlyReturnTime)
+{
+    UNUSED(intermediateVariableSetRequested);
+    fmiIntermediateRecorder *recorder = (fmiIntermediateRecorder*)instanceEnvironment;
+    (*earlyReturnRequested) = false;
+    if(!intermediateVariableGetAllowed) {
+        return;
+    }
+    if(recorder->count == recorder->capacity) {
+        ++recorder->numberOfDroppedSamples;
+        if(canReturnEarly) {
+            (*earlyReturnRequested) = true;
+            (*earlyReturnTime) = intermediateUpdateTime;
+        }
+        return;
+    }
+
+    int slot = (recorder->first+recorder->count) % recorder->capacity;
+    char *sample = recorder->values+slot*recorder->sampleSize;
+    for(int type=0; type<FMI3_NUMBER_OF_DATA_TYPES; ++type) {
+        if(recorder->layouts[type] == NULL) {
+            continue;
+        }
+        fmi3Status status = fmi3_getArrayValues(recorder->layouts[type], sample+recorder->groupOffsets[type]);
+        if(status > recorder->status) {
+            recorder->status = status;
+        }
+        if(status >= fmi3Error) {
+            ++recorder->numberOfDroppedSamples;
+            return;
+        }
+    }
+    recorder->times[slot] = intermediateUpdateTime;
+    recorder->stepFinished[slot] = intermediateStepFinished;
+    ++recorder->count;
+}
+
+
+//! @brief Returns the number of samples in the buffer of an intermediate recorder
+//! @param recorder Intermediate recorder
+//! @returns Number of samples, oldest first
+int fmi3_getNumberOfIntermediateSamples(fmiIntermediateRecorder *recorder)
+{
+    return recorder->count;
+}
+
+
+//! @brief Returns one sample of an intermediate recorder
+//! The values of each data type are laid out as in fmi3_getIntermediateRecorderLayout(), use
+//! fmi3_getArrayLayoutEntry() to find the values of a variable.
+//! @param recorder Intermediate recorder
+//! @param i Sample index, from 0 (oldest) to fmi3_getNumberOfIntermediateSamples()-1
+//! @param dataType Data type of the values to return (enumerations are recorded as Int64)
+//! @param time Returns the intermediate update time
+//! @param stepFinished Returns true if the sample was taken at the end of an internal step
+//! @returns Values of the data type, owned by the recorder and valid until the sample is removed, or NULL if no variables of the type are recorded
+const void *fmi3_getIntermediateSample(fmiIntermediateRecorder *recorder, int i, fmi3DataType dataType, double *time, bool *stepFinished)
+{
+    int slot = (recorder->first+i) % recorder->capacity;
+    (*time) = recorder->times[slot];
+    (*stepFinished) = recorder->stepFinished[slot];
+    if(dataType == fmi3DataTypeEnumeration) {
+        dataType = fmi3DataTypeInt64;
+    }
+    if((int)dataType < 0 || (int)dataType >= FMI3_NUMBER_OF_DATA_TYPES || recorder->layouts[dataType] == NULL) {
+        return NULL;
+    }
+    return recorder->values+slot*recorder->sampleSize+recorder->groupOffsets[dataType];
+}
+
+
+//! @brief Returns the layout of the recorded values of one data type
+//! @param recorder Intermediate recorder
+//! @param dataType Data type (enumerations are recorded as Int64)
+//! @returns Layout owned by the recorder, or NULL if no variables of the type are recorded
+fmiArrayLayout *fmi3_getIntermediateRecorderLayout(fmiIntermediateRecorder *recorder, fmi3DataType dataType)
+{
+    if(dataType == fmi3DataTypeEnumeration) {
+        dataType = fmi3DataTypeInt64;
+    }
+    if((int)dataType < 0 || (int)dataType >= FMI3_NUMBER_OF_DATA_TYPES) {
+        return NULL;
+    }
+    return recorder->layouts[dataType];
+}
+
+
+//! @brief Removes the oldest samples from an intermediate recorder
+//! Should be called between calls to fmi3_doStep(), the recorder is not synchronized with the FMU.
+//! @param recorder Intermediate recorder
+//! @param numberOfSamples Number of samples to remove, or -1 for all samples
+void fmi3_removeIntermediateSamples(fmiIntermediateRecorder *recorder, int numberOfSamples)
+{
+    if(numberOfSamples < 0 || numberOfSamples > recorder->count) {
+        numberOfSamples = recorder->count;
+    }
+    recorder->first = (recorder->first+numberOfSamples) % recorder->capacity;
+    recorder->count -= numberOfSamples;
+}
+
+
+//! @brief Returns the number of samples dropped because the buffer was full or a get call failed
+//! @param recorder Intermediate recorder
+//! @returns Number of dropped samples
+int64_t fmi3_getNumberOfDroppedIntermediateSamples(fmiIntermediateRecorder *recorder)
+{
+    return recorder->numberOfDroppedSamples;
+}
+
+
+//! @brief Returns the worst status of all get calls made by an intermediate recorder
+//! @param recorder Intermediate recorder
+//! @returns Worst status
+fmi3Status fmi3_getIntermediateRecorderStatus(fmiIntermediateRecorder *recorder)
+{
+    return recorder->status;
+}
+
+
+//! @brief Enables or disables call-level profiling of an FMU handle
+//! When enabled, the number of calls, the number of value references and the wall time of
+//! each wrapped FMU function are recorded. Statistics are kept when profiling is disabled.
+//! @param fmu FMU handle
+//! @param enabled True to enable profiling
+void fmi4c_setProfilingEnabled(fmiHandle *fmu, bool enabled)
+{
+    if(fmu->profile == NULL) {
+        if(!enabled) {
+            return;
+        }
+        fmu->profile = fmi4cCalloc(1, sizeof(fmiProfile));
+    }
+    fmu->profile->enabled = enabled;
+}
+
+
+//! @brief Clears all profiling statistics of an FMU handle
+//! @param fmu FMU handle
+void fmi4c_resetProfiling(fmiHandle *fmu)
+{
+    if(fmu->profile != NULL) {
+        bool enabled = fmu->profile->enabled;
+        memset(fmu->profile, 0, sizeof(fmiProfile));
+        fmu->profile->enabled = enabled;
+    }
+}
+
+
+//! @brief Returns the number of functions with profiling statistics
+//! @param fmu FMU handle
+//! @returns Number of profiled functions
+int fmi4c_getNumberOfProfiledFunctions(fmiHandle *fmu)
+{
+    if(fmu->profile == NULL) {
+        return 0;
+    }
+    return fmu->profile->numberOfFunctions;
+}
+
+
+//! @brief Returns the profiling statistics of one function
+//! @param fmu FMU handle
+//! @param i Function index, from 0 to fmi4c_getNumberOfProfiledFunctions()-1
+//! @param name Name of the fmi4c wrapper function
+//! @param numberOfCalls Number of calls
+//! @param numberOfValueReferences Total number of value references in all calls
+//! @param totalTime Total wall time in seconds
+//! @param maxTime Longest call in seconds
+//! @returns True if the function index exists
+bool fmi4c_getProfiledFunction(fmiHandle *fmu,
+                               int i,
+                               const char **name,
+                               uint64_t *numberOfCalls,
+                               uint64_t *numberOfValueReferences,
+                               double *totalTime,
+                               double *maxTime)
+{
+    if(fmu->profile == NULL || i < 0) {
+        return false;
+    }
+    for(int slot=0; slot<FMI4C_PROFILE_SLOTS; ++slot) {
+        fmiCallStatistics *statistics = &fmu->profile->functions[slot];
+        if(statistics->function != NULL && i-- == 0) {
+            *name = statistics->function;
+            *numberOfCalls = statistics->numberOfCalls;
+            *numberOfValueReferences = statistics->numberOfValueReferences;
+            *totalTime = statistics->totalTime;
+            *maxTime = statistics->maxTime;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//! @brief Writes the profiling statistics of an FMU handle to a JSON file
+//! @param fmu FMU handle
+//! @param path Path to output file
+//! @returns True if the file was written
+bool fmi4c_writeProfileToJson(fmiHandle *fmu, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if(file == NULL) {
+        printf("Failed to open profile file for writing: %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"instanceName\": \"%s\",\n  \"functions\": [", fmu->instanceName);
+    const char *separator = "";
+    for(int slot=0; fmu->profile != NULL && slot<FMI4C_PROFILE_SLOTS; ++slot) {
+        fmiCallStatistics *statistics = &fmu->profile->functions[slot];
+        if(statistics->function == NULL) {
+            continue;
+        }
+        fprintf(file, "%s\n    { \"name\": \"%s\", \"calls\": %llu, \"valueReferences\": %llu, \"totalTime\": %.9g, \"maxTime\": %.9g }",
+                separator,
+                statistics->function,
+                (unsigned long long)statistics->numberOfCalls,
+                (unsigned long long)statistics->numberOfValueReferences,
+                statistics->totalTime,
+                statistics->maxTime);
+        separator = ",";
+    }
+    fprintf(file, "\n  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+
+//! @brief Checks a state capability flag for all supported FMU kinds
+//! @param fmu FMU handle
+//! @param serialize True to check canSerializeFMUState, false to check canGetAndSetFMUState
+//! @returns True if any supported FMU kind has the capability
+static bool getStateCapability(fmiHandle *fmu, bool serialize)
+{
+    if(fmu->version == fmiVersion2) {
+        return (fmu->fmi2.supportsCoSimulation && (serialize ? fmu->fmi2.cs.canSerializeFMUState : fmu->fmi2.cs.canGetAndSetFMUState)) ||
+               (fmu->fmi2.supportsModelExchange && (serialize ? fmu->fmi2.me.canSerializeFMUState : fmu->fmi2.me.canGetAndSetFMUState));
+    }
+    else if(fmu->version == fmiVersion3) {
+        return (fmu->fmi3.supportsCoSimulation && (serialize ? fmu->fmi3.cs.canSerializeFMUState : fmu->fmi3.cs.canGetAndSetFMUState)) ||
+               (fmu->fmi3.supportsModelExchange && (serialize ? fmu->fmi3.me.canSerializeFMUState : fmu->fmi3.me.canGetAndSetFMUState)) ||
+               (fmu->fmi3.supportsScheduledExecution && (serialize ? fmu->fmi3.se.canSerializeFMUState : fmu->fmi3.se.canGetAndSetFMUState));
+    }
+    return false;
+}
+
+
+//! @brief Creates a pool of reusable FMU state snapshots, for repeated rollback without allocating new FMU states
+//! The pool keeps the latest numberOfSlots checkpoints. Each slot keeps its FMU state, which the FMU
+//! overwrites in place when a new checkpoint is saved to it. If serialize is true, the FMU states are
+//! instead serialized into reused buffers, so that only one FMU state is ever allocated.
+//! @param fmu FMU handle (FMI 2 or 3), must be instantiated before saving snapshots
+//! @param numberOfSlots Number of checkpoints to keep
+//! @param serialize True to store serialized states (requires canSerializeFMUState)
+//! @returns Snapshot pool, or NULL if the FMU cannot get and set (or serialize) its state
+fmiSnapshotPool *fmi4c_createSnapshotPool(fmiHandle *fmu, int numberOfSlots, bool serialize)
+{
+    if(fmu->version != fmiVersion2 && fmu->version != fmiVersion3) {
+        printf("Snapshot pools are only supported for FMI 2 and FMI 3\n");
+        return NULL;
+    }
+    if(!getStateCapability(fmu, false) || (serialize && !getStateCapability(fmu, true))) {
+        printf("FMU does not support %s its state: %s\n", serialize ? "serializing" : "getting and setting", fmu->instanceName);
+        return NULL;
+    }
+    if(numberOfSlots < 1) {
+        printf("Snapshot pool must have at least one slot\n");
+        return NULL;
+    }
+
+    fmiSnapshotPool *pool = fmi4cMalloc(sizeof(fmiSnapshotPool));
+    pool->fmu = fmu;
+    pool->serialize = serialize;
+    pool->workState = NULL;
+    pool->nextCheckpoint = 0;
+    pool->numberOfSlots = numberOfSlots;
+    pool->slots = fmi4cCalloc(numberOfSlots, sizeof(fmiSnapshot));
+    for(int i=0; i<numberOfSlots; ++i) {
+        pool->slots[i].checkpoint = -1;
+    }
+    return pool;
+}
+
+
+//! @brief Frees a snapshot pool and all FMU states it holds
+//! The FMU must still be instantiated.
+//! @param pool Snapshot pool
+void fmi4c_freeSnapshotPool(fmiSnapshotPool *pool)
+{
+    for(int i=0; i<pool->numberOfSlots; ++i) {
+        if(pool->slots[i].state != NULL) {
+            if(pool->fmu->version == fmiVersion2) {
+                fmi2_freeFMUstate(pool->fmu, &pool->slots[i].state);
+            }
+            else {
+                fmi3_freeFMUState(pool->fmu, &pool->slots[i].state);
+            }
+        }
+        fmi4cFree(pool->slots[i].buffer);
+    }
+    if(pool->workState != NULL) {
+        if(pool->fmu->version == fmiVersion2) {
+            fmi2_freeFMUstate(pool->fmu, &pool->workState);
+        }
+        else {
+            fmi3_freeFMUState(pool->fmu, &pool->workState);
+        }
+    }
+    fmi4cFree(pool->slots);
+    fmi4cFree(pool);
+}
+
+
+//! @brief Gets the current FMU state into an existing (or new) FMU state
+//! @param fmu FMU handle
+//! @param state FMU state, updated in place by the FMU if not NULL
+//! @returns True on success
+static bool getSnapshotState(fmiHandle *fmu, void **state)
+{
+    if(fmu->version == fmiVersion2) {
+        return fmi2_getFMUstate(fmu, state) <= fmi2Warning;
+    }
+    return fmi3_getFMUState(fmu, state) <= fmi3Warning;
+}
+
+
+//! @brief Serializes an FMU state into a slot buffer, which only grows if the state does not fit
+//! @param fmu FMU handle
+//! @param state FMU state
+//! @param slot Snapshot slot
+//! @returns True on success
+static bool serializeSnapshotState(fmiHandle *fmu, void *state, fmiSnapshot *slot)
+{
+    size_t size;
+    if(fmu->version == fmiVersion2) {
+        if(fmi2_serializedFMUstateSize(fmu, state, &size) > fmi2Warning) {
+            return false;
+        }
+    }
+    else if(fmi3_serializedFMUStateSize(fmu, state, &size) > fmi3Warning) {
+        return false;
+    }
+
+    if(size > slot->capacity) {
+        char *buffer = fmi4cRealloc(slot->buffer, size);
+        if(buffer == NULL) {
+            printf("Failed to allocate %zu bytes for serialized FMU state\n", size);
+            return false;
+        }
+        slot->buffer = buffer;
+        slot->capacity = size;
+    }
+    slot->size = size;
+
+    if(fmu->version == fmiVersion2) {
+        return fmi2_serializeFMUstate(fmu, state, slot->buffer, size) <= fmi2Warning;
+    }
+    return fmi3_serializeFMUState(fmu, state, (fmi3Byte*)slot->buffer, size) <= fmi3Warning;
+}
+
+
+//! @brief Saves a checkpoint of the current FMU state, replacing the oldest checkpoint if all slots are used
+//! @param pool Snapshot pool
+//! @returns Checkpoint number, used to restore the checkpoint, or -1 on failure
+int64_t fmi4c_saveSnapshot(fmiSnapshotPool *pool)
+{
+    int64_t checkpoint = pool->nextCheckpoint;
+    fmiSnapshot *slot = &pool->slots[checkpoint % pool->numberOfSlots];
+    slot->checkpoint = -1;
+
+    if(pool->serialize) {
+        if(!getSnapshotState(pool->fmu, &pool->workState) ||
+           !serializeSnapshotState(pool->fmu, pool->workState, slot)) {
+            printf("Failed to save serialized FMU state: %s\n", pool->fmu->instanceName);
+            return -1;
+        }
+    }
+    else if(!getSnapshotState(pool->fmu, &slot->state)) {
+        printf("Failed to save FMU state: %s\n", pool->fmu->instanceName);
+        return -1;
+    }
+
+    slot->checkpoint = checkpoint;
+    ++pool->nextCheckpoint;
+    return checkpoint;
+}
+
+
+//! @brief Restores the FMU to a saved checkpoint
+//! The checkpoint is kept in the pool, so the FMU can be rolled back to it several times.
+//! @param pool Snapshot pool
+//! @param checkpoint Checkpoint number returned by fmi4c_saveSnapshot()
+//! @returns True on success, false if the checkpoint has been replaced or the FMU fails to restore it
+bool fmi4c_restoreSnapshot(fmiSnapshotPool *pool, int64_t checkpoint)
+{
+    if(checkpoint < 0 || pool->slots[checkpoint % pool->numberOfSlots].checkpoint != checkpoint) {
+        printf("Checkpoint %lld is not available in snapshot pool: %s\n", (long long)checkpoint, pool->fmu->instanceName);
+        return false;
+    }
+
+    fmiSnapshot *slot = &pool->slots[checkpoint % pool->numberOfSlots];
+    fmiHandle *fmu = pool->fmu;
+    if(fmu->version == fmiVersion2) {
+        if(pool->serialize) {
+            return fmi2_deSerializeFMUstate(fmu, slot->buffer, slot->size, &pool->workState) <= fmi2Warning &&
+                   fmi2_setFMUstate(fmu, pool->workState) <= fmi2Warning;
+        }
+        return fmi2_setFMUstate(fmu, slot->state) <= fmi2Warning;
+    }
+    if(pool->serialize) {
+        return fmi3_deserializeFMUState(fmu, (const fmi3Byte*)slot->buffer, slot->size, &pool->workState) <= fmi3Warning &&
+               fmi3_setFMUState(fmu, pool->workState) <= fmi3Warning;
+    }
+    return fmi3_setFMUState(fmu, slot->state) <= fmi3Warning;
+}
+
+
+//! @brief Steps one FMU of a batch, using the doStep() function of its FMI version
+//! @param batch Step batch
+//! @param i FMU index in batch
+static void doStepInBatch(fmiStepBatch *batch, int i)
+{
+    fmiHandle *fmu = batch->fmus[i];
+    if(fmu->version == fmiVersion1) {
+        batch->statuses[i] = fmi1_doStep(fmu, batch->currentCommunicationPoint, batch->communicationStepSize, true);
+    }
+    else if(fmu->version == fmiVersion2) {
+        batch->statuses[i] = fmi2_doStep(fmu, batch->currentCommunicationPoint, batch->communicationStepSize, fmi2True);
+    }
+    else if(fmu->version == fmiVersion3) {
+        batch->statuses[i] = fmi3_doStep(fmu,
+                                         batch->currentCommunicationPoint,
+                                         batch->communicationStepSize,
+                                         true,
+                                         &batch->eventHandlingNeeded[i],
+                                         &batch->terminateSimulation[i],
+                                         &batch->earlyReturn[i],
+                                         &batch->lastSuccessfulTime[i]);
+    }
+    else {
+        batch->statuses[i] = fmi3Error;
+    }
+}
+
+
+//! @brief Worker for step pools, steps FMUs from queued batches until the pool is stopped
+#ifdef _WIN32
+static DWORD WINAPI stepPoolWorker(LPVOID data)
+#else
+static void *stepPoolWorker(void *data)
+#endif
+{
+    fmiStepPool *pool = data;
+
+    fmiMutexLock(&pool->mutex);
+    int core = pool->numberOfStartedThreads++;
+    fmiMutexUnlock(&pool->mutex);
+    if(pool->pinThreads && !setThreadAffinity(core)) {
+        printf("Failed to set affinity of step pool thread to core %i\n", core);
+    }
+
+    fmiMutexLock(&pool->mutex);
+    while(true) {
+        while(!pool->stop && pool->firstBatch == NULL) {
+            fmiConditionWait(&pool->workAvailable, &pool->mutex);
+        }
+        if(pool->firstBatch == NULL) {
+            break;  //Stopped, and all queued steps are finished
+        }
+        fmiStepBatch *batch = pool->firstBatch;
+        int i = batch->nextFmu++;
+        if(batch->nextFmu == batch->numberOfFmus) {
+            pool->firstBatch = batch->next;
+            if(pool->firstBatch == NULL) {
+                pool->lastBatch = NULL;
+            }
+        }
+        fmiMutexUnlock(&pool->mutex);
+
+        doStepInBatch(batch, i);
+
+        fmiMutexLock(&pool->mutex);
+        if(--batch->numberOfRemainingFmus == 0) {
+            fmiConditionBroadcast(&pool->stepFinished);
+        }
+    }
+    fmiMutexUnlock(&pool->mutex);
+    return 0;
+}
+
+
+//! @brief Creates a pool of worker threads for stepping FMUs concurrently
+//! Works like a fixed size thread pool (e.g. CTPL): threads are started once and wait for queued steps.
+//! @param numberOfThreads Number of worker threads (at least one is used)
+//! @param pinThreads Pin each worker thread to its own core
+//! @returns Step pool, or NULL if no thread could be started
+fmiStepPool *fmi4c_createStepPool(int numberOfThreads, bool pinThreads)
+{
+    if(numberOfThreads < 1) {
+        numberOfThreads = 1;
+    }
+
+    fmiStepPool *pool = fmi4cMalloc(sizeof(fmiStepPool));
+    pool->numberOfStartedThreads = 0;
+    pool->pinThreads = pinThreads;
+    pool->stop = false;
+    pool->firstBatch = NULL;
+    pool->lastBatch = NULL;
+    fmiMutexInit(&pool->mutex);
+    fmiConditionInit(&pool->workAvailable);
+    fmiConditionInit(&pool->stepFinished);
+
+    //Only count threads that were actually started
+    pool->numberOfThreads = 0;
+#ifdef _WIN32
+    pool->threads = fmi4cMalloc(numberOfThreads*sizeof(HANDLE));
+    for(int i=0; i<numberOfThreads; ++i) {
+        pool->threads[pool->numberOfThreads] = CreateThread(NULL, 0, stepPoolWorker, pool, 0, NULL);
+        if(pool->threads[pool->numberOfThreads] != NULL) {
+            ++pool->numberOfThreads;
+        }
+    }
+#else
+    pool->threads = fmi4cMalloc(numberOfThreads*sizeof(pthread_t));
+    for(int i=0; i<numberOfThreads; ++i) {
+        if(pthread_create(&pool->threads[pool->numberOfThreads], NULL, stepPoolWorker, pool) == 0) {
+            ++pool->numberOfThreads;
+        }
+    }
+#endif
+
+    if(pool->numberOfThreads == 0) {
+        printf("Failed to start any step pool threads\n");
+        fmi4c_freeStepPool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+
+//! @brief Frees a step pool, after finishing all queued steps
+//! Batches must still be freed with fmi4c_freeStepBatch().
+//! @param pool Step pool
+void fmi4c_freeStepPool(fmiStepPool *pool)
+{
+    fmiMutexLock(&pool->mutex);
+    pool->stop = true;
+    fmiConditionBroadcast(&pool->workAvailable);
+    fmiMutexUnlock(&pool->mutex);
+
+    for(int i=0; i<pool->numberOfThreads; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+    fmi4cFree(pool->threads);
+    fmiConditionDestroy(&pool->workAvailable);
+    fmiConditionDestroy(&pool->stepFinished);
+    fmiMutexDestroy(&pool->mutex);
+    fmi4cFree(pool);
+}
+
+
+//! @brief Starts a communication step for several FMUs concurrently, using the threads of a step pool
+//! Each FMU is stepped with the doStep() function of its FMI version, with newStep (FMI 1)
+//! and noSetFMUStatePriorToCurrentPoint (FMI 2 and 3) true. An FMU must not occur twice in the same
+//! batch, and must not be used by the caller until the batch has finished.
+//! @param pool Step pool
+//! @param numberOfFmus Number of FMUs
+//! @param fmus FMU handles (co-simulation), the array must remain valid until the batch has finished
+//! @param currentCommunicationPoint Current communication point for all FMUs
+//! @param communicationStepSize Communication step size for all FMUs
+//! @returns Completion handle, to be freed with fmi4c_freeStepBatch()
+fmiStepBatch *fmi4c_doStepsAsync(fmiStepPool *pool, int numberOfFmus, fmiHandle **fmus, double currentCommunicationPoint, double communicationStepSize)
+{
+    fmiStepBatch *batch = fmi4cMalloc(sizeof(fmiStepBatch));
+    batch->pool = pool;
+    batch->fmus = fmus;
+    batch->numberOfFmus = numberOfFmus;
+    batch->currentCommunicationPoint = currentCommunicationPoint;
+    batch->communicationStepSize = communicationStepSize;
+    batch->nextFmu = 0;
+    batch->numberOfRemainingFmus = numberOfFmus;
+    batch->statuses = fmi4cCalloc(numberOfFmus, sizeof(int));
+    batch->eventHandlingNeeded = fmi4cCalloc(numberOfFmus, sizeof(bool));
+    batch->terminateSimulation = fmi4cCalloc(numberOfFmus, sizeof(bool));
+    batch->earlyReturn = fmi4cCalloc(numberOfFmus, sizeof(bool));
+    batch->lastSuccessfulTime = fmi4cCalloc(numberOfFmus, sizeof(double));
+    batch->next = NULL;
+
+    if(numberOfFmus > 0) {
+        fmiMutexLock(&pool->mutex);
+        if(pool->lastBatch == NULL) {
+            pool->firstBatch = batch;
+        }
+        else {
+            pool->lastBatch->next = batch;
+        }
+        pool->lastBatch = batch;
+        fmiConditionBroadcast(&pool->workAvailable);
+        fmiMutexUnlock(&pool->mutex);
+    }
+    return batch;
+}
+
+
+//! @brief Checks if all FMUs in a batch have finished their step, without blocking
+//! @param batch Step batch
+//! @returns True if the batch has finished
+bool fmi4c_isStepBatchFinished(fmiStepBatch *batch)
+{
+    fmiMutexLock(&batch->pool->mutex);
+    bool finished = (batch->numberOfRemainingFmus == 0);
+    fmiMutexUnlock(&batch->pool->mutex);
+    return finished;
+}
+
+
+//! @brief Waits until all FMUs in a batch have finished their step
+//! @param batch Step batch
+//! @returns Worst status of all FMUs (statuses have the same values in all FMI versions)
+int fmi4c_waitForSteps(fmiStepBatch *batch)
+{
+    fmiMutexLock(&batch->pool->mutex);
+    while(batch->numberOfRemainingFmus > 0) {
+        fmiConditionWait(&batch->pool->stepFinished, &batch->pool->mutex);
+    }
+    fmiMutexUnlock(&batch->pool->mutex);
+
+    int worstStatus = 0;
+    for(int i=0; i<batch->numberOfFmus; ++i) {
+        if(batch->statuses[i] > worstStatus) {
+            worstStatus = batch->statuses[i];
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief Returns the doStep() status of one FMU in a finished batch
+//! @param batch Step batch
+//! @param i FMU index in batch
+//! @returns Status (fmi1Status, fmi2Status or fmi3Status depending on FMI version)
+int fmi4c_getStepStatus(fmiStepBatch *batch, int i)
+{
+    return batch->statuses[i];
+}
+
+
+//! @brief Returns the output arguments of fmi3_doStep() for one FMU in a finished batch
+//! @param batch Step batch
+//! @param i FMU index in batch
+//! @param eventHandlingNeeded Event handling needed
+//! @param terminateSimulation Terminate simulation
+//! @param earlyReturn Early return
+//! @param lastSuccessfulTime Last successful time
+void fmi4c_getStepResultFmi3(fmiStepBatch *batch, int i, bool *eventHandlingNeeded, bool *terminateSimulation, bool *earlyReturn, double *lastSuccessfulTime)
+{
+    *eventHandlingNeeded = batch->eventHandlingNeeded[i];
+    *terminateSimulation = batch->terminateSimulation[i];
+    *earlyReturn = batch->earlyReturn[i];
+    *lastSuccessfulTime = batch->lastSuccessfulTime[i];
+}
+
+
+//! @brief Waits for a batch to finish and frees it
+//! @param batch Step batch
+void fmi4c_freeStepBatch(fmiStepBatch *batch)
+{
+    fmi4c_waitForSteps(batch);
+    fmi4cFree(batch->statuses);
+    fmi4cFree(batch->eventHandlingNeeded);
+    fmi4cFree(batch->terminateSimulation);
+    fmi4cFree(batch->earlyReturn);
+    fmi4cFree(batch->lastSuccessfulTime);
+    fmi4cFree(batch);
+}
+
+
+//! @brief Frees a sparse Jacobian
+//! @param jacobian Sparse Jacobian
+void fmi3_freeSparseJacobian(fmiSparseJacobian *jacobian)
+{
+    fmi4cFree(jacobian->derivativeValueReferences);
+    fmi4cFree(jacobian->stateValueReferences);
+    fmi4cFree(jacobian->columnPointers);
+    fmi4cFree(jacobian->rowIndices);
+    fmi4cFree(jacobian->colorPointers);
+    fmi4cFree(jacobian->colorColumns);
+    fmi4cFree(jacobian->colorKnowns);
+    fmi4cFree(jacobian->unknownPointers);
+    fmi4cFree(jacobian->colorUnknowns);
+    fmi4cFree(jacobian->sensitivityIndices);
+    fmi4cFree(jacobian->seed);
+    fmi4cFree(jacobian->sensitivity);
+    fmi4cFree(jacobian);
+}
+
+
+//! @brief Creates a sparse Jacobian of the continuous state derivatives with respect to the continuous states
+//! The sparsity pattern is built from the dependencies of <ContinuousStateDerivative> elements in the
+//! ModelStructure (elements without a dependencies attribute are assumed to depend on all states,
+//! dependencies on other variables than states are ignored). Columns are colored so that columns of
+//! the same color have no common rows, which allows evaluating all of them with one directional
+//! derivative call. Rows and columns are ordered as the ContinuousStateDerivative elements.
+//! @param fmu FMU handle (FMI 3)
+//! @returns Sparse Jacobian, or NULL on failure
+fmiSparseJacobian *fmi3_createSparseJacobian(fmiHandle *fmu)
+{
+    if(fmu->version != fmiVersion3) {
+        printf("Sparse Jacobians are only supported for FMI 3\n");
+        return NULL;
+    }
+    if(!(fmu->fmi3.supportsModelExchange && fmu->fmi3.me.providesDirectionalDerivative) &&
+       !(fmu->fmi3.supportsCoSimulation && fmu->fmi3.cs.providesDirectionalDerivative)) {
+        printf("FMU does not provide directional derivatives: %s\n", fmu->instanceName);
+        return NULL;
+    }
+
+    int n = fmu->fmi3.numberOfContinuousStateDerivatives;
+    fmiSparseJacobian *jacobian = fmi4cCalloc(1, sizeof(fmiSparseJacobian));
+    jacobian->fmu = fmu;
+    jacobian->numberOfStates = n;
+    jacobian->derivativeValueReferences = fmi4cMalloc(n*sizeof(fmi3ValueReference));
+    jacobian->stateValueReferences = fmi4cMalloc(n*sizeof(fmi3ValueReference));
+
+    //Find the state of each derivative, and the column of each state variable
+    int *columnOfVariable = fmi4cMalloc(fmu->fmi3.numberOfVariables*sizeof(int));
+    for(int i=0; i<fmu->fmi3.numberOfVariables; ++i) {
+        columnOfVariable[i] = -1;
+    }
+    for(int i=0; i<n; ++i) {
+        jacobian->derivativeValueReferences[i] = fmu->fmi3.continuousStateDerivatives[i].valueReference;
+        int derivative = findVariableIndexByValueReference(&fmu->fmi3.variableIndex, jacobian->derivativeValueReferences[i]);
+        int state = (derivative < 0) ? -1 : findVariableIndexByValueReference(&fmu->fmi3.variableIndex, fmu->fmi3.variables[derivative].derivative);
+        if(state < 0) {
+            printf("Failed to find state of continuous state derivative with value reference %u\n", jacobian->derivativeValueReferences[i]);
+            fmi4cFree(columnOfVariable);
+            fmi3_freeSparseJacobian(jacobian);
+            return NULL;
+        }
+        jacobian->stateValueReferences[i] = (fmi3ValueReference)fmu->fmi3.variables[state].valueReference;
+        columnOfVariable[state] = i;
+    }
+
+    //Build row pattern, without duplicates
+    int *rowPointers = fmi4cMalloc((n+1)*sizeof(int));
+    int *marker = fmi4cMalloc(n*sizeof(int));
+    int capacity = n;
+    int *columnIndices = fmi4cMalloc(capacity*sizeof(int));
+    int numberOfNonZeros = 0;
+    for(int j=0; j<n; ++j) {
+        marker[j] = -1;
+    }
+    for(int i=0; i<n; ++i) {
+        rowPointers[i] = numberOfNonZeros;
+        fmi3ModelStructureElement *element = &fmu->fmi3.continuousStateDerivatives[i];
+        int numberOfDependencies = element->dependenciesDefined ? element->numberOfDependencies : n;
+        for(int k=0; k<numberOfDependencies; ++k) {
+            int column = k;
+            if(element->dependenciesDefined) {
+                int variable = findVariableIndexByValueReference(&fmu->fmi3.variableIndex, element->dependencies[k]);
+                column = (variable < 0) ? -1 : columnOfVariable[variable];
+            }
+            if(column < 0 || marker[column] == i) {
+                continue;
+            }
+            marker[column] = i;
+            if(numberOfNonZeros == capacity) {
+                capacity *= 2;
+                columnIndices = fmi4cRealloc(columnIndices, capacity*sizeof(int));
+            }
+            columnIndices[numberOfNonZeros++] = column;
+        }
+    }
+    rowPointers[n] = numberOfNonZeros;
+    fmi4cFree(columnOfVariable);
+
+    //Transpose into compressed sparse columns, with sorted row indices
+    jacobian->numberOfNonZeros = numberOfNonZeros;
+    jacobian->columnPointers = fmi4cCalloc(n+1, sizeof(int64_t));
+    jacobian->rowIndices = fmi4cMalloc((numberOfNonZeros > 0 ? numberOfNonZeros : 1)*sizeof(int64_t));
+    for(int k=0; k<numberOfNonZeros; ++k) {
+        ++jacobian->columnPointers[columnIndices[k]+1];
+    }
+    for(int j=0; j<n; ++j) {
+        jacobian->columnPointers[j+1] += jacobian->columnPointers[j];
+        marker[j] = (int)jacobian->columnPointers[j];
+    }
+    for(int i=0; i<n; ++i) {
+        for(int k=rowPointers[i]; k<rowPointers[i+1]; ++k) {
+            jacobian->rowIndices[marker[columnIndices[k]]++] = i;
+        }
+    }
+
+    //Greedy coloring of the column intersection graph
+    int *colors = fmi4cMalloc(n*sizeof(int));
+    for(int j=0; j<n; ++j) {
+        colors[j] = -1;
+        marker[j] = -1;     //Color c is forbidden for column j if marker[c] == j
+    }
+    jacobian->numberOfColors = 0;
+    for(int j=0; j<n; ++j) {
+        for(int64_t k=jacobian->columnPointers[j]; k<jacobian->columnPointers[j+1]; ++k) {
+            int64_t row = jacobian->rowIndices[k];
+            for(int kk=rowPointers[row]; kk<rowPointers[row+1]; ++kk) {
+                if(colors[columnIndices[kk]] >= 0) {
+                    marker[colors[columnIndices[kk]]] = j;
+                }
+            }
+        }
+        int color = 0;
+        while(marker[color] == j) {
+            ++color;
+        }
+        colors[j] = color;
+        if(color >= jacobian->numberOfColors) {
+            jacobian->numberOfColors = color+1;
+        }
+    }
+    fmi4cFree(rowPointers);
+    fmi4cFree(columnIndices);
+    fmi4cFree(marker);
+
+    //Group columns, and the rows they contain, by color
+    jacobian->colorPointers = fmi4cCalloc(jacobian->numberOfColors+1, sizeof(int));
+    jacobian->colorColumns = fmi4cMalloc((n > 0 ? n : 1)*sizeof(int));
+    jacobian->colorKnowns = fmi4cMalloc((n > 0 ? n : 1)*sizeof(fmi3ValueReference));
+    jacobian->unknownPointers = fmi4cCalloc(jacobian->numberOfColors+1, sizeof(int));
+    jacobian->colorUnknowns = fmi4cMalloc((numberOfNonZeros > 0 ? numberOfNonZeros : 1)*sizeof(fmi3ValueReference));
+    jacobian->sensitivityIndices = fmi4cMalloc((numberOfNonZeros > 0 ? numberOfNonZeros : 1)*sizeof(int));
+    for(int j=0; j<n; ++j) {
+        ++jacobian->colorPointers[colors[j]+1];
+        jacobian->unknownPointers[colors[j]+1] += (int)(jacobian->columnPointers[j+1]-jacobian->columnPointers[j]);
+    }
+    for(int c=0; c<jacobian->numberOfColors; ++c) {
+        jacobian->colorPointers[c+1] += jacobian->colorPointers[c];
+        jacobian->unknownPointers[c+1] += jacobian->unknownPointers[c];
+    }
+    int *nextColumn = fmi4cMalloc((jacobian->numberOfColors > 0 ? jacobian->numberOfColors : 1)*sizeof(int));
+    int *nextUnknown = fmi4cMalloc((jacobian->numberOfColors > 0 ? jacobian->numberOfColors : 1)*sizeof(int));
+    for(int c=0; c<jacobian->numberOfColors; ++c) {
+        nextColumn[c] = jacobian->colorPointers[c];
+        nextUnknown[c] = jacobian->unknownPointers[c];
+    }
+    for(int j=0; j<n; ++j) {
+        int c = colors[j];
+        jacobian->colorColumns[nextColumn[c]] = j;
+        jacobian->colorKnowns[nextColumn[c]++] = jacobian->stateValueReferences[j];
+        for(int64_t k=jacobian->columnPointers[j]; k<jacobian->columnPointers[j+1]; ++k) {
+            jacobian->colorUnknowns[nextUnknown[c]] = jacobian->derivativeValueReferences[jacobian->rowIndices[k]];
+            jacobian->sensitivityIndices[k] = nextUnknown[c]++ - jacobian->unknownPointers[c];
+        }
+    }
+    fmi4cFree(nextColumn);
+    fmi4cFree(nextUnknown);
+    fmi4cFree(colors);
+
+    jacobian->seed = fmi4cMalloc((n > 0 ? n : 1)*sizeof(fmi3Float64));
+    jacobian->sensitivity = fmi4cMalloc((n > 0 ? n : 1)*sizeof(fmi3Float64));
+    for(int j=0; j<n; ++j) {
+        jacobian->seed[j] = 1;
+    }
+
+    return jacobian;
+}
+
+
+//! @brief Returns the dimensions of a sparse Jacobian
+//! @param jacobian Sparse Jacobian
+//! @param numberOfStates Returns the number of rows and columns
+//! @param numberOfNonZeros Returns the number of structural non-zeros
+//! @param numberOfColors Returns the number of directional derivative calls per evaluation
+void fmi3_getSparseJacobianDimensions(fmiSparseJacobian *jacobian, int *numberOfStates, int *numberOfNonZeros, int *numberOfColors)
+{
+    *numberOfStates = jacobian->numberOfStates;
+    *numberOfNonZeros = jacobian->numberOfNonZeros;
+    *numberOfColors = jacobian->numberOfColors;
+}
+
+
+//! @brief Copies the compressed sparse column pattern of a sparse Jacobian
+//! The layout matches a SUNDIALS SUNSparseMatrix of type CSC_MAT with 64 bit indices, so the index
+//! arrays of such a matrix (with at least numberOfNonZeros capacity) can be passed directly.
+//! @param jacobian Sparse Jacobian
+//! @param columnPointers Returns column start indices (numberOfStates+1 elements)
+//! @param rowIndices Returns row indices (numberOfNonZeros elements)
+void fmi3_getSparseJacobianPattern(fmiSparseJacobian *jacobian, int64_t columnPointers[], int64_t rowIndices[])
+{
+    memcpy(columnPointers, jacobian->columnPointers, (jacobian->numberOfStates+1)*sizeof(int64_t));
+    memcpy(rowIndices, jacobian->rowIndices, jacobian->numberOfNonZeros*sizeof(int64_t));
+}
+
+
+//! @brief Evaluates a sparse Jacobian at the current state of the FMU, with one directional derivative call per color
+//! @param jacobian Sparse Jacobian
+//! @param values Returns the non-zero values in compressed sparse column order (numberOfNonZeros elements)
+//! @returns Worst status of the directional derivative calls
+fmi3Status fmi3_evaluateSparseJacobian(fmiSparseJacobian *jacobian, fmi3Float64 values[])
+{
+    fmi3Status worstStatus = fmi3OK;
+    for(int c=0; c<jacobian->numberOfColors; ++c) {
+        int firstColumn = jacobian->colorPointers[c];
+        size_t numberOfKnowns = jacobian->colorPointers[c+1]-firstColumn;
+        size_t numberOfUnknowns = jacobian->unknownPointers[c+1]-jacobian->unknownPointers[c];
+        if(numberOfUnknowns == 0) {
+            continue;
+        }
+
+        fmi3Status status = fmi3_getDirectionalDerivative(jacobian->fmu,
+                                                          &jacobian->colorUnknowns[jacobian->unknownPointers[c]],
+                                                          numberOfUnknowns,
+                                                          &jacobian->colorKnowns[firstColumn],
+                                                          numberOfKnowns,
+                                                          jacobian->seed,
+                                                          numberOfKnowns,
+                                                          jacobian->sensitivity,
+                                                          numberOfUnknowns);
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi3Error) {
+            return status;
+        }
+
+        for(int i=firstColumn; i<jacobian->colorPointers[c+1]; ++i) {
+            int j = jacobian->colorColumns[i];
+            for(int64_t k=jacobian->columnPointers[j]; k<jacobian->columnPointers[j+1]; ++k) {
+                values[k] = jacobian->sensitivity[jacobian->sensitivityIndices[k]];
+            }
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief Checks if a clock activation is dispatched before another one (earlier time, then higher priority, then scheduled first)
+static bool isActivationBefore(fmiClockScheduler *scheduler, const fmiClockActivation *a, const fmiClockActivation *b)
+{
+    if(a->time != b->time) {
+        return a->time < b->time;
+    }
+    int priorityA = scheduler->clocks[a->clock].priority;
+    int priorityB = scheduler->clocks[b->clock].priority;
+    if(priorityA != priorityB) {
+        return priorityA < priorityB;
+    }
+    return a->sequence < b->sequence;
+}
+
+
+//! @brief Moves a clock activation towards the root of the queue until the heap order is restored
+static void siftActivationUp(fmiClockScheduler *scheduler, int i)
+{
+    fmiClockActivation activation = scheduler->queue[i];
+    while(i > 0) {
+        int parent = (i-1)/2;
+        if(!isActivationBefore(scheduler, &activation, &scheduler->queue[parent])) {
+            break;
+        }
+        scheduler->queue[i] = scheduler->queue[parent];
+        i = parent;
+    }
+    scheduler->queue[i] = activation;
+}
+
+
+//! @brief Moves a clock activation towards the leaves of the queue until the heap order is restored
+static void siftActivationDown(fmiClockScheduler *scheduler, int i)
+{
+    fmiClockActivation activation = scheduler->queue[i];
+    while(true) {
+        int child = 2*i+1;
+        if(child >= scheduler->queueSize) {
+            break;
+        }
+        if(child+1 < scheduler->queueSize && isActivationBefore(scheduler, &scheduler->queue[child+1], &scheduler->queue[child])) {
+            ++child;
+        }
+        if(!isActivationBefore(scheduler, &scheduler->queue[child], &activation)) {
+            break;
+        }
+        scheduler->queue[i] = scheduler->queue[child];
+        i = child;
+    }
+    scheduler->queue[i] = activation;
+}
+
+
+//! @brief Queues an activation of a clock (scheduler mutex must be locked, except during creation)
+static void queueActivation(fmiClockScheduler *scheduler, int clock, double time)
+{
+    if(scheduler->queueSize == scheduler->queueCapacity) {
+        scheduler->queueCapacity *= 2;
+        scheduler->queue = fmi4cRealloc(scheduler->queue, scheduler->queueCapacity*sizeof(fmiClockActivation));
+    }
+    fmiClockActivation *activation = &scheduler->queue[scheduler->queueSize];
+    activation->time = time;
+    activation->clock = clock;
+    activation->sequence = scheduler->nextSequence++;
+    siftActivationUp(scheduler, scheduler->queueSize++);
+}
+
+
+//! @brief Finds the first queued activation that may be dispatched now (scheduler mutex must be locked)
+//! Activations after the stop time, activations of clocks whose previous activation is still running
+//! and all activations after a failed one are held back.
+//! @returns Index in queue, or -1 if no activation can be dispatched
+static int findDispatchableActivation(fmiClockScheduler *scheduler)
+{
+    if(scheduler->status >= fmi3Error || scheduler->queueSize == 0 || scheduler->queue[0].time > scheduler->stopTime) {
+        return -1;
+    }
+    if(!scheduler->clocks[scheduler->queue[0].clock].running) {
+        return 0;   //Common case, the earliest activation
+    }
+    int first = -1;
+    for(int i=1; i<scheduler->queueSize; ++i) {
+        fmiClockActivation *activation = &scheduler->queue[i];
+        if(activation->time <= scheduler->stopTime && !scheduler->clocks[activation->clock].running &&
+           (first < 0 || isActivationBefore(scheduler, activation, &scheduler->queue[first]))) {
+            first = i;
+        }
+    }
+    return first;
+}
+
+
+//! @brief Removes an activation from the queue (scheduler mutex must be locked)
+static fmiClockActivation takeActivation(fmiClockScheduler *scheduler, int i)
+{
+    fmiClockActivation activation = scheduler->queue[i];
+    scheduler->queue[i] = scheduler->queue[--scheduler->queueSize];
+    if(i < scheduler->queueSize) {
+        siftActivationDown(scheduler, i);
+        siftActivationUp(scheduler, i);
+    }
+    return activation;
+}
+
+
+//! @brief Queues the next activation of a periodic clock (scheduler mutex must be locked, except during creation)
+static void queueNextTick(fmiClockScheduler *scheduler, int clock)
+{
+    fmiScheduledClock *scheduledClock = &scheduler->clocks[clock];
+    ++scheduledClock->numberOfTicks;
+    queueActivation(scheduler, clock, scheduledClock->intervalStart + scheduledClock->numberOfTicks*scheduledClock->interval);
+}
+
+
+//! @brief Reads the current interval of a clock from the FMU
+//! @returns True if the FMU returned a known interval
+static bool getClockInterval(fmiClockScheduler *scheduler, int clock, double *interval, fmi3IntervalQualifier *qualifier)
+{
+    fmi3Float64 value;
+    *qualifier = fmi3IntervalNotYetKnown;
+    if(fmi3_getIntervalDecimal(scheduler->fmu, &scheduler->clocks[clock].valueReference, 1, &value, qualifier) >= fmi3Error ||
+       *qualifier == fmi3IntervalNotYetKnown) {
+        return false;
+    }
+    *interval = value;
+    return true;
+}
+
+
+//! @brief Worker for clock schedulers, activates model partitions until the scheduler is freed
+#ifdef _WIN32
+static DWORD WINAPI clockSchedulerWorker(LPVOID data)
+#else
+static void *clockSchedulerWorker(void *data)
+#endif
+{
+    fmiClockScheduler *scheduler = data;
+
+    fmiMutexLock(&scheduler->mutex);
+    int core = scheduler->numberOfStartedThreads++;
+    fmiMutexUnlock(&scheduler->mutex);
+    if(scheduler->pinThreads && !setThreadAffinity(core)) {
+        printf("Failed to set affinity of clock scheduler thread to core %i\n", core);
+    }
+
+    fmiMutexLock(&scheduler->mutex);
+    while(true) {
+        int i = -1;
+        while(!scheduler->stop && (i = findDispatchableActivation(scheduler)) < 0) {
+            fmiConditionWait(&scheduler->workAvailable, &scheduler->mutex);
+        }
+        if(scheduler->stop) {
+            break;
+        }
+        fmiClockActivation activation = takeActivation(scheduler, i);
+        fmiScheduledClock *clock = &scheduler->clocks[activation.clock];
+        clock->running = true;
+        ++scheduler->numberOfRunningActivations;
+        fmiMutexUnlock(&scheduler->mutex);
+
+        fmi3Status status = fmi3_activateModelPartition(scheduler->fmu, clock->valueReference, activation.time);
+
+        //Clocks with variable intervals report the next interval after their activation
+        double interval = 0;
+        fmi3IntervalQualifier qualifier = fmi3IntervalUnchanged;
+        bool intervalKnown = false;
+        if(status < fmi3Error && (clock->intervalVariability == fmi3IntervalVariabilityTunable ||
+                                  clock->intervalVariability == fmi3IntervalVariabilityChanging ||
+                                  clock->intervalVariability == fmi3IntervalVariabilityCountdown)) {
+            intervalKnown = getClockInterval(scheduler, activation.clock, &interval, &qualifier);
+        }
+
+        fmiMutexLock(&scheduler->mutex);
+        clock->running = false;
+        --scheduler->numberOfRunningActivations;
+        if(status > scheduler->status) {
+            scheduler->status = status;
+        }
+        if(status < fmi3Error) {
+            if(clock->intervalVariability == fmi3IntervalVariabilityCountdown) {
+                if(intervalKnown && qualifier == fmi3IntervalChanged && interval > 0) {
+                    queueActivation(scheduler, activation.clock, activation.time + interval);
+                }
+            }
+            else if(clock->interval > 0) {
+                if(intervalKnown && qualifier == fmi3IntervalChanged && interval > 0 && interval != clock->interval) {
+                    clock->interval = interval;
+                    clock->intervalStart = activation.time;
+                    clock->numberOfTicks = 0;
+                }
+                queueNextTick(scheduler, activation.clock);
+            }
+        }
+        fmiConditionBroadcast(&scheduler->workAvailable);
+        fmiConditionBroadcast(&scheduler->activationFinished);
+    }
+    fmiMutexUnlock(&scheduler->mutex);
+    return 0;
+}
+
+
+//! @brief Frees a clock scheduler, after the running activations have finished (queued activations are dropped)
+//! @param scheduler Clock scheduler
+void fmi3_freeClockScheduler(fmiClockScheduler *scheduler)
+{
+    fmiMutexLock(&scheduler->mutex);
+    scheduler->stop = true;
+    fmiConditionBroadcast(&scheduler->workAvailable);
+    fmiMutexUnlock(&scheduler->mutex);
+
+    for(int i=0; i<scheduler->numberOfThreads; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(scheduler->threads[i], INFINITE);
+        CloseHandle(scheduler->threads[i]);
+#else
+        pthread_join(scheduler->threads[i], NULL);
+#endif
+    }
+    fmi4cFree(scheduler->threads);
+    fmi4cFree(scheduler->clocks);
+    fmi4cFree(scheduler->queue);
+    fmiConditionDestroy(&scheduler->workAvailable);
+    fmiConditionDestroy(&scheduler->activationFinished);
+    fmiMutexDestroy(&scheduler->mutex);
+    fmi4cFree(scheduler);
+}
+
+
+//! @brief Creates a scheduler for the model partitions of a Scheduled Execution FMU
+//! Every input clock of the FMU is a model partition. Periodic clocks (constant, fixed, calculated, tunable
+//! and changing interval variability) are scheduled from their shift and interval, countdown clocks whenever
+//! the FMU reports a new interval after an activation, and triggered clocks with fmi3_scheduleClock().
+//! Activations are dispatched onto worker threads in order of activation time and then clock priority, so
+//! partitions of different clocks run concurrently, while each partition runs at most once at a time.
+//! The FMU must be instantiated for Scheduled Execution and initialized. Profiling should be disabled, as
+//! fmi3_activateModelPartition() is called from several threads.
+//! @param fmu FMU handle (FMI 3)
+//! @param startTime Start time, the first periodic activations are at startTime plus clock shift
+//! @param numberOfThreads Number of worker threads (at least one is used)
+//! @param pinThreads Pin each worker thread to its own core
+//! @returns Clock scheduler, or NULL on failure
+fmiClockScheduler *fmi3_createClockScheduler(fmiHandle *fmu, double startTime, int numberOfThreads, bool pinThreads)
+{
+    if(fmu->version != fmiVersion3 || !fmu->fmi3.supportsScheduledExecution) {
+        printf("Clock scheduler requires an FMI 3 Scheduled Execution FMU\n");
+        return NULL;
+    }
+    if(numberOfThreads < 1) {
+        numberOfThreads = 1;
+    }
+
+    fmiClockScheduler *scheduler = fmi4cCalloc(1, sizeof(fmiClockScheduler));
+    scheduler->fmu = fmu;
+    scheduler->stopTime = -DBL_MAX;     //Nothing is dispatched before the first run
+    scheduler->status = fmi3OK;
+    scheduler->pinThreads = pinThreads;
+    fmiMutexInit(&scheduler->mutex);
+    fmiConditionInit(&scheduler->workAvailable);
+    fmiConditionInit(&scheduler->activationFinished);
+
+    //Collect input clocks
+    scheduler->clocks = fmi4cMalloc((fmu->fmi3.numberOfVariables > 0 ? fmu->fmi3.numberOfVariables : 1)*sizeof(fmiScheduledClock));
+    scheduler->queueCapacity = 16;
+    scheduler->queue = fmi4cMalloc(scheduler->queueCapacity*sizeof(fmiClockActivation));
+    for(int i=0; i<fmu->fmi3.numberOfVariables; ++i) {
+        fmi3VariableHandle *var = &fmu->fmi3.variables[i];
+        if(var->datatype != fmi3DataTypeClock || var->causality != fmi3CausalityInput) {
+            continue;
+        }
+        int clock = scheduler->numberOfClocks++;
+        fmiScheduledClock *scheduledClock = &scheduler->clocks[clock];
+        scheduledClock->valueReference = (fmi3ValueReference)var->valueReference;
+        scheduledClock->priority = var->priority;
+        scheduledClock->intervalVariability = var->intervalVariability;
+        scheduledClock->interval = 0;
+        scheduledClock->numberOfTicks = 0;
+        scheduledClock->running = false;
+
+        double interval = var->intervalDecimal;
+        double shift = var->shiftDecimal;
+        fmi3IntervalQualifier qualifier;
+        switch(var->intervalVariability) {
+        case fmi3IntervalVariabilityFixed:
+        case fmi3IntervalVariabilityCalculated:
+        case fmi3IntervalVariabilityTunable:
+        case fmi3IntervalVariabilityChanging:
+            if(getClockInterval(scheduler, clock, &interval, &qualifier)) {
+                fmi3Float64 value;
+                if(fmi3_getShiftDecimal(fmu, &scheduledClock->valueReference, 1, &value) < fmi3Error) {
+                    shift = value;
+                }
+            }
+            //Fall through
+        case fmi3IntervalVariabilityConstant:
+            if(interval > 0) {
+                scheduledClock->interval = interval;
+                scheduledClock->intervalStart = startTime + shift;
+                queueActivation(scheduler, clock, scheduledClock->intervalStart);
+            }
+            else {
+                printf("Clock %s has no positive interval and is not scheduled\n", var->name);
+            }
+            break;
+        case fmi3IntervalVariabilityCountdown:
+            if(getClockInterval(scheduler, clock, &interval, &qualifier) && qualifier == fmi3IntervalChanged && interval > 0) {
+                queueActivation(scheduler, clock, startTime + interval);
+            }
+            break;
+        default:
+            break;  //Triggered clocks are only activated by fmi3_scheduleClock()
+        }
+    }
+
+    //Only count threads that were actually started
+#ifdef _WIN32
+    scheduler->threads = fmi4cMalloc(numberOfThreads*sizeof(HANDLE));
+    for(int i=0; i<numberOfThreads; ++i) {
+        scheduler->threads[scheduler->numberOfThreads] = CreateThread(NULL, 0, clockSchedulerWorker, scheduler, 0, NULL);
+        if(scheduler->threads[scheduler->numberOfThreads] != NULL) {
+            ++scheduler->numberOfThreads;
+        }
+    }
+#else
+    scheduler->threads = fmi4cMalloc(numberOfThreads*sizeof(pthread_t));
+    for(int i=0; i<numberOfThreads; ++i) {
+        if(pthread_create(&scheduler->threads[scheduler->numberOfThreads], NULL, clockSchedulerWorker, scheduler) == 0) {
+            ++scheduler->numberOfThreads;
+        }
+    }
+#endif
+
+    if(scheduler->numberOfThreads == 0) {
+        printf("Failed to start any clock scheduler threads\n");
+        fmi3_freeClockScheduler(scheduler);
+        return NULL;
+    }
+    return scheduler;
+}
+
+
+//! @brief Schedules an additional activation of an input clock, e.g. of a triggered clock
+//! May be called while the scheduler is running.
+//! @param scheduler Clock scheduler
+//! @param clockReference Value reference of an input clock
+//! @param activationTime Activation time
+//! @returns False if the value reference is not an input clock of the FMU
+bool fmi3_scheduleClock(fmiClockScheduler *scheduler, fmi3ValueReference clockReference, double activationTime)
+{
+    for(int i=0; i<scheduler->numberOfClocks; ++i) {
+        if(scheduler->clocks[i].valueReference == clockReference) {
+            fmiMutexLock(&scheduler->mutex);
+            queueActivation(scheduler, i, activationTime);
+            fmiConditionBroadcast(&scheduler->workAvailable);
+            fmiMutexUnlock(&scheduler->mutex);
+            return true;
+        }
+    }
+    printf("Value reference %u is not an input clock: %s\n", clockReference, scheduler->fmu->instanceName);
+    return false;
+}
+
+
+//! @brief Dispatches all queued clock activations up to and including the stop time, and waits for them to finish
+//! Activations queued by finished activations (e.g. the next tick of periodic clocks) are dispatched as well if
+//! they are not after the stop time. After an activation fails with fmi3Error or worse, no further activations
+//! are dispatched, until the next call.
+//! @param scheduler Clock scheduler
+//! @param stopTime Stop time
+//! @returns Worst status of the activations
+fmi3Status fmi3_runClockSchedulerUntil(fmiClockScheduler *scheduler, double stopTime)
+{
+    fmiMutexLock(&scheduler->mutex);
+    scheduler->stopTime = stopTime;
+    scheduler->status = fmi3OK;
+    fmiConditionBroadcast(&scheduler->workAvailable);
+    while(scheduler->numberOfRunningActivations > 0 || findDispatchableActivation(scheduler) >= 0) {
+        fmiConditionWait(&scheduler->activationFinished, &scheduler->mutex);
+    }
+    fmi3Status status = scheduler->status;
+    fmiMutexUnlock(&scheduler->mutex);
+    return status;
+}
@@ -0,0 +1,403 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+
+#include <cvode/cvode.h>
+#include <nvector/nvector_serial.h>
+#include <sunmatrix/sunmatrix_dense.h>
+#include <sunlinsol/sunlinsol_dense.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Model Exchange solver, integrating the continuous states of an FMI 3 FMU with CVODE (BDF)
+struct fmiModelExchangeSolver {
+    fmiHandle *fmu;
+    void *cvodeMemory;
+    int numberOfStates;             // May be 0, CVODE then integrates one dummy state
+    int numberOfEventIndicators;
+    fmiStateVector *stateVector;    // Skips set calls at unchanged time and states
+    N_Vector states;                // Aliases the state buffer of stateVector, the FMU reads and writes it directly
+    N_Vector absoluteTolerances;
+    SUNMatrix matrix;
+    SUNLinearSolver linearSolver;
+    fmiSparseJacobian *jacobian;    // NULL if the FMU does not provide directional derivatives
+    int64_t *columnPointers;
+    int64_t *rowIndices;
+    fmi3Float64 *jacobianValues;
+    double relativeTolerance;
+    double absoluteTolerance;
+    double time;
+    bool nextEventTimeDefined;
+    double nextEventTime;
+    fmi3Status status;              // Worst status of FMU calls made from CVODE callbacks
+    long numberOfEvents;
+    long numberOfJacobianEvaluations;
+    long numberOfSteps;             // Accumulated over CVODE restarts, which reset its counters
+    long numberOfRhsEvaluations;
+};
+
+
+//! @brief Sets time and continuous states of the FMU from a CVODE state vector
+static int setTimeAndStates(fmiModelExchangeSolver *solver, realtype t, N_Vector y)
+{
+    return fmi4c_setTimeAndContinuousStates(solver->stateVector, t, NV_DATA_S(y));
+}
+
+
+//! @brief Records the status of an FMU call from a CVODE callback and converts it to a CVODE return value
+//! Discard is returned as a recoverable error, so that CVODE retries with a smaller step.
+static int callbackResult(fmiModelExchangeSolver *solver, fmi3Status status)
+{
+    if(status > solver->status) {
+        solver->status = status;
+    }
+    if(status == fmi3Discard) {
+        return 1;
+    }
+    return (status > fmi3Discard) ? -1 : 0;
+}
+
+
+//! @brief CVODE right hand side function, returns the state derivatives of the FMU
+static int rhs(realtype t, N_Vector y, N_Vector ydot, void *userData)
+{
+    fmiModelExchangeSolver *solver = userData;
+    int status = setTimeAndStates(solver, t, y);
+    if(status < fmi3Discard) {
+        if(solver->numberOfStates > 0) {
+            status = fmi4c_getContinuousStateDerivatives(solver->stateVector, NV_DATA_S(ydot));
+        }
+        else {
+            NV_Ith_S(ydot, 0) = 0;
+        }
+    }
+    return callbackResult(solver, status);
+}
+
+
+//! @brief CVODE root function, returns the event indicators of the FMU
+static int roots(realtype t, N_Vector y, realtype *gout, void *userData)
+{
+    fmiModelExchangeSolver *solver = userData;
+    int status = setTimeAndStates(solver, t, y);
+    if(status < fmi3Discard) {
+        status = fmi3_getEventIndicators(solver->fmu, gout, solver->numberOfEventIndicators);
+    }
+    return callbackResult(solver, status);
+}
+
+
+//! @brief CVODE Jacobian function, evaluates the sparse state Jacobian of the FMU into the dense CVODE matrix
+static int jacobian(realtype t, N_Vector y, N_Vector fy, SUNMatrix J, void *userData, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+    (void)fy; (void)tmp1; (void)tmp2; (void)tmp3;
+    fmiModelExchangeSolver *solver = userData;
+    int status = setTimeAndStates(solver, t, y);
+    if(status < fmi3Discard) {
+        status = fmi3_evaluateSparseJacobian(solver->jacobian, solver->jacobianValues);
+    }
+    if(status < fmi3Discard) {
+        SUNMatZero(J);
+        for(int j=0; j<solver->numberOfStates; ++j) {
+            realtype *column = SUNDenseMatrix_Column(J, j);
+            for(int64_t k=solver->columnPointers[j]; k<solver->columnPointers[j+1]; ++k) {
+                column[solver->rowIndices[k]] = solver->jacobianValues[k];
+            }
+        }
+        ++solver->numberOfJacobianEvaluations;
+    }
+    return callbackResult(solver, status);
+}
+
+
+//! @brief Sets absolute tolerances from the nominal values of the continuous states
+static fmi3Status updateTolerances(fmiModelExchangeSolver *solver)
+{
+    if(solver->numberOfStates > 0) {
+        fmi3Status status = fmi3_getNominalsOfContinuousStates(solver->fmu, NV_DATA_S(solver->absoluteTolerances), solver->numberOfStates);
+        if(status >= fmi3Discard) {
+            return status;
+        }
+        N_VAbs(solver->absoluteTolerances, solver->absoluteTolerances);
+    }
+    else {
+        N_VConst(1, solver->absoluteTolerances);
+    }
+    N_VScale(solver->absoluteTolerance, solver->absoluteTolerances, solver->absoluteTolerances);
+    if(solver->cvodeMemory != NULL) {
+        CVodeSVtolerances(solver->cvodeMemory, solver->relativeTolerance, solver->absoluteTolerances);
+    }
+    return fmi3OK;
+}
+
+
+//! @brief Iterates discrete states until they are stable and returns to continuous time mode
+//! The FMU must be in event mode. Re-reads the continuous states if the FMU changed them.
+//! @param solver Model Exchange solver
+//! @param terminateSimulation Returns true if the FMU requested termination
+//! @returns Worst status of the FMU calls
+static fmi3Status handleEvent(fmiModelExchangeSolver *solver, bool *terminateSimulation)
+{
+    fmi3Status worstStatus = fmi3OK;
+    fmi3Boolean discreteStatesNeedUpdate = fmi3True;
+    fmi3Boolean nominalsChanged = fmi3False;
+    fmi3Boolean valuesChanged = fmi3False;
+    fmi3Boolean nextEventTimeDefined = fmi3False;
+    fmi3Float64 nextEventTime = 0;
+    *terminateSimulation = false;
+    while(discreteStatesNeedUpdate) {
+        fmi3Boolean terminate = fmi3False;
+        fmi3Boolean nominalsChangedNow = fmi3False;
+        fmi3Boolean valuesChangedNow = fmi3False;
+        fmi3Status status = fmi3_updateDiscreteStates(solver->fmu, &discreteStatesNeedUpdate, &terminate, &nominalsChangedNow,
+                                                      &valuesChangedNow, &nextEventTimeDefined, &nextEventTime);
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi3Discard) {
+            return worstStatus;
+        }
+        if(terminate) {
+            *terminateSimulation = true;
+            return worstStatus;
+        }
+        nominalsChanged = nominalsChanged || nominalsChangedNow;
+        valuesChanged = valuesChanged || valuesChangedNow;
+    }
+    ++solver->numberOfEvents;
+    fmi4c_invalidateStateVector(solver->stateVector);
+
+    //An event time that is not ahead of the current time would stop the integration forever
+    solver->nextEventTimeDefined = nextEventTimeDefined && nextEventTime > solver->time;
+    solver->nextEventTime = nextEventTime;
+
+    fmi3Status status = fmi3_enterContinuousTimeMode(solver->fmu);
+    if(status > worstStatus) {
+        worstStatus = status;
+    }
+    if(status < fmi3Discard && solver->numberOfStates > 0) {
+        if(valuesChanged) {
+            status = fmi4c_updateContinuousStates(solver->stateVector);
+        }
+        if(status < fmi3Discard && nominalsChanged) {
+            status = updateTolerances(solver);
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief Frees a Model Exchange solver (the FMU is not freed)
+//! @param solver Model Exchange solver
+void fmi3_freeModelExchangeSolver(fmiModelExchangeSolver *solver)
+{
+    if(solver->cvodeMemory != NULL) {
+        CVodeFree(&solver->cvodeMemory);
+    }
+    if(solver->linearSolver != NULL) {
+        SUNLinSolFree(solver->linearSolver);
+    }
+    if(solver->matrix != NULL) {
+        SUNMatDestroy(solver->matrix);
+    }
+    if(solver->states != NULL) {
+        N_VDestroy(solver->states);
+    }
+    if(solver->absoluteTolerances != NULL) {
+        N_VDestroy(solver->absoluteTolerances);
+    }
+    if(solver->stateVector != NULL) {
+        fmi4c_freeStateVector(solver->stateVector);
+    }
+    if(solver->jacobian != NULL) {
+        fmi3_freeSparseJacobian(solver->jacobian);
+    }
+    fmi4cFree(solver->columnPointers);
+    fmi4cFree(solver->rowIndices);
+    fmi4cFree(solver->jacobianValues);
+    fmi4cFree(solver);
+}
+
+
+//! @brief Creates a CVODE (BDF) solver for an FMI 3 Model Exchange FMU
+//! The FMU must be instantiated for Model Exchange and be in event mode, i.e. fmi3_exitInitializationMode()
+//! has just been called. The initial event iteration is performed, and the FMU is left in continuous time mode.
+//! State and derivative vectors are allocated once and passed directly to the FMU. Event indicators are used
+//! as CVODE root functions. If the FMU provides directional derivatives, the Jacobian is computed from them
+//! (see fmi3_createSparseJacobian()), otherwise CVODE uses difference quotients.
+//! @param fmu FMU handle (FMI 3)
+//! @param startTime Start time
+//! @param relativeTolerance Relative tolerance
+//! @param absoluteTolerance Absolute tolerance, scaled by the nominal value of each state
+//! @returns Model Exchange solver, or NULL on failure
+fmiModelExchangeSolver *fmi3_createModelExchangeSolver(fmiHandle *fmu, double startTime, double relativeTolerance, double absoluteTolerance)
+{
+    if(fmu->version != fmiVersion3 || !fmu->fmi3.supportsModelExchange) {
+        printf("Model Exchange solver requires an FMI 3 Model Exchange FMU\n");
+        return NULL;
+    }
+
+    fmiModelExchangeSolver *solver = fmi4cCalloc(1, sizeof(fmiModelExchangeSolver));
+    solver->fmu = fmu;
+    solver->relativeTolerance = relativeTolerance;
+    solver->absoluteTolerance = absoluteTolerance;
+    solver->time = startTime;
+    solver->numberOfStates = fmu->fmi3.numberOfContinuousStateDerivatives;
+    solver->numberOfEventIndicators = fmu->fmi3.numberOfEventIndicators;
+    int n = (solver->numberOfStates > 0) ? solver->numberOfStates : 1;
+    solver->stateVector = fmi4c_createStateVector(fmu);
+    if(solver->stateVector == NULL) {
+        fmi4cFree(solver);
+        return NULL;
+    }
+    solver->states = N_VMake_Serial(n, fmi4c_getStateBuffer(solver->stateVector));
+    solver->absoluteTolerances = N_VNew_Serial(n);
+
+    bool terminateSimulation;
+    if(handleEvent(solver, &terminateSimulation) >= fmi3Discard || terminateSimulation) {
+        printf("Initial event iteration failed: %s\n", fmu->instanceName);
+        fmi3_freeModelExchangeSolver(solver);
+        return NULL;
+    }
+    if(fmi4c_updateContinuousStates(solver->stateVector) >= fmi3Discard ||
+       updateTolerances(solver) >= fmi3Discard) {
+        printf("Failed to get continuous states: %s\n", fmu->instanceName);
+        fmi3_freeModelExchangeSolver(solver);
+        return NULL;
+    }
+
+    solver->cvodeMemory = CVodeCreate(CV_BDF);
+    solver->matrix = SUNDenseMatrix(n, n);
+    solver->linearSolver = SUNLinSol_Dense(solver->states, solver->matrix);
+    if(solver->cvodeMemory == NULL || solver->matrix == NULL || solver->linearSolver == NULL ||
+       CVodeInit(solver->cvodeMemory, rhs, startTime, solver->states) != CV_SUCCESS ||
+       CVodeSetUserData(solver->cvodeMemory, solver) != CV_SUCCESS ||
+       CVodeSVtolerances(solver->cvodeMemory, relativeTolerance, solver->absoluteTolerances) != CV_SUCCESS ||
+       CVodeSetLinearSolver(solver->cvodeMemory, solver->linearSolver, solver->matrix) != CVLS_SUCCESS ||
+       (solver->numberOfEventIndicators > 0 &&
+        CVodeRootInit(solver->cvodeMemory, solver->numberOfEventIndicators, roots) != CV_SUCCESS)) {
+        printf("Failed to initialize CVODE: %s\n", fmu->instanceName);
+        fmi3_freeModelExchangeSolver(solver);
+        return NULL;
+    }
+
+    if(solver->numberOfStates > 0 && fmu->fmi3.me.providesDirectionalDerivative) {
+        solver->jacobian = fmi3_createSparseJacobian(fmu);
+    }
+    if(solver->jacobian != NULL) {
+        int numberOfStates, numberOfNonZeros, numberOfColors;
+        fmi3_getSparseJacobianDimensions(solver->jacobian, &numberOfStates, &numberOfNonZeros, &numberOfColors);
+        solver->columnPointers = fmi4cMalloc((numberOfStates+1)*sizeof(int64_t));
+        solver->rowIndices = fmi4cMalloc((numberOfNonZeros > 0 ? numberOfNonZeros : 1)*sizeof(int64_t));
+        solver->jacobianValues = fmi4cMalloc((numberOfNonZeros > 0 ? numberOfNonZeros : 1)*sizeof(fmi3Float64));
+        fmi3_getSparseJacobianPattern(solver->jacobian, solver->columnPointers, solver->rowIndices);
+        CVodeSetJacFn(solver->cvodeMemory, jacobian);
+    }
+
+    return solver;
+}
+
+
+//! @brief Integrates a Model Exchange FMU until the stop time, handling time, state and step events
+//! The FMU is left in continuous time mode, with its time and continuous states set to the reached time.
+//! @param solver Model Exchange solver
+//! @param stopTime Stop time
+//! @param terminateSimulation Returns true if the FMU requested termination (the reached time is then before stopTime)
+//! @returns Worst status of the FMU calls, or fmi3Error if CVODE failed
+fmi3Status fmi3_solveModelExchangeUntil(fmiModelExchangeSolver *solver, double stopTime, bool *terminateSimulation)
+{
+    fmiHandle *fmu = solver->fmu;
+    fmi3Status worstStatus = fmi3OK;
+    *terminateSimulation = false;
+    solver->status = fmi3OK;
+    while(solver->time < stopTime) {
+        double endTime = stopTime;
+        bool timeEvent = solver->nextEventTimeDefined && solver->nextEventTime <= stopTime;
+        if(timeEvent) {
+            endTime = solver->nextEventTime;
+        }
+
+        //One internal CVODE step, so that step events are detected after every step
+        realtype reachedTime;
+        CVodeSetStopTime(solver->cvodeMemory, endTime);
+        int flag = CVode(solver->cvodeMemory, endTime, solver->states, &reachedTime, CV_ONE_STEP);
+        if(solver->status > worstStatus) {
+            worstStatus = solver->status;
+        }
+        if(flag < 0) {
+            printf("CVODE failed with flag %d at time %g: %s\n", flag, solver->time, fmu->instanceName);
+            return (worstStatus > fmi3Error) ? worstStatus : fmi3Error;
+        }
+        solver->time = reachedTime;
+        timeEvent = timeEvent && flag == CV_TSTOP_RETURN;
+
+        //The FMU was last evaluated at a trial point, not at the accepted step
+        fmi3Status status = setTimeAndStates(solver, reachedTime, solver->states);
+        fmi3Boolean enterEventMode = fmi3False;
+        fmi3Boolean terminate = fmi3False;
+        if(status < fmi3Discard && fmu->fmi3.me.needsCompletedIntegratorStep) {
+            status = fmi3_completedIntegratorStep(fmu, fmi3True, &enterEventMode, &terminate);
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi3Discard) {
+            return worstStatus;
+        }
+        if(terminate) {
+            *terminateSimulation = true;
+            return worstStatus;
+        }
+
+        if(timeEvent || flag == CV_ROOT_RETURN || enterEventMode) {
+            status = fmi3_enterEventMode(fmu);
+            if(status < fmi3Discard) {
+                status = handleEvent(solver, terminateSimulation);
+            }
+            if(status > worstStatus) {
+                worstStatus = status;
+            }
+            if(status >= fmi3Discard || *terminateSimulation) {
+                return worstStatus;
+            }
+            //States may be discontinuous, so restart with a new history
+            long numberOfSteps, numberOfRhsEvaluations;
+            CVodeGetNumSteps(solver->cvodeMemory, &numberOfSteps);
+            CVodeGetNumRhsEvals(solver->cvodeMemory, &numberOfRhsEvaluations);
+            solver->numberOfSteps += numberOfSteps;
+            solver->numberOfRhsEvaluations += numberOfRhsEvaluations;
+            CVodeReInit(solver->cvodeMemory, reachedTime, solver->states);
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief Returns the time reached by a Model Exchange solver
+//! @param solver Model Exchange solver
+//! @returns Time
+double fmi3_getModelExchangeSolverTime(fmiModelExchangeSolver *solver)
+{
+    return solver->time;
+}
+
+
+//! @brief Returns statistics of a Model Exchange solver since it was created
+//! @param solver Model Exchange solver
+//! @param numberOfSteps Returns the number of CVODE steps
+//! @param numberOfRhsEvaluations Returns the number of state derivative evaluations
+//! @param numberOfJacobianEvaluations Returns the number of Jacobian evaluations from directional derivatives
+//! @param numberOfEvents Returns the number of handled events (including the initial event iteration)
+void fmi3_getModelExchangeSolverStatistics(fmiModelExchangeSolver *solver, long *numberOfSteps, long *numberOfRhsEvaluations, long *numberOfJacobianEvaluations, long *numberOfEvents)
+{
+    CVodeGetNumSteps(solver->cvodeMemory, numberOfSteps);
+    CVodeGetNumRhsEvals(solver->cvodeMemory, numberOfRhsEvaluations);
+    *numberOfSteps += solver->numberOfSteps;
+    *numberOfRhsEvaluations += solver->numberOfRhsEvaluations;
+    *numberOfJacobianEvaluations = solver->numberOfJacobianEvaluations;
+    *numberOfEvents = solver->numberOfEvents;
+}
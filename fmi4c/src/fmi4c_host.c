@@ -0,0 +1,595 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // For memfd_create()
+#endif
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_host.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+extern char **environ;
+
+// Client side of an FMU host process, also used as the fmi3Instance of the hosted FMU
+struct fmiHost {
+    fmiHostChannel *channel;
+    pid_t pid;
+    bool terminated;
+    uint32_t responsesSeen;
+    int spinCount;                  // Polls before sleeping, 0 on single processor systems where spinning only delays the host
+    char *strings;                  // Values from the last get string call, valid until the next one
+    size_t stringsCapacity;
+};
+
+
+//! @brief Sleeps until a futex word in the shared channel changes, or until the timeout
+static void futexWait(uint32_t *word, uint32_t value, long timeoutNanoseconds)
+{
+    struct timespec timeout = { 0, timeoutNanoseconds };
+    syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+
+//! @brief Wakes the other process if it sleeps on a futex word in the shared channel
+static void futexWake(uint32_t *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+
+//! @brief Tells if the host process is still running, and reaps it if not
+//! @param host FMU host
+//! @returns False if the host process has terminated
+static bool isHostRunning(fmiHost *host)
+{
+    if(!host->terminated && waitpid(host->pid, NULL, WNOHANG) != 0) {
+        printf("FMU host process %d terminated\n", (int)host->pid);
+        host->terminated = true;
+    }
+    return !host->terminated;
+}
+
+
+//! @brief Reserves space for a message in the ring buffer, waiting for the host to consume earlier messages if needed
+//! @param host FMU host
+//! @param function Called function
+//! @param size Size of arguments (at most FMI4C_HOST_MAX_MESSAGE_SIZE minus header)
+//! @returns Pointer to arguments, to be filled in before postMessage(), or NULL if the host has terminated
+static char *beginMessage(fmiHost *host, fmiHostFunction function, size_t size)
+{
+    fmiHostChannel *channel = host->channel;
+    size_t messageSize = FMI4C_HOST_ALIGN(sizeof(fmiHostMessage)+size);
+    uint64_t head = channel->head;
+    size_t offset = head & (FMI4C_HOST_RING_SIZE-1);
+    size_t padding = (offset+messageSize > FMI4C_HOST_RING_SIZE) ? FMI4C_HOST_RING_SIZE-offset : 0;
+
+    for(int i=0; head+padding+messageSize-__atomic_load_n(&channel->tail, __ATOMIC_ACQUIRE) > FMI4C_HOST_RING_SIZE; ++i) {
+        if(i % 1000 == 999 && !isHostRunning(host)) {
+            return NULL;
+        }
+        sched_yield();
+    }
+    if(host->terminated) {
+        return NULL;
+    }
+
+    if(padding > 0) {
+        fmiHostMessage *message = (fmiHostMessage*)(channel->ring+offset);
+        message->function = fmiHostPadding;
+        message->size = (uint32_t)(padding-sizeof(fmiHostMessage));
+        offset = 0;
+    }
+    fmiHostMessage *message = (fmiHostMessage*)(channel->ring+offset);
+    message->function = (uint32_t)function;
+    message->size = (uint32_t)size;
+    return (char*)(message+1);
+}
+
+
+//! @brief Publishes the message from beginMessage() to the host
+//! @param host FMU host
+//! @param size Size of arguments, same as for beginMessage()
+static void postMessage(fmiHost *host, size_t size)
+{
+    fmiHostChannel *channel = host->channel;
+    size_t messageSize = FMI4C_HOST_ALIGN(sizeof(fmiHostMessage)+size);
+    uint64_t head = channel->head;
+    size_t offset = head & (FMI4C_HOST_RING_SIZE-1);
+    if(offset+messageSize > FMI4C_HOST_RING_SIZE) {
+        head += FMI4C_HOST_RING_SIZE-offset;    //Padding message
+    }
+    __atomic_store_n(&channel->head, head+messageSize, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&channel->requestsPosted, 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&channel->hostWaiting, __ATOMIC_SEQ_CST)) {
+        futexWake(&channel->requestsPosted);
+    }
+}
+
+
+//! @brief Waits for the response to the last posted message
+//! @param host FMU host
+//! @returns Status of the call, including the worst status of earlier calls that were not waited for
+static fmi3Status waitForResponse(fmiHost *host)
+{
+    fmiHostChannel *channel = host->channel;
+    uint32_t expected = host->responsesSeen+1;
+    for(int i=0; __atomic_load_n(&channel->responsesPosted, __ATOMIC_ACQUIRE) != expected; ++i) {
+        if(i < host->spinCount) {
+            continue;
+        }
+        if(!isHostRunning(host)) {
+            return fmi3Fatal;
+        }
+        __atomic_store_n(&channel->clientWaiting, 1, __ATOMIC_SEQ_CST);
+        uint32_t posted = __atomic_load_n(&channel->responsesPosted, __ATOMIC_SEQ_CST);
+        if(posted != expected) {
+            futexWait(&channel->responsesPosted, posted, 100000000);    //Timeout, to notice if the host crashes
+        }
+        __atomic_store_n(&channel->clientWaiting, 0, __ATOMIC_RELAXED);
+    }
+    host->responsesSeen = expected;
+    return (fmi3Status)channel->status;
+}
+
+
+//! @brief Calls a function in the host and waits for its status
+//! @param host FMU host
+//! @param function Called function
+//! @param arguments Arguments, or NULL if size is 0
+//! @param size Size of arguments
+//! @returns Status of the call
+static fmi3Status callHost(fmiHost *host, fmiHostFunction function, const void *arguments, size_t size)
+{
+    char *data = beginMessage(host, function, size);
+    if(data == NULL) {
+        return fmi3Fatal;
+    }
+    if(size > 0) {
+        memcpy(data, arguments, size);
+    }
+    postMessage(host, size);
+    return waitForResponse(host);
+}
+
+
+//! @brief Returns the worse of two statuses
+static fmi3Status worstStatus(fmi3Status a, fmi3Status b)
+{
+    return (a > b) ? a : b;
+}
+
+
+//! @brief Number of values per get or set message, when each value reference has one value
+static size_t getValuesPerMessage(size_t valueSize)
+{
+    size_t count = (FMI4C_HOST_MAX_MESSAGE_SIZE-sizeof(fmiHostMessage)-sizeof(fmiHostValueArguments)-8)/(sizeof(fmi3ValueReference)+valueSize);
+    if(count*valueSize > FMI4C_HOST_RESPONSE_SIZE) {
+        count = FMI4C_HOST_RESPONSE_SIZE/valueSize;
+    }
+    return count;
+}
+
+
+//! @brief Writes get or set arguments and value references into a message
+//! @returns Pointer to where values are written in set messages
+static char *writeValueArguments(char *data, const fmi3ValueReference vr[], size_t nvr, size_t nValues)
+{
+    fmiHostValueArguments *arguments = (fmiHostValueArguments*)data;
+    arguments->numberOfValueReferences = nvr;
+    arguments->numberOfValues = nValues;
+    data += sizeof(fmiHostValueArguments);
+    memcpy(data, vr, nvr*sizeof(fmi3ValueReference));
+    return data+FMI4C_HOST_ALIGN(nvr*sizeof(fmi3ValueReference));
+}
+
+
+//! @brief Gets values of a fixed size data type, split into several messages if they do not fit in one
+static fmi3Status getValues(fmiHost *host, fmiHostFunction function, const fmi3ValueReference vr[], size_t nvr, void *values, size_t nValues, size_t valueSize)
+{
+    size_t chunk = (nvr == nValues) ? getValuesPerMessage(valueSize) : nvr;
+    fmi3Status status = fmi3OK;
+    for(size_t first=0; first<nvr || first==0; first+=chunk) {
+        size_t count = (nvr-first < chunk) ? nvr-first : chunk;
+        size_t countValues = (nvr == nValues) ? count : nValues;
+        size_t size = sizeof(fmiHostValueArguments)+FMI4C_HOST_ALIGN(count*sizeof(fmi3ValueReference));
+        if(sizeof(fmiHostMessage)+size > FMI4C_HOST_MAX_MESSAGE_SIZE || countValues*valueSize > FMI4C_HOST_RESPONSE_SIZE) {
+            printf("Too many array values for out-of-process call\n");
+            return fmi3Error;
+        }
+        char *data = beginMessage(host, function, size);
+        if(data == NULL) {
+            return fmi3Fatal;
+        }
+        writeValueArguments(data, vr+first, count, countValues);
+        postMessage(host, size);
+        fmi3Status callStatus = waitForResponse(host);
+        if(callStatus <= fmi3Warning) {
+            memcpy((char*)values+first*valueSize, host->channel->response, countValues*valueSize);
+        }
+        status = worstStatus(status, callStatus);
+        if(status > fmi3Warning || nvr == 0) {
+            break;
+        }
+    }
+    return status;
+}
+
+
+//! @brief Sets values of a fixed size data type without waiting for the host, split into several messages if needed
+//! Errors are reported by the next call that waits for the host.
+static fmi3Status setValues(fmiHost *host, fmiHostFunction function, const fmi3ValueReference vr[], size_t nvr, const void *values, size_t nValues, size_t valueSize)
+{
+    size_t chunk = (nvr == nValues) ? getValuesPerMessage(valueSize) : nvr;
+    for(size_t first=0; first<nvr; first+=chunk) {
+        size_t count = (nvr-first < chunk) ? nvr-first : chunk;
+        size_t countValues = (nvr == nValues) ? count : nValues;
+        size_t size = sizeof(fmiHostValueArguments)+FMI4C_HOST_ALIGN(count*sizeof(fmi3ValueReference))+countValues*valueSize;
+        if(sizeof(fmiHostMessage)+size > FMI4C_HOST_MAX_MESSAGE_SIZE) {
+            printf("Too many array values for out-of-process call\n");
+            return fmi3Error;
+        }
+        char *data = beginMessage(host, function, size);
+        if(data == NULL) {
+            return fmi3Fatal;
+        }
+        data = writeValueArguments(data, vr+first, count, countValues);
+        memcpy(data, (const char*)values+first*valueSize, countValues*valueSize);
+        postMessage(host, size);
+    }
+    return fmi3OK;
+}
+
+
+// Get and set functions for fixed size data types, with the signatures of the FMI functions they replace
+#define HOST_VALUE_FUNCTIONS(TYPE) \
+static fmi3Status hostGet##TYPE(fmi3Instance instance, const fmi3ValueReference vr[], size_t nvr, fmi3##TYPE values[], size_t nValues) \
+{ \
+    return getValues((fmiHost*)instance, fmiHostGet##TYPE, vr, nvr, values, nValues, sizeof(fmi3##TYPE)); \
+} \
+static fmi3Status hostSet##TYPE(fmi3Instance instance, const fmi3ValueReference vr[], size_t nvr, const fmi3##TYPE values[], size_t nValues) \
+{ \
+    return setValues((fmiHost*)instance, fmiHostSet##TYPE, vr, nvr, values, nValues, sizeof(fmi3##TYPE)); \
+}
+
+HOST_VALUE_FUNCTIONS(Float64)
+HOST_VALUE_FUNCTIONS(Float32)
+HOST_VALUE_FUNCTIONS(Int64)
+HOST_VALUE_FUNCTIONS(Int32)
+HOST_VALUE_FUNCTIONS(Int16)
+HOST_VALUE_FUNCTIONS(Int8)
+HOST_VALUE_FUNCTIONS(UInt64)
+HOST_VALUE_FUNCTIONS(UInt32)
+HOST_VALUE_FUNCTIONS(UInt16)
+HOST_VALUE_FUNCTIONS(UInt8)
+HOST_VALUE_FUNCTIONS(Boolean)
+
+
+static fmi3Status hostGetString(fmi3Instance instance, const fmi3ValueReference vr[], size_t nvr, fmi3String values[], size_t nValues)
+{
+    fmiHost *host = (fmiHost*)instance;
+    size_t size = sizeof(fmiHostValueArguments)+FMI4C_HOST_ALIGN(nvr*sizeof(fmi3ValueReference));
+    if(sizeof(fmiHostMessage)+size > FMI4C_HOST_MAX_MESSAGE_SIZE) {
+        printf("Too many strings for out-of-process call\n");
+        return fmi3Error;
+    }
+    char *data = beginMessage(host, fmiHostGetString, size);
+    if(data == NULL) {
+        return fmi3Fatal;
+    }
+    writeValueArguments(data, vr, nvr, nValues);
+    postMessage(host, size);
+    fmi3Status status = waitForResponse(host);
+    if(status > fmi3Warning) {
+        return status;
+    }
+
+    //Strings must stay valid after the next message, so copy them out of the response area
+    size_t responseSize = host->channel->responseSize;
+    if(responseSize > host->stringsCapacity) {
+        fmi4cFree(host->strings);
+        host->strings = fmi4cMalloc(responseSize);
+        host->stringsCapacity = responseSize;
+    }
+    memcpy(host->strings, host->channel->response, responseSize);
+    const char *string = host->strings;
+    for(size_t i=0; i<nValues; ++i) {
+        values[i] = string;
+        string += strlen(string)+1;
+    }
+    return status;
+}
+
+
+static fmi3Status hostSetString(fmi3Instance instance, const fmi3ValueReference vr[], size_t nvr, const fmi3String values[], size_t nValues)
+{
+    fmiHost *host = (fmiHost*)instance;
+    size_t size = sizeof(fmiHostValueArguments)+FMI4C_HOST_ALIGN(nvr*sizeof(fmi3ValueReference));
+    for(size_t i=0; i<nValues; ++i) {
+        size += strlen(values[i])+1;
+    }
+    if(sizeof(fmiHostMessage)+size > FMI4C_HOST_MAX_MESSAGE_SIZE) {
+        printf("Too many strings for out-of-process call\n");
+        return fmi3Error;
+    }
+    char *data = beginMessage(host, fmiHostSetString, size);
+    if(data == NULL) {
+        return fmi3Fatal;
+    }
+    data = writeValueArguments(data, vr, nvr, nValues);
+    for(size_t i=0; i<nValues; ++i) {
+        size_t length = strlen(values[i])+1;
+        memcpy(data, values[i], length);
+        data += length;
+    }
+    postMessage(host, size);
+    return fmi3OK;
+}
+
+
+static fmi3Status hostSetDebugLogging(fmi3Instance instance, fmi3Boolean loggingOn, size_t nCategories, const fmi3String categories[])
+{
+    fmiHost *host = (fmiHost*)instance;
+    size_t size = sizeof(fmiHostDebugLoggingArguments);
+    for(size_t i=0; i<nCategories; ++i) {
+        size += strlen(categories[i])+1;
+    }
+    if(sizeof(fmiHostMessage)+size > FMI4C_HOST_MAX_MESSAGE_SIZE) {
+        return fmi3Error;
+    }
+    char *data = beginMessage(host, fmiHostSetDebugLogging, size);
+    if(data == NULL) {
+        return fmi3Fatal;
+    }
+    fmiHostDebugLoggingArguments *arguments = (fmiHostDebugLoggingArguments*)data;
+    arguments->numberOfCategories = nCategories;
+    arguments->loggingOn = loggingOn;
+    data += sizeof(fmiHostDebugLoggingArguments);
+    for(size_t i=0; i<nCategories; ++i) {
+        size_t length = strlen(categories[i])+1;
+        memcpy(data, categories[i], length);
+        data += length;
+    }
+    postMessage(host, size);
+    return waitForResponse(host);
+}
+
+
+static void hostFreeInstance(fmi3Instance instance)
+{
+    callHost((fmiHost*)instance, fmiHostFreeInstance, NULL, 0);
+}
+
+
+static fmi3Status hostEnterInitializationMode(fmi3Instance instance, fmi3Boolean toleranceDefined, fmi3Float64 tolerance,
+                                              fmi3Float64 startTime, fmi3Boolean stopTimeDefined, fmi3Float64 stopTime)
+{
+    fmiHostInitializationArguments arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.toleranceDefined = toleranceDefined;
+    arguments.tolerance = tolerance;
+    arguments.startTime = startTime;
+    arguments.stopTimeDefined = stopTimeDefined;
+    arguments.stopTime = stopTime;
+    return callHost((fmiHost*)instance, fmiHostEnterInitializationMode, &arguments, sizeof(arguments));
+}
+
+
+static fmi3Status hostExitInitializationMode(fmi3Instance instance)
+{
+    return callHost((fmiHost*)instance, fmiHostExitInitializationMode, NULL, 0);
+}
+
+
+static fmi3Status hostEnterEventMode(fmi3Instance instance)
+{
+    return callHost((fmiHost*)instance, fmiHostEnterEventMode, NULL, 0);
+}
+
+
+static fmi3Status hostEnterStepMode(fmi3Instance instance)
+{
+    return callHost((fmiHost*)instance, fmiHostEnterStepMode, NULL, 0);
+}
+
+
+static fmi3Status hostTerminate(fmi3Instance instance)
+{
+    return callHost((fmiHost*)instance, fmiHostTerminate, NULL, 0);
+}
+
+
+static fmi3Status hostReset(fmi3Instance instance)
+{
+    return callHost((fmiHost*)instance, fmiHostReset, NULL, 0);
+}
+
+
+static fmi3Status hostDoStep(fmi3Instance instance, fmi3Float64 currentCommunicationPoint, fmi3Float64 communicationStepSize,
+                             fmi3Boolean noSetFMUStatePriorToCurrentPoint, fmi3Boolean *eventHandlingNeeded,
+                             fmi3Boolean *terminateSimulation, fmi3Boolean *earlyReturn, fmi3Float64 *lastSuccessfulTime)
+{
+    fmiHost *host = (fmiHost*)instance;
+    fmiHostDoStepArguments arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.currentCommunicationPoint = currentCommunicationPoint;
+    arguments.communicationStepSize = communicationStepSize;
+    arguments.noSetFMUStatePriorToCurrentPoint = noSetFMUStatePriorToCurrentPoint;
+    fmi3Status status = callHost(host, fmiHostDoStep, &arguments, sizeof(arguments));
+    if(status == fmi3Fatal) {
+        return status;
+    }
+    const fmiHostDoStepResults *results = (const fmiHostDoStepResults*)host->channel->response;
+    (*eventHandlingNeeded) = results->eventHandlingNeeded;
+    (*terminateSimulation) = results->terminateSimulation;
+    (*earlyReturn) = results->earlyReturn;
+    (*lastSuccessfulTime) = results->lastSuccessfulTime;
+    return status;
+}
+
+
+//! @brief Starts an FMU host process for an FMI 3 library
+//! @param hostExecutable Path to the fmi4c_host executable
+//! @param libraryPath Absolute path to FMU shared library
+//! @returns FMU host, or NULL on failure
+fmiHost *startHost(const char *hostExecutable, const char *libraryPath)
+{
+    //The channel is an anonymous shared memory file, inherited by the host process
+    int fd = memfd_create("fmi4c_host", 0);
+    if(fd < 0 || ftruncate(fd, sizeof(fmiHostChannel)) != 0) {
+        printf("Failed to create shared memory for FMU host: %s\n", strerror(errno));
+        if(fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+    void *channel = mmap(NULL, sizeof(fmiHostChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(channel == MAP_FAILED) {
+        printf("Failed to map shared memory for FMU host: %s\n", strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    char fdArgument[16];
+    snprintf(fdArgument, sizeof(fdArgument), "%d", fd);
+    char *argv[] = { (char*)hostExecutable, fdArgument, (char*)libraryPath, NULL };
+    pid_t pid;
+    int error = posix_spawn(&pid, hostExecutable, NULL, NULL, argv, environ);
+    close(fd);
+    if(error != 0) {
+        printf("Failed to start FMU host %s: %s\n", hostExecutable, strerror(error));
+        munmap(channel, sizeof(fmiHostChannel));
+        return NULL;
+    }
+
+    fmiHost *host = fmi4cMalloc(sizeof(fmiHost));
+    host->channel = (fmiHostChannel*)channel;
+    host->pid = pid;
+    host->terminated = false;
+    host->responsesSeen = 0;
+    host->spinCount = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? FMI4C_HOST_SPIN_COUNT : 0;
+    host->strings = NULL;
+    host->stringsCapacity = 0;
+
+    //The host responds once when it has loaded the library
+    if(waitForResponse(host) != fmi3OK) {
+        printf("FMU host failed to load %s\n", libraryPath);
+        stopHost(host);
+        return NULL;
+    }
+    return host;
+}
+
+
+//! @brief Stops an FMU host process and frees the host
+//! @param host FMU host
+void stopHost(fmiHost *host)
+{
+    if(!host->terminated) {
+        char *data = beginMessage(host, fmiHostShutdown, 0);
+        if(data != NULL) {
+            postMessage(host, 0);
+        }
+        //Give the host one second to free its instance, then kill it
+        bool exited = (waitpid(host->pid, NULL, WNOHANG) != 0);
+        for(int i=0; i<100 && !exited; ++i) {
+            struct timespec delay = { 0, 10000000 };
+            nanosleep(&delay, NULL);
+            exited = (waitpid(host->pid, NULL, WNOHANG) != 0);
+        }
+        if(!exited) {
+            kill(host->pid, SIGKILL);
+            waitpid(host->pid, NULL, 0);
+        }
+    }
+    munmap(host->channel, sizeof(fmiHostChannel));
+    fmi4cFree(host->strings);
+    fmi4cFree(host);
+}
+
+
+//! @brief Instantiates the FMI 3 Co-Simulation FMU in the host process
+//! Callbacks are not forwarded to the host, log messages are printed by the host.
+//! @returns The host, to be used as FMI instance, or NULL on failure
+fmi3Instance instantiateHostCoSimulation(fmiHost *host, fmi3String instanceName, fmi3String instantiationToken, fmi3String resourcePath,
+                                         fmi3Boolean visible, fmi3Boolean loggingOn, fmi3Boolean eventModeUsed, fmi3Boolean earlyReturnAllowed,
+                                         const fmi3ValueReference requiredIntermediateVariables[], size_t nRequiredIntermediateVariables)
+{
+    size_t size = sizeof(fmiHostInstantiateArguments)+FMI4C_HOST_ALIGN(nRequiredIntermediateVariables*sizeof(fmi3ValueReference));
+    size += strlen(instanceName)+1 + strlen(instantiationToken)+1 + strlen(resourcePath)+1;
+    if(sizeof(fmiHostMessage)+size > FMI4C_HOST_MAX_MESSAGE_SIZE) {
+        return NULL;
+    }
+    char *data = beginMessage(host, fmiHostInstantiateCoSimulation, size);
+    if(data == NULL) {
+        return NULL;
+    }
+    fmiHostInstantiateArguments *arguments = (fmiHostInstantiateArguments*)data;
+    arguments->numberOfRequiredIntermediateVariables = nRequiredIntermediateVariables;
+    arguments->visible = visible;
+    arguments->loggingOn = loggingOn;
+    arguments->eventModeUsed = eventModeUsed;
+    arguments->earlyReturnAllowed = earlyReturnAllowed;
+    data += sizeof(fmiHostInstantiateArguments);
+    memcpy(data, requiredIntermediateVariables, nRequiredIntermediateVariables*sizeof(fmi3ValueReference));
+    data += FMI4C_HOST_ALIGN(nRequiredIntermediateVariables*sizeof(fmi3ValueReference));
+    const char *strings[] = { instanceName, instantiationToken, resourcePath };
+    for(int i=0; i<3; ++i) {
+        size_t length = strlen(strings[i])+1;
+        memcpy(data, strings[i], length);
+        data += length;
+    }
+    postMessage(host, size);
+    return (waitForResponse(host) == fmi3OK) ? (fmi3Instance)host : NULL;
+}
+
+
+//! @brief Replaces the FMI 3 functions of a handle with calls to its host process
+//! Functions that are not forwarded keep their placeholders.
+//! @param fmu FMU handle with a started host
+void assignHostFunctionsFmi3(fmiHandle *fmu)
+{
+    fmu->fmi3.setDebugLogging = hostSetDebugLogging;
+    fmu->fmi3.freeInstance = hostFreeInstance;
+    fmu->fmi3.enterInitializationMode = hostEnterInitializationMode;
+    fmu->fmi3.exitInitializationMode = hostExitInitializationMode;
+    fmu->fmi3.enterEventMode = hostEnterEventMode;
+    fmu->fmi3.terminate = hostTerminate;
+    fmu->fmi3.reset = hostReset;
+    fmu->fmi3.getFloat64 = hostGetFloat64;
+    fmu->fmi3.setFloat64 = hostSetFloat64;
+    fmu->fmi3.getFloat32 = hostGetFloat32;
+    fmu->fmi3.setFloat32 = hostSetFloat32;
+    fmu->fmi3.getInt64 = hostGetInt64;
+    fmu->fmi3.setInt64 = hostSetInt64;
+    fmu->fmi3.getInt32 = hostGetInt32;
+    fmu->fmi3.setInt32 = hostSetInt32;
+    fmu->fmi3.getInt16 = hostGetInt16;
+    fmu->fmi3.setInt16 = hostSetInt16;
+    fmu->fmi3.getInt8 = hostGetInt8;
+    fmu->fmi3.setInt8 = hostSetInt8;
+    fmu->fmi3.getUInt64 = hostGetUInt64;
+    fmu->fmi3.setUInt64 = hostSetUInt64;
+    fmu->fmi3.getUInt32 = hostGetUInt32;
+    fmu->fmi3.setUInt32 = hostSetUInt32;
+    fmu->fmi3.getUInt16 = hostGetUInt16;
+    fmu->fmi3.setUInt16 = hostSetUInt16;
+    fmu->fmi3.getUInt8 = hostGetUInt8;
+    fmu->fmi3.setUInt8 = hostSetUInt8;
+    fmu->fmi3.getBoolean = hostGetBoolean;
+    fmu->fmi3.setBoolean = hostSetBoolean;
+    fmu->fmi3.getString = hostGetString;
+    fmu->fmi3.setString = hostSetString;
+    fmu->fmi3.enterStepMode = hostEnterStepMode;
+    fmu->fmi3.doStep = hostDoStep;
+}
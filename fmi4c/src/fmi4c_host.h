@@ -0,0 +1,126 @@
+#ifndef FMI4C_HOST_H
+#define FMI4C_HOST_H
+
+// Shared memory protocol between fmi4c and the out-of-process FMU host (fmi4c_host), see fmi4c_setOutOfProcess()
+//
+// The client writes requests into a single-producer single-consumer ring buffer. Calls that return nothing but
+// a status (the set functions) are not waited for, so values set before a step are transferred as one batch
+// and their worst status is reported by the next call that waits. All other calls wait for the response, which
+// the host writes into a separate response area. Both sides spin briefly before sleeping on a futex, so that
+// the short calls of a simulation step do not go through the kernel scheduler.
+
+#include <stdint.h>
+
+#define FMI4C_HOST_RING_SIZE (1 << 20)                          // Power of two
+#define FMI4C_HOST_MAX_MESSAGE_SIZE (FMI4C_HOST_RING_SIZE / 4)  // Larger get and set calls are split
+#define FMI4C_HOST_RESPONSE_SIZE FMI4C_HOST_MAX_MESSAGE_SIZE
+#define FMI4C_HOST_SPIN_COUNT 20000                             // Polls before sleeping on a futex
+
+typedef enum {
+    fmiHostPadding,                 // Fills the end of the ring buffer, the next message starts at offset 0
+    fmiHostShutdown,
+    fmiHostInstantiateCoSimulation,
+    fmiHostFreeInstance,
+    fmiHostSetDebugLogging,
+    fmiHostEnterInitializationMode,
+    fmiHostExitInitializationMode,
+    fmiHostEnterEventMode,
+    fmiHostEnterStepMode,
+    fmiHostTerminate,
+    fmiHostReset,
+    fmiHostDoStep,
+    fmiHostGetFloat64,
+    fmiHostGetFloat32,
+    fmiHostGetInt64,
+    fmiHostGetInt32,
+    fmiHostGetInt16,
+    fmiHostGetInt8,
+    fmiHostGetUInt64,
+    fmiHostGetUInt32,
+    fmiHostGetUInt16,
+    fmiHostGetUInt8,
+    fmiHostGetBoolean,
+    fmiHostGetString,
+    fmiHostSetFloat64,
+    fmiHostSetFloat32,
+    fmiHostSetInt64,
+    fmiHostSetInt32,
+    fmiHostSetInt16,
+    fmiHostSetInt8,
+    fmiHostSetUInt64,
+    fmiHostSetUInt32,
+    fmiHostSetUInt16,
+    fmiHostSetUInt8,
+    fmiHostSetBoolean,
+    fmiHostSetString
+} fmiHostFunction;
+
+// Header of each message in the ring buffer, followed by size bytes of arguments (padded to 8 bytes)
+typedef struct {
+    uint32_t function;
+    uint32_t size;
+} fmiHostMessage;
+
+// Arguments of get and set messages, followed by the value references (padded to 8 bytes) and, for set
+// messages, the values. Strings are stored null-terminated one after another.
+typedef struct {
+    uint64_t numberOfValueReferences;
+    uint64_t numberOfValues;
+} fmiHostValueArguments;
+
+typedef struct {
+    double currentCommunicationPoint;
+    double communicationStepSize;
+    uint8_t noSetFMUStatePriorToCurrentPoint;
+} fmiHostDoStepArguments;
+
+typedef struct {
+    double lastSuccessfulTime;
+    uint8_t eventHandlingNeeded;
+    uint8_t terminateSimulation;
+    uint8_t earlyReturn;
+} fmiHostDoStepResults;
+
+typedef struct {
+    double tolerance;
+    double startTime;
+    double stopTime;
+    uint8_t toleranceDefined;
+    uint8_t stopTimeDefined;
+} fmiHostInitializationArguments;
+
+// Followed by the required intermediate variables (padded to 8 bytes), then instance name, instantiation token
+// and resource path as null-terminated strings
+typedef struct {
+    uint64_t numberOfRequiredIntermediateVariables;
+    uint8_t visible;
+    uint8_t loggingOn;
+    uint8_t eventModeUsed;
+    uint8_t earlyReturnAllowed;
+} fmiHostInstantiateArguments;
+
+// Followed by the categories as null-terminated strings
+typedef struct {
+    uint64_t numberOfCategories;
+    uint8_t loggingOn;
+} fmiHostDebugLoggingArguments;
+
+// Shared memory mapped by both processes
+typedef struct {
+    // Written by the client
+    uint64_t head;                  // Bytes written to the ring buffer
+    uint32_t requestsPosted;        // Futex word, incremented for each message
+    uint32_t clientWaiting;
+    // Written by the host
+    uint64_t tail;                  // Bytes consumed from the ring buffer
+    uint32_t responsesPosted;       // Futex word, incremented for each response
+    uint32_t hostWaiting;
+    int32_t status;                 // Status of the last waited for call, including earlier unwaited calls
+    uint32_t responseSize;
+    char ring[FMI4C_HOST_RING_SIZE];
+    char response[FMI4C_HOST_RESPONSE_SIZE];
+} fmiHostChannel;
+
+#define FMI4C_HOST_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#endif // FMI4C_HOST_H
@@ -0,0 +1,366 @@
+// Out-of-process FMU host, started by fmi4c for handles set up with fmi4c_setOutOfProcess()
+//
+// Usage: fmi4c_host <shared memory file descriptor> <FMU library path>
+//
+// Loads an FMI 3 library and runs the calls that fmi4c writes into the shared channel (see fmi4c_host.h),
+// until it is told to shut down or fmi4c goes away.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // For syscall() and strdup()
+#endif
+#include "fmi4c_host.h"
+#include "fmi4c_types_fmi3.h"
+#include "fmi4c_functions_fmi3.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static fmiHostChannel *channel;
+static fmi3Instance instance = NULL;
+static char *instanceName = NULL;
+static fmi3Status deferredStatus = fmi3OK;    // Worst status of calls not waited for by the client
+static int spinCount = 0;                     // Polls before sleeping, 0 on single processor systems
+
+static struct {
+    fmi3InstantiateCoSimulation_t instantiateCoSimulation;
+    fmi3FreeInstance_t freeInstance;
+    fmi3SetDebugLogging_t setDebugLogging;
+    fmi3EnterInitializationMode_t enterInitializationMode;
+    fmi3ExitInitializationMode_t exitInitializationMode;
+    fmi3EnterEventMode_t enterEventMode;
+    fmi3EnterStepMode_t enterStepMode;
+    fmi3Terminate_t terminate;
+    fmi3Reset_t reset;
+    fmi3DoStep_t doStep;
+    fmi3GetFloat64_t getFloat64;
+    fmi3GetFloat32_t getFloat32;
+    fmi3GetInt64_t getInt64;
+    fmi3GetInt32_t getInt32;
+    fmi3GetInt16_t getInt16;
+    fmi3GetInt8_t getInt8;
+    fmi3GetUInt64_t getUInt64;
+    fmi3GetUInt32_t getUInt32;
+    fmi3GetUInt16_t getUInt16;
+    fmi3GetUInt8_t getUInt8;
+    fmi3GetBoolean_t getBoolean;
+    fmi3GetString_t getString;
+    fmi3SetFloat64_t setFloat64;
+    fmi3SetFloat32_t setFloat32;
+    fmi3SetInt64_t setInt64;
+    fmi3SetInt32_t setInt32;
+    fmi3SetInt16_t setInt16;
+    fmi3SetInt8_t setInt8;
+    fmi3SetUInt64_t setUInt64;
+    fmi3SetUInt32_t setUInt32;
+    fmi3SetUInt16_t setUInt16;
+    fmi3SetUInt8_t setUInt8;
+    fmi3SetBoolean_t setBoolean;
+    fmi3SetString_t setString;
+} functions;
+
+
+//! @brief Posts the status of a waited for call, and any earlier errors, to the client
+static void respond(fmi3Status status, size_t responseSize)
+{
+    channel->status = (status > deferredStatus) ? status : deferredStatus;
+    channel->responseSize = (uint32_t)responseSize;
+    deferredStatus = fmi3OK;
+    __atomic_add_fetch(&channel->responsesPosted, 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&channel->clientWaiting, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &channel->responsesPosted, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+
+//! @brief Waits until the client has written a message past tail
+//! Exits if the client process goes away (the host is then reparented).
+static void waitForMessage(uint64_t tail)
+{
+    pid_t client = getppid();
+    for(int i=0; __atomic_load_n(&channel->head, __ATOMIC_ACQUIRE) == tail; ++i) {
+        if(i < spinCount) {
+            continue;
+        }
+        if(getppid() != client) {
+            exit(1);
+        }
+        __atomic_store_n(&channel->hostWaiting, 1, __ATOMIC_SEQ_CST);
+        uint32_t posted = __atomic_load_n(&channel->requestsPosted, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&channel->head, __ATOMIC_SEQ_CST) == tail) {
+            struct timespec timeout = { 1, 0 };
+            syscall(SYS_futex, &channel->requestsPosted, FUTEX_WAIT, posted, &timeout, NULL, 0);
+        }
+        __atomic_store_n(&channel->hostWaiting, 0, __ATOMIC_RELAXED);
+    }
+}
+
+
+//! @brief Prints log messages from the FMU, since the client callback can not be called from this process
+static void logMessage(fmi3InstanceEnvironment instanceEnvironment, fmi3Status status, fmi3String category, fmi3String message)
+{
+    (void)instanceEnvironment;
+    printf("[%s] %s (status %d): %s\n", instanceName != NULL ? instanceName : "", category, (int)status, message);
+    fflush(stdout);
+}
+
+
+//! @brief Reads get and set arguments from a message
+//! @returns Pointer to values in set messages
+static const char *readValueArguments(const char *data, const fmi3ValueReference **vr, size_t *nvr, size_t *nValues)
+{
+    const fmiHostValueArguments *arguments = (const fmiHostValueArguments*)data;
+    (*nvr) = (size_t)arguments->numberOfValueReferences;
+    (*nValues) = (size_t)arguments->numberOfValues;
+    (*vr) = (const fmi3ValueReference*)(data+sizeof(fmiHostValueArguments));
+    return data+sizeof(fmiHostValueArguments)+FMI4C_HOST_ALIGN((*nvr)*sizeof(fmi3ValueReference));
+}
+
+
+// Dispatches get and set messages for fixed size data types
+#define HOST_VALUE_CASES(TYPE, GET, SET) \
+    case fmiHostGet##TYPE: \
+        readValueArguments(data, &vr, &nvr, &nValues); \
+        respond(functions.GET(instance, vr, nvr, (fmi3##TYPE*)channel->response, nValues), nValues*sizeof(fmi3##TYPE)); \
+        break; \
+    case fmiHostSet##TYPE: \
+        values = readValueArguments(data, &vr, &nvr, &nValues); \
+        status = functions.SET(instance, vr, nvr, (const fmi3##TYPE*)values, nValues); \
+        deferredStatus = (status > deferredStatus) ? status : deferredStatus; \
+        break;
+
+
+//! @brief Runs one call from the client
+//! @returns False when told to shut down
+static bool dispatch(fmiHostFunction function, const char *data)
+{
+    const fmi3ValueReference *vr;
+    size_t nvr, nValues;
+    const char *values;
+    fmi3Status status;
+
+    switch(function) {
+    case fmiHostPadding:
+        break;
+    case fmiHostShutdown:
+        return false;
+    case fmiHostInstantiateCoSimulation: {
+        const fmiHostInstantiateArguments *arguments = (const fmiHostInstantiateArguments*)data;
+        const fmi3ValueReference *requiredIntermediateVariables = (const fmi3ValueReference*)(arguments+1);
+        size_t nRequired = (size_t)arguments->numberOfRequiredIntermediateVariables;
+        const char *name = (const char*)(arguments+1)+FMI4C_HOST_ALIGN(nRequired*sizeof(fmi3ValueReference));
+        const char *instantiationToken = name+strlen(name)+1;
+        const char *resourcePath = instantiationToken+strlen(instantiationToken)+1;
+        free(instanceName);
+        instanceName = strdup(name);
+        if(instance == NULL) {
+            instance = functions.instantiateCoSimulation(instanceName, instantiationToken, resourcePath,
+                                                         arguments->visible, arguments->loggingOn,
+                                                         arguments->eventModeUsed, arguments->earlyReturnAllowed,
+                                                         requiredIntermediateVariables, nRequired, NULL, logMessage, NULL);
+        }
+        respond(instance != NULL ? fmi3OK : fmi3Error, 0);
+        break;
+    }
+    case fmiHostFreeInstance:
+        if(instance != NULL) {
+            functions.freeInstance(instance);
+            instance = NULL;
+        }
+        respond(fmi3OK, 0);
+        break;
+    case fmiHostSetDebugLogging: {
+        const fmiHostDebugLoggingArguments *arguments = (const fmiHostDebugLoggingArguments*)data;
+        size_t nCategories = (size_t)arguments->numberOfCategories;
+        fmi3String *categories = malloc((nCategories+1)*sizeof(fmi3String));
+        const char *category = (const char*)(arguments+1);
+        for(size_t i=0; i<nCategories; ++i) {
+            categories[i] = category;
+            category += strlen(category)+1;
+        }
+        respond(functions.setDebugLogging(instance, arguments->loggingOn, nCategories, categories), 0);
+        free(categories);
+        break;
+    }
+    case fmiHostEnterInitializationMode: {
+        const fmiHostInitializationArguments *arguments = (const fmiHostInitializationArguments*)data;
+        respond(functions.enterInitializationMode(instance, arguments->toleranceDefined, arguments->tolerance, arguments->startTime,
+                                                  arguments->stopTimeDefined, arguments->stopTime), 0);
+        break;
+    }
+    case fmiHostExitInitializationMode:
+        respond(functions.exitInitializationMode(instance), 0);
+        break;
+    case fmiHostEnterEventMode:
+        respond(functions.enterEventMode(instance), 0);
+        break;
+    case fmiHostEnterStepMode:
+        respond(functions.enterStepMode != NULL ? functions.enterStepMode(instance) : fmi3Error, 0);
+        break;
+    case fmiHostTerminate:
+        respond(functions.terminate(instance), 0);
+        break;
+    case fmiHostReset:
+        respond(functions.reset(instance), 0);
+        break;
+    case fmiHostDoStep: {
+        const fmiHostDoStepArguments *arguments = (const fmiHostDoStepArguments*)data;
+        fmi3Boolean eventHandlingNeeded = false, terminateSimulation = false, earlyReturn = false;
+        fmi3Float64 lastSuccessfulTime = arguments->currentCommunicationPoint;
+        status = functions.doStep(instance, arguments->currentCommunicationPoint, arguments->communicationStepSize,
+                                  arguments->noSetFMUStatePriorToCurrentPoint, &eventHandlingNeeded, &terminateSimulation,
+                                  &earlyReturn, &lastSuccessfulTime);
+        fmiHostDoStepResults *results = (fmiHostDoStepResults*)channel->response;
+        results->eventHandlingNeeded = eventHandlingNeeded;
+        results->terminateSimulation = terminateSimulation;
+        results->earlyReturn = earlyReturn;
+        results->lastSuccessfulTime = lastSuccessfulTime;
+        respond(status, sizeof(fmiHostDoStepResults));
+        break;
+    }
+    HOST_VALUE_CASES(Float64, getFloat64, setFloat64)
+    HOST_VALUE_CASES(Float32, getFloat32, setFloat32)
+    HOST_VALUE_CASES(Int64, getInt64, setInt64)
+    HOST_VALUE_CASES(Int32, getInt32, setInt32)
+    HOST_VALUE_CASES(Int16, getInt16, setInt16)
+    HOST_VALUE_CASES(Int8, getInt8, setInt8)
+    HOST_VALUE_CASES(UInt64, getUInt64, setUInt64)
+    HOST_VALUE_CASES(UInt32, getUInt32, setUInt32)
+    HOST_VALUE_CASES(UInt16, getUInt16, setUInt16)
+    HOST_VALUE_CASES(UInt8, getUInt8, setUInt8)
+    HOST_VALUE_CASES(Boolean, getBoolean, setBoolean)
+    case fmiHostGetString: {
+        readValueArguments(data, &vr, &nvr, &nValues);
+        fmi3String *strings = malloc((nValues+1)*sizeof(fmi3String));
+        status = functions.getString(instance, vr, nvr, strings, nValues);
+        size_t size = 0;
+        for(size_t i=0; status <= fmi3Warning && i<nValues; ++i) {
+            size_t length = strlen(strings[i])+1;
+            if(size+length > FMI4C_HOST_RESPONSE_SIZE) {
+                printf("Strings too long for out-of-process call\n");
+                status = fmi3Error;
+                break;
+            }
+            memcpy(channel->response+size, strings[i], length);
+            size += length;
+        }
+        free(strings);
+        respond(status, size);
+        break;
+    }
+    case fmiHostSetString: {
+        values = readValueArguments(data, &vr, &nvr, &nValues);
+        fmi3String *strings = malloc((nValues+1)*sizeof(fmi3String));
+        for(size_t i=0; i<nValues; ++i) {
+            strings[i] = values;
+            values += strlen(values)+1;
+        }
+        status = functions.setString(instance, vr, nvr, strings, nValues);
+        deferredStatus = (status > deferredStatus) ? status : deferredStatus;
+        free(strings);
+        break;
+    }
+    default:
+        respond(fmi3Error, 0);
+        break;
+    }
+    return true;
+}
+
+
+//! @brief Resolves a function from the FMU library
+static void *loadFunction(void *dll, const char *name, bool required, bool *ok)
+{
+    void *function = dlsym(dll, name);
+    if(function == NULL && required) {
+        printf("Failed to load function \"%s\"\n", name);
+        (*ok) = false;
+    }
+    return function;
+}
+
+
+int main(int argc, char *argv[])
+{
+    if(argc != 3) {
+        fprintf(stderr, "Usage: fmi4c_host <shared memory file descriptor> <FMU library path>\n");
+        return 1;
+    }
+    int fd = atoi(argv[1]);
+    channel = mmap(NULL, sizeof(fmiHostChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(channel == MAP_FAILED) {
+        fprintf(stderr, "fmi4c_host: failed to map shared memory\n");
+        return 1;
+    }
+
+    spinCount = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? FMI4C_HOST_SPIN_COUNT : 0;
+
+    bool ok = true;
+    void *dll = dlopen(argv[2], RTLD_NOW|RTLD_LOCAL);
+    if(dll == NULL) {
+        printf("Loading shared object failed: %s (%s)\n", argv[2], dlerror());
+        respond(fmi3Fatal, 0);
+        return 1;
+    }
+    functions.instantiateCoSimulation = (fmi3InstantiateCoSimulation_t)loadFunction(dll, "fmi3InstantiateCoSimulation", true, &ok);
+    functions.freeInstance = (fmi3FreeInstance_t)loadFunction(dll, "fmi3FreeInstance", true, &ok);
+    functions.setDebugLogging = (fmi3SetDebugLogging_t)loadFunction(dll, "fmi3SetDebugLogging", true, &ok);
+    functions.enterInitializationMode = (fmi3EnterInitializationMode_t)loadFunction(dll, "fmi3EnterInitializationMode", true, &ok);
+    functions.exitInitializationMode = (fmi3ExitInitializationMode_t)loadFunction(dll, "fmi3ExitInitializationMode", true, &ok);
+    functions.enterEventMode = (fmi3EnterEventMode_t)loadFunction(dll, "fmi3EnterEventMode", true, &ok);
+    functions.enterStepMode = (fmi3EnterStepMode_t)loadFunction(dll, "fmi3EnterStepMode", false, &ok);
+    functions.terminate = (fmi3Terminate_t)loadFunction(dll, "fmi3Terminate", true, &ok);
+    functions.reset = (fmi3Reset_t)loadFunction(dll, "fmi3Reset", true, &ok);
+    functions.doStep = (fmi3DoStep_t)loadFunction(dll, "fmi3DoStep", true, &ok);
+    functions.getFloat64 = (fmi3GetFloat64_t)loadFunction(dll, "fmi3GetFloat64", true, &ok);
+    functions.getFloat32 = (fmi3GetFloat32_t)loadFunction(dll, "fmi3GetFloat32", true, &ok);
+    functions.getInt64 = (fmi3GetInt64_t)loadFunction(dll, "fmi3GetInt64", true, &ok);
+    functions.getInt32 = (fmi3GetInt32_t)loadFunction(dll, "fmi3GetInt32", true, &ok);
+    functions.getInt16 = (fmi3GetInt16_t)loadFunction(dll, "fmi3GetInt16", true, &ok);
+    functions.getInt8 = (fmi3GetInt8_t)loadFunction(dll, "fmi3GetInt8", true, &ok);
+    functions.getUInt64 = (fmi3GetUInt64_t)loadFunction(dll, "fmi3GetUInt64", true, &ok);
+    functions.getUInt32 = (fmi3GetUInt32_t)loadFunction(dll, "fmi3GetUInt32", true, &ok);
+    functions.getUInt16 = (fmi3GetUInt16_t)loadFunction(dll, "fmi3GetUInt16", true, &ok);
+    functions.getUInt8 = (fmi3GetUInt8_t)loadFunction(dll, "fmi3GetUInt8", true, &ok);
+    functions.getBoolean = (fmi3GetBoolean_t)loadFunction(dll, "fmi3GetBoolean", true, &ok);
+    functions.getString = (fmi3GetString_t)loadFunction(dll, "fmi3GetString", true, &ok);
+    functions.setFloat64 = (fmi3SetFloat64_t)loadFunction(dll, "fmi3SetFloat64", true, &ok);
+    functions.setFloat32 = (fmi3SetFloat32_t)loadFunction(dll, "fmi3SetFloat32", true, &ok);
+    functions.setInt64 = (fmi3SetInt64_t)loadFunction(dll, "fmi3SetInt64", true, &ok);
+    functions.setInt32 = (fmi3SetInt32_t)loadFunction(dll, "fmi3SetInt32", true, &ok);
+    functions.setInt16 = (fmi3SetInt16_t)loadFunction(dll, "fmi3SetInt16", true, &ok);
+    functions.setInt8 = (fmi3SetInt8_t)loadFunction(dll, "fmi3SetInt8", true, &ok);
+    functions.setUInt64 = (fmi3SetUInt64_t)loadFunction(dll, "fmi3SetUInt64", true, &ok);
+    functions.setUInt32 = (fmi3SetUInt32_t)loadFunction(dll, "fmi3SetUInt32", true, &ok);
+    functions.setUInt16 = (fmi3SetUInt16_t)loadFunction(dll, "fmi3SetUInt16", true, &ok);
+    functions.setUInt8 = (fmi3SetUInt8_t)loadFunction(dll, "fmi3SetUInt8", true, &ok);
+    functions.setBoolean = (fmi3SetBoolean_t)loadFunction(dll, "fmi3SetBoolean", true, &ok);
+    functions.setString = (fmi3SetString_t)loadFunction(dll, "fmi3SetString", true, &ok);
+    respond(ok ? fmi3OK : fmi3Fatal, 0);
+    if(!ok) {
+        return 1;
+    }
+
+    uint64_t tail = channel->tail;
+    bool running = true;
+    while(running) {
+        waitForMessage(tail);
+        const fmiHostMessage *message = (const fmiHostMessage*)(channel->ring+(tail & (FMI4C_HOST_RING_SIZE-1)));
+        running = dispatch((fmiHostFunction)message->function, (const char*)(message+1));
+        tail += FMI4C_HOST_ALIGN(sizeof(fmiHostMessage)+message->size);
+        __atomic_store_n(&channel->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    if(instance != NULL) {
+        functions.freeInstance(instance);
+    }
+    dlclose(dll);
+    return 0;
+}
@@ -0,0 +1,389 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+
+#include <kinsol/kinsol.h>
+#include <nvector/nvector_serial.h>
+#include <sunlinsol/sunlinsol_spgmr.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Loop variables set in or read from one FMU, with buffers for one set, get and directional derivative call each
+typedef struct {
+    fmiHandle *fmu;
+    int numberOfInputs;
+    int numberOfOutputs;
+    int *inputIndices;                      // Connection index of each input
+    int *outputIndices;                     // Connection index of each output
+    fmi3ValueReference *inputValueReferences;
+    fmi3ValueReference *outputValueReferences;
+    double *inputValues;                    // Also used for the seed of directional derivatives
+    double *outputValues;                   // Also used for the sensitivity of directional derivatives
+} fmiAlgebraicLoopFmu;
+
+// Algebraic loop over connections output -> input between FMUs, solved with KINSOL (Newton-Krylov, SPGMR)
+// For the input values u, the residual is F(u) = u - y(u), where y are the connected output values.
+struct fmiAlgebraicLoop {
+    int numberOfConnections;
+    int numberOfFmus;
+    fmiAlgebraicLoopFmu *fmus;
+    bool directionalDerivatives;            // All FMUs with inputs and outputs in the loop provide directional derivatives
+    void *kinsolMemory;
+    N_Vector inputs;
+    N_Vector scaling;
+    N_Vector lastInputs;                    // Input values last set in the FMUs
+    bool lastInputsValid;
+    SUNLinearSolver linearSolver;
+    int status;                             // Worst status of FMU calls made from KINSOL callbacks
+    long numberOfResidualEvaluations;
+    long numberOfJacobianProducts;
+    long numberOfIterations;
+};
+
+
+//! @brief Records the status of an FMU call from a KINSOL callback and converts it to a KINSOL return value
+//! Discard is returned as a recoverable error, so that KINSOL may try a shorter step.
+static int callbackResult(fmiAlgebraicLoop *loop, int status)
+{
+    if(status > loop->status) {
+        loop->status = status;
+    }
+    if(status == fmi3Discard) {
+        return 1;
+    }
+    return (status > fmi3Discard) ? -1 : 0;
+}
+
+
+//! @brief Sets input values of the loop in all FMUs, with one set call per FMU
+static int setInputs(fmiAlgebraicLoop *loop, N_Vector u)
+{
+    double *values = NV_DATA_S(u);
+    int worstStatus = fmi3OK;
+    for(int i=0; i<loop->numberOfFmus && worstStatus < fmi3Discard; ++i) {
+        fmiAlgebraicLoopFmu *fmu = &loop->fmus[i];
+        if(fmu->numberOfInputs == 0) {
+            continue;
+        }
+        for(int k=0; k<fmu->numberOfInputs; ++k) {
+            fmu->inputValues[k] = values[fmu->inputIndices[k]];
+        }
+        int status;
+        if(fmu->fmu->version == fmiVersion2) {
+            status = fmi2_setReal(fmu->fmu, fmu->inputValueReferences, fmu->numberOfInputs, fmu->inputValues);
+        }
+        else {
+            status = fmi3_setFloat64(fmu->fmu, fmu->inputValueReferences, fmu->numberOfInputs, fmu->inputValues, fmu->numberOfInputs);
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+    }
+    loop->lastInputsValid = (worstStatus < fmi3Discard);
+    if(loop->lastInputsValid) {
+        N_VScale(1, u, loop->lastInputs);
+    }
+    return worstStatus;
+}
+
+
+//! @brief Gets output values of the loop from all FMUs, with one get call per FMU
+static int getOutputs(fmiAlgebraicLoop *loop, N_Vector y)
+{
+    double *values = NV_DATA_S(y);
+    int worstStatus = fmi3OK;
+    for(int i=0; i<loop->numberOfFmus && worstStatus < fmi3Discard; ++i) {
+        fmiAlgebraicLoopFmu *fmu = &loop->fmus[i];
+        if(fmu->numberOfOutputs == 0) {
+            continue;
+        }
+        int status;
+        if(fmu->fmu->version == fmiVersion2) {
+            status = fmi2_getReal(fmu->fmu, fmu->outputValueReferences, fmu->numberOfOutputs, fmu->outputValues);
+        }
+        else {
+            status = fmi3_getFloat64(fmu->fmu, fmu->outputValueReferences, fmu->numberOfOutputs, fmu->outputValues, fmu->numberOfOutputs);
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        for(int k=0; k<fmu->numberOfOutputs; ++k) {
+            values[fmu->outputIndices[k]] = fmu->outputValues[k];
+        }
+    }
+    return worstStatus;
+}
+
+
+//! @brief KINSOL system function, F(u) = u - y(u)
+static int residual(N_Vector u, N_Vector f, void *userData)
+{
+    fmiAlgebraicLoop *loop = userData;
+    ++loop->numberOfResidualEvaluations;
+    int status = setInputs(loop, u);
+    if(status < fmi3Discard) {
+        status = getOutputs(loop, f);
+    }
+    if(status < fmi3Discard) {
+        N_VLinearSum(1, u, -1, f, f);
+    }
+    return callbackResult(loop, status);
+}
+
+
+//! @brief KINSOL Jacobian times vector function, Jv = v - (dy/du) v from one directional derivative call per FMU
+//! The derivatives are taken at u, which is set in the FMUs unless it was the last point evaluated.
+static int jacobianTimesVector(N_Vector v, N_Vector Jv, N_Vector u, booleantype *newU, void *userData)
+{
+    fmiAlgebraicLoop *loop = userData;
+    int worstStatus = fmi3OK;
+    if(!loop->lastInputsValid ||
+       memcmp(NV_DATA_S(u), NV_DATA_S(loop->lastInputs), loop->numberOfConnections*sizeof(double)) != 0) {
+        worstStatus = setInputs(loop, u);
+    }
+    *newU = SUNFALSE;
+
+    double *seed = NV_DATA_S(v);
+    double *product = NV_DATA_S(Jv);
+    N_VScale(1, v, Jv);
+    for(int i=0; i<loop->numberOfFmus && worstStatus < fmi3Discard; ++i) {
+        fmiAlgebraicLoopFmu *fmu = &loop->fmus[i];
+        if(fmu->numberOfInputs == 0 || fmu->numberOfOutputs == 0) {
+            continue;
+        }
+        for(int k=0; k<fmu->numberOfInputs; ++k) {
+            fmu->inputValues[k] = seed[fmu->inputIndices[k]];
+        }
+        int status;
+        if(fmu->fmu->version == fmiVersion2) {
+            status = fmi2_getDirectionalDerivative(fmu->fmu, fmu->outputValueReferences, fmu->numberOfOutputs,
+                                                   fmu->inputValueReferences, fmu->numberOfInputs,
+                                                   fmu->inputValues, fmu->outputValues);
+        }
+        else {
+            status = fmi3_getDirectionalDerivative(fmu->fmu, fmu->outputValueReferences, fmu->numberOfOutputs,
+                                                   fmu->inputValueReferences, fmu->numberOfInputs,
+                                                   fmu->inputValues, fmu->numberOfInputs,
+                                                   fmu->outputValues, fmu->numberOfOutputs);
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        for(int k=0; k<fmu->numberOfOutputs; ++k) {
+            product[fmu->outputIndices[k]] -= fmu->outputValues[k];
+        }
+    }
+    ++loop->numberOfJacobianProducts;
+    return callbackResult(loop, worstStatus);
+}
+
+
+//! @brief Returns the loop data of an FMU, adding it to the loop if needed
+static fmiAlgebraicLoopFmu *findOrAddFmu(fmiAlgebraicLoop *loop, fmiHandle *fmu)
+{
+    for(int i=0; i<loop->numberOfFmus; ++i) {
+        if(loop->fmus[i].fmu == fmu) {
+            return &loop->fmus[i];
+        }
+    }
+    fmiAlgebraicLoopFmu *loopFmu = &loop->fmus[loop->numberOfFmus++];
+    loopFmu->fmu = fmu;
+    return loopFmu;
+}
+
+
+//! @brief Returns true if an FMU provides directional derivatives
+static bool providesDirectionalDerivative(fmiHandle *fmu)
+{
+    if(fmu->version == fmiVersion2) {
+        return (fmu->fmi2.supportsModelExchange && fmu->fmi2.me.providesDirectionalDerivative) ||
+               (fmu->fmi2.supportsCoSimulation && fmu->fmi2.cs.providesDirectionalDerivative);
+    }
+    return (fmu->fmi3.supportsModelExchange && fmu->fmi3.me.providesDirectionalDerivative) ||
+           (fmu->fmi3.supportsCoSimulation && fmu->fmi3.cs.providesDirectionalDerivative);
+}
+
+
+//! @brief Frees an algebraic loop (the FMUs are not freed)
+//! @param loop Algebraic loop
+void fmi4c_freeAlgebraicLoop(fmiAlgebraicLoop *loop)
+{
+    if(loop->kinsolMemory != NULL) {
+        KINFree(&loop->kinsolMemory);
+    }
+    if(loop->linearSolver != NULL) {
+        SUNLinSolFree(loop->linearSolver);
+    }
+    if(loop->inputs != NULL) {
+        N_VDestroy(loop->inputs);
+    }
+    if(loop->scaling != NULL) {
+        N_VDestroy(loop->scaling);
+    }
+    if(loop->lastInputs != NULL) {
+        N_VDestroy(loop->lastInputs);
+    }
+    for(int i=0; i<loop->numberOfFmus; ++i) {
+        fmiAlgebraicLoopFmu *fmu = &loop->fmus[i];
+        fmi4cFree(fmu->inputIndices);
+        fmi4cFree(fmu->outputIndices);
+        fmi4cFree(fmu->inputValueReferences);
+        fmi4cFree(fmu->outputValueReferences);
+        fmi4cFree(fmu->inputValues);
+        fmi4cFree(fmu->outputValues);
+    }
+    fmi4cFree(loop->fmus);
+    fmi4cFree(loop);
+}
+
+
+//! @brief Creates a solver for an algebraic loop between FMUs, using KINSOL with the SPGMR linear solver
+//! Connection i feeds output outputValueReferences[i] of outputFmus[i] to input inputValueReferences[i] of
+//! inputFmus[i]. All variables are Real (FMI 2) or Float64 (FMI 3) scalars, and FMI 2 and 3 FMUs may be mixed.
+//! The loop is solved for the input values u with y(u) = u, where y are the connected outputs. If all FMUs with
+//! both inputs and outputs in the loop provide directional derivatives, Jacobian times vector products are
+//! computed exactly with one directional derivative call per FMU, and no Jacobian is stored. Otherwise KINSOL
+//! uses difference quotients.
+//! @param numberOfConnections Number of connections (loop variables)
+//! @param outputFmus FMU of each output
+//! @param outputValueReferences Value reference of each output
+//! @param inputFmus FMU of each input
+//! @param inputValueReferences Value reference of each input
+//! @returns Algebraic loop, or NULL on failure
+fmiAlgebraicLoop *fmi4c_createAlgebraicLoop(int numberOfConnections,
+                                            fmiHandle **outputFmus,
+                                            const fmi3ValueReference *outputValueReferences,
+                                            fmiHandle **inputFmus,
+                                            const fmi3ValueReference *inputValueReferences)
+{
+    if(numberOfConnections <= 0) {
+        printf("An algebraic loop requires at least one connection\n");
+        return NULL;
+    }
+    for(int i=0; i<numberOfConnections; ++i) {
+        if((outputFmus[i]->version != fmiVersion2 && outputFmus[i]->version != fmiVersion3) ||
+           (inputFmus[i]->version != fmiVersion2 && inputFmus[i]->version != fmiVersion3)) {
+            printf("Algebraic loops require FMI 2 or FMI 3 FMUs\n");
+            return NULL;
+        }
+    }
+
+    fmiAlgebraicLoop *loop = fmi4cCalloc(1, sizeof(fmiAlgebraicLoop));
+    loop->numberOfConnections = numberOfConnections;
+    loop->fmus = fmi4cCalloc(2*numberOfConnections, sizeof(fmiAlgebraicLoopFmu));
+
+    //Count the inputs and outputs of each FMU, then fill in the variables
+    for(int i=0; i<numberOfConnections; ++i) {
+        findOrAddFmu(loop, inputFmus[i])->numberOfInputs++;
+        findOrAddFmu(loop, outputFmus[i])->numberOfOutputs++;
+    }
+    for(int i=0; i<loop->numberOfFmus; ++i) {
+        fmiAlgebraicLoopFmu *fmu = &loop->fmus[i];
+        int nInputs = (fmu->numberOfInputs > 0) ? fmu->numberOfInputs : 1;
+        int nOutputs = (fmu->numberOfOutputs > 0) ? fmu->numberOfOutputs : 1;
+        fmu->inputIndices = fmi4cMalloc(nInputs*sizeof(int));
+        fmu->outputIndices = fmi4cMalloc(nOutputs*sizeof(int));
+        fmu->inputValueReferences = fmi4cMalloc(nInputs*sizeof(fmi3ValueReference));
+        fmu->outputValueReferences = fmi4cMalloc(nOutputs*sizeof(fmi3ValueReference));
+        fmu->inputValues = fmi4cMalloc(nInputs*sizeof(double));
+        fmu->outputValues = fmi4cMalloc(nOutputs*sizeof(double));
+        fmu->numberOfInputs = 0;
+        fmu->numberOfOutputs = 0;
+    }
+    for(int i=0; i<numberOfConnections; ++i) {
+        fmiAlgebraicLoopFmu *fmu = findOrAddFmu(loop, inputFmus[i]);
+        fmu->inputIndices[fmu->numberOfInputs] = i;
+        fmu->inputValueReferences[fmu->numberOfInputs++] = inputValueReferences[i];
+        fmu = findOrAddFmu(loop, outputFmus[i]);
+        fmu->outputIndices[fmu->numberOfOutputs] = i;
+        fmu->outputValueReferences[fmu->numberOfOutputs++] = outputValueReferences[i];
+    }
+    loop->directionalDerivatives = true;
+    for(int i=0; i<loop->numberOfFmus; ++i) {
+        fmiAlgebraicLoopFmu *fmu = &loop->fmus[i];
+        if(fmu->numberOfInputs > 0 && fmu->numberOfOutputs > 0 && !providesDirectionalDerivative(fmu->fmu)) {
+            loop->directionalDerivatives = false;
+        }
+    }
+
+    loop->inputs = N_VNew_Serial(numberOfConnections);
+    loop->scaling = N_VNew_Serial(numberOfConnections);
+    loop->lastInputs = N_VNew_Serial(numberOfConnections);
+    N_VConst(1, loop->scaling);
+    loop->kinsolMemory = KINCreate();
+    loop->linearSolver = SUNLinSol_SPGMR(loop->inputs, PREC_NONE, 0);
+    if(loop->kinsolMemory == NULL || loop->linearSolver == NULL ||
+       KINInit(loop->kinsolMemory, residual, loop->inputs) != KIN_SUCCESS ||
+       KINSetUserData(loop->kinsolMemory, loop) != KIN_SUCCESS ||
+       KINSetLinearSolver(loop->kinsolMemory, loop->linearSolver, NULL) != KINLS_SUCCESS ||
+       (loop->directionalDerivatives &&
+        KINSetJacTimesVecFn(loop->kinsolMemory, jacobianTimesVector) != KINLS_SUCCESS)) {
+        printf("Failed to initialize KINSOL for algebraic loop\n");
+        fmi4c_freeAlgebraicLoop(loop);
+        return NULL;
+    }
+    return loop;
+}
+
+
+//! @brief Solves an algebraic loop at the current time and values of the FMUs
+//! The initial guess of the inputs are the current output values. On success, the solution is set in the FMUs.
+//! @param loop Algebraic loop
+//! @param tolerance Tolerance on the max norm of u - y(u)
+//! @returns Worst status of the FMU calls (fmi2Status or fmi3Status values), or Error if KINSOL failed
+int fmi4c_solveAlgebraicLoop(fmiAlgebraicLoop *loop, double tolerance)
+{
+    loop->status = fmi3OK;
+    loop->lastInputsValid = false;
+    int status = getOutputs(loop, loop->inputs);
+    if(status >= fmi3Discard) {
+        return status;
+    }
+
+    KINSetFuncNormTol(loop->kinsolMemory, tolerance);
+    int flag = KINSol(loop->kinsolMemory, loop->inputs, KIN_LINESEARCH, loop->scaling, loop->scaling);
+    long numberOfIterations = 0;
+    KINGetNumNonlinSolvIters(loop->kinsolMemory, &numberOfIterations);
+    loop->numberOfIterations += numberOfIterations;
+    if(flag < 0) {
+        printf("KINSOL failed with flag %d for algebraic loop\n", flag);
+        return (loop->status > fmi3Error) ? loop->status : fmi3Error;
+    }
+
+    //The FMUs were last evaluated at the solution unless KINSOL stopped on a line search trial point
+    if(!loop->lastInputsValid ||
+       memcmp(NV_DATA_S(loop->inputs), NV_DATA_S(loop->lastInputs), loop->numberOfConnections*sizeof(double)) != 0) {
+        status = setInputs(loop, loop->inputs);
+        if(status > loop->status) {
+            loop->status = status;
+        }
+    }
+    return loop->status;
+}
+
+
+//! @brief Returns the solution of the last solve of an algebraic loop
+//! @param loop Algebraic loop
+//! @param values Returns the input value of each connection
+void fmi4c_getAlgebraicLoopSolution(fmiAlgebraicLoop *loop, double values[])
+{
+    memcpy(values, NV_DATA_S(loop->inputs), loop->numberOfConnections*sizeof(double));
+}
+
+
+//! @brief Returns statistics of an algebraic loop since it was created
+//! @param loop Algebraic loop
+//! @param numberOfIterations Returns the number of Newton iterations
+//! @param numberOfResidualEvaluations Returns the number of residual evaluations (one set and one get call per FMU each)
+//! @param numberOfJacobianProducts Returns the number of Jacobian times vector products from directional derivatives
+//! @param directionalDerivatives Returns true if the products use directional derivatives, false if difference quotients
+void fmi4c_getAlgebraicLoopStatistics(fmiAlgebraicLoop *loop, long *numberOfIterations, long *numberOfResidualEvaluations,
+                                      long *numberOfJacobianProducts, bool *directionalDerivatives)
+{
+    *numberOfIterations = loop->numberOfIterations;
+    *numberOfResidualEvaluations = loop->numberOfResidualEvaluations;
+    *numberOfJacobianProducts = loop->numberOfJacobianProducts;
+    *directionalDerivatives = loop->directionalDerivatives;
+}
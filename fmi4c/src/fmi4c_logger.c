@@ -0,0 +1,348 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#define FMI4C_LOG_NAME_SIZE 64
+#define FMI4C_LOG_MESSAGE_SIZE 512
+
+// Atomic operations on 64-bit counters shared between logging threads and the writer thread
+#ifdef _WIN32
+#define atomicLoad(p) InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define atomicStore(p, value) InterlockedExchange64((volatile LONG64*)(p), (LONG64)(value))
+#define atomicCompareExchange(p, expected, desired) \
+    (InterlockedCompareExchange64((volatile LONG64*)(p), (LONG64)(desired), (LONG64)(expected)) == (LONG64)(expected))
+#define atomicIncrement(p) InterlockedIncrement64((volatile LONG64*)(p))
+#else
+#define atomicLoad(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define atomicStore(p, value) __atomic_store_n(p, value, __ATOMIC_SEQ_CST)
+#define atomicCompareExchange(p, expected, desired) \
+    ({ int64_t expectedValue = (expected); __atomic_compare_exchange_n(p, &expectedValue, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); })
+#define atomicIncrement(p) __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST)
+#endif
+
+// One log message in the ring buffer, formatted directly into the record by the logging thread
+typedef struct {
+    int64_t sequence;               // Position the record is ready to be written at, or position+1 when it has been written
+    int status;
+    char instanceName[FMI4C_LOG_NAME_SIZE];
+    char category[FMI4C_LOG_NAME_SIZE];
+    char message[FMI4C_LOG_MESSAGE_SIZE];
+} fmiLogRecord;
+
+// Filtering logger for FMU callbacks, with messages written to a sink by a background thread
+struct fmiLogger {
+    fmiLogRecord *records;          // Bounded multi-producer queue, see appendRecord()
+    int64_t mask;                   // Number of records minus one
+    int64_t writePosition;          // Next position to be claimed by a logging thread
+    int64_t readPosition;           // Next position to be passed to the sink, only used by the writer thread
+    int64_t numberOfDroppedMessages;
+    int64_t writerSleeping;
+    int minimumStatus;
+    int numberOfCategories;         // 0 for all categories
+    char **categories;
+    fmi4cLogSink sink;
+    void *userData;
+    bool stop;
+    fmiMutex mutex;                 // Only used for sleeping and waking the writer thread
+    fmiCondition recordsAvailable;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+};
+
+
+//! @brief Tells if a message passes the status and category filters
+//! This is all the work done for filtered messages, nothing is formatted or copied for them.
+static bool isLogged(fmiLogger *logger, int status, const char *category)
+{
+    if(status < logger->minimumStatus) {
+        return false;
+    }
+    if(logger->numberOfCategories == 0) {
+        return true;
+    }
+    for(int i=0; i<logger->numberOfCategories; ++i) {
+        if(category != NULL && !strcmp(logger->categories[i], category)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//! @brief Claims a record in the ring buffer, without blocking
+//! Uses the sequence number of each record to tell if it is free, so that logging threads never wait for each other
+//! or for the writer thread. If the buffer is full, the message is dropped and counted instead.
+//! @returns Record to fill in and pass to commitRecord(), or NULL if the buffer is full
+static fmiLogRecord *claimRecord(fmiLogger *logger)
+{
+    int64_t position = atomicLoad(&logger->writePosition);
+    while(true) {
+        fmiLogRecord *record = &logger->records[position & logger->mask];
+        int64_t difference = atomicLoad(&record->sequence)-position;
+        if(difference == 0) {
+            if(atomicCompareExchange(&logger->writePosition, position, position+1)) {
+                return record;
+            }
+        }
+        else if(difference < 0) {
+            atomicIncrement(&logger->numberOfDroppedMessages);
+            return NULL;
+        }
+        position = atomicLoad(&logger->writePosition);
+    }
+}
+
+
+//! @brief Publishes a record from claimRecord() to the writer thread
+static void commitRecord(fmiLogger *logger, fmiLogRecord *record)
+{
+    atomicStore(&record->sequence, atomicLoad(&record->sequence)+1);
+    if(atomicLoad(&logger->writerSleeping)) {
+        fmiMutexLock(&logger->mutex);
+        fmiConditionBroadcast(&logger->recordsAvailable);
+        fmiMutexUnlock(&logger->mutex);
+    }
+}
+
+
+//! @brief Copies a string into a record field, truncating it if needed
+static void copyField(char *field, size_t size, const char *string)
+{
+    if(string == NULL) {
+        field[0] = '\0';
+        return;
+    }
+    size_t length = strlen(string);
+    if(length >= size) {
+        length = size-1;
+    }
+    memcpy(field, string, length);
+    field[length] = '\0';
+}
+
+
+//! @brief Default sink, prints messages to standard output
+static void printLogMessage(void *userData, const char *instanceName, int status, const char *category, const char *message)
+{
+    UNUSED(userData);
+    printf("[%s] %s (status %d): %s\n", instanceName, category, status, message);
+}
+
+
+//! @brief Passes the next committed record to the sink
+//! @returns False if there was no committed record
+static bool writeRecord(fmiLogger *logger)
+{
+    fmiLogRecord *record = &logger->records[logger->readPosition & logger->mask];
+    if(atomicLoad(&record->sequence) != logger->readPosition+1) {
+        return false;
+    }
+    logger->sink(logger->userData, record->instanceName, record->status, record->category, record->message);
+    atomicStore(&record->sequence, logger->readPosition+logger->mask+1);    //Free for the next lap
+    ++logger->readPosition;
+    return true;
+}
+
+
+#ifdef _WIN32
+static DWORD WINAPI loggerWriter(LPVOID data)
+#else
+static void *loggerWriter(void *data)
+#endif
+{
+    fmiLogger *logger = data;
+    while(true) {
+        while(writeRecord(logger));
+
+        //Sleep until a logging thread commits a record. The flag is set before checking again, and logging threads
+        //check it after committing, so either this thread sees the record or the logging thread wakes it.
+        fmiMutexLock(&logger->mutex);
+        atomicStore(&logger->writerSleeping, 1);
+        fmiLogRecord *record = &logger->records[logger->readPosition & logger->mask];
+        bool stop = logger->stop;
+        if(!stop && atomicLoad(&record->sequence) != logger->readPosition+1) {
+            fmiConditionWait(&logger->recordsAvailable, &logger->mutex);
+        }
+        atomicStore(&logger->writerSleeping, 0);
+        fmiMutexUnlock(&logger->mutex);
+        if(stop) {
+            while(writeRecord(logger));
+            break;
+        }
+    }
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+
+//! @brief Creates a logger to be passed to FMUs with fmi4c_logMessageFmi2() or fmi4c_logMessageFmi3() as logging callback
+//! Messages below the minimum status, or outside the selected categories, are discarded before they are formatted.
+//! Other messages are formatted into a lock-free ring buffer and passed to the sink by a background thread, so
+//! logging FMUs never wait for I/O. If the buffer is full, messages are dropped (see fmi4c_getNumberOfDroppedLogMessages()).
+//! @param numberOfRecords Capacity of the ring buffer in messages (rounded up to a power of two)
+//! @param minimumStatus Lowest status (fmi2Status or fmi3Status value) of messages to be logged
+//! @param sink Function called by the background thread for each message, or NULL to print messages
+//! @param userData Passed to sink
+//! @returns New logger, or NULL on failure
+fmiLogger *fmi4c_createLogger(int numberOfRecords, int minimumStatus, fmi4cLogSink sink, void *userData)
+{
+    int64_t capacity = 1;
+    while(capacity < numberOfRecords) {
+        capacity *= 2;
+    }
+
+    fmiLogger *logger = fmi4cCalloc(1, sizeof(fmiLogger));
+    logger->records = fmi4cMalloc((size_t)capacity*sizeof(fmiLogRecord));
+    if(logger->records == NULL) {
+        printf("Failed to allocate log buffer\n");
+        fmi4cFree(logger);
+        return NULL;
+    }
+    for(int64_t i=0; i<capacity; ++i) {
+        logger->records[i].sequence = i;
+    }
+    logger->mask = capacity-1;
+    logger->minimumStatus = minimumStatus;
+    logger->sink = (sink != NULL) ? sink : printLogMessage;
+    logger->userData = userData;
+    fmiMutexInit(&logger->mutex);
+    fmiConditionInit(&logger->recordsAvailable);
+
+#ifdef _WIN32
+    logger->thread = CreateThread(NULL, 0, loggerWriter, logger, 0, NULL);
+    bool started = (logger->thread != NULL);
+#else
+    bool started = (pthread_create(&logger->thread, NULL, loggerWriter, logger) == 0);
+#endif
+    if(!started) {
+        printf("Failed to start log writer thread\n");
+        fmiConditionDestroy(&logger->recordsAvailable);
+        fmiMutexDestroy(&logger->mutex);
+        fmi4cFree(logger->records);
+        fmi4cFree(logger);
+        return NULL;
+    }
+    return logger;
+}
+
+
+//! @brief Writes all remaining messages, stops the background thread and frees the logger
+//! FMUs using the logger must be freed first.
+//! @param logger Logger
+void fmi4c_freeLogger(fmiLogger *logger)
+{
+    fmiMutexLock(&logger->mutex);
+    logger->stop = true;
+    fmiConditionBroadcast(&logger->recordsAvailable);
+    fmiMutexUnlock(&logger->mutex);
+#ifdef _WIN32
+    WaitForSingleObject(logger->thread, INFINITE);
+    CloseHandle(logger->thread);
+#else
+    pthread_join(logger->thread, NULL);
+#endif
+
+    for(int i=0; i<logger->numberOfCategories; ++i) {
+        fmi4cFree(logger->categories[i]);
+    }
+    fmi4cFree(logger->categories);
+    fmiConditionDestroy(&logger->recordsAvailable);
+    fmiMutexDestroy(&logger->mutex);
+    fmi4cFree(logger->records);
+    fmi4cFree(logger);
+}
+
+
+//! @brief Sets the lowest status of messages to be logged
+//! Not synchronized with logging FMUs, should be set while no FMU is running.
+//! @param logger Logger
+//! @param minimumStatus Lowest status (fmi2Status or fmi3Status value) of messages to be logged
+void fmi4c_setLoggerMinimumStatus(fmiLogger *logger, int minimumStatus)
+{
+    logger->minimumStatus = minimumStatus;
+}
+
+
+//! @brief Selects the categories of messages to be logged
+//! Not synchronized with logging FMUs, should be set while no FMU is running.
+//! @param logger Logger
+//! @param numberOfCategories Number of categories, or 0 to log all categories
+//! @param categories Categories to log
+void fmi4c_setLoggerCategories(fmiLogger *logger, int numberOfCategories, const char **categories)
+{
+    for(int i=0; i<logger->numberOfCategories; ++i) {
+        fmi4cFree(logger->categories[i]);
+    }
+    fmi4cFree(logger->categories);
+    logger->categories = NULL;
+    logger->numberOfCategories = 0;
+    if(numberOfCategories > 0) {
+        logger->categories = fmi4cMalloc((size_t)numberOfCategories*sizeof(char*));
+        for(int i=0; i<numberOfCategories; ++i) {
+            logger->categories[i] = fmi4cStrdup(categories[i]);
+        }
+        logger->numberOfCategories = numberOfCategories;
+    }
+}
+
+
+//! @brief Returns the number of messages dropped because the ring buffer was full
+//! @param logger Logger
+//! @returns Number of dropped messages
+int64_t fmi4c_getNumberOfDroppedLogMessages(fmiLogger *logger)
+{
+    return atomicLoad(&logger->numberOfDroppedMessages);
+}
+
+
+//! @brief FMI 2 logging callback, to be passed to fmi2_instantiate() with an fmiLogger as component environment
+void fmi4c_logMessageFmi2(fmi2ComponentEnvironment componentEnvironment, fmi2String instanceName, fmi2Status status,
+                          fmi2String category, fmi2String message, ...)
+{
+    fmiLogger *logger = (fmiLogger*)componentEnvironment;
+    if(!isLogged(logger, (int)status, category)) {
+        return;
+    }
+    fmiLogRecord *record = claimRecord(logger);
+    if(record == NULL) {
+        return;
+    }
+    record->status = (int)status;
+    copyField(record->instanceName, sizeof(record->instanceName), instanceName);
+    copyField(record->category, sizeof(record->category), category);
+    va_list arguments;
+    va_start(arguments, message);
+    vsnprintf(record->message, sizeof(record->message), message, arguments);
+    va_end(arguments);
+    commitRecord(logger, record);
+}
+
+
+//! @brief FMI 3 logging callback, to be passed to the fmi3 instantiate functions with an fmiLogger as instance environment
+void fmi4c_logMessageFmi3(fmi3InstanceEnvironment instanceEnvironment, fmi3Status status, fmi3String category, fmi3String message)
+{
+    fmiLogger *logger = (fmiLogger*)instanceEnvironment;
+    if(!isLogged(logger, (int)status, category)) {
+        return;
+    }
+    fmiLogRecord *record = claimRecord(logger);
+    if(record == NULL) {
+        return;
+    }
+    record->status = (int)status;
+    record->instanceName[0] = '\0';     //Not passed to FMI 3 callbacks
+    copyField(record->category, sizeof(record->category), category);
+    copyField(record->message, sizeof(record->message), message);
+    commitRecord(logger, record);
+}
@@ -0,0 +1,90 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The allocator set by fmi4c_setAllocator(), allocate is NULL for the C library functions
+static fmi4cAllocator allocator = { NULL, NULL, NULL, NULL };
+
+
+//! @brief Sets the allocator used for all memory allocated by fmi4c, e.g. to use a memory pool.
+//! This includes the parsed model descriptions, handles, loggers, solvers and the XML trees, but not
+//! the memory of the FMUs themselves (see the allocateMemory callback of FMI 1 and 2).
+//! The allocator must be set while no memory allocated by fmi4c is in use, i.e. before the first FMU
+//! is loaded or after all handles, loggers and other objects have been freed, since memory is always
+//! released through the allocator that is set. The functions may be called from any thread.
+//! @param newAllocator Allocator functions and their user data (copied), or NULL for malloc() and free()
+void fmi4c_setAllocator(const fmi4cAllocator *newAllocator)
+{
+    if(newAllocator != NULL && newAllocator->allocate != NULL &&
+       newAllocator->reallocate != NULL && newAllocator->deallocate != NULL) {
+        allocator = *newAllocator;
+    }
+    else {
+        allocator.allocate = NULL;
+        allocator.reallocate = NULL;
+        allocator.deallocate = NULL;
+        allocator.userData = NULL;
+    }
+}
+
+
+void *fmi4cMalloc(size_t size)
+{
+    if(allocator.allocate == NULL) {
+        return malloc(size);
+    }
+    return allocator.allocate(allocator.userData, size);
+}
+
+
+void *fmi4cCalloc(size_t count, size_t size)
+{
+    if(allocator.allocate == NULL) {
+        return calloc(count, size);
+    }
+    if(size != 0 && count > (size_t)-1/size) {
+        return NULL;
+    }
+    void *ptr = allocator.allocate(allocator.userData, count*size);
+    if(ptr != NULL) {
+        memset(ptr, 0, count*size);
+    }
+    return ptr;
+}
+
+
+void *fmi4cRealloc(void *ptr, size_t size)
+{
+    if(allocator.allocate == NULL) {
+        return realloc(ptr, size);
+    }
+    return allocator.reallocate(allocator.userData, ptr, size);
+}
+
+
+void fmi4cFree(void *ptr)
+{
+    if(ptr == NULL) {
+        return;
+    }
+    if(allocator.allocate == NULL) {
+        free(ptr);
+    }
+    else {
+        allocator.deallocate(allocator.userData, ptr);
+    }
+}
+
+
+char *fmi4cStrdup(const char *str)
+{
+    size_t length = strlen(str)+1;
+    char *copy = fmi4cMalloc(length);
+    if(copy != NULL) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
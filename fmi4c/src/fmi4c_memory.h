@@ -0,0 +1,13 @@
+#ifndef FMIC_MEMORY_H
+#define FMIC_MEMORY_H
+
+#include <stddef.h>
+
+// Allocation functions of fmi4c and its ezxml, which use the allocator set by fmi4c_setAllocator()
+void *fmi4cMalloc(size_t size);
+void *fmi4cCalloc(size_t count, size_t size);
+void *fmi4cRealloc(void *ptr, size_t size);
+void fmi4cFree(void *ptr);
+char *fmi4cStrdup(const char *str);
+
+#endif // FMIC_MEMORY_H
@@ -883,7 +883,7 @@ fmi3Instance placeholder_fmi3InstantiateScheduledExecution(fmi3String instanceNa
                                                              fmi3Boolean loggingOn,
                                                              fmi3InstanceEnvironment instanceEnvironment,
                                                              fmi3LogMessageCallback logMessage,
-                                                             fmi3IntermediateUpdateCallback intermediateUpdate,
+                                                             fmi3ClockUpdateCallback clockUpdate,
                                                              fmi3CallbackLockPreemption lockPreemption,
                                                              fmi3CallbackUnlockPreemption unlockPreemption) {
     UNUSED(instanceName);
@@ -893,7 +893,7 @@ fmi3Instance placeholder_fmi3InstantiateScheduledExecution(fmi3String instanceNa
     UNUSED(loggingOn);
     UNUSED(instanceEnvironment);
     UNUSED(logMessage);
-    UNUSED(intermediateUpdate);
+    UNUSED(clockUpdate);
     UNUSED(lockPreemption);
     UNUSED(unlockPreemption);
     NOT_IMPLEMENTED(fmi3InstantiateScheduledExecution);
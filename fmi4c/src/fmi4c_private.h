@@ -8,6 +8,9 @@
 #include "fmi4c_functions_fmi1.h"
 #include "fmi4c_functions_fmi2.h"
 #include "fmi4c_functions_fmi3.h"
+#include "fmi4c_common.h"
+#include "fmi4c_memory.h"
+#include "fmi4c_xml.h"
 
 #include <stdlib.h>
 #ifdef _WIN32
@@ -16,6 +19,7 @@
     #include <windows.h>
 #else
     #include <dlfcn.h>
+    #include <pthread.h>
 #endif
 
 #ifdef DEBUG
@@ -24,7 +28,110 @@
 #define TRACEFUNC
 #endif
 
-extern const char* fmi4cErrorMessage;
+extern FMI4C_THREAD_LOCAL const char* fmi4cErrorMessage;
+
+// Call statistics of one wrapped FMI function, for profiling
+typedef struct {
+    const char *function;           // Name of the wrapper function, NULL for unused slots
+    uint64_t numberOfCalls;
+    uint64_t numberOfValueReferences;
+    double totalTime;
+    double maxTime;
+} fmiCallStatistics;
+
+#define FMI4C_PROFILE_SLOTS 256     // Power of two, larger than the number of wrapped functions
+
+typedef struct {
+    bool enabled;
+    int numberOfFunctions;
+    double callStartTime;
+    fmiCallStatistics functions[FMI4C_PROFILE_SLOTS];   // Hashed by function name pointer
+} fmiProfile;
+
+// Times a call to an FMU function if profiling is enabled for the handle, and evaluates to its status as an int
+#define PROFILED_CALL(fmu, numberOfValueReferences, call) \
+    (((fmu)->profile == NULL || !(fmu)->profile->enabled) ? (int)(call) : \
+     (beginProfiledCall((fmu)->profile), endProfiledCall((fmu)->profile, __func__, (size_t)(numberOfValueReferences), (call))))
+
+// Minimal portable mutex, statically initializable on both platforms
+#ifdef _WIN32
+typedef SRWLOCK fmiMutex;
+#define FMI4C_MUTEX_INITIALIZER SRWLOCK_INIT
+#define fmiMutexInit(mutex) InitializeSRWLock(mutex)
+#define fmiMutexDestroy(mutex)
+#define fmiMutexLock(mutex) AcquireSRWLockExclusive(mutex)
+#define fmiMutexUnlock(mutex) ReleaseSRWLockExclusive(mutex)
+#else
+typedef pthread_mutex_t fmiMutex;
+#define FMI4C_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define fmiMutexInit(mutex) pthread_mutex_init(mutex, NULL)
+#define fmiMutexDestroy(mutex) pthread_mutex_destroy(mutex)
+#define fmiMutexLock(mutex) pthread_mutex_lock(mutex)
+#define fmiMutexUnlock(mutex) pthread_mutex_unlock(mutex)
+#endif
+
+// Condition variable for use with fmiMutex
+#ifdef _WIN32
+typedef CONDITION_VARIABLE fmiCondition;
+#define fmiConditionInit(condition) InitializeConditionVariable(condition)
+#define fmiConditionDestroy(condition)
+#define fmiConditionWait(condition, mutex) SleepConditionVariableSRW(condition, mutex, INFINITE, 0)
+#define fmiConditionBroadcast(condition) WakeAllConditionVariable(condition)
+#else
+typedef pthread_cond_t fmiCondition;
+#define fmiConditionInit(condition) pthread_cond_init(condition, NULL)
+#define fmiConditionDestroy(condition) pthread_cond_destroy(condition)
+#define fmiConditionWait(condition, mutex) pthread_cond_wait(condition, mutex)
+#define fmiConditionBroadcast(condition) pthread_cond_broadcast(condition)
+#endif
+
+// Bump allocator for everything parsed from modelDescription.xml, released all at once
+typedef struct fmiArenaBlock fmiArenaBlock;
+typedef struct fmiArenaBuffer fmiArenaBuffer;
+typedef struct {
+    fmiArenaBlock *blocks;
+    fmiArenaBuffer *buffers;        // Adopted buffers, such as the in-situ parsed modelDescription.xml
+} fmiArena;
+
+// Position-independent copy of an arena and the structure that points into it, pointers are stored as offset+1 (0 is NULL)
+typedef struct fmiImageRegion fmiImageRegion;
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+    fmiImageRegion *regions;        // Only used when writing, sorted by address
+    int numberOfRegions;
+    bool writing;
+    bool ok;                        // Cleared by the first pointer that can not be relocated
+} fmiImage;
+
+typedef struct fmiSharedModel fmiSharedModel;
+typedef struct fmiHost fmiHost;
+
+typedef struct {
+    const char *variables;
+    size_t stride;
+    size_t nameOffset;
+    size_t valueReferenceOffset;
+    size_t mask;
+    int *nameSlots;
+    int *valueReferenceSlots;
+} fmiVariableIndex;
+
+// Structure-of-arrays copies of the most commonly filtered variable attributes, indexed like the variables array
+typedef struct {
+    fmi2ValueReference *valueReferences;
+    fmi2Causality *causalities;
+    fmi2Variability *variabilities;
+    fmi2DataType *dataTypes;
+} fmi2VariableArrays;
+
+typedef struct {
+    fmi3ValueReference *valueReferences;
+    fmi3Causality *causalities;
+    fmi3Variability *variabilities;
+    fmi3DataType *dataTypes;
+} fmi3VariableArrays;
 
 typedef struct {
     fmi1DataType datatype;
@@ -61,6 +168,13 @@ typedef struct {
     fmi2ValueReference derivative;
 } fmi2VariableHandle;
 
+// Size of one dimension of an FMI 3 array variable, either fixed or given by a structural parameter
+typedef struct {
+    bool hasStart;
+    uint64_t start;
+    fmi3ValueReference valueReference;
+} fmi3Dimension;
+
 typedef struct {
     fmi3DataType datatype;
     const char *name;
@@ -111,6 +225,8 @@ typedef struct {
     int64_t shiftCounter;
     int numberOfClocks;
     int *clocks;
+    int numberOfDimensions;             // 0 for scalar variables
+    fmi3Dimension *dimensions;
 
 } fmi3VariableHandle;
 
@@ -179,6 +295,7 @@ typedef struct {
     int numberOfVariables;
     fmi1VariableHandle *variables;
     int variablesSize;
+    fmiVariableIndex variableIndex;
 
     fmi1Type type;
 
@@ -295,6 +412,8 @@ typedef struct {
     int numberOfVariables;
     fmi2VariableHandle *variables;
     int variablesSize;
+    fmiVariableIndex variableIndex;
+    fmi2VariableArrays variableArrays;
 
     fmi2Component component;
 
@@ -491,6 +610,7 @@ typedef struct {
 typedef struct {
     fmi3ValueReference valueReference;
     int numberOfDependencies;
+    bool dependenciesDefined;       // If false, the element may depend on all knowns
     bool dependencyKindsDefined;
     fmi3ValueReference *dependencies;
     fmi3DependencyKind *dependencyKinds;
@@ -590,6 +710,8 @@ typedef struct {
     int numberOfVariables;
     fmi3VariableHandle *variables;
     int variablesSize;
+    fmiVariableIndex variableIndex;
+    fmi3VariableArrays variableArrays;
 
     fmi3Instance fmi3Instance;
     fmi3GetVersion_t getVersion;
@@ -723,20 +845,282 @@ typedef struct {
     const char* unzippedLocation;
     const char* resourcesLocation;
     const char* instanceName;
+    const char* fmuFile;            // Only set if extraction of binaries and resources is deferred
+    bool extracted;
+    double parseTime;
+    double libraryLoadTime;
+    fmiSharedModel* sharedModel;    // Only set if extracted files and model description are shared with other handles
+    fmiArena arena;                 // Owns the parsed model description
+    fmiProfile* profile;            // Only set if profiling has been enabled
+    void* mappedDescription;        // Only set if the model description was loaded from the binary description cache
+    size_t mappedDescriptionSize;
+    char* hostExecutable;           // Only set if the FMU is to be run in a host process, see fmi4c_setOutOfProcess()
+    fmiHost* host;                  // Only set while the FMU runs in a host process
 #ifdef _WIN32
     HINSTANCE dll;
+    HINSTANCE preloadedDll;         // Only set if the library was loaded by fmi4c_loadFmusPipelined() and is not used yet
 #else
     void* dll;
+    void* preloadedDll;
 #endif
+    char* preloadedDllPath;
 
     fmi1_data_t fmi1;
     fmi2Data_t fmi2;
     fmi3Data_t fmi3;
 } fmiHandle;
 
-bool parseModelDescriptionFmi1(fmiHandle *fmuFile);
-bool parseModelDescriptionFmi2(fmiHandle *fmuFile);
-bool parseModelDescriptionFmi3(fmiHandle *fmuFile);
+// Values of one data type moved by a transfer plan, using one get and one set call per execution
+typedef struct {
+    int dataType;                           // fmi2DataType or fmi3DataType, depending on FMI version
+    size_t valueSize;
+    int numberOfSources;
+    int numberOfDestinations;
+    int capacity;
+    bool direct;                            // Destination i gets source i, so no gathering is needed
+    fmi3ValueReference *sourceValueReferences;
+    fmi3ValueReference *destinationValueReferences;
+    int *sourceIndices;                     // Source value index for each destination
+    char *sourceValues;
+    char *destinationValues;
+    size_t *sourceValueSizes;               // Only used for binaries
+    size_t *destinationValueSizes;
+} fmiTransferGroup;
+
+typedef struct fmiTransferPlan {
+    fmiHandle *source;
+    fmiHandle *destination;
+    int numberOfGroups;
+    fmiTransferGroup *groups;
+} fmiTransferPlan;
+
+// Values of one data type set by a parameter set with one set call, sorted by value reference
+typedef struct {
+    int dataType;                           // fmi2DataType or fmi3DataType, depending on FMI version
+    size_t valueSize;
+    int numberOfValueReferences;
+    int capacity;
+    fmi3ValueReference *valueReferences;
+    size_t *numberOfValues;                 // Values of each value reference, more than one for FMI 3 arrays
+    size_t totalNumberOfValues;
+    size_t valuesCapacity;
+    char *values;                           // Strings are owned copies
+} fmiParameterGroup;
+
+typedef struct fmiParameterSet {
+    fmiHandle *fmu;                         // Resolves names, only used while parameters are added
+    fmiVersion_t version;
+    char *token;                            // GUID or instantiation token of the model description
+    int numberOfGroups;
+    fmiParameterGroup *groups;
+} fmiParameterSet;
+
+// Position of one variable in the values of an array layout
+typedef struct {
+    fmi3ValueReference valueReference;
+    size_t offset;
+    size_t size;
+} fmiArrayLayoutEntry;
+
+// Flattened values of a set of FMI 3 variables with the same data type, see fmi3_createArrayLayout()
+typedef struct fmiArrayLayout {
+    fmiHandle *fmu;
+    fmi3DataType dataType;                  // Enumerations are accessed as Int64
+    size_t numberOfValueReferences;
+    fmi3ValueReference *valueReferences;    // In the order of the values
+    size_t numberOfValues;
+    fmiArrayLayoutEntry *entries;           // Sorted by value reference
+} fmiArrayLayout;
+
+#define FMI3_NUMBER_OF_DATA_TYPES (fmi3DataTypeClock+1)
+
+// Ring buffer of intermediate values, filled by fmi3_recordIntermediateUpdate() during fmi3_doStep()
+typedef struct fmiIntermediateRecorder {
+    fmiHandle *fmu;
+    fmiArrayLayout *layouts[FMI3_NUMBER_OF_DATA_TYPES];    // One get call per data type, NULL for unused types
+    size_t groupOffsets[FMI3_NUMBER_OF_DATA_TYPES];        // Offset of the values of each data type in a sample
+    size_t sampleSize;
+    int capacity;
+    int first;                      // Oldest sample
+    int count;
+    double *times;
+    bool *stepFinished;
+    char *values;                   // capacity samples of sampleSize bytes
+    int64_t numberOfDroppedSamples;
+    fmi3Status status;              // Worst status of all get calls
+} fmiIntermediateRecorder;
+
+// One checkpoint slot in a snapshot pool
+typedef struct {
+    int64_t checkpoint;             // Checkpoint stored in slot, -1 if unused
+    void *state;                    // FMU state, reused by the FMU for each new checkpoint (not used when serializing)
+    char *buffer;                   // Serialized FMU state (only used when serializing)
+    size_t size;
+    size_t capacity;
+} fmiSnapshot;
+
+typedef struct fmiSnapshotPool {
+    fmiHandle *fmu;
+    bool serialize;
+    void *workState;                // Only FMU state when serializing, used for getting and restoring all checkpoints
+    int64_t nextCheckpoint;
+    int numberOfSlots;
+    fmiSnapshot *slots;             // Ring buffer, checkpoint i is stored in slot i % numberOfSlots
+} fmiSnapshotPool;
+
+// Sparse Jacobian of state derivatives with respect to states, evaluated with one
+// directional derivative call per column color
+typedef struct fmiSparseJacobian {
+    fmiHandle *fmu;
+    int numberOfStates;
+    int numberOfNonZeros;
+    fmi3ValueReference *derivativeValueReferences;  // Rows
+    fmi3ValueReference *stateValueReferences;       // Columns
+    int64_t *columnPointers;                        // Compressed sparse column pattern
+    int64_t *rowIndices;
+    int numberOfColors;
+    int *colorPointers;                             // Columns of color c start at colorPointers[c]
+    int *colorColumns;                              // Columns, grouped by color
+    fmi3ValueReference *colorKnowns;                // State value references of colorColumns
+    int *unknownPointers;                           // Rows of color c start at unknownPointers[c]
+    fmi3ValueReference *colorUnknowns;              // Derivative value references of all rows in the columns of each color
+    int *sensitivityIndices;                        // Index in sensitivity vector of its color, for each non-zero
+    fmi3Float64 *seed;                              // Ones
+    fmi3Float64 *sensitivity;
+} fmiSparseJacobian;
+
+// CVODE solver for Model Exchange FMUs, defined in fmi4c_cvode.c
+typedef struct fmiModelExchangeSolver fmiModelExchangeSolver;
+
+// Filtering logger for FMU callbacks, defined in fmi4c_logger.c
+typedef struct fmiLogger fmiLogger;
+
+// Result recorder with a background writer thread, defined in fmi4c_recorder.c
+typedef struct fmiResultRecorder fmiResultRecorder;
+
+// KINSOL solver for algebraic loops between FMUs, defined in fmi4c_kinsol.c
+typedef struct fmiAlgebraicLoop fmiAlgebraicLoop;
+
+// Continuous state and derivative buffers of a Model Exchange FMU, defined in fmi4c_statevector.c
+typedef struct fmiStateVector fmiStateVector;
+
+// Asynchronous doStep() calls for a set of FMUs, see fmi4c_doStepsAsync()
+typedef struct fmiStepBatch {
+    struct fmiStepPool *pool;
+    fmiHandle **fmus;
+    int numberOfFmus;
+    double currentCommunicationPoint;
+    double communicationStepSize;
+    int nextFmu;                    // Next FMU to be stepped by a worker
+    int numberOfRemainingFmus;      // FMUs not yet finished
+    int *statuses;
+    bool *eventHandlingNeeded;      // FMI 3 output arguments
+    bool *terminateSimulation;
+    bool *earlyReturn;
+    double *lastSuccessfulTime;
+    struct fmiStepBatch *next;      // Queued batches
+} fmiStepBatch;
+
+typedef struct fmiStepPool {
+    int numberOfThreads;
+#ifdef _WIN32
+    HANDLE *threads;
+#else
+    pthread_t *threads;
+#endif
+    bool pinThreads;
+    int numberOfStartedThreads;
+    bool stop;
+    fmiStepBatch *firstBatch;       // Queue of batches with FMUs left to step
+    fmiStepBatch *lastBatch;
+    fmiMutex mutex;
+    fmiCondition workAvailable;
+    fmiCondition stepFinished;
+} fmiStepPool;
+
+// Pending activation of a model partition in a clock scheduler
+typedef struct {
+    double time;
+    int clock;                      // Index in fmiClockScheduler::clocks
+    uint64_t sequence;              // Activations with equal time and priority are dispatched in scheduling order
+} fmiClockActivation;
+
+// Input clock of a Scheduled Execution FMU, and the state of its model partition
+typedef struct {
+    fmi3ValueReference valueReference;
+    int priority;                   // Lower value is dispatched first
+    fmi3IntervalVariability intervalVariability;
+    double interval;                // Period of periodic clocks, 0 for triggered clocks
+    double intervalStart;           // Periodic activations are at intervalStart + k*interval, to avoid accumulated rounding
+    int64_t numberOfTicks;
+    bool running;                   // A partition is never activated while its previous activation is running
+} fmiScheduledClock;
+
+// Dispatches model partitions of a Scheduled Execution FMU onto worker threads, in order of activation time and priority
+typedef struct fmiClockScheduler {
+    fmiHandle *fmu;
+    int numberOfClocks;
+    fmiScheduledClock *clocks;
+    fmiClockActivation *queue;      // Binary min-heap ordered by time, priority and sequence
+    int queueSize;
+    int queueCapacity;
+    uint64_t nextSequence;
+    double stopTime;                // Activations after the stop time stay queued
+    int numberOfRunningActivations;
+    fmi3Status status;              // Worst activation status since the last run started
+    int numberOfThreads;
+#ifdef _WIN32
+    HANDLE *threads;
+#else
+    pthread_t *threads;
+#endif
+    bool pinThreads;
+    int numberOfStartedThreads;
+    bool stop;
+    fmiMutex mutex;
+    fmiCondition workAvailable;
+    fmiCondition activationFinished;
+} fmiClockScheduler;
+
+// Model description and extracted files shared by several handles, i.e. instances of the same loaded FMU
+// or FMUs loaded from identical archives through the cache
+struct fmiSharedModel {
+    fmiHandle *model;               // Owns the parsed model description, never instantiated
+    char *location;                 // Cache directory entry, NULL if not in the cache
+    int referenceCount;
+    fmiMutex mutex;                 // Held while files are extracted or parsed
+    fmiSharedModel *next;
+};
+
+// Loaded FMU shared library, shared by all handles using the same library file
+typedef struct fmiSharedLibrary {
+    unsigned long long device;      // File identity, so that different paths to the same file share the library
+    unsigned long long file;
+    unsigned long long size;
+    long long modified;
+#ifdef _WIN32
+    HINSTANCE dll;
+#else
+    void* dll;
+#endif
+    char *copyPath;                 // Private copy of the library file, NULL if the original file was loaded
+    bool separateImage;             // Not shared with other handles (FMU can only be instantiated once per process)
+    int referenceCount;
+    struct fmiSharedLibrary *next;
+} fmiSharedLibrary;
+
+bool parseModelDescriptionFmi1(fmiHandle *fmuFile, fmiXmlElement rootElement);
+bool parseModelDescriptionFmi2(fmiHandle *fmuFile, fmiXmlElement rootElement);
+bool parseModelDescriptionFmi3(fmiHandle *fmuFile, fmiXmlElement rootElement);
+
+#ifdef FMI4C_WITH_HOST
+fmiHost *startHost(const char *hostExecutable, const char *libraryPath);
+void stopHost(fmiHost *host);
+fmi3Instance instantiateHostCoSimulation(fmiHost *host, fmi3String instanceName, fmi3String instantiationToken, fmi3String resourcePath,
+                                         fmi3Boolean visible, fmi3Boolean loggingOn, fmi3Boolean eventModeUsed, fmi3Boolean earlyReturnAllowed,
+                                         const fmi3ValueReference requiredIntermediateVariables[], size_t nRequiredIntermediateVariables);
+void assignHostFunctionsFmi3(fmiHandle *fmu);
+#endif
 
 bool loadFunctionsFmi1(fmiHandle *contents);
 bool loadFunctionsFmi2(fmiHandle *contents, fmi2Type fmuType);
@@ -0,0 +1,848 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "zlib.h"
+
+#define FMI4C_RECORD_MAGIC "FMI4CREC"
+#define FMI4C_RECORD_VERSION 1
+
+// Values of one data type sampled by a recorder with one get call per sample
+typedef struct {
+    int dataType;                           // fmi2DataType or fmi3DataType, depending on FMI version
+    fmi3DataType columnType;                // Data type of the columns in the file
+    size_t valueSize;
+    int numberOfValueReferences;
+    int capacity;
+    fmi3ValueReference *valueReferences;
+    size_t offset;                          // Of the values of the group in each chunk
+} fmiResultRecorderGroup;
+
+// One recorded variable, in the order the variables were added
+typedef struct {
+    char *name;
+    char *description;
+    int group;
+    int index;                              // In the values of the group
+} fmiResultRecorderColumn;
+
+// Samples passed to the writer thread at once. Times come first, followed by the values of each group, sample by
+// sample, so that each get call fills one contiguous row. The writer thread transposes them into columns.
+typedef struct {
+    char *data;
+    int numberOfSamples;
+    bool full;                              // Owned by the writer thread, only accessed with the mutex locked
+} fmiResultRecorderChunk;
+
+// Result recorder, with samples written to a file by a background thread
+struct fmiResultRecorder {
+    fmiHandle *fmu;
+    FILE *file;
+    int format;
+    int samplesPerChunk;
+    int numberOfChunks;
+    int numberOfGroups;
+    fmiResultRecorderGroup *groups;
+    int numberOfColumns;                    // Without the time column
+    fmiResultRecorderColumn *columns;
+    size_t chunkSize;
+    fmiResultRecorderChunk *chunks;
+    int fillChunk;                          // Chunk sampled into, only used by the simulation thread
+    int fillSample;
+    int writeChunk;                         // Chunk to be written, only used by the writer thread
+    bool started;                           // Columns can no longer be added
+    bool running;                           // The writer thread was started
+    bool stop;
+    bool failed;                            // A write failed, remaining chunks are discarded
+    char *buffer;                           // Chunk transposed by the writer thread
+    size_t bufferSize;
+    unsigned char *compressed;
+    size_t compressedSize;
+    z_stream stream;
+    double startTime;                       // MAT v4 only, patched into data_1 when the recorder is freed
+    double stopTime;
+    int64_t numberOfSamples;
+    long startTimePosition;
+    long dataHeaderPosition;
+    fmiMutex mutex;
+    fmiCondition chunkFull;
+    fmiCondition chunkFree;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+};
+
+
+static voidpf recorderZalloc(voidpf opaque, uInt items, uInt size)
+{
+    UNUSED(opaque);
+    return fmi4cMalloc((size_t)items*size);
+}
+
+
+static void recorderZfree(voidpf opaque, voidpf address)
+{
+    UNUSED(opaque);
+    fmi4cFree(address);
+}
+
+
+//! @brief Creates a recorder that samples variables of an FMU into preallocated chunks, which a background thread writes to a file
+//! Add the variables with fmi4c_addRecordedVariable(), fmi4c_addRecordedValueReferences() or fmi4c_addRecordedTransferPlan(),
+//! then call fmi2_recordSample() or fmi3_recordSample() after each step. Sampling does one get call per data type, values
+//! are only transposed, converted and written by the background thread. When all chunks are waiting to be written,
+//! sampling waits for the writer instead of dropping samples.
+//!
+//! FMI4C_RECORD_COLUMNAR files start with "FMI4CREC", a uint32 format version (1), a uint32 compression (0 for none,
+//! 1 for zlib) and a uint32 number of columns, followed by a uint32 fmi3DataType and a uint32 name length and the name
+//! of each column. The first column is the time, Float64. FMI 2 Real, Integer (and enumeration) and Boolean variables
+//! are Float64, Int32 and Int32 columns, FMI 3 enumerations are Int64 columns. Then each chunk has a uint64 number of
+//! samples and a uint64 size of its data, which holds the values of each column in turn, as a zlib stream when compressed.
+//! All numbers are in the byte order of the writing machine.
+//!
+//! FMI4C_RECORD_MAT4 files are MAT v4 result files in the transposed layout of Dymola and OpenModelica (Aclass,
+//! name, description, dataInfo, data_1 and data_2), with all values as doubles.
+//! @param fmu FMU to sample, must not be freed before the recorder
+//! @param path Path of the file, which is overwritten
+//! @param format FMI4C_RECORD_COLUMNAR, FMI4C_RECORD_COLUMNAR_ZLIB or FMI4C_RECORD_MAT4
+//! @param samplesPerChunk Number of samples passed to the writer thread at once
+//! @param numberOfChunks Number of chunks that can wait to be written
+//! @returns Recorder, or NULL on failure
+fmiResultRecorder *fmi4c_createResultRecorder(fmiHandle *fmu, const char *path, int format, int samplesPerChunk, int numberOfChunks)
+{
+    if(fmu->version != fmiVersion2 && fmu->version != fmiVersion3) {
+        printf("Recorders require an FMI 2 or FMI 3 FMU.\n");
+        return NULL;
+    }
+    if(format != FMI4C_RECORD_COLUMNAR && format != FMI4C_RECORD_COLUMNAR_ZLIB && format != FMI4C_RECORD_MAT4) {
+        printf("Unknown record format: %i\n", format);
+        return NULL;
+    }
+    if(samplesPerChunk < 1 || numberOfChunks < 2) {
+        printf("Recorders require at least one sample per chunk and two chunks.\n");
+        return NULL;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if(file == NULL) {
+        printf("Failed to open %s for writing\n", path);
+        return NULL;
+    }
+
+    fmiResultRecorder *recorder = fmi4cCalloc(1, sizeof(fmiResultRecorder));
+    recorder->fmu = fmu;
+    recorder->file = file;
+    recorder->format = format;
+    recorder->samplesPerChunk = samplesPerChunk;
+    recorder->numberOfChunks = numberOfChunks;
+    fmiMutexInit(&recorder->mutex);
+    fmiConditionInit(&recorder->chunkFull);
+    fmiConditionInit(&recorder->chunkFree);
+    return recorder;
+}
+
+
+//! @brief Tells the data type of the columns and values of a variable, or returns false if it can not be recorded
+static bool getColumnType(fmiVersion_t version, int dataType, int *groupType, fmi3DataType *columnType, size_t *valueSize)
+{
+    if(version == fmiVersion2) {
+        switch(dataType) {
+        case fmi2DataTypeReal:
+            (*groupType) = fmi2DataTypeReal;
+            (*columnType) = fmi3DataTypeFloat64;
+            (*valueSize) = sizeof(fmi2Real);
+            return true;
+        case fmi2DataTypeInteger:
+        case fmi2DataTypeEnumeration:
+            (*groupType) = fmi2DataTypeInteger;
+            (*columnType) = fmi3DataTypeInt32;
+            (*valueSize) = sizeof(fmi2Integer);
+            return true;
+        case fmi2DataTypeBoolean:
+            (*groupType) = fmi2DataTypeBoolean;
+            (*columnType) = fmi3DataTypeInt32;
+            (*valueSize) = sizeof(fmi2Boolean);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    (*groupType) = dataType;
+    (*columnType) = dataType;
+    switch(dataType) {
+    case fmi3DataTypeFloat64:       (*valueSize) = sizeof(fmi3Float64); return true;
+    case fmi3DataTypeFloat32:       (*valueSize) = sizeof(fmi3Float32); return true;
+    case fmi3DataTypeInt64:         (*valueSize) = sizeof(fmi3Int64); return true;
+    case fmi3DataTypeInt32:         (*valueSize) = sizeof(fmi3Int32); return true;
+    case fmi3DataTypeInt16:         (*valueSize) = sizeof(fmi3Int16); return true;
+    case fmi3DataTypeInt8:          (*valueSize) = sizeof(fmi3Int8); return true;
+    case fmi3DataTypeUInt64:        (*valueSize) = sizeof(fmi3UInt64); return true;
+    case fmi3DataTypeUInt32:        (*valueSize) = sizeof(fmi3UInt32); return true;
+    case fmi3DataTypeUInt16:        (*valueSize) = sizeof(fmi3UInt16); return true;
+    case fmi3DataTypeUInt8:         (*valueSize) = sizeof(fmi3UInt8); return true;
+    case fmi3DataTypeBoolean:       (*valueSize) = sizeof(fmi3Boolean); return true;
+    case fmi3DataTypeEnumeration:
+        (*groupType) = fmi3DataTypeInt64;
+        (*columnType) = fmi3DataTypeInt64;
+        (*valueSize) = sizeof(fmi3Int64);
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+//! @brief Adds a column for a value reference, to the group of its data type
+//! @param dataType fmi2DataType or fmi3DataType, depending on FMI version
+static bool addColumn(fmiResultRecorder *recorder, int dataType, fmi3ValueReference valueReference, const char *name, const char *description)
+{
+    if(recorder->started) {
+        printf("Variables can not be added to a recorder after the first sample.\n");
+        return false;
+    }
+    int groupType;
+    fmi3DataType columnType;
+    size_t valueSize;
+    if(!getColumnType(recorder->fmu->version, dataType, &groupType, &columnType, &valueSize)) {
+        printf("Data type of %s is not supported by recorders\n", name);
+        return false;
+    }
+
+    int g = 0;
+    while(g < recorder->numberOfGroups && recorder->groups[g].dataType != groupType) {
+        ++g;
+    }
+    if(g == recorder->numberOfGroups) {
+        recorder->groups = fmi4cRealloc(recorder->groups, (size_t)(g+1)*sizeof(fmiResultRecorderGroup));
+        memset(&recorder->groups[g], 0, sizeof(fmiResultRecorderGroup));
+        recorder->groups[g].dataType = groupType;
+        recorder->groups[g].columnType = columnType;
+        recorder->groups[g].valueSize = valueSize;
+        ++recorder->numberOfGroups;
+    }
+    fmiResultRecorderGroup *group = &recorder->groups[g];
+    if(group->numberOfValueReferences == group->capacity) {
+        group->capacity = (group->capacity > 0) ? 2*group->capacity : 16;
+        group->valueReferences = fmi4cRealloc(group->valueReferences, (size_t)group->capacity*sizeof(fmi3ValueReference));
+    }
+    group->valueReferences[group->numberOfValueReferences] = valueReference;
+
+    recorder->columns = fmi4cRealloc(recorder->columns, (size_t)(recorder->numberOfColumns+1)*sizeof(fmiResultRecorderColumn));
+    fmiResultRecorderColumn *column = &recorder->columns[recorder->numberOfColumns];
+    column->name = fmi4cStrdup(name);
+    column->description = fmi4cStrdup(description ? description : "");
+    column->group = g;
+    column->index = group->numberOfValueReferences;
+    ++group->numberOfValueReferences;
+    ++recorder->numberOfColumns;
+    return true;
+}
+
+
+//! @brief Adds a column for a variable, with the name and description of the model description
+//! @param dataType fmi2DataType or fmi3DataType of the value reference, or -1 to take it from the variable
+static bool addVariableColumn(fmiResultRecorder *recorder, int dataType, fmi3ValueReference valueReference, const char *name)
+{
+    fmiHandle *fmu = recorder->fmu;
+    if(fmu->version == fmiVersion2) {
+        fmi2VariableHandle *var = name ? fmi2_getVariableByName(fmu, name) : fmi2_getVariableByValueReference(fmu, valueReference);
+        //Value references are only unique per data type in FMI 2, so another variable may be found
+        if(var != NULL && (dataType < 0 || (int)var->datatype == dataType ||
+                           (var->datatype == fmi2DataTypeEnumeration && dataType == fmi2DataTypeInteger))) {
+            return addColumn(recorder, var->datatype, (fmi3ValueReference)var->valueReference, var->name, var->description);
+        }
+    }
+    else {
+        fmi3VariableHandle *var = name ? fmi3_getVariableByName(fmu, name) : fmi3_getVariableByValueReference(fmu, valueReference);
+        if(var != NULL && var->numberOfDimensions > 0) {
+            printf("Array variable %s can not be recorded\n", var->name);
+            return false;
+        }
+        if(var != NULL) {
+            return addColumn(recorder, var->datatype, (fmi3ValueReference)var->valueReference, var->name, var->description);
+        }
+    }
+    if(name != NULL || dataType < 0) {
+        return false;
+    }
+    char generatedName[32];
+    snprintf(generatedName, sizeof(generatedName), "vr%u", (unsigned)valueReference);
+    return addColumn(recorder, dataType, valueReference, generatedName, NULL);
+}
+
+
+//! @brief Adds a variable to be recorded, with its name and description as column name and description
+//! Scalar variables of all data types except strings, binaries and clocks can be recorded.
+//! @param recorder Recorder, which has not sampled yet
+//! @param name Variable name
+//! @returns True if successful
+bool fmi4c_addRecordedVariable(fmiResultRecorder *recorder, const char *name)
+{
+    return addVariableColumn(recorder, -1, 0, name);
+}
+
+
+//! @brief Adds a list of value references to be recorded
+//! Columns are named after the variables with the value references, or "vr" and the value reference if there is none.
+//! @param recorder Recorder, which has not sampled yet
+//! @param dataType fmi2DataType or fmi3DataType of the value references, depending on FMI version
+//! @param valueReferences Value references
+//! @param nValueReferences Number of value references
+//! @returns True if successful
+bool fmi4c_addRecordedValueReferences(fmiResultRecorder *recorder, int dataType, const fmi3ValueReference *valueReferences, size_t nValueReferences)
+{
+    for(size_t i=0; i<nValueReferences; ++i) {
+        if(!addVariableColumn(recorder, dataType, valueReferences[i], NULL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//! @brief Adds the source values of a transfer plan to be recorded, so that the signals between FMUs are logged
+//! Strings, binaries and clocks are skipped.
+//! @param recorder Recorder, which has not sampled yet
+//! @param plan Transfer plan with the FMU of the recorder as source
+//! @returns True if successful
+bool fmi4c_addRecordedTransferPlan(fmiResultRecorder *recorder, const fmiTransferPlan *plan)
+{
+    if(plan->source != recorder->fmu) {
+        printf("Transfer plan does not have the FMU of the recorder as source.\n");
+        return false;
+    }
+    for(int g=0; g<plan->numberOfGroups; ++g) {
+        const fmiTransferGroup *group = &plan->groups[g];
+        int groupType;
+        fmi3DataType columnType;
+        size_t valueSize;
+        if(!getColumnType(recorder->fmu->version, group->dataType, &groupType, &columnType, &valueSize)) {
+            continue;
+        }
+        if(!fmi4c_addRecordedValueReferences(recorder, group->dataType, group->sourceValueReferences, (size_t)group->numberOfSources)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//! @brief Writes to the file, or remembers that the file is incomplete
+static void writeBytes(fmiResultRecorder *recorder, const void *data, size_t size)
+{
+    if(!recorder->failed && fwrite(data, 1, size, recorder->file) != size) {
+        printf("Failed to write recorded results\n");
+        recorder->failed = true;
+    }
+}
+
+
+static void writeUInt32(fmiResultRecorder *recorder, uint32_t value)
+{
+    writeBytes(recorder, &value, sizeof(value));
+}
+
+
+static void writeUInt64(fmiResultRecorder *recorder, uint64_t value)
+{
+    writeBytes(recorder, &value, sizeof(value));
+}
+
+
+//! @brief Writes the header of a MAT v4 matrix, in the byte order of the writing machine
+//! @param type Precision digit of the matrix type (0 for double, 2 for int32, 5 for uint8), 1 is added for text matrices
+static void writeMat4Header(fmiResultRecorder *recorder, const char *name, int type, bool text, int rows, int columns)
+{
+    const uint16_t byteOrder = 1;
+    int32_t header[5];
+    header[0] = (*(const char*)&byteOrder ? 0 : 1000)+10*type+(text ? 1 : 0);
+    header[1] = rows;
+    header[2] = columns;
+    header[3] = 0;
+    header[4] = (int32_t)strlen(name)+1;
+    writeBytes(recorder, header, sizeof(header));
+    writeBytes(recorder, name, strlen(name)+1);
+}
+
+
+//! @brief Writes a text matrix with one string per column, padded with spaces
+static void writeMat4Strings(fmiResultRecorder *recorder, const char *name, int numberOfStrings, const char **strings)
+{
+    size_t length = 1;
+    for(int i=0; i<numberOfStrings; ++i) {
+        if(strlen(strings[i]) > length) {
+            length = strlen(strings[i]);
+        }
+    }
+    writeMat4Header(recorder, name, 5, true, (int)length, numberOfStrings);
+    char *padded = fmi4cMalloc(length);
+    for(int i=0; i<numberOfStrings; ++i) {
+        memset(padded, ' ', length);
+        memcpy(padded, strings[i], strlen(strings[i]));
+        writeBytes(recorder, padded, length);
+    }
+    fmi4cFree(padded);
+}
+
+
+//! @brief Writes everything before the samples, with the number of samples and the stop time to be patched
+static void writeHeader(fmiResultRecorder *recorder)
+{
+    int n = recorder->numberOfColumns;
+    if(recorder->format != FMI4C_RECORD_MAT4) {
+        writeBytes(recorder, FMI4C_RECORD_MAGIC, strlen(FMI4C_RECORD_MAGIC));
+        writeUInt32(recorder, FMI4C_RECORD_VERSION);
+        writeUInt32(recorder, (recorder->format == FMI4C_RECORD_COLUMNAR_ZLIB) ? 1 : 0);
+        writeUInt32(recorder, (uint32_t)n+1);
+        writeUInt32(recorder, fmi3DataTypeFloat64);
+        writeUInt32(recorder, 4);
+        writeBytes(recorder, "time", 4);
+        for(int i=0; i<n; ++i) {
+            writeUInt32(recorder, recorder->groups[recorder->columns[i].group].columnType);
+            writeUInt32(recorder, (uint32_t)strlen(recorder->columns[i].name));
+            writeBytes(recorder, recorder->columns[i].name, strlen(recorder->columns[i].name));
+        }
+        return;
+    }
+
+    const char *aclass[] = { "Atrajectory", "1.1", "", "binTrans" };
+    char data[4*11];
+    memset(data, ' ', sizeof(data));
+    for(int row=0; row<4; ++row) {
+        for(size_t i=0; i<strlen(aclass[row]); ++i) {
+            data[i*4+row] = aclass[row][i];
+        }
+    }
+    writeMat4Header(recorder, "Aclass", 5, true, 4, 11);
+    writeBytes(recorder, data, sizeof(data));
+
+    const char **strings = fmi4cMalloc((size_t)(n+1)*sizeof(char*));
+    strings[0] = "time";
+    for(int i=0; i<n; ++i) {
+        strings[i+1] = recorder->columns[i].name;
+    }
+    writeMat4Strings(recorder, "name", n+1, strings);
+    strings[0] = "Time [s]";
+    for(int i=0; i<n; ++i) {
+        strings[i+1] = recorder->columns[i].description;
+    }
+    writeMat4Strings(recorder, "description", n+1, strings);
+    fmi4cFree(strings);
+
+    //Time is the abscissa, all variables are rows of data_2 after it
+    writeMat4Header(recorder, "dataInfo", 2, false, 4, n+1);
+    for(int i=0; i<=n; ++i) {
+        int32_t info[4] = { (i == 0) ? 0 : 2, i+1, 0, -1 };
+        writeBytes(recorder, info, sizeof(info));
+    }
+
+    double times[2] = { 0, 0 };
+    writeMat4Header(recorder, "data_1", 0, false, 1, 2);
+    recorder->startTimePosition = ftell(recorder->file);
+    writeBytes(recorder, times, sizeof(times));
+
+    recorder->dataHeaderPosition = ftell(recorder->file);
+    writeMat4Header(recorder, "data_2", 0, false, n+1, 0);
+}
+
+
+//! @brief Returns a recorded value as double, for MAT v4 files
+static double valueAsDouble(fmi3DataType columnType, const char *value)
+{
+    switch(columnType) {
+    case fmi3DataTypeFloat64:   { fmi3Float64 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeFloat32:   { fmi3Float32 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeInt64:     { fmi3Int64 v; memcpy(&v, value, sizeof(v)); return (double)v; }
+    case fmi3DataTypeInt32:     { fmi3Int32 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeInt16:     { fmi3Int16 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeInt8:      { fmi3Int8 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeUInt64:    { fmi3UInt64 v; memcpy(&v, value, sizeof(v)); return (double)v; }
+    case fmi3DataTypeUInt32:    { fmi3UInt32 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeUInt16:    { fmi3UInt16 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeUInt8:     { fmi3UInt8 v; memcpy(&v, value, sizeof(v)); return v; }
+    case fmi3DataTypeBoolean:   { fmi3Boolean v; memcpy(&v, value, sizeof(v)); return v ? 1.0 : 0.0; }
+    default:                    return 0;
+    }
+}
+
+
+//! @brief Copies every stride-th value of a chunk into a contiguous column
+static char *gatherColumn(char *destination, const char *source, size_t valueSize, size_t stride, int numberOfSamples)
+{
+    if(stride == valueSize) {
+        memcpy(destination, source, valueSize*(size_t)numberOfSamples);
+        return destination+valueSize*(size_t)numberOfSamples;
+    }
+    for(int s=0; s<numberOfSamples; ++s) {
+        memcpy(destination, source, valueSize);
+        destination += valueSize;
+        source += stride;
+    }
+    return destination;
+}
+
+
+//! @brief Transposes a chunk into columns and writes it, compressed if requested
+static void writeChunk(fmiResultRecorder *recorder, const fmiResultRecorderChunk *chunk)
+{
+    int samples = chunk->numberOfSamples;
+    const double *times = (const double*)chunk->data;
+
+    if(recorder->format == FMI4C_RECORD_MAT4) {
+        //Transposed layout, one column of data_2 per sample
+        double *values = (double*)recorder->buffer;
+        for(int s=0; s<samples; ++s) {
+            (*values++) = times[s];
+            for(int i=0; i<recorder->numberOfColumns; ++i) {
+                const fmiResultRecorderGroup *group = &recorder->groups[recorder->columns[i].group];
+                const char *row = chunk->data+group->offset+(size_t)s*group->numberOfValueReferences*group->valueSize;
+                (*values++) = valueAsDouble(group->columnType, row+(size_t)recorder->columns[i].index*group->valueSize);
+            }
+        }
+        if(recorder->numberOfSamples == 0) {
+            recorder->startTime = times[0];
+        }
+        recorder->stopTime = times[samples-1];
+        writeBytes(recorder, recorder->buffer, (size_t)((char*)values-recorder->buffer));
+        return;
+    }
+
+    char *end = gatherColumn(recorder->buffer, chunk->data, sizeof(double), sizeof(double), samples);
+    for(int i=0; i<recorder->numberOfColumns; ++i) {
+        const fmiResultRecorderGroup *group = &recorder->groups[recorder->columns[i].group];
+        const char *source = chunk->data+group->offset+(size_t)recorder->columns[i].index*group->valueSize;
+        end = gatherColumn(end, source, group->valueSize, group->numberOfValueReferences*group->valueSize, samples);
+    }
+    size_t size = (size_t)(end-recorder->buffer);
+
+    writeUInt64(recorder, (uint64_t)samples);
+    if(recorder->format == FMI4C_RECORD_COLUMNAR) {
+        writeUInt64(recorder, size);
+        writeBytes(recorder, recorder->buffer, size);
+        return;
+    }
+    deflateReset(&recorder->stream);
+    recorder->stream.next_in = (Bytef*)recorder->buffer;
+    recorder->stream.avail_in = (uInt)size;
+    recorder->stream.next_out = recorder->compressed;
+    recorder->stream.avail_out = (uInt)recorder->compressedSize;
+    if(deflate(&recorder->stream, Z_FINISH) != Z_STREAM_END) {
+        printf("Failed to compress recorded results\n");
+        recorder->failed = true;
+        return;
+    }
+    writeUInt64(recorder, recorder->stream.total_out);
+    writeBytes(recorder, recorder->compressed, recorder->stream.total_out);
+}
+
+
+#ifdef _WIN32
+static DWORD WINAPI recorderWriter(LPVOID data)
+#else
+static void *recorderWriter(void *data)
+#endif
+{
+    fmiResultRecorder *recorder = data;
+    writeHeader(recorder);
+    while(true) {
+        fmiResultRecorderChunk *chunk = &recorder->chunks[recorder->writeChunk];
+        fmiMutexLock(&recorder->mutex);
+        while(!chunk->full && !recorder->stop) {
+            fmiConditionWait(&recorder->chunkFull, &recorder->mutex);
+        }
+        bool full = chunk->full;
+        fmiMutexUnlock(&recorder->mutex);
+        if(!full) {
+            break;      //Stopped, and chunks are passed in order, so all of them have been written
+        }
+
+        writeChunk(recorder, chunk);
+        recorder->numberOfSamples += chunk->numberOfSamples;
+
+        fmiMutexLock(&recorder->mutex);
+        chunk->full = false;
+        fmiConditionBroadcast(&recorder->chunkFree);
+        fmiMutexUnlock(&recorder->mutex);
+        recorder->writeChunk = (recorder->writeChunk+1) % recorder->numberOfChunks;
+    }
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+
+//! @brief Allocates the chunks for the added variables and starts the writer thread
+static bool startRecorder(fmiResultRecorder *recorder)
+{
+    recorder->started = true;
+
+    //Times, then the values of each group, aligned for the largest data types
+    size_t samples = (size_t)recorder->samplesPerChunk;
+    size_t rowSize = sizeof(double);
+    recorder->chunkSize = samples*sizeof(double);
+    for(int g=0; g<recorder->numberOfGroups; ++g) {
+        fmiResultRecorderGroup *group = &recorder->groups[g];
+        recorder->chunkSize = (recorder->chunkSize+7) & ~(size_t)7;
+        group->offset = recorder->chunkSize;
+        recorder->chunkSize += samples*group->numberOfValueReferences*group->valueSize;
+        rowSize += group->numberOfValueReferences*group->valueSize;
+    }
+    if(recorder->format == FMI4C_RECORD_MAT4) {
+        rowSize = (size_t)(recorder->numberOfColumns+1)*sizeof(double);
+    }
+    recorder->bufferSize = samples*rowSize;
+    recorder->buffer = fmi4cMalloc(recorder->bufferSize);
+    recorder->chunks = fmi4cCalloc((size_t)recorder->numberOfChunks, sizeof(fmiResultRecorderChunk));
+    bool allocated = (recorder->buffer != NULL && recorder->chunks != NULL);
+    for(int i=0; allocated && i<recorder->numberOfChunks; ++i) {
+        recorder->chunks[i].data = fmi4cMalloc(recorder->chunkSize);
+        allocated = (recorder->chunks[i].data != NULL);
+    }
+    if(!allocated) {
+        printf("Failed to allocate recorder chunks\n");
+        return false;
+    }
+
+    if(recorder->format == FMI4C_RECORD_COLUMNAR_ZLIB) {
+        recorder->stream.zalloc = recorderZalloc;
+        recorder->stream.zfree = recorderZfree;
+        if(deflateInit(&recorder->stream, Z_BEST_SPEED) != Z_OK) {
+            printf("Failed to initialize compression of recorded results\n");
+            return false;
+        }
+        recorder->compressedSize = deflateBound(&recorder->stream, (uLong)recorder->bufferSize);
+        recorder->compressed = fmi4cMalloc(recorder->compressedSize);
+    }
+
+#ifdef _WIN32
+    recorder->thread = CreateThread(NULL, 0, recorderWriter, recorder, 0, NULL);
+    bool started = (recorder->thread != NULL);
+#else
+    bool started = (pthread_create(&recorder->thread, NULL, recorderWriter, recorder) == 0);
+#endif
+    if(!started) {
+        printf("Failed to start recorder writer thread\n");
+        return false;
+    }
+    recorder->running = true;
+    return true;
+}
+
+
+//! @brief Passes the chunk being filled to the writer thread
+static void passChunk(fmiResultRecorder *recorder)
+{
+    fmiResultRecorderChunk *chunk = &recorder->chunks[recorder->fillChunk];
+    fmiMutexLock(&recorder->mutex);
+    chunk->numberOfSamples = recorder->fillSample;
+    chunk->full = true;
+    fmiConditionBroadcast(&recorder->chunkFull);
+    fmiMutexUnlock(&recorder->mutex);
+    recorder->fillChunk = (recorder->fillChunk+1) % recorder->numberOfChunks;
+    recorder->fillSample = 0;
+}
+
+
+//! @brief Returns the chunk to sample into, after storing the time, or NULL on failure
+//! Waits for the writer thread only when it still owns the next chunk.
+static char *beginSample(fmiResultRecorder *recorder, double time)
+{
+    if(!recorder->started && !startRecorder(recorder)) {
+        return NULL;
+    }
+    if(!recorder->running) {
+        return NULL;
+    }
+    fmiResultRecorderChunk *chunk = &recorder->chunks[recorder->fillChunk];
+    if(recorder->fillSample == 0) {
+        fmiMutexLock(&recorder->mutex);
+        while(chunk->full) {
+            fmiConditionWait(&recorder->chunkFree, &recorder->mutex);
+        }
+        fmiMutexUnlock(&recorder->mutex);
+    }
+    ((double*)chunk->data)[recorder->fillSample] = time;
+    return chunk->data;
+}
+
+
+//! @brief Returns where the values of a group go in a chunk for the current sample
+static void *sampleValues(const fmiResultRecorder *recorder, char *data, const fmiResultRecorderGroup *group)
+{
+    return data+group->offset+(size_t)recorder->fillSample*group->numberOfValueReferences*group->valueSize;
+}
+
+
+//! @brief Counts the sample, and passes the chunk to the writer thread if it is full
+static void endSample(fmiResultRecorder *recorder)
+{
+    if(++recorder->fillSample == recorder->samplesPerChunk) {
+        passChunk(recorder);
+    }
+}
+
+
+//! @brief Samples the recorded variables of an FMI 2 FMU, with one get call per data type
+//! @param recorder Recorder
+//! @param time Time of the sample
+//! @returns Worst status of all get calls, the sample is discarded if it is fmi2Error or worse
+fmi2Status fmi2_recordSample(fmiResultRecorder *recorder, fmi2Real time)
+{
+    char *data = beginSample(recorder, time);
+    if(data == NULL || recorder->fmu->version != fmiVersion2) {
+        return fmi2Error;
+    }
+
+    fmi2Status worstStatus = fmi2OK;
+    for(int g=0; g<recorder->numberOfGroups; ++g) {
+        const fmiResultRecorderGroup *group = &recorder->groups[g];
+        const fmi2ValueReference *vrs = group->valueReferences;
+        size_t n = (size_t)group->numberOfValueReferences;
+        void *values = sampleValues(recorder, data, group);
+        fmi2Status status = fmi2Error;
+        switch(group->dataType) {
+        case fmi2DataTypeReal:
+            status = fmi2_getReal(recorder->fmu, vrs, n, values);
+            break;
+        case fmi2DataTypeInteger:
+            status = fmi2_getInteger(recorder->fmu, vrs, n, values);
+            break;
+        case fmi2DataTypeBoolean:
+            status = fmi2_getBoolean(recorder->fmu, vrs, n, values);
+            break;
+        }
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi2Error) {
+            return worstStatus;
+        }
+    }
+    endSample(recorder);
+    return worstStatus;
+}
+
+
+//! @brief Gets all values of an FMI 3 recorder group
+static fmi3Status getRecordedValuesFmi3(fmiHandle *fmu, const fmiResultRecorderGroup *group, void *values)
+{
+    const fmi3ValueReference *vrs = group->valueReferences;
+    size_t n = (size_t)group->numberOfValueReferences;
+    switch(group->dataType) {
+    case fmi3DataTypeFloat64:   return fmi3_getFloat64(fmu, vrs, n, values, n);
+    case fmi3DataTypeFloat32:   return fmi3_getFloat32(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt64:     return fmi3_getInt64(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt32:     return fmi3_getInt32(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt16:     return fmi3_getInt16(fmu, vrs, n, values, n);
+    case fmi3DataTypeInt8:      return fmi3_getInt8(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt64:    return fmi3_getUInt64(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt32:    return fmi3_getUInt32(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt16:    return fmi3_getUInt16(fmu, vrs, n, values, n);
+    case fmi3DataTypeUInt8:     return fmi3_getUInt8(fmu, vrs, n, values, n);
+    case fmi3DataTypeBoolean:   return fmi3_getBoolean(fmu, vrs, n, values, n);
+    default:                    return fmi3Error;
+    }
+}
+
+
+//! @brief Samples the recorded variables of an FMI 3 FMU, with one get call per data type
+//! @param recorder Recorder
+//! @param time Time of the sample
+//! @returns Worst status of all get calls, the sample is discarded if it is fmi3Error or worse
+fmi3Status fmi3_recordSample(fmiResultRecorder *recorder, fmi3Float64 time)
+{
+    char *data = beginSample(recorder, time);
+    if(data == NULL || recorder->fmu->version != fmiVersion3) {
+        return fmi3Error;
+    }
+
+    fmi3Status worstStatus = fmi3OK;
+    for(int g=0; g<recorder->numberOfGroups; ++g) {
+        fmi3Status status = getRecordedValuesFmi3(recorder->fmu, &recorder->groups[g], sampleValues(recorder, data, &recorder->groups[g]));
+        if(status > worstStatus) {
+            worstStatus = status;
+        }
+        if(status >= fmi3Error) {
+            return worstStatus;
+        }
+    }
+    endSample(recorder);
+    return worstStatus;
+}
+
+
+//! @brief Writes all remaining samples, stops the background thread, closes the file and frees the recorder
+//! @param recorder Recorder
+//! @returns True if all samples were written
+bool fmi4c_freeResultRecorder(fmiResultRecorder *recorder)
+{
+    if(!recorder->started) {
+        startRecorder(recorder);    //Writes the header of a file without samples
+    }
+    bool success = recorder->running;
+    if(success) {
+        if(recorder->fillSample > 0) {
+            passChunk(recorder);
+        }
+        fmiMutexLock(&recorder->mutex);
+        recorder->stop = true;
+        fmiConditionBroadcast(&recorder->chunkFull);
+        fmiMutexUnlock(&recorder->mutex);
+#ifdef _WIN32
+        WaitForSingleObject(recorder->thread, INFINITE);
+        CloseHandle(recorder->thread);
+#else
+        pthread_join(recorder->thread, NULL);
+#endif
+    }
+
+    //Patch the time range and the number of samples of MAT v4 files
+    if(success && recorder->format == FMI4C_RECORD_MAT4 && !recorder->failed) {
+        double times[2] = { recorder->startTime, recorder->stopTime };
+        if(fseek(recorder->file, recorder->startTimePosition, SEEK_SET) == 0) {
+            writeBytes(recorder, times, sizeof(times));
+        }
+        if(fseek(recorder->file, recorder->dataHeaderPosition, SEEK_SET) == 0) {
+            writeMat4Header(recorder, "data_2", 0, false, recorder->numberOfColumns+1, (int)recorder->numberOfSamples);
+        }
+    }
+    success = success && !recorder->failed;
+    if(fclose(recorder->file) != 0) {
+        printf("Failed to close recorded results\n");
+        success = false;
+    }
+
+    if(recorder->format == FMI4C_RECORD_COLUMNAR_ZLIB && recorder->compressed != NULL) {
+        deflateEnd(&recorder->stream);
+    }
+    fmi4cFree(recorder->compressed);
+    fmi4cFree(recorder->buffer);
+    if(recorder->chunks != NULL) {
+        for(int i=0; i<recorder->numberOfChunks; ++i) {
+            fmi4cFree(recorder->chunks[i].data);
+        }
+    }
+    fmi4cFree(recorder->chunks);
+    for(int i=0; i<recorder->numberOfColumns; ++i) {
+        fmi4cFree(recorder->columns[i].name);
+        fmi4cFree(recorder->columns[i].description);
+    }
+    fmi4cFree(recorder->columns);
+    for(int g=0; g<recorder->numberOfGroups; ++g) {
+        fmi4cFree(recorder->groups[g].valueReferences);
+    }
+    fmi4cFree(recorder->groups);
+    fmiConditionDestroy(&recorder->chunkFree);
+    fmiConditionDestroy(&recorder->chunkFull);
+    fmiMutexDestroy(&recorder->mutex);
+    fmi4cFree(recorder);
+    return success;
+}
@@ -0,0 +1,244 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Alignment of state and derivative buffers, one cache line (also suitable for AVX-512 loads)
+#define FMI4C_STATE_ALIGNMENT 64
+
+// Continuous state and derivative buffers of an FMI 2 or FMI 3 Model Exchange FMU, with the time and states
+// last set in the FMU, so that set and get calls are only made when the values have changed
+struct fmiStateVector {
+    fmiHandle *fmu;
+    int numberOfStates;
+    double *states;                 // Aligned, may be aliased by a solver vector (e.g. N_VMake_Serial)
+    double *derivatives;            // Aligned, holds the derivatives at lastStates if derivativesValid
+    double *lastStates;             // States last set in or read from the FMU
+    double lastTime;
+    bool lastTimeValid;
+    bool lastStatesValid;
+    bool derivativesValid;
+    bool statesChanged;             // The FMU may have changed its states, see fmi4c_invalidateStateVector()
+    long numberOfSetCalls;
+    long numberOfSkippedSetCalls;
+    long numberOfGetCalls;
+    long numberOfSkippedGetCalls;
+};
+
+
+static double *allocateAligned(int n)
+{
+    size_t size = (size_t)((n > 0) ? n : 1)*sizeof(double);
+#ifdef _WIN32
+    return _aligned_malloc(size, FMI4C_STATE_ALIGNMENT);
+#else
+    void *memory = NULL;
+    if(posix_memalign(&memory, FMI4C_STATE_ALIGNMENT, size) != 0) {
+        return NULL;
+    }
+    return memory;
+#endif
+}
+
+
+static void freeAligned(double *memory)
+{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+
+//! @brief Creates continuous state and derivative buffers for a Model Exchange FMU
+//! The buffers are aligned to 64 bytes and are meant to be shared with a solver without copying, e.g. by
+//! wrapping them with N_VMake_Serial(). Set and get calls through the state vector are skipped when the
+//! time and states are bitwise equal to the ones last set in the FMU, so that a solver may evaluate its
+//! right hand side, root and Jacobian functions at the same point with only one set call.
+//! @param fmu FMU handle (FMI 2 or FMI 3, instantiated for Model Exchange)
+//! @returns State vector, or NULL on failure
+fmiStateVector *fmi4c_createStateVector(fmiHandle *fmu)
+{
+    int n;
+    if(fmu->version == fmiVersion2) {
+        n = fmu->fmi2.numberOfContinuousStates;
+    }
+    else if(fmu->version == fmiVersion3) {
+        n = fmu->fmi3.numberOfContinuousStateDerivatives;
+    }
+    else {
+        printf("State vectors require an FMI 2 or FMI 3 FMU\n");
+        return NULL;
+    }
+
+    fmiStateVector *vector = fmi4cCalloc(1, sizeof(fmiStateVector));
+    vector->fmu = fmu;
+    vector->numberOfStates = n;
+    vector->states = allocateAligned(n);
+    vector->derivatives = allocateAligned(n);
+    vector->lastStates = allocateAligned(n);
+    if(vector->states == NULL || vector->derivatives == NULL || vector->lastStates == NULL) {
+        printf("Failed to allocate state vector: %s\n", fmu->instanceName);
+        fmi4c_freeStateVector(vector);
+        return NULL;
+    }
+    memset(vector->states, 0, ((n > 0) ? n : 1)*sizeof(double));
+    memset(vector->derivatives, 0, ((n > 0) ? n : 1)*sizeof(double));
+    vector->statesChanged = true;
+    return vector;
+}
+
+
+//! @brief Frees a state vector (the FMU is not freed)
+//! @param vector State vector
+void fmi4c_freeStateVector(fmiStateVector *vector)
+{
+    freeAligned(vector->states);
+    freeAligned(vector->derivatives);
+    freeAligned(vector->lastStates);
+    fmi4cFree(vector);
+}
+
+
+//! @brief Returns the number of continuous states of a state vector
+int fmi4c_getStateVectorSize(fmiStateVector *vector)
+{
+    return vector->numberOfStates;
+}
+
+
+//! @brief Returns the aligned state buffer (at least one element)
+double *fmi4c_getStateBuffer(fmiStateVector *vector)
+{
+    return vector->states;
+}
+
+
+//! @brief Returns the aligned derivative buffer (at least one element), which must not be modified by the caller
+double *fmi4c_getDerivativeBuffer(fmiStateVector *vector)
+{
+    return vector->derivatives;
+}
+
+
+//! @brief Sets time and continuous states of the FMU, skipping the calls for values that are already set
+//! @param vector State vector
+//! @param time Time
+//! @param states Continuous states, e.g. the state buffer or the data of a solver vector
+//! @returns Worst status of the FMU calls (fmi2Status or fmi3Status values)
+int fmi4c_setTimeAndContinuousStates(fmiStateVector *vector, double time, const double *states)
+{
+    fmiHandle *fmu = vector->fmu;
+    int n = vector->numberOfStates;
+    int status = fmi3OK;
+    if(!vector->lastTimeValid || time != vector->lastTime) {
+        status = (fmu->version == fmiVersion2) ? (int)fmi2_setTime(fmu, time) : (int)fmi3_setTime(fmu, time);
+        vector->lastTimeValid = (status < fmi3Discard);
+        vector->lastTime = time;
+        vector->derivativesValid = false;
+        if(status >= fmi3Discard) {
+            return status;
+        }
+    }
+    if(n == 0) {
+        return status;
+    }
+    if(vector->lastStatesValid && memcmp(states, vector->lastStates, n*sizeof(double)) == 0) {
+        ++vector->numberOfSkippedSetCalls;
+        return status;
+    }
+    int setStatus = (fmu->version == fmiVersion2) ? (int)fmi2_setContinuousStates(fmu, states, n) :
+                                                    (int)fmi3_setContinuousStates(fmu, states, n);
+    ++vector->numberOfSetCalls;
+    vector->derivativesValid = false;
+    vector->lastStatesValid = (setStatus < fmi3Discard);
+    if(vector->lastStatesValid) {
+        memcpy(vector->lastStates, states, n*sizeof(double));
+    }
+    return (setStatus > status) ? setStatus : status;
+}
+
+
+//! @brief Gets the continuous state derivatives of the FMU at the time and states last set
+//! The get call is skipped if the derivative buffer already holds the derivatives at these values.
+//! @param vector State vector
+//! @param derivatives Returns the derivatives, e.g. the derivative buffer or the data of a solver vector
+//! @returns Worst status of the FMU calls (fmi2Status or fmi3Status values)
+int fmi4c_getContinuousStateDerivatives(fmiStateVector *vector, double *derivatives)
+{
+    fmiHandle *fmu = vector->fmu;
+    int n = vector->numberOfStates;
+    if(n == 0) {
+        return fmi3OK;
+    }
+    if(vector->derivativesValid) {
+        if(derivatives != vector->derivatives) {
+            memcpy(derivatives, vector->derivatives, n*sizeof(double));
+        }
+        ++vector->numberOfSkippedGetCalls;
+        return fmi3OK;
+    }
+    int status = (fmu->version == fmiVersion2) ? (int)fmi2_getDerivatives(fmu, derivatives, n) :
+                                                 (int)fmi3_getContinuousStateDerivatives(fmu, derivatives, n);
+    ++vector->numberOfGetCalls;
+    if(status < fmi3Discard && derivatives == vector->derivatives) {
+        vector->derivativesValid = vector->lastTimeValid && vector->lastStatesValid;
+    }
+    return status;
+}
+
+
+//! @brief Reads the continuous states of the FMU into the state buffer, if they may have changed
+//! This is the case after creation and after fmi4c_invalidateStateVector(). The values read count as set.
+//! @param vector State vector
+//! @returns Status of the FMU call (fmi2Status or fmi3Status values)
+int fmi4c_updateContinuousStates(fmiStateVector *vector)
+{
+    fmiHandle *fmu = vector->fmu;
+    int n = vector->numberOfStates;
+    if(!vector->statesChanged || n == 0) {
+        return fmi3OK;
+    }
+    int status = (fmu->version == fmiVersion2) ? (int)fmi2_getContinuousStates(fmu, vector->states, n) :
+                                                 (int)fmi3_getContinuousStates(fmu, vector->states, n);
+    if(status < fmi3Discard) {
+        memcpy(vector->lastStates, vector->states, n*sizeof(double));
+        vector->lastStatesValid = true;
+        vector->statesChanged = false;
+    }
+    return status;
+}
+
+
+//! @brief Marks the values of the FMU as changed outside the state vector
+//! Call after event iterations, fmi2_setFMUstate()/fmi3_setFMUState() or other calls that may change the
+//! continuous states or derivatives. The next set and get calls are then made unconditionally, and
+//! fmi4c_updateContinuousStates() reads the states again.
+//! @param vector State vector
+void fmi4c_invalidateStateVector(fmiStateVector *vector)
+{
+    vector->lastTimeValid = false;
+    vector->lastStatesValid = false;
+    vector->derivativesValid = false;
+    vector->statesChanged = true;
+}
+
+
+//! @brief Returns the numbers of made and skipped set and get calls of a state vector
+//! @param vector State vector
+//! @param numberOfSetCalls Returns the number of continuous state set calls made
+//! @param numberOfSkippedSetCalls Returns the number of continuous state set calls skipped
+//! @param numberOfGetCalls Returns the number of derivative get calls made
+//! @param numberOfSkippedGetCalls Returns the number of derivative get calls skipped
+void fmi4c_getStateVectorStatistics(fmiStateVector *vector, long *numberOfSetCalls, long *numberOfSkippedSetCalls,
+                                    long *numberOfGetCalls, long *numberOfSkippedGetCalls)
+{
+    *numberOfSetCalls = vector->numberOfSetCalls;
+    *numberOfSkippedSetCalls = vector->numberOfSkippedSetCalls;
+    *numberOfGetCalls = vector->numberOfGetCalls;
+    *numberOfSkippedGetCalls = vector->numberOfSkippedGetCalls;
+}
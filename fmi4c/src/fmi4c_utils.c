@@ -1,7 +1,30 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // For sched_setaffinity()
+#endif
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
 #include "fmi4c_utils.h"
 #include "fmi4c_common.h"
+#include "minizip/unzip.h"
+
+#define ARCHIVE_BUFFER_SIZE 8192
 
 
 //! @brief Concatenates model name and function name into "modelName_functionName" (for FMI 1)
@@ -12,7 +35,7 @@ const char* getFunctionName(const char* modelName, const char* functionName) {
     if(modelName == NULL || modelName[0] == '\0') {
         return functionName;    //!< Do not change function name if model name is empty
     }
-    char* fullName = (char*)malloc(strlen(modelName)+strlen(functionName)+2);
+    char* fullName = (char*)fmi4cMalloc(strlen(modelName)+strlen(functionName)+2);
     strncpy(fullName, modelName, strlen(modelName)+strlen(functionName)+2);
     fullName[strlen(modelName)] = '\0';
     strncat(fullName,  "_", strlen(modelName)+strlen(functionName)+2);
@@ -20,18 +43,1054 @@ const char* getFunctionName(const char* modelName, const char* functionName) {
     return fullName;
 }
 
+//! @brief Returns a monotonic wall clock time, for measuring durations
+//! @returns Time in seconds
+double getWallTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart/(double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+#endif
+}
+
+//! @brief Creates a directory and all of its missing parent directories
+//! @param path Directory path
+//! @returns True if the directory exists afterwards, else false
+bool makeDirectories(const char *path)
+{
+    char buffer[FILENAME_MAX];
+    size_t length = strlen(path);
+    if(length == 0 || length >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, path, length+1);
+
+    for(size_t i=1; i<=length; ++i) {
+        if(buffer[i] == '/' || buffer[i] == '\\' || buffer[i] == '\0') {
+            char separator = buffer[i];
+            buffer[i] = '\0';
+#ifdef _WIN32
+            int status = _mkdir(buffer);
+#else
+            int status = mkdir(buffer, S_IRWXU | S_IRWXG | S_IRWXO);
+#endif
+            if(status != 0 && errno != EEXIST) {
+                return false;
+            }
+            buffer[i] = separator;
+        }
+    }
+    return true;
+}
+
+//! @brief Reads one file from a zip archive into memory, without extracting anything to disk
+//! @param archive Path to zip archive
+//! @param fileName Name of file inside the archive
+//! @param size Returns the size of the file (excluding the appended null terminator)
+//! @returns Null-terminated buffer allocated with malloc(), or NULL on failure
+char *readFileFromArchive(const char *archive, const char *fileName, size_t *size)
+{
+    unzFile zip = unzOpen64(archive);
+    if(zip == NULL) {
+        printf("Cannot open archive: %s\n", archive);
+        return NULL;
+    }
+
+    unz_file_info64 fileInfo;
+    if(unzLocateFile(zip, fileName, 1) != UNZ_OK ||
+       unzGetCurrentFileInfo64(zip, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK ||
+       unzOpenCurrentFile(zip) != UNZ_OK) {
+        printf("File %s not found in archive: %s\n", fileName, archive);
+        unzClose(zip);
+        return NULL;
+    }
+
+    char *buffer = fmi4cMalloc((size_t)fileInfo.uncompressed_size+1);
+    size_t bytesRead = 0;
+    while(buffer != NULL && bytesRead < fileInfo.uncompressed_size) {
+        unsigned chunk = (unsigned)(fileInfo.uncompressed_size-bytesRead < ARCHIVE_BUFFER_SIZE ?
+                                    fileInfo.uncompressed_size-bytesRead : ARCHIVE_BUFFER_SIZE);
+        int status = unzReadCurrentFile(zip, buffer+bytesRead, chunk);
+        if(status <= 0) {
+            printf("Failed to read %s from archive: %s\n", fileName, archive);
+            fmi4cFree(buffer);
+            buffer = NULL;
+            break;
+        }
+        bytesRead += (size_t)status;
+    }
+    unzCloseCurrentFile(zip);
+    unzClose(zip);
+
+    if(buffer != NULL) {
+        buffer[bytesRead] = '\0';
+        (*size) = bytesRead;
+    }
+    return buffer;
+}
+
+
+//! @brief Reads a whole file into a null-terminated buffer
+//! @param path Path to file
+//! @param size Returns size of file (excluding null terminator)
+//! @returns Buffer to be freed by caller, or NULL on failure
+char *readFile(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if(file == NULL) {
+        printf("Cannot open file: %s\n", path);
+        return NULL;
+    }
+
+    char *buffer = NULL;
+    long length = -1;
+    if(fseek(file, 0, SEEK_END) == 0) {
+        length = ftell(file);
+    }
+    if(length >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        buffer = fmi4cMalloc((size_t)length+1);
+    }
+    if(buffer != NULL && fread(buffer, 1, (size_t)length, file) != (size_t)length) {
+        fmi4cFree(buffer);
+        buffer = NULL;
+    }
+    fclose(file);
+
+    if(buffer == NULL) {
+        printf("Failed to read file: %s\n", path);
+        return NULL;
+    }
+    buffer[length] = '\0';
+    (*size) = (size_t)length;
+    return buffer;
+}
+
+
+
+//! @brief Copies a file, failing if the target already exists
+//! @param source Path to source file
+//! @param target Path to new file
+//! @returns True if the file was copied
+bool copyFile(const char *source, const char *target)
+{
+#ifdef _WIN32
+    return CopyFileA(source, target, TRUE);
+#else
+    int in = open(source, O_RDONLY);
+    if(in < 0) {
+        return false;
+    }
+    struct stat st;
+    int out = -1;
+    if(fstat(in, &st) == 0) {
+        out = open(target, O_WRONLY|O_CREAT|O_EXCL, st.st_mode & 0777);
+    }
+    if(out < 0) {
+        close(in);
+        return false;
+    }
+
+    char buffer[ARCHIVE_BUFFER_SIZE];
+    bool ok = true;
+    ssize_t bytesRead;
+    while(ok && (bytesRead = read(in, buffer, sizeof(buffer))) > 0) {
+        ok = (write(out, buffer, (size_t)bytesRead) == bytesRead);
+    }
+    ok = ok && (bytesRead == 0);
+    close(in);
+    if(close(out) != 0 || !ok) {
+        unlink(target);
+        return false;
+    }
+    return true;
+#endif
+}
+
+//! @brief Skips an XML comment, processing instruction or CDATA section
+//! @param p Position of '<'
+//! @param end End of buffer
+//! @returns Position after the markup, p if it is not such markup, or NULL if it is not terminated
+static char *skipXmlMarkup(char *p, char *end)
+{
+    const char *terminator = NULL;
+    if(end-p >= 4 && !strncmp(p, "<!--", 4)) {
+        terminator = "-->";
+    }
+    else if(end-p >= 9 && !strncmp(p, "<![CDATA[", 9)) {
+        terminator = "]]>";
+    }
+    else if(end-p >= 2 && !strncmp(p, "<?", 2)) {
+        terminator = "?>";
+    }
+    else {
+        return p;
+    }
+    size_t length = strlen(terminator);
+    for(char *q = p+2; q+length <= end; ++q) {
+        if(!strncmp(q, terminator, length)) {
+            return q+length;
+        }
+    }
+    return NULL;
+}
+
+
+//! @brief Finds the end of a tag, skipping '>' in quoted attribute values
+//! @param p Position of '<'
+//! @param end End of buffer
+//! @returns Position of '>', or NULL if the tag is not terminated
+static char *findXmlTagEnd(char *p, char *end)
+{
+    char quote = 0;
+    for(; p < end; ++p) {
+        if(quote) {
+            if(*p == quote) {
+                quote = 0;
+            }
+        }
+        else if(*p == '"' || *p == '\'') {
+            quote = *p;
+        }
+        else if(*p == '>') {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+
+//! @brief Finds the next start tag in a buffer, skipping text, comments and processing instructions
+//! @param p Start of search
+//! @param end End of buffer
+//! @returns Position of '<' of the start tag, or NULL if there are no more start tags before the next end tag
+char *findNextXmlElement(char *p, char *end)
+{
+    while(p != NULL && p < end) {
+        if(*p != '<') {
+            ++p;
+            continue;
+        }
+        char *next = skipXmlMarkup(p, end);
+        if(next == p) {
+            return (p+1 < end && p[1] != '/') ? p : NULL;
+        }
+        p = next;
+    }
+    return NULL;
+}
+
+
+//! @brief Finds the end of an element, including all its child elements
+//! @param p Position of '<' of the start tag
+//! @param end End of buffer
+//! @returns Position after the closing '>' of the element, or NULL if the element is not terminated
+char *findXmlElementEnd(char *p, char *end)
+{
+    int depth = 0;
+    while(p != NULL && p < end) {
+        if(*p != '<') {
+            ++p;
+            continue;
+        }
+        char *next = skipXmlMarkup(p, end);
+        if(next != p) {
+            p = next;
+            continue;
+        }
+        bool endTag = (p+1 < end && p[1] == '/');
+        char *tagEnd = findXmlTagEnd(p, end);
+        if(tagEnd == NULL) {
+            return NULL;
+        }
+        if(endTag) {
+            --depth;
+        }
+        else if(tagEnd[-1] != '/') {
+            ++depth;
+        }
+        p = tagEnd+1;
+        if(depth <= 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+//! @brief Extracts all files in a zip archive whose names start with a given prefix
+//! @param archive Path to zip archive
+//! @param prefix Prefix of the file names to extract, e.g. "resources/"
+//! @param targetDirectory Directory where files are extracted (keeping their relative paths)
+//! @returns True if all matching files were extracted, else false
+bool extractFilesFromArchive(const char *archive, const char *prefix, const char *targetDirectory)
+{
+    unzFile zip = unzOpen64(archive);
+    if(zip == NULL) {
+        printf("Cannot open archive: %s\n", archive);
+        return false;
+    }
+
+    char buffer[ARCHIVE_BUFFER_SIZE];
+    size_t prefixLength = strlen(prefix);
+    bool ok = true;
+    for(int status = unzGoToFirstFile(zip); ok && status == UNZ_OK; status = unzGoToNextFile(zip)) {
+        char fileName[FILENAME_MAX];
+        unz_file_info64 fileInfo;
+        if(unzGetCurrentFileInfo64(zip, &fileInfo, fileName, sizeof(fileName), NULL, 0, NULL, 0) != UNZ_OK) {
+            ok = false;
+            break;
+        }
+        if(strncmp(fileName, prefix, prefixLength)) {
+            continue;   //Not requested
+        }
+
+        char path[FILENAME_MAX];
+        snprintf(path, sizeof(path), "%s/%s", targetDirectory, fileName);
+        size_t pathLength = strlen(path);
+        if(path[pathLength-1] == '/') {
+            ok = makeDirectories(path);     //Directory entry
+            continue;
+        }
+
+        //Create parent directory
+        char* lastSeparator = strrchr(path, '/');
+        *lastSeparator = '\0';
+        ok = makeDirectories(path);
+        *lastSeparator = '/';
+        if(!ok) {
+            break;
+        }
+
+        FILE *file = fopen(path, "wb");
+        if(file == NULL || unzOpenCurrentFile(zip) != UNZ_OK) {
+            printf("Failed to extract %s to %s\n", fileName, path);
+            if(file != NULL) {
+                fclose(file);
+            }
+            ok = false;
+            break;
+        }
+        int bytesRead;
+        while((bytesRead = unzReadCurrentFile(zip, buffer, sizeof(buffer))) > 0) {
+            if(fwrite(buffer, 1, (size_t)bytesRead, file) != (size_t)bytesRead) {
+                bytesRead = -1;
+                break;
+            }
+        }
+        if(bytesRead < 0) {
+            printf("Failed to extract %s to %s\n", fileName, path);
+            ok = false;
+        }
+        fclose(file);
+        unzCloseCurrentFile(zip);
+    }
+    unzClose(zip);
+    return ok;
+}
+
+
+//! @brief Recursively removes a directory and everything in it (like "rm -rf")
+//! Symbolic links are removed, but never followed.
+//! @param path Directory to remove
+//! @returns True if successful
+bool removeDirectory(const char *path)
+{
+    char entryPath[FILENAME_MAX];
+    bool ok = true;
+#ifdef _WIN32
+    snprintf(entryPath, sizeof(entryPath), "%s/*", path);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(entryPath, &data);
+    if(find != INVALID_HANDLE_VALUE) {
+        do {
+            if(!strcmp(data.cFileName, ".") || !strcmp(data.cFileName, "..")) {
+                continue;
+            }
+            snprintf(entryPath, sizeof(entryPath), "%s/%s", path, data.cFileName);
+            if((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && !(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+                ok = removeDirectory(entryPath) && ok;
+            }
+            else if(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                ok = RemoveDirectoryA(entryPath) && ok;
+            }
+            else {
+                ok = DeleteFileA(entryPath) && ok;
+            }
+        } while(FindNextFileA(find, &data));
+        FindClose(find);
+    }
+    ok = RemoveDirectoryA(path) && ok;
+#else
+    DIR *dir = opendir(path);
+    if(dir != NULL) {
+        struct dirent *entry;
+        while((entry = readdir(dir)) != NULL) {
+            if(!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+                continue;
+            }
+            snprintf(entryPath, sizeof(entryPath), "%s/%s", path, entry->d_name);
+            struct stat status;
+            if(lstat(entryPath, &status) == 0 && S_ISDIR(status.st_mode)) {
+                ok = removeDirectory(entryPath) && ok;
+            }
+            else {
+                ok = (unlink(entryPath) == 0) && ok;
+            }
+        }
+        closedir(dir);
+    }
+    ok = (rmdir(path) == 0) && ok;
+#endif
+    if(!ok) {
+        printf("Failed to remove directory: %s\n", path);
+    }
+    return ok;
+}
+
+
+//! @brief Computes the CRC32 checksum of a file, used for identifying FMU archives by their contents
+//! @param path Path to file
+//! @param checksum Returns the CRC32 checksum
+//! @param size Returns the file size in bytes
+//! @returns True if the whole file could be read
+bool computeFileChecksum(const char *path, unsigned long *checksum, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if(file == NULL) {
+        return false;
+    }
+
+    unsigned char buffer[ARCHIVE_BUFFER_SIZE];
+    uLong crc = crc32(0L, Z_NULL, 0);
+    size_t bytesRead;
+    *size = 0;
+    while((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        crc = crc32(crc, buffer, (uInt)bytesRead);
+        *size += bytesRead;
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+
+    *checksum = crc;
+    return ok;
+}
+
+#define ARENA_BLOCK_SIZE 65536
+#define ARENA_ALIGNMENT 16
+
+struct fmiArenaBlock {
+    fmiArenaBlock *next;
+    size_t size;
+    size_t used;
+};
+
+//! @brief Size of the block header, rounded up so that block data is aligned
+#define ARENA_HEADER_SIZE ((sizeof(fmiArenaBlock)+ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1))
+
+
+//! @brief Allocates memory from an arena. The memory is only released by freeArena().
+//! Small allocations are carved from large blocks, allocations larger than a block get a block of their own.
+//! @param arena Arena (zero-initialized before first use)
+//! @param size Number of bytes to allocate
+//! @returns Pointer to zero-initialized memory aligned for any type
+void *arenaAlloc(fmiArena *arena, size_t size)
+{
+    size = (size+ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1);
+    fmiArenaBlock *block = arena->blocks;
+    if(block == NULL || block->size-block->used < size) {
+        size_t blockSize = (size > ARENA_BLOCK_SIZE/4) ? size : ARENA_BLOCK_SIZE;
+        fmiArenaBlock *newBlock = fmi4cCalloc(1, ARENA_HEADER_SIZE+blockSize);   //Zeroed, so that unset fields are well defined in description cache images
+        if(newBlock == NULL) {
+            return NULL;
+        }
+        newBlock->size = blockSize;
+        newBlock->used = 0;
+        if(block != NULL && blockSize != ARENA_BLOCK_SIZE) {
+            //Keep filling the current block, dedicated blocks are full from the start
+            newBlock->next = block->next;
+            block->next = newBlock;
+        }
+        else {
+            newBlock->next = block;
+            arena->blocks = newBlock;
+        }
+        block = newBlock;
+    }
+    void *ptr = (char*)block+ARENA_HEADER_SIZE+block->used;
+    block->used += size;
+    return ptr;
+}
+
+
+//! @brief Grows an arena allocation, in place if it was the latest allocation and there is room in the block
+//! @param arena Arena
+//! @param ptr Previous allocation, or NULL
+//! @param oldSize Size of previous allocation
+//! @param newSize Requested size
+//! @returns Pointer to memory with the contents of the previous allocation
+void *arenaRealloc(fmiArena *arena, void *ptr, size_t oldSize, size_t newSize)
+{
+    fmiArenaBlock *block = arena->blocks;
+    if(ptr != NULL && block != NULL) {
+        size_t alignedOldSize = (oldSize+ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1);
+        size_t alignedNewSize = (newSize+ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1);
+        char *end = (char*)block+ARENA_HEADER_SIZE+block->used;
+        if((char*)ptr+alignedOldSize == end && block->used-alignedOldSize+alignedNewSize <= block->size) {
+            block->used = block->used-alignedOldSize+alignedNewSize;
+            return ptr;
+        }
+    }
+    void *newPtr = arenaAlloc(arena, newSize);
+    if(newPtr != NULL && ptr != NULL) {
+        memcpy(newPtr, ptr, oldSize < newSize ? oldSize : newSize);
+    }
+    return newPtr;
+}
+
+
+//! @brief Duplicates a string into an arena
+//! @param arena Arena
+//! @param str String to copy
+//! @returns Copy of the string (writable, unlike the original)
+char *arenaStrdup(fmiArena *arena, const char *str)
+{
+    size_t length = strlen(str)+1;
+    char *copy = arenaAlloc(arena, length);
+    if(copy != NULL) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+
+struct fmiArenaBuffer {
+    fmiArenaBuffer *next;
+    void *data;
+};
+
+
+//! @brief Makes an arena the owner of a buffer allocated with fmi4cMalloc(), so that it is released by freeArena()
+//! @param arena Arena
+//! @param buffer Buffer to adopt
+//! @returns True if successful, else the buffer is still owned by the caller
+bool arenaAdopt(fmiArena *arena, void *buffer)
+{
+    fmiArenaBuffer *node = arenaAlloc(arena, sizeof(fmiArenaBuffer));
+    if(node == NULL) {
+        return false;
+    }
+    node->data = buffer;
+    node->next = arena->buffers;
+    arena->buffers = node;
+    return true;
+}
+
+
+//! @brief Releases all memory allocated from an arena
+//! @param arena Arena
+void freeArena(fmiArena *arena)
+{
+    for(fmiArenaBuffer *buffer = arena->buffers; buffer != NULL; buffer = buffer->next) {
+        fmi4cFree(buffer->data);
+    }
+    arena->buffers = NULL;
+    fmiArenaBlock *block = arena->blocks;
+    while(block != NULL) {
+        fmiArenaBlock *next = block->next;
+        fmi4cFree(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+}
+
+
+struct fmiImageRegion {
+    const char *start;
+    size_t size;
+    size_t offset;
+};
+
+static int compareImageRegions(const void *a, const void *b)
+{
+    const char *startA = ((const fmiImageRegion*)a)->start;
+    const char *startB = ((const fmiImageRegion*)b)->start;
+    return (startA > startB) - (startA < startB);
+}
+
+
+//! @brief Starts writing an image, by copying a root structure and all used memory of an arena
+//! Pointers in the copy must then be converted with relocatePointer() and relocateString().
+//! @param image Image to initialize, released with freeImage()
+//! @param root Structure that holds the pointers into the arena, placed at offset 0 in the image
+//! @param rootSize Size of root structure
+//! @param arena Arena
+//! @returns True if successful
+bool beginImage(fmiImage *image, const void *root, size_t rootSize, const fmiArena *arena)
+{
+    image->writing = true;
+    image->ok = false;
+    image->size = 0;
+    image->numberOfRegions = 1;
+    for(fmiArenaBlock *block = arena->blocks; block != NULL; block = block->next) {
+        ++image->numberOfRegions;
+    }
+    image->regions = fmi4cMalloc(image->numberOfRegions*sizeof(fmiImageRegion));
+    if(image->regions == NULL) {
+        image->data = NULL;
+        return false;
+    }
+
+    //Regions keep their alignment, since they all start at multiples of the arena alignment
+    image->regions[0].start = root;
+    image->regions[0].size = rootSize;
+    image->regions[0].offset = 0;
+    size_t offset = (rootSize+ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1);
+    int i = 1;
+    for(fmiArenaBlock *block = arena->blocks; block != NULL; block = block->next, ++i) {
+        image->regions[i].start = (const char*)block+ARENA_HEADER_SIZE;
+        image->regions[i].size = block->used;
+        image->regions[i].offset = offset;
+        offset += block->used;
+    }
+
+    image->capacity = offset+offset/8+64;
+    image->data = fmi4cCalloc(1, image->capacity);
+    if(image->data == NULL) {
+        fmi4cFree(image->regions);
+        image->regions = NULL;
+        return false;
+    }
+    for(i=0; i<image->numberOfRegions; ++i) {
+        memcpy(image->data+image->regions[i].offset, image->regions[i].start, image->regions[i].size);
+    }
+    image->size = offset+1;     //Terminated, so that no string can run past the end of the image
+    qsort(image->regions, image->numberOfRegions, sizeof(fmiImageRegion), compareImageRegions);
+    image->ok = true;
+    return true;
+}
+
+
+//! @brief Opens an image for reading, pointers are converted back in place by relocatePointer() and relocateString()
+//! @param image Image to initialize
+//! @param data Image data, must be writable and end with a null character
+//! @param size Size of image data
+void openImage(fmiImage *image, char *data, size_t size)
+{
+    image->data = data;
+    image->size = size;
+    image->capacity = size;
+    image->regions = NULL;
+    image->numberOfRegions = 0;
+    image->writing = false;
+    image->ok = (size > 0 && data[size-1] == '\0');
+}
+
+
+//! @brief Releases memory owned by an image (only written images own their data)
+//! @param image Image
+void freeImage(fmiImage *image)
+{
+    if(image->writing) {
+        fmi4cFree(image->data);
+    }
+    fmi4cFree(image->regions);
+    image->data = NULL;
+    image->regions = NULL;
+}
+
+
+//! @brief Finds the image offset of a live address that was copied into the image
+//! @param image Image being written
+//! @param address Address of copied memory (may point to the end of a region)
+//! @param offset Returns offset in image
+//! @returns True if the address is inside a copied region
+static bool findImageOffset(const fmiImage *image, const void *address, size_t *offset)
+{
+    const char *p = address;
+    int low = 0;
+    int high = image->numberOfRegions-1;
+    while(low <= high) {
+        int middle = (low+high)/2;
+        if(image->regions[middle].start <= p) {
+            low = middle+1;
+        }
+        else {
+            high = middle-1;
+        }
+    }
+    if(high < 0 || p > image->regions[high].start+image->regions[high].size) {
+        return false;
+    }
+    (*offset) = image->regions[high].offset+(size_t)(p-image->regions[high].start);
+    return true;
+}
+
+
+//! @brief Stores a relocated pointer value in the copy of a field in a written image
+static void storeImageOffset(fmiImage *image, const void *field, uintptr_t stored)
+{
+    size_t fieldOffset;
+    if(!findImageOffset(image, field, &fieldOffset) || fieldOffset+sizeof(void*) > image->size) {
+        image->ok = false;
+        return;
+    }
+    memcpy(image->data+fieldOffset, &stored, sizeof(void*));
+}
+
+
+//! @brief Relocates a pointer to an array in an image
+//! When writing, the field and the array must be in the root structure or the arena, and the live pointer is returned.
+//! When reading, the field is converted back to a pointer into the image, and the array is checked to be inside the image.
+//! @param image Image
+//! @param field Address of the pointer field
+//! @param count Number of array elements (pointers to arrays with elements must not be NULL)
+//! @param elementSize Size of one array element
+//! @returns Pointer value, or NULL if it could not be relocated
+void *relocatePointer(fmiImage *image, void *field, size_t count, size_t elementSize)
+{
+    void *value;
+    memcpy(&value, field, sizeof(void*));
+    if(image->writing) {
+        size_t offset;
+        if(value == NULL) {
+            image->ok = image->ok && count == 0;
+            storeImageOffset(image, field, 0);
+        }
+        else if(findImageOffset(image, value, &offset)) {
+            storeImageOffset(image, field, (uintptr_t)offset+1);
+        }
+        else {
+            image->ok = false;
+        }
+        return value;
+    }
+
+    uintptr_t stored = (uintptr_t)value;
+    value = NULL;
+    if(stored == 0) {
+        image->ok = image->ok && count == 0;
+    }
+    else if(stored-1 > image->size || (elementSize > 0 && count > (image->size-(stored-1))/elementSize)) {
+        image->ok = false;
+    }
+    else {
+        value = image->data+(stored-1);
+    }
+    memcpy(field, &value, sizeof(void*));
+    return value;
+}
+
+
+//! @brief Relocates a string pointer in an image
+//! When writing, strings that are not in the arena (such as string literals) are appended to the image.
+//! @param image Image
+//! @param field Address of the string pointer field
+//! @returns String
+const char *relocateString(fmiImage *image, void *field)
+{
+    const char *value;
+    memcpy(&value, field, sizeof(char*));
+    if(image->writing) {
+        size_t offset;
+        if(value == NULL) {
+            storeImageOffset(image, field, 0);
+        }
+        else if(findImageOffset(image, value, &offset)) {
+            storeImageOffset(image, field, (uintptr_t)offset+1);
+        }
+        else {
+            size_t length = strlen(value)+1;
+            if(image->size+length > image->capacity) {
+                size_t capacity = 2*image->capacity+length;
+                char *data = fmi4cRealloc(image->data, capacity);
+                if(data == NULL) {
+                    image->ok = false;
+                    return value;
+                }
+                image->data = data;
+                image->capacity = capacity;
+            }
+            memcpy(image->data+image->size, value, length);
+            uintptr_t stored = (uintptr_t)image->size+1;
+            image->size += length;
+            storeImageOffset(image, field, stored);
+        }
+        return value;
+    }
+
+    uintptr_t stored = (uintptr_t)value;
+    value = NULL;
+    if(stored > image->size) {
+        image->ok = false;
+    }
+    else if(stored > 0) {
+        value = image->data+(stored-1);     //Strings end before the null character at the end of the image
+    }
+    memcpy(field, &value, sizeof(char*));
+    return value;
+}
+
+
+//! @brief Maps a whole file into memory with private (copy-on-write) pages
+//! @param path Path to file
+//! @param size Returns size of file
+//! @returns Writable view of the file, to be released with unmapFile(), or NULL on failure
+void *mapFile(const char *path, size_t *size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER length;
+    void *data = NULL;
+    if(GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if(mapping != NULL) {
+            data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);   //The view keeps the mapping alive
+        }
+    }
+    CloseHandle(file);
+    if(data != NULL) {
+        (*size) = (size_t)length.QuadPart;
+    }
+    return data;
+#else
+    int file = open(path, O_RDONLY);
+    if(file < 0) {
+        return NULL;
+    }
+    struct stat status;
+    void *data = NULL;
+    if(fstat(file, &status) == 0 && status.st_size > 0) {
+        data = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if(data == MAP_FAILED) {
+            data = NULL;
+        }
+    }
+    close(file);
+    if(data != NULL) {
+        (*size) = (size_t)status.st_size;
+    }
+    return data;
+#endif
+}
+
+
+//! @brief Releases a file mapping created by mapFile()
+//! @param data Mapped view
+//! @param size Size of file
+void unmapFile(void *data, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+
+//! @brief Pins the calling thread to one processor core (not supported on all platforms)
+//! @param core Core index, wrapped around the number of available cores
+//! @returns True if the affinity was set
+bool setThreadAffinity(int core)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int numberOfCores = info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (core % numberOfCores % (8*sizeof(DWORD_PTR)))) != 0;
+#elif defined(__linux__)
+    long numberOfCores = sysconf(_SC_NPROCESSORS_ONLN);
+    if(numberOfCores < 1) {
+        numberOfCores = 1;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core % numberOfCores, &cpus);
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+
+//! @brief Starts timing a profiled FMU call (calls on one handle never overlap)
+//! @param profile Profile of FMU handle
+void beginProfiledCall(fmiProfile *profile)
+{
+    profile->callStartTime = getWallTime();
+}
+
+
+//! @brief Stops timing a profiled FMU call and adds it to the statistics of the calling function
+//! @param profile Profile of FMU handle
+//! @param function Wrapper function name (__func__, so the pointer identifies the function)
+//! @param numberOfValueReferences Number of value references in the call
+//! @param status Status returned by the FMU
+//! @returns The status, unchanged
+int endProfiledCall(fmiProfile *profile, const char *function, size_t numberOfValueReferences, int status)
+{
+    double time = getWallTime()-profile->callStartTime;
+
+    size_t slot = ((uintptr_t)function >> 4) & (FMI4C_PROFILE_SLOTS-1);
+    while(profile->functions[slot].function != function) {
+        if(profile->functions[slot].function == NULL) {
+            profile->functions[slot].function = function;
+            ++profile->numberOfFunctions;
+            break;
+        }
+        slot = (slot+1) & (FMI4C_PROFILE_SLOTS-1);
+    }
+
+    fmiCallStatistics *statistics = &profile->functions[slot];
+    ++statistics->numberOfCalls;
+    statistics->numberOfValueReferences += numberOfValueReferences;
+    statistics->totalTime += time;
+    if(time > statistics->maxTime) {
+        statistics->maxTime = time;
+    }
+    return status;
+}
+
+
+//! @brief FNV-1a hash of a null-terminated string
+static size_t hashName(const char *name)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(const unsigned char *c = (const unsigned char*)name; *c; ++c) {
+        hash ^= *c;
+        hash *= 1099511628211ULL;
+    }
+    return (size_t)hash;
+}
+
+//! @brief Fibonacci hash of a value reference
+static size_t hashValueReference(int64_t valueReference)
+{
+    uint64_t hash = (uint64_t)valueReference * 11400714819323198485ULL;
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+static const char *indexedName(const fmiVariableIndex *index, int i)
+{
+    return *(const char**)(index->variables + (size_t)i*index->stride + index->nameOffset);
+}
+
+static int64_t indexedValueReference(const fmiVariableIndex *index, int i)
+{
+    return *(const int64_t*)(index->variables + (size_t)i*index->stride + index->valueReferenceOffset);
+}
+
+//! @brief Builds hash indexes for variable lookup by name and by value reference.
+//! The variable array must not be reallocated while the index is in use.
+//! If several variables share a key (e.g. aliases), lookup returns the first one.
+//! @param index Index to build
+//! @param variables Array of variable handles
+//! @param numberOfVariables Number of variables in array
+//! @param stride Size of one variable handle
+//! @param nameOffset Offset of the name member (const char*) in the variable handle
+//! @param valueReferenceOffset Offset of the value reference member (int64_t) in the variable handle
+void buildVariableIndex(fmiVariableIndex *index, const void *variables, int numberOfVariables, size_t stride, size_t nameOffset, size_t valueReferenceOffset)
+{
+    index->variables = (const char*)variables;
+    index->stride = stride;
+    index->nameOffset = nameOffset;
+    index->valueReferenceOffset = valueReferenceOffset;
+
+    //Use a power of two with a load factor of at most 0.5
+    size_t size = 16;
+    while(size < 2*(size_t)numberOfVariables) {
+        size *= 2;
+    }
+    index->mask = size-1;
+    index->nameSlots = fmi4cCalloc(size, sizeof(int));
+    index->valueReferenceSlots = fmi4cCalloc(size, sizeof(int));
+
+    for(int i=0; i<numberOfVariables; ++i) {
+        const char *name = indexedName(index, i);
+        if(name != NULL) {
+            size_t slot = hashName(name) & index->mask;
+            while(index->nameSlots[slot] != 0 && strcmp(indexedName(index, index->nameSlots[slot]-1), name)) {
+                slot = (slot+1) & index->mask;
+            }
+            if(index->nameSlots[slot] == 0) {
+                index->nameSlots[slot] = i+1;
+            }
+        }
+
+        int64_t valueReference = indexedValueReference(index, i);
+        size_t slot = hashValueReference(valueReference) & index->mask;
+        while(index->valueReferenceSlots[slot] != 0 && indexedValueReference(index, index->valueReferenceSlots[slot]-1) != valueReference) {
+            slot = (slot+1) & index->mask;
+        }
+        if(index->valueReferenceSlots[slot] == 0) {
+            index->valueReferenceSlots[slot] = i+1;
+        }
+    }
+}
+
+//! @brief Releases memory used by a variable index
+//! @param index Index to free
+void freeVariableIndex(fmiVariableIndex *index)
+{
+    fmi4cFree(index->nameSlots);
+    fmi4cFree(index->valueReferenceSlots);
+    index->nameSlots = NULL;
+    index->valueReferenceSlots = NULL;
+}
+
+//! @brief Looks up a variable by name
+//! @param index Variable index
+//! @param name Variable name
+//! @returns Index of variable in variable array, or -1 if not found
+int findVariableIndexByName(const fmiVariableIndex *index, const char *name)
+{
+    if(index->nameSlots == NULL || name == NULL) {
+        return -1;
+    }
+    for(size_t slot = hashName(name) & index->mask; index->nameSlots[slot] != 0; slot = (slot+1) & index->mask) {
+        if(!strcmp(indexedName(index, index->nameSlots[slot]-1), name)) {
+            return index->nameSlots[slot]-1;
+        }
+    }
+    return -1;
+}
+
+//! @brief Looks up a variable by value reference
+//! @param index Variable index
+//! @param valueReference Value reference
+//! @returns Index of (first) variable with value reference in variable array, or -1 if not found
+int findVariableIndexByValueReference(const fmiVariableIndex *index, int64_t valueReference)
+{
+    if(index->valueReferenceSlots == NULL) {
+        return -1;
+    }
+    for(size_t slot = hashValueReference(valueReference) & index->mask; index->valueReferenceSlots[slot] != 0; slot = (slot+1) & index->mask) {
+        if(indexedValueReference(index, index->valueReferenceSlots[slot]-1) == valueReference) {
+            return index->valueReferenceSlots[slot]-1;
+        }
+    }
+    return -1;
+}
+
 //! @brief Parses specified XML attribute and assigns it to target
 //! @param element XML element
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
+//! @param arena Arena that owns the string
 //! @returns True if attribute was found, else false
-bool parseStringAttributeEzXml(ezxml_t element, const char *attributeName, const char **target)
+bool parseStringAttributeXml(fmiXmlElement element, const char *attributeName, const char **target, fmiArena *arena)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = _strdup(ezxml_attr(element, attributeName));
-        return true;
-    }
-    return false;
+    return parseStringAttribute(xmlAttribute(element, attributeName), target, arena);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -39,13 +1098,9 @@ bool parseStringAttributeEzXml(ezxml_t element, const char *attributeName, const
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseBooleanAttributeEzXml(ezxml_t element, const char *attributeName, bool *target)
+bool parseBooleanAttributeXml(fmiXmlElement element, const char *attributeName, bool *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = !strcmp(ezxml_attr(element, attributeName), "true");
-        return true;
-    }
-    return false;
+    return parseBooleanAttribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -53,13 +1108,9 @@ bool parseBooleanAttributeEzXml(ezxml_t element, const char *attributeName, bool
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseFloat64AttributeEzXml(ezxml_t element, const char *attributeName, double *target)
+bool parseFloat64AttributeXml(fmiXmlElement element, const char *attributeName, double *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = atof(ezxml_attr(element, attributeName));
-        return true;
-    }
-    return false;
+    return parseFloat64Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -67,13 +1118,9 @@ bool parseFloat64AttributeEzXml(ezxml_t element, const char *attributeName, doub
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseInt16AttributeEzXml(ezxml_t element, const char *attributeName, short *target)
+bool parseInt16AttributeXml(fmiXmlElement element, const char *attributeName, short *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = (short)atoi(ezxml_attr(element, attributeName));
-        return true;
-    }
-    return false;
+    return parseInt16Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -81,13 +1128,9 @@ bool parseInt16AttributeEzXml(ezxml_t element, const char *attributeName, short
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseInt64AttributeEzXml(ezxml_t element, const char *attributeName, int64_t* target)
+bool parseInt64AttributeXml(fmiXmlElement element, const char *attributeName, int64_t* target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = atol(ezxml_attr(element, attributeName));
-        return true;
-    }
-    return false;
+    return parseInt64Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -95,13 +1138,9 @@ bool parseInt64AttributeEzXml(ezxml_t element, const char *attributeName, int64_
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseInt32AttributeEzXml(ezxml_t element, const char *attributeName, int32_t *target)
+bool parseInt32AttributeXml(fmiXmlElement element, const char *attributeName, int32_t *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = atoi(ezxml_attr(element, attributeName));
-        return true;
-    }
-    return false;
+    return parseInt32Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -109,13 +1148,9 @@ bool parseInt32AttributeEzXml(ezxml_t element, const char *attributeName, int32_
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseFloat32AttributeEzXml(ezxml_t element, const char *attributeName, float *target)
+bool parseFloat32AttributeXml(fmiXmlElement element, const char *attributeName, float *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = (float)atof(ezxml_attr(element, attributeName));
-        return true;
-    }
-    return false;
+    return parseFloat32Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -123,13 +1158,9 @@ bool parseFloat32AttributeEzXml(ezxml_t element, const char *attributeName, floa
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseInt8AttributeEzXml(ezxml_t element, const char *attributeName, int8_t *target)
+bool parseInt8AttributeXml(fmiXmlElement element, const char *attributeName, int8_t *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = (int8_t)atoi(ezxml_attr(element, attributeName));
-        return true;
-    }
-    return false;
+    return parseInt8Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -137,13 +1168,9 @@ bool parseInt8AttributeEzXml(ezxml_t element, const char *attributeName, int8_t
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseUInt64AttributeEzXml(ezxml_t element, const char *attributeName, uint64_t *target)
+bool parseUInt64AttributeXml(fmiXmlElement element, const char *attributeName, uint64_t *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = strtoul(ezxml_attr(element, attributeName), NULL, 10);
-        return true;
-    }
-    return false;
+    return parseUInt64Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -151,13 +1178,9 @@ bool parseUInt64AttributeEzXml(ezxml_t element, const char *attributeName, uint6
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseUInt32AttributeEzXml(ezxml_t element, const char *attributeName, uint32_t *target)
+bool parseUInt32AttributeXml(fmiXmlElement element, const char *attributeName, uint32_t *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = (uint32_t)strtoul(ezxml_attr(element, attributeName), NULL, 10);
-        return true;
-    }
-    return false;
+    return parseUInt32Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -165,13 +1188,9 @@ bool parseUInt32AttributeEzXml(ezxml_t element, const char *attributeName, uint3
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseUInt16AttributeEzXml(ezxml_t element, const char *attributeName, uint16_t *target)
+bool parseUInt16AttributeXml(fmiXmlElement element, const char *attributeName, uint16_t *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = (uint16_t)strtoul(ezxml_attr(element, attributeName), NULL, 10);
-        return true;
-    }
-    return false;
+    return parseUInt16Attribute(xmlAttribute(element, attributeName), target);
 }
 
 //! @brief Parses specified XML attribute and assigns it to target
@@ -179,40 +1198,274 @@ bool parseUInt16AttributeEzXml(ezxml_t element, const char *attributeName, uint1
 //! @param attributeName Attribute name
 //! @param target Pointer to target variable
 //! @returns True if attribute was found, else false
-bool parseUInt8AttributeEzXml(ezxml_t element, const char *attributeName, uint8_t *target)
+bool parseUInt8AttributeXml(fmiXmlElement element, const char *attributeName, uint8_t *target)
+{
+    return parseUInt8Attribute(xmlAttribute(element, attributeName), target);
+}
+
+// Attribute names known to decodeAttributesXml(), at their perfect hash slot (see hashAttributeName())
+static const struct {
+    const char *name;
+    fmiAttribute attribute;
+} attributeSlots[64] = {
+    [2] = { "intermediateUpdate", fmiAttributeIntermediateUpdate },
+    [5] = { "valueReference", fmiAttributeValueReference },
+    [9] = { "canBeDeactivated", fmiAttributeCanBeDeactivated },
+    [10] = { "clocks", fmiAttributeClocks },
+    [11] = { "priority", fmiAttributePriority },
+    [13] = { "shiftDecimal", fmiAttributeShiftDecimal },
+    [15] = { "unit", fmiAttributeUnit },
+    [17] = { "start", fmiAttributeStart },
+    [18] = { "intervalVariability", fmiAttributeIntervalVariability },
+    [19] = { "intervalCounter", fmiAttributeIntervalCounter },
+    [21] = { "declaredType", fmiAttributeDeclaredType },
+    [25] = { "min", fmiAttributeMin },
+    [26] = { "reinit", fmiAttributeReinit },
+    [32] = { "quantity", fmiAttributeQuantity },
+    [33] = { "canHandleMultipleSetPerTimeInstant", fmiAttributeCanHandleMultipleSetPerTimeInstant },
+    [34] = { "displayUnit", fmiAttributeDisplayUnit },
+    [36] = { "nominal", fmiAttributeNominal },
+    [38] = { "maxSize", fmiAttributeMaxSize },
+    [40] = { "description", fmiAttributeDescription },
+    [41] = { "intervalDecimal", fmiAttributeIntervalDecimal },
+    [42] = { "resolution", fmiAttributeResolution },
+    [43] = { "previous", fmiAttributePrevious },
+    [45] = { "variability", fmiAttributeVariability },
+    [47] = { "max", fmiAttributeMax },
+    [48] = { "mimeType", fmiAttributeMimeType },
+    [49] = { "supportsFraction", fmiAttributeSupportsFraction },
+    [51] = { "shiftCounter", fmiAttributeShiftCounter },
+    [52] = { "causality", fmiAttributeCausality },
+    [53] = { "derivative", fmiAttributeDerivative },
+    [55] = { "relativeQuantity", fmiAttributeRelativeQuantity },
+    [57] = { "initial", fmiAttributeInitial },
+    [59] = { "unbounded", fmiAttributeUnbounded },
+    [63] = { "name", fmiAttributeName },
+};
+
+//! @brief Perfect hash of the attribute names in attributeSlots (no two of them share a slot)
+//! Must be regenerated together with the table when attribute names are added.
+static size_t hashAttributeName(const char *name, size_t length)
+{
+    return (length*4 + (unsigned char)name[0]*9 + (unsigned char)name[length-1]*7 + (unsigned char)name[length/2]*6) & 63;
+}
+
+//! @brief Decodes the attributes of an XML element in one pass over its attribute list
+//! Each attribute name is looked up with one hash and one string comparison, so decoding is linear in the
+//! number of attributes, instead of one linear search per looked up attribute as with xmlAttribute().
+//! Unknown attributes are ignored. Default attributes declared in a DTD are not decoded.
+//! @param element XML element
+//! @param values Returns the value of each attribute in fmiAttribute, or NULL if not defined
+void decodeAttributesXml(fmiXmlElement element, const char *values[fmiNumberOfAttributes])
+{
+    for(int i=0; i<fmiNumberOfAttributes; ++i) {
+        values[i] = NULL;
+    }
+    void *cursor = NULL;
+    const char *name;
+    const char *value;
+    while(xmlNextAttribute(element, &cursor, &name, &value)) {
+        size_t length = strlen(name);
+        if(length == 0) {
+            continue;
+        }
+        size_t slot = hashAttributeName(name, length);
+        if(attributeSlots[slot].name != NULL && !strcmp(attributeSlots[slot].name, name) &&
+           values[attributeSlots[slot].attribute] == NULL) {
+            values[attributeSlots[slot].attribute] = value;     //First definition wins, as in xmlAttribute()
+        }
+    }
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @param arena Arena that owns the string
+//! @returns True if attribute was defined, else false
+bool parseStringAttribute(const char *value, const char **target, fmiArena *arena)
+{
+    if(value) {
+#ifdef FMI4C_WITH_PUGIXML
+        (void)arena;
+        (*target) = value;      //In-situ parsing, the document buffer is owned by the arena
+#else
+        (*target) = arenaStrdup(arena, value);
+#endif
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseBooleanAttribute(const char *value, bool *target)
+{
+    if(value) {
+        (*target) = !strcmp(value, "true");
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseFloat64Attribute(const char *value, double *target)
+{
+    if(value) {
+        (*target) = atof(value);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseInt16Attribute(const char *value, int16_t *target)
+{
+    if(value) {
+        (*target) = (int16_t)atoi(value);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseInt64Attribute(const char *value, int64_t *target)
 {
-    if(ezxml_attr(element, attributeName)) {
-        (*target) = (uint8_t)strtoul(ezxml_attr(element, attributeName), NULL, 10);
+    if(value) {
+        (*target) = atol(value);
         return true;
     }
     return false;
 }
 
-bool parseModelStructureElement(fmi3ModelStructureElement *output, ezxml_t *element)
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseInt32Attribute(const char *value, int32_t *target)
 {
-    //Count number of dependencies
+    if(value) {
+        (*target) = atoi(value);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseFloat32Attribute(const char *value, float *target)
+{
+    if(value) {
+        (*target) = (float)atof(value);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseInt8Attribute(const char *value, int8_t *target)
+{
+    if(value) {
+        (*target) = (int8_t)atoi(value);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseUInt64Attribute(const char *value, uint64_t *target)
+{
+    if(value) {
+        (*target) = strtoul(value, NULL, 10);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseUInt32Attribute(const char *value, uint32_t *target)
+{
+    if(value) {
+        (*target) = (uint32_t)strtoul(value, NULL, 10);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseUInt16Attribute(const char *value, uint16_t *target)
+{
+    if(value) {
+        (*target) = (uint16_t)strtoul(value, NULL, 10);
+        return true;
+    }
+    return false;
+}
+
+//! @brief Parses an attribute value, from decodeAttributesXml() or xmlAttribute(), and assigns it to target
+//! @param value Attribute value, or NULL if the attribute is not defined
+//! @param target Pointer to target variable
+//! @returns True if attribute was defined, else false
+bool parseUInt8Attribute(const char *value, uint8_t *target)
+{
+    if(value) {
+        (*target) = (uint8_t)strtoul(value, NULL, 10);
+        return true;
+    }
+    return false;
+}
+
+bool parseModelStructureElement(fmi3ModelStructureElement *output, fmiXmlElement *element, fmiArena *arena)
+{
+    output->valueReference = 0;
     output->numberOfDependencies = 0;
+    output->dependenciesDefined = false;
+    output->dependencyKindsDefined = false;
+    output->dependencies = NULL;
+    output->dependencyKinds = NULL;
+    parseUInt32AttributeXml(*element, "valueReference", &output->valueReference);
+
     const char* dependencies = NULL;
-    if(parseStringAttributeEzXml(*element, "dependencies", &dependencies)) {
-        char* nonConstDependencies = _strdup(dependencies);
-        free((char*)dependencies);
+    if(parseStringAttributeXml(*element, "dependencies", &dependencies, arena)) {
+        char* nonConstDependencies = (char*)dependencies;   //Owned by the arena, safe to tokenize
+        output->dependenciesDefined = true;
 
-        //Count number of dependencies
-        if(nonConstDependencies != NULL) {
-            output->numberOfDependencies = 1;
-        }
-        else {
-            return true;
-        }
+        //Count number of dependencies (an empty list means no dependencies)
         for(int i=0; nonConstDependencies[i]; ++i) {
-            if(nonConstDependencies[i] == ' ') {
+            if(nonConstDependencies[i] != ' ' && (i == 0 || nonConstDependencies[i-1] == ' ')) {
                 ++output->numberOfDependencies;
             }
         }
-
+        if(output->numberOfDependencies == 0) {
+            return true;
+        }
 
         //Allocate memory for dependencies
-        output->dependencies = malloc(output->numberOfDependencies*sizeof(fmi3ValueReference));
+        output->dependencies = arenaAlloc(arena, output->numberOfDependencies*sizeof(fmi3ValueReference));
 
         //Read dependencies
         const char* delim = " ";
@@ -227,13 +1480,13 @@ bool parseModelStructureElement(fmi3ModelStructureElement *output, ezxml_t *elem
 
         //Parse depenendency kinds element if present
         const char* dependencyKinds = NULL;
-        parseStringAttributeEzXml(*element, "dependencyKinds", &dependencyKinds);
+        parseStringAttributeXml(*element, "dependencyKinds", &dependencyKinds, arena);
         if(dependencyKinds) {
-            char* nonConstDependencyKinds = _strdup(dependencyKinds);
-            free((char*)dependencyKinds);
+            char* nonConstDependencyKinds = (char*)dependencyKinds;
+            output->dependencyKindsDefined = true;
 
-            //Allocate memory for dependencies (assume same number as dependencies, according to FMI3 specification)
-            output->dependencies = malloc(output->numberOfDependencies*sizeof(fmi3ValueReference));
+            //Allocate memory for dependency kinds (assume same number as dependencies, according to FMI3 specification)
+            output->dependencyKinds = arenaAlloc(arena, output->numberOfDependencies*sizeof(fmi3DependencyKind));
 
             //Read dependency kinds
             for(int j=0; j<output->numberOfDependencies; ++j) {
@@ -245,10 +1498,12 @@ bool parseModelStructureElement(fmi3ModelStructureElement *output, ezxml_t *elem
                     kind = strtok(NULL, delim);
                 }
 
-                if(!strcmp(kind, "independent")) {
+                if(kind == NULL) {
+                    fmi4cErrorMessage = _strdup("Number of dependency kinds does not match number of dependencies.");
+                    return false;
+                }
+                else if(!strcmp(kind, "independent")) {
                     fmi4cErrorMessage = _strdup("Dependency kind = \"independent\" is not allowed for output dependencies.");
-                    free(nonConstDependencyKinds);
-                    free(nonConstDependencies);
                     return false;
                 }
                 else if(!strcmp(kind, "constant")) {
@@ -268,14 +1523,10 @@ bool parseModelStructureElement(fmi3ModelStructureElement *output, ezxml_t *elem
                 }
                 else {
                     fmi4cErrorMessage = _strdup("Unknown dependency kind for output dependency.");
-                    free(nonConstDependencyKinds);
-                    free(nonConstDependencies);
                     return false;
                 }
             }
-            free(nonConstDependencyKinds);
         }
-        free(nonConstDependencies);
     }
 
     return true;
@@ -2,25 +2,113 @@
 #define FMIC_UTILS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
-#include "ezxml/ezxml.h"
+#include "fmi4c_xml.h"
 #include "fmi4c_private.h"
 
+// Attributes decoded by decodeAttributesXml()
+typedef enum {
+    fmiAttributeName,
+    fmiAttributeValueReference,
+    fmiAttributeDescription,
+    fmiAttributeCanHandleMultipleSetPerTimeInstant,
+    fmiAttributeIntermediateUpdate,
+    fmiAttributePrevious,
+    fmiAttributeDeclaredType,
+    fmiAttributeClocks,
+    fmiAttributeStart,
+    fmiAttributeCausality,
+    fmiAttributeVariability,
+    fmiAttributeInitial,
+    fmiAttributeQuantity,
+    fmiAttributeMin,
+    fmiAttributeMax,
+    fmiAttributeUnit,
+    fmiAttributeDisplayUnit,
+    fmiAttributeRelativeQuantity,
+    fmiAttributeUnbounded,
+    fmiAttributeNominal,
+    fmiAttributeDerivative,
+    fmiAttributeReinit,
+    fmiAttributeMimeType,
+    fmiAttributeMaxSize,
+    fmiAttributeCanBeDeactivated,
+    fmiAttributePriority,
+    fmiAttributeIntervalDecimal,
+    fmiAttributeShiftDecimal,
+    fmiAttributeSupportsFraction,
+    fmiAttributeResolution,
+    fmiAttributeIntervalCounter,
+    fmiAttributeShiftCounter,
+    fmiAttributeIntervalVariability,
+    fmiNumberOfAttributes
+} fmiAttribute;
+
 const char* getFunctionName(const char* modelName, const char* functionName);
 
-bool parseStringAttributeEzXml(ezxml_t element, const char* attributeName, const char** target);
-bool parseBooleanAttributeEzXml(ezxml_t element, const char* attributeName, bool* target);
-bool parseFloat64AttributeEzXml(ezxml_t element, const char* attributeName, double* target);
-bool parseFloat32AttributeEzXml(ezxml_t element, const char* attributeName, float *target);
-bool parseInt64AttributeEzXml(ezxml_t element, const char* attributeName, int64_t* target);
-bool parseInt32AttributeEzXml(ezxml_t element, const char* attributeName, int32_t* target);
-bool parseInt16AttributeEzXml(ezxml_t element, const char *attributeName, int16_t* target);
-bool parseInt8AttributeEzXml(ezxml_t element, const char *attributeName, int8_t* target);
-bool parseUInt64AttributeEzXml(ezxml_t element, const char* attributeName, uint64_t *target);
-bool parseUInt32AttributeEzXml(ezxml_t element, const char* attributeName, uint32_t* target);
-bool parseUInt16AttributeEzXml(ezxml_t element, const char *attributeName, uint16_t* target);
-bool parseUInt8AttributeEzXml(ezxml_t element, const char *attributeName, uint8_t *target);
-
-bool parseModelStructureElement(fmi3ModelStructureElement *output, ezxml_t *element);
+double getWallTime();
+bool makeDirectories(const char* path);
+char* readFileFromArchive(const char* archive, const char* fileName, size_t* size);
+char* readFile(const char* path, size_t* size);
+bool copyFile(const char* source, const char* target);
+char* findNextXmlElement(char* p, char* end);
+char* findXmlElementEnd(char* p, char* end);
+bool extractFilesFromArchive(const char* archive, const char* prefix, const char* targetDirectory);
+bool removeDirectory(const char* path);
+bool computeFileChecksum(const char* path, unsigned long* checksum, size_t* size);
+
+void *arenaAlloc(fmiArena *arena, size_t size);
+void *arenaRealloc(fmiArena *arena, void *ptr, size_t oldSize, size_t newSize);
+char *arenaStrdup(fmiArena *arena, const char *str);
+bool arenaAdopt(fmiArena *arena, void *buffer);
+void freeArena(fmiArena *arena);
+
+bool beginImage(fmiImage *image, const void *root, size_t rootSize, const fmiArena *arena);
+void openImage(fmiImage *image, char *data, size_t size);
+void freeImage(fmiImage *image);
+void *relocatePointer(fmiImage *image, void *field, size_t count, size_t elementSize);
+const char *relocateString(fmiImage *image, void *field);
+void *mapFile(const char *path, size_t *size);
+void unmapFile(void *data, size_t size);
+
+bool setThreadAffinity(int core);
+
+void beginProfiledCall(fmiProfile *profile);
+int endProfiledCall(fmiProfile *profile, const char *function, size_t numberOfValueReferences, int status);
+
+void buildVariableIndex(fmiVariableIndex *index, const void *variables, int numberOfVariables, size_t stride, size_t nameOffset, size_t valueReferenceOffset);
+void freeVariableIndex(fmiVariableIndex *index);
+int findVariableIndexByName(const fmiVariableIndex *index, const char *name);
+int findVariableIndexByValueReference(const fmiVariableIndex *index, int64_t valueReference);
+
+bool parseStringAttributeXml(fmiXmlElement element, const char* attributeName, const char** target, fmiArena* arena);
+bool parseBooleanAttributeXml(fmiXmlElement element, const char* attributeName, bool* target);
+bool parseFloat64AttributeXml(fmiXmlElement element, const char* attributeName, double* target);
+bool parseFloat32AttributeXml(fmiXmlElement element, const char* attributeName, float *target);
+bool parseInt64AttributeXml(fmiXmlElement element, const char* attributeName, int64_t* target);
+bool parseInt32AttributeXml(fmiXmlElement element, const char* attributeName, int32_t* target);
+bool parseInt16AttributeXml(fmiXmlElement element, const char *attributeName, int16_t* target);
+bool parseInt8AttributeXml(fmiXmlElement element, const char *attributeName, int8_t* target);
+bool parseUInt64AttributeXml(fmiXmlElement element, const char* attributeName, uint64_t *target);
+bool parseUInt32AttributeXml(fmiXmlElement element, const char* attributeName, uint32_t* target);
+bool parseUInt16AttributeXml(fmiXmlElement element, const char *attributeName, uint16_t* target);
+bool parseUInt8AttributeXml(fmiXmlElement element, const char *attributeName, uint8_t *target);
+
+void decodeAttributesXml(fmiXmlElement element, const char* values[fmiNumberOfAttributes]);
+bool parseStringAttribute(const char* value, const char** target, fmiArena* arena);
+bool parseBooleanAttribute(const char* value, bool* target);
+bool parseFloat64Attribute(const char* value, double* target);
+bool parseFloat32Attribute(const char* value, float* target);
+bool parseInt64Attribute(const char* value, int64_t* target);
+bool parseInt32Attribute(const char* value, int32_t* target);
+bool parseInt16Attribute(const char* value, int16_t* target);
+bool parseInt8Attribute(const char* value, int8_t* target);
+bool parseUInt64Attribute(const char* value, uint64_t* target);
+bool parseUInt32Attribute(const char* value, uint32_t* target);
+bool parseUInt16Attribute(const char* value, uint16_t* target);
+bool parseUInt8Attribute(const char* value, uint8_t* target);
+
+bool parseModelStructureElement(fmi3ModelStructureElement *output, fmiXmlElement *element, fmiArena *arena);
 
 #endif // FMIC_UTILS_H
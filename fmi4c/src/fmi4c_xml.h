@@ -0,0 +1,75 @@
+#ifndef FMIC_XML_H
+#define FMIC_XML_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// XML trees of modelDescription.xml, from ezxml or, when built with FMI4C_USE_PUGIXML, from pugixml's in-situ parser.
+// Elements are NULL when not found, and xmlChild() and xmlAttribute() accept a NULL element.
+typedef struct fmiXmlDocument fmiXmlDocument;
+
+#ifdef FMI4C_WITH_PUGIXML
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fmiXmlNode *fmiXmlElement;
+
+// The document is parsed in place and its strings point into the buffer, which must outlive them
+fmiXmlDocument *parseXmlDocument(char *buffer, size_t size);
+void freeXmlDocument(fmiXmlDocument *document);
+fmiXmlElement xmlDocumentElement(fmiXmlDocument *document);
+
+const char *xmlName(fmiXmlElement element);
+fmiXmlElement xmlChild(fmiXmlElement element, const char *name);
+fmiXmlElement xmlFirstChild(fmiXmlElement element);
+fmiXmlElement xmlNext(fmiXmlElement element);
+fmiXmlElement xmlNextSibling(fmiXmlElement element);
+const char *xmlAttribute(fmiXmlElement element, const char *name);
+bool xmlNextAttribute(fmiXmlElement element, void **cursor, const char **name, const char **value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+
+#include "ezxml/ezxml.h"
+
+typedef ezxml_t fmiXmlElement;
+
+// The tree takes over the buffer, strings must be copied before the document is freed
+static inline fmiXmlDocument *parseXmlDocument(char *buffer, size_t size) { return (fmiXmlDocument*)ezxml_parse_mem(buffer, size); }
+static inline void freeXmlDocument(fmiXmlDocument *document) { ezxml_free((ezxml_t)document); }
+static inline fmiXmlElement xmlDocumentElement(fmiXmlDocument *document) { return (ezxml_t)document; }
+
+// Element name
+static inline const char *xmlName(fmiXmlElement element) { return element->name; }
+// First child element with a name
+static inline fmiXmlElement xmlChild(fmiXmlElement element, const char *name) { return ezxml_child(element, name); }
+// First child element
+static inline fmiXmlElement xmlFirstChild(fmiXmlElement element) { return element->child; }
+// Next sibling element with the same name
+static inline fmiXmlElement xmlNext(fmiXmlElement element) { return element->next; }
+// Next sibling element, in document order
+static inline fmiXmlElement xmlNextSibling(fmiXmlElement element) { return element->ordered; }
+// Attribute value, or NULL if not defined
+static inline const char *xmlAttribute(fmiXmlElement element, const char *name) { return ezxml_attr(element, name); }
+
+// Iterates the attributes of an element, cursor must be NULL for the first attribute
+static inline bool xmlNextAttribute(fmiXmlElement element, void **cursor, const char **name, const char **value)
+{
+    char **attr = (*cursor) ? (char**)(*cursor) : element->attr;
+    if(attr[0] == NULL) {
+        return false;
+    }
+    (*name) = attr[0];
+    (*value) = attr[1];
+    (*cursor) = attr+2;
+    return true;
+}
+
+#endif
+
+#endif // FMIC_XML_H
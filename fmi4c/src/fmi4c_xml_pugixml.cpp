@@ -0,0 +1,110 @@
+#include "fmi4c_xml.h"
+
+#include <cstdio>
+#include <new>
+#include "pugixml.hpp"
+
+// Elements are the node structures of pugixml, which are valid as long as their document
+static inline pugi::xml_node toNode(fmiXmlElement element)
+{
+    return pugi::xml_node(reinterpret_cast<pugi::xml_node_struct*>(element));
+}
+
+static inline fmiXmlElement toElement(pugi::xml_node node)
+{
+    return reinterpret_cast<fmiXmlElement>(node.internal_object());
+}
+
+//! @brief Skips nodes that are not elements, such as comments and processing instructions
+static inline pugi::xml_node skipToElement(pugi::xml_node node)
+{
+    while(node && node.type() != pugi::node_element) {
+        node = node.next_sibling();
+    }
+    return node;
+}
+
+
+//! @brief Parses an XML document in place, with the tree pointing into the buffer instead of copying strings
+//! Entities and character references are decoded in place, since they are never longer than what they encode.
+//! @param buffer Document, must outlive the tree and all strings taken from it
+//! @param size Size of the document
+//! @returns Document, or NULL if it could not be parsed
+fmiXmlDocument *parseXmlDocument(char *buffer, size_t size)
+{
+    pugi::xml_document *document = new(std::nothrow) pugi::xml_document;
+    if(document == nullptr) {
+        return nullptr;
+    }
+    pugi::xml_parse_result result = document->load_buffer_inplace(buffer, size, pugi::parse_default, pugi::encoding_utf8);
+    if(!result) {
+        printf("Failed to parse modelDescription.xml: %s at offset %ld\n", result.description(), (long)result.offset);
+        delete document;
+        return nullptr;
+    }
+    return reinterpret_cast<fmiXmlDocument*>(document);
+}
+
+
+void freeXmlDocument(fmiXmlDocument *document)
+{
+    delete reinterpret_cast<pugi::xml_document*>(document);
+}
+
+
+fmiXmlElement xmlDocumentElement(fmiXmlDocument *document)
+{
+    return toElement(reinterpret_cast<pugi::xml_document*>(document)->document_element());
+}
+
+
+const char *xmlName(fmiXmlElement element)
+{
+    return toNode(element).name();
+}
+
+
+fmiXmlElement xmlChild(fmiXmlElement element, const char *name)
+{
+    return toElement(toNode(element).child(name));
+}
+
+
+fmiXmlElement xmlFirstChild(fmiXmlElement element)
+{
+    return toElement(skipToElement(toNode(element).first_child()));
+}
+
+
+fmiXmlElement xmlNext(fmiXmlElement element)
+{
+    pugi::xml_node node = toNode(element);
+    return toElement(node.next_sibling(node.name()));
+}
+
+
+fmiXmlElement xmlNextSibling(fmiXmlElement element)
+{
+    return toElement(skipToElement(toNode(element).next_sibling()));
+}
+
+
+const char *xmlAttribute(fmiXmlElement element, const char *name)
+{
+    pugi::xml_attribute attribute = toNode(element).attribute(name);
+    return attribute ? attribute.value() : nullptr;
+}
+
+
+bool xmlNextAttribute(fmiXmlElement element, void **cursor, const char **name, const char **value)
+{
+    pugi::xml_attribute attribute = (*cursor) ? pugi::xml_attribute(static_cast<pugi::xml_attribute_struct*>(*cursor)).next_attribute()
+                                              : toNode(element).first_attribute();
+    if(!attribute) {
+        return false;
+    }
+    (*name) = attribute.name();
+    (*value) = attribute.value();
+    (*cursor) = attribute.internal_object();
+    return true;
+}
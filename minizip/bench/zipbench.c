@@ -0,0 +1,703 @@
+/*
+   zipbench.c
+   Throughput benchmark of zlib and minizip on a corpus of FMUs and SSPs.
+
+   usage: zipbench [-r reps] [-t threads] [-w workdir] file-or-dir...
+
+   Every .fmu and .ssp archive given, or found below a given directory, is
+   read into memory. Its entries are then deflated one by one at each level,
+   and at level 1 with the Z_QUICK strategy, the way zip stores them, and
+   inflated again, and crc32 and adler32 run over them. Each archive is also
+   extracted to the work directory and packed back into a new archive with
+   minizip, which includes the file i/o of ioapi.
+
+   All rates are MB/s (10^6 bytes) of uncompressed data, the best of reps
+   runs. The peak resident set size of the process so far is printed after
+   each phase, so the growth over the corpus held in memory is the cost of
+   the phase.
+*/
+
+#if (!defined(_WIN32)) && (!defined(WIN32)) && (!defined(__APPLE__))
+        #ifndef _LARGEFILE64_SOURCE
+                #define _LARGEFILE64_SOURCE
+        #endif
+        #ifndef _POSIX_C_SOURCE
+                #define _POSIX_C_SOURCE 200809L
+        #endif
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef _WIN32
+# include <windows.h>
+# include <psapi.h>
+# include <direct.h>
+#else
+# include <unistd.h>
+# include <dirent.h>
+# include <time.h>
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/resource.h>
+#endif
+
+#include "zlib.h"
+#include "zip.h"
+#include "unzip.h"
+#include "minizip.h"
+#include "miniunz.h"
+
+#define MAXPATH (1024)
+
+typedef struct
+{
+    char* name;                 /* name in the archive */
+    unsigned char* data;        /* uncompressed contents */
+    uLong size;
+} bench_entry;
+
+typedef struct
+{
+    char* path;                 /* the archive */
+    bench_entry* entries;
+    int count;
+    char** dirs;                /* directory entries */
+    int ndirs;
+    ZPOS64_T bytes;             /* total uncompressed size */
+} bench_archive;
+
+typedef struct
+{
+    bench_archive* archives;
+    int count;
+    int size;
+    ZPOS64_T bytes;
+    int entries;
+} bench_corpus;
+
+static double bench_now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* Peak resident set size of the process in MB. */
+static double bench_peak_rss(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.PeakWorkingSetSize / 1e6;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1e6;          /* bytes */
+#else
+    return ru.ru_maxrss * 1024 / 1e6;   /* kilobytes */
+#endif
+#endif
+}
+
+static double bench_rate(ZPOS64_T bytes, double seconds)
+{
+    return seconds > 0 ? bytes / seconds / 1e6 : 0;
+}
+
+static int bench_is_archive(const char* path)
+{
+    size_t len = strlen(path);
+    const char* ext;
+    if (len < 4)
+        return 0;
+    ext = path + len - 4;
+    return ext[0] == '.' &&
+           ((tolower((unsigned char)ext[1]) == 'f' && tolower((unsigned char)ext[2]) == 'm' &&
+             tolower((unsigned char)ext[3]) == 'u') ||
+            (tolower((unsigned char)ext[1]) == 's' && tolower((unsigned char)ext[2]) == 's' &&
+             tolower((unsigned char)ext[3]) == 'p'));
+}
+
+static char* bench_strdup(const char* s)
+{
+    char* copy = (char*)malloc(strlen(s) + 1);
+    if (copy != NULL)
+        strcpy(copy, s);
+    return copy;
+}
+
+/* Read all of the file entries of the archive at path into a new archive of
+   the corpus. Returns 0 on success. */
+static int bench_load(bench_corpus* corpus, const char* path)
+{
+    bench_archive* archive;
+    unzFile uf;
+    int err;
+
+    if (corpus->count == corpus->size)
+    {
+        int size = corpus->size ? 2 * corpus->size : 16;
+        bench_archive* archives = (bench_archive*)realloc(corpus->archives, size * sizeof(bench_archive));
+        if (archives == NULL)
+            return -1;
+        corpus->archives = archives;
+        corpus->size = size;
+    }
+
+    uf = unzOpen64(path);
+    if (uf == NULL)
+    {
+        fprintf(stderr, "zipbench: cannot open %s\n", path);
+        return -1;
+    }
+
+    archive = &corpus->archives[corpus->count];
+    memset(archive, 0, sizeof(bench_archive));
+    archive->path = bench_strdup(path);
+
+    for (err = unzGoToFirstFile(uf); err == UNZ_OK; err = unzGoToNextFile(uf))
+    {
+        char name[MAXPATH];
+        unz_file_info64 info;
+        bench_entry* entry;
+        bench_entry* entries;
+
+        err = unzGetCurrentFileInfo64(uf, &info, name, sizeof(name), NULL, 0, NULL, 0);
+        if (err != UNZ_OK)
+            break;
+        if (name[0] == 0)
+            continue;
+        if (name[strlen(name) - 1] == '/')
+        {
+            char** dirs = (char**)realloc(archive->dirs, (archive->ndirs + 1) * sizeof(char*));
+            if (dirs == NULL || (dirs[archive->ndirs] = bench_strdup(name)) == NULL)
+            {
+                if (dirs != NULL)
+                    archive->dirs = dirs;
+                err = UNZ_INTERNALERROR;
+                break;
+            }
+            archive->dirs = dirs;
+            archive->ndirs++;
+            continue;
+        }
+        if (info.uncompressed_size > 0x7fffffff)
+        {
+            fprintf(stderr, "zipbench: skipping large %s in %s\n", name, path);
+            continue;
+        }
+
+        entries = (bench_entry*)realloc(archive->entries, (archive->count + 1) * sizeof(bench_entry));
+        if (entries == NULL)
+        {
+            err = UNZ_INTERNALERROR;
+            break;
+        }
+        archive->entries = entries;
+        entry = &entries[archive->count];
+        entry->name = bench_strdup(name);
+        entry->size = (uLong)info.uncompressed_size;
+        entry->data = (unsigned char*)malloc(entry->size ? entry->size : 1);
+        if (entry->name == NULL || entry->data == NULL)
+        {
+            free(entry->name);
+            free(entry->data);
+            err = UNZ_INTERNALERROR;
+            break;
+        }
+        archive->count++;
+
+        err = unzOpenCurrentFile(uf);
+        if (err == UNZ_OK)
+        {
+            int got = unzReadCurrentFile(uf, entry->data, (unsigned)entry->size);
+            err = unzCloseCurrentFile(uf);
+            if (got != (int)entry->size && err == UNZ_OK)
+                err = UNZ_ERRNO;
+        }
+        if (err != UNZ_OK)
+        {
+            fprintf(stderr, "zipbench: cannot read %s in %s\n", name, path);
+            break;
+        }
+        archive->bytes += entry->size;
+    }
+    unzClose(uf);
+
+    corpus->count++;
+    corpus->bytes += archive->bytes;
+    corpus->entries += archive->count;
+    return err == UNZ_END_OF_LIST_OF_FILE ? 0 : -1;
+}
+
+/* Load path if it is an archive, or the archives below it if it is a
+   directory. */
+static int bench_scan(bench_corpus* corpus, const char* path)
+{
+#ifdef _WIN32
+    char pattern[MAXPATH];
+    WIN32_FIND_DATAA found;
+    HANDLE find;
+    DWORD attributes = GetFileAttributesA(path);
+    int ret = 0;
+
+    if (attributes == INVALID_FILE_ATTRIBUTES)
+    {
+        fprintf(stderr, "zipbench: cannot find %s\n", path);
+        return -1;
+    }
+    if (!(attributes & FILE_ATTRIBUTE_DIRECTORY))
+        return bench_load(corpus, path);
+
+    snprintf(pattern, sizeof(pattern), "%s\\*", path);
+    find = FindFirstFileA(pattern, &found);
+    if (find == INVALID_HANDLE_VALUE)
+        return 0;
+    do
+    {
+        char sub[MAXPATH];
+        if (strcmp(found.cFileName, ".") == 0 || strcmp(found.cFileName, "..") == 0)
+            continue;
+        snprintf(sub, sizeof(sub), "%s\\%s", path, found.cFileName);
+        if ((found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || bench_is_archive(sub))
+            if (bench_scan(corpus, sub) != 0)
+                ret = -1;
+    } while (FindNextFileA(find, &found));
+    FindClose(find);
+    return ret;
+#else
+    struct stat st;
+    DIR* dir;
+    struct dirent* ent;
+    int ret = 0;
+
+    if (stat(path, &st) != 0)
+    {
+        fprintf(stderr, "zipbench: cannot find %s\n", path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode))
+        return bench_load(corpus, path);
+
+    dir = opendir(path);
+    if (dir == NULL)
+        return 0;
+    while ((ent = readdir(dir)) != NULL)
+    {
+        char sub[MAXPATH];
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+        snprintf(sub, sizeof(sub), "%s/%s", path, ent->d_name);
+        if (stat(sub, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode) || bench_is_archive(sub))
+            if (bench_scan(corpus, sub) != 0)
+                ret = -1;
+    }
+    closedir(dir);
+    return ret;
+#endif
+}
+
+static void bench_free(bench_corpus* corpus)
+{
+    int i, j;
+    for (i = 0; i < corpus->count; i++)
+    {
+        for (j = 0; j < corpus->archives[i].count; j++)
+        {
+            free(corpus->archives[i].entries[j].name);
+            free(corpus->archives[i].entries[j].data);
+        }
+        for (j = 0; j < corpus->archives[i].ndirs; j++)
+            free(corpus->archives[i].dirs[j]);
+        free(corpus->archives[i].dirs);
+        free(corpus->archives[i].entries);
+        free(corpus->archives[i].path);
+    }
+    free(corpus->archives);
+}
+
+static void bench_rmdir(const char* path)
+{
+#ifdef _WIN32
+    _rmdir(path);
+#else
+    rmdir(path);
+#endif
+}
+
+static void bench_mkdir(const char* path)
+{
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0775);
+#endif
+}
+
+/* Remove the directories of name below dir, the deepest first. Directories
+   that are not empty yet stay. */
+static void bench_remove_dirs(const char* dir, const char* name)
+{
+    char path[MAXPATH];
+    char* slash;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    while ((slash = strrchr(path, '/')) != NULL && slash > path + strlen(dir))
+    {
+        *slash = 0;
+        bench_rmdir(path);
+    }
+}
+
+/* Remove the files of archive extracted below dir, then the directories. */
+static void bench_remove(const bench_archive* archive, const char* dir)
+{
+    char path[MAXPATH];
+    int i;
+
+    for (i = 0; i < archive->count; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", dir, archive->entries[i].name);
+        remove(path);
+    }
+    /* the deepest directories of an archive are usually listed last */
+    for (i = archive->ndirs - 1; i >= 0; i--)
+        bench_remove_dirs(dir, archive->dirs[i]);
+    for (i = 0; i < archive->count; i++)
+        bench_remove_dirs(dir, archive->entries[i].name);
+    bench_rmdir(dir);
+}
+
+/* Deflate every entry of the corpus as a raw stream at level with strategy
+   into out, which has room for the largest entry. Sets the compressed size
+   and returns the time taken, or -1 on error. */
+static double bench_deflate(const bench_corpus* corpus, int level, int strategy,
+                            unsigned char** out, uLong* outsize, ZPOS64_T* compressed)
+{
+    double start = bench_now();
+    int i, j, k = 0;
+
+    *compressed = 0;
+    for (i = 0; i < corpus->count; i++)
+        for (j = 0; j < corpus->archives[i].count; j++, k++)
+        {
+            const bench_entry* entry = &corpus->archives[i].entries[j];
+            z_stream strm;
+            int ret;
+
+            memset(&strm, 0, sizeof(strm));
+            if (deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8, strategy) != Z_OK)
+                return -1;
+            strm.next_in = entry->data;
+            strm.avail_in = (uInt)entry->size;
+            strm.next_out = out[k];
+            strm.avail_out = (uInt)deflateBound(&strm, entry->size);
+            ret = deflate(&strm, Z_FINISH);
+            outsize[k] = strm.total_out;
+            deflateRelease(&strm);
+            if (ret != Z_STREAM_END)
+                return -1;
+            *compressed += outsize[k];
+        }
+    return bench_now() - start;
+}
+
+/* Inflate what bench_deflate() produced into buf and check the size. */
+static double bench_inflate(const bench_corpus* corpus, unsigned char** in, const uLong* insize,
+                            unsigned char* buf)
+{
+    double start = bench_now();
+    int i, j, k = 0;
+
+    for (i = 0; i < corpus->count; i++)
+        for (j = 0; j < corpus->archives[i].count; j++, k++)
+        {
+            const bench_entry* entry = &corpus->archives[i].entries[j];
+            z_stream strm;
+            int ret;
+
+            memset(&strm, 0, sizeof(strm));
+            if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+                return -1;
+            strm.next_in = in[k];
+            strm.avail_in = (uInt)insize[k];
+            strm.next_out = buf;
+            strm.avail_out = (uInt)entry->size + 1;
+            ret = inflate(&strm, Z_FINISH);
+            inflateRelease(&strm);
+            if (ret != Z_STREAM_END || strm.total_out != entry->size)
+                return -1;
+        }
+    return bench_now() - start;
+}
+
+static volatile uLong bench_sink;   /* keeps the checks from being dropped */
+
+static double bench_check(const bench_corpus* corpus, int adler)
+{
+    double start = bench_now();
+    uLong check = 0;
+    int i, j;
+
+    for (i = 0; i < corpus->count; i++)
+        for (j = 0; j < corpus->archives[i].count; j++)
+        {
+            const bench_entry* entry = &corpus->archives[i].entries[j];
+            if (adler)
+                check ^= adler32(adler32(0L, Z_NULL, 0), entry->data, (uInt)entry->size);
+            else
+                check ^= crc32(crc32(0L, Z_NULL, 0), entry->data, (uInt)entry->size);
+        }
+    bench_sink = check;
+    return bench_now() - start;
+}
+
+/* Extract archive number n below workdir, then pack the extracted files into
+   a new archive. Returns 0 on success, setting the times taken. */
+static int bench_zip(const bench_corpus* corpus, int n, const char* workdir, int threads,
+                     double* extract, double* pack)
+{
+    const bench_archive* archive = &corpus->archives[n];
+    char dir[MAXPATH], zipname[MAXPATH];
+    char** paths;
+    const char** names;
+    double start;
+    zipFile zf;
+    int i, err;
+
+    snprintf(dir, sizeof(dir), "%s/x%d", workdir, n);
+    snprintf(zipname, sizeof(zipname), "%s/p%d.zip", workdir, n);
+
+    start = bench_now();
+    err = miniunz_extract_parallel(archive->path, dir, threads, NULL);
+    *extract = bench_now() - start;
+    if (err != UNZ_OK)
+    {
+        fprintf(stderr, "zipbench: cannot extract %s (%d)\n", archive->path, err);
+        bench_remove(archive, dir);
+        return -1;
+    }
+
+    paths = (char**)calloc(archive->count + 1, sizeof(char*));
+    names = (const char**)calloc(archive->count + 1, sizeof(char*));
+    for (i = 0; paths != NULL && names != NULL && i < archive->count; i++)
+    {
+        paths[i] = (char*)malloc(MAXPATH);
+        if (paths[i] == NULL)
+            break;
+        snprintf(paths[i], MAXPATH, "%s/%s", dir, archive->entries[i].name);
+        names[i] = archive->entries[i].name;
+    }
+
+    err = ZIP_INTERNALERROR;
+    if (paths != NULL && names != NULL && i == archive->count)
+    {
+        start = bench_now();
+        zf = zipOpen64(zipname, APPEND_STATUS_CREATE);
+        if (zf != NULL)
+        {
+            err = minizip_add_files_parallel(zf, archive->count, (const char* const*)paths, names,
+                                             Z_DEFAULT_COMPRESSION, threads);
+            if (zipClose(zf, NULL) != ZIP_OK && err == ZIP_OK)
+                err = ZIP_ERRNO;
+        }
+        *pack = bench_now() - start;
+    }
+    if (err != ZIP_OK)
+        fprintf(stderr, "zipbench: cannot pack %s (%d)\n", zipname, err);
+
+    for (i = 0; paths != NULL && i < archive->count; i++)
+        free(paths[i]);
+    free(paths);
+    free((void*)names);
+    remove(zipname);
+    bench_remove(archive, dir);
+    return err == ZIP_OK ? 0 : -1;
+}
+
+static void bench_usage(void)
+{
+    fprintf(stderr,
+            "usage: zipbench [-r reps] [-t threads] [-w workdir] file-or-dir...\n"
+            "  -r reps     runs of each measurement, the best is kept (default 3)\n"
+            "  -t threads  workers for extract and pack, 0 for one per processor (default 1)\n"
+            "  -w workdir  directory for the extracted and packed files (default zipbench.tmp)\n");
+}
+
+int main(int argc, char* argv[])
+{
+    bench_corpus corpus;
+    const char* workdir = "zipbench.tmp";
+    int reps = 3, threads = 1;
+    unsigned char** out = NULL;
+    uLong* outsize = NULL;
+    unsigned char* buf = NULL;
+    uLong largest = 0;
+    double best, t;
+    int i, j, k, r, level, ret = 0;
+
+    memset(&corpus, 0, sizeof(corpus));
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            workdir = argv[++i];
+        else if (argv[i][0] == '-')
+        {
+            bench_usage();
+            return 2;
+        }
+        else if (bench_scan(&corpus, argv[i]) != 0)
+            ret = 1;
+    }
+    if (reps < 1)
+        reps = 1;
+    if (corpus.entries == 0)
+    {
+        if (corpus.count == 0)
+            bench_usage();
+        fprintf(stderr, "zipbench: no entries to measure\n");
+        bench_free(&corpus);
+        return 2;
+    }
+
+    printf("zlib %s, %d archives, %d entries, %.2f MB, best of %d\n", zlibVersion(),
+           corpus.count, corpus.entries, corpus.bytes / 1e6, reps);
+    printf("peak RSS after loading: %.1f MB\n\n", bench_peak_rss());
+
+    /* one output buffer per entry, so that inflate reads what deflate wrote */
+    out = (unsigned char**)calloc(corpus.entries, sizeof(unsigned char*));
+    outsize = (uLong*)calloc(corpus.entries, sizeof(uLong));
+    for (i = 0, k = 0; out != NULL && outsize != NULL && i < corpus.count; i++)
+        for (j = 0; j < corpus.archives[i].count; j++, k++)
+        {
+            uLong size = corpus.archives[i].entries[j].size;
+            out[k] = (unsigned char*)malloc(compressBound(size) + 64);
+            if (out[k] == NULL)
+                break;
+            if (size > largest)
+                largest = size;
+        }
+    if (out != NULL && outsize != NULL && k == corpus.entries)
+        buf = (unsigned char*)malloc(largest + 1);
+    if (buf == NULL)
+    {
+        fprintf(stderr, "zipbench: out of memory\n");
+        ret = 1;
+        goto done;
+    }
+
+    printf("level   ratio  deflate MB/s  inflate MB/s  peak RSS MB\n");
+    for (level = 0; level <= 10; level++)
+    {
+        /* the last row is level 1 with the quick strategy */
+        int quick = level == 10;
+        ZPOS64_T compressed = 0;
+        double inf = 0;
+        best = 0;
+        for (r = 0; r < reps; r++)
+        {
+            t = bench_deflate(&corpus, quick ? 1 : level, quick ? Z_QUICK : Z_DEFAULT_STRATEGY,
+                              out, outsize, &compressed);
+            if (t < 0)
+                break;
+            if (r == 0 || t < best)
+                best = t;
+        }
+        for (r = 0; t >= 0 && r < reps; r++)
+        {
+            double u = bench_inflate(&corpus, out, outsize, buf);
+            if (u < 0)
+            {
+                t = u;
+                break;
+            }
+            if (r == 0 || u < inf)
+                inf = u;
+        }
+        if (t < 0)
+        {
+            if (quick)
+                fprintf(stderr, "zipbench: quick failed\n");
+            else
+                fprintf(stderr, "zipbench: level %d failed\n", level);
+            ret = 1;
+            continue;
+        }
+        if (quick)
+            printf("quick");
+        else
+            printf("%5d", level);
+        printf("  %6.3f  %12.1f  %12.1f  %11.1f\n",
+               corpus.bytes ? (double)compressed / corpus.bytes : 0.0,
+               bench_rate(corpus.bytes, best), bench_rate(corpus.bytes, inf), bench_peak_rss());
+    }
+
+    for (k = 0; k < 2; k++)
+    {
+        for (r = 0; r < reps; r++)
+        {
+            t = bench_check(&corpus, k);
+            if (r == 0 || t < best)
+                best = t;
+        }
+        printf("%-7s MB/s %12.1f\n", k ? "adler32" : "crc32", bench_rate(corpus.bytes, best));
+    }
+
+    /* minizip end to end, through ioapi and the file system */
+    bench_mkdir(workdir);
+    {
+        double extract = 0, pack = 0;
+        for (i = 0; i < corpus.count; i++)
+        {
+            double ebest = 0, pbest = 0, e, p;
+            for (r = 0; r < reps; r++)
+            {
+                if (bench_zip(&corpus, i, workdir, threads, &e, &p) != 0)
+                {
+                    ret = 1;
+                    break;
+                }
+                if (r == 0 || e < ebest)
+                    ebest = e;
+                if (r == 0 || p < pbest)
+                    pbest = p;
+            }
+            extract += ebest;
+            pack += pbest;
+        }
+        printf("\nminizip with %d thread%s\n", threads, threads == 1 ? "" : "s");
+        printf("extract MB/s %12.1f\n", bench_rate(corpus.bytes, extract));
+        printf("pack    MB/s %12.1f\n", bench_rate(corpus.bytes, pack));
+        printf("peak RSS MB  %12.1f\n", bench_peak_rss());
+    }
+    bench_rmdir(workdir);
+
+done:
+    for (k = 0; out != NULL && k < corpus.entries; k++)
+        free(out[k]);
+    free(out);
+    free(outsize);
+    free(buf);
+    bench_free(&corpus);
+    zlibPoolFree();
+    return ret;
+}
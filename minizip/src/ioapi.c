@@ -28,6 +28,18 @@
 
 #include "ioapi.h"
 
+#include <string.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# include <pthread.h>
+#endif
+
 voidpf call_zopen64 (const zlib_filefunc64_32_def* pfilefunc,const void*filename,int mode)
 {
     if (pfilefunc->zfile_func64.zopen64_file != NULL)
@@ -255,3 +267,738 @@ void fill_fopen64_filefunc (zlib_filefunc64_def*  pzlib_filefunc_def)
     pzlib_filefunc_def->zerror_file = ferror_file_func;
     pzlib_filefunc_def->opaque = NULL;
 }
+
+
+/* the whole file is mapped read only, reads are copies from the mapping */
+typedef struct
+{
+    const unsigned char* base;
+    ZPOS64_T size;
+    ZPOS64_T pos;
+    int error;
+#ifdef _WIN32
+    HANDLE hFile;
+    HANDLE hMap;
+#endif
+} mmap_stream;
+
+static voidpf  ZCALLBACK mmap_open64_file_func OF((voidpf opaque, const void* filename, int mode));
+static uLong   ZCALLBACK mmap_read_file_func OF((voidpf opaque, voidpf stream, void* buf, uLong size));
+static uLong   ZCALLBACK mmap_write_file_func OF((voidpf opaque, voidpf stream, const void* buf,uLong size));
+static ZPOS64_T ZCALLBACK mmap_tell64_file_func OF((voidpf opaque, voidpf stream));
+static long    ZCALLBACK mmap_seek64_file_func OF((voidpf opaque, voidpf stream, ZPOS64_T offset, int origin));
+static int     ZCALLBACK mmap_close_file_func OF((voidpf opaque, voidpf stream));
+static int     ZCALLBACK mmap_error_file_func OF((voidpf opaque, voidpf stream));
+
+static voidpf ZCALLBACK mmap_open64_file_func (voidpf opaque, const void* filename, int mode)
+{
+    mmap_stream* mm;
+    (void)opaque;
+    if ((filename==NULL) || ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER)!=ZLIB_FILEFUNC_MODE_READ))
+        return NULL;
+
+    mm = (mmap_stream*)malloc(sizeof(mmap_stream));
+    if (mm==NULL)
+        return NULL;
+    memset(mm, 0, sizeof(mmap_stream));
+
+#ifdef _WIN32
+    {
+        LARGE_INTEGER size;
+        mm->hFile = CreateFileA((const char*)filename, GENERIC_READ, FILE_SHARE_READ,
+                                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if ((mm->hFile==INVALID_HANDLE_VALUE) || (!GetFileSizeEx(mm->hFile, &size)))
+        {
+            if (mm->hFile!=INVALID_HANDLE_VALUE)
+                CloseHandle(mm->hFile);
+            free(mm);
+            return NULL;
+        }
+        mm->size = (ZPOS64_T)size.QuadPart;
+        if (mm->size > 0)
+        {
+            mm->hMap = CreateFileMappingA(mm->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mm->hMap!=NULL)
+                mm->base = (const unsigned char*)MapViewOfFile(mm->hMap, FILE_MAP_READ, 0, 0, 0);
+            if (mm->base==NULL)
+            {
+                if (mm->hMap!=NULL)
+                    CloseHandle(mm->hMap);
+                CloseHandle(mm->hFile);
+                free(mm);
+                return NULL;
+            }
+        }
+    }
+#else
+    {
+        struct stat st;
+        int fd = open((const char*)filename, O_RDONLY);
+        if ((fd==-1) || (fstat(fd, &st)!=0))
+        {
+            if (fd!=-1)
+                close(fd);
+            free(mm);
+            return NULL;
+        }
+        mm->size = (ZPOS64_T)st.st_size;
+        if (mm->size > 0)
+        {
+            void* base = mmap(NULL, (size_t)mm->size, PROT_READ, MAP_SHARED, fd, 0);
+            if (base==MAP_FAILED)
+            {
+                close(fd);
+                free(mm);
+                return NULL;
+            }
+            mm->base = (const unsigned char*)base;
+        }
+        /* the mapping stays valid without the descriptor */
+        close(fd);
+    }
+#endif
+    return mm;
+}
+
+static uLong ZCALLBACK mmap_read_file_func (voidpf opaque, voidpf stream, void* buf, uLong size)
+{
+    mmap_stream* mm = (mmap_stream*)stream;
+    (void)opaque;
+    if (mm->pos >= mm->size)
+        return 0;
+    if (size > mm->size - mm->pos)
+        size = (uLong)(mm->size - mm->pos);
+    memcpy(buf, mm->base + mm->pos, (size_t)size);
+    mm->pos += size;
+    return size;
+}
+
+static uLong ZCALLBACK mmap_write_file_func (voidpf opaque, voidpf stream, const void* buf, uLong size)
+{
+    mmap_stream* mm = (mmap_stream*)stream;
+    (void)opaque;
+    (void)buf;
+    (void)size;
+    mm->error = 1;
+    return 0;
+}
+
+static ZPOS64_T ZCALLBACK mmap_tell64_file_func (voidpf opaque, voidpf stream)
+{
+    (void)opaque;
+    return ((mmap_stream*)stream)->pos;
+}
+
+static long ZCALLBACK mmap_seek64_file_func (voidpf opaque, voidpf stream, ZPOS64_T offset, int origin)
+{
+    mmap_stream* mm = (mmap_stream*)stream;
+    ZPOS64_T new_pos;
+    (void)opaque;
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_CUR :
+        new_pos = mm->pos + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END :
+        new_pos = mm->size + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_SET :
+        new_pos = offset;
+        break;
+    default: return -1;
+    }
+    if (new_pos > mm->size)
+        return -1;
+    mm->pos = new_pos;
+    return 0;
+}
+
+static int ZCALLBACK mmap_close_file_func (voidpf opaque, voidpf stream)
+{
+    mmap_stream* mm = (mmap_stream*)stream;
+    (void)opaque;
+#ifdef _WIN32
+    if (mm->base!=NULL)
+    {
+        UnmapViewOfFile(mm->base);
+        CloseHandle(mm->hMap);
+    }
+    CloseHandle(mm->hFile);
+#else
+    if (mm->base!=NULL)
+        munmap((void*)mm->base, (size_t)mm->size);
+#endif
+    free(mm);
+    return 0;
+}
+
+static int ZCALLBACK mmap_error_file_func (voidpf opaque, voidpf stream)
+{
+    (void)opaque;
+    return ((mmap_stream*)stream)->error;
+}
+
+void fill_mmap_filefunc64 (zlib_filefunc64_def*  pzlib_filefunc_def)
+{
+    pzlib_filefunc_def->zopen64_file = mmap_open64_file_func;
+    pzlib_filefunc_def->zread_file = mmap_read_file_func;
+    pzlib_filefunc_def->zwrite_file = mmap_write_file_func;
+    pzlib_filefunc_def->ztell64_file = mmap_tell64_file_func;
+    pzlib_filefunc_def->zseek64_file = mmap_seek64_file_func;
+    pzlib_filefunc_def->zclose_file = mmap_close_file_func;
+    pzlib_filefunc_def->zerror_file = mmap_error_file_func;
+    pzlib_filefunc_def->opaque = NULL;
+}
+
+int call_zmapping64 (const zlib_filefunc64_32_def* pfilefunc,voidpf filestream, const void** base, ZPOS64_T* size)
+{
+    const mmap_stream* mm = (const mmap_stream*)filestream;
+    if (pfilefunc->zfile_func64.zopen64_file != mmap_open64_file_func)
+        return -1;
+    *base = mm->base;
+    *size = mm->size;
+    return 0;
+}
+
+
+/* the archive is in a zlib_mem_buffer, given instead of the file name */
+typedef struct
+{
+    zlib_mem_buffer* buffer;
+    zlib_mem_buffer read_only; /* copy of the caller buffer, for reading */
+    ZPOS64_T pos;
+    int writable;
+    int error;
+} mem_stream;
+
+static voidpf  ZCALLBACK mem_open64_file_func OF((voidpf opaque, const void* filename, int mode));
+static uLong   ZCALLBACK mem_read_file_func OF((voidpf opaque, voidpf stream, void* buf, uLong size));
+static uLong   ZCALLBACK mem_write_file_func OF((voidpf opaque, voidpf stream, const void* buf,uLong size));
+static ZPOS64_T ZCALLBACK mem_tell64_file_func OF((voidpf opaque, voidpf stream));
+static long    ZCALLBACK mem_seek64_file_func OF((voidpf opaque, voidpf stream, ZPOS64_T offset, int origin));
+static int     ZCALLBACK mem_close_file_func OF((voidpf opaque, voidpf stream));
+static int     ZCALLBACK mem_error_file_func OF((voidpf opaque, voidpf stream));
+
+static voidpf ZCALLBACK mem_open64_file_func (voidpf opaque, const void* filename, int mode)
+{
+    mem_stream* mem;
+    (void)opaque;
+    if (filename==NULL)
+        return NULL;
+
+    mem = (mem_stream*)malloc(sizeof(mem_stream));
+    if (mem==NULL)
+        return NULL;
+    memset(mem, 0, sizeof(mem_stream));
+
+    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER)==ZLIB_FILEFUNC_MODE_READ)
+    {
+        mem->read_only = *(const zlib_mem_buffer*)filename;
+        mem->buffer = &mem->read_only;
+    }
+    else
+    {
+        mem->buffer = (zlib_mem_buffer*)filename;
+        mem->writable = 1;
+        if (mode & ZLIB_FILEFUNC_MODE_CREATE)
+            mem->buffer->size = 0;
+    }
+    return mem;
+}
+
+static uLong ZCALLBACK mem_read_file_func (voidpf opaque, voidpf stream, void* buf, uLong size)
+{
+    mem_stream* mem = (mem_stream*)stream;
+    (void)opaque;
+    if (mem->pos >= mem->buffer->size)
+        return 0;
+    if (size > mem->buffer->size - mem->pos)
+        size = (uLong)(mem->buffer->size - mem->pos);
+    memcpy(buf, mem->buffer->base + mem->pos, (size_t)size);
+    mem->pos += size;
+    return size;
+}
+
+static uLong ZCALLBACK mem_write_file_func (voidpf opaque, voidpf stream, const void* buf, uLong size)
+{
+    mem_stream* mem = (mem_stream*)stream;
+    zlib_mem_buffer* buffer = mem->buffer;
+    (void)opaque;
+    if (!mem->writable)
+    {
+        mem->error = 1;
+        return 0;
+    }
+
+    if (mem->pos + size > buffer->capacity)
+    {
+        ZPOS64_T capacity = (buffer->capacity < 0x10000) ? 0x10000 : buffer->capacity * 2;
+        char* base;
+        if (capacity < mem->pos + size)
+            capacity = mem->pos + size;
+        base = (char*)realloc(buffer->base, (size_t)capacity);
+        if ((base==NULL) || (capacity!=(ZPOS64_T)(size_t)capacity))
+        {
+            mem->error = 1;
+            return 0;
+        }
+        buffer->base = base;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->base + mem->pos, buf, (size_t)size);
+    mem->pos += size;
+    if (mem->pos > buffer->size)
+        buffer->size = mem->pos;
+    return size;
+}
+
+static ZPOS64_T ZCALLBACK mem_tell64_file_func (voidpf opaque, voidpf stream)
+{
+    (void)opaque;
+    return ((mem_stream*)stream)->pos;
+}
+
+static long ZCALLBACK mem_seek64_file_func (voidpf opaque, voidpf stream, ZPOS64_T offset, int origin)
+{
+    mem_stream* mem = (mem_stream*)stream;
+    ZPOS64_T new_pos;
+    (void)opaque;
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_CUR :
+        new_pos = mem->pos + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END :
+        new_pos = mem->buffer->size + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_SET :
+        new_pos = offset;
+        break;
+    default: return -1;
+    }
+    if (new_pos > mem->buffer->size)
+        return -1;
+    mem->pos = new_pos;
+    return 0;
+}
+
+static int ZCALLBACK mem_close_file_func (voidpf opaque, voidpf stream)
+{
+    (void)opaque;
+    free(stream);
+    return 0;
+}
+
+static int ZCALLBACK mem_error_file_func (voidpf opaque, voidpf stream)
+{
+    (void)opaque;
+    return ((mem_stream*)stream)->error;
+}
+
+void fill_memory_filefunc64 (zlib_filefunc64_def*  pzlib_filefunc_def)
+{
+    pzlib_filefunc_def->zopen64_file = mem_open64_file_func;
+    pzlib_filefunc_def->zread_file = mem_read_file_func;
+    pzlib_filefunc_def->zwrite_file = mem_write_file_func;
+    pzlib_filefunc_def->ztell64_file = mem_tell64_file_func;
+    pzlib_filefunc_def->zseek64_file = mem_seek64_file_func;
+    pzlib_filefunc_def->zclose_file = mem_close_file_func;
+    pzlib_filefunc_def->zerror_file = mem_error_file_func;
+    pzlib_filefunc_def->opaque = NULL;
+}
+
+
+/* the file is read in aligned blocks of the base backend kept in a small
+   cache. Reads of the caller copy from the cache, a missing block is read at
+   once, and a thread reads the blocks that follow a sequential read ahead.
+   The base stream is used by one of them at a time, under io_lock */
+#define PREFETCH_EMPTY   (0)
+#define PREFETCH_LOADING (1)
+#define PREFETCH_READY   (2)
+
+typedef struct
+{
+    ZPOS64_T index;        /* block number in the file */
+    unsigned char* data;   /* allocated on first use */
+    uLong len;             /* bytes read, less than the block size at the end */
+    unsigned long used;    /* access time, the least recently used is reused */
+    int state;
+} prefetch_block;
+
+typedef struct
+{
+    const zlib_filefunc64_def* base;
+    voidpf base_stream;
+    uLong block_size;
+    int nblocks;
+    int ahead;             /* blocks read ahead of a sequential read */
+    prefetch_block* blocks;
+    ZPOS64_T size;
+    ZPOS64_T pos;
+    ZPOS64_T last;         /* block of the previous read */
+    ZPOS64_T want;         /* next block for the thread to read */
+    int want_count;        /* number of blocks from want to read */
+    unsigned long clock;
+    int stop;
+    int error;
+    int has_thread;
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+    CRITICAL_SECTION io_lock;
+    CONDITION_VARIABLE ready;   /* a block was read */
+    CONDITION_VARIABLE work;    /* blocks are wanted, or stop */
+    HANDLE thread;
+#else
+    pthread_mutex_t lock;
+    pthread_mutex_t io_lock;
+    pthread_cond_t ready;
+    pthread_cond_t work;
+    pthread_t thread;
+#endif
+} prefetch_stream;
+
+#ifdef _WIN32
+#define PREFETCH_LOCK(m)        EnterCriticalSection(&(m))
+#define PREFETCH_UNLOCK(m)      LeaveCriticalSection(&(m))
+#define PREFETCH_WAIT(c,m)      SleepConditionVariableCS(&(c), &(m), INFINITE)
+#define PREFETCH_BROADCAST(c)   WakeAllConditionVariable(&(c))
+#else
+#define PREFETCH_LOCK(m)        pthread_mutex_lock(&(m))
+#define PREFETCH_UNLOCK(m)      pthread_mutex_unlock(&(m))
+#define PREFETCH_WAIT(c,m)      pthread_cond_wait(&(c), &(m))
+#define PREFETCH_BROADCAST(c)   pthread_cond_broadcast(&(c))
+#endif
+
+/* the slot holding or reading block index, or -1 */
+static int prefetch_find (const prefetch_stream* ps, ZPOS64_T index)
+{
+    int i;
+    for (i = 0; i < ps->nblocks; i++)
+        if ((ps->blocks[i].state!=PREFETCH_EMPTY) && (ps->blocks[i].index==index))
+            return i;
+    return -1;
+}
+
+/* an empty slot, else the least recently used ready one, else -1 */
+static int prefetch_slot (const prefetch_stream* ps)
+{
+    int i, slot = -1;
+    for (i = 0; i < ps->nblocks; i++)
+    {
+        const prefetch_block* block = &ps->blocks[i];
+        if (block->state==PREFETCH_EMPTY)
+            return i;
+        if ((block->state==PREFETCH_READY) &&
+            ((slot==-1) || (block->used < ps->blocks[slot].used)))
+            slot = i;
+    }
+    return slot;
+}
+
+/* read block index into slot, called and returning with lock held. Returns 0
+   on success, else the slot is left empty */
+static int prefetch_load (prefetch_stream* ps, int slot, ZPOS64_T index)
+{
+    prefetch_block* block = &ps->blocks[slot];
+    ZPOS64_T offset = index * ps->block_size;
+    uLong want = (ps->size - offset < ps->block_size) ? (uLong)(ps->size - offset) : ps->block_size;
+    uLong got = 0;
+    int err = 0;
+
+    block->index = index;
+    block->state = PREFETCH_LOADING;
+    PREFETCH_UNLOCK(ps->lock);
+
+    if (block->data==NULL)
+        block->data = (unsigned char*)malloc(ps->block_size);
+    if (block->data==NULL)
+        err = -1;
+    else
+    {
+        PREFETCH_LOCK(ps->io_lock);
+        if (ps->base->zseek64_file(ps->base->opaque, ps->base_stream, offset, ZLIB_FILEFUNC_SEEK_SET)!=0)
+            err = -1;
+        while ((err==0) && (got < want))
+        {
+            uLong n = ps->base->zread_file(ps->base->opaque, ps->base_stream, block->data + got, want - got);
+            if (n==0)
+                err = -1;
+            got += n;
+        }
+        PREFETCH_UNLOCK(ps->io_lock);
+    }
+
+    PREFETCH_LOCK(ps->lock);
+    block->len = got;
+    block->used = ++ps->clock;
+    block->state = (err==0) ? PREFETCH_READY : PREFETCH_EMPTY;
+    PREFETCH_BROADCAST(ps->ready);
+    return err;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI prefetch_thread (LPVOID arg)
+#else
+static void* prefetch_thread (void* arg)
+#endif
+{
+    prefetch_stream* ps = (prefetch_stream*)arg;
+
+    PREFETCH_LOCK(ps->lock);
+    while (!ps->stop)
+    {
+        ZPOS64_T index;
+        int slot;
+
+        if (ps->want_count==0)
+        {
+            PREFETCH_WAIT(ps->work, ps->lock);
+            continue;
+        }
+        index = ps->want++;
+        ps->want_count--;
+        if (index * ps->block_size >= ps->size)
+        {
+            ps->want_count = 0;
+            continue;
+        }
+        if (prefetch_find(ps, index)!=-1)
+            continue;
+        slot = prefetch_slot(ps);
+        if (slot==-1)
+            ps->want_count = 0;
+        else
+            prefetch_load(ps, slot, index);
+    }
+    PREFETCH_UNLOCK(ps->lock);
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static voidpf  ZCALLBACK prefetch_open64_file_func OF((voidpf opaque, const void* filename, int mode));
+static uLong   ZCALLBACK prefetch_read_file_func OF((voidpf opaque, voidpf stream, void* buf, uLong size));
+static uLong   ZCALLBACK prefetch_write_file_func OF((voidpf opaque, voidpf stream, const void* buf,uLong size));
+static ZPOS64_T ZCALLBACK prefetch_tell64_file_func OF((voidpf opaque, voidpf stream));
+static long    ZCALLBACK prefetch_seek64_file_func OF((voidpf opaque, voidpf stream, ZPOS64_T offset, int origin));
+static int     ZCALLBACK prefetch_close_file_func OF((voidpf opaque, voidpf stream));
+static int     ZCALLBACK prefetch_error_file_func OF((voidpf opaque, voidpf stream));
+
+static voidpf ZCALLBACK prefetch_open64_file_func (voidpf opaque, const void* filename, int mode)
+{
+    const zlib_prefetch_def* def = (const zlib_prefetch_def*)opaque;
+    prefetch_stream* ps;
+    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER)!=ZLIB_FILEFUNC_MODE_READ)
+        return NULL;
+
+    ps = (prefetch_stream*)malloc(sizeof(prefetch_stream));
+    if (ps==NULL)
+        return NULL;
+    memset(ps, 0, sizeof(prefetch_stream));
+    ps->base = &def->base;
+    ps->block_size = (def->block_size > 0) ? (def->block_size + 4095) & ~(uLong)4095 : 0x100000;
+    ps->ahead = (def->ahead > 0) ? def->ahead : (def->ahead < 0) ? 0 : 4;
+    ps->nblocks = (def->blocks > 0) ? def->blocks : 16;
+    /* the block being read must not be the least recently used one */
+    if (ps->nblocks < ps->ahead + 2)
+        ps->nblocks = ps->ahead + 2;
+    ps->last = (ZPOS64_T)-1;
+
+    ps->blocks = (prefetch_block*)calloc((size_t)ps->nblocks, sizeof(prefetch_block));
+    ps->base_stream = (ps->blocks!=NULL) ? ps->base->zopen64_file(ps->base->opaque, filename, mode) : NULL;
+    if ((ps->base_stream==NULL) ||
+        (ps->base->zseek64_file(ps->base->opaque, ps->base_stream, 0, ZLIB_FILEFUNC_SEEK_END)!=0))
+    {
+        if (ps->base_stream!=NULL)
+            ps->base->zclose_file(ps->base->opaque, ps->base_stream);
+        free(ps->blocks);
+        free(ps);
+        return NULL;
+    }
+    ps->size = ps->base->ztell64_file(ps->base->opaque, ps->base_stream);
+
+#ifdef _WIN32
+    InitializeCriticalSection(&ps->lock);
+    InitializeCriticalSection(&ps->io_lock);
+    InitializeConditionVariable(&ps->ready);
+    InitializeConditionVariable(&ps->work);
+    if (ps->ahead > 0)
+    {
+        ps->thread = CreateThread(NULL, 0, prefetch_thread, ps, 0, NULL);
+        ps->has_thread = (ps->thread!=NULL);
+    }
+#else
+    pthread_mutex_init(&ps->lock, NULL);
+    pthread_mutex_init(&ps->io_lock, NULL);
+    pthread_cond_init(&ps->ready, NULL);
+    pthread_cond_init(&ps->work, NULL);
+    if (ps->ahead > 0)
+        ps->has_thread = (pthread_create(&ps->thread, NULL, prefetch_thread, ps)==0);
+#endif
+    /* without the thread, the blocks are still read whole and cached */
+    if (!ps->has_thread)
+        ps->ahead = 0;
+    return ps;
+}
+
+static uLong ZCALLBACK prefetch_read_file_func (voidpf opaque, voidpf stream, void* buf, uLong size)
+{
+    prefetch_stream* ps = (prefetch_stream*)stream;
+    uLong done = 0;
+    (void)opaque;
+
+    PREFETCH_LOCK(ps->lock);
+    while ((done < size) && (ps->pos < ps->size) && (!ps->error))
+    {
+        ZPOS64_T index = ps->pos / ps->block_size;
+        prefetch_block* block;
+        uLong offset, n;
+        int slot = prefetch_find(ps, index);
+
+        if (slot==-1)
+        {
+            slot = prefetch_slot(ps);
+            if (slot==-1)
+                PREFETCH_WAIT(ps->ready, ps->lock);
+            else if (prefetch_load(ps, slot, index)!=0)
+                ps->error = 1;
+            continue;
+        }
+        block = &ps->blocks[slot];
+        if (block->state==PREFETCH_LOADING)
+        {
+            PREFETCH_WAIT(ps->ready, ps->lock);
+            continue;
+        }
+
+        offset = (uLong)(ps->pos - index * ps->block_size);
+        n = block->len - offset;
+        if (n > size - done)
+            n = size - done;
+        memcpy((char*)buf + done, block->data + offset, (size_t)n);
+        block->used = ++ps->clock;
+        done += n;
+        ps->pos += n;
+
+        /* read the following blocks ahead when reading on from the last one */
+        if (index!=ps->last)
+        {
+            if ((index==ps->last + 1) && (ps->ahead > 0))
+            {
+                ps->want = index + 1;
+                ps->want_count = ps->ahead;
+                PREFETCH_BROADCAST(ps->work);
+            }
+            ps->last = index;
+        }
+    }
+    PREFETCH_UNLOCK(ps->lock);
+    return done;
+}
+
+static uLong ZCALLBACK prefetch_write_file_func (voidpf opaque, voidpf stream, const void* buf, uLong size)
+{
+    prefetch_stream* ps = (prefetch_stream*)stream;
+    (void)opaque;
+    (void)buf;
+    (void)size;
+    PREFETCH_LOCK(ps->lock);
+    ps->error = 1;
+    PREFETCH_UNLOCK(ps->lock);
+    return 0;
+}
+
+static ZPOS64_T ZCALLBACK prefetch_tell64_file_func (voidpf opaque, voidpf stream)
+{
+    (void)opaque;
+    return ((prefetch_stream*)stream)->pos;
+}
+
+static long ZCALLBACK prefetch_seek64_file_func (voidpf opaque, voidpf stream, ZPOS64_T offset, int origin)
+{
+    prefetch_stream* ps = (prefetch_stream*)stream;
+    ZPOS64_T new_pos;
+    (void)opaque;
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_CUR :
+        new_pos = ps->pos + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END :
+        new_pos = ps->size + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_SET :
+        new_pos = offset;
+        break;
+    default: return -1;
+    }
+    if (new_pos > ps->size)
+        return -1;
+    ps->pos = new_pos;
+    return 0;
+}
+
+static int ZCALLBACK prefetch_close_file_func (voidpf opaque, voidpf stream)
+{
+    prefetch_stream* ps = (prefetch_stream*)stream;
+    int i, err;
+    (void)opaque;
+
+    if (ps->has_thread)
+    {
+        PREFETCH_LOCK(ps->lock);
+        ps->stop = 1;
+        PREFETCH_BROADCAST(ps->work);
+        PREFETCH_UNLOCK(ps->lock);
+#ifdef _WIN32
+        WaitForSingleObject(ps->thread, INFINITE);
+        CloseHandle(ps->thread);
+#else
+        pthread_join(ps->thread, NULL);
+#endif
+    }
+#ifdef _WIN32
+    DeleteCriticalSection(&ps->lock);
+    DeleteCriticalSection(&ps->io_lock);
+#else
+    pthread_mutex_destroy(&ps->lock);
+    pthread_mutex_destroy(&ps->io_lock);
+    pthread_cond_destroy(&ps->ready);
+    pthread_cond_destroy(&ps->work);
+#endif
+
+    err = ps->base->zclose_file(ps->base->opaque, ps->base_stream);
+    for (i = 0; i < ps->nblocks; i++)
+        free(ps->blocks[i].data);
+    free(ps->blocks);
+    free(ps);
+    return err;
+}
+
+static int ZCALLBACK prefetch_error_file_func (voidpf opaque, voidpf stream)
+{
+    prefetch_stream* ps = (prefetch_stream*)stream;
+    int err;
+    (void)opaque;
+    PREFETCH_LOCK(ps->lock);
+    err = ps->error;
+    PREFETCH_UNLOCK(ps->lock);
+    return err;
+}
+
+void fill_prefetch_filefunc64 (zlib_filefunc64_def* pzlib_filefunc_def, zlib_prefetch_def* prefetch)
+{
+    if (prefetch->base.zopen64_file==NULL)
+        fill_fopen64_filefunc(&prefetch->base);
+    pzlib_filefunc_def->zopen64_file = prefetch_open64_file_func;
+    pzlib_filefunc_def->zread_file = prefetch_read_file_func;
+    pzlib_filefunc_def->zwrite_file = prefetch_write_file_func;
+    pzlib_filefunc_def->ztell64_file = prefetch_tell64_file_func;
+    pzlib_filefunc_def->zseek64_file = prefetch_seek64_file_func;
+    pzlib_filefunc_def->zclose_file = prefetch_close_file_func;
+    pzlib_filefunc_def->zerror_file = prefetch_error_file_func;
+    pzlib_filefunc_def->opaque = prefetch;
+}
@@ -176,6 +176,39 @@ typedef struct zlib_filefunc64_def_s
 void fill_fopen64_filefunc OF((zlib_filefunc64_def* pzlib_filefunc_def));
 void fill_fopen_filefunc OF((zlib_filefunc_def* pzlib_filefunc_def));
 
+/* read only backend which maps the whole file in memory, see
+   unzGetCurrentFileMapping for reading stored files without a copy */
+void fill_mmap_filefunc64 OF((zlib_filefunc64_def* pzlib_filefunc_def));
+
+/* an archive in memory, for fill_memory_filefunc64 */
+typedef struct zlib_mem_buffer_s
+{
+    char*    base;     /* the bytes of the archive */
+    ZPOS64_T size;     /* size of the archive */
+    ZPOS64_T capacity; /* allocated size of base, for writing */
+} zlib_mem_buffer;
+
+/* backend which reads and writes a zlib_mem_buffer, passed instead of the
+   file name. For writing, base is NULL or allocated with malloc, it grows
+   with realloc and the caller frees it */
+void fill_memory_filefunc64 OF((zlib_filefunc64_def* pzlib_filefunc_def));
+
+/* read only wrapper of another backend for file systems where each request
+   is slow, like NFS. The file is read in large aligned blocks kept in a
+   cache, and a thread reads the blocks after a sequential read ahead of it,
+   so that opening an archive and extracting it takes a few requests instead
+   of one per header. Zero fields take the defaults. The zlib_prefetch_def is
+   the opaque of the filled functions and must outlive the files opened */
+typedef struct zlib_prefetch_def_s
+{
+    zlib_filefunc64_def base; /* backend read from, fopen64 if zopen64_file is NULL */
+    uLong block_size;         /* size of the reads, rounded up to 4 KB, default 1 MB */
+    int   blocks;             /* blocks in the cache of a file, default 16 */
+    int   ahead;              /* blocks read ahead, default 4, -1 for none */
+} zlib_prefetch_def;
+
+void fill_prefetch_filefunc64 OF((zlib_filefunc64_def* pzlib_filefunc_def, zlib_prefetch_def* prefetch));
+
 /* now internal definition, only for zip.c and unzip.h */
 typedef struct zlib_filefunc64_32_def_s
 {
@@ -198,6 +231,8 @@ long    call_zseek64 OF((const zlib_filefunc64_32_def* pfilefunc,voidpf filestre
 ZPOS64_T call_ztell64 OF((const zlib_filefunc64_32_def* pfilefunc,voidpf filestream));
 
 void    fill_zlib_filefunc64_32_def_from_filefunc32(zlib_filefunc64_32_def* p_filefunc64_32,const zlib_filefunc_def* p_filefunc32);
+/* the mapping of a stream of fill_mmap_filefunc64, -1 for other backends */
+int     call_zmapping64 OF((const zlib_filefunc64_32_def* pfilefunc,voidpf filestream, const void** base, ZPOS64_T* size));
 
 #define ZOPEN64(filefunc,filename,mode)         (call_zopen64((&(filefunc)),(filename),(mode)))
 #define ZTELL64(filefunc,filestream)            (call_ztell64((&(filefunc)),(filestream)))
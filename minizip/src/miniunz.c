@@ -53,6 +53,7 @@
 #else
 # include <unistd.h>
 # include <utime.h>
+# include <pthread.h>
 #endif
 
 
@@ -72,6 +73,14 @@
 #define USEWIN32IOAPI
 #include "iowin32.h"
 #endif
+
+// MODIFICATION: Chrome trace events, recorded when built with OMS_TRACE
+#ifdef OMS_TRACE
+#include "omstrace.h"
+#else
+#define OMS_TRACE_BEGIN(category, name)
+#define OMS_TRACE_END(category, name)
+#endif
 /*
   mini unzip, demo of unzip package
 
@@ -246,6 +255,7 @@ static int do_list(uf)
     unz_global_info64 gi;
     int err;
 
+    OMS_TRACE_BEGIN("minizip", "do_extract");
     err = unzGetGlobalInfo64(uf,&gi);
     if (err!=UNZ_OK)
         MINIZIP_PRINT("error %d with zipfile in unzGetGlobalInfo \n",err);
@@ -313,6 +323,7 @@ static int do_list(uf)
         }
     }
 
+    OMS_TRACE_END("minizip", "do_extract");
     return 0;
 }
 
@@ -535,6 +546,453 @@ static int do_extract_onefile(uf,filename,opt_extract_without_path,opt_overwrite
         return 1;
 }
 
+/* parallel extraction: the entries of the archive, in directory order */
+typedef struct
+{
+    unz64_file_pos file_pos;
+    char* write_filename; /* dirname/filename_inzip */
+    int is_dir;
+    uLong dosDate;
+    tm_unz tmu_date;
+} miniunz_entry;
+
+typedef struct
+{
+    const char* archive;
+    const char* password;
+    miniunz_entry* entries;
+    ZPOS64_T number_entry;
+    ZPOS64_T next_entry;  /* next entry to extract, under the lock */
+    int err;              /* first error of a worker, under the lock */
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} miniunz_extract_job;
+
+static unzFile open_archive(const char* archive)
+{
+#ifdef USEWIN32IOAPI
+    zlib_filefunc64_def ffunc;
+    fill_win32_filefunc64A(&ffunc);
+    return unzOpen2_64(archive, &ffunc);
+#else
+    return unzOpen64(archive);
+#endif
+}
+
+static void job_lock(miniunz_extract_job* job)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&job->lock);
+#else
+    pthread_mutex_lock(&job->lock);
+#endif
+}
+
+static void job_unlock(miniunz_extract_job* job)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&job->lock);
+#else
+    pthread_mutex_unlock(&job->lock);
+#endif
+}
+
+/* the entries are extracted in the target directory only */
+static int is_unsafe_filename(const char* filename)
+{
+    const char* p = filename;
+    if ((*p=='/') || (*p=='\\') || ((*p!='\0') && (p[1]==':')))
+        return 1;
+    while (*p!='\0')
+    {
+        if ((p[0]=='.') && (p[1]=='.') &&
+            ((p[2]=='\0') || (p[2]=='/') || (p[2]=='\\')))
+            return 1;
+        while ((*p!='\0') && (*p!='/') && (*p!='\\'))
+            p++;
+        while ((*p=='/') || (*p=='\\'))
+            p++;
+    }
+    return 0;
+}
+
+/* match name against a glob pattern, where '*' is any run of characters,
+   '/' included, and '?' any one character */
+static int match_pattern(const char* pattern, const char* name)
+{
+    const char* star = NULL;  /* last '*' of the pattern seen */
+    const char* resume = NULL; /* where name goes on after it */
+
+    while (*name!='\0')
+    {
+        if (*pattern=='*')
+        {
+            star = pattern++;
+            resume = name;
+        }
+        else if ((*pattern=='?') || (*pattern==*name))
+        {
+            pattern++;
+            name++;
+        }
+        else if (star!=NULL)
+        {
+            /* let the last '*' take one more character */
+            pattern = star+1;
+            name = ++resume;
+        }
+        else
+            return 0;
+    }
+    while (*pattern=='*')
+        pattern++;
+    return *pattern=='\0';
+}
+
+/* an entry is extracted if it matches an include pattern, or there are none,
+   and it matches no exclude pattern */
+static int is_selected(const char* filename_inzip, const char* const* includes,
+                       const char* const* excludes)
+{
+    int selected = (includes==NULL) || (*includes==NULL);
+    for (;(includes!=NULL) && (*includes!=NULL) && !selected;includes++)
+        selected = match_pattern(*includes,filename_inzip);
+    for (;(excludes!=NULL) && (*excludes!=NULL) && selected;excludes++)
+        selected = !match_pattern(*excludes,filename_inzip);
+    return selected;
+}
+
+/* list the entries selected and create their directories, before any worker
+   runs. Only the central directory is read, the entries left out cost no
+   seek to their local header */
+static int prepare_extract_job(uf,dirname,includes,excludes,job)
+    unzFile uf;
+    const char* dirname;
+    const char* const* includes;
+    const char* const* excludes;
+    miniunz_extract_job* job;
+{
+    unz_global_info64 gi;
+    ZPOS64_T i;
+    ZPOS64_T n=0;
+    size_t len_dirname = strlen(dirname);
+    int err;
+
+    err = unzGetGlobalInfo64(uf,&gi);
+    if (err!=UNZ_OK)
+    {
+        MINIZIP_PRINT("error %d with zipfile in unzGetGlobalInfo \n",err);
+        return err;
+    }
+
+    job->entries = (miniunz_entry*)calloc((size_t)gi.number_entry+1,sizeof(miniunz_entry));
+    if (job->entries==NULL)
+    {
+        MINIZIP_PRINT("Error allocating memory\n");
+        return UNZ_INTERNALERROR;
+    }
+
+    err = unzGoToFirstFile(uf);
+    for (i=0;(i<gi.number_entry) && (err==UNZ_OK);i++)
+    {
+        char filename_inzip[256];
+        unz_file_info64 file_info;
+        miniunz_entry* entry = &job->entries[n];
+        char* filename_withoutpath;
+        char* p;
+
+        err = unzGetCurrentFileInfo64(uf,&file_info,filename_inzip,sizeof(filename_inzip),NULL,0,NULL,0);
+        if (err!=UNZ_OK)
+        {
+            MINIZIP_PRINT("error %d with zipfile in unzGetCurrentFileInfo\n",err);
+            break;
+        }
+        if (!is_selected(filename_inzip,includes,excludes))
+        {
+            if ((i+1)<gi.number_entry)
+            {
+                err = unzGoToNextFile(uf);
+                if (err!=UNZ_OK)
+                    MINIZIP_PRINT("error %d with zipfile in unzGoToNextFile\n",err);
+            }
+            continue;
+        }
+        if (is_unsafe_filename(filename_inzip))
+        {
+            MINIZIP_PRINT("unsafe file name %s in the zipfile\n",filename_inzip);
+            err = UNZ_BADZIPFILE;
+            break;
+        }
+        unzGetFilePos64(uf,&entry->file_pos);
+        entry->dosDate = file_info.dosDate;
+        entry->tmu_date = file_info.tmu_date;
+
+        entry->write_filename = (char*)malloc(len_dirname+1+strlen(filename_inzip)+1);
+        if (entry->write_filename==NULL)
+        {
+            MINIZIP_PRINT("Error allocating memory\n");
+            err = UNZ_INTERNALERROR;
+            break;
+        }
+        sprintf(entry->write_filename,"%s/%s",dirname,filename_inzip);
+        job->number_entry = ++n;
+
+        p = filename_withoutpath = entry->write_filename;
+        while ((*p) != '\0')
+        {
+            if (((*p)=='/') || ((*p)=='\\'))
+                filename_withoutpath = p+1;
+            p++;
+        }
+
+        /* some zipfile don't contain directory alone before file */
+        if ((*filename_withoutpath)=='\0')
+        {
+            entry->is_dir = 1;
+            makedir(entry->write_filename);
+        }
+        else
+        {
+            char c=*(filename_withoutpath-1);
+            *(filename_withoutpath-1)='\0';
+            makedir(entry->write_filename);
+            *(filename_withoutpath-1)=c;
+        }
+
+        if ((i+1)<gi.number_entry)
+        {
+            err = unzGoToNextFile(uf);
+            if (err!=UNZ_OK)
+                MINIZIP_PRINT("error %d with zipfile in unzGoToNextFile\n",err);
+        }
+    }
+    return err;
+}
+
+static int extract_entry(uf,entry,password,buf,size_buf)
+    unzFile uf;
+    const miniunz_entry* entry;
+    const char* password;
+    void* buf;
+    uInt size_buf;
+{
+    FILE *fout;
+    int err;
+
+    err = unzGoToFilePos64(uf,&entry->file_pos);
+    if (err==UNZ_OK)
+        err = unzOpenCurrentFilePassword(uf,password);
+    if (err!=UNZ_OK)
+    {
+        MINIZIP_PRINT("error %d with zipfile in unzOpenCurrentFilePassword\n",err);
+        return err;
+    }
+
+    fout=FOPEN_FUNC(entry->write_filename,"wb");
+    if (fout==NULL)
+    {
+        MINIZIP_PRINT("error opening %s\n",entry->write_filename);
+        unzCloseCurrentFile(uf);
+        return UNZ_ERRNO;
+    }
+
+    MINIZIP_PRINT(" extracting: %s\n",entry->write_filename);
+    do
+    {
+        err = unzReadCurrentFile(uf,buf,size_buf);
+        if (err<0)
+        {
+            MINIZIP_PRINT("error %d with zipfile in unzReadCurrentFile\n",err);
+            break;
+        }
+        if (err>0)
+            if (fwrite(buf,(unsigned)err,1,fout)!=1)
+            {
+                MINIZIP_PRINT("error in writing extracted file\n");
+                err=UNZ_ERRNO;
+                break;
+            }
+    }
+    while (err>0);
+    fclose(fout);
+
+    if (err==UNZ_OK)
+    {
+        change_file_date(entry->write_filename,entry->dosDate,
+                         entry->tmu_date);
+        err = unzCloseCurrentFile(uf);
+        if (err!=UNZ_OK)
+            MINIZIP_PRINT("error %d with zipfile in unzCloseCurrentFile\n",err);
+    }
+    else
+        unzCloseCurrentFile(uf); /* don't lose the error */
+    return err;
+}
+
+/* a worker takes the next entry until none is left, with its own handle */
+#ifdef _WIN32
+static DWORD WINAPI extract_worker(LPVOID arg)
+#else
+static void* extract_worker(void* arg)
+#endif
+{
+    miniunz_extract_job* job = (miniunz_extract_job*)arg;
+    unzFile uf;
+    void* buf;
+    int err=UNZ_OK;
+
+    uf = open_archive(job->archive);
+    buf = malloc(WRITEBUFFERSIZE);
+    if ((uf==NULL) || (buf==NULL))
+        err = (uf==NULL) ? UNZ_ERRNO : UNZ_INTERNALERROR;
+
+    for (;;)
+    {
+        const miniunz_entry* entry = NULL;
+
+        job_lock(job);
+        if ((err!=UNZ_OK) && (job->err==UNZ_OK))
+            job->err = err;
+        while ((job->err==UNZ_OK) && (job->next_entry<job->number_entry))
+        {
+            entry = &job->entries[job->next_entry++];
+            if (!entry->is_dir)
+                break;
+            entry = NULL;
+        }
+        job_unlock(job);
+
+        if (entry==NULL)
+            break;
+        err = extract_entry(uf,entry,job->password,buf,WRITEBUFFERSIZE);
+    }
+
+    free(buf);
+    if (uf!=NULL)
+        unzClose(uf);
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static int default_thread_count()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+#endif
+}
+
+int miniunz_extract_matching(const char* archive, const char* dirname,
+                             const char* const* includes, const char* const* excludes,
+                             int nthreads, const char* password)
+{
+    miniunz_extract_job job;
+    unzFile uf;
+    ZPOS64_T i;
+    int nstarted=0;
+    int err;
+#ifdef _WIN32
+    HANDLE* threads;
+#else
+    pthread_t* threads;
+#endif
+
+    if ((archive==NULL) || (dirname==NULL))
+        return UNZ_PARAMERROR;
+
+    uf = open_archive(archive);
+    if (uf==NULL)
+    {
+        MINIZIP_PRINT("Cannot open %s\n",archive);
+        return UNZ_ERRNO;
+    }
+
+    memset(&job,0,sizeof(job));
+    job.archive = archive;
+    job.password = password;
+    job.err = UNZ_OK;
+    makedir(dirname);
+    err = prepare_extract_job(uf,dirname,includes,excludes,&job);
+    unzClose(uf);
+
+    if (nthreads<=0)
+        nthreads = default_thread_count();
+    if ((ZPOS64_T)nthreads > job.number_entry)
+        nthreads = (int)job.number_entry;
+
+#ifdef _WIN32
+    threads = (HANDLE*)malloc(sizeof(HANDLE)*(nthreads+1));
+#else
+    threads = (pthread_t*)malloc(sizeof(pthread_t)*(nthreads+1));
+#endif
+    if ((err==UNZ_OK) && (threads==NULL))
+        err = UNZ_INTERNALERROR;
+
+    if (err==UNZ_OK)
+    {
+#ifdef _WIN32
+        InitializeCriticalSection(&job.lock);
+        for (;nstarted<nthreads;nstarted++)
+        {
+            threads[nstarted] = CreateThread(NULL,0,extract_worker,&job,0,NULL);
+            if (threads[nstarted]==NULL)
+                break;
+        }
+#else
+        pthread_mutex_init(&job.lock,NULL);
+        for (;nstarted<nthreads;nstarted++)
+            if (pthread_create(&threads[nstarted],NULL,extract_worker,&job)!=0)
+                break;
+#endif
+        /* with no thread at all, this one does the work */
+        if (nstarted==0)
+            extract_worker(&job);
+
+        for (i=0;i<(ZPOS64_T)nstarted;i++)
+        {
+#ifdef _WIN32
+            WaitForSingleObject(threads[i],INFINITE);
+            CloseHandle(threads[i]);
+#else
+            pthread_join(threads[i],NULL);
+#endif
+        }
+#ifdef _WIN32
+        DeleteCriticalSection(&job.lock);
+#else
+        pthread_mutex_destroy(&job.lock);
+#endif
+        err = job.err;
+    }
+
+    /* the directories get their date once their content is written */
+    for (i=job.number_entry;(err==UNZ_OK) && (i>0);i--)
+        if (job.entries[i-1].is_dir)
+            change_file_date(job.entries[i-1].write_filename,job.entries[i-1].dosDate,
+                             job.entries[i-1].tmu_date);
+
+    free(threads);
+    for (i=0;i<job.number_entry;i++)
+        free(job.entries[i].write_filename);
+    free(job.entries);
+    return err;
+}
+
+int miniunz_extract_parallel(const char* archive, const char* dirname, int nthreads, const char* password)
+{
+    return miniunz_extract_matching(archive, dirname, NULL, NULL, nthreads, password);
+}
+
 void miniunz_free(const char *ptr)
 {
     free(ptr);
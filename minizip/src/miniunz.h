@@ -11,6 +11,23 @@ int miniunz(int argc , char *argv[]);
 const char* miniunz_onefile_to_memory(const char* archive, const char* filename);
 void miniunz_free(const char *ptr);
 
+// MODIFICATION: Extract all files of the archive into dirname with nthreads
+// workers, each with its own handle on the archive. The directories are
+// created first. nthreads <= 0 uses one worker per processor.
+// Returns UNZ_OK or the first error.
+int miniunz_extract_parallel(const char* archive, const char* dirname, int nthreads, const char* password);
+
+// MODIFICATION: Extract the files of the archive selected by glob patterns,
+// as miniunz_extract_parallel. includes and excludes are NULL terminated
+// lists of patterns, where '*' matches any characters, '/' included, and '?'
+// any one character, e.g. "modelDescription.xml", "binaries/linux64/*" and
+// "resources/*". A file is extracted if it matches an include pattern, or
+// includes is NULL or empty, and no exclude pattern. The names are matched
+// on the central directory, the files left out are not read at all.
+int miniunz_extract_matching(const char* archive, const char* dirname,
+                             const char* const* includes, const char* const* excludes,
+                             int nthreads, const char* password);
+
 #ifdef __cplusplus
 }
 #endif
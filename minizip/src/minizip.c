@@ -56,9 +56,11 @@
 # include <utime.h>
 # include <sys/types.h>
 # include <sys/stat.h>
+# include <pthread.h>
 #endif
 
 #include "zip.h"
+#include "minizip.h"
 
 #ifdef _WIN32
         #define USEWIN32IOAPI
@@ -250,6 +252,369 @@ static int isLargeFile(const char* filename)
  return largeFile;
 }
 
+/* parallel compression: each entry is deflated into memory by a worker,
+   then written raw in the zipfile, in order */
+typedef struct
+{
+    const char* filename;
+    const char* filenameinzip;
+    zip_fileinfo zi;
+    unsigned char* data;     /* the compressed bytes */
+    ZPOS64_T size_data;
+    ZPOS64_T uncompressed_size;
+    uLong crc;
+    int err;
+    int done;
+} minizip_entry;
+
+typedef struct
+{
+    minizip_entry* entries;
+    int count;
+    int next_entry;          /* next entry to compress, under the lock */
+    int level;
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE entry_done;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t entry_done;
+#endif
+} minizip_compress_job;
+
+static void job_lock(minizip_compress_job* job)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&job->lock);
+#else
+    pthread_mutex_lock(&job->lock);
+#endif
+}
+
+static void job_unlock(minizip_compress_job* job)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&job->lock);
+#else
+    pthread_mutex_unlock(&job->lock);
+#endif
+}
+
+static int append_data(entry,buf,len,capacity)
+    minizip_entry* entry;
+    const void* buf;
+    size_t len;
+    size_t* capacity;
+{
+    if (len==0)
+        return ZIP_OK;
+    if (entry->size_data + len > *capacity)
+    {
+        size_t new_capacity = (*capacity < WRITEBUFFERSIZE) ? WRITEBUFFERSIZE : *capacity * 2;
+        unsigned char* data;
+        while (new_capacity < entry->size_data + len)
+            new_capacity *= 2;
+        data = (unsigned char*)realloc(entry->data,new_capacity);
+        if (data==NULL)
+            return ZIP_INTERNALERROR;
+        entry->data = data;
+        *capacity = new_capacity;
+    }
+    memcpy(entry->data+entry->size_data,buf,len);
+    entry->size_data += len;
+    return ZIP_OK;
+}
+
+/* read the file and deflate it, or keep it as is with level 0 */
+static int compress_entry(entry,level)
+    minizip_entry* entry;
+    int level;
+{
+    unsigned char in[WRITEBUFFERSIZE];
+    unsigned char out[WRITEBUFFERSIZE];
+    size_t capacity = 0;
+    size_t size_read;
+    z_stream stream;
+    int err = ZIP_OK;
+    int flush;
+    FILE* fin;
+
+    fin = FOPEN_FUNC(entry->filename,"rb");
+    if (fin==NULL)
+    {
+        MINIZIP_PRINT("error in opening %s for reading\n",entry->filename);
+        return ZIP_ERRNO;
+    }
+
+    memset(&stream,0,sizeof(stream));
+    if ((level!=0) &&
+        (deflateInit2(&stream,level,Z_DEFLATED,-MAX_WBITS,DEF_MEM_LEVEL,Z_DEFAULT_STRATEGY)!=Z_OK))
+    {
+        fclose(fin);
+        return ZIP_INTERNALERROR;
+    }
+
+    entry->crc = crc32(0L,Z_NULL,0);
+    do
+    {
+        size_read = fread(in,1,sizeof(in),fin);
+        if ((size_read < sizeof(in)) && (feof(fin)==0))
+        {
+            MINIZIP_PRINT("error in reading %s\n",entry->filename);
+            err = ZIP_ERRNO;
+            break;
+        }
+        entry->crc = crc32(entry->crc,in,(uInt)size_read);
+        entry->uncompressed_size += size_read;
+
+        if (level==0)
+        {
+            err = append_data(entry,in,size_read,&capacity);
+            continue;
+        }
+
+        flush = (size_read < sizeof(in)) ? Z_FINISH : Z_NO_FLUSH;
+        stream.next_in = in;
+        stream.avail_in = (uInt)size_read;
+        do
+        {
+            stream.next_out = out;
+            stream.avail_out = sizeof(out);
+            if (deflate(&stream,flush)==Z_STREAM_ERROR)
+                err = ZIP_INTERNALERROR;
+            else
+                err = append_data(entry,out,sizeof(out)-stream.avail_out,&capacity);
+        }
+        while ((err==ZIP_OK) && (stream.avail_out==0));
+    }
+    while ((err==ZIP_OK) && (size_read==sizeof(in)));
+
+    if (level!=0)
+        deflateRelease(&stream);
+    fclose(fin);
+    return err;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI compress_worker(LPVOID arg)
+#else
+static void* compress_worker(void* arg)
+#endif
+{
+    minizip_compress_job* job = (minizip_compress_job*)arg;
+
+    for (;;)
+    {
+        minizip_entry* entry = NULL;
+        int err;
+
+        job_lock(job);
+        if (job->next_entry < job->count)
+            entry = &job->entries[job->next_entry++];
+        job_unlock(job);
+        if (entry==NULL)
+            break;
+
+        err = compress_entry(entry,job->level);
+
+        job_lock(job);
+        entry->err = err;
+        entry->done = 1;
+#ifdef _WIN32
+        WakeAllConditionVariable(&job->entry_done);
+#else
+        pthread_cond_broadcast(&job->entry_done);
+#endif
+        job_unlock(job);
+    }
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static int write_entry(zf,entry,level)
+    zipFile zf;
+    const minizip_entry* entry;
+    int level;
+{
+    int zip64 = (entry->uncompressed_size >= 0xffffffff) || (entry->size_data >= 0xffffffff);
+    ZPOS64_T pos = 0;
+    int err;
+
+    err = zipOpenNewFileInZip3_64(zf,entry->filenameinzip,&entry->zi,
+                                  NULL,0,NULL,0,NULL /* comment*/,
+                                  (level != 0) ? Z_DEFLATED : 0,
+                                  level,1,
+                                  -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY,
+                                  NULL,0, zip64);
+    if (err != ZIP_OK)
+    {
+        MINIZIP_PRINT("error in opening %s in zipfile\n",entry->filenameinzip);
+        return err;
+    }
+
+    /* zipWriteInFileInZip takes at most 4 GB at once */
+    while ((err==ZIP_OK) && (pos < entry->size_data))
+    {
+        ZPOS64_T len = entry->size_data - pos;
+        if (len > 0x40000000)
+            len = 0x40000000;
+        err = zipWriteInFileInZip(zf,entry->data+pos,(unsigned)len);
+        pos += len;
+    }
+
+    if (err==ZIP_OK)
+        err = zipCloseFileInZipRaw64(zf,entry->uncompressed_size,entry->crc);
+    else
+        zipCloseFileInZipRaw64(zf,entry->uncompressed_size,entry->crc);
+    if (err!=ZIP_OK)
+        MINIZIP_PRINT("error in writing %s in the zipfile\n",entry->filenameinzip);
+    return err;
+}
+
+static int default_thread_count()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+#endif
+}
+
+int minizip_add_files_parallel(zipFile zf, int count, const char* const* filenames,
+                               const char* const* filenamesinzip, int level, int nthreads)
+{
+    minizip_compress_job job;
+    int nstarted=0;
+    int err=ZIP_OK;
+    int i;
+#ifdef _WIN32
+    HANDLE* threads;
+#else
+    pthread_t* threads;
+#endif
+
+    if ((zf==NULL) || (count<0) || ((count>0) && (filenames==NULL)))
+        return ZIP_PARAMERROR;
+    if (count==0)
+        return ZIP_OK;
+    if (level==Z_DEFAULT_COMPRESSION)
+        level = 6;
+    if ((level<0) || (level>9))
+        return ZIP_PARAMERROR;
+
+    memset(&job,0,sizeof(job));
+    job.count = count;
+    job.level = level;
+    job.entries = (minizip_entry*)calloc((size_t)count,sizeof(minizip_entry));
+
+    if (nthreads<=0)
+        nthreads = default_thread_count();
+    if (nthreads > count)
+        nthreads = count;
+#ifdef _WIN32
+    threads = (HANDLE*)malloc(sizeof(HANDLE)*nthreads);
+#else
+    threads = (pthread_t*)malloc(sizeof(pthread_t)*nthreads);
+#endif
+    if ((job.entries==NULL) || (threads==NULL))
+    {
+        free(job.entries);
+        free(threads);
+        return ZIP_INTERNALERROR;
+    }
+
+    for (i=0;i<count;i++)
+    {
+        minizip_entry* entry = &job.entries[i];
+        entry->filename = filenames[i];
+        entry->filenameinzip = (filenamesinzip!=NULL) ? filenamesinzip[i] : filenames[i];
+        /* the path name saved should not include a leading slash */
+        while ((entry->filenameinzip[0]=='\\') || (entry->filenameinzip[0]=='/'))
+            entry->filenameinzip++;
+        filetime(entry->filename,&entry->zi.tmz_date,&entry->zi.dosDate);
+    }
+
+#ifdef _WIN32
+    InitializeCriticalSection(&job.lock);
+    InitializeConditionVariable(&job.entry_done);
+    for (;nstarted<nthreads;nstarted++)
+    {
+        threads[nstarted] = CreateThread(NULL,0,compress_worker,&job,0,NULL);
+        if (threads[nstarted]==NULL)
+            break;
+    }
+#else
+    pthread_mutex_init(&job.lock,NULL);
+    pthread_cond_init(&job.entry_done,NULL);
+    for (;nstarted<nthreads;nstarted++)
+        if (pthread_create(&threads[nstarted],NULL,compress_worker,&job)!=0)
+            break;
+#endif
+    /* with no thread at all, this one does the work */
+    if (nstarted==0)
+        compress_worker(&job);
+
+    /* each entry is written as soon as it is compressed, then freed */
+    for (i=0;i<count;i++)
+    {
+        minizip_entry* entry = &job.entries[i];
+
+        job_lock(&job);
+        while (!entry->done)
+        {
+#ifdef _WIN32
+            SleepConditionVariableCS(&job.entry_done,&job.lock,INFINITE);
+#else
+            pthread_cond_wait(&job.entry_done,&job.lock);
+#endif
+        }
+        err = entry->err;
+        job_unlock(&job);
+
+        if (err==ZIP_OK)
+            err = write_entry(zf,entry,level);
+        free(entry->data);
+        entry->data = NULL;
+
+        /* the entries which are not started are never done */
+        if (err!=ZIP_OK)
+        {
+            job_lock(&job);
+            job.next_entry = count;
+            job_unlock(&job);
+            break;
+        }
+    }
+
+    for (i=0;i<nstarted;i++)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i],INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i],NULL);
+#endif
+    }
+#ifdef _WIN32
+    DeleteCriticalSection(&job.lock);
+#else
+    pthread_cond_destroy(&job.entry_done);
+    pthread_mutex_destroy(&job.lock);
+#endif
+
+    for (i=0;i<count;i++)
+        free(job.entries[i].data);
+    free(job.entries);
+    free(threads);
+    return err;
+}
+
 int minizip(argc,argv)
     int argc;
     char *argv[];
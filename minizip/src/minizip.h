@@ -1,12 +1,22 @@
 #ifndef _MINIZIP_H_
 #define _MINIZIP_H_
 
+#include "zip.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 int minizip(int argc , char *argv[]);
 
+// MODIFICATION: Add count files to the open zipfile zf, deflated at level in
+// parallel by nthreads workers (<= 0 for one per processor), each into
+// memory, then written raw in order with zipCloseFileInZipRaw64.
+// filenamesinzip may be NULL to store the files under their own names.
+// Returns ZIP_OK or the first error.
+int minizip_add_files_parallel(zipFile zf, int count, const char* const* filenames,
+                               const char* const* filenamesinzip, int level, int nthreads);
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,6 +10,9 @@
 #include <string.h>
 #include "zlib.h"
 #include "unzip.h"
+#include "zip.h"
+
+#define COPYBUFFERSIZE (16384)
 
 #define READ_8(adr)  ((unsigned char)*(adr))
 #define READ_16(adr) ( READ_8(adr) | (READ_8(adr+1) << 8) )
@@ -289,3 +292,127 @@ uLong* bytesRecovered;
   }
   return err;
 }
+
+extern int ZEXPORT zipCopyCurrentFileRaw(uf, zf, filenameinzip)
+unzFile uf;
+zipFile zf;
+const char* filenameinzip;
+{
+  unz_file_info64 file_info;
+  zip_fileinfo zi;
+  char* filename = NULL;
+  char* extrafield_global = NULL;
+  char* extrafield_local = NULL;
+  char* comment = NULL;
+  char* buf = NULL;
+  int size_extrafield_global;
+  int size_extrafield_local = 0;
+  int method;
+  int level;
+  int zip64;
+  int opened = 0;
+  int err;
+
+  err = unzGetCurrentFileInfo64(uf, &file_info, NULL, 0, NULL, 0, NULL, 0);
+  if (err != UNZ_OK)
+    return err;
+
+  /* without crc in the local header, the check byte of crypted files is
+     from the time, which is not kept when writing */
+  if ((file_info.flag & 1) && (file_info.flag & 8))
+    return UNZ_PARAMERROR;
+
+  filename = (char*)malloc(file_info.size_filename + 1);
+  extrafield_global = (char*)malloc(file_info.size_file_extra + 1);
+  comment = (char*)malloc(file_info.size_file_comment + 1);
+  buf = (char*)malloc(COPYBUFFERSIZE);
+  if (filename == NULL || extrafield_global == NULL || comment == NULL || buf == NULL)
+    err = UNZ_INTERNALERROR;
+
+  if (err == UNZ_OK)
+    err = unzGetCurrentFileInfo64(uf, &file_info,
+                                  filename, file_info.size_filename + 1,
+                                  extrafield_global, file_info.size_file_extra,
+                                  comment, file_info.size_file_comment + 1);
+
+  if (err == UNZ_OK) {
+    err = unzOpenCurrentFile2(uf, &method, &level, 1);
+    opened = (err == UNZ_OK);
+  }
+
+  /* the local extra field, once the file is opened */
+  if (err == UNZ_OK) {
+    size_extrafield_local = unzGetLocalExtrafield(uf, NULL, 0);
+    if (size_extrafield_local < 0)
+      err = size_extrafield_local;
+    else {
+      extrafield_local = (char*)malloc(size_extrafield_local + 1);
+      if (extrafield_local == NULL)
+        err = UNZ_INTERNALERROR;
+      else if (unzGetLocalExtrafield(uf, extrafield_local, size_extrafield_local) != size_extrafield_local)
+        err = UNZ_ERRNO;
+    }
+  }
+
+  if (err == UNZ_OK) {
+    /* zip.c writes its own Zip64 extra field */
+    size_extrafield_global = (int)file_info.size_file_extra;
+    zipRemoveExtraInfoBlock(extrafield_local, &size_extrafield_local, 0x0001);
+    zipRemoveExtraInfoBlock(extrafield_global, &size_extrafield_global, 0x0001);
+
+    memset(&zi, 0, sizeof(zi));
+    zi.tmz_date.tm_sec = file_info.tmu_date.tm_sec;
+    zi.tmz_date.tm_min = file_info.tmu_date.tm_min;
+    zi.tmz_date.tm_hour = file_info.tmu_date.tm_hour;
+    zi.tmz_date.tm_mday = file_info.tmu_date.tm_mday;
+    zi.tmz_date.tm_mon = file_info.tmu_date.tm_mon;
+    zi.tmz_date.tm_year = file_info.tmu_date.tm_year;
+    zi.dosDate = file_info.dosDate;
+    zi.internal_fa = file_info.internal_fa;
+    zi.external_fa = file_info.external_fa;
+
+    zip64 = (file_info.uncompressed_size >= 0xffffffff) ||
+            (file_info.compressed_size >= 0xffffffff);
+    err = zipOpenNewFileInZip4_64(zf,
+                                  (filenameinzip != NULL) ? filenameinzip : filename,
+                                  &zi,
+                                  extrafield_local, (uInt)size_extrafield_local,
+                                  extrafield_global, (uInt)size_extrafield_global,
+                                  (file_info.size_file_comment > 0) ? comment : NULL,
+                                  method, level, 1,
+                                  -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY,
+                                  NULL, 0,
+                                  file_info.version, file_info.flag & ~(uLong)8,
+                                  zip64);
+
+    if (err == ZIP_OK) {
+      int size_read;
+      do {
+        size_read = unzReadCurrentFile(uf, buf, COPYBUFFERSIZE);
+        if (size_read < 0)
+          err = size_read;
+        else if (size_read > 0)
+          err = zipWriteInFileInZip(zf, buf, (unsigned)size_read);
+      } while (err == ZIP_OK && size_read > 0);
+
+      if (err == ZIP_OK)
+        err = zipCloseFileInZipRaw64(zf, file_info.uncompressed_size, file_info.crc);
+      else
+        zipCloseFileInZipRaw64(zf, file_info.uncompressed_size, file_info.crc);
+    }
+  }
+
+  if (opened) {
+    if (err == UNZ_OK)
+      err = unzCloseCurrentFile(uf);
+    else
+      unzCloseCurrentFile(uf);
+  }
+
+  free(filename);
+  free(extrafield_global);
+  free(extrafield_local);
+  free(comment);
+  free(buf);
+  return err;
+}
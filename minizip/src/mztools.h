@@ -16,6 +16,7 @@ extern "C" {
 #endif
 
 #include "unzip.h"
+#include "zip.h"
 
 /* Repair a ZIP file (missing central directory)
    file: file to recover
@@ -28,6 +29,17 @@ extern int ZEXPORT unzRepair(const char* file,
                              uLong* nRecovered,
                              uLong* bytesRecovered);
 
+/* Copy the current file of uf into zf without decompressing it: the
+   compressed bytes, crc, sizes, dates, attributes, extra fields and comment
+   are kept as they are. Crypted files are copied still crypted.
+   uf: zipfile to read, positioned on the file to copy
+   zf: zipfile to write, with no file opened in it
+   filenameinzip: name in zf, or NULL to keep the name
+*/
+extern int ZEXPORT zipCopyCurrentFileRaw(unzFile uf,
+                                         zipFile zf,
+                                         const char* filenameinzip);
+
 
 #ifdef __cplusplus
 }
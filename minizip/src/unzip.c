@@ -157,9 +157,35 @@ typedef struct
     uLong compression_method;   /* compression method (0==store) */
     ZPOS64_T byte_before_the_zipfile;/* byte before the zipfile, (>0 for sfx)*/
     int   raw;
+    uInt  read_buffer_size;     /* size of read_buffer */
 } file_in_zip64_read_info_s;
 
 
+/* unz64_index_entry is a file name of the central directory, found by its
+    hash in unz64_file_index
+*/
+typedef struct
+{
+    uLong    name_offset;          /* offset of the name in central_dir */
+    uLong    size_filename;        /* filename length */
+    uLong    hash;                 /* hash of the name, ascii case folded */
+    uLong    next;                 /* next entry in the bucket, in directory
+                                      order, or UNZ_INDEX_NONE */
+    ZPOS64_T pos_in_zip_directory; /* position of the file header */
+    ZPOS64_T num_of_file;          /* # of file */
+} unz64_index_entry;
+
+#define UNZ_INDEX_NONE ((uLong)-1)
+
+typedef struct
+{
+    unsigned char* central_dir;    /* the central directory, read at once */
+    unz64_index_entry* entries;    /* the files, in directory order */
+    uLong number_entry;            /* number of entries */
+    uLong* buckets;                /* first entry of each hash bucket */
+    uLong number_bucket;           /* a power of two */
+} unz64_file_index;
+
 /* unz64_s contain internal information about the zipfile
 */
 typedef struct
@@ -186,6 +212,11 @@ typedef struct
 
     int isZip64;
 
+    unz64_file_index* file_index; /* index of the file names, NULL until
+                                     unzBuildFileIndex is called */
+
+    uInt read_buffer_size;      /* read buffer of the files opened next */
+
 #    ifndef NOUNCRYPT
     unsigned long keys[3];     /* keys defining the pseudo-random sequence */
     const z_crc_t* pcrc_32_tab;
@@ -374,6 +405,11 @@ local int strcmpcasenosensitive_internal (const char* fileName1, const char* fil
 #define CASESENSITIVITYDEFAULTVALUE 1
 #endif
 
+#ifdef STRCMPCASENOSENTIVEFUNCTION
+/* the file index cannot know which names such a function finds equal */
+#define UNZ_INDEX_CASESENSITIVE_ONLY
+#endif
+
 #ifndef STRCMPCASENOSENTIVEFUNCTION
 #define STRCMPCASENOSENTIVEFUNCTION strcmpcasenosensitive_internal
 #endif
@@ -581,6 +617,17 @@ local ZPOS64_T unz64local_SearchCentralDir64(const zlib_filefunc64_32_def* pzlib
      Else, the return value is a unzFile Handle, usable with other function
        of this unzip package.
 */
+local void unz64local_FreeFileIndex OF((unz64_file_index* index));
+local void unz64local_FreeFileIndex (unz64_file_index* index)
+{
+    if (index==NULL)
+        return;
+    TRYFREE(index->central_dir);
+    TRYFREE(index->entries);
+    TRYFREE(index->buckets);
+    TRYFREE(index);
+}
+
 local unzFile unzOpenInternal (const void *path,
                                zlib_filefunc64_32_def* pzlib_filefunc64_32_def,
                                int is64bitOpenFunction)
@@ -750,12 +797,18 @@ local unzFile unzOpenInternal (const void *path,
     us.central_pos = central_pos;
     us.pfile_in_zip_read = NULL;
     us.encrypted = 0;
+    us.file_index = NULL;
+    us.read_buffer_size = UNZ_BUFSIZE;
 
 
     s=(unz64_s*)ALLOC(sizeof(unz64_s));
     if( s != NULL)
     {
         *s=us;
+#ifdef UNZ_FILE_INDEX_ON_OPEN
+        /* without the index the archive is walked as usual */
+        unzBuildFileIndex((unzFile)s);
+#endif
         unzGoToFirstFile((unzFile)s);
     }
     return (unzFile)s;
@@ -790,6 +843,19 @@ extern unzFile ZEXPORT unzOpen2_64 (const void *path,
         return unzOpenInternal(path, NULL, 1);
 }
 
+extern unzFile ZEXPORT unzOpenMemory (const void *buf, ZPOS64_T size)
+{
+    zlib_filefunc64_def zlib_filefunc_def;
+    zlib_mem_buffer buffer;
+    if (buf == NULL)
+        return NULL;
+    buffer.base = (char*)buf;
+    buffer.size = size;
+    buffer.capacity = 0;
+    fill_memory_filefunc64(&zlib_filefunc_def);
+    return unzOpen2_64(&buffer, &zlib_filefunc_def);
+}
+
 extern unzFile ZEXPORT unzOpen (const char *path)
 {
     return unzOpenInternal(path, NULL, 0);
@@ -815,6 +881,8 @@ extern int ZEXPORT unzClose (unzFile file)
     if (s->pfile_in_zip_read!=NULL)
         unzCloseCurrentFile(file);
 
+    unz64local_FreeFileIndex(s->file_index);
+
     ZCLOSE64(s->z_filefunc, s->filestream);
     TRYFREE(s);
     return UNZ_OK;
@@ -1221,6 +1289,244 @@ extern int ZEXPORT unzGoToNextFile (unzFile  file)
 }
 
 
+/*
+  The file index. The central directory is read into memory in one piece
+  and the names are hashed, folding the ascii case so that one hash serves
+  both kinds of comparison.
+*/
+local uLong unz64local_HashFileName OF((const char* szFileName, uLong size_filename));
+local uLong unz64local_HashFileName (const char* szFileName, uLong size_filename)
+{
+    uLong hash = 2166136261UL;
+    uLong i;
+    for (i=0;i<size_filename;i++)
+    {
+        char c = szFileName[i];
+        if ((c>='a') && (c<='z'))
+            c -= 0x20;
+        hash = ((hash ^ (unsigned char)c) * 16777619UL) & 0xffffffffUL;
+    }
+    return hash;
+}
+
+local int unz64local_CanUseFileIndex OF((const unz64_s* s, int iCaseSensitivity));
+local int unz64local_CanUseFileIndex (const unz64_s* s, int iCaseSensitivity)
+{
+    if (s->file_index==NULL)
+        return 0;
+#ifdef UNZ_INDEX_CASESENSITIVE_ONLY
+    if (iCaseSensitivity==0)
+        iCaseSensitivity=CASESENSITIVITYDEFAULTVALUE;
+    if (iCaseSensitivity!=1)
+        return 0;
+#else
+    (void)iCaseSensitivity;
+#endif
+    return 1;
+}
+
+/*
+  Find szFileName in the index, without changing the current file. The
+  first of the files with the name is found, like walking the directory.
+*/
+local int unz64local_LookupFileIndex OF((const unz64_s* s,
+                                         const char* szFileName,
+                                         int iCaseSensitivity,
+                                         unz64_file_pos* file_pos));
+local int unz64local_LookupFileIndex (const unz64_s* s,
+                                      const char* szFileName,
+                                      int iCaseSensitivity,
+                                      unz64_file_pos* file_pos)
+{
+    const unz64_file_index* index = s->file_index;
+    uLong size_filename = (uLong)strlen(szFileName);
+    uLong hash = unz64local_HashFileName(szFileName,size_filename);
+    uLong i;
+
+    if (iCaseSensitivity==0)
+        iCaseSensitivity=CASESENSITIVITYDEFAULTVALUE;
+
+    for (i=index->buckets[hash & (index->number_bucket-1)];
+         i!=UNZ_INDEX_NONE;
+         i=index->entries[i].next)
+    {
+        const unz64_index_entry* entry = &index->entries[i];
+        const char* name = (const char*)index->central_dir + entry->name_offset;
+        if ((entry->hash!=hash) || (entry->size_filename!=size_filename))
+            continue;
+
+        if (iCaseSensitivity==1)
+        {
+            if (memcmp(name,szFileName,size_filename)!=0)
+                continue;
+        }
+        else
+        {
+            char szCurrentFileName[UNZ_MAXFILENAMEINZIP+1];
+            memcpy(szCurrentFileName,name,size_filename);
+            szCurrentFileName[size_filename]='\0';
+            if (STRCMPCASENOSENTIVEFUNCTION(szCurrentFileName,szFileName)!=0)
+                continue;
+        }
+
+        file_pos->pos_in_zip_directory = entry->pos_in_zip_directory;
+        file_pos->num_of_file = entry->num_of_file;
+        return UNZ_OK;
+    }
+    return UNZ_END_OF_LIST_OF_FILE;
+}
+
+extern int ZEXPORT unzBuildFileIndex (unzFile file)
+{
+    unz64_s* s;
+    unz64_file_index* index;
+    uLong size_central_dir;
+    uLong max_entry;
+    uLong offset = 0;
+    uLong i;
+    int err = UNZ_OK;
+
+    if (file==NULL)
+        return UNZ_PARAMERROR;
+    s=(unz64_s*)file;
+    if (s->file_index!=NULL)
+        return UNZ_OK;
+
+    size_central_dir = (uLong)s->size_central_dir;
+    if (size_central_dir!=s->size_central_dir)
+        return UNZ_INTERNALERROR;
+
+    index = (unz64_file_index*)ALLOC(sizeof(unz64_file_index));
+    if (index==NULL)
+        return UNZ_INTERNALERROR;
+
+    max_entry = size_central_dir / SIZECENTRALDIRITEM;
+    index->number_entry = 0;
+    index->number_bucket = 16;
+    while ((index->number_bucket < max_entry) && (index->number_bucket < 0x40000000UL))
+        index->number_bucket <<= 1;
+
+    index->central_dir = (unsigned char*)ALLOC(size_central_dir + 1);
+    index->entries = (unz64_index_entry*)ALLOC((max_entry + 1) * sizeof(unz64_index_entry));
+    index->buckets = (uLong*)ALLOC(index->number_bucket * sizeof(uLong));
+    if ((index->central_dir==NULL) || (index->entries==NULL) || (index->buckets==NULL))
+        err=UNZ_INTERNALERROR;
+
+    if (err==UNZ_OK)
+    {
+        if (ZSEEK64(s->z_filefunc, s->filestream,
+                  s->offset_central_dir+s->byte_before_the_zipfile,
+                  ZLIB_FILEFUNC_SEEK_SET)!=0)
+            err=UNZ_ERRNO;
+        else if (ZREAD64(s->z_filefunc, s->filestream,
+                         index->central_dir,size_central_dir)!=size_central_dir)
+            err=UNZ_ERRNO;
+    }
+
+    /* the same headers as unz64local_GetCurrentFileInfoInternal reads */
+    while ((err==UNZ_OK) && (offset + SIZECENTRALDIRITEM <= size_central_dir))
+    {
+        const unsigned char* header = index->central_dir + offset;
+        unz64_index_entry* entry = &index->entries[index->number_entry];
+        uLong size_file_extra;
+        uLong size_file_comment;
+
+        if ((header[0]!=0x50) || (header[1]!=0x4b) || (header[2]!=0x01) || (header[3]!=0x02))
+        {
+            err=UNZ_BADZIPFILE;
+            break;
+        }
+
+        entry->size_filename = (uLong)header[28] | ((uLong)header[29] << 8);
+        size_file_extra = (uLong)header[30] | ((uLong)header[31] << 8);
+        size_file_comment = (uLong)header[32] | ((uLong)header[33] << 8);
+        if (size_central_dir - offset - SIZECENTRALDIRITEM <
+            entry->size_filename + size_file_extra + size_file_comment)
+        {
+            err=UNZ_BADZIPFILE;
+            break;
+        }
+
+        entry->name_offset = offset + SIZECENTRALDIRITEM;
+        entry->hash = unz64local_HashFileName((const char*)index->central_dir + entry->name_offset,
+                                              entry->size_filename);
+        entry->pos_in_zip_directory = s->offset_central_dir + offset;
+        entry->num_of_file = index->number_entry;
+        index->number_entry++;
+
+        offset += SIZECENTRALDIRITEM + entry->size_filename + size_file_extra + size_file_comment;
+    }
+
+    /* 2^16 files overflow hack, as in unzGoToNextFile */
+    if ((err==UNZ_OK) && (s->gi.number_entry!=0xffff) &&
+        (s->gi.number_entry!=index->number_entry))
+        err=UNZ_BADZIPFILE;
+
+    if (err!=UNZ_OK)
+    {
+        unz64local_FreeFileIndex(index);
+        return err;
+    }
+
+    /* filled from the end, so that each bucket is in directory order */
+    for (i=0;i<index->number_bucket;i++)
+        index->buckets[i] = UNZ_INDEX_NONE;
+    for (i=index->number_entry;i>0;i--)
+    {
+        unz64_index_entry* entry = &index->entries[i-1];
+        uLong bucket = entry->hash & (index->number_bucket-1);
+        entry->next = index->buckets[bucket];
+        index->buckets[bucket] = i-1;
+    }
+
+    s->file_index = index;
+    return UNZ_OK;
+}
+
+extern int ZEXPORT unzLocateFilePos64 (unzFile file,
+                                       const char *szFileName,
+                                       int iCaseSensitivity,
+                                       unz64_file_pos* file_pos)
+{
+    unz64_s* s;
+    int err;
+
+    if ((file==NULL) || (szFileName==NULL) || (file_pos==NULL))
+        return UNZ_PARAMERROR;
+
+    if (strlen(szFileName)>=UNZ_MAXFILENAMEINZIP)
+        return UNZ_PARAMERROR;
+
+    s=(unz64_s*)file;
+    if (s->file_index==NULL)
+        unzBuildFileIndex(file);
+
+    if (unz64local_CanUseFileIndex(s,iCaseSensitivity))
+        return unz64local_LookupFileIndex(s,szFileName,iCaseSensitivity,file_pos);
+
+    /* walk the directory and come back to the current file */
+    {
+        unz_file_info64 cur_file_infoSaved = s->cur_file_info;
+        unz_file_info64_internal cur_file_info_internalSaved = s->cur_file_info_internal;
+        ZPOS64_T num_fileSaved = s->num_file;
+        ZPOS64_T pos_in_central_dirSaved = s->pos_in_central_dir;
+        ZPOS64_T current_file_okSaved = s->current_file_ok;
+
+        s->current_file_ok = 1;
+        err = unzLocateFile(file,szFileName,iCaseSensitivity);
+        if (err==UNZ_OK)
+            err = unzGetFilePos64(file,file_pos);
+
+        s->num_file = num_fileSaved;
+        s->pos_in_central_dir = pos_in_central_dirSaved;
+        s->cur_file_info = cur_file_infoSaved;
+        s->cur_file_info_internal = cur_file_info_internalSaved;
+        s->current_file_ok = current_file_okSaved;
+        return err;
+    }
+}
+
+
 /*
   Try locate the file szFileName in the zipfile.
   For the iCaseSensitivity signification, see unzStringFileNameCompare
@@ -1253,6 +1559,15 @@ extern int ZEXPORT unzLocateFile (unzFile file, const char *szFileName, int iCas
     if (!s->current_file_ok)
         return UNZ_END_OF_LIST_OF_FILE;
 
+    if (unz64local_CanUseFileIndex(s,iCaseSensitivity))
+    {
+        unz64_file_pos file_pos;
+        err = unz64local_LookupFileIndex(s,szFileName,iCaseSensitivity,&file_pos);
+        if (err!=UNZ_OK)
+            return err;
+        return unzGoToFilePos64(file,&file_pos);
+    }
+
     /* Save the current state */
     num_fileSaved = s->num_file;
     pos_in_central_dirSaved = s->pos_in_central_dir;
@@ -1501,7 +1816,8 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
     if (pfile_in_zip_read_info==NULL)
         return UNZ_INTERNALERROR;
 
-    pfile_in_zip_read_info->read_buffer=(char*)ALLOC(UNZ_BUFSIZE);
+    pfile_in_zip_read_info->read_buffer_size=s->read_buffer_size;
+    pfile_in_zip_read_info->read_buffer=(char*)ALLOC(s->read_buffer_size);
     pfile_in_zip_read_info->offset_local_extrafield = offset_local_extrafield;
     pfile_in_zip_read_info->size_local_extrafield = size_local_extrafield;
     pfile_in_zip_read_info->pos_local_extrafield=0;
@@ -1673,6 +1989,88 @@ extern ZPOS64_T ZEXPORT unzGetCurrentFileZStreamPos64( unzFile file)
 
 /** Addition for GDAL : END */
 
+extern int ZEXPORT unzGetCurrentFileMapping (unzFile file, const void** buf, ZPOS64_T* len)
+{
+    unz64_s* s;
+    file_in_zip64_read_info_s* pfile_in_zip_read_info;
+    const void* base;
+    ZPOS64_T size;
+    ZPOS64_T pos;
+
+    if ((file==NULL) || (buf==NULL) || (len==NULL))
+        return UNZ_PARAMERROR;
+    s=(unz64_s*)file;
+    pfile_in_zip_read_info=s->pfile_in_zip_read;
+    if (pfile_in_zip_read_info==NULL)
+        return UNZ_PARAMERROR;
+
+    /* only the bytes of the file as they are in the zipfile */
+    if (((pfile_in_zip_read_info->compression_method!=0) && (!pfile_in_zip_read_info->raw)) ||
+        (s->encrypted))
+        return UNZ_PARAMERROR;
+
+    if (call_zmapping64(&pfile_in_zip_read_info->z_filefunc,
+                        pfile_in_zip_read_info->filestream,&base,&size)!=0)
+        return UNZ_PARAMERROR;
+
+    pos = pfile_in_zip_read_info->pos_in_zipfile +
+          pfile_in_zip_read_info->byte_before_the_zipfile;
+    if ((pos > size) || (pfile_in_zip_read_info->rest_read_compressed > size - pos))
+        return UNZ_BADZIPFILE;
+
+    *buf = (const unsigned char*)base + pos;
+    *len = pfile_in_zip_read_info->rest_read_compressed;
+    return UNZ_OK;
+}
+
+/*
+  Read the next compressed bytes of the current file in its read buffer,
+  once the previous ones are used.
+*/
+local int unz64local_FillReadBuffer OF((unz64_s* s));
+local int unz64local_FillReadBuffer (unz64_s* s)
+{
+    file_in_zip64_read_info_s* pfile_in_zip_read_info=s->pfile_in_zip_read;
+    uInt uReadThis = pfile_in_zip_read_info->read_buffer_size;
+    if (pfile_in_zip_read_info->rest_read_compressed<uReadThis)
+        uReadThis = (uInt)pfile_in_zip_read_info->rest_read_compressed;
+    if (uReadThis == 0)
+        return UNZ_EOF;
+    if (ZSEEK64(pfile_in_zip_read_info->z_filefunc,
+              pfile_in_zip_read_info->filestream,
+              pfile_in_zip_read_info->pos_in_zipfile +
+                 pfile_in_zip_read_info->byte_before_the_zipfile,
+                 ZLIB_FILEFUNC_SEEK_SET)!=0)
+        return UNZ_ERRNO;
+    if (ZREAD64(pfile_in_zip_read_info->z_filefunc,
+              pfile_in_zip_read_info->filestream,
+              pfile_in_zip_read_info->read_buffer,
+              uReadThis)!=uReadThis)
+        return UNZ_ERRNO;
+
+
+#    ifndef NOUNCRYPT
+    if(s->encrypted)
+    {
+        uInt i;
+        for(i=0;i<uReadThis;i++)
+          pfile_in_zip_read_info->read_buffer[i] =
+              zdecode(s->keys,s->pcrc_32_tab,
+                      pfile_in_zip_read_info->read_buffer[i]);
+    }
+#    endif
+
+
+    pfile_in_zip_read_info->pos_in_zipfile += uReadThis;
+
+    pfile_in_zip_read_info->rest_read_compressed-=uReadThis;
+
+    pfile_in_zip_read_info->stream.next_in =
+        (Bytef*)pfile_in_zip_read_info->read_buffer;
+    pfile_in_zip_read_info->stream.avail_in = (uInt)uReadThis;
+    return UNZ_OK;
+}
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1724,43 +2122,9 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
         if ((pfile_in_zip_read_info->stream.avail_in==0) &&
             (pfile_in_zip_read_info->rest_read_compressed>0))
         {
-            uInt uReadThis = UNZ_BUFSIZE;
-            if (pfile_in_zip_read_info->rest_read_compressed<uReadThis)
-                uReadThis = (uInt)pfile_in_zip_read_info->rest_read_compressed;
-            if (uReadThis == 0)
-                return UNZ_EOF;
-            if (ZSEEK64(pfile_in_zip_read_info->z_filefunc,
-                      pfile_in_zip_read_info->filestream,
-                      pfile_in_zip_read_info->pos_in_zipfile +
-                         pfile_in_zip_read_info->byte_before_the_zipfile,
-                         ZLIB_FILEFUNC_SEEK_SET)!=0)
-                return UNZ_ERRNO;
-            if (ZREAD64(pfile_in_zip_read_info->z_filefunc,
-                      pfile_in_zip_read_info->filestream,
-                      pfile_in_zip_read_info->read_buffer,
-                      uReadThis)!=uReadThis)
-                return UNZ_ERRNO;
-
-
-#            ifndef NOUNCRYPT
-            if(s->encrypted)
-            {
-                uInt i;
-                for(i=0;i<uReadThis;i++)
-                  pfile_in_zip_read_info->read_buffer[i] =
-                      zdecode(s->keys,s->pcrc_32_tab,
-                              pfile_in_zip_read_info->read_buffer[i]);
-            }
-#            endif
-
-
-            pfile_in_zip_read_info->pos_in_zipfile += uReadThis;
-
-            pfile_in_zip_read_info->rest_read_compressed-=uReadThis;
-
-            pfile_in_zip_read_info->stream.next_in =
-                (Bytef*)pfile_in_zip_read_info->read_buffer;
-            pfile_in_zip_read_info->stream.avail_in = (uInt)uReadThis;
+            err = unz64local_FillReadBuffer(s);
+            if (err!=UNZ_OK)
+                return err;
         }
 
         if ((pfile_in_zip_read_info->compression_method==0) || (pfile_in_zip_read_info->raw))
@@ -1888,6 +2252,94 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
 }
 
 
+extern int ZEXPORT unzSetReadBufferSize (unzFile file, uInt size)
+{
+    unz64_s* s;
+    if (file==NULL)
+        return UNZ_PARAMERROR;
+    s=(unz64_s*)file;
+    s->read_buffer_size = (size==0) ? UNZ_BUFSIZE : size;
+    return UNZ_OK;
+}
+
+/*
+  Give all the bytes left in the current file to sink. The bytes of a stored
+  file go from the read buffer to sink; the others are decompressed in a
+  buffer of the size of the read buffer.
+*/
+extern int ZEXPORT unzReadCurrentFileToSink (unzFile file, unz_sink_func sink, voidpf opaque)
+{
+    unz64_s* s;
+    file_in_zip64_read_info_s* pfile_in_zip_read_info;
+    Bytef* buf;
+    int err=UNZ_OK;
+
+    if ((file==NULL) || (sink==NULL))
+        return UNZ_PARAMERROR;
+    s=(unz64_s*)file;
+    pfile_in_zip_read_info=s->pfile_in_zip_read;
+    if (pfile_in_zip_read_info==NULL)
+        return UNZ_PARAMERROR;
+    if (pfile_in_zip_read_info->read_buffer == NULL)
+        return UNZ_END_OF_LIST_OF_FILE;
+
+    if ((pfile_in_zip_read_info->compression_method==0) || (pfile_in_zip_read_info->raw))
+    {
+        for (;;)
+        {
+            uInt uDoCopy;
+            if ((pfile_in_zip_read_info->stream.avail_in==0) &&
+                (pfile_in_zip_read_info->rest_read_compressed>0))
+            {
+                err = unz64local_FillReadBuffer(s);
+                if (err!=UNZ_OK)
+                    return err;
+            }
+
+            uDoCopy = pfile_in_zip_read_info->stream.avail_in;
+            if (uDoCopy==0)
+                return UNZ_OK;
+            if ((!pfile_in_zip_read_info->raw) &&
+                (uDoCopy>pfile_in_zip_read_info->rest_read_uncompressed))
+                uDoCopy = (uInt)pfile_in_zip_read_info->rest_read_uncompressed;
+            if (uDoCopy==0)
+                return UNZ_OK;
+
+            pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uDoCopy;
+            pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,
+                                pfile_in_zip_read_info->stream.next_in,
+                                uDoCopy);
+            pfile_in_zip_read_info->rest_read_uncompressed-=uDoCopy;
+            pfile_in_zip_read_info->stream.avail_in -= uDoCopy;
+            pfile_in_zip_read_info->stream.next_in += uDoCopy;
+            pfile_in_zip_read_info->stream.total_out += uDoCopy;
+
+            if ((*sink)(opaque,pfile_in_zip_read_info->stream.next_in-uDoCopy,uDoCopy)!=0)
+                return UNZ_ERRNO;
+        }
+    }
+
+    buf = (Bytef*)ALLOC(pfile_in_zip_read_info->read_buffer_size);
+    if (buf==NULL)
+        return UNZ_INTERNALERROR;
+    for (;;)
+    {
+        int iRead = unzReadCurrentFile(file,buf,pfile_in_zip_read_info->read_buffer_size);
+        if (iRead<=0)
+        {
+            err = iRead;
+            break;
+        }
+        if ((*sink)(opaque,buf,(uInt)iRead)!=0)
+        {
+            err = UNZ_ERRNO;
+            break;
+        }
+    }
+    TRYFREE(buf);
+    return err;
+}
+
 /*
   Give the current position in uncompressed data
 */
@@ -2032,7 +2484,7 @@ extern int ZEXPORT unzCloseCurrentFile (unzFile file)
     TRYFREE(pfile_in_zip_read_info->read_buffer);
     pfile_in_zip_read_info->read_buffer = NULL;
     if (pfile_in_zip_read_info->stream_initialised == Z_DEFLATED)
-        inflateEnd(&pfile_in_zip_read_info->stream);
+        inflateRelease(&pfile_in_zip_read_info->stream);
 #ifdef HAVE_BZIP2
     else if (pfile_in_zip_read_info->stream_initialised == Z_BZIP2ED)
         BZ2_bzDecompressEnd(&pfile_in_zip_read_info->bstream);
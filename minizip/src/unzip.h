@@ -195,6 +195,12 @@ extern unzFile ZEXPORT unzOpen2_64 OF((const void *path,
       for read/write the zip file (see ioapi.h)
 */
 
+extern unzFile ZEXPORT unzOpenMemory OF((const void *buf, ZPOS64_T size));
+/*
+   Open a Zip file which is in memory. buf is not copied, it must stay valid
+     until unzClose.
+*/
+
 extern int ZEXPORT unzClose OF((unzFile file));
 /*
   Close a ZipFile opened with unzOpen.
@@ -283,6 +289,31 @@ extern int ZEXPORT unzGoToFilePos64(
     unzFile file,
     const unz64_file_pos* file_pos);
 
+extern int ZEXPORT unzBuildFileIndex OF((unzFile file));
+/*
+  Read the central directory at once and index the file names, best right
+  after unzOpen. Then unzLocateFile finds a file without walking the
+  directory. The index lives until unzClose. Define UNZ_FILE_INDEX_ON_OPEN
+  to build it in every unzOpen.
+  return UNZ_OK if there is no problem, the archive is usable without the
+    index otherwise
+*/
+
+extern int ZEXPORT unzLocateFilePos64 OF((unzFile file,
+                     const char *szFileName,
+                     int iCaseSensitivity,
+                     unz64_file_pos* file_pos));
+/*
+  Find the file szFileName like unzLocateFile, through the index, which is
+  built on the first call, or by walking the directory if the index cannot
+  be built. The current file does not change, go to the
+  file with unzGoToFilePos64.
+
+  return value :
+  UNZ_OK if the file is found, its position is in *file_pos
+  UNZ_END_OF_LIST_OF_FILE if the file is not found
+*/
+
 /* ****************************************** */
 
 extern int ZEXPORT unzGetCurrentFileInfo64 OF((unzFile file,
@@ -390,6 +421,41 @@ extern int ZEXPORT unzReadCurrentFile OF((unzFile file,
     (UNZ_ERRNO for IO error, or zLib error for uncompress error)
 */
 
+extern int ZEXPORT unzSetReadBufferSize OF((unzFile file, uInt size));
+/*
+  Set the size of the buffer the compressed bytes are read in, for the
+  files opened next, UNZ_BUFSIZE (16384) with size 0. A large one means
+  fewer and larger reads of the zipfile.
+*/
+
+typedef int (*unz_sink_func) OF((voidpf opaque, const void* buf, uInt len));
+
+extern int ZEXPORT unzReadCurrentFileToSink OF((unzFile file,
+                      unz_sink_func sink,
+                      voidpf opaque));
+/*
+  Read all the bytes left in the current file (opened by unzOpenCurrentFile)
+  and give them to sink, in pieces of at most the read buffer size, instead
+  of copying them in a buffer of the caller. sink returns 0 to go on.
+  The crc is checked by unzCloseCurrentFile, as after unzReadCurrentFile.
+
+  return UNZ_OK once the end of the file is reached, UNZ_ERRNO if sink
+    fails, or the error of unzReadCurrentFile
+*/
+
+extern int ZEXPORT unzGetCurrentFileMapping OF((unzFile file,
+                      const void** buf,
+                      ZPOS64_T* len));
+/*
+  Get the bytes of the current file (opened by unzOpenCurrentFile) which are
+  not read yet, in the mapping of a zipfile opened with fill_mmap_filefunc64,
+  without copying them. The file must be stored (compression method 0) or
+  opened raw, and not crypted. The crc is not checked and the read position
+  does not move. *buf is valid until unzClose.
+
+  return UNZ_OK, or UNZ_PARAMERROR if the file cannot be read this way
+*/
+
 extern z_off_t ZEXPORT unztell OF((unzFile file));
 
 extern ZPOS64_T ZEXPORT unztell64 OF((unzFile file));
@@ -105,6 +105,7 @@ const char zip_copyright[] =" zip 1.01 Copyright 1998-2004 Gilles Vollant - http
 #define ENDHEADERMAGIC      (0x06054b50)
 #define ZIP64ENDHEADERMAGIC      (0x6064b50)
 #define ZIP64ENDLOCHEADERMAGIC   (0x7064b50)
+#define DATADESCRIPTORMAGIC (0x08074b50)
 
 #define FLAG_LOCALHEADER_OFFSET (0x06)
 #define CRC_LOCALHEADER_OFFSET  (0x0e)
@@ -178,6 +179,9 @@ typedef struct
     char *globalcomment;
 #endif
 
+    int  streaming;             /* 1 if opened with APPEND_STATUS_STREAM */
+    zlib_filefunc64_32_def stream_func; /* backend below the streaming functions */
+    ZPOS64_T stream_pos;        /* bytes written when streaming */
 } zip64_internal;
 
 
@@ -845,6 +849,51 @@ local int LoadCentralDirectoryRecord(zip64_internal* pziinit)
 #endif /* !NO_ADDFILEINEXISTINGZIP*/
 
 
+/* The functions of a zipfile opened with APPEND_STATUS_STREAM. Writes go to
+   the backend and are counted, so that the position is known without asking
+   the backend, and a seek is an error. The opaque is the zip64_internal. */
+local uLong ZCALLBACK zip64local_stream_read(voidpf opaque, voidpf stream, void* buf, uLong size)
+{
+    (void)opaque;
+    (void)stream;
+    (void)buf;
+    (void)size;
+    return 0;
+}
+
+local uLong ZCALLBACK zip64local_stream_write(voidpf opaque, voidpf stream, const void* buf, uLong size)
+{
+    zip64_internal* zi = (zip64_internal*)opaque;
+    uLong written = ZWRITE64(zi->stream_func, stream, buf, size);
+    zi->stream_pos += written;
+    return written;
+}
+
+local ZPOS64_T ZCALLBACK zip64local_stream_tell(voidpf opaque, voidpf stream)
+{
+    (void)stream;
+    return ((zip64_internal*)opaque)->stream_pos;
+}
+
+local long ZCALLBACK zip64local_stream_seek(voidpf opaque, voidpf stream, ZPOS64_T offset, int origin)
+{
+    (void)opaque;
+    (void)stream;
+    (void)offset;
+    (void)origin;
+    return -1;
+}
+
+local int ZCALLBACK zip64local_stream_close(voidpf opaque, voidpf stream)
+{
+    return ZCLOSE64(((zip64_internal*)opaque)->stream_func, stream);
+}
+
+local int ZCALLBACK zip64local_stream_error(voidpf opaque, voidpf stream)
+{
+    return ZERROR64(((zip64_internal*)opaque)->stream_func, stream);
+}
+
 /************************************************************/
 extern zipFile ZEXPORT zipOpen3 (const void *pathname, int append, zipcharpc* globalcomment, zlib_filefunc64_32_def* pzlib_filefunc64_32_def)
 {
@@ -859,8 +908,13 @@ extern zipFile ZEXPORT zipOpen3 (const void *pathname, int append, zipcharpc* gl
     else
         ziinit.z_filefunc = *pzlib_filefunc64_32_def;
 
+    ziinit.streaming = (append == APPEND_STATUS_STREAM);
+    ziinit.stream_pos = 0;
+
     ziinit.filestream = ZOPEN64(ziinit.z_filefunc,
                   pathname,
+                  ziinit.streaming ?
+                  (ZLIB_FILEFUNC_MODE_WRITE | ZLIB_FILEFUNC_MODE_CREATE) :
                   (append == APPEND_STATUS_CREATE) ?
                   (ZLIB_FILEFUNC_MODE_READ | ZLIB_FILEFUNC_MODE_WRITE | ZLIB_FILEFUNC_MODE_CREATE) :
                     (ZLIB_FILEFUNC_MODE_READ | ZLIB_FILEFUNC_MODE_WRITE | ZLIB_FILEFUNC_MODE_EXISTING));
@@ -871,7 +925,10 @@ extern zipFile ZEXPORT zipOpen3 (const void *pathname, int append, zipcharpc* gl
     if (append == APPEND_STATUS_CREATEAFTER)
         ZSEEK64(ziinit.z_filefunc,ziinit.filestream,0,SEEK_END);
 
-    ziinit.begin_pos = ZTELL64(ziinit.z_filefunc,ziinit.filestream);
+    if (ziinit.streaming)
+        ziinit.begin_pos = 0;
+    else
+        ziinit.begin_pos = ZTELL64(ziinit.z_filefunc,ziinit.filestream);
     ziinit.in_opened_file_inzip = 0;
     ziinit.ci.stream_initialised = 0;
     ziinit.number_entry = 0;
@@ -913,6 +970,22 @@ extern zipFile ZEXPORT zipOpen3 (const void *pathname, int append, zipcharpc* gl
     else
     {
         *zi = ziinit;
+        if (zi->streaming)
+        {
+            /* from now on, go through the counting functions */
+            zi->stream_func = zi->z_filefunc;
+            zi->z_filefunc.zfile_func64.zopen64_file = NULL;
+            zi->z_filefunc.zfile_func64.zread_file = zip64local_stream_read;
+            zi->z_filefunc.zfile_func64.zwrite_file = zip64local_stream_write;
+            zi->z_filefunc.zfile_func64.ztell64_file = zip64local_stream_tell;
+            zi->z_filefunc.zfile_func64.zseek64_file = zip64local_stream_seek;
+            zi->z_filefunc.zfile_func64.zclose_file = zip64local_stream_close;
+            zi->z_filefunc.zfile_func64.zerror_file = zip64local_stream_error;
+            zi->z_filefunc.zfile_func64.opaque = zi;
+            zi->z_filefunc.zopen32_file = NULL;
+            zi->z_filefunc.ztell32_file = NULL;
+            zi->z_filefunc.zseek32_file = NULL;
+        }
         return (zipFile)zi;
     }
 }
@@ -955,6 +1028,15 @@ extern zipFile ZEXPORT zipOpen64 (const void* pathname, int append)
     return zipOpen3(pathname,append,NULL,NULL);
 }
 
+extern zipFile ZEXPORT zipOpenMemory (zlib_mem_buffer* buffer, int append)
+{
+    zlib_filefunc64_def zlib_filefunc_def;
+    if (buffer == NULL)
+        return NULL;
+    fill_memory_filefunc64(&zlib_filefunc_def);
+    return zipOpen2_64(buffer,append,NULL,&zlib_filefunc_def);
+}
+
 local int Write_LocalFileHeader(zip64_internal* zi, const char* filename, uInt size_extrafield_local, const void* extrafield_local)
 {
   /* write the local header */
@@ -1121,6 +1203,13 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
       zi->ci.flag |= 6;
     if (password != NULL)
       zi->ci.flag |= 1;
+    if (zi->streaming)
+    {
+      /* the crc is not known yet, it follows the data in a data descriptor,
+         and the check byte of the encryption header is the time instead */
+      zi->ci.flag |= 8;
+      crcForCrypting = (zi->ci.dosDate & 0xffff) << 16;
+    }
 
     zi->ci.crc32 = 0;
     zi->ci.method = method;
@@ -1577,7 +1666,7 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
 
     if ((zi->ci.method == Z_DEFLATED) && (!zi->ci.raw))
     {
-        int tmp_err = deflateEnd(&zi->ci.stream);
+        int tmp_err = deflateRelease(&zi->ci.stream);
         if (err == ZIP_OK)
             err = tmp_err;
         zi->ci.stream_initialised = 0;
@@ -1694,7 +1783,35 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
 
     free(zi->ci.central_header);
 
-    if (err==ZIP_OK)
+    if ((err==ZIP_OK) && (zi->streaming))
+    {
+        // Write the data descriptor, the local header can not be updated.
+        err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)DATADESCRIPTORMAGIC,4);
+
+        if (err==ZIP_OK)
+            err = zip64local_putValue(&zi->z_filefunc,zi->filestream,crc32,4);
+
+        if (zi->ci.pos_zip64extrainfo > 0)
+        {
+          // The local header has a ZIP64 extended field, the sizes are 8 bytes.
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,compressed_size,8);
+
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,uncompressed_size,8);
+        }
+        else if(uncompressed_size >= 0xffffffff || compressed_size >= 0xffffffff )
+            err = ZIP_BADZIPFILE; // Caller passed zip64 = 0, so no room for zip64 info -> fatal
+        else
+        {
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,compressed_size,4);
+
+          if (err==ZIP_OK)
+              err = zip64local_putValue(&zi->z_filefunc,zi->filestream,uncompressed_size,4);
+        }
+    }
+    else if (err==ZIP_OK)
     {
         // Update the LocalFileHeader with the new values.
 
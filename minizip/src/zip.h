@@ -112,6 +112,7 @@ typedef const char* zipcharpc;
 #define APPEND_STATUS_CREATE        (0)
 #define APPEND_STATUS_CREATEAFTER   (1)
 #define APPEND_STATUS_ADDINZIP      (2)
+#define APPEND_STATUS_STREAM        (3)
 
 extern zipFile ZEXPORT zipOpen OF((const char *pathname, int append));
 extern zipFile ZEXPORT zipOpen64 OF((const void *pathname, int append));
@@ -124,6 +125,12 @@ extern zipFile ZEXPORT zipOpen64 OF((const void *pathname, int append));
          (useful if the file contain a self extractor code)
      if the file pathname exist and append==APPEND_STATUS_ADDINZIP, we will
        add files in existing zip (be sure you don't add file that doesn't exist)
+     if append==APPEND_STATUS_STREAM, the zip is created and written front to
+       back without ever seeking or asking for the position, so that the
+       backend may write to a pipe or a socket. The crc and the sizes of each
+       file follow its data in a data descriptor (bit 3 of the flag) instead
+       of being written back into its local header. A file larger than 4 GB
+       must be opened with zip64=1, as the sizes are not known in advance.
      If the zipfile cannot be opened, the return value is NULL.
      Else, the return value is a zipFile Handle, usable with other function
        of this zip package.
@@ -149,6 +156,13 @@ extern zipFile ZEXPORT zipOpen3 OF((const void *pathname,
                                     zipcharpc* globalcomment,
                                     zlib_filefunc64_32_def* pzlib_filefunc64_32_def));
 
+extern zipFile ZEXPORT zipOpenMemory OF((zlib_mem_buffer* buffer, int append));
+/*
+  Create a zipfile in buffer, or add to the zipfile in it with append, like
+    zipOpen (see fill_memory_filefunc64 in ioapi.h). After zipClose, the
+    archive is in buffer->base and buffer->size, free buffer->base.
+*/
+
 extern int ZEXPORT zipOpenNewFileInZip OF((zipFile file,
                        const char* filename,
                        const zip_fileinfo* zipfi,
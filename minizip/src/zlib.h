@@ -197,6 +197,7 @@ typedef gz_header FAR *gz_headerp;
 #define Z_HUFFMAN_ONLY        2
 #define Z_RLE                 3
 #define Z_FIXED               4
+#define Z_QUICK               5
 #define Z_DEFAULT_STRATEGY    0
 /* compression strategy; see deflateInit2() below for details */
 
@@ -598,7 +599,12 @@ ZEXTERN int ZEXPORT deflateInit2 OF((z_streamp strm,
    strategy parameter only affects the compression ratio but not the
    correctness of the compressed output even if it is not set appropriately.
    Z_FIXED prevents the use of dynamic Huffman codes, allowing for a simpler
-   decoder for special applications.
+   decoder for special applications.  Z_QUICK is faster than level 1, at some
+   cost in compression: it takes the most recent match candidate without
+   comparing it to others or to the match at the next byte, and uses fixed
+   Huffman codes.  It suits data that is compressed for speed rather than
+   size, such as temporary files and caches, and does the same at any level
+   other than zero.
 
      deflateInit2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
    memory, Z_STREAM_ERROR if any parameter is invalid (such as an invalid
@@ -703,6 +709,21 @@ ZEXTERN int ZEXPORT deflateReset OF((z_streamp strm));
    stream state was inconsistent (such as zalloc or state being Z_NULL).
 */
 
+ZEXTERN int ZEXPORT deflateRelease OF((z_streamp strm));
+/*
+     This function is the same as deflateEnd, except that the internal
+   compression state and its buffers are kept in a pool instead of being
+   freed, when the stream uses the default zalloc and zfree.  A later
+   deflateInit2() with the same windowBits and memLevel (the wrapper and level
+   may differ) takes the state from the pool, avoiding the allocation of the
+   window, hash, and pending buffers.  This saves time when many small streams
+   are compressed one after another, as for the entries of a zip file.  The
+   pool is shared by all threads, holds a small number of states, and falls
+   back to deflateEnd when full.  zlibPoolFree() frees the pooled states.
+
+     deflateRelease returns the same values as deflateEnd.
+*/
+
 ZEXTERN int ZEXPORT deflateParams OF((z_streamp strm,
                                       int level,
                                       int strategy));
@@ -978,6 +999,16 @@ ZEXTERN int ZEXPORT inflateReset2 OF((z_streamp strm,
    the windowBits parameter is invalid.
 */
 
+ZEXTERN int ZEXPORT inflateRelease OF((z_streamp strm));
+/*
+     This function is the same as inflateEnd, except that the internal
+   decompression state and its window are kept in a pool for a later
+   inflateInit2(), when the stream uses the default zalloc and zfree.  See
+   deflateRelease() for the pool.
+
+     inflateRelease returns the same values as inflateEnd.
+*/
+
 ZEXTERN int ZEXPORT inflatePrime OF((z_streamp strm,
                                      int bits,
                                      int value));
@@ -1171,6 +1202,15 @@ ZEXTERN int ZEXPORT inflateBackEnd OF((z_streamp strm));
    state was inconsistent.
 */
 
+ZEXTERN void ZEXPORT zlibPoolFree OF((void));
+/*
+     Free all of the states kept by deflateRelease() and inflateRelease().  This
+   can be called at any time, for example at the end of a batch of streams or
+   before the application exits, and is safe to call while other threads use
+   zlib.  Without thread support in the build, the Release functions do not
+   pool and zlibPoolFree() does nothing.
+*/
+
 ZEXTERN uLong ZEXPORT zlibCompileFlags OF((void));
 /* Return flags indicating compile-time options.
 
@@ -1305,11 +1345,11 @@ ZEXTERN gzFile ZEXPORT gzopen OF((const char *path, const char *mode));
      Opens a gzip (.gz) file for reading or writing.  The mode parameter is as
    in fopen ("rb" or "wb") but can also include a compression level ("wb9") or
    a strategy: 'f' for filtered data as in "wb6f", 'h' for Huffman-only
-   compression as in "wb1h", 'R' for run-length encoding as in "wb1R", or 'F'
-   for fixed code compression as in "wb9F".  (See the description of
-   deflateInit2 for more information about the strategy parameter.)  'T' will
-   request transparent writing or appending with no compression and not using
-   the gzip format.
+   compression as in "wb1h", 'R' for run-length encoding as in "wb1R", 'F' for
+   fixed code compression as in "wb9F", or 'Q' for quick compression as in
+   "wbQ".  (See the description of deflateInit2 for more information about the
+   strategy parameter.)  'T' will request transparent writing or appending with
+   no compression and not using the gzip format.
 
      "a" can be used instead of "w" to request that the gzip stream that will
    be written be appended to the file.  "+" will result in an error, since
@@ -38,6 +38,14 @@ extern "C" {
 #define DEFAULT_ERK_6           VERNER_8_5_6
 #define DEFAULT_ERK_8           FEHLBERG_13_7_8
 
+/* Low-storage (2N) methods for ERKStepSetLowStorageMethod */
+
+#define LSRK_WILLIAMSON_3_2_3          0
+#define LSRK_CARPENTER_KENNEDY_5_3_4   1
+
+#define MIN_LSRK_NUM  0
+#define MAX_LSRK_NUM  1
+
 
 /* -------------------
  * Exported Functions
@@ -81,6 +89,7 @@ SUNDIALS_EXPORT int ERKStepSetDenseOrder(void *arkode_mem, int dord);
 SUNDIALS_EXPORT int ERKStepSetTable(void *arkode_mem,
                                     ARKodeButcherTable B);
 SUNDIALS_EXPORT int ERKStepSetTableNum(void *arkode_mem, int itable);
+SUNDIALS_EXPORT int ERKStepSetLowStorageMethod(void *arkode_mem, int lsnum);
 SUNDIALS_EXPORT int ERKStepSetCFLFraction(void *arkode_mem,
                                           realtype cfl_frac);
 SUNDIALS_EXPORT int ERKStepSetSafetyFactor(void *arkode_mem,
@@ -47,10 +47,11 @@ typedef enum {
 #define MRI_GARK_ERK45a    201
 #define MRI_GARK_IRK21a    202
 #define MRI_GARK_ESDIRK34a 203
+#define MRI_GARK_ERK33a    204
 
 /* Utility #defines to ensure valid input IDs for MRI tables */
 #define MIN_MRI_NUM        200
-#define MAX_MRI_NUM        203
+#define MAX_MRI_NUM        204
 
 /* Default MRI coupling tables for each order */
 #define DEFAULT_MRI_TABLE_3           MIS_KW3     /* backwards-compatibility */
@@ -122,6 +123,14 @@ SUNDIALS_EXPORT void* MRIStepCreate(ARKRhsFn fs, realtype t0, N_Vector y0,
                                     MRISTEP_ID inner_step_id,
                                     void* inner_step_mem);
 
+/* Multirate driver for a fast/slow partitioned ODE: fs is the slow
+   RHS, ffe and ffi the explicit and implicit parts of the fast RHS
+   (either may be NULL). The fast ARKStep integrator is created and
+   owned by MRIStep, use MRIStepGetInnerStepper to configure it. */
+SUNDIALS_EXPORT void* MRIStepCreateFastSlow(ARKRhsFn fs, ARKRhsFn ffe,
+                                            ARKRhsFn ffi, realtype t0,
+                                            N_Vector y0);
+
 SUNDIALS_EXPORT int MRIStepResize(void *arkode_mem, N_Vector ynew,
                                   realtype t0, ARKVecResizeFn resize,
                                   void *resize_data);
@@ -272,6 +281,8 @@ SUNDIALS_EXPORT int MRIStepGetNumGEvals(void *arkode_mem,
 SUNDIALS_EXPORT int MRIStepGetRootInfo(void *arkode_mem,
                                        int *rootsfound);
 SUNDIALS_EXPORT int MRIStepGetLastInnerStepFlag(void *arkode_mem, int *flag);
+SUNDIALS_EXPORT int MRIStepGetInnerStepper(void *arkode_mem,
+                                           void **inner_arkode_mem);
 
 SUNDIALS_EXPORT char *MRIStepGetReturnFlagName(long int flag);
 
@@ -0,0 +1,130 @@
+/* -----------------------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------------------
+ * This is the header file for the ARKODE parallel-in-time (Parareal) driver.
+ *
+ * The interval [t0, tf] is split into nslices time slices. A coarse ARKStep
+ * integrator (fixed step) gives a first guess at the slice interfaces, fine
+ * ARKStep integrators then solve all slices concurrently on threads and the
+ * coarse integrator propagates the fine corrections serially:
+ *
+ *   U_{n+1}^{k+1} = G(U_n^{k+1}) + F(U_n^k) - G(U_n^k)
+ *
+ * This is two-level MGRIT with F-relaxation, the same iteration the ARKBraid
+ * interface runs through XBraid with two levels, but on shared memory and
+ * without MPI. After k iterations the first k slices equal the serial fine
+ * solution, so at most nslices iterations are needed.
+ * ---------------------------------------------------------------------------*/
+
+#ifndef _ARKODE_PARAREAL_H
+#define _ARKODE_PARAREAL_H
+
+#include <sundials/sundials_nvector.h>
+#include <arkode/arkode.h>
+#include <arkode/arkode_arkstep.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+
+/* ---------------------------
+ * ARKParareal Constants
+ * --------------------------- */
+
+
+#define ARKPR_DEFAULT_COARSE_STEPS 1
+#define ARKPR_DEFAULT_RTOL         RCONST(1.0e-6)
+#define ARKPR_DEFAULT_ATOL         RCONST(1.0e-9)
+
+
+/* ---------------------------
+ * ARKParareal Function Types
+ * --------------------------- */
+
+
+/* Creates and configures an ARKStep integrator (RHS functions, method, linear
+   solver, user data, fixed step or tolerances) starting at (t0, y0). It is
+   called once for the coarse integrator (coarse = SUNTRUE) and once per
+   thread for the fine integrators. Fine integrators run concurrently, so
+   their RHS functions must not share writable user data. Return NULL on
+   failure. */
+typedef void* (*ARKPararealCreateFn)(realtype t0, N_Vector y0,
+                                     booleantype coarse, void *user_data);
+
+/* Frees an integrator made by the create function together with anything
+   attached to it (matrices, linear solvers). If not given, ARKStepFree is
+   called. */
+typedef void (*ARKPararealFreeFn)(void **arkode_mem, void *user_data);
+
+
+/* -------------------------------
+ * Construct, initialize, and free
+ * ------------------------------- */
+
+
+SUNDIALS_EXPORT void* ARKParareal_Create(ARKPararealCreateFn create,
+                                         ARKPararealFreeFn free_fn,
+                                         void *user_data, realtype t0,
+                                         realtype tf, N_Vector y0,
+                                         int nslices);
+
+SUNDIALS_EXPORT void ARKParareal_Free(void **pr_mem);
+
+
+/* -------------------------
+ * ARKParareal Set Functions
+ * ------------------------- */
+
+
+SUNDIALS_EXPORT int ARKParareal_SetNumThreads(void *pr_mem, int nthreads);
+
+SUNDIALS_EXPORT int ARKParareal_SetMaxIters(void *pr_mem, int maxiters);
+
+SUNDIALS_EXPORT int ARKParareal_SetCoarseSteps(void *pr_mem, int nsteps);
+
+SUNDIALS_EXPORT int ARKParareal_SetTolerances(void *pr_mem, realtype rtol,
+                                              realtype atol);
+
+
+/* -------------------
+ * ARKParareal Solve
+ * ------------------- */
+
+
+SUNDIALS_EXPORT int ARKParareal_Evolve(void *pr_mem, N_Vector yout);
+
+
+/* -------------------------
+ * ARKParareal Get Functions
+ * ------------------------- */
+
+
+SUNDIALS_EXPORT int ARKParareal_GetNumIterations(void *pr_mem, int *niters);
+
+SUNDIALS_EXPORT int ARKParareal_GetCorrectionNorms(void *pr_mem,
+                                                   realtype *norms);
+
+SUNDIALS_EXPORT int ARKParareal_GetNumSteps(void *pr_mem, long int *nfine,
+                                            long int *ncoarse);
+
+SUNDIALS_EXPORT int ARKParareal_GetSliceSolution(void *pr_mem, int n,
+                                                 realtype *t, N_Vector y);
+
+SUNDIALS_EXPORT int ARKParareal_GetLastARKStepFlag(void *pr_mem,
+                                                   int *last_flag);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <sundials/sundials_nvector.h>
 #include <sundials/sundials_nonlinearsolver.h>
+#include <sundials/sundials_profiler.h>
 #include <cvode/cvode_ls.h>
 #include <cvode/cvode_proj.h>
 
@@ -40,6 +41,10 @@ extern "C" {
 #define CV_NORMAL         1
 #define CV_ONE_STEP       2
 
+/* ensemble layout */
+#define CV_ENSEMBLE_BLOCKED      0
+#define CV_ENSEMBLE_INTERLEAVED  1
+
 
 /* return values */
 
@@ -94,6 +99,10 @@ typedef int (*CVRhsFn)(realtype t, N_Vector y,
 typedef int (*CVRootFn)(realtype t, N_Vector y, realtype *gout,
                         void *user_data);
 
+typedef int (*CVRootChangedFn)(realtype t, N_Vector y, realtype *gout,
+                               int *nchanged, int *ichanged,
+                               void *user_data);
+
 typedef int (*CVEwtFn)(N_Vector y, N_Vector ewt, void *user_data);
 
 typedef void (*CVErrHandlerFn)(int error_code,
@@ -127,6 +136,7 @@ SUNDIALS_EXPORT int CVodeSetErrFile(void *cvode_mem, FILE *errfp);
 SUNDIALS_EXPORT int CVodeSetUserData(void *cvode_mem, void *user_data);
 SUNDIALS_EXPORT int CVodeSetMonitorFn(void *cvode_mem, CVMonitorFn fn);
 SUNDIALS_EXPORT int CVodeSetMonitorFrequency(void *cvode_mem, long int nst);
+SUNDIALS_EXPORT int CVodeSetProfiler(void *cvode_mem, SUNProfiler profiler);
 SUNDIALS_EXPORT int CVodeSetMaxOrd(void *cvode_mem, int maxord);
 SUNDIALS_EXPORT int CVodeSetMaxNumSteps(void *cvode_mem, long int mxsteps);
 SUNDIALS_EXPORT int CVodeSetMaxHnilWarns(void *cvode_mem, int mxhnil);
@@ -144,6 +154,11 @@ SUNDIALS_EXPORT int CVodeSetConstraints(void *cvode_mem, N_Vector constraints);
 SUNDIALS_EXPORT int CVodeSetNonlinearSolver(void *cvode_mem,
                                             SUNNonlinearSolver NLS);
 SUNDIALS_EXPORT int CVodeSetUseIntegratorFusedKernels(void *cvode_mem, booleantype onoff);
+SUNDIALS_EXPORT int CVodeSetJacReuseOnReInit(void *cvode_mem, booleantype onoff);
+SUNDIALS_EXPORT int CVodeSetMethodSwitching(void *cvode_mem, booleantype onoff);
+SUNDIALS_EXPORT int CVodeInvalidateJac(void *cvode_mem);
+SUNDIALS_EXPORT int CVodeSetEnsemble(void *cvode_mem, int nmembers,
+                                     int layout);
 
 /* Rootfinding initialization function */
 SUNDIALS_EXPORT int CVodeRootInit(void *cvode_mem, int nrtfn, CVRootFn g);
@@ -151,6 +166,8 @@ SUNDIALS_EXPORT int CVodeRootInit(void *cvode_mem, int nrtfn, CVRootFn g);
 /* Rootfinding optional input functions */
 SUNDIALS_EXPORT int CVodeSetRootDirection(void *cvode_mem, int *rootdir);
 SUNDIALS_EXPORT int CVodeSetNoInactiveRootWarn(void *cvode_mem);
+SUNDIALS_EXPORT int CVodeSetRootChangedFn(void *cvode_mem,
+                                          CVRootChangedFn gchg);
 
 /* Solver function */
 SUNDIALS_EXPORT int CVode(void *cvode_mem, realtype tout, N_Vector yout,
@@ -159,9 +176,16 @@ SUNDIALS_EXPORT int CVode(void *cvode_mem, realtype tout, N_Vector yout,
 /* Utility functions to update/compute y based on ycor */
 SUNDIALS_EXPORT int CVodeComputeState(void *cvode_mem, N_Vector ycor, N_Vector y);
 
+/* Integrator state snapshot, e.g. to repeat a rejected step */
+SUNDIALS_EXPORT int CVodeGetStateSize(void *cvode_mem, long int *nbytes);
+SUNDIALS_EXPORT int CVodeGetState(void *cvode_mem, void *buf, long int nbytes);
+SUNDIALS_EXPORT int CVodeSetState(void *cvode_mem, const void *buf, long int nbytes);
+
 /* Dense output function */
 SUNDIALS_EXPORT int CVodeGetDky(void *cvode_mem, realtype t, int k,
                                 N_Vector dky);
+SUNDIALS_EXPORT int CVodeGetDkyMulti(void *cvode_mem, int ntimes,
+                                     const realtype *t, int k, realtype *dky);
 
 /* Optional output functions */
 SUNDIALS_EXPORT int CVodeGetWorkSpace(void *cvode_mem, long int *lenrw,
@@ -177,6 +201,8 @@ SUNDIALS_EXPORT int CVodeGetCurrentOrder(void *cvode_mem, int *qcur);
 SUNDIALS_EXPORT int CVodeGetCurrentGamma(void *cvode_mem, realtype *gamma);
 SUNDIALS_EXPORT int CVodeGetNumStabLimOrderReds(void *cvode_mem,
                                                 long int *nslred);
+SUNDIALS_EXPORT int CVodeGetNumMethodSwitches(void *cvode_mem, long int *nswitch);
+SUNDIALS_EXPORT int CVodeGetCurrentMethod(void *cvode_mem, int *lmm);
 SUNDIALS_EXPORT int CVodeGetActualInitStep(void *cvode_mem, realtype *hinused);
 SUNDIALS_EXPORT int CVodeGetLastStep(void *cvode_mem, realtype *hlast);
 SUNDIALS_EXPORT int CVodeGetCurrentStep(void *cvode_mem, realtype *hcur);
@@ -205,6 +231,7 @@ SUNDIALS_EXPORT int CVodeGetNumNonlinSolvConvFails(void *cvode_mem,
                                                    long int *nncfails);
 SUNDIALS_EXPORT int CVodeGetNonlinSolvStats(void *cvode_mem, long int *nniters,
                                             long int *nncfails);
+SUNDIALS_EXPORT int CVodeGetProfiler(void *cvode_mem, SUNProfiler *profiler);
 SUNDIALS_EXPORT char *CVodeGetReturnFlagName(long int flag);
 
 /* Free function */
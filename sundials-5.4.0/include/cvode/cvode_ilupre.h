@@ -0,0 +1,63 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the CVILUPRE module, which provides
+ * an incomplete LU (ILU(0) or ILUT) preconditioner of the Newton
+ * matrix I - gamma*J for a sparse Jacobian J.
+ *
+ * J is a SUNSparseMatrix (CSR or CSC) giving the dimensions and the
+ * sparsity pattern of the Jacobian. It is computed either by the
+ * user function jac or, when jac is NULL, by colored difference
+ * quotients over the pattern of J.
+ * -----------------------------------------------------------------*/
+
+#ifndef _CVILUPRE_H
+#define _CVILUPRE_H
+
+#include <sundials/sundials_nvector.h>
+#include <sundials/sundials_ilu.h>
+#include <cvode/cvode_ls.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+
+/* ILUPrec inititialization function */
+
+SUNDIALS_EXPORT int CVILUPrecInit(void *cvode_mem, SUNMatrix J,
+                                  CVLsJacFn jac, int ilutype);
+
+/* Optional input functions */
+
+SUNDIALS_EXPORT int CVILUPrecSetThresholds(void *cvode_mem,
+                                           realtype droptol,
+                                           sunindextype lfil);
+SUNDIALS_EXPORT int CVILUPrecSetNumThreads(void *cvode_mem,
+                                           int nthreads);
+
+/* Optional output functions */
+
+SUNDIALS_EXPORT int CVILUPrecGetWorkSpace(void *cvode_mem,
+                                          long int *lenrwIP,
+                                          long int *leniwIP);
+SUNDIALS_EXPORT int CVILUPrecGetNumJacEvals(void *cvode_mem,
+                                            long int *njevalsIP);
+SUNDIALS_EXPORT int CVILUPrecGetNumLevels(void *cvode_mem,
+                                          sunindextype *nlevL,
+                                          sunindextype *nlevU);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
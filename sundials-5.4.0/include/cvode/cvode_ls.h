@@ -90,6 +90,8 @@ SUNDIALS_EXPORT int CVodeSetLinearSolver(void *cvode_mem,
 SUNDIALS_EXPORT int CVodeSetJacFn(void *cvode_mem, CVLsJacFn jac);
 SUNDIALS_EXPORT int CVodeSetJacEvalFrequency(void *cvode_mem,
                                              long int msbj);
+SUNDIALS_EXPORT int CVodeSetJacSparsityPattern(void *cvode_mem,
+                                               SUNMatrix P);
 SUNDIALS_EXPORT int CVodeSetLinearSolutionScaling(void *cvode_mem,
                                                   booleantype onoff);
 SUNDIALS_EXPORT int CVodeSetEpsLin(void *cvode_mem, realtype eplifac);
@@ -359,6 +359,9 @@ SUNDIALS_EXPORT int CVodeSetSensErrCon(void *cvode_mem, booleantype errconS);
 SUNDIALS_EXPORT int CVodeSetSensMaxNonlinIters(void *cvode_mem, int maxcorS);
 SUNDIALS_EXPORT int CVodeSetSensParams(void *cvode_mem, realtype *p,
                                        realtype *pbar, int *plist);
+SUNDIALS_EXPORT int CVodeSetSensRhsContexts(void *cvode_mem, int ncontexts,
+                                            void **contexts,
+                                            realtype **params);
 
 /* Integrator nonlinear solver specification functions */
 SUNDIALS_EXPORT int CVodeSetNonlinearSolverSensSim(void *cvode_mem,
@@ -518,6 +521,8 @@ SUNDIALS_EXPORT int CVodeB(void *cvode_mem, realtype tBout, int itaskB);
 /* Optional Input Functions For Adjoint Problems */
 
 SUNDIALS_EXPORT int CVodeSetAdjNoSensi(void *cvode_mem);
+SUNDIALS_EXPORT int CVodeSetAdjCheckpointFile(void *cvode_mem,
+                                              const char *filename);
 
 SUNDIALS_EXPORT int CVodeSetUserDataB(void *cvode_mem, int which,
                                       void *user_dataB);
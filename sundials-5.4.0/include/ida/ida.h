@@ -126,6 +126,10 @@ SUNDIALS_EXPORT int IDASetMaxNumItersIC(void *ida_mem, int maxnit);
 SUNDIALS_EXPORT int IDASetLineSearchOffIC(void *ida_mem, booleantype lsoff);
 SUNDIALS_EXPORT int IDASetStepToleranceIC(void *ida_mem, realtype steptol);
 SUNDIALS_EXPORT int IDASetMaxBacksIC(void *ida_mem, int maxbacks);
+SUNDIALS_EXPORT int IDASetLineSearchParamsIC(void *ida_mem, realtype alpha,
+                                             realtype eta);
+SUNDIALS_EXPORT int IDASetJacReuseIC(void *ida_mem, booleantype reuse);
+SUNDIALS_EXPORT int IDASetCorrectionMaskIC(void *ida_mem, N_Vector mask);
 
 /* Optional input functions */
 SUNDIALS_EXPORT int IDASetErrHandlerFn(void *ida_mem, IDAErrHandlerFn ehfun,
@@ -174,6 +178,7 @@ SUNDIALS_EXPORT int IDAGetNumResEvals(void *ida_mem, long int *nrevals);
 SUNDIALS_EXPORT int IDAGetNumLinSolvSetups(void *ida_mem, long int *nlinsetups);
 SUNDIALS_EXPORT int IDAGetNumErrTestFails(void *ida_mem, long int *netfails);
 SUNDIALS_EXPORT int IDAGetNumBacktrackOps(void *ida_mem, long int *nbacktr);
+SUNDIALS_EXPORT int IDAGetNumReusedSetupsIC(void *ida_mem, long int *nreuse);
 SUNDIALS_EXPORT int IDAGetConsistentIC(void *ida_mem, N_Vector yy0_mod,
                                        N_Vector yp0_mod);
 SUNDIALS_EXPORT int IDAGetLastOrder(void *ida_mem, int *klast);
@@ -0,0 +1,63 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the IDAILUPRE module, which provides
+ * an incomplete LU (ILU(0) or ILUT) preconditioner of the iteration
+ * matrix dF/dy + c_j*dF/dy' for a sparse system.
+ *
+ * J is a SUNSparseMatrix (CSR or CSC) giving the dimensions and the
+ * sparsity pattern of the iteration matrix. It is computed either
+ * by the user function jac or, when jac is NULL, by colored
+ * difference quotients over the pattern of J.
+ * -----------------------------------------------------------------*/
+
+#ifndef _IDAILUPRE_H
+#define _IDAILUPRE_H
+
+#include <sundials/sundials_nvector.h>
+#include <sundials/sundials_ilu.h>
+#include <ida/ida_ls.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+
+/* ILUPrec inititialization function */
+
+SUNDIALS_EXPORT int IDAILUPrecInit(void *ida_mem, SUNMatrix J,
+                                   IDALsJacFn jac, int ilutype);
+
+/* Optional input functions */
+
+SUNDIALS_EXPORT int IDAILUPrecSetThresholds(void *ida_mem,
+                                            realtype droptol,
+                                            sunindextype lfil);
+SUNDIALS_EXPORT int IDAILUPrecSetNumThreads(void *ida_mem,
+                                            int nthreads);
+
+/* Optional output functions */
+
+SUNDIALS_EXPORT int IDAILUPrecGetWorkSpace(void *ida_mem,
+                                           long int *lenrwIP,
+                                           long int *leniwIP);
+SUNDIALS_EXPORT int IDAILUPrecGetNumJacEvals(void *ida_mem,
+                                             long int *njevalsIP);
+SUNDIALS_EXPORT int IDAILUPrecGetNumLevels(void *ida_mem,
+                                           sunindextype *nlevL,
+                                           sunindextype *nlevU);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
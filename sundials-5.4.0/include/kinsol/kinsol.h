@@ -20,6 +20,7 @@
 
 #include <stdio.h>
 #include <sundials/sundials_nvector.h>
+#include <sundials/sundials_profiler.h>
 #include <kinsol/kinsol_ls.h>
 
 #ifdef __cplusplus  /* wrapper to enable C++ usage */
@@ -68,6 +69,11 @@ extern "C" {
 #define KIN_PICARD     2
 #define KIN_FP         3
 
+/* Enumeration for the Anderson acceleration QR update */
+#define KIN_ORTH_MGS   0
+#define KIN_ORTH_CGS2  1
+#define KIN_ORTH_DCGS2 2
+
 /* ------------------------------
  * User-Supplied Function Types
  * ------------------------------ */
@@ -103,11 +109,15 @@ SUNDIALS_EXPORT int KINSetInfoHandlerFn(void *kinmem, KINInfoHandlerFn ihfun,
                                         void *ih_data);
 SUNDIALS_EXPORT int KINSetInfoFile(void *kinmem, FILE *infofp);
 SUNDIALS_EXPORT int KINSetUserData(void *kinmem, void *user_data);
+SUNDIALS_EXPORT int KINSetProfiler(void *kinmem, SUNProfiler profiler);
 SUNDIALS_EXPORT int KINSetPrintLevel(void *kinmemm, int printfl);
 SUNDIALS_EXPORT int KINSetMAA(void *kinmem, long int maa);
 SUNDIALS_EXPORT int KINSetDampingAA(void *kinmem, realtype beta);
+SUNDIALS_EXPORT int KINSetOrthAA(void *kinmem, int orthaa);
 SUNDIALS_EXPORT int KINSetNumMaxIters(void *kinmem, long int mxiter);
 SUNDIALS_EXPORT int KINSetNoInitSetup(void *kinmem, booleantype noInitSetup);
+SUNDIALS_EXPORT int KINSetWarmStart(void *kinmem, booleantype warmstart);
+SUNDIALS_EXPORT int KINResetWarmStart(void *kinmem);
 SUNDIALS_EXPORT int KINSetNoResMon(void *kinmem, booleantype noNNIResMon);
 SUNDIALS_EXPORT int KINSetMaxSetupCalls(void *kinmem, long int msbset);
 SUNDIALS_EXPORT int KINSetMaxSubSetupCalls(void *kinmem, long int msbsetsub);
@@ -137,6 +147,7 @@ SUNDIALS_EXPORT int KINGetNumBetaCondFails(void *kinmem, long int *nbcfails);
 SUNDIALS_EXPORT int KINGetNumBacktrackOps(void *kinmem, long int *nbacktr);
 SUNDIALS_EXPORT int KINGetFuncNorm(void *kinmem, realtype *fnorm);
 SUNDIALS_EXPORT int KINGetStepLength(void *kinmem, realtype *steplength);
+SUNDIALS_EXPORT int KINGetProfiler(void *kinmem, SUNProfiler *profiler);
 SUNDIALS_EXPORT char *KINGetReturnFlagName(long int flag);
 
 /* Free function */
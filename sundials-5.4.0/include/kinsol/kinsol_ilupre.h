@@ -0,0 +1,61 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the KINILUPRE module, which provides
+ * an incomplete LU (ILU(0) or ILUT) preconditioner of the system
+ * Jacobian J for a sparse system.
+ *
+ * J is a SUNSparseMatrix (CSR or CSC) giving the dimensions of the
+ * Jacobian, which is computed by the user function jac.
+ * -----------------------------------------------------------------*/
+
+#ifndef _KINILUPRE_H
+#define _KINILUPRE_H
+
+#include <sundials/sundials_nvector.h>
+#include <sundials/sundials_ilu.h>
+#include <kinsol/kinsol_ls.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+
+/* ILUPrec inititialization function */
+
+SUNDIALS_EXPORT int KINILUPrecInit(void *kinmem, SUNMatrix J,
+                                   KINLsJacFn jac, int ilutype);
+
+/* Optional input functions */
+
+SUNDIALS_EXPORT int KINILUPrecSetThresholds(void *kinmem,
+                                            realtype droptol,
+                                            sunindextype lfil);
+SUNDIALS_EXPORT int KINILUPrecSetNumThreads(void *kinmem,
+                                            int nthreads);
+
+/* Optional output functions */
+
+SUNDIALS_EXPORT int KINILUPrecGetWorkSpace(void *kinmem,
+                                           long int *lenrwIP,
+                                           long int *leniwIP);
+SUNDIALS_EXPORT int KINILUPrecGetNumJacEvals(void *kinmem,
+                                             long int *njevalsIP);
+SUNDIALS_EXPORT int KINILUPrecGetNumLevels(void *kinmem,
+                                           sunindextype *nlevL,
+                                           sunindextype *nlevU);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -83,6 +83,8 @@ SUNDIALS_EXPORT int KINSetPreconditioner(void *kinmem,
                                          KINLsPrecSolveFn psolve);
 SUNDIALS_EXPORT int KINSetJacTimesVecFn(void *kinmem,
                                         KINLsJacTimesVecFn jtv);
+SUNDIALS_EXPORT int KINSetJacDQContexts(void *kinmem, int ncontexts,
+                                        void **contexts);
 
 /*-----------------------------------------------------------------
   Optional outputs from the KINLS linear solver interface
@@ -53,6 +53,7 @@ struct _N_VectorContent_ManyVector {
   sunindextype  global_length;   /* overall manyvector length       */
   N_Vector*     subvec_array;    /* pointer to N_Vector array       */
   booleantype   own_data;        /* flag indicating data ownership  */
+  int           num_threads;     /* threads used on the subvectors  */
 };
 
 typedef struct _N_VectorContent_ManyVector *N_VectorContent_ManyVector;
@@ -75,6 +76,13 @@ SUNDIALS_EXPORT int N_VSetSubvectorArrayPointer_ManyVector(realtype *v_data, N_V
 
 SUNDIALS_EXPORT sunindextype N_VGetNumSubvectors_ManyVector(N_Vector v);
 
+/* Work on the subvectors with a team of num_threads OpenMP threads
+   (default 1, i.e. one subvector after the other). Sums over the
+   subvectors are accumulated in subvector order, so the results do
+   not depend on the number of threads. Clones inherit the setting.
+   Without OpenMP support the setting is stored but has no effect. */
+SUNDIALS_EXPORT int N_VSetNumThreads_ManyVector(N_Vector v, int num_threads);
+
 /* standard vector operations */
 SUNDIALS_EXPORT N_Vector_ID N_VGetVectorID_ManyVector(N_Vector v);
 SUNDIALS_EXPORT N_Vector N_VCloneEmpty_ManyVector(N_Vector w);
@@ -43,6 +43,7 @@
 #define _NVECTOR_OPENMP_H
 
 #include <stdio.h>
+#include <sundials/sundials_memory.h>
 #include <sundials/sundials_nvector.h>
 
 #ifdef __cplusplus  /* wrapper to enable C++ usage */
@@ -56,10 +57,13 @@ extern "C" {
  */
 
 struct _N_VectorContent_OpenMP {
-  sunindextype length;   /* vector length            */
-  booleantype own_data;  /* data ownership flag      */
-  realtype *data;        /* data array               */
-  int num_threads;       /* number of OpenMP threads */
+  sunindextype length;        /* vector length                 */
+  booleantype own_data;       /* data ownership flag           */
+  realtype *data;             /* data array                    */
+  int num_threads;            /* number of OpenMP threads      */
+  SUNMemoryHelper mem_helper; /* helper the data is drawn from */
+  SUNMemory data_mem;         /* memory of the data array      */
+  booleantype deterministic;  /* deterministic reductions flag */
 };
 
 typedef struct _N_VectorContent_OpenMP *N_VectorContent_OpenMP;
@@ -77,6 +81,8 @@ typedef struct _N_VectorContent_OpenMP *N_VectorContent_OpenMP;
 
 #define NV_NUM_THREADS_OMP(v)   ( NV_CONTENT_OMP(v)->num_threads )
 
+#define NV_DETERMINISTIC_OMP(v) ( NV_CONTENT_OMP(v)->deterministic )
+
 #define NV_OWN_DATA_OMP(v) ( NV_CONTENT_OMP(v)->own_data )
 
 #define NV_DATA_OMP(v)     ( NV_CONTENT_OMP(v)->data )
@@ -93,6 +99,10 @@ SUNDIALS_EXPORT N_Vector N_VNew_OpenMP(sunindextype vec_length, int num_threads)
 
 SUNDIALS_EXPORT N_Vector N_VNewEmpty_OpenMP(sunindextype vec_length, int num_threads);
 
+SUNDIALS_EXPORT N_Vector N_VNewWithMemHelp_OpenMP(sunindextype vec_length,
+                                                  int num_threads,
+                                                  SUNMemoryHelper helper);
+
 SUNDIALS_EXPORT N_Vector N_VMake_OpenMP(sunindextype vec_length, realtype *v_data,
                                         int num_threads);
 
@@ -200,6 +210,20 @@ SUNDIALS_EXPORT int N_VEnableWrmsNormMaskVectorArray_OpenMP(N_Vector v, booleant
 SUNDIALS_EXPORT int N_VEnableScaleAddMultiVectorArray_OpenMP(N_Vector v, booleantype tf);
 SUNDIALS_EXPORT int N_VEnableLinearCombinationVectorArray_OpenMP(N_Vector v, booleantype tf);
 
+/*
+ * -----------------------------------------------------------------
+ * Enable / disable deterministic reductions
+ * -----------------------------------------------------------------
+ * With deterministic reductions the dot products, norms and square
+ * sums (also in the fused and vector array operations) add partial
+ * sums over chunks that depend on the vector length only, in a fixed
+ * order. Results are then bitwise reproducible between runs and for
+ * any number of threads. Clones inherit the setting.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int N_VSetDeterministicReductions_OpenMP(N_Vector v, booleantype tf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -57,11 +57,19 @@ extern "C" {
  * -----------------------------------------------------------------
  */
 
+/* Persistent team of POSIX threads that runs the vector operations. It is
+   created with the vector, shared by all of its clones and stopped when the
+   last of them is destroyed. */
+
+typedef struct _Pthreads_Team *Pthreads_Team;
+
 struct _N_VectorContent_Pthreads {
   sunindextype length;   /* vector length           */
   booleantype own_data;  /* data ownership flag     */
   realtype *data;        /* data array              */
   int num_threads;       /* number of POSIX threads */
+  Pthreads_Team team;    /* worker threads          */
+  booleantype deterministic; /* deterministic reductions */
 };
 
 typedef struct _N_VectorContent_Pthreads *N_VectorContent_Pthreads;
@@ -75,6 +83,7 @@ typedef struct _N_VectorContent_Pthreads *N_VectorContent_Pthreads;
 struct _Pthreads_Data{
   sunindextype start;            /* starting index for loop  */
   sunindextype end;              /* ending index for loop    */
+  sunindextype chunk;            /* deterministic sum chunk  */
   realtype c1, c2;               /* scalar values            */
   realtype *v1, *v2, *v3;        /* vector data              */
   realtype *global_val;          /* shared global variable   */
@@ -112,6 +121,8 @@ typedef struct _Pthreads_Data Pthreads_Data;
 
 #define NV_NUM_THREADS_PT(v)   ( NV_CONTENT_PT(v)->num_threads )
 
+#define NV_DETERMINISTIC_PT(v) ( NV_CONTENT_PT(v)->deterministic )
+
 #define NV_OWN_DATA_PT(v)      ( NV_CONTENT_PT(v)->own_data )
 
 #define NV_DATA_PT(v)          ( NV_CONTENT_PT(v)->data )
@@ -233,6 +244,20 @@ SUNDIALS_EXPORT int N_VEnableWrmsNormMaskVectorArray_Pthreads(N_Vector v, boolea
 SUNDIALS_EXPORT int N_VEnableScaleAddMultiVectorArray_Pthreads(N_Vector v, booleantype tf);
 SUNDIALS_EXPORT int N_VEnableLinearCombinationVectorArray_Pthreads(N_Vector v, booleantype tf);
 
+/*
+ * -----------------------------------------------------------------
+ * Enable / disable deterministic reductions
+ * -----------------------------------------------------------------
+ * With deterministic reductions the dot products, norms and square
+ * sums (also in the fused and vector array operations) add partial
+ * sums over chunks that depend on the vector length only, in a fixed
+ * order. Results are then bitwise reproducible between runs and for
+ * any number of threads. Clones inherit the setting.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int N_VSetDeterministicReductions_Pthreads(N_Vector v, booleantype tf);
+
 #ifdef __cplusplus
 }
 #endif
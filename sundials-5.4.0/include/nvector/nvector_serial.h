@@ -39,6 +39,7 @@
 #define _NVECTOR_SERIAL_H
 
 #include <stdio.h>
+#include <sundials/sundials_memory.h>
 #include <sundials/sundials_nvector.h>
 
 #ifdef __cplusplus  /* wrapper to enable C++ usage */
@@ -52,9 +53,11 @@ extern "C" {
  */
 
 struct _N_VectorContent_Serial {
-  sunindextype length;   /* vector length       */
-  booleantype own_data;  /* data ownership flag */
-  realtype *data;        /* data array          */
+  sunindextype length;        /* vector length                 */
+  booleantype own_data;       /* data ownership flag           */
+  realtype *data;             /* data array                    */
+  SUNMemoryHelper mem_helper; /* helper the data is drawn from */
+  SUNMemory data_mem;         /* memory of the data array      */
 };
 
 typedef struct _N_VectorContent_Serial *N_VectorContent_Serial;
@@ -86,6 +89,9 @@ SUNDIALS_EXPORT N_Vector N_VNew_Serial(sunindextype vec_length);
 
 SUNDIALS_EXPORT N_Vector N_VNewEmpty_Serial(sunindextype vec_length);
 
+SUNDIALS_EXPORT N_Vector N_VNewWithMemHelp_Serial(sunindextype vec_length,
+                                                  SUNMemoryHelper helper);
+
 SUNDIALS_EXPORT N_Vector N_VMake_Serial(sunindextype vec_length, realtype *v_data);
 
 SUNDIALS_EXPORT N_Vector* N_VCloneVectorArray_Serial(int count, N_Vector w);
@@ -0,0 +1,113 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * SUNDIALS backends: runtime selection of the N_Vector, SUNMatrix
+ * and direct SUNLinearSolver modules for a problem.
+ *
+ * SUNBackend_Select picks a serial or a threaded (OpenMP or
+ * Pthreads) N_Vector from the problem size and the number of
+ * cores, and a dense or a sparse (KLU or SuperLU_MT) linear solver
+ * from the size and the number of nonzeros of the Jacobian, among
+ * the modules that were built. The constructors below then create
+ * the objects of the selected backend, so that the same code runs
+ * large problems on the parallel and sparse modules without being
+ * built against them.
+ * ----------------------------------------------------------------*/
+
+#ifndef _SUNDIALS_BACKEND_H
+#define _SUNDIALS_BACKEND_H
+
+#include <sundials/sundials_config.h>
+#include <sundials/sundials_types.h>
+#include <sundials/sundials_nvector.h>
+#include <sundials/sundials_matrix.h>
+#include <sundials/sundials_linearsolver.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+typedef enum {
+  SUNBACKEND_VECTOR_SERIAL,
+  SUNBACKEND_VECTOR_OPENMP,
+  SUNBACKEND_VECTOR_PTHREADS
+} SUNBackendVector;
+
+typedef enum {
+  SUNBACKEND_SOLVER_DENSE,
+  SUNBACKEND_SOLVER_KLU,
+  SUNBACKEND_SOLVER_SUPERLUMT
+} SUNBackendSolver;
+
+typedef struct {
+  SUNBackendVector vector;
+  SUNBackendSolver solver;
+  int nthreads;        /* threads of a threaded vector */
+  int nsolverthreads;  /* threads of SuperLU_MT        */
+} SUNBackend;
+
+/* Problems with fewer equations use serial vectors */
+#ifndef SUNBACKEND_THREADED_MIN_N
+#define SUNBACKEND_THREADED_MIN_N 100000
+#endif
+
+/* Least number of equations per thread of a threaded vector */
+#ifndef SUNBACKEND_N_PER_THREAD
+#define SUNBACKEND_N_PER_THREAD 20000
+#endif
+
+/* Problems with fewer equations, or with a denser Jacobian
+   (nonzeros over n^2), use a dense solver */
+#ifndef SUNBACKEND_SPARSE_MIN_N
+#define SUNBACKEND_SPARSE_MIN_N 100
+#endif
+#ifndef SUNBACKEND_SPARSE_MAX_DENSITY
+#define SUNBACKEND_SPARSE_MAX_DENSITY 0.1
+#endif
+
+/* Sparse problems with fewer equations use KLU over SuperLU_MT */
+#ifndef SUNBACKEND_SUPERLUMT_MIN_N
+#define SUNBACKEND_SUPERLUMT_MIN_N 20000
+#endif
+
+/* Whether a module was built, i.e. can be selected */
+SUNDIALS_EXPORT booleantype SUNBackend_HasVector(SUNBackendVector vector);
+SUNDIALS_EXPORT booleantype SUNBackend_HasSolver(SUNBackendSolver solver);
+
+/* Number of cores of the machine, 1 if it can not be determined */
+SUNDIALS_EXPORT int SUNBackend_NumCores(void);
+
+/* Select the backend of a system of n equations whose Jacobian has
+   nnz nonzeros (nnz <= 0 if unknown, which selects a dense solver)
+   on ncores cores (ncores <= 0 for all the cores of the machine) */
+SUNDIALS_EXPORT int SUNBackend_Select(sunindextype n, sunindextype nnz,
+                                      int ncores, SUNBackend *backend);
+
+SUNDIALS_EXPORT N_Vector SUNBackend_NewVector(const SUNBackend *backend,
+                                              sunindextype n);
+
+/* A dense n x n matrix, or a compressed-sparse-column matrix with
+   room for nnz nonzeros for the sparse solvers */
+SUNDIALS_EXPORT SUNMatrix SUNBackend_NewMatrix(const SUNBackend *backend,
+                                               sunindextype n,
+                                               sunindextype nnz);
+
+SUNDIALS_EXPORT SUNLinearSolver SUNBackend_NewLinearSolver(const SUNBackend *backend,
+                                                           N_Vector y,
+                                                           SUNMatrix A);
+
+SUNDIALS_EXPORT const char *SUNBackend_Name(const SUNBackend *backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
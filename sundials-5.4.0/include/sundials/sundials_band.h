@@ -81,6 +81,24 @@ SUNDIALS_EXPORT sunindextype bandGBTRF(realtype **a, sunindextype n,
                                        sunindextype mu, sunindextype ml,
                                        sunindextype smu, sunindextype *p);
 
+/*
+ * -----------------------------------------------------------------
+ * Function : bandGBTRFBlocked
+ * -----------------------------------------------------------------
+ * bandGBTRFBlocked computes the same factorization and pivots as
+ * bandGBTRF. The elimination steps are applied to the columns a few
+ * at a time, which loads each column fewer times and lets the
+ * compiler vectorize the updates of wide bands. Entries of the
+ * factors are the same as those of bandGBTRF, up to the sign of
+ * zero entries. Bands with a lower bandwidth below 8 are factored
+ * by bandGBTRF. A small work array is allocated on each call.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT sunindextype bandGBTRFBlocked(realtype **a, sunindextype n,
+                                              sunindextype mu, sunindextype ml,
+                                              sunindextype smu, sunindextype *p);
+
 /*
  * -----------------------------------------------------------------
  * Function : BandGBTRS
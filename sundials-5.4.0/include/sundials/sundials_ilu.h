@@ -0,0 +1,117 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the incomplete LU factorization used
+ * by the CVODE, IDA and KINSOL ILU preconditioner modules.
+ *
+ * The factors of a SUNSparseMatrix (CSR or CSC) are computed either
+ * with no fill-in (ILU(0)) or with the dual threshold strategy of
+ * Saad (ILUT): entries smaller than droptol times the average
+ * absolute value of the row are dropped and at most lfil entries
+ * are kept in each row of L and of U.
+ *
+ * The rows of L and U are grouped into levels such that the rows of
+ * one level depend only on rows of earlier levels. The triangular
+ * solves run level by level, and with OpenMP the rows of a level
+ * are solved in parallel.
+ * -----------------------------------------------------------------*/
+
+#ifndef _SUNDIALS_ILU_H
+#define _SUNDIALS_ILU_H
+
+#include <sundials/sundials_matrix.h>
+#include <sundials/sundials_nvector.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/* factorization types */
+#define SUNILU_ILU0  0
+#define SUNILU_ILUT  1
+
+/* return values */
+#define SUNILU_SUCCESS     0
+#define SUNILU_MEM_FAIL   -1
+#define SUNILU_ILL_INPUT  -2
+
+/* default ILUT thresholds */
+#define SUNILU_DROPTOL_DEFAULT  RCONST(1.0e-4)
+#define SUNILU_LFIL_DEFAULT     0
+
+typedef struct SUNILUMemRec *SUNILUMem;
+
+/*
+ * -----------------------------------------------------------------
+ * SUNILUCreate creates the factorization memory for N by N
+ * matrices. type is SUNILU_ILU0 or SUNILU_ILUT. NULL is returned
+ * if an input is illegal or memory allocation fails.
+ *
+ * SUNILUSetThresholds sets the ILUT drop tolerance (>= 0) and the
+ * maximum number of entries kept in each row of L and of U
+ * (lfil <= 0 keeps all entries above the drop tolerance). The
+ * thresholds are ignored by ILU(0).
+ *
+ * SUNILUSetNumThreads sets the number of OpenMP threads used by the
+ * triangular solves (default 1). It has no effect without OpenMP.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT SUNILUMem SUNILUCreate(int type, sunindextype N);
+
+SUNDIALS_EXPORT int SUNILUSetThresholds(SUNILUMem ilu, realtype droptol,
+                                        sunindextype lfil);
+
+SUNDIALS_EXPORT int SUNILUSetNumThreads(SUNILUMem ilu, int nthreads);
+
+/*
+ * -----------------------------------------------------------------
+ * SUNILUFactor computes the incomplete factors of the sparse matrix
+ * A. For ILU(0) the symbolic part is reused as long as the sparsity
+ * pattern of A does not change. Pivots that are zero or tiny with
+ * respect to the row are replaced by sqrt(uround) times the largest
+ * absolute value in the row, so the factors are always usable.
+ *
+ * SUNILUSolve solves L U x = b with the last factors. b and x may be
+ * the same vector. The vectors must provide N_VGetArrayPointer.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int SUNILUFactor(SUNILUMem ilu, SUNMatrix A);
+
+SUNDIALS_EXPORT int SUNILUSolve(SUNILUMem ilu, N_Vector b, N_Vector x);
+
+SUNDIALS_EXPORT void SUNILUFree(SUNILUMem ilu);
+
+/*
+ * -----------------------------------------------------------------
+ * Optional outputs: number of levels of the L and U solves, number
+ * of nonzeros of the factors (L, diagonal and U), number of pivots
+ * replaced since creation, and workspace in realtype and
+ * sunindextype words.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int SUNILUGetNumLevels(SUNILUMem ilu, sunindextype *nlevL,
+                                       sunindextype *nlevU);
+
+SUNDIALS_EXPORT int SUNILUGetNumNonzeros(SUNILUMem ilu, sunindextype *nnz);
+
+SUNDIALS_EXPORT int SUNILUGetNumPivotFixes(SUNILUMem ilu, long int *npivfix);
+
+SUNDIALS_EXPORT int SUNILUGetWorkSpace(SUNILUMem ilu, long int *lenrw,
+                                       long int *leniw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
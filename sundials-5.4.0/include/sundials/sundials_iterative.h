@@ -63,10 +63,18 @@ enum { PREC_NONE, PREC_LEFT, PREC_RIGHT, PREC_BOTH };
  * CLASSICAL_GS : The iterative solver uses the classical
  *                Gram-Schmidt routine ClassicalGS listed in this
  *                file.
+ *
+ * CLASSICAL_GS2: The iterative solver uses the classical
+ *                Gram-Schmidt routine with reorthogonalization
+ *                ClassicalGS2 listed in this file.
+ *
+ * LOWSYNC_GS   : The iterative solver uses the single reduction
+ *                classical Gram-Schmidt routine LowSyncGS listed
+ *                in this file.
  * -----------------------------------------------------------------
  */
 
-enum { MODIFIED_GS = 1, CLASSICAL_GS = 2 };
+enum { MODIFIED_GS = 1, CLASSICAL_GS = 2, CLASSICAL_GS2 = 3, LOWSYNC_GS = 4 };
 
 /*
  * -----------------------------------------------------------------
@@ -188,6 +196,43 @@ SUNDIALS_EXPORT int ClassicalGS(N_Vector* v, realtype **h, int k, int p,
                                 realtype *new_vk_norm, realtype *stemp,
                                 N_Vector* vtemp);
 
+/*
+ * -----------------------------------------------------------------
+ * Function: ClassicalGS2
+ * -----------------------------------------------------------------
+ * ClassicalGS2 performs the classical Gram-Schmidt
+ * orthogonalization twice (CGS2). The squared norm of v[k] is
+ * reduced together with the inner products of each pass, so that
+ * the routine needs two reductions where ClassicalGS needs up to
+ * four. The parameters are as described for ClassicalGS.
+ *
+ * ClassicalGS2 returns 0 to indicate success.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int ClassicalGS2(N_Vector* v, realtype **h, int k, int p,
+                                 realtype *new_vk_norm, realtype *stemp,
+                                 N_Vector* vtemp);
+
+/*
+ * -----------------------------------------------------------------
+ * Function: LowSyncGS
+ * -----------------------------------------------------------------
+ * LowSyncGS performs a single classical Gram-Schmidt pass with one
+ * reduction for the inner products and the norm of v[k], and uses
+ * the Pythagorean theorem for the norm of the result. A second
+ * pass is only made if the orthogonalized v[k] lost more than
+ * about three digits of its norm. The parameters are as described
+ * for ClassicalGS.
+ *
+ * LowSyncGS returns 0 to indicate success.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int LowSyncGS(N_Vector* v, realtype **h, int k, int p,
+                              realtype *new_vk_norm, realtype *stemp,
+                              N_Vector* vtemp);
+
 /*
  * -----------------------------------------------------------------
  * Function: QRfact
@@ -256,6 +301,87 @@ SUNDIALS_EXPORT int QRfact(int n, realtype **h, realtype *q, int job);
 
 SUNDIALS_EXPORT int QRsol(int n, realtype **h, realtype *q, realtype *b);
 
+/*
+ * -----------------------------------------------------------------
+ * Type: QRAddFn
+ * -----------------------------------------------------------------
+ * A QRAddFn appends a column to a thin QR factorization, as used
+ * by Anderson acceleration to update the factorization of the
+ * residual differences one column per iteration.
+ *
+ * Q is an array of at least m+1 N_Vectors. On entry Q[0], ...,
+ * Q[m-1] hold the orthonormal columns of the factorization of
+ * the first m columns. On return Q[m] holds the new column.
+ *
+ * R is the upper triangular factor, stored column-wise with
+ * leading dimension mmax, so that the (i,j)th entry is
+ * R[j*mmax+i]. On return column m, R[m*mmax+i] for i=0,...,m,
+ * holds the coefficients of df.
+ *
+ * df is the column to append. It is not changed and must not be
+ * one of the Q[i].
+ *
+ * stemp is a length 2*m+2 array of realtype and vtemp is an array
+ * of m+1 N_Vectors which are used as workspace.
+ *
+ * If df lies in the span of Q[0], ..., Q[m-1], then Q[m] is set
+ * to zero together with R[m*mmax+m].
+ *
+ * A QRAddFn returns 0 to indicate success and -1 if a vector
+ * operation failed.
+ * -----------------------------------------------------------------
+ */
+
+typedef int (*QRAddFn)(N_Vector *Q, realtype *R, N_Vector df, int m,
+                       int mmax, realtype *stemp, N_Vector *vtemp);
+
+/*
+ * -----------------------------------------------------------------
+ * Function: QRAddMGS
+ * -----------------------------------------------------------------
+ * QRAddMGS orthogonalizes df with modified Gram-Schmidt, one
+ * inner product and one vector update per column of Q.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int QRAddMGS(N_Vector *Q, realtype *R, N_Vector df, int m,
+                             int mmax, realtype *stemp, N_Vector *vtemp);
+
+/*
+ * -----------------------------------------------------------------
+ * Function: QRAddCGS2
+ * -----------------------------------------------------------------
+ * QRAddCGS2 orthogonalizes df with two passes of classical
+ * Gram-Schmidt. Each pass is one N_VDotProdMulti call, which also
+ * reduces the squared norm, and one N_VLinearCombination call.
+ * The normalization is folded into the second combination.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int QRAddCGS2(N_Vector *Q, realtype *R, N_Vector df, int m,
+                              int mmax, realtype *stemp, N_Vector *vtemp);
+
+/*
+ * -----------------------------------------------------------------
+ * Function: QRAddDCGS2
+ * -----------------------------------------------------------------
+ * QRAddDCGS2 is classical Gram-Schmidt with delayed
+ * reorthogonalization. df gets a single pass and Q[m] is left to
+ * be reorthogonalized by the next call, which does it together
+ * with the pass of its own column. The inner products of both
+ * passes only depend on the vectors on entry, so they are
+ * independent of each other.
+ *
+ * The last column of Q is therefore orthogonal to one classical
+ * Gram-Schmidt pass only. The columns of Q must not be changed
+ * between calls other than by the rotations that remove the first
+ * column of the factorization.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int QRAddDCGS2(N_Vector *Q, realtype *R, N_Vector df, int m,
+                               int mmax, realtype *stemp, N_Vector *vtemp);
+
 #ifdef __cplusplus
 }
 #endif
@@ -87,6 +87,8 @@ typedef enum {
   SUNLINEARSOLVER_SUPERLUDIST,
   SUNLINEARSOLVER_SUPERLUMT,
   SUNLINEARSOLVER_CUSOLVERSP_BATCHQR,
+  SUNLINEARSOLVER_BLOCKDIAG,
+  SUNLINEARSOLVER_MIXEDIR,
   SUNLINEARSOLVER_CUSTOM
 } SUNLinearSolver_ID;
 
@@ -62,6 +62,7 @@ typedef enum {
   SUNMATRIX_SPARSE,
   SUNMATRIX_SLUNRLOC,
   SUNMATRIX_CUSPARSE,
+  SUNMATRIX_BLOCKDIAG,
   SUNMATRIX_CUSTOM
 } SUNMatrix_ID;
 
@@ -0,0 +1,79 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * SUNDIALS profiler: hierarchical timers for the regions of the
+ * integrators, the nonlinear and linear solvers, and the generic
+ * N_Vector and SUNMatrix operations.
+ *
+ * A region is opened with SUNProfiler_Begin and closed with
+ * SUNProfiler_End, regions opened inside of it become its children.
+ * The timers are only compiled into the SUNDIALS regions if SUNDIALS
+ * is configured with SUNDIALS_BUILD_WITH_PROFILING, the functions
+ * below are always available.
+ *
+ * The integrators record into the profiler attached to their memory
+ * (e.g. CVodeSetProfiler) and make it the active profiler of the
+ * calling thread while they run, which is the one the N_Vector and
+ * SUNMatrix operations record into.
+ * ----------------------------------------------------------------*/
+
+#ifndef _SUNDIALS_PROFILER_H
+#define _SUNDIALS_PROFILER_H
+
+#include <stdio.h>
+
+#include <sundials/sundials_config.h>
+#include <sundials/sundials_types.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+typedef struct _SUNProfiler *SUNProfiler;
+
+SUNDIALS_EXPORT int SUNProfiler_Create(const char *title, SUNProfiler *p);
+SUNDIALS_EXPORT int SUNProfiler_Free(SUNProfiler *p);
+
+SUNDIALS_EXPORT int SUNProfiler_Begin(SUNProfiler p, const char *name);
+SUNDIALS_EXPORT int SUNProfiler_End(SUNProfiler p, const char *name);
+
+/* Total time [s] and number of calls of all the regions called name */
+SUNDIALS_EXPORT int SUNProfiler_GetElapsedTime(SUNProfiler p, const char *name,
+                                               double *time, long int *ncalls);
+
+SUNDIALS_EXPORT int SUNProfiler_Reset(SUNProfiler p);
+SUNDIALS_EXPORT int SUNProfiler_Print(SUNProfiler p, FILE *fp);
+
+/* Set the active profiler of the calling thread, returns the previous one */
+SUNDIALS_EXPORT SUNProfiler SUNProfiler_SetActive(SUNProfiler p);
+SUNDIALS_EXPORT SUNProfiler SUNProfiler_GetActive(void);
+
+#if defined(SUNDIALS_BUILD_WITH_PROFILING)
+
+#define SUNDIALS_MARK_BEGIN(p, name)      SUNProfiler_Begin(p, name)
+#define SUNDIALS_MARK_END(p, name)        SUNProfiler_End(p, name)
+#define SUNDIALS_MARK_FUNCTION_BEGIN(p)   SUNProfiler_Begin(p, __func__)
+#define SUNDIALS_MARK_FUNCTION_END(p)     SUNProfiler_End(p, __func__)
+
+#else
+
+#define SUNDIALS_MARK_BEGIN(p, name)
+#define SUNDIALS_MARK_END(p, name)
+#define SUNDIALS_MARK_FUNCTION_BEGIN(p)
+#define SUNDIALS_MARK_FUNCTION_END(p)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
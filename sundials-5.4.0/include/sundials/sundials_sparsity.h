@@ -0,0 +1,117 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the Jacobian sparsity detection
+ * utilities.
+ *
+ * SUNSparsityProbe finds the sparsity pattern of the Jacobian of a
+ * function fy = fn(y) by perturbing one component of y at a time
+ * and recording the components of fy that change. The result is a
+ * SUNSparseMatrix with unit entries on the pattern that can be
+ * passed to CVodeSetJacSparsityPattern, IDASetJacSparsityPattern or
+ * used as the template matrix of the ILU preconditioners.
+ *
+ * Probing costs nprobes*(N+1) evaluations of fn, so the pattern can
+ * be cached on disk under a model identifier and read back by later
+ * runs (SUNSparsityProbeCached).
+ * -----------------------------------------------------------------*/
+
+#ifndef _SUNDIALS_SPARSITY_H
+#define _SUNDIALS_SPARSITY_H
+
+#include <sundials/sundials_matrix.h>
+#include <sundials/sundials_nvector.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/* return values */
+#define SUNSPARSITY_SUCCESS     0
+#define SUNSPARSITY_NO_CACHE    1
+#define SUNSPARSITY_MEM_FAIL   -1
+#define SUNSPARSITY_ILL_INPUT  -2
+#define SUNSPARSITY_FN_FAIL    -3
+#define SUNSPARSITY_FILE_FAIL  -4
+
+/*
+ * -----------------------------------------------------------------
+ * Type : SUNSparsityFn
+ * -----------------------------------------------------------------
+ * The function probed, fy = fn(y). It returns 0 on success and a
+ * nonzero value on failure. It must be deterministic: two calls with
+ * the same y must give bitwise identical results. For an ODE right
+ * hand side f(t,y), wrap f at a fixed t; for a DAE residual F(t,y,y')
+ * probe y and y' separately and add the two patterns with
+ * SUNMatScaleAdd.
+ * -----------------------------------------------------------------
+ */
+
+typedef int (*SUNSparsityFn)(N_Vector y, N_Vector fy, void *user_data);
+
+/*
+ * -----------------------------------------------------------------
+ * SUNSparsityProbe creates *P, the N by N pattern of dfn/dy, with
+ * sparsetype CSC_MAT or CSR_MAT. The first probe is made around y,
+ * further probes (nprobes > 1) around deterministic shifts of y, so
+ * that dependencies that vanish at y (e.g. y_j*y_k with y_k = 0) are
+ * found too. The vector y must provide N_VGetArrayPointer and is not
+ * modified.
+ *
+ * SUNSparsityColoring colors the columns of P greedily in their
+ * natural order so that columns of the same color share no row.
+ * color must have N entries. A difference quotient Jacobian on P
+ * costs ncolors evaluations.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int SUNSparsityProbe(SUNSparsityFn fn, N_Vector y,
+                                     void *user_data, int nprobes,
+                                     int sparsetype, SUNMatrix *P);
+
+SUNDIALS_EXPORT int SUNSparsityColoring(SUNMatrix P, sunindextype *color,
+                                        sunindextype *ncolors);
+
+/*
+ * -----------------------------------------------------------------
+ * Pattern cache. A pattern is stored in the directory dir in the file
+ * <key>.sparsity, where characters of key other than letters, digits,
+ * '-', '_' and '.' are replaced by '_'. The full key and the size are
+ * stored in the file and checked on reading.
+ *
+ * SUNSparsityRead returns SUNSPARSITY_NO_CACHE if there is no usable
+ * pattern for key and N. SUNSparsityWrite writes to a temporary file
+ * and renames it, so concurrent readers never see a partial file.
+ *
+ * SUNSparsityProbeCached reads the pattern for key or, if there is
+ * none, probes fn and writes the result. A failure to write the cache
+ * is not an error.
+ * -----------------------------------------------------------------
+ */
+
+SUNDIALS_EXPORT int SUNSparsityWrite(const char *dir, const char *key,
+                                     SUNMatrix P);
+
+SUNDIALS_EXPORT int SUNSparsityRead(const char *dir, const char *key,
+                                    sunindextype N, int sparsetype,
+                                    SUNMatrix *P);
+
+SUNDIALS_EXPORT int SUNSparsityProbeCached(const char *dir,
+                                           const char *key,
+                                           SUNSparsityFn fn, N_Vector y,
+                                           void *user_data, int nprobes,
+                                           int sparsetype, SUNMatrix *P);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
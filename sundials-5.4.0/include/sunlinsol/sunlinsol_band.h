@@ -42,6 +42,7 @@ struct _SUNLinearSolverContent_Band {
   sunindextype  N;
   sunindextype *pivots;
   sunindextype last_flag;
+  booleantype  blocked;   /* factor with bandGBTRFBlocked? */
 };
 
 typedef struct _SUNLinearSolverContent_Band *SUNLinearSolverContent_Band;
@@ -53,6 +54,9 @@ typedef struct _SUNLinearSolverContent_Band *SUNLinearSolverContent_Band;
 
 SUNDIALS_EXPORT SUNLinearSolver SUNLinSol_Band(N_Vector y, SUNMatrix A);
 
+SUNDIALS_EXPORT int SUNLinSol_BandSetBlocked(SUNLinearSolver S,
+                                             booleantype onoff);
+
 /* deprecated */
 SUNDIALS_EXPORT SUNLinearSolver SUNBandLinearSolver(N_Vector y,
                                                     SUNMatrix A);
@@ -0,0 +1,84 @@
+/*
+ * -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the block-diagonal implementation of
+ * the SUNLINSOL module, SUNLINSOL_BLOCKDIAG.
+ *
+ * The solver factors the blocks of a SUNMATRIX_BLOCKDIAG matrix
+ * with partial pivoting, SUNBLOCKDIAG_BATCH blocks at a time. The
+ * blocks of a batch are interleaved in memory, so that the LU
+ * factorization and the triangular solves work on the same entry
+ * of all the blocks of a batch in one inner loop, which the
+ * compiler vectorizes.
+ *
+ * Notes:
+ *   - The definition of the generic SUNLinearSolver structure can
+ *     be found in the header file sundials_linearsolver.h.
+ * -----------------------------------------------------------------
+ */
+
+#ifndef _SUNLINSOL_BLOCKDIAG_H
+#define _SUNLINSOL_BLOCKDIAG_H
+
+#include <sundials/sundials_linearsolver.h>
+#include <sundials/sundials_matrix.h>
+#include <sundials/sundials_nvector.h>
+#include <sunmatrix/sunmatrix_blockdiag.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/* Number of blocks factored together */
+#define SUNBLOCKDIAG_BATCH 8
+
+/* -----------------------------------------------
+ * Block-diagonal implementation of SUNLinearSolver
+ * ----------------------------------------------- */
+
+struct _SUNLinearSolverContent_BlockDiag {
+  sunindextype nblocks;    /* number of diagonal blocks                   */
+  sunindextype bs;         /* size of each block                          */
+  sunindextype nbatches;   /* ceil(nblocks/SUNBLOCKDIAG_BATCH)            */
+  realtype *lu;            /* LU factors, entry (i,j) of block w of batch
+                              g at lu[(g*bs*bs + j*bs + i)*BATCH + w]     */
+  sunindextype *pivots;    /* pivots, same interleaving as lu             */
+  realtype *work;          /* bs*SUNBLOCKDIAG_BATCH entries               */
+  sunindextype last_flag;
+};
+
+typedef struct _SUNLinearSolverContent_BlockDiag *SUNLinearSolverContent_BlockDiag;
+
+
+/* ----------------------------------------------
+ * Exported Functions for SUNLINSOL_BLOCKDIAG
+ * ---------------------------------------------- */
+
+SUNDIALS_EXPORT SUNLinearSolver SUNLinSol_BlockDiag(N_Vector y, SUNMatrix A);
+
+SUNDIALS_EXPORT SUNLinearSolver_Type SUNLinSolGetType_BlockDiag(SUNLinearSolver S);
+SUNDIALS_EXPORT SUNLinearSolver_ID SUNLinSolGetID_BlockDiag(SUNLinearSolver S);
+SUNDIALS_EXPORT int SUNLinSolInitialize_BlockDiag(SUNLinearSolver S);
+SUNDIALS_EXPORT int SUNLinSolSetup_BlockDiag(SUNLinearSolver S, SUNMatrix A);
+SUNDIALS_EXPORT int SUNLinSolSolve_BlockDiag(SUNLinearSolver S, SUNMatrix A,
+                                             N_Vector x, N_Vector b, realtype tol);
+SUNDIALS_EXPORT sunindextype SUNLinSolLastFlag_BlockDiag(SUNLinearSolver S);
+SUNDIALS_EXPORT int SUNLinSolSpace_BlockDiag(SUNLinearSolver S,
+                                             long int *lenrwLS,
+                                             long int *leniwLS);
+SUNDIALS_EXPORT int SUNLinSolFree_BlockDiag(SUNLinearSolver S);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
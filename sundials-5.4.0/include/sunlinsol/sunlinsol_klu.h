@@ -92,6 +92,7 @@ struct _SUNLinearSolverContent_KLU {
   int              last_flag;
   int              first_factorize;
   sun_klu_symbolic *symbolic;
+  int              own_symbolic;  /* 0 if symbolic is shared, see SUNLinSol_KLUSetSymbolic */
   sun_klu_numeric  *numeric;
   sun_klu_common   common;
   KLUSolveFn       klu_solver;
@@ -109,6 +110,8 @@ SUNDIALS_EXPORT int SUNLinSol_KLUReInit(SUNLinearSolver S, SUNMatrix A,
                                         sunindextype nnz, int reinit_type);
 SUNDIALS_EXPORT int SUNLinSol_KLUSetOrdering(SUNLinearSolver S,
                                              int ordering_choice);
+SUNDIALS_EXPORT int SUNLinSol_KLUSetSymbolic(SUNLinearSolver S,
+                                             sun_klu_symbolic *symbolic);
 
 /* deprecated */
 SUNDIALS_EXPORT SUNLinearSolver SUNKLU(N_Vector y, SUNMatrix A);
@@ -0,0 +1,118 @@
+/*
+ * -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the mixed precision iterative
+ * refinement implementation of the SUNLINSOL module,
+ * SUNLINSOL_MIXEDIR.
+ *
+ * The solver factors a SUNMATRIX_DENSE or SUNMATRIX_SPARSE matrix
+ * in single precision (double precision if realtype is extended)
+ * and recovers the accuracy of realtype by iterative refinement:
+ * the residual b - A x is computed with the original matrix and
+ * the correction is solved for with the low precision factors.
+ *
+ * Notes:
+ *   - The dense matrix is factored with partial pivoting, the
+ *     sparse one with a left-looking LU (threshold partial
+ *     pivoting, natural column order).
+ *   - The matrix passed to the solve has to be the one passed to
+ *     the setup, it is not overwritten by the factorization.
+ *   - The refinement only converges when the matrix is well enough
+ *     conditioned for the low precision, otherwise the solve fails
+ *     with the recoverable SUNLS_CONV_FAIL.
+ *   - The definition of the generic SUNLinearSolver structure can
+ *     be found in the header file sundials_linearsolver.h.
+ * -----------------------------------------------------------------
+ */
+
+#ifndef _SUNLINSOL_MIXEDIR_H
+#define _SUNLINSOL_MIXEDIR_H
+
+#include <sundials/sundials_linearsolver.h>
+#include <sundials/sundials_matrix.h>
+#include <sundials/sundials_nvector.h>
+#include <sunmatrix/sunmatrix_dense.h>
+#include <sunmatrix/sunmatrix_sparse.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/* Precision of the factorization */
+#if defined(SUNDIALS_EXTENDED_PRECISION)
+typedef double sunlowrealtype;
+#else
+typedef float sunlowrealtype;
+#endif
+
+/* Default maximum number of refinement steps */
+#define SUNMIXEDIR_MAXITERS_DEFAULT 10
+
+/* ---------------------------------------------
+ * Mixed precision implementation of SUNLinearSolver
+ * --------------------------------------------- */
+
+struct _SUNLinearSolverContent_MixedIR {
+  sunindextype N;
+  SUNMatrix_ID mat_id;       /* SUNMATRIX_DENSE or SUNMATRIX_SPARSE       */
+  int maxiters;              /* maximum number of refinement steps        */
+  int numiters;              /* refinement steps of the last solve        */
+  realtype resnorm;          /* last correction relative to the solution  */
+  N_Vector r;                /* residual b - A x                          */
+  sunlowrealtype *work;      /* N entries, right-hand side of the solves  */
+  sunindextype *pivots;      /* dense: pivot rows, sparse: pivot order of
+                                each row                                  */
+  sunlowrealtype *lu;        /* dense LU factors, N x N by columns        */
+  sunindextype *Ap, *Ai;     /* sparse: low precision copy of A, by       */
+  sunlowrealtype *Ax;        /*   columns                                 */
+  sunindextype Anzmax;
+  sunindextype *Lp, *Li;     /* sparse: unit lower factor L, by columns   */
+  sunlowrealtype *Lx;
+  sunindextype Lnzmax;
+  sunindextype *Up, *Ui;     /* sparse: upper factor U, by columns        */
+  sunlowrealtype *Ux;
+  sunindextype Unzmax;
+  sunindextype *xi;          /* sparse: 3N index work entries             */
+  sunindextype last_flag;
+};
+
+typedef struct _SUNLinearSolverContent_MixedIR *SUNLinearSolverContent_MixedIR;
+
+
+/* ---------------------------------------------
+ * Exported Functions for SUNLINSOL_MIXEDIR
+ * --------------------------------------------- */
+
+SUNDIALS_EXPORT SUNLinearSolver SUNLinSol_MixedIR(N_Vector y, SUNMatrix A);
+
+SUNDIALS_EXPORT int SUNLinSol_MixedIRSetMaxIters(SUNLinearSolver S,
+                                                 int maxiters);
+
+SUNDIALS_EXPORT SUNLinearSolver_Type SUNLinSolGetType_MixedIR(SUNLinearSolver S);
+SUNDIALS_EXPORT SUNLinearSolver_ID SUNLinSolGetID_MixedIR(SUNLinearSolver S);
+SUNDIALS_EXPORT int SUNLinSolInitialize_MixedIR(SUNLinearSolver S);
+SUNDIALS_EXPORT int SUNLinSolSetup_MixedIR(SUNLinearSolver S, SUNMatrix A);
+SUNDIALS_EXPORT int SUNLinSolSolve_MixedIR(SUNLinearSolver S, SUNMatrix A,
+                                           N_Vector x, N_Vector b, realtype tol);
+SUNDIALS_EXPORT int SUNLinSolNumIters_MixedIR(SUNLinearSolver S);
+SUNDIALS_EXPORT realtype SUNLinSolResNorm_MixedIR(SUNLinearSolver S);
+SUNDIALS_EXPORT sunindextype SUNLinSolLastFlag_MixedIR(SUNLinearSolver S);
+SUNDIALS_EXPORT int SUNLinSolSpace_MixedIR(SUNLinearSolver S,
+                                           long int *lenrwLS,
+                                           long int *leniwLS);
+SUNDIALS_EXPORT int SUNLinSolFree_MixedIR(SUNLinearSolver S);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the header file for the block-diagonal implementation of
+ * the SUNMATRIX module, SUNMATRIX_BLOCKDIAG.
+ *
+ * The matrix has nblocks dense diagonal blocks of size bs x bs and
+ * is used for an ensemble of independent systems of the same size,
+ * integrated together as one system of size nblocks*bs. Block b
+ * acts on the entries b*bs, ..., (b+1)*bs-1 of a vector. The blocks
+ * are stored one after the other, each one column-major.
+ *
+ * Notes:
+ *   - The definition of the generic SUNMatrix structure can be found
+ *     in the header file sundials_matrix.h.
+ * -----------------------------------------------------------------
+ */
+
+#ifndef _SUNMATRIX_BLOCKDIAG_H
+#define _SUNMATRIX_BLOCKDIAG_H
+
+#include <stdio.h>
+#include <sundials/sundials_matrix.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/* -------------------------------------------
+ * Block-diagonal implementation of SUNMatrix
+ * ------------------------------------------- */
+
+struct _SUNMatrixContent_BlockDiag {
+  sunindextype nblocks;  /* number of diagonal blocks       */
+  sunindextype bs;       /* rows and columns of each block  */
+  sunindextype ldata;    /* nblocks*bs*bs                   */
+  realtype *data;
+};
+
+typedef struct _SUNMatrixContent_BlockDiag *SUNMatrixContent_BlockDiag;
+
+
+/* -----------------------------------------
+ * Macros for access to SUNMATRIX_BLOCKDIAG
+ * ----------------------------------------- */
+
+#define SM_CONTENT_BD(A)     ( (SUNMatrixContent_BlockDiag)(A->content) )
+
+#define SM_NBLOCKS_BD(A)     ( SM_CONTENT_BD(A)->nblocks )
+
+#define SM_BLOCKSIZE_BD(A)   ( SM_CONTENT_BD(A)->bs )
+
+#define SM_ROWS_BD(A)        ( SM_NBLOCKS_BD(A) * SM_BLOCKSIZE_BD(A) )
+
+#define SM_LDATA_BD(A)       ( SM_CONTENT_BD(A)->ldata )
+
+#define SM_DATA_BD(A)        ( SM_CONTENT_BD(A)->data )
+
+#define SM_BLOCK_BD(A,b)     ( SM_DATA_BD(A) + (b)*SM_BLOCKSIZE_BD(A)*SM_BLOCKSIZE_BD(A) )
+
+#define SM_ELEMENT_BD(A,b,i,j) ( SM_BLOCK_BD(A,b)[(j)*SM_BLOCKSIZE_BD(A)+(i)] )
+
+
+/* ---------------------------------------------
+ * Exported Functions for SUNMATRIX_BLOCKDIAG
+ * --------------------------------------------- */
+
+SUNDIALS_EXPORT SUNMatrix SUNBlockDiagMatrix(sunindextype nblocks,
+                                             sunindextype bs);
+
+SUNDIALS_EXPORT void SUNBlockDiagMatrix_Print(SUNMatrix A, FILE* outfile);
+
+SUNDIALS_EXPORT sunindextype SUNBlockDiagMatrix_NumBlocks(SUNMatrix A);
+SUNDIALS_EXPORT sunindextype SUNBlockDiagMatrix_BlockSize(SUNMatrix A);
+SUNDIALS_EXPORT sunindextype SUNBlockDiagMatrix_Rows(SUNMatrix A);
+SUNDIALS_EXPORT sunindextype SUNBlockDiagMatrix_Columns(SUNMatrix A);
+SUNDIALS_EXPORT sunindextype SUNBlockDiagMatrix_LData(SUNMatrix A);
+SUNDIALS_EXPORT realtype* SUNBlockDiagMatrix_Data(SUNMatrix A);
+SUNDIALS_EXPORT realtype* SUNBlockDiagMatrix_Block(SUNMatrix A, sunindextype b);
+
+SUNDIALS_EXPORT SUNMatrix_ID SUNMatGetID_BlockDiag(SUNMatrix A);
+SUNDIALS_EXPORT SUNMatrix SUNMatClone_BlockDiag(SUNMatrix A);
+SUNDIALS_EXPORT void SUNMatDestroy_BlockDiag(SUNMatrix A);
+SUNDIALS_EXPORT int SUNMatZero_BlockDiag(SUNMatrix A);
+SUNDIALS_EXPORT int SUNMatCopy_BlockDiag(SUNMatrix A, SUNMatrix B);
+SUNDIALS_EXPORT int SUNMatScaleAdd_BlockDiag(realtype c, SUNMatrix A, SUNMatrix B);
+SUNDIALS_EXPORT int SUNMatScaleAddI_BlockDiag(realtype c, SUNMatrix A);
+SUNDIALS_EXPORT int SUNMatMatvec_BlockDiag(SUNMatrix A, N_Vector x, N_Vector y);
+SUNDIALS_EXPORT int SUNMatSpace_BlockDiag(SUNMatrix A, long int *lenrw, long int *leniw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -68,6 +68,16 @@ struct _SUNMatrixContent_Sparse {
   /* CSR indices */
   sunindextype **colvals;
   sunindextype **rowptrs;
+  /* threads of the matrix-vector products */
+  int num_threads;
+  /* cached transpose: the pattern in the other format (tptrs, tvals)
+     and the position in data of each of its entries (tmap), valid
+     while tnnz = indexptrs[NP] */
+  booleantype tcache;
+  sunindextype tnnz;
+  sunindextype *tptrs;
+  sunindextype *tvals;
+  sunindextype *tmap;
 };
 
 typedef struct _SUNMatrixContent_Sparse *SUNMatrixContent_Sparse;
@@ -110,8 +120,11 @@ SUNDIALS_EXPORT SUNMatrix SUNSparseFromBandMatrix(SUNMatrix A,
                                                   realtype droptol,
                                                   int sparsetype);
 
+SUNDIALS_EXPORT int SUNSparseMatrix_CopyFromDense(SUNMatrix Ad, SUNMatrix As);
+
 SUNDIALS_EXPORT int SUNSparseMatrix_ToCSR(const SUNMatrix A, SUNMatrix* Bout);
 SUNDIALS_EXPORT int SUNSparseMatrix_ToCSC(const SUNMatrix A, SUNMatrix* Bout);
+SUNDIALS_EXPORT int SUNSparseMatrix_Convert(const SUNMatrix A, SUNMatrix B);
 
 SUNDIALS_EXPORT int SUNSparseMatrix_Realloc(SUNMatrix A);
 
@@ -119,6 +132,14 @@ SUNDIALS_EXPORT int SUNSparseMatrix_Reallocate(SUNMatrix A, sunindextype NNZ);
 
 SUNDIALS_EXPORT void SUNSparseMatrix_Print(SUNMatrix A, FILE* outfile);
 
+SUNDIALS_EXPORT int SUNSparseMatrix_SetNumThreads(SUNMatrix A, int num_threads);
+SUNDIALS_EXPORT int SUNSparseMatrix_CacheTranspose(SUNMatrix A,
+                                                   booleantype onoff);
+SUNDIALS_EXPORT int SUNSparseMatrix_MatvecTranspose(SUNMatrix A, N_Vector x,
+                                                    N_Vector y);
+SUNDIALS_EXPORT int SUNSparseMatrix_MatvecMulti(SUNMatrix A, int nvec,
+                                                N_Vector* X, N_Vector* Y);
+
 SUNDIALS_EXPORT sunindextype SUNSparseMatrix_Rows(SUNMatrix A);
 SUNDIALS_EXPORT sunindextype SUNSparseMatrix_Columns(SUNMatrix A);
 SUNDIALS_EXPORT sunindextype SUNSparseMatrix_NNZ(SUNMatrix A);
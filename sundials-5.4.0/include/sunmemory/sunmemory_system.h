@@ -0,0 +1,69 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * SUNDIALS system (host) memory helper with a size-class pool.
+ *
+ * Blocks are rounded up to a power of two and a freed block is kept
+ * on the free list of its size class, so objects created and
+ * destroyed over and over (the work vectors of short-lived
+ * integrators, the Krylov bases of the iterative linear solvers)
+ * reuse the same memory instead of going back to malloc.
+ *
+ * The serial and OpenMP vectors created with N_VNewWithMemHelp_*
+ * take their data arrays from a memory helper, and so do all of
+ * their clones. The helper is not thread safe, a helper must not
+ * be used by several threads at the same time.
+ * ----------------------------------------------------------------*/
+
+#ifndef _SUNDIALS_SYSMEMORY_H
+#define _SUNDIALS_SYSMEMORY_H
+
+#include <sundials/sundials_memory.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+
+/* Implementation specific functions */
+
+SUNDIALS_EXPORT SUNMemoryHelper SUNMemoryHelper_Sys();
+
+/* Release all the cached blocks */
+SUNDIALS_EXPORT int SUNMemoryHelper_SysTrim(SUNMemoryHelper helper);
+
+/* Pool statistics: number of allocation requests, number of them
+   served from the pool, and bytes currently cached */
+SUNDIALS_EXPORT int SUNMemoryHelper_SysGetStats(SUNMemoryHelper helper,
+                                                long int* nalloc,
+                                                long int* nreuse,
+                                                size_t* cached);
+
+/* SUNMemoryHelper functions */
+
+SUNDIALS_EXPORT int SUNMemoryHelper_Alloc_Sys(SUNMemoryHelper helper, SUNMemory* memptr,
+                                              size_t memsize, SUNMemoryType mem_type);
+
+SUNDIALS_EXPORT int SUNMemoryHelper_Dealloc_Sys(SUNMemoryHelper helper, SUNMemory mem);
+
+SUNDIALS_EXPORT int SUNMemoryHelper_Copy_Sys(SUNMemoryHelper helper, SUNMemory dst,
+                                             SUNMemory src, size_t memory_size);
+
+SUNDIALS_EXPORT SUNMemoryHelper SUNMemoryHelper_Clone_Sys(SUNMemoryHelper helper);
+
+SUNDIALS_EXPORT int SUNMemoryHelper_Destroy_Sys(SUNMemoryHelper helper);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,11 +25,17 @@
 #include "sundials/sundials_types.h"
 #include "sundials/sundials_nvector.h"
 #include "sundials/sundials_nonlinearsolver.h"
+#include "sundials/sundials_iterative.h"
 
 #ifdef __cplusplus  /* wrapper to enable C++ usage */
 extern "C" {
 #endif
 
+/* QR update used by Anderson acceleration */
+#define SUN_NLS_ORTH_MGS   0
+#define SUN_NLS_ORTH_CGS2  1
+#define SUN_NLS_ORTH_DCGS2 2
+
 /*-----------------------------------------------------------------------------
   I. Content structure
   ---------------------------------------------------------------------------*/
@@ -45,6 +51,7 @@ struct _SUNNonlinearSolverContent_FixedPoint {
   int         *imap;       /* array of length m                              */
   booleantype  damping;    /* flag to apply dampling in acceleration         */
   realtype     beta;       /* damping paramter                               */
+  QRAddFn      qradd;      /* QR update of the acceleration subspace         */
   realtype    *R;          /* array of length m*m                            */
   realtype    *gamma;      /* array of length m                              */
   realtype    *cvals;      /* array of length m+1 for fused vector op        */
@@ -105,6 +112,9 @@ SUNDIALS_EXPORT int SUNNonlinSolSetMaxIters_FixedPoint(SUNNonlinearSolver NLS,
 SUNDIALS_EXPORT int SUNNonlinSolSetDamping_FixedPoint(SUNNonlinearSolver NLS,
                                                       realtype beta);
 
+SUNDIALS_EXPORT int SUNNonlinSolSetOrthAA_FixedPoint(SUNNonlinearSolver NLS,
+                                                     int orthaa);
+
 /* get functions */
 SUNDIALS_EXPORT int SUNNonlinSolGetNumIters_FixedPoint(SUNNonlinearSolver NLS,
                                                        long int *niters);
@@ -35,6 +35,55 @@
 #define ONE    RCONST(1.0)
 
 
+/*---------------------------------------------------------------
+  Low-storage (2N) methods in Williamson form,
+
+    dU_i = A_i dU_{i-1} + h f(t_n + c_i h, U_i),  U_{i+1} = U_i + B_i dU_i
+
+  with A_0 = 0 and U_0 = y_n. d holds the embedding weights of the
+  equivalent Butcher table. The embeddings are not part of the
+  published methods: Williamson 3(2) uses d = [1/8, 3/8, 1/2], and
+  Carpenter-Kennedy 5(3) uses d = dmin - 5 (b - dmin), with dmin
+  the least-norm third order weights. The least-norm weights alone
+  give an error estimate well below the actual error.
+  ---------------------------------------------------------------*/
+typedef struct {
+  int stages, q, p;
+  realtype A[ERK_LS_MAXSTAGES];
+  realtype B[ERK_LS_MAXSTAGES];
+  realtype d[ERK_LS_MAXSTAGES];
+} erkStepLSTable;
+
+static const erkStepLSTable erkStepLSTables[] = {
+
+  /* LSRK_WILLIAMSON_3_2_3 (Williamson, J. Comput. Phys. 35, 1980) */
+  { 3, 3, 2,
+    { RCONST(0.0), RCONST(-5.0)/RCONST(9.0), RCONST(-153.0)/RCONST(128.0) },
+    { RCONST(1.0)/RCONST(3.0), RCONST(15.0)/RCONST(16.0),
+      RCONST(8.0)/RCONST(15.0) },
+    { RCONST(1.0)/RCONST(8.0), RCONST(3.0)/RCONST(8.0),
+      RCONST(1.0)/RCONST(2.0) } },
+
+  /* LSRK_CARPENTER_KENNEDY_5_3_4 (Carpenter & Kennedy, NASA TM-109112, 1994) */
+  { 5, 4, 3,
+    { RCONST(0.0),
+      RCONST(-567301805773.0)/RCONST(1357537059087.0),
+      RCONST(-2404267990393.0)/RCONST(2016746695238.0),
+      RCONST(-3550918686646.0)/RCONST(2091501179385.0),
+      RCONST(-1275806237668.0)/RCONST(842570457699.0) },
+    { RCONST(1432997174477.0)/RCONST(9575080441755.0),
+      RCONST(5161836677717.0)/RCONST(13612068292357.0),
+      RCONST(1720146321549.0)/RCONST(2090206949498.0),
+      RCONST(3134564353537.0)/RCONST(4481467310338.0),
+      RCONST(2277821191437.0)/RCONST(14882151754819.0) },
+    { RCONST(0.6428880590564304233200243),
+      RCONST(-1.025534873979523428029988),
+      RCONST(0.9990489161774751372706265),
+      RCONST(0.2504658818541496127873580),
+      RCONST(0.1331320168914682546519793) } }
+};
+
+
 /*===============================================================
   ERKStep Exported functions -- Required
   ===============================================================*/
@@ -543,10 +592,11 @@ int erkStep_Init(void* arkode_mem, int init_type)
   }
 
   /* Allocate ARK RHS vector memory, update storage requirements */
-  /*   Allocate F[0] ... F[stages-1] if needed */
+  /*   Allocate F[0] ... F[stages-1] if needed, the low-storage
+       mode only keeps F[0] */
   if (step_mem->F == NULL)
     step_mem->F = (N_Vector *) calloc(step_mem->stages, sizeof(N_Vector));
-  for (j=0; j<step_mem->stages; j++) {
+  for (j=0; j<(step_mem->lowstorage ? 1 : step_mem->stages); j++) {
     if (!arkAllocVec(ark_mem, ark_mem->ewt, &(step_mem->F[j])))
       return(ARK_MEM_FAIL);
   }
@@ -731,6 +781,16 @@ int erkStep_TakeStep(void* arkode_mem, realtype *dsmPtr, int *nflagPtr)
                                  &ark_mem, &step_mem);
   if (retval != ARK_SUCCESS) return(retval);
 
+  /* low-storage methods use their own stage recursion */
+  if (step_mem->lowstorage) {
+    retval = erkStep_TakeStepLowStorage(ark_mem, dsmPtr);
+    if (retval != ARK_SUCCESS) return(retval);
+    if (ark_mem->report)
+      fprintf(ark_mem->diagfp, "ERKStep  etest  %li  %"RSYM"  %"RSYM"\n",
+              ark_mem->nst, ark_mem->h, *dsmPtr);
+    return(ARK_SUCCESS);
+  }
+
   /* local shortcuts for fused vector operations */
   cvals = step_mem->cvals;
   Xvecs = step_mem->Xvecs;
@@ -1099,6 +1159,154 @@ int erkStep_ComputeSolutions(ARKodeMem ark_mem, realtype *dsmPtr)
   return(ARK_SUCCESS);
 }
 
+
+/*---------------------------------------------------------------
+  erkStep_SetLowStorageTable
+
+  Loads low-storage method lsnum: stores its 2N coefficients, the
+  equivalent Butcher table in step_mem->B, and the weights lsG of
+  the error estimate. With e = b - d the error is
+
+    y - yhat = sum_i e_i h F_i = sum_i (e_i - A_{i+1} e_{i+1}) dU_i,
+
+  since h F_i = dU_i - A_i dU_{i-1}, so it is accumulated from the
+  increments dU_i together with the solution.
+  ---------------------------------------------------------------*/
+int erkStep_SetLowStorageTable(ARKodeMem ark_mem, int lsnum)
+{
+  int i, j, m, s;
+  realtype alpha[ERK_LS_MAXSTAGES][ERK_LS_MAXSTAGES];
+  const erkStepLSTable *T;
+  ARKodeERKStepMem step_mem;
+  ARKodeButcherTable B;
+
+  step_mem = (ARKodeERKStepMem) ark_mem->step_mem;
+  T = &erkStepLSTables[lsnum - MIN_LSRK_NUM];
+  s = T->stages;
+
+  B = ARKodeButcherTable_Alloc(s, SUNTRUE);
+  if (B == NULL) return(ARK_MEM_FAIL);
+  B->q = T->q;
+  B->p = T->p;
+
+  /* dU_i = sum_j alpha_ij h F_j, alpha_ii = 1, alpha_ij = A_i alpha_i-1,j */
+  for (i=0; i<s; i++) {
+    for (j=0; j<s; j++) alpha[i][j] = ZERO;
+    alpha[i][i] = ONE;
+    for (j=0; j<i; j++) alpha[i][j] = T->A[i] * alpha[i-1][j];
+  }
+
+  /* U_i = y_n + sum_{m<i} B_m dU_m */
+  for (i=0; i<s; i++) {
+    B->c[i] = ZERO;
+    for (j=0; j<i; j++) {
+      B->A[i][j] = ZERO;
+      for (m=j; m<i; m++) B->A[i][j] += T->B[m] * alpha[m][j];
+      B->c[i] += B->A[i][j];
+    }
+  }
+  for (j=0; j<s; j++) {
+    B->b[j] = ZERO;
+    for (m=j; m<s; m++) B->b[j] += T->B[m] * alpha[m][j];
+    B->d[j] = T->d[j];
+  }
+
+  /* error weights on the increments */
+  for (i=0; i<s; i++) {
+    step_mem->lsG[i] = B->b[i] - B->d[i];
+    if (i+1 < s)
+      step_mem->lsG[i] -= T->A[i+1] * (B->b[i+1] - B->d[i+1]);
+  }
+
+  step_mem->B = B;
+  step_mem->lsA = T->A;
+  step_mem->lsB = T->B;
+  step_mem->lowstorage = SUNTRUE;
+
+  return(ARK_SUCCESS);
+}
+
+
+/*---------------------------------------------------------------
+  erkStep_TakeStepLowStorage
+
+  One step of a low-storage method. The stage value U_i is kept in
+  ycur, the increment dU in tempv2, the stage RHS in tempv3 and the
+  error estimate in tempv1, so the memory does not grow with the
+  number of stages. After the RHS evaluation each stage is two
+  passes over memory: dU = A_i dU + h F, then a fused update of
+  ycur and the error estimate from dU.
+  ---------------------------------------------------------------*/
+int erkStep_TakeStepLowStorage(ARKodeMem ark_mem, realtype *dsmPtr)
+{
+  int retval, is;
+  booleantype adapt;
+  realtype h, cvals[2];
+  N_Vector dU, Fs, yerr, Yvecs[2];
+  ARKodeERKStepMem step_mem;
+
+  step_mem = (ARKodeERKStepMem) ark_mem->step_mem;
+
+  h     = ark_mem->h;
+  yerr  = ark_mem->tempv1;
+  dU    = ark_mem->tempv2;
+  Fs    = ark_mem->tempv3;
+  adapt = !ark_mem->fixedstep;
+
+  *dsmPtr = ZERO;
+
+  /* first stage, F[0] = f(t_n, y_n) */
+  N_VScale(h, step_mem->F[0], dU);
+  N_VLinearSum(ONE, ark_mem->yn, step_mem->lsB[0], dU, ark_mem->ycur);
+  if (adapt) N_VScale(step_mem->lsG[0], dU, yerr);
+
+  Yvecs[0] = ark_mem->ycur;
+  Yvecs[1] = yerr;
+
+  for (is=1; is<step_mem->stages; is++) {
+
+    /* Set current stage time */
+    ark_mem->tcur = ark_mem->tn + step_mem->B->c[is]*h;
+
+    /* Solver diagnostics reporting */
+    if (ark_mem->report)
+      fprintf(ark_mem->diagfp, "ERKStep  step  %li  %"RSYM"  %i  %"RSYM"\n",
+              ark_mem->nst, h, is, ark_mem->tcur);
+
+    /* apply user-supplied stage postprocessing function (if supplied) */
+    if (ark_mem->ProcessStage != NULL) {
+      retval = ark_mem->ProcessStage(ark_mem->tcur,
+                                     ark_mem->ycur,
+                                     ark_mem->user_data);
+      if (retval != 0) return(ARK_POSTPROCESS_STAGE_FAIL);
+    }
+
+    /* compute stage RHS */
+    retval = step_mem->f(ark_mem->tcur, ark_mem->ycur, Fs,
+                         ark_mem->user_data);
+    step_mem->nfe++;
+    if (retval < 0)  return(ARK_RHSFUNC_FAIL);
+    if (retval > 0)  return(ARK_UNREC_RHSFUNC_ERR);
+
+    /* dU = A_i dU + h F_i */
+    N_VLinearSum(step_mem->lsA[is], dU, h, Fs, dU);
+
+    /* ycur += B_i dU and yerr += G_i dU in a single pass */
+    if (adapt) {
+      cvals[0] = step_mem->lsB[is];
+      cvals[1] = step_mem->lsG[is];
+      retval = N_VScaleAddMulti(2, cvals, dU, Yvecs, Yvecs);
+      if (retval != 0) return(ARK_VECTOROP_ERR);
+    } else {
+      N_VLinearSum(ONE, ark_mem->ycur, step_mem->lsB[is], dU, ark_mem->ycur);
+    }
+  }
+
+  if (adapt) *dsmPtr = N_VWrmsNorm(yerr, ark_mem->ewt);
+
+  return(ARK_SUCCESS);
+}
+
 /*===============================================================
   EOF
   ===============================================================*/
@@ -30,6 +30,8 @@ extern "C" {
   arkode_impl.h
   ===============================================================*/
 
+/* Maximum number of stages of the low-storage methods */
+#define ERK_LS_MAXSTAGES 5
 
 
 /*===============================================================
@@ -62,6 +64,13 @@ typedef struct ARKodeERKStepMemRec {
   realtype* cvals;
   N_Vector* Xvecs;
 
+  /* Low-storage (2N) mode: B holds the equivalent Butcher table,
+     only F[0] is allocated and the stages run in ark_mem->tempv* */
+  booleantype     lowstorage;             /* use the 2N recursion      */
+  const realtype *lsA;                    /* 2N coefficients A_i       */
+  const realtype *lsB;                    /* 2N coefficients B_i       */
+  realtype lsG[ERK_LS_MAXSTAGES];         /* error weights on dU_i     */
+
 } *ARKodeERKStepMem;
 
 
@@ -82,6 +91,8 @@ booleantype erkStep_CheckNVector(N_Vector tmpl);
 int erkStep_SetButcherTable(ARKodeMem ark_mem);
 int erkStep_CheckButcherTable(ARKodeMem ark_mem);
 int erkStep_ComputeSolutions(ARKodeMem ark_mem, realtype *dsm);
+int erkStep_SetLowStorageTable(ARKodeMem ark_mem, int lsnum);
+int erkStep_TakeStepLowStorage(ARKodeMem ark_mem, realtype *dsm);
 
 /*===============================================================
   Reusable ERKStep Error Messages
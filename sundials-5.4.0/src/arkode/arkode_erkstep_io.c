@@ -197,6 +197,7 @@ int ERKStepSetDefaults(void* arkode_mem)
   ark_mem->hadapt_mem->k2      = RCONST(0.31); /* step adaptivity parameter */
   step_mem->stages = 0;                        /* no stages */
   step_mem->B = NULL;                          /* no Butcher table */
+  step_mem->lowstorage = SUNFALSE;             /* full-storage ERK */
   return(ARK_SUCCESS);
 }
 
@@ -229,6 +230,7 @@ int ERKStepSetOrder(void *arkode_mem, int ord)
      or a reset to defaults.  Tables will be set in ARKInitialSetup. */
   step_mem->stages = 0;
   step_mem->p = 0;
+  step_mem->lowstorage = SUNFALSE;
 
   ARKodeButcherTable_Space(step_mem->B, &Bliw, &Blrw);
   ARKodeButcherTable_Free(step_mem->B);
@@ -274,6 +276,7 @@ int ERKStepSetTable(void *arkode_mem, ARKodeButcherTable B)
   step_mem->stages = 0;
   step_mem->q = 0;
   step_mem->p = 0;
+  step_mem->lowstorage = SUNFALSE;
 
   ARKodeButcherTable_Space(step_mem->B, &Bliw, &Blrw);
   ARKodeButcherTable_Free(step_mem->B);
@@ -333,6 +336,7 @@ int ERKStepSetTableNum(void *arkode_mem, int itable)
   step_mem->stages = 0;
   step_mem->q = 0;
   step_mem->p = 0;
+  step_mem->lowstorage = SUNFALSE;
 
   ARKodeButcherTable_Space(step_mem->B, &Bliw, &Blrw);
   ARKodeButcherTable_Free(step_mem->B);
@@ -360,6 +364,69 @@ int ERKStepSetTableNum(void *arkode_mem, int itable)
 }
 
 
+/*---------------------------------------------------------------
+  ERKStepSetLowStorageMethod:
+
+  Specifies to use a low-storage (2N) method, based on the integer
+  flag LSRK_* in arkode_erkstep.h. The stages are computed with
+  the 2N recursion, so that the vector storage does not depend on
+  the number of stages. ERKStepGetCurrentButcherTable returns the
+  equivalent Butcher table. A negative lsnum switches back to the
+  default full-storage method of the current order.
+  ---------------------------------------------------------------*/
+int ERKStepSetLowStorageMethod(void *arkode_mem, int lsnum)
+{
+  ARKodeMem ark_mem;
+  ARKodeERKStepMem step_mem;
+  sunindextype Blrw, Bliw;
+  int retval;
+
+  /* access ARKodeERKStepMem structure */
+  retval = erkStep_AccessStepMem(arkode_mem, "ERKStepSetLowStorageMethod",
+                                 &ark_mem, &step_mem);
+  if (retval != ARK_SUCCESS) return(retval);
+
+  /* check that argument specifies a low-storage method */
+  if (lsnum > MAX_LSRK_NUM || (lsnum >= 0 && lsnum < MIN_LSRK_NUM)) {
+    arkProcessError(ark_mem, ARK_ILL_INPUT, "ARKode::ERKStep",
+                    "ERKStepSetLowStorageMethod",
+                    "Illegal low-storage method number");
+    return(ARK_ILL_INPUT);
+  }
+
+  /* clear any existing parameters and Butcher tables */
+  step_mem->stages = 0;
+  step_mem->p = 0;
+  step_mem->lowstorage = SUNFALSE;
+
+  ARKodeButcherTable_Space(step_mem->B, &Bliw, &Blrw);
+  ARKodeButcherTable_Free(step_mem->B);
+  step_mem->B = NULL;
+  ark_mem->liw -= Bliw;
+  ark_mem->lrw -= Blrw;
+
+  /* back to the default table of the current order */
+  if (lsnum < 0) return(ARK_SUCCESS);
+
+  retval = erkStep_SetLowStorageTable(ark_mem, lsnum);
+  if (retval != ARK_SUCCESS) {
+    arkProcessError(ark_mem, retval, "ARKode::ERKStep",
+                    "ERKStepSetLowStorageMethod",
+                    "Error setting low-storage method");
+    return(retval);
+  }
+  step_mem->stages = step_mem->B->stages;
+  step_mem->q = step_mem->B->q;
+  step_mem->p = step_mem->B->p;
+
+  ARKodeButcherTable_Space(step_mem->B, &Bliw, &Blrw);
+  ark_mem->liw += Bliw;
+  ark_mem->lrw += Blrw;
+
+  return(ARK_SUCCESS);
+}
+
+
 /*===============================================================
   ERKStep optional output functions -- stepper-specific
   ===============================================================*/
@@ -52,6 +52,7 @@
      imeth                       order   type    QP
     ------------------------------------------------
      MIS_KW3                     3       E       Y
+     MRI_GARK_ERK33a             3       E       Y
      MRI_GARK_ERK45a             4       E       Y?
      MRI_GARK_IRK21a             2       ID      Y
      MRI_GARK_ESDIRK34a          4       ID      N?
@@ -76,6 +77,24 @@ MRIStepCoupling MRIStepCoupling_LoadTable(int imethod)
     ARKodeButcherTable_Free(B);
     break;
 
+  case(MRI_GARK_ERK33a):      /* A. Sandu, SINUM 57:2300-2327, 2019 */
+    C = MRIStepCoupling_Alloc(2,4);
+    C->q = 3;
+    C->p = 0;
+    C->c[1] = ONE/RCONST(3.0);
+    C->c[2] = TWO/RCONST(3.0);
+    C->c[3] = ONE;
+
+    C->G[0][1][0] = ONE/RCONST(3.0);
+    C->G[0][2][0] = -ONE/RCONST(3.0);
+    C->G[0][2][1] = TWO/RCONST(3.0);
+    C->G[0][3][1] = -TWO/RCONST(3.0);
+    C->G[0][3][2] = ONE;
+
+    C->G[1][3][0] = HALF;
+    C->G[1][3][2] = -HALF;
+    break;
+
   case(MRI_GARK_ERK45a):      /* A. Sandu, SINUM 57:2300-2327, 2019 */
     C = MRIStepCoupling_Alloc(2,6);
     C->q = 4;
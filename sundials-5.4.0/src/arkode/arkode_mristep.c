@@ -190,6 +190,48 @@ void* MRIStepCreate(ARKRhsFn fs, realtype t0, N_Vector y0,
 }
 
 
+/*---------------------------------------------------------------
+  Create MRIStep integrator memory struct together with the
+  ARKStep integrator of the fast partition
+  ---------------------------------------------------------------*/
+void* MRIStepCreateFastSlow(ARKRhsFn fs, ARKRhsFn ffe, ARKRhsFn ffi,
+                            realtype t0, N_Vector y0)
+{
+  void             *arkode_mem;      /* outer ARKode memory  */
+  void             *inner_mem;       /* fast ARKStep memory  */
+  ARKodeMRIStepMem  step_mem;        /* outer stepper memory */
+
+  /* Check that the fast RHS is supplied */
+  if ((ffe == NULL) && (ffi == NULL)) {
+    arkProcessError(NULL, ARK_ILL_INPUT, "ARKode::MRIStep",
+                    "MRIStepCreateFastSlow", MSG_ARK_NULL_F);
+    return(NULL);
+  }
+
+  /* Create the fast integrator */
+  inner_mem = ARKStepCreate(ffe, ffi, t0, y0);
+  if (inner_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_FAIL, "ARKode::MRIStep",
+                    "MRIStepCreateFastSlow",
+                    "Unable to create the fast integrator");
+    return(NULL);
+  }
+
+  /* Create the slow integrator */
+  arkode_mem = MRIStepCreate(fs, t0, y0, MRISTEP_ARKSTEP, inner_mem);
+  if (arkode_mem == NULL) {
+    ARKStepFree(&inner_mem);
+    return(NULL);
+  }
+
+  /* the fast integrator is freed with the slow one */
+  step_mem = (ARKodeMRIStepMem) ((ARKodeMem) arkode_mem)->step_mem;
+  step_mem->inner_own = SUNTRUE;
+
+  return(arkode_mem);
+}
+
+
 /*---------------------------------------------------------------
   MRIStepResize:
 
@@ -410,6 +452,12 @@ int MRIStepReset(void* arkode_mem, realtype tR, N_Vector yR)
     return(retval);
   }
 
+  /* Reset a fast integrator created by MRIStepCreateFastSlow */
+  if (step_mem->inner_own) {
+    retval = step_mem->inner_reset(step_mem->inner_mem, tR, yR);
+    if (retval != ARK_SUCCESS)  return(ARK_INNERSTEP_FAIL);
+  }
+
   return(ARK_SUCCESS);
 }
 
@@ -633,6 +681,12 @@ void MRIStepFree(void **arkode_mem)
       ark_mem->liw -= (step_mem->stages + 1);
     }
 
+    /* free a fast integrator created by MRIStepCreateFastSlow */
+    if (step_mem->inner_own) {
+      ARKStepFree(&(step_mem->inner_mem));
+      step_mem->inner_own = SUNFALSE;
+    }
+
     /* free the time stepper module itself */
     free(ark_mem->step_mem);
     ark_mem->step_mem = NULL;
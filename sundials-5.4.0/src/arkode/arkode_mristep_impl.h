@@ -132,6 +132,7 @@ typedef struct ARKodeMRIStepMemRec {
   int                inner_num_forcing; /* number of RHS forcing vectors   */
   int                inner_retval;      /* last inner stepper return value */
   MRISTEP_ID         inner_stepper_id;  /* inner stepper identifier        */
+  booleantype        inner_own;         /* inner stepper created by MRIStep */
 
   /* Inner-stepper-supplied functions */
   MRIStepSetInnerForcingFn inner_setforcing; /* set inner forcing data  */
@@ -224,6 +224,12 @@ int MRIStepSetUserData(void *arkode_mem, void *user_data)
     if (retval != ARKLS_SUCCESS) return(retval);
   }
 
+  /* the fast RHS of MRIStepCreateFastSlow gets the same user data */
+  if (step_mem->inner_own) {
+    retval = ARKStepSetUserData(step_mem->inner_mem, user_data);
+    if (retval != ARK_SUCCESS) return(retval);
+  }
+
   return(ARK_SUCCESS);
 }
 
@@ -890,6 +896,30 @@ int MRIStepGetLastInnerStepFlag(void *arkode_mem, int *flag)
 }
 
 
+/*---------------------------------------------------------------
+  MRIStepGetInnerStepper:
+
+  Returns the memory of the inner (fast) stepper, e.g. to set the
+  fast step size, tolerances or linear solver of the integrator
+  created by MRIStepCreateFastSlow.
+  ---------------------------------------------------------------*/
+int MRIStepGetInnerStepper(void *arkode_mem, void **inner_arkode_mem)
+{
+  ARKodeMem ark_mem;
+  ARKodeMRIStepMem step_mem;
+  int retval;
+
+  /* access ARKodeMRIStepMem structure */
+  retval = mriStep_AccessStepMem(arkode_mem, "MRIStepGetInnerStepper",
+                                 &ark_mem, &step_mem);
+  if (retval != ARK_SUCCESS) return(retval);
+
+  *inner_arkode_mem = step_mem->inner_mem;
+
+  return(ARK_SUCCESS);
+}
+
+
 /*---------------------------------------------------------------
   MRIStepGetCurrentGamma: Returns the current value of gamma
   ---------------------------------------------------------------*/
@@ -0,0 +1,614 @@
+/* -----------------------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------------------
+ * This is the implementation file for ARKODE's Parareal driver.
+ * ---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "arkode_parareal_impl.h"
+#include <sundials/sundials_math.h>
+
+#define ZERO RCONST(0.0)
+#define ONE  RCONST(1.0)
+
+#define MSG_PR_NO_MEM  "pr_mem = NULL illegal."
+
+
+/*===============================================================
+  Private functions
+  ===============================================================*/
+
+/* Time of slice interface n */
+static realtype arkPR_SliceTime(ARKPararealMem pr, int n)
+{
+  if (n == pr->nslices) return(pr->tf);
+  return(pr->t0 + (pr->tf - pr->t0) * n / pr->nslices);
+}
+
+
+/* Free an integrator made by the user create function */
+static void arkPR_FreeIntegrator(ARKPararealMem pr, void **arkode_mem)
+{
+  if (*arkode_mem == NULL) return;
+  if (pr->free_fn != NULL)
+    pr->free_fn(arkode_mem, pr->user_data);
+  else
+    ARKStepFree(arkode_mem);
+  *arkode_mem = NULL;
+}
+
+
+/* Free the fine integrators */
+static void arkPR_FreeFine(ARKPararealMem pr)
+{
+  int i;
+
+  if (pr->fine == NULL) return;
+  for (i=0; i<pr->nfinemem; i++)
+    arkPR_FreeIntegrator(pr, &(pr->fine[i]));
+  free(pr->fine);
+  pr->fine = NULL;
+  pr->nfinemem = 0;
+}
+
+
+/*---------------------------------------------------------------
+  arkPR_Propagate
+
+  Integrates y from t0 to t1 with the given ARKStep integrator
+  and returns the number of steps taken in nsteps.
+  ---------------------------------------------------------------*/
+static int arkPR_Propagate(void *arkode_mem, realtype t0, realtype t1,
+                           N_Vector y, long int *nsteps)
+{
+  int retval;
+  long int nst0, nst1;
+  realtype tret;
+
+  *nsteps = 0;
+
+  /* the step counter is not reset by ARKStepReset */
+  retval = ARKStepGetNumSteps(arkode_mem, &nst0);
+  if (retval != ARK_SUCCESS) return(retval);
+
+  retval = ARKStepReset(arkode_mem, t0, y);
+  if (retval != ARK_SUCCESS) return(retval);
+
+  retval = ARKStepSetStopTime(arkode_mem, t1);
+  if (retval != ARK_SUCCESS) return(retval);
+
+  retval = ARKStepEvolve(arkode_mem, t1, y, &tret, ARK_NORMAL);
+  if (retval < 0) return(retval);
+
+  retval = ARKStepGetNumSteps(arkode_mem, &nst1);
+  if (retval != ARK_SUCCESS) return(retval);
+
+  *nsteps = nst1 - nst0;
+  return(ARK_SUCCESS);
+}
+
+
+/*---------------------------------------------------------------
+  arkPR_Setup
+
+  Creates the coarse integrator and one fine integrator per
+  thread, unless they exist from a previous solve.
+  ---------------------------------------------------------------*/
+static int arkPR_Setup(ARKPararealMem pr)
+{
+  int i, nthreads, retval;
+  realtype hc;
+
+  /* the coarse integrator takes ncoarse fixed steps per slice */
+  if (pr->coarse == NULL) {
+    pr->coarse = pr->create(pr->t0, pr->y0, SUNTRUE, pr->user_data);
+    if (pr->coarse == NULL) {
+      arkProcessError(NULL, ARK_MEM_FAIL, "ARKode::Parareal",
+                      "ARKParareal_Evolve",
+                      "Unable to create the coarse integrator");
+      return(ARK_MEM_FAIL);
+    }
+  }
+  hc = (pr->tf - pr->t0) / (pr->nslices * pr->ncoarse);
+  retval = ARKStepSetFixedStep(pr->coarse, hc);
+  if (retval != ARK_SUCCESS) return(retval);
+
+  /* the fine solves of a sweep run on at most nslices threads */
+#ifdef _OPENMP
+  nthreads = SUNMIN(pr->nthreads, pr->nslices);
+#else
+  nthreads = 1;
+#endif
+
+  if (pr->nfinemem == nthreads) return(ARK_SUCCESS);
+  arkPR_FreeFine(pr);
+
+  pr->fine = (void **) calloc(nthreads, sizeof(void *));
+  if (pr->fine == NULL) {
+    arkProcessError(NULL, ARK_MEM_FAIL, "ARKode::Parareal",
+                    "ARKParareal_Evolve", MSG_ARK_MEM_FAIL);
+    return(ARK_MEM_FAIL);
+  }
+  pr->nfinemem = nthreads;
+
+  for (i=0; i<nthreads; i++) {
+    pr->fine[i] = pr->create(pr->t0, pr->y0, SUNFALSE, pr->user_data);
+    if (pr->fine[i] == NULL) {
+      arkProcessError(NULL, ARK_MEM_FAIL, "ARKode::Parareal",
+                      "ARKParareal_Evolve",
+                      "Unable to create fine integrator %i", i);
+      arkPR_FreeFine(pr);
+      return(ARK_MEM_FAIL);
+    }
+  }
+
+  return(ARK_SUCCESS);
+}
+
+
+/*===============================================================
+  Construct and free
+  ===============================================================*/
+
+/*---------------------------------------------------------------
+  ARKParareal_Create
+
+  Creates a Parareal driver for the interval [t0, tf] split into
+  nslices time slices. The integrators are made by the create
+  function on the first call to ARKParareal_Evolve.
+  ---------------------------------------------------------------*/
+void* ARKParareal_Create(ARKPararealCreateFn create, ARKPararealFreeFn free_fn,
+                         void *user_data, realtype t0, realtype tf,
+                         N_Vector y0, int nslices)
+{
+  ARKPararealMem pr;
+
+  /* Check inputs */
+  if (create == NULL || y0 == NULL) {
+    arkProcessError(NULL, ARK_ILL_INPUT, "ARKode::Parareal",
+                    "ARKParareal_Create",
+                    "The create function and y0 must be non-NULL.");
+    return(NULL);
+  }
+  if (nslices < 1 || tf == t0) {
+    arkProcessError(NULL, ARK_ILL_INPUT, "ARKode::Parareal",
+                    "ARKParareal_Create",
+                    "Need nslices >= 1 and tf != t0.");
+    return(NULL);
+  }
+
+  pr = (ARKPararealMem) calloc(1, sizeof(*pr));
+  if (pr == NULL) {
+    arkProcessError(NULL, ARK_MEM_FAIL, "ARKode::Parareal",
+                    "ARKParareal_Create", MSG_ARK_MEM_FAIL);
+    return(NULL);
+  }
+
+  pr->create    = create;
+  pr->free_fn   = free_fn;
+  pr->user_data = user_data;
+  pr->t0        = t0;
+  pr->tf        = tf;
+  pr->nslices   = nslices;
+
+#ifdef _OPENMP
+  pr->nthreads  = omp_get_max_threads();
+#else
+  pr->nthreads  = 1;
+#endif
+  pr->maxiters  = nslices;
+  pr->ncoarse   = ARKPR_DEFAULT_COARSE_STEPS;
+  pr->rtol      = ARKPR_DEFAULT_RTOL;
+  pr->atol      = ARKPR_DEFAULT_ATOL;
+
+  pr->y0   = N_VClone(y0);
+  pr->ynew = N_VClone(y0);
+  pr->gnew = N_VClone(y0);
+  pr->ewt  = N_VClone(y0);
+  pr->U    = N_VCloneVectorArray(nslices+1, y0);
+  pr->G    = N_VCloneVectorArray(nslices, y0);
+  pr->F    = N_VCloneVectorArray(nslices, y0);
+
+  pr->fflag  = (int *) calloc(nslices, sizeof(int));
+  pr->fsteps = (long int *) calloc(nslices, sizeof(long int));
+  pr->cnorms = (realtype *) calloc(nslices, sizeof(realtype));
+
+  if (pr->y0 == NULL || pr->ynew == NULL || pr->gnew == NULL ||
+      pr->ewt == NULL || pr->U == NULL || pr->G == NULL || pr->F == NULL ||
+      pr->fflag == NULL || pr->fsteps == NULL || pr->cnorms == NULL) {
+    ARKParareal_Free((void **) &pr);
+    arkProcessError(NULL, ARK_MEM_FAIL, "ARKode::Parareal",
+                    "ARKParareal_Create", MSG_ARK_MEM_FAIL);
+    return(NULL);
+  }
+
+  N_VScale(ONE, y0, pr->y0);
+
+  return((void *) pr);
+}
+
+
+/*---------------------------------------------------------------
+  ARKParareal_Free
+
+  Frees the driver and the integrators it created.
+  ---------------------------------------------------------------*/
+void ARKParareal_Free(void **pr_mem)
+{
+  ARKPararealMem pr;
+
+  if (*pr_mem == NULL) return;
+  pr = (ARKPararealMem) (*pr_mem);
+
+  arkPR_FreeIntegrator(pr, &(pr->coarse));
+  arkPR_FreeFine(pr);
+
+  if (pr->y0   != NULL) N_VDestroy(pr->y0);
+  if (pr->ynew != NULL) N_VDestroy(pr->ynew);
+  if (pr->gnew != NULL) N_VDestroy(pr->gnew);
+  if (pr->ewt  != NULL) N_VDestroy(pr->ewt);
+  if (pr->U    != NULL) N_VDestroyVectorArray(pr->U, pr->nslices+1);
+  if (pr->G    != NULL) N_VDestroyVectorArray(pr->G, pr->nslices);
+  if (pr->F    != NULL) N_VDestroyVectorArray(pr->F, pr->nslices);
+
+  free(pr->fflag);
+  free(pr->fsteps);
+  free(pr->cnorms);
+
+  free(*pr_mem);
+  *pr_mem = NULL;
+}
+
+
+/*===============================================================
+  Set functions
+  ===============================================================*/
+
+/*---------------------------------------------------------------
+  ARKParareal_SetNumThreads
+
+  Number of threads for the fine solves (default: the OpenMP
+  maximum). Without OpenMP the slices are solved one after
+  another and the setting is ignored.
+  ---------------------------------------------------------------*/
+int ARKParareal_SetNumThreads(void *pr_mem, int nthreads)
+{
+  ARKPararealMem pr;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_SetNumThreads", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+
+  if (nthreads < 1) {
+#ifdef _OPENMP
+    pr->nthreads = omp_get_max_threads();
+#else
+    pr->nthreads = 1;
+#endif
+  } else {
+    pr->nthreads = nthreads;
+  }
+
+  return(ARK_SUCCESS);
+}
+
+
+/*---------------------------------------------------------------
+  ARKParareal_SetMaxIters
+
+  Iteration limit, at most (and by default) nslices since the
+  iteration is exact after nslices sweeps. A value <= 0 restores
+  the default.
+  ---------------------------------------------------------------*/
+int ARKParareal_SetMaxIters(void *pr_mem, int maxiters)
+{
+  ARKPararealMem pr;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_SetMaxIters", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+
+  if (maxiters <= 0 || maxiters > pr->nslices)
+    pr->maxiters = pr->nslices;
+  else
+    pr->maxiters = maxiters;
+
+  return(ARK_SUCCESS);
+}
+
+
+/*---------------------------------------------------------------
+  ARKParareal_SetCoarseSteps
+
+  Number of fixed steps the coarse integrator takes per slice.
+  A value <= 0 restores the default.
+  ---------------------------------------------------------------*/
+int ARKParareal_SetCoarseSteps(void *pr_mem, int nsteps)
+{
+  ARKPararealMem pr;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_SetCoarseSteps", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+
+  pr->ncoarse = (nsteps <= 0) ? ARKPR_DEFAULT_COARSE_STEPS : nsteps;
+
+  return(ARK_SUCCESS);
+}
+
+
+/*---------------------------------------------------------------
+  ARKParareal_SetTolerances
+
+  The iteration stops when the WRMS norm of every interface
+  correction, weighted by 1/(rtol |U| + atol), is at most one.
+  ---------------------------------------------------------------*/
+int ARKParareal_SetTolerances(void *pr_mem, realtype rtol, realtype atol)
+{
+  ARKPararealMem pr;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_SetTolerances", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+
+  if (rtol < ZERO || atol < ZERO || (rtol == ZERO && atol == ZERO)) {
+    arkProcessError(NULL, ARK_ILL_INPUT, "ARKode::Parareal",
+                    "ARKParareal_SetTolerances",
+                    "Tolerances must be non-negative and not both zero.");
+    return(ARK_ILL_INPUT);
+  }
+
+  pr->rtol = rtol;
+  pr->atol = atol;
+
+  return(ARK_SUCCESS);
+}
+
+
+/*===============================================================
+  Solve
+  ===============================================================*/
+
+/*---------------------------------------------------------------
+  ARKParareal_Evolve
+
+  Runs the Parareal iteration and returns the solution at tf in
+  yout. Iteration k solves the slices k-1, ..., nslices-1 with
+  the fine integrators in parallel; the earlier slices already
+  equal the serial fine solution. The coarse integrator then
+  propagates the fine corrections across the remaining slices.
+
+  Returns ARK_CONV_FAILURE if the corrections are still above
+  the tolerance after maxiters iterations.
+  ---------------------------------------------------------------*/
+int ARKParareal_Evolve(void *pr_mem, N_Vector yout)
+{
+  ARKPararealMem pr;
+  N_Vector vtmp;
+  int n, k, first, nslices, nthreads, retval;
+  long int nst;
+  realtype cnorm, enorm;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_Evolve", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+  nslices = pr->nslices;
+
+  retval = arkPR_Setup(pr);
+  if (retval != ARK_SUCCESS) return(retval);
+  nthreads = pr->nfinemem;
+
+  pr->niters    = 0;
+  pr->nfine     = 0;
+  pr->ncoarsest = 0;
+  pr->last_flag = ARK_SUCCESS;
+
+  /* initial coarse sweep */
+  N_VScale(ONE, pr->y0, pr->U[0]);
+  for (n=0; n<nslices; n++) {
+    N_VScale(ONE, pr->U[n], pr->G[n]);
+    retval = arkPR_Propagate(pr->coarse, arkPR_SliceTime(pr, n),
+                             arkPR_SliceTime(pr, n+1), pr->G[n], &nst);
+    pr->last_flag = retval;
+    if (retval != ARK_SUCCESS) return(retval);
+    pr->ncoarsest += nst;
+    N_VScale(ONE, pr->G[n], pr->U[n+1]);
+  }
+
+  cnorm = ZERO;
+  for (k=1; k<=pr->maxiters; k++) {
+
+    first = k-1;
+
+    /* fine sweep, one slice per thread at a time */
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+#endif
+    for (n=first; n<nslices; n++) {
+      int tid = 0;
+#ifdef _OPENMP
+      tid = omp_get_thread_num();
+#endif
+      N_VScale(ONE, pr->U[n], pr->F[n]);
+      pr->fflag[n] = arkPR_Propagate(pr->fine[tid], arkPR_SliceTime(pr, n),
+                                     arkPR_SliceTime(pr, n+1), pr->F[n],
+                                     &(pr->fsteps[n]));
+    }
+
+    for (n=first; n<nslices; n++) {
+      if (pr->fflag[n] != ARK_SUCCESS) {
+        pr->last_flag = pr->fflag[n];
+        return(pr->fflag[n]);
+      }
+      pr->nfine += pr->fsteps[n];
+    }
+
+    /* serial coarse correction sweep,
+       U_{n+1} = G(U_n^new) + F(U_n^old) - G(U_n^old) */
+    cnorm = ZERO;
+    for (n=first; n<nslices; n++) {
+
+      if (n == first) {
+        /* U_first is unchanged, the correction cancels G */
+        N_VScale(ONE, pr->F[n], pr->ynew);
+      } else {
+        N_VScale(ONE, pr->U[n], pr->gnew);
+        retval = arkPR_Propagate(pr->coarse, arkPR_SliceTime(pr, n),
+                                 arkPR_SliceTime(pr, n+1), pr->gnew, &nst);
+        pr->last_flag = retval;
+        if (retval != ARK_SUCCESS) return(retval);
+        pr->ncoarsest += nst;
+
+        N_VLinearSum(ONE, pr->gnew, ONE, pr->F[n], pr->ynew);
+        N_VLinearSum(ONE, pr->ynew, -ONE, pr->G[n], pr->ynew);
+
+        vtmp = pr->G[n]; pr->G[n] = pr->gnew; pr->gnew = vtmp;
+      }
+
+      /* correction norm, U_{n+1} holds the correction before the swap */
+      N_VAbs(pr->ynew, pr->ewt);
+      N_VScale(pr->rtol, pr->ewt, pr->ewt);
+      N_VAddConst(pr->ewt, pr->atol, pr->ewt);
+      N_VInv(pr->ewt, pr->ewt);
+      N_VLinearSum(ONE, pr->ynew, -ONE, pr->U[n+1], pr->U[n+1]);
+      enorm = N_VWrmsNorm(pr->U[n+1], pr->ewt);
+      cnorm = SUNMAX(cnorm, enorm);
+
+      vtmp = pr->U[n+1]; pr->U[n+1] = pr->ynew; pr->ynew = vtmp;
+    }
+
+    pr->cnorms[k-1] = cnorm;
+    pr->niters = k;
+
+    if (cnorm <= ONE) break;
+  }
+
+  N_VScale(ONE, pr->U[nslices], yout);
+
+  /* after nslices iterations every slice is exact */
+  if (cnorm > ONE && pr->niters < nslices) return(ARK_CONV_FAILURE);
+
+  return(ARK_SUCCESS);
+}
+
+
+/*===============================================================
+  Get functions
+  ===============================================================*/
+
+/* Iterations of the last solve */
+int ARKParareal_GetNumIterations(void *pr_mem, int *niters)
+{
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_GetNumIterations", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  *niters = ((ARKPararealMem) pr_mem)->niters;
+  return(ARK_SUCCESS);
+}
+
+
+/* Maximum interface correction norm of each iteration of the last
+   solve, norms must hold at least niters values */
+int ARKParareal_GetCorrectionNorms(void *pr_mem, realtype *norms)
+{
+  ARKPararealMem pr;
+  int k;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_GetCorrectionNorms", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+
+  for (k=0; k<pr->niters; k++)
+    norms[k] = pr->cnorms[k];
+  return(ARK_SUCCESS);
+}
+
+
+/* Fine and coarse steps taken by the last solve */
+int ARKParareal_GetNumSteps(void *pr_mem, long int *nfine, long int *ncoarse)
+{
+  ARKPararealMem pr;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_GetNumSteps", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+
+  *nfine   = pr->nfine;
+  *ncoarse = pr->ncoarsest;
+  return(ARK_SUCCESS);
+}
+
+
+/* Solution at slice interface n (0 <= n <= nslices) */
+int ARKParareal_GetSliceSolution(void *pr_mem, int n, realtype *t, N_Vector y)
+{
+  ARKPararealMem pr;
+
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_GetSliceSolution", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  pr = (ARKPararealMem) pr_mem;
+
+  if (n < 0 || n > pr->nslices) {
+    arkProcessError(NULL, ARK_ILL_INPUT, "ARKode::Parareal",
+                    "ARKParareal_GetSliceSolution",
+                    "Slice index out of range.");
+    return(ARK_ILL_INPUT);
+  }
+
+  *t = arkPR_SliceTime(pr, n);
+  N_VScale(ONE, pr->U[n], y);
+  return(ARK_SUCCESS);
+}
+
+
+/* Last flag returned by an ARKStep call */
+int ARKParareal_GetLastARKStepFlag(void *pr_mem, int *last_flag)
+{
+  if (pr_mem == NULL) {
+    arkProcessError(NULL, ARK_MEM_NULL, "ARKode::Parareal",
+                    "ARKParareal_GetLastARKStepFlag", MSG_PR_NO_MEM);
+    return(ARK_MEM_NULL);
+  }
+  *last_flag = ((ARKPararealMem) pr_mem)->last_flag;
+  return(ARK_SUCCESS);
+}
@@ -0,0 +1,78 @@
+/* -----------------------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------------------
+ * Implementation header file for ARKODE's Parareal driver.
+ * ---------------------------------------------------------------------------*/
+
+#ifndef _ARKODE_PARAREAL_IMPL_H
+#define _ARKODE_PARAREAL_IMPL_H
+
+#include "arkode/arkode_parareal.h"
+#include "arkode_impl.h"
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+
+/*---------------------------------------------------------------
+  Parareal driver memory
+  ---------------------------------------------------------------*/
+typedef struct ARKPararealMemRec {
+
+  /* User-supplied integrator setup */
+  ARKPararealCreateFn create;
+  ARKPararealFreeFn   free_fn;
+  void               *user_data;
+
+  /* Time slices */
+  realtype t0, tf;      /* time interval                            */
+  int      nslices;     /* number of time slices                    */
+
+  /* Options */
+  int      nthreads;    /* threads for the fine solves              */
+  int      maxiters;    /* iteration limit (default nslices)        */
+  int      ncoarse;     /* coarse steps per slice                   */
+  realtype rtol, atol;  /* convergence weights of the corrections   */
+
+  /* Integrators */
+  void   *coarse;       /* coarse ARKStep integrator                */
+  void  **fine;         /* fine ARKStep integrators, one per thread */
+  int     nfinemem;     /* number of fine integrators created       */
+
+  /* Vectors */
+  N_Vector  y0;         /* initial condition                        */
+  N_Vector *U;          /* slice interfaces U_0 ... U_nslices       */
+  N_Vector *G;          /* coarse values G(U_n) of the last sweep   */
+  N_Vector *F;          /* fine values F(U_n) of the last sweep     */
+  N_Vector  ynew;       /* corrected interface value                */
+  N_Vector  gnew;       /* coarse value of the corrected interface  */
+  N_Vector  ewt;        /* correction norm weights                  */
+
+  /* Per slice fine results */
+  int      *fflag;      /* ARKStepEvolve return flags               */
+  long int *fsteps;     /* fine steps taken                         */
+
+  /* Diagnostics */
+  int       niters;     /* iterations of the last solve             */
+  realtype *cnorms;     /* correction norm of each iteration        */
+  long int  nfine;      /* total fine steps                         */
+  long int  ncoarsest;  /* total coarse steps                       */
+  int       last_flag;  /* last ARKStep flag                        */
+
+} *ARKPararealMem;
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -46,8 +46,9 @@ module farkode_mristep_mod
  integer(C_INT), parameter, public :: MRI_GARK_ERK45a = 201_C_INT
  integer(C_INT), parameter, public :: MRI_GARK_IRK21a = 202_C_INT
  integer(C_INT), parameter, public :: MRI_GARK_ESDIRK34a = 203_C_INT
+ integer(C_INT), parameter, public :: MRI_GARK_ERK33a = 204_C_INT
  integer(C_INT), parameter, public :: MIN_MRI_NUM = 200_C_INT
- integer(C_INT), parameter, public :: MAX_MRI_NUM = 203_C_INT
+ integer(C_INT), parameter, public :: MAX_MRI_NUM = 204_C_INT
  integer(C_INT), parameter, public :: DEFAULT_MRI_TABLE_3 = 200_C_INT
  integer(C_INT), parameter, public :: DEFAULT_EXPL_MRI_TABLE_3 = 200_C_INT
  integer(C_INT), parameter, public :: DEFAULT_EXPL_MRI_TABLE_4 = 201_C_INT
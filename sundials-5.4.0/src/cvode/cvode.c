@@ -29,6 +29,14 @@
 #include <sundials/sundials_types.h>
 #include <sunnonlinsol/sunnonlinsol_newton.h>
 
+/* Chrome trace events of the enclosing build, recorded with OMS_TRACE */
+#ifdef OMS_TRACE
+#include "omstrace.h"
+#else
+#define OMS_TRACE_BEGIN(category, name)
+#define OMS_TRACE_END(category, name)
+#endif
+
 /*=================================================================*/
 /* CVODE Private Constants                                         */
 /*=================================================================*/
@@ -135,6 +143,17 @@
  *
  *    DGMAX       |gamma/gammap-1| > DGMAX => call lsetup
  *
+ * cvSwitchCheck (automatic method switching)
+ *
+ *    SW_MINSTEPS  number of steps after a switch before the next one
+ *    SW_LIPSTEPS  maximum number of steps between estimates of the
+ *                 Lipschitz constant of f
+ *    SW_RATIO     switch to BDF if it allows a step SW_RATIO times larger
+ *    SW_MAXNCF    switch to BDF after SW_MAXNCF fixed point convergence
+ *                 failures in one step
+ *    SW_STABSTEPS switch to BDF after SW_STABSTEPS consecutive Adams
+ *                 steps with h L at the stability bound
+ *
  */
 
 
@@ -169,6 +188,12 @@
 
 #define DGMAX  RCONST(0.3)
 
+#define SW_MINSTEPS  20
+#define SW_LIPSTEPS  10
+#define SW_RATIO     RCONST(2.0)
+#define SW_MAXNCF     2
+#define SW_STABSTEPS 15
+
 
 /*=================================================================*/
 /* Private Helper Functions Prototypes                             */
@@ -176,6 +201,11 @@
 
 static booleantype cvCheckNvector(N_Vector tmpl);
 
+/* Main solver function, called by CVode with the profiler active */
+
+static int cvSolve(CVodeMem cv_mem, realtype tout, N_Vector yout,
+                   realtype *tret, int itask);
+
 /* Initial setup */
 
 static int cvInitialSetup(CVodeMem cv_mem);
@@ -263,6 +293,7 @@ static void cvPrepareNextStep(CVodeMem cv_mem, realtype dsm);
 static void cvSetEta(CVodeMem cv_mem);
 static realtype cvComputeEtaqm1(CVodeMem cv_mem);
 static realtype cvComputeEtaqp1(CVodeMem cv_mem);
+static void cvComputeEtaqs_cpu(CVodeMem cv_mem);
 static void cvChooseEta(CVodeMem cv_mem);
 
 /* Function to handle failures */
@@ -271,15 +302,26 @@ static int cvHandleFailure(CVodeMem cv_mem,int flag);
 
 /* Functions for BDF Stability Limit Detection */
 
+static void cvStabData(CVodeMem cv_mem);
 static void cvBDFStab(CVodeMem cv_mem);
 static int cvSLdet(CVodeMem cv_mem);
 
+/* Functions for automatic Adams / BDF switching */
+
+static booleantype cvSwitchLipDue(CVodeMem cv_mem, long int nst);
+static int cvSwitchCheck(CVodeMem cv_mem, realtype dsm);
+static int cvSwitchStep(CVodeMem cv_mem, int lmm, realtype eta);
+static int cvSwitchMethod(CVodeMem cv_mem, int lmm);
+
 /* Functions for rootfinding */
 
 static int cvRcheck1(CVodeMem cv_mem);
 static int cvRcheck2(CVodeMem cv_mem);
 static int cvRcheck3(CVodeMem cv_mem);
 static int cvRootfind(CVodeMem cv_mem);
+static int cvRootEval(CVodeMem cv_mem, realtype t, N_Vector y,
+                      realtype *gout, booleantype full);
+static void cvRootShrinkSet(CVodeMem cv_mem);
 
 
 /*
@@ -347,6 +389,9 @@ void *CVodeCreate(int lmm)
   cv_mem->cv_eh_data          = cv_mem;
   cv_mem->cv_monitorfun       = NULL;
   cv_mem->cv_monitor_interval = 0;
+
+  /* No profiler by default */
+  cv_mem->cv_profiler = NULL;
   cv_mem->cv_errfp            = stderr;
   cv_mem->cv_qmax             = maxord;
   cv_mem->cv_mxstep           = MXSTEP_DEFAULT;
@@ -375,6 +420,20 @@ void *CVodeCreate(int lmm)
   cv_mem->cv_nrtfn      = 0;
   cv_mem->cv_gactive    = NULL;
   cv_mem->cv_mxgnull    = 1;
+  cv_mem->cv_gchgfun    = NULL;
+  cv_mem->cv_gcur       = NULL;
+  cv_mem->cv_gchg       = NULL;
+  cv_mem->cv_gset       = NULL;
+  cv_mem->cv_ngset      = 0;
+  cv_mem->cv_ginset     = NULL;
+  cv_mem->cv_gfull      = SUNTRUE;
+
+  /* Initialize ensemble variables */
+
+  cv_mem->cv_ens_nmembers = 0;
+  cv_mem->cv_ens_layout   = CV_ENSEMBLE_BLOCKED;
+  cv_mem->cv_ens_n        = 0;
+  cv_mem->cv_ens_sums     = NULL;
 
   /* Initialize projection variables */
   cv_mem->proj_mem     = NULL;
@@ -400,8 +459,22 @@ void *CVodeCreate(int lmm)
   cv_mem->NLS    = NULL;
   cv_mem->ownNLS = SUNFALSE;
 
+  /* No automatic method switching by default */
+  cv_mem->cv_swon        = SUNFALSE;
+  cv_mem->cv_swNLSfp     = NULL;
+  cv_mem->cv_swNLSnewton = NULL;
+  cv_mem->cv_swfpred     = NULL;
+  cv_mem->cv_swgrab      = SUNFALSE;
+  cv_mem->cv_nsw         = 0;
+
   /* Initialize fused operations variable */
-  cv_mem->cv_usefused = SUNFALSE;
+  cv_mem->cv_usefused    = SUNFALSE;
+  cv_mem->cv_usefusedcpu = SUNFALSE;
+
+  /* Initialize linear solver setup reuse variables */
+  cv_mem->cv_lsetupreuse = SUNFALSE;
+  cv_mem->cv_lsetupok    = SUNFALSE;
+  cv_mem->cv_lsetupkept  = SUNFALSE;
 
   /* Return pointer to CVODE memory block */
 
@@ -527,6 +600,9 @@ int CVodeInit(void *cvode_mem, CVRhsFn f, realtype t0, N_Vector y0)
   cv_mem->cv_lfree  = NULL;
   cv_mem->cv_lmem   = NULL;
 
+  cv_mem->cv_lsetupok   = SUNFALSE;
+  cv_mem->cv_lsetupkept = SUNFALSE;
+
   /* Initialize zn[0] in the history array */
 
   N_VScale(ONE, y0, cv_mem->cv_zn[0]);
@@ -562,6 +638,14 @@ int CVodeInit(void *cvode_mem, CVRhsFn f, realtype t0, N_Vector y0)
     for (k = 1; k <= 3; k++)
       cv_mem->cv_ssdat[i-1][k-1] = ZERO;
 
+  /* Initialize automatic method switching data */
+
+  cv_mem->cv_swlip  = ZERO;
+  cv_mem->cv_nstsw  = 0;
+  cv_mem->cv_nstlip = 0;
+  cv_mem->cv_nstab  = 0;
+  cv_mem->cv_nsw    = 0;
+
   /* Problem has been successfully initialized */
 
   cv_mem->cv_MallocDone = SUNTRUE;
@@ -659,6 +743,19 @@ int CVodeReInit(void *cvode_mem, realtype t0, N_Vector y0)
     for (k = 1; k <= 3; k++)
       cv_mem->cv_ssdat[i-1][k-1] = ZERO;
 
+  /* Initialize automatic method switching data */
+
+  cv_mem->cv_swlip  = ZERO;
+  cv_mem->cv_nstsw  = 0;
+  cv_mem->cv_nstlip = 0;
+  cv_mem->cv_nstab  = 0;
+  cv_mem->cv_nsw    = 0;
+
+  /* Keep the Jacobian and linear solver setup of the previous integration
+     if requested, the first step only calls lsetup if gamma changed too much */
+
+  cv_mem->cv_lsetupkept = cv_mem->cv_lsetupreuse && cv_mem->cv_lsetupok;
+
   /* Problem has been successfully re-initialized */
 
   return(CV_SUCCESS);
@@ -846,6 +943,7 @@ int CVodeRootInit(void *cvode_mem, int nrtfn, CVRootFn g)
      functions (changing number of gfun components), then free
      currently held memory resources */
   if ((nrt != cv_mem->cv_nrtfn) && (cv_mem->cv_nrtfn > 0)) {
+    cvRootChangedFree(cv_mem);
     free(cv_mem->cv_glo); cv_mem->cv_glo = NULL;
     free(cv_mem->cv_ghi); cv_mem->cv_ghi = NULL;
     free(cv_mem->cv_grout); cv_mem->cv_grout = NULL;
@@ -873,6 +971,7 @@ int CVodeRootInit(void *cvode_mem, int nrtfn, CVRootFn g)
   if (nrt == cv_mem->cv_nrtfn) {
     if (g != cv_mem->cv_gfun) {
       if (g == NULL) {
+        cvRootChangedFree(cv_mem);
         free(cv_mem->cv_glo); cv_mem->cv_glo = NULL;
         free(cv_mem->cv_ghi); cv_mem->cv_ghi = NULL;
         free(cv_mem->cv_grout); cv_mem->cv_grout = NULL;
@@ -1007,6 +1106,30 @@ int CVode(void *cvode_mem, realtype tout, N_Vector yout,
           realtype *tret, int itask)
 {
   CVodeMem cv_mem;
+  SUNProfiler prev;
+  int retval;
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVode", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  /* the vector and matrix operations record into the active profiler */
+  prev = SUNProfiler_SetActive(cv_mem->cv_profiler);
+  SUNDIALS_MARK_FUNCTION_BEGIN(cv_mem->cv_profiler);
+
+  retval = cvSolve(cv_mem, tout, yout, tret, itask);
+
+  SUNDIALS_MARK_FUNCTION_END(cv_mem->cv_profiler);
+  SUNProfiler_SetActive(prev);
+
+  return(retval);
+}
+
+static int cvSolve(CVodeMem cv_mem, realtype tout, N_Vector yout,
+                   realtype *tret, int itask)
+{
   long int nstloc;
   int retval, hflag, kflag, istate, ir, ier, irfndp;
   int ewtsetOK;
@@ -1019,13 +1142,6 @@ int CVode(void *cvode_mem, realtype tout, N_Vector yout,
    * -------------------------------------
    */
 
-  /* Check if cvode_mem exists */
-  if (cvode_mem == NULL) {
-    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVode", MSGCV_NO_MEM);
-    return(CV_MEM_NULL);
-  }
-  cv_mem = (CVodeMem) cvode_mem;
-
   /* Check if cvode_mem was allocated */
   if (cv_mem->cv_MallocDone == SUNFALSE) {
     cvProcessError(cv_mem, CV_NO_MALLOC, "CVODE", "CVode", MSGCV_NO_MALLOC);
@@ -1322,7 +1438,7 @@ int CVode(void *cvode_mem, realtype tout, N_Vector yout,
     }
 
     /* Check for too much accuracy requested */
-    nrm = N_VWrmsNorm(cv_mem->cv_zn[0], cv_mem->cv_ewt);
+    nrm = cvWrmsNorm(cv_mem, cv_mem->cv_zn[0], cv_mem->cv_ewt);
     cv_mem->cv_tolsf = cv_mem->cv_uround * nrm;
     if (cv_mem->cv_tolsf > ONE) {
       cvProcessError(cv_mem, CV_TOO_MUCH_ACC, "CVODE", "CVode",
@@ -1347,7 +1463,11 @@ int CVode(void *cvode_mem, realtype tout, N_Vector yout,
     }
 
     /* Call cvStep to take a step */
+    SUNDIALS_MARK_BEGIN(cv_mem->cv_profiler, "cvStep");
+    OMS_TRACE_BEGIN("cvode", "cvStep");
     kflag = cvStep(cv_mem);
+    OMS_TRACE_END("cvode", "cvStep");
+    SUNDIALS_MARK_END(cv_mem->cv_profiler, "cvStep");
 
     /* Process failed step cases, and exit loop */
     if (kflag != CV_SUCCESS) {
@@ -1362,7 +1482,9 @@ int CVode(void *cvode_mem, realtype tout, N_Vector yout,
     /* Check for root in last step taken. */
     if (cv_mem->cv_nrtfn > 0) {
 
+      SUNDIALS_MARK_BEGIN(cv_mem->cv_profiler, "cvRcheck3");
       retval = cvRcheck3(cv_mem);
+      SUNDIALS_MARK_END(cv_mem->cv_profiler, "cvRcheck3");
 
       if (retval == RTFOUND) {  /* A new root was found */
         cv_mem->cv_irfnd = 1;
@@ -1523,6 +1645,128 @@ int CVodeGetDky(void *cvode_mem, realtype t, int k, N_Vector dky)
   return(CV_SUCCESS);
 }
 
+/*
+ * CVodeGetDkyMulti
+ *
+ * This routine computes the k-th derivative of the interpolating
+ * polynomial at the ntimes times t[0], ..., t[ntimes-1] within the
+ * last step, as CVodeGetDky does, and stores the result for t[m] in
+ * row m of the ntimes x N row-major array dky (dky[m*N+i]). The
+ * Nordsieck array is read once, in blocks of CV_DKY_BLOCK components
+ * that are scaled into a contiguous work array and stay in cache
+ * while the polynomial is evaluated at all times by Horner's scheme:
+ *
+ *  dky = h^(-k) * ( ... (c(q,k) zn[q] * s + c(q-1,k) zn[q-1]) * s
+ *                   + ... + c(k,k) zn[k] ) ,   s = (t - tn) / h .
+ *
+ * Needs a vector with contiguous host data (serial, OpenMP or
+ * pthreads). The results agree with CVodeGetDky up to roundoff.
+ */
+
+#define CV_DKY_BLOCK 128
+
+/* out[i] = sum_l w[l*CV_DKY_BLOCK+i] s^l for i < len, by Horner's scheme */
+static void cvDkyHorner(const realtype *w, int deg, realtype s,
+                        sunindextype len, realtype *out)
+{
+  realtype p[CV_DKY_BLOCK];
+  sunindextype i;
+  int l;
+
+  for (i = 0; i < len; i++)
+    p[i] = w[deg*CV_DKY_BLOCK + i];
+  for (l = deg-1; l >= 0; l--)
+    for (i = 0; i < len; i++)
+      p[i] = p[i] * s + w[l*CV_DKY_BLOCK + i];
+  for (i = 0; i < len; i++)
+    out[i] = p[i];
+}
+
+int CVodeGetDkyMulti(void *cvode_mem, int ntimes, const realtype *t, int k,
+                     realtype *dky)
+{
+  realtype tfuzz, tp, tn1, r, s, *out;
+  realtype coef[L_MAX], *zd[L_MAX], w[L_MAX*CV_DKY_BLOCK];
+  sunindextype N, ib, nb, i;
+  int j, l, m, deg;
+  N_Vector_ID id;
+  CVodeMem cv_mem;
+
+  /* Check all inputs for legality */
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeGetDkyMulti", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  if ((dky == NULL) || (ntimes > 0 && t == NULL)) {
+    cvProcessError(cv_mem, CV_BAD_DKY, "CVODE", "CVodeGetDkyMulti", MSGCV_NULL_DKY);
+    return(CV_BAD_DKY);
+  }
+
+  if ((k < 0) || (k > cv_mem->cv_q)) {
+    cvProcessError(cv_mem, CV_BAD_K, "CVODE", "CVodeGetDkyMulti", MSGCV_BAD_K);
+    return(CV_BAD_K);
+  }
+
+  id = N_VGetVectorID(cv_mem->cv_zn[0]);
+  if ( (id != SUNDIALS_NVEC_SERIAL) && (id != SUNDIALS_NVEC_OPENMP) &&
+       (id != SUNDIALS_NVEC_PTHREADS) ) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeGetDkyMulti", MSGCV_BAD_NVECTOR);
+    return(CV_ILL_INPUT);
+  }
+
+  /* Allow for some slack */
+  tfuzz = FUZZ_FACTOR * cv_mem->cv_uround *
+    (SUNRabs(cv_mem->cv_tn) + SUNRabs(cv_mem->cv_hu));
+  if (cv_mem->cv_hu < ZERO) tfuzz = -tfuzz;
+  tp = cv_mem->cv_tn - cv_mem->cv_hu - tfuzz;
+  tn1 = cv_mem->cv_tn + tfuzz;
+  for (m = 0; m < ntimes; m++) {
+    if ((t[m]-tp)*(t[m]-tn1) > ZERO) {
+      cvProcessError(cv_mem, CV_BAD_T, "CVODE", "CVodeGetDkyMulti", MSGCV_BAD_T,
+                     t[m], cv_mem->cv_tn-cv_mem->cv_hu, cv_mem->cv_tn);
+      return(CV_BAD_T);
+    }
+  }
+
+  /* Coefficients c(j,k) h^(-k) of the Horner scheme, zd[l] holds the
+     column of power l of s */
+  deg = cv_mem->cv_q - k;
+  r = (k == 0) ? ONE : SUNRpowerI(cv_mem->cv_h, -k);
+  for (l = 0; l <= deg; l++) {
+    j = l + k;
+    coef[l] = r;
+    for (i = j; i >= j-k+1; i--)
+      coef[l] *= i;
+    zd[l] = N_VGetArrayPointer(cv_mem->cv_zn[j]);
+  }
+
+  N = N_VGetLength(cv_mem->cv_zn[0]);
+
+  for (ib = 0; ib < N; ib += CV_DKY_BLOCK) {
+    nb = SUNMIN(CV_DKY_BLOCK, N - ib);
+
+    /* scaled copy of the block, contiguous for the Horner loops */
+    for (l = 0; l <= deg; l++)
+      for (i = 0; i < nb; i++)
+        w[l*CV_DKY_BLOCK + i] = coef[l] * zd[l][ib + i];
+
+    for (m = 0; m < ntimes; m++) {
+      s   = (t[m] - cv_mem->cv_tn) / cv_mem->cv_h;
+      out = dky + (sunindextype) m * N + ib;
+      /* full blocks get loops of fixed length, which vectorize */
+      if (nb == CV_DKY_BLOCK)
+        cvDkyHorner(w, deg, s, CV_DKY_BLOCK, out);
+      else
+        cvDkyHorner(w, deg, s, nb, out);
+    }
+  }
+
+  return(CV_SUCCESS);
+}
+
 /*
  * CVodeComputeState
  *
@@ -1546,6 +1790,318 @@ int CVodeComputeState(void *cvode_mem, N_Vector ycor, N_Vector y)
   return(CV_SUCCESS);
 }
 
+/*
+ * CVodeGetStateSize, CVodeGetState, CVodeSetState
+ *
+ * Save the integrator state into a caller buffer and restore it
+ * later, e.g. to repeat a rejected co-simulation step without the
+ * restart of CVodeReInit. The state consists of the Nordsieck array
+ * zn[0..qmax], the step size and order data with the step size
+ * history, the number of steps, the stability limit detection data
+ * and the rootfinding data at the start of the next step. With
+ * automatic method switching it includes the method, restored with
+ * its solver, and all allocated columns of zn.
+ *
+ * The Jacobian and the linear solver setup are not copied. If the
+ * linear solver setup is still the one in use when the state was
+ * saved, CVodeSetState keeps it and the steps repeat exactly. If it was
+ * renewed since, it belongs to the later steps and is marked outdated
+ * as by CVodeInvalidateJac, since an old-state Newton iteration with it
+ * converges poorly. The counters of work done (f, g, Jacobian and setup
+ * evaluations, failures) are not restored, so that the statistics
+ * include the rejected steps.
+ *
+ * The buffer must be nbytes long as returned by CVodeGetStateSize and
+ * aligned for a realtype, e.g. allocated with malloc. Saving and
+ * restoring copy the vector data once and allocate no memory. The
+ * vector must implement N_VBufSize, N_VBufPack and N_VBufUnpack.
+ */
+
+typedef struct {
+  long int nbytes;     /* size of the state, to check the buffer */
+  sunindextype vbytes; /* bytes of one packed vector             */
+  int lmm, qmax, nrtfn;
+
+  int q, qprime, next_q, qwait, L, qu, indx_acor, nscon, irfnd;
+  long int nst, nstlp, nor;
+  realtype h, hprime, next_h, eta, hscale, tn, tretlast, hu, h0u;
+  realtype tau[L_MAX+1], tq[NUM_TESTS+1], l[L_MAX];
+  realtype rl1, gamma, gammap, crate, delp, acnrm, etamax, saved_tq5, tolsf;
+  realtype etaqm1, etaq, etaqp1, ssdat[6][4], tlo;
+  booleantype acnrmcur;
+  realtype swlip;
+  long int nstsw, nstlip, nstab;
+} CVodeStateHeader;
+
+#define CV_STATE_ALIGN(n) ((((n) + 7) / 8) * 8)
+
+/* offset of zn[0] in the buffer, the root arrays follow the header */
+static long int cvStateVecOffset(int nrtfn)
+{
+  return(CV_STATE_ALIGN((long int) sizeof(CVodeStateHeader) +
+                        nrtfn * (long int) (sizeof(realtype) + sizeof(int) +
+                                            sizeof(booleantype))));
+}
+
+/* number of zn vectors saved, all allocated ones with method switching */
+static int cvStateNumVecs(CVodeMem cv_mem)
+{
+  return((cv_mem->cv_swon ? cv_mem->cv_qmax_alloc : cv_mem->cv_qmax) + 1);
+}
+
+static int cvStateVecBytes(CVodeMem cv_mem, const char *fname,
+                           sunindextype *vbytes)
+{
+  if ( (cv_mem->cv_zn[0]->ops->nvbufsize == NULL) ||
+       (cv_mem->cv_zn[0]->ops->nvbufpack == NULL) ||
+       (cv_mem->cv_zn[0]->ops->nvbufunpack == NULL) ||
+       (N_VBufSize(cv_mem->cv_zn[0], vbytes) != 0) ) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", fname, MSGCV_BAD_NVECTOR);
+    return(CV_ILL_INPUT);
+  }
+  return(CV_SUCCESS);
+}
+
+int CVodeGetStateSize(void *cvode_mem, long int *nbytes)
+{
+  CVodeMem cv_mem;
+  sunindextype vbytes;
+  int flag;
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeGetStateSize", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  if (cv_mem->cv_MallocDone == SUNFALSE) {
+    cvProcessError(cv_mem, CV_NO_MALLOC, "CVODE", "CVodeGetStateSize", MSGCV_NO_MALLOC);
+    return(CV_NO_MALLOC);
+  }
+
+  flag = cvStateVecBytes(cv_mem, "CVodeGetStateSize", &vbytes);
+  if (flag != CV_SUCCESS) return(flag);
+
+  *nbytes = cvStateVecOffset(cv_mem->cv_nrtfn) +
+    cvStateNumVecs(cv_mem) * CV_STATE_ALIGN((long int) vbytes);
+
+  return(CV_SUCCESS);
+}
+
+int CVodeGetState(void *cvode_mem, void *buf, long int nbytes)
+{
+  CVodeMem cv_mem;
+  CVodeStateHeader hd;
+  long int size, off;
+  char *p;
+  int flag, j, nrt;
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeGetState", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  flag = CVodeGetStateSize(cvode_mem, &size);
+  if (flag != CV_SUCCESS) return(flag);
+
+  if ((buf == NULL) || (nbytes < size)) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeGetState", MSGCV_BAD_STATE_BUF);
+    return(CV_ILL_INPUT);
+  }
+
+  memset(&hd, 0, sizeof(hd));
+  hd.nbytes = size;
+  N_VBufSize(cv_mem->cv_zn[0], &hd.vbytes);
+  hd.lmm   = cv_mem->cv_lmm;
+  hd.qmax  = cv_mem->cv_qmax;
+  hd.nrtfn = cv_mem->cv_nrtfn;
+
+  hd.q         = cv_mem->cv_q;
+  hd.qprime    = cv_mem->cv_qprime;
+  hd.next_q    = cv_mem->cv_next_q;
+  hd.qwait     = cv_mem->cv_qwait;
+  hd.L         = cv_mem->cv_L;
+  hd.qu        = cv_mem->cv_qu;
+  hd.indx_acor = cv_mem->cv_indx_acor;
+  hd.nscon     = cv_mem->cv_nscon;
+  hd.irfnd     = cv_mem->cv_irfnd;
+  hd.nst       = cv_mem->cv_nst;
+  hd.nstlp     = cv_mem->cv_nstlp;
+  hd.nor       = cv_mem->cv_nor;
+  hd.h         = cv_mem->cv_h;
+  hd.hprime    = cv_mem->cv_hprime;
+  hd.next_h    = cv_mem->cv_next_h;
+  hd.eta       = cv_mem->cv_eta;
+  hd.hscale    = cv_mem->cv_hscale;
+  hd.tn        = cv_mem->cv_tn;
+  hd.tretlast  = cv_mem->cv_tretlast;
+  hd.hu        = cv_mem->cv_hu;
+  hd.h0u       = cv_mem->cv_h0u;
+  memcpy(hd.tau, cv_mem->cv_tau, sizeof(hd.tau));
+  memcpy(hd.tq, cv_mem->cv_tq, sizeof(hd.tq));
+  memcpy(hd.l, cv_mem->cv_l, sizeof(hd.l));
+  hd.rl1       = cv_mem->cv_rl1;
+  hd.gamma     = cv_mem->cv_gamma;
+  hd.gammap    = cv_mem->cv_gammap;
+  hd.crate     = cv_mem->cv_crate;
+  hd.delp      = cv_mem->cv_delp;
+  hd.acnrm     = cv_mem->cv_acnrm;
+  hd.acnrmcur  = cv_mem->cv_acnrmcur;
+  hd.etamax    = cv_mem->cv_etamax;
+  hd.saved_tq5 = cv_mem->cv_saved_tq5;
+  hd.tolsf     = cv_mem->cv_tolsf;
+  hd.etaqm1    = cv_mem->cv_etaqm1;
+  hd.etaq      = cv_mem->cv_etaq;
+  hd.etaqp1    = cv_mem->cv_etaqp1;
+  memcpy(hd.ssdat, cv_mem->cv_ssdat, sizeof(hd.ssdat));
+  hd.tlo       = cv_mem->cv_tlo;
+  hd.swlip     = cv_mem->cv_swlip;
+  hd.nstsw     = cv_mem->cv_nstsw;
+  hd.nstlip    = cv_mem->cv_nstlip;
+  hd.nstab     = cv_mem->cv_nstab;
+
+  p = (char *) buf;
+  memcpy(p, &hd, sizeof(hd));
+  off = sizeof(hd);
+
+  nrt = cv_mem->cv_nrtfn;
+  if (nrt > 0) {
+    memcpy(p + off, cv_mem->cv_glo, nrt * sizeof(realtype));
+    off += nrt * sizeof(realtype);
+    memcpy(p + off, cv_mem->cv_iroots, nrt * sizeof(int));
+    off += nrt * sizeof(int);
+    memcpy(p + off, cv_mem->cv_gactive, nrt * sizeof(booleantype));
+  }
+
+  off = cvStateVecOffset(nrt);
+  for (j = 0; j < cvStateNumVecs(cv_mem); j++) {
+    if (N_VBufPack(cv_mem->cv_zn[j], p + off) != 0) {
+      cvProcessError(cv_mem, CV_VECTOROP_ERR, "CVODE", "CVodeGetState", MSGCV_BAD_NVECTOR);
+      return(CV_VECTOROP_ERR);
+    }
+    off += CV_STATE_ALIGN((long int) hd.vbytes);
+  }
+
+  return(CV_SUCCESS);
+}
+
+int CVodeSetState(void *cvode_mem, const void *buf, long int nbytes)
+{
+  CVodeMem cv_mem;
+  CVodeStateHeader hd;
+  sunindextype vbytes;
+  long int size, off;
+  const char *p;
+  int flag, j, nrt;
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeSetState", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  flag = CVodeGetStateSize(cvode_mem, &size);
+  if (flag != CV_SUCCESS) return(flag);
+  N_VBufSize(cv_mem->cv_zn[0], &vbytes);
+
+  /* the state must come from a CVODE memory block of the same shape,
+     with method switching the method may differ */
+  p = (const char *) buf;
+  if ((buf == NULL) || (nbytes < (long int) sizeof(hd))) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetState", MSGCV_BAD_STATE_BUF);
+    return(CV_ILL_INPUT);
+  }
+  memcpy(&hd, p, sizeof(hd));
+  if ( (hd.nbytes != size) || (nbytes < size) || (hd.vbytes != vbytes) ||
+       (((hd.lmm != cv_mem->cv_lmm) || (hd.qmax != cv_mem->cv_qmax)) &&
+        !cv_mem->cv_swon) ||
+       (hd.nrtfn != cv_mem->cv_nrtfn) ) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetState", MSGCV_BAD_STATE_BUF);
+    return(CV_ILL_INPUT);
+  }
+
+  off = cvStateVecOffset(hd.nrtfn);
+  for (j = 0; j < cvStateNumVecs(cv_mem); j++) {
+    if (N_VBufUnpack(cv_mem->cv_zn[j], (void *) (p + off)) != 0) {
+      cvProcessError(cv_mem, CV_VECTOROP_ERR, "CVODE", "CVodeSetState", MSGCV_BAD_NVECTOR);
+      return(CV_VECTOROP_ERR);
+    }
+    off += CV_STATE_ALIGN((long int) vbytes);
+  }
+
+  cv_mem->cv_q         = hd.q;
+  cv_mem->cv_qprime    = hd.qprime;
+  cv_mem->cv_next_q    = hd.next_q;
+  cv_mem->cv_qwait     = hd.qwait;
+  cv_mem->cv_L         = hd.L;
+  cv_mem->cv_qu        = hd.qu;
+  cv_mem->cv_indx_acor = hd.indx_acor;
+  cv_mem->cv_nscon     = hd.nscon;
+  cv_mem->cv_irfnd     = hd.irfnd;
+  cv_mem->cv_nst       = hd.nst;
+  cv_mem->cv_nor       = hd.nor;
+  cv_mem->cv_h         = hd.h;
+  cv_mem->cv_hprime    = hd.hprime;
+  cv_mem->cv_next_h    = hd.next_h;
+  cv_mem->cv_eta       = hd.eta;
+  cv_mem->cv_hscale    = hd.hscale;
+  cv_mem->cv_tn        = hd.tn;
+  cv_mem->cv_tretlast  = hd.tretlast;
+  cv_mem->cv_hu        = hd.hu;
+  cv_mem->cv_h0u       = hd.h0u;
+  memcpy(cv_mem->cv_tau, hd.tau, sizeof(hd.tau));
+  memcpy(cv_mem->cv_tq, hd.tq, sizeof(hd.tq));
+  memcpy(cv_mem->cv_l, hd.l, sizeof(hd.l));
+  cv_mem->cv_rl1       = hd.rl1;
+  cv_mem->cv_gamma     = hd.gamma;
+  cv_mem->cv_crate     = hd.crate;
+  cv_mem->cv_delp      = hd.delp;
+  cv_mem->cv_acnrm     = hd.acnrm;
+  cv_mem->cv_acnrmcur  = hd.acnrmcur;
+  cv_mem->cv_etamax    = hd.etamax;
+  cv_mem->cv_saved_tq5 = hd.saved_tq5;
+  cv_mem->cv_tolsf     = hd.tolsf;
+  cv_mem->cv_etaqm1    = hd.etaqm1;
+  cv_mem->cv_etaq      = hd.etaq;
+  cv_mem->cv_etaqp1    = hd.etaqp1;
+  memcpy(cv_mem->cv_ssdat, hd.ssdat, sizeof(hd.ssdat));
+  cv_mem->cv_tlo       = hd.tlo;
+  cv_mem->cv_swlip     = hd.swlip;
+  cv_mem->cv_nstsw     = hd.nstsw;
+  cv_mem->cv_nstlip    = hd.nstlip;
+  cv_mem->cv_nstab     = hd.nstab;
+
+  nrt = hd.nrtfn;
+  if (nrt > 0) {
+    off = sizeof(hd);
+    memcpy(cv_mem->cv_glo, p + off, nrt * sizeof(realtype));
+    off += nrt * sizeof(realtype);
+    memcpy(cv_mem->cv_iroots, p + off, nrt * sizeof(int));
+    off += nrt * sizeof(int);
+    memcpy(cv_mem->cv_gactive, p + off, nrt * sizeof(booleantype));
+    /* the changed components reported by gchgfun refer to the dropped steps */
+    cv_mem->cv_gfull = SUNTRUE;
+  }
+
+  /* a linear solver setup done after the state was saved is dropped */
+  if ( (cv_mem->cv_nstlp != hd.nstlp) || (cv_mem->cv_gammap != hd.gammap) ) {
+    cv_mem->cv_lsetupok   = SUNFALSE;
+    cv_mem->cv_lsetupkept = SUNFALSE;
+  }
+  cv_mem->cv_nstlp  = hd.nstlp;
+  cv_mem->cv_gammap = hd.gammap;
+
+  /* attach the solver of the saved method */
+  if (hd.lmm != cv_mem->cv_lmm) {
+    cv_mem->cv_lmm  = hd.lmm;
+    cv_mem->cv_qmax = hd.qmax;
+    return(cvNlsSwitch(cv_mem, hd.lmm));
+  }
+
+  return(CV_SUCCESS);
+}
+
 /*
  * CVodeFree
  *
@@ -1565,6 +2121,9 @@ void CVodeFree(void **cvode_mem)
 
   cvFreeVectors(cv_mem);
 
+  /* free the solver of automatic method switching */
+  cvNlsFreeSwitching(cv_mem);
+
   /* if CVODE created the nonlinear solver object then free it */
   if (cv_mem->ownNLS) {
     SUNNonlinSolFree(cv_mem->NLS);
@@ -1575,6 +2134,7 @@ void CVodeFree(void **cvode_mem)
   if (cv_mem->cv_lfree != NULL) cv_mem->cv_lfree(cv_mem);
 
   if (cv_mem->cv_nrtfn > 0) {
+    cvRootChangedFree(cv_mem);
     free(cv_mem->cv_glo); cv_mem->cv_glo = NULL;
     free(cv_mem->cv_ghi); cv_mem->cv_ghi = NULL;
     free(cv_mem->cv_grout); cv_mem->cv_grout = NULL;
@@ -1583,6 +2143,8 @@ void CVodeFree(void **cvode_mem)
     free(cv_mem->cv_gactive); cv_mem->cv_gactive = NULL;
   }
 
+  free(cv_mem->cv_ens_sums); cv_mem->cv_ens_sums = NULL;
+
   free(*cvode_mem);
   *cvode_mem = NULL;
 }
@@ -2070,7 +2632,7 @@ static int cvYddNorm(CVodeMem cv_mem, realtype hg, realtype *yddnrm)
 
   N_VLinearSum(ONE/hg, cv_mem->cv_tempv, -ONE/hg, cv_mem->cv_zn[1], cv_mem->cv_tempv);
 
-  *yddnrm = N_VWrmsNorm(cv_mem->cv_tempv, cv_mem->cv_ewt);
+  *yddnrm = cvWrmsNorm(cv_mem, cv_mem->cv_tempv, cv_mem->cv_ewt);
 
   return(CV_SUCCESS);
 }
@@ -2097,6 +2659,7 @@ static int cvYddNorm(CVodeMem cv_mem, realtype hg, realtype *yddnrm)
  * - updating zn and other state data if successful;
  * - resetting stepsize and order for the next step.
  * - if SLDET is on, check for stability, reduce order if necessary.
+ * - with automatic method switching, consider a switch of the method.
  * On a failure in the nonlinear system solution or error test, the
  * step may be reattempted, depending on the nature of the failure.
  */
@@ -2135,11 +2698,20 @@ static int cvStep(CVodeMem cv_mem)
     cvPredict(cv_mem);
     cvSet(cv_mem);
 
+    SUNDIALS_MARK_BEGIN(cv_mem->cv_profiler, "cvNls");
     nflag = cvNls(cv_mem, nflag);
+    SUNDIALS_MARK_END(cv_mem->cv_profiler, "cvNls");
     kflag = cvHandleNFlag(cv_mem, &nflag, saved_t, &ncf);
 
-    /* Go back in loop if we need to predict again (nflag=PREV_CONV_FAIL) */
-    if (kflag == PREDICT_AGAIN) continue;
+    /* Go back in loop if we need to predict again (nflag=PREV_CONV_FAIL),
+       fixed point failures of an Adams phase indicate stiffness */
+    if (kflag == PREDICT_AGAIN) {
+      if (cv_mem->cv_swon && (cv_mem->cv_lmm == CV_ADAMS) && (ncf >= SW_MAXNCF)) {
+        kflag = cvSwitchMethod(cv_mem, CV_BDF);
+        if (kflag != CV_SUCCESS) return(kflag);
+      }
+      continue;
+    }
 
     /* Return if nonlinear solve failed and recovery is not possible. */
     if (kflag != DO_ERROR_TEST) return(kflag);
@@ -2181,9 +2753,15 @@ static int cvStep(CVodeMem cv_mem)
   cvPrepareNextStep(cv_mem, dsm);
 
   /* If Stablilty Limit Detection is turned on, call stability limit
-     detection routine for possible order reduction. */
+     detection routine for possible order reduction. With automatic
+     method switching, consider a switch (and call it in BDF phases). */
 
-  if (cv_mem->cv_sldeton) cvBDFStab(cv_mem);
+  if (cv_mem->cv_swon) {
+    kflag = cvSwitchCheck(cv_mem, dsm);
+    if (kflag != CV_SUCCESS) return(kflag);
+  } else if (cv_mem->cv_sldeton) {
+    cvBDFStab(cv_mem);
+  }
 
   cv_mem->cv_etamax = (cv_mem->cv_nst <= SMALL_NST) ? ETAMX2 : ETAMX3;
 
@@ -2441,6 +3019,11 @@ static void cvPredict(CVodeMem cv_mem)
       cv_mem->cv_tn = cv_mem->cv_tstop;
   }
 
+  if (cv_mem->cv_usefusedcpu) {
+    cvPredict_cpu(cv_mem->cv_q, ONE, cv_mem->cv_zn);
+    return;
+  }
+
   for (k = 1; k <= cv_mem->cv_q; k++)
     for (j = cv_mem->cv_q; j >= k; j--)
       N_VLinearSum(ONE, cv_mem->cv_zn[j-1], ONE,
@@ -2477,8 +3060,9 @@ static void cvSet(CVodeMem cv_mem)
   }
   cv_mem->cv_rl1 = ONE / cv_mem->cv_l[1];
   cv_mem->cv_gamma = cv_mem->cv_h * cv_mem->cv_rl1;
-  if (cv_mem->cv_nst == 0) cv_mem->cv_gammap = cv_mem->cv_gamma;
-  cv_mem->cv_gamrat = (cv_mem->cv_nst > 0) ?
+  if ((cv_mem->cv_nst == 0) && !cv_mem->cv_lsetupkept)
+    cv_mem->cv_gammap = cv_mem->cv_gamma;
+  cv_mem->cv_gamrat = ((cv_mem->cv_nst > 0) || cv_mem->cv_lsetupkept) ?
     cv_mem->cv_gamma / cv_mem->cv_gammap : ONE;  /* protect x / x != 1.0 */
 }
 
@@ -2726,15 +3310,19 @@ static int cvNls(CVodeMem cv_mem, int nflag)
   int flag = CV_SUCCESS;
   booleantype callSetup;
   long int nni_inc;
+  realtype acnrm;
 
   /* Decide whether or not to call setup routine (if one exists) and */
   /* set flag convfail (input to lsetup for its evaluation decision) */
-  if (cv_mem->cv_lsetup) {
+  /* The fixed point iteration of Adams phases of method switching   */
+  /* does not use the linear solver                                  */
+  if (cv_mem->cv_lsetup && (cv_mem->NLS != cv_mem->cv_swNLSfp)) {
     cv_mem->convfail = ((nflag == FIRST_CALL) || (nflag == PREV_ERR_FAIL)) ?
       CV_NO_FAILURES : CV_FAIL_OTHER;
 
     callSetup = (nflag == PREV_CONV_FAIL) || (nflag == PREV_ERR_FAIL) ||
-      (cv_mem->cv_nst == 0) ||
+      ((cv_mem->cv_nst == 0) && !cv_mem->cv_lsetupkept) ||
+      !cv_mem->cv_lsetupok ||
       (cv_mem->cv_nst >= cv_mem->cv_nstlp + cv_mem->cv_msbp) ||
       (SUNRabs(cv_mem->cv_gamrat-ONE) > DGMAX);
   } else {
@@ -2742,6 +3330,14 @@ static int cvNls(CVodeMem cv_mem, int nflag)
     callSetup = SUNFALSE;
   }
 
+  /* with method switching, estimate the Lipschitz constant of f from the
+     fixed point rates of all attempts of the step, or save f at the
+     predictor when it is estimated after the step */
+  if (cv_mem->cv_swon) {
+    if (nflag == FIRST_CALL) cv_mem->cv_swlipfp = ZERO;
+    cv_mem->cv_swgrab = cvSwitchLipDue(cv_mem, cv_mem->cv_nst);
+  }
+
   /* initial guess for the correction to the predictor */
   N_VConst(ZERO, cv_mem->cv_acor);
 
@@ -2766,12 +3362,17 @@ static int cvNls(CVodeMem cv_mem, int nflag)
 
   /* solve successful */
 
-  /* update the state based on the final correction from the nonlinear solver */
-  N_VLinearSum(ONE, cv_mem->cv_zn[0], ONE, cv_mem->cv_acor, cv_mem->cv_y);
-
-  /* compute acnrm if is was not already done by the nonlinear solver */
-  if (!cv_mem->cv_acnrmcur)
-    cv_mem->cv_acnrm = N_VWrmsNorm(cv_mem->cv_acor, cv_mem->cv_ewt);
+  /* update the state based on the final correction from the nonlinear solver
+     and compute acnrm if is was not already done by the nonlinear solver */
+  if (cv_mem->cv_usefusedcpu) {
+    acnrm = cvUpdateY_cpu(cv_mem->cv_zn[0], cv_mem->cv_acor, cv_mem->cv_ewt,
+                          cv_mem->cv_y);
+    if (!cv_mem->cv_acnrmcur) cv_mem->cv_acnrm = acnrm;
+  } else {
+    N_VLinearSum(ONE, cv_mem->cv_zn[0], ONE, cv_mem->cv_acor, cv_mem->cv_y);
+    if (!cv_mem->cv_acnrmcur)
+      cv_mem->cv_acnrm = cvWrmsNorm(cv_mem, cv_mem->cv_acor, cv_mem->cv_ewt);
+  }
 
   /* update Jacobian status */
   cv_mem->cv_jcur = SUNFALSE;
@@ -2811,27 +3412,35 @@ static int cvCheckConstraints(CVodeMem cv_mem)
 
   /* Constraints not met */
 
-  /* Compute correction to satisfy constraints */
-#ifdef SUNDIALS_BUILD_PACKAGE_FUSED_KERNELS
-  if (cv_mem->cv_usefused)
+  /* Compute correction to satisfy constraints and its norm ||v|| */
+  if (cv_mem->cv_usefusedcpu)
   {
-    cvCheckConstraints_fused(cv_mem->cv_constraints,
-                             cv_mem->cv_ewt,
-                             cv_mem->cv_y,
-                             mm,
-                             tmp);
+    vnorm = cvCheckConstraints_cpu(cv_mem->cv_constraints, cv_mem->cv_ewt,
+                                   cv_mem->cv_y, mm, tmp);
   }
   else
-#endif
   {
-    N_VCompare(ONEPT5, cv_mem->cv_constraints, tmp); /* a[i]=1 when |c[i]|=2  */
-    N_VProd(tmp, cv_mem->cv_constraints, tmp);       /* a * c                 */
-    N_VDiv(tmp, cv_mem->cv_ewt, tmp);                /* a * c * wt            */
-    N_VLinearSum(ONE, cv_mem->cv_y, -PT1, tmp, tmp); /* y - 0.1 * a * c * wt  */
-    N_VProd(tmp, mm, tmp);                           /* v = mm*(y-0.1*a*c*wt) */
-  }
+#ifdef SUNDIALS_BUILD_PACKAGE_FUSED_KERNELS
+    if (cv_mem->cv_usefused)
+    {
+      cvCheckConstraints_fused(cv_mem->cv_constraints,
+                               cv_mem->cv_ewt,
+                               cv_mem->cv_y,
+                               mm,
+                               tmp);
+    }
+    else
+#endif
+    {
+      N_VCompare(ONEPT5, cv_mem->cv_constraints, tmp); /* a[i]=1 when |c[i]|=2  */
+      N_VProd(tmp, cv_mem->cv_constraints, tmp);       /* a * c                 */
+      N_VDiv(tmp, cv_mem->cv_ewt, tmp);                /* a * c * wt            */
+      N_VLinearSum(ONE, cv_mem->cv_y, -PT1, tmp, tmp); /* y - 0.1 * a * c * wt  */
+      N_VProd(tmp, mm, tmp);                           /* v = mm*(y-0.1*a*c*wt) */
+    }
 
-  vnorm = N_VWrmsNorm(tmp, cv_mem->cv_ewt);        /* ||v|| */
+    vnorm = N_VWrmsNorm(tmp, cv_mem->cv_ewt);        /* ||v|| */
+  }
 
   /* If vector v of constraint corrections is small in norm, correct and
      accept this step */
@@ -2949,6 +3558,12 @@ void cvRestore(CVodeMem cv_mem, realtype saved_t)
   int j, k;
 
   cv_mem->cv_tn = saved_t;
+
+  if (cv_mem->cv_usefusedcpu) {
+    cvPredict_cpu(cv_mem->cv_q, -ONE, cv_mem->cv_zn);
+    return;
+  }
+
   for (k = 1; k <= cv_mem->cv_q; k++)
     for (j = cv_mem->cv_q; j >= k; j--)
       N_VLinearSum(ONE, cv_mem->cv_zn[j-1], -ONE,
@@ -3084,8 +3699,11 @@ static void cvCompleteStep(CVodeMem cv_mem)
   cv_mem->cv_tau[1] = cv_mem->cv_h;
 
   /* Apply correction to column j of zn: l_j * Delta_n */
-  (void) N_VScaleAddMulti(cv_mem->cv_q+1, cv_mem->cv_l, cv_mem->cv_acor,
-                          cv_mem->cv_zn, cv_mem->cv_zn);
+  if (cv_mem->cv_usefusedcpu)
+    cvCorrectZn_cpu(cv_mem->cv_q, cv_mem->cv_l, cv_mem->cv_acor, cv_mem->cv_zn);
+  else
+    (void) N_VScaleAddMulti(cv_mem->cv_q+1, cv_mem->cv_l, cv_mem->cv_acor,
+                            cv_mem->cv_zn, cv_mem->cv_zn);
 
   /* Apply the projection correction to column j of zn: p_j * Delta_n */
   if (cv_mem->proj_applied) {
@@ -3145,8 +3763,12 @@ static void cvPrepareNextStep(CVodeMem cv_mem, realtype dsm)
      the ratios of new to old h at orders q-1 and q+1, respectively.
      cvChooseEta selects the largest; cvSetEta adjusts eta and acor */
   cv_mem->cv_qwait = 2;
-  cv_mem->cv_etaqm1 = cvComputeEtaqm1(cv_mem);
-  cv_mem->cv_etaqp1 = cvComputeEtaqp1(cv_mem);
+  if (cv_mem->cv_usefusedcpu && (cv_mem->cv_ens_nmembers < 2)) {
+    cvComputeEtaqs_cpu(cv_mem);
+  } else {
+    cv_mem->cv_etaqm1 = cvComputeEtaqm1(cv_mem);
+    cv_mem->cv_etaqp1 = cvComputeEtaqp1(cv_mem);
+  }
   cvChooseEta(cv_mem);
   cvSetEta(cv_mem);
 }
@@ -3188,7 +3810,7 @@ static realtype cvComputeEtaqm1(CVodeMem cv_mem)
 
   cv_mem->cv_etaqm1 = ZERO;
   if (cv_mem->cv_q > 1) {
-    ddn = N_VWrmsNorm(cv_mem->cv_zn[cv_mem->cv_q], cv_mem->cv_ewt) * cv_mem->cv_tq[1];
+    ddn = cvWrmsNorm(cv_mem, cv_mem->cv_zn[cv_mem->cv_q], cv_mem->cv_ewt) * cv_mem->cv_tq[1];
     cv_mem->cv_etaqm1 = ONE/(SUNRpowerR(BIAS1*ddn, ONE/cv_mem->cv_q) + ADDON);
   }
   return(cv_mem->cv_etaqm1);
@@ -3212,12 +3834,51 @@ static realtype cvComputeEtaqp1(CVodeMem cv_mem)
       SUNRpowerI(cv_mem->cv_h/cv_mem->cv_tau[2], cv_mem->cv_L);
     N_VLinearSum(-cquot, cv_mem->cv_zn[cv_mem->cv_qmax], ONE,
                  cv_mem->cv_acor, cv_mem->cv_tempv);
-    dup = N_VWrmsNorm(cv_mem->cv_tempv, cv_mem->cv_ewt) * cv_mem->cv_tq[3];
+    dup = cvWrmsNorm(cv_mem, cv_mem->cv_tempv, cv_mem->cv_ewt) * cv_mem->cv_tq[3];
     cv_mem->cv_etaqp1 = ONE / (SUNRpowerR(BIAS3*dup, ONE/(cv_mem->cv_L+1)) + ADDON);
   }
   return(cv_mem->cv_etaqp1);
 }
 
+/*
+ * cvComputeEtaqs_cpu
+ *
+ * This routine computes etaqm1 and etaqp1 as cvComputeEtaqm1 and
+ * cvComputeEtaqp1 do, with both norms taken in one pass of the fused
+ * CPU kernels.
+ */
+
+static void cvComputeEtaqs_cpu(CVodeMem cv_mem)
+{
+  booleantype qm1, qp1;
+  realtype ddn, dup, cquot;
+
+  cv_mem->cv_etaqm1 = ZERO;
+  cv_mem->cv_etaqp1 = ZERO;
+
+  qm1 = (cv_mem->cv_q > 1);
+  qp1 = (cv_mem->cv_q != cv_mem->cv_qmax) && (cv_mem->cv_saved_tq5 != ZERO);
+  if (!qm1 && !qp1) return;
+
+  cquot = ZERO;
+  if (qp1)
+    cquot = (cv_mem->cv_tq[5] / cv_mem->cv_saved_tq5) *
+      SUNRpowerI(cv_mem->cv_h/cv_mem->cv_tau[2], cv_mem->cv_L);
+
+  cvOrderNorms_cpu(qm1 ? cv_mem->cv_zn[cv_mem->cv_q] : NULL, cquot,
+                   qp1 ? cv_mem->cv_zn[cv_mem->cv_qmax] : NULL,
+                   cv_mem->cv_acor, cv_mem->cv_ewt, &ddn, &dup);
+
+  if (qm1) {
+    ddn *= cv_mem->cv_tq[1];
+    cv_mem->cv_etaqm1 = ONE/(SUNRpowerR(BIAS1*ddn, ONE/cv_mem->cv_q) + ADDON);
+  }
+  if (qp1) {
+    dup *= cv_mem->cv_tq[3];
+    cv_mem->cv_etaqp1 = ONE / (SUNRpowerR(BIAS3*dup, ONE/(cv_mem->cv_L+1)) + ADDON);
+  }
+}
+
 /*
  * cvChooseEta
  * Given etaqm1, etaq, etaqp1 (the values of eta for qprime =
@@ -3381,41 +4042,54 @@ static int cvHandleFailure(CVodeMem cv_mem, int flag)
  */
 
 /*
- * cvBDFStab
+ * cvStabData
  *
- * This routine handles the BDF Stability Limit Detection Algorithm
- * STALD.  It is called if lmm = CV_BDF and the SLDET option is on.
- * If the order is 3 or more, the required norm data is saved.
- * If a decision to reduce order has not already been made, and
- * enough data has been saved, cvSLdet is called.  If it signals
- * a stability limit violation, the order is reduced, and the step
- * size is reset accordingly.
+ * If the order is 3 or more, this routine saves the scaled derivative
+ * data used by cvSLdet, pushing the old data down in i and adding the
+ * current values to the top. The factorial is a realtype since Adams
+ * orders up to 12 overflow an int.
  */
 
-static void cvBDFStab(CVodeMem cv_mem)
+static void cvStabData(CVodeMem cv_mem)
 {
-  int i,k, ldflag, factorial;
-  realtype sq, sqm1, sqm2;
-
-  /* If order is 3 or greater, then save scaled derivative data,
-     push old data down in i, then add current values to top.    */
+  int i, k;
+  realtype factorial, sq, sqm1, sqm2;
 
   if (cv_mem->cv_q >= 3) {
     for (k = 1; k <= 3; k++)
       for (i = 5; i >= 2; i--)
         cv_mem->cv_ssdat[i][k] = cv_mem->cv_ssdat[i-1][k];
-    factorial = 1;
+    factorial = ONE;
     for (i = 1; i <= cv_mem->cv_q-1; i++) factorial *= i;
     sq = factorial * cv_mem->cv_q * (cv_mem->cv_q+1) *
       cv_mem->cv_acnrm / SUNMAX(cv_mem->cv_tq[5],TINY);
     sqm1 = factorial * cv_mem->cv_q *
-      N_VWrmsNorm(cv_mem->cv_zn[cv_mem->cv_q], cv_mem->cv_ewt);
+      cvWrmsNorm(cv_mem, cv_mem->cv_zn[cv_mem->cv_q], cv_mem->cv_ewt);
     sqm2 = factorial *
-      N_VWrmsNorm(cv_mem->cv_zn[cv_mem->cv_q-1], cv_mem->cv_ewt);
+      cvWrmsNorm(cv_mem, cv_mem->cv_zn[cv_mem->cv_q-1], cv_mem->cv_ewt);
     cv_mem->cv_ssdat[1][1] = sqm2*sqm2;
     cv_mem->cv_ssdat[1][2] = sqm1*sqm1;
     cv_mem->cv_ssdat[1][3] = sq*sq;
   }
+}
+
+/*
+ * cvBDFStab
+ *
+ * This routine handles the BDF Stability Limit Detection Algorithm
+ * STALD.  It is called if lmm = CV_BDF and the SLDET option is on.
+ * If the order is 3 or more, the required norm data is saved.
+ * If a decision to reduce order has not already been made, and
+ * enough data has been saved, cvSLdet is called.  If it signals
+ * a stability limit violation, the order is reduced, and the step
+ * size is reset accordingly.
+ */
+
+static void cvBDFStab(CVodeMem cv_mem)
+{
+  int ldflag;
+
+  cvStabData(cv_mem);
 
   if (cv_mem->cv_qprime >= cv_mem->cv_q) {
 
@@ -3755,12 +4429,241 @@ static int cvSLdet(CVodeMem cv_mem)
 
 }
 
+/*
+ * -----------------------------------------------------------------
+ * Functions for automatic Adams / BDF switching
+ * -----------------------------------------------------------------
+ */
+
+/*
+ * Magnitudes of the error constants of the Adams-Moulton methods and
+ * of the BDF methods of order q, and the stability bounds on h |J|
+ * of the Adams methods of LSODA, all indexed by q.
+ */
+
+static const realtype cvAdamsErrConst[ADAMS_Q_MAX+1] = {
+  RCONST(1.0), RCONST(0.5), RCONST(1.0)/RCONST(12.0),
+  RCONST(1.0)/RCONST(24.0), RCONST(19.0)/RCONST(720.0),
+  RCONST(3.0)/RCONST(160.0), RCONST(863.0)/RCONST(60480.0),
+  RCONST(275.0)/RCONST(24192.0), RCONST(33953.0)/RCONST(3628800.0),
+  RCONST(8183.0)/RCONST(1036800.0), RCONST(3250433.0)/RCONST(479001600.0),
+  RCONST(4671.0)/RCONST(788480.0),
+  RCONST(13695779093.0)/RCONST(2615348736000.0)
+};
+
+static const realtype cvBDFErrConst[BDF_Q_MAX+1] = {
+  RCONST(1.0), RCONST(0.5), RCONST(2.0)/RCONST(9.0), RCONST(3.0)/RCONST(22.0),
+  RCONST(12.0)/RCONST(125.0), RCONST(10.0)/RCONST(137.0)
+};
+
+static const realtype cvAdamsStabBound[ADAMS_Q_MAX+1] = {
+  RCONST(0.5), RCONST(0.5), RCONST(0.575), RCONST(0.55), RCONST(0.45),
+  RCONST(0.35), RCONST(0.25), RCONST(0.2), RCONST(0.15), RCONST(0.1),
+  RCONST(0.075), RCONST(0.05), RCONST(0.025)
+};
+
+/*
+ * cvSwitchLipDue
+ *
+ * Returns SUNTRUE if the Lipschitz constant of f is to be estimated
+ * from f values after step nst+1, unless the fixed point iteration of
+ * an Adams step estimates it.
+ */
+
+static booleantype cvSwitchLipDue(CVodeMem cv_mem, long int nst)
+{
+  return( (nst >= cv_mem->cv_nstsw + SW_MINSTEPS) &&
+          (nst >= cv_mem->cv_nstlip + SW_LIPSTEPS) );
+}
+
+/*
+ * cvSwitchCheck
+ *
+ * This routine is called after a successful step with automatic
+ * method switching, after the step size and order for the next step
+ * were chosen, and decides on a switch as LSODA does.
+ *
+ * The Lipschitz constant L of f is estimated in Adams phases from the
+ * rates of the fixed point iteration, which contracts as gamma L, in
+ * all attempts of the step including those that failed. If there was
+ * no estimate during SW_LIPSTEPS steps, e.g. in BDF phases or while
+ * the iteration converges at once, it is estimated from f at the
+ * predictor, saved by the nonlinear system function, and f at the new
+ * y, at the cost of one more evaluation of f.
+ *
+ * In an Adams phase the scaled derivative data of the stability limit
+ * detection is saved. The switch to BDF is made if cvSLdet detects a
+ * stability limit, or if the BDF step ratio, from the error estimate
+ * scaled by the ratio of the error constants, is SW_RATIO times the
+ * Adams step ratio limited by accuracy and by the stability bound on
+ * h L, or after SW_STABSTEPS consecutive steps with h L near that
+ * bound, where the error estimate is dominated by the growing
+ * parasitic solution. Otherwise the next Adams step is limited by the
+ * bound, as in LSODA. In a BDF phase the switch to Adams is made after
+ * a new estimate of L if the Adams step ratio is not smaller than the
+ * BDF step ratio. Otherwise cvBDFStab is called if the SLDET option
+ * is on.
+ *
+ * No switch is made during SW_MINSTEPS steps after a switch, and no
+ * switch to Adams after a step with failures (etamax = 1).
+ */
+
+static int cvSwitchCheck(CVodeMem cv_mem, realtype dsm)
+{
+  int q, qnew, ldflag, retval;
+  realtype pdh, etaA, etaB, dsmnew;
+
+  q = cv_mem->cv_q;
+
+  /* estimate L from the fixed point rates of an Adams step, or from f at
+     the predictor and at the new y if the last estimate is too old */
+  if ((cv_mem->cv_lmm == CV_ADAMS) && (cv_mem->cv_swlipfp > ZERO)) {
+    cv_mem->cv_swlip  = cv_mem->cv_swlipfp;
+    cv_mem->cv_nstlip = cv_mem->cv_nst;
+  } else if (cvSwitchLipDue(cv_mem, cv_mem->cv_nst - 1) &&
+             (cv_mem->cv_acnrm > ZERO)) {
+    retval = cv_mem->cv_f(cv_mem->cv_tn, cv_mem->cv_y, cv_mem->cv_tempv,
+                          cv_mem->cv_user_data);
+    cv_mem->cv_nfe++;
+    /* a failed evaluation only skips the estimate, the step is done */
+    if (retval == 0) {
+      N_VLinearSum(ONE, cv_mem->cv_tempv, -ONE, cv_mem->cv_swfpred,
+                   cv_mem->cv_tempv);
+      cv_mem->cv_swlip = cvWrmsNorm(cv_mem, cv_mem->cv_tempv, cv_mem->cv_ewt) /
+        cv_mem->cv_acnrm;
+      cv_mem->cv_nstlip = cv_mem->cv_nst;
+    }
+  }
+
+  if (cv_mem->cv_lmm == CV_ADAMS) {
+
+    cvStabData(cv_mem);
+    ldflag = 0;
+    if (cv_mem->cv_qprime < cv_mem->cv_q)
+      cv_mem->cv_nscon = 0;
+    else if ((q >= 3) && (cv_mem->cv_nscon >= q+5))
+      ldflag = cvSLdet(cv_mem);
+
+    if (cv_mem->cv_nst < cv_mem->cv_nstsw + SW_MINSTEPS) return(CV_SUCCESS);
+
+    etaA = cv_mem->cv_etaq;
+    pdh = SUNRabs(cv_mem->cv_h) * cv_mem->cv_swlip;
+    if (pdh > ZERO) etaA = SUNMIN(etaA, cvAdamsStabBound[q] / pdh);
+
+    qnew = SUNMIN(q, cv_mem->cv_swqbdf);
+    dsmnew = dsm * cvBDFErrConst[qnew] / cvAdamsErrConst[q];
+    etaB = ONE / (SUNRpowerR(BIAS2*dsmnew, ONE/(qnew+1)) + ADDON);
+
+    if ( (ldflag > 3) || ((pdh > ZERO) && (etaB >= SW_RATIO * etaA)) )
+      return(cvSwitchStep(cv_mem, CV_BDF, etaB));
+
+    /* near the stability bound the error estimate is dominated by the
+       growing parasitic solution and does not show what BDF would allow */
+    if ((pdh > ZERO) && (pdh >= PT9 * cvAdamsStabBound[q]))
+      cv_mem->cv_nstab++;
+    else
+      cv_mem->cv_nstab = 0;
+    if (cv_mem->cv_nstab >= SW_STABSTEPS)
+      return(cvSwitchStep(cv_mem, CV_BDF, SUNMAX(etaB, ONE)));
+
+    /* staying with Adams, keep h L within the stability bound */
+    if (pdh > ZERO) {
+      etaA = cvAdamsStabBound[cv_mem->cv_qprime] / pdh;
+      if (etaA < cv_mem->cv_eta) {
+        cv_mem->cv_eta    = etaA;
+        cv_mem->cv_hprime = cv_mem->cv_h * etaA;
+      }
+    }
+
+    return(CV_SUCCESS);
+  }
+
+  if ( (cv_mem->cv_nstlip == cv_mem->cv_nst) && (cv_mem->cv_etamax != ONE) &&
+       (cv_mem->cv_nst >= cv_mem->cv_nstsw + SW_MINSTEPS) ) {
+    qnew = SUNMIN(q, cv_mem->cv_swqadams);
+    dsmnew = dsm * cvAdamsErrConst[qnew] / cvBDFErrConst[q];
+    etaA = ONE / (SUNRpowerR(BIAS2*dsmnew, ONE/(qnew+1)) + ADDON);
+    pdh = SUNRabs(cv_mem->cv_h) * cv_mem->cv_swlip;
+    if (pdh > ZERO) etaA = SUNMIN(etaA, cvAdamsStabBound[qnew] / pdh);
+
+    if (etaA >= cv_mem->cv_etaq)
+      return(cvSwitchStep(cv_mem, CV_ADAMS, etaA));
+  }
+
+  if (cv_mem->cv_sldeton) cvBDFStab(cv_mem);
+
+  return(CV_SUCCESS);
+}
+
+/*
+ * cvSwitchStep
+ *
+ * This routine switches to the method lmm after a successful step
+ * and sets the step size ratio eta for the next step, bounded as
+ * in cvSetEta. The order is kept if the new method allows it.
+ */
+
+static int cvSwitchStep(CVodeMem cv_mem, int lmm, realtype eta)
+{
+  int retval;
+
+  retval = cvSwitchMethod(cv_mem, lmm);
+  if (retval != CV_SUCCESS) return(retval);
+
+  eta = SUNMIN(eta, cv_mem->cv_etamax);
+  eta = eta / SUNMAX(ONE, SUNRabs(cv_mem->cv_h)*cv_mem->cv_hmax_inv*eta);
+  cv_mem->cv_eta    = eta;
+  cv_mem->cv_hprime = cv_mem->cv_h * eta;
+
+  return(CV_SUCCESS);
+}
+
+/*
+ * cvSwitchMethod
+ *
+ * This routine makes lmm the method of the following steps. The
+ * Nordsieck array is the same for both methods, if the order is above
+ * the maximum order of lmm the higher columns are dropped, as LSODA
+ * does. No order change is considered during the next q+1 steps and
+ * the stability limit detection data is collected anew. The solver of
+ * lmm is attached, when switching to BDF the linear solver setup is
+ * renewed on the next step.
+ */
+
+static int cvSwitchMethod(CVodeMem cv_mem, int lmm)
+{
+  cv_mem->cv_lmm  = lmm;
+  cv_mem->cv_qmax = (lmm == CV_BDF) ? cv_mem->cv_swqbdf : cv_mem->cv_swqadams;
+  if (cv_mem->cv_q > cv_mem->cv_qmax) {
+    cv_mem->cv_q = cv_mem->cv_qmax;
+    cv_mem->cv_L = cv_mem->cv_q + 1;
+  }
+  cv_mem->cv_qprime = cv_mem->cv_q;
+  cv_mem->cv_qwait  = cv_mem->cv_L;
+  cv_mem->cv_nscon  = 0;
+  cv_mem->cv_crate  = ONE;
+  if (lmm == CV_BDF) cv_mem->cv_lsetupok = SUNFALSE;
+
+  cv_mem->cv_nstsw = cv_mem->cv_nst;
+  cv_mem->cv_nstab = 0;
+  cv_mem->cv_nsw++;
+
+  return(cvNlsSwitch(cv_mem, lmm));
+}
+
 /*
  * -----------------------------------------------------------------
  * Functions for rootfinding
  * -----------------------------------------------------------------
  */
 
+/* Index of the k-th component of g scanned for roots and the number of
+   components scanned: all of them, or the active set if gchgfun is used */
+#define CV_GIDX(cv_mem, k) \
+  ( ((cv_mem)->cv_gchgfun != NULL) ? (cv_mem)->cv_gset[k] : (k) )
+#define CV_NGIDX(cv_mem) \
+  ( ((cv_mem)->cv_gchgfun != NULL) ? (cv_mem)->cv_ngset : (cv_mem)->cv_nrtfn )
+
 /*
  * cvRcheck1
  *
@@ -3785,8 +4688,8 @@ static int cvRcheck1(CVodeMem cv_mem)
     cv_mem->cv_uround*HUNDRED;
 
   /* Evaluate g at initial t and check for zero values. */
-  retval = cv_mem->cv_gfun(cv_mem->cv_tlo, cv_mem->cv_zn[0],
-                           cv_mem->cv_glo, cv_mem->cv_user_data);
+  retval = cvRootEval(cv_mem, cv_mem->cv_tlo, cv_mem->cv_zn[0],
+                      cv_mem->cv_glo, SUNTRUE);
   cv_mem->cv_nge = 1;
   if (retval != 0) return(CV_RTFUNC_FAIL);
 
@@ -3804,8 +4707,7 @@ static int cvRcheck1(CVodeMem cv_mem)
   smallh = hratio*cv_mem->cv_h;
   tplus = cv_mem->cv_tlo + smallh;
   N_VLinearSum(ONE, cv_mem->cv_zn[0], hratio, cv_mem->cv_zn[1], cv_mem->cv_y);
-  retval = cv_mem->cv_gfun(tplus, cv_mem->cv_y,
-                           cv_mem->cv_ghi, cv_mem->cv_user_data);
+  retval = cvRootEval(cv_mem, tplus, cv_mem->cv_y, cv_mem->cv_ghi, SUNFALSE);
   cv_mem->cv_nge++;
   if (retval != 0) return(CV_RTFUNC_FAIL);
 
@@ -3843,21 +4745,22 @@ static int cvRcheck1(CVodeMem cv_mem)
 
 static int cvRcheck2(CVodeMem cv_mem)
 {
-  int i, retval;
+  int i, k, retval;
   realtype smallh, hratio, tplus;
   booleantype zroot;
 
   if (cv_mem->cv_irfnd == 0) return(CV_SUCCESS);
 
   (void) CVodeGetDky(cv_mem, cv_mem->cv_tlo, 0, cv_mem->cv_y);
-  retval = cv_mem->cv_gfun(cv_mem->cv_tlo, cv_mem->cv_y,
-                           cv_mem->cv_glo, cv_mem->cv_user_data);
+  retval = cvRootEval(cv_mem, cv_mem->cv_tlo, cv_mem->cv_y,
+                      cv_mem->cv_glo, SUNFALSE);
   cv_mem->cv_nge++;
   if (retval != 0) return(CV_RTFUNC_FAIL);
 
   zroot = SUNFALSE;
   for (i = 0; i < cv_mem->cv_nrtfn; i++) cv_mem->cv_iroots[i] = 0;
-  for (i = 0; i < cv_mem->cv_nrtfn; i++) {
+  for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+    i = CV_GIDX(cv_mem, k);
     if (!cv_mem->cv_gactive[i]) continue;
     if (SUNRabs(cv_mem->cv_glo[i]) == ZERO) {
       zroot = SUNTRUE;
@@ -3877,15 +4780,15 @@ static int cvRcheck2(CVodeMem cv_mem)
   } else {
     (void) CVodeGetDky(cv_mem, tplus, 0, cv_mem->cv_y);
   }
-  retval = cv_mem->cv_gfun(tplus, cv_mem->cv_y,
-                           cv_mem->cv_ghi, cv_mem->cv_user_data);
+  retval = cvRootEval(cv_mem, tplus, cv_mem->cv_y, cv_mem->cv_ghi, SUNFALSE);
   cv_mem->cv_nge++;
   if (retval != 0) return(CV_RTFUNC_FAIL);
 
   /* Check for close roots (error return), for a new zero at tlo+smallh,
   and for a g_i that changed from zero to nonzero. */
   zroot = SUNFALSE;
-  for (i = 0; i < cv_mem->cv_nrtfn; i++) {
+  for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+    i = CV_GIDX(cv_mem, k);
     if (!cv_mem->cv_gactive[i]) continue;
     if (SUNRabs(cv_mem->cv_ghi[i]) == ZERO) {
       if (cv_mem->cv_iroots[i] == 1) return(CLOSERT);
@@ -3915,7 +4818,7 @@ static int cvRcheck2(CVodeMem cv_mem)
 
 static int cvRcheck3(CVodeMem cv_mem)
 {
-  int i, ier, retval;
+  int i, k, ier, retval;
 
   /* Set thi = tn or tout, whichever comes first; set y = y(thi). */
   if (cv_mem->cv_taskc == CV_ONE_STEP) {
@@ -3933,8 +4836,8 @@ static int cvRcheck3(CVodeMem cv_mem)
   }
 
   /* Set ghi = g(thi) and call cvRootfind to search (tlo,thi) for roots. */
-  retval = cv_mem->cv_gfun(cv_mem->cv_thi, cv_mem->cv_y,
-                           cv_mem->cv_ghi, cv_mem->cv_user_data);
+  retval = cvRootEval(cv_mem, cv_mem->cv_thi, cv_mem->cv_y,
+                      cv_mem->cv_ghi, SUNFALSE);
   cv_mem->cv_nge++;
   if (retval != 0) return(CV_RTFUNC_FAIL);
 
@@ -3942,13 +4845,17 @@ static int cvRcheck3(CVodeMem cv_mem)
     cv_mem->cv_uround * HUNDRED;
   ier = cvRootfind(cv_mem);
   if (ier == CV_RTFUNC_FAIL) return(CV_RTFUNC_FAIL);
-  for(i=0; i<cv_mem->cv_nrtfn; i++) {
+  for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+    i = CV_GIDX(cv_mem, k);
     if(!cv_mem->cv_gactive[i] && cv_mem->cv_grout[i] != ZERO)
       cv_mem->cv_gactive[i] = SUNTRUE;
   }
   cv_mem->cv_tlo = cv_mem->cv_trout;
-  for (i = 0; i < cv_mem->cv_nrtfn; i++)
+  for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+    i = CV_GIDX(cv_mem, k);
     cv_mem->cv_glo[i] = cv_mem->cv_grout[i];
+  }
+  if (cv_mem->cv_gchgfun != NULL) cvRootShrinkSet(cv_mem);
 
   /* If no root found, return CV_SUCCESS. */
   if (ier == CV_SUCCESS) return(CV_SUCCESS);
@@ -4038,7 +4945,7 @@ static int cvRcheck3(CVodeMem cv_mem)
 static int cvRootfind(CVodeMem cv_mem)
 {
   realtype alph, tmid, gfrac, maxfrac, fracint, fracsub;
-  int i, retval, imax, side, sideprev;
+  int i, k, retval, imax, side, sideprev;
   booleantype zroot, sgnchg;
 
   imax = 0;
@@ -4047,7 +4954,8 @@ static int cvRootfind(CVodeMem cv_mem)
   maxfrac = ZERO;
   zroot = SUNFALSE;
   sgnchg = SUNFALSE;
-  for (i = 0;  i < cv_mem->cv_nrtfn; i++) {
+  for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+    i = CV_GIDX(cv_mem, k);
     if(!cv_mem->cv_gactive[i]) continue;
     if (SUNRabs(cv_mem->cv_ghi[i]) == ZERO) {
       if(cv_mem->cv_rootdir[i]*cv_mem->cv_glo[i] <= ZERO) {
@@ -4070,10 +4978,14 @@ static int cvRootfind(CVodeMem cv_mem)
      CV_SUCCESS if no zero was found, or set iroots and return RTFOUND.  */
   if (!sgnchg) {
     cv_mem->cv_trout = cv_mem->cv_thi;
-    for (i = 0; i < cv_mem->cv_nrtfn; i++) cv_mem->cv_grout[i] = cv_mem->cv_ghi[i];
+    for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+      i = CV_GIDX(cv_mem, k);
+      cv_mem->cv_grout[i] = cv_mem->cv_ghi[i];
+    }
     if (!zroot) return(CV_SUCCESS);
-    for (i = 0; i < cv_mem->cv_nrtfn; i++) {
-      cv_mem->cv_iroots[i] = 0;
+    for (i = 0; i < cv_mem->cv_nrtfn; i++) cv_mem->cv_iroots[i] = 0;
+    for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+      i = CV_GIDX(cv_mem, k);
       if(!cv_mem->cv_gactive[i]) continue;
       if ( (SUNRabs(cv_mem->cv_ghi[i]) == ZERO) &&
            (cv_mem->cv_rootdir[i]*cv_mem->cv_glo[i] <= ZERO) )
@@ -4126,8 +5038,7 @@ static int cvRootfind(CVodeMem cv_mem)
     }
 
     (void) CVodeGetDky(cv_mem, tmid, 0, cv_mem->cv_y);
-    retval = cv_mem->cv_gfun(tmid, cv_mem->cv_y, cv_mem->cv_grout,
-                             cv_mem->cv_user_data);
+    retval = cvRootEval(cv_mem, tmid, cv_mem->cv_y, cv_mem->cv_grout, SUNFALSE);
     cv_mem->cv_nge++;
     if (retval != 0) return(CV_RTFUNC_FAIL);
 
@@ -4137,7 +5048,8 @@ static int cvRootfind(CVodeMem cv_mem)
     zroot = SUNFALSE;
     sgnchg = SUNFALSE;
     sideprev = side;
-    for (i = 0;  i < cv_mem->cv_nrtfn; i++) {
+    for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+      i = CV_GIDX(cv_mem, k);
       if(!cv_mem->cv_gactive[i]) continue;
       if (SUNRabs(cv_mem->cv_grout[i]) == ZERO) {
         if(cv_mem->cv_rootdir[i]*cv_mem->cv_glo[i] <= ZERO) zroot = SUNTRUE;
@@ -4157,8 +5069,10 @@ static int cvRootfind(CVodeMem cv_mem)
     if (sgnchg) {
       /* Sign change found in (tlo,tmid); replace thi with tmid. */
       cv_mem->cv_thi = tmid;
-      for (i = 0; i < cv_mem->cv_nrtfn; i++)
+      for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+        i = CV_GIDX(cv_mem, k);
         cv_mem->cv_ghi[i] = cv_mem->cv_grout[i];
+      }
       side = 1;
       /* Stop at root thi if converged; otherwise loop. */
       if (SUNRabs(cv_mem->cv_thi - cv_mem->cv_tlo) <= cv_mem->cv_ttol) break;
@@ -4168,16 +5082,20 @@ static int cvRootfind(CVodeMem cv_mem)
     if (zroot) {
       /* No sign change in (tlo,tmid), but g = 0 at tmid; return root tmid. */
       cv_mem->cv_thi = tmid;
-      for (i = 0; i < cv_mem->cv_nrtfn; i++)
+      for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+        i = CV_GIDX(cv_mem, k);
         cv_mem->cv_ghi[i] = cv_mem->cv_grout[i];
+      }
       break;
     }
 
     /* No sign change in (tlo,tmid), and no zero at tmid.
        Sign change must be in (tmid,thi).  Replace tlo with tmid. */
     cv_mem->cv_tlo = tmid;
-    for (i = 0; i < cv_mem->cv_nrtfn; i++)
+    for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+      i = CV_GIDX(cv_mem, k);
       cv_mem->cv_glo[i] = cv_mem->cv_grout[i];
+    }
     side = 2;
     /* Stop at root thi if converged; otherwise loop back. */
     if (SUNRabs(cv_mem->cv_thi - cv_mem->cv_tlo) <= cv_mem->cv_ttol) break;
@@ -4186,9 +5104,10 @@ static int cvRootfind(CVodeMem cv_mem)
 
   /* Reset trout and grout, set iroots, and return RTFOUND. */
   cv_mem->cv_trout = cv_mem->cv_thi;
-  for (i = 0; i < cv_mem->cv_nrtfn; i++) {
+  for (i = 0; i < cv_mem->cv_nrtfn; i++) cv_mem->cv_iroots[i] = 0;
+  for (k = 0; k < CV_NGIDX(cv_mem); k++) {
+    i = CV_GIDX(cv_mem, k);
     cv_mem->cv_grout[i] = cv_mem->cv_ghi[i];
-    cv_mem->cv_iroots[i] = 0;
     if(!cv_mem->cv_gactive[i]) continue;
     if ( (SUNRabs(cv_mem->cv_ghi[i]) == ZERO) &&
          (cv_mem->cv_rootdir[i]*cv_mem->cv_glo[i] <= ZERO) )
@@ -4200,6 +5119,167 @@ static int cvRootfind(CVodeMem cv_mem)
   return(RTFOUND);
 }
 
+/*
+ * cvRootEval
+ *
+ * This routine evaluates g at (t,y) into gout, with gfun or, if set,
+ * with gchgfun. gchgfun updates the components of gcur that changed
+ * since its last call and reports them; these are added to the active
+ * set gset, and only the components in gset are copied to gout.
+ * Components outside of gset have the same value in glo, ghi and grout.
+ * If full is SUNTRUE (or gfull is set), gchgfun has to set all of gcur.
+ */
+
+static int cvRootEval(CVodeMem cv_mem, realtype t, N_Vector y,
+                      realtype *gout, booleantype full)
+{
+  int i, k, nchg, retval;
+
+  if (cv_mem->cv_gchgfun == NULL)
+    return(cv_mem->cv_gfun(t, y, gout, cv_mem->cv_user_data));
+
+  nchg = (full || cv_mem->cv_gfull) ? -1 : 0;
+  retval = cv_mem->cv_gchgfun(t, y, cv_mem->cv_gcur, &nchg, cv_mem->cv_gchg,
+                              cv_mem->cv_user_data);
+  if (retval != 0) return(retval);
+  cv_mem->cv_gfull = SUNFALSE;
+
+  /* All components changed */
+  if (nchg < 0 || nchg >= cv_mem->cv_nrtfn) {
+    nchg = cv_mem->cv_nrtfn;
+    for (i = 0; i < nchg; i++) cv_mem->cv_gchg[i] = i;
+  }
+
+  for (k = 0; k < nchg; k++) {
+    i = cv_mem->cv_gchg[k];
+    if (i < 0 || i >= cv_mem->cv_nrtfn) return(-1);
+    if (cv_mem->cv_ginset[i]) continue;
+    cv_mem->cv_ginset[i] = SUNTRUE;
+    cv_mem->cv_gset[cv_mem->cv_ngset++] = i;
+  }
+
+  for (k = 0; k < cv_mem->cv_ngset; k++) {
+    i = cv_mem->cv_gset[k];
+    gout[i] = cv_mem->cv_gcur[i];
+  }
+
+  return(0);
+}
+
+/*
+ * cvRootShrinkSet
+ *
+ * This routine removes the components from the active set gset whose
+ * value at the new left endpoint tlo equals their value at the last
+ * call of gchgfun, except for exact zeros which cvRcheck2 still has
+ * to see. A removed component gets this value in ghi and grout too.
+ */
+
+static void cvRootShrinkSet(CVodeMem cv_mem)
+{
+  int i, k, m;
+
+  m = 0;
+  for (k = 0; k < cv_mem->cv_ngset; k++) {
+    i = cv_mem->cv_gset[k];
+    if (cv_mem->cv_glo[i] != cv_mem->cv_gcur[i] || cv_mem->cv_glo[i] == ZERO) {
+      cv_mem->cv_gset[m++] = i;
+    } else {
+      cv_mem->cv_ginset[i] = SUNFALSE;
+      cv_mem->cv_ghi[i] = cv_mem->cv_glo[i];
+      cv_mem->cv_grout[i] = cv_mem->cv_glo[i];
+    }
+  }
+  cv_mem->cv_ngset = m;
+}
+
+/*
+ * cvRootChangedFree
+ *
+ * This routine frees the memory allocated by CVodeSetRootChangedFn
+ * and switches back to gfun.
+ */
+
+void cvRootChangedFree(CVodeMem cv_mem)
+{
+  if (cv_mem->cv_gcur != NULL) {
+    cv_mem->cv_lrw -= cv_mem->cv_nrtfn;
+    cv_mem->cv_liw -= 3*cv_mem->cv_nrtfn;
+  }
+  free(cv_mem->cv_gcur);   cv_mem->cv_gcur = NULL;
+  free(cv_mem->cv_gchg);   cv_mem->cv_gchg = NULL;
+  free(cv_mem->cv_gset);   cv_mem->cv_gset = NULL;
+  free(cv_mem->cv_ginset); cv_mem->cv_ginset = NULL;
+  cv_mem->cv_gchgfun = NULL;
+  cv_mem->cv_ngset = 0;
+}
+
+/*
+ * =================================================================
+ * Ensemble norm
+ * =================================================================
+ */
+
+/*
+ * cvWrmsNorm
+ *
+ * This routine returns the weighted RMS norm of x used by the error
+ * test, the step size selection and the nonlinear solver convergence
+ * test. For an ensemble set with CVodeSetEnsemble it is the largest of
+ * the norms of the members, each one taken over the ens_n components
+ * of its member, so that every member meets its tolerances however
+ * many members share the step. Otherwise it is N_VWrmsNorm(x, w).
+ */
+
+realtype cvWrmsNorm(CVodeMem cv_mem, N_Vector x, N_Vector w)
+{
+  realtype *xd, *wd, *sums, prod, sum, nrm;
+  sunindextype i, n, m, nm;
+
+  if (cv_mem->cv_ens_nmembers < 2) return(N_VWrmsNorm(x, w));
+
+  xd = N_VGetArrayPointer(x);
+  wd = N_VGetArrayPointer(w);
+  n  = cv_mem->cv_ens_n;
+  nm = cv_mem->cv_ens_nmembers;
+  nrm = ZERO;
+
+  if (cv_mem->cv_ens_layout == CV_ENSEMBLE_BLOCKED) {
+
+    /* component i of member m is entry m*n+i */
+    for (m = 0; m < nm; m++) {
+      sum = ZERO;
+      for (i = 0; i < n; i++) {
+        prod = xd[i] * wd[i];
+        sum += prod * prod;
+      }
+      if (sum > nrm) nrm = sum;
+      xd += n;
+      wd += n;
+    }
+
+  } else {
+
+    /* component i of member m is entry i*nmembers+m, the inner loop
+       runs over the members */
+    sums = cv_mem->cv_ens_sums;
+    for (m = 0; m < nm; m++) sums[m] = ZERO;
+    for (i = 0; i < n; i++) {
+      for (m = 0; m < nm; m++) {
+        prod = xd[m] * wd[m];
+        sums[m] += prod * prod;
+      }
+      xd += nm;
+      wd += nm;
+    }
+    for (m = 0; m < nm; m++)
+      if (sums[m] > nrm) nrm = sums[m];
+
+  }
+
+  return(SUNRsqrt(nrm / n));
+}
+
 /*
  * =================================================================
  * Internal EWT function
@@ -4257,6 +5337,10 @@ int cvEwtSet(N_Vector ycur, N_Vector weight, void *data)
 
 static int cvEwtSetSS(CVodeMem cv_mem, N_Vector ycur, N_Vector weight)
 {
+  if (cv_mem->cv_usefusedcpu)
+    return(cvEwtSetSS_cpu(cv_mem->cv_atolmin0, cv_mem->cv_reltol,
+                          cv_mem->cv_Sabstol, ycur, weight));
+
 #ifdef SUNDIALS_BUILD_PACKAGE_FUSED_KERNELS
   if (cv_mem->cv_usefused)
   {
@@ -4296,6 +5380,10 @@ static int cvEwtSetSS(CVodeMem cv_mem, N_Vector ycur, N_Vector weight)
 
 static int cvEwtSetSV(CVodeMem cv_mem, N_Vector ycur, N_Vector weight)
 {
+  if (cv_mem->cv_usefusedcpu)
+    return(cvEwtSetSV_cpu(cv_mem->cv_atolmin0, cv_mem->cv_reltol,
+                          cv_mem->cv_Vabstol, ycur, weight));
+
 #ifdef SUNDIALS_BUILD_PACKAGE_FUSED_KERNELS
   if (cv_mem->cv_usefused)
   {
@@ -0,0 +1,340 @@
+/*
+ * -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This file implements fused CPU kernels for CVODE. They operate
+ * directly on the data arrays of vectors with contiguous host
+ * memory (serial, and OpenMP if CVODE is compiled with OpenMP) and
+ * replace sequences of vector operations in the integrator by a
+ * single pass over memory.
+ * -----------------------------------------------------------------
+ */
+
+#include "cvode_impl.h"
+#include <sundials/sundials_math.h>
+
+#if defined(_OPENMP)
+#include <nvector/nvector_openmp.h>
+#endif
+
+#define ZERO   RCONST(0.0)
+#define PT1    RCONST(0.1)
+#define ONEPT5 RCONST(1.50)
+#define ONE    RCONST(1.0)
+
+/* Number of components processed at a time by the kernels working on the
+   Nordsieck array, L_MAX blocks of this size fit into the L1 cache */
+#define CV_FUSED_BLOCK 128
+
+/* Number of threads for a loop over the entries of v */
+#if defined(_OPENMP)
+#define CV_NTHREADS(v) \
+  ( (N_VGetVectorID(v) == SUNDIALS_NVEC_OPENMP) ? NV_NUM_THREADS_OMP(v) : 1 )
+#endif
+
+/*
+ * -----------------------------------------------------------------
+ * Check if the fused CPU kernels can be used with vectors like v.
+ * -----------------------------------------------------------------
+ */
+
+booleantype cvFusedCpuSupported(N_Vector v)
+{
+  if (v == NULL) return(SUNFALSE);
+
+  switch (N_VGetVectorID(v)) {
+  case SUNDIALS_NVEC_SERIAL:
+    return(SUNTRUE);
+#if defined(_OPENMP)
+  case SUNDIALS_NVEC_OPENMP:
+    return(SUNTRUE);
+#endif
+  default:
+    return(SUNFALSE);
+  }
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Compute the ewt vector when the tol type is CV_SS:
+ *   weight = 1 / (reltol*|ycur| + Sabstol)
+ * Returns -1 if atolmin0 is set and a component of the denominator
+ * is not positive, in which case weight is undefined.
+ * -----------------------------------------------------------------
+ */
+
+int cvEwtSetSS_cpu(booleantype atolmin0, realtype reltol, realtype Sabstol,
+                   N_Vector ycur, N_Vector weight)
+{
+  sunindextype i, N;
+  realtype *yd, *wd, tmp;
+  int nonpos;
+
+  N  = N_VGetLength(ycur);
+  yd = N_VGetArrayPointer(ycur);
+  wd = N_VGetArrayPointer(weight);
+  nonpos = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i,tmp) shared(N,yd,wd,reltol,Sabstol) \
+  reduction(+:nonpos) schedule(static) num_threads(CV_NTHREADS(ycur))
+#endif
+  for (i = 0; i < N; i++) {
+    tmp = reltol * SUNRabs(yd[i]) + Sabstol;
+    if (tmp <= ZERO) nonpos++;
+    wd[i] = ONE / tmp;
+  }
+
+  if (atolmin0 && nonpos > 0) return(-1);
+  return(0);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Compute the ewt vector when the tol type is CV_SV:
+ *   weight = 1 / (reltol*|ycur| + Vabstol)
+ * -----------------------------------------------------------------
+ */
+
+int cvEwtSetSV_cpu(booleantype atolmin0, realtype reltol, N_Vector Vabstol,
+                   N_Vector ycur, N_Vector weight)
+{
+  sunindextype i, N;
+  realtype *yd, *ad, *wd, tmp;
+  int nonpos;
+
+  N  = N_VGetLength(ycur);
+  yd = N_VGetArrayPointer(ycur);
+  ad = N_VGetArrayPointer(Vabstol);
+  wd = N_VGetArrayPointer(weight);
+  nonpos = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i,tmp) shared(N,yd,ad,wd,reltol) \
+  reduction(+:nonpos) schedule(static) num_threads(CV_NTHREADS(ycur))
+#endif
+  for (i = 0; i < N; i++) {
+    tmp = reltol * SUNRabs(yd[i]) + ad[i];
+    if (tmp <= ZERO) nonpos++;
+    wd[i] = ONE / tmp;
+  }
+
+  if (atolmin0 && nonpos > 0) return(-1);
+  return(0);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Compute the constraint correction
+ *   tmp = mm * (y - 0.1 * a * c / ewt),  a[i] = 1 when |c[i]| = 2
+ * and return its WRMS norm with weights ewt.
+ * -----------------------------------------------------------------
+ */
+
+realtype cvCheckConstraints_cpu(N_Vector c, N_Vector ewt, N_Vector y,
+                                N_Vector mm, N_Vector tmp)
+{
+  sunindextype i, N;
+  realtype *cd, *wd, *yd, *md, *td, ai, prodi, sum;
+
+  N  = N_VGetLength(y);
+  cd = N_VGetArrayPointer(c);
+  wd = N_VGetArrayPointer(ewt);
+  yd = N_VGetArrayPointer(y);
+  md = N_VGetArrayPointer(mm);
+  td = N_VGetArrayPointer(tmp);
+  sum = ZERO;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i,ai,prodi) shared(N,cd,wd,yd,md,td) \
+  reduction(+:sum) schedule(static) num_threads(CV_NTHREADS(y))
+#endif
+  for (i = 0; i < N; i++) {
+    ai    = (SUNRabs(cd[i]) >= ONEPT5) ? ONE : ZERO;
+    td[i] = md[i] * (yd[i] - PT1 * ((ai * cd[i]) / wd[i]));
+    prodi = td[i] * wd[i];
+    sum  += SUNSQR(prodi);
+  }
+
+  return(SUNRsqrt(sum / N));
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Compute the nonlinear residual
+ *   res = rl1 * zn1 + ycor + ngamma * ftemp
+ * -----------------------------------------------------------------
+ */
+
+void cvNlsResid_cpu(realtype rl1, realtype ngamma, N_Vector zn1,
+                    N_Vector ycor, N_Vector ftemp, N_Vector res)
+{
+  sunindextype i, N;
+  realtype *zd, *cd, *fd, *rd;
+
+  N  = N_VGetLength(ycor);
+  zd = N_VGetArrayPointer(zn1);
+  cd = N_VGetArrayPointer(ycor);
+  fd = N_VGetArrayPointer(ftemp);
+  rd = N_VGetArrayPointer(res);
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i) shared(N,zd,cd,fd,rd,rl1,ngamma) \
+  schedule(static) num_threads(CV_NTHREADS(ycor))
+#endif
+  for (i = 0; i < N; i++)
+    rd[i] = ngamma * fd[i] + (rl1 * zd[i] + cd[i]);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Compute the predicted Nordsieck array, zn <- zn * Pascal matrix,
+ * (sign = ONE) or undo the prediction (sign = -ONE). The repeated
+ * additions of cvPredict/cvRestore are done block by block, so each
+ * block of zn stays in the L1 cache and zn is read and written once
+ * instead of q*(q+1)/2 times.
+ * -----------------------------------------------------------------
+ */
+
+void cvPredict_cpu(int q, realtype sign, N_Vector* zn)
+{
+  sunindextype i, i0, n, N;
+  realtype *zd[L_MAX], *a, *b;
+  int j, k;
+
+  N = N_VGetLength(zn[0]);
+  for (j = 0; j <= q; j++) zd[j] = N_VGetArrayPointer(zn[j]);
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i,i0,n,j,k,a,b) shared(N,zd,q,sign) \
+  schedule(static) num_threads(CV_NTHREADS(zn[0]))
+#endif
+  for (i0 = 0; i0 < N; i0 += CV_FUSED_BLOCK) {
+    n = SUNMIN(CV_FUSED_BLOCK, N - i0);
+    for (k = 1; k <= q; k++) {
+      for (j = q; j >= k; j--) {
+        a = zd[j-1] + i0;
+        b = zd[j] + i0;
+        for (i = 0; i < n; i++)
+          a[i] += sign * b[i];
+      }
+    }
+  }
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Apply the correction to the Nordsieck array after a successful
+ * step, zn[j] += l[j] * acor for j = 0,...,q, block by block so a
+ * block of acor is read from memory once for all columns of zn.
+ * -----------------------------------------------------------------
+ */
+
+void cvCorrectZn_cpu(int q, realtype* l, N_Vector acor, N_Vector* zn)
+{
+  sunindextype i, i0, n, N;
+  realtype *zd[L_MAX], *ad, *a, *b, lj;
+  int j;
+
+  N  = N_VGetLength(acor);
+  ad = N_VGetArrayPointer(acor);
+  for (j = 0; j <= q; j++) zd[j] = N_VGetArrayPointer(zn[j]);
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i,i0,n,j,a,b,lj) shared(N,zd,ad,l,q) \
+  schedule(static) num_threads(CV_NTHREADS(acor))
+#endif
+  for (i0 = 0; i0 < N; i0 += CV_FUSED_BLOCK) {
+    n = SUNMIN(CV_FUSED_BLOCK, N - i0);
+    b = ad + i0;
+    for (j = 0; j <= q; j++) {
+      a  = zd[j] + i0;
+      lj = l[j];
+      for (i = 0; i < n; i++)
+        a[i] += lj * b[i];
+    }
+  }
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Form the corrected state y = zn0 + acor after the nonlinear solve
+ * and return the WRMS norm of acor with weights ewt, which is used
+ * in the local error test.
+ * -----------------------------------------------------------------
+ */
+
+realtype cvUpdateY_cpu(N_Vector zn0, N_Vector acor, N_Vector ewt, N_Vector y)
+{
+  sunindextype i, N;
+  realtype *zd, *ad, *wd, *yd, prodi, sum;
+
+  N  = N_VGetLength(acor);
+  zd = N_VGetArrayPointer(zn0);
+  ad = N_VGetArrayPointer(acor);
+  wd = N_VGetArrayPointer(ewt);
+  yd = N_VGetArrayPointer(y);
+  sum = ZERO;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i,prodi) shared(N,zd,ad,wd,yd) \
+  reduction(+:sum) schedule(static) num_threads(CV_NTHREADS(acor))
+#endif
+  for (i = 0; i < N; i++) {
+    yd[i] = zd[i] + ad[i];
+    prodi = ad[i] * wd[i];
+    sum  += SUNSQR(prodi);
+  }
+
+  return(SUNRsqrt(sum / N));
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Compute the WRMS norms used in the selection of the next order,
+ * of zn[q] for order q-1 and of acor - cquot*zn[qmax] for order q+1,
+ * in one pass. znq or znqmax is NULL if that order is not considered
+ * and its norm is then not computed.
+ * -----------------------------------------------------------------
+ */
+
+void cvOrderNorms_cpu(N_Vector znq, realtype cquot, N_Vector znqmax,
+                      N_Vector acor, N_Vector ewt, realtype* nrmqm1,
+                      realtype* nrmqp1)
+{
+  sunindextype i, N;
+  realtype *qd, *md, *ad, *wd, prodi, summ1, sump1;
+
+  N  = N_VGetLength(ewt);
+  qd = (znq != NULL) ? N_VGetArrayPointer(znq) : NULL;
+  md = (znqmax != NULL) ? N_VGetArrayPointer(znqmax) : NULL;
+  ad = N_VGetArrayPointer(acor);
+  wd = N_VGetArrayPointer(ewt);
+  summ1 = sump1 = ZERO;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) private(i,prodi) shared(N,qd,md,ad,wd,cquot) \
+  reduction(+:summ1,sump1) schedule(static) num_threads(CV_NTHREADS(ewt))
+#endif
+  for (i = 0; i < N; i++) {
+    if (qd != NULL) {
+      prodi  = qd[i] * wd[i];
+      summ1 += SUNSQR(prodi);
+    }
+    if (md != NULL) {
+      prodi  = (ad[i] - cquot * md[i]) * wd[i];
+      sump1 += SUNSQR(prodi);
+    }
+  }
+
+  *nrmqm1 = SUNRsqrt(summ1 / N);
+  *nrmqp1 = SUNRsqrt(sump1 / N);
+}
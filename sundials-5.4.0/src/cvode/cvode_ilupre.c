@@ -0,0 +1,451 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This file contains implementations of the incomplete LU
+ * preconditioner and solver routines for use with the CVLS linear
+ * solver interface.
+ * -----------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cvode_impl.h"
+#include "cvode_ilupre_impl.h"
+#include "cvode_ls_impl.h"
+#include <sundials/sundials_math.h>
+
+#define ZERO RCONST(0.0)
+
+/* Prototypes of CVILUPrecSetup and CVILUPrecSolve */
+static int CVILUPrecSetup(realtype t, N_Vector y, N_Vector fy,
+                          booleantype jok, booleantype *jcurPtr,
+                          realtype gamma, void *ip_data);
+static int CVILUPrecSolve(realtype t, N_Vector y, N_Vector fy,
+                          N_Vector r, N_Vector z,
+                          realtype gamma, realtype delta,
+                          int lr, void *ip_data);
+
+/* Prototype for CVILUPrecFree */
+static int CVILUPrecFree(CVodeMem cv_mem);
+
+/* Access to the preconditioner data */
+static int cvILUPrec_AccessPData(void *cvode_mem, const char *fname,
+                                 CVodeMem *cv_mem, CVILUPrecData *pdata);
+
+
+/*-----------------------------------------------------------------
+  Initialization, Free, and Get Functions
+  NOTE: The ILU triangular solves access the vector data directly.
+        Therefore, CVILUPrecInit will first test for a compatible
+        N_Vector internal representation by checking that the
+        function N_VGetArrayPointer exists.
+  -----------------------------------------------------------------*/
+int CVILUPrecInit(void *cvode_mem, SUNMatrix J, CVLsJacFn jac,
+                  int ilutype)
+{
+  CVodeMem cv_mem;
+  CVLsMem cvls_mem;
+  CVILUPrecData pdata;
+  CVLsSparsity S;
+  sunindextype N;
+  int flag;
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CVLS_MEM_NULL, "CVILUPRE",
+                   "CVILUPrecInit", MSGIP_MEM_NULL);
+    return(CVLS_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  /* Test if the CVLS linear solver interface has been attached */
+  if (cv_mem->cv_lmem == NULL) {
+    cvProcessError(cv_mem, CVLS_LMEM_NULL, "CVILUPRE",
+                   "CVILUPrecInit", MSGIP_LMEM_NULL);
+    return(CVLS_LMEM_NULL);
+  }
+  cvls_mem = (CVLsMem) cv_mem->cv_lmem;
+
+  /* Test compatibility of NVECTOR package with the ILU preconditioner */
+  if(cv_mem->cv_tempv->ops->nvgetarraypointer == NULL) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVILUPRE",
+                   "CVILUPrecInit", MSGIP_BAD_NVECTOR);
+    return(CVLS_ILL_INPUT);
+  }
+
+  /* Test the template matrix and the factorization type */
+  if ( (J == NULL) || (J->ops->getid == NULL) ||
+       (SUNMatGetID(J) != SUNMATRIX_SPARSE) ||
+       (SUNSparseMatrix_Rows(J) != SUNSparseMatrix_Columns(J)) ||
+       (SUNSparseMatrix_Rows(J) != N_VGetLength(cv_mem->cv_tempv)) ) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVILUPRE",
+                   "CVILUPrecInit", MSGIP_BAD_MATRIX);
+    return(CVLS_ILL_INPUT);
+  }
+  if ((ilutype != SUNILU_ILU0) && (ilutype != SUNILU_ILUT)) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVILUPRE",
+                   "CVILUPrecInit", MSGIP_BAD_TYPE);
+    return(CVLS_ILL_INPUT);
+  }
+  N = SUNSparseMatrix_Rows(J);
+
+  /* Without a Jacobian routine the pattern of J drives the colored
+     difference quotients of cvLsSparseDQJac */
+  if (jac == NULL) {
+    S = cvls_mem->jpattern;
+    if ( (S == NULL) || (S->N != N) ||
+         (S->jactype != SUNSparseMatrix_SparseType(J)) ) {
+      S = cvLsSparsityCreate(J, SUNSparseMatrix_SparseType(J));
+      if (S == NULL) {
+        cvProcessError(cv_mem, CVLS_MEM_FAIL, "CVILUPRE",
+                       "CVILUPrecInit", MSGIP_MEM_FAIL);
+        return(CVLS_MEM_FAIL);
+      }
+      cvLsSparsityFree(&(cvls_mem->jpattern));
+      cvls_mem->jpattern = S;
+    }
+  }
+
+  /* Allocate data memory */
+  pdata = NULL;
+  pdata = (CVILUPrecData) calloc(1, sizeof *pdata);
+  if (pdata == NULL) {
+    cvProcessError(cv_mem, CVLS_MEM_FAIL, "CVILUPRE",
+                   "CVILUPrecInit", MSGIP_MEM_FAIL);
+    return(CVLS_MEM_FAIL);
+  }
+
+  /* Load pointers into pdata block. */
+  pdata->cvode_mem = cvode_mem;
+  pdata->jac = jac;
+  pdata->njeIP = 0;
+
+  /* Allocate memory for the saved Jacobian, the preconditioner
+     matrix, the factorization and temporary N_Vectors */
+  pdata->savedJ = SUNMatClone(J);
+  pdata->savedP = SUNMatClone(J);
+  pdata->ilu    = SUNILUCreate(ilutype, N);
+  pdata->tmp1   = N_VClone(cv_mem->cv_tempv);
+  pdata->tmp2   = N_VClone(cv_mem->cv_tempv);
+  pdata->tmp3   = N_VClone(cv_mem->cv_tempv);
+  if ( (pdata->savedJ == NULL) || (pdata->savedP == NULL) ||
+       (pdata->ilu == NULL) || (pdata->tmp1 == NULL) ||
+       (pdata->tmp2 == NULL) || (pdata->tmp3 == NULL) ) {
+    if (pdata->savedJ) SUNMatDestroy(pdata->savedJ);
+    if (pdata->savedP) SUNMatDestroy(pdata->savedP);
+    SUNILUFree(pdata->ilu);
+    if (pdata->tmp1) N_VDestroy(pdata->tmp1);
+    if (pdata->tmp2) N_VDestroy(pdata->tmp2);
+    if (pdata->tmp3) N_VDestroy(pdata->tmp3);
+    free(pdata); pdata = NULL;
+    cvProcessError(cv_mem, CVLS_MEM_FAIL, "CVILUPRE",
+                   "CVILUPrecInit", MSGIP_MEM_FAIL);
+    return(CVLS_MEM_FAIL);
+  }
+
+  /* make sure P_data is free from any previous allocations */
+  if (cvls_mem->pfree)
+    cvls_mem->pfree(cv_mem);
+
+  /* Point to the new P_data field in the LS memory */
+  cvls_mem->P_data = pdata;
+
+  /* Attach the pfree function */
+  cvls_mem->pfree = CVILUPrecFree;
+
+  /* Attach preconditioner solve and setup functions */
+  flag = CVodeSetPreconditioner(cvode_mem,
+                                CVILUPrecSetup,
+                                CVILUPrecSolve);
+  return(flag);
+}
+
+
+int CVILUPrecSetThresholds(void *cvode_mem, realtype droptol,
+                           sunindextype lfil)
+{
+  CVodeMem cv_mem;
+  CVILUPrecData pdata;
+  int retval;
+
+  retval = cvILUPrec_AccessPData(cvode_mem, "CVILUPrecSetThresholds",
+                                 &cv_mem, &pdata);
+  if (retval != CVLS_SUCCESS) return(retval);
+
+  if (SUNILUSetThresholds(pdata->ilu, droptol, lfil) != SUNILU_SUCCESS) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVILUPRE",
+                   "CVILUPrecSetThresholds", MSGIP_BAD_INPUT);
+    return(CVLS_ILL_INPUT);
+  }
+
+  return(CVLS_SUCCESS);
+}
+
+
+int CVILUPrecSetNumThreads(void *cvode_mem, int nthreads)
+{
+  CVodeMem cv_mem;
+  CVILUPrecData pdata;
+  int retval;
+
+  retval = cvILUPrec_AccessPData(cvode_mem, "CVILUPrecSetNumThreads",
+                                 &cv_mem, &pdata);
+  if (retval != CVLS_SUCCESS) return(retval);
+
+  if (SUNILUSetNumThreads(pdata->ilu, nthreads) != SUNILU_SUCCESS) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVILUPRE",
+                   "CVILUPrecSetNumThreads", MSGIP_BAD_INPUT);
+    return(CVLS_ILL_INPUT);
+  }
+
+  return(CVLS_SUCCESS);
+}
+
+
+int CVILUPrecGetWorkSpace(void *cvode_mem, long int *lenrwIP,
+                          long int *leniwIP)
+{
+  CVodeMem cv_mem;
+  CVILUPrecData pdata;
+  sunindextype lrw1, liw1;
+  long int lrw, liw;
+  int retval;
+
+  retval = cvILUPrec_AccessPData(cvode_mem, "CVILUPrecGetWorkSpace",
+                                 &cv_mem, &pdata);
+  if (retval != CVLS_SUCCESS) return(retval);
+
+  /* sum space requirements for all objects in pdata */
+  *leniwIP = 4;
+  *lenrwIP = 0;
+  if (cv_mem->cv_tempv->ops->nvspace) {
+    N_VSpace(cv_mem->cv_tempv, &lrw1, &liw1);
+    *leniwIP += 3*liw1;
+    *lenrwIP += 3*lrw1;
+  }
+  if (pdata->savedJ->ops->space) {
+    retval = SUNMatSpace(pdata->savedJ, &lrw, &liw);
+    if (retval != 0) return(-1);
+    *leniwIP += liw;
+    *lenrwIP += lrw;
+  }
+  if (pdata->savedP->ops->space) {
+    retval = SUNMatSpace(pdata->savedP, &lrw, &liw);
+    if (retval != 0) return(-1);
+    *leniwIP += liw;
+    *lenrwIP += lrw;
+  }
+  SUNILUGetWorkSpace(pdata->ilu, &lrw, &liw);
+  *leniwIP += liw;
+  *lenrwIP += lrw;
+
+  return(CVLS_SUCCESS);
+}
+
+
+int CVILUPrecGetNumJacEvals(void *cvode_mem, long int *njevalsIP)
+{
+  CVodeMem cv_mem;
+  CVILUPrecData pdata;
+  int retval;
+
+  retval = cvILUPrec_AccessPData(cvode_mem, "CVILUPrecGetNumJacEvals",
+                                 &cv_mem, &pdata);
+  if (retval != CVLS_SUCCESS) return(retval);
+
+  *njevalsIP = pdata->njeIP;
+
+  return(CVLS_SUCCESS);
+}
+
+
+int CVILUPrecGetNumLevels(void *cvode_mem, sunindextype *nlevL,
+                          sunindextype *nlevU)
+{
+  CVodeMem cv_mem;
+  CVILUPrecData pdata;
+  int retval;
+
+  retval = cvILUPrec_AccessPData(cvode_mem, "CVILUPrecGetNumLevels",
+                                 &cv_mem, &pdata);
+  if (retval != CVLS_SUCCESS) return(retval);
+
+  SUNILUGetNumLevels(pdata->ilu, nlevL, nlevU);
+
+  return(CVLS_SUCCESS);
+}
+
+
+/*-----------------------------------------------------------------
+  CVILUPrecSetup
+  -----------------------------------------------------------------
+  Together CVILUPrecSetup and CVILUPrecSolve use an incomplete LU
+  factorization of the Newton matrix as a preconditioner.
+  CVILUPrecSetup calculates a new J, if necessary, with the user
+  Jacobian routine or with sparse difference quotients, then
+  calculates P = I - gamma*J and computes its incomplete factors.
+
+  jok     is an input flag indicating whether Jacobian-related
+          data needs to be recomputed (SUNFALSE) or the saved J can
+          be reused with the current value of gamma (SUNTRUE).
+
+  *jcurPtr is set to SUNTRUE if J was recomputed and to SUNFALSE
+           otherwise.
+
+  The value to be returned by the CVILUPrecSetup function is
+    0  if successful,
+    1  if the Jacobian routine failed recoverably, or
+   -1  if an unrecoverable error occurred.
+  -----------------------------------------------------------------*/
+static int CVILUPrecSetup(realtype t, N_Vector y, N_Vector fy,
+                          booleantype jok, booleantype *jcurPtr,
+                          realtype gamma, void *ip_data)
+{
+  CVILUPrecData pdata;
+  CVodeMem cv_mem;
+  int retval;
+
+  pdata = (CVILUPrecData) ip_data;
+  cv_mem = (CVodeMem) pdata->cvode_mem;
+
+  if (!jok) {
+
+    /* If jok = SUNFALSE, compute a new J value. */
+    *jcurPtr = SUNTRUE;
+    retval = SUNMatZero(pdata->savedJ);
+    if (retval) {
+      cvProcessError(cv_mem, -1, "CVILUPRE",
+                     "CVILUPrecSetup", MSGIP_SUNMAT_FAIL);
+      return(-1);
+    }
+
+    pdata->njeIP++;
+    if (pdata->jac)
+      retval = pdata->jac(t, y, fy, pdata->savedJ, cv_mem->cv_user_data,
+                          pdata->tmp1, pdata->tmp2, pdata->tmp3);
+    else
+      retval = cvLsSparseDQJac(t, y, fy, pdata->savedJ, cv_mem,
+                               pdata->tmp1, pdata->tmp2);
+    if (retval < 0) {
+      cvProcessError(cv_mem, -1, "CVILUPRE",
+                     "CVILUPrecSetup", MSGIP_JACFUNC_FAILED);
+      return(-1);
+    }
+    if (retval > 0) {
+      return(1);
+    }
+
+  } else {
+    *jcurPtr = SUNFALSE;
+  }
+
+  /* Copy J and scale and add identity to get savedP = I - gamma*J. */
+  retval = SUNMatCopy(pdata->savedJ, pdata->savedP);
+  if (retval == 0)
+    retval = SUNMatScaleAddI(-gamma, pdata->savedP);
+  if (retval) {
+    cvProcessError(cv_mem, -1, "CVILUPRE",
+                   "CVILUPrecSetup", MSGIP_SUNMAT_FAIL);
+    return(-1);
+  }
+
+  /* Compute the incomplete factors */
+  retval = SUNILUFactor(pdata->ilu, pdata->savedP);
+  if (retval != SUNILU_SUCCESS) {
+    cvProcessError(cv_mem, -1, "CVILUPRE",
+                   "CVILUPrecSetup", MSGIP_ILU_FAIL);
+    return(-1);
+  }
+
+  return(0);
+}
+
+
+/*-----------------------------------------------------------------
+  CVILUPrecSolve
+  -----------------------------------------------------------------
+  CVILUPrecSolve solves a linear system P z = r, where P is the
+  incomplete LU factorization computed by CVILUPrecSetup.
+
+  The value returned by the CVILUPrecSolve function is 0 if
+  successful and -1 otherwise.
+  -----------------------------------------------------------------*/
+static int CVILUPrecSolve(realtype t, N_Vector y, N_Vector fy,
+                          N_Vector r, N_Vector z, realtype gamma,
+                          realtype delta, int lr, void *ip_data)
+{
+  CVILUPrecData pdata;
+
+  pdata = (CVILUPrecData) ip_data;
+
+  if (SUNILUSolve(pdata->ilu, r, z) != SUNILU_SUCCESS) return(-1);
+  return(0);
+}
+
+
+static int CVILUPrecFree(CVodeMem cv_mem)
+{
+  CVLsMem cvls_mem;
+  CVILUPrecData pdata;
+
+  if (cv_mem->cv_lmem == NULL) return(0);
+  cvls_mem = (CVLsMem) cv_mem->cv_lmem;
+
+  if (cvls_mem->P_data == NULL) return(0);
+  pdata = (CVILUPrecData) cvls_mem->P_data;
+
+  SUNILUFree(pdata->ilu);
+  SUNMatDestroy(pdata->savedP);
+  SUNMatDestroy(pdata->savedJ);
+  N_VDestroy(pdata->tmp1);
+  N_VDestroy(pdata->tmp2);
+  N_VDestroy(pdata->tmp3);
+
+  free(pdata);
+  pdata = NULL;
+
+  return(0);
+}
+
+
+/*-----------------------------------------------------------------
+  cvILUPrec_AccessPData
+
+  Shortcut routine to unpack the cv_mem and preconditioner data
+  structures. Returns CVLS_SUCCESS or a CVLS error flag.
+  -----------------------------------------------------------------*/
+static int cvILUPrec_AccessPData(void *cvode_mem, const char *fname,
+                                 CVodeMem *cv_mem, CVILUPrecData *pdata)
+{
+  CVLsMem cvls_mem;
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CVLS_MEM_NULL, "CVILUPRE", fname, MSGIP_MEM_NULL);
+    return(CVLS_MEM_NULL);
+  }
+  *cv_mem = (CVodeMem) cvode_mem;
+
+  if ((*cv_mem)->cv_lmem == NULL) {
+    cvProcessError(*cv_mem, CVLS_LMEM_NULL, "CVILUPRE", fname,
+                   MSGIP_LMEM_NULL);
+    return(CVLS_LMEM_NULL);
+  }
+  cvls_mem = (CVLsMem) (*cv_mem)->cv_lmem;
+
+  if ( (cvls_mem->P_data == NULL) || (cvls_mem->pfree != CVILUPrecFree) ) {
+    cvProcessError(*cv_mem, CVLS_PMEM_NULL, "CVILUPRE", fname,
+                   MSGIP_PMEM_NULL);
+    return(CVLS_PMEM_NULL);
+  }
+  *pdata = (CVILUPrecData) cvls_mem->P_data;
+
+  return(CVLS_SUCCESS);
+}
@@ -0,0 +1,72 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * Implementation header file for the CVILUPRE module.
+ * -----------------------------------------------------------------
+ */
+
+#ifndef _CVILUPRE_IMPL_H
+#define _CVILUPRE_IMPL_H
+
+#include <cvode/cvode_ilupre.h>
+#include <sunmatrix/sunmatrix_sparse.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/*-----------------------------------------------------------------
+  Type: CVILUPrecData
+  -----------------------------------------------------------------*/
+
+typedef struct CVILUPrecDataRec {
+
+  /* Data set by user in CVILUPrecInit */
+  CVLsJacFn jac;
+
+  /* Data set by CVILUPrecSetup */
+  SUNMatrix savedJ;
+  SUNMatrix savedP;
+  SUNILUMem ilu;
+  N_Vector tmp1;
+  N_Vector tmp2;
+  N_Vector tmp3;
+
+  /* Jacobian evaluations */
+  long int njeIP;
+
+  /* Pointer to cvode_mem */
+  void *cvode_mem;
+
+} *CVILUPrecData;
+
+/*-----------------------------------------------------------------
+  CVILUPRE error messages
+  -----------------------------------------------------------------*/
+
+#define MSGIP_MEM_NULL       "Integrator memory is NULL."
+#define MSGIP_LMEM_NULL      "Linear solver memory is NULL. One of the SPILS linear solvers must be attached."
+#define MSGIP_MEM_FAIL       "A memory request failed."
+#define MSGIP_BAD_NVECTOR    "A required vector operation is not implemented."
+#define MSGIP_BAD_MATRIX     "J must be a square SUNSparseMatrix of the problem size."
+#define MSGIP_BAD_TYPE       "Illegal value for ilutype. Legal values are SUNILU_ILU0 and SUNILU_ILUT."
+#define MSGIP_BAD_INPUT      "Illegal ILU threshold or number of threads."
+#define MSGIP_SUNMAT_FAIL    "An error arose from a SUNSparseMatrix routine."
+#define MSGIP_ILU_FAIL       "The incomplete LU factorization failed."
+#define MSGIP_PMEM_NULL      "ILU preconditioner memory is NULL. CVILUPrecInit must be called."
+#define MSGIP_JACFUNC_FAILED "The Jacobian routine failed in an unrecoverable manner."
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -291,6 +291,12 @@ typedef struct CVodeMemRec {
   void     *cv_lmem;  /* linear solver interface memory structure */
   long int  cv_msbp;  /* max number of steps between lsetip calls */
 
+  booleantype cv_lsetupreuse; /* keep the last lsetup across CVodeReInit?   */
+  booleantype cv_lsetupok;    /* last lsetup succeeded and was not
+                                 invalidated by CVodeInvalidateJac         */
+  booleantype cv_lsetupkept;  /* the lsetup data of the previous integration
+                                 is used until the next lsetup call        */
+
   /*------------
     Saved Values
     ------------*/
@@ -327,6 +333,11 @@ typedef struct CVodeMemRec {
   CVMonitorFn cv_monitorfun;     /* func called with CVODE mem and user data  */
   long int cv_monitor_interval;  /* step interval to call cv_monitorfun       */
 
+  /*-------------------------------------------
+    Profiling
+    -------------------------------------------*/
+  SUNProfiler cv_profiler;       /* timers of CVode, its solvers and the ops  */
+
   /*-------------------------
     Stability Limit Detection
     -------------------------*/
@@ -336,6 +347,24 @@ typedef struct CVodeMemRec {
   int cv_nscon;               /* counter for STALD method                     */
   long int cv_nor;            /* counter for number of order reductions       */
 
+  /*------------------------------
+    Automatic Adams / BDF switching
+    ------------------------------*/
+
+  booleantype cv_swon;        /* is automatic method switching on?            */
+  SUNNonlinearSolver cv_swNLSfp;     /* fixed point solver of Adams phases    */
+  SUNNonlinearSolver cv_swNLSnewton; /* Newton solver of BDF phases           */
+  N_Vector cv_swfpred;        /* f at the predictor, for the estimate of |J|  */
+  booleantype cv_swgrab;      /* save the next f evaluation in swfpred?       */
+  int cv_swqadams;            /* qmax in Adams phases                         */
+  int cv_swqbdf;              /* qmax in BDF phases                           */
+  realtype cv_swlipfp;        /* largest L from fixed point rates of the step */
+  realtype cv_swlip;          /* estimate of the Lipschitz constant of f      */
+  long int cv_nstsw;          /* step number of the last method switch        */
+  long int cv_nstlip;         /* step number of the last estimate of swlip    */
+  long int cv_nstab;          /* consecutive Adams steps at the stability bound */
+  long int cv_nsw;            /* number of method switches                    */
+
   /*----------------
     Rootfinding Data
     ----------------*/
@@ -358,6 +387,27 @@ typedef struct CVodeMemRec {
   booleantype *cv_gactive; /* array with active/inactive event functions      */
   int cv_mxgnull;          /* number of warning messages about possible g==0  */
 
+  /*----------------------------------------------------------
+    Rootfinding Data for a root function reporting its changes
+    ----------------------------------------------------------*/
+
+  CVRootChangedFn cv_gchgfun; /* replaces gfun if not NULL                   */
+  realtype *cv_gcur;       /* g values of the last call of gchgfun            */
+  int *cv_gchg;            /* components changed in the last call of gchgfun  */
+  int *cv_gset;            /* components of g scanned for roots (active set)  */
+  int cv_ngset;            /* number of components in gset                    */
+  booleantype *cv_ginset;  /* is a component of g in gset?                    */
+  booleantype cv_gfull;    /* next call of gchgfun must set all of gcur       */
+
+  /*-------------
+    Ensemble Data
+    -------------*/
+
+  int cv_ens_nmembers;     /* number of independent members, 0 if none        */
+  int cv_ens_layout;       /* CV_ENSEMBLE_BLOCKED or CV_ENSEMBLE_INTERLEAVED  */
+  sunindextype cv_ens_n;   /* number of equations of each member              */
+  realtype *cv_ens_sums;   /* per-member sums of squares of a norm            */
+
   /*---------------
     Projection Data
     ---------------*/
@@ -375,6 +425,7 @@ typedef struct CVodeMemRec {
   N_Vector cv_Xvecs[L_MAX]; /* array of vectors */
 
   booleantype cv_usefused;  /* flag indicating if CVODE specific fused kernels should be used */
+  booleantype cv_usefusedcpu; /* flag indicating if the fused CPU kernels should be used */
 
 } *CVodeMem;
 
@@ -534,6 +585,19 @@ void cvErrHandler(int error_code, const char *module, const char *function,
 
 int cvNlsInit(CVodeMem cv_mem);
 
+/* Automatic Adams / BDF switching: change the method, free the solvers */
+
+int cvNlsSwitch(CVodeMem cv_mem, int lmm);
+void cvNlsFreeSwitching(CVodeMem cv_mem);
+
+/* Free the memory of a root function reporting its changes */
+
+void cvRootChangedFree(CVodeMem cv_mem);
+
+/* Weighted RMS norm, the largest norm of the members of an ensemble */
+
+realtype cvWrmsNorm(CVodeMem cv_mem, N_Vector x, N_Vector w);
+
 /* Projection functions */
 
 int cvDoProjection(CVodeMem cv_mem, int *nflagPtr, realtype saved_t,
@@ -549,6 +613,24 @@ void cvRestore(CVodeMem cv_mem, realtype saved_t);
 
 void cvRescale(CVodeMem cv_mem);
 
+/* Fused CPU kernels for vectors with contiguous host data */
+
+booleantype cvFusedCpuSupported(N_Vector v);
+int cvEwtSetSS_cpu(booleantype atolmin0, realtype reltol, realtype Sabstol,
+                   N_Vector ycur, N_Vector weight);
+int cvEwtSetSV_cpu(booleantype atolmin0, realtype reltol, N_Vector Vabstol,
+                   N_Vector ycur, N_Vector weight);
+realtype cvCheckConstraints_cpu(N_Vector c, N_Vector ewt, N_Vector y,
+                                N_Vector mm, N_Vector tmp);
+void cvNlsResid_cpu(realtype rl1, realtype ngamma, N_Vector zn1,
+                    N_Vector ycor, N_Vector ftemp, N_Vector res);
+void cvPredict_cpu(int q, realtype sign, N_Vector* zn);
+void cvCorrectZn_cpu(int q, realtype* l, N_Vector acor, N_Vector* zn);
+realtype cvUpdateY_cpu(N_Vector zn0, N_Vector acor, N_Vector ewt, N_Vector y);
+void cvOrderNorms_cpu(N_Vector znq, realtype cquot, N_Vector znqmax,
+                      N_Vector acor, N_Vector ewt, realtype* nrmqm1,
+                      realtype* nrmqp1);
+
 /*
  * =================================================================
  *    E R R O R    M E S S A G E S
@@ -591,6 +673,7 @@ void cvRescale(CVodeMem cv_mem);
 #define MSGCV_NEG_MAXORD "maxord <= 0 illegal."
 #define MSGCV_BAD_MAXORD  "Illegal attempt to increase maximum method order."
 #define MSGCV_SET_SLDET  "Attempt to use stability limit detection with the CV_ADAMS method illegal."
+#define MSGCV_SET_SWITCH "Method switching requires a Newton nonlinear solver and a linear solver."
 #define MSGCV_NEG_HMIN "hmin < 0 illegal."
 #define MSGCV_NEG_HMAX "hmax < 0 illegal."
 #define MSGCV_BAD_HMIN_HMAX "Inconsistent step size limits: hmin > hmax."
@@ -602,9 +685,12 @@ void cvRescale(CVodeMem cv_mem);
 #define MSGCV_NULL_F "f = NULL illegal."
 #define MSGCV_NULL_G "g = NULL illegal."
 #define MSGCV_BAD_NVECTOR "A required vector operation is not implemented."
+#define MSGCV_BAD_ENS_LAYOUT "Illegal value for the ensemble layout."
+#define MSGCV_BAD_ENS_SIZE "The system size is not a multiple of the number of ensemble members."
 #define MSGCV_BAD_CONSTR "Illegal values in constraints vector."
 #define MSGCV_BAD_K "Illegal value for k."
 #define MSGCV_NULL_DKY "dky = NULL illegal."
+#define MSGCV_BAD_STATE_BUF "The state buffer is too small or was not saved from a CVODE memory block of this shape."
 #define MSGCV_BAD_T "Illegal value for t." MSG_TIME_INT
 #define MSGCV_NO_ROOT "Rootfinding was not initialized."
 #define MSGCV_NLS_INIT_FAIL "The nonlinear solver's init routine failed."
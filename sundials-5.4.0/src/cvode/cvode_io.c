@@ -157,6 +157,29 @@ int CVodeSetMonitorFrequency(void *cvode_mem, long int nst)
 #endif
 }
 
+/*
+ * CVodeSetProfiler
+ *
+ * Specifies the profiler CVode records its timers into. The
+ * profiler is owned by the user, NULL turns the timers off.
+ */
+
+int CVodeSetProfiler(void *cvode_mem, SUNProfiler profiler)
+{
+  CVodeMem cv_mem;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeSetProfiler", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  cv_mem->cv_profiler = profiler;
+
+  return(CV_SUCCESS);
+}
+
 /*
  * CVodeSetMaxOrd
  *
@@ -474,6 +497,12 @@ int CVodeSetMaxNonlinIters(void *cvode_mem, int maxcor)
     return (CV_MEM_FAIL);
   }
 
+  /* with method switching both solvers use maxcor */
+  if (cv_mem->cv_swon) {
+    (void) SUNNonlinSolSetMaxIters(cv_mem->cv_swNLSfp, maxcor);
+    return(SUNNonlinSolSetMaxIters(cv_mem->cv_swNLSnewton, maxcor));
+  }
+
   return(SUNNonlinSolSetMaxIters(cv_mem->NLS, maxcor));
 }
 
@@ -562,6 +591,66 @@ int CVodeSetRootDirection(void *cvode_mem, int *rootdir)
   return(CV_SUCCESS);
 }
 
+/*
+ * CVodeSetRootChangedFn
+ *
+ * Replaces the root function g given to CVodeRootInit by gchg, which
+ * also reports the components of g that changed since its last call.
+ * Only these components (the active set) are scanned for sign changes,
+ * so the cost of the root search does not grow with nrtfn. A NULL gchg
+ * switches back to g.
+ */
+
+int CVodeSetRootChangedFn(void *cvode_mem, CVRootChangedFn gchg)
+{
+  CVodeMem cv_mem;
+  int i, nrt;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeSetRootChangedFn", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  nrt = cv_mem->cv_nrtfn;
+  if (nrt==0) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetRootChangedFn", MSGCV_NO_ROOT);
+    return(CV_ILL_INPUT);
+  }
+
+  if (gchg == NULL) {
+    cvRootChangedFree(cv_mem);
+    return(CV_SUCCESS);
+  }
+
+  if (cv_mem->cv_gcur == NULL) {
+    cv_mem->cv_gcur   = (realtype *) malloc(nrt*sizeof(realtype));
+    cv_mem->cv_gchg   = (int *) malloc(nrt*sizeof(int));
+    cv_mem->cv_gset   = (int *) malloc(nrt*sizeof(int));
+    cv_mem->cv_ginset = (booleantype *) malloc(nrt*sizeof(booleantype));
+    if (cv_mem->cv_gcur == NULL || cv_mem->cv_gchg == NULL ||
+        cv_mem->cv_gset == NULL || cv_mem->cv_ginset == NULL) {
+      free(cv_mem->cv_gcur);   cv_mem->cv_gcur = NULL;
+      free(cv_mem->cv_gchg);   cv_mem->cv_gchg = NULL;
+      free(cv_mem->cv_gset);   cv_mem->cv_gset = NULL;
+      free(cv_mem->cv_ginset); cv_mem->cv_ginset = NULL;
+      cvProcessError(cv_mem, CV_MEM_FAIL, "CVODE", "CVodeSetRootChangedFn", MSGCV_MEM_FAIL);
+      return(CV_MEM_FAIL);
+    }
+    cv_mem->cv_lrw += nrt;
+    cv_mem->cv_liw += 3*nrt;
+  }
+
+  /* The next call of gchg sets all components */
+  for (i=0; i<nrt; i++) cv_mem->cv_ginset[i] = SUNFALSE;
+  cv_mem->cv_ngset = 0;
+  cv_mem->cv_gfull = SUNTRUE;
+  cv_mem->cv_gchgfun = gchg;
+
+  return(CV_SUCCESS);
+}
+
 /*
  * CVodeSetNoInactiveRootWarn
  *
@@ -665,20 +754,163 @@ int CVodeSetUseIntegratorFusedKernels(void *cvode_mem, booleantype onoff)
 
   cv_mem = (CVodeMem) cvode_mem;
 
+  if (!cv_mem->cv_MallocDone) {
+    cvProcessError(cv_mem, CV_NO_MALLOC, "CVODE", "CVodeSetUseIntegratorFusedKernels", MSGCV_NO_MALLOC);
+    return(CV_NO_MALLOC);
+  }
+
+  /* fused CPU kernels for vectors with contiguous host data */
+  if (cvFusedCpuSupported(cv_mem->cv_ewt)) {
+    cv_mem->cv_usefusedcpu = onoff;
+    return(CV_SUCCESS);
+  }
+
 #ifdef SUNDIALS_BUILD_PACKAGE_FUSED_KERNELS
-  if (!cv_mem->cv_MallocDone ||
-      N_VGetVectorID(cv_mem->cv_ewt) != SUNDIALS_NVEC_CUDA) {
+  if (N_VGetVectorID(cv_mem->cv_ewt) != SUNDIALS_NVEC_CUDA) {
     cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetUseIntegratorFusedKernels", MSGCV_BAD_NVECTOR);
     return(CV_MEM_NULL);
   }
   cv_mem->cv_usefused = onoff;
   return(CV_SUCCESS);
 #else
-  cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetUseIntegratorFusedKernels", "CVODE was not built with fused integrator kernels enabled");
+  cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetUseIntegratorFusedKernels", "CVODE was not built with fused integrator kernels for this vector type");
   return(CV_ILL_INPUT);
 #endif
 }
 
+/*
+ * CVodeSetJacReuseOnReInit
+ *
+ * Specifies if the Jacobian and the linear solver setup (e.g. the LU
+ * factors) of the previous integration are kept by CVodeReInit. The
+ * first step after CVodeReInit then reuses them as any later step
+ * would, i.e. the system matrix is only refactored if gamma changed
+ * too much and the Jacobian is only evaluated again if the nonlinear
+ * solver fails to converge or after msbj steps. Call CVodeInvalidateJac
+ * if the Jacobian is known to have changed.
+ */
+
+int CVodeSetJacReuseOnReInit(void *cvode_mem, booleantype onoff)
+{
+  CVodeMem cv_mem;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeSetJacReuseOnReInit", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  cv_mem->cv_lsetupreuse = onoff;
+
+  return(CV_SUCCESS);
+}
+
+/*
+ * CVodeInvalidateJac
+ *
+ * Marks the Jacobian and the linear solver setup as outdated, the
+ * next step evaluates the Jacobian and calls the linear solver setup.
+ * Can be called before CVodeReInit or between calls to CVode.
+ */
+
+int CVodeInvalidateJac(void *cvode_mem)
+{
+  CVodeMem cv_mem;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeInvalidateJac", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  cv_mem->cv_lsetupok   = SUNFALSE;
+  cv_mem->cv_lsetupkept = SUNFALSE;
+
+  return(CV_SUCCESS);
+}
+
+/*
+ * CVodeSetEnsemble
+ *
+ * Declares the system as an ensemble of nmembers independent systems
+ * of the same size that share the step size, e.g. the runs of a
+ * parameter sweep. The right-hand side is then called once for all
+ * members. The error test, the step size and order selection and the
+ * nonlinear solver convergence test use the largest of the WRMS norms
+ * of the members instead of the norm over the whole system, so each
+ * member is integrated to its own tolerances.
+ *
+ * With CV_ENSEMBLE_BLOCKED component i of member m is entry m*n+i of
+ * the vectors (the layout of SUNMATRIX_BLOCKDIAG), with
+ * CV_ENSEMBLE_INTERLEAVED it is entry i*nmembers+m, so a right-hand
+ * side written as a loop over the members vectorizes. Needs a vector
+ * with contiguous host data; nmembers < 2 switches back to the norm
+ * over the whole system.
+ */
+
+int CVodeSetEnsemble(void *cvode_mem, int nmembers, int layout)
+{
+  CVodeMem cv_mem;
+  sunindextype N;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeSetEnsemble", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  if (!cv_mem->cv_MallocDone) {
+    cvProcessError(cv_mem, CV_NO_MALLOC, "CVODE", "CVodeSetEnsemble", MSGCV_NO_MALLOC);
+    return(CV_NO_MALLOC);
+  }
+
+  if (cv_mem->cv_ens_sums != NULL) {
+    free(cv_mem->cv_ens_sums);
+    cv_mem->cv_ens_sums = NULL;
+    cv_mem->cv_lrw -= cv_mem->cv_ens_nmembers;
+  }
+  cv_mem->cv_ens_nmembers = 0;
+  cv_mem->cv_ens_n        = 0;
+
+  if (nmembers < 2) return(CV_SUCCESS);
+
+  if (layout != CV_ENSEMBLE_BLOCKED && layout != CV_ENSEMBLE_INTERLEAVED) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetEnsemble", MSGCV_BAD_ENS_LAYOUT);
+    return(CV_ILL_INPUT);
+  }
+
+  if ( (N_VGetVectorID(cv_mem->cv_ewt) != SUNDIALS_NVEC_SERIAL) &&
+       (N_VGetVectorID(cv_mem->cv_ewt) != SUNDIALS_NVEC_OPENMP) &&
+       (N_VGetVectorID(cv_mem->cv_ewt) != SUNDIALS_NVEC_PTHREADS) ) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetEnsemble", MSGCV_BAD_NVECTOR);
+    return(CV_ILL_INPUT);
+  }
+
+  N = N_VGetLength(cv_mem->cv_ewt);
+  if (N % nmembers != 0) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetEnsemble", MSGCV_BAD_ENS_SIZE);
+    return(CV_ILL_INPUT);
+  }
+
+  if (layout == CV_ENSEMBLE_INTERLEAVED) {
+    cv_mem->cv_ens_sums = (realtype *) malloc(nmembers*sizeof(realtype));
+    if (cv_mem->cv_ens_sums == NULL) {
+      cvProcessError(cv_mem, CV_MEM_FAIL, "CVODE", "CVodeSetEnsemble", MSGCV_MEM_FAIL);
+      return(CV_MEM_FAIL);
+    }
+    cv_mem->cv_lrw += nmembers;
+  }
+
+  cv_mem->cv_ens_nmembers = nmembers;
+  cv_mem->cv_ens_layout   = layout;
+  cv_mem->cv_ens_n        = N / nmembers;
+
+  return(CV_SUCCESS);
+}
+
 /*
  * =================================================================
  * CVODE optional output functions
@@ -866,6 +1098,50 @@ int CVodeGetNumStabLimOrderReds(void *cvode_mem, long int *nslred)
   return(CV_SUCCESS);
 }
 
+/*
+ * CVodeGetNumMethodSwitches
+ *
+ * Returns the number of switches between the Adams and BDF methods
+ */
+
+int CVodeGetNumMethodSwitches(void *cvode_mem, long int *nswitch)
+{
+  CVodeMem cv_mem;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeGetNumMethodSwitches", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  *nswitch = cv_mem->cv_nsw;
+
+  return(CV_SUCCESS);
+}
+
+/*
+ * CVodeGetCurrentMethod
+ *
+ * Returns the method of the next step, CV_ADAMS or CV_BDF
+ */
+
+int CVodeGetCurrentMethod(void *cvode_mem, int *lmm)
+{
+  CVodeMem cv_mem;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeGetCurrentMethod", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  *lmm = cv_mem->cv_lmm;
+
+  return(CV_SUCCESS);
+}
+
 /*
  * CVodeGetActualInitStep
  *
@@ -1216,6 +1492,28 @@ int CVodeGetNonlinSolvStats(void *cvode_mem, long int *nniters,
   return(CV_SUCCESS);
 }
 
+/*
+ * CVodeGetProfiler
+ *
+ * Returns the profiler attached with CVodeSetProfiler
+ */
+
+int CVodeGetProfiler(void *cvode_mem, SUNProfiler *profiler)
+{
+  CVodeMem cv_mem;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeGetProfiler", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  *profiler = cv_mem->cv_profiler;
+
+  return(CV_SUCCESS);
+}
+
 /*-----------------------------------------------------------------*/
 
 char *CVodeGetReturnFlagName(long int flag)
@@ -23,6 +23,7 @@
 #include "cvode_ls_impl.h"
 #include <sundials/sundials_math.h>
 #include <sunmatrix/sunmatrix_band.h>
+#include <sunmatrix/sunmatrix_blockdiag.h>
 #include <sunmatrix/sunmatrix_dense.h>
 #include <sunmatrix/sunmatrix_sparse.h>
 
@@ -134,6 +135,10 @@ int CVodeSetLinearSolver(void *cvode_mem, SUNLinearSolver LS,
   cv_mem->cv_lsolve = cvLsSolve;
   cv_mem->cv_lfree  = cvLsFree;
 
+  /* A new linear solver has no setup that could be reused */
+  cv_mem->cv_lsetupok   = SUNFALSE;
+  cv_mem->cv_lsetupkept = SUNFALSE;
+
   /* Allocate memory for CVLsMemRec */
   cvls_mem = NULL;
   cvls_mem = (CVLsMem) malloc(sizeof(struct CVLsMemRec));
@@ -382,6 +387,57 @@ int CVodeSetMaxStepsBetweenJac(void *cvode_mem, long int msbj)
 }
 
 
+/* CVodeSetJacSparsityPattern specifies the structure of the Jacobian used
+   by the sparse difference quotient approximation. Only the index arrays
+   of P are used and copied, P may be destroyed after the call. Passing
+   NULL removes the pattern, it will then be taken from the structure of
+   the SUNSparseMatrix when CVode is initialized. */
+int CVodeSetJacSparsityPattern(void *cvode_mem, SUNMatrix P)
+{
+  CVodeMem     cv_mem;
+  CVLsMem      cvls_mem;
+  CVLsSparsity S;
+  int          retval;
+
+  /* access CVLsMem structure */
+  retval = cvLs_AccessLMem(cvode_mem, "CVodeSetJacSparsityPattern",
+                           &cv_mem, &cvls_mem);
+  if (retval != CVLS_SUCCESS)  return(retval);
+
+  if (P == NULL) {
+    cvLsSparsityFree(&(cvls_mem->jpattern));
+    return(CVLS_SUCCESS);
+  }
+
+  /* the pattern has to match a sparse system matrix */
+  if ( (cvls_mem->A == NULL) || (cvls_mem->A->ops->getid == NULL) ||
+       (SUNMatGetID(cvls_mem->A) != SUNMATRIX_SPARSE) ) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVLS", "CVodeSetJacSparsityPattern",
+                   "A sparsity pattern requires a SUNSparseMatrix");
+    return(CVLS_ILL_INPUT);
+  }
+  if ( (P->ops->getid == NULL) || (SUNMatGetID(P) != SUNMATRIX_SPARSE) ||
+       (SUNSparseMatrix_Rows(P) != SUNSparseMatrix_Columns(cvls_mem->A)) ||
+       (SUNSparseMatrix_Columns(P) != SUNSparseMatrix_Columns(cvls_mem->A)) ) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVLS", "CVodeSetJacSparsityPattern",
+                   MSG_LS_BAD_PATTERN);
+    return(CVLS_ILL_INPUT);
+  }
+
+  S = cvLsSparsityCreate(P, SUNSparseMatrix_SparseType(cvls_mem->A));
+  if (S == NULL) {
+    cvProcessError(cv_mem, CVLS_MEM_FAIL, "CVLS", "CVodeSetJacSparsityPattern",
+                   MSG_LS_MEM_FAIL);
+    return(CVLS_MEM_FAIL);
+  }
+
+  cvLsSparsityFree(&(cvls_mem->jpattern));
+  cvls_mem->jpattern = S;
+
+  return(CVLS_SUCCESS);
+}
+
+
 /* CVodeSetLinearSolutionScaling enables or disables scaling the
    linear solver solution to account for changes in gamma. */
 int CVodeSetLinearSolutionScaling(void *cvode_mem, booleantype onoff)
@@ -939,7 +995,7 @@ int cvLsPSolve(void *cvode_mem, N_Vector r, N_Vector z, realtype tol, int lr)
 /*-----------------------------------------------------------------
   cvLsDQJac
 
-  This routine is a wrapper for the Dense and Band
+  This routine is a wrapper for the Dense, Band and Sparse
   implementations of the difference quotient Jacobian
   approximation routines.
   ---------------------------------------------------------------*/
@@ -983,6 +1039,10 @@ int cvLsDQJac(realtype t, N_Vector y, N_Vector fy,
     retval = cvLsDenseDQJac(t, y, fy, Jac, cv_mem, tmp1);
   } else if (SUNMatGetID(Jac) == SUNMATRIX_BAND) {
     retval = cvLsBandDQJac(t, y, fy, Jac, cv_mem, tmp1, tmp2);
+  } else if (SUNMatGetID(Jac) == SUNMATRIX_SPARSE) {
+    retval = cvLsSparseDQJac(t, y, fy, Jac, cv_mem, tmp1, tmp2);
+  } else if (SUNMatGetID(Jac) == SUNMATRIX_BLOCKDIAG) {
+    retval = cvLsBlockDiagDQJac(t, y, fy, Jac, cv_mem, tmp1, tmp2);
   } else {
     cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVLS", "cvLsDQJac",
                    "unrecognized matrix type for cvLsDQJac");
@@ -1184,6 +1244,374 @@ int cvLsBandDQJac(realtype t, N_Vector y, N_Vector fy, SUNMatrix Jac,
 }
 
 
+/*-----------------------------------------------------------------
+  cvLsBlockDiagDQJac
+
+  This routine generates a block-diagonal difference quotient
+  approximation to the Jacobian of f(t,y). Since the blocks do not
+  couple, column j of all blocks is computed with one evaluation of
+  f, so bs evaluations give the whole matrix.
+  -----------------------------------------------------------------*/
+int cvLsBlockDiagDQJac(realtype t, N_Vector y, N_Vector fy, SUNMatrix Jac,
+                       CVodeMem cv_mem, N_Vector tmp1, N_Vector tmp2)
+{
+  N_Vector ftemp, ytemp;
+  realtype fnorm, minInc, inc, inc_inv, srur, conj;
+  realtype *col_j, *ewt_data, *fy_data, *ftemp_data;
+  realtype *y_data, *ytemp_data, *cns_data;
+  sunindextype b, i, j, k, N, nblocks, bs;
+  CVLsMem cvls_mem;
+  int retval = 0;
+
+  /* initialize cns_data to avoid compiler warning */
+  cns_data = NULL;
+
+  /* access LsMem interface structure */
+  cvls_mem = (CVLsMem) cv_mem->cv_lmem;
+
+  /* access matrix dimensions */
+  N       = SUNBlockDiagMatrix_Columns(Jac);
+  nblocks = SUNBlockDiagMatrix_NumBlocks(Jac);
+  bs      = SUNBlockDiagMatrix_BlockSize(Jac);
+
+  /* Rename work vectors for use as temporary values of y and f */
+  ftemp = tmp1;
+  ytemp = tmp2;
+
+  /* Obtain pointers to the data for ewt, fy, ftemp, y, ytemp */
+  ewt_data   = N_VGetArrayPointer(cv_mem->cv_ewt);
+  fy_data    = N_VGetArrayPointer(fy);
+  ftemp_data = N_VGetArrayPointer(ftemp);
+  y_data     = N_VGetArrayPointer(y);
+  ytemp_data = N_VGetArrayPointer(ytemp);
+  if (cv_mem->cv_constraintsSet)
+    cns_data = N_VGetArrayPointer(cv_mem->cv_constraints);
+
+  /* Load ytemp with y = predicted y vector */
+  N_VScale(ONE, y, ytemp);
+
+  /* Set minimum increment based on uround and norm of f */
+  srur = SUNRsqrt(cv_mem->cv_uround);
+  fnorm = N_VWrmsNorm(fy, cv_mem->cv_ewt);
+  minInc = (fnorm != ZERO) ?
+    (MIN_INC_MULT * SUNRabs(cv_mem->cv_h) * cv_mem->cv_uround * N * fnorm) : ONE;
+
+  /* Loop over the columns of a block */
+  for (j=0; j < bs; j++) {
+
+    /* Increment y_k of column j in all blocks */
+    for (k=j; k < N; k+=bs) {
+      inc = SUNMAX(srur*SUNRabs(y_data[k]), minInc/ewt_data[k]);
+
+      /* Adjust sign(inc) if yk has an inequality constraint. */
+      if (cv_mem->cv_constraintsSet) {
+        conj = cns_data[k];
+        if (SUNRabs(conj) == ONE)      {if ((ytemp_data[k]+inc)*conj < ZERO)  inc = -inc;}
+        else if (SUNRabs(conj) == TWO) {if ((ytemp_data[k]+inc)*conj <= ZERO) inc = -inc;}
+      }
+
+      ytemp_data[k] += inc;
+    }
+
+    /* Evaluate f with incremented y */
+    retval = cv_mem->cv_f(cv_mem->cv_tn, ytemp, ftemp, cv_mem->cv_user_data);
+    cvls_mem->nfeDQ++;
+    if (retval != 0) break;
+
+    /* Restore ytemp, then form and load difference quotients */
+    for (b=0; b < nblocks; b++) {
+      k = b*bs + j;
+      ytemp_data[k] = y_data[k];
+      col_j = SUNBlockDiagMatrix_Block(Jac, b) + j*bs;
+      inc = SUNMAX(srur*SUNRabs(y_data[k]), minInc/ewt_data[k]);
+
+      /* Adjust sign(inc) as before. */
+      if (cv_mem->cv_constraintsSet) {
+        conj = cns_data[k];
+        if (SUNRabs(conj) == ONE)      {if ((ytemp_data[k]+inc)*conj < ZERO)  inc = -inc;}
+        else if (SUNRabs(conj) == TWO) {if ((ytemp_data[k]+inc)*conj <= ZERO) inc = -inc;}
+      }
+
+      inc_inv = ONE/inc;
+      for (i=0; i < bs; i++)
+        col_j[i] = inc_inv * (ftemp_data[b*bs+i] - fy_data[b*bs+i]);
+    }
+  }
+
+  return(retval);
+}
+
+
+/*-----------------------------------------------------------------
+  cvLsSparseDQJac
+
+  This routine generates a sparse difference quotient approximation
+  to the Jacobian of f(t,y), using the sparsity pattern and column
+  coloring in cvls_mem->jpattern. The structure of the CSC or CSR
+  SUNMatrix is set to the pattern, then all columns of one color
+  are incremented together, requiring one call to f per color
+  instead of one per column. Each entry of the pattern is written
+  once, at its index in the data array of Jac.
+  -----------------------------------------------------------------*/
+int cvLsSparseDQJac(realtype t, N_Vector y, N_Vector fy,
+                    SUNMatrix Jac, CVodeMem cv_mem, N_Vector tmp1,
+                    N_Vector tmp2)
+{
+  N_Vector ftemp, ytemp;
+  realtype fnorm, minInc, inc, inc_inv, srur, conj;
+  realtype *jac_data, *ewt_data, *fy_data, *ftemp_data;
+  realtype *y_data, *ytemp_data, *cns_data;
+  sunindextype c, i, j, k, p, N;
+  sunindextype *colptrs, *rowvals, *jacpos, *ptrs, *vals;
+  CVLsMem cvls_mem;
+  CVLsSparsity S;
+  int retval = 0;
+
+  /* initialize cns_data to avoid compiler warning */
+  cns_data = NULL;
+
+  /* access LsMem interface structure and the sparsity pattern */
+  cvls_mem = (CVLsMem) cv_mem->cv_lmem;
+  S = cvls_mem->jpattern;
+
+  /* access matrix dimension */
+  N = SUNSparseMatrix_Columns(Jac);
+
+  if ( (S == NULL) || (S->N != N) || (SUNSparseMatrix_Rows(Jac) != N) ||
+       (S->jactype != SUNSparseMatrix_SparseType(Jac)) ) {
+    cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVLS", "cvLsSparseDQJac",
+                   MSG_LS_NO_PATTERN);
+    return(CVLS_ILL_INPUT);
+  }
+
+  /* Set the structure of Jac to the pattern */
+  if (SUNSparseMatrix_NNZ(Jac) < S->nnz) {
+    if (SUNSparseMatrix_Reallocate(Jac, S->nnz) != 0) {
+      cvProcessError(cv_mem, CVLS_MEM_FAIL, "CVLS", "cvLsSparseDQJac",
+                     MSG_LS_MEM_FAIL);
+      return(CVLS_MEM_FAIL);
+    }
+  }
+  ptrs = (S->jactype == CSC_MAT) ? S->colptrs : S->rowptrs;
+  vals = (S->jactype == CSC_MAT) ? S->rowvals : S->colvals;
+  memcpy(SUNSparseMatrix_IndexPointers(Jac), ptrs, (N+1)*sizeof(sunindextype));
+  memcpy(SUNSparseMatrix_IndexValues(Jac), vals, S->nnz*sizeof(sunindextype));
+
+  colptrs  = S->colptrs;
+  rowvals  = S->rowvals;
+  jacpos   = S->jacpos;
+  jac_data = SUNSparseMatrix_Data(Jac);
+
+  /* Rename work vectors for use as temporary values of y and f */
+  ftemp = tmp1;
+  ytemp = tmp2;
+
+  /* Obtain pointers to the data for ewt, fy, ftemp, y, ytemp */
+  ewt_data   = N_VGetArrayPointer(cv_mem->cv_ewt);
+  fy_data    = N_VGetArrayPointer(fy);
+  ftemp_data = N_VGetArrayPointer(ftemp);
+  y_data     = N_VGetArrayPointer(y);
+  ytemp_data = N_VGetArrayPointer(ytemp);
+  if (cv_mem->cv_constraintsSet)
+    cns_data = N_VGetArrayPointer(cv_mem->cv_constraints);
+
+  /* Load ytemp with y = predicted y vector */
+  N_VScale(ONE, y, ytemp);
+
+  /* Set minimum increment based on uround and norm of f */
+  srur = SUNRsqrt(cv_mem->cv_uround);
+  fnorm = N_VWrmsNorm(fy, cv_mem->cv_ewt);
+  minInc = (fnorm != ZERO) ?
+    (MIN_INC_MULT * SUNRabs(cv_mem->cv_h) * cv_mem->cv_uround * N * fnorm) : ONE;
+
+  /* Loop over column colors. */
+  for (c = 0; c < S->ncolors; c++) {
+
+    /* Increment all y_j of the color */
+    for (p = S->colorptrs[c]; p < S->colorptrs[c+1]; p++) {
+      j = S->colorcols[p];
+      inc = SUNMAX(srur*SUNRabs(y_data[j]), minInc/ewt_data[j]);
+
+      /* Adjust sign(inc) if yj has an inequality constraint. */
+      if (cv_mem->cv_constraintsSet) {
+        conj = cns_data[j];
+        if (SUNRabs(conj) == ONE)      {if ((ytemp_data[j]+inc)*conj < ZERO)  inc = -inc;}
+        else if (SUNRabs(conj) == TWO) {if ((ytemp_data[j]+inc)*conj <= ZERO) inc = -inc;}
+      }
+
+      ytemp_data[j] += inc;
+    }
+
+    /* Evaluate f with incremented y */
+    retval = cv_mem->cv_f(t, ytemp, ftemp, cv_mem->cv_user_data);
+    cvls_mem->nfeDQ++;
+    if (retval != 0) break;
+
+    /* Restore ytemp, then form and load difference quotients */
+    for (p = S->colorptrs[c]; p < S->colorptrs[c+1]; p++) {
+      j = S->colorcols[p];
+      ytemp_data[j] = y_data[j];
+      inc = SUNMAX(srur*SUNRabs(y_data[j]), minInc/ewt_data[j]);
+
+      /* Adjust sign(inc) as before. */
+      if (cv_mem->cv_constraintsSet) {
+        conj = cns_data[j];
+        if (SUNRabs(conj) == ONE)      {if ((ytemp_data[j]+inc)*conj < ZERO)  inc = -inc;}
+        else if (SUNRabs(conj) == TWO) {if ((ytemp_data[j]+inc)*conj <= ZERO) inc = -inc;}
+      }
+
+      inc_inv = ONE/inc;
+      if (jacpos == NULL) {
+        for (k = colptrs[j]; k < colptrs[j+1]; k++) {
+          i = rowvals[k];
+          jac_data[k] = inc_inv * (ftemp_data[i] - fy_data[i]);
+        }
+      } else {
+        for (k = colptrs[j]; k < colptrs[j+1]; k++) {
+          i = rowvals[k];
+          jac_data[jacpos[k]] = inc_inv * (ftemp_data[i] - fy_data[i]);
+        }
+      }
+    }
+  }
+
+  return(retval);
+}
+
+
+/*-----------------------------------------------------------------
+  cvLsSparsityCreate
+
+  This routine copies the structure of the square sparse matrix P
+  into a new CVLsSparsity object, in CSC and CSR form, and colors
+  the columns greedily in their natural order: column j gets the
+  smallest color not used by an earlier column that has a row in
+  common with j. For banded structures this gives the same groups
+  as the band DQ Jacobian. jactype is the layout of the matrices
+  the pattern will be loaded into. Returns NULL if a memory
+  request failed.
+  -----------------------------------------------------------------*/
+CVLsSparsity cvLsSparsityCreate(SUNMatrix P, int jactype)
+{
+  CVLsSparsity S;
+  sunindextype i, j, k, p, c, N, nnz;
+  sunindextype *ptrs, *vals, *next, *mark, *color;
+
+  N    = SUNSparseMatrix_Columns(P);
+  ptrs = SUNSparseMatrix_IndexPointers(P);
+  vals = SUNSparseMatrix_IndexValues(P);
+  nnz  = ptrs[N];
+
+  S = (CVLsSparsity) malloc(sizeof(struct CVLsSparsityRec));
+  if (S == NULL) return(NULL);
+  memset(S, 0, sizeof(struct CVLsSparsityRec));
+
+  S->N       = N;
+  S->nnz     = nnz;
+  S->jactype = jactype;
+
+  S->colptrs   = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  S->rowvals   = (sunindextype*) malloc(SUNMAX(nnz,1)*sizeof(sunindextype));
+  S->rowptrs   = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  S->colvals   = (sunindextype*) malloc(SUNMAX(nnz,1)*sizeof(sunindextype));
+  S->colorptrs = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  S->colorcols = (sunindextype*) malloc(SUNMAX(N,1)*sizeof(sunindextype));
+  if (jactype == CSR_MAT)
+    S->jacpos  = (sunindextype*) malloc(SUNMAX(nnz,1)*sizeof(sunindextype));
+  next  = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  mark  = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  color = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+
+  if ( (S->colptrs == NULL) || (S->rowvals == NULL) || (S->rowptrs == NULL) ||
+       (S->colvals == NULL) || (S->colorptrs == NULL) || (S->colorcols == NULL) ||
+       ((jactype == CSR_MAT) && (S->jacpos == NULL)) ||
+       (next == NULL) || (mark == NULL) || (color == NULL) ) {
+    free(next); free(mark); free(color);
+    cvLsSparsityFree(&S);
+    return(NULL);
+  }
+
+  /* CSC pattern: copy, or transpose a CSR matrix by counting sort */
+  if (SUNSparseMatrix_SparseType(P) == CSC_MAT) {
+    memcpy(S->colptrs, ptrs, (N+1)*sizeof(sunindextype));
+    memcpy(S->rowvals, vals, nnz*sizeof(sunindextype));
+  } else {
+    for (j = 0; j <= N; j++) S->colptrs[j] = 0;
+    for (k = 0; k < nnz; k++) S->colptrs[vals[k]+1]++;
+    for (j = 0; j < N; j++) S->colptrs[j+1] += S->colptrs[j];
+    for (j = 0; j < N; j++) next[j] = S->colptrs[j];
+    for (i = 0; i < N; i++)
+      for (k = ptrs[i]; k < ptrs[i+1]; k++)
+        S->rowvals[next[vals[k]]++] = i;
+  }
+
+  /* CSR pattern from the CSC pattern, jacpos maps CSC to CSR entries */
+  for (i = 0; i <= N; i++) S->rowptrs[i] = 0;
+  for (k = 0; k < nnz; k++) S->rowptrs[S->rowvals[k]+1]++;
+  for (i = 0; i < N; i++) S->rowptrs[i+1] += S->rowptrs[i];
+  for (i = 0; i < N; i++) next[i] = S->rowptrs[i];
+  for (j = 0; j < N; j++) {
+    for (k = S->colptrs[j]; k < S->colptrs[j+1]; k++) {
+      p = next[S->rowvals[k]]++;
+      S->colvals[p] = j;
+      if (S->jacpos) S->jacpos[k] = p;
+    }
+  }
+
+  /* Greedy coloring, mark[c] == j if color c is taken by a neighbor of j */
+  for (j = 0; j < N; j++) {
+    mark[j]  = -1;
+    color[j] = -1;
+  }
+  S->ncolors = 0;
+  for (j = 0; j < N; j++) {
+    for (k = S->colptrs[j]; k < S->colptrs[j+1]; k++) {
+      i = S->rowvals[k];
+      for (p = S->rowptrs[i]; p < S->rowptrs[i+1]; p++) {
+        c = color[S->colvals[p]];
+        if (c >= 0) mark[c] = j;
+      }
+    }
+    for (c = 0; mark[c] == j; c++) ;
+    color[j] = c;
+    if (c >= S->ncolors) S->ncolors = c+1;
+  }
+
+  /* Sort the columns by color */
+  for (c = 0; c <= S->ncolors; c++) S->colorptrs[c] = 0;
+  for (j = 0; j < N; j++) S->colorptrs[color[j]+1]++;
+  for (c = 0; c < S->ncolors; c++) S->colorptrs[c+1] += S->colorptrs[c];
+  for (c = 0; c < S->ncolors; c++) next[c] = S->colorptrs[c];
+  for (j = 0; j < N; j++) S->colorcols[next[color[j]]++] = j;
+
+  free(next);
+  free(mark);
+  free(color);
+
+  return(S);
+}
+
+
+/*-----------------------------------------------------------------
+  cvLsSparsityFree
+
+  This routine frees a CVLsSparsity object and sets it to NULL.
+  -----------------------------------------------------------------*/
+void cvLsSparsityFree(CVLsSparsity *S)
+{
+  if (S == NULL || *S == NULL) return;
+  free((*S)->colptrs);
+  free((*S)->rowvals);
+  free((*S)->rowptrs);
+  free((*S)->colvals);
+  free((*S)->jacpos);
+  free((*S)->colorptrs);
+  free((*S)->colorcols);
+  free(*S);
+  *S = NULL;
+}
+
+
 /*-----------------------------------------------------------------
   cvLsDQJtimes
 
@@ -1347,6 +1775,18 @@ int cvLsInitialize(CVodeMem cv_mem)
 
     /* Matrix-based case */
 
+    /* The blocks of SUNMATRIX_BLOCKDIAG act on contiguous entries, they
+       cannot hold the members of an interleaved ensemble */
+    if ( (cv_mem->cv_ens_nmembers > 1) &&
+         (cv_mem->cv_ens_layout == CV_ENSEMBLE_INTERLEAVED) &&
+         (cvls_mem->A->ops->getid != NULL) &&
+         (SUNMatGetID(cvls_mem->A) == SUNMATRIX_BLOCKDIAG) ) {
+      cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVLS", "cvLsInitialize",
+                     MSG_LS_BAD_ENSEMBLE);
+      cvls_mem->last_flag = CVLS_ILL_INPUT;
+      return(CVLS_ILL_INPUT);
+    }
+
     if (cvls_mem->user_linsys) {
 
       /* User-supplied linear system function, reset A_data (just in case) */
@@ -1361,15 +1801,38 @@ int cvLsInitialize(CVodeMem cv_mem)
       /* Check if an internal or user-supplied Jacobian function is used */
       if (cvls_mem->jacDQ) {
 
-        /* Internal difference quotient Jacobian. Check that A is dense or band,
-           otherwise return an error */
+        /* Internal difference quotient Jacobian. Check that A is dense, band,
+           block-diagonal or sparse, otherwise return an error */
         retval = 0;
         if (cvls_mem->A->ops->getid) {
 
           if ( (SUNMatGetID(cvls_mem->A) == SUNMATRIX_DENSE) ||
-               (SUNMatGetID(cvls_mem->A) == SUNMATRIX_BAND) ) {
+               (SUNMatGetID(cvls_mem->A) == SUNMATRIX_BAND) ||
+               (SUNMatGetID(cvls_mem->A) == SUNMATRIX_BLOCKDIAG) ) {
             cvls_mem->jac    = cvLsDQJac;
             cvls_mem->J_data = cv_mem;
+          } else if (SUNMatGetID(cvls_mem->A) == SUNMATRIX_SPARSE) {
+            cvls_mem->jac    = cvLsDQJac;
+            cvls_mem->J_data = cv_mem;
+
+            /* Take the sparsity pattern from the structure of A, unless it
+               was set with CVodeSetJacSparsityPattern */
+            if (cvls_mem->jpattern == NULL) {
+              if (SUNSparseMatrix_IndexPointers(cvls_mem->A)[SUNSparseMatrix_NP(cvls_mem->A)] == 0) {
+                cvProcessError(cv_mem, CVLS_ILL_INPUT, "CVLS", "cvLsInitialize",
+                               MSG_LS_NO_PATTERN);
+                cvls_mem->last_flag = CVLS_ILL_INPUT;
+                return(CVLS_ILL_INPUT);
+              }
+              cvls_mem->jpattern =
+                cvLsSparsityCreate(cvls_mem->A, SUNSparseMatrix_SparseType(cvls_mem->A));
+              if (cvls_mem->jpattern == NULL) {
+                cvProcessError(cv_mem, CVLS_MEM_FAIL, "CVLS", "cvLsInitialize",
+                               MSG_LS_MEM_FAIL);
+                cvls_mem->last_flag = CVLS_MEM_FAIL;
+                return(CVLS_MEM_FAIL);
+              }
+            }
           } else {
             retval++;
           }
@@ -1434,7 +1897,12 @@ int cvLsInitialize(CVodeMem cv_mem)
   if ( (cvls_mem->A == NULL) && (cvls_mem->pset == NULL) )
     cv_mem->cv_lsetup = NULL;
 
-  /* Call LS initialize routine, and return result */
+  /* Call LS initialize routine, and return result. The LS is not
+     initialized again if its setup is kept across CVodeReInit. */
+  if (cv_mem->cv_lsetupkept) {
+    cvls_mem->last_flag = CVLS_SUCCESS;
+    return(cvls_mem->last_flag);
+  }
   cvls_mem->last_flag = SUNLinSolInitialize(cvls_mem->LS);
   return(cvls_mem->last_flag);
 }
@@ -1476,7 +1944,8 @@ int cvLsSetup(CVodeMem cv_mem, int convfail, N_Vector ypred,
 
   /* Use nst, gamma/gammap, and convfail to set J/P eval. flag jok */
   dgamma = SUNRabs((cv_mem->cv_gamma/cv_mem->cv_gammap) - ONE);
-  cvls_mem->jbad = (cv_mem->cv_nst == 0) ||
+  cvls_mem->jbad = ((cv_mem->cv_nst == 0) && !cv_mem->cv_lsetupkept) ||
+    !cv_mem->cv_lsetupok ||
     (cv_mem->cv_nst >= cvls_mem->nstlj + cvls_mem->msbj) ||
     ((convfail == CV_FAIL_BAD_J) && (dgamma < CVLS_DGMAX)) ||
     (convfail == CV_FAIL_OTHER);
@@ -1737,6 +2206,9 @@ int cvLsFree(CVodeMem cv_mem)
     cvls_mem->savedJ = NULL;
   }
 
+  /* Free sparsity pattern of the DQ Jacobian */
+  cvLsSparsityFree(&(cvls_mem->jpattern));
+
   /* Nullify other N_Vector pointers */
   cvls_mem->ycur = NULL;
   cvls_mem->fcur = NULL;
@@ -42,6 +42,36 @@ extern "C" {
 #define CVLS_EPLIN  RCONST(0.05)
 
 
+/*-----------------------------------------------------------------
+  Types : CVLsSparsityRec, CVLsSparsity
+
+  Sparsity pattern of the Jacobian used by the sparse difference
+  quotient approximation. The pattern is stored column-wise (CSC)
+  and row-wise (CSR) together with a column coloring: two columns
+  have the same color only if they have no row in common, so all
+  columns of a color are perturbed with a single call to f.
+  -----------------------------------------------------------------*/
+typedef struct CVLsSparsityRec {
+
+  sunindextype N;      /* number of rows and columns                   */
+  sunindextype nnz;    /* number of structural nonzeros                */
+  int jactype;         /* CSC_MAT or CSR_MAT, layout of the Jacobian   */
+
+  sunindextype *colptrs;  /* CSC pattern, size N+1                     */
+  sunindextype *rowvals;  /* CSC pattern, size nnz                     */
+  sunindextype *rowptrs;  /* CSR pattern, size N+1                     */
+  sunindextype *colvals;  /* CSR pattern, size nnz                     */
+  sunindextype *jacpos;   /* index in the CSR data of each CSC entry,
+                             NULL if the Jacobian is CSC               */
+
+  sunindextype ncolors;   /* number of column colors                   */
+  sunindextype *colorptrs; /* columns of color c are colorcols[k] for
+                              colorptrs[c] <= k < colorptrs[c+1]       */
+  sunindextype *colorcols; /* columns sorted by color, size N          */
+
+} *CVLsSparsity;
+
+
 /*-----------------------------------------------------------------
   Types : CVLsMemRec, CVLsMem
 
@@ -58,6 +88,8 @@ typedef struct CVLsMemRec {
   CVLsJacFn jac;      /* Jacobian routine to be called                */
   void *J_data;       /* user data is passed to jac                   */
   booleantype jbad;   /* heuristic suggestion for pset                */
+  CVLsSparsity jpattern; /* Jacobian sparsity and coloring used by the
+                            sparse DQ Jac approx.                     */
 
   /* Matrix-based solver, scale solution to account for change in gamma */
   booleantype scalesol;
@@ -151,6 +183,16 @@ int cvLsDenseDQJac(realtype t, N_Vector y, N_Vector fy,
 int cvLsBandDQJac(realtype t, N_Vector y, N_Vector fy,
                   SUNMatrix Jac, CVodeMem cv_mem, N_Vector tmp1,
                   N_Vector tmp2);
+int cvLsSparseDQJac(realtype t, N_Vector y, N_Vector fy,
+                    SUNMatrix Jac, CVodeMem cv_mem, N_Vector tmp1,
+                    N_Vector tmp2);
+int cvLsBlockDiagDQJac(realtype t, N_Vector y, N_Vector fy,
+                       SUNMatrix Jac, CVodeMem cv_mem, N_Vector tmp1,
+                       N_Vector tmp2);
+
+/* Sparsity pattern and column coloring for cvLsSparseDQJac */
+CVLsSparsity cvLsSparsityCreate(SUNMatrix P, int jactype);
+void cvLsSparsityFree(CVLsSparsity *S);
 
 /* Generic linit/lsetup/lsolve/lfree interface routines for CVode to call */
 int cvLsInitialize(CVodeMem cv_mem);
@@ -178,6 +220,9 @@ int cvLs_AccessLMem(void* cvode_mem, const char* fname,
 #define MSG_LS_LMEM_NULL      "Linear solver memory is NULL."
 #define MSG_LS_BAD_SIZES      "Illegal bandwidth parameter(s). Must have 0 <=  ml, mu <= N-1."
 #define MSG_LS_BAD_EPLIN      "eplifac < 0 illegal."
+#define MSG_LS_BAD_PATTERN    "The sparsity pattern must be a square SUNSparseMatrix with the size of the linear system."
+#define MSG_LS_NO_PATTERN     "The sparse difference quotient Jacobian requires a sparsity pattern, either in the structure of the SUNSparseMatrix or from CVodeSetJacSparsityPattern."
+#define MSG_LS_BAD_ENSEMBLE   "SUNMATRIX_BLOCKDIAG needs the blocked ensemble layout."
 
 #define MSG_LS_PSET_FAILED    "The preconditioner setup routine failed in an unrecoverable manner."
 #define MSG_LS_PSOLVE_FAILED  "The preconditioner solve routine failed in an unrecoverable manner."
@@ -16,9 +16,11 @@
 
 #include "cvode_impl.h"
 #include "sundials/sundials_math.h"
+#include "sunnonlinsol/sunnonlinsol_fixedpoint.h"
 
 /* constant macros */
-#define ONE RCONST(1.0) /* real 1.0 */
+#define ZERO RCONST(0.0) /* real 0.0 */
+#define ONE  RCONST(1.0) /* real 1.0 */
 
 /* nonlinear solver constants
      NLS_MAXCOR  maximum no. of corrector iterations for the nonlinear solver
@@ -39,6 +41,9 @@ static int cvNlsLSolve(N_Vector delta, void* cvode_mem);
 static int cvNlsConvTest(SUNNonlinearSolver NLS, N_Vector ycor, N_Vector del,
                          realtype tol, N_Vector ewt, void* cvode_mem);
 
+static int cvNlsSetFunctions(CVodeMem cv_mem, SUNNonlinearSolver NLS,
+                             const char *fname);
+
 #ifdef SUNDIALS_BUILD_PACKAGE_FUSED_KERNELS
 int cvNlsResid_fused(const realtype rl1,
                      const realtype ngamma,
@@ -80,6 +85,9 @@ int CVodeSetNonlinearSolver(void *cvode_mem, SUNNonlinearSolver NLS)
     return(CV_ILL_INPUT);
   }
 
+  /* automatic method switching is turned off with a new solver */
+  if (cv_mem->cv_swon) cvNlsFreeSwitching(cv_mem);
+
   /* free any existing nonlinear solver */
   if ((cv_mem->NLS != NULL) && (cv_mem->ownNLS))
     retval = SUNNonlinSolFree(cv_mem->NLS);
@@ -91,38 +99,9 @@ int CVodeSetNonlinearSolver(void *cvode_mem, SUNNonlinearSolver NLS)
      NLS, CVODE will set the flag to SUNTRUE after this function returns. */
   cv_mem->ownNLS = SUNFALSE;
 
-  /* set the nonlinear system function */
-  if (SUNNonlinSolGetType(NLS) == SUNNONLINEARSOLVER_ROOTFIND) {
-    retval = SUNNonlinSolSetSysFn(cv_mem->NLS, cvNlsResidual);
-  } else if (SUNNonlinSolGetType(NLS) ==  SUNNONLINEARSOLVER_FIXEDPOINT) {
-    retval = SUNNonlinSolSetSysFn(cv_mem->NLS, cvNlsFPFunction);
-  } else {
-    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetNonlinearSolver",
-                   "Invalid nonlinear solver type");
-    return(CV_ILL_INPUT);
-  }
-
-  if (retval != CV_SUCCESS) {
-    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetNonlinearSolver",
-                   "Setting nonlinear system function failed");
-    return(CV_ILL_INPUT);
-  }
-
-  /* set convergence test function */
-  retval = SUNNonlinSolSetConvTestFn(cv_mem->NLS, cvNlsConvTest, cvode_mem);
-  if (retval != CV_SUCCESS) {
-    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetNonlinearSolver",
-                   "Setting convergence test function failed");
-    return(CV_ILL_INPUT);
-  }
-
-  /* set max allowed nonlinear iterations */
-  retval = SUNNonlinSolSetMaxIters(cv_mem->NLS, NLS_MAXCOR);
-  if (retval != CV_SUCCESS) {
-    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetNonlinearSolver",
-                   "Setting maximum number of nonlinear iterations failed");
-    return(CV_ILL_INPUT);
-  }
+  /* set the nonlinear system function, convergence test and max iterations */
+  retval = cvNlsSetFunctions(cv_mem, NLS, "CVodeSetNonlinearSolver");
+  if (retval != CV_SUCCESS) return(retval);
 
   /* Reset the acnrmcur flag to SUNFALSE */
   cv_mem->cv_acnrmcur = SUNFALSE;
@@ -165,10 +144,150 @@ int CVodeGetNonlinearSystemData(void *cvode_mem, realtype *tcur,
 }
 
 
+/*---------------------------------------------------------------
+  CVodeSetMethodSwitching:
+
+  Turns on/off the automatic switching between the Adams method
+  with fixed point iteration and the BDF method with Newton
+  iteration. The method given to CVodeCreate is used first, after
+  every step CVODE compares the step size the other method would
+  allow and switches if it is clearly larger, as LSODA does.
+
+  Adams steps use a fixed point solver created here and do no linear
+  solves. Their step size is kept within the stability bound given
+  by an estimate of the Lipschitz constant of f from the rate of the
+  fixed point iteration. The switch to BDF is made when the Adams
+  steps stay at that bound, when the stability limit detection finds
+  them limited by stability, or when BDF would allow a much larger
+  step. In
+  BDF phases that estimate is renewed every few steps with one more
+  evaluation of f, and CVODE returns to Adams when the stability and
+  accuracy limited Adams step is not smaller than the BDF step.
+
+  Must be called after CVodeInit and CVodeSetLinearSolver with the
+  Newton solver attached. The Adams order is limited by the maxord
+  of CVodeCreate (12 with CV_ADAMS, 5 with CV_BDF) and CVodeSetMaxOrd,
+  the BDF order by 5. Attaching another nonlinear solver turns the
+  switching off.
+  ---------------------------------------------------------------*/
+int CVodeSetMethodSwitching(void *cvode_mem, booleantype onoff)
+{
+  CVodeMem cv_mem;
+  int retval;
+
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODE", "CVodeSetMethodSwitching", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  if (!onoff) {
+    if (!cv_mem->cv_swon) return(CV_SUCCESS);
+    cvNlsFreeSwitching(cv_mem);
+    if (cv_mem->cv_nst > 0) return(cvNlsInit(cv_mem));
+    return(CV_SUCCESS);
+  }
+  if (cv_mem->cv_swon) return(CV_SUCCESS);
+
+  if (cv_mem->cv_MallocDone == SUNFALSE) {
+    cvProcessError(cv_mem, CV_NO_MALLOC, "CVODE", "CVodeSetMethodSwitching", MSGCV_NO_MALLOC);
+    return(CV_NO_MALLOC);
+  }
+
+  if ( (cv_mem->NLS == NULL) || (cv_mem->cv_lsolve == NULL) ||
+       (SUNNonlinSolGetType(cv_mem->NLS) != SUNNONLINEARSOLVER_ROOTFIND) ) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", "CVodeSetMethodSwitching", MSGCV_SET_SWITCH);
+    return(CV_ILL_INPUT);
+  }
+
+  cv_mem->cv_swNLSfp = SUNNonlinSol_FixedPoint(cv_mem->cv_acor, 0);
+  cv_mem->cv_swfpred = N_VClone(cv_mem->cv_acor);
+  if ((cv_mem->cv_swNLSfp == NULL) || (cv_mem->cv_swfpred == NULL)) {
+    cvNlsFreeSwitching(cv_mem);
+    cvProcessError(cv_mem, CV_MEM_FAIL, "CVODE", "CVodeSetMethodSwitching", MSGCV_MEM_FAIL);
+    return(CV_MEM_FAIL);
+  }
+
+  retval = cvNlsSetFunctions(cv_mem, cv_mem->cv_swNLSfp, "CVodeSetMethodSwitching");
+  if (retval != CV_SUCCESS) {
+    cvNlsFreeSwitching(cv_mem);
+    return(retval);
+  }
+
+  cv_mem->cv_swon         = SUNTRUE;
+  cv_mem->cv_swNLSnewton  = cv_mem->NLS;
+  cv_mem->cv_swqadams     = SUNMIN(cv_mem->cv_qmax, ADAMS_Q_MAX);
+  cv_mem->cv_swqbdf       = SUNMIN(cv_mem->cv_qmax, BDF_Q_MAX);
+  cv_mem->cv_swgrab       = SUNFALSE;
+  cv_mem->cv_swlipfp      = ZERO;
+  cv_mem->cv_swlip        = ZERO;
+  cv_mem->cv_nstsw        = cv_mem->cv_nst;
+  cv_mem->cv_nstlip       = cv_mem->cv_nst;
+  cv_mem->cv_nstab        = 0;
+  cv_mem->cv_lrw         += cv_mem->cv_lrw1;
+  cv_mem->cv_liw         += cv_mem->cv_liw1;
+
+  /* attach the solver of the current method, initialized by the next step */
+  cv_mem->cv_qmax = (cv_mem->cv_lmm == CV_ADAMS) ?
+    cv_mem->cv_swqadams : cv_mem->cv_swqbdf;
+  if (cv_mem->cv_lmm == CV_ADAMS) cv_mem->NLS = cv_mem->cv_swNLSfp;
+  if (cv_mem->cv_nst > 0) return(cvNlsInit(cv_mem));
+
+  return(CV_SUCCESS);
+}
+
+
 /* -----------------------------------------------------------------------------
  * Private functions
  * ---------------------------------------------------------------------------*/
 
+/*---------------------------------------------------------------
+  cvNlsSetFunctions:
+
+  Attaches the nonlinear system function of the solver type, the
+  convergence test and the maximum number of iterations to NLS.
+  ---------------------------------------------------------------*/
+static int cvNlsSetFunctions(CVodeMem cv_mem, SUNNonlinearSolver NLS,
+                             const char *fname)
+{
+  int retval;
+
+  /* set the nonlinear system function */
+  if (SUNNonlinSolGetType(NLS) == SUNNONLINEARSOLVER_ROOTFIND) {
+    retval = SUNNonlinSolSetSysFn(NLS, cvNlsResidual);
+  } else if (SUNNonlinSolGetType(NLS) ==  SUNNONLINEARSOLVER_FIXEDPOINT) {
+    retval = SUNNonlinSolSetSysFn(NLS, cvNlsFPFunction);
+  } else {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", fname,
+                   "Invalid nonlinear solver type");
+    return(CV_ILL_INPUT);
+  }
+
+  if (retval != CV_SUCCESS) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", fname,
+                   "Setting nonlinear system function failed");
+    return(CV_ILL_INPUT);
+  }
+
+  /* set convergence test function */
+  retval = SUNNonlinSolSetConvTestFn(NLS, cvNlsConvTest, cv_mem);
+  if (retval != CV_SUCCESS) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", fname,
+                   "Setting convergence test function failed");
+    return(CV_ILL_INPUT);
+  }
+
+  /* set max allowed nonlinear iterations */
+  retval = SUNNonlinSolSetMaxIters(NLS, NLS_MAXCOR);
+  if (retval != CV_SUCCESS) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODE", fname,
+                   "Setting maximum number of nonlinear iterations failed");
+    return(CV_ILL_INPUT);
+  }
+
+  return(CV_SUCCESS);
+}
+
 
 int cvNlsInit(CVodeMem cvode_mem)
 {
@@ -211,6 +330,43 @@ int cvNlsInit(CVodeMem cvode_mem)
 }
 
 
+/*---------------------------------------------------------------
+  cvNlsSwitch:
+
+  Attaches the solver of the method lmm of automatic method
+  switching and initializes it.
+  ---------------------------------------------------------------*/
+int cvNlsSwitch(CVodeMem cv_mem, int lmm)
+{
+  cv_mem->NLS = (lmm == CV_BDF) ? cv_mem->cv_swNLSnewton : cv_mem->cv_swNLSfp;
+  cv_mem->cv_acnrmcur = SUNFALSE;
+  return(cvNlsInit(cv_mem));
+}
+
+
+/*---------------------------------------------------------------
+  cvNlsFreeSwitching:
+
+  Turns automatic method switching off, attaches the Newton solver
+  again and frees the fixed point solver. The Newton solver is not
+  initialized here.
+  ---------------------------------------------------------------*/
+void cvNlsFreeSwitching(CVodeMem cv_mem)
+{
+  if (cv_mem->cv_swon) {
+    cv_mem->NLS = cv_mem->cv_swNLSnewton;
+    cv_mem->cv_lrw -= cv_mem->cv_lrw1;
+    cv_mem->cv_liw -= cv_mem->cv_liw1;
+  }
+  if (cv_mem->cv_swNLSfp != NULL) SUNNonlinSolFree(cv_mem->cv_swNLSfp);
+  if (cv_mem->cv_swfpred != NULL) N_VDestroy(cv_mem->cv_swfpred);
+  cv_mem->cv_swNLSfp     = NULL;
+  cv_mem->cv_swNLSnewton = NULL;
+  cv_mem->cv_swfpred     = NULL;
+  cv_mem->cv_swon        = SUNFALSE;
+}
+
+
 static int cvNlsLSetup(booleantype jbad, booleantype* jcur, void* cvode_mem)
 {
   CVodeMem cv_mem;
@@ -227,11 +383,17 @@ static int cvNlsLSetup(booleantype jbad, booleantype* jcur, void* cvode_mem)
     cv_mem->convfail = CV_FAIL_BAD_J;
 
   /* setup the linear solver */
+  SUNDIALS_MARK_BEGIN(cv_mem->cv_profiler, "cvLsSetup");
   retval = cv_mem->cv_lsetup(cv_mem, cv_mem->convfail, cv_mem->cv_y, cv_mem->cv_ftemp,
                              &(cv_mem->cv_jcur), cv_mem->cv_vtemp1, cv_mem->cv_vtemp2,
                              cv_mem->cv_vtemp3);
+  SUNDIALS_MARK_END(cv_mem->cv_profiler, "cvLsSetup");
   cv_mem->cv_nsetups++;
 
+  /* the setup of a previous integration is no longer used */
+  cv_mem->cv_lsetupok   = (retval == 0);
+  cv_mem->cv_lsetupkept = SUNFALSE;
+
   /* update Jacobian status */
   *jcur = cv_mem->cv_jcur;
 
@@ -258,7 +420,9 @@ static int cvNlsLSolve(N_Vector delta, void* cvode_mem)
   }
   cv_mem = (CVodeMem) cvode_mem;
 
+  SUNDIALS_MARK_BEGIN(cv_mem->cv_profiler, "cvLsSolve");
   retval = cv_mem->cv_lsolve(cv_mem, delta, cv_mem->cv_ewt, cv_mem->cv_y, cv_mem->cv_ftemp);
+  SUNDIALS_MARK_END(cv_mem->cv_profiler, "cvLsSolve");
 
   if (retval < 0) return(CV_LSOLVE_FAIL);
   if (retval > 0) return(SUN_NLS_CONV_RECVR);
@@ -282,7 +446,7 @@ static int cvNlsConvTest(SUNNonlinearSolver NLS, N_Vector ycor, N_Vector delta,
   cv_mem = (CVodeMem) cvode_mem;
 
   /* compute the norm of the correction */
-  del = N_VWrmsNorm(delta, ewt);
+  del = cvWrmsNorm(cv_mem, delta, ewt);
 
   /* get the current nonlinear solver iteration count */
   retval = SUNNonlinSolGetCurIter(NLS, &m);
@@ -292,11 +456,15 @@ static int cvNlsConvTest(SUNNonlinearSolver NLS, N_Vector ycor, N_Vector delta,
      rate constant is stored in crate, and used in the test.        */
   if (m > 0) {
     cv_mem->cv_crate = SUNMAX(CRDOWN * cv_mem->cv_crate, del/cv_mem->cv_delp);
+    /* the fixed point iteration of method switching contracts as gamma L */
+    if (cv_mem->cv_swon && (NLS == cv_mem->cv_swNLSfp))
+      cv_mem->cv_swlipfp = SUNMAX(cv_mem->cv_swlipfp,
+                                  del / (cv_mem->cv_delp * SUNRabs(cv_mem->cv_gamma)));
   }
   dcon = del * SUNMIN(ONE, cv_mem->cv_crate) / tol;
 
   if (dcon <= ONE) {
-    cv_mem->cv_acnrm = (m==0) ? del : N_VWrmsNorm(ycor, ewt);
+    cv_mem->cv_acnrm = (m==0) ? del : cvWrmsNorm(cv_mem, ycor, ewt);
     cv_mem->cv_acnrmcur = SUNTRUE;
     return(CV_SUCCESS); /* Nonlinear system was solved successfully */
   }
@@ -327,12 +495,26 @@ static int cvNlsResidual(N_Vector ycor, N_Vector res, void* cvode_mem)
   N_VLinearSum(ONE, cv_mem->cv_zn[0], ONE, ycor, cv_mem->cv_y);
 
   /* evaluate the rhs function */
+  SUNDIALS_MARK_BEGIN(cv_mem->cv_profiler, "cvRhs");
   retval = cv_mem->cv_f(cv_mem->cv_tn, cv_mem->cv_y, cv_mem->cv_ftemp,
                         cv_mem->cv_user_data);
+  SUNDIALS_MARK_END(cv_mem->cv_profiler, "cvRhs");
   cv_mem->cv_nfe++;
   if (retval < 0) return(CV_RHSFUNC_FAIL);
   if (retval > 0) return(RHSFUNC_RECVR);
 
+  /* f at the predictor for the estimate of the Lipschitz constant */
+  if (cv_mem->cv_swgrab) {
+    N_VScale(ONE, cv_mem->cv_ftemp, cv_mem->cv_swfpred);
+    cv_mem->cv_swgrab = SUNFALSE;
+  }
+
+  if (cv_mem->cv_usefusedcpu)
+  {
+    cvNlsResid_cpu(cv_mem->cv_rl1, -cv_mem->cv_gamma, cv_mem->cv_zn[1],
+                   ycor, cv_mem->cv_ftemp, res);
+  }
+  else
 #ifdef SUNDIALS_BUILD_PACKAGE_FUSED_KERNELS
   if (cv_mem->cv_usefused)
   {
@@ -365,12 +547,20 @@ static int cvNlsFPFunction(N_Vector ycor, N_Vector res, void* cvode_mem)
   N_VLinearSum(ONE, cv_mem->cv_zn[0], ONE, ycor, cv_mem->cv_y);
 
   /* evaluate the rhs function */
+  SUNDIALS_MARK_BEGIN(cv_mem->cv_profiler, "cvRhs");
   retval = cv_mem->cv_f(cv_mem->cv_tn, cv_mem->cv_y, res,
                         cv_mem->cv_user_data);
+  SUNDIALS_MARK_END(cv_mem->cv_profiler, "cvRhs");
   cv_mem->cv_nfe++;
   if (retval < 0) return(CV_RHSFUNC_FAIL);
   if (retval > 0) return(RHSFUNC_RECVR);
 
+  /* f at the predictor for the estimate of the Lipschitz constant */
+  if (cv_mem->cv_swgrab) {
+    N_VScale(ONE, res, cv_mem->cv_swfpred);
+    cv_mem->cv_swgrab = SUNFALSE;
+  }
+
   N_VLinearSum(cv_mem->cv_h, res, -ONE, cv_mem->cv_zn[1], res);
   N_VScale(cv_mem->cv_rl1, res, res);
 
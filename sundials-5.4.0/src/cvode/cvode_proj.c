@@ -336,7 +336,7 @@ int cvDoProjection(CVodeMem cv_mem, int *nflagPtr, realtype saved_t,
   {
     /* Recompute acnrm to be used in error test (if projecting the error) */
     if (proj_mem->err_proj)
-      cv_mem->cv_acnrm = N_VWrmsNorm(errP, cv_mem->cv_ewt);
+      cv_mem->cv_acnrm = cvWrmsNorm(cv_mem, errP, cv_mem->cv_ewt);
 
     /* The projection was successful, return now */
     cv_mem->proj_applied = SUNTRUE;
@@ -42,6 +42,11 @@
 #define HUNDRED     RCONST(100.0)      /* real 100.0 */
 #define FUZZ_FACTOR RCONST(1000000.0)  /* fuzz factor for IMget */
 
+/* Operations of CVAckpntIO on the vectors of a check point */
+#define CVA_CKPNT_WRITE   0   /* write to the check point file and release */
+#define CVA_CKPNT_READ    1   /* allocate and read from the check point file */
+#define CVA_CKPNT_RELEASE 2   /* release (the data stays in the file) */
+
 /*
  * =================================================================
  * PRIVATE FUNCTION PROTOTYPES
@@ -51,6 +56,8 @@
 static CkpntMem CVAckpntInit(CVodeMem cv_mem);
 static CkpntMem CVAckpntNew(CVodeMem cv_mem);
 static void CVAckpntDelete(CkpntMem *ck_memPtr);
+static int CVAckpntIO(CVodeMem cv_mem, CkpntMem ck_mem, int mode);
+static int CVAckpntVecIO(CVadjMem ca_mem, N_Vector *v, N_Vector tmpl, int mode);
 
 static void CVAbckpbDelete(CVodeBMem *cvB_memPtr);
 
@@ -145,6 +152,10 @@ int CVodeAdjInit(void *cvode_mem, long int steps, int interp)
   /* No interpolation data is available */
   ca_mem->ca_ckpntData = NULL;
 
+  /* Check points are kept in memory */
+  ca_mem->ca_ckfile = NULL;
+  ca_mem->ca_ckfileName = NULL;
+
   /* ------------------------------------
    * Initialization of interpolation data
    * ------------------------------------ */
@@ -293,6 +304,15 @@ int CVodeAdjReInit(void *cvode_mem)
   ca_mem->ca_nckpnts = 0;
   ca_mem->ca_ckpntData = NULL;
 
+  /* Discard the data in the check point file */
+
+  if (ca_mem->ca_ckfile != NULL) {
+    if (cvAckpntFileOpen(ca_mem) != 0) {
+      cvProcessError(cv_mem, CV_MEM_FAIL, "CVODEA", "CVodeAdjReInit", MSGCV_CKFILE_OPEN);
+      return(CV_MEM_FAIL);
+    }
+  }
+
   /* CVodeF and CVodeB not called yet */
 
   ca_mem->ca_firstCVodeFcall = SUNTRUE;
@@ -324,6 +344,13 @@ void CVodeAdjFree(void *cvode_mem)
     /* Delete check points one by one */
     while (ca_mem->ck_mem != NULL) CVAckpntDelete(&(ca_mem->ck_mem));
 
+    /* Close and delete the check point file */
+    if (ca_mem->ca_ckfile != NULL) fclose(ca_mem->ca_ckfile);
+    if (ca_mem->ca_ckfileName != NULL) {
+      remove(ca_mem->ca_ckfileName);
+      free(ca_mem->ca_ckfileName);
+    }
+
     /* Free vectors at all data points */
     if (ca_mem->ca_IMmallocDone) {
       ca_mem->ca_IMfree(cv_mem);
@@ -429,6 +456,13 @@ int CVodeF(void *cvode_mem, realtype tout, N_Vector yout,
       return(CV_MEM_FAIL);
     }
 
+    if (ca_mem->ca_ckfile != NULL) {
+      if (CVAckpntIO(cv_mem, ca_mem->ck_mem, CVA_CKPNT_WRITE) != 0) {
+        cvProcessError(cv_mem, CV_MEM_FAIL, "CVODEA", "CVodeF", MSGCV_CKFILE_IO);
+        return(CV_MEM_FAIL);
+      }
+    }
+
     if ( !ca_mem->ca_IMmallocDone ) {
 
       /* Do we need to store sensitivities? */
@@ -532,6 +566,15 @@ int CVodeF(void *cvode_mem, realtype tout, N_Vector yout,
       ca_mem->ca_nckpnts++;
       cv_mem->cv_forceSetup = SUNTRUE;
 
+      /* Move its vectors to the check point file */
+      if (ca_mem->ca_ckfile != NULL) {
+        if (CVAckpntIO(cv_mem, tmp, CVA_CKPNT_WRITE) != 0) {
+          cvProcessError(cv_mem, CV_MEM_FAIL, "CVODEA", "CVodeF", MSGCV_CKFILE_IO);
+          flag = CV_MEM_FAIL;
+          break;
+        }
+      }
+
       /* Reset i=0 and load dt_mem[0] */
       dt_mem[0]->t = ca_mem->ck_mem->ck_t0;
       ca_mem->ca_IMstore(cv_mem, dt_mem[0]);
@@ -1550,6 +1593,8 @@ static CkpntMem CVAckpntInit(CVodeMem cv_mem)
   ck_mem = (CkpntMem) malloc(sizeof(struct CkpntMemRec));
   if (ck_mem == NULL) return(NULL);
 
+  ck_mem->ck_spilled = SUNFALSE;
+
   ck_mem->ck_zn[0] = N_VClone(cv_mem->cv_tempv);
   if (ck_mem->ck_zn[0] == NULL) {
     free(ck_mem); ck_mem = NULL;
@@ -1657,6 +1702,8 @@ static CkpntMem CVAckpntNew(CVodeMem cv_mem)
   ck_mem = (CkpntMem) malloc(sizeof(struct CkpntMemRec));
   if (ck_mem == NULL) return(NULL);
 
+  ck_mem->ck_spilled = SUNFALSE;
+
   /* Set cv_next to NULL */
   ck_mem->ck_next = NULL;
 
@@ -1949,6 +1996,119 @@ static void CVAckpntDelete(CkpntMem *ck_memPtr)
 
 }
 
+/*
+ * cvAckpntFileOpen
+ *
+ * This routine (re)opens the check point file, either the file named
+ * ca_ckfileName which is truncated or a new temporary file. It
+ * returns 0 on success and -1 otherwise.
+ */
+
+int cvAckpntFileOpen(CVadjMem ca_mem)
+{
+  if (ca_mem->ca_ckfile != NULL) fclose(ca_mem->ca_ckfile);
+
+  if (ca_mem->ca_ckfileName != NULL)
+    ca_mem->ca_ckfile = fopen(ca_mem->ca_ckfileName, "w+b");
+  else
+    ca_mem->ca_ckfile = tmpfile();
+
+  return( (ca_mem->ca_ckfile == NULL) ? -1 : 0 );
+}
+
+/*
+ * CVAckpntIO
+ *
+ * This routine applies one of the CVA_CKPNT_* operations to all the
+ * vectors of the check point ck_mem, in the same order for each of
+ * them. A write appends the data to the check point file.
+ * Note that at the check point at t_initial, only zn[0], znQ[0],
+ * znS[0] and znQS[0] hold data; zn[1] always stays in memory.
+ * It returns 0 on success and -1 otherwise.
+ */
+
+static int CVAckpntIO(CVodeMem cv_mem, CkpntMem ck_mem, int mode)
+{
+  CVadjMem ca_mem;
+  int i, j, jlast, is, retval;
+
+  ca_mem = cv_mem->cv_adj_mem;
+
+  if (mode == CVA_CKPNT_WRITE) {
+    ck_mem->ck_spilled = SUNTRUE;
+    if (fseek(ca_mem->ca_ckfile, 0, SEEK_END) != 0) return(-1);
+    if (fgetpos(ca_mem->ca_ckfile, &(ck_mem->ck_fpos)) != 0) return(-1);
+  } else if (mode == CVA_CKPNT_READ) {
+    if (fsetpos(ca_mem->ca_ckfile, &(ck_mem->ck_fpos)) != 0) return(-1);
+  }
+
+  /* zn[0],...,zn[q] and zn[qmax] if it was allocated */
+  jlast = (ck_mem->ck_next == NULL) ? 0 : ck_mem->ck_q + 1;
+
+  retval = 0;
+  for (i = 0; i <= jlast && retval == 0; i++) {
+
+    if (i == ck_mem->ck_q + 1) {
+      if (ck_mem->ck_zqm == 0) break;
+      j = ck_mem->ck_zqm;
+    } else {
+      j = i;
+    }
+
+    retval = CVAckpntVecIO(ca_mem, &(ck_mem->ck_zn[j]), cv_mem->cv_tempv, mode);
+
+    if (ck_mem->ck_quadr && retval == 0)
+      retval = CVAckpntVecIO(ca_mem, &(ck_mem->ck_znQ[j]), cv_mem->cv_tempvQ, mode);
+
+    if (ck_mem->ck_sensi)
+      for (is = 0; is < ck_mem->ck_Ns && retval == 0; is++)
+        retval = CVAckpntVecIO(ca_mem, &(ck_mem->ck_znS[j][is]), cv_mem->cv_tempv, mode);
+
+    if (ck_mem->ck_quadr_sensi)
+      for (is = 0; is < ck_mem->ck_Ns && retval == 0; is++)
+        retval = CVAckpntVecIO(ca_mem, &(ck_mem->ck_znQS[j][is]), cv_mem->cv_tempvQ, mode);
+  }
+
+  return(retval);
+}
+
+/*
+ * CVAckpntVecIO
+ *
+ * This routine applies a CVA_CKPNT_* operation to the vector *v at
+ * the current position of the check point file. A vector read from
+ * the file is cloned from tmpl.
+ */
+
+static int CVAckpntVecIO(CVadjMem ca_mem, N_Vector *v, N_Vector tmpl, int mode)
+{
+  realtype *data;
+  size_t n;
+
+  if (mode == CVA_CKPNT_RELEASE) {
+    N_VDestroy(*v);
+    *v = NULL;
+    return(0);
+  }
+
+  if (mode == CVA_CKPNT_READ) {
+    *v = N_VClone(tmpl);
+    if (*v == NULL) return(-1);
+  }
+
+  data = N_VGetArrayPointer(*v);
+  if (data == NULL) return(-1);
+  n = (size_t) N_VGetLength(*v);
+
+  if (mode == CVA_CKPNT_READ)
+    return( (fread(data, sizeof(realtype), n, ca_mem->ca_ckfile) == n) ? 0 : -1 );
+
+  if (fwrite(data, sizeof(realtype), n, ca_mem->ca_ckfile) != n) return(-1);
+  N_VDestroy(*v);
+  *v = NULL;
+  return(0);
+}
+
 /*
  * =================================================================
  * PRIVATE FUNCTIONS FOR BACKWARD PROBLEMS
@@ -2016,8 +2176,19 @@ static int CVAdataStore(CVodeMem cv_mem, CkpntMem ck_mem)
   ca_mem = cv_mem->cv_adj_mem;
   dt_mem = ca_mem->dt_mem;
 
+  /* Read the vectors of ck_mem from the check point file */
+  if (ck_mem->ck_spilled) {
+    if (CVAckpntIO(cv_mem, ck_mem, CVA_CKPNT_READ) != 0) {
+      (void) CVAckpntIO(cv_mem, ck_mem, CVA_CKPNT_RELEASE);
+      cvProcessError(cv_mem, CV_REIFWD_FAIL, "CVODEA", "CVAdataStore", MSGCV_CKFILE_IO);
+      return(CV_REIFWD_FAIL);
+    }
+  }
+
   /* Initialize cv_mem with data from ck_mem */
   flag = CVAckpntGet(cv_mem, ck_mem);
+  if (ck_mem->ck_spilled)
+    (void) CVAckpntIO(cv_mem, ck_mem, CVA_CKPNT_RELEASE);
   if (flag != CV_SUCCESS)
     return(CV_REIFWD_FAIL);
 
@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cvodes_impl.h"
 #include <sundials/sundials_types.h>
@@ -76,6 +77,78 @@ int CVodeSetAdjNoSensi(void *cvode_mem)
   return(CV_SUCCESS);
 }
 
+/*
+ * CVodeSetAdjCheckpointFile
+ *
+ * Keeps the vectors of the check points in a file instead of memory.
+ * They are written when the check point is created by CVodeF and read
+ * back when CVodeB recomputes the forward solution from it. If filename
+ * is NULL an anonymous temporary file is used, otherwise the file is
+ * created (or truncated) and deleted again by CVodeAdjFree. Only the
+ * vectors with an array of data (serial, OpenMP, Pthreads) can be
+ * stored.
+ */
+
+int CVodeSetAdjCheckpointFile(void *cvode_mem, const char *filename)
+{
+  CVodeMem cv_mem;
+  CVadjMem ca_mem;
+
+  /* Check if cvode_mem exists */
+  if (cvode_mem == NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODEA", "CVodeSetAdjCheckpointFile", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+  cv_mem = (CVodeMem) cvode_mem;
+
+  /* Was ASA initialized? */
+  if (cv_mem->cv_adjMallocDone == SUNFALSE) {
+    cvProcessError(cv_mem, CV_NO_ADJ, "CVODEA", "CVodeSetAdjCheckpointFile", MSGCV_NO_ADJ);
+    return(CV_NO_ADJ);
+  }
+  ca_mem = cv_mem->cv_adj_mem;
+
+  /* The check points created so far are in memory */
+  if (!ca_mem->ca_firstCVodeFcall) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODEA", "CVodeSetAdjCheckpointFile", MSGCV_CKFILE_SET);
+    return(CV_ILL_INPUT);
+  }
+
+  if (cv_mem->cv_tempv->ops->nvgetarraypointer == NULL) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODEA", "CVodeSetAdjCheckpointFile", MSGCV_CKFILE_VEC);
+    return(CV_ILL_INPUT);
+  }
+
+  /* Close a previous file */
+  if (ca_mem->ca_ckfile != NULL) {
+    fclose(ca_mem->ca_ckfile);
+    ca_mem->ca_ckfile = NULL;
+  }
+  if (ca_mem->ca_ckfileName != NULL) {
+    remove(ca_mem->ca_ckfileName);
+    free(ca_mem->ca_ckfileName);
+    ca_mem->ca_ckfileName = NULL;
+  }
+
+  if (filename != NULL) {
+    ca_mem->ca_ckfileName = (char *) malloc(strlen(filename)+1);
+    if (ca_mem->ca_ckfileName == NULL) {
+      cvProcessError(cv_mem, CV_MEM_FAIL, "CVODEA", "CVodeSetAdjCheckpointFile", MSGCV_MEM_FAIL);
+      return(CV_MEM_FAIL);
+    }
+    strcpy(ca_mem->ca_ckfileName, filename);
+  }
+
+  if (cvAckpntFileOpen(ca_mem) != 0) {
+    free(ca_mem->ca_ckfileName);
+    ca_mem->ca_ckfileName = NULL;
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODEA", "CVodeSetAdjCheckpointFile", MSGCV_CKFILE_OPEN);
+    return(CV_ILL_INPUT);
+  }
+
+  return(CV_SUCCESS);
+}
+
 /* 
  * -----------------------------------------------------------------
  * Optional input functions for backward integration
@@ -169,10 +169,13 @@
  *   Wrappers for sensitivity RHS
  *      cvSensRhsWrapper
  *      cvSensRhs1Wrapper
+ *      cvSensRhsCtx
+ *      cvSensFreeContexts
  *
  *   Internal DQ approximations for sensitivity RHS
  *      cvSensRhsInternalDQ
  *      cvSensRhs1InternalDQ
+ *      cvSensRhs1DQ
  *      cvQuadSensRhsDQ
  *
  *   Error message handling functions
@@ -537,6 +540,12 @@ static realtype cvQuadSensUpdateNorm(CVodeMem cv_mem, realtype old_nrm,
 
 /* Internal sensitivity RHS DQ functions */
 
+static int cvSensRhs1DQ(CVodeMem cv_mem, realtype t,
+                        N_Vector y, N_Vector ydot,
+                        int is, N_Vector yS, N_Vector ySdot,
+                        void *user_data, realtype *p,
+                        N_Vector ytemp, N_Vector ftemp, long int *nfel);
+
 static int cvQuadSensRhsInternalDQ(int Ns, realtype t,
                                    N_Vector y, N_Vector *yS,
                                    N_Vector yQdot, N_Vector *yQSdot,
@@ -3974,6 +3983,8 @@ void CVodeFree(void **cvode_mem)
 
   CVodeSensFree(cv_mem);
 
+  cvSensFreeContexts(cv_mem);
+
   CVodeQuadSensFree(cv_mem);
 
   CVodeAdjFree(cv_mem);
@@ -8548,6 +8559,13 @@ int cvSensRhsWrapper(CVodeMem cv_mem, realtype time,
 {
   int retval=0, is;
 
+  /* evaluate the sensitivities concurrently if there are several contexts
+     and the RHS is given one sensitivity at a time */
+  if ( (cv_mem->cv_nsctx > 0) &&
+       ( (cv_mem->cv_fSDQ && (cv_mem->cv_sctxp != NULL)) ||
+         (!cv_mem->cv_fSDQ && (cv_mem->cv_ifS == CV_ONESENS)) ) )
+    return(cvSensRhsCtx(cv_mem, time, ycur, fcur, yScur, fScur));
+
   if (cv_mem->cv_ifS==CV_ALLSENS) {
     retval = cv_mem->cv_fS(cv_mem->cv_Ns, time, ycur, fcur, yScur,
                            fScur, cv_mem->cv_fS_data, temp1, temp2);
@@ -8591,6 +8609,97 @@ int cvSensRhs1Wrapper(CVodeMem cv_mem, realtype time,
   return(retval);
 }
 
+/*
+ * cvSensRhsCtx
+ *
+ * cvSensRhsCtx computes the same sensitivity right-hand sides as
+ * cvSensRhsWrapper, with the sensitivities distributed round-robin over
+ * the contexts set by CVodeSetSensRhsContexts. With OpenMP every context
+ * is handled by its own thread. It is used with fS1 supplied by the user
+ * or with the internal DQ approximation, which then perturbs the
+ * parameter array of the context. If a call fails the first negative
+ * (unrecoverable) return value is returned, otherwise the first positive
+ * one.
+ */
+
+int cvSensRhsCtx(CVodeMem cv_mem, realtype time,
+                 N_Vector ycur, N_Vector fcur,
+                 N_Vector *yScur, N_Vector *fScur)
+{
+  int k, K, is, Ns, which, retval, retmin, retmax;
+  long int nfel, nfe, nfS;
+  booleantype dq;
+
+  K  = cv_mem->cv_nsctx;
+  Ns = cv_mem->cv_Ns;
+  dq = cv_mem->cv_fSDQ;
+
+  retmin = retmax = 0;
+  nfe = nfS = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) \
+  private(k,is,which,retval,nfel) \
+  shared(K,Ns,dq,cv_mem,time,ycur,fcur,yScur,fScur) \
+  reduction(min:retmin) reduction(max:retmax) reduction(+:nfe,nfS) \
+  schedule(static,1) num_threads(K)
+#endif
+  for (k = 0; k < K; k++) {
+    for (is = k; is < Ns; is += K) {
+
+      if (dq) {
+        /* the context's copy of the perturbed parameter */
+        which = cv_mem->cv_plist[is];
+        cv_mem->cv_sctxp[k][which] = cv_mem->cv_p[which];
+
+        nfel = 0;
+        retval = cvSensRhs1DQ(cv_mem, time, ycur, fcur, is, yScur[is],
+                              fScur[is], cv_mem->cv_sctx[k],
+                              cv_mem->cv_sctxp[k], cv_mem->cv_sctxtmp[2*k],
+                              cv_mem->cv_sctxtmp[2*k+1], &nfel);
+        if (retval == 0) nfe += nfel;
+      } else {
+        retval = cv_mem->cv_fS1(Ns, time, ycur, fcur, is, yScur[is],
+                                fScur[is], cv_mem->cv_sctx[k],
+                                cv_mem->cv_sctxtmp[2*k],
+                                cv_mem->cv_sctxtmp[2*k+1]);
+      }
+      nfS++;
+
+      if (retval != 0) {
+        retmin = SUNMIN(retmin, retval);
+        retmax = SUNMAX(retmax, retval);
+        break;
+      }
+    }
+  }
+
+  cv_mem->cv_nfeS += nfe;
+  cv_mem->cv_nfSe += (cv_mem->cv_ifS == CV_ALLSENS) ? 1 : nfS;
+
+  return((retmin < 0) ? retmin : retmax);
+}
+
+/*
+ * cvSensFreeContexts
+ *
+ * cvSensFreeContexts frees the memory of the sensitivity RHS contexts.
+ */
+
+void cvSensFreeContexts(CVodeMem cv_mem)
+{
+  if (cv_mem->cv_sctxtmp != NULL)
+    N_VDestroyVectorArray(cv_mem->cv_sctxtmp, 2*cv_mem->cv_nsctx);
+  if (cv_mem->cv_sctxp != NULL)
+    free(cv_mem->cv_sctxp);
+  if (cv_mem->cv_sctx != NULL)
+    free(cv_mem->cv_sctx);
+  cv_mem->cv_sctx    = NULL;
+  cv_mem->cv_sctxp   = NULL;
+  cv_mem->cv_sctxtmp = NULL;
+  cv_mem->cv_nsctx   = 0;
+}
+
 /*
  * -----------------------------------------------------------------
  * Internal DQ approximations for sensitivity RHS
@@ -8642,8 +8751,43 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
                          N_Vector ytemp, N_Vector ftemp)
 {
   CVodeMem cv_mem;
+  int retval;
+  long int nfel = 0;
+
+  /* cvode_mem is passed here as user data */
+  cv_mem = (CVodeMem) cvode_mem;
+
+  retval = cvSensRhs1DQ(cv_mem, t, y, ydot, is, yS, ySdot,
+                        cv_mem->cv_user_data, cv_mem->cv_p,
+                        ytemp, ftemp, &nfel);
+  if (retval != 0) return(retval);
+
+  /* Increment counter nfeS */
+  cv_mem->cv_nfeS += nfel;
+
+  return(0);
+}
+
+/*
+ * cvSensRhs1DQ
+ *
+ * cvSensRhs1DQ computes the right hand side of the is-th sensitivity
+ * equation by finite differences, calling f with the given user data
+ * and perturbing the given parameter array. The number of f calls is
+ * added to nfel.
+ *
+ * cvSensRhs1DQ returns 0 if successful. Otherwise it returns the
+ * non-zero return value from f().
+ */
+
+static int cvSensRhs1DQ(CVodeMem cv_mem, realtype t,
+                        N_Vector y, N_Vector ydot,
+                        int is, N_Vector yS, N_Vector ySdot,
+                        void *user_data, realtype *p,
+                        N_Vector ytemp, N_Vector ftemp, long int *nfel)
+{
   int retval, method;
-  int nfel = 0, which;
+  int which;
   realtype psave, pbari;
   realtype delta , rdelta;
   realtype Deltap, rDeltap, r2Deltap;
@@ -8655,9 +8799,6 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
   realtype cvals[3];
   N_Vector Xvecs[3];
 
-  /* cvode_mem is passed here as user data */
-  cv_mem = (CVodeMem) cvode_mem;
-
   delta = SUNRsqrt(SUNMAX(cv_mem->cv_reltol, cv_mem->cv_uround));
   rdelta = ONE/delta;
 
@@ -8665,7 +8806,7 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
 
   which = cv_mem->cv_plist[is];
 
-  psave = cv_mem->cv_p[which];
+  psave = p[which];
 
   Deltap  = pbari * delta;
   rDeltap = ONE/Deltap;
@@ -8693,17 +8834,17 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
     r2Delta = HALF/Delta;
 
     N_VLinearSum(ONE,y,Delta,yS,ytemp);
-    cv_mem->cv_p[which] = psave + Delta;
+    p[which] = psave + Delta;
 
-    retval = cv_mem->cv_f(t, ytemp, ySdot, cv_mem->cv_user_data);
-    nfel++;
+    retval = cv_mem->cv_f(t, ytemp, ySdot, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     N_VLinearSum(ONE,y,-Delta,yS,ytemp);
-    cv_mem->cv_p[which] = psave - Delta;
+    p[which] = psave - Delta;
 
-    retval = cv_mem->cv_f(t, ytemp, ftemp, cv_mem->cv_user_data);
-    nfel++;
+    retval = cv_mem->cv_f(t, ytemp, ftemp, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     N_VLinearSum(r2Delta,ySdot,-r2Delta,ftemp,ySdot);
@@ -8717,26 +8858,26 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
 
     N_VLinearSum(ONE,y,Deltay,yS,ytemp);
 
-    retval = cv_mem->cv_f(t, ytemp, ySdot, cv_mem->cv_user_data);
-    nfel++;
+    retval = cv_mem->cv_f(t, ytemp, ySdot, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     N_VLinearSum(ONE,y,-Deltay,yS,ytemp);
 
-    retval = cv_mem->cv_f(t, ytemp, ftemp, cv_mem->cv_user_data);
-    nfel++;
+    retval = cv_mem->cv_f(t, ytemp, ftemp, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     N_VLinearSum(r2Deltay, ySdot, -r2Deltay, ftemp, ySdot);
 
-    cv_mem->cv_p[which] = psave + Deltap;
-    retval = cv_mem->cv_f(t, y, ytemp, cv_mem->cv_user_data);
-    nfel++;
+    p[which] = psave + Deltap;
+    retval = cv_mem->cv_f(t, y, ytemp, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
-    cv_mem->cv_p[which] = psave - Deltap;
-    retval = cv_mem->cv_f(t, y, ftemp, cv_mem->cv_user_data);
-    nfel++;
+    p[which] = psave - Deltap;
+    retval = cv_mem->cv_f(t, y, ftemp, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     /* ySdot = ySdot + r2Deltap * ytemp - r2Deltap * ftemp */
@@ -8755,10 +8896,10 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
     rDelta = ONE/Delta;
 
     N_VLinearSum(ONE,y,Delta,yS,ytemp);
-    cv_mem->cv_p[which] = psave + Delta;
+    p[which] = psave + Delta;
 
-    retval = cv_mem->cv_f(t, ytemp, ySdot, cv_mem->cv_user_data);
-    nfel++;
+    retval = cv_mem->cv_f(t, ytemp, ySdot, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     N_VLinearSum(rDelta,ySdot,-rDelta,ydot,ySdot);
@@ -8769,15 +8910,15 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
 
     N_VLinearSum(ONE,y,Deltay,yS,ytemp);
 
-    retval = cv_mem->cv_f(t, ytemp, ySdot, cv_mem->cv_user_data);
-    nfel++;
+    retval = cv_mem->cv_f(t, ytemp, ySdot, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     N_VLinearSum(rDeltay, ySdot, -rDeltay, ydot, ySdot);
 
-    cv_mem->cv_p[which] = psave + Deltap;
-    retval = cv_mem->cv_f(t, y, ytemp, cv_mem->cv_user_data);
-    nfel++;
+    p[which] = psave + Deltap;
+    retval = cv_mem->cv_f(t, y, ytemp, user_data);
+    (*nfel)++;
     if (retval != 0) return(retval);
 
     /* ySdot = ySdot + rDeltap * ytemp - rDeltap * ydot */
@@ -8792,10 +8933,7 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
 
   }
 
-  cv_mem->cv_p[which] = psave;
-
-  /* Increment counter nfeS */
-  cv_mem->cv_nfeS += nfel;
+  p[which] = psave;
 
   return(0);
 }
@@ -18,6 +18,7 @@
 #define _CVODES_IMPL_H
 
 #include <stdarg.h>
+#include <stdio.h>
 
 #include "cvodes/cvodes.h"
 
@@ -151,6 +152,15 @@ typedef struct CVodeMemRec {
   int cv_DQtype;              /* central/forward finite differences           */
   realtype cv_DQrhomax;       /* cut-off value for separate/simultaneous FD   */
 
+  /* Sensitivity RHS evaluation contexts, the sensitivities are
+     distributed over nsctx threads, thread k calls fS1 or the DQ f calls
+     with user data sctx[k], perturbs the parameters sctxp[k] and uses
+     the work vectors sctxtmp[2k] and sctxtmp[2k+1] */
+  int cv_nsctx;
+  void **cv_sctx;
+  realtype **cv_sctxp;
+  N_Vector *cv_sctxtmp;
+
   booleantype cv_errconS;     /* SUNTRUE if yS are considered in err. control */
 
   int cv_itolS;
@@ -595,6 +605,11 @@ struct CkpntMemRec {
   /* Saved values */
   realtype ck_saved_tq5;
 
+  /* Were the vectors written to the check point file and released?
+     ck_fpos is the position of their data in the file */
+  booleantype ck_spilled;
+  fpos_t ck_fpos;
+
   /* Pointer to next structure in list */
   struct CkpntMemRec *ck_next;
 
@@ -771,6 +786,11 @@ struct CVadjMemRec {
   /* address of the check point structure for which data is available */
   struct CkpntMemRec *ca_ckpntData;
 
+  /* File holding the vectors of the check points (NULL if they are kept
+     in memory) and its name (NULL for an anonymous temporary file) */
+  FILE *ca_ckfile;
+  char *ca_ckfileName;
+
   /* ------------------
    * Interpolation data
    * ------------------ */
@@ -996,6 +1016,12 @@ int cvSensRhs1Wrapper(CVodeMem cv_mem, realtype time,
                       int is, N_Vector yScur, N_Vector fScur,
                       N_Vector temp1, N_Vector temp2);
 
+int cvSensRhsCtx(CVodeMem cv_mem, realtype time,
+                 N_Vector ycur, N_Vector fcur,
+                 N_Vector *yScur, N_Vector *fScur);
+
+void cvSensFreeContexts(CVodeMem cv_mem);
+
 /* Prototypes for internal sensitivity rhs DQ functions */
 
 int cvSensRhsInternalDQ(int Ns, realtype t,
@@ -1010,6 +1036,10 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
                          void *fS_data,
                          N_Vector tempv, N_Vector ftemp);
 
+/* Prototype for (re)opening the check point file of the adjoint module */
+
+int cvAckpntFileOpen(CVadjMem ca_mem);
+
 /*
  * =================================================================
  *    E R R O R    M E S S A G E S
@@ -1171,6 +1201,10 @@ int cvSensRhs1InternalDQ(int Ns, realtype t,
  */
 
 #define MSGCV_NO_ADJ      "Illegal attempt to call before calling CVodeAdjMalloc."
+#define MSGCV_CKFILE_SET  "The check point file must be set before the first call to CVodeF."
+#define MSGCV_CKFILE_VEC  "The check point file requires vectors with an array of data (N_VGetArrayPointer)."
+#define MSGCV_CKFILE_OPEN "The check point file could not be opened."
+#define MSGCV_CKFILE_IO   "Writing or reading the check point file failed."
 #define MSGCV_BAD_STEPS   "Steps nonpositive illegal."
 #define MSGCV_BAD_INTERP  "Illegal value for interp."
 #define MSGCV_BAD_WHICH   "Illegal value for which."
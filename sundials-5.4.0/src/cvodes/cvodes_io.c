@@ -791,6 +791,67 @@ int CVodeSetSensParams(void *cvode_mem, realtype *p, realtype *pbar, int *plist)
 
 /*-----------------------------------------------------------------*/
 
+/*
+ * CVodeSetSensRhsContexts
+ *
+ * Sets ncontexts user data pointers for the sensitivity right-hand
+ * sides. The sensitivities are distributed over the contexts and
+ * computed concurrently, each context is used by one thread at a
+ * time, so fS1 (or f for the DQ approximation) must be safe to call
+ * at the same time with different contexts. For the DQ
+ * approximation, params[k] is the parameter array that f reads
+ * through contexts[k]; without params the DQ approximation stays
+ * serial. ncontexts = 0 turns this off again.
+ */
+
+int CVodeSetSensRhsContexts(void *cvode_mem, int ncontexts, void **contexts,
+                            realtype **params)
+{
+  CVodeMem cv_mem;
+  int k;
+
+  if (cvode_mem==NULL) {
+    cvProcessError(NULL, CV_MEM_NULL, "CVODES", "CVodeSetSensRhsContexts", MSGCV_NO_MEM);
+    return(CV_MEM_NULL);
+  }
+
+  cv_mem = (CVodeMem) cvode_mem;
+
+  if (cv_mem->cv_MallocDone == SUNFALSE) {
+    cvProcessError(cv_mem, CV_NO_MALLOC, "CVODES", "CVodeSetSensRhsContexts", MSGCV_NO_MALLOC);
+    return(CV_NO_MALLOC);
+  }
+
+  if ((ncontexts < 0) || ((ncontexts > 0) && (contexts == NULL))) {
+    cvProcessError(cv_mem, CV_ILL_INPUT, "CVODES", "CVodeSetSensRhsContexts",
+                   "Invalid number of contexts or NULL contexts.");
+    return(CV_ILL_INPUT);
+  }
+
+  cvSensFreeContexts(cv_mem);
+  if (ncontexts == 0) return(CV_SUCCESS);
+
+  cv_mem->cv_sctx    = (void **) malloc(ncontexts * sizeof(void *));
+  cv_mem->cv_sctxtmp = N_VCloneVectorArray(2*ncontexts, cv_mem->cv_tempv);
+  if (params != NULL)
+    cv_mem->cv_sctxp = (realtype **) malloc(ncontexts * sizeof(realtype *));
+  cv_mem->cv_nsctx = ncontexts;
+  if ((cv_mem->cv_sctx == NULL) || (cv_mem->cv_sctxtmp == NULL) ||
+      ((params != NULL) && (cv_mem->cv_sctxp == NULL))) {
+    cvSensFreeContexts(cv_mem);
+    cvProcessError(cv_mem, CV_MEM_FAIL, "CVODES", "CVodeSetSensRhsContexts", MSGCV_MEM_FAIL);
+    return(CV_MEM_FAIL);
+  }
+  for (k=0; k<ncontexts; k++) {
+    cv_mem->cv_sctx[k] = contexts[k];
+    if (params != NULL) cv_mem->cv_sctxp[k] = params[k];
+  }
+
+  return(CV_SUCCESS);
+}
+
+/*-----------------------------------------------------------------*/
+
 int CVodeSetQuadSensErrCon(void *cvode_mem, booleantype errconQS)
 {
   CVodeMem cv_mem;
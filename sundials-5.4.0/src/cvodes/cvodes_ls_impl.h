@@ -225,7 +225,7 @@ int cvLs_AccessLMemBCur(void *cvode_mem, const char *fname,
 #define MSG_LS_BAD_EPLIN      "eplifac < 0 illegal."
 #define MSG_LS_BAD_PRETYPE    "Illegal value for pretype. Legal values are PREC_NONE, PREC_LEFT, PREC_RIGHT, and PREC_BOTH."
 #define MSG_LS_PSOLVE_REQ     "pretype != PREC_NONE, but PSOLVE = NULL is illegal."
-#define MSG_LS_BAD_GSTYPE     "Illegal value for gstype. Legal values are MODIFIED_GS and CLASSICAL_GS."
+#define MSG_LS_BAD_GSTYPE     "Illegal value for gstype. Legal values are MODIFIED_GS, CLASSICAL_GS, CLASSICAL_GS2 and LOWSYNC_GS."
 
 #define MSG_LS_PSET_FAILED    "The preconditioner setup routine failed in an unrecoverable manner."
 #define MSG_LS_PSOLVE_FAILED  "The preconditioner solve routine failed in an unrecoverable manner."
@@ -319,6 +319,11 @@ void *IDACreate(void)
   IDA_mem->ida_maxbacks  = MAXBACKS;
   IDA_mem->ida_lsoff   = SUNFALSE;
   IDA_mem->ida_steptol = SUNRpowerR(IDA_mem->ida_uround, TWOTHIRDS);
+  IDA_mem->ida_alphals = PT0001;
+  IDA_mem->ida_etals   = HALF;
+  IDA_mem->ida_jacreuseIC = SUNFALSE;
+  IDA_mem->ida_reuseIC    = SUNFALSE;
+  IDA_mem->ida_icmask     = NULL;
 
   /* Initialize lrw and liw */
   IDA_mem->ida_lrw = 25 + 5*MXORDP1;
@@ -328,6 +333,7 @@ void *IDACreate(void)
   IDA_mem->ida_VatolMallocDone       = SUNFALSE;
   IDA_mem->ida_constraintsMallocDone = SUNFALSE;
   IDA_mem->ida_idMallocDone          = SUNFALSE;
+  IDA_mem->ida_icmaskMallocDone      = SUNFALSE;
   IDA_mem->ida_MallocDone            = SUNFALSE;
 
   /* Initialize nonlinear solver variables */
@@ -450,6 +456,7 @@ int IDAInit(void *ida_mem, IDAResFn res,
   IDA_mem->ida_lperf  = NULL;
   IDA_mem->ida_lfree  = NULL;
   IDA_mem->ida_lmem   = NULL;
+  IDA_mem->ida_lsetupOK = SUNFALSE;
 
   /* Initialize the phi array */
 
@@ -464,6 +471,7 @@ int IDAInit(void *ida_mem, IDAResFn res,
   IDA_mem->ida_netf    = 0;
   IDA_mem->ida_nni     = 0;
   IDA_mem->ida_nsetups = 0;
+  IDA_mem->ida_nreuseIC = 0;
 
   IDA_mem->ida_kused = 0;
   IDA_mem->ida_hused = ZERO;
@@ -561,6 +569,7 @@ int IDAReInit(void *ida_mem,
   IDA_mem->ida_netf    = 0;
   IDA_mem->ida_nni     = 0;
   IDA_mem->ida_nsetups = 0;
+  IDA_mem->ida_nreuseIC = 0;
 
   IDA_mem->ida_kused = 0;
   IDA_mem->ida_hused = ZERO;
@@ -1657,6 +1666,12 @@ static void IDAFreeVectors(IDAMem IDA_mem)
     IDA_mem->ida_liw -= IDA_mem->ida_liw1;
   }
 
+  if (IDA_mem->ida_icmaskMallocDone) {
+    N_VDestroy(IDA_mem->ida_icmask); IDA_mem->ida_icmask = NULL;
+    IDA_mem->ida_lrw -= IDA_mem->ida_lrw1;
+    IDA_mem->ida_liw -= IDA_mem->ida_liw1;
+  }
+
 }
 
 /*
@@ -45,7 +45,6 @@
 /* IDACalcIC control constants */
 
 #define ICRATEMAX  RCONST(0.9)    /* max. Newton conv. rate */
-#define ALPHALS    RCONST(0.0001) /* alpha in linesearch conv. test */
 
 /* Return values for lower level routines used by IDACalcIC */
 
@@ -204,6 +203,21 @@ int IDACalcIC(void *ida_mem, int icopt, realtype tout1)
     mxnh = 1;
   }
 
+  /* If the last linear solver setup may be reused, adopt its cj in the
+     IDA_YA_YDP_INIT case when it has the sign of 1/hic and corresponds to
+     a step no larger than hic. (The computed initial conditions do not
+     depend on hic, which only enters the iteration matrix.) */
+
+  if(IDA_mem->ida_jacreuseIC && IDA_mem->ida_lsetupOK &&
+     icopt == IDA_YA_YDP_INIT) {
+    if(IDA_mem->ida_cjold*hic > ZERO &&
+       SUNRabs(IDA_mem->ida_cjold) >= SUNRabs(IDA_mem->ida_cj)) {
+      hic = ONE/IDA_mem->ida_cjold;
+      IDA_mem->ida_cj = IDA_mem->ida_cjold;
+      IDA_mem->ida_hh = hic;
+    }
+  }
+
   /* Loop over nwt = number of evaluations of ewt vector. */
 
   for(nwt = 1; nwt <= 2; nwt++) {
@@ -211,7 +225,10 @@ int IDACalcIC(void *ida_mem, int icopt, realtype tout1)
     /* Loop over nh = number of h values. */
     for(nh = 1; nh <= mxnh; nh++) {
 
-      /* Call the IC nonlinear solver function. */
+      /* Call the IC nonlinear solver function, first with the last
+         setup if it was made with the current cj and reuse is enabled. */
+      IDA_mem->ida_reuseIC = IDA_mem->ida_jacreuseIC && IDA_mem->ida_lsetup &&
+        IDA_mem->ida_lsetupOK && (IDA_mem->ida_cjold == IDA_mem->ida_cj);
       retval = IDAnlsIC(IDA_mem);
 
       /* Cut h and loop on recoverable IDA_YA_YDP_INIT failure; else break. */
@@ -313,6 +330,34 @@ static int IDAnlsIC (IDAMem IDA_mem)
 
   N_VScale(ONE, IDA_mem->ida_delta, IDA_mem->ida_savres);
 
+  /* If allowed, iterate with the last setup before making a new one. On
+     slow convergence continue from the current iterate with a new setup,
+     on any other recoverable failure restart from yy0 and yp0. */
+
+  if(IDA_mem->ida_reuseIC) {
+    IDA_mem->ida_reuseIC = SUNFALSE;
+    retval = IDANewtonIC(IDA_mem);
+    if(retval == IDA_SUCCESS) {
+      IDA_mem->ida_nreuseIC++;
+      return(IDA_SUCCESS);
+    }
+    if(retval < 0) return(retval);
+
+    if(retval == IC_SLOW_CONVRG) {
+      N_VScale(ONE, IDA_mem->ida_savres, IDA_mem->ida_delta);
+    } else {
+      N_VScale(ONE, IDA_mem->ida_phi[0], IDA_mem->ida_yy0);
+      N_VScale(ONE, IDA_mem->ida_phi[1], IDA_mem->ida_yp0);
+      retval = IDA_mem->ida_res(IDA_mem->ida_t0, IDA_mem->ida_yy0,
+                                IDA_mem->ida_yp0, IDA_mem->ida_delta,
+                                IDA_mem->ida_user_data);
+      IDA_mem->ida_nre++;
+      if(retval < 0) return(IDA_RES_FAIL);
+      if(retval > 0) return(IC_FAIL_RECOV);
+      N_VScale(ONE, IDA_mem->ida_delta, IDA_mem->ida_savres);
+    }
+  }
+
   /* Loop over nj = number of linear solve Jacobian setups. */
 
   for(nj = 1; nj <= IDA_mem->ida_maxnj; nj++) {
@@ -323,6 +368,8 @@ static int IDAnlsIC (IDAMem IDA_mem)
       retval = IDA_mem->ida_lsetup(IDA_mem, IDA_mem->ida_yy0,
                                    IDA_mem->ida_yp0, IDA_mem->ida_delta,
                                    tv1, tv2, tv3);
+      IDA_mem->ida_cjold = IDA_mem->ida_cj;
+      IDA_mem->ida_lsetupOK = (retval == 0);
       if(retval < 0) return(IDA_LSETUP_FAIL);
       if(retval > 0) return(IC_FAIL_RECOV);
     }
@@ -469,6 +516,14 @@ static int IDALineSrch(IDAMem IDA_mem, realtype *delnorm, realtype *fnorm)
   f1norm = (*fnorm)*(*fnorm)*HALF;
   ratio = ONE;
 
+  /* With a correction mask, drop the step in the components held fixed. */
+  if(IDA_mem->ida_icmask != NULL) {
+    N_VProd(IDA_mem->ida_icmask, IDA_mem->ida_delta, IDA_mem->ida_delta);
+    *delnorm = IDAWrmsNorm(IDA_mem, IDA_mem->ida_delta, IDA_mem->ida_ewt, SUNFALSE);
+    if(IDA_mem->ida_sysindex == 0)
+      (*delnorm) *= IDA_mem->ida_tscale * SUNRabs(IDA_mem->ida_cj);
+  }
+
   /* If there are constraints, check and reduce step if necessary. */
   if(IDA_mem->ida_constraintsSet) {
 
@@ -511,9 +566,9 @@ static int IDALineSrch(IDAMem IDA_mem, realtype *delnorm, realtype *fnorm)
 
     /* Do alpha-condition test. */
     f1normp = fnormp*fnormp*HALF;
-    if(f1normp <= f1norm + ALPHALS*slpi*lambda) break;
+    if(f1normp <= f1norm + IDA_mem->ida_alphals*slpi*lambda) break;
     if(lambda < minlam) return(IC_LINESRCH_FAILED);
-    lambda /= TWO;
+    lambda *= IDA_mem->ida_etals;
     IDA_mem->ida_nbacktr++; nbacks++;
 
   }  /* End of breakout linesearch loop */
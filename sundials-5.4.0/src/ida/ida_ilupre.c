@@ -0,0 +1,416 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This file contains implementations of the incomplete LU
+ * preconditioner routines for use with IDA, the IDALS linear
+ * solver interface.
+ * -----------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ida_impl.h"
+#include "ida_ls_impl.h"
+#include "ida_ilupre_impl.h"
+#include <sundials/sundials_math.h>
+
+/* Prototypes of IDAILUPrecSetup and IDAILUPrecSolve */
+static int IDAILUPrecSetup(realtype tt, N_Vector yy, N_Vector yp,
+                           N_Vector rr, realtype c_j, void *ip_data);
+static int IDAILUPrecSolve(realtype tt, N_Vector yy, N_Vector yp,
+                           N_Vector rr, N_Vector rvec, N_Vector zvec,
+                           realtype c_j, realtype delta, void *ip_data);
+
+/* Prototype for IDAILUPrecFree */
+static int IDAILUPrecFree(IDAMem IDA_mem);
+
+/* Access to the preconditioner data */
+static int idaILUPrec_AccessPData(void *ida_mem, const char *fname,
+                                  IDAMem *IDA_mem, IILUPrecData *pdata);
+
+
+/*---------------------------------------------------------------
+  User-Callable Functions: initialization, optional inputs and
+  outputs
+  ---------------------------------------------------------------*/
+int IDAILUPrecInit(void *ida_mem, SUNMatrix J, IDALsJacFn jac,
+                   int ilutype)
+{
+  IDAMem IDA_mem;
+  IDALsMem idals_mem;
+  IILUPrecData pdata;
+  IDALsSparsity S;
+  sunindextype N;
+  int flag;
+
+  if (ida_mem == NULL) {
+    IDAProcessError(NULL, IDALS_MEM_NULL, "IDAILUPRE",
+                    "IDAILUPrecInit", MSGIP_MEM_NULL);
+    return(IDALS_MEM_NULL);
+  }
+  IDA_mem = (IDAMem) ida_mem;
+
+  /* Test if the LS linear solver interface has been created */
+  if (IDA_mem->ida_lmem == NULL) {
+    IDAProcessError(IDA_mem, IDALS_LMEM_NULL, "IDAILUPRE",
+                    "IDAILUPrecInit", MSGIP_LMEM_NULL);
+    return(IDALS_LMEM_NULL);
+  }
+  idals_mem = (IDALsMem) IDA_mem->ida_lmem;
+
+  /* Test compatibility of NVECTOR package with the ILU preconditioner */
+  if(IDA_mem->ida_tempv1->ops->nvgetarraypointer == NULL) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDAILUPRE",
+                    "IDAILUPrecInit", MSGIP_BAD_NVECTOR);
+    return(IDALS_ILL_INPUT);
+  }
+
+  /* Test the template matrix and the factorization type */
+  if ( (J == NULL) || (J->ops->getid == NULL) ||
+       (SUNMatGetID(J) != SUNMATRIX_SPARSE) ||
+       (SUNSparseMatrix_Rows(J) != SUNSparseMatrix_Columns(J)) ||
+       (SUNSparseMatrix_Rows(J) != N_VGetLength(IDA_mem->ida_tempv1)) ) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDAILUPRE",
+                    "IDAILUPrecInit", MSGIP_BAD_MATRIX);
+    return(IDALS_ILL_INPUT);
+  }
+  if ((ilutype != SUNILU_ILU0) && (ilutype != SUNILU_ILUT)) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDAILUPRE",
+                    "IDAILUPrecInit", MSGIP_BAD_TYPE);
+    return(IDALS_ILL_INPUT);
+  }
+  N = SUNSparseMatrix_Rows(J);
+
+  /* Without a Jacobian routine the pattern of J drives the colored
+     difference quotients of idaLsSparseDQJac */
+  if (jac == NULL) {
+    S = idals_mem->jpattern;
+    if ( (S == NULL) || (S->N != N) ||
+         (S->jactype != SUNSparseMatrix_SparseType(J)) ) {
+      S = idaLsSparsityCreate(J, SUNSparseMatrix_SparseType(J));
+      if (S == NULL) {
+        IDAProcessError(IDA_mem, IDALS_MEM_FAIL, "IDAILUPRE",
+                        "IDAILUPrecInit", MSGIP_MEM_FAIL);
+        return(IDALS_MEM_FAIL);
+      }
+      idaLsSparsityFree(&(idals_mem->jpattern));
+      idals_mem->jpattern = S;
+    }
+  }
+
+  /* Allocate data memory */
+  pdata = NULL;
+  pdata = (IILUPrecData) calloc(1, sizeof *pdata);
+  if (pdata == NULL) {
+    IDAProcessError(IDA_mem, IDALS_MEM_FAIL, "IDAILUPRE",
+                    "IDAILUPrecInit", MSGIP_MEM_FAIL);
+    return(IDALS_MEM_FAIL);
+  }
+
+  /* Set pointers in pdata */
+  pdata->ida_mem = IDA_mem;
+  pdata->jac = jac;
+  pdata->njeIP = 0;
+
+  /* Allocate memory for the preconditioner matrix, the factorization
+     and temporary N_Vectors */
+  pdata->savedP = SUNMatClone(J);
+  pdata->ilu    = SUNILUCreate(ilutype, N);
+  pdata->tempv1 = N_VClone(IDA_mem->ida_tempv1);
+  pdata->tempv2 = N_VClone(IDA_mem->ida_tempv1);
+  pdata->tempv3 = N_VClone(IDA_mem->ida_tempv1);
+  if ( (pdata->savedP == NULL) || (pdata->ilu == NULL) ||
+       (pdata->tempv1 == NULL) || (pdata->tempv2 == NULL) ||
+       (pdata->tempv3 == NULL) ) {
+    if (pdata->savedP) SUNMatDestroy(pdata->savedP);
+    SUNILUFree(pdata->ilu);
+    if (pdata->tempv1) N_VDestroy(pdata->tempv1);
+    if (pdata->tempv2) N_VDestroy(pdata->tempv2);
+    if (pdata->tempv3) N_VDestroy(pdata->tempv3);
+    free(pdata); pdata = NULL;
+    IDAProcessError(IDA_mem, IDALS_MEM_FAIL, "IDAILUPRE",
+                    "IDAILUPrecInit", MSGIP_MEM_FAIL);
+    return(IDALS_MEM_FAIL);
+  }
+
+  /* make sure pdata is free from any previous allocations */
+  if (idals_mem->pfree)
+    idals_mem->pfree(IDA_mem);
+
+  /* Point to the new pdata field in the LS memory */
+  idals_mem->pdata = pdata;
+
+  /* Attach the pfree function */
+  idals_mem->pfree = IDAILUPrecFree;
+
+  /* Attach preconditioner solve and setup functions */
+  flag = IDASetPreconditioner(ida_mem, IDAILUPrecSetup, IDAILUPrecSolve);
+
+  return(flag);
+}
+
+
+/*-------------------------------------------------------------*/
+int IDAILUPrecSetThresholds(void *ida_mem, realtype droptol,
+                            sunindextype lfil)
+{
+  IDAMem IDA_mem;
+  IILUPrecData pdata;
+  int retval;
+
+  retval = idaILUPrec_AccessPData(ida_mem, "IDAILUPrecSetThresholds",
+                                  &IDA_mem, &pdata);
+  if (retval != IDALS_SUCCESS) return(retval);
+
+  if (SUNILUSetThresholds(pdata->ilu, droptol, lfil) != SUNILU_SUCCESS) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDAILUPRE",
+                    "IDAILUPrecSetThresholds", MSGIP_BAD_INPUT);
+    return(IDALS_ILL_INPUT);
+  }
+
+  return(IDALS_SUCCESS);
+}
+
+
+/*-------------------------------------------------------------*/
+int IDAILUPrecSetNumThreads(void *ida_mem, int nthreads)
+{
+  IDAMem IDA_mem;
+  IILUPrecData pdata;
+  int retval;
+
+  retval = idaILUPrec_AccessPData(ida_mem, "IDAILUPrecSetNumThreads",
+                                  &IDA_mem, &pdata);
+  if (retval != IDALS_SUCCESS) return(retval);
+
+  if (SUNILUSetNumThreads(pdata->ilu, nthreads) != SUNILU_SUCCESS) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDAILUPRE",
+                    "IDAILUPrecSetNumThreads", MSGIP_BAD_INPUT);
+    return(IDALS_ILL_INPUT);
+  }
+
+  return(IDALS_SUCCESS);
+}
+
+
+/*-------------------------------------------------------------*/
+int IDAILUPrecGetWorkSpace(void *ida_mem, long int *lenrwIP,
+                           long int *leniwIP)
+{
+  IDAMem IDA_mem;
+  IILUPrecData pdata;
+  sunindextype lrw1, liw1;
+  long int lrw, liw;
+  int retval;
+
+  retval = idaILUPrec_AccessPData(ida_mem, "IDAILUPrecGetWorkSpace",
+                                  &IDA_mem, &pdata);
+  if (retval != IDALS_SUCCESS) return(retval);
+
+  /* sum space requirements for all objects in pdata */
+  *leniwIP = 4;
+  *lenrwIP = 0;
+  if (IDA_mem->ida_tempv1->ops->nvspace) {
+    N_VSpace(IDA_mem->ida_tempv1, &lrw1, &liw1);
+    *leniwIP += 3*liw1;
+    *lenrwIP += 3*lrw1;
+  }
+  if (pdata->savedP->ops->space) {
+    retval = SUNMatSpace(pdata->savedP, &lrw, &liw);
+    if (retval != 0) return(-1);
+    *leniwIP += liw;
+    *lenrwIP += lrw;
+  }
+  SUNILUGetWorkSpace(pdata->ilu, &lrw, &liw);
+  *leniwIP += liw;
+  *lenrwIP += lrw;
+
+  return(IDALS_SUCCESS);
+}
+
+
+/*-------------------------------------------------------------*/
+int IDAILUPrecGetNumJacEvals(void *ida_mem, long int *njevalsIP)
+{
+  IDAMem IDA_mem;
+  IILUPrecData pdata;
+  int retval;
+
+  retval = idaILUPrec_AccessPData(ida_mem, "IDAILUPrecGetNumJacEvals",
+                                  &IDA_mem, &pdata);
+  if (retval != IDALS_SUCCESS) return(retval);
+
+  *njevalsIP = pdata->njeIP;
+
+  return(IDALS_SUCCESS);
+}
+
+
+/*-------------------------------------------------------------*/
+int IDAILUPrecGetNumLevels(void *ida_mem, sunindextype *nlevL,
+                           sunindextype *nlevU)
+{
+  IDAMem IDA_mem;
+  IILUPrecData pdata;
+  int retval;
+
+  retval = idaILUPrec_AccessPData(ida_mem, "IDAILUPrecGetNumLevels",
+                                  &IDA_mem, &pdata);
+  if (retval != IDALS_SUCCESS) return(retval);
+
+  SUNILUGetNumLevels(pdata->ilu, nlevL, nlevU);
+
+  return(IDALS_SUCCESS);
+}
+
+
+/*---------------------------------------------------------------
+  IDAILUPrecSetup
+
+  IDAILUPrecSetup computes the iteration matrix
+  P = dF/dy + c_j*dF/dy' with the user Jacobian routine or with
+  sparse difference quotients, and its incomplete LU factors.
+
+  Return value:
+  The return value is 0 if successful, > 0 for a recoverable
+  error (the step will be retried), or < 0 for a nonrecoverable
+  error (the integration is halted).
+  ---------------------------------------------------------------*/
+static int IDAILUPrecSetup(realtype tt, N_Vector yy, N_Vector yp,
+                           N_Vector rr, realtype c_j, void *ip_data)
+{
+  IILUPrecData pdata;
+  IDAMem IDA_mem;
+  int retval;
+
+  pdata = (IILUPrecData) ip_data;
+  IDA_mem = (IDAMem) pdata->ida_mem;
+
+  /* Compute a new iteration matrix and store in savedP. */
+  retval = SUNMatZero(pdata->savedP);
+  if (retval) {
+    IDAProcessError(IDA_mem, -1, "IDAILUPRE", "IDAILUPrecSetup",
+                    MSGIP_SUNMAT_FAIL);
+    return(-1);
+  }
+
+  pdata->njeIP++;
+  if (pdata->jac)
+    retval = pdata->jac(tt, c_j, yy, yp, rr, pdata->savedP,
+                        IDA_mem->ida_user_data, pdata->tempv1,
+                        pdata->tempv2, pdata->tempv3);
+  else
+    retval = idaLsSparseDQJac(tt, c_j, yy, yp, rr, pdata->savedP,
+                              IDA_mem, pdata->tempv1, pdata->tempv2,
+                              pdata->tempv3);
+  if (retval < 0) {
+    IDAProcessError(IDA_mem, -1, "IDAILUPRE", "IDAILUPrecSetup",
+                    MSGIP_JACFUNC_FAILED);
+    return(-1);
+  }
+  if (retval > 0) {
+    return(1);
+  }
+
+  /* Compute the incomplete factors */
+  retval = SUNILUFactor(pdata->ilu, pdata->savedP);
+  if (retval != SUNILU_SUCCESS) {
+    IDAProcessError(IDA_mem, -1, "IDAILUPRE", "IDAILUPrecSetup",
+                    MSGIP_ILU_FAIL);
+    return(-1);
+  }
+
+  return(0);
+}
+
+
+/*---------------------------------------------------------------
+  IDAILUPrecSolve
+
+  The function IDAILUPrecSolve computes a solution to the linear
+  system P z = r, where P is the incomplete LU factorization
+  computed by IDAILUPrecSetup.
+
+  The arguments tt, yy, yp, rr, c_j and delta are NOT used.
+  ---------------------------------------------------------------*/
+static int IDAILUPrecSolve(realtype tt, N_Vector yy, N_Vector yp,
+                           N_Vector rr, N_Vector rvec, N_Vector zvec,
+                           realtype c_j, realtype delta, void *ip_data)
+{
+  IILUPrecData pdata;
+
+  pdata = (IILUPrecData) ip_data;
+
+  if (SUNILUSolve(pdata->ilu, rvec, zvec) != SUNILU_SUCCESS) return(-1);
+  return(0);
+}
+
+
+/*-------------------------------------------------------------*/
+static int IDAILUPrecFree(IDAMem IDA_mem)
+{
+  IDALsMem idals_mem;
+  IILUPrecData pdata;
+
+  if (IDA_mem->ida_lmem == NULL) return(0);
+  idals_mem = (IDALsMem) IDA_mem->ida_lmem;
+
+  if (idals_mem->pdata == NULL) return(0);
+  pdata = (IILUPrecData) idals_mem->pdata;
+
+  SUNILUFree(pdata->ilu);
+  SUNMatDestroy(pdata->savedP);
+  N_VDestroy(pdata->tempv1);
+  N_VDestroy(pdata->tempv2);
+  N_VDestroy(pdata->tempv3);
+
+  free(pdata);
+  pdata = NULL;
+
+  return(0);
+}
+
+
+/*---------------------------------------------------------------
+  idaILUPrec_AccessPData
+
+  Shortcut routine to unpack the IDA_mem and preconditioner data
+  structures. Returns IDALS_SUCCESS or an IDALS error flag.
+  ---------------------------------------------------------------*/
+static int idaILUPrec_AccessPData(void *ida_mem, const char *fname,
+                                  IDAMem *IDA_mem, IILUPrecData *pdata)
+{
+  IDALsMem idals_mem;
+
+  if (ida_mem == NULL) {
+    IDAProcessError(NULL, IDALS_MEM_NULL, "IDAILUPRE", fname,
+                    MSGIP_MEM_NULL);
+    return(IDALS_MEM_NULL);
+  }
+  *IDA_mem = (IDAMem) ida_mem;
+
+  if ((*IDA_mem)->ida_lmem == NULL) {
+    IDAProcessError(*IDA_mem, IDALS_LMEM_NULL, "IDAILUPRE", fname,
+                    MSGIP_LMEM_NULL);
+    return(IDALS_LMEM_NULL);
+  }
+  idals_mem = (IDALsMem) (*IDA_mem)->ida_lmem;
+
+  if ( (idals_mem->pdata == NULL) || (idals_mem->pfree != IDAILUPrecFree) ) {
+    IDAProcessError(*IDA_mem, IDALS_PMEM_NULL, "IDAILUPRE", fname,
+                    MSGIP_PMEM_NULL);
+    return(IDALS_PMEM_NULL);
+  }
+  *pdata = (IILUPrecData) idals_mem->pdata;
+
+  return(IDALS_SUCCESS);
+}
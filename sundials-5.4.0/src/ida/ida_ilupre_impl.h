@@ -0,0 +1,71 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * Implementation header file for the IDAILUPRE module.
+ * -----------------------------------------------------------------
+ */
+
+#ifndef _IDAILUPRE_IMPL_H
+#define _IDAILUPRE_IMPL_H
+
+#include <ida/ida_ilupre.h>
+#include <sunmatrix/sunmatrix_sparse.h>
+
+#ifdef __cplusplus  /* wrapper to enable C++ usage */
+extern "C" {
+#endif
+
+/*-----------------------------------------------------------------
+  Type: IILUPrecData
+  -----------------------------------------------------------------*/
+
+typedef struct IILUPrecDataRec {
+
+  /* Data set by user in IDAILUPrecInit */
+  IDALsJacFn jac;
+
+  /* Data set by IDAILUPrecSetup */
+  SUNMatrix savedP;
+  SUNILUMem ilu;
+  N_Vector tempv1;
+  N_Vector tempv2;
+  N_Vector tempv3;
+
+  /* Jacobian evaluations */
+  long int njeIP;
+
+  /* pointer to ida_mem */
+  void *ida_mem;
+
+} *IILUPrecData;
+
+/*-----------------------------------------------------------------
+  IDAILUPRE error messages
+  -----------------------------------------------------------------*/
+
+#define MSGIP_MEM_NULL       "Integrator memory is NULL."
+#define MSGIP_LMEM_NULL      "Linear solver memory is NULL. One of the SPILS linear solvers must be attached."
+#define MSGIP_MEM_FAIL       "A memory request failed."
+#define MSGIP_BAD_NVECTOR    "A required vector operation is not implemented."
+#define MSGIP_BAD_MATRIX     "J must be a square SUNSparseMatrix of the problem size."
+#define MSGIP_BAD_TYPE       "Illegal value for ilutype. Legal values are SUNILU_ILU0 and SUNILU_ILUT."
+#define MSGIP_BAD_INPUT      "Illegal ILU threshold or number of threads."
+#define MSGIP_SUNMAT_FAIL    "An error arose from a SUNSparseMatrix routine."
+#define MSGIP_ILU_FAIL       "The incomplete LU factorization failed."
+#define MSGIP_PMEM_NULL      "ILU preconditioner memory is NULL. IDAILUPrecInit must be called."
+#define MSGIP_JACFUNC_FAILED "The Jacobian routine failed in an unrecoverable manner."
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -136,6 +136,12 @@ typedef struct IDAMemRec {
   int ida_nbacktr;          /* number of IC linesearch backtrack operations   */
   int ida_sysindex;         /* computed system index (0 or 1)                 */
   int ida_maxbacks;         /* max backtracks per Newton step                 */
+  realtype ida_alphals;     /* IC linesearch sufficient decrease constant     */
+  realtype ida_etals;       /* IC linesearch step reduction factor            */
+  booleantype ida_jacreuseIC; /* try the last lsetup first in IDACalcIC       */
+  booleantype ida_reuseIC;  /* last lsetup is tried in the current IC solve   */
+  long int ida_nreuseIC;    /* number of IC solves done on a reused lsetup    */
+  N_Vector ida_icmask;      /* components corrected by IDACalcIC              */
   realtype ida_epiccon;     /* IC nonlinear convergence test constant         */
   realtype ida_steptol;     /* minimum Newton step size in IC calculation     */
   realtype ida_tscale;      /* time scale factor = abs(tout1 - t0)            */
@@ -164,6 +170,7 @@ typedef struct IDAMemRec {
   realtype ida_cjlast;   /* cj value saved from last successful step          */
   realtype ida_cjold;    /* cj value saved from last call to lsetup           */
   realtype ida_cjratio;  /* ratio of cj values: cj/cjold                      */
+  booleantype ida_lsetupOK; /* lsetup has succeeded since the LS was attached */
   realtype ida_ss;       /* scalar used in Newton iteration convergence test  */
   realtype ida_oldnrm;   /* norm of previous nonlinear solver update          */
   realtype ida_epsNewt;  /* test constant in Newton convergence test          */
@@ -220,6 +227,7 @@ typedef struct IDAMemRec {
   booleantype ida_VatolMallocDone;
   booleantype ida_constraintsMallocDone;
   booleantype ida_idMallocDone;
+  booleantype ida_icmaskMallocDone;
 
   booleantype ida_MallocDone; /* set to SUNFALSE by IDACreate
                                  set to SUNTRUE by IDAMAlloc
@@ -477,6 +485,9 @@ int idaNlsInit(IDAMem IDA_mem);
 
 #define MSG_IC_BAD_ICOPT   "icopt has an illegal value."
 #define MSG_IC_BAD_MAXBACKS "maxbacks <= 0 illegal."
+#define MSG_IC_BAD_ALPHALS "alpha must be in (0, 0.5)."
+#define MSG_IC_BAD_ETALS   "eta must be in (0, 1)."
+#define MSG_IC_BAD_MASK    "mask has illegal values."
 #define MSG_IC_MISSING_ID  "id = NULL conflicts with icopt."
 #define MSG_IC_TOO_CLOSE   "tout1 too close to t0 to attempt initial condition calculation."
 #define MSG_IC_BAD_ID      "id has illegal values."
@@ -633,6 +633,96 @@ int IDASetStepToleranceIC(void *ida_mem, realtype steptol)
   return(IDA_SUCCESS);
 }
 
+/*-----------------------------------------------------------------*/
+
+int IDASetLineSearchParamsIC(void *ida_mem, realtype alpha, realtype eta)
+{
+  IDAMem IDA_mem;
+
+  if (ida_mem==NULL) {
+    IDAProcessError(NULL, IDA_MEM_NULL, "IDA", "IDASetLineSearchParamsIC", MSG_NO_MEM);
+    return(IDA_MEM_NULL);
+  }
+
+  IDA_mem = (IDAMem) ida_mem;
+
+  if (alpha <= ZERO || alpha >= HALF) {
+    IDAProcessError(IDA_mem, IDA_ILL_INPUT, "IDA", "IDASetLineSearchParamsIC", MSG_IC_BAD_ALPHALS);
+    return(IDA_ILL_INPUT);
+  }
+
+  if (eta <= ZERO || eta >= ONE) {
+    IDAProcessError(IDA_mem, IDA_ILL_INPUT, "IDA", "IDASetLineSearchParamsIC", MSG_IC_BAD_ETALS);
+    return(IDA_ILL_INPUT);
+  }
+
+  IDA_mem->ida_alphals = alpha;
+  IDA_mem->ida_etals   = eta;
+
+  return(IDA_SUCCESS);
+}
+
+/*-----------------------------------------------------------------*/
+
+int IDASetJacReuseIC(void *ida_mem, booleantype reuse)
+{
+  IDAMem IDA_mem;
+
+  if (ida_mem==NULL) {
+    IDAProcessError(NULL, IDA_MEM_NULL, "IDA", "IDASetJacReuseIC", MSG_NO_MEM);
+    return(IDA_MEM_NULL);
+  }
+
+  IDA_mem = (IDAMem) ida_mem;
+
+  IDA_mem->ida_jacreuseIC = reuse;
+
+  return(IDA_SUCCESS);
+}
+
+/*-----------------------------------------------------------------*/
+
+int IDASetCorrectionMaskIC(void *ida_mem, N_Vector mask)
+{
+  IDAMem IDA_mem;
+
+  if (ida_mem==NULL) {
+    IDAProcessError(NULL, IDA_MEM_NULL, "IDA", "IDASetCorrectionMaskIC", MSG_NO_MEM);
+    return(IDA_MEM_NULL);
+  }
+
+  IDA_mem = (IDAMem) ida_mem;
+
+  if (mask == NULL) {
+    if (IDA_mem->ida_icmaskMallocDone) {
+      N_VDestroy(IDA_mem->ida_icmask);
+      IDA_mem->ida_lrw -= IDA_mem->ida_lrw1;
+      IDA_mem->ida_liw -= IDA_mem->ida_liw1;
+    }
+    IDA_mem->ida_icmask = NULL;
+    IDA_mem->ida_icmaskMallocDone = SUNFALSE;
+    return(IDA_SUCCESS);
+  }
+
+  if (N_VMin(mask) < ZERO || N_VMaxNorm(mask) > ONE) {
+    IDAProcessError(IDA_mem, IDA_ILL_INPUT, "IDA", "IDASetCorrectionMaskIC", MSG_IC_BAD_MASK);
+    return(IDA_ILL_INPUT);
+  }
+
+  if ( !(IDA_mem->ida_icmaskMallocDone) ) {
+    IDA_mem->ida_icmask = N_VClone(mask);
+    IDA_mem->ida_lrw += IDA_mem->ida_lrw1;
+    IDA_mem->ida_liw += IDA_mem->ida_liw1;
+    IDA_mem->ida_icmaskMallocDone = SUNTRUE;
+  }
+
+  /* Load the mask vector */
+
+  N_VScale(ONE, mask, IDA_mem->ida_icmask);
+
+  return(IDA_SUCCESS);
+}
+
 /*
  * =================================================================
  * IDA optional input functions
@@ -729,6 +819,24 @@ int IDAGetNumBacktrackOps(void *ida_mem, long int *nbacktracks)
 
 /*-----------------------------------------------------------------*/
 
+int IDAGetNumReusedSetupsIC(void *ida_mem, long int *nreuse)
+{
+  IDAMem IDA_mem;
+
+  if (ida_mem==NULL) {
+    IDAProcessError(NULL, IDA_MEM_NULL, "IDA", "IDAGetNumReusedSetupsIC", MSG_NO_MEM);
+    return(IDA_MEM_NULL);
+  }
+
+  IDA_mem = (IDAMem) ida_mem;
+
+  *nreuse = IDA_mem->ida_nreuseIC;
+
+  return(IDA_SUCCESS);
+}
+
+/*-----------------------------------------------------------------*/
+
 int IDAGetConsistentIC(void *ida_mem, N_Vector yy0, N_Vector yp0)
 {
   IDAMem IDA_mem;
@@ -132,6 +132,7 @@ int IDASetLinearSolver(void *ida_mem, SUNLinearSolver LS, SUNMatrix A)
   IDA_mem->ida_lsetup = idaLsSetup;
   IDA_mem->ida_lsolve = idaLsSolve;
   IDA_mem->ida_lfree  = idaLsFree;
+  IDA_mem->ida_lsetupOK = SUNFALSE;
 
   /* Set ida_lperf if using an iterative SUNLinearSolver object */
   IDA_mem->ida_lperf = (iterative) ? idaLsPerf : NULL;
@@ -292,6 +293,57 @@ int IDASetJacFn(void *ida_mem, IDALsJacFn jac)
 }
 
 
+/* IDASetJacSparsityPattern specifies the structure of the Jacobian
+   dF/dy + cj*dF/dy' used by the sparse difference quotient approximation.
+   Only the index arrays of P are used and copied, P may be destroyed after
+   the call. Passing NULL removes the pattern, it will then be taken from the
+   structure of the SUNSparseMatrix when IDA is initialized. */
+int IDASetJacSparsityPattern(void *ida_mem, SUNMatrix P)
+{
+  IDAMem        IDA_mem;
+  IDALsMem      idals_mem;
+  IDALsSparsity S;
+  int           retval;
+
+  /* access IDALsMem structure */
+  retval = idaLs_AccessLMem(ida_mem, "IDASetJacSparsityPattern",
+                            &IDA_mem, &idals_mem);
+  if (retval != IDALS_SUCCESS)  return(retval);
+
+  if (P == NULL) {
+    idaLsSparsityFree(&(idals_mem->jpattern));
+    return(IDALS_SUCCESS);
+  }
+
+  /* the pattern has to match a sparse system matrix */
+  if ( (idals_mem->J == NULL) || (idals_mem->J->ops->getid == NULL) ||
+       (SUNMatGetID(idals_mem->J) != SUNMATRIX_SPARSE) ) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDALS", "IDASetJacSparsityPattern",
+                    "A sparsity pattern requires a SUNSparseMatrix");
+    return(IDALS_ILL_INPUT);
+  }
+  if ( (P->ops->getid == NULL) || (SUNMatGetID(P) != SUNMATRIX_SPARSE) ||
+       (SUNSparseMatrix_Rows(P) != SUNSparseMatrix_Columns(idals_mem->J)) ||
+       (SUNSparseMatrix_Columns(P) != SUNSparseMatrix_Columns(idals_mem->J)) ) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDALS", "IDASetJacSparsityPattern",
+                    MSG_LS_BAD_PATTERN);
+    return(IDALS_ILL_INPUT);
+  }
+
+  S = idaLsSparsityCreate(P, SUNSparseMatrix_SparseType(idals_mem->J));
+  if (S == NULL) {
+    IDAProcessError(IDA_mem, IDALS_MEM_FAIL, "IDALS", "IDASetJacSparsityPattern",
+                    MSG_LS_MEM_FAIL);
+    return(IDALS_MEM_FAIL);
+  }
+
+  idaLsSparsityFree(&(idals_mem->jpattern));
+  idals_mem->jpattern = S;
+
+  return(IDALS_SUCCESS);
+}
+
+
 /* IDASetEpsLin specifies the nonlinear -> linear tolerance scale factor */
 int IDASetEpsLin(void *ida_mem, realtype eplifac)
 {
@@ -847,7 +899,7 @@ int idaLsPSolve(void *ida_mem, N_Vector r, N_Vector z, realtype tol, int lr)
 /*---------------------------------------------------------------
   idaLsDQJac:
 
-  This routine is a wrapper for the Dense and Band
+  This routine is a wrapper for the Dense, Band and Sparse
   implementations of the difference quotient Jacobian
   approximation routines.
 ---------------------------------------------------------------*/
@@ -890,6 +942,8 @@ int idaLsDQJac(realtype t, realtype c_j, N_Vector y, N_Vector yp,
     retval = idaLsDenseDQJac(t, c_j, y, yp, r, Jac, IDA_mem, tmp1);
   } else if (SUNMatGetID(Jac) == SUNMATRIX_BAND) {
     retval = idaLsBandDQJac(t, c_j, y, yp, r, Jac, IDA_mem, tmp1, tmp2, tmp3);
+  } else if (SUNMatGetID(Jac) == SUNMATRIX_SPARSE) {
+    retval = idaLsSparseDQJac(t, c_j, y, yp, r, Jac, IDA_mem, tmp1, tmp2, tmp3);
   } else {
     IDAProcessError(IDA_mem, IDA_ILL_INPUT, "IDALS",
                     "idaLsDQJac",
@@ -1123,6 +1177,293 @@ int idaLsBandDQJac(realtype tt, realtype c_j, N_Vector yy,
 }
 
 
+/*---------------------------------------------------------------
+  idaLsSparseDQJac
+
+  This routine generates a sparse difference quotient approximation
+  to the DAE system Jacobian F_y + c_j*F_y', using the sparsity
+  pattern and column coloring in idals_mem->jpattern. The structure
+  of the CSC or CSR SUNMatrix is set to the pattern, then y_j and
+  yp_j are incremented together for all columns j of one color,
+  requiring one call to res per color instead of one per column.
+  Each entry of the pattern is written once, at its index in the
+  data array of Jac. The increments are those of idaLsBandDQJac.
+  ---------------------------------------------------------------*/
+int idaLsSparseDQJac(realtype tt, realtype c_j, N_Vector yy,
+                     N_Vector yp, N_Vector rr, SUNMatrix Jac,
+                     IDAMem IDA_mem, N_Vector tmp1, N_Vector tmp2,
+                     N_Vector tmp3)
+{
+  realtype inc, inc_inv, yj, ypj, srur, conj;
+  realtype *y_data, *yp_data, *ewt_data, *cns_data = NULL;
+  realtype *ytemp_data, *yptemp_data, *rtemp_data, *r_data, *jac_data;
+  N_Vector rtemp, ytemp, yptemp;
+  sunindextype c, i, j, k, p, N;
+  sunindextype *colptrs, *rowvals, *jacpos, *ptrs, *vals;
+  IDALsMem idals_mem;
+  IDALsSparsity S;
+  int retval = 0;
+
+  /* access LsMem interface structure and the sparsity pattern */
+  idals_mem = (IDALsMem) IDA_mem->ida_lmem;
+  S = idals_mem->jpattern;
+
+  /* access matrix dimension */
+  N = SUNSparseMatrix_Columns(Jac);
+
+  if ( (S == NULL) || (S->N != N) || (SUNSparseMatrix_Rows(Jac) != N) ||
+       (S->jactype != SUNSparseMatrix_SparseType(Jac)) ) {
+    IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDALS", "idaLsSparseDQJac",
+                    MSG_LS_NO_PATTERN);
+    return(IDALS_ILL_INPUT);
+  }
+
+  /* Set the structure of Jac to the pattern */
+  if (SUNSparseMatrix_NNZ(Jac) < S->nnz) {
+    if (SUNSparseMatrix_Reallocate(Jac, S->nnz) != 0) {
+      IDAProcessError(IDA_mem, IDALS_MEM_FAIL, "IDALS", "idaLsSparseDQJac",
+                      MSG_LS_MEM_FAIL);
+      return(IDALS_MEM_FAIL);
+    }
+  }
+  ptrs = (S->jactype == CSC_MAT) ? S->colptrs : S->rowptrs;
+  vals = (S->jactype == CSC_MAT) ? S->rowvals : S->colvals;
+  memcpy(SUNSparseMatrix_IndexPointers(Jac), ptrs, (N+1)*sizeof(sunindextype));
+  memcpy(SUNSparseMatrix_IndexValues(Jac), vals, S->nnz*sizeof(sunindextype));
+
+  colptrs  = S->colptrs;
+  rowvals  = S->rowvals;
+  jacpos   = S->jacpos;
+  jac_data = SUNSparseMatrix_Data(Jac);
+
+  /* Rename work vectors for use as temporary values of r, y and yp */
+  rtemp = tmp1;
+  ytemp = tmp2;
+  yptemp= tmp3;
+
+  /* Obtain pointers to the data for all the vectors used. */
+  ewt_data    = N_VGetArrayPointer(IDA_mem->ida_ewt);
+  r_data      = N_VGetArrayPointer(rr);
+  y_data      = N_VGetArrayPointer(yy);
+  yp_data     = N_VGetArrayPointer(yp);
+  rtemp_data  = N_VGetArrayPointer(rtemp);
+  ytemp_data  = N_VGetArrayPointer(ytemp);
+  yptemp_data = N_VGetArrayPointer(yptemp);
+  if (IDA_mem->ida_constraintsSet)
+    cns_data = N_VGetArrayPointer(IDA_mem->ida_constraints);
+
+  /* Initialize ytemp and yptemp. */
+  N_VScale(ONE, yy, ytemp);
+  N_VScale(ONE, yp, yptemp);
+
+  srur = SUNRsqrt(IDA_mem->ida_uround);
+
+  /* Loop over column colors. */
+  for (c = 0; c < S->ncolors; c++) {
+
+    /* Increment all yy[j] and yp[j] for j of this color. */
+    for (p = S->colorptrs[c]; p < S->colorptrs[c+1]; p++) {
+      j = S->colorcols[p];
+      yj = y_data[j];
+      ypj = yp_data[j];
+
+      /* Set increment inc to yj based on sqrt(uround)*abs(yj), with
+      adjustments using ypj and ewtj if this is small, and a further
+      adjustment to give it the same sign as hh*ypj. */
+      inc = SUNMAX( srur * SUNMAX( SUNRabs(yj), SUNRabs(IDA_mem->ida_hh*ypj) ),
+                    ONE/ewt_data[j] );
+      if (IDA_mem->ida_hh*ypj < ZERO)  inc = -inc;
+      inc = (yj + inc) - yj;
+
+      /* Adjust sign(inc) again if yj has an inequality constraint. */
+      if (IDA_mem->ida_constraintsSet) {
+        conj = cns_data[j];
+        if (SUNRabs(conj) == ONE)      {if((yj+inc)*conj <  ZERO) inc = -inc;}
+        else if (SUNRabs(conj) == TWO) {if((yj+inc)*conj <= ZERO) inc = -inc;}
+      }
+
+      /* Increment yj and ypj. */
+      ytemp_data[j] += inc;
+      yptemp_data[j] += c_j*inc;
+    }
+
+    /* Call res routine with incremented arguments. */
+    retval = IDA_mem->ida_res(tt, ytemp, yptemp, rtemp, IDA_mem->ida_user_data);
+    idals_mem->nreDQ++;
+    if (retval != 0) break;
+
+    /* Loop over the columns of this color again. */
+    for (p = S->colorptrs[c]; p < S->colorptrs[c+1]; p++) {
+      j = S->colorcols[p];
+
+      /* Reset ytemp and yptemp components that were perturbed. */
+      yj = ytemp_data[j]  = y_data[j];
+      ypj = yptemp_data[j] = yp_data[j];
+
+      /* Set increment inc exactly as above. */
+      inc = SUNMAX( srur * SUNMAX( SUNRabs(yj), SUNRabs(IDA_mem->ida_hh*ypj) ),
+                    ONE/ewt_data[j] );
+      if (IDA_mem->ida_hh*ypj < ZERO)  inc = -inc;
+      inc = (yj + inc) - yj;
+      if (IDA_mem->ida_constraintsSet) {
+        conj = cns_data[j];
+        if (SUNRabs(conj) == ONE)      {if((yj+inc)*conj <  ZERO) inc = -inc;}
+        else if (SUNRabs(conj) == TWO) {if((yj+inc)*conj <= ZERO) inc = -inc;}
+      }
+
+      /* Load the difference quotient Jacobian elements for column j */
+      inc_inv = ONE/inc;
+      if (jacpos == NULL) {
+        for (k = colptrs[j]; k < colptrs[j+1]; k++) {
+          i = rowvals[k];
+          jac_data[k] = inc_inv * (rtemp_data[i] - r_data[i]);
+        }
+      } else {
+        for (k = colptrs[j]; k < colptrs[j+1]; k++) {
+          i = rowvals[k];
+          jac_data[jacpos[k]] = inc_inv * (rtemp_data[i] - r_data[i]);
+        }
+      }
+    }
+  }
+
+  return(retval);
+}
+
+
+/*---------------------------------------------------------------
+  idaLsSparsityCreate
+
+  This routine copies the structure of the square sparse matrix P
+  into a new IDALsSparsity object, in CSC and CSR form, and colors
+  the columns greedily in their natural order: column j gets the
+  smallest color not used by an earlier column that has a row in
+  common with j. For banded structures this gives the same groups
+  as the band DQ Jacobian. jactype is the layout of the matrices
+  the pattern will be loaded into. Returns NULL if a memory
+  request failed.
+  ---------------------------------------------------------------*/
+IDALsSparsity idaLsSparsityCreate(SUNMatrix P, int jactype)
+{
+  IDALsSparsity S;
+  sunindextype i, j, k, p, c, N, nnz;
+  sunindextype *ptrs, *vals, *next, *mark, *color;
+
+  N    = SUNSparseMatrix_Columns(P);
+  ptrs = SUNSparseMatrix_IndexPointers(P);
+  vals = SUNSparseMatrix_IndexValues(P);
+  nnz  = ptrs[N];
+
+  S = (IDALsSparsity) malloc(sizeof(struct IDALsSparsityRec));
+  if (S == NULL) return(NULL);
+  memset(S, 0, sizeof(struct IDALsSparsityRec));
+
+  S->N       = N;
+  S->nnz     = nnz;
+  S->jactype = jactype;
+
+  S->colptrs   = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  S->rowvals   = (sunindextype*) malloc(SUNMAX(nnz,1)*sizeof(sunindextype));
+  S->rowptrs   = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  S->colvals   = (sunindextype*) malloc(SUNMAX(nnz,1)*sizeof(sunindextype));
+  S->colorptrs = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  S->colorcols = (sunindextype*) malloc(SUNMAX(N,1)*sizeof(sunindextype));
+  if (jactype == CSR_MAT)
+    S->jacpos  = (sunindextype*) malloc(SUNMAX(nnz,1)*sizeof(sunindextype));
+  next  = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  mark  = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+  color = (sunindextype*) malloc((N+1)*sizeof(sunindextype));
+
+  if ( (S->colptrs == NULL) || (S->rowvals == NULL) || (S->rowptrs == NULL) ||
+       (S->colvals == NULL) || (S->colorptrs == NULL) || (S->colorcols == NULL) ||
+       ((jactype == CSR_MAT) && (S->jacpos == NULL)) ||
+       (next == NULL) || (mark == NULL) || (color == NULL) ) {
+    free(next); free(mark); free(color);
+    idaLsSparsityFree(&S);
+    return(NULL);
+  }
+
+  /* CSC pattern: copy, or transpose a CSR matrix by counting sort */
+  if (SUNSparseMatrix_SparseType(P) == CSC_MAT) {
+    memcpy(S->colptrs, ptrs, (N+1)*sizeof(sunindextype));
+    memcpy(S->rowvals, vals, nnz*sizeof(sunindextype));
+  } else {
+    for (j = 0; j <= N; j++) S->colptrs[j] = 0;
+    for (k = 0; k < nnz; k++) S->colptrs[vals[k]+1]++;
+    for (j = 0; j < N; j++) S->colptrs[j+1] += S->colptrs[j];
+    for (j = 0; j < N; j++) next[j] = S->colptrs[j];
+    for (i = 0; i < N; i++)
+      for (k = ptrs[i]; k < ptrs[i+1]; k++)
+        S->rowvals[next[vals[k]]++] = i;
+  }
+
+  /* CSR pattern from the CSC pattern, jacpos maps CSC to CSR entries */
+  for (i = 0; i <= N; i++) S->rowptrs[i] = 0;
+  for (k = 0; k < nnz; k++) S->rowptrs[S->rowvals[k]+1]++;
+  for (i = 0; i < N; i++) S->rowptrs[i+1] += S->rowptrs[i];
+  for (i = 0; i < N; i++) next[i] = S->rowptrs[i];
+  for (j = 0; j < N; j++) {
+    for (k = S->colptrs[j]; k < S->colptrs[j+1]; k++) {
+      p = next[S->rowvals[k]]++;
+      S->colvals[p] = j;
+      if (S->jacpos) S->jacpos[k] = p;
+    }
+  }
+
+  /* Greedy coloring, mark[c] == j if color c is taken by a neighbor of j */
+  for (j = 0; j < N; j++) {
+    mark[j]  = -1;
+    color[j] = -1;
+  }
+  S->ncolors = 0;
+  for (j = 0; j < N; j++) {
+    for (k = S->colptrs[j]; k < S->colptrs[j+1]; k++) {
+      i = S->rowvals[k];
+      for (p = S->rowptrs[i]; p < S->rowptrs[i+1]; p++) {
+        c = color[S->colvals[p]];
+        if (c >= 0) mark[c] = j;
+      }
+    }
+    for (c = 0; mark[c] == j; c++) ;
+    color[j] = c;
+    if (c >= S->ncolors) S->ncolors = c+1;
+  }
+
+  /* Sort the columns by color */
+  for (c = 0; c <= S->ncolors; c++) S->colorptrs[c] = 0;
+  for (j = 0; j < N; j++) S->colorptrs[color[j]+1]++;
+  for (c = 0; c < S->ncolors; c++) S->colorptrs[c+1] += S->colorptrs[c];
+  for (c = 0; c < S->ncolors; c++) next[c] = S->colorptrs[c];
+  for (j = 0; j < N; j++) S->colorcols[next[color[j]]++] = j;
+
+  free(next);
+  free(mark);
+  free(color);
+
+  return(S);
+}
+
+
+/*---------------------------------------------------------------
+  idaLsSparsityFree
+
+  This routine frees an IDALsSparsity object and sets it to NULL.
+  ---------------------------------------------------------------*/
+void idaLsSparsityFree(IDALsSparsity *S)
+{
+  if (S == NULL || *S == NULL) return;
+  free((*S)->colptrs);
+  free((*S)->rowvals);
+  free((*S)->rowptrs);
+  free((*S)->colvals);
+  free((*S)->jacpos);
+  free((*S)->colorptrs);
+  free((*S)->colorcols);
+  free(*S);
+  *S = NULL;
+}
+
+
 /*---------------------------------------------------------------
   idaLsDQJtimes
 
@@ -1218,7 +1559,7 @@ int idaLsInitialize(IDAMem IDA_mem)
   } else if (idals_mem->jacDQ) {
 
     /* If J is non-NULL, and 'jac' is not user-supplied:
-       - if J is dense or band, ensure that our DQ approx. is used
+       - if J is dense, band or sparse, ensure that our DQ approx. is used
        - otherwise => error */
     retval = 0;
     if (idals_mem->J->ops->getid) {
@@ -1227,6 +1568,28 @@ int idaLsInitialize(IDAMem IDA_mem)
            (SUNMatGetID(idals_mem->J) == SUNMATRIX_BAND) ) {
         idals_mem->jac    = idaLsDQJac;
         idals_mem->J_data = IDA_mem;
+      } else if (SUNMatGetID(idals_mem->J) == SUNMATRIX_SPARSE) {
+        idals_mem->jac    = idaLsDQJac;
+        idals_mem->J_data = IDA_mem;
+
+        /* Take the sparsity pattern from the structure of J, unless it
+           was set with IDASetJacSparsityPattern */
+        if (idals_mem->jpattern == NULL) {
+          if (SUNSparseMatrix_IndexPointers(idals_mem->J)[SUNSparseMatrix_NP(idals_mem->J)] == 0) {
+            IDAProcessError(IDA_mem, IDALS_ILL_INPUT, "IDALS", "idaLsInitialize",
+                            MSG_LS_NO_PATTERN);
+            idals_mem->last_flag = IDALS_ILL_INPUT;
+            return(IDALS_ILL_INPUT);
+          }
+          idals_mem->jpattern =
+            idaLsSparsityCreate(idals_mem->J, SUNSparseMatrix_SparseType(idals_mem->J));
+          if (idals_mem->jpattern == NULL) {
+            IDAProcessError(IDA_mem, IDALS_MEM_FAIL, "IDALS", "idaLsInitialize",
+                            MSG_LS_MEM_FAIL);
+            idals_mem->last_flag = IDALS_MEM_FAIL;
+            return(IDALS_MEM_FAIL);
+          }
+        }
       } else {
         retval++;
       }
@@ -1582,6 +1945,9 @@ int idaLsFree(IDAMem IDA_mem)
     idals_mem->x = NULL;
   }
 
+  /* Free sparsity pattern of the DQ Jacobian */
+  idaLsSparsityFree(&(idals_mem->jpattern));
+
   /* Nullify other N_Vector pointers */
   idals_mem->ycur  = NULL;
   idals_mem->ypcur = NULL;
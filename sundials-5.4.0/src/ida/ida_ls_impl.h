@@ -25,6 +25,38 @@
 extern "C" {
 #endif
 
+/*-----------------------------------------------------------------
+  Types : struct IDALsSparsityRec, struct *IDALsSparsity
+
+  Sparsity pattern of the DAE system Jacobian dF/dy + cj*dF/dy'
+  used by the sparse difference quotient approximation, i.e. the
+  union of the patterns of dF/dy and dF/dy'. The pattern is stored
+  column-wise (CSC) and row-wise (CSR) together with a column
+  coloring: two columns have the same color only if they have no
+  row in common, so all columns of a color are perturbed with a
+  single call to res.
+  -----------------------------------------------------------------*/
+typedef struct IDALsSparsityRec {
+
+  sunindextype N;      /* number of rows and columns                   */
+  sunindextype nnz;    /* number of structural nonzeros                */
+  int jactype;         /* CSC_MAT or CSR_MAT, layout of the Jacobian   */
+
+  sunindextype *colptrs;  /* CSC pattern, size N+1                     */
+  sunindextype *rowvals;  /* CSC pattern, size nnz                     */
+  sunindextype *rowptrs;  /* CSR pattern, size N+1                     */
+  sunindextype *colvals;  /* CSR pattern, size nnz                     */
+  sunindextype *jacpos;   /* index in the CSR data of each CSC entry,
+                             NULL if the Jacobian is CSC               */
+
+  sunindextype ncolors;   /* number of column colors                   */
+  sunindextype *colorptrs; /* columns of color c are colorcols[k] for
+                              colorptrs[c] <= k < colorptrs[c+1]       */
+  sunindextype *colorcols; /* columns sorted by color, size N          */
+
+} *IDALsSparsity;
+
+
 /*-----------------------------------------------------------------
   Types : struct IDALsMemRec, struct *IDALsMem
 
@@ -42,6 +74,8 @@ typedef struct IDALsMemRec {
   booleantype jacDQ;    /* SUNTRUE if using internal DQ Jacobian approx. */
   IDALsJacFn jac;       /* Jacobian routine to be called                 */
   void *J_data;         /* J_data is passed to jac                       */
+  IDALsSparsity jpattern; /* Jacobian sparsity and coloring used by the
+                             sparse DQ Jac approx.                       */
 
   /* Linear solver, matrix and vector objects/pointers */
   SUNLinearSolver LS;   /* generic linear solver object                  */
@@ -133,6 +167,14 @@ int idaLsBandDQJac(realtype tt, realtype c_j,  N_Vector yy,
                    N_Vector yp, N_Vector rr, SUNMatrix Jac,
                    IDAMem IDA_mem, N_Vector tmp1,
                    N_Vector tmp2, N_Vector tmp3);
+int idaLsSparseDQJac(realtype tt, realtype c_j, N_Vector yy,
+                     N_Vector yp, N_Vector rr, SUNMatrix Jac,
+                     IDAMem IDA_mem, N_Vector tmp1,
+                     N_Vector tmp2, N_Vector tmp3);
+
+/* Sparsity pattern and column coloring for idaLsSparseDQJac */
+IDALsSparsity idaLsSparsityCreate(SUNMatrix P, int jactype);
+void idaLsSparsityFree(IDALsSparsity *S);
 
 /* Generic linit/lsetup/lsolve/lperf/lfree interface routines for IDA to call */
 int idaLsInitialize(IDAMem IDA_mem);
@@ -176,6 +218,8 @@ int idaLs_AccessLMem(void* ida_mem, const char* fname,
 #define MSG_LS_NEG_MAXRS      "maxrs < 0 illegal."
 #define MSG_LS_NEG_EPLIFAC    "eplifac < 0.0 illegal."
 #define MSG_LS_NEG_DQINCFAC   "dqincfac < 0.0 illegal."
+#define MSG_LS_BAD_PATTERN    "The sparsity pattern must be a square SUNSparseMatrix with the size of the linear system."
+#define MSG_LS_NO_PATTERN     "The sparse difference quotient Jacobian requires a sparsity pattern, either in the structure of the SUNSparseMatrix or from IDASetJacSparsityPattern."
 #define MSG_LS_PSET_FAILED    "The preconditioner setup routine failed in an unrecoverable manner."
 #define MSG_LS_PSOLVE_FAILED  "The preconditioner solve routine failed in an unrecoverable manner."
 #define MSG_LS_JTSETUP_FAILED "The Jacobian x vector setup routine failed in an unrecoverable manner."
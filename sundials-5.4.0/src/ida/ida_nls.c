@@ -220,6 +220,7 @@ static int idaNlsLSetup(booleantype jbad, booleantype* jcur, void* ida_mem)
   IDA_mem->ida_cjold   = IDA_mem->ida_cj;
   IDA_mem->ida_cjratio = ONE;
   IDA_mem->ida_ss      = TWENTY;
+  IDA_mem->ida_lsetupOK = (retval == 0);
 
   if (retval < 0) return(IDA_LSETUP_FAIL);
   if (retval > 0) return(IDA_LSETUP_RECVR);
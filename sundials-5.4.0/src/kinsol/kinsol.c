@@ -73,6 +73,14 @@
 #include "kinsol_impl.h"
 #include <sundials/sundials_math.h>
 
+/* Chrome trace events of the enclosing build, recorded with OMS_TRACE */
+#ifdef OMS_TRACE
+#include "omstrace.h"
+#else
+#define OMS_TRACE_BEGIN(category, name)
+#define OMS_TRACE_END(category, name)
+#endif
+
 /*
  * =================================================================
  * KINSOL PRIVATE CONSTANTS
@@ -160,6 +168,8 @@
 
 static booleantype KINCheckNvector(N_Vector tmpl);
 static booleantype KINAllocVectors(KINMem kin_mem, N_Vector tmpl);
+static int KINSolve(KINMem kin_mem, N_Vector u, int strategy_in,
+                    N_Vector u_scale, N_Vector f_scale);
 static int KINSolInit(KINMem kin_mem);
 static int KINConstraint(KINMem kin_mem );
 static void KINForcingTerm(KINMem kin_mem, realtype fnormp);
@@ -180,8 +190,10 @@ static realtype KINScFNorm(KINMem kin_mem, N_Vector v, N_Vector scale);
 static realtype KINScSNorm(KINMem kin_mem, N_Vector v, N_Vector u);
 static int KINStop(KINMem kin_mem, booleantype maxStepTaken,
                    int sflag);
+static void KINWarmStartUpdate(KINMem kin_mem, int ret);
 static int AndersonAcc(KINMem kin_mem, N_Vector gval, N_Vector fv, N_Vector x,
-                       N_Vector x_old, long int iter, realtype *R, realtype *gamma);
+                       N_Vector x_old, long int iter, booleantype addcol,
+                       realtype *R, realtype *gamma);
 
 /*
  * =================================================================
@@ -228,6 +240,7 @@ void *KINCreate(void)
 
   kin_mem->kin_func             = NULL;
   kin_mem->kin_user_data        = NULL;
+  kin_mem->kin_profiler         = NULL;
   kin_mem->kin_uu               = NULL;
   kin_mem->kin_unew             = NULL;
   kin_mem->kin_fval             = NULL;
@@ -254,6 +267,7 @@ void *KINCreate(void)
   kin_mem->kin_setstop_aa       = 0;
   kin_mem->kin_beta_aa          = ONE;
   kin_mem->kin_damping_aa       = SUNFALSE;
+  kin_mem->kin_qradd_aa         = QRAddMGS;
   kin_mem->kin_constraintsSet   = SUNFALSE;
   kin_mem->kin_ehfun            = KINErrHandler;
   kin_mem->kin_eh_data          = kin_mem;
@@ -264,6 +278,10 @@ void *KINCreate(void)
   kin_mem->kin_printfl          = PRINTFL_DEFAULT;
   kin_mem->kin_mxiter           = MXITER_DEFAULT;
   kin_mem->kin_noInitSetup      = SUNFALSE;
+  kin_mem->kin_warmstart        = SUNFALSE;
+  kin_mem->kin_lsetupok         = SUNFALSE;
+  kin_mem->kin_lsetupage        = 0;
+  kin_mem->kin_iter_aa          = 0;
   kin_mem->kin_msbset           = MSBSET_DEFAULT;
   kin_mem->kin_noResMon         = SUNFALSE;
   kin_mem->kin_msbset_sub       = MSBSET_SUB_DEFAULT;
@@ -367,6 +385,11 @@ int KINInit(void *kinmem, KINSysFn func, N_Vector tmpl)
   kin_mem->kin_lfree  = NULL;
   kin_mem->kin_lmem   = NULL;
 
+  /* nothing to warm start from */
+
+  kin_mem->kin_lsetupok = SUNFALSE;
+  kin_mem->kin_iter_aa = 0;
+
   /* problem memory has been successfully allocated */
 
   kin_mem->kin_MallocDone = SUNTRUE;
@@ -405,8 +428,37 @@ int KINInit(void *kinmem, KINSysFn func, N_Vector tmpl)
 int KINSol(void *kinmem, N_Vector u, int strategy_in,
            N_Vector u_scale, N_Vector f_scale)
 {
-  realtype fnormp, f1normp, epsmin, fmax=ZERO;
   KINMem kin_mem;
+  SUNProfiler prev;
+  int ret;
+
+  /* check for kinmem non-NULL */
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KIN_MEM_NULL, "KINSOL", "KINSol", MSG_NO_MEM);
+    return(KIN_MEM_NULL);
+  }
+  kin_mem = (KINMem) kinmem;
+
+  /* the vector and matrix operations record into the active profiler */
+
+  prev = SUNProfiler_SetActive(kin_mem->kin_profiler);
+  SUNDIALS_MARK_FUNCTION_BEGIN(kin_mem->kin_profiler);
+  OMS_TRACE_BEGIN("kinsol", "KINSol");
+
+  ret = KINSolve(kin_mem, u, strategy_in, u_scale, f_scale);
+
+  OMS_TRACE_END("kinsol", "KINSol");
+  SUNDIALS_MARK_FUNCTION_END(kin_mem->kin_profiler);
+  SUNProfiler_SetActive(prev);
+
+  return(ret);
+}
+
+static int KINSolve(KINMem kin_mem, N_Vector u, int strategy_in,
+                    N_Vector u_scale, N_Vector f_scale)
+{
+  realtype fnormp, f1normp, epsmin, fmax=ZERO;
   int ret, sflag;
   booleantype maxStepTaken;
 
@@ -419,14 +471,6 @@ int KINSol(void *kinmem, N_Vector u, int strategy_in,
 
   epsmin = ZERO;
 
-  /* check for kinmem non-NULL */
-
-  if (kinmem == NULL) {
-    KINProcessError(NULL, KIN_MEM_NULL, "KINSOL", "KINSol", MSG_NO_MEM);
-    return(KIN_MEM_NULL);
-  }
-  kin_mem = (KINMem) kinmem;
-
   if(kin_mem->kin_MallocDone == SUNFALSE) {
     KINProcessError(NULL, KIN_NO_MALLOC, "KINSOL", "KINSol", MSG_NO_MALLOC);
     return(KIN_NO_MALLOC);
@@ -459,6 +503,8 @@ int KINSol(void *kinmem, N_Vector u, int strategy_in,
     kin_mem->kin_nfe = kin_mem->kin_nnilset = kin_mem->kin_nnilset_sub = kin_mem->kin_nni = kin_mem->kin_nbcf = kin_mem->kin_nbktrk = 0;
     ret = KINFP(kin_mem);
 
+    KINWarmStartUpdate(kin_mem, ret);
+
     switch(ret) {
     case KIN_SYSFUNC_FAIL:
       KINProcessError(kin_mem, KIN_SYSFUNC_FAIL, "KINSOL", "KINSol", MSG_SYSFUNC_FAILED);
@@ -484,6 +530,15 @@ int KINSol(void *kinmem, N_Vector u, int strategy_in,
   if (kin_mem->kin_noInitSetup) kin_mem->kin_sthrsh = ONE;
   else                          kin_mem->kin_sthrsh = TWO;
 
+  /* In warm start mode the setup data of an earlier call is reused until
+     it is msbset nonlinear iterations old, counting the iterations of the
+     earlier calls */
+
+  if (kin_mem->kin_warmstart && kin_mem->kin_lsetupok) {
+    kin_mem->kin_sthrsh = ONE;
+    kin_mem->kin_nnilset = kin_mem->kin_nnilset_sub = -kin_mem->kin_lsetupage;
+  }
+
   /* if eps is to be bounded from below, set the bound */
 
   if (kin_mem->kin_inexact_ls && !(kin_mem->kin_noMinEps))
@@ -514,6 +569,8 @@ int KINSol(void *kinmem, N_Vector u, int strategy_in,
     }
     ret = KINPicardAA(kin_mem, &(kin_mem->kin_nni), kin_mem->kin_R_aa, kin_mem->kin_gamma_aa, &fmax);
 
+    KINWarmStartUpdate(kin_mem, ret);
+
     return(ret);
   }
 
@@ -611,7 +668,7 @@ int KINSol(void *kinmem, N_Vector u, int strategy_in,
 
   }  /* end of loop; return */
 
-
+  KINWarmStartUpdate(kin_mem, ret);
 
   if (kin_mem->kin_printfl > 0)
     KINPrintInfo(kin_mem, PRNT_RETVAL, "KINSOL", "KINSol", INFO_RETVAL, ret);
@@ -1339,8 +1396,11 @@ static int KINLinSolDrv(KINMem kin_mem)
     kin_mem->kin_jacCurrent = SUNFALSE;
 
     if ((kin_mem->kin_sthrsh > ONEPT5) && (kin_mem->kin_lsetup != NULL)) {
+      SUNDIALS_MARK_BEGIN(kin_mem->kin_profiler, "kinLsSetup");
       retval = kin_mem->kin_lsetup(kin_mem);
+      SUNDIALS_MARK_END(kin_mem->kin_profiler, "kinLsSetup");
       kin_mem->kin_jacCurrent = SUNTRUE;
+      kin_mem->kin_lsetupok = (retval == 0);
       kin_mem->kin_nnilset = kin_mem->kin_nni;
       kin_mem->kin_nnilset_sub = kin_mem->kin_nni;
       if (retval != 0) return(KIN_LSETUP_FAIL);
@@ -1357,8 +1417,10 @@ static int KINLinSolDrv(KINMem kin_mem)
 
     /* call the generic 'lsolve' routine to solve the system Jx = b */
 
+    SUNDIALS_MARK_BEGIN(kin_mem->kin_profiler, "kinLsSolve");
     retval = kin_mem->kin_lsolve(kin_mem, x, b, &(kin_mem->kin_sJpnorm),
                                  &(kin_mem->kin_sFdotJp));
+    SUNDIALS_MARK_END(kin_mem->kin_profiler, "kinLsSolve");
 
     if (retval == 0)                          return(KIN_SUCCESS);
     else if (retval < 0)                      return(KIN_LSOLVE_FAIL);
@@ -2338,7 +2400,8 @@ static int KINPicardAA(KINMem kin_mem, long int *iterp, realtype *R,
     }
     else {  /* use Anderson, if desired */
       N_VScale(ONE, kin_mem->kin_uu, kin_mem->kin_unew);
-      AndersonAcc(kin_mem, gval, delta, kin_mem->kin_unew, kin_mem->kin_uu, iter-1, R, gamma);
+      AndersonAcc(kin_mem, gval, delta, kin_mem->kin_unew, kin_mem->kin_uu,
+                  kin_mem->kin_iter_aa + iter-1, (iter > 1), R, gamma);
     }
 
     /* Fill the Newton residual based on the new solution iterate */
@@ -2418,8 +2481,11 @@ static int KINPicardFcnEval(KINMem kin_mem, N_Vector gval, N_Vector uval, N_Vect
     kin_mem->kin_jacCurrent = SUNFALSE;
 
     if ((kin_mem->kin_sthrsh > ONEPT5) && (kin_mem->kin_lsetup != NULL)) {
+      SUNDIALS_MARK_BEGIN(kin_mem->kin_profiler, "kinLsSetup");
       retval = kin_mem->kin_lsetup(kin_mem);
+      SUNDIALS_MARK_END(kin_mem->kin_profiler, "kinLsSetup");
       kin_mem->kin_jacCurrent = SUNTRUE;
+      kin_mem->kin_lsetupok = (retval == 0);
       kin_mem->kin_nnilset = kin_mem->kin_nni;
       kin_mem->kin_nnilset_sub = kin_mem->kin_nni;
       if (retval != 0) return(KIN_LSETUP_FAIL);
@@ -2428,8 +2494,10 @@ static int KINPicardFcnEval(KINMem kin_mem, N_Vector gval, N_Vector uval, N_Vect
     /* call the generic 'lsolve' routine to solve the system Lx = -fval
        Note that we are using gval to hold x. */
     N_VScale(-ONE, fval1, fval1);
+    SUNDIALS_MARK_BEGIN(kin_mem->kin_profiler, "kinLsSolve");
     retval = kin_mem->kin_lsolve(kin_mem, gval, fval1, &(kin_mem->kin_sJpnorm),
                                  &(kin_mem->kin_sFdotJp));
+    SUNDIALS_MARK_END(kin_mem->kin_profiler, "kinLsSolve");
 
     if (retval == 0) {
       /* Update gval = uval + gval since gval = -L^{-1}F(uu)  */
@@ -2491,7 +2559,8 @@ static int KINFP(KINMem kin_mem)
     } else {
       /* apply Anderson acceleration */
       AndersonAcc(kin_mem, kin_mem->kin_fval, delta, kin_mem->kin_unew,
-                  kin_mem->kin_uu, kin_mem->kin_nni - 1, kin_mem->kin_R_aa,
+                  kin_mem->kin_uu, kin_mem->kin_iter_aa + kin_mem->kin_nni - 1,
+                  (kin_mem->kin_nni > 1), kin_mem->kin_R_aa,
                   kin_mem->kin_gamma_aa);
     }
 
@@ -2542,6 +2611,30 @@ static int KINFP(KINMem kin_mem)
  */
 
 
+/*
+ * KINWarmStartUpdate
+ *
+ * This routine is called at the end of KINSol. In warm start mode it
+ * records the age of the linear solver setup data and appends the
+ * iterations of this call to the kept Anderson acceleration history.
+ * After a failure, or without warm start, nothing is kept for the next
+ * call.
+ */
+
+static void KINWarmStartUpdate(KINMem kin_mem, int ret)
+{
+  if (kin_mem->kin_warmstart && (ret >= 0)) {
+    kin_mem->kin_lsetupage = kin_mem->kin_nni - kin_mem->kin_nnilset;
+    if ( (kin_mem->kin_m_aa > 0) &&
+         ( (kin_mem->kin_globalstrategy == KIN_PICARD) ||
+           (kin_mem->kin_globalstrategy == KIN_FP) ) )
+      kin_mem->kin_iter_aa += kin_mem->kin_nni - 1;
+  } else {
+    kin_mem->kin_lsetupok = SUNFALSE;
+    kin_mem->kin_iter_aa = 0;
+  }
+}
+
 /*
  * ========================================================================
  * Anderson Acceleration
@@ -2550,12 +2643,12 @@ static int KINFP(KINMem kin_mem)
 
 static int AndersonAcc(KINMem kin_mem, N_Vector gval, N_Vector fv,
                        N_Vector x, N_Vector xold,
-                       long int iter, realtype *R, realtype *gamma)
+                       long int iter, booleantype addcol,
+                       realtype *R, realtype *gamma)
 {
   int retval;
   long int i_pt, i, j, lAA;
   long int *ipt_map;
-  realtype alfa;
   realtype onembeta;
   realtype a, b, temp, c, s;
 
@@ -2567,7 +2660,7 @@ static int AndersonAcc(KINMem kin_mem, N_Vector gval, N_Vector fv,
   ipt_map = kin_mem->kin_ipt_map;
   i_pt = iter-1 - ((iter-1) / kin_mem->kin_m_aa) * kin_mem->kin_m_aa;
   N_VLinearSum(ONE, gval, -ONE, xold, fv);
-  if (iter > 0) {
+  if ((iter > 0) && addcol) {
     /* compute dg_new = gval - gval_old */
     N_VLinearSum(ONE, gval, -ONE, kin_mem->kin_gold_aa, kin_mem->kin_dg_aa[i_pt]);
     /* compute df_new = fval - fval_old */
@@ -2583,28 +2676,23 @@ static int AndersonAcc(KINMem kin_mem, N_Vector gval, N_Vector fv,
     return(0);
   }
 
-  /* update data structures based on current iteration index */
+  /* update data structures based on current iteration index, on the first
+     iteration of a warm started call to KINSol the kept history is used
+     as is, since gold and fold belong to the previous system */
 
-  if (iter == 1) {
+  if (!addcol) {
 
-    /* second iteration */
-    R[0] = SUNRsqrt(N_VDotProd(kin_mem->kin_df_aa[i_pt], kin_mem->kin_df_aa[i_pt]));
-    alfa = ONE/R[0];
-    N_VScale(alfa, kin_mem->kin_df_aa[i_pt], kin_mem->kin_q_aa[i_pt]);
-    ipt_map[0] = 0;
+    /* nothing to add */
 
   } else if (iter <= kin_mem->kin_m_aa) {
 
     /* another iteration before we've reached maa */
-    N_VScale(ONE, kin_mem->kin_df_aa[i_pt], kin_mem->kin_vtemp2);
-    for (j=0; j < (iter-1); j++) {
+    for (j=0; j < iter; j++)
       ipt_map[j] = j;
-      R[(iter-1)*kin_mem->kin_m_aa+j] = N_VDotProd(kin_mem->kin_q_aa[j], kin_mem->kin_vtemp2);
-      N_VLinearSum(ONE,kin_mem->kin_vtemp2, -R[(iter-1)*kin_mem->kin_m_aa+j], kin_mem->kin_q_aa[j], kin_mem->kin_vtemp2);
-    }
-    R[(iter-1)*kin_mem->kin_m_aa+iter-1] = SUNRsqrt(N_VDotProd(kin_mem->kin_vtemp2, kin_mem->kin_vtemp2));
-    N_VScale((1/R[(iter-1)*kin_mem->kin_m_aa+iter-1]), kin_mem->kin_vtemp2, kin_mem->kin_q_aa[i_pt]);
-    ipt_map[iter-1] = iter-1;
+    retval = kin_mem->kin_qradd_aa(kin_mem->kin_q_aa, R,
+                                   kin_mem->kin_df_aa[i_pt], (int) (iter-1),
+                                   (int) kin_mem->kin_m_aa, cv, Xv);
+    if (retval != 0) return(KIN_VECTOROP_ERR);
 
   } else {
 
@@ -2642,13 +2730,11 @@ static int AndersonAcc(KINMem kin_mem, N_Vector gval, N_Vector fv,
     }
 
     /* Add the new df vector */
-    N_VScale(ONE, kin_mem->kin_df_aa[i_pt], kin_mem->kin_vtemp2);
-    for (j=0; j < (kin_mem->kin_m_aa-1); j++) {
-      R[(kin_mem->kin_m_aa-1)*kin_mem->kin_m_aa+j] = N_VDotProd(kin_mem->kin_q_aa[j], kin_mem->kin_vtemp2);
-      N_VLinearSum(ONE, kin_mem->kin_vtemp2, -R[(kin_mem->kin_m_aa-1)*kin_mem->kin_m_aa+j], kin_mem->kin_q_aa[j],kin_mem->kin_vtemp2);
-    }
-    R[(kin_mem->kin_m_aa-1)*kin_mem->kin_m_aa+kin_mem->kin_m_aa-1] = SUNRsqrt(N_VDotProd(kin_mem->kin_vtemp2, kin_mem->kin_vtemp2));
-    N_VScale((1/R[(kin_mem->kin_m_aa-1)*kin_mem->kin_m_aa+kin_mem->kin_m_aa-1]), kin_mem->kin_vtemp2, kin_mem->kin_q_aa[kin_mem->kin_m_aa-1]);
+    retval = kin_mem->kin_qradd_aa(kin_mem->kin_q_aa, R,
+                                   kin_mem->kin_df_aa[i_pt],
+                                   (int) (kin_mem->kin_m_aa-1),
+                                   (int) kin_mem->kin_m_aa, cv, Xv);
+    if (retval != 0) return(KIN_VECTOROP_ERR);
 
     /* Update the iteration map */
     j = 0;
@@ -2674,7 +2760,11 @@ static int AndersonAcc(KINMem kin_mem, N_Vector gval, N_Vector fv,
     for (j=i+1; j < lAA; j++) {
       gamma[i] = gamma[i]-R[j*kin_mem->kin_m_aa+i]*gamma[j];
     }
-    gamma[i] = gamma[i]/R[i*kin_mem->kin_m_aa+i];
+    if (R[i*kin_mem->kin_m_aa+i] == ZERO) {
+      gamma[i] = ZERO;
+    } else {
+      gamma[i] = gamma[i]/R[i*kin_mem->kin_m_aa+i];
+    }
 
     cv[nvec] = -gamma[i];
     Xv[nvec] = kin_mem->kin_dg_aa[ipt_map[i]];
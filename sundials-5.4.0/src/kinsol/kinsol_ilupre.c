@@ -0,0 +1,416 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This file contains implementations of routines for an incomplete
+ * LU preconditioner for use with KINSol and the KINLS linear solver
+ * interface.
+ * -----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "kinsol_impl.h"
+#include "kinsol_ls_impl.h"
+#include "kinsol_ilupre_impl.h"
+
+#include <sundials/sundials_math.h>
+
+/* Prototypes of functions KINILUPrecSetup and KINILUPrecSolve */
+static int KINILUPrecSetup(N_Vector uu, N_Vector uscale,
+                           N_Vector fval, N_Vector fscale,
+                           void *ip_data);
+static int KINILUPrecSolve(N_Vector uu, N_Vector uscale,
+                           N_Vector fval, N_Vector fscale,
+                           N_Vector vv, void *ip_data);
+
+/* Prototype for KINILUPrecFree */
+static int KINILUPrecFree(KINMem kin_mem);
+
+/* Access to the preconditioner data */
+static int kinILUPrec_AccessPData(void *kinmem, const char *fname,
+                                  KINMem *kin_mem, KILUPrecData *pdata);
+
+
+/*
+ *-----------------------------------------------------------------
+ * user-callable functions
+ *-----------------------------------------------------------------
+ */
+
+/*------------------------------------------------------------------
+  KINILUPrecInit
+  ------------------------------------------------------------------*/
+int KINILUPrecInit(void *kinmem, SUNMatrix J, KINLsJacFn jac,
+                   int ilutype)
+{
+  KINMem kin_mem;
+  KINLsMem kinls_mem;
+  KILUPrecData pdata;
+  sunindextype N;
+  int flag;
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KINLS_MEM_NULL, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_MEM_NULL);
+    return(KINLS_MEM_NULL);
+  }
+  kin_mem = (KINMem) kinmem;
+
+  /* Test if the LS linear solver interface has been created */
+  if (kin_mem->kin_lmem == NULL) {
+    KINProcessError(kin_mem, KINLS_LMEM_NULL, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_LMEM_NULL);
+    return(KINLS_LMEM_NULL);
+  }
+  kinls_mem = (KINLsMem) kin_mem->kin_lmem;
+
+  /* Test compatibility of NVECTOR package with the ILU preconditioner */
+  if (kin_mem->kin_vtemp1->ops->nvgetarraypointer == NULL) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_BAD_NVECTOR);
+    return(KINLS_ILL_INPUT);
+  }
+
+  /* Test the template matrix, the Jacobian routine and the
+     factorization type */
+  if ( (J == NULL) || (J->ops->getid == NULL) ||
+       (SUNMatGetID(J) != SUNMATRIX_SPARSE) ||
+       (SUNSparseMatrix_Rows(J) != SUNSparseMatrix_Columns(J)) ||
+       (SUNSparseMatrix_Rows(J) != N_VGetLength(kin_mem->kin_vtemp1)) ) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_BAD_MATRIX);
+    return(KINLS_ILL_INPUT);
+  }
+  if (jac == NULL) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_NO_JAC);
+    return(KINLS_ILL_INPUT);
+  }
+  if ((ilutype != SUNILU_ILU0) && (ilutype != SUNILU_ILUT)) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_BAD_TYPE);
+    return(KINLS_ILL_INPUT);
+  }
+  N = SUNSparseMatrix_Rows(J);
+
+  /* allocate data memory */
+  pdata = NULL;
+  pdata = (KILUPrecData) calloc(1, sizeof *pdata);
+  if (pdata == NULL) {
+    KINProcessError(kin_mem, KINLS_MEM_FAIL, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_MEM_FAIL);
+    return(KINLS_MEM_FAIL);
+  }
+
+  /* set pointers in pdata */
+  pdata->kin_mem = kinmem;
+  pdata->jac = jac;
+  pdata->njeIP = 0;
+
+  /* allocate memory for the preconditioner matrix, the factorization
+     and temporary N_Vectors */
+  pdata->savedP = SUNMatClone(J);
+  pdata->ilu    = SUNILUCreate(ilutype, N);
+  pdata->tempv1 = N_VClone(kin_mem->kin_vtemp1);
+  pdata->tempv2 = N_VClone(kin_mem->kin_vtemp1);
+  if ( (pdata->savedP == NULL) || (pdata->ilu == NULL) ||
+       (pdata->tempv1 == NULL) || (pdata->tempv2 == NULL) ) {
+    if (pdata->savedP) SUNMatDestroy(pdata->savedP);
+    SUNILUFree(pdata->ilu);
+    if (pdata->tempv1) N_VDestroy(pdata->tempv1);
+    if (pdata->tempv2) N_VDestroy(pdata->tempv2);
+    free(pdata); pdata = NULL;
+    KINProcessError(kin_mem, KINLS_MEM_FAIL, "KINILUPRE",
+                    "KINILUPrecInit", MSGIP_MEM_FAIL);
+    return(KINLS_MEM_FAIL);
+  }
+
+  /* make sure pdata is free from any previous allocations */
+  if (kinls_mem->pfree != NULL)
+    kinls_mem->pfree(kin_mem);
+
+  /* Point to the new pdata field in the LS memory */
+  kinls_mem->pdata = pdata;
+
+  /* Attach the pfree function */
+  kinls_mem->pfree = KINILUPrecFree;
+
+  /* Attach preconditioner solve and setup functions */
+  flag = KINSetPreconditioner(kinmem, KINILUPrecSetup,
+                              KINILUPrecSolve);
+
+  return(flag);
+}
+
+
+/*------------------------------------------------------------------
+  KINILUPrecSetThresholds
+  ------------------------------------------------------------------*/
+int KINILUPrecSetThresholds(void *kinmem, realtype droptol,
+                            sunindextype lfil)
+{
+  KINMem kin_mem;
+  KILUPrecData pdata;
+  int retval;
+
+  retval = kinILUPrec_AccessPData(kinmem, "KINILUPrecSetThresholds",
+                                  &kin_mem, &pdata);
+  if (retval != KINLS_SUCCESS) return(retval);
+
+  if (SUNILUSetThresholds(pdata->ilu, droptol, lfil) != SUNILU_SUCCESS) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINILUPRE",
+                    "KINILUPrecSetThresholds", MSGIP_BAD_INPUT);
+    return(KINLS_ILL_INPUT);
+  }
+
+  return(KINLS_SUCCESS);
+}
+
+
+/*------------------------------------------------------------------
+  KINILUPrecSetNumThreads
+  ------------------------------------------------------------------*/
+int KINILUPrecSetNumThreads(void *kinmem, int nthreads)
+{
+  KINMem kin_mem;
+  KILUPrecData pdata;
+  int retval;
+
+  retval = kinILUPrec_AccessPData(kinmem, "KINILUPrecSetNumThreads",
+                                  &kin_mem, &pdata);
+  if (retval != KINLS_SUCCESS) return(retval);
+
+  if (SUNILUSetNumThreads(pdata->ilu, nthreads) != SUNILU_SUCCESS) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINILUPRE",
+                    "KINILUPrecSetNumThreads", MSGIP_BAD_INPUT);
+    return(KINLS_ILL_INPUT);
+  }
+
+  return(KINLS_SUCCESS);
+}
+
+
+/*------------------------------------------------------------------
+  KINILUPrecGetWorkSpace
+  ------------------------------------------------------------------*/
+int KINILUPrecGetWorkSpace(void *kinmem, long int *lenrwIP,
+                           long int *leniwIP)
+{
+  KINMem kin_mem;
+  KILUPrecData pdata;
+  sunindextype lrw1, liw1;
+  long int lrw, liw;
+  int retval;
+
+  retval = kinILUPrec_AccessPData(kinmem, "KINILUPrecGetWorkSpace",
+                                  &kin_mem, &pdata);
+  if (retval != KINLS_SUCCESS) return(retval);
+
+  *leniwIP = 4;
+  *lenrwIP = 0;
+  if (kin_mem->kin_vtemp1->ops->nvspace) {
+    N_VSpace(kin_mem->kin_vtemp1, &lrw1, &liw1);
+    *leniwIP += 2*liw1;
+    *lenrwIP += 2*lrw1;
+  }
+  if (pdata->savedP->ops->space) {
+    retval = SUNMatSpace(pdata->savedP, &lrw, &liw);
+    if (retval != 0) return(-1);
+    *leniwIP += liw;
+    *lenrwIP += lrw;
+  }
+  SUNILUGetWorkSpace(pdata->ilu, &lrw, &liw);
+  *leniwIP += liw;
+  *lenrwIP += lrw;
+
+  return(KINLS_SUCCESS);
+}
+
+
+/*------------------------------------------------------------------
+  KINILUPrecGetNumJacEvals
+  ------------------------------------------------------------------*/
+int KINILUPrecGetNumJacEvals(void *kinmem, long int *njevalsIP)
+{
+  KINMem kin_mem;
+  KILUPrecData pdata;
+  int retval;
+
+  retval = kinILUPrec_AccessPData(kinmem, "KINILUPrecGetNumJacEvals",
+                                  &kin_mem, &pdata);
+  if (retval != KINLS_SUCCESS) return(retval);
+
+  *njevalsIP = pdata->njeIP;
+
+  return(KINLS_SUCCESS);
+}
+
+
+/*------------------------------------------------------------------
+  KINILUPrecGetNumLevels
+  ------------------------------------------------------------------*/
+int KINILUPrecGetNumLevels(void *kinmem, sunindextype *nlevL,
+                           sunindextype *nlevU)
+{
+  KINMem kin_mem;
+  KILUPrecData pdata;
+  int retval;
+
+  retval = kinILUPrec_AccessPData(kinmem, "KINILUPrecGetNumLevels",
+                                  &kin_mem, &pdata);
+  if (retval != KINLS_SUCCESS) return(retval);
+
+  SUNILUGetNumLevels(pdata->ilu, nlevL, nlevU);
+
+  return(KINLS_SUCCESS);
+}
+
+
+/*
+ *-----------------------------------------------------------------
+ * KINILUPrecSetup
+ *-----------------------------------------------------------------
+ * KINILUPrecSetup evaluates the sparse Jacobian J(uu) with the
+ * user routine and computes its incomplete LU factors.
+ *
+ * The return value is 0 if successful, > 0 for a recoverable
+ * error, and < 0 for an unrecoverable error.
+ *-----------------------------------------------------------------
+ */
+static int KINILUPrecSetup(N_Vector uu, N_Vector uscale,
+                           N_Vector fval, N_Vector fscale,
+                           void *ip_data)
+{
+  KILUPrecData pdata;
+  KINMem kin_mem;
+  int retval;
+
+  pdata = (KILUPrecData) ip_data;
+  kin_mem = (KINMem) pdata->kin_mem;
+
+  /* call the Jacobian routine and store J in savedP */
+  retval = SUNMatZero(pdata->savedP);
+  if (retval) {
+    KINProcessError(kin_mem, -1, "KINILUPRE", "KINILUPrecSetup",
+                    MSGIP_SUNMAT_FAIL);
+    return(-1);
+  }
+
+  pdata->njeIP++;
+  retval = pdata->jac(uu, fval, pdata->savedP, kin_mem->kin_user_data,
+                      pdata->tempv1, pdata->tempv2);
+  if (retval < 0) {
+    KINProcessError(kin_mem, -1, "KINILUPRE", "KINILUPrecSetup",
+                    MSGIP_JACFUNC_FAILED);
+    return(-1);
+  }
+  if (retval > 0) {
+    return(1);
+  }
+
+  /* compute the incomplete factors */
+  retval = SUNILUFactor(pdata->ilu, pdata->savedP);
+  if (retval != SUNILU_SUCCESS) {
+    KINProcessError(kin_mem, -1, "KINILUPRE", "KINILUPrecSetup",
+                    MSGIP_ILU_FAIL);
+    return(-1);
+  }
+
+  return(0);
+}
+
+
+/*
+ *-----------------------------------------------------------------
+ * KINILUPrecSolve
+ *-----------------------------------------------------------------
+ * KINILUPrecSolve solves a linear system P z = r, with the
+ * incomplete LU factors computed by KINILUPrecSetup. The
+ * right-hand side r is passed in vv and overwritten by z.
+ *-----------------------------------------------------------------
+ */
+static int KINILUPrecSolve(N_Vector uu, N_Vector uscale,
+                           N_Vector fval, N_Vector fscale,
+                           N_Vector vv, void *ip_data)
+{
+  KILUPrecData pdata;
+
+  pdata = (KILUPrecData) ip_data;
+
+  if (SUNILUSolve(pdata->ilu, vv, vv) != SUNILU_SUCCESS) return(-1);
+  return(0);
+}
+
+
+/*
+ *-----------------------------------------------------------------
+ * KINILUPrecFree
+ *-----------------------------------------------------------------
+ */
+static int KINILUPrecFree(KINMem kin_mem)
+{
+  KINLsMem kinls_mem;
+  KILUPrecData pdata;
+
+  if (kin_mem->kin_lmem == NULL) return(0);
+  kinls_mem = (KINLsMem) kin_mem->kin_lmem;
+
+  if (kinls_mem->pdata == NULL) return(0);
+  pdata = (KILUPrecData) kinls_mem->pdata;
+
+  SUNILUFree(pdata->ilu);
+  SUNMatDestroy(pdata->savedP);
+  N_VDestroy(pdata->tempv1);
+  N_VDestroy(pdata->tempv2);
+
+  free(pdata);
+  pdata = NULL;
+
+  return(0);
+}
+
+
+/*
+ *-----------------------------------------------------------------
+ * kinILUPrec_AccessPData
+ *-----------------------------------------------------------------
+ * Shortcut routine to unpack the kin_mem and preconditioner data
+ * structures. Returns KINLS_SUCCESS or a KINLS error flag.
+ *-----------------------------------------------------------------
+ */
+static int kinILUPrec_AccessPData(void *kinmem, const char *fname,
+                                  KINMem *kin_mem, KILUPrecData *pdata)
+{
+  KINLsMem kinls_mem;
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KINLS_MEM_NULL, "KINILUPRE", fname,
+                    MSGIP_MEM_NULL);
+    return(KINLS_MEM_NULL);
+  }
+  *kin_mem = (KINMem) kinmem;
+
+  if ((*kin_mem)->kin_lmem == NULL) {
+    KINProcessError(*kin_mem, KINLS_LMEM_NULL, "KINILUPRE", fname,
+                    MSGIP_LMEM_NULL);
+    return(KINLS_LMEM_NULL);
+  }
+  kinls_mem = (KINLsMem) (*kin_mem)->kin_lmem;
+
+  if ( (kinls_mem->pdata == NULL) || (kinls_mem->pfree != KINILUPrecFree) ) {
+    KINProcessError(*kin_mem, KINLS_PMEM_NULL, "KINILUPRE", fname,
+                    MSGIP_PMEM_NULL);
+    return(KINLS_PMEM_NULL);
+  }
+  *pdata = (KILUPrecData) kinls_mem->pdata;
+
+  return(KINLS_SUCCESS);
+}
@@ -23,6 +23,7 @@
 #include <stdarg.h>
 
 #include <kinsol/kinsol.h>
+#include <sundials/sundials_iterative.h>
 
 #ifdef __cplusplus  /* wrapper to enable C++ usage */
 extern "C" {
@@ -65,6 +66,7 @@ typedef struct KINMemRec {
 
   KINSysFn kin_func;           /* nonlinear system function implementation     */
   void *kin_user_data;         /* work space available to func routine         */
+  SUNProfiler kin_profiler;    /* timers of KINSol, its solvers and the ops    */
   realtype kin_fnormtol;       /* stopping tolerance on L2-norm of function
                                   value                                        */
   realtype kin_scsteptol;      /* scaled step length tolerance                 */
@@ -112,6 +114,14 @@ typedef struct KINMemRec {
   booleantype kin_noInitSetup; /* flag controlling whether or not the KINSol
                                   routine makes an initial call to the
                                   linear solver setup routine (lsetup)         */
+  booleantype kin_warmstart;   /* keep the linear solver setup data and the
+                                  Anderson acceleration history between
+                                  calls to KINSol                              */
+  booleantype kin_lsetupok;    /* the last call to lsetup succeeded            */
+  long int kin_lsetupage;      /* nonlinear iterations done by earlier calls
+                                  to KINSol since the last call to lsetup      */
+  long int kin_iter_aa;        /* Anderson acceleration iteration the kept
+                                  history ends at                              */
   realtype kin_sthrsh;         /* threshold value for calling the linear
                                   solver setup routine                         */
 
@@ -164,6 +174,7 @@ typedef struct KINMemRec {
   booleantype kin_aamem_aa; /* sets additional memory needed for Anderson Acc */
   booleantype kin_setstop_aa; /* determines whether user will set stopping criterion */
   booleantype kin_damping_aa; /* flag to apply damping in AA */
+  QRAddFn kin_qradd_aa;     /* QR update used in AA */
   realtype *kin_cv;         /* scalar array for fused vector operations */
   N_Vector *kin_Xv;         /* vector array for fused vector operations */
 
@@ -392,6 +403,7 @@ void KINInfoHandler(const char *module, const char *function,
 
 #define MSG_BAD_PRINTFL        "Illegal value for printfl."
 #define MSG_BAD_MXITER         "Illegal value for mxiter."
+#define MSG_BAD_ORTHAA         "Illegal value for orthaa."
 #define MSG_BAD_MSBSET         "Illegal msbset < 0."
 #define MSG_BAD_MSBSETSUB      "Illegal msbsetsub < 0."
 #define MSG_BAD_ETACHOICE      "Illegal value for etachoice."
@@ -246,6 +246,42 @@ int KINSetDampingAA(void *kinmem, realtype beta)
   return(KIN_SUCCESS);
 }
 
+/*
+ * -----------------------------------------------------------------
+ * Function : KINSetOrthAA
+ * -----------------------------------------------------------------
+ */
+
+int KINSetOrthAA(void *kinmem, int orthaa)
+{
+  KINMem kin_mem;
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KIN_MEM_NULL, "KINSOL", "KINSetOrthAA", MSG_NO_MEM);
+    return(KIN_MEM_NULL);
+  }
+
+  kin_mem = (KINMem) kinmem;
+
+  switch (orthaa) {
+  case KIN_ORTH_MGS:
+    kin_mem->kin_qradd_aa = QRAddMGS;
+    break;
+  case KIN_ORTH_CGS2:
+    kin_mem->kin_qradd_aa = QRAddCGS2;
+    break;
+  case KIN_ORTH_DCGS2:
+    kin_mem->kin_qradd_aa = QRAddDCGS2;
+    break;
+  default:
+    KINProcessError(NULL, KIN_ILL_INPUT, "KINSOL", "KINSetOrthAA",
+                    MSG_BAD_ORTHAA);
+    return(KIN_ILL_INPUT);
+  }
+
+  return(KIN_SUCCESS);
+}
+
 /*
  * -----------------------------------------------------------------
  * Function : KINSetAAStopCrit
@@ -321,6 +357,54 @@ int KINSetNoInitSetup(void *kinmem, booleantype noInitSetup)
   return(KIN_SUCCESS);
 }
 
+/*
+ * -----------------------------------------------------------------
+ * Function : KINSetWarmStart
+ * -----------------------------------------------------------------
+ */
+
+int KINSetWarmStart(void *kinmem, booleantype warmstart)
+{
+  KINMem kin_mem;
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KIN_MEM_NULL, "KINSOL", "KINSetWarmStart", MSG_NO_MEM);
+    return(KIN_MEM_NULL);
+  }
+
+  kin_mem = (KINMem) kinmem;
+  kin_mem->kin_warmstart = warmstart;
+
+  if (!warmstart) {
+    kin_mem->kin_lsetupok = SUNFALSE;
+    kin_mem->kin_iter_aa = 0;
+  }
+
+  return(KIN_SUCCESS);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Function : KINResetWarmStart
+ * -----------------------------------------------------------------
+ */
+
+int KINResetWarmStart(void *kinmem)
+{
+  KINMem kin_mem;
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KIN_MEM_NULL, "KINSOL", "KINResetWarmStart", MSG_NO_MEM);
+    return(KIN_MEM_NULL);
+  }
+
+  kin_mem = (KINMem) kinmem;
+  kin_mem->kin_lsetupok = SUNFALSE;
+  kin_mem->kin_iter_aa = 0;
+
+  return(KIN_SUCCESS);
+}
+
 /*
  * -----------------------------------------------------------------
  * Function : KINSetNoResMon
@@ -821,6 +905,27 @@ int KINSetConstraints(void *kinmem, N_Vector constraints)
   return(KIN_SUCCESS);
 }
 
+/*
+ * -----------------------------------------------------------------
+ * Function : KINSetProfiler
+ * -----------------------------------------------------------------
+ */
+
+int KINSetProfiler(void *kinmem, SUNProfiler profiler)
+{
+  KINMem kin_mem;
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KIN_MEM_NULL, "KINSOL", "KINSetProfiler", MSG_NO_MEM);
+    return(KIN_MEM_NULL);
+  }
+
+  kin_mem = (KINMem) kinmem;
+  kin_mem->kin_profiler = profiler;
+
+  return(KIN_SUCCESS);
+}
+
 /*
  * -----------------------------------------------------------------
  * Function : KINSetSysFunc
@@ -1004,6 +1109,27 @@ int KINGetStepLength(void *kinmem, realtype *steplength)
   return(KIN_SUCCESS);
 }
 
+/*
+ * -----------------------------------------------------------------
+ * Function : KINGetProfiler
+ * -----------------------------------------------------------------
+ */
+
+int KINGetProfiler(void *kinmem, SUNProfiler *profiler)
+{
+  KINMem kin_mem;
+
+  if (kinmem == NULL) {
+    KINProcessError(NULL, KIN_MEM_NULL, "KINSOL", "KINGetProfiler", MSG_NO_MEM);
+    return(KIN_MEM_NULL);
+  }
+
+  kin_mem = (KINMem) kinmem;
+  *profiler = kin_mem->kin_profiler;
+
+  return(KIN_SUCCESS);
+}
+
 /*
  * -----------------------------------------------------------------
  * Function : KINGetReturnFlagName
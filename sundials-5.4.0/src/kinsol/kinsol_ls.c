@@ -118,6 +118,7 @@ int KINSetLinearSolver(void *kinmem, SUNLinearSolver LS, SUNMatrix A)
 
   /* free any existing system solver attached to KIN */
   if (kin_mem->kin_lfree) kin_mem->kin_lfree(kin_mem);
+  kin_mem->kin_lsetupok = SUNFALSE;
 
   /* Determine if this is an iterative linear solver */
   kin_mem->kin_inexact_ls = iterative;
@@ -244,6 +245,57 @@ int KINSetJacFn(void *kinmem, KINLsJacFn jac)
 }
 
 
+/*------------------------------------------------------------------
+  KINSetJacDQContexts sets ncontexts user data pointers for the
+  dense difference quotient Jacobian. The columns are computed
+  concurrently, each context is used by one thread at a time, so
+  func must be safe to call at the same time with different
+  contexts. ncontexts = 0 turns this off again.
+  ------------------------------------------------------------------*/
+int KINSetJacDQContexts(void *kinmem, int ncontexts, void **contexts)
+{
+  KINMem   kin_mem;
+  KINLsMem kinls_mem;
+  int      retval, k;
+
+  /* access KINLsMem structure */
+  retval = kinLs_AccessLMem(kinmem, "KINSetJacDQContexts",
+                            &kin_mem, &kinls_mem);
+  if (retval != KIN_SUCCESS)  return(retval);
+
+  if ((ncontexts < 0) || ((ncontexts > 0) && (contexts == NULL))) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINLS", "KINSetJacDQContexts",
+                    "Invalid number of contexts or NULL contexts");
+    return(KINLS_ILL_INPUT);
+  }
+
+  if ((ncontexts > 0) && (kinls_mem->J == NULL)) {
+    KINProcessError(kin_mem, KINLS_ILL_INPUT, "KINLS", "KINSetJacDQContexts",
+                    "Jacobian contexts cannot be supplied for NULL SUNMatrix");
+    return(KINLS_ILL_INPUT);
+  }
+
+  kinLsFreeDQContexts(kinls_mem);
+  if (ncontexts == 0) return(KINLS_SUCCESS);
+
+  kinls_mem->dqctx = (void **) malloc(ncontexts * sizeof(void *));
+  kinls_mem->dqu   = N_VCloneVectorArray(ncontexts, kin_mem->kin_vtemp1);
+  kinls_mem->dqf   = N_VCloneVectorArray(ncontexts, kin_mem->kin_vtemp1);
+  kinls_mem->ndqctx = ncontexts;
+  if ((kinls_mem->dqctx == NULL) || (kinls_mem->dqu == NULL) ||
+      (kinls_mem->dqf == NULL)) {
+    kinLsFreeDQContexts(kinls_mem);
+    KINProcessError(kin_mem, KINLS_MEM_FAIL, "KINLS", "KINSetJacDQContexts",
+                    MSG_LS_MEM_FAIL);
+    return(KINLS_MEM_FAIL);
+  }
+  for (k = 0; k < ncontexts; k++)
+    kinls_mem->dqctx[k] = contexts[k];
+
+  return(KINLS_SUCCESS);
+}
+
+
 /*------------------------------------------------------------------
   KINSetPreconditioner sets the preconditioner setup and solve
   functions
@@ -759,6 +811,10 @@ int kinLsDenseDQJac(N_Vector u, N_Vector fu, SUNMatrix Jac,
   /* access LsMem interface structure */
   kinls_mem = (KINLsMem) kin_mem->kin_lmem;
 
+  /* compute the columns concurrently if there are several contexts */
+  if (kinls_mem->ndqctx > 0)
+    return(kinLsDenseDQJacCtx(u, fu, Jac, kin_mem));
+
   /* access matrix dimension */
   N = SUNDenseMatrix_Columns(Jac);
 
@@ -810,6 +866,94 @@ int kinLsDenseDQJac(N_Vector u, N_Vector fu, SUNMatrix Jac,
 }
 
 
+/*------------------------------------------------------------------
+  kinLsDenseDQJacCtx
+
+  This routine computes the same dense difference quotient Jacobian
+  as kinLsDenseDQJac, with the columns distributed round-robin over
+  the function evaluation contexts set by KINSetJacDQContexts. With
+  OpenMP every context is handled by its own thread. If func fails
+  the first negative (unrecoverable) return value is returned,
+  otherwise the first positive one.
+  ------------------------------------------------------------------*/
+int kinLsDenseDQJacCtx(N_Vector u, N_Vector fu, SUNMatrix Jac,
+                       KINMem kin_mem)
+{
+  realtype inc, inc_inv, ujsaved, ujscale, sign;
+  realtype *u_data, *fu_data, *uscale_data, *uk_data, *fk_data, *col_j;
+  sunindextype i, j, N;
+  KINLsMem kinls_mem;
+  int k, K, retval, retmin, retmax;
+  long int nfe;
+
+  /* access LsMem interface structure */
+  kinls_mem = (KINLsMem) kin_mem->kin_lmem;
+
+  /* access matrix dimension and the number of contexts */
+  N = SUNDenseMatrix_Columns(Jac);
+  K = kinls_mem->ndqctx;
+
+  /* Obtain pointers to the data for u, fu and uscale */
+  u_data      = N_VGetArrayPointer(u);
+  fu_data     = N_VGetArrayPointer(fu);
+  uscale_data = N_VGetArrayPointer(kin_mem->kin_uscale);
+
+  retmin = retmax = 0;
+  nfe = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel for default(none) \
+  private(k,i,j,inc,inc_inv,ujsaved,ujscale,sign,uk_data,fk_data,col_j,retval) \
+  shared(N,K,u,u_data,fu_data,uscale_data,kin_mem,kinls_mem,Jac) \
+  reduction(min:retmin) reduction(max:retmax) reduction(+:nfe) \
+  schedule(static,1) num_threads(K)
+#endif
+  for (k = 0; k < K; k++) {
+
+    /* thread k works on a copy of u */
+    N_VScale(ONE, u, kinls_mem->dqu[k]);
+    uk_data = N_VGetArrayPointer(kinls_mem->dqu[k]);
+    fk_data = N_VGetArrayPointer(kinls_mem->dqf[k]);
+
+    for (j = k; j < N; j += K) {
+
+      /* Generate the jth col of J(u) */
+      col_j   = SUNDenseMatrix_Column(Jac,j);
+      ujsaved = u_data[j];
+      ujscale = ONE/uscale_data[j];
+
+      /* Compute increment */
+      sign = (ujsaved >= ZERO) ? ONE : -ONE;
+      inc = kin_mem->kin_sqrt_relfunc*SUNMAX(SUNRabs(ujsaved), ujscale)*sign;
+
+      /* Increment u_j, call F(u), and stop if an error occurs */
+      uk_data[j] += inc;
+
+      retval = kin_mem->kin_func(kinls_mem->dqu[k], kinls_mem->dqf[k],
+                                 kinls_mem->dqctx[k]);
+      nfe++;
+      if (retval != 0) {
+        retmin = SUNMIN(retmin, retval);
+        retmax = SUNMAX(retmax, retval);
+        break;
+      }
+
+      /* reset u_j */
+      uk_data[j] = ujsaved;
+
+      /* Construct difference quotient in col_j */
+      inc_inv = ONE/inc;
+      for (i = 0; i < N; i++)
+        col_j[i] = inc_inv * (fk_data[i] - fu_data[i]);
+    }
+  }
+
+  kinls_mem->nfeDQ += nfe;
+
+  return((retmin < 0) ? retmin : retmax);
+}
+
+
 /*------------------------------------------------------------------
   kinLsBandDQJac
 
@@ -1311,6 +1455,9 @@ int kinLsFree(KINMem kin_mem)
   /* Free preconditioner memory (if applicable) */
   if (kinls_mem->pfree) kinls_mem->pfree(kin_mem);
 
+  /* Free the DQ Jacobian contexts */
+  kinLsFreeDQContexts(kinls_mem);
+
   /* free KINLs interface structure */
   free(kin_mem->kin_lmem);
 
@@ -1334,6 +1481,26 @@ int kinLsInitializeCounters(KINLsMem kinls_mem)
 }
 
 
+/*---------------------------------------------------------------
+  kinLsFreeDQContexts
+
+  This routine frees the work vectors of the DQ Jacobian contexts.
+  ---------------------------------------------------------------*/
+void kinLsFreeDQContexts(KINLsMem kinls_mem)
+{
+  if (kinls_mem->dqu != NULL)
+    N_VDestroyVectorArray(kinls_mem->dqu, kinls_mem->ndqctx);
+  if (kinls_mem->dqf != NULL)
+    N_VDestroyVectorArray(kinls_mem->dqf, kinls_mem->ndqctx);
+  if (kinls_mem->dqctx != NULL)
+    free(kinls_mem->dqctx);
+  kinls_mem->dqctx  = NULL;
+  kinls_mem->dqu    = NULL;
+  kinls_mem->dqf    = NULL;
+  kinls_mem->ndqctx = 0;
+}
+
+
 /*---------------------------------------------------------------
   kinLs_AccessLMem
 
@@ -99,6 +99,14 @@ typedef struct KINLsMemRec {
   KINSysFn jt_func;
   void *jt_data;
 
+  /* Function evaluation contexts for the dense DQ Jacobian, the columns
+     are distributed over ndqctx threads, thread k calls func with
+     user data dqctx[k] and the work vectors dqu[k] and dqf[k] */
+  int ndqctx;
+  void **dqctx;
+  N_Vector *dqu;
+  N_Vector *dqf;
+
 } *KINLsMem;
 
 
@@ -123,6 +131,9 @@ int kinLsDQJac(N_Vector u, N_Vector fu, SUNMatrix Jac,
 int kinLsDenseDQJac(N_Vector u, N_Vector fu, SUNMatrix Jac,
                     KINMem kin_mem, N_Vector tmp1, N_Vector tmp2);
 
+int kinLsDenseDQJacCtx(N_Vector u, N_Vector fu, SUNMatrix Jac,
+                       KINMem kin_mem);
+
 int kinLsBandDQJac(N_Vector u, N_Vector fu, SUNMatrix Jac,
                    KINMem kin_mem, N_Vector tmp1, N_Vector tmp2);
 
@@ -135,6 +146,7 @@ int kinLsFree(KINMem kin_mem);
 
 /* Auxilliary functions */
 int kinLsInitializeCounters(KINLsMem kinls_mem);
+void kinLsFreeDQContexts(KINLsMem kinls_mem);
 int kinLs_AccessLMem(void* kinmem, const char *fname,
                      KINMem* kin_mem, KINLsMem *kinls_mem);
 
@@ -49,10 +49,43 @@
 #define MANYVECTOR_SUBVEC(v,i)    ( MANYVECTOR_SUBVECS(v)[i] )
 #define MANYVECTOR_OWN_DATA(v)    ( MANYVECTOR_CONTENT(v)->own_data )
 
+/* -----------------------------------------------------------------
+   Thread team over the subvectors
+
+   Only the MPI-unaware ManyVector runs its subvectors in parallel,
+   the subvectors of an MPIManyVector may communicate. The min/max
+   reductions need OpenMP 3.1.
+   -----------------------------------------------------------------*/
+#if !SUNDIALS_MPI_ENABLED && defined(_OPENMP) && (_OPENMP >= 201107)
+#include <omp.h>
+#define MANYVECTOR_THREADED            1
+#define MANYVECTOR_NUM_THREADS(v)      ( MANYVECTOR_CONTENT(v)->num_threads )
+#define MANYVECTOR_THREAD_NUM()        ( omp_get_thread_num() )
+#define MV_PRAGMA(x)                   _Pragma(#x)
+#define MV_OMP_FOR(v)                  MV_PRAGMA(omp parallel for schedule(dynamic,1) num_threads(MANYVECTOR_NUM_THREADS(v)) if(MANYVECTOR_NUM_THREADS(v) > 1))
+#define MV_OMP_FOR_IF(v,cond)          MV_PRAGMA(omp parallel for schedule(dynamic,1) num_threads(MANYVECTOR_NUM_THREADS(v)) if(cond))
+#define MV_OMP_FOR_REDUCE(v,red,priv)  MV_PRAGMA(omp parallel for schedule(dynamic,1) num_threads(MANYVECTOR_NUM_THREADS(v)) if(MANYVECTOR_NUM_THREADS(v) > 1) reduction(red) private(priv))
+#define MV_OMP_ATOMIC_WRITE            MV_PRAGMA(omp atomic write)
+#else
+#define MANYVECTOR_THREADED            0
+#define MANYVECTOR_NUM_THREADS(v)      1
+#define MANYVECTOR_THREAD_NUM()        0
+#define MV_OMP_FOR(v)
+#define MV_OMP_FOR_IF(v,cond)
+#define MV_OMP_FOR_REDUCE(v,red,priv)
+#define MV_OMP_ATOMIC_WRITE
+#endif
+
 /* -----------------------------------------------------------------
    Prototypes of utility routines
    -----------------------------------------------------------------*/
 static N_Vector ManyVectorClone(N_Vector w, booleantype cloneempty);
+static realtype *ManyVectorPartials(N_Vector v, int nvec);
+static realtype ManyVectorSumPartials(N_Vector v, realtype *part);
+#if MANYVECTOR_THREADED
+static void ManyVectorSumPartialsMulti(N_Vector v, int nvec, realtype *part,
+                                       realtype *sums);
+#endif
 #if SUNDIALS_MPI_ENABLED
 static int SubvectorMPIRank(N_Vector w);
 #endif
@@ -339,6 +372,7 @@ N_Vector N_VNew_ManyVector(sunindextype num_subvectors,
   /* allocate and set subvector array */
   content->num_subvectors = num_subvectors;
   content->own_data       = SUNFALSE;
+  content->num_threads    = 1;
 
   content->subvec_array = NULL;
   content->subvec_array = (N_Vector *) malloc(num_subvectors * sizeof(N_Vector));
@@ -410,6 +444,19 @@ sunindextype MVAPPEND(N_VGetNumSubvectors)(N_Vector v)
 }
 
 
+#if !SUNDIALS_MPI_ENABLED
+/* This function sets the number of threads working on the subvectors
+   of a ManyVector.  It returns -1 if v is NULL or num_threads < 1. */
+int N_VSetNumThreads_ManyVector(N_Vector v, int num_threads)
+{
+  if ( (v == NULL) || (v->content == NULL) || (num_threads < 1) )
+    return(-1);
+  MANYVECTOR_CONTENT(v)->num_threads = num_threads;
+  return(0);
+}
+#endif
+
+
 /* -----------------------------------------------------------------
    ManyVector implementations of generic NVector routines
    -----------------------------------------------------------------*/
@@ -530,6 +577,7 @@ sunindextype MVAPPEND(N_VGetLength)(N_Vector v)
 void MVAPPEND(N_VLinearSum)(realtype a, N_Vector x, realtype b, N_Vector y, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VLinearSum(a, MANYVECTOR_SUBVEC(x,i), b, MANYVECTOR_SUBVEC(y,i),
                  MANYVECTOR_SUBVEC(z,i));
@@ -541,6 +589,7 @@ void MVAPPEND(N_VLinearSum)(realtype a, N_Vector x, realtype b, N_Vector y, N_Ve
 void MVAPPEND(N_VConst)(realtype c, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(z)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(z); i++)
     N_VConst(c, MANYVECTOR_SUBVEC(z,i));
   return;
@@ -553,6 +602,7 @@ void MVAPPEND(N_VConst)(realtype c, N_Vector z)
 void MVAPPEND(N_VProd)(N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VProd(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(y,i),
             MANYVECTOR_SUBVEC(z,i));
@@ -566,6 +616,7 @@ void MVAPPEND(N_VProd)(N_Vector x, N_Vector y, N_Vector z)
 void MVAPPEND(N_VDiv)(N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VDiv(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(y,i),
            MANYVECTOR_SUBVEC(z,i));
@@ -579,6 +630,7 @@ void MVAPPEND(N_VDiv)(N_Vector x, N_Vector y, N_Vector z)
 void MVAPPEND(N_VScale)(realtype c, N_Vector x, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VScale(c, MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(z,i));
   return;
@@ -591,6 +643,7 @@ void MVAPPEND(N_VScale)(realtype c, N_Vector x, N_Vector z)
 void MVAPPEND(N_VAbs)(N_Vector x, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VAbs(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(z,i));
   return;
@@ -603,6 +656,7 @@ void MVAPPEND(N_VAbs)(N_Vector x, N_Vector z)
 void MVAPPEND(N_VInv)(N_Vector x, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VInv(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(z,i));
   return;
@@ -615,6 +669,7 @@ void MVAPPEND(N_VInv)(N_Vector x, N_Vector z)
 void MVAPPEND(N_VAddConst)(N_Vector x, realtype b, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VAddConst(MANYVECTOR_SUBVEC(x,i), b, MANYVECTOR_SUBVEC(z,i));
   return;
@@ -633,7 +688,7 @@ void MVAPPEND(N_VAddConst)(N_Vector x, realtype b, N_Vector z)
 realtype MVAPPEND(N_VDotProdLocal)(N_Vector x, N_Vector y)
 {
   sunindextype i;
-  realtype sum;
+  realtype sum, *part;
 #if SUNDIALS_MPI_ENABLED
   realtype contrib;
   int rank;
@@ -642,6 +697,10 @@ realtype MVAPPEND(N_VDotProdLocal)(N_Vector x, N_Vector y)
   /* initialize output*/
   sum = ZERO;
 
+  /* per-subvector results, NULL if the subvectors are done in sequence */
+  part = ManyVectorPartials(x, 1);
+
+  MV_OMP_FOR_IF(x, part != NULL)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
 #if SUNDIALS_MPI_ENABLED
@@ -667,12 +726,17 @@ realtype MVAPPEND(N_VDotProdLocal)(N_Vector x, N_Vector y)
 #else
 
     /* add subvector contribution */
-    sum += N_VDotProd(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(y,i));
+    if (part)
+      part[i] = N_VDotProd(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(y,i));
+    else
+      sum += N_VDotProd(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(y,i));
 
 #endif
 
   }
 
+  if (part)  sum = ManyVectorSumPartials(x, part);
+
   return(sum);
 }
 
@@ -706,6 +770,7 @@ realtype MVAPPEND(N_VMaxNormLocal)(N_Vector x)
   /* initialize output*/
   max = ZERO;
 
+  MV_OMP_FOR_REDUCE(x, max:max, lmax)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
     /* check for nvmaxnormlocal in subvector */
@@ -753,8 +818,8 @@ realtype N_VMaxNorm_MPIManyVector(N_Vector x)
    subvector's communicator (note: serial vectors are always root task). */
 realtype MVAPPEND(N_VWSqrSumLocal)(N_Vector x, N_Vector w)
 {
-  sunindextype i, N;
-  realtype sum, contrib;
+  sunindextype i;
+  realtype sum, *part;
 #if SUNDIALS_MPI_ENABLED
   int rank;
 #endif
@@ -762,8 +827,15 @@ realtype MVAPPEND(N_VWSqrSumLocal)(N_Vector x, N_Vector w)
   /* initialize output*/
   sum = ZERO;
 
+  /* per-subvector results, NULL if the subvectors are done in sequence */
+  part = ManyVectorPartials(x, 1);
+
+  MV_OMP_FOR_IF(x, part != NULL)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
+    sunindextype N;
+    realtype contrib;
+
 #if SUNDIALS_MPI_ENABLED
 
     /* check for nvwsqrsumlocal in subvector */
@@ -791,12 +863,15 @@ realtype MVAPPEND(N_VWSqrSumLocal)(N_Vector x, N_Vector w)
     /* accumulate subvector contribution to overall sum */
     contrib = N_VWrmsNorm(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(w,i));
     N = N_VGetLength(MANYVECTOR_SUBVEC(x,i));
-    sum += (contrib*contrib*N);
+    if (part)  part[i] = (contrib*contrib*N);
+    else       sum += (contrib*contrib*N);
 
 #endif
 
   }
 
+  if (part)  sum = ManyVectorSumPartials(x, part);
+
   return(sum);
 }
 
@@ -833,8 +908,8 @@ realtype MVAPPEND(N_VWrmsNorm)(N_Vector x, N_Vector w)
    root task). */
 realtype MVAPPEND(N_VWSqrSumMaskLocal)(N_Vector x, N_Vector w, N_Vector id)
 {
-  sunindextype i, N;
-  realtype sum, contrib;
+  sunindextype i;
+  realtype sum, *part;
 #if SUNDIALS_MPI_ENABLED
   int rank;
 #endif
@@ -842,8 +917,15 @@ realtype MVAPPEND(N_VWSqrSumMaskLocal)(N_Vector x, N_Vector w, N_Vector id)
   /* initialize output*/
   sum = ZERO;
 
+  /* per-subvector results, NULL if the subvectors are done in sequence */
+  part = ManyVectorPartials(x, 1);
+
+  MV_OMP_FOR_IF(x, part != NULL)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
+    sunindextype N;
+    realtype contrib;
+
 #if SUNDIALS_MPI_ENABLED
 
     /* check for nvwsqrsummasklocal in subvector */
@@ -874,12 +956,15 @@ realtype MVAPPEND(N_VWSqrSumMaskLocal)(N_Vector x, N_Vector w, N_Vector id)
     contrib = N_VWrmsNormMask(MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(w,i),
                               MANYVECTOR_SUBVEC(id,i));
     N = N_VGetLength(MANYVECTOR_SUBVEC(x,i));
-    sum += (contrib*contrib*N);
+    if (part)  part[i] = (contrib*contrib*N);
+    else       sum += (contrib*contrib*N);
 
 #endif
 
   }
 
+  if (part)  sum = ManyVectorSumPartials(x, part);
+
   return(sum);
 }
 
@@ -916,6 +1001,7 @@ realtype MVAPPEND(N_VMinLocal)(N_Vector x)
   /* initialize output*/
   min = BIG_REAL;
 
+  MV_OMP_FOR_REDUCE(x, min:min, lmin)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
     /* check for nvminlocal in subvector */
@@ -978,7 +1064,7 @@ realtype MVAPPEND(N_VWL2Norm)(N_Vector x, N_Vector w)
 realtype MVAPPEND(N_VL1NormLocal)(N_Vector x)
 {
   sunindextype i;
-  realtype sum;
+  realtype sum, *part;
 #if SUNDIALS_MPI_ENABLED
   realtype contrib;
   int rank;
@@ -987,6 +1073,10 @@ realtype MVAPPEND(N_VL1NormLocal)(N_Vector x)
   /* initialize output*/
   sum = ZERO;
 
+  /* per-subvector results, NULL if the subvectors are done in sequence */
+  part = ManyVectorPartials(x, 1);
+
+  MV_OMP_FOR_IF(x, part != NULL)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
 #if SUNDIALS_MPI_ENABLED
@@ -1012,12 +1102,17 @@ realtype MVAPPEND(N_VL1NormLocal)(N_Vector x)
 #else
 
     /* accumulate subvector contribution to overall sum */
-    sum += N_VL1Norm(MANYVECTOR_SUBVEC(x,i));
+    if (part)
+      part[i] = N_VL1Norm(MANYVECTOR_SUBVEC(x,i));
+    else
+      sum += N_VL1Norm(MANYVECTOR_SUBVEC(x,i));
 
 #endif
 
   }
 
+  if (part)  sum = ManyVectorSumPartials(x, part);
+
   return(sum);
 }
 
@@ -1042,6 +1137,7 @@ realtype N_VL1Norm_MPIManyVector(N_Vector x)
 void MVAPPEND(N_VCompare)(realtype c, N_Vector x, N_Vector z)
 {
   sunindextype i;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++)
     N_VCompare(c, MANYVECTOR_SUBVEC(x,i), MANYVECTOR_SUBVEC(z,i));
   return;
@@ -1063,6 +1159,7 @@ booleantype MVAPPEND(N_VInvTestLocal)(N_Vector x, N_Vector z)
   /* initialize output*/
   val = SUNTRUE;
 
+  MV_OMP_FOR_REDUCE(x, &&:val, subval)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
     /* check for nvinvtestlocal in subvector */
@@ -1115,6 +1212,7 @@ booleantype MVAPPEND(N_VConstrMaskLocal)(N_Vector c, N_Vector x, N_Vector m)
   /* initialize output*/
   val = SUNTRUE;
 
+  MV_OMP_FOR_REDUCE(x, &&:val, subval)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
     /* check for nvconstrmasklocal in subvector */
@@ -1169,6 +1267,7 @@ realtype MVAPPEND(N_VMinQuotientLocal)(N_Vector num, N_Vector denom)
   /* initialize output*/
   min = BIG_REAL;
 
+  MV_OMP_FOR_REDUCE(num, min:min, lmin)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(num); i++) {
 
     /* check for nvminquotientlocal in subvector */
@@ -1224,35 +1323,40 @@ realtype N_VMinQuotient_MPIManyVector(N_Vector num, N_Vector denom)
    we must unravel the subvectors while retaining an array of outer vectors. */
 int MVAPPEND(N_VLinearCombination)(int nvec, realtype* c, N_Vector* X, N_Vector z)
 {
-  sunindextype i, j;
+  sunindextype i;
   int retval;
   N_Vector *Xsub;
 
-  /* create array of nvec N_Vector pointers for reuse within loop */
+  /* create array of nvec N_Vector pointers per thread for reuse within loop */
   Xsub = NULL;
-  Xsub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
+  Xsub = (N_Vector *) malloc( nvec * MANYVECTOR_NUM_THREADS(z) * sizeof(N_Vector) );
   if (Xsub == NULL)  return(1);
 
   /* perform operation by calling N_VLinearCombination for each subvector */
+  retval = 0;
+  MV_OMP_FOR(z)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(z); i++) {
 
+    N_Vector *Xi = Xsub + nvec*MANYVECTOR_THREAD_NUM();
+    int j, subret;
+
     /* for each subvector, create the array of subvectors of X */
-    for (j=0; j<nvec; j++)  Xsub[j] = MANYVECTOR_SUBVEC(X[j],i);
+    for (j=0; j<nvec; j++)  Xi[j] = MANYVECTOR_SUBVEC(X[j],i);
 
     /* now call N_VLinearCombination for this array of subvectors */
-    retval = N_VLinearCombination(nvec, c, Xsub, MANYVECTOR_SUBVEC(z,i));
+    subret = N_VLinearCombination(nvec, c, Xi, MANYVECTOR_SUBVEC(z,i));
 
-    /* fail gracefully */
-    if (retval) {
-      free(Xsub);
-      return(retval);
+    /* record a failure, the remaining subvectors are still processed */
+    if (subret) {
+      MV_OMP_ATOMIC_WRITE
+      retval = subret;
     }
 
   }
 
   /* clean up and return */
   free(Xsub);
-  return(0);
+  return(retval);
 }
 
 
@@ -1267,33 +1371,42 @@ int MVAPPEND(N_VLinearCombination)(int nvec, realtype* c, N_Vector* X, N_Vector
    the subvectors while retaining an array of outer vectors. */
 int MVAPPEND(N_VScaleAddMulti)(int nvec, realtype* a, N_Vector x, N_Vector* Y, N_Vector* Z)
 {
-  sunindextype i, j;
+  sunindextype i;
   int retval;
   N_Vector *Ysub, *Zsub;
 
-  /* create arrays of nvec N_Vector pointers for reuse within loop */
+  /* create arrays of nvec N_Vector pointers per thread for reuse within loop */
   Ysub = Zsub = NULL;
-  Ysub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
-  Zsub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
-  if ( (Ysub == NULL) || (Zsub == NULL) )  return(1);
+  Ysub = (N_Vector *) malloc( nvec * MANYVECTOR_NUM_THREADS(x) * sizeof(N_Vector) );
+  Zsub = (N_Vector *) malloc( nvec * MANYVECTOR_NUM_THREADS(x) * sizeof(N_Vector) );
+  if ( (Ysub == NULL) || (Zsub == NULL) ) {
+    free(Ysub);
+    free(Zsub);
+    return(1);
+  }
 
   /* perform operation by calling N_VScaleAddMulti for each subvector */
+  retval = 0;
+  MV_OMP_FOR(x)
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
 
+    N_Vector *Yi = Ysub + nvec*MANYVECTOR_THREAD_NUM();
+    N_Vector *Zi = Zsub + nvec*MANYVECTOR_THREAD_NUM();
+    int j, subret;
+
     /* for each subvector, create the array of subvectors of Y and Z */
     for (j=0; j<nvec; j++)  {
-      Ysub[j] = MANYVECTOR_SUBVEC(Y[j],i);
-      Zsub[j] = MANYVECTOR_SUBVEC(Z[j],i);
+      Yi[j] = MANYVECTOR_SUBVEC(Y[j],i);
+      Zi[j] = MANYVECTOR_SUBVEC(Z[j],i);
     }
 
     /* now call N_VScaleAddMulti for this array of subvectors */
-    retval = N_VScaleAddMulti(nvec, a, MANYVECTOR_SUBVEC(x,i), Ysub, Zsub);
+    subret = N_VScaleAddMulti(nvec, a, MANYVECTOR_SUBVEC(x,i), Yi, Zi);
 
-    /* fail gracefully */
-    if (retval) {
-      free(Ysub);
-      free(Zsub);
-      return(retval);
+    /* record a failure, the remaining subvectors are still processed */
+    if (subret) {
+      MV_OMP_ATOMIC_WRITE
+      retval = subret;
     }
 
   }
@@ -1301,7 +1414,7 @@ int MVAPPEND(N_VScaleAddMulti)(int nvec, realtype* a, N_Vector x, N_Vector* Y, N
   /* clean up and return */
   free(Ysub);
   free(Zsub);
-  return(0);
+  return(retval);
 }
 
 
@@ -1316,6 +1429,23 @@ int MVAPPEND(N_VScaleAddMulti)(int nvec, realtype* a, N_Vector x, N_Vector* Y, N
 int MVAPPEND(N_VDotProdMulti)(int nvec, N_Vector x, N_Vector* Y, realtype* dotprods)
 {
   sunindextype i;
+#if MANYVECTOR_THREADED
+  realtype *part;
+
+  /* with a thread team, compute all products in one pass over the subvectors */
+  part = ManyVectorPartials(x, nvec);
+  if (part) {
+    MV_OMP_FOR(x)
+    for (i=0; i<MANYVECTOR_NUM_SUBVECS(x); i++) {
+      int j;
+      for (j=0; j<nvec; j++)
+        part[i*nvec+j] = N_VDotProd(MANYVECTOR_SUBVEC(x,i),
+                                    MANYVECTOR_SUBVEC(Y[j],i));
+    }
+    ManyVectorSumPartialsMulti(x, nvec, part, dotprods);
+    return(0);
+  }
+#endif
 
   /* call N_VDotProdLocal for each <x,Y[i]> pair */
   for (i=0; i<nvec; i++)  dotprods[i] = N_VDotProdLocal(x,Y[i]);
@@ -1348,39 +1478,50 @@ int MVAPPEND(N_VLinearSumVectorArray)(int nvec, realtype a,
                                       N_Vector *X, realtype b,
                                       N_Vector *Y, N_Vector *Z)
 {
-  sunindextype i, j;
-  int retval;
+  sunindextype i;
+  int retval, nthr;
   N_Vector *Xsub, *Ysub, *Zsub;
 
   /* immediately return if nvec <= 0 */
   if (nvec <= 0)  return(0);
 
-  /* create arrays of nvec N_Vector pointers for reuse within loop */
+  /* create arrays of nvec N_Vector pointers per thread for reuse within loop */
+  nthr = MANYVECTOR_NUM_THREADS(X[0]);
   Xsub = Ysub = Zsub = NULL;
-  Xsub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
-  Ysub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
-  Zsub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
-  if ( (Xsub == NULL) || (Ysub == NULL) || (Zsub == NULL) )  return(1);
+  Xsub = (N_Vector *) malloc( nvec * nthr * sizeof(N_Vector) );
+  Ysub = (N_Vector *) malloc( nvec * nthr * sizeof(N_Vector) );
+  Zsub = (N_Vector *) malloc( nvec * nthr * sizeof(N_Vector) );
+  if ( (Xsub == NULL) || (Ysub == NULL) || (Zsub == NULL) ) {
+    free(Xsub);
+    free(Ysub);
+    free(Zsub);
+    return(1);
+  }
 
   /* perform operation by calling N_VLinearSumVectorArray for each subvector */
+  retval = 0;
+  MV_OMP_FOR(X[0])
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(X[0]); i++) {
 
+    N_Vector *Xi = Xsub + nvec*MANYVECTOR_THREAD_NUM();
+    N_Vector *Yi = Ysub + nvec*MANYVECTOR_THREAD_NUM();
+    N_Vector *Zi = Zsub + nvec*MANYVECTOR_THREAD_NUM();
+    int j, subret;
+
     /* for each subvector, create the array of subvectors of X, Y and Z */
     for (j=0; j<nvec; j++)  {
-      Xsub[j] = MANYVECTOR_SUBVEC(X[j],i);
-      Ysub[j] = MANYVECTOR_SUBVEC(Y[j],i);
-      Zsub[j] = MANYVECTOR_SUBVEC(Z[j],i);
+      Xi[j] = MANYVECTOR_SUBVEC(X[j],i);
+      Yi[j] = MANYVECTOR_SUBVEC(Y[j],i);
+      Zi[j] = MANYVECTOR_SUBVEC(Z[j],i);
     }
 
     /* now call N_VLinearSumVectorArray for this array of subvectors */
-    retval = N_VLinearSumVectorArray(nvec, a, Xsub, b, Ysub, Zsub);
-
-    /* fail gracefully */
-    if (retval) {
-      free(Xsub);
-      free(Ysub);
-      free(Zsub);
-      return(retval);
+    subret = N_VLinearSumVectorArray(nvec, a, Xi, b, Yi, Zi);
+
+    /* record a failure, the remaining subvectors are still processed */
+    if (subret) {
+      MV_OMP_ATOMIC_WRITE
+      retval = subret;
     }
 
   }
@@ -1389,7 +1530,7 @@ int MVAPPEND(N_VLinearSumVectorArray)(int nvec, realtype a,
   free(Xsub);
   free(Ysub);
   free(Zsub);
-  return(0);
+  return(retval);
 }
 
 
@@ -1404,36 +1545,46 @@ int MVAPPEND(N_VLinearSumVectorArray)(int nvec, realtype a,
    the subvectors while retaining arrays of outer vectors. */
 int MVAPPEND(N_VScaleVectorArray)(int nvec, realtype* c, N_Vector* X, N_Vector* Z)
 {
-  sunindextype i, j;
-  int retval;
+  sunindextype i;
+  int retval, nthr;
   N_Vector *Xsub, *Zsub;
 
   /* immediately return if nvec <= 0 */
   if (nvec <= 0)  return(0);
 
-  /* create arrays of nvec N_Vector pointers for reuse within loop */
+  /* create arrays of nvec N_Vector pointers per thread for reuse within loop */
+  nthr = MANYVECTOR_NUM_THREADS(X[0]);
   Xsub = Zsub = NULL;
-  Xsub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
-  Zsub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
-  if ( (Xsub == NULL) || (Zsub == NULL) )  return(1);
+  Xsub = (N_Vector *) malloc( nvec * nthr * sizeof(N_Vector) );
+  Zsub = (N_Vector *) malloc( nvec * nthr * sizeof(N_Vector) );
+  if ( (Xsub == NULL) || (Zsub == NULL) ) {
+    free(Xsub);
+    free(Zsub);
+    return(1);
+  }
 
   /* perform operation by calling N_VScaleVectorArray for each subvector */
+  retval = 0;
+  MV_OMP_FOR(X[0])
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(X[0]); i++) {
 
+    N_Vector *Xi = Xsub + nvec*MANYVECTOR_THREAD_NUM();
+    N_Vector *Zi = Zsub + nvec*MANYVECTOR_THREAD_NUM();
+    int j, subret;
+
     /* for each subvector, create the array of subvectors of X, Y and Z */
     for (j=0; j<nvec; j++)  {
-      Xsub[j] = MANYVECTOR_SUBVEC(X[j],i);
-      Zsub[j] = MANYVECTOR_SUBVEC(Z[j],i);
+      Xi[j] = MANYVECTOR_SUBVEC(X[j],i);
+      Zi[j] = MANYVECTOR_SUBVEC(Z[j],i);
     }
 
     /* now call N_VScaleVectorArray for this array of subvectors */
-    retval = N_VScaleVectorArray(nvec, c, Xsub, Zsub);
+    subret = N_VScaleVectorArray(nvec, c, Xi, Zi);
 
-    /* fail gracefully */
-    if (retval) {
-      free(Xsub);
-      free(Zsub);
-      return(retval);
+    /* record a failure, the remaining subvectors are still processed */
+    if (subret) {
+      MV_OMP_ATOMIC_WRITE
+      retval = subret;
     }
 
   }
@@ -1441,7 +1592,7 @@ int MVAPPEND(N_VScaleVectorArray)(int nvec, realtype* c, N_Vector* X, N_Vector*
   /* clean up and return */
   free(Xsub);
   free(Zsub);
-  return(0);
+  return(retval);
 }
 
 
@@ -1454,39 +1605,44 @@ int MVAPPEND(N_VScaleVectorArray)(int nvec, realtype* c, N_Vector* X, N_Vector*
    the subvectors while retaining an array of outer vectors. */
 int MVAPPEND(N_VConstVectorArray)(int nvec, realtype c, N_Vector* Z)
 {
-  sunindextype i, j;
+  sunindextype i;
   int retval;
   N_Vector *Zsub;
 
   /* immediately return if nvec <= 0 */
   if (nvec <= 0)  return(0);
 
-  /* create array of N_Vector pointers for reuse within loop */
+  /* create array of N_Vector pointers per thread for reuse within loop */
   Zsub = NULL;
-  Zsub = (N_Vector *) malloc( nvec * sizeof(N_Vector) );
+  Zsub = (N_Vector *) malloc( nvec * MANYVECTOR_NUM_THREADS(Z[0]) * sizeof(N_Vector) );
   if (Zsub == NULL)  return(1);
 
   /* perform operation by calling N_VConstVectorArray for each subvector */
+  retval = 0;
+  MV_OMP_FOR(Z[0])
   for (i=0; i<MANYVECTOR_NUM_SUBVECS(Z[0]); i++) {
 
+    N_Vector *Zi = Zsub + nvec*MANYVECTOR_THREAD_NUM();
+    int j, subret;
+
     /* for each subvector, create the array of subvectors of X, Y and Z */
     for (j=0; j<nvec; j++)
-      Zsub[j] = MANYVECTOR_SUBVEC(Z[j],i);
+      Zi[j] = MANYVECTOR_SUBVEC(Z[j],i);
 
     /* now call N_VConstVectorArray for this array of subvectors */
-    retval = N_VConstVectorArray(nvec, c, Zsub);
+    subret = N_VConstVectorArray(nvec, c, Zi);
 
-    /* fail gracefully */
-    if (retval) {
-      free(Zsub);
-      return(retval);
+    /* record a failure, the remaining subvectors are still processed */
+    if (subret) {
+      MV_OMP_ATOMIC_WRITE
+      retval = subret;
     }
 
   }
 
   /* clean up and return */
   free(Zsub);
-  return(0);
+  return(retval);
 }
 
 
@@ -1502,10 +1658,31 @@ int MVAPPEND(N_VWrmsNormVectorArray)(int nvec, N_Vector* X, N_Vector* W, realtyp
 {
   sunindextype i;
   int retval;
+#if MANYVECTOR_THREADED
+  realtype *part;
+#endif
 
   /* immediately return if nvec <= 0 */
   if (nvec <= 0)  return(0);
 
+#if MANYVECTOR_THREADED
+  /* with a thread team, compute all sums in one pass over the subvectors */
+  part = ManyVectorPartials(X[0], nvec);
+  if (part) {
+    MV_OMP_FOR(X[0])
+    for (i=0; i<MANYVECTOR_NUM_SUBVECS(X[0]); i++) {
+      sunindextype N = N_VGetLength(MANYVECTOR_SUBVEC(X[0],i));
+      realtype contrib;
+      int j;
+      for (j=0; j<nvec; j++) {
+        contrib = N_VWrmsNorm(MANYVECTOR_SUBVEC(X[j],i), MANYVECTOR_SUBVEC(W[j],i));
+        part[i*nvec+j] = (contrib*contrib*N);
+      }
+    }
+    ManyVectorSumPartialsMulti(X[0], nvec, part, nrm);
+  } else
+#endif
+
   /* call N_VWSqrSumLocal for each (X[i],W[i]) pair */
   for (i=0; i<nvec; i++)  nrm[i] = N_VWSqrSumLocal(X[i], W[i]);
 
@@ -1539,10 +1716,32 @@ int MVAPPEND(N_VWrmsNormMaskVectorArray)(int nvec, N_Vector* X, N_Vector* W,
 {
   sunindextype i;
   int retval;
+#if MANYVECTOR_THREADED
+  realtype *part;
+#endif
 
   /* immediately return if nvec <= 0 */
   if (nvec <= 0)  return(0);
 
+#if MANYVECTOR_THREADED
+  /* with a thread team, compute all sums in one pass over the subvectors */
+  part = ManyVectorPartials(X[0], nvec);
+  if (part) {
+    MV_OMP_FOR(X[0])
+    for (i=0; i<MANYVECTOR_NUM_SUBVECS(X[0]); i++) {
+      sunindextype N = N_VGetLength(MANYVECTOR_SUBVEC(X[0],i));
+      realtype contrib;
+      int j;
+      for (j=0; j<nvec; j++) {
+        contrib = N_VWrmsNormMask(MANYVECTOR_SUBVEC(X[j],i), MANYVECTOR_SUBVEC(W[j],i),
+                                  MANYVECTOR_SUBVEC(id,i));
+        part[i*nvec+j] = (contrib*contrib*N);
+      }
+    }
+    ManyVectorSumPartialsMulti(X[0], nvec, part, nrm);
+  } else
+#endif
+
   /* call N_VWSqrSumMaskLocal for each (X[i],W[i]) pair */
   for (i=0; i<nvec; i++)  nrm[i] = N_VWSqrSumMaskLocal(X[i], W[i], id);
 
@@ -1878,6 +2077,8 @@ static N_Vector ManyVectorClone(N_Vector w, booleantype cloneempty)
   /* Set scalar components */
 #if SUNDIALS_MPI_ENABLED
   content->comm           = MPI_COMM_NULL;
+#else
+  content->num_threads    = MANYVECTOR_CONTENT(w)->num_threads;
 #endif
   content->num_subvectors = MANYVECTOR_NUM_SUBVECS(w);
   content->global_length  = MANYVECTOR_GLOBLENGTH(w);
@@ -1917,6 +2118,44 @@ static N_Vector ManyVectorClone(N_Vector w, booleantype cloneempty)
 }
 
 
+/* This function returns an array for nvec results per subvector when the
+   subvectors of v are worked on by a thread team, and NULL otherwise. */
+static realtype *ManyVectorPartials(N_Vector v, int nvec)
+{
+  if ( (MANYVECTOR_NUM_THREADS(v) < 2) || (MANYVECTOR_NUM_SUBVECS(v) < 2) ||
+       (nvec < 1) )
+    return(NULL);
+  return((realtype *) malloc(MANYVECTOR_NUM_SUBVECS(v) * nvec * sizeof(realtype)));
+}
+
+
+/* This function sums the per-subvector results in subvector order, which
+   gives the same value as the sequential loop, and frees the array. */
+static realtype ManyVectorSumPartials(N_Vector v, realtype *part)
+{
+  sunindextype i;
+  realtype sum = ZERO;
+  for (i=0; i<MANYVECTOR_NUM_SUBVECS(v); i++)  sum += part[i];
+  free(part);
+  return(sum);
+}
+
+
+#if MANYVECTOR_THREADED
+/* As ManyVectorSumPartials, for nvec results per subvector. */
+static void ManyVectorSumPartialsMulti(N_Vector v, int nvec, realtype *part,
+                                       realtype *sums)
+{
+  sunindextype i;
+  int j;
+  for (j=0; j<nvec; j++)  sums[j] = ZERO;
+  for (i=0; i<MANYVECTOR_NUM_SUBVECS(v); i++)
+    for (j=0; j<nvec; j++)  sums[j] += part[i*nvec+j];
+  free(part);
+}
+#endif
+
+
 #if SUNDIALS_MPI_ENABLED
 /* This function returns the rank of this task in the MPI communicator
    associated with the input N_Vector.  If the input N_Vector is MPI-unaware, it
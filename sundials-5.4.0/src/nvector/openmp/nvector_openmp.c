@@ -33,6 +33,23 @@
 #define ONE    RCONST(1.0)
 #define ONEPT5 RCONST(1.5)
 
+/* Private function to allocate the data array of a vector */
+static int VAllocData_OpenMP(N_Vector v, SUNMemoryHelper helper);
+
+/* Private function for deterministic sum reductions */
+static realtype VDetSum_OpenMP(int kind, N_Vector x, N_Vector y, N_Vector id);
+
+/* Sums computed by VDetSum_OpenMP */
+#define DET_DOTPROD     0   /* sum(x[i]*y[i])               */
+#define DET_WSQRSUM     1   /* sum((x[i]*w[i])^2)           */
+#define DET_WSQRSUMMASK 2   /* sum((x[i]*w[i])^2), id[i] > 0 */
+#define DET_L1NORM      3   /* sum(|x[i]|)                  */
+
+/* Chunks of deterministic reductions: at most DET_MAX_CHUNKS of at least
+   DET_MIN_CHUNK elements each, the chunking depends on the length only */
+#define DET_MAX_CHUNKS 256
+#define DET_MIN_CHUNK  4096
+
 /* Private functions for special cases of vector operations */
 static void VCopy_OpenMP(N_Vector x, N_Vector z);                              /* z=x       */
 static void VSum_OpenMP(N_Vector x, N_Vector y, N_Vector z);                   /* z=x+y     */
@@ -147,6 +164,9 @@ N_Vector N_VNewEmpty_OpenMP(sunindextype length, int num_threads)
   content->num_threads = num_threads;
   content->own_data    = SUNFALSE;
   content->data        = NULL;
+  content->mem_helper  = NULL;
+  content->data_mem    = NULL;
+  content->deterministic = SUNFALSE;
 
   return(v);
 }
@@ -158,25 +178,35 @@ N_Vector N_VNewEmpty_OpenMP(sunindextype length, int num_threads)
 N_Vector N_VNew_OpenMP(sunindextype length, int num_threads)
 {
   N_Vector v;
-  realtype *data;
 
   v = NULL;
   v = N_VNewEmpty_OpenMP(length, num_threads);
   if (v == NULL) return(NULL);
 
   /* Create data */
-  if (length > 0) {
+  if (VAllocData_OpenMP(v, NULL)) { N_VDestroy_OpenMP(v); return(NULL); }
 
-    /* Allocate memory */
-    data = NULL;
-    data = (realtype *) malloc(length * sizeof(realtype));
-    if(data == NULL) { N_VDestroy_OpenMP(v); return(NULL); }
+  return(v);
+}
 
-    /* Attach data */
-    NV_OWN_DATA_OMP(v) = SUNTRUE;
-    NV_DATA_OMP(v)     = data;
+/* ----------------------------------------------------------------------------
+ * Function to create a new vector with its data, and the data of all of its
+ * clones, drawn from a memory helper
+ */
 
-  }
+N_Vector N_VNewWithMemHelp_OpenMP(sunindextype length, int num_threads,
+                                  SUNMemoryHelper helper)
+{
+  N_Vector v;
+
+  if (helper == NULL) return(NULL);
+
+  v = NULL;
+  v = N_VNewEmpty_OpenMP(length, num_threads);
+  if (v == NULL) return(NULL);
+
+  /* Create data */
+  if (VAllocData_OpenMP(v, helper)) { N_VDestroy_OpenMP(v); return(NULL); }
 
   return(v);
 }
@@ -354,6 +384,9 @@ N_Vector N_VCloneEmpty_OpenMP(N_Vector w)
   content->num_threads = NV_NUM_THREADS_OMP(w);
   content->own_data    = SUNFALSE;
   content->data        = NULL;
+  content->mem_helper  = NULL;
+  content->data_mem    = NULL;
+  content->deterministic = NV_DETERMINISTIC_OMP(w);
 
   return(v);
 }
@@ -366,27 +399,15 @@ N_Vector N_VCloneEmpty_OpenMP(N_Vector w)
 N_Vector N_VClone_OpenMP(N_Vector w)
 {
   N_Vector v;
-  realtype *data;
-  sunindextype length;
 
   v = NULL;
   v = N_VCloneEmpty_OpenMP(w);
   if (v == NULL) return(NULL);
 
-  length = NV_LENGTH_OMP(w);
-
-  /* Create data */
-  if (length > 0) {
-
-    /* Allocate memory */
-    data = NULL;
-    data = (realtype *) malloc(length * sizeof(realtype));
-    if(data == NULL) { N_VDestroy_OpenMP(v); return(NULL); }
-
-    /* Attach data */
-    NV_OWN_DATA_OMP(v) = SUNTRUE;
-    NV_DATA_OMP(v)     = data;
-
+  /* Create data, drawn from the same helper as the data of w */
+  if (VAllocData_OpenMP(v, NV_CONTENT_OMP(w)->mem_helper)) {
+    N_VDestroy_OpenMP(v);
+    return(NULL);
   }
 
   return(v);
@@ -405,7 +426,12 @@ void N_VDestroy_OpenMP(N_Vector v)
   if (v->content != NULL) {
     /* free data array if it's owned by the vector */
     if (NV_OWN_DATA_OMP(v) && NV_DATA_OMP(v) != NULL) {
-      free(NV_DATA_OMP(v));
+      if (NV_CONTENT_OMP(v)->data_mem != NULL)
+        SUNMemoryHelper_Dealloc(NV_CONTENT_OMP(v)->mem_helper,
+                                NV_CONTENT_OMP(v)->data_mem);
+      else
+        free(NV_DATA_OMP(v));
+      NV_CONTENT_OMP(v)->data_mem = NULL;
       NV_DATA_OMP(v) = NULL;
     }
     free(v->content);
@@ -752,6 +778,9 @@ realtype N_VDotProd_OpenMP(N_Vector x, N_Vector y)
   xd = NV_DATA_OMP(x);
   yd = NV_DATA_OMP(y);
 
+  if (NV_DETERMINISTIC_OMP(x))
+    return(VDetSum_OpenMP(DET_DOTPROD, x, y, NULL));
+
 #pragma omp parallel for default(none) private(i) shared(N,xd,yd) \
   reduction(+:sum) schedule(static) num_threads(NV_NUM_THREADS_OMP(x))
   for (i = 0; i < N; i++) {
@@ -871,6 +900,9 @@ realtype N_VWL2Norm_OpenMP(N_Vector x, N_Vector w)
   xd = NV_DATA_OMP(x);
   wd = NV_DATA_OMP(w);
 
+  if (NV_DETERMINISTIC_OMP(x))
+    return(SUNRsqrt(VDetSum_OpenMP(DET_WSQRSUM, x, w, NULL)));
+
 #pragma omp parallel for default(none) private(i) shared(N,xd,wd) \
   reduction(+:sum) schedule(static) num_threads(NV_NUM_THREADS_OMP(x))
   for (i = 0; i < N; i++) {
@@ -897,6 +929,9 @@ realtype N_VL1Norm_OpenMP(N_Vector x)
   N  = NV_LENGTH_OMP(x);
   xd = NV_DATA_OMP(x);
 
+  if (NV_DETERMINISTIC_OMP(x))
+    return(VDetSum_OpenMP(DET_L1NORM, x, NULL, NULL));
+
 #pragma omp parallel for default(none) private(i) shared(N,xd) \
   reduction(+:sum) schedule(static) num_threads(NV_NUM_THREADS_OMP(x))
   for (i = 0; i<N; i++)
@@ -1066,6 +1101,9 @@ realtype N_VWSqrSumLocal_OpenMP(N_Vector x, N_Vector w)
   xd = NV_DATA_OMP(x);
   wd = NV_DATA_OMP(w);
 
+  if (NV_DETERMINISTIC_OMP(x))
+    return(VDetSum_OpenMP(DET_WSQRSUM, x, w, NULL));
+
 #pragma omp parallel for default(none) private(i) shared(N,xd,wd) \
   reduction(+:sum) schedule(static) num_threads(NV_NUM_THREADS_OMP(x))
   for (i = 0; i < N; i++) {
@@ -1094,6 +1132,9 @@ realtype N_VWSqrSumMaskLocal_OpenMP(N_Vector x, N_Vector w, N_Vector id)
   wd  = NV_DATA_OMP(w);
   idd = NV_DATA_OMP(id);
 
+  if (NV_DETERMINISTIC_OMP(x))
+    return(VDetSum_OpenMP(DET_WSQRSUMMASK, x, w, id));
+
 #pragma omp parallel for default(none) private(i) shared(N,xd,wd,idd) \
   reduction(+:sum) schedule(static) num_threads(NV_NUM_THREADS_OMP(x))
   for (i = 0; i < N; i++) {
@@ -1288,6 +1329,13 @@ int N_VDotProdMulti_OpenMP(int nvec, N_Vector x, N_Vector* Y, realtype* dotprods
     return(0);
   }
 
+  /* deterministic reductions, one vector at a time */
+  if (NV_DETERMINISTIC_OMP(x)) {
+    for (i=0; i<nvec; i++)
+      dotprods[i] = VDetSum_OpenMP(DET_DOTPROD, x, Y[i], NULL);
+    return(0);
+  }
+
   /* get vector length and data array */
   N  = NV_LENGTH_OMP(x);
   xd = NV_DATA_OMP(x);
@@ -1550,6 +1598,13 @@ int N_VWrmsNormVectorArray_OpenMP(int nvec, N_Vector* X, N_Vector* W, realtype*
   /* get vector length */
   N  = NV_LENGTH_OMP(X[0]);
 
+  /* deterministic reductions, one vector at a time */
+  if (NV_DETERMINISTIC_OMP(X[0])) {
+    for (i=0; i<nvec; i++)
+      nrm[i] = SUNRsqrt(VDetSum_OpenMP(DET_WSQRSUM, X[i], W[i], NULL)/N);
+    return(0);
+  }
+
   /* initialize norms */
   for (i=0; i<nvec; i++) {
     nrm[i] = ZERO;
@@ -1608,6 +1663,13 @@ int N_VWrmsNormMaskVectorArray_OpenMP(int nvec, N_Vector* X, N_Vector* W,
   N   = NV_LENGTH_OMP(X[0]);
   idd = NV_DATA_OMP(id);
 
+  /* deterministic reductions, one vector at a time */
+  if (NV_DETERMINISTIC_OMP(X[0])) {
+    for (i=0; i<nvec; i++)
+      nrm[i] = SUNRsqrt(VDetSum_OpenMP(DET_WSQRSUMMASK, X[i], W[i], id)/N);
+    return(0);
+  }
+
   /* initialize norms */
   for (i=0; i<nvec; i++) {
     nrm[i] = ZERO;
@@ -1963,6 +2025,50 @@ int N_VBufUnpack_OpenMP(N_Vector x, void *buf)
 }
 
 
+/*
+ * -----------------------------------------------------------------
+ * private function to allocate the data array of a vector, from the
+ * memory helper if there is one and with malloc otherwise
+ *
+ * The array is zeroed by the threads of the vector with the static
+ * schedule of the vector kernels, so that on NUMA systems each page
+ * is placed by first touch on the node of the thread that works on
+ * it in all later operations.
+ * -----------------------------------------------------------------
+ */
+
+static int VAllocData_OpenMP(N_Vector v, SUNMemoryHelper helper)
+{
+  sunindextype i, length;
+  realtype *data;
+
+  length = NV_LENGTH_OMP(v);
+  if (length <= 0) return(0);
+
+  if (helper != NULL) {
+    if (SUNMemoryHelper_Alloc(helper, &(NV_CONTENT_OMP(v)->data_mem),
+                              length * sizeof(realtype), SUNMEMTYPE_HOST))
+      return(-1);
+    data = (realtype *) NV_CONTENT_OMP(v)->data_mem->ptr;
+    NV_CONTENT_OMP(v)->mem_helper = helper;
+  } else {
+    data = (realtype *) malloc(length * sizeof(realtype));
+    if (data == NULL) return(-1);
+  }
+
+  /* First touch by the threads that use the data */
+#pragma omp parallel for default(none) private(i) shared(length,data) schedule(static) \
+   num_threads(NV_NUM_THREADS_OMP(v))
+  for (i = 0; i < length; i++)
+    data[i] = ZERO;
+
+  /* Attach data */
+  NV_OWN_DATA_OMP(v) = SUNTRUE;
+  NV_DATA_OMP(v)     = data;
+
+  return(0);
+}
+
 /*
  * -----------------------------------------------------------------
  * private functions for special cases of vector operations
@@ -2478,6 +2584,74 @@ static int VaxpyVectorArray_OpenMP(int nvec, realtype a, N_Vector* X, N_Vector*
 }
 
 
+/*
+ * -----------------------------------------------------------------
+ * private function for deterministic sum reductions
+ *
+ * The elements are split into chunks that depend on the vector length
+ * only. The partial sums of the chunks are computed by the threads in
+ * order of the elements, and then combined by the calling thread in a
+ * fixed pairwise tree. The result is therefore the same in every run
+ * and for any number of threads, unlike with a reduction clause or a
+ * critical section, where the partial sums of the threads are added
+ * in the order in which the threads finish.
+ * -----------------------------------------------------------------
+ */
+
+static realtype VDetSum_OpenMP(int kind, N_Vector x, N_Vector y, N_Vector id)
+{
+  sunindextype c, i, N, chunk, nchunks, start, end, stride;
+  realtype sum, *xd, *yd, *idd;
+  realtype partial[DET_MAX_CHUNKS];
+
+  N   = NV_LENGTH_OMP(x);
+  xd  = NV_DATA_OMP(x);
+  yd  = (y  == NULL) ? NULL : NV_DATA_OMP(y);
+  idd = (id == NULL) ? NULL : NV_DATA_OMP(id);
+
+  if (N <= 0) return(ZERO);
+
+  chunk = (N + DET_MAX_CHUNKS - 1) / DET_MAX_CHUNKS;
+  if (chunk < DET_MIN_CHUNK) chunk = DET_MIN_CHUNK;
+  nchunks = (N + chunk - 1) / chunk;
+
+#pragma omp parallel for default(none) private(c,i,start,end,sum) \
+  shared(kind,N,chunk,nchunks,xd,yd,idd,partial) schedule(static) \
+  num_threads(NV_NUM_THREADS_OMP(x))
+  for (c = 0; c < nchunks; c++) {
+    start = c*chunk;
+    end   = (start + chunk < N) ? start + chunk : N;
+    sum   = ZERO;
+    switch (kind) {
+    case DET_DOTPROD:
+      for (i = start; i < end; i++)
+        sum += xd[i]*yd[i];
+      break;
+    case DET_WSQRSUM:
+      for (i = start; i < end; i++)
+        sum += SUNSQR(xd[i]*yd[i]);
+      break;
+    case DET_WSQRSUMMASK:
+      for (i = start; i < end; i++)
+        if (idd[i] > ZERO) sum += SUNSQR(xd[i]*yd[i]);
+      break;
+    default:
+      for (i = start; i < end; i++)
+        sum += SUNRabs(xd[i]);
+      break;
+    }
+    partial[c] = sum;
+  }
+
+  /* combine the partial sums pairwise */
+  for (stride = 1; stride < nchunks; stride *= 2)
+    for (c = 0; c + stride < nchunks; c += 2*stride)
+      partial[c] += partial[c + stride];
+
+  return(partial[0]);
+}
+
+
 /*
  * -----------------------------------------------------------------
  * Enable / Disable fused and vector array operations
@@ -2704,3 +2878,24 @@ int N_VEnableLinearCombinationVectorArray_OpenMP(N_Vector v, booleantype tf)
   /* return success */
   return(0);
 }
+
+
+/*
+ * -----------------------------------------------------------------
+ * Enable / Disable deterministic reductions
+ * -----------------------------------------------------------------
+ */
+
+int N_VSetDeterministicReductions_OpenMP(N_Vector v, booleantype tf)
+{
+  /* check that vector is non-NULL */
+  if (v == NULL) return(-1);
+
+  /* check that content structure is non-NULL */
+  if (v->content == NULL) return(-1);
+
+  NV_DETERMINISTIC_OMP(v) = tf;
+
+  /* return success */
+  return(0);
+}
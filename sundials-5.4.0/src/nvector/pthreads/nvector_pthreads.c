@@ -33,6 +33,35 @@
 #define ONE    RCONST(1.0)
 #define ONEPT5 RCONST(1.5)
 
+/* Worker thread of a team and the team itself. The thread calling a vector
+   operation is member 0 of the team, the workers wait on start_cond for the
+   next operation and signal done_cond when the last of them has finished. */
+
+struct _Pthreads_Worker {
+  pthread_t thread;           /* worker thread                 */
+  Pthreads_Team team;         /* team of the worker            */
+  int id;                     /* index of the thread data used */
+};
+
+struct _Pthreads_Team {
+  int num_threads;            /* team size incl. calling thread     */
+  int refcount;               /* number of vectors using the team   */
+  struct _Pthreads_Worker *workers; /* num_threads-1 worker threads */
+
+  pthread_mutex_t run_mutex;  /* serializes operations on the team  */
+  pthread_mutex_t mutex;      /* protects the fields below          */
+  pthread_cond_t start_cond;  /* signals a new operation or stop    */
+  pthread_cond_t done_cond;   /* signals that the workers finished  */
+
+  unsigned long generation;   /* incremented for every operation    */
+  int pending;                /* workers still running an operation */
+  int shutdown;               /* workers exit when set              */
+
+  void *(*func)(void *);      /* companion function of operation    */
+  Pthreads_Data *thread_data; /* thread data of operation           */
+  int nactive;                /* number of thread data entries      */
+};
+
 /* Private functions for special cases of vector operations */
 static void VCopy_Pthreads(N_Vector x, N_Vector z);                              /* z=x       */
 static void VSum_Pthreads(N_Vector x, N_Vector y, N_Vector z);                   /* z=x+y     */
@@ -75,6 +104,21 @@ static void *N_VWSqrSumMask_PT(void *thread_data);
 static void *N_VConstrMask_PT(void *thread_data);
 static void *N_VMinQuotient_PT(void *thread_data);
 
+/* Private function for deterministic sum reductions and its companion */
+static realtype VDetSum_Pthreads(int kind, N_Vector x, N_Vector y, N_Vector id);
+static void *VDetSum_PT(void *thread_data);
+
+/* Sums computed by VDetSum_Pthreads */
+#define DET_DOTPROD     0   /* sum(x[i]*y[i])               */
+#define DET_WSQRSUM     1   /* sum((x[i]*w[i])^2)           */
+#define DET_WSQRSUMMASK 2   /* sum((x[i]*w[i])^2), id[i] > 0 */
+#define DET_L1NORM      3   /* sum(|x[i]|)                  */
+
+/* Chunks of deterministic reductions: at most DET_MAX_CHUNKS of at least
+   DET_MIN_CHUNK elements each, the chunking depends on the length only */
+#define DET_MAX_CHUNKS 256
+#define DET_MIN_CHUNK  4096
+
 /* Pthread companion functions special cases of vector operations */
 static void *VCopy_PT(void *thread_data);
 static void *VSum_PT(void *thread_data);
@@ -121,6 +165,16 @@ static void N_VSplitLoop(int myid, int *nthreads, sunindextype *N,
 /* Function to initialize thread data */
 static void N_VInitThreadData(Pthreads_Data *thread_data);
 
+/* Functions to manage the persistent thread team shared by a vector and its clones */
+static Pthreads_Team N_VNewTeam_Pthreads(int num_threads);
+static Pthreads_Team N_VRetainTeam_Pthreads(Pthreads_Team team);
+static void N_VReleaseTeam_Pthreads(Pthreads_Team team);
+static void N_VRunTeam_Pthreads(Pthreads_Team team, void *(*func)(void *),
+                                Pthreads_Data *thread_data, int nthreads);
+static void *N_VTeamWorker_PT(void *worker);
+
+#define NV_TEAM_PT(v) ( NV_CONTENT_PT(v)->team )
+
 /*
  * -----------------------------------------------------------------
  * exported functions
@@ -214,6 +268,12 @@ N_Vector N_VNewEmpty_Pthreads(sunindextype length, int num_threads)
   content->num_threads = num_threads;
   content->own_data    = SUNFALSE;
   content->data        = NULL;
+  content->team        = NULL;
+  content->deterministic = SUNFALSE;
+
+  /* Start the worker threads, shared with all clones of the vector */
+  content->team = N_VNewTeam_Pthreads(num_threads);
+  if (content->team == NULL) { N_VDestroy(v); return(NULL); }
 
   return(v);
 }
@@ -421,6 +481,8 @@ N_Vector N_VCloneEmpty_Pthreads(N_Vector w)
   content->num_threads = NV_NUM_THREADS_PT(w);
   content->own_data    = SUNFALSE;
   content->data        = NULL;
+  content->team        = N_VRetainTeam_Pthreads(NV_TEAM_PT(w));
+  content->deterministic = NV_DETERMINISTIC_PT(w);
 
   return(v);
 }
@@ -473,6 +535,7 @@ void N_VDestroy_Pthreads(N_Vector v)
       free(NV_DATA_PT(v));
       NV_DATA_PT(v) = NULL;
     }
+    N_VReleaseTeam_Pthreads(NV_TEAM_PT(v));
     free(v->content);
     v->content = NULL;
   }
@@ -527,9 +590,7 @@ void N_VLinearSum_Pthreads(realtype a, N_Vector x, realtype b, N_Vector y, N_Vec
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   realtype c;
   N_Vector v1, v2;
@@ -602,16 +663,11 @@ void N_VLinearSum_Pthreads(realtype a, N_Vector x, realtype b, N_Vector y, N_Vec
      (2) a == 0.0, b == other - user should have called N_VScale
      (3) a,b == other, a !=b, a != -b */
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = (pthread_t *) malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -625,19 +681,12 @@ void N_VLinearSum_Pthreads(realtype a, N_Vector x, realtype b, N_Vector y, N_Vec
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VLinearSum_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VLinearSum_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -672,7 +721,7 @@ static void *N_VLinearSum_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -684,20 +733,13 @@ void N_VConst_Pthreads(realtype c, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(z);
   nthreads     = NV_NUM_THREADS_PT(z);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -708,19 +750,12 @@ void N_VConst_Pthreads(realtype c, N_Vector z)
     /* pack thread data */
     thread_data[i].c1 = c;
     thread_data[i].v1 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VConst_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(z), N_VConst_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -752,7 +787,7 @@ static void *N_VConst_PT(void *thread_data)
     zd[i] = c;
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -764,20 +799,13 @@ void N_VProd_Pthreads(N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -789,19 +817,12 @@ void N_VProd_Pthreads(N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VProd_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VProd_PT, thread_data, nthreads);
 
   /* clean up and exit */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -832,7 +853,7 @@ static void *N_VProd_PT(void *thread_data)
     zd[i] = xd[i]*yd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -844,20 +865,13 @@ void N_VDiv_Pthreads(N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -869,19 +883,12 @@ void N_VDiv_Pthreads(N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VDiv_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VDiv_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -913,7 +920,7 @@ static void *N_VDiv_PT(void *thread_data)
     zd[i] = xd[i]/yd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -925,9 +932,7 @@ void N_VScale_Pthreads(realtype c, N_Vector x, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   if (z == x) {  /* BLAS usage: scale x <- cx */
     VScaleBy_Pthreads(c, x);
@@ -939,16 +944,11 @@ void N_VScale_Pthreads(realtype c, N_Vector x, N_Vector z)
   } else if (c == -ONE) {
     VNeg_Pthreads(x, z);
   } else {
-    /* allocate threads and thread data structs */
+    /* allocate thread data structs */
     N            = NV_LENGTH_PT(x);
     nthreads     = NV_NUM_THREADS_PT(x);
-    threads      = malloc(nthreads*sizeof(pthread_t));
     thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-    /* set thread attributes */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
     for (i=0; i<nthreads; i++) {
       /* initialize thread data */
       N_VInitThreadData(&thread_data[i]);
@@ -960,19 +960,12 @@ void N_VScale_Pthreads(realtype c, N_Vector x, N_Vector z)
       thread_data[i].c1 = c;
       thread_data[i].v1 = NV_DATA_PT(x);
       thread_data[i].v2 = NV_DATA_PT(z);
-
-      /* create threads and call pthread companion function */
-      pthread_create(&threads[i], &attr, N_VScale_PT, (void *) &thread_data[i]);
     }
 
-    /* wait for all threads to finish */
-    for (i=0; i<nthreads; i++) {
-      pthread_join(threads[i], NULL);
-    }
+    /* run companion function on the thread team and wait for it */
+    N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VScale_PT, thread_data, nthreads);
 
     /* clean up */
-    pthread_attr_destroy(&attr);
-    free(threads);
     free(thread_data);
   }
 
@@ -1006,7 +999,7 @@ static void *N_VScale_PT(void *thread_data)
     zd[i] = c*xd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1018,20 +1011,13 @@ void N_VAbs_Pthreads(N_Vector x, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -1042,19 +1028,12 @@ void N_VAbs_Pthreads(N_Vector x, N_Vector z)
     /* pack thread data */
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VAbs_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VAbs_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -1085,7 +1064,7 @@ static void *N_VAbs_PT(void *thread_data)
     zd[i] = SUNRabs(xd[i]);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1097,20 +1076,13 @@ void N_VInv_Pthreads(N_Vector x, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -1121,19 +1093,12 @@ void N_VInv_Pthreads(N_Vector x, N_Vector z)
     /* pack thread data */
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VInv_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VInv_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -1164,7 +1129,7 @@ static void *N_VInv_PT(void *thread_data)
     zd[i] = ONE/xd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1176,20 +1141,13 @@ void N_VAddConst_Pthreads(N_Vector x, realtype b, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -1201,19 +1159,12 @@ void N_VAddConst_Pthreads(N_Vector x, realtype b, N_Vector z)
     thread_data[i].c1 = b;
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VAddConst_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VAddConst_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -1246,7 +1197,7 @@ static void *N_VAddConst_PT(void *thread_data)
     zd[i] = xd[i] + b;
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1258,22 +1209,18 @@ realtype N_VDotProd_Pthreads(N_Vector x, N_Vector y)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        sum = ZERO;
 
-  /* allocate threads and thread data structs */
+  if (NV_DETERMINISTIC_PT(x))
+    return(VDetSum_Pthreads(DET_DOTPROD, x, y, NULL));
+
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -1289,20 +1236,13 @@ realtype N_VDotProd_Pthreads(N_Vector x, N_Vector y)
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].global_val   = &sum;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VDotProd_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VDotProd_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(sum);
@@ -1344,7 +1284,7 @@ static void *N_VDotProd_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1356,22 +1296,15 @@ realtype N_VMaxNorm_Pthreads(N_Vector x)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        max = ZERO;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -1386,20 +1319,13 @@ realtype N_VMaxNorm_Pthreads(N_Vector x)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].global_val   = &max;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VMaxNorm_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VMaxNorm_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(max);
@@ -1442,7 +1368,7 @@ static void *N_VMaxNorm_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1464,22 +1390,18 @@ realtype N_VWSqrSumLocal_Pthreads(N_Vector x, N_Vector w)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        sum = ZERO;
 
-  /* allocate threads and thread data structs */
+  if (NV_DETERMINISTIC_PT(x))
+    return(VDetSum_Pthreads(DET_WSQRSUM, x, w, NULL));
+
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -1495,20 +1417,13 @@ realtype N_VWSqrSumLocal_Pthreads(N_Vector x, N_Vector w)
     thread_data[i].v2 = NV_DATA_PT(w);
     thread_data[i].global_val   = &sum;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VWSqrSum_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VWSqrSum_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(sum);
@@ -1550,7 +1465,7 @@ static void *N_VWSqrSum_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1572,22 +1487,18 @@ realtype N_VWSqrSumMaskLocal_Pthreads(N_Vector x, N_Vector w, N_Vector id)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        sum = ZERO;
 
-  /* allocate threads and thread data structs */
+  if (NV_DETERMINISTIC_PT(x))
+    return(VDetSum_Pthreads(DET_WSQRSUMMASK, x, w, id));
+
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -1604,20 +1515,13 @@ realtype N_VWSqrSumMaskLocal_Pthreads(N_Vector x, N_Vector w, N_Vector id)
     thread_data[i].v3 = NV_DATA_PT(id);
     thread_data[i].global_val   = &sum;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VWSqrSumMask_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VWSqrSumMask_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(sum);
@@ -1662,7 +1566,7 @@ static void *N_VWSqrSumMask_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1674,25 +1578,18 @@ realtype N_VMin_Pthreads(N_Vector x)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        min;
 
   /* initialize global min */
   min = NV_Ith_PT(x,0);
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -1707,20 +1604,13 @@ realtype N_VMin_Pthreads(N_Vector x)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].global_val   = &min;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VMin_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VMin_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(min);
@@ -1751,7 +1641,7 @@ static void *N_VMin_PT(void *thread_data)
   end   = my_data->end;
 
   /* find local min */
-  local_min = *global_min;
+  local_min = xd[0];  /* initial value of *global_min, read without the lock */
   for (i = start; i < end; i++) {
     if (xd[i] < local_min)
       local_min = xd[i];
@@ -1764,7 +1654,7 @@ static void *N_VMin_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1776,22 +1666,18 @@ realtype N_VWL2Norm_Pthreads(N_Vector x, N_Vector w)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        sum = ZERO;
 
-  /* allocate threads and thread data structs */
+  if (NV_DETERMINISTIC_PT(x))
+    return(SUNRsqrt(VDetSum_Pthreads(DET_WSQRSUM, x, w, NULL)));
+
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -1807,20 +1693,13 @@ realtype N_VWL2Norm_Pthreads(N_Vector x, N_Vector w)
     thread_data[i].v2 = NV_DATA_PT(w);
     thread_data[i].global_val   = &sum;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VWL2Norm_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VWL2Norm_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(SUNRsqrt(sum));
@@ -1862,7 +1741,7 @@ static void *N_VWL2Norm_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1874,22 +1753,18 @@ realtype N_VL1Norm_Pthreads(N_Vector x)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        sum = ZERO;
 
-  /* allocate threads and thread data structs */
+  if (NV_DETERMINISTIC_PT(x))
+    return(VDetSum_Pthreads(DET_L1NORM, x, NULL, NULL));
+
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -1904,20 +1779,13 @@ realtype N_VL1Norm_Pthreads(N_Vector x)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].global_val   = &sum;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VL1Norm_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VL1Norm_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(sum);
@@ -1958,7 +1826,7 @@ static void *N_VL1Norm_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -1970,20 +1838,13 @@ void N_VCompare_Pthreads(realtype c, N_Vector x, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -1995,19 +1856,12 @@ void N_VCompare_Pthreads(realtype c, N_Vector x, N_Vector z)
     thread_data[i].c1  = c;
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VCompare_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VCompare_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -2039,7 +1893,7 @@ static void *N_VCompare_PT(void *thread_data)
     zd[i] = (SUNRabs(xd[i]) >= c) ? ONE : ZERO;
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2051,22 +1905,15 @@ booleantype N_VInvTest_Pthreads(N_Vector x, N_Vector z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   realtype val = ZERO;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -2078,19 +1925,12 @@ booleantype N_VInvTest_Pthreads(N_Vector x, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(z);
     thread_data[i].global_val = &val;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VInvTest_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VInvTest_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   if (val > ZERO)
@@ -2137,7 +1977,7 @@ static void *N_VInvTest_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2149,22 +1989,15 @@ booleantype N_VConstrMask_Pthreads(N_Vector c, N_Vector x, N_Vector m)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   realtype val = ZERO;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -2177,19 +2010,12 @@ booleantype N_VConstrMask_Pthreads(N_Vector c, N_Vector x, N_Vector m)
     thread_data[i].v2 = NV_DATA_PT(x);
     thread_data[i].v3 = NV_DATA_PT(m);
     thread_data[i].global_val = &val;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VConstrMask_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VConstrMask_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   if (val > ZERO)
@@ -2244,7 +2070,7 @@ static void *N_VConstrMask_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2256,22 +2082,15 @@ realtype N_VMinQuotient_Pthreads(N_Vector num, N_Vector denom)
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
   realtype        min = BIG_REAL;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(num);
   nthreads    = NV_NUM_THREADS_PT(num);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -2287,20 +2106,13 @@ realtype N_VMinQuotient_Pthreads(N_Vector num, N_Vector denom)
     thread_data[i].v2 = NV_DATA_PT(denom);
     thread_data[i].global_val   = &min;
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VMinQuotient_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(num), N_VMinQuotient_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(min);
@@ -2346,7 +2158,7 @@ static void *N_VMinQuotient_PT(void *thread_data)
   pthread_mutex_unlock(global_mutex);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2365,9 +2177,7 @@ int N_VLinearCombination_Pthreads(int nvec, realtype* c, N_Vector* X, N_Vector z
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   /* invalid number of vectors */
   if (nvec < 1) return(-1);
@@ -2387,13 +2197,8 @@ int N_VLinearCombination_Pthreads(int nvec, realtype* c, N_Vector* X, N_Vector z
   /* get vector length and data array */
   N           = NV_LENGTH_PT(z);
   nthreads    = NV_NUM_THREADS_PT(z);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -2406,19 +2211,12 @@ int N_VLinearCombination_Pthreads(int nvec, realtype* c, N_Vector* X, N_Vector z
     thread_data[i].cvals = c;
     thread_data[i].Y1    = X;
     thread_data[i].x1    = z;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VLinearCombination_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(z), N_VLinearCombination_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -2458,7 +2256,7 @@ static void *N_VLinearCombination_PT(void *thread_data)
         zd[j] += c[i] * xd[j];
       }
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   /*
@@ -2474,7 +2272,7 @@ static void *N_VLinearCombination_PT(void *thread_data)
         zd[j] += c[i] * xd[j];
       }
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   /*
@@ -2490,7 +2288,7 @@ static void *N_VLinearCombination_PT(void *thread_data)
       zd[j] += c[i] * xd[j];
     }
   }
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2502,9 +2300,7 @@ int N_VScaleAddMulti_Pthreads(int nvec, realtype* a, N_Vector x, N_Vector* Y, N_
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   /* invalid number of vectors */
   if (nvec < 1) return(-1);
@@ -2518,13 +2314,8 @@ int N_VScaleAddMulti_Pthreads(int nvec, realtype* a, N_Vector x, N_Vector* Y, N_
   /* get vector length and data array */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -2538,19 +2329,12 @@ int N_VScaleAddMulti_Pthreads(int nvec, realtype* a, N_Vector x, N_Vector* Y, N_
     thread_data[i].x1    = x;
     thread_data[i].Y1    = Y;
     thread_data[i].Y2    = Z;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VScaleAddMulti_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VScaleAddMulti_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -2591,7 +2375,7 @@ static void *N_VScaleAddMulti_PT(void *thread_data)
         yd[j] += a[i] * xd[j];
       }
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   /*
@@ -2604,7 +2388,7 @@ static void *N_VScaleAddMulti_PT(void *thread_data)
       zd[j] = a[i] * xd[j] + yd[j];
     }
   }
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2616,9 +2400,7 @@ int N_VDotProdMulti_Pthreads(int nvec, N_Vector x, N_Vector* Y, realtype* dotpro
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
 
   /* invalid number of vectors */
@@ -2630,20 +2412,22 @@ int N_VDotProdMulti_Pthreads(int nvec, N_Vector x, N_Vector* Y, realtype* dotpro
     return(0);
   }
 
+  /* deterministic reductions, one vector at a time */
+  if (NV_DETERMINISTIC_PT(x)) {
+    for (i=0; i<nvec; i++)
+      dotprods[i] = VDetSum_Pthreads(DET_DOTPROD, x, Y[i], NULL);
+    return(0);
+  }
+
   /* initialize output array */
   for (i=0; i<nvec; i++)
     dotprods[i] = ZERO;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -2661,20 +2445,13 @@ int N_VDotProdMulti_Pthreads(int nvec, N_Vector x, N_Vector* Y, realtype* dotpro
     thread_data[i].cvals = dotprods;
 
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VDotProdMulti_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), N_VDotProdMulti_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -2721,7 +2498,7 @@ static void *N_VDotProdMulti_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2741,9 +2518,7 @@ int N_VLinearSumVectorArray_Pthreads(int nvec, realtype a, N_Vector* X,
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   realtype    c;
   N_Vector*  V1;
@@ -2818,13 +2593,8 @@ int N_VLinearSumVectorArray_Pthreads(int nvec, realtype a, N_Vector* X,
   /* get vector length and data array */
   N           = NV_LENGTH_PT(Z[0]);
   nthreads    = NV_NUM_THREADS_PT(Z[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -2839,20 +2609,12 @@ int N_VLinearSumVectorArray_Pthreads(int nvec, realtype a, N_Vector* X,
     thread_data[i].Y1   = X;
     thread_data[i].Y2   = Y;
     thread_data[i].Y3   = Z;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VLinearSumVectorArray_PT,
-                   (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(Z[0]), N_VLinearSumVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -2894,7 +2656,7 @@ static void *N_VLinearSumVectorArray_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -2906,9 +2668,7 @@ int N_VScaleVectorArray_Pthreads(int nvec, realtype* c, N_Vector* X, N_Vector* Z
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   /* invalid number of vectors */
   if (nvec < 1) return(-1);
@@ -2922,13 +2682,8 @@ int N_VScaleVectorArray_Pthreads(int nvec, realtype* c, N_Vector* X, N_Vector* Z
   /* get vector length and data array */
   N           = NV_LENGTH_PT(Z[0]);
   nthreads    = NV_NUM_THREADS_PT(Z[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -2941,20 +2696,12 @@ int N_VScaleVectorArray_Pthreads(int nvec, realtype* c, N_Vector* X, N_Vector* Z
     thread_data[i].cvals = c;
     thread_data[i].Y1    = X;
     thread_data[i].Y2    = Z;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VScaleVectorArray_PT,
-                   (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(Z[0]), N_VScaleVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -2993,7 +2740,7 @@ static void *N_VScaleVectorArray_PT(void *thread_data)
         xd[j] *= c[i];
       }
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   /*
@@ -3006,7 +2753,7 @@ static void *N_VScaleVectorArray_PT(void *thread_data)
       zd[j] = c[i] * xd[j];
     }
   }
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3018,9 +2765,7 @@ int N_VConstVectorArray_Pthreads(int nvec, realtype c, N_Vector* Z)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   /* invalid number of vectors */
   if (nvec < 1) return(-1);
@@ -3034,13 +2779,8 @@ int N_VConstVectorArray_Pthreads(int nvec, realtype c, N_Vector* Z)
   /* get vector length and data array */
   N           = NV_LENGTH_PT(Z[0]);
   nthreads    = NV_NUM_THREADS_PT(Z[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -3052,20 +2792,12 @@ int N_VConstVectorArray_Pthreads(int nvec, realtype c, N_Vector* Z)
     thread_data[i].nvec = nvec;
     thread_data[i].c1   = c;
     thread_data[i].Y1   = Z;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VConstVectorArray_PT,
-                   (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(Z[0]), N_VConstVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -3099,7 +2831,7 @@ static void *N_VConstVectorArray_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3111,9 +2843,7 @@ int N_VWrmsNormVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* W, realtype
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
 
   /* invalid number of vectors */
@@ -3125,20 +2855,23 @@ int N_VWrmsNormVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* W, realtype
     return(0);
   }
 
+  /* deterministic reductions, one vector at a time */
+  if (NV_DETERMINISTIC_PT(X[0])) {
+    for (i=0; i<nvec; i++)
+      nrm[i] = SUNRsqrt(VDetSum_Pthreads(DET_WSQRSUM, X[i], W[i], NULL) /
+                        NV_LENGTH_PT(X[0]));
+    return(0);
+  }
+
   /* initialize output array */
   for (i=0; i<nvec; i++)
     nrm[i] = ZERO;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -3156,25 +2889,17 @@ int N_VWrmsNormVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* W, realtype
     thread_data[i].cvals = nrm;
 
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VWrmsNormVectorArray_PT,
-                   (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), N_VWrmsNormVectorArray_PT, thread_data, nthreads);
 
   /* finalize wrms calculation */
   for (i=0; i<nvec; i++)
     nrm[i] = SUNRsqrt(nrm[i]/N);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -3221,7 +2946,7 @@ static void *N_VWrmsNormVectorArray_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3234,9 +2959,7 @@ int N_VWrmsNormMaskVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* W,
 {
   sunindextype    N;
   int             i, nthreads;
-  pthread_t       *threads;
   Pthreads_Data   *thread_data;
-  pthread_attr_t  attr;
   pthread_mutex_t global_mutex;
 
   /* invalid number of vectors */
@@ -3248,20 +2971,23 @@ int N_VWrmsNormMaskVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* W,
     return(0);
   }
 
+  /* deterministic reductions, one vector at a time */
+  if (NV_DETERMINISTIC_PT(X[0])) {
+    for (i=0; i<nvec; i++)
+      nrm[i] = SUNRsqrt(VDetSum_Pthreads(DET_WSQRSUMMASK, X[i], W[i], id) /
+                        NV_LENGTH_PT(X[0]));
+    return(0);
+  }
+
   /* initialize output array */
   for (i=0; i<nvec; i++)
     nrm[i] = ZERO;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   /* lock for reduction */
   pthread_mutex_init(&global_mutex, NULL);
 
@@ -3280,25 +3006,17 @@ int N_VWrmsNormMaskVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* W,
     thread_data[i].cvals = nrm;
 
     thread_data[i].global_mutex = &global_mutex;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VWrmsNormMaskVectorArray_PT,
-                   (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), N_VWrmsNormMaskVectorArray_PT, thread_data, nthreads);
 
   /* finalize wrms calculation */
   for (i=0; i<nvec; i++)
     nrm[i] = SUNRsqrt(nrm[i]/N);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&global_mutex);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -3348,7 +3066,7 @@ static void *N_VWrmsNormMaskVectorArray_PT(void *thread_data)
   }
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3361,9 +3079,7 @@ int N_VScaleAddMultiVectorArray_Pthreads(int nvec, int nsum, realtype* a,
 {
   sunindextype   N;
   int            i, j, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   int          retval;
   N_Vector*   YY;
@@ -3418,13 +3134,8 @@ int N_VScaleAddMultiVectorArray_Pthreads(int nvec, int nsum, realtype* a,
   /* get vector length and data array */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -3439,20 +3150,12 @@ int N_VScaleAddMultiVectorArray_Pthreads(int nvec, int nsum, realtype* a,
     thread_data[i].Y1    = X;
     thread_data[i].ZZ1   = Y;
     thread_data[i].ZZ2   = Z;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VScaleAddMultiVectorArray_PT,
-                   (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), N_VScaleAddMultiVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -3495,7 +3198,7 @@ static void *N_VScaleAddMultiVectorArray_PT(void *thread_data)
         }
       }
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   /*
@@ -3511,7 +3214,7 @@ static void *N_VScaleAddMultiVectorArray_PT(void *thread_data)
       }
     }
   }
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3524,9 +3227,7 @@ int N_VLinearCombinationVectorArray_Pthreads(int nvec, int nsum, realtype* c,
 {
   sunindextype   N;
   int            i, j, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   int          retval;
   realtype*    ctmp;
@@ -3599,13 +3300,8 @@ int N_VLinearCombinationVectorArray_Pthreads(int nvec, int nsum, realtype* c,
   /* get vector length and data array */
   N           = NV_LENGTH_PT(Z[0]);
   nthreads    = NV_NUM_THREADS_PT(Z[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -3619,20 +3315,12 @@ int N_VLinearCombinationVectorArray_Pthreads(int nvec, int nsum, realtype* c,
     thread_data[i].cvals = c;
     thread_data[i].ZZ1   = X;
     thread_data[i].Y1    = Z;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, N_VLinearCombinationVectorArray_PT,
-                   (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(Z[0]), N_VLinearCombinationVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -3675,7 +3363,7 @@ static void *N_VLinearCombinationVectorArray_PT(void *thread_data)
         }
       }
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   /*
@@ -3694,7 +3382,7 @@ static void *N_VLinearCombinationVectorArray_PT(void *thread_data)
         }
       }
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   /*
@@ -3713,7 +3401,7 @@ static void *N_VLinearCombinationVectorArray_PT(void *thread_data)
       }
     }
   }
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3745,22 +3433,15 @@ int N_VBufPack_Pthreads(N_Vector x, void *buf)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   if (x == NULL || buf == NULL) return(-1);
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -3771,19 +3452,12 @@ int N_VBufPack_Pthreads(N_Vector x, void *buf)
     /* pack thread data */
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = (realtype*)buf;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VBufPack_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VBufPack_PT, thread_data, nthreads);
 
   /* clean up */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -3815,7 +3489,7 @@ static void *VBufPack_PT(void *thread_data)
     bd[i] = xd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3827,22 +3501,15 @@ int N_VBufUnpack_Pthreads(N_Vector x, void *buf)
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
   if (x == NULL || buf == NULL) return(-1);
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(x);
   nthreads    = NV_NUM_THREADS_PT(x);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -3853,19 +3520,12 @@ int N_VBufUnpack_Pthreads(N_Vector x, void *buf)
     /* pack thread data */
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = (realtype*)buf;
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VBufUnpack_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VBufUnpack_PT, thread_data, nthreads);
 
   /* clean up */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -3897,7 +3557,7 @@ static void *VBufUnpack_PT(void *thread_data)
     xd[i] = bd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3916,20 +3576,13 @@ static void VCopy_Pthreads(N_Vector x, N_Vector z)
 {
   sunindextype      N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -3940,19 +3593,12 @@ static void VCopy_Pthreads(N_Vector x, N_Vector z)
     /* pack thread data */
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VCopy_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VCopy_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -3983,7 +3629,7 @@ static void *VCopy_PT(void *thread_data)
     zd[i] = xd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -3995,20 +3641,13 @@ static void VSum_Pthreads(N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype      N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4020,19 +3659,12 @@ static void VSum_Pthreads(N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VSum_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VSum_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4064,7 +3696,7 @@ static void *VSum_PT(void *thread_data)
     zd[i] = xd[i] + yd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4076,20 +3708,13 @@ static void VDiff_Pthreads(N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4101,19 +3726,12 @@ static void VDiff_Pthreads(N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VDiff_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VDiff_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4145,7 +3763,7 @@ static void *VDiff_PT(void *thread_data)
     zd[i] = xd[i] - yd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4157,20 +3775,13 @@ static void VNeg_Pthreads(N_Vector x, N_Vector z)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4181,19 +3792,12 @@ static void VNeg_Pthreads(N_Vector x, N_Vector z)
     /* pack thread data */
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VNeg_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VNeg_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4224,7 +3828,7 @@ static void *VNeg_PT(void *thread_data)
     zd[i] = -xd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4236,20 +3840,13 @@ static void VScaleSum_Pthreads(realtype c, N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4262,19 +3859,12 @@ static void VScaleSum_Pthreads(realtype c, N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VScaleSum_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VScaleSum_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4308,7 +3898,7 @@ static void *VScaleSum_PT(void *thread_data)
     zd[i] = c*(xd[i] + yd[i]);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4320,20 +3910,13 @@ static void VScaleDiff_Pthreads(realtype c, N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4346,19 +3929,12 @@ static void VScaleDiff_Pthreads(realtype c, N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VScaleDiff_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VScaleDiff_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4392,7 +3968,7 @@ static void *VScaleDiff_PT(void *thread_data)
     zd[i] = c*(xd[i] - yd[i]);
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4404,20 +3980,13 @@ static void VLin1_Pthreads(realtype a, N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4430,19 +3999,12 @@ static void VLin1_Pthreads(realtype a, N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VLin1_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VLin1_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4476,7 +4038,7 @@ static void *VLin1_PT(void *thread_data)
     zd[i] = (a*xd[i]) + yd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4488,20 +4050,13 @@ static void VLin2_Pthreads(realtype a, N_Vector x, N_Vector y, N_Vector z)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4514,19 +4069,12 @@ static void VLin2_Pthreads(realtype a, N_Vector x, N_Vector y, N_Vector z)
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
     thread_data[i].v3 = NV_DATA_PT(z);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VLin2_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VLin2_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4559,7 +4107,7 @@ static void *VLin2_PT(void *thread_data)
     zd[i] = (a*xd[i]) - yd[i];
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4571,20 +4119,13 @@ static void Vaxpy_Pthreads(realtype a, N_Vector x, N_Vector y)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4596,19 +4137,12 @@ static void Vaxpy_Pthreads(realtype a, N_Vector x, N_Vector y)
     thread_data[i].c1 = a;
     thread_data[i].v1 = NV_DATA_PT(x);
     thread_data[i].v2 = NV_DATA_PT(y);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, Vaxpy_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), Vaxpy_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4641,7 +4175,7 @@ static void *Vaxpy_PT(void *thread_data)
       yd[i] += xd[i];
 
     /* exit */
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   if (a == -ONE) {
@@ -4649,14 +4183,14 @@ static void *Vaxpy_PT(void *thread_data)
       yd[i] -= xd[i];
 
     /* exit */
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   for (i = start; i < end; i++)
     yd[i] += a*xd[i];
 
   /* return */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4668,20 +4202,13 @@ static void VScaleBy_Pthreads(realtype a, N_Vector x)
 {
   sunindextype  N;
   int           i, nthreads;
-  pthread_t     *threads;
   Pthreads_Data *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(x);
   nthreads     = NV_NUM_THREADS_PT(x);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
   for (i=0; i<nthreads; i++) {
     /* initialize thread data */
     N_VInitThreadData(&thread_data[i]);
@@ -4692,19 +4219,12 @@ static void VScaleBy_Pthreads(realtype a, N_Vector x)
     /* pack thread data */
     thread_data[i].c1 = a;
     thread_data[i].v1 = NV_DATA_PT(x);
-
-    /* create threads and call pthread companion function */
-    pthread_create(&threads[i], &attr, VScaleBy_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++) {
-    pthread_join(threads[i], NULL);
-  }
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VScaleBy_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return;
@@ -4736,7 +4256,7 @@ static void *VScaleBy_PT(void *thread_data)
     xd[i] *= a;
 
   /* exit */
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4750,21 +4270,14 @@ static int VSumVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* Y, N_Vector
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-  /* pack thread data, distribute loop indices, and create threads/call kernel */
+  /* pack thread data, distribute loop indices, and run kernel */
   for (i=0; i<nthreads; i++) {
     N_VInitThreadData(&thread_data[i]);
 
@@ -4775,16 +4288,12 @@ static int VSumVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* Y, N_Vector
 
     N_VSplitLoop(i, &nthreads, &N, &thread_data[i].start, &thread_data[i].end);
 
-    pthread_create(&threads[i], &attr, VSumVectorArray_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++)
-    pthread_join(threads[i], NULL);
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), VSumVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -4812,7 +4321,7 @@ static void *VSumVectorArray_PT(void *thread_data)
       zd[j] = xd[j] + yd[j];
   }
 
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4820,21 +4329,14 @@ static int VDiffVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* Y, N_Vecto
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-  /* pack thread data, distribute loop indices, and create threads/call kernel */
+  /* pack thread data, distribute loop indices, and run kernel */
   for (i=0; i<nthreads; i++) {
     N_VInitThreadData(&thread_data[i]);
 
@@ -4845,16 +4347,12 @@ static int VDiffVectorArray_Pthreads(int nvec, N_Vector* X, N_Vector* Y, N_Vecto
 
     N_VSplitLoop(i, &nthreads, &N, &thread_data[i].start, &thread_data[i].end);
 
-    pthread_create(&threads[i], &attr, VDiffVectorArray_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++)
-    pthread_join(threads[i], NULL);
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), VDiffVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -4882,7 +4380,7 @@ static void *VDiffVectorArray_PT(void *thread_data)
       zd[j] = xd[j] - yd[j];
   }
 
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4890,21 +4388,14 @@ static int VScaleSumVectorArray_Pthreads(int nvec, realtype c, N_Vector* X, N_Ve
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N            = NV_LENGTH_PT(X[0]);
   nthreads     = NV_NUM_THREADS_PT(X[0]);
-  threads      = malloc(nthreads*sizeof(pthread_t));
   thread_data  = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-  /* pack thread data, distribute loop indices, and create threads/call kernel */
+  /* pack thread data, distribute loop indices, and run kernel */
   for (i=0; i<nthreads; i++) {
     N_VInitThreadData(&thread_data[i]);
 
@@ -4916,16 +4407,12 @@ static int VScaleSumVectorArray_Pthreads(int nvec, realtype c, N_Vector* X, N_Ve
 
     N_VSplitLoop(i, &nthreads, &N, &thread_data[i].start, &thread_data[i].end);
 
-    pthread_create(&threads[i], &attr, VScaleSumVectorArray_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++)
-    pthread_join(threads[i], NULL);
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), VScaleSumVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -4955,7 +4442,7 @@ static void *VScaleSumVectorArray_PT(void *thread_data)
       zd[j] = c * (xd[j] + yd[j]);
   }
 
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -4963,21 +4450,14 @@ static int VScaleDiffVectorArray_Pthreads(int nvec, realtype c, N_Vector* X, N_V
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-  /* pack thread data, distribute loop indices, and create threads/call kernel */
+  /* pack thread data, distribute loop indices, and run kernel */
   for (i=0; i<nthreads; i++) {
     N_VInitThreadData(&thread_data[i]);
 
@@ -4989,16 +4469,12 @@ static int VScaleDiffVectorArray_Pthreads(int nvec, realtype c, N_Vector* X, N_V
 
     N_VSplitLoop(i, &nthreads, &N, &thread_data[i].start, &thread_data[i].end);
 
-    pthread_create(&threads[i], &attr, VScaleDiffVectorArray_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++)
-    pthread_join(threads[i], NULL);
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), VScaleDiffVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -5028,7 +4504,7 @@ static void *VScaleDiffVectorArray_PT(void *thread_data)
       zd[j] = c * (xd[j] - yd[j]);
   }
 
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -5036,21 +4512,14 @@ static int VLin1VectorArray_Pthreads(int nvec, realtype a, N_Vector* X, N_Vector
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-  /* pack thread data, distribute loop indices, and create threads/call kernel */
+  /* pack thread data, distribute loop indices, and run kernel */
   for (i=0; i<nthreads; i++) {
     N_VInitThreadData(&thread_data[i]);
 
@@ -5062,16 +4531,12 @@ static int VLin1VectorArray_Pthreads(int nvec, realtype a, N_Vector* X, N_Vector
 
     N_VSplitLoop(i, &nthreads, &N, &thread_data[i].start, &thread_data[i].end);
 
-    pthread_create(&threads[i], &attr, VLin1VectorArray_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++)
-    pthread_join(threads[i], NULL);
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), VLin1VectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -5101,7 +4566,7 @@ static void *VLin1VectorArray_PT(void *thread_data)
       zd[j] = (a * xd[j]) + yd[j];
   }
 
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -5109,21 +4574,14 @@ static int VLin2VectorArray_Pthreads(int nvec, realtype a, N_Vector* X, N_Vector
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-  /* pack thread data, distribute loop indices, and create threads/call kernel */
+  /* pack thread data, distribute loop indices, and run kernel */
   for (i=0; i<nthreads; i++) {
     N_VInitThreadData(&thread_data[i]);
 
@@ -5135,16 +4593,12 @@ static int VLin2VectorArray_Pthreads(int nvec, realtype a, N_Vector* X, N_Vector
 
     N_VSplitLoop(i, &nthreads, &N, &thread_data[i].start, &thread_data[i].end);
 
-    pthread_create(&threads[i], &attr, VLin2VectorArray_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++)
-    pthread_join(threads[i], NULL);
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), VLin2VectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -5174,7 +4628,7 @@ static void *VLin2VectorArray_PT(void *thread_data)
       zd[j] = (a * xd[j]) - yd[j];
   }
 
-  pthread_exit(NULL);
+  return(NULL);
 }
 
 
@@ -5182,21 +4636,14 @@ static int VaxpyVectorArray_Pthreads(int nvec, realtype a, N_Vector* X, N_Vector
 {
   sunindextype   N;
   int            i, nthreads;
-  pthread_t      *threads;
   Pthreads_Data  *thread_data;
-  pthread_attr_t attr;
 
-  /* allocate threads and thread data structs */
+  /* allocate thread data structs */
   N           = NV_LENGTH_PT(X[0]);
   nthreads    = NV_NUM_THREADS_PT(X[0]);
-  threads     = malloc(nthreads*sizeof(pthread_t));
   thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
 
-  /* set thread attributes */
-  pthread_attr_init(&attr);
-  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-  /* pack thread data, distribute loop indices, and create threads/call kernel */
+  /* pack thread data, distribute loop indices, and run kernel */
   for (i=0; i<nthreads; i++) {
     N_VInitThreadData(&thread_data[i]);
 
@@ -5207,16 +4654,12 @@ static int VaxpyVectorArray_Pthreads(int nvec, realtype a, N_Vector* X, N_Vector
 
     N_VSplitLoop(i, &nthreads, &N, &thread_data[i].start, &thread_data[i].end);
 
-    pthread_create(&threads[i], &attr, VaxpyVectorArray_PT, (void *) &thread_data[i]);
   }
 
-  /* wait for all threads to finish */
-  for (i=0; i<nthreads; i++)
-    pthread_join(threads[i], NULL);
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(X[0]), VaxpyVectorArray_PT, thread_data, nthreads);
 
   /* clean up and return */
-  pthread_attr_destroy(&attr);
-  free(threads);
   free(thread_data);
 
   return(0);
@@ -5244,7 +4687,7 @@ static void *VaxpyVectorArray_PT(void *thread_data)
       for (j=start; j<end; j++)
         yd[j] += xd[j];
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   if (a == -ONE) {
@@ -5254,7 +4697,7 @@ static void *VaxpyVectorArray_PT(void *thread_data)
       for (j=start; j<end; j++)
         yd[j] -= xd[j];
     }
-    pthread_exit(NULL);
+    return(NULL);
   }
 
   for (i=0; i<my_data->nvec; i++) {
@@ -5263,7 +4706,125 @@ static void *VaxpyVectorArray_PT(void *thread_data)
     for (j=start; j<end; j++)
       yd[j] += a * xd[j];
   }
-  pthread_exit(NULL);
+  return(NULL);
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * private function for deterministic sum reductions
+ *
+ * The elements are split into chunks that depend on the vector length
+ * only. Each thread computes the partial sums of a contiguous range of
+ * chunks, and the calling thread combines them in a fixed pairwise
+ * tree. The result is therefore the same in every run and for any
+ * number of threads, unlike with the locked global sum, to which the
+ * threads add their partial sums in the order in which they finish.
+ * -----------------------------------------------------------------
+ */
+
+static realtype VDetSum_Pthreads(int kind, N_Vector x, N_Vector y, N_Vector id)
+{
+  sunindextype  N, c, chunk, nchunks, stride;
+  int           i, nthreads;
+  Pthreads_Data *thread_data;
+  realtype      partial[DET_MAX_CHUNKS];
+
+  N = NV_LENGTH_PT(x);
+  if (N <= 0) return(ZERO);
+
+  chunk = (N + DET_MAX_CHUNKS - 1) / DET_MAX_CHUNKS;
+  if (chunk < DET_MIN_CHUNK) chunk = DET_MIN_CHUNK;
+  nchunks = (N + chunk - 1) / chunk;
+
+  /* allocate thread data structs, no more threads than chunks */
+  nthreads    = NV_NUM_THREADS_PT(x);
+  if (nthreads > nchunks) nthreads = (int) nchunks;
+  thread_data = (Pthreads_Data *) malloc(nthreads*sizeof(struct _Pthreads_Data));
+
+  for (i=0; i<nthreads; i++) {
+    /* initialize thread data */
+    N_VInitThreadData(&thread_data[i]);
+
+    /* compute start and end chunk for thread, converted to loop indices */
+    N_VSplitLoop(i, &nthreads, &nchunks, &thread_data[i].start, &thread_data[i].end);
+    thread_data[i].start *= chunk;
+    thread_data[i].end    = (thread_data[i].end*chunk < N) ? thread_data[i].end*chunk : N;
+
+    /* pack thread data */
+    thread_data[i].nvec  = kind;
+    thread_data[i].chunk = chunk;
+    thread_data[i].v1 = NV_DATA_PT(x);
+    thread_data[i].v2 = (y  == NULL) ? NULL : NV_DATA_PT(y);
+    thread_data[i].v3 = (id == NULL) ? NULL : NV_DATA_PT(id);
+    thread_data[i].global_val = partial;
+  }
+
+  /* run companion function on the thread team and wait for it */
+  N_VRunTeam_Pthreads(NV_TEAM_PT(x), VDetSum_PT, thread_data, nthreads);
+
+  free(thread_data);
+
+  /* combine the partial sums pairwise */
+  for (stride = 1; stride < nchunks; stride *= 2)
+    for (c = 0; c + stride < nchunks; c += 2*stride)
+      partial[c] += partial[c + stride];
+
+  return(partial[0]);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Pthread companion function to VDetSum_Pthreads
+ */
+
+static void *VDetSum_PT(void *thread_data)
+{
+  sunindextype i, start, end, cstart, cend, chunk;
+  realtype *xd, *yd, *idd, *partial;
+  realtype sum;
+  Pthreads_Data *my_data;
+
+  /* extract thread data */
+  my_data = (Pthreads_Data *) thread_data;
+
+  xd  = my_data->v1;
+  yd  = my_data->v2;
+  idd = my_data->v3;
+
+  partial = my_data->global_val;
+
+  start = my_data->start;
+  end   = my_data->end;
+  chunk = my_data->chunk;
+
+  /* compute the partial sum of each chunk */
+  for (cstart = start; cstart < end; cstart += chunk) {
+    cend = (cstart + chunk < end) ? cstart + chunk : end;
+    sum  = ZERO;
+    switch (my_data->nvec) {
+    case DET_DOTPROD:
+      for (i = cstart; i < cend; i++)
+        sum += xd[i]*yd[i];
+      break;
+    case DET_WSQRSUM:
+      for (i = cstart; i < cend; i++)
+        sum += SUNSQR(xd[i]*yd[i]);
+      break;
+    case DET_WSQRSUMMASK:
+      for (i = cstart; i < cend; i++)
+        if (idd[i] > ZERO) sum += SUNSQR(xd[i]*yd[i]);
+      break;
+    default:
+      for (i = cstart; i < cend; i++)
+        sum += SUNRabs(xd[i]);
+      break;
+    }
+    partial[cstart/chunk] = sum;
+  }
+
+  /* exit */
+  return(NULL);
 }
 
 
@@ -5305,6 +4866,7 @@ static void N_VInitThreadData(Pthreads_Data *thread_data)
 {
   thread_data->start = -1;
   thread_data->end   = -1;
+  thread_data->chunk = 0;
 
 #if __STDC_VERSION__ >= 199901L
   thread_data->c1 = NAN;
@@ -5329,6 +4891,197 @@ static void N_VInitThreadData(Pthreads_Data *thread_data)
 }
 
 
+/* ----------------------------------------------------------------------------
+ * Create a team of num_threads-1 worker threads. The thread calling a vector
+ * operation works on the first part of the loop itself, the workers sleep on
+ * a condition variable between operations.
+ */
+
+static Pthreads_Team N_VNewTeam_Pthreads(int num_threads)
+{
+  Pthreads_Team team;
+  int i;
+
+  team = NULL;
+  team = (Pthreads_Team) malloc(sizeof *team);
+  if (team == NULL) return(NULL);
+
+  team->num_threads = (num_threads > 1) ? num_threads : 1;
+  team->refcount    = 1;
+  team->generation  = 0;
+  team->pending     = 0;
+  team->shutdown    = 0;
+  team->nactive     = 0;
+  team->func        = NULL;
+  team->thread_data = NULL;
+  team->workers     = NULL;
+
+  pthread_mutex_init(&team->run_mutex, NULL);
+  pthread_mutex_init(&team->mutex, NULL);
+  pthread_cond_init(&team->start_cond, NULL);
+  pthread_cond_init(&team->done_cond, NULL);
+
+  if (team->num_threads == 1) return(team);
+
+  team->workers = (struct _Pthreads_Worker *)
+    malloc((team->num_threads-1) * sizeof(struct _Pthreads_Worker));
+  if (team->workers == NULL) {
+    team->num_threads = 1;
+    N_VReleaseTeam_Pthreads(team);
+    return(NULL);
+  }
+
+  for (i=1; i<team->num_threads; i++) {
+    team->workers[i-1].team = team;
+    team->workers[i-1].id   = i;
+    if (pthread_create(&team->workers[i-1].thread, NULL, N_VTeamWorker_PT,
+                       (void *) &team->workers[i-1]) != 0) {
+      /* only join the threads started so far */
+      team->num_threads = i;
+      N_VReleaseTeam_Pthreads(team);
+      return(NULL);
+    }
+  }
+
+  return(team);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Add a reference to a thread team, used when a vector is cloned
+ */
+
+static Pthreads_Team N_VRetainTeam_Pthreads(Pthreads_Team team)
+{
+  if (team == NULL) return(NULL);
+
+  pthread_mutex_lock(&team->mutex);
+  team->refcount++;
+  pthread_mutex_unlock(&team->mutex);
+
+  return(team);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Drop a reference to a thread team, the last vector using the team stops
+ * and joins the workers
+ */
+
+static void N_VReleaseTeam_Pthreads(Pthreads_Team team)
+{
+  int i, refcount;
+
+  if (team == NULL) return;
+
+  pthread_mutex_lock(&team->mutex);
+  refcount = --team->refcount;
+  if (refcount == 0) {
+    team->shutdown = 1;
+    pthread_cond_broadcast(&team->start_cond);
+  }
+  pthread_mutex_unlock(&team->mutex);
+
+  if (refcount > 0) return;
+
+  for (i=1; i<team->num_threads; i++)
+    pthread_join(team->workers[i-1].thread, NULL);
+
+  pthread_cond_destroy(&team->done_cond);
+  pthread_cond_destroy(&team->start_cond);
+  pthread_mutex_destroy(&team->mutex);
+  pthread_mutex_destroy(&team->run_mutex);
+  free(team->workers);
+  free(team);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Call func for each of the nthreads entries in thread_data, distributed over
+ * the team, and wait until all calls have returned
+ */
+
+static void N_VRunTeam_Pthreads(Pthreads_Team team, void *(*func)(void *),
+                                Pthreads_Data *thread_data, int nthreads)
+{
+  int i;
+
+  /* nothing to distribute, run on the calling thread */
+  if (team == NULL || team->num_threads == 1 || nthreads == 1) {
+    for (i=0; i<nthreads; i++) func((void *) &thread_data[i]);
+    return;
+  }
+
+  /* vectors sharing a team may be used by several application threads */
+  pthread_mutex_lock(&team->run_mutex);
+
+  /* publish the operation and wake the workers */
+  pthread_mutex_lock(&team->mutex);
+  team->func        = func;
+  team->thread_data = thread_data;
+  team->nactive     = nthreads;
+  team->pending     = team->num_threads - 1;
+  team->generation++;
+  pthread_mutex_unlock(&team->mutex);
+  pthread_cond_broadcast(&team->start_cond);
+
+  /* the calling thread takes the first part and any parts beyond the team size */
+  func((void *) &thread_data[0]);
+  for (i=team->num_threads; i<nthreads; i++) func((void *) &thread_data[i]);
+
+  /* wait for the workers */
+  pthread_mutex_lock(&team->mutex);
+  while (team->pending > 0)
+    pthread_cond_wait(&team->done_cond, &team->mutex);
+  team->func        = NULL;
+  team->thread_data = NULL;
+  pthread_mutex_unlock(&team->mutex);
+
+  pthread_mutex_unlock(&team->run_mutex);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Main loop of a team worker thread
+ */
+
+static void *N_VTeamWorker_PT(void *worker)
+{
+  struct _Pthreads_Worker *my_worker;
+  Pthreads_Team team;
+  unsigned long generation;
+  void *(*func)(void *);
+  Pthreads_Data *thread_data;
+  int nactive;
+
+  my_worker  = (struct _Pthreads_Worker *) worker;
+  team       = my_worker->team;
+  generation = 0;
+
+  pthread_mutex_lock(&team->mutex);
+  for (;;) {
+    /* sleep until the next operation or the shutdown of the team */
+    while (team->generation == generation && !team->shutdown)
+      pthread_cond_wait(&team->start_cond, &team->mutex);
+    if (team->shutdown) break;
+
+    generation  = team->generation;
+    func        = team->func;
+    thread_data = team->thread_data;
+    nactive     = team->nactive;
+    pthread_mutex_unlock(&team->mutex);
+
+    if (my_worker->id < nactive) func((void *) &thread_data[my_worker->id]);
+
+    pthread_mutex_lock(&team->mutex);
+    if (--team->pending == 0) pthread_cond_signal(&team->done_cond);
+  }
+  pthread_mutex_unlock(&team->mutex);
+
+  return(NULL);
+}
+
+
 /*
  * -----------------------------------------------------------------
  * Enable / Disable fused and vector array operations
@@ -5555,3 +5308,24 @@ int N_VEnableLinearCombinationVectorArray_Pthreads(N_Vector v, booleantype tf)
   /* return success */
   return(0);
 }
+
+
+/*
+ * -----------------------------------------------------------------
+ * Enable / Disable deterministic reductions
+ * -----------------------------------------------------------------
+ */
+
+int N_VSetDeterministicReductions_Pthreads(N_Vector v, booleantype tf)
+{
+  /* check that vector is non-NULL */
+  if (v == NULL) return(-1);
+
+  /* check that content structure is non-NULL */
+  if (v->content == NULL) return(-1);
+
+  NV_DETERMINISTIC_PT(v) = tf;
+
+  /* return success */
+  return(0);
+}
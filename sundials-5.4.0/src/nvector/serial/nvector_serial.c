@@ -27,6 +27,9 @@
 #define ONE    RCONST(1.0)
 #define ONEPT5 RCONST(1.5)
 
+/* Private function to allocate the data array of a vector */
+static int VAllocData_Serial(N_Vector v, SUNMemoryHelper helper);
+
 /* Private functions for special cases of vector operations */
 static void VCopy_Serial(N_Vector x, N_Vector z);                              /* z=x       */
 static void VSum_Serial(N_Vector x, N_Vector y, N_Vector z);                   /* z=x+y     */
@@ -48,6 +51,12 @@ static int VLin1VectorArray_Serial(int nvec, realtype a, N_Vector* X, N_Vector*
 static int VLin2VectorArray_Serial(int nvec, realtype a, N_Vector* X, N_Vector* Y, N_Vector* Z);      /* Z=aX-Y    */
 static int VaxpyVectorArray_Serial(int nvec, realtype a, N_Vector* X, N_Vector* Y);                    /* Y <- aX+Y */
 
+/* Private kernels shared by several operations */
+static realtype VDotKernel_Serial(sunindextype N, realtype* xd, realtype* yd);     /* sum x[i]*y[i]     */
+static realtype VWSqrSumKernel_Serial(sunindextype N, realtype* xd, realtype* wd); /* sum (x[i]*w[i])^2 */
+static void VLinearCombinationAdd_Serial(int nvec, realtype* c, N_Vector* X,
+                                         sunindextype N, realtype* zd);          /* z += sum c[i]X[i] */
+
 /*
  * -----------------------------------------------------------------
  * exported functions
@@ -141,9 +150,16 @@ N_Vector N_VNewEmpty_Serial(sunindextype length)
   v->content = content;
 
   /* Initialize content */
-  content->length   = length;
-  content->own_data = SUNFALSE;
-  content->data     = NULL;
+  content->length     = length;
+  content->own_data   = SUNFALSE;
+  content->data       = NULL;
+  content->mem_helper = NULL;
+  content->data_mem   = NULL;
+
+#ifdef SUNDIALS_NVECTOR_FUSED_OPS_DEFAULT
+  /* enable fused and vector array operations, copied to all clones */
+  N_VEnableFusedOps_Serial(v, SUNTRUE);
+#endif
 
   return(v);
 }
@@ -155,25 +171,34 @@ N_Vector N_VNewEmpty_Serial(sunindextype length)
 N_Vector N_VNew_Serial(sunindextype length)
 {
   N_Vector v;
-  realtype *data;
 
   v = NULL;
   v = N_VNewEmpty_Serial(length);
   if (v == NULL) return(NULL);
 
   /* Create data */
-  if (length > 0) {
+  if (VAllocData_Serial(v, NULL)) { N_VDestroy_Serial(v); return(NULL); }
 
-    /* Allocate memory */
-    data = NULL;
-    data = (realtype *) malloc(length * sizeof(realtype));
-    if(data == NULL) { N_VDestroy_Serial(v); return(NULL); }
+  return(v);
+}
 
-    /* Attach data */
-    NV_OWN_DATA_S(v) = SUNTRUE;
-    NV_DATA_S(v)     = data;
+/* ----------------------------------------------------------------------------
+ * Function to create a new serial vector with its data, and the data of all
+ * of its clones, drawn from a memory helper
+ */
 
-  }
+N_Vector N_VNewWithMemHelp_Serial(sunindextype length, SUNMemoryHelper helper)
+{
+  N_Vector v;
+
+  if (helper == NULL) return(NULL);
+
+  v = NULL;
+  v = N_VNewEmpty_Serial(length);
+  if (v == NULL) return(NULL);
+
+  /* Create data */
+  if (VAllocData_Serial(v, helper)) { N_VDestroy_Serial(v); return(NULL); }
 
   return(v);
 }
@@ -343,9 +368,11 @@ N_Vector N_VCloneEmpty_Serial(N_Vector w)
   v->content = content;
 
   /* Initialize content */
-  content->length   = NV_LENGTH_S(w);
-  content->own_data = SUNFALSE;
-  content->data     = NULL;
+  content->length     = NV_LENGTH_S(w);
+  content->own_data   = SUNFALSE;
+  content->data       = NULL;
+  content->mem_helper = NULL;
+  content->data_mem   = NULL;
 
   return(v);
 }
@@ -353,27 +380,15 @@ N_Vector N_VCloneEmpty_Serial(N_Vector w)
 N_Vector N_VClone_Serial(N_Vector w)
 {
   N_Vector v;
-  realtype *data;
-  sunindextype length;
 
   v = NULL;
   v = N_VCloneEmpty_Serial(w);
   if (v == NULL) return(NULL);
 
-  length = NV_LENGTH_S(w);
-
-  /* Create data */
-  if (length > 0) {
-
-    /* Allocate memory */
-    data = NULL;
-    data = (realtype *) malloc(length * sizeof(realtype));
-    if(data == NULL) { N_VDestroy_Serial(v); return(NULL); }
-
-    /* Attach data */
-    NV_OWN_DATA_S(v) = SUNTRUE;
-    NV_DATA_S(v)     = data;
-
+  /* Create data, drawn from the same helper as the data of w */
+  if (VAllocData_Serial(v, NV_CONTENT_S(w)->mem_helper)) {
+    N_VDestroy_Serial(v);
+    return(NULL);
   }
 
   return(v);
@@ -387,7 +402,12 @@ void N_VDestroy_Serial(N_Vector v)
   if (v->content != NULL) {
     /* free data array if it's owned by the vector */
     if (NV_OWN_DATA_S(v) && NV_DATA_S(v) != NULL) {
-      free(NV_DATA_S(v));
+      if (NV_CONTENT_S(v)->data_mem != NULL)
+        SUNMemoryHelper_Dealloc(NV_CONTENT_S(v)->mem_helper,
+                                NV_CONTENT_S(v)->data_mem);
+      else
+        free(NV_DATA_S(v));
+      NV_CONTENT_S(v)->data_mem = NULL;
       NV_DATA_S(v) = NULL;
     }
     free(v->content);
@@ -639,20 +659,7 @@ void N_VAddConst_Serial(N_Vector x, realtype b, N_Vector z)
 
 realtype N_VDotProd_Serial(N_Vector x, N_Vector y)
 {
-  sunindextype i, N;
-  realtype sum, *xd, *yd;
-
-  sum = ZERO;
-  xd = yd = NULL;
-
-  N  = NV_LENGTH_S(x);
-  xd = NV_DATA_S(x);
-  yd = NV_DATA_S(y);
-
-  for (i = 0; i < N; i++)
-    sum += xd[i]*yd[i];
-
-  return(sum);
+  return(VDotKernel_Serial(NV_LENGTH_S(x), NV_DATA_S(x), NV_DATA_S(y)));
 }
 
 realtype N_VMaxNorm_Serial(N_Vector x)
@@ -680,22 +687,7 @@ realtype N_VWrmsNorm_Serial(N_Vector x, N_Vector w)
 
 realtype N_VWSqrSumLocal_Serial(N_Vector x, N_Vector w)
 {
-  sunindextype i, N;
-  realtype sum, prodi, *xd, *wd;
-
-  sum = ZERO;
-  xd = wd = NULL;
-
-  N  = NV_LENGTH_S(x);
-  xd = NV_DATA_S(x);
-  wd = NV_DATA_S(w);
-
-  for (i = 0; i < N; i++) {
-    prodi = xd[i]*wd[i];
-    sum += SUNSQR(prodi);
-  }
-
-  return(sum);
+  return(VWSqrSumKernel_Serial(NV_LENGTH_S(x), NV_DATA_S(x), NV_DATA_S(w)));
 }
 
 realtype N_VWrmsNormMask_Serial(N_Vector x, N_Vector w, N_Vector id)
@@ -899,7 +891,10 @@ int N_VLinearCombination_Serial(int nvec, realtype* c, N_Vector* X, N_Vector z)
   int          i;
   sunindextype j, N;
   realtype*    zd=NULL;
-  realtype*    xd=NULL;
+  realtype*    x0=NULL;
+  realtype*    x1=NULL;
+  realtype*    x2=NULL;
+  realtype*    x3=NULL;
 
   /* invalid number of vectors */
   if (nvec < 1) return(-1);
@@ -924,12 +919,7 @@ int N_VLinearCombination_Serial(int nvec, realtype* c, N_Vector* X, N_Vector z)
    * X[0] += c[i]*X[i], i = 1,...,nvec-1
    */
   if ((X[0] == z) && (c[0] == ONE)) {
-    for (i=1; i<nvec; i++) {
-      xd = NV_DATA_S(X[i]);
-      for (j=0; j<N; j++) {
-        zd[j] += c[i] * xd[j];
-      }
-    }
+    VLinearCombinationAdd_Serial(nvec-1, c+1, X+1, N, zd);
     return(0);
   }
 
@@ -940,28 +930,30 @@ int N_VLinearCombination_Serial(int nvec, realtype* c, N_Vector* X, N_Vector z)
     for (j=0; j<N; j++) {
       zd[j] *= c[0];
     }
-    for (i=1; i<nvec; i++) {
-      xd = NV_DATA_S(X[i]);
-      for (j=0; j<N; j++) {
-        zd[j] += c[i] * xd[j];
-      }
-    }
+    VLinearCombinationAdd_Serial(nvec-1, c+1, X+1, N, zd);
     return(0);
   }
 
   /*
    * z = sum{ c[i] * X[i] }, i = 0,...,nvec-1
    */
-  xd = NV_DATA_S(X[0]);
-  for (j=0; j<N; j++) {
-    zd[j] = c[0] * xd[j];
-  }
-  for (i=1; i<nvec; i++) {
-    xd = NV_DATA_S(X[i]);
+  i  = 1;
+  x0 = NV_DATA_S(X[0]);
+  if (nvec >= 4) {
+    /* the first four vectors in one pass, in the order of the loop below */
+    x1 = NV_DATA_S(X[1]);
+    x2 = NV_DATA_S(X[2]);
+    x3 = NV_DATA_S(X[3]);
     for (j=0; j<N; j++) {
-      zd[j] += c[i] * xd[j];
+      zd[j] = c[0] * x0[j] + c[1] * x1[j] + c[2] * x2[j] + c[3] * x3[j];
+    }
+    i = 4;
+  } else {
+    for (j=0; j<N; j++) {
+      zd[j] = c[0] * x0[j];
     }
   }
+  VLinearCombinationAdd_Serial(nvec-i, c+i, X+i, N, zd);
   return(0);
 }
 
@@ -1019,7 +1011,11 @@ int N_VDotProdMulti_Serial(int nvec, N_Vector x, N_Vector* Y, realtype* dotprods
   int          i;
   sunindextype j, N;
   realtype*    xd=NULL;
-  realtype*    yd=NULL;
+  realtype*    y0=NULL;
+  realtype*    y1=NULL;
+  realtype*    y2=NULL;
+  realtype*    y3=NULL;
+  realtype     s0, s1, s2, s3;
 
   /* invalid number of vectors */
   if (nvec < 1) return(-1);
@@ -1034,13 +1030,27 @@ int N_VDotProdMulti_Serial(int nvec, N_Vector x, N_Vector* Y, realtype* dotprods
   N  = NV_LENGTH_S(x);
   xd = NV_DATA_S(x);
 
-  /* compute multiple dot products */
-  for (i=0; i<nvec; i++) {
-    yd = NV_DATA_S(Y[i]);
-    dotprods[i] = ZERO;
+  /* compute multiple dot products, four at a time so that x is read once for
+     four vectors */
+  for (i=0; i+3<nvec; i+=4) {
+    y0 = NV_DATA_S(Y[i]);
+    y1 = NV_DATA_S(Y[i+1]);
+    y2 = NV_DATA_S(Y[i+2]);
+    y3 = NV_DATA_S(Y[i+3]);
+    s0 = s1 = s2 = s3 = ZERO;
     for (j=0; j<N; j++) {
-      dotprods[i] += xd[j] * yd[j];
+      s0 += xd[j] * y0[j];
+      s1 += xd[j] * y1[j];
+      s2 += xd[j] * y2[j];
+      s3 += xd[j] * y3[j];
     }
+    dotprods[i]   = s0;
+    dotprods[i+1] = s1;
+    dotprods[i+2] = s2;
+    dotprods[i+3] = s3;
+  }
+  for (; i<nvec; i++) {
+    dotprods[i] = VDotKernel_Serial(N, xd, NV_DATA_S(Y[i]));
   }
 
   return(0);
@@ -1230,7 +1240,7 @@ int N_VWrmsNormVectorArray_Serial(int nvec, N_Vector* X, N_Vector* W,
                                   realtype* nrm)
 {
   int          i;
-  sunindextype j, N;
+  sunindextype N;
   realtype*    wd=NULL;
   realtype*    xd=NULL;
 
@@ -1250,11 +1260,7 @@ int N_VWrmsNormVectorArray_Serial(int nvec, N_Vector* X, N_Vector* W,
   for (i=0; i<nvec; i++) {
     xd = NV_DATA_S(X[i]);
     wd = NV_DATA_S(W[i]);
-    nrm[i] = ZERO;
-    for (j=0; j<N; j++) {
-      nrm[i] += SUNSQR(xd[j] * wd[j]);
-    }
-    nrm[i] = SUNRsqrt(nrm[i]/N);
+    nrm[i] = SUNRsqrt(VWSqrSumKernel_Serial(N, xd, wd)/N);
   }
 
   return(0);
@@ -1583,6 +1589,39 @@ int N_VBufUnpack_Serial(N_Vector x, void *buf)
 }
 
 
+/*
+ * -----------------------------------------------------------------
+ * private function to allocate the data array of a vector, from the
+ * memory helper if there is one and with malloc otherwise
+ * -----------------------------------------------------------------
+ */
+
+static int VAllocData_Serial(N_Vector v, SUNMemoryHelper helper)
+{
+  sunindextype length;
+  realtype *data;
+
+  length = NV_LENGTH_S(v);
+  if (length <= 0) return(0);
+
+  if (helper != NULL) {
+    if (SUNMemoryHelper_Alloc(helper, &(NV_CONTENT_S(v)->data_mem),
+                              length * sizeof(realtype), SUNMEMTYPE_HOST))
+      return(-1);
+    data = (realtype *) NV_CONTENT_S(v)->data_mem->ptr;
+    NV_CONTENT_S(v)->mem_helper = helper;
+  } else {
+    data = (realtype *) malloc(length * sizeof(realtype));
+    if (data == NULL) return(-1);
+  }
+
+  /* Attach data */
+  NV_OWN_DATA_S(v) = SUNTRUE;
+  NV_DATA_S(v)     = data;
+
+  return(0);
+}
+
 /*
  * -----------------------------------------------------------------
  * private functions for special cases of vector operations
@@ -1951,6 +1990,88 @@ static int VaxpyVectorArray_Serial(int nvec, realtype a, N_Vector* X, N_Vector*
 }
 
 
+/*
+ * -----------------------------------------------------------------
+ * private kernels
+ * -----------------------------------------------------------------
+ */
+
+/* The reductions keep four independent partial sums. This breaks the
+   dependency between consecutive additions, so the loop is not limited
+   by the latency of the adder and the compiler can keep the partial sums
+   in SIMD registers without reassociating the sum itself. */
+
+static realtype VDotKernel_Serial(sunindextype N, realtype* xd, realtype* yd)
+{
+  sunindextype i, N4;
+  realtype s0, s1, s2, s3;
+
+  s0 = s1 = s2 = s3 = ZERO;
+  N4 = N - N%4;
+
+  for (i = 0; i < N4; i += 4) {
+    s0 += xd[i]   * yd[i];
+    s1 += xd[i+1] * yd[i+1];
+    s2 += xd[i+2] * yd[i+2];
+    s3 += xd[i+3] * yd[i+3];
+  }
+  for (; i < N; i++)
+    s0 += xd[i] * yd[i];
+
+  return((s0 + s1) + (s2 + s3));
+}
+
+static realtype VWSqrSumKernel_Serial(sunindextype N, realtype* xd, realtype* wd)
+{
+  sunindextype i, N4;
+  realtype s0, s1, s2, s3;
+
+  s0 = s1 = s2 = s3 = ZERO;
+  N4 = N - N%4;
+
+  for (i = 0; i < N4; i += 4) {
+    s0 += SUNSQR(xd[i]   * wd[i]);
+    s1 += SUNSQR(xd[i+1] * wd[i+1]);
+    s2 += SUNSQR(xd[i+2] * wd[i+2]);
+    s3 += SUNSQR(xd[i+3] * wd[i+3]);
+  }
+  for (; i < N; i++)
+    s0 += SUNSQR(xd[i] * wd[i]);
+
+  return((s0 + s1) + (s2 + s3));
+}
+
+/* z += sum{ c[i] * X[i] }, i = 0,...,nvec-1. Up to four vectors are added
+   per pass, so z is loaded and stored once for four vectors instead of once
+   per vector. The additions are done in the same order as one vector at a
+   time. */
+
+static void VLinearCombinationAdd_Serial(int nvec, realtype* c, N_Vector* X,
+                                         sunindextype N, realtype* zd)
+{
+  int          i;
+  sunindextype j;
+  realtype     *x0, *x1, *x2, *x3;
+
+  for (i=0; i+3<nvec; i+=4) {
+    x0 = NV_DATA_S(X[i]);
+    x1 = NV_DATA_S(X[i+1]);
+    x2 = NV_DATA_S(X[i+2]);
+    x3 = NV_DATA_S(X[i+3]);
+    for (j=0; j<N; j++) {
+      zd[j] = zd[j] + c[i] * x0[j] + c[i+1] * x1[j] + c[i+2] * x2[j] + c[i+3] * x3[j];
+    }
+  }
+
+  for (; i<nvec; i++) {
+    x0 = NV_DATA_S(X[i]);
+    for (j=0; j<N; j++) {
+      zd[j] += c[i] * x0[j];
+    }
+  }
+}
+
+
 /*
  * -----------------------------------------------------------------
  * Enable / Disable fused and vector array operations
@@ -54,13 +54,15 @@ module fsundials_linearsolver_mod
   enumerator :: SUNLINEARSOLVER_SUPERLUDIST
   enumerator :: SUNLINEARSOLVER_SUPERLUMT
   enumerator :: SUNLINEARSOLVER_CUSOLVERSP_BATCHQR
+  enumerator :: SUNLINEARSOLVER_BLOCKDIAG
+  enumerator :: SUNLINEARSOLVER_MIXEDIR
   enumerator :: SUNLINEARSOLVER_CUSTOM
  end enum
  integer, parameter, public :: SUNLinearSolver_ID = kind(SUNLINEARSOLVER_BAND)
  public :: SUNLINEARSOLVER_BAND, SUNLINEARSOLVER_DENSE, SUNLINEARSOLVER_KLU, SUNLINEARSOLVER_LAPACKBAND, &
     SUNLINEARSOLVER_LAPACKDENSE, SUNLINEARSOLVER_PCG, SUNLINEARSOLVER_SPBCGS, SUNLINEARSOLVER_SPFGMR, SUNLINEARSOLVER_SPGMR, &
     SUNLINEARSOLVER_SPTFQMR, SUNLINEARSOLVER_SUPERLUDIST, SUNLINEARSOLVER_SUPERLUMT, SUNLINEARSOLVER_CUSOLVERSP_BATCHQR, &
-    SUNLINEARSOLVER_CUSTOM
+    SUNLINEARSOLVER_BLOCKDIAG, SUNLINEARSOLVER_MIXEDIR, SUNLINEARSOLVER_CUSTOM
  ! struct struct _generic_SUNLinearSolver_Ops
  type, bind(C), public :: SUNLinearSolver_Ops
   type(C_FUNPTR), public :: gettype
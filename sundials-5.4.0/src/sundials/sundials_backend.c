@@ -0,0 +1,202 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the SUNDIALS backends.
+ *
+ * The optional modules are compiled in when the build defines
+ * SUNBACKEND_WITH_OPENMP, SUNBACKEND_WITH_PTHREADS,
+ * SUNBACKEND_WITH_KLU and SUNBACKEND_WITH_SUPERLUMT, which it does
+ * for the modules it builds.
+ * ----------------------------------------------------------------*/
+
+#include <stdlib.h>
+
+#include <sundials/sundials_backend.h>
+#include <nvector/nvector_serial.h>
+#include <sunmatrix/sunmatrix_dense.h>
+#include <sunmatrix/sunmatrix_sparse.h>
+#include <sunlinsol/sunlinsol_dense.h>
+
+#if defined(SUNBACKEND_WITH_OPENMP)
+#include <nvector/nvector_openmp.h>
+#endif
+#if defined(SUNBACKEND_WITH_PTHREADS)
+#include <nvector/nvector_pthreads.h>
+#endif
+#if defined(SUNBACKEND_WITH_KLU)
+#include <sunlinsol/sunlinsol_klu.h>
+#endif
+#if defined(SUNBACKEND_WITH_SUPERLUMT)
+#include <sunlinsol/sunlinsol_superlumt.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+booleantype SUNBackend_HasVector(SUNBackendVector vector)
+{
+  switch (vector) {
+  case SUNBACKEND_VECTOR_SERIAL:
+    return(SUNTRUE);
+#if defined(SUNBACKEND_WITH_OPENMP)
+  case SUNBACKEND_VECTOR_OPENMP:
+    return(SUNTRUE);
+#endif
+#if defined(SUNBACKEND_WITH_PTHREADS)
+  case SUNBACKEND_VECTOR_PTHREADS:
+    return(SUNTRUE);
+#endif
+  default:
+    return(SUNFALSE);
+  }
+}
+
+booleantype SUNBackend_HasSolver(SUNBackendSolver solver)
+{
+  switch (solver) {
+  case SUNBACKEND_SOLVER_DENSE:
+    return(SUNTRUE);
+#if defined(SUNBACKEND_WITH_KLU)
+  case SUNBACKEND_SOLVER_KLU:
+    return(SUNTRUE);
+#endif
+#if defined(SUNBACKEND_WITH_SUPERLUMT)
+  case SUNBACKEND_SOLVER_SUPERLUMT:
+    return(SUNTRUE);
+#endif
+  default:
+    return(SUNFALSE);
+  }
+}
+
+int SUNBackend_NumCores(void)
+{
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return(info.dwNumberOfProcessors > 0 ? (int) info.dwNumberOfProcessors : 1);
+#elif defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return(n > 0 ? (int) n : 1);
+#else
+  return(1);
+#endif
+}
+
+int SUNBackend_Select(sunindextype n, sunindextype nnz, int ncores,
+                      SUNBackend *backend)
+{
+  sunindextype nthreads;
+
+  if (backend == NULL || n <= 0) return(-1);
+  if (ncores <= 0) ncores = SUNBackend_NumCores();
+
+  /* Vector operations are bound by memory bandwidth, threads only pay
+     off for long vectors, with enough elements for each of them */
+  nthreads = n / SUNBACKEND_N_PER_THREAD;
+  if (nthreads > ncores) nthreads = ncores;
+  backend->vector = SUNBACKEND_VECTOR_SERIAL;
+  backend->nthreads = 1;
+  if (n >= SUNBACKEND_THREADED_MIN_N && nthreads > 1) {
+    if (SUNBackend_HasVector(SUNBACKEND_VECTOR_OPENMP))
+      backend->vector = SUNBACKEND_VECTOR_OPENMP;
+    else if (SUNBackend_HasVector(SUNBACKEND_VECTOR_PTHREADS))
+      backend->vector = SUNBACKEND_VECTOR_PTHREADS;
+    if (backend->vector != SUNBACKEND_VECTOR_SERIAL)
+      backend->nthreads = (int) nthreads;
+  }
+
+  /* A sparse factorization beats a dense one for all but small or
+     nearly full Jacobians, SuperLU_MT only for large ones with cores
+     to spare */
+  backend->solver = SUNBACKEND_SOLVER_DENSE;
+  backend->nsolverthreads = 1;
+  if (nnz > 0 && n >= SUNBACKEND_SPARSE_MIN_N &&
+      (realtype) nnz <= SUNBACKEND_SPARSE_MAX_DENSITY * (realtype) n * (realtype) n) {
+    if (n >= SUNBACKEND_SUPERLUMT_MIN_N && ncores > 1 &&
+        SUNBackend_HasSolver(SUNBACKEND_SOLVER_SUPERLUMT)) {
+      backend->solver = SUNBACKEND_SOLVER_SUPERLUMT;
+      backend->nsolverthreads = ncores;
+    }
+    else if (SUNBackend_HasSolver(SUNBACKEND_SOLVER_KLU))
+      backend->solver = SUNBACKEND_SOLVER_KLU;
+    else if (SUNBackend_HasSolver(SUNBACKEND_SOLVER_SUPERLUMT))
+      backend->solver = SUNBACKEND_SOLVER_SUPERLUMT;
+  }
+
+  return(0);
+}
+
+N_Vector SUNBackend_NewVector(const SUNBackend *backend, sunindextype n)
+{
+  if (backend == NULL) return(NULL);
+
+  switch (backend->vector) {
+  case SUNBACKEND_VECTOR_SERIAL:
+    return(N_VNew_Serial(n));
+#if defined(SUNBACKEND_WITH_OPENMP)
+  case SUNBACKEND_VECTOR_OPENMP:
+    return(N_VNew_OpenMP(n, backend->nthreads));
+#endif
+#if defined(SUNBACKEND_WITH_PTHREADS)
+  case SUNBACKEND_VECTOR_PTHREADS:
+    return(N_VNew_Pthreads(n, backend->nthreads));
+#endif
+  default:
+    return(NULL);
+  }
+}
+
+SUNMatrix SUNBackend_NewMatrix(const SUNBackend *backend, sunindextype n,
+                               sunindextype nnz)
+{
+  if (backend == NULL) return(NULL);
+
+  if (backend->solver == SUNBACKEND_SOLVER_DENSE)
+    return(SUNDenseMatrix(n, n));
+  return(SUNSparseMatrix(n, n, nnz, CSC_MAT));
+}
+
+SUNLinearSolver SUNBackend_NewLinearSolver(const SUNBackend *backend,
+                                           N_Vector y, SUNMatrix A)
+{
+  if (backend == NULL) return(NULL);
+
+  switch (backend->solver) {
+  case SUNBACKEND_SOLVER_DENSE:
+    return(SUNLinSol_Dense(y, A));
+#if defined(SUNBACKEND_WITH_KLU)
+  case SUNBACKEND_SOLVER_KLU:
+    return(SUNLinSol_KLU(y, A));
+#endif
+#if defined(SUNBACKEND_WITH_SUPERLUMT)
+  case SUNBACKEND_SOLVER_SUPERLUMT:
+    return(SUNLinSol_SuperLUMT(y, A, backend->nsolverthreads));
+#endif
+  default:
+    return(NULL);
+  }
+}
+
+const char *SUNBackend_Name(const SUNBackend *backend)
+{
+  static const char *names[3][3] = {
+    { "serial/dense",   "serial/klu",   "serial/superlumt"   },
+    { "openmp/dense",   "openmp/klu",   "openmp/superlumt"   },
+    { "pthreads/dense", "pthreads/klu", "pthreads/superlumt" }
+  };
+
+  if (backend == NULL) return(NULL);
+  return(names[backend->vector][backend->solver]);
+}
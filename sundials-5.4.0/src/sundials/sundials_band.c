@@ -174,6 +174,190 @@ sunindextype bandGBTRF(realtype **a, sunindextype n, sunindextype mu, sunindexty
   return(0);
 }
 
+/*
+ * Blocked band LU factorization. The elimination steps are done in panels
+ * of BAND_GBTRF_NB steps. A panel is factored by the unblocked algorithm
+ * in its own columns. Each column on its right is then loaded once per
+ * panel instead of once per step: the row interchanges of the panel are
+ * applied to it first, which is the same as applying them to the panel
+ * columns of L, so these are copied to the work array w with the later
+ * interchanges of the panel applied. The rows of the block row of U are
+ * then formed one after the other and the rows below are updated with
+ * all panel columns in one pass the compiler can vectorize. Every entry
+ * gets the same updates in the same order as in bandGBTRF, so the pivots
+ * and factors are the same. A zero multiplier of U is not skipped here,
+ * which can only change the sign of a zero entry. Columns that are not
+ * reached by all steps of the panel use the unblocked steps.
+ */
+
+#define BAND_GBTRF_NB    4
+#define BAND_GBTRF_MLMIN 8
+
+sunindextype bandGBTRFBlocked(realtype **a, sunindextype n, sunindextype mu, sunindextype ml, sunindextype smu, sunindextype *p)
+{
+  sunindextype c, r, num_rows, nw;
+  sunindextype i, j, k, l, k0, k1, m, mm, nb, last_row, last_col, first_row;
+  realtype *a_c, *col_k, *diag_k, *col_j, *w, *wm[BAND_GBTRF_NB];
+  realtype *c0, *w0, *w1, *w2, *w3;
+  realtype max, temp, mult, a_kj, u[BAND_GBTRF_NB], u0, u1, u2, u3;
+
+  if ( (ml < BAND_GBTRF_MLMIN) || (n <= 2*BAND_GBTRF_NB) )
+    return(bandGBTRF(a, n, mu, ml, smu, p));
+
+  /* work array for the panel columns of L, rows k0+1,...,k0+nb-1+ml */
+  nw = ml + BAND_GBTRF_NB;
+  w = (realtype *) malloc(BAND_GBTRF_NB * nw * sizeof(realtype));
+  if (w == NULL) return(bandGBTRF(a, n, mu, ml, smu, p));
+  for (m=0; m < BAND_GBTRF_NB; m++) wm[m] = w + m*nw;
+
+  /* zero out the first smu - mu rows of the rectangular array a */
+
+  num_rows = smu - mu;
+  if (num_rows > 0) {
+    for (c=0; c < n; c++) {
+      a_c = a[c];
+      for (r=0; r < num_rows; r++) {
+        a_c[r] = ZERO;
+      }
+    }
+  }
+
+  for (k0=0; k0 < n-1; k0+=BAND_GBTRF_NB) {
+
+    k1 = SUNMIN(k0+BAND_GBTRF_NB, n-1);
+    nb = k1 - k0;
+
+    /* factor the panel in its own columns, as in bandGBTRF */
+
+    for (k=k0; k < k1; k++) {
+      col_k    = a[k];
+      diag_k   = col_k + smu;
+      last_row = SUNMIN(n-1,k+ml);
+
+      l = k;
+      max = SUNRabs(*diag_k);
+      for (i=k+1; i <= last_row; i++) {
+        if (SUNRabs(diag_k[i-k]) > max) {
+          l = i;
+          max = SUNRabs(diag_k[i-k]);
+        }
+      }
+      p[k] = l;
+
+      if (diag_k[l-k] == ZERO) { free(w); return(k+1); }
+
+      if (l != k) {
+        temp = diag_k[l-k];
+        diag_k[l-k] = *diag_k;
+        *diag_k = temp;
+      }
+
+      mult = -ONE / (*diag_k);
+      for (i=k+1; i <= last_row; i++)
+        diag_k[i-k] *= mult;
+
+      last_col = SUNMIN(k+smu,k1-1);
+      for (j=k+1; j <= last_col; j++) {
+        col_j = a[j];
+        a_kj = col_j[ROW(l,j,smu)];
+        if (l != k) {
+          col_j[ROW(l,j,smu)] = col_j[ROW(k,j,smu)];
+          col_j[ROW(k,j,smu)] = a_kj;
+        }
+        if (a_kj != ZERO) {
+          for (i=k+1; i <= last_row; i++)
+            col_j[ROW(i,j,smu)] += a_kj * diag_k[i-k];
+        }
+      }
+    }
+
+    /* copy the panel columns of L to w, w[m][i-k0] = L(i,k0+m), and apply
+       the interchanges of the later steps of the panel */
+
+    last_row = SUNMIN(n-1,k1-1+ml);
+    for (m=0; m < nb; m++) {
+      k = k0+m;
+      diag_k = a[k] + smu;
+      for (i=k0+1; i <= last_row; i++)
+        wm[m][i-k0] = ((i > k) && (i <= k+ml)) ? diag_k[i-k] : ZERO;
+      for (mm=m+1; mm < nb; mm++) {
+        l = p[k0+mm];
+        temp = wm[m][l-k0];
+        wm[m][l-k0] = wm[m][mm];
+        wm[m][mm] = temp;
+      }
+    }
+
+    /* update the columns on the right of the panel */
+
+    last_col = SUNMIN(k1-1+smu,n-1);
+    for (j=k1; j <= last_col; j++) {
+      col_j = a[j];
+
+      /* columns not reached by the first steps of the panel */
+      if (j-smu > k0) {
+        for (k=j-smu; k < k1; k++) {
+          l = p[k];
+          diag_k = a[k] + smu;
+          a_kj = col_j[ROW(l,j,smu)];
+          if (l != k) {
+            col_j[ROW(l,j,smu)] = col_j[ROW(k,j,smu)];
+            col_j[ROW(k,j,smu)] = a_kj;
+          }
+          if (a_kj != ZERO) {
+            for (i=k+1; i <= SUNMIN(n-1,k+ml); i++)
+              col_j[ROW(i,j,smu)] += a_kj * diag_k[i-k];
+          }
+        }
+        continue;
+      }
+
+      /* row interchanges of the panel */
+      for (k=k0; k < k1; k++) {
+        l = p[k];
+        if (l != k) {
+          temp = col_j[ROW(l,j,smu)];
+          col_j[ROW(l,j,smu)] = col_j[ROW(k,j,smu)];
+          col_j[ROW(k,j,smu)] = temp;
+        }
+      }
+
+      /* block row of U */
+      c0 = col_j + ROW(k0,j,smu);
+      for (m=0; m < nb; m++) {
+        for (mm=0; mm < m; mm++)
+          c0[m] += u[mm] * wm[mm][m];
+        u[m] = c0[m];
+      }
+
+      /* rows below the panel */
+      first_row = k1;
+      if (nb < BAND_GBTRF_NB) {
+        for (m=0; m < nb; m++)
+          for (i=first_row; i <= last_row; i++)
+            c0[i-k0] += u[m] * wm[m][i-k0];
+      } else if ( (u[0] != ZERO) || (u[1] != ZERO) ||
+                  (u[2] != ZERO) || (u[3] != ZERO) ) {
+        u0 = u[0]; u1 = u[1]; u2 = u[2]; u3 = u[3];
+        w0 = wm[0]; w1 = wm[1]; w2 = wm[2]; w3 = wm[3];
+        for (i=first_row-k0; i <= last_row-k0; i++)
+          c0[i] = (((c0[i] + u0*w0[i]) + u1*w1[i]) + u2*w2[i]) + u3*w3[i];
+      }
+    }
+  }
+
+  free(w);
+
+  /* set the last pivot row to be n-1 and check for a zero pivot */
+
+  p[n-1] = n-1;
+  if (a[n-1][smu] == ZERO) return(n);
+
+  /* return 0 to indicate success */
+
+  return(0);
+}
+
 void bandGBTRS(realtype **a, sunindextype n, sunindextype smu, sunindextype ml, sunindextype *p, realtype *b)
 {
   sunindextype k, l, i, first_row_k, last_row_k;
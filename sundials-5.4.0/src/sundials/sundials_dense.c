@@ -82,14 +82,21 @@ void DenseMatvec(DlsMat A, realtype *x, realtype *y)
   denseMatvec(A->cols, x, y, A->M, A->N);
 }
 
-sunindextype denseGETRF(realtype **a, sunindextype m, sunindextype n, sunindextype *p)
+/*
+ * Unblocked LU factorization of the columns k0,...,k1-1 of a, for the rows
+ * k0,...,m-1. The rows are only swapped in these columns. With k0 = 0 and
+ * k1 = n this is the complete factorization, otherwise it factors a panel
+ * of the blocked algorithm in denseGETRF.
+ */
+static sunindextype denseGETF2(realtype **a, sunindextype m, sunindextype k0,
+                               sunindextype k1, sunindextype *p)
 {
   sunindextype i, j, k, l;
   realtype *col_j, *col_k;
   realtype temp, mult, a_kj;
 
   /* k-th elimination step number */
-  for (k=0; k < n; k++) {
+  for (k=k0; k < k1; k++) {
 
     col_k  = a[k];
 
@@ -102,9 +109,9 @@ sunindextype denseGETRF(realtype **a, sunindextype m, sunindextype n, sunindexty
     /* check for zero pivot element */
     if (col_k[l] == ZERO) return(k+1);
     
-    /* swap a(k,1:n) and a(l,1:n) if necessary */    
+    /* swap a(k,k0:k1) and a(l,k0:k1) if necessary */
     if ( l!= k ) {
-      for (i=0; i<n; i++) {
+      for (i=k0; i<k1; i++) {
         temp = a[i][l];
         a[i][l] = a[i][k];
         a[i][k] = temp;
@@ -123,9 +130,9 @@ sunindextype denseGETRF(realtype **a, sunindextype m, sunindextype n, sunindexty
     /* row_i = row_i - [a(i,k)/a(k,k)] row_k, i=k+1, ..., m-1 */
     /* row k is the pivot row after swapping with row l.      */
     /* The computation is done one column at a time,          */
-    /* column j=k+1, ..., n-1.                                */
+    /* column j=k+1, ..., k1-1.                               */
 
-    for (j=k+1; j < n; j++) {
+    for (j=k+1; j < k1; j++) {
 
       col_j = a[j];
       a_kj = col_j[k];
@@ -145,6 +152,162 @@ sunindextype denseGETRF(realtype **a, sunindextype m, sunindextype n, sunindexty
   return(0);
 }
 
+/*
+ * Update of the trailing submatrix in the blocked factorization,
+ *   a(i1:m,j) -= a(i1:m,k0:k1) * a(k0:k1,j),  j = j0,...,j1-1,
+ * for rows i0 <= i < i1 of a row block. The panel columns are used four
+ * at a time so each element of column j is loaded and stored once per
+ * four panel columns, the loop over i is left to the compiler to
+ * vectorize.
+ */
+static void denseGEMMBlock(realtype **a, sunindextype i0, sunindextype i1,
+                           sunindextype k0, sunindextype k1,
+                           sunindextype j0, sunindextype j1)
+{
+  sunindextype i, j, k;
+  realtype *c0, *c1, *l0, *l1, *l2, *l3;
+  realtype u00, u10, u20, u30, u01, u11, u21, u31;
+
+  /* two columns of a at a time */
+  for (j=j0; j+1 < j1; j+=2) {
+    c0 = a[j];
+    c1 = a[j+1];
+    for (k=k0; k+3 < k1; k+=4) {
+      u00 = c0[k]; u10 = c0[k+1]; u20 = c0[k+2]; u30 = c0[k+3];
+      u01 = c1[k]; u11 = c1[k+1]; u21 = c1[k+2]; u31 = c1[k+3];
+      l0 = a[k];
+      l1 = a[k+1];
+      l2 = a[k+2];
+      l3 = a[k+3];
+      for (i=i0; i < i1; i++) {
+        c0[i] -= (u00*l0[i] + u10*l1[i]) + (u20*l2[i] + u30*l3[i]);
+        c1[i] -= (u01*l0[i] + u11*l1[i]) + (u21*l2[i] + u31*l3[i]);
+      }
+    }
+    for (; k < k1; k++) {
+      u00 = c0[k];
+      u01 = c1[k];
+      l0 = a[k];
+      for (i=i0; i < i1; i++) {
+        c0[i] -= u00*l0[i];
+        c1[i] -= u01*l0[i];
+      }
+    }
+  }
+
+  /* remaining column */
+  for (; j < j1; j++) {
+    c0 = a[j];
+    for (k=k0; k+3 < k1; k+=4) {
+      u00 = c0[k]; u10 = c0[k+1]; u20 = c0[k+2]; u30 = c0[k+3];
+      l0 = a[k];
+      l1 = a[k+1];
+      l2 = a[k+2];
+      l3 = a[k+3];
+      for (i=i0; i < i1; i++)
+        c0[i] -= (u00*l0[i] + u10*l1[i]) + (u20*l2[i] + u30*l3[i]);
+    }
+    for (; k < k1; k++) {
+      u00 = c0[k];
+      l0 = a[k];
+      for (i=i0; i < i1; i++)
+        c0[i] -= u00*l0[i];
+    }
+  }
+}
+
+/*
+ * LU factorization with partial pivoting. Matrices with fewer than
+ * DENSE_GETRF_NBMIN columns use the unblocked algorithm. Larger matrices
+ * are factored with a right-looking blocked algorithm (as LAPACK dgetrf):
+ * a panel of DENSE_GETRF_NB columns is factored, its row interchanges are
+ * applied to the other columns, the block row of U is computed by forward
+ * substitution and the trailing submatrix is updated with the panel,
+ * DENSE_GETRF_MB rows at a time so the part of the panel used stays in
+ * the cache. The pivots are chosen as in the unblocked algorithm, but the
+ * updates are summed in a different order. If compiled with OpenMP, the
+ * trailing update of large matrices is shared by the threads.
+ */
+
+#define DENSE_GETRF_NB    32
+#define DENSE_GETRF_MB    256
+#define DENSE_GETRF_NBMIN 128
+
+sunindextype denseGETRF(realtype **a, sunindextype m, sunindextype n, sunindextype *p)
+{
+  sunindextype i, j, k, k0, k1, i0, pk, ret;
+  realtype *col_j, *col_k;
+  realtype temp, a_kj;
+
+  if (n < DENSE_GETRF_NBMIN)
+    return(denseGETF2(a, m, 0, n, p));
+
+  for (k0=0; k0 < n; k0+=DENSE_GETRF_NB) {
+
+    k1 = SUNMIN(k0+DENSE_GETRF_NB, n);
+
+    /* factor the panel a(k0:m,k0:k1) */
+    ret = denseGETF2(a, m, k0, k1, p);
+    if (ret != 0) return(ret);
+
+    /* apply the row interchanges of the panel to the columns on its left */
+    for (j=0; j < k0; j++) {
+      col_j = a[j];
+      for (k=k0; k < k1; k++) {
+        pk = p[k];
+        if (pk != k) {
+          temp = col_j[k];
+          col_j[k] = col_j[pk];
+          col_j[pk] = temp;
+        }
+      }
+    }
+
+    if (k1 == n) break;
+
+    /* apply the row interchanges to the columns on the right of the panel,
+       then a(k0:k1,j) = L11^{-1} a(k0:k1,j) with the unit lower triangle */
+#if defined(_OPENMP)
+    #pragma omp parallel for default(shared) private(i,j,k,pk,col_j,col_k,temp,a_kj) \
+      schedule(static) if((n-k1)*(m-k1) > DENSE_GETRF_NBMIN*DENSE_GETRF_NBMIN*4)
+#endif
+    for (j=k1; j < n; j++) {
+      col_j = a[j];
+      for (k=k0; k < k1; k++) {
+        pk = p[k];
+        if (pk != k) {
+          temp = col_j[k];
+          col_j[k] = col_j[pk];
+          col_j[pk] = temp;
+        }
+      }
+      for (k=k0; k < k1; k++) {
+        col_k = a[k];
+        a_kj = col_j[k];
+        if (a_kj != ZERO) {
+          for (i=k+1; i < k1; i++)
+            col_j[i] -= a_kj * col_k[i];
+        }
+      }
+    }
+
+    /* a(k1:m,k1:n) -= a(k1:m,k0:k1) * a(k0:k1,k1:n) */
+    for (i0=k1; i0 < m; i0+=DENSE_GETRF_MB) {
+#if defined(_OPENMP)
+      #pragma omp parallel for default(shared) private(j) \
+        schedule(static) if((n-k1)*(m-k1) > DENSE_GETRF_NBMIN*DENSE_GETRF_NBMIN*4)
+#endif
+      for (j=k1; j < n; j+=4)
+        denseGEMMBlock(a, i0, SUNMIN(i0+DENSE_GETRF_MB, m), k0, k1,
+                       j, SUNMIN(j+4, n));
+    }
+  }
+
+  /* return 0 to indicate success */
+
+  return(0);
+}
+
 void denseGETRS(realtype **a, sunindextype n, sunindextype *p, realtype *b)
 {
   sunindextype i, k, pk;
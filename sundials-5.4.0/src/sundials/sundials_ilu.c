@@ -0,0 +1,764 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the ILU(0)/ILUT incomplete
+ * factorization and its level-scheduled triangular solves.
+ * -----------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sundials/sundials_ilu.h>
+#include <sundials/sundials_math.h>
+#include <sunmatrix/sunmatrix_sparse.h>
+
+#define ZERO RCONST(0.0)
+#define ONE  RCONST(1.0)
+
+/* levels with fewer rows are solved on one thread */
+#define SUNILU_PAR_MIN 64
+
+/*
+ * -----------------------------------------------------------------
+ * The factors are stored by rows: row i holds its L entries, the
+ * diagonal of U at position diag[i] and its U entries, each part
+ * sorted by column. The unit diagonal of L is not stored and dinv
+ * holds the inverse of the diagonal of U.
+ * -----------------------------------------------------------------
+ */
+
+struct SUNILUMemRec {
+  int          type;       /* SUNILU_ILU0 or SUNILU_ILUT              */
+  sunindextype N;          /* matrix size                             */
+  realtype     droptol;    /* ILUT drop tolerance                     */
+  sunindextype lfil;       /* ILUT maximum row fill of L and of U     */
+  int          nthreads;   /* threads of the triangular solves        */
+
+  sunindextype  nnz, cap;  /* nonzeros and capacity of colind/val     */
+  sunindextype *rowptr;    /* row starts (N+1)                        */
+  sunindextype *colind;    /* column indices                          */
+  sunindextype *diag;      /* position of the diagonal of each row    */
+  realtype     *val;       /* values of L and U                       */
+  realtype     *dinv;      /* inverse diagonal of U                   */
+
+  int           atype;     /* ILU(0): pattern of the last matrix      */
+  sunindextype  annz;
+  sunindextype *aptrs, *avals;
+  sunindextype *amap;      /* ILU(0): factor position of each entry   */
+
+  sunindextype  nlevL, nlevU;       /* level schedules                */
+  sunindextype *levLptr, *levLrows;
+  sunindextype *levUptr, *levUrows;
+
+  sunindextype *iw;        /* column markers (N), -1 when unused      */
+  sunindextype *jw;        /* index work array (2N)                   */
+  realtype     *w;         /* dense work row (N), zero when unused    */
+
+  long int npivfix;        /* number of replaced pivots               */
+};
+
+/* private functions */
+static int  iluReserve(SUNILUMem ilu, sunindextype cap);
+static int  ilu0Symbolic(SUNILUMem ilu, SUNMatrix A);
+static void ilu0Numeric(SUNILUMem ilu, SUNMatrix A);
+static int  ilutFactor(SUNILUMem ilu, SUNMatrix A);
+static realtype iluPivot(SUNILUMem ilu, realtype d, realtype rowmax);
+static void iluLevels(SUNILUMem ilu);
+static void iluSelect(sunindextype *idx, sunindextype n, sunindextype k,
+                      realtype *w);
+static void iluSort(sunindextype *idx, sunindextype n);
+static int  iluCompare(const void *a, const void *b);
+
+
+/*
+ * -----------------------------------------------------------------
+ * Construction and options
+ * -----------------------------------------------------------------
+ */
+
+SUNILUMem SUNILUCreate(int type, sunindextype N)
+{
+  SUNILUMem ilu;
+  sunindextype i;
+
+  if ((type != SUNILU_ILU0) && (type != SUNILU_ILUT)) return(NULL);
+  if (N <= 0) return(NULL);
+
+  ilu = NULL;
+  ilu = (SUNILUMem) calloc(1, sizeof(struct SUNILUMemRec));
+  if (ilu == NULL) return(NULL);
+
+  ilu->type     = type;
+  ilu->N        = N;
+  ilu->droptol  = SUNILU_DROPTOL_DEFAULT;
+  ilu->lfil     = SUNILU_LFIL_DEFAULT;
+  ilu->nthreads = 1;
+  ilu->atype    = -1;
+
+  ilu->rowptr   = (sunindextype *) malloc((N+1)*sizeof(sunindextype));
+  ilu->diag     = (sunindextype *) malloc(N*sizeof(sunindextype));
+  ilu->dinv     = (realtype *) malloc(N*sizeof(realtype));
+  ilu->aptrs    = (sunindextype *) malloc((N+1)*sizeof(sunindextype));
+  ilu->levLptr  = (sunindextype *) malloc((N+1)*sizeof(sunindextype));
+  ilu->levLrows = (sunindextype *) malloc(N*sizeof(sunindextype));
+  ilu->levUptr  = (sunindextype *) malloc((N+1)*sizeof(sunindextype));
+  ilu->levUrows = (sunindextype *) malloc(N*sizeof(sunindextype));
+  ilu->iw       = (sunindextype *) malloc(N*sizeof(sunindextype));
+  ilu->jw       = (sunindextype *) malloc(2*N*sizeof(sunindextype));
+  ilu->w        = (realtype *) malloc(N*sizeof(realtype));
+
+  if ((ilu->rowptr == NULL) || (ilu->diag == NULL) || (ilu->dinv == NULL) ||
+      (ilu->aptrs == NULL) || (ilu->levLptr == NULL) ||
+      (ilu->levLrows == NULL) || (ilu->levUptr == NULL) ||
+      (ilu->levUrows == NULL) || (ilu->iw == NULL) || (ilu->jw == NULL) ||
+      (ilu->w == NULL)) {
+    SUNILUFree(ilu);
+    return(NULL);
+  }
+
+  for (i=0; i<N; i++) {
+    ilu->iw[i] = -1;
+    ilu->w[i]  = ZERO;
+  }
+  ilu->rowptr[0] = 0;
+
+  return(ilu);
+}
+
+int SUNILUSetThresholds(SUNILUMem ilu, realtype droptol, sunindextype lfil)
+{
+  if (ilu == NULL) return(SUNILU_ILL_INPUT);
+  if (droptol < ZERO) return(SUNILU_ILL_INPUT);
+
+  ilu->droptol = droptol;
+  ilu->lfil    = (lfil > 0) ? lfil : 0;
+
+  return(SUNILU_SUCCESS);
+}
+
+int SUNILUSetNumThreads(SUNILUMem ilu, int nthreads)
+{
+  if (ilu == NULL) return(SUNILU_ILL_INPUT);
+  if (nthreads < 1) return(SUNILU_ILL_INPUT);
+
+  ilu->nthreads = nthreads;
+
+  return(SUNILU_SUCCESS);
+}
+
+void SUNILUFree(SUNILUMem ilu)
+{
+  if (ilu == NULL) return;
+
+  free(ilu->rowptr);
+  free(ilu->colind);
+  free(ilu->diag);
+  free(ilu->val);
+  free(ilu->dinv);
+  free(ilu->aptrs);
+  free(ilu->avals);
+  free(ilu->amap);
+  free(ilu->levLptr);
+  free(ilu->levLrows);
+  free(ilu->levUptr);
+  free(ilu->levUrows);
+  free(ilu->iw);
+  free(ilu->jw);
+  free(ilu->w);
+  free(ilu);
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * Factorization
+ * -----------------------------------------------------------------
+ */
+
+int SUNILUFactor(SUNILUMem ilu, SUNMatrix A)
+{
+  sunindextype *ptrs, annz;
+  int retval;
+
+  if ((ilu == NULL) || (A == NULL)) return(SUNILU_ILL_INPUT);
+  if (SUNMatGetID(A) != SUNMATRIX_SPARSE) return(SUNILU_ILL_INPUT);
+  if ((SUNSparseMatrix_Rows(A) != ilu->N) ||
+      (SUNSparseMatrix_Columns(A) != ilu->N)) return(SUNILU_ILL_INPUT);
+
+  if (ilu->type == SUNILU_ILUT) {
+    retval = ilutFactor(ilu, A);
+    if (retval != SUNILU_SUCCESS) return(retval);
+    iluLevels(ilu);
+    return(SUNILU_SUCCESS);
+  }
+
+  /* ILU(0): redo the symbolic part only if the pattern changed */
+  ptrs = SUNSparseMatrix_IndexPointers(A);
+  annz = ptrs[ilu->N];
+  if ((ilu->atype != SUNSparseMatrix_SparseType(A)) || (ilu->annz != annz) ||
+      memcmp(ilu->aptrs, ptrs, (ilu->N+1)*sizeof(sunindextype)) ||
+      memcmp(ilu->avals, SUNSparseMatrix_IndexValues(A),
+             annz*sizeof(sunindextype))) {
+    retval = ilu0Symbolic(ilu, A);
+    if (retval != SUNILU_SUCCESS) return(retval);
+  }
+  ilu0Numeric(ilu, A);
+
+  return(SUNILU_SUCCESS);
+}
+
+/* Grows colind/val to hold at least cap entries, keeping the contents */
+static int iluReserve(SUNILUMem ilu, sunindextype cap)
+{
+  sunindextype *colind;
+  realtype *val;
+
+  if (cap <= ilu->cap) return(SUNILU_SUCCESS);
+  if (cap < 2*ilu->cap) cap = 2*ilu->cap;
+
+  colind = (sunindextype *) realloc(ilu->colind, cap*sizeof(sunindextype));
+  if (colind == NULL) return(SUNILU_MEM_FAIL);
+  ilu->colind = colind;
+
+  val = (realtype *) realloc(ilu->val, cap*sizeof(realtype));
+  if (val == NULL) return(SUNILU_MEM_FAIL);
+  ilu->val = val;
+
+  ilu->cap = cap;
+  return(SUNILU_SUCCESS);
+}
+
+/* Builds the ILU(0) pattern: the pattern of A by rows with the diagonal
+   added where it is structurally missing */
+static int ilu0Symbolic(SUNILUMem ilu, SUNMatrix A)
+{
+  sunindextype N, annz, nnz, i, j, p, q, row, col, tmp;
+  sunindextype *ptrs, *vals, *rowptr, *colind, *cur, *src, *amap, *avals;
+  int csr;
+
+  N    = ilu->N;
+  csr  = (SUNSparseMatrix_SparseType(A) == CSR_MAT);
+  ptrs = SUNSparseMatrix_IndexPointers(A);
+  vals = SUNSparseMatrix_IndexValues(A);
+  annz = ptrs[N];
+
+  rowptr = ilu->rowptr;
+  cur    = ilu->jw;
+  ilu->atype = -1;
+
+  /* count the entries of each row and mark the rows that have a
+     diagonal entry */
+  for (i=0; i<=N; i++) rowptr[i] = 0;
+  for (i=0; i<N; i++) cur[N+i] = 0;
+  for (j=0; j<N; j++) {
+    for (p=ptrs[j]; p<ptrs[j+1]; p++) {
+      row = csr ? j : vals[p];
+      col = csr ? vals[p] : j;
+      rowptr[row+1]++;
+      if (row == col) cur[N+row] = 1;
+    }
+  }
+  for (i=0; i<N; i++) {
+    if (!cur[N+i]) rowptr[i+1]++;
+    rowptr[i+1] += rowptr[i];
+  }
+  nnz = rowptr[N];
+
+  if (iluReserve(ilu, nnz) != SUNILU_SUCCESS) return(SUNILU_MEM_FAIL);
+  src = (sunindextype *) malloc(nnz*sizeof(sunindextype));
+  if (src == NULL) return(SUNILU_MEM_FAIL);
+  amap = (sunindextype *) realloc(ilu->amap,
+                                  (annz > 0 ? annz : 1)*sizeof(sunindextype));
+  if (amap == NULL) { free(src); return(SUNILU_MEM_FAIL); }
+  ilu->amap = amap;
+  avals = (sunindextype *) realloc(ilu->avals,
+                                   (annz > 0 ? annz : 1)*sizeof(sunindextype));
+  if (avals == NULL) { free(src); return(SUNILU_MEM_FAIL); }
+  ilu->avals = avals;
+  colind = ilu->colind;
+
+  /* scatter the entries into their rows; src records the entry of A
+     that each position came from (-1 for an added diagonal) */
+  for (i=0; i<N; i++) cur[i] = rowptr[i];
+  for (j=0; j<N; j++) {
+    for (p=ptrs[j]; p<ptrs[j+1]; p++) {
+      row = csr ? j : vals[p];
+      col = csr ? vals[p] : j;
+      q = cur[row]++;
+      colind[q] = col;
+      src[q] = p;
+    }
+  }
+  for (i=0; i<N; i++) {
+    if (!cur[N+i]) {
+      q = cur[i]++;
+      colind[q] = i;
+      src[q] = -1;
+    }
+  }
+
+  /* sort each row by column and locate the diagonal */
+  for (i=0; i<N; i++) {
+    for (p=rowptr[i]+1; p<rowptr[i+1]; p++) {
+      col = colind[p];
+      tmp = src[p];
+      for (q=p; (q>rowptr[i]) && (colind[q-1]>col); q--) {
+        colind[q] = colind[q-1];
+        src[q] = src[q-1];
+      }
+      colind[q] = col;
+      src[q] = tmp;
+    }
+    for (p=rowptr[i]; p<rowptr[i+1]; p++)
+      if (colind[p] == i) ilu->diag[i] = p;
+  }
+  for (q=0; q<nnz; q++)
+    if (src[q] >= 0) amap[src[q]] = q;
+  free(src);
+
+  /* remember the pattern of A */
+  memcpy(ilu->aptrs, ptrs, (N+1)*sizeof(sunindextype));
+  memcpy(ilu->avals, vals, annz*sizeof(sunindextype));
+  ilu->annz  = annz;
+  ilu->atype = SUNSparseMatrix_SparseType(A);
+  ilu->nnz   = nnz;
+
+  iluLevels(ilu);
+
+  return(SUNILU_SUCCESS);
+}
+
+/* ILU(0) elimination in IKJ order on the fixed pattern */
+static void ilu0Numeric(SUNILUMem ilu, SUNMatrix A)
+{
+  sunindextype N, i, k, p, q, jpos;
+  sunindextype *rowptr, *colind, *diag, *iw;
+  realtype *val, *dinv, *Adata, lik, rowmax, d;
+
+  N      = ilu->N;
+  rowptr = ilu->rowptr;
+  colind = ilu->colind;
+  diag   = ilu->diag;
+  val    = ilu->val;
+  dinv   = ilu->dinv;
+  iw     = ilu->iw;
+  Adata  = SUNSparseMatrix_Data(A);
+
+  for (p=0; p<ilu->nnz; p++) val[p] = ZERO;
+  for (p=0; p<ilu->annz; p++) val[ilu->amap[p]] += Adata[p];
+
+  for (i=0; i<N; i++) {
+    rowmax = ZERO;
+    for (p=rowptr[i]; p<rowptr[i+1]; p++) {
+      iw[colind[p]] = p;
+      rowmax = SUNMAX(rowmax, SUNRabs(val[p]));
+    }
+
+    for (p=rowptr[i]; p<diag[i]; p++) {
+      k = colind[p];
+      lik = val[p] * dinv[k];
+      val[p] = lik;
+      for (q=diag[k]+1; q<rowptr[k+1]; q++) {
+        jpos = iw[colind[q]];
+        if (jpos >= 0) val[jpos] -= lik*val[q];
+      }
+    }
+
+    d = iluPivot(ilu, val[diag[i]], rowmax);
+    val[diag[i]] = d;
+    dinv[i] = ONE/d;
+
+    for (p=rowptr[i]; p<rowptr[i+1]; p++) iw[colind[p]] = -1;
+  }
+}
+
+/* ILUT(droptol, lfil) factorization, Saad, Iterative Methods for
+   Sparse Linear Systems, Algorithm 10.6 */
+static int ilutFactor(SUNILUMem ilu, SUNMatrix A)
+{
+  sunindextype N, i, j, k, p, q, m, t, lenl, lenu, len, nnz, lfil;
+  sunindextype *ptrs, *vals, *rptr, *rind, *iw, *jw, *Lw, *Uw;
+  sunindextype *tptr, *tind;
+  realtype *Adata, *rval, *tval, *w, tnorm, thresh, rowmax, lik, d;
+
+  N     = ilu->N;
+  lfil  = ilu->lfil;
+  iw    = ilu->iw;
+  jw    = ilu->jw;
+  w     = ilu->w;
+  Lw    = jw;
+  Uw    = jw + N;
+  ptrs  = SUNSparseMatrix_IndexPointers(A);
+  vals  = SUNSparseMatrix_IndexValues(A);
+  Adata = SUNSparseMatrix_Data(A);
+
+  /* access A by rows */
+  tptr = NULL; tind = NULL; tval = NULL;
+  if (SUNSparseMatrix_SparseType(A) == CSR_MAT) {
+    rptr = ptrs;
+    rind = vals;
+    rval = Adata;
+  } else {
+    nnz  = ptrs[N];
+    tptr = (sunindextype *) calloc(N+1, sizeof(sunindextype));
+    tind = (sunindextype *) malloc((nnz > 0 ? nnz : 1)*sizeof(sunindextype));
+    tval = (realtype *) malloc((nnz > 0 ? nnz : 1)*sizeof(realtype));
+    if ((tptr == NULL) || (tind == NULL) || (tval == NULL)) {
+      free(tptr); free(tind); free(tval);
+      return(SUNILU_MEM_FAIL);
+    }
+    for (p=0; p<nnz; p++) tptr[vals[p]+1]++;
+    for (i=0; i<N; i++) tptr[i+1] += tptr[i];
+    for (i=0; i<N; i++) jw[i] = tptr[i];
+    for (j=0; j<N; j++) {
+      for (p=ptrs[j]; p<ptrs[j+1]; p++) {
+        q = jw[vals[p]]++;
+        tind[q] = j;
+        tval[q] = Adata[p];
+      }
+    }
+    rptr = tptr;
+    rind = tind;
+    rval = tval;
+  }
+
+  nnz = 0;
+  ilu->rowptr[0] = 0;
+
+  for (i=0; i<N; i++) {
+
+    /* scatter row i into the work row */
+    tnorm = ZERO;
+    rowmax = ZERO;
+    lenl = 0;
+    lenu = 0;
+    iw[i] = i;
+    for (p=rptr[i]; p<rptr[i+1]; p++) {
+      j = rind[p];
+      tnorm += SUNRabs(rval[p]);
+      rowmax = SUNMAX(rowmax, SUNRabs(rval[p]));
+      if (iw[j] < 0) {
+        iw[j] = j;
+        if (j < i) Lw[lenl++] = j;
+        else if (j > i) Uw[lenu++] = j;
+      }
+      w[j] += rval[p];
+    }
+    len = rptr[i+1] - rptr[i];
+    thresh = (len > 0) ? ilu->droptol * tnorm / len : ZERO;
+
+    /* eliminate the L entries in increasing column order; fill-in in
+       a column already passed cannot occur */
+    for (m=0; m<lenl; ) {
+      t = m;
+      for (q=m+1; q<lenl; q++) if (Lw[q] < Lw[t]) t = q;
+      k = Lw[t]; Lw[t] = Lw[m]; Lw[m] = k;
+
+      lik = w[k] * ilu->dinv[k];
+      if (SUNRabs(lik) <= thresh) {
+        w[k] = ZERO;
+        iw[k] = -1;
+        Lw[m] = Lw[--lenl];
+        continue;
+      }
+      w[k] = lik;
+
+      for (q=ilu->diag[k]+1; q<ilu->rowptr[k+1]; q++) {
+        j = ilu->colind[q];
+        if (iw[j] < 0) {
+          iw[j] = j;
+          if (j < i) Lw[lenl++] = j;
+          else Uw[lenu++] = j;
+        }
+        w[j] -= lik*ilu->val[q];
+      }
+      m++;
+    }
+
+    /* drop small U entries and keep the lfil largest of L and U */
+    for (m=0, t=0; m<lenu; m++) {
+      j = Uw[m];
+      if (SUNRabs(w[j]) > thresh) {
+        Uw[t++] = j;
+      } else {
+        w[j] = ZERO;
+        iw[j] = -1;
+      }
+    }
+    lenu = t;
+    if ((lfil > 0) && (lenl > lfil)) {
+      iluSelect(Lw, lenl, lfil, w);
+      for (m=lfil; m<lenl; m++) { w[Lw[m]] = ZERO; iw[Lw[m]] = -1; }
+      lenl = lfil;
+    }
+    if ((lfil > 0) && (lenu > lfil)) {
+      iluSelect(Uw, lenu, lfil, w);
+      for (m=lfil; m<lenu; m++) { w[Uw[m]] = ZERO; iw[Uw[m]] = -1; }
+      lenu = lfil;
+    }
+
+    /* store row i */
+    if (iluReserve(ilu, nnz+lenl+lenu+1) != SUNILU_SUCCESS) {
+      free(tptr); free(tind); free(tval);
+      return(SUNILU_MEM_FAIL);
+    }
+    iluSort(Lw, lenl);
+    iluSort(Uw, lenu);
+    for (m=0; m<lenl; m++) {
+      ilu->colind[nnz+m] = Lw[m];
+      ilu->val[nnz+m] = w[Lw[m]];
+    }
+    nnz += lenl;
+
+    d = iluPivot(ilu, w[i], rowmax);
+    ilu->diag[i] = nnz;
+    ilu->colind[nnz] = i;
+    ilu->val[nnz] = d;
+    ilu->dinv[i] = ONE/d;
+    nnz++;
+
+    for (m=0; m<lenu; m++) {
+      ilu->colind[nnz+m] = Uw[m];
+      ilu->val[nnz+m] = w[Uw[m]];
+    }
+    nnz += lenu;
+    ilu->rowptr[i+1] = nnz;
+
+    /* reset the work row */
+    for (m=0; m<lenl; m++) { w[Lw[m]] = ZERO; iw[Lw[m]] = -1; }
+    for (m=0; m<lenu; m++) { w[Uw[m]] = ZERO; iw[Uw[m]] = -1; }
+    w[i] = ZERO;
+    iw[i] = -1;
+  }
+
+  ilu->nnz = nnz;
+
+  free(tptr); free(tind); free(tval);
+  return(SUNILU_SUCCESS);
+}
+
+/* Replaces a zero or tiny pivot */
+static realtype iluPivot(SUNILUMem ilu, realtype d, realtype rowmax)
+{
+  realtype tiny;
+
+  if (rowmax == ZERO) rowmax = ONE;
+  tiny = SUNRsqrt(UNIT_ROUNDOFF) * rowmax;
+  if (SUNRabs(d) >= tiny) return(d);
+
+  ilu->npivfix++;
+  return((d < ZERO) ? -tiny : tiny);
+}
+
+/* Partially sorts idx[0..n) so that its first k entries index the k
+   largest values of |w| (quick split, Saad's SPARSKIT qsplit) */
+static void iluSelect(sunindextype *idx, sunindextype n, sunindextype k,
+                      realtype *w)
+{
+  sunindextype first, last, mid, j, tmp;
+  realtype abskey;
+
+  first = 0;
+  last  = n-1;
+  if ((k <= 0) || (k >= n)) return;
+
+  for (;;) {
+    mid = first;
+    abskey = SUNRabs(w[idx[mid]]);
+    for (j=first+1; j<=last; j++) {
+      if (SUNRabs(w[idx[j]]) > abskey) {
+        mid++;
+        tmp = idx[mid]; idx[mid] = idx[j]; idx[j] = tmp;
+      }
+    }
+    tmp = idx[mid]; idx[mid] = idx[first]; idx[first] = tmp;
+
+    if (mid == k-1 || mid == k) return;
+    if (mid > k) last = mid-1;
+    else first = mid+1;
+  }
+}
+
+/* Sorts a list of column indices */
+static void iluSort(sunindextype *idx, sunindextype n)
+{
+  sunindextype p, q, col;
+
+  if (n >= 32) {
+    qsort(idx, n, sizeof(sunindextype), iluCompare);
+    return;
+  }
+
+  for (p=1; p<n; p++) {
+    col = idx[p];
+    for (q=p; (q>0) && (idx[q-1]>col); q--) idx[q] = idx[q-1];
+    idx[q] = col;
+  }
+}
+
+static int iluCompare(const void *a, const void *b)
+{
+  sunindextype ia = *((const sunindextype *) a);
+  sunindextype ib = *((const sunindextype *) b);
+  return((ia > ib) - (ia < ib));
+}
+
+/* Groups the rows of L (forward) and U (backward) into levels and
+   sorts the rows by level, keeping the row order within a level */
+static void iluLevels(SUNILUMem ilu)
+{
+  sunindextype N, i, p, l, nlev;
+  sunindextype *rowptr, *colind, *diag, *lev, *ptr;
+
+  N      = ilu->N;
+  rowptr = ilu->rowptr;
+  colind = ilu->colind;
+  diag   = ilu->diag;
+  lev    = ilu->jw;
+
+  /* L */
+  nlev = 0;
+  for (i=0; i<N; i++) {
+    l = 0;
+    for (p=rowptr[i]; p<diag[i]; p++) l = SUNMAX(l, lev[colind[p]]+1);
+    lev[i] = l;
+    nlev = SUNMAX(nlev, l+1);
+  }
+  ptr = ilu->levLptr;
+  for (l=0; l<=nlev; l++) ptr[l] = 0;
+  for (i=0; i<N; i++) ptr[lev[i]+1]++;
+  for (l=0; l<nlev; l++) ptr[l+1] += ptr[l];
+  for (i=0; i<N; i++) ilu->levLrows[ptr[lev[i]]++] = i;
+  for (l=nlev; l>0; l--) ptr[l] = ptr[l-1];
+  ptr[0] = 0;
+  ilu->nlevL = nlev;
+
+  /* U */
+  nlev = 0;
+  for (i=N-1; i>=0; i--) {
+    l = 0;
+    for (p=diag[i]+1; p<rowptr[i+1]; p++) l = SUNMAX(l, lev[colind[p]]+1);
+    lev[i] = l;
+    nlev = SUNMAX(nlev, l+1);
+  }
+  ptr = ilu->levUptr;
+  for (l=0; l<=nlev; l++) ptr[l] = 0;
+  for (i=0; i<N; i++) ptr[lev[i]+1]++;
+  for (l=0; l<nlev; l++) ptr[l+1] += ptr[l];
+  for (i=N-1; i>=0; i--) ilu->levUrows[ptr[lev[i]]++] = i;
+  for (l=nlev; l>0; l--) ptr[l] = ptr[l-1];
+  ptr[0] = 0;
+  ilu->nlevU = nlev;
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * Triangular solves
+ * -----------------------------------------------------------------
+ */
+
+int SUNILUSolve(SUNILUMem ilu, N_Vector b, N_Vector x)
+{
+  sunindextype l, r, i, p, lo, hi;
+  sunindextype *rowptr, *colind, *diag, *rows;
+  realtype *val, *dinv, *bd, *xd, s;
+  int nthreads;
+
+  if ((ilu == NULL) || (b == NULL) || (x == NULL)) return(SUNILU_ILL_INPUT);
+  if (ilu->nnz == 0) return(SUNILU_ILL_INPUT);
+
+  bd = N_VGetArrayPointer(b);
+  xd = N_VGetArrayPointer(x);
+  if ((bd == NULL) || (xd == NULL)) return(SUNILU_ILL_INPUT);
+
+  rowptr   = ilu->rowptr;
+  colind   = ilu->colind;
+  diag     = ilu->diag;
+  val      = ilu->val;
+  dinv     = ilu->dinv;
+  nthreads = ilu->nthreads;
+
+  /* L z = b; each row reads b before writing x, so b == x is fine */
+  rows = ilu->levLrows;
+  for (l=0; l<ilu->nlevL; l++) {
+    lo = ilu->levLptr[l];
+    hi = ilu->levLptr[l+1];
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) private(r,i,p,s) schedule(static) \
+  if((nthreads > 1) && (hi-lo >= SUNILU_PAR_MIN)) num_threads(nthreads)
+#endif
+    for (r=lo; r<hi; r++) {
+      i = rows[r];
+      s = bd[i];
+      for (p=rowptr[i]; p<diag[i]; p++) s -= val[p]*xd[colind[p]];
+      xd[i] = s;
+    }
+  }
+
+  /* U x = z */
+  rows = ilu->levUrows;
+  for (l=0; l<ilu->nlevU; l++) {
+    lo = ilu->levUptr[l];
+    hi = ilu->levUptr[l+1];
+#if defined(_OPENMP)
+#pragma omp parallel for default(shared) private(r,i,p,s) schedule(static) \
+  if((nthreads > 1) && (hi-lo >= SUNILU_PAR_MIN)) num_threads(nthreads)
+#endif
+    for (r=lo; r<hi; r++) {
+      i = rows[r];
+      s = xd[i];
+      for (p=diag[i]+1; p<rowptr[i+1]; p++) s -= val[p]*xd[colind[p]];
+      xd[i] = s*dinv[i];
+    }
+  }
+
+  (void) nthreads;
+  return(SUNILU_SUCCESS);
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * Optional outputs
+ * -----------------------------------------------------------------
+ */
+
+int SUNILUGetNumLevels(SUNILUMem ilu, sunindextype *nlevL,
+                       sunindextype *nlevU)
+{
+  if (ilu == NULL) return(SUNILU_ILL_INPUT);
+  *nlevL = ilu->nlevL;
+  *nlevU = ilu->nlevU;
+  return(SUNILU_SUCCESS);
+}
+
+int SUNILUGetNumNonzeros(SUNILUMem ilu, sunindextype *nnz)
+{
+  if (ilu == NULL) return(SUNILU_ILL_INPUT);
+  *nnz = ilu->nnz;
+  return(SUNILU_SUCCESS);
+}
+
+int SUNILUGetNumPivotFixes(SUNILUMem ilu, long int *npivfix)
+{
+  if (ilu == NULL) return(SUNILU_ILL_INPUT);
+  *npivfix = ilu->npivfix;
+  return(SUNILU_SUCCESS);
+}
+
+int SUNILUGetWorkSpace(SUNILUMem ilu, long int *lenrw, long int *leniw)
+{
+  if (ilu == NULL) return(SUNILU_ILL_INPUT);
+  *lenrw = (long int) (ilu->cap + 2*ilu->N);
+  *leniw = (long int) (ilu->cap + 10*ilu->N + 4 + 2*ilu->annz);
+  return(SUNILU_SUCCESS);
+}
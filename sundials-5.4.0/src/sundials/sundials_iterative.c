@@ -153,6 +153,314 @@ int ClassicalGS(N_Vector *v, realtype **h, int k, int p, realtype *new_vk_norm,
   return(0);
 }
 
+/*
+ * -----------------------------------------------------------------
+ * Function : cgsPass
+ * -----------------------------------------------------------------
+ * One classical Gram-Schmidt pass which also reduces the squared
+ * norm of v[k] with the same N_VDotProdMulti call. The inner
+ * products are added to h, the norm of the corrected v[k] follows
+ * from the Pythagorean theorem since v[i0], ..., v[k-1] are
+ * orthonormal. It is only trusted if no more than about three
+ * digits cancel, the norm is recomputed otherwise. On return
+ * needs_reorth tells if v[k] came out nearly in the span of the
+ * basis (one extra pass restores its orthogonality).
+ * -----------------------------------------------------------------
+ */
+
+static int cgsPass(N_Vector *v, realtype **h, int k, int i0,
+                   realtype *new_vk_norm, realtype *stemp, N_Vector *vtemp,
+                   booleantype *needs_reorth)
+{
+  int i, nv, retval;
+  realtype vk_norm2, proj_norm2, new_norm2;
+
+  nv = k - i0;
+
+  retval = N_VDotProdMulti(nv+1, v[k], v+i0, stemp);
+  if (retval != 0) return(-1);
+
+  vk_norm2   = stemp[nv];
+  proj_norm2 = ZERO;
+  for (i=nv-1; i >= 0; i--) {
+    h[i0+i][k-1] += stemp[i];
+    proj_norm2   += SUNSQR(stemp[i]);
+    stemp[i+1] = -stemp[i];
+    vtemp[i+1] = v[i0+i];
+  }
+  stemp[0] = ONE;
+  vtemp[0] = v[k];
+
+  retval = N_VLinearCombination(nv+1, stemp, vtemp, v[k]);
+  if (retval != 0) return(-1);
+
+  new_norm2 = vk_norm2 - proj_norm2;
+  *needs_reorth = (SUNSQR(FACTOR) * new_norm2 < vk_norm2);
+
+  if (*needs_reorth)
+    *new_vk_norm = SUNRsqrt(N_VDotProd(v[k], v[k]));
+  else
+    *new_vk_norm = SUNRsqrt(new_norm2);
+
+  return(0);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Function : ClassicalGS2
+ * -----------------------------------------------------------------
+ */
+
+int ClassicalGS2(N_Vector *v, realtype **h, int k, int p,
+                 realtype *new_vk_norm, realtype *stemp, N_Vector *vtemp)
+{
+  int i, i0, retval;
+  booleantype needs_reorth;
+
+  i0 = SUNMAX(k-p, 0);
+
+  for (i=i0; i < k; i++) h[i][k-1] = ZERO;
+
+  /* Orthogonalize twice, the norm comes with the second reduction */
+
+  retval = cgsPass(v, h, k, i0, new_vk_norm, stemp, vtemp, &needs_reorth);
+  if (retval != 0) return(-1);
+
+  retval = cgsPass(v, h, k, i0, new_vk_norm, stemp, vtemp, &needs_reorth);
+  if (retval != 0) return(-1);
+
+  return(0);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Function : LowSyncGS
+ * -----------------------------------------------------------------
+ */
+
+int LowSyncGS(N_Vector *v, realtype **h, int k, int p,
+              realtype *new_vk_norm, realtype *stemp, N_Vector *vtemp)
+{
+  int i, i0, retval;
+  booleantype needs_reorth;
+
+  i0 = SUNMAX(k-p, 0);
+
+  for (i=i0; i < k; i++) h[i][k-1] = ZERO;
+
+  /* One reduction, reorthogonalize only if v[k] lost most of its norm */
+
+  retval = cgsPass(v, h, k, i0, new_vk_norm, stemp, vtemp, &needs_reorth);
+  if (retval != 0) return(-1);
+
+  if (needs_reorth) {
+    retval = cgsPass(v, h, k, i0, new_vk_norm, stemp, vtemp, &needs_reorth);
+    if (retval != 0) return(-1);
+  }
+
+  return(0);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Function : qrCombine
+ * -----------------------------------------------------------------
+ * Forms z = X[0] + sum c[i] X[i], i = 1, ..., nvec-1, normalized.
+ * c[0] is set here. nrm2 is the squared norm of the result from
+ * the Pythagorean theorem and ref2 the squared norm of X[0]. If no
+ * more than about three digits cancel, the scaling is folded into
+ * the combination, otherwise the norm is recomputed. A zero result
+ * is left as zero. The norm used is returned in nrm.
+ * -----------------------------------------------------------------
+ */
+
+static int qrCombine(int nvec, realtype *c, N_Vector *X, N_Vector z,
+                     realtype nrm2, realtype ref2, realtype *nrm)
+{
+  int i, retval;
+  realtype scale;
+
+  if ((nrm2 > ZERO) && (SUNSQR(FACTOR) * nrm2 >= ref2)) {
+    *nrm  = SUNRsqrt(nrm2);
+    scale = ONE / (*nrm);
+    c[0]  = scale;
+    for (i=1; i < nvec; i++) c[i] *= scale;
+    retval = N_VLinearCombination(nvec, c, X, z);
+    if (retval != 0) return(-1);
+    return(0);
+  }
+
+  c[0] = ONE;
+  retval = N_VLinearCombination(nvec, c, X, z);
+  if (retval != 0) return(-1);
+
+  *nrm = SUNRsqrt(N_VDotProd(z, z));
+  if (*nrm > ZERO)
+    N_VScale(ONE/(*nrm), z, z);
+  else
+    N_VConst(ZERO, z);
+
+  return(0);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Function : QRAddMGS
+ * -----------------------------------------------------------------
+ */
+
+int QRAddMGS(N_Vector *Q, realtype *R, N_Vector df, int m, int mmax,
+             realtype *stemp, N_Vector *vtemp)
+{
+  int j;
+  realtype *Rm;
+
+  Rm = R + m*mmax;
+
+  N_VScale(ONE, df, Q[m]);
+  for (j=0; j < m; j++) {
+    Rm[j] = N_VDotProd(Q[j], Q[m]);
+    N_VLinearSum(ONE, Q[m], -Rm[j], Q[j], Q[m]);
+  }
+
+  Rm[m] = SUNRsqrt(N_VDotProd(Q[m], Q[m]));
+  if (Rm[m] > ZERO)
+    N_VScale(ONE/Rm[m], Q[m], Q[m]);
+  else
+    N_VConst(ZERO, Q[m]);
+
+  return(0);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Function : QRAddCGS2
+ * -----------------------------------------------------------------
+ */
+
+int QRAddCGS2(N_Vector *Q, realtype *R, N_Vector df, int m, int mmax,
+              realtype *stemp, N_Vector *vtemp)
+{
+  int j, retval;
+  realtype *Rm, dd, vv, ss;
+
+  Rm = R + m*mmax;
+
+  /* first pass, r = Q^T df and ||df||^2 in one reduction */
+
+  for (j=0; j < m; j++) vtemp[j] = Q[j];
+  vtemp[m] = df;
+
+  retval = N_VDotProdMulti(m+1, df, vtemp, stemp);
+  if (retval != 0) return(-1);
+
+  dd = stemp[m];
+  for (j=m-1; j >= 0; j--) {
+    Rm[j]      = stemp[j];
+    stemp[j+1] = -stemp[j];
+    vtemp[j+1] = Q[j];
+  }
+  vtemp[0] = df;
+
+  if (m == 0)
+    return(qrCombine(1, stemp, vtemp, Q[0], dd, dd, &Rm[0]));
+
+  stemp[0] = ONE;
+  retval = N_VLinearCombination(m+1, stemp, vtemp, Q[m]);
+  if (retval != 0) return(-1);
+
+  /* second pass, s = Q^T v and ||v||^2, Q[m] is the last entry of Q */
+
+  retval = N_VDotProdMulti(m+1, Q[m], Q, stemp);
+  if (retval != 0) return(-1);
+
+  vv = stemp[m];
+  ss = ZERO;
+  for (j=m-1; j >= 0; j--) {
+    Rm[j]      += stemp[j];
+    ss         += SUNSQR(stemp[j]);
+    stemp[j+1]  = -stemp[j];
+    vtemp[j+1]  = Q[j];
+  }
+  vtemp[0] = Q[m];
+
+  return(qrCombine(m+1, stemp, vtemp, Q[m], vv - ss, vv, &Rm[m]));
+}
+
+/*
+ * -----------------------------------------------------------------
+ * Function : QRAddDCGS2
+ * -----------------------------------------------------------------
+ */
+
+int QRAddDCGS2(N_Vector *Q, realtype *R, N_Vector df, int m, int mmax,
+               realtype *stemp, N_Vector *vtemp)
+{
+  int j, retval;
+  realtype *Rm, *Rl, *s, *t, qq, ss, st, dd, tt, nrm;
+
+  Rm = R + m*mmax;
+
+  if (m == 0) {
+    dd = N_VDotProd(df, df);
+    vtemp[0] = df;
+    return(qrCombine(1, stemp, vtemp, Q[0], dd, dd, &Rm[0]));
+  }
+
+  Rl = R + (m-1)*mmax;
+  s  = stemp;
+  t  = stemp + m;
+
+  /* s = Q[0..m-2]^T Q[m-1] with ||Q[m-1]||^2, and t = Q^T df with
+     ||df||^2, both from the vectors on entry */
+
+  retval = N_VDotProdMulti(m, Q[m-1], Q, s);
+  if (retval != 0) return(-1);
+
+  for (j=0; j < m; j++) vtemp[j] = Q[j];
+  vtemp[m] = df;
+
+  retval = N_VDotProdMulti(m+1, df, vtemp, t);
+  if (retval != 0) return(-1);
+
+  /* delayed second pass of Q[m-1] */
+
+  qq = s[m-1];
+  if (qq > ZERO) {
+    ss = ZERO;
+    st = ZERO;
+    for (j=m-2; j >= 0; j--) {
+      ss      += SUNSQR(s[j]);
+      st      += s[j] * t[j];
+      Rl[j]   += Rl[m-1] * s[j];
+      s[j+1]   = -s[j];
+      vtemp[j+1] = Q[j];
+    }
+    vtemp[0] = Q[m-1];
+
+    retval = qrCombine(m, s, vtemp, Q[m-1], qq - ss, qq, &nrm);
+    if (retval != 0) return(-1);
+
+    /* the inner product of df with the corrected Q[m-1] */
+    Rl[m-1] *= nrm;
+    t[m-1] = (nrm > ZERO) ? (t[m-1] - st) / nrm : ZERO;
+  }
+
+  /* first pass of df */
+
+  dd = t[m];
+  tt = ZERO;
+  for (j=m-1; j >= 0; j--) {
+    Rm[j]      = t[j];
+    tt        += SUNSQR(t[j]);
+    t[j+1]     = -t[j];
+    vtemp[j+1] = Q[j];
+  }
+  vtemp[0] = df;
+
+  return(qrCombine(m+1, t, vtemp, Q[m], dd - tt, dd, &Rm[m]));
+}
+
 /*
  * -----------------------------------------------------------------
  * Function : QRfact
@@ -21,6 +21,10 @@
 #include <stdlib.h>
 #include <sundials/sundials_matrix.h>
 #include <sundials/sundials_nvector.h>
+#include <sundials/sundials_profiler.h>
+
+/* the operations record into the profiler of the running integrator */
+#define SM_PROFILER SUNProfiler_GetActive()
 
 /* -----------------------------------------------------------------
  * Create a new empty SUNMatrix object
@@ -141,32 +145,56 @@ void SUNMatDestroy(SUNMatrix A)
 
 int SUNMatZero(SUNMatrix A)
 {
-  return((int) A->ops->zero(A));
+  int ier;
+  SUNDIALS_MARK_FUNCTION_BEGIN(SM_PROFILER);
+  ier = (int) A->ops->zero(A);
+  SUNDIALS_MARK_FUNCTION_END(SM_PROFILER);
+  return(ier);
 }
 
 int SUNMatCopy(SUNMatrix A, SUNMatrix B)
 {
-  return((int) A->ops->copy(A, B));
+  int ier;
+  SUNDIALS_MARK_FUNCTION_BEGIN(SM_PROFILER);
+  ier = (int) A->ops->copy(A, B);
+  SUNDIALS_MARK_FUNCTION_END(SM_PROFILER);
+  return(ier);
 }
 
 int SUNMatScaleAdd(realtype c, SUNMatrix A, SUNMatrix B)
 {
-  return((int) A->ops->scaleadd(c, A, B));
+  int ier;
+  SUNDIALS_MARK_FUNCTION_BEGIN(SM_PROFILER);
+  ier = (int) A->ops->scaleadd(c, A, B);
+  SUNDIALS_MARK_FUNCTION_END(SM_PROFILER);
+  return(ier);
 }
 
 int SUNMatScaleAddI(realtype c, SUNMatrix A)
 {
-  return((int) A->ops->scaleaddi(c, A));
+  int ier;
+  SUNDIALS_MARK_FUNCTION_BEGIN(SM_PROFILER);
+  ier = (int) A->ops->scaleaddi(c, A);
+  SUNDIALS_MARK_FUNCTION_END(SM_PROFILER);
+  return(ier);
 }
 
 int SUNMatMatvecSetup(SUNMatrix A)
 {
-  return((int) A->ops->matvecsetup(A));
+  int ier;
+  SUNDIALS_MARK_FUNCTION_BEGIN(SM_PROFILER);
+  ier = (int) A->ops->matvecsetup(A);
+  SUNDIALS_MARK_FUNCTION_END(SM_PROFILER);
+  return(ier);
 }
 
 int SUNMatMatvec(SUNMatrix A, N_Vector x, N_Vector y)
 {
-  return((int) A->ops->matvec(A, x, y));
+  int ier;
+  SUNDIALS_MARK_FUNCTION_BEGIN(SM_PROFILER);
+  ier = (int) A->ops->matvec(A, x, y);
+  SUNDIALS_MARK_FUNCTION_END(SM_PROFILER);
+  return(ier);
 }
 
 int SUNMatSpace(SUNMatrix A, long int *lenrw, long int *leniw)
@@ -22,6 +22,10 @@
 #include <stdlib.h>
 
 #include <sundials/sundials_nvector.h>
+#include <sundials/sundials_profiler.h>
+
+/* the operations record into the profiler of the running integrator */
+#define NV_PROFILER SUNProfiler_GetActive()
 
 /* -----------------------------------------------------------------
  * Create an empty NVector object
@@ -289,106 +293,164 @@ sunindextype N_VGetLength(N_Vector v)
 
 void N_VLinearSum(realtype a, N_Vector x, realtype b, N_Vector y, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvlinearsum(a, x, b, y, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 void N_VConst(realtype c, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvconst(c, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 void N_VProd(N_Vector x, N_Vector y, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvprod(x, y, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 void N_VDiv(N_Vector x, N_Vector y, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvdiv(x, y, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 void N_VScale(realtype c, N_Vector x, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvscale(c, x, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 void N_VAbs(N_Vector x, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvabs(x, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 void N_VInv(N_Vector x, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvinv(x, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 void N_VAddConst(N_Vector x, realtype b, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvaddconst(x, b, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 realtype N_VDotProd(N_Vector x, N_Vector y)
 {
-  return((realtype) y->ops->nvdotprod(x, y));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) y->ops->nvdotprod(x, y);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VMaxNorm(N_Vector x)
 {
-  return((realtype) x->ops->nvmaxnorm(x));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvmaxnorm(x);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VWrmsNorm(N_Vector x, N_Vector w)
 {
-  return((realtype) x->ops->nvwrmsnorm(x, w));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvwrmsnorm(x, w);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VWrmsNormMask(N_Vector x, N_Vector w, N_Vector id)
 {
-  return((realtype) x->ops->nvwrmsnormmask(x, w, id));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvwrmsnormmask(x, w, id);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VMin(N_Vector x)
 {
-  return((realtype) x->ops->nvmin(x));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvmin(x);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VWL2Norm(N_Vector x, N_Vector w)
 {
-  return((realtype) x->ops->nvwl2norm(x, w));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvwl2norm(x, w);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VL1Norm(N_Vector x)
 {
-  return((realtype) x->ops->nvl1norm(x));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvl1norm(x);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 void N_VCompare(realtype c, N_Vector x, N_Vector z)
 {
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
   z->ops->nvcompare(c, x, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
   return;
 }
 
 booleantype N_VInvTest(N_Vector x, N_Vector z)
 {
-  return((booleantype) z->ops->nvinvtest(x, z));
+  booleantype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (booleantype) z->ops->nvinvtest(x, z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 booleantype N_VConstrMask(N_Vector c, N_Vector x, N_Vector m)
 {
-  return((booleantype) x->ops->nvconstrmask(c, x, m));
+  booleantype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (booleantype) x->ops->nvconstrmask(c, x, m);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VMinQuotient(N_Vector num, N_Vector denom)
 {
-  return((realtype) num->ops->nvminquotient(num, denom));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) num->ops->nvminquotient(num, denom);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 /* -----------------------------------------------------------------
@@ -397,12 +459,14 @@ realtype N_VMinQuotient(N_Vector num, N_Vector denom)
 
 int N_VLinearCombination(int nvec, realtype* c, N_Vector* X, N_Vector z)
 {
-  int i;
+  int i, ier;
   realtype ONE=RCONST(1.0);
 
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+
   if (z->ops->nvlinearcombination != NULL) {
 
-    return(z->ops->nvlinearcombination(nvec, c, X, z));
+    ier = z->ops->nvlinearcombination(nvec, c, X, z);
 
   } else {
 
@@ -410,46 +474,59 @@ int N_VLinearCombination(int nvec, realtype* c, N_Vector* X, N_Vector z)
     for (i=1; i<nvec; i++) {
       z->ops->nvlinearsum(c[i], X[i], ONE, z, z);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VScaleAddMulti(int nvec, realtype* a, N_Vector x, N_Vector* Y, N_Vector* Z)
 {
-  int i;
+  int i, ier;
   realtype ONE=RCONST(1.0);
 
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+
   if (x->ops->nvscaleaddmulti != NULL) {
 
-    return(x->ops->nvscaleaddmulti(nvec, a, x, Y, Z));
+    ier = x->ops->nvscaleaddmulti(nvec, a, x, Y, Z);
 
   } else {
 
     for (i=0; i<nvec; i++) {
       x->ops->nvlinearsum(a[i], x, ONE, Y[i], Z[i]);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VDotProdMulti(int nvec, N_Vector x, N_Vector* Y, realtype* dotprods)
 {
-  int i;
+  int i, ier;
+
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
 
   if (x->ops->nvdotprodmulti != NULL) {
 
-    return(x->ops->nvdotprodmulti(nvec, x, Y, dotprods));
+    ier = x->ops->nvdotprodmulti(nvec, x, Y, dotprods);
 
   } else {
 
     for (i=0; i<nvec; i++) {
       dotprods[i] = x->ops->nvdotprod(x, Y[i]);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 /* -----------------------------------------------------------------
@@ -459,76 +536,94 @@ int N_VDotProdMulti(int nvec, N_Vector x, N_Vector* Y, realtype* dotprods)
 int N_VLinearSumVectorArray(int nvec, realtype a, N_Vector* X,
                             realtype b, N_Vector* Y, N_Vector* Z)
 {
-  int i;
+  int i, ier;
+
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
 
   if (Z[0]->ops->nvlinearsumvectorarray != NULL) {
 
-    return(Z[0]->ops->nvlinearsumvectorarray(nvec, a, X, b, Y, Z));
+    ier = Z[0]->ops->nvlinearsumvectorarray(nvec, a, X, b, Y, Z);
 
   } else {
 
     for (i=0; i<nvec; i++) {
       Z[0]->ops->nvlinearsum(a, X[i], b, Y[i], Z[i]);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VScaleVectorArray(int nvec, realtype* c, N_Vector* X, N_Vector* Z)
 {
-  int i;
+  int i, ier;
+
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
 
   if (Z[0]->ops->nvscalevectorarray != NULL) {
 
-    return(Z[0]->ops->nvscalevectorarray(nvec, c, X, Z));
+    ier = Z[0]->ops->nvscalevectorarray(nvec, c, X, Z);
 
   } else {
 
     for (i=0; i<nvec; i++) {
       Z[0]->ops->nvscale(c[i], X[i], Z[i]);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VConstVectorArray(int nvec, realtype c, N_Vector* Z)
 {
   int i, ier;
 
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+
   if (Z[0]->ops->nvconstvectorarray != NULL) {
 
     ier = Z[0]->ops->nvconstvectorarray(nvec, c, Z);
-    return(ier);
 
   } else {
 
     for (i=0; i<nvec; i++) {
       Z[0]->ops->nvconst(c, Z[i]);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VWrmsNormVectorArray(int nvec, N_Vector* X, N_Vector* W, realtype* nrm)
 {
   int i, ier;
 
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+
   if (X[0]->ops->nvwrmsnormvectorarray != NULL) {
 
     ier = X[0]->ops->nvwrmsnormvectorarray(nvec, X, W, nrm);
-    return(ier);
 
   } else {
 
     for (i=0; i<nvec; i++) {
       nrm[i] = X[0]->ops->nvwrmsnorm(X[i], W[i]);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VWrmsNormMaskVectorArray(int nvec, N_Vector* X, N_Vector* W, N_Vector id,
@@ -536,19 +631,23 @@ int N_VWrmsNormMaskVectorArray(int nvec, N_Vector* X, N_Vector* W, N_Vector id,
 {
   int i, ier;
 
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+
   if (id->ops->nvwrmsnormmaskvectorarray != NULL) {
 
     ier = id->ops->nvwrmsnormmaskvectorarray(nvec, X, W, id, nrm);
-    return(ier);
 
   } else {
 
     for (i=0; i<nvec; i++) {
       nrm[i] = id->ops->nvwrmsnormmask(X[i], W[i], id);
     }
-    return(0);
+    ier = 0;
 
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VScaleAddMultiVectorArray(int nvec, int nsum, realtype* a, N_Vector* X,
@@ -560,10 +659,11 @@ int N_VScaleAddMultiVectorArray(int nvec, int nsum, realtype* a, N_Vector* X,
   N_Vector* YY=NULL;
   N_Vector* ZZ=NULL;
 
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+
   if (X[0]->ops->nvscaleaddmultivectorarray != NULL) {
 
     ier = X[0]->ops->nvscaleaddmultivectorarray(nvec, nsum, a, X, Y, Z);
-    return(ier);
 
   } else if (X[0]->ops->nvscaleaddmulti != NULL ) {
 
@@ -586,8 +686,6 @@ int N_VScaleAddMultiVectorArray(int nvec, int nsum, realtype* a, N_Vector* X,
     free(YY);
     free(ZZ);
 
-    return(ier);
-
   } else {
 
     for (i=0; i<nvec; i++) {
@@ -595,8 +693,11 @@ int N_VScaleAddMultiVectorArray(int nvec, int nsum, realtype* a, N_Vector* X,
         X[0]->ops->nvlinearsum(a[j], X[i], ONE, Y[j][i], Z[j][i]);
       }
     }
-    return(0);
+    ier = 0;
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 int N_VLinearCombinationVectorArray(int nvec, int nsum, realtype* c,
@@ -607,10 +708,11 @@ int N_VLinearCombinationVectorArray(int nvec, int nsum, realtype* c,
   realtype   ONE=RCONST(1.0);
   N_Vector* Y=NULL;
 
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+
   if (Z[0]->ops->nvlinearcombinationvectorarray != NULL) {
 
     ier = Z[0]->ops->nvlinearcombinationvectorarray(nvec, nsum, c, X, Z);
-    return(ier);
 
   } else if (Z[0]->ops->nvlinearcombination != NULL ) {
 
@@ -630,8 +732,6 @@ int N_VLinearCombinationVectorArray(int nvec, int nsum, realtype* c,
     /* free array of vectors */
     free(Y);
 
-    return(ier);
-
   } else {
 
     for (i=0; i<nvec; i++) {
@@ -640,8 +740,11 @@ int N_VLinearCombinationVectorArray(int nvec, int nsum, realtype* c,
         Z[0]->ops->nvlinearsum(c[j], X[j][i], ONE, Z[i], Z[i]);
       }
     }
-    return(0);
+    ier = 0;
   }
+
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(ier);
 }
 
 /* -----------------------------------------------------------------
@@ -650,47 +753,83 @@ int N_VLinearCombinationVectorArray(int nvec, int nsum, realtype* c,
 
 realtype N_VDotProdLocal(N_Vector x, N_Vector y)
 {
-  return((realtype) y->ops->nvdotprodlocal(x, y));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) y->ops->nvdotprodlocal(x, y);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VMaxNormLocal(N_Vector x)
 {
-  return((realtype) x->ops->nvmaxnormlocal(x));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvmaxnormlocal(x);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VMinLocal(N_Vector x)
 {
-  return((realtype) x->ops->nvminlocal(x));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvminlocal(x);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VL1NormLocal(N_Vector x)
 {
-  return((realtype) x->ops->nvl1normlocal(x));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvl1normlocal(x);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VWSqrSumLocal(N_Vector x, N_Vector w)
 {
-  return((realtype) x->ops->nvwsqrsumlocal(x,w));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvwsqrsumlocal(x,w);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VWSqrSumMaskLocal(N_Vector x, N_Vector w, N_Vector id)
 {
-  return((realtype) x->ops->nvwsqrsummasklocal(x,w,id));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) x->ops->nvwsqrsummasklocal(x,w,id);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 booleantype N_VInvTestLocal(N_Vector x, N_Vector z)
 {
-  return((booleantype) z->ops->nvinvtestlocal(x,z));
+  booleantype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (booleantype) z->ops->nvinvtestlocal(x,z);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 booleantype N_VConstrMaskLocal(N_Vector c, N_Vector x, N_Vector m)
 {
-  return((booleantype) x->ops->nvconstrmasklocal(c,x,m));
+  booleantype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (booleantype) x->ops->nvconstrmasklocal(c,x,m);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 realtype N_VMinQuotientLocal(N_Vector num, N_Vector denom)
 {
-  return((realtype) num->ops->nvminquotientlocal(num,denom));
+  realtype result;
+  SUNDIALS_MARK_FUNCTION_BEGIN(NV_PROFILER);
+  result = (realtype) num->ops->nvminquotientlocal(num,denom);
+  SUNDIALS_MARK_FUNCTION_END(NV_PROFILER);
+  return(result);
 }
 
 /* ------------------------------------
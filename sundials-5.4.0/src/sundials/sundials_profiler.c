@@ -0,0 +1,324 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the SUNDIALS profiler.
+ *
+ * The regions form a tree, a region opened while another one is
+ * open is recorded as a child of it. The children of a node are
+ * looked up by the address of the name first, since the regions
+ * are almost always marked with string literals, and by the name
+ * itself otherwise.
+ * ----------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sundials/sundials_profiler.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(SUNDIALS_HAVE_POSIX_TIMERS)
+#include <time.h>
+#include <unistd.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+#define SUN_THREAD_LOCAL __declspec(thread)
+#else
+#define SUN_THREAD_LOCAL __thread
+#endif
+
+typedef struct _SUNProfilerNode *SUNProfilerNode;
+
+struct _SUNProfilerNode {
+  const char *key;             /* address the region was marked with */
+  char *name;                  /* copy of the region name            */
+  long int count;              /* number of calls                    */
+  double total;                /* accumulated time [s]               */
+  double tstart;               /* start time of the open call        */
+  SUNProfilerNode parent;
+  SUNProfilerNode *children;
+  int nchildren;
+  int capacity;
+};
+
+struct _SUNProfiler {
+  char *title;
+  SUNProfilerNode root;
+  SUNProfilerNode current;     /* innermost open region              */
+  double tcreate;              /* time of creation or last reset     */
+};
+
+static SUN_THREAD_LOCAL SUNProfiler sunActiveProfiler = NULL;
+
+/* -----------------------------------------------------------------
+ * private functions
+ * ----------------------------------------------------------------- */
+
+static double sunProfilerWalltime(void)
+{
+#if defined(_WIN32)
+  LARGE_INTEGER count, freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return((double) count.QuadPart / (double) freq.QuadPart);
+#elif defined(SUNDIALS_HAVE_POSIX_TIMERS)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return((double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec);
+#else
+  return((double) clock() / (double) CLOCKS_PER_SEC);
+#endif
+}
+
+static SUNProfilerNode sunProfilerNodeNew(const char *name, SUNProfilerNode parent)
+{
+  SUNProfilerNode node;
+  size_t len;
+
+  node = (SUNProfilerNode) calloc(1, sizeof(struct _SUNProfilerNode));
+  if (node == NULL) return(NULL);
+
+  len = strlen(name);
+  node->name = (char *) malloc(len + 1);
+  if (node->name == NULL) { free(node); return(NULL); }
+  memcpy(node->name, name, len + 1);
+
+  node->key    = name;
+  node->parent = parent;
+
+  return(node);
+}
+
+static void sunProfilerNodeFree(SUNProfilerNode node)
+{
+  int i;
+
+  if (node == NULL) return;
+  for (i = 0; i < node->nchildren; i++)
+    sunProfilerNodeFree(node->children[i]);
+  free(node->children);
+  free(node->name);
+  free(node);
+}
+
+static void sunProfilerNodeReset(SUNProfilerNode node)
+{
+  int i;
+
+  node->count = 0;
+  node->total = 0.0;
+  for (i = 0; i < node->nchildren; i++)
+    sunProfilerNodeReset(node->children[i]);
+}
+
+static SUNProfilerNode sunProfilerChild(SUNProfilerNode node, const char *name)
+{
+  SUNProfilerNode child, *children;
+  int i, capacity;
+
+  for (i = 0; i < node->nchildren; i++)
+    if (node->children[i]->key == name) return(node->children[i]);
+
+  for (i = 0; i < node->nchildren; i++)
+    if (strcmp(node->children[i]->name, name) == 0) return(node->children[i]);
+
+  if (node->nchildren == node->capacity) {
+    capacity = (node->capacity == 0) ? 4 : 2 * node->capacity;
+    children = (SUNProfilerNode *) realloc(node->children,
+                                           capacity * sizeof(SUNProfilerNode));
+    if (children == NULL) return(NULL);
+    node->children = children;
+    node->capacity = capacity;
+  }
+
+  child = sunProfilerNodeNew(name, node);
+  if (child == NULL) return(NULL);
+  node->children[node->nchildren++] = child;
+
+  return(child);
+}
+
+static void sunProfilerNodeSum(SUNProfilerNode node, const char *name,
+                               double *time, long int *ncalls)
+{
+  int i;
+
+  if (strcmp(node->name, name) == 0) {
+    *time   += node->total;
+    *ncalls += node->count;
+  }
+  for (i = 0; i < node->nchildren; i++)
+    sunProfilerNodeSum(node->children[i], name, time, ncalls);
+}
+
+static void sunProfilerNodePrint(SUNProfilerNode node, double ptotal,
+                                 int depth, FILE *fp)
+{
+  double self;
+  int i;
+
+  self = node->total;
+  for (i = 0; i < node->nchildren; i++)
+    self -= node->children[i]->total;
+
+  fprintf(fp, "%*s%-*s %10ld %12.6f %12.6f %7.2f\n", 2*depth, "",
+          40 - 2*depth, node->name, node->count, node->total, self,
+          (ptotal > 0.0) ? 100.0 * node->total / ptotal : 0.0);
+
+  for (i = 0; i < node->nchildren; i++)
+    sunProfilerNodePrint(node->children[i], node->total, depth + 1, fp);
+}
+
+/* -----------------------------------------------------------------
+ * exported functions
+ * ----------------------------------------------------------------- */
+
+int SUNProfiler_Create(const char *title, SUNProfiler *p)
+{
+  SUNProfiler prof;
+  size_t len;
+
+  if (p == NULL) return(-1);
+  *p = NULL;
+
+  if (title == NULL) title = "SUNDIALS";
+
+  prof = (SUNProfiler) calloc(1, sizeof(struct _SUNProfiler));
+  if (prof == NULL) return(-1);
+
+  len = strlen(title);
+  prof->title = (char *) malloc(len + 1);
+  if (prof->title == NULL) { free(prof); return(-1); }
+  memcpy(prof->title, title, len + 1);
+
+  prof->root = sunProfilerNodeNew(title, NULL);
+  if (prof->root == NULL) { free(prof->title); free(prof); return(-1); }
+
+  prof->current = prof->root;
+  prof->tcreate = sunProfilerWalltime();
+
+  *p = prof;
+  return(0);
+}
+
+int SUNProfiler_Free(SUNProfiler *p)
+{
+  if (p == NULL || *p == NULL) return(0);
+
+  if (sunActiveProfiler == *p) sunActiveProfiler = NULL;
+
+  sunProfilerNodeFree((*p)->root);
+  free((*p)->title);
+  free(*p);
+  *p = NULL;
+
+  return(0);
+}
+
+int SUNProfiler_Begin(SUNProfiler p, const char *name)
+{
+  SUNProfilerNode node;
+
+  if (p == NULL || name == NULL) return(0);
+
+  node = sunProfilerChild(p->current, name);
+  if (node == NULL) return(-1);
+
+  node->tstart = sunProfilerWalltime();
+  p->current   = node;
+
+  return(0);
+}
+
+int SUNProfiler_End(SUNProfiler p, const char *name)
+{
+  SUNProfilerNode node;
+
+  if (p == NULL || name == NULL) return(0);
+
+  /* the region to close has to be the innermost open one */
+  node = p->current;
+  if (node == p->root) return(-1);
+  if (node->key != name && strcmp(node->name, name) != 0) return(-1);
+
+  node->total += sunProfilerWalltime() - node->tstart;
+  node->count++;
+  p->current = node->parent;
+
+  return(0);
+}
+
+int SUNProfiler_GetElapsedTime(SUNProfiler p, const char *name,
+                               double *time, long int *ncalls)
+{
+  double t  = 0.0;
+  long int n = 0;
+  int i;
+
+  if (p == NULL || name == NULL) return(-1);
+
+  for (i = 0; i < p->root->nchildren; i++)
+    sunProfilerNodeSum(p->root->children[i], name, &t, &n);
+
+  if (time)   *time   = t;
+  if (ncalls) *ncalls = n;
+
+  return(0);
+}
+
+int SUNProfiler_Reset(SUNProfiler p)
+{
+  if (p == NULL) return(0);
+
+  /* regions still open keep their start time */
+  sunProfilerNodeReset(p->root);
+  p->tcreate = sunProfilerWalltime();
+
+  return(0);
+}
+
+int SUNProfiler_Print(SUNProfiler p, FILE *fp)
+{
+  double elapsed;
+  int i;
+
+  if (p == NULL) return(0);
+  if (fp == NULL) fp = stdout;
+
+  elapsed = sunProfilerWalltime() - p->tcreate;
+
+  fprintf(fp, "\n================================================================================\n");
+  fprintf(fp, "SUNDIALS profile: %s, %.6f s elapsed\n", p->title, elapsed);
+  fprintf(fp, "================================================================================\n");
+  fprintf(fp, "%-40s %10s %12s %12s %7s\n", "region", "calls", "total [s]",
+          "self [s]", "%");
+  fprintf(fp, "--------------------------------------------------------------------------------\n");
+  for (i = 0; i < p->root->nchildren; i++)
+    sunProfilerNodePrint(p->root->children[i], elapsed, 0, fp);
+  fprintf(fp, "================================================================================\n");
+
+  return(0);
+}
+
+SUNProfiler SUNProfiler_SetActive(SUNProfiler p)
+{
+  SUNProfiler prev = sunActiveProfiler;
+  sunActiveProfiler = p;
+  return(prev);
+}
+
+SUNProfiler SUNProfiler_GetActive(void)
+{
+  return(sunActiveProfiler);
+}
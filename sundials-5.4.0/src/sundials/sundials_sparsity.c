@@ -0,0 +1,482 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the Jacobian sparsity
+ * detection utilities.
+ * -----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sundials/sundials_sparsity.h>
+#include <sundials/sundials_math.h>
+#include <sunmatrix/sunmatrix_sparse.h>
+
+#define ZERO RCONST(0.0)
+#define HALF RCONST(0.5)
+#define ONE  RCONST(1.0)
+
+/* relative size of the shift between probe points */
+#define PROBE_SHIFT RCONST(0.01)
+
+/* file format tag and version */
+#define SPARSITY_TAG "SUNDIALS_SPARSITY 1"
+
+/* private functions */
+static SUNMatrix sparsityMatrix(sunindextype N, sunindextype *colptrs,
+                                sunindextype *rowvals, int sparsetype);
+static int sparsityTranspose(sunindextype N, sunindextype *ptrs,
+                             sunindextype *vals, sunindextype **tptrs,
+                             sunindextype **tvals);
+static char *sparsityFileName(const char *dir, const char *key,
+                              const char *suffix);
+static realtype sparsityHash(sunindextype j, int k);
+
+
+/*
+ * -----------------------------------------------------------------
+ * Probing
+ * -----------------------------------------------------------------
+ */
+
+int SUNSparsityProbe(SUNSparsityFn fn, N_Vector y, void *user_data,
+                     int nprobes, int sparsetype, SUNMatrix *P)
+{
+  N_Vector *yk, *fk, ftemp;
+  realtype *yd, *ykd, *fkd, *ftd, yj, inc, srur;
+  sunindextype N, i, j, p, q, nnz, cap, row;
+  sunindextype *colptrs, *rowvals, *stamp, *tmp;
+  int k, retval;
+
+  if ((fn == NULL) || (y == NULL) || (P == NULL)) return(SUNSPARSITY_ILL_INPUT);
+  if (nprobes < 1) return(SUNSPARSITY_ILL_INPUT);
+  if ((sparsetype != CSC_MAT) && (sparsetype != CSR_MAT))
+    return(SUNSPARSITY_ILL_INPUT);
+  if (y->ops->nvgetarraypointer == NULL) return(SUNSPARSITY_ILL_INPUT);
+  *P = NULL;
+
+  N  = N_VGetLength(y);
+  yd = N_VGetArrayPointer(y);
+
+  /* probe points and the function values there */
+  yk = N_VCloneVectorArray(nprobes, y);
+  fk = N_VCloneVectorArray(nprobes, y);
+  ftemp = N_VClone(y);
+  cap = 4*N + 1;
+  colptrs = (sunindextype *) malloc((N+1)*sizeof(sunindextype));
+  rowvals = (sunindextype *) malloc(cap*sizeof(sunindextype));
+  stamp   = (sunindextype *) malloc(N*sizeof(sunindextype));
+  if ((yk == NULL) || (fk == NULL) || (ftemp == NULL) || (colptrs == NULL) ||
+      (rowvals == NULL) || (stamp == NULL)) {
+    retval = SUNSPARSITY_MEM_FAIL;
+    goto cleanup;
+  }
+
+  for (k=0; k<nprobes; k++) {
+    ykd = N_VGetArrayPointer(yk[k]);
+    for (j=0; j<N; j++)
+      ykd[j] = yd[j] + k * PROBE_SHIFT * SUNMAX(SUNRabs(yd[j]), ONE) *
+        sparsityHash(j, k);
+    if (fn(yk[k], fk[k], user_data) != 0) {
+      retval = SUNSPARSITY_FN_FAIL;
+      goto cleanup;
+    }
+  }
+
+  /* perturb one column at a time around each probe point and record
+     the rows whose value changes */
+  srur = SUNRsqrt(UNIT_ROUNDOFF);
+  ftd  = N_VGetArrayPointer(ftemp);
+  for (i=0; i<N; i++) stamp[i] = -1;
+  nnz = 0;
+  for (j=0; j<N; j++) {
+    colptrs[j] = nnz;
+    for (k=0; k<nprobes; k++) {
+      ykd = N_VGetArrayPointer(yk[k]);
+      fkd = N_VGetArrayPointer(fk[k]);
+
+      yj = ykd[j];
+      inc = srur * SUNMAX(SUNRabs(yj), ONE);
+      if (yj < ZERO) inc = -inc;
+      ykd[j] = yj + inc;
+      retval = fn(yk[k], ftemp, user_data);
+      ykd[j] = yj;
+      if (retval != 0) {
+        retval = SUNSPARSITY_FN_FAIL;
+        goto cleanup;
+      }
+
+      for (i=0; i<N; i++) {
+        if ((ftd[i] == fkd[i]) || (stamp[i] == j)) continue;
+        if (nnz == cap) {
+          cap *= 2;
+          tmp = (sunindextype *) realloc(rowvals, cap*sizeof(sunindextype));
+          if (tmp == NULL) {
+            retval = SUNSPARSITY_MEM_FAIL;
+            goto cleanup;
+          }
+          rowvals = tmp;
+        }
+        rowvals[nnz++] = i;
+        stamp[i] = j;
+      }
+    }
+
+    /* rows of later probes are appended, sort the column */
+    for (p=colptrs[j]+1; p<nnz; p++) {
+      row = rowvals[p];
+      for (q=p; (q>colptrs[j]) && (rowvals[q-1]>row); q--)
+        rowvals[q] = rowvals[q-1];
+      rowvals[q] = row;
+    }
+  }
+  colptrs[N] = nnz;
+
+  *P = sparsityMatrix(N, colptrs, rowvals, sparsetype);
+  retval = (*P == NULL) ? SUNSPARSITY_MEM_FAIL : SUNSPARSITY_SUCCESS;
+
+ cleanup:
+  if (yk) N_VDestroyVectorArray(yk, nprobes);
+  if (fk) N_VDestroyVectorArray(fk, nprobes);
+  if (ftemp) N_VDestroy(ftemp);
+  free(colptrs);
+  free(rowvals);
+  free(stamp);
+  return(retval);
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * Coloring
+ * -----------------------------------------------------------------
+ */
+
+int SUNSparsityColoring(SUNMatrix P, sunindextype *color,
+                        sunindextype *ncolors)
+{
+  sunindextype N, i, j, k, p, q, c, nc;
+  sunindextype *colptrs, *rowvals, *rowptrs, *colvals, *mark;
+  sunindextype *tptrs, *tvals;
+
+  if ((P == NULL) || (color == NULL) || (ncolors == NULL))
+    return(SUNSPARSITY_ILL_INPUT);
+  if ((SUNMatGetID(P) != SUNMATRIX_SPARSE) ||
+      (SUNSparseMatrix_Rows(P) != SUNSparseMatrix_Columns(P)))
+    return(SUNSPARSITY_ILL_INPUT);
+
+  /* the pattern is needed both by columns and by rows */
+  N = SUNSparseMatrix_Columns(P);
+  if (sparsityTranspose(N, SUNSparseMatrix_IndexPointers(P),
+                        SUNSparseMatrix_IndexValues(P),
+                        &tptrs, &tvals) != SUNSPARSITY_SUCCESS)
+    return(SUNSPARSITY_MEM_FAIL);
+  if (SUNSparseMatrix_SparseType(P) == CSC_MAT) {
+    colptrs = SUNSparseMatrix_IndexPointers(P);
+    rowvals = SUNSparseMatrix_IndexValues(P);
+    rowptrs = tptrs;
+    colvals = tvals;
+  } else {
+    rowptrs = SUNSparseMatrix_IndexPointers(P);
+    colvals = SUNSparseMatrix_IndexValues(P);
+    colptrs = tptrs;
+    rowvals = tvals;
+  }
+
+  /* mark[c] == j if color c is used by a column that shares a row
+     with column j */
+  mark = (sunindextype *) malloc(N*sizeof(sunindextype));
+  if (mark == NULL) {
+    free(tptrs); free(tvals);
+    return(SUNSPARSITY_MEM_FAIL);
+  }
+  for (c=0; c<N; c++) mark[c] = -1;
+
+  nc = 0;
+  for (j=0; j<N; j++) {
+    for (p=colptrs[j]; p<colptrs[j+1]; p++) {
+      i = rowvals[p];
+      for (q=rowptrs[i]; q<rowptrs[i+1]; q++) {
+        k = colvals[q];
+        if (k < j) mark[color[k]] = j;
+      }
+    }
+    for (c=0; mark[c] == j; c++) ;
+    color[j] = c;
+    nc = SUNMAX(nc, c+1);
+  }
+  *ncolors = nc;
+
+  free(mark);
+  free(tptrs);
+  free(tvals);
+  return(SUNSPARSITY_SUCCESS);
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * Cache
+ * -----------------------------------------------------------------
+ */
+
+int SUNSparsityWrite(const char *dir, const char *key, SUNMatrix P)
+{
+  FILE *fp;
+  char *fname, *tname;
+  sunindextype N, j, p, nnz;
+  sunindextype *colptrs, *rowvals, *tptrs, *tvals;
+  int ok;
+
+  if ((dir == NULL) || (key == NULL) || (P == NULL))
+    return(SUNSPARSITY_ILL_INPUT);
+  if ((SUNMatGetID(P) != SUNMATRIX_SPARSE) ||
+      (SUNSparseMatrix_Rows(P) != SUNSparseMatrix_Columns(P)))
+    return(SUNSPARSITY_ILL_INPUT);
+
+  /* the file holds the pattern by columns */
+  N = SUNSparseMatrix_Columns(P);
+  tptrs = tvals = NULL;
+  if (SUNSparseMatrix_SparseType(P) == CSC_MAT) {
+    colptrs = SUNSparseMatrix_IndexPointers(P);
+    rowvals = SUNSparseMatrix_IndexValues(P);
+  } else {
+    if (sparsityTranspose(N, SUNSparseMatrix_IndexPointers(P),
+                          SUNSparseMatrix_IndexValues(P),
+                          &tptrs, &tvals) != SUNSPARSITY_SUCCESS)
+      return(SUNSPARSITY_MEM_FAIL);
+    colptrs = tptrs;
+    rowvals = tvals;
+  }
+  nnz = colptrs[N];
+
+  fname = sparsityFileName(dir, key, ".sparsity");
+  tname = sparsityFileName(dir, key, ".sparsity.tmp");
+  if ((fname == NULL) || (tname == NULL)) {
+    free(fname); free(tname); free(tptrs); free(tvals);
+    return(SUNSPARSITY_MEM_FAIL);
+  }
+
+  fp = fopen(tname, "w");
+  ok = (fp != NULL);
+  if (ok) {
+    fprintf(fp, "%s\n%lu %s\n%lld %lld\n", SPARSITY_TAG,
+            (unsigned long) strlen(key), key, (long long) N, (long long) nnz);
+    for (j=0; j<=N; j++) fprintf(fp, "%lld\n", (long long) colptrs[j]);
+    for (p=0; p<nnz; p++) fprintf(fp, "%lld\n", (long long) rowvals[p]);
+    ok = !ferror(fp);
+    ok = (fclose(fp) == 0) && ok;
+    if (ok) ok = (rename(tname, fname) == 0);
+    if (!ok) remove(tname);
+  }
+
+  free(fname); free(tname); free(tptrs); free(tvals);
+  return(ok ? SUNSPARSITY_SUCCESS : SUNSPARSITY_FILE_FAIL);
+}
+
+int SUNSparsityRead(const char *dir, const char *key, sunindextype N,
+                    int sparsetype, SUNMatrix *P)
+{
+  FILE *fp;
+  char *fname, *fkey, tag[32];
+  unsigned long klen;
+  long long n, nnz, v;
+  sunindextype j, p, *colptrs, *rowvals;
+  int ok;
+
+  if ((dir == NULL) || (key == NULL) || (P == NULL) || (N <= 0))
+    return(SUNSPARSITY_ILL_INPUT);
+  if ((sparsetype != CSC_MAT) && (sparsetype != CSR_MAT))
+    return(SUNSPARSITY_ILL_INPUT);
+  *P = NULL;
+
+  fname = sparsityFileName(dir, key, ".sparsity");
+  if (fname == NULL) return(SUNSPARSITY_MEM_FAIL);
+  fp = fopen(fname, "r");
+  free(fname);
+  if (fp == NULL) return(SUNSPARSITY_NO_CACHE);
+
+  /* header: tag, key and size must match */
+  colptrs = rowvals = NULL;
+  fkey = NULL;
+  ok = (fgets(tag, sizeof(tag), fp) != NULL) &&
+    (strncmp(tag, SPARSITY_TAG, strlen(SPARSITY_TAG)) == 0) &&
+    (fscanf(fp, "%lu", &klen) == 1) && (klen == strlen(key)) &&
+    (fgetc(fp) == ' ');
+  if (ok) {
+    fkey = (char *) malloc(klen+1);
+    ok = (fkey != NULL) && (fread(fkey, 1, klen, fp) == klen);
+    if (ok) {
+      fkey[klen] = '\0';
+      ok = (strcmp(fkey, key) == 0);
+    }
+  }
+  ok = ok && (fscanf(fp, "%lld %lld", &n, &nnz) == 2) &&
+    (n == (long long) N) && (nnz >= 0) && (nnz <= n*n);
+
+  /* pattern by columns */
+  if (ok) {
+    colptrs = (sunindextype *) malloc((N+1)*sizeof(sunindextype));
+    rowvals = (sunindextype *) malloc((nnz > 0 ? nnz : 1)*sizeof(sunindextype));
+    ok = (colptrs != NULL) && (rowvals != NULL);
+  }
+  for (j=0; ok && (j<=N); j++) {
+    ok = (fscanf(fp, "%lld", &v) == 1) && (v >= 0) && (v <= nnz) &&
+      ((j == 0) ? (v == 0) : (v >= colptrs[j-1]));
+    if (ok) colptrs[j] = (sunindextype) v;
+  }
+  ok = ok && (colptrs[N] == nnz);
+  for (p=0; ok && (p<nnz); p++) {
+    ok = (fscanf(fp, "%lld", &v) == 1) && (v >= 0) && (v < n);
+    if (ok) rowvals[p] = (sunindextype) v;
+  }
+  fclose(fp);
+
+  if (ok) *P = sparsityMatrix(N, colptrs, rowvals, sparsetype);
+
+  free(fkey);
+  free(colptrs);
+  free(rowvals);
+  if (!ok) return(SUNSPARSITY_NO_CACHE);
+  return((*P == NULL) ? SUNSPARSITY_MEM_FAIL : SUNSPARSITY_SUCCESS);
+}
+
+int SUNSparsityProbeCached(const char *dir, const char *key,
+                           SUNSparsityFn fn, N_Vector y, void *user_data,
+                           int nprobes, int sparsetype, SUNMatrix *P)
+{
+  int retval;
+
+  if ((dir == NULL) || (key == NULL) || (y == NULL) || (P == NULL))
+    return(SUNSPARSITY_ILL_INPUT);
+
+  retval = SUNSparsityRead(dir, key, N_VGetLength(y), sparsetype, P);
+  if (retval != SUNSPARSITY_NO_CACHE) return(retval);
+
+  retval = SUNSparsityProbe(fn, y, user_data, nprobes, sparsetype, P);
+  if (retval != SUNSPARSITY_SUCCESS) return(retval);
+
+  (void) SUNSparsityWrite(dir, key, *P);
+  return(SUNSPARSITY_SUCCESS);
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * Private functions
+ * -----------------------------------------------------------------
+ */
+
+/* Creates a sparse matrix with unit entries on a CSC pattern */
+static SUNMatrix sparsityMatrix(sunindextype N, sunindextype *colptrs,
+                                sunindextype *rowvals, int sparsetype)
+{
+  SUNMatrix P;
+  sunindextype nnz, p, *tptrs, *tvals, *ptrs, *vals;
+  realtype *data;
+
+  nnz = colptrs[N];
+  P = SUNSparseMatrix(N, N, (nnz > 0) ? nnz : 1, sparsetype);
+  if (P == NULL) return(NULL);
+
+  ptrs = colptrs;
+  vals = rowvals;
+  tptrs = tvals = NULL;
+  if (sparsetype == CSR_MAT) {
+    if (sparsityTranspose(N, colptrs, rowvals, &tptrs, &tvals)
+        != SUNSPARSITY_SUCCESS) {
+      SUNMatDestroy(P);
+      return(NULL);
+    }
+    ptrs = tptrs;
+    vals = tvals;
+  }
+
+  memcpy(SUNSparseMatrix_IndexPointers(P), ptrs, (N+1)*sizeof(sunindextype));
+  memcpy(SUNSparseMatrix_IndexValues(P), vals, nnz*sizeof(sunindextype));
+  data = SUNSparseMatrix_Data(P);
+  for (p=0; p<nnz; p++) data[p] = ONE;
+
+  free(tptrs);
+  free(tvals);
+  return(P);
+}
+
+/* Transposes a compressed pattern; the indices of each transposed
+   vector come out sorted */
+static int sparsityTranspose(sunindextype N, sunindextype *ptrs,
+                             sunindextype *vals, sunindextype **tptrs,
+                             sunindextype **tvals)
+{
+  sunindextype j, p, q, nnz;
+
+  nnz = ptrs[N];
+  *tptrs = (sunindextype *) calloc(N+1, sizeof(sunindextype));
+  *tvals = (sunindextype *) malloc((nnz > 0 ? nnz : 1)*sizeof(sunindextype));
+  if ((*tptrs == NULL) || (*tvals == NULL)) {
+    free(*tptrs); free(*tvals);
+    *tptrs = *tvals = NULL;
+    return(SUNSPARSITY_MEM_FAIL);
+  }
+
+  for (p=0; p<nnz; p++) (*tptrs)[vals[p]+1]++;
+  for (j=0; j<N; j++) (*tptrs)[j+1] += (*tptrs)[j];
+  for (j=0; j<N; j++) {
+    for (p=ptrs[j]; p<ptrs[j+1]; p++) {
+      q = (*tptrs)[vals[p]]++;
+      (*tvals)[q] = j;
+    }
+  }
+  for (j=N; j>0; j--) (*tptrs)[j] = (*tptrs)[j-1];
+  (*tptrs)[0] = 0;
+
+  return(SUNSPARSITY_SUCCESS);
+}
+
+/* Builds dir/<sanitized key><suffix> */
+static char *sparsityFileName(const char *dir, const char *key,
+                              const char *suffix)
+{
+  char *name, *c;
+  size_t ld, lk;
+
+  ld = strlen(dir);
+  lk = strlen(key);
+  name = (char *) malloc(ld + lk + strlen(suffix) + 2);
+  if (name == NULL) return(NULL);
+
+  strcpy(name, dir);
+  if ((ld > 0) && (dir[ld-1] != '/')) strcat(name, "/");
+  c = name + strlen(name);
+  strcpy(c, key);
+  for (; *c != '\0'; c++) {
+    if (!(((*c >= 'a') && (*c <= 'z')) || ((*c >= 'A') && (*c <= 'Z')) ||
+          ((*c >= '0') && (*c <= '9')) || (*c == '-') || (*c == '_') ||
+          (*c == '.')))
+      *c = '_';
+  }
+  strcat(name, suffix);
+
+  return(name);
+}
+
+/* Deterministic factor in [0.5, 1) for component j of probe k */
+static realtype sparsityHash(sunindextype j, int k)
+{
+  unsigned long h;
+
+  h = (unsigned long) j * 2654435761UL + (unsigned long) k * 40503UL;
+  h ^= h >> 13;
+  h *= 0x5bd1e995UL;
+  h ^= h >> 15;
+  return(HALF + HALF * (realtype) (h % 1024UL) / RCONST(1024.0));
+}
@@ -34,6 +34,7 @@
 #define BAND_CONTENT(S)   ( (SUNLinearSolverContent_Band)(S->content) )
 #define PIVOTS(S)         ( BAND_CONTENT(S)->pivots )
 #define LASTFLAG(S)       ( BAND_CONTENT(S)->last_flag )
+#define BLOCKED(S)        ( BAND_CONTENT(S)->blocked )
 
 /*
  * -----------------------------------------------------------------
@@ -107,6 +108,7 @@ SUNLinearSolver SUNLinSol_Band(N_Vector y, SUNMatrix A)
   content->N         = MatrixRows;
   content->last_flag = 0;
   content->pivots    = NULL;
+  content->blocked   = SUNTRUE;
 
   /* Allocate content */
   content->pivots = (sunindextype *) malloc(MatrixRows * sizeof(sunindextype));
@@ -115,6 +117,18 @@ SUNLinearSolver SUNLinSol_Band(N_Vector y, SUNMatrix A)
   return(S);
 }
 
+/* ----------------------------------------------------------------------------
+ * Function to choose the blocked factorization bandGBTRFBlocked (default)
+ * or the unblocked bandGBTRF, both give the same factors and pivots
+ */
+
+int SUNLinSol_BandSetBlocked(SUNLinearSolver S, booleantype onoff)
+{
+  if (S == NULL) return(SUNLS_MEM_NULL);
+  BLOCKED(S) = onoff;
+  return(SUNLS_SUCCESS);
+}
+
 /*
  * -----------------------------------------------------------------
  * implementation of linear solver operations
@@ -170,8 +184,12 @@ int SUNLinSolSetup_Band(SUNLinearSolver S, SUNMatrix A)
   }
 
   /* perform LU factorization of input matrix */
-  LASTFLAG(S) = bandGBTRF(A_cols, SM_COLUMNS_B(A), SM_UBAND_B(A),
-                          SM_LBAND_B(A), SM_SUBAND_B(A), pivots);
+  if (BLOCKED(S))
+    LASTFLAG(S) = bandGBTRFBlocked(A_cols, SM_COLUMNS_B(A), SM_UBAND_B(A),
+                                   SM_LBAND_B(A), SM_SUBAND_B(A), pivots);
+  else
+    LASTFLAG(S) = bandGBTRF(A_cols, SM_COLUMNS_B(A), SM_UBAND_B(A),
+                            SM_LBAND_B(A), SM_SUBAND_B(A), pivots);
 
   /* store error flag (if nonzero, that row encountered zero-valued pivod) */
   if (LASTFLAG(S) > 0)
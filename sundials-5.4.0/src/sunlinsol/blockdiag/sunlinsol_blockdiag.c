@@ -0,0 +1,367 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the block-diagonal
+ * implementation of the SUNLINSOL package.
+ * -----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sunlinsol/sunlinsol_blockdiag.h>
+#include <sundials/sundials_math.h>
+
+#define ZERO RCONST(0.0)
+#define ONE  RCONST(1.0)
+
+#define W SUNBLOCKDIAG_BATCH
+
+/*
+ * -----------------------------------------------------------------
+ * BlockDiag solver structure accessibility macros:
+ * -----------------------------------------------------------------
+ */
+
+#define BD_CONTENT(S)  ( (SUNLinearSolverContent_BlockDiag)(S->content) )
+#define LU(S)          ( BD_CONTENT(S)->lu )
+#define PIVOTS(S)      ( BD_CONTENT(S)->pivots )
+#define WORK(S)        ( BD_CONTENT(S)->work )
+#define LASTFLAG(S)    ( BD_CONTENT(S)->last_flag )
+
+/*
+ * -----------------------------------------------------------------
+ * exported functions
+ * -----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------------------
+ * Function to create a new block-diagonal linear solver
+ */
+
+SUNLinearSolver SUNLinSol_BlockDiag(N_Vector y, SUNMatrix A)
+{
+  SUNLinearSolver S;
+  SUNLinearSolverContent_BlockDiag content;
+  sunindextype nblocks, bs, nbatches;
+
+  /* Check compatibility with supplied SUNMatrix and N_Vector */
+  if (SUNMatGetID(A) != SUNMATRIX_BLOCKDIAG) return(NULL);
+
+  if ( (N_VGetVectorID(y) != SUNDIALS_NVEC_SERIAL) &&
+       (N_VGetVectorID(y) != SUNDIALS_NVEC_OPENMP) &&
+       (N_VGetVectorID(y) != SUNDIALS_NVEC_PTHREADS) )
+    return(NULL);
+
+  if (SUNBlockDiagMatrix_Rows(A) != N_VGetLength(y)) return(NULL);
+
+  nblocks  = SUNBlockDiagMatrix_NumBlocks(A);
+  bs       = SUNBlockDiagMatrix_BlockSize(A);
+  nbatches = (nblocks + W - 1) / W;
+
+  /* Create an empty linear solver */
+  S = NULL;
+  S = SUNLinSolNewEmpty();
+  if (S == NULL) return(NULL);
+
+  /* Attach operations */
+  S->ops->gettype    = SUNLinSolGetType_BlockDiag;
+  S->ops->getid      = SUNLinSolGetID_BlockDiag;
+  S->ops->initialize = SUNLinSolInitialize_BlockDiag;
+  S->ops->setup      = SUNLinSolSetup_BlockDiag;
+  S->ops->solve      = SUNLinSolSolve_BlockDiag;
+  S->ops->lastflag   = SUNLinSolLastFlag_BlockDiag;
+  S->ops->space      = SUNLinSolSpace_BlockDiag;
+  S->ops->free       = SUNLinSolFree_BlockDiag;
+
+  /* Create content */
+  content = NULL;
+  content = (SUNLinearSolverContent_BlockDiag) malloc(sizeof *content);
+  if (content == NULL) { SUNLinSolFree(S); return(NULL); }
+
+  /* Attach content */
+  S->content = content;
+
+  /* Fill content */
+  content->nblocks   = nblocks;
+  content->bs        = bs;
+  content->nbatches  = nbatches;
+  content->last_flag = 0;
+  content->lu        = NULL;
+  content->pivots    = NULL;
+  content->work      = NULL;
+
+  /* Allocate content */
+  content->lu = (realtype *) malloc(nbatches * bs * bs * W * sizeof(realtype));
+  if (content->lu == NULL) { SUNLinSolFree(S); return(NULL); }
+
+  content->pivots = (sunindextype *) malloc(nbatches * bs * W * sizeof(sunindextype));
+  if (content->pivots == NULL) { SUNLinSolFree(S); return(NULL); }
+
+  content->work = (realtype *) malloc(bs * W * sizeof(realtype));
+  if (content->work == NULL) { SUNLinSolFree(S); return(NULL); }
+
+  return(S);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * implementation of linear solver operations
+ * -----------------------------------------------------------------
+ */
+
+SUNLinearSolver_Type SUNLinSolGetType_BlockDiag(SUNLinearSolver S)
+{
+  return(SUNLINEARSOLVER_DIRECT);
+}
+
+SUNLinearSolver_ID SUNLinSolGetID_BlockDiag(SUNLinearSolver S)
+{
+  return(SUNLINEARSOLVER_BLOCKDIAG);
+}
+
+int SUNLinSolInitialize_BlockDiag(SUNLinearSolver S)
+{
+  /* all solver-specific memory has already been allocated */
+  LASTFLAG(S) = SUNLS_SUCCESS;
+  return(SUNLS_SUCCESS);
+}
+
+/* ----------------------------------------------------------------------------
+ * Copy the blocks of A into the interleaved storage and factor them, one
+ * batch at a time. The last batch is padded with identity blocks. The
+ * pivot search and row interchanges are done per block, the elimination
+ * for all blocks of the batch at once and in the same order as denseGETRF.
+ */
+
+int SUNLinSolSetup_BlockDiag(SUNLinearSolver S, SUNMatrix A)
+{
+  sunindextype nblocks, bs, g, b, i, j, k, l, w;
+  sunindextype *piv;
+  realtype *Adata, *Ab, *lu, *col_k, *col_j, tmp;
+  realtype rinv[W], a_kj[W];
+
+  /* check for valid inputs */
+  if ( (A == NULL) || (S == NULL) )
+    return(SUNLS_MEM_NULL);
+
+  /* Ensure that A is a block-diagonal matrix of matching size */
+  if ( (SUNMatGetID(A) != SUNMATRIX_BLOCKDIAG) ||
+       (SUNBlockDiagMatrix_NumBlocks(A) != BD_CONTENT(S)->nblocks) ||
+       (SUNBlockDiagMatrix_BlockSize(A) != BD_CONTENT(S)->bs) ) {
+    LASTFLAG(S) = SUNLS_ILL_INPUT;
+    return(SUNLS_ILL_INPUT);
+  }
+
+  nblocks = BD_CONTENT(S)->nblocks;
+  bs      = BD_CONTENT(S)->bs;
+
+  Adata = SUNBlockDiagMatrix_Data(A);
+  if ( (Adata == NULL) || (LU(S) == NULL) || (PIVOTS(S) == NULL) ) {
+    LASTFLAG(S) = SUNLS_MEM_FAIL;
+    return(SUNLS_MEM_FAIL);
+  }
+
+  for (g = 0; g < BD_CONTENT(S)->nbatches; g++) {
+
+    lu  = LU(S) + g * bs * bs * W;
+    piv = PIVOTS(S) + g * bs * W;
+
+    /* interleave the blocks of this batch */
+    for (w = 0; w < W; w++) {
+      b = g * W + w;
+      if (b < nblocks) {
+        Ab = Adata + b * bs * bs;
+        for (j = 0; j < bs * bs; j++)
+          lu[j * W + w] = Ab[j];
+      } else {
+        for (j = 0; j < bs; j++)
+          for (i = 0; i < bs; i++)
+            lu[(j * bs + i) * W + w] = (i == j) ? ONE : ZERO;
+      }
+    }
+
+    for (k = 0; k < bs; k++) {
+
+      col_k = lu + k * bs * W;
+
+      /* find the pivot row of each block and swap rows */
+      for (w = 0; w < W; w++) {
+        l = k;
+        for (i = k+1; i < bs; i++)
+          if (SUNRabs(col_k[i * W + w]) > SUNRabs(col_k[l * W + w])) l = i;
+        piv[k * W + w] = l;
+
+        /* check for zero pivot element */
+        if (col_k[l * W + w] == ZERO) {
+          LASTFLAG(S) = (g * W + w) * bs + k + 1;
+          return(SUNLS_LUFACT_FAIL);
+        }
+
+        if (l != k) {
+          for (j = 0; j < bs; j++) {
+            tmp = lu[(j * bs + l) * W + w];
+            lu[(j * bs + l) * W + w] = lu[(j * bs + k) * W + w];
+            lu[(j * bs + k) * W + w] = tmp;
+          }
+        }
+      }
+
+      /* scale the elements below the diagonal in column k */
+      for (w = 0; w < W; w++)
+        rinv[w] = ONE / col_k[k * W + w];
+      for (i = k+1; i < bs; i++)
+        for (w = 0; w < W; w++)
+          col_k[i * W + w] *= rinv[w];
+
+      /* row_i -= [a(i,k)/a(k,k)] row_k, i=k+1, ..., bs-1 */
+      for (j = k+1; j < bs; j++) {
+        col_j = lu + j * bs * W;
+        for (w = 0; w < W; w++)
+          a_kj[w] = col_j[k * W + w];
+        for (i = k+1; i < bs; i++)
+          for (w = 0; w < W; w++)
+            col_j[i * W + w] -= a_kj[w] * col_k[i * W + w];
+      }
+    }
+  }
+
+  LASTFLAG(S) = SUNLS_SUCCESS;
+  return(SUNLS_SUCCESS);
+}
+
+int SUNLinSolSolve_BlockDiag(SUNLinearSolver S, SUNMatrix A, N_Vector x,
+                             N_Vector b, realtype tol)
+{
+  sunindextype nblocks, bs, g, blk, i, k, w;
+  sunindextype *piv;
+  realtype *xdata, *bdata, *lu, *col_k, *z, tmp;
+
+  if ( (A == NULL) || (S == NULL) || (x == NULL) || (b == NULL) )
+    return(SUNLS_MEM_NULL);
+
+  nblocks = BD_CONTENT(S)->nblocks;
+  bs      = BD_CONTENT(S)->bs;
+
+  /* access data pointers (return with failure on NULL) */
+  xdata = N_VGetArrayPointer(x);
+  bdata = N_VGetArrayPointer(b);
+  z     = WORK(S);
+  if ( (xdata == NULL) || (bdata == NULL) || (z == NULL) ) {
+    LASTFLAG(S) = SUNLS_MEM_FAIL;
+    return(SUNLS_MEM_FAIL);
+  }
+
+  /* z holds the right-hand sides of a batch interleaved like the factors,
+     b is read before x is written so x and b may be the same vector */
+  for (g = 0; g < BD_CONTENT(S)->nbatches; g++) {
+
+    lu  = LU(S) + g * bs * bs * W;
+    piv = PIVOTS(S) + g * bs * W;
+
+    /* gather b and permute it according to the pivots */
+    for (w = 0; w < W; w++) {
+      blk = g * W + w;
+      if (blk < nblocks) {
+        for (i = 0; i < bs; i++)
+          z[i * W + w] = bdata[blk * bs + i];
+      } else {
+        for (i = 0; i < bs; i++)
+          z[i * W + w] = ZERO;
+      }
+      for (k = 0; k < bs; k++) {
+        i = piv[k * W + w];
+        if (i != k) {
+          tmp = z[i * W + w];
+          z[i * W + w] = z[k * W + w];
+          z[k * W + w] = tmp;
+        }
+      }
+    }
+
+    /* Solve Ly = b, store solution y in z */
+    for (k = 0; k < bs-1; k++) {
+      col_k = lu + k * bs * W;
+      for (i = k+1; i < bs; i++)
+        for (w = 0; w < W; w++)
+          z[i * W + w] -= col_k[i * W + w] * z[k * W + w];
+    }
+
+    /* Solve Ux = y, store solution x in z */
+    for (k = bs-1; k >= 0; k--) {
+      col_k = lu + k * bs * W;
+      for (w = 0; w < W; w++)
+        z[k * W + w] /= col_k[k * W + w];
+      for (i = 0; i < k; i++)
+        for (w = 0; w < W; w++)
+          z[i * W + w] -= col_k[i * W + w] * z[k * W + w];
+    }
+
+    /* scatter the solution */
+    for (w = 0; w < W; w++) {
+      blk = g * W + w;
+      if (blk >= nblocks) break;
+      for (i = 0; i < bs; i++)
+        xdata[blk * bs + i] = z[i * W + w];
+    }
+  }
+
+  LASTFLAG(S) = SUNLS_SUCCESS;
+  return(SUNLS_SUCCESS);
+}
+
+sunindextype SUNLinSolLastFlag_BlockDiag(SUNLinearSolver S)
+{
+  /* return the stored 'last_flag' value */
+  if (S == NULL) return(-1);
+  return(LASTFLAG(S));
+}
+
+int SUNLinSolSpace_BlockDiag(SUNLinearSolver S,
+                             long int *lenrwLS,
+                             long int *leniwLS)
+{
+  sunindextype bs = BD_CONTENT(S)->bs;
+  sunindextype nbatches = BD_CONTENT(S)->nbatches;
+
+  *lenrwLS = nbatches * bs * bs * W + bs * W;
+  *leniwLS = 4 + nbatches * bs * W;
+  return(SUNLS_SUCCESS);
+}
+
+int SUNLinSolFree_BlockDiag(SUNLinearSolver S)
+{
+  /* return if S is already free */
+  if (S == NULL) return(SUNLS_SUCCESS);
+
+  /* delete items from contents, then delete generic structure */
+  if (S->content) {
+    if (LU(S)) {
+      free(LU(S));
+      LU(S) = NULL;
+    }
+    if (PIVOTS(S)) {
+      free(PIVOTS(S));
+      PIVOTS(S) = NULL;
+    }
+    if (WORK(S)) {
+      free(WORK(S));
+      WORK(S) = NULL;
+    }
+    free(S->content);
+    S->content = NULL;
+  }
+  if (S->ops) {
+    free(S->ops);
+    S->ops = NULL;
+  }
+  free(S); S = NULL;
+  return(SUNLS_SUCCESS);
+}
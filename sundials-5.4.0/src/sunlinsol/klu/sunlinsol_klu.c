@@ -37,6 +37,7 @@
 #define LASTFLAG(S)        ( KLU_CONTENT(S)->last_flag )
 #define FIRSTFACTORIZE(S)  ( KLU_CONTENT(S)->first_factorize )
 #define SYMBOLIC(S)        ( KLU_CONTENT(S)->symbolic )
+#define OWNSYMBOLIC(S)     ( KLU_CONTENT(S)->own_symbolic )
 #define NUMERIC(S)         ( KLU_CONTENT(S)->numeric )
 #define COMMON(S)          ( KLU_CONTENT(S)->common )
 #define SOLVE(S)           ( KLU_CONTENT(S)->klu_solver )
@@ -125,6 +126,7 @@ SUNLinearSolver SUNLinSol_KLU(N_Vector y, SUNMatrix A)
   content->last_flag       = 0;
   content->first_factorize = 1;
   content->symbolic        = NULL;
+  content->own_symbolic    = 1;
   content->numeric         = NULL;
 
 #if defined(SUNDIALS_INT64_T)
@@ -176,9 +178,12 @@ int SUNLinSol_KLUReInit(SUNLinearSolver S, SUNMatrix A,
     if (SUNSparseMatrix_Reallocate(A, nnz) != 0)
       return(SUNLS_MEM_FAIL);
 
-  /* Free the prior factorazation and reset for first factorization */
-  if( SYMBOLIC(S) != NULL)
+  /* Free the prior factorazation and reset for first factorization. A shared
+     symbolic factorization is not used any more, the structure may differ */
+  if( (SYMBOLIC(S) != NULL) && OWNSYMBOLIC(S) )
     sun_klu_free_symbolic(&SYMBOLIC(S), &COMMON(S));
+  SYMBOLIC(S) = NULL;
+  OWNSYMBOLIC(S) = 1;
   if( NUMERIC(S) != NULL)
     sun_klu_free_numeric(&NUMERIC(S), &COMMON(S));
   FIRSTFACTORIZE(S) = 1;
@@ -207,6 +212,36 @@ int SUNLinSol_KLUSetOrdering(SUNLinearSolver S, int ordering_choice)
   return(LASTFLAG(S));
 }
 
+/* ----------------------------------------------------------------------------
+ * Function to use a symbolic factorization computed elsewhere, e.g. by
+ * another KLU linear solver (SUNLinSol_KLUGetSymbolic after its first setup)
+ * or by sun_klu_analyze, instead of analyzing the matrix at the first setup.
+ * The symbolic object is only read, so it can be shared by any number of
+ * solvers for matrices with the same sparsity structure. It is not freed by
+ * S, the caller has to keep it alive as long as S uses it. Passing NULL
+ * restores the default of computing a symbolic factorization in S.
+ */
+
+int SUNLinSol_KLUSetSymbolic(SUNLinearSolver S, sun_klu_symbolic *symbolic)
+{
+  /* Check for non-NULL SUNLinearSolver */
+  if (S == NULL) return(SUNLS_MEM_NULL);
+
+  /* Free the own symbolic factorization and the numeric factorization based
+     on it, then force a numeric factorization at the next setup */
+  if (NUMERIC(S) != NULL)
+    sun_klu_free_numeric(&NUMERIC(S), &COMMON(S));
+  if ( (SYMBOLIC(S) != NULL) && OWNSYMBOLIC(S) )
+    sun_klu_free_symbolic(&SYMBOLIC(S), &COMMON(S));
+
+  SYMBOLIC(S)    = symbolic;
+  OWNSYMBOLIC(S) = (symbolic == NULL);
+  FIRSTFACTORIZE(S) = 1;
+
+  LASTFLAG(S) = SUNLS_SUCCESS;
+  return(LASTFLAG(S));
+}
+
 
 /*
  * -----------------------------------------------------------------
@@ -274,16 +309,30 @@ int SUNLinSolSetup_KLU(SUNLinearSolver S, SUNMatrix A)
   /* On first decomposition, get the symbolic factorization */
   if (FIRSTFACTORIZE(S)) {
 
-    /* Perform symbolic analysis of sparsity structure */
-    if (SYMBOLIC(S))
-      sun_klu_free_symbolic(&SYMBOLIC(S), &COMMON(S));
-    SYMBOLIC(S) = sun_klu_analyze(SUNSparseMatrix_NP(A),
-                                  (KLU_INDEXTYPE*) SUNSparseMatrix_IndexPointers(A),
-                                  (KLU_INDEXTYPE*) SUNSparseMatrix_IndexValues(A),
-                                  &COMMON(S));
-    if (SYMBOLIC(S) == NULL) {
-      LASTFLAG(S) = SUNLS_PACKAGE_FAIL_UNREC;
-      return(LASTFLAG(S));
+    if (OWNSYMBOLIC(S)) {
+
+      /* Perform symbolic analysis of sparsity structure */
+      if (SYMBOLIC(S))
+        sun_klu_free_symbolic(&SYMBOLIC(S), &COMMON(S));
+      SYMBOLIC(S) = sun_klu_analyze(SUNSparseMatrix_NP(A),
+                                    (KLU_INDEXTYPE*) SUNSparseMatrix_IndexPointers(A),
+                                    (KLU_INDEXTYPE*) SUNSparseMatrix_IndexValues(A),
+                                    &COMMON(S));
+      if (SYMBOLIC(S) == NULL) {
+        LASTFLAG(S) = SUNLS_PACKAGE_FAIL_UNREC;
+        return(LASTFLAG(S));
+      }
+
+    } else {
+
+      /* Shared symbolic analysis, check that it was done for a matrix
+         of the same size and number of nonzeros */
+      if ( (SYMBOLIC(S)->n != SUNSparseMatrix_NP(A)) ||
+           (SYMBOLIC(S)->nz != (SUNSparseMatrix_IndexPointers(A))[SUNSparseMatrix_NP(A)]) ) {
+        LASTFLAG(S) = SUNLS_ILL_INPUT;
+        return(LASTFLAG(S));
+      }
+
     }
 
     /* ------------------------------------------------------------
@@ -428,7 +477,7 @@ int SUNLinSolFree_KLU(SUNLinearSolver S)
   if (S->content) {
     if (NUMERIC(S))
       sun_klu_free_numeric(&NUMERIC(S), &COMMON(S));
-    if (SYMBOLIC(S))
+    if (SYMBOLIC(S) && OWNSYMBOLIC(S))
       sun_klu_free_symbolic(&SYMBOLIC(S), &COMMON(S));
     free(S->content);
     S->content = NULL;
@@ -0,0 +1,722 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the mixed precision iterative
+ * refinement implementation of the SUNLINSOL package.
+ *
+ * The sparse factorization is the left-looking LU of Gilbert and
+ * Peierls: column k of L and U is the solution of a triangular
+ * system with the first k columns of L, whose nonzero pattern is
+ * found by a depth-first search in the graph of L.
+ * -----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sunlinsol/sunlinsol_mixedir.h>
+#include <sundials/sundials_math.h>
+
+#define ZERO RCONST(0.0)
+#define HALF RCONST(0.5)
+#define ONE  RCONST(1.0)
+
+/* a correction below DXTOL*||x|| ends the refinement, one below
+   SUNRsqrt(UNIT_ROUNDOFF)*||x|| is still accepted when the
+   refinement stagnates */
+#define DXTOL (RCONST(4.0)*UNIT_ROUNDOFF)
+
+/* a row other than the diagonal one is only chosen as sparse pivot
+   if the diagonal entry is smaller than PIVTOL times its entry */
+#define PIVTOL ((sunlowrealtype) 0.001)
+
+#define LABS(x) ( ((x) < 0) ? -(x) : (x) )
+
+/*
+ * -----------------------------------------------------------------
+ * MixedIR solver structure accessibility macros:
+ * -----------------------------------------------------------------
+ */
+
+#define MIR_CONTENT(S)  ( (SUNLinearSolverContent_MixedIR)(S->content) )
+#define LASTFLAG(S)     ( MIR_CONTENT(S)->last_flag )
+
+/*
+ * -----------------------------------------------------------------
+ * private functions
+ * -----------------------------------------------------------------
+ */
+
+/* Ensure that an index/value array pair holds at least need entries */
+static int mixedirReserve(sunindextype **idx, sunlowrealtype **val,
+                          sunindextype *nzmax, sunindextype need)
+{
+  sunindextype *newidx;
+  sunlowrealtype *newval;
+  sunindextype nz;
+
+  if (need <= *nzmax) return(0);
+
+  nz = 2 * (*nzmax);
+  if (nz < need) nz = need;
+
+  newidx = (sunindextype *) realloc(*idx, nz * sizeof(sunindextype));
+  if (newidx == NULL) return(-1);
+  *idx = newidx;
+
+  newval = (sunlowrealtype *) realloc(*val, nz * sizeof(sunlowrealtype));
+  if (newval == NULL) return(-1);
+  *val = newval;
+
+  *nzmax = nz;
+  return(0);
+}
+
+/* Low precision LU factorization with partial pivoting of the N x N
+   column-major array a, same algorithm as denseGETRF */
+static sunindextype mixedirDenseGETRF(sunlowrealtype *a, sunindextype n,
+                                      sunindextype *p)
+{
+  sunindextype i, j, k, l;
+  sunlowrealtype *col_j, *col_k;
+  sunlowrealtype temp, mult, a_kj;
+
+  for (k = 0; k < n; k++) {
+
+    col_k = a + k*n;
+
+    /* find l = pivot row number */
+    l = k;
+    for (i = k+1; i < n; i++)
+      if (LABS(col_k[i]) > LABS(col_k[l])) l = i;
+    p[k] = l;
+
+    /* check for zero (or non-finite) pivot element */
+    if (col_k[l] == 0 || col_k[l] != col_k[l] ||
+        LABS(col_k[l]) * 0 != 0) return(k+1);
+
+    /* swap a(k,1:n) and a(l,1:n) if necessary */
+    if ( l != k ) {
+      for (i = 0; i < n; i++) {
+        temp = a[i*n + l];
+        a[i*n + l] = a[i*n + k];
+        a[i*n + k] = temp;
+      }
+    }
+
+    /* scale the elements below the diagonal in column k */
+    mult = 1 / col_k[k];
+    for (i = k+1; i < n; i++) col_k[i] *= mult;
+
+    /* row_i = row_i - [a(i,k)/a(k,k)] row_k, i=k+1, ..., n-1 */
+    for (j = k+1; j < n; j++) {
+      col_j = a + j*n;
+      a_kj = col_j[k];
+      if (a_kj != 0) {
+        for (i = k+1; i < n; i++)
+          col_j[i] -= a_kj * col_k[i];
+      }
+    }
+  }
+
+  return(0);
+}
+
+/* Solve with the factors of mixedirDenseGETRF, b is overwritten */
+static void mixedirDenseGETRS(sunlowrealtype *a, sunindextype n,
+                              sunindextype *p, sunlowrealtype *b)
+{
+  sunindextype i, k, pk;
+  sunlowrealtype *col_k, tmp;
+
+  /* permute b, based on pivot information in p */
+  for (k = 0; k < n; k++) {
+    pk = p[k];
+    if (pk != k) {
+      tmp = b[k];
+      b[k] = b[pk];
+      b[pk] = tmp;
+    }
+  }
+
+  /* solve Ly = b, store solution y in b */
+  for (k = 0; k < n-1; k++) {
+    col_k = a + k*n;
+    for (i = k+1; i < n; i++) b[i] -= col_k[i] * b[k];
+  }
+
+  /* solve Ux = y, store solution x in b */
+  for (k = n-1; k > 0; k--) {
+    col_k = a + k*n;
+    b[k] /= col_k[k];
+    for (i = 0; i < k; i++) b[i] -= col_k[i] * b[k];
+  }
+  b[0] /= a[0];
+}
+
+/* Low precision copy of a sparse matrix, transposed if it is CSR */
+static int mixedirSparseCopy(SUNLinearSolver S, SUNMatrix A)
+{
+  SUNLinearSolverContent_MixedIR c = MIR_CONTENT(S);
+  sunindextype n, nnz, i, j, p, q;
+  sunindextype *Aptr, *Aind, *cnt;
+  realtype *Adata;
+
+  n     = c->N;
+  Aptr  = SUNSparseMatrix_IndexPointers(A);
+  Aind  = SUNSparseMatrix_IndexValues(A);
+  Adata = SUNSparseMatrix_Data(A);
+  nnz   = Aptr[n];
+
+  if (mixedirReserve(&(c->Ai), &(c->Ax), &(c->Anzmax), nnz)) return(-1);
+
+  if (SUNSparseMatrix_SparseType(A) == CSC_MAT) {
+    for (j = 0; j <= n; j++) c->Ap[j] = Aptr[j];
+    for (p = 0; p < nnz; p++) {
+      c->Ai[p] = Aind[p];
+      c->Ax[p] = (sunlowrealtype) Adata[p];
+    }
+    return(0);
+  }
+
+  /* CSR: count the entries of each column, then scatter the rows */
+  cnt = c->xi;
+  for (j = 0; j < n; j++) cnt[j] = 0;
+  for (p = 0; p < nnz; p++) cnt[Aind[p]]++;
+  c->Ap[0] = 0;
+  for (j = 0; j < n; j++) {
+    c->Ap[j+1] = c->Ap[j] + cnt[j];
+    cnt[j] = c->Ap[j];
+  }
+  for (i = 0; i < n; i++) {
+    for (p = Aptr[i]; p < Aptr[i+1]; p++) {
+      q = cnt[Aind[p]]++;
+      c->Ai[q] = i;
+      c->Ax[q] = (sunlowrealtype) Adata[p];
+    }
+  }
+
+  return(0);
+}
+
+/* Depth-first search from row j in the graph of the first columns of
+   L, the rows reached are pushed onto xi[top-1], xi[top-2], ... in
+   topological order */
+static sunindextype mixedirDFS(sunindextype j, sunindextype top,
+                               sunindextype *Lp, sunindextype *Li,
+                               sunindextype *pinv, sunindextype *xi,
+                               sunindextype *pstack, sunindextype *mark)
+{
+  sunindextype head, jnew, p, p2, i;
+  booleantype done;
+
+  head = 0;
+  xi[0] = j;
+  while (head >= 0) {
+    j = xi[head];
+    jnew = pinv[j];
+    if (!mark[j]) {
+      mark[j] = 1;
+      pstack[head] = (jnew < 0) ? 0 : Lp[jnew];
+    }
+    done = SUNTRUE;
+    p2 = (jnew < 0) ? 0 : Lp[jnew+1];
+    for (p = pstack[head]; p < p2; p++) {
+      i = Li[p];
+      if (mark[i]) continue;
+      pstack[head] = p;
+      xi[++head] = i;
+      done = SUNFALSE;
+      break;
+    }
+    if (done) {
+      head--;
+      xi[--top] = j;
+    }
+  }
+  return(top);
+}
+
+/* Left-looking LU factorization with threshold partial pivoting of
+   the low precision copy of A */
+static sunindextype mixedirSparseGETRF(SUNLinearSolver S)
+{
+  SUNLinearSolverContent_MixedIR c = MIR_CONTENT(S);
+  sunindextype n, i, j, k, p, top, ipiv, lnz, unz, J;
+  sunindextype *xi, *pstack, *mark, *pinv;
+  sunlowrealtype *x, a, t, pivot;
+
+  n      = c->N;
+  x      = c->work;
+  pinv   = c->pivots;
+  xi     = c->xi;
+  pstack = xi + n;
+  mark   = xi + 2*n;
+
+  for (i = 0; i < n; i++) {
+    x[i]    = 0;
+    pinv[i] = -1;
+    mark[i] = 0;
+  }
+  lnz = unz = 0;
+
+  for (k = 0; k < n; k++) {
+
+    c->Lp[k] = lnz;
+    c->Up[k] = unz;
+
+    /* room for a full column of L and U */
+    if (mixedirReserve(&(c->Li), &(c->Lx), &(c->Lnzmax), lnz + n - k) ||
+        mixedirReserve(&(c->Ui), &(c->Ux), &(c->Unzmax), unz + k + 1))
+      return(-1);
+
+    /* nonzero pattern of x = L \ A(:,k) */
+    top = n;
+    for (p = c->Ap[k]; p < c->Ap[k+1]; p++)
+      if (!mark[c->Ai[p]])
+        top = mixedirDFS(c->Ai[p], top, c->Lp, c->Li, pinv, xi, pstack, mark);
+    for (p = top; p < n; p++) mark[xi[p]] = 0;
+
+    /* numerical values of x */
+    for (p = c->Ap[k]; p < c->Ap[k+1]; p++) x[c->Ai[p]] = c->Ax[p];
+    for (p = top; p < n; p++) {
+      j = xi[p];
+      J = pinv[j];
+      if (J < 0) continue;
+      for (i = c->Lp[J] + 1; i < c->Lp[J+1]; i++)
+        x[c->Li[i]] -= c->Lx[i] * x[j];
+    }
+
+    /* largest entry in a row that is not pivotal yet, the rows that
+       are go to U */
+    ipiv = -1;
+    a = -1;
+    for (p = top; p < n; p++) {
+      i = xi[p];
+      if (pinv[i] < 0) {
+        t = LABS(x[i]);
+        if (t > a) { a = t; ipiv = i; }
+      } else {
+        c->Ui[unz]   = pinv[i];
+        c->Ux[unz++] = x[i];
+      }
+    }
+    if (ipiv < 0 || a <= 0 || a * 0 != 0) return(k+1);
+
+    /* prefer the diagonal entry */
+    if (pinv[k] < 0 && LABS(x[k]) >= a * PIVTOL) ipiv = k;
+
+    /* diagonal of U and L */
+    pivot = x[ipiv];
+    c->Ui[unz]   = k;
+    c->Ux[unz++] = pivot;
+    pinv[ipiv]   = k;
+    c->Li[lnz]   = ipiv;
+    c->Lx[lnz++] = 1;
+
+    /* scaled column of L, clear x */
+    for (p = top; p < n; p++) {
+      i = xi[p];
+      if (pinv[i] < 0) {
+        c->Li[lnz]   = i;
+        c->Lx[lnz++] = x[i] / pivot;
+      }
+      x[i] = 0;
+    }
+  }
+
+  c->Lp[n] = lnz;
+  c->Up[n] = unz;
+
+  /* number the rows of L in pivot order */
+  for (p = 0; p < lnz; p++) c->Li[p] = pinv[c->Li[p]];
+
+  return(0);
+}
+
+/* Solve with the factors of mixedirSparseGETRF, y holds the permuted
+   right-hand side P b on input and the solution on output */
+static void mixedirSparseGETRS(SUNLinearSolver S, sunlowrealtype *y)
+{
+  SUNLinearSolverContent_MixedIR c = MIR_CONTENT(S);
+  sunindextype n, j, p;
+  sunlowrealtype yj;
+
+  n = c->N;
+
+  /* solve L y = P b */
+  for (j = 0; j < n; j++) {
+    yj = y[j];
+    for (p = c->Lp[j] + 1; p < c->Lp[j+1]; p++)
+      y[c->Li[p]] -= c->Lx[p] * yj;
+  }
+
+  /* solve U x = y */
+  for (j = n-1; j >= 0; j--) {
+    y[j] /= c->Ux[c->Up[j+1] - 1];
+    yj = y[j];
+    for (p = c->Up[j]; p < c->Up[j+1] - 1; p++)
+      y[c->Ui[p]] -= c->Ux[p] * yj;
+  }
+}
+
+/* Low precision solve of A dx = r, scaled by ||r|| to stay in the
+   range of the low precision */
+static void mixedirLowSolve(SUNLinearSolver S, realtype *r, realtype rnorm)
+{
+  SUNLinearSolverContent_MixedIR c = MIR_CONTENT(S);
+  sunindextype i, n;
+  realtype scale;
+
+  n = c->N;
+  scale = ONE / rnorm;
+
+  if (c->mat_id == SUNMATRIX_DENSE) {
+    for (i = 0; i < n; i++) c->work[i] = (sunlowrealtype) (r[i] * scale);
+    mixedirDenseGETRS(c->lu, n, c->pivots, c->work);
+  } else {
+    /* the sparse pivoting permutes the right-hand side up front */
+    for (i = 0; i < n; i++)
+      c->work[c->pivots[i]] = (sunlowrealtype) (r[i] * scale);
+    mixedirSparseGETRS(S, c->work);
+  }
+
+  for (i = 0; i < n; i++) r[i] = rnorm * ((realtype) c->work[i]);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * exported functions
+ * -----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------------------
+ * Function to create a new mixed precision linear solver
+ */
+
+SUNLinearSolver SUNLinSol_MixedIR(N_Vector y, SUNMatrix A)
+{
+  SUNLinearSolver S;
+  SUNLinearSolverContent_MixedIR content;
+  sunindextype N;
+
+  /* Check compatibility with supplied SUNMatrix and N_Vector */
+  if (SUNMatGetID(A) == SUNMATRIX_DENSE) {
+    if (SUNDenseMatrix_Rows(A) != SUNDenseMatrix_Columns(A)) return(NULL);
+    N = SUNDenseMatrix_Rows(A);
+  } else if (SUNMatGetID(A) == SUNMATRIX_SPARSE) {
+    if (SUNSparseMatrix_Rows(A) != SUNSparseMatrix_Columns(A)) return(NULL);
+    N = SUNSparseMatrix_Rows(A);
+  } else {
+    return(NULL);
+  }
+
+  if ( (N_VGetVectorID(y) != SUNDIALS_NVEC_SERIAL) &&
+       (N_VGetVectorID(y) != SUNDIALS_NVEC_OPENMP) &&
+       (N_VGetVectorID(y) != SUNDIALS_NVEC_PTHREADS) )
+    return(NULL);
+
+  if (N != N_VGetLength(y)) return(NULL);
+
+  /* Create an empty linear solver */
+  S = NULL;
+  S = SUNLinSolNewEmpty();
+  if (S == NULL) return(NULL);
+
+  /* Attach operations */
+  S->ops->gettype    = SUNLinSolGetType_MixedIR;
+  S->ops->getid      = SUNLinSolGetID_MixedIR;
+  S->ops->initialize = SUNLinSolInitialize_MixedIR;
+  S->ops->setup      = SUNLinSolSetup_MixedIR;
+  S->ops->solve      = SUNLinSolSolve_MixedIR;
+  S->ops->numiters   = SUNLinSolNumIters_MixedIR;
+  S->ops->resnorm    = SUNLinSolResNorm_MixedIR;
+  S->ops->lastflag   = SUNLinSolLastFlag_MixedIR;
+  S->ops->space      = SUNLinSolSpace_MixedIR;
+  S->ops->free       = SUNLinSolFree_MixedIR;
+
+  /* Create content */
+  content = NULL;
+  content = (SUNLinearSolverContent_MixedIR) calloc(1, sizeof *content);
+  if (content == NULL) { SUNLinSolFree(S); return(NULL); }
+
+  /* Attach content */
+  S->content = content;
+
+  /* Fill content */
+  content->N         = N;
+  content->mat_id    = SUNMatGetID(A);
+  content->maxiters  = SUNMIXEDIR_MAXITERS_DEFAULT;
+  content->numiters  = 0;
+  content->resnorm   = ZERO;
+  content->last_flag = 0;
+
+  /* Allocate content */
+  content->r = N_VClone(y);
+  if (content->r == NULL) { SUNLinSolFree(S); return(NULL); }
+
+  content->work   = (sunlowrealtype *) malloc(N * sizeof(sunlowrealtype));
+  content->pivots = (sunindextype *) malloc(N * sizeof(sunindextype));
+  if ( (content->work == NULL) || (content->pivots == NULL) )
+    { SUNLinSolFree(S); return(NULL); }
+
+  if (content->mat_id == SUNMATRIX_DENSE) {
+    content->lu = (sunlowrealtype *) malloc(N * N * sizeof(sunlowrealtype));
+    if (content->lu == NULL) { SUNLinSolFree(S); return(NULL); }
+  } else {
+    content->Ap = (sunindextype *) malloc((N+1) * sizeof(sunindextype));
+    content->Lp = (sunindextype *) malloc((N+1) * sizeof(sunindextype));
+    content->Up = (sunindextype *) malloc((N+1) * sizeof(sunindextype));
+    content->xi = (sunindextype *) malloc(3 * N * sizeof(sunindextype));
+    if ( (content->Ap == NULL) || (content->Lp == NULL) ||
+         (content->Up == NULL) || (content->xi == NULL) )
+      { SUNLinSolFree(S); return(NULL); }
+  }
+
+  return(S);
+}
+
+/* ----------------------------------------------------------------------------
+ * Function to set the maximum number of refinement steps
+ */
+
+int SUNLinSol_MixedIRSetMaxIters(SUNLinearSolver S, int maxiters)
+{
+  /* Check for non-NULL SUNLinearSolver */
+  if (S == NULL) return(SUNLS_MEM_NULL);
+
+  /* Check for legal number of iters */
+  if (maxiters <= 0)
+    maxiters = SUNMIXEDIR_MAXITERS_DEFAULT;
+
+  /* Set max iters */
+  MIR_CONTENT(S)->maxiters = maxiters;
+  return(SUNLS_SUCCESS);
+}
+
+/*
+ * -----------------------------------------------------------------
+ * implementation of linear solver operations
+ * -----------------------------------------------------------------
+ */
+
+SUNLinearSolver_Type SUNLinSolGetType_MixedIR(SUNLinearSolver S)
+{
+  return(SUNLINEARSOLVER_DIRECT);
+}
+
+SUNLinearSolver_ID SUNLinSolGetID_MixedIR(SUNLinearSolver S)
+{
+  return(SUNLINEARSOLVER_MIXEDIR);
+}
+
+int SUNLinSolInitialize_MixedIR(SUNLinearSolver S)
+{
+  /* all solver-specific memory has already been allocated */
+  LASTFLAG(S) = SUNLS_SUCCESS;
+  return(SUNLS_SUCCESS);
+}
+
+int SUNLinSolSetup_MixedIR(SUNLinearSolver S, SUNMatrix A)
+{
+  SUNLinearSolverContent_MixedIR c;
+  realtype *Adata;
+  sunindextype i, n;
+
+  /* check for valid inputs */
+  if ( (A == NULL) || (S == NULL) )
+    return(SUNLS_MEM_NULL);
+  c = MIR_CONTENT(S);
+  n = c->N;
+
+  /* Ensure that A has the type the solver was created for */
+  if (SUNMatGetID(A) != c->mat_id) {
+    LASTFLAG(S) = SUNLS_ILL_INPUT;
+    return(SUNLS_ILL_INPUT);
+  }
+
+  if (c->mat_id == SUNMATRIX_DENSE) {
+
+    /* low precision copy of A, factored in place */
+    Adata = SUNDenseMatrix_Data(A);
+    if (Adata == NULL) {
+      LASTFLAG(S) = SUNLS_MEM_FAIL;
+      return(SUNLS_MEM_FAIL);
+    }
+    for (i = 0; i < n*n; i++) c->lu[i] = (sunlowrealtype) Adata[i];
+
+    LASTFLAG(S) = mixedirDenseGETRF(c->lu, n, c->pivots);
+
+  } else {
+
+    if (mixedirSparseCopy(S, A)) {
+      LASTFLAG(S) = SUNLS_MEM_FAIL;
+      return(SUNLS_MEM_FAIL);
+    }
+
+    LASTFLAG(S) = mixedirSparseGETRF(S);
+    if (LASTFLAG(S) < 0) {
+      LASTFLAG(S) = SUNLS_MEM_FAIL;
+      return(SUNLS_MEM_FAIL);
+    }
+  }
+
+  /* store error flag (if nonzero, this column has no usable pivot) */
+  if (LASTFLAG(S) > 0)
+    return(SUNLS_LUFACT_FAIL);
+  return(SUNLS_SUCCESS);
+}
+
+int SUNLinSolSolve_MixedIR(SUNLinearSolver S, SUNMatrix A, N_Vector x,
+                           N_Vector b, realtype tol)
+{
+  SUNLinearSolverContent_MixedIR c;
+  realtype *rdata, *xdata;
+  realtype bnorm, rnorm, xnorm, dxnorm, dxprev;
+  int it;
+
+  if ( (A == NULL) || (S == NULL) || (x == NULL) || (b == NULL) )
+    return(SUNLS_MEM_NULL);
+  c = MIR_CONTENT(S);
+
+  c->numiters = 0;
+  c->resnorm  = ZERO;
+
+  /* access data pointers (return with failure on NULL) */
+  rdata = N_VGetArrayPointer(c->r);
+  xdata = N_VGetArrayPointer(x);
+  if ( (rdata == NULL) || (xdata == NULL) ) {
+    LASTFLAG(S) = SUNLS_MEM_FAIL;
+    return(SUNLS_MEM_FAIL);
+  }
+
+  /* first solution with the low precision factors */
+  bnorm = N_VMaxNorm(b);
+  if (bnorm == ZERO) {
+    N_VConst(ZERO, x);
+    LASTFLAG(S) = SUNLS_SUCCESS;
+    return(SUNLS_SUCCESS);
+  }
+  N_VScale(ONE, b, x);
+  mixedirLowSolve(S, xdata, bnorm);
+
+  /* refine: x = x + A^{-1} (b - A x) */
+  dxprev = N_VMaxNorm(x);
+  for (it = 1; it <= c->maxiters; it++) {
+
+    if (SUNMatMatvec(A, x, c->r)) {
+      LASTFLAG(S) = SUNLS_ATIMES_FAIL_UNREC;
+      return(SUNLS_ATIMES_FAIL_UNREC);
+    }
+    N_VLinearSum(ONE, b, -ONE, c->r, c->r);
+
+    rnorm = N_VMaxNorm(c->r);
+    if (rnorm == ZERO) break;
+
+    mixedirLowSolve(S, rdata, rnorm);
+    N_VLinearSum(ONE, x, ONE, c->r, x);
+    c->numiters = it;
+
+    dxnorm = N_VMaxNorm(c->r);
+    xnorm  = N_VMaxNorm(x);
+    c->resnorm = (xnorm > ZERO) ? dxnorm / xnorm : dxnorm;
+
+    /* converged, or no further progress */
+    if (c->resnorm <= DXTOL) break;
+    if (dxnorm > HALF * dxprev) break;
+    dxprev = dxnorm;
+  }
+
+  if (c->resnorm > SUNRsqrt(UNIT_ROUNDOFF)) {
+    LASTFLAG(S) = SUNLS_CONV_FAIL;
+    return(SUNLS_CONV_FAIL);
+  }
+
+  LASTFLAG(S) = SUNLS_SUCCESS;
+  return(SUNLS_SUCCESS);
+}
+
+int SUNLinSolNumIters_MixedIR(SUNLinearSolver S)
+{
+  /* return the stored 'numiters' value */
+  if (S == NULL) return(-1);
+  return(MIR_CONTENT(S)->numiters);
+}
+
+realtype SUNLinSolResNorm_MixedIR(SUNLinearSolver S)
+{
+  /* return the stored 'resnorm' value */
+  if (S == NULL) return(-ONE);
+  return(MIR_CONTENT(S)->resnorm);
+}
+
+sunindextype SUNLinSolLastFlag_MixedIR(SUNLinearSolver S)
+{
+  /* return the stored 'last_flag' value */
+  if (S == NULL) return(-1);
+  return(LASTFLAG(S));
+}
+
+int SUNLinSolSpace_MixedIR(SUNLinearSolver S,
+                           long int *lenrwLS,
+                           long int *leniwLS)
+{
+  SUNLinearSolverContent_MixedIR c = MIR_CONTENT(S);
+  sunindextype liw1, lrw1;
+  long int nlow;
+
+  /* the low precision entries are counted as parts of realtype ones */
+  if (c->mat_id == SUNMATRIX_DENSE) {
+    nlow     = c->N + c->N * c->N;
+    *leniwLS = 6 + c->N;
+  } else {
+    nlow     = c->N + c->Anzmax + c->Lnzmax + c->Unzmax;
+    *leniwLS = 10 + 7 * c->N + c->Anzmax + c->Lnzmax + c->Unzmax;
+  }
+  *lenrwLS = 1 + (long int) ((nlow * sizeof(sunlowrealtype) + sizeof(realtype) - 1)
+                             / sizeof(realtype));
+
+  if (c->r->ops->nvspace) {
+    N_VSpace(c->r, &lrw1, &liw1);
+    *lenrwLS += lrw1;
+    *leniwLS += liw1;
+  }
+  return(SUNLS_SUCCESS);
+}
+
+int SUNLinSolFree_MixedIR(SUNLinearSolver S)
+{
+  SUNLinearSolverContent_MixedIR c;
+
+  /* return if S is already free */
+  if (S == NULL) return(SUNLS_SUCCESS);
+
+  /* delete items from contents, then delete generic structure */
+  if (S->content) {
+    c = MIR_CONTENT(S);
+    if (c->r) N_VDestroy(c->r);
+    free(c->work);
+    free(c->pivots);
+    free(c->lu);
+    free(c->Ap); free(c->Ai); free(c->Ax);
+    free(c->Lp); free(c->Li); free(c->Lx);
+    free(c->Up); free(c->Ui); free(c->Ux);
+    free(c->xi);
+    free(S->content);
+    S->content = NULL;
+  }
+  if (S->ops) {
+    free(S->ops);
+    S->ops = NULL;
+  }
+  free(S); S = NULL;
+  return(SUNLS_SUCCESS);
+}
@@ -181,7 +181,8 @@ SUNDIALS_EXPORT int SUNLinSol_SPFGMRSetPrecType(SUNLinearSolver S, int pretype)
 SUNDIALS_EXPORT int SUNLinSol_SPFGMRSetGSType(SUNLinearSolver S, int gstype)
 {
   /* Check for legal gstype */
-  if ((gstype != MODIFIED_GS) && (gstype != CLASSICAL_GS)) {
+  if ((gstype != MODIFIED_GS) && (gstype != CLASSICAL_GS) &&
+      (gstype != CLASSICAL_GS2) && (gstype != LOWSYNC_GS)) {
     return(SUNLS_ILL_INPUT);
   }
 
@@ -576,6 +577,16 @@ int SUNLinSolSolve_SPFGMR(SUNLinearSolver S, SUNMatrix A, N_Vector x,
           LASTFLAG(S) = SUNLS_GS_FAIL;
           return(LASTFLAG(S));
         }
+      } else if (gstype == CLASSICAL_GS2) {
+        if (ClassicalGS2(V, Hes, l+1, l_max, &(Hes[l+1][l]), cv, Xv) != 0) {
+          LASTFLAG(S) = SUNLS_GS_FAIL;
+          return(LASTFLAG(S));
+        }
+      } else if (gstype == LOWSYNC_GS) {
+        if (LowSyncGS(V, Hes, l+1, l_max, &(Hes[l+1][l]), cv, Xv) != 0) {
+          LASTFLAG(S) = SUNLS_GS_FAIL;
+          return(LASTFLAG(S));
+        }
       } else {
         if (ModifiedGS(V, Hes, l+1, l_max, &(Hes[l+1][l])) != 0) {
           LASTFLAG(S) = SUNLS_GS_FAIL;
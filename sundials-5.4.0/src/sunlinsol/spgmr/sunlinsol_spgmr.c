@@ -177,7 +177,8 @@ SUNDIALS_EXPORT int SUNLinSol_SPGMRSetPrecType(SUNLinearSolver S, int pretype)
 SUNDIALS_EXPORT int SUNLinSol_SPGMRSetGSType(SUNLinearSolver S, int gstype)
 {
   /* Check for legal gstype */
-  if ((gstype != MODIFIED_GS) && (gstype != CLASSICAL_GS)) {
+  if ((gstype != MODIFIED_GS) && (gstype != CLASSICAL_GS) &&
+      (gstype != CLASSICAL_GS2) && (gstype != LOWSYNC_GS)) {
     return(SUNLS_ILL_INPUT);
   }
 
@@ -592,6 +593,18 @@ int SUNLinSolSolve_SPGMR(SUNLinearSolver S, SUNMatrix A, N_Vector x,
           LASTFLAG(S) = SUNLS_GS_FAIL;
           return(LASTFLAG(S));
         }
+      } else if (gstype == CLASSICAL_GS2) {
+        if (ClassicalGS2(V, Hes, l_plus_1, l_max, &(Hes[l_plus_1][l]),
+                         cv, Xv) != 0) {
+          LASTFLAG(S) = SUNLS_GS_FAIL;
+          return(LASTFLAG(S));
+        }
+      } else if (gstype == LOWSYNC_GS) {
+        if (LowSyncGS(V, Hes, l_plus_1, l_max, &(Hes[l_plus_1][l]),
+                      cv, Xv) != 0) {
+          LASTFLAG(S) = SUNLS_GS_FAIL;
+          return(LASTFLAG(S));
+        }
       } else {
         if (ModifiedGS(V, Hes, l_plus_1, l_max, &(Hes[l_plus_1][l])) != 0) {
           LASTFLAG(S) = SUNLS_GS_FAIL;
@@ -0,0 +1,364 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * This is the implementation file for the block-diagonal
+ * implementation of the SUNMATRIX package.
+ * -----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sunmatrix/sunmatrix_blockdiag.h>
+#include <sundials/sundials_math.h>
+
+#define ZERO RCONST(0.0)
+#define ONE  RCONST(1.0)
+
+
+/* Private function prototypes */
+static booleantype SMCompatible_BlockDiag(SUNMatrix A, SUNMatrix B);
+static booleantype SMCompatible2_BlockDiag(SUNMatrix A, N_Vector x, N_Vector y);
+
+
+/*
+ * -----------------------------------------------------------------
+ * exported functions
+ * -----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------------------
+ * Function to create a new block-diagonal matrix
+ */
+
+SUNMatrix SUNBlockDiagMatrix(sunindextype nblocks, sunindextype bs)
+{
+  SUNMatrix A;
+  SUNMatrixContent_BlockDiag content;
+
+  /* return with NULL matrix on illegal dimension input */
+  if ( (nblocks <= 0) || (bs <= 0) ) return(NULL);
+
+  /* Create an empty matrix object */
+  A = NULL;
+  A = SUNMatNewEmpty();
+  if (A == NULL) return(NULL);
+
+  /* Attach operations */
+  A->ops->getid     = SUNMatGetID_BlockDiag;
+  A->ops->clone     = SUNMatClone_BlockDiag;
+  A->ops->destroy   = SUNMatDestroy_BlockDiag;
+  A->ops->zero      = SUNMatZero_BlockDiag;
+  A->ops->copy      = SUNMatCopy_BlockDiag;
+  A->ops->scaleadd  = SUNMatScaleAdd_BlockDiag;
+  A->ops->scaleaddi = SUNMatScaleAddI_BlockDiag;
+  A->ops->matvec    = SUNMatMatvec_BlockDiag;
+  A->ops->space     = SUNMatSpace_BlockDiag;
+
+  /* Create content */
+  content = NULL;
+  content = (SUNMatrixContent_BlockDiag) malloc(sizeof *content);
+  if (content == NULL) { SUNMatDestroy(A); return(NULL); }
+
+  /* Attach content */
+  A->content = content;
+
+  /* Fill content */
+  content->nblocks = nblocks;
+  content->bs      = bs;
+  content->ldata   = nblocks*bs*bs;
+  content->data    = NULL;
+
+  /* Allocate content */
+  content->data = (realtype *) calloc(content->ldata, sizeof(realtype));
+  if (content->data == NULL) { SUNMatDestroy(A); return(NULL); }
+
+  return(A);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Function to print the block-diagonal matrix, block by block
+ */
+
+void SUNBlockDiagMatrix_Print(SUNMatrix A, FILE* outfile)
+{
+  sunindextype b, i, j;
+
+  /* should not be called unless A is a block-diagonal matrix;
+     otherwise return immediately */
+  if (SUNMatGetID(A) != SUNMATRIX_BLOCKDIAG)
+    return;
+
+  /* perform operation */
+  for (b=0; b<SM_NBLOCKS_BD(A); b++) {
+    fprintf(outfile,"\nblock %ld\n", (long int) b);
+    for (i=0; i<SM_BLOCKSIZE_BD(A); i++) {
+      for (j=0; j<SM_BLOCKSIZE_BD(A); j++) {
+#if defined(SUNDIALS_EXTENDED_PRECISION)
+        fprintf(outfile,"%12Lg  ", SM_ELEMENT_BD(A,b,i,j));
+#elif defined(SUNDIALS_DOUBLE_PRECISION)
+        fprintf(outfile,"%12g  ", SM_ELEMENT_BD(A,b,i,j));
+#else
+        fprintf(outfile,"%12g  ", SM_ELEMENT_BD(A,b,i,j));
+#endif
+      }
+      fprintf(outfile,"\n");
+    }
+  }
+  fprintf(outfile,"\n");
+  return;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Functions to access the contents of the block-diagonal matrix structure
+ */
+
+sunindextype SUNBlockDiagMatrix_NumBlocks(SUNMatrix A)
+{
+  if (SUNMatGetID(A) == SUNMATRIX_BLOCKDIAG)
+    return SM_NBLOCKS_BD(A);
+  else
+    return SUNMAT_ILL_INPUT;
+}
+
+sunindextype SUNBlockDiagMatrix_BlockSize(SUNMatrix A)
+{
+  if (SUNMatGetID(A) == SUNMATRIX_BLOCKDIAG)
+    return SM_BLOCKSIZE_BD(A);
+  else
+    return SUNMAT_ILL_INPUT;
+}
+
+sunindextype SUNBlockDiagMatrix_Rows(SUNMatrix A)
+{
+  if (SUNMatGetID(A) == SUNMATRIX_BLOCKDIAG)
+    return SM_ROWS_BD(A);
+  else
+    return SUNMAT_ILL_INPUT;
+}
+
+sunindextype SUNBlockDiagMatrix_Columns(SUNMatrix A)
+{
+  if (SUNMatGetID(A) == SUNMATRIX_BLOCKDIAG)
+    return SM_ROWS_BD(A);
+  else
+    return SUNMAT_ILL_INPUT;
+}
+
+sunindextype SUNBlockDiagMatrix_LData(SUNMatrix A)
+{
+  if (SUNMatGetID(A) == SUNMATRIX_BLOCKDIAG)
+    return SM_LDATA_BD(A);
+  else
+    return SUNMAT_ILL_INPUT;
+}
+
+realtype* SUNBlockDiagMatrix_Data(SUNMatrix A)
+{
+  if (SUNMatGetID(A) == SUNMATRIX_BLOCKDIAG)
+    return SM_DATA_BD(A);
+  else
+    return NULL;
+}
+
+realtype* SUNBlockDiagMatrix_Block(SUNMatrix A, sunindextype b)
+{
+  if (SUNMatGetID(A) == SUNMATRIX_BLOCKDIAG)
+    return SM_BLOCK_BD(A,b);
+  else
+    return NULL;
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * implementation of matrix operations
+ * -----------------------------------------------------------------
+ */
+
+SUNMatrix_ID SUNMatGetID_BlockDiag(SUNMatrix A)
+{
+  return SUNMATRIX_BLOCKDIAG;
+}
+
+SUNMatrix SUNMatClone_BlockDiag(SUNMatrix A)
+{
+  SUNMatrix B = SUNBlockDiagMatrix(SM_NBLOCKS_BD(A), SM_BLOCKSIZE_BD(A));
+  return(B);
+}
+
+void SUNMatDestroy_BlockDiag(SUNMatrix A)
+{
+  if (A == NULL) return;
+
+  /* free content */
+  if (A->content != NULL) {
+    /* free data array */
+    if (SM_DATA_BD(A) != NULL) {
+      free(SM_DATA_BD(A));
+      SM_DATA_BD(A) = NULL;
+    }
+    /* free content struct */
+    free(A->content);
+    A->content = NULL;
+  }
+
+  /* free ops and matrix */
+  if (A->ops) { free(A->ops); A->ops = NULL; }
+  free(A); A = NULL;
+
+  return;
+}
+
+int SUNMatZero_BlockDiag(SUNMatrix A)
+{
+  sunindextype i;
+  realtype *Adata;
+
+  /* Perform operation */
+  Adata = SM_DATA_BD(A);
+  for (i=0; i<SM_LDATA_BD(A); i++)
+    Adata[i] = ZERO;
+  return SUNMAT_SUCCESS;
+}
+
+int SUNMatCopy_BlockDiag(SUNMatrix A, SUNMatrix B)
+{
+  sunindextype i;
+  realtype *Adata, *Bdata;
+
+  /* Verify that A and B are compatible */
+  if (!SMCompatible_BlockDiag(A, B))
+    return SUNMAT_ILL_INPUT;
+
+  /* Perform operation */
+  Adata = SM_DATA_BD(A);
+  Bdata = SM_DATA_BD(B);
+  for (i=0; i<SM_LDATA_BD(A); i++)
+    Bdata[i] = Adata[i];
+  return SUNMAT_SUCCESS;
+}
+
+int SUNMatScaleAddI_BlockDiag(realtype c, SUNMatrix A)
+{
+  sunindextype i, b, bs;
+  realtype *Adata, *Ab;
+
+  /* Perform operation */
+  Adata = SM_DATA_BD(A);
+  for (i=0; i<SM_LDATA_BD(A); i++)
+    Adata[i] *= c;
+  bs = SM_BLOCKSIZE_BD(A);
+  for (b=0; b<SM_NBLOCKS_BD(A); b++) {
+    Ab = SM_BLOCK_BD(A,b);
+    for (i=0; i<bs; i++)
+      Ab[i*bs+i] += ONE;
+  }
+  return SUNMAT_SUCCESS;
+}
+
+int SUNMatScaleAdd_BlockDiag(realtype c, SUNMatrix A, SUNMatrix B)
+{
+  sunindextype i;
+  realtype *Adata, *Bdata;
+
+  /* Verify that A and B are compatible */
+  if (!SMCompatible_BlockDiag(A, B))
+    return SUNMAT_ILL_INPUT;
+
+  /* Perform operation */
+  Adata = SM_DATA_BD(A);
+  Bdata = SM_DATA_BD(B);
+  for (i=0; i<SM_LDATA_BD(A); i++)
+    Adata[i] = c*Adata[i] + Bdata[i];
+  return SUNMAT_SUCCESS;
+}
+
+int SUNMatMatvec_BlockDiag(SUNMatrix A, N_Vector x, N_Vector y)
+{
+  sunindextype b, i, j, bs;
+  realtype *Ab, *col_j, *xd, *yd, *xb, *yb;
+
+  /* Verify that A, x and y are compatible */
+  if (!SMCompatible2_BlockDiag(A, x, y))
+    return SUNMAT_ILL_INPUT;
+
+  /* access vector data (return if failure) */
+  xd = N_VGetArrayPointer(x);
+  yd = N_VGetArrayPointer(y);
+  if ((xd == NULL) || (yd == NULL) || (xd == yd))
+    return SUNMAT_MEM_FAIL;
+
+  /* Perform operation */
+  bs = SM_BLOCKSIZE_BD(A);
+  for (b=0; b<SM_NBLOCKS_BD(A); b++) {
+    Ab = SM_BLOCK_BD(A,b);
+    xb = xd + b*bs;
+    yb = yd + b*bs;
+    for (i=0; i<bs; i++)
+      yb[i] = ZERO;
+    for (j=0; j<bs; j++) {
+      col_j = Ab + j*bs;
+      for (i=0; i<bs; i++)
+        yb[i] += col_j[i]*xb[j];
+    }
+  }
+  return SUNMAT_SUCCESS;
+}
+
+int SUNMatSpace_BlockDiag(SUNMatrix A, long int *lenrw, long int *leniw)
+{
+  *lenrw = SM_LDATA_BD(A);
+  *leniw = 3;
+  return SUNMAT_SUCCESS;
+}
+
+
+/*
+ * -----------------------------------------------------------------
+ * private functions
+ * -----------------------------------------------------------------
+ */
+
+static booleantype SMCompatible_BlockDiag(SUNMatrix A, SUNMatrix B)
+{
+  /* both matrices must be SUNMATRIX_BLOCKDIAG */
+  if (SUNMatGetID(A) != SUNMATRIX_BLOCKDIAG)
+    return SUNFALSE;
+  if (SUNMatGetID(B) != SUNMATRIX_BLOCKDIAG)
+    return SUNFALSE;
+
+  /* both matrices must have the same blocks */
+  if (SM_NBLOCKS_BD(A) != SM_NBLOCKS_BD(B))
+    return SUNFALSE;
+  if (SM_BLOCKSIZE_BD(A) != SM_BLOCKSIZE_BD(B))
+    return SUNFALSE;
+
+  return SUNTRUE;
+}
+
+
+static booleantype SMCompatible2_BlockDiag(SUNMatrix A, N_Vector x, N_Vector y)
+{
+  /*   vectors must be one of {SERIAL, OPENMP, PTHREADS} */
+  if ( (N_VGetVectorID(x) != SUNDIALS_NVEC_SERIAL) &&
+       (N_VGetVectorID(x) != SUNDIALS_NVEC_OPENMP) &&
+       (N_VGetVectorID(x) != SUNDIALS_NVEC_PTHREADS) )
+    return SUNFALSE;
+
+  /* the vectors have to cover all blocks */
+  if ( (N_VGetLength(x) != SM_ROWS_BD(A)) ||
+       (N_VGetLength(y) != SM_ROWS_BD(A)) )
+    return SUNFALSE;
+
+  return SUNTRUE;
+}
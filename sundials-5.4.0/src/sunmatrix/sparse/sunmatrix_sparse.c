@@ -30,12 +30,38 @@
 #define ZERO RCONST(0.0)
 #define ONE  RCONST(1.0)
 
+/* number of vectors handled per pass over the matrix by
+   SUNSparseMatrix_MatvecMulti */
+#define SM_NVEC_CHUNK 8
+
+/* Rows of the products are split among the threads set with
+   SUNSparseMatrix_SetNumThreads, each row sum keeps its order so the
+   results do not depend on the number of threads */
+#if defined(_OPENMP)
+#define SM_PRAGMA(x)       _Pragma(#x)
+#define SM_OMP_FOR(nth)    SM_PRAGMA(omp parallel for schedule(static) num_threads(nth) if(nth > 1))
+#else
+#define SM_OMP_FOR(nth)
+#endif
+
 /* Private function prototypes */
 static booleantype SMCompatible_Sparse(SUNMatrix A, SUNMatrix B);
 static booleantype SMCompatible2_Sparse(SUNMatrix A, N_Vector x, N_Vector y);
 static int Matvec_SparseCSC(SUNMatrix A, N_Vector x, N_Vector y);
 static int Matvec_SparseCSR(SUNMatrix A, N_Vector x, N_Vector y);
 static int format_convert(const SUNMatrix A, SUNMatrix B);
+static void SMTransposeStale_Sparse(SUNMatrix A);
+static booleantype SMTransposeReady_Sparse(SUNMatrix A);
+static void SMProdGather_Sparse(int nthreads, sunindextype n,
+                                const sunindextype *p, const sunindextype *idx,
+                                const sunindextype *map, const realtype *Ax,
+                                int nvec, realtype **xd, realtype **yd);
+static void SMProdScatter_Sparse(sunindextype n, sunindextype m,
+                                 const sunindextype *p, const sunindextype *idx,
+                                 const realtype *Ax, int nvec, realtype **xd,
+                                 realtype **yd);
+static int SMProd_Sparse(SUNMatrix A, booleantype trans, int nvec,
+                         N_Vector *X, N_Vector *Y);
 
 /*
  * -----------------------------------------------------------------
@@ -112,6 +138,12 @@ SUNMatrix SUNSparseMatrix(sunindextype M, sunindextype N,
   content->data      = NULL;
   content->indexvals = NULL;
   content->indexptrs = NULL;
+  content->num_threads = 1;
+  content->tcache    = SUNFALSE;
+  content->tnnz      = -1;
+  content->tptrs     = NULL;
+  content->tvals     = NULL;
+  content->tmap      = NULL;
 
   /* Allocate content */
   content->data = (realtype *) calloc(NNZ, sizeof(realtype));
@@ -258,6 +290,62 @@ SUNMatrix SUNSparseFromBandMatrix(SUNMatrix Ad, realtype droptol, int sparsetype
 }
 
 
+/* ----------------------------------------------------------------------------
+ * Function to copy the values of a dense matrix into the existing pattern of
+ * a sparse matrix of the same dimensions, e.g. one created once with
+ * SUNSparseFromDenseMatrix. Only the entries of the pattern are read, the
+ * other entries of Ad are dropped whatever their value, and nothing is
+ * allocated, so the cost is O(nnz) instead of the O(M*N) scan. The rows
+ * (columns for CSR) are split among the threads of As.
+ */
+
+int SUNSparseMatrix_CopyFromDense(SUNMatrix Ad, SUNMatrix As)
+{
+  sunindextype r, M, N, np;
+  sunindextype *Ap, *Ai;
+  realtype *Ax, *Dx;
+
+  if ((SUNMatGetID(Ad) != SUNMATRIX_DENSE) ||
+      (SUNMatGetID(As) != SUNMATRIX_SPARSE))
+    return SUNMAT_ILL_INPUT;
+
+  M = SM_ROWS_D(Ad);
+  N = SM_COLUMNS_D(Ad);
+  if ((SM_ROWS_S(As) != M) || (SM_COLUMNS_S(As) != N))
+    return SUNMAT_ILL_INPUT;
+
+  Ap = SM_INDEXPTRS_S(As);
+  Ai = SM_INDEXVALS_S(As);
+  Ax = SM_DATA_S(As);
+  Dx = SM_DATA_D(Ad);
+  if ((Ap == NULL) || (Ai == NULL) || (Ax == NULL) || (Dx == NULL))
+    return SUNMAT_MEM_FAIL;
+
+  np = SM_NP_S(As);
+
+  if (SM_SPARSETYPE_S(As) == CSC_MAT) {
+    /* column r of Ad is contiguous */
+    SM_OMP_FOR(SM_CONTENT_S(As)->num_threads)
+    for (r = 0; r < np; r++) {
+      sunindextype k;
+      realtype *col = Dx + r*M;
+      for (k = Ap[r]; k < Ap[r+1]; k++)
+        Ax[k] = col[Ai[k]];
+    }
+  } else {
+    /* row r of Ad has stride M */
+    SM_OMP_FOR(SM_CONTENT_S(As)->num_threads)
+    for (r = 0; r < np; r++) {
+      sunindextype k;
+      for (k = Ap[r]; k < Ap[r+1]; k++)
+        Ax[k] = Dx[Ai[k]*M + r];
+    }
+  }
+
+  return SUNMAT_SUCCESS;
+}
+
+
 /* ----------------------------------------------------------------------------
  * Function to create a new CSR matrix from a CSC matrix.
  */
@@ -288,6 +376,34 @@ int SUNSparseMatrix_ToCSC(const SUNMatrix A, SUNMatrix* Bout)
 }
 
 
+/* ----------------------------------------------------------------------------
+ * Function to copy A into an existing matrix B of the same dimensions, in
+ * the format of B (CSR from CSC, CSC from CSR, or a plain copy). The storage
+ * of B is only reallocated if it cannot hold the nonzeros of A, so repeated
+ * conversions into the same B do not allocate.
+ */
+int SUNSparseMatrix_Convert(const SUNMatrix A, SUNMatrix B)
+{
+    if ((A == NULL) || (B == NULL)) return(SUNMAT_ILL_INPUT);
+    if ((SUNMatGetID(A) != SUNMATRIX_SPARSE) ||
+        (SUNMatGetID(B) != SUNMATRIX_SPARSE)) return(SUNMAT_ILL_INPUT);
+    if ((SM_ROWS_S(A) != SM_ROWS_S(B)) ||
+        (SM_COLUMNS_S(A) != SM_COLUMNS_S(B))) return(SUNMAT_ILL_INPUT);
+
+    if (SM_SPARSETYPE_S(A) == SM_SPARSETYPE_S(B))
+      return SUNMatCopy_Sparse(A, B);
+
+    if (SM_NNZ_S(B) < (SM_INDEXPTRS_S(A))[SM_NP_S(A)]) {
+      if (SUNSparseMatrix_Reallocate(B, (SM_INDEXPTRS_S(A))[SM_NP_S(A)]) != SUNMAT_SUCCESS)
+        return(SUNMAT_MEM_FAIL);
+      if ((SM_INDEXVALS_S(B) == NULL) || (SM_DATA_S(B) == NULL))
+        return(SUNMAT_MEM_FAIL);
+    }
+
+    return format_convert(A, B);
+}
+
+
 /* ----------------------------------------------------------------------------
  * Function to reallocate internal sparse matrix storage arrays so that the
  * resulting sparse matrix holds indexptrs[NP] nonzeros.  Returns 0 on success
@@ -307,6 +423,7 @@ int SUNSparseMatrix_Realloc(SUNMatrix A)
   if (nzmax < 0) return SUNMAT_ILL_INPUT;
 
   /* perform reallocation */
+  SMTransposeStale_Sparse(A);
   SM_INDEXVALS_S(A) = (sunindextype *) realloc(SM_INDEXVALS_S(A), nzmax*sizeof(sunindextype));
   SM_DATA_S(A) = (realtype *) realloc(SM_DATA_S(A), nzmax*sizeof(realtype));
   SM_NNZ_S(A) = nzmax;
@@ -331,6 +448,7 @@ int SUNSparseMatrix_Reallocate(SUNMatrix A, sunindextype NNZ)
   if (NNZ < 0)  return SUNMAT_ILL_INPUT;
 
   /* perform reallocation */
+  SMTransposeStale_Sparse(A);
   SM_INDEXVALS_S(A) = (sunindextype *) realloc(SM_INDEXVALS_S(A), NNZ*sizeof(sunindextype));
   SM_DATA_S(A) = (realtype *) realloc(SM_DATA_S(A), NNZ*sizeof(realtype));
   SM_NNZ_S(A) = NNZ;
@@ -459,6 +577,81 @@ sunindextype* SUNSparseMatrix_IndexPointers(SUNMatrix A)
 }
 
 
+/* ----------------------------------------------------------------------------
+ * Function to set the number of OpenMP threads of the matrix-vector products
+ * (default 1). Without OpenMP the value is stored and ignored. Clones inherit
+ * the value.
+ */
+
+int SUNSparseMatrix_SetNumThreads(SUNMatrix A, int num_threads)
+{
+  if (SUNMatGetID(A) != SUNMATRIX_SPARSE) return SUNMAT_ILL_INPUT;
+  if (num_threads < 1) return SUNMAT_ILL_INPUT;
+
+  SM_CONTENT_S(A)->num_threads = num_threads;
+  return SUNMAT_SUCCESS;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Function to switch the cached transpose on or off. The cache holds the
+ * sparsity pattern in the other format together with the position of each
+ * entry in the data array, so it stays valid when the values change. With it
+ * and more than one thread (SUNSparseMatrix_SetNumThreads) the products that
+ * would scatter (A*x for CSC, A^T*x for CSR) are computed row by row as
+ * threaded gathers, with one thread they keep scattering.
+ *
+ * The cache is rebuilt when SUNMATRIX_SPARSE operations change the pattern or
+ * the number of nonzeros changes; call this function again with SUNTRUE after
+ * changing the index arrays directly.
+ */
+
+int SUNSparseMatrix_CacheTranspose(SUNMatrix A, booleantype onoff)
+{
+  SUNMatrixContent_Sparse content;
+
+  if (SUNMatGetID(A) != SUNMATRIX_SPARSE) return SUNMAT_ILL_INPUT;
+  content = SM_CONTENT_S(A);
+
+  SMTransposeStale_Sparse(A);
+  content->tcache = onoff;
+
+  if (!onoff) {
+    free(content->tptrs); content->tptrs = NULL;
+    free(content->tvals); content->tvals = NULL;
+    free(content->tmap);  content->tmap  = NULL;
+    return SUNMAT_SUCCESS;
+  }
+
+  return SMTransposeReady_Sparse(A) ? SUNMAT_SUCCESS : SUNMAT_MEM_FAIL;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Function to compute y = A^T x, where x has length M and y has length N.
+ */
+
+int SUNSparseMatrix_MatvecTranspose(SUNMatrix A, N_Vector x, N_Vector y)
+{
+  if (SUNMatGetID(A) != SUNMATRIX_SPARSE) return SUNMAT_ILL_INPUT;
+  return SMProd_Sparse(A, SUNTRUE, 1, &x, &y);
+}
+
+
+/* ----------------------------------------------------------------------------
+ * Function to compute Y[k] = A X[k] for nvec vectors, passing over the matrix
+ * once for up to SM_NVEC_CHUNK vectors. The result of each product is the
+ * same as the one of SUNMatMatvec.
+ */
+
+int SUNSparseMatrix_MatvecMulti(SUNMatrix A, int nvec, N_Vector* X, N_Vector* Y)
+{
+  if (SUNMatGetID(A) != SUNMATRIX_SPARSE) return SUNMAT_ILL_INPUT;
+  if (nvec < 1) return SUNMAT_ILL_INPUT;
+  return SMProd_Sparse(A, SUNFALSE, nvec, X, Y);
+}
+
+
 /*
  * -----------------------------------------------------------------
  * implementation of matrix operations
@@ -474,6 +667,11 @@ SUNMatrix SUNMatClone_Sparse(SUNMatrix A)
 {
   SUNMatrix B = SUNSparseMatrix(SM_ROWS_S(A), SM_COLUMNS_S(A),
                                 SM_NNZ_S(A), SM_SPARSETYPE_S(A));
+  if (B == NULL) return(NULL);
+
+  /* the clone has its own cache, built at its first use */
+  SM_CONTENT_S(B)->num_threads = SM_CONTENT_S(A)->num_threads;
+  SM_CONTENT_S(B)->tcache      = SM_CONTENT_S(A)->tcache;
   return(B);
 }
 
@@ -502,6 +700,10 @@ void SUNMatDestroy_Sparse(SUNMatrix A)
       SM_CONTENT_S(A)->colptrs = NULL;
       SM_CONTENT_S(A)->rowptrs = NULL;
     }
+    /* free cached transpose */
+    free(SM_CONTENT_S(A)->tptrs);
+    free(SM_CONTENT_S(A)->tvals);
+    free(SM_CONTENT_S(A)->tmap);
     /* free content struct */
     free(A->content);
     A->content = NULL;
@@ -519,6 +721,7 @@ int SUNMatZero_Sparse(SUNMatrix A)
   sunindextype i;
 
   /* Perform operation */
+  SMTransposeStale_Sparse(A);
   for (i=0; i<SM_NNZ_S(A); i++) {
     (SM_DATA_S(A))[i] = ZERO;
     (SM_INDEXVALS_S(A))[i] = 0;
@@ -618,6 +821,10 @@ int SUNMatScaleAddI_Sparse(realtype c, SUNMatrix A)
   if (newvals > (SM_NNZ_S(A) - Ap[N]))
     newmat = SUNTRUE;
 
+  /* new entries change the pattern */
+  if (newvals > 0)
+    SMTransposeStale_Sparse(A);
+
 
   /* perform operation based on existing/necessary structure */
 
@@ -848,6 +1055,10 @@ int SUNMatScaleAdd_Sparse(realtype c, SUNMatrix A, SUNMatrix B)
   if (newvals > (SM_NNZ_S(A) - Ap[N]))
     newmat = SUNTRUE;
 
+  /* new entries change the pattern */
+  if (newvals > 0)
+    SMTransposeStale_Sparse(A);
+
   /* perform operation based on existing/necessary structure */
 
   /*   case 1: A already contains sparsity pattern of B */
@@ -1080,85 +1291,245 @@ static booleantype SMCompatible2_Sparse(SUNMatrix A, N_Vector x, N_Vector y)
  * compatible N_Vector object of length N, and y is a compatible
  * N_Vector object of length M.
  *
+ * Scatters the columns of A into y, or gathers the rows from the cached
+ * transpose if there is one and the product is threaded.
+ *
  * Returns 0 if successful, 1 if unsuccessful (failed memory access, or both
  * x and y are the same vector).
  */
 int Matvec_SparseCSC(SUNMatrix A, N_Vector x, N_Vector y)
 {
-  sunindextype i, j;
-  sunindextype *Ap, *Ai;
-  realtype *Ax, *xd, *yd;
+  return SMProd_Sparse(A, SUNFALSE, 1, &x, &y);
+}
+
+
+/* -----------------------------------------------------------------
+ * Computes y=A*x, where A is a CSR SUNMatrix_Sparse of dimension MxN, x is a
+ * compatible N_Vector object of length N, and y is a compatible
+ * N_Vector object of length M.
+ *
+ * Returns 0 if successful, -1 if unsuccessful (failed memory access).
+ */
+int Matvec_SparseCSR(SUNMatrix A, N_Vector x, N_Vector y)
+{
+  return SMProd_Sparse(A, SUNFALSE, 1, &x, &y);
+}
+
+
+/* -----------------------------------------------------------------
+ * Computes Y[k]=A*X[k] (trans = SUNFALSE) or Y[k]=A^T*X[k] (trans =
+ * SUNTRUE) for k < nvec, after checking the matrix and the vectors.
+ * A product along the stored direction (A*x for CSR, A^T*x for CSC)
+ * gathers, the other one gathers from the cached transpose if there is
+ * one and the product is threaded, and scatters otherwise.
+ */
+static int SMProd_Sparse(SUNMatrix A, booleantype trans, int nvec,
+                         N_Vector *X, N_Vector *Y)
+{
+  realtype *xd[SM_NVEC_CHUNK], *yd[SM_NVEC_CHUNK];
+  sunindextype *Ap, *Ai, M, N, nrows, ncols;
+  realtype *Ax;
+  booleantype stored, threaded;
+  int k, c, nc;
 
-  /* access data from CSC structure (return if failure) */
+  /* access data from the sparse structure (return if failure) */
   Ap = SM_INDEXPTRS_S(A);
   Ai = SM_INDEXVALS_S(A);
   Ax = SM_DATA_S(A);
   if ((Ap == NULL) || (Ai == NULL) || (Ax == NULL))
     return SUNMAT_MEM_FAIL;
 
-  /* access vector data (return if failure) */
-  xd = N_VGetArrayPointer(x);
-  yd = N_VGetArrayPointer(y);
-  if ((xd == NULL) || (yd == NULL) || (xd == yd) )
-    return SUNMAT_MEM_FAIL;
+  /* rows and columns of the product */
+  M = SM_ROWS_S(A);
+  N = SM_COLUMNS_S(A);
+  nrows = trans ? N : M;
+  ncols = trans ? M : N;
+
+  /* is the product along the stored direction? */
+  stored = (SM_SPARSETYPE_S(A) == CSR_MAT) ? !trans : trans;
+
+  /* the cached transpose only pays off when the gather is threaded */
+  threaded = (SM_CONTENT_S(A)->num_threads > 1);
+  if (!stored && threaded) SMTransposeReady_Sparse(A);
+
+  for (c = 0; c < nvec; c += SM_NVEC_CHUNK) {
+
+    nc = SUNMIN(SM_NVEC_CHUNK, nvec - c);
+
+    /* access vector data (return if failure) */
+    for (k = 0; k < nc; k++) {
+      if ( (X[c+k]->ops->nvgetarraypointer == NULL) ||
+           (Y[c+k]->ops->nvgetarraypointer == NULL) ||
+           (N_VGetLength(X[c+k]) != ncols) || (N_VGetLength(Y[c+k]) != nrows) )
+        return SUNMAT_ILL_INPUT;
+      xd[k] = N_VGetArrayPointer(X[c+k]);
+      yd[k] = N_VGetArrayPointer(Y[c+k]);
+      if ((xd[k] == NULL) || (yd[k] == NULL) || (xd[k] == yd[k]))
+        return SUNMAT_MEM_FAIL;
+    }
 
-  /* initialize result */
-  for (i=0; i<SM_ROWS_S(A); i++)
-    yd[i] = 0.0;
+    if (stored)
+      SMProdGather_Sparse(SM_CONTENT_S(A)->num_threads, nrows, Ap, Ai, NULL,
+                          Ax, nc, xd, yd);
+    else if (threaded && SM_CONTENT_S(A)->tnnz >= 0)
+      SMProdGather_Sparse(SM_CONTENT_S(A)->num_threads, nrows,
+                          SM_CONTENT_S(A)->tptrs, SM_CONTENT_S(A)->tvals,
+                          SM_CONTENT_S(A)->tmap, Ax, nc, xd, yd);
+    else
+      SMProdScatter_Sparse(ncols, nrows, Ap, Ai, Ax, nc, xd, yd);
+  }
 
-  /* iterate through matrix columns */
-  for (j=0; j<SM_COLUMNS_S(A); j++) {
+  return SUNMAT_SUCCESS;
+}
 
-    /* iterate down column of A, performing product */
-    for (i=Ap[j]; i<Ap[j+1]; i++)
-      yd[Ai[i]] += Ax[i]*xd[j];
 
+/* -----------------------------------------------------------------
+ * Computes yd[k][r] = sum_{d=p[r]}^{p[r+1]-1} Ax[map[d]] xd[k][idx[d]]
+ * for r < n and k < nvec (map = NULL stands for map[d] = d). The rows
+ * are independent and split among nthreads OpenMP threads.
+ */
+static void SMProdGather_Sparse(int nthreads, sunindextype n,
+                                const sunindextype *p, const sunindextype *idx,
+                                const sunindextype *map, const realtype *Ax,
+                                int nvec, realtype **xd, realtype **yd)
+{
+  sunindextype r;
+  realtype *x, *y;
+
+  if (nvec == 1) {
+
+    x = xd[0];
+    y = yd[0];
+
+    if (map == NULL) {
+      SM_OMP_FOR(nthreads)
+      for (r = 0; r < n; r++) {
+        sunindextype e;
+        realtype rsum = ZERO;
+        for (e = p[r]; e < p[r+1]; e++)
+          rsum += Ax[e]*x[idx[e]];
+        y[r] = rsum;
+      }
+    } else {
+      SM_OMP_FOR(nthreads)
+      for (r = 0; r < n; r++) {
+        sunindextype e;
+        realtype rsum = ZERO;
+        for (e = p[r]; e < p[r+1]; e++)
+          rsum += Ax[map[e]]*x[idx[e]];
+        y[r] = rsum;
+      }
+    }
+    return;
   }
 
-  return SUNMAT_SUCCESS;
+  SM_OMP_FOR(nthreads)
+  for (r = 0; r < n; r++) {
+    sunindextype e, col;
+    realtype ak, rsum[SM_NVEC_CHUNK];
+    int v;
+    for (v = 0; v < nvec; v++) rsum[v] = ZERO;
+    for (e = p[r]; e < p[r+1]; e++) {
+      ak  = (map == NULL) ? Ax[e] : Ax[map[e]];
+      col = idx[e];
+      for (v = 0; v < nvec; v++)
+        rsum[v] += ak*xd[v][col];
+    }
+    for (v = 0; v < nvec; v++) yd[v][r] = rsum[v];
+  }
 }
 
 
 /* -----------------------------------------------------------------
- * Computes y=A*x, where A is a CSR SUNMatrix_Sparse of dimension MxN, x is a
- * compatible N_Vector object of length N, and y is a compatible
- * N_Vector object of length M.
- *
- * Returns 0 if successful, -1 if unsuccessful (failed memory access).
+ * Computes yd[k] = sum_{j<n} xd[k][j] (column j of the stored pattern)
+ * for k < nvec, where yd[k] has length m. Sequential, the columns
+ * scatter into the same entries of yd.
  */
-int Matvec_SparseCSR(SUNMatrix A, N_Vector x, N_Vector y)
+static void SMProdScatter_Sparse(sunindextype n, sunindextype m,
+                                 const sunindextype *p, const sunindextype *idx,
+                                 const realtype *Ax, int nvec, realtype **xd,
+                                 realtype **yd)
 {
   sunindextype i, j;
-  sunindextype *Ap, *Aj;
-  realtype *Ax, *xd, *yd;
-
-  /* access data from CSR structure (return if failure) */
-  Ap = SM_INDEXPTRS_S(A);
-  Aj = SM_INDEXVALS_S(A);
-  Ax = SM_DATA_S(A);
-  if ((Ap == NULL) || (Aj == NULL) || (Ax == NULL))
-    return SUNMAT_MEM_FAIL;
-
-  /* access vector data (return if failure) */
-  xd = N_VGetArrayPointer(x);
-  yd = N_VGetArrayPointer(y);
-  if ((xd == NULL) || (yd == NULL) || (xd == yd))
-    return SUNMAT_MEM_FAIL;
+  realtype xj;
+  int k;
 
   /* initialize result */
-  for (i=0; i<SM_ROWS_S(A); i++)
-    yd[i] = 0.0;
+  for (k = 0; k < nvec; k++)
+    for (i = 0; i < m; i++)
+      yd[k][i] = ZERO;
+
+  /* iterate through the columns of the stored pattern */
+  for (j = 0; j < n; j++) {
+    for (k = 0; k < nvec; k++) {
+      xj = xd[k][j];
+      for (i = p[j]; i < p[j+1]; i++)
+        yd[k][idx[i]] += Ax[i]*xj;
+    }
+  }
+}
 
-  /* iterate through matrix rows */
-  for (i=0; i<SM_ROWS_S(A); i++) {
 
-    /* iterate along row of A, performing product */
-    for (j=Ap[i]; j<Ap[i+1]; j++)
-      yd[i] += Ax[j]*xd[Aj[j]];
+/* -----------------------------------------------------------------
+ * Marks the cached transpose of A as outdated, it is rebuilt at its
+ * next use.
+ */
+static void SMTransposeStale_Sparse(SUNMatrix A)
+{
+  SM_CONTENT_S(A)->tnnz = -1;
+}
+
 
+/* -----------------------------------------------------------------
+ * Builds the cached transpose of A if it is switched on and outdated.
+ * Returns SUNTRUE if the cache can be used.
+ */
+static booleantype SMTransposeReady_Sparse(SUNMatrix A)
+{
+  SUNMatrixContent_Sparse content;
+  sunindextype *Ap, *Ai, *Tp, *Ti, *Tm;
+  sunindextype np, nq, nnz, i, j, d;
+
+  content = SM_CONTENT_S(A);
+  if (!content->tcache) return(SUNFALSE);
+
+  Ap  = content->indexptrs;
+  Ai  = content->indexvals;
+  np  = content->NP;
+  nq  = (content->sparsetype == CSC_MAT) ? content->M : content->N;
+  nnz = Ap[np];
+
+  if (content->tnnz == nnz) return(SUNTRUE);
+  content->tnnz = -1;
+
+  /* (re)allocate the cache */
+  if (content->tptrs == NULL)
+    content->tptrs = (sunindextype *) malloc((nq+1)*sizeof(sunindextype));
+  Tp = content->tptrs;
+  Ti = (sunindextype *) realloc(content->tvals, SUNMAX(nnz,1)*sizeof(sunindextype));
+  if (Ti != NULL) content->tvals = Ti;
+  Tm = (sunindextype *) realloc(content->tmap, SUNMAX(nnz,1)*sizeof(sunindextype));
+  if (Tm != NULL) content->tmap = Tm;
+  if ((Tp == NULL) || (Ti == NULL) || (Tm == NULL)) return(SUNFALSE);
+
+  /* count the entries of each row (column) of the transpose */
+  for (i = 0; i <= nq; i++) Tp[i] = 0;
+  for (d = 0; d < nnz; d++) Tp[Ai[d]+1]++;
+  for (i = 0; i < nq; i++) Tp[i+1] += Tp[i];
+
+  /* fill in, Tp[i] moves to the start of i+1 */
+  for (j = 0; j < np; j++) {
+    for (d = Ap[j]; d < Ap[j+1]; d++) {
+      i = Tp[Ai[d]]++;
+      Ti[i] = j;
+      Tm[i] = d;
+    }
   }
+  for (i = nq; i > 0; i--) Tp[i] = Tp[i-1];
+  Tp[0] = 0;
 
-  return(0);
+  content->tnnz = nnz;
+  return(SUNTRUE);
 }
 
 
@@ -1190,7 +1561,10 @@ int format_convert(const SUNMatrix A, SUNMatrix B)
 
     nnz = Ap[n_row];
 
-    SUNMatZero_Sparse(B);
+    /* only the pointers of B have to be zeroed */
+    SMTransposeStale_Sparse(B);
+    for (col = 0; col <= n_col; col++)
+        Bp[col] = 0;
 
     /* compute number of non-zero entries per column (if CSR) or per row (if CSC) of A */
     for (n = 0; n < nnz; n++)
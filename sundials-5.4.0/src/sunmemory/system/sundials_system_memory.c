@@ -0,0 +1,263 @@
+/* -----------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------
+ * SUNDIALS system memory helper implementation.
+ *
+ * Every block starts with a header holding its size class, the
+ * header of a cached block also links it into the free list of the
+ * class. The helper counts the blocks handed out and not returned
+ * yet, a helper destroyed while some of them are still in use is
+ * only released when the last one comes back.
+ * ----------------------------------------------------------------*/
+
+#include <string.h>
+
+#include <sunmemory/sunmemory_system.h>
+
+/* the smallest class holds 2^SUN_SYS_MINSHIFT bytes, blocks larger
+   than the largest class are not cached */
+#define SUN_SYS_MINSHIFT 6
+#define SUN_SYS_NCLASS   26
+
+typedef union _SUNSysBlock *SUNSysBlock;
+
+union _SUNSysBlock {
+  struct {
+    SUNSysBlock next;          /* next cached block of the class     */
+    size_t cls;                /* size class, SUN_SYS_NCLASS if none */
+    size_t size;               /* usable size of the block [bytes]   */
+  } h;
+  long double align;           /* keep the payload maximally aligned */
+};
+
+typedef struct _SUNSysMemContent *SUNSysMemContent;
+
+struct _SUNSysMemContent {
+  SUNSysBlock free[SUN_SYS_NCLASS];
+  long int nalloc;             /* number of allocation requests      */
+  long int nreuse;             /* requests served from the pool      */
+  long int noutstanding;       /* blocks handed out, not returned    */
+  size_t cached;               /* bytes kept on the free lists       */
+  booleantype destroyed;
+};
+
+#define SYS_CONTENT(h) ( (SUNSysMemContent)((h)->content) )
+
+/* -----------------------------------------------------------------
+ * private functions
+ * ----------------------------------------------------------------- */
+
+static size_t sunSysClass(size_t mem_size)
+{
+  size_t cls = 0;
+
+  while (cls < SUN_SYS_NCLASS &&
+         ((size_t) 1 << (cls + SUN_SYS_MINSHIFT)) < mem_size)
+    cls++;
+
+  return(cls);
+}
+
+static void sunSysRelease(SUNMemoryHelper helper)
+{
+  free(helper->content);
+  free(helper->ops);
+  free(helper);
+}
+
+static void* sunSysMalloc(SUNMemoryHelper helper, size_t mem_size)
+{
+  SUNSysMemContent content;
+  SUNSysBlock block;
+  size_t cls, size;
+
+  if (helper == NULL || mem_size == 0) return(NULL);
+  content = SYS_CONTENT(helper);
+
+  cls  = sunSysClass(mem_size);
+  size = (cls < SUN_SYS_NCLASS) ? ((size_t) 1 << (cls + SUN_SYS_MINSHIFT)) : mem_size;
+
+  content->nalloc++;
+
+  if (cls < SUN_SYS_NCLASS && content->free[cls] != NULL) {
+    block = content->free[cls];
+    content->free[cls] = block->h.next;
+    content->cached   -= block->h.size;
+    content->nreuse++;
+  } else {
+    block = (SUNSysBlock) malloc(sizeof(union _SUNSysBlock) + size);
+    if (block == NULL) return(NULL);
+    block->h.cls  = cls;
+    block->h.size = size;
+  }
+
+  block->h.next = NULL;
+  content->noutstanding++;
+
+  return((void*) (block + 1));
+}
+
+static void sunSysFree(SUNMemoryHelper helper, void* ptr)
+{
+  SUNSysMemContent content;
+  SUNSysBlock block;
+
+  if (helper == NULL || ptr == NULL) return;
+  content = SYS_CONTENT(helper);
+
+  block = ((SUNSysBlock) ptr) - 1;
+  content->noutstanding--;
+
+  if (content->destroyed || block->h.cls >= SUN_SYS_NCLASS) {
+    free(block);
+    if (content->destroyed && content->noutstanding == 0)
+      sunSysRelease(helper);
+    return;
+  }
+
+  block->h.next = content->free[block->h.cls];
+  content->free[block->h.cls] = block;
+  content->cached += block->h.size;
+
+  return;
+}
+
+/* -----------------------------------------------------------------
+ * exported functions
+ * ----------------------------------------------------------------- */
+
+SUNMemoryHelper SUNMemoryHelper_Sys()
+{
+  SUNMemoryHelper helper;
+  SUNSysMemContent content;
+
+  /* Allocate the helper */
+  helper = SUNMemoryHelper_NewEmpty();
+  if (helper == NULL) return(NULL);
+
+  /* Set the ops */
+  helper->ops->alloc   = SUNMemoryHelper_Alloc_Sys;
+  helper->ops->dealloc = SUNMemoryHelper_Dealloc_Sys;
+  helper->ops->copy    = SUNMemoryHelper_Copy_Sys;
+  helper->ops->clone   = SUNMemoryHelper_Clone_Sys;
+  helper->ops->destroy = SUNMemoryHelper_Destroy_Sys;
+
+  /* Attach content and ops */
+  content = (SUNSysMemContent) calloc(1, sizeof(struct _SUNSysMemContent));
+  if (content == NULL) { free(helper->ops); free(helper); return(NULL); }
+  helper->content = content;
+
+  return(helper);
+}
+
+int SUNMemoryHelper_SysTrim(SUNMemoryHelper helper)
+{
+  SUNSysMemContent content;
+  SUNSysBlock block;
+  int cls;
+
+  if (helper == NULL) return(-1);
+  content = SYS_CONTENT(helper);
+
+  for (cls = 0; cls < SUN_SYS_NCLASS; cls++) {
+    while (content->free[cls] != NULL) {
+      block = content->free[cls];
+      content->free[cls] = block->h.next;
+      free(block);
+    }
+  }
+  content->cached = 0;
+
+  return(0);
+}
+
+int SUNMemoryHelper_SysGetStats(SUNMemoryHelper helper, long int* nalloc,
+                                long int* nreuse, size_t* cached)
+{
+  SUNSysMemContent content;
+
+  if (helper == NULL) return(-1);
+  content = SYS_CONTENT(helper);
+
+  if (nalloc) *nalloc = content->nalloc;
+  if (nreuse) *nreuse = content->nreuse;
+  if (cached) *cached = content->cached;
+
+  return(0);
+}
+
+int SUNMemoryHelper_Alloc_Sys(SUNMemoryHelper helper, SUNMemory* memptr,
+                              size_t mem_size, SUNMemoryType mem_type)
+{
+  SUNMemory mem;
+
+  /* the pool only holds pageable host memory */
+  if (mem_type != SUNMEMTYPE_HOST) return(-1);
+
+  mem = SUNMemoryNewEmpty();
+  if (mem == NULL) return(-1);
+
+  mem->ptr  = sunSysMalloc(helper, mem_size);
+  mem->own  = SUNTRUE;
+  mem->type = mem_type;
+
+  if (mem->ptr == NULL) {
+    free(mem);
+    return(-1);
+  }
+
+  *memptr = mem;
+  return(0);
+}
+
+int SUNMemoryHelper_Dealloc_Sys(SUNMemoryHelper helper, SUNMemory mem)
+{
+  if (mem == NULL) return(0);
+
+  if (mem->ptr != NULL && mem->own) {
+    if (mem->type != SUNMEMTYPE_HOST) return(-1);
+    sunSysFree(helper, mem->ptr);
+    mem->ptr = NULL;
+  }
+
+  free(mem);
+  return(0);
+}
+
+int SUNMemoryHelper_Copy_Sys(SUNMemoryHelper helper, SUNMemory dst,
+                             SUNMemory src, size_t memory_size)
+{
+  if (dst->type != SUNMEMTYPE_HOST || src->type != SUNMEMTYPE_HOST)
+    return(-1);
+
+  memcpy(dst->ptr, src->ptr, memory_size);
+  return(0);
+}
+
+SUNMemoryHelper SUNMemoryHelper_Clone_Sys(SUNMemoryHelper helper)
+{
+  /* a clone gets a pool of its own */
+  return(SUNMemoryHelper_Sys());
+}
+
+int SUNMemoryHelper_Destroy_Sys(SUNMemoryHelper helper)
+{
+  if (helper == NULL) return(0);
+
+  SUNMemoryHelper_SysTrim(helper);
+
+  if (SYS_CONTENT(helper)->noutstanding > 0)
+    SYS_CONTENT(helper)->destroyed = SUNTRUE;
+  else
+    sunSysRelease(helper);
+
+  return(0);
+}
@@ -94,6 +94,7 @@ SUNNonlinearSolver SUNNonlinSol_FixedPoint(N_Vector y, int m)
   content->m           = m;
   content->damping     = SUNFALSE;
   content->beta        = ONE;
+  content->qradd       = QRAddMGS;
   content->curiter     = 0;
   content->maxiters    = 3;
   content->niters      = 0;
@@ -383,6 +384,29 @@ int SUNNonlinSolSetDamping_FixedPoint(SUNNonlinearSolver NLS, realtype beta)
 }
 
 
+int SUNNonlinSolSetOrthAA_FixedPoint(SUNNonlinearSolver NLS, int orthaa)
+{
+  /* check that the nonlinear solver is non-null */
+  if (NLS == NULL)
+    return(SUN_NLS_MEM_NULL);
+
+  switch (orthaa) {
+  case SUN_NLS_ORTH_MGS:
+    FP_CONTENT(NLS)->qradd = QRAddMGS;
+    break;
+  case SUN_NLS_ORTH_CGS2:
+    FP_CONTENT(NLS)->qradd = QRAddCGS2;
+    break;
+  case SUN_NLS_ORTH_DCGS2:
+    FP_CONTENT(NLS)->qradd = QRAddDCGS2;
+    break;
+  default:
+    return(SUN_NLS_ILL_INPUT);
+  }
+
+  return(SUN_NLS_SUCCESS);
+}
+
 /*==============================================================================
   Get functions
   ============================================================================*/
@@ -460,6 +484,7 @@ static int AndersonAccelerate(SUNNonlinearSolver NLS, N_Vector gval,
   realtype    a, b, rtemp, c, s, beta, onembeta, *cvals, *R, *gamma;
   N_Vector    fv, vtemp, gold, fold, *df, *dg, *Q, *Xvecs;
   booleantype damping;
+  QRAddFn     qradd;
 
   /* local shortcut variables */
   vtemp   = x;    /* use result as temporary vector */
@@ -477,6 +502,7 @@ static int AndersonAccelerate(SUNNonlinearSolver NLS, N_Vector gval,
   fv      = FP_CONTENT(NLS)->delta;
   damping = FP_CONTENT(NLS)->damping;
   beta    = FP_CONTENT(NLS)->beta;
+  qradd   = FP_CONTENT(NLS)->qradd;
 
   /* reset ipt_map, i_pt */
   for (i = 0; i < maa; i++)  ipt_map[i]=0;
@@ -499,27 +525,11 @@ static int AndersonAccelerate(SUNNonlinearSolver NLS, N_Vector gval,
 
   /* update data structures based on current iteration index */
 
-  if (iter == 1) {   /* second iteration */
-
-    R[0] = SUNRsqrt( N_VDotProd(df[i_pt], df[i_pt]) );
-    N_VScale(ONE/R[0], df[i_pt], Q[i_pt]);
-    ipt_map[0] = 0;
-
-  } else if (iter <= maa) {   /* another iteration before we've reached maa */
+  if (iter <= maa) {   /* another iteration before we've reached maa */
 
-    N_VScale(ONE, df[i_pt], vtemp);
-    for (j = 0; j < iter-1; j++) {
-      ipt_map[j] = j;
-      R[(iter-1)*maa+j] = N_VDotProd(Q[j], vtemp);
-      N_VLinearSum(ONE, vtemp, -R[(iter-1)*maa+j], Q[j], vtemp);
-    }
-    R[(iter-1)*maa+iter-1] = SUNRsqrt( N_VDotProd(vtemp, vtemp) );
-    if (R[(iter-1)*maa+iter-1] == ZERO) {
-      N_VScale(ZERO, vtemp, Q[i_pt]);
-    } else {
-      N_VScale((ONE/R[(iter-1)*maa+iter-1]), vtemp, Q[i_pt]);
-    }
-    ipt_map[iter-1] = iter-1;
+    for (j = 0; j < iter; j++)  ipt_map[j] = j;
+    retval = qradd(Q, R, df[i_pt], iter-1, maa, cvals, Xvecs);
+    if (retval != 0)  return(SUN_NLS_VECTOROP_ERR);
 
   } else {   /* we've filled the acceleration subspace, so start recycling */
 
@@ -552,13 +562,8 @@ static int AndersonAccelerate(SUNNonlinearSolver NLS, N_Vector gval,
         R[(i-1)*maa + j] = R[i*maa + j];
 
     /* add the new df vector */
-    N_VScale(ONE, df[i_pt], vtemp);
-    for (j = 0; j < maa-1; j++) {
-      R[(maa-1)*maa+j] = N_VDotProd(Q[j], vtemp);
-      N_VLinearSum(ONE, vtemp, -R[(maa-1)*maa+j], Q[j], vtemp);
-    }
-    R[(maa-1)*maa+maa-1] = SUNRsqrt( N_VDotProd(vtemp, vtemp) );
-    N_VScale((ONE/R[(maa-1)*maa+maa-1]), vtemp, Q[maa-1]);
+    retval = qradd(Q, R, df[i_pt], maa-1, maa, cvals, Xvecs);
+    if (retval != 0)  return(SUN_NLS_VECTOROP_ERR);
 
     /* update the iteration map */
     j = 0;
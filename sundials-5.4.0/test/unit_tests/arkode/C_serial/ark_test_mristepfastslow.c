@@ -0,0 +1,366 @@
+/* -----------------------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------------------
+ * Unit test and benchmark for MRIStepCreateFastSlow
+ *
+ * The two-rate problem
+ *
+ *   u' = -lambda (u - v)           (fast partition)
+ *   v' = -u v + cos(t)             (slow partition)
+ *
+ * is integrated to Tf with the multirate driver for a sequence of slow step
+ * sizes, the fast partition is integrated by the inner ARKStep integrator with
+ * tight tolerances (explicitly for the nonstiff split, implicitly for the
+ * stiff split). For the nonstiff split the test fails if the observed order
+ * of the MRI coupling table is more than 0.5 below its nominal order, for
+ * the stiff split the multirate methods show order reduction and the results
+ * are only reported.
+ *
+ * The problem is also integrated with single-rate CVODE (BDF, dense linear
+ * solver) and the number of slow RHS evaluations, the error and the run time
+ * of both integrators are printed. In single rate the slow RHS is evaluated
+ * with every RHS evaluation of the integrator.
+ *
+ * Usage: ark_test_mristepfastslow [table] [stiff]
+ *   table -- MRI coupling table number (default MRI_GARK_ERK33a)
+ *   stiff -- 0: lambda = 20, explicit fast method (default)
+ *            1: lambda = 1e4, implicit fast method
+ * ---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "arkode/arkode_mristep.h"
+#include "arkode/arkode_arkstep.h"
+#include "cvode/cvode.h"
+#include "nvector/nvector_serial.h"
+#include "sunmatrix/sunmatrix_dense.h"
+#include "sunlinsol/sunlinsol_dense.h"
+#include "sundials/sundials_types.h"
+#include "sundials/sundials_math.h"
+
+#if defined(SUNDIALS_EXTENDED_PRECISION)
+#define GSYM "Lg"
+#define ESYM "Le"
+#else
+#define GSYM "g"
+#define ESYM "e"
+#endif
+
+#define ZERO RCONST(0.0)
+#define ONE  RCONST(1.0)
+#define TWO  RCONST(2.0)
+
+/* problem data */
+struct UserDataRec {
+  realtype lambda;  /* fast rate                  */
+  long int nfs;     /* number of slow evaluations */
+};
+typedef struct UserDataRec *UserData;
+
+/* User-supplied Functions Called by the Solver */
+static int ff(realtype t, N_Vector y, N_Vector ydot, void *user_data);
+static int fs(realtype t, N_Vector y, N_Vector ydot, void *user_data);
+static int fall(realtype t, N_Vector y, N_Vector ydot, void *user_data);
+
+/* Private function to check function return values */
+static int check_flag(void *flagvalue, const char *funcname, int opt);
+
+/* Private functions to run the integrators */
+static int run_mri(UserData udata, int table, int implicit, int stiff,
+                   realtype hs, realtype Tf, N_Vector y, double *runtime);
+static int run_cvode(UserData udata, realtype rtol, realtype atol,
+                     realtype Tf, N_Vector y, double *runtime);
+static realtype error_norm(N_Vector y, N_Vector yref);
+
+/* Main Program */
+int main(int argc, char *argv[])
+{
+  realtype T0 = RCONST(0.0);    /* initial time        */
+  realtype Tf = RCONST(2.0);    /* final time          */
+  int      table = MRI_GARK_ERK33a;
+  int      stiff = 0;
+
+  struct UserDataRec udata_rec;
+  UserData udata = &udata_rec;
+
+  MRIStepCoupling MRIC = NULL;
+  N_Vector y = NULL, yref = NULL;
+  realtype hs, err, errold, order, minorder;
+  double   runtime;
+  int      q, i, k, flag, implicit, numfails = 0;
+
+  if (argc > 1) table = atoi(argv[1]);
+  if (argc > 2) stiff = atoi(argv[2]);
+
+  udata->lambda = stiff ? RCONST(1.0e4) : RCONST(20.0);
+
+  MRIC = MRIStepCoupling_LoadTable(table);
+  if (check_flag((void *) MRIC, "MRIStepCoupling_LoadTable", 0)) return(1);
+  q = MRIC->q;
+  implicit = 0;
+  for (k = 0; k < MRIC->nmat; k++)
+    for (i = 0; i < MRIC->stages; i++)
+      if (MRIC->G[k][i][i] != ZERO) implicit = 1;
+  MRIStepCoupling_Free(MRIC);
+
+  y    = N_VNew_Serial(2);
+  yref = N_VNew_Serial(2);
+  if (check_flag((void *) y, "N_VNew_Serial", 0)) return(1);
+  if (check_flag((void *) yref, "N_VNew_Serial", 0)) return(1);
+
+  /* reference solution */
+  NV_Ith_S(yref,0) = TWO;
+  NV_Ith_S(yref,1) = TWO;
+  flag = run_cvode(udata, RCONST(1.0e-12), RCONST(1.0e-14), Tf - T0, yref,
+                   &runtime);
+  if (check_flag(&flag, "run_cvode", 1)) return(1);
+
+  printf("\nMRIStep fast/slow test: table %d (order %d), lambda = %"GSYM"\n",
+         table, q, udata->lambda);
+  printf("  %10s %14s %8s %10s %10s\n", "hs", "error", "order", "slow evals",
+         "time [s]");
+
+  /* convergence of the multirate method */
+  hs       = RCONST(0.1);
+  errold   = ZERO;
+  minorder = q - RCONST(0.5);
+  for (i = 0; i < 4; i++) {
+    NV_Ith_S(y,0) = TWO;
+    NV_Ith_S(y,1) = TWO;
+    udata->nfs = 0;
+    flag = run_mri(udata, table, implicit, stiff, hs, Tf - T0, y, &runtime);
+    if (check_flag(&flag, "run_mri", 1)) return(1);
+
+    err = error_norm(y, yref);
+    if (i > 0) {
+      order = log(errold/err)/log(TWO);
+      printf("  %10.4"GSYM" %14.6"ESYM" %8.3"GSYM" %10ld %10.4f\n", hs, err,
+             order, udata->nfs, runtime);
+      if (!stiff && order < minorder) numfails++;
+    } else {
+      printf("  %10.4"GSYM" %14.6"ESYM" %8s %10ld %10.4f\n", hs, err, "-",
+             udata->nfs, runtime);
+    }
+    errold = err;
+    hs    /= TWO;
+  }
+
+  /* single-rate CVODE for comparison */
+  NV_Ith_S(y,0) = TWO;
+  NV_Ith_S(y,1) = TWO;
+  udata->nfs = 0;
+  flag = run_cvode(udata, RCONST(1.0e-7), RCONST(1.0e-9), Tf - T0, y,
+                   &runtime);
+  if (check_flag(&flag, "run_cvode", 1)) return(1);
+  printf("  %10s %14.6"ESYM" %8s %10ld %10.4f  (single-rate CVODE)\n",
+         "-", error_norm(y, yref), "-", udata->nfs, runtime);
+
+  if (numfails)
+    printf("\nFAIL: observed order below %"GSYM"\n", minorder);
+  else
+    printf("\nSUCCESS\n");
+
+  N_VDestroy(y);
+  N_VDestroy(yref);
+
+  return(numfails);
+}
+
+/* -----------------------------------------------------------------------------
+ * Functions called by the solver
+ * ---------------------------------------------------------------------------*/
+
+static int ff(realtype t, N_Vector y, N_Vector ydot, void *user_data)
+{
+  UserData udata = (UserData) user_data;
+  NV_Ith_S(ydot,0) = -udata->lambda * (NV_Ith_S(y,0) - NV_Ith_S(y,1));
+  NV_Ith_S(ydot,1) = ZERO;
+  return(0);
+}
+
+static int fs(realtype t, N_Vector y, N_Vector ydot, void *user_data)
+{
+  UserData udata = (UserData) user_data;
+  NV_Ith_S(ydot,0) = ZERO;
+  NV_Ith_S(ydot,1) = -NV_Ith_S(y,0) * NV_Ith_S(y,1) + cos(t);
+  udata->nfs++;
+  return(0);
+}
+
+static int fall(realtype t, N_Vector y, N_Vector ydot, void *user_data)
+{
+  UserData udata = (UserData) user_data;
+  NV_Ith_S(ydot,0) = -udata->lambda * (NV_Ith_S(y,0) - NV_Ith_S(y,1));
+  NV_Ith_S(ydot,1) = -NV_Ith_S(y,0) * NV_Ith_S(y,1) + cos(t);
+  udata->nfs++;
+  return(0);
+}
+
+/* -----------------------------------------------------------------------------
+ * Private helper functions
+ * ---------------------------------------------------------------------------*/
+
+static int run_mri(UserData udata, int table, int implicit, int stiff,
+                   realtype hs, realtype Tf, N_Vector y, double *runtime)
+{
+  void            *arkode_mem = NULL;
+  void            *inner_mem  = NULL;
+  SUNMatrix        A  = NULL, As  = NULL;
+  SUNLinearSolver  LS = NULL, LSs = NULL;
+  realtype         t;
+  clock_t          start;
+  int              flag;
+
+  start = clock();
+
+  if (stiff)
+    arkode_mem = MRIStepCreateFastSlow(fs, NULL, ff, ZERO, y);
+  else
+    arkode_mem = MRIStepCreateFastSlow(fs, ff, NULL, ZERO, y);
+  if (check_flag((void *) arkode_mem, "MRIStepCreateFastSlow", 0)) return(-1);
+
+  flag = MRIStepSetUserData(arkode_mem, (void *) udata);
+  if (check_flag(&flag, "MRIStepSetUserData", 1)) return(-1);
+
+  flag = MRIStepSetTableNum(arkode_mem, table);
+  if (check_flag(&flag, "MRIStepSetTableNum", 1)) return(-1);
+
+  flag = MRIStepSetFixedStep(arkode_mem, hs);
+  if (check_flag(&flag, "MRIStepSetFixedStep", 1)) return(-1);
+
+  flag = MRIStepSetMaxNumSteps(arkode_mem, 100000);
+  if (check_flag(&flag, "MRIStepSetMaxNumSteps", 1)) return(-1);
+
+  /* solve-decoupled implicit tables need a slow linear solver */
+  if (implicit) {
+    flag = MRIStepSStolerances(arkode_mem, RCONST(1.0e-10), RCONST(1.0e-12));
+    if (check_flag(&flag, "MRIStepSStolerances", 1)) return(-1);
+    As  = SUNDenseMatrix(2, 2);
+    LSs = SUNLinSol_Dense(y, As);
+    if (check_flag((void *) LSs, "SUNLinSol_Dense", 0)) return(-1);
+    flag = MRIStepSetLinearSolver(arkode_mem, LSs, As);
+    if (check_flag(&flag, "MRIStepSetLinearSolver", 1)) return(-1);
+  }
+
+  /* the fast integrator is configured through the ARKStep interface */
+  flag = MRIStepGetInnerStepper(arkode_mem, &inner_mem);
+  if (check_flag(&flag, "MRIStepGetInnerStepper", 1)) return(-1);
+
+  flag = ARKStepSStolerances(inner_mem, RCONST(1.0e-12), RCONST(1.0e-14));
+  if (check_flag(&flag, "ARKStepSStolerances", 1)) return(-1);
+
+  flag = ARKStepSetMaxNumSteps(inner_mem, 1000000);
+  if (check_flag(&flag, "ARKStepSetMaxNumSteps", 1)) return(-1);
+
+  if (stiff) {
+    A  = SUNDenseMatrix(2, 2);
+    LS = SUNLinSol_Dense(y, A);
+    if (check_flag((void *) LS, "SUNLinSol_Dense", 0)) return(-1);
+    flag = ARKStepSetLinearSolver(inner_mem, LS, A);
+    if (check_flag(&flag, "ARKStepSetLinearSolver", 1)) return(-1);
+    flag = ARKStepSetLinear(inner_mem, 0);
+    if (check_flag(&flag, "ARKStepSetLinear", 1)) return(-1);
+  }
+
+  flag = MRIStepEvolve(arkode_mem, Tf, y, &t, ARK_NORMAL);
+  if (check_flag(&flag, "MRIStepEvolve", 1)) return(-1);
+
+  *runtime = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  MRIStepFree(&arkode_mem);
+  if (LS)  SUNLinSolFree(LS);
+  if (A)   SUNMatDestroy(A);
+  if (LSs) SUNLinSolFree(LSs);
+  if (As)  SUNMatDestroy(As);
+
+  return(0);
+}
+
+static int run_cvode(UserData udata, realtype rtol, realtype atol,
+                     realtype Tf, N_Vector y, double *runtime)
+{
+  void            *cvode_mem = NULL;
+  SUNMatrix        A  = NULL;
+  SUNLinearSolver  LS = NULL;
+  realtype         t;
+  clock_t          start;
+  int              flag;
+
+  start = clock();
+
+  cvode_mem = CVodeCreate(CV_BDF);
+  if (check_flag((void *) cvode_mem, "CVodeCreate", 0)) return(-1);
+
+  flag = CVodeInit(cvode_mem, fall, ZERO, y);
+  if (check_flag(&flag, "CVodeInit", 1)) return(-1);
+
+  flag = CVodeSetUserData(cvode_mem, (void *) udata);
+  if (check_flag(&flag, "CVodeSetUserData", 1)) return(-1);
+
+  flag = CVodeSStolerances(cvode_mem, rtol, atol);
+  if (check_flag(&flag, "CVodeSStolerances", 1)) return(-1);
+
+  flag = CVodeSetMaxNumSteps(cvode_mem, 1000000);
+  if (check_flag(&flag, "CVodeSetMaxNumSteps", 1)) return(-1);
+
+  A  = SUNDenseMatrix(2, 2);
+  LS = SUNLinSol_Dense(y, A);
+  if (check_flag((void *) LS, "SUNLinSol_Dense", 0)) return(-1);
+
+  flag = CVodeSetLinearSolver(cvode_mem, LS, A);
+  if (check_flag(&flag, "CVodeSetLinearSolver", 1)) return(-1);
+
+  flag = CVode(cvode_mem, Tf, y, &t, CV_NORMAL);
+  if (check_flag(&flag, "CVode", 1)) return(-1);
+
+  *runtime = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  CVodeFree(&cvode_mem);
+  SUNLinSolFree(LS);
+  SUNMatDestroy(A);
+
+  return(0);
+}
+
+static realtype error_norm(N_Vector y, N_Vector yref)
+{
+  realtype e0 = NV_Ith_S(y,0) - NV_Ith_S(yref,0);
+  realtype e1 = NV_Ith_S(y,1) - NV_Ith_S(yref,1);
+  return(SUNRsqrt(e0*e0 + e1*e1));
+}
+
+/* Check function return value
+     opt == 0 means the function allocates memory and returns a
+              pointer so check if a NULL pointer was returned
+     opt == 1 means the function returns an integer where a
+              value < 0 indicates an error occured */
+static int check_flag(void *flagvalue, const char *funcname, int opt)
+{
+  int *errflag;
+
+  if (opt == 0 && flagvalue == NULL) {
+    fprintf(stderr, "\nERROR: %s() failed - returned NULL pointer\n\n",
+            funcname);
+    return(1);
+  }
+  else if (opt == 1) {
+    errflag = (int *) flagvalue;
+    if (*errflag < 0) {
+      fprintf(stderr, "\nERROR: %s() returned %d\n\n", funcname, *errflag);
+      return(1);
+    }
+  }
+
+  return(0);
+}
@@ -0,0 +1,304 @@
+/* -----------------------------------------------------------------------------
+ * SUNDIALS Copyright Start
+ * Copyright (c) 2002-2020, Lawrence Livermore National Security
+ * and Southern Methodist University.
+ * All rights reserved.
+ *
+ * See the top-level LICENSE and NOTICE files for details.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SUNDIALS Copyright End
+ * -----------------------------------------------------------------------------
+ * Unit test for the ARKODE Parareal driver
+ *
+ * The damped nonlinear oscillator
+ *
+ *   u' = -v
+ *   v' =  u - c v + d sin(u)
+ *
+ * is integrated over [0, Tf] with the Parareal driver. The fine integrators
+ * take fixed steps (explicit ERK, or DIRK with a dense linear solver), the
+ * coarse integrator takes a few fixed steps per slice with a low order method.
+ * The reference is the fine integrator run serially across the same slices.
+ *
+ * The test fails if the driver does not converge, if the final solution is
+ * not within the iteration tolerance of the reference, or if a solve with a
+ * tolerance below roundoff does not reproduce the reference.
+ *
+ * Usage: ark_test_parareal [nslices] [implicit] [nthreads]
+ * ---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "arkode/arkode_arkstep.h"
+#include "arkode/arkode_parareal.h"
+#include "nvector/nvector_serial.h"
+#include "sunmatrix/sunmatrix_dense.h"
+#include "sunlinsol/sunlinsol_dense.h"
+#include "sundials/sundials_types.h"
+#include "sundials/sundials_math.h"
+
+#if defined(SUNDIALS_EXTENDED_PRECISION)
+#define GSYM "Lg"
+#define ESYM "Le"
+#else
+#define GSYM "g"
+#define ESYM "e"
+#endif
+
+#define ZERO RCONST(0.0)
+#define ONE  RCONST(1.0)
+
+#define MAXINT 64
+
+/* problem data */
+struct UserDataRec {
+  int      implicit;  /* DIRK fine integrator */
+  realtype hfine;     /* fine step size       */
+
+  /* linear solvers of the integrators, freed with them */
+  int             nint;
+  void           *mem[MAXINT];
+  SUNMatrix       A[MAXINT];
+  SUNLinearSolver LS[MAXINT];
+};
+typedef struct UserDataRec *UserData;
+
+/* User-supplied Functions Called by the Solver */
+static int f(realtype t, N_Vector y, N_Vector ydot, void *user_data);
+
+/* Parareal integrator setup */
+static void* create_integrator(realtype t0, N_Vector y0, booleantype coarse,
+                               void *user_data);
+static void free_integrator(void **arkode_mem, void *user_data);
+
+/* Private function to check function return values */
+static int check_flag(void *flagvalue, const char *funcname, int opt);
+
+/* Main Program */
+int main(int argc, char *argv[])
+{
+  realtype T0   = RCONST(0.0);
+  realtype Tf   = RCONST(40.0);
+  realtype rtol = RCONST(1.0e-8);
+  realtype atol = RCONST(1.0e-10);
+  int nslices   = 16;
+  int nthreads  = 0;
+
+  struct UserDataRec udata_rec;
+  UserData udata = &udata_rec;
+
+  void *arkode_mem = NULL, *pr_mem = NULL;
+  N_Vector y = NULL, yref = NULL, yout = NULL;
+  realtype t, ta, tb, err, norms[256];
+  long int nfine, ncoarse;
+  int n, k, niters, flag, numfails = 0;
+
+  if (argc > 1) nslices = atoi(argv[1]);
+  if (argc > 2) udata->implicit = atoi(argv[2]); else udata->implicit = 0;
+  if (argc > 3) nthreads = atoi(argv[3]);
+  if (nslices < 1 || nslices > 256) nslices = 16;
+
+  udata->hfine = RCONST(0.005);
+  udata->nint  = 0;
+
+  y    = N_VNew_Serial(2);
+  yref = N_VNew_Serial(2);
+  yout = N_VNew_Serial(2);
+  if (check_flag((void *) y, "N_VNew_Serial", 0)) return(1);
+  if (check_flag((void *) yref, "N_VNew_Serial", 0)) return(1);
+  if (check_flag((void *) yout, "N_VNew_Serial", 0)) return(1);
+
+  NV_Ith_S(y,0) = ONE;
+  NV_Ith_S(y,1) = ZERO;
+
+  printf("\nParareal test: %d slices, %s fine integrator\n", nslices,
+         udata->implicit ? "DIRK" : "ERK");
+
+  /* serial reference across the same slices */
+  arkode_mem = create_integrator(T0, y, SUNFALSE, udata);
+  if (check_flag(arkode_mem, "create_integrator", 0)) return(1);
+  N_VScale(ONE, y, yref);
+  for (n = 0; n < nslices; n++) {
+    ta = T0 + (Tf - T0) * n / nslices;
+    tb = (n+1 == nslices) ? Tf : T0 + (Tf - T0) * (n+1) / nslices;
+    flag = ARKStepReset(arkode_mem, ta, yref);
+    if (check_flag(&flag, "ARKStepReset", 1)) return(1);
+    flag = ARKStepSetStopTime(arkode_mem, tb);
+    if (check_flag(&flag, "ARKStepSetStopTime", 1)) return(1);
+    flag = ARKStepEvolve(arkode_mem, tb, yref, &t, ARK_NORMAL);
+    if (check_flag(&flag, "ARKStepEvolve", 1)) return(1);
+  }
+  free_integrator(&arkode_mem, udata);
+
+  /* Parareal solve to the iteration tolerance */
+  pr_mem = ARKParareal_Create(create_integrator, free_integrator, udata,
+                              T0, Tf, y, nslices);
+  if (check_flag(pr_mem, "ARKParareal_Create", 0)) return(1);
+  flag = ARKParareal_SetNumThreads(pr_mem, nthreads);
+  if (check_flag(&flag, "ARKParareal_SetNumThreads", 1)) return(1);
+  flag = ARKParareal_SetCoarseSteps(pr_mem, 8);
+  if (check_flag(&flag, "ARKParareal_SetCoarseSteps", 1)) return(1);
+  flag = ARKParareal_SetTolerances(pr_mem, rtol, atol);
+  if (check_flag(&flag, "ARKParareal_SetTolerances", 1)) return(1);
+
+  flag = ARKParareal_Evolve(pr_mem, yout);
+  if (check_flag(&flag, "ARKParareal_Evolve", 1)) numfails++;
+
+  flag = ARKParareal_GetNumIterations(pr_mem, &niters);
+  if (check_flag(&flag, "ARKParareal_GetNumIterations", 1)) return(1);
+  flag = ARKParareal_GetCorrectionNorms(pr_mem, norms);
+  if (check_flag(&flag, "ARKParareal_GetCorrectionNorms", 1)) return(1);
+  flag = ARKParareal_GetNumSteps(pr_mem, &nfine, &ncoarse);
+  if (check_flag(&flag, "ARKParareal_GetNumSteps", 1)) return(1);
+
+  for (k = 0; k < niters; k++)
+    printf("  iteration %2d: correction norm = %.3"ESYM"\n", k+1, norms[k]);
+
+  N_VLinearSum(ONE, yout, -ONE, yref, yout);
+  err = N_VMaxNorm(yout);
+  printf("  iterations = %d, fine steps = %li, coarse steps = %li\n",
+         niters, nfine, ncoarse);
+  printf("  max error vs serial fine = %.3"ESYM"\n", err);
+
+  if (niters >= nslices && nslices > 2) {
+    printf("  FAIL: no convergence before the exact iteration\n");
+    numfails++;
+  }
+  if (err > RCONST(100.0) * (rtol * N_VMaxNorm(yref) + atol)) {
+    printf("  FAIL: error above the iteration tolerance\n");
+    numfails++;
+  }
+
+  /* with a tolerance far below roundoff the iteration runs until it is exact */
+  flag = ARKParareal_SetTolerances(pr_mem, ZERO,
+                                   UNIT_ROUNDOFF * UNIT_ROUNDOFF);
+  if (check_flag(&flag, "ARKParareal_SetTolerances", 1)) return(1);
+  flag = ARKParareal_Evolve(pr_mem, yout);
+  if (check_flag(&flag, "ARKParareal_Evolve", 1)) numfails++;
+  flag = ARKParareal_GetNumIterations(pr_mem, &niters);
+  if (check_flag(&flag, "ARKParareal_GetNumIterations", 1)) return(1);
+
+  N_VLinearSum(ONE, yout, -ONE, yref, yout);
+  err = N_VMaxNorm(yout);
+  printf("  exact solve: iterations = %d, max error = %.3"ESYM"\n",
+         niters, err);
+  if (err > RCONST(100.0) * UNIT_ROUNDOFF) {
+    printf("  FAIL: exact solve does not match the serial fine solution\n");
+    numfails++;
+  }
+
+  ARKParareal_Free(&pr_mem);
+  N_VDestroy(y);
+  N_VDestroy(yref);
+  N_VDestroy(yout);
+
+  if (numfails)
+    printf("\nFAIL: %d check(s) failed\n", numfails);
+  else
+    printf("\nSUCCESS\n");
+
+  return(numfails);
+}
+
+/* ----------------------------------------------------------------------------
+ * Functions called by the solver
+ * --------------------------------------------------------------------------*/
+
+static int f(realtype t, N_Vector y, N_Vector ydot, void *user_data)
+{
+  realtype u = NV_Ith_S(y,0);
+  realtype v = NV_Ith_S(y,1);
+
+  NV_Ith_S(ydot,0) = -v;
+  NV_Ith_S(ydot,1) = u - RCONST(0.1) * v + RCONST(0.2) * sin(u);
+
+  return(0);
+}
+
+/* Fine: fixed step ERK or DIRK, coarse: Heun-Euler or SDIRK 2 with 8 steps */
+static void* create_integrator(realtype t0, N_Vector y0, booleantype coarse,
+                               void *user_data)
+{
+  UserData udata = (UserData) user_data;
+  SUNMatrix A;
+  SUNLinearSolver LS;
+  void *arkode_mem;
+
+  if (udata->implicit) {
+    arkode_mem = ARKStepCreate(NULL, f, t0, y0);
+    if (arkode_mem == NULL) return(NULL);
+    if (udata->nint == MAXINT) return(NULL);
+    A  = SUNDenseMatrix(2, 2);
+    LS = SUNLinSol_Dense(y0, A);
+    udata->mem[udata->nint] = arkode_mem;
+    udata->A[udata->nint]   = A;
+    udata->LS[udata->nint]  = LS;
+    udata->nint++;
+    if (ARKStepSetLinearSolver(arkode_mem, LS, A)) return(NULL);
+    if (ARKStepSStolerances(arkode_mem, RCONST(1.0e-10), RCONST(1.0e-12)))
+      return(NULL);
+    if (ARKStepSetMaxNonlinIters(arkode_mem, 10)) return(NULL);
+    if (coarse && ARKStepSetTableNum(arkode_mem, SDIRK_2_1_2, -1))
+      return(NULL);
+  } else {
+    arkode_mem = ARKStepCreate(f, NULL, t0, y0);
+    if (arkode_mem == NULL) return(NULL);
+    if (coarse && ARKStepSetTableNum(arkode_mem, -1, HEUN_EULER_2_1_2))
+      return(NULL);
+  }
+
+  /* the driver sets the coarse step size */
+  if (!coarse) {
+    if (ARKStepSetFixedStep(arkode_mem, udata->hfine)) return(NULL);
+    if (ARKStepSetMaxNumSteps(arkode_mem, 100000)) return(NULL);
+  }
+
+  return(arkode_mem);
+}
+
+/* Free the integrator with its linear solver and matrix */
+static void free_integrator(void **arkode_mem, void *user_data)
+{
+  UserData udata = (UserData) user_data;
+  int i;
+
+  for (i = 0; i < udata->nint; i++) {
+    if (udata->mem[i] != *arkode_mem) continue;
+    SUNLinSolFree(udata->LS[i]);
+    SUNMatDestroy(udata->A[i]);
+    udata->nint--;
+    udata->mem[i] = udata->mem[udata->nint];
+    udata->A[i]   = udata->A[udata->nint];
+    udata->LS[i]  = udata->LS[udata->nint];
+    break;
+  }
+  ARKStepFree(arkode_mem);
+}
+
+/* Check function return value */
+static int check_flag(void *flagvalue, const char *funcname, int opt)
+{
+  int *errflag;
+
+  /* Check if function returned NULL pointer - no memory allocated */
+  if (opt == 0 && flagvalue == NULL) {
+    fprintf(stderr, "\nERROR: %s() failed - returned NULL pointer\n\n",
+            funcname);
+    return(1);
+  }
+
+  /* Check if flag < 0 */
+  if (opt == 1) {
+    errflag = (int *) flagvalue;
+    if (*errflag < 0) {
+      fprintf(stderr, "\nERROR: %s() failed with flag = %d\n\n",
+              funcname, *errflag);
+      return(1);
+    }
+  }
+
+  return(0);
+}
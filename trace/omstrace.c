@@ -0,0 +1,217 @@
+/* omstrace.c -- Chrome trace events of the 3rd-party components
+ *
+ * Each thread appends its events to a buffer of its own, a list of
+ * chunks that only grows, and publishes the number of events with a
+ * release store after writing them. The buffers are linked into a global
+ * list by a compare-and-swap when a thread records its first event and
+ * are kept until the process exits, so that omstrace_write() also finds
+ * the events of finished threads. The writer reads each buffer up to its
+ * published count while the threads go on recording.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "omstrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define CHUNK_EVENTS 4096               /* events per chunk of a buffer */
+#ifndef OMSTRACE_MAX_EVENTS
+#define OMSTRACE_MAX_EVENTS (1L << 22)  /* events kept per thread, the later ones are dropped */
+#endif
+
+typedef struct {
+    const char *category;
+    const char *name;
+    unsigned long long ts;              /* monotonic clock [ns] */
+    char phase;                         /* 'B', 'E' or 'i' */
+} event;
+
+typedef struct chunk {
+    event events[CHUNK_EVENTS];
+    struct chunk *next;
+} chunk;
+
+typedef struct buffer {
+    struct buffer *next;                /* in the list of all buffers */
+    long tid;
+    chunk *first;
+    chunk *last;                        /* only used by the owning thread */
+    long count;                         /* events published, written with release */
+} buffer;
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+/* /volatile:ms gives volatile accesses acquire and release semantics */
+#define LOAD_ACQUIRE(p)         (*(volatile long *)(p))
+#define STORE_RELEASE(p, v)     (*(volatile long *)(p) = (v))
+#define LOAD_PTR_ACQUIRE(p)     (*(void * volatile *)(p))
+#define CAS_PTR(p, old, new)    (InterlockedCompareExchangePointer((PVOID volatile *)(p), (new), (old)) == (old))
+#define FETCH_ADD(p, v)         InterlockedExchangeAdd((volatile LONG *)(p), (v))
+#else
+#define THREAD_LOCAL __thread
+#define LOAD_ACQUIRE(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define LOAD_PTR_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define CAS_PTR(p, old, new)    __atomic_compare_exchange_n((p), &(old), (new), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define FETCH_ADD(p, v)         __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#endif
+
+static buffer *buffers = NULL;          /* all buffers, pushed at the head */
+static long nextTid = 0;
+static long atexitRegistered = 0;
+static THREAD_LOCAL buffer *threadBuffer = NULL;
+
+static unsigned long long now(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)(counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+           (unsigned long long)(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / (unsigned long long)frequency.QuadPart;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long)t.tv_sec * 1000000000ULL + (unsigned long long)t.tv_nsec;
+#endif
+}
+
+static void writeAtExit(void)
+{
+    const char *filename = getenv("OMS_TRACE_FILE");
+    if (filename != NULL && *filename != '\0')
+        omstrace_write(filename);
+}
+
+/* the buffer of the calling thread, created and linked on its first event */
+static buffer *getBuffer(void)
+{
+    buffer *b = threadBuffer;
+    buffer *head;
+
+    if (b != NULL)
+        return b;
+    b = (buffer *)calloc(1, sizeof(buffer));
+    if (b == NULL)
+        return NULL;
+    b->first = b->last = (chunk *)calloc(1, sizeof(chunk));
+    if (b->first == NULL) {
+        free(b);
+        return NULL;
+    }
+    b->tid = FETCH_ADD(&nextTid, 1) + 1;
+    if (FETCH_ADD(&atexitRegistered, 1) == 0)
+        atexit(writeAtExit);
+    do {
+        /* reloaded on every try, CAS_PTR does not update head on MSVC */
+        head = (buffer *)LOAD_PTR_ACQUIRE(&buffers);
+        b->next = head;
+    } while (!CAS_PTR(&buffers, head, b));
+    threadBuffer = b;
+    return b;
+}
+
+static void record(const char *category, const char *name, char phase)
+{
+    buffer *b = getBuffer();
+    long count;
+    event *e;
+
+    if (b == NULL || b->count >= OMSTRACE_MAX_EVENTS)
+        return;
+    count = b->count;
+    if (count > 0 && count % CHUNK_EVENTS == 0) {
+        chunk *c = (chunk *)calloc(1, sizeof(chunk));
+        if (c == NULL)
+            return;
+        b->last->next = c;  /* published by the release store of count below */
+        b->last = c;
+    }
+    e = &b->last->events[count % CHUNK_EVENTS];
+    e->category = category;
+    e->name = name;
+    e->ts = now();
+    e->phase = phase;
+    STORE_RELEASE(&b->count, count + 1);
+}
+
+void omstrace_begin(const char *category, const char *name)
+{
+    record(category, name, 'B');
+}
+
+void omstrace_end(const char *category, const char *name)
+{
+    record(category, name, 'E');
+}
+
+void omstrace_instant(const char *category, const char *name)
+{
+    record(category, name, 'i');
+}
+
+static void writeString(FILE *file, const char *s)
+{
+    fputc('"', file);
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+int omstrace_write(const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    const buffer *b;
+    const char *separator = "\n";
+    long pid;
+    int ok;
+
+    if (file == NULL)
+        return -1;
+#ifdef _WIN32
+    pid = (long)GetCurrentProcessId();
+#else
+    pid = (long)getpid();
+#endif
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    for (b = (const buffer *)LOAD_PTR_ACQUIRE(&buffers); b != NULL; b = b->next) {
+        long count = LOAD_ACQUIRE(&b->count);
+        const chunk *c = b->first;
+        long i;
+
+        for (i = 0; i < count; i++) {
+            const event *e;
+            if (i > 0 && i % CHUNK_EVENTS == 0)
+                c = c->next;
+            e = &c->events[i % CHUNK_EVENTS];
+            fprintf(file, "%s{\"name\":", separator);
+            writeString(file, e->name);
+            fputs(",\"cat\":", file);
+            writeString(file, e->category);
+            fprintf(file, ",\"ph\":\"%c\",\"ts\":%llu.%03llu,\"pid\":%ld,\"tid\":%ld%s}",
+                    e->phase, e->ts / 1000, e->ts % 1000, pid, b->tid,
+                    e->phase == 'i' ? ",\"s\":\"t\"" : "");
+            separator = ",\n";
+        }
+    }
+    fputs("\n]}\n", file);
+    ok = !ferror(file);
+    return (fclose(file) == 0 && ok) ? 0 : -1;
+}
@@ -0,0 +1,70 @@
+/* omstrace.h -- Chrome trace events of the 3rd-party components
+ *
+ * The components record the begin and end of their main phases (loading
+ * FMUs, extracting archives, scanning XML documents, running pool tasks,
+ * solver steps) into one timeline, written as Chrome trace JSON that
+ * chrome://tracing and https://ui.perfetto.dev open.
+ *
+ * Every thread records into its own buffer, without locks; the buffers
+ * are written by omstrace_write(), or at exit into the file named by the
+ * environment variable OMS_TRACE_FILE. Names and categories are not
+ * copied and must be string literals.
+ *
+ * The recording is compiled in only when OMS_TRACE is defined, which the
+ * CMake option OMS_TRACE does for the components linking oms_trace. The
+ * components include this header under #ifdef OMS_TRACE and otherwise
+ * define the OMS_TRACE_* macros they use as empty.
+ */
+
+#ifndef OMSTRACE_H
+#define OMSTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Open a region of the calling thread, closed by omstrace_end() */
+void omstrace_begin(const char *category, const char *name);
+void omstrace_end(const char *category, const char *name);
+
+/* Mark a point in time on the calling thread */
+void omstrace_instant(const char *category, const char *name);
+
+/* Write the events recorded so far by all threads to filename,
+   returns 0 on success and -1 if the file can not be written */
+int omstrace_write(const char *filename);
+
+#ifdef __cplusplus
+}
+
+namespace omstrace {
+    // a region lasting until the end of the enclosing scope, also when leaving it by an exception
+    class Scope {
+    public:
+        Scope(const char *category, const char *name) : category(category), name(name) {
+            omstrace_begin(category, name);
+        }
+        ~Scope() { omstrace_end(this->category, this->name); }
+
+    private:
+        Scope(const Scope &);  // = delete;
+        Scope & operator=(const Scope &);  // = delete;
+
+        const char *category;
+        const char *name;
+    };
+}
+#endif
+
+#define OMS_TRACE_BEGIN(category, name)     omstrace_begin(category, name)
+#define OMS_TRACE_END(category, name)       omstrace_end(category, name)
+#define OMS_TRACE_INSTANT(category, name)   omstrace_instant(category, name)
+
+#ifdef __cplusplus
+#define OMS_TRACE_CONCAT_(a, b)             a##b
+#define OMS_TRACE_CONCAT(a, b)              OMS_TRACE_CONCAT_(a, b)
+#define OMS_TRACE_SCOPE(category, name) \
+    omstrace::Scope OMS_TRACE_CONCAT(omstrace_scope_, __LINE__)(category, name)
+#endif
+
+#endif /* OMSTRACE_H */
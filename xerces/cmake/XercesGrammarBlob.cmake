@@ -0,0 +1,62 @@
+# CMake build for xerces-c
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.
+# The ASF licenses this file to You under the Apache License, Version 2.0
+# (the "License"); you may not use this file except in compliance with
+# the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Serialized grammar blobs compiled into a target
+#
+#   xerces_add_grammar_blob(<target> NAME <symbol> SCHEMAS <xsd>... [DEPENDS <file>...])
+#
+# Runs xerces-grammar-compiler at build time: the schemas are loaded into a
+# grammar pool, serialized and written as the byte array <symbol> into
+# <symbol>.cpp, which is added to the sources of <target>. <symbol>.hpp
+# declares the array and its size <symbol>Size, the application loads the
+# grammars with
+#
+#   pool->loadSerializedGrammars(<symbol>, <symbol>Size);
+#
+# The schemas imported or included by SCHEMAS should be listed as DEPENDS so
+# that the blob is rebuilt when they change. The blob is tied to the Xerces-C
+# version it was compiled with; the compiler runs on the build machine, so
+# this does not work when cross-compiling.
+
+function(xerces_add_grammar_blob target)
+  cmake_parse_arguments(blob "" "NAME" "SCHEMAS;DEPENDS" ${ARGN})
+
+  if(NOT blob_NAME OR NOT blob_SCHEMAS)
+    message(FATAL_ERROR "xerces_add_grammar_blob: NAME and SCHEMAS are required")
+  endif()
+
+  set(schemas)
+  foreach(schema IN LISTS blob_SCHEMAS)
+    get_filename_component(schema "${schema}" ABSOLUTE)
+    list(APPEND schemas "${schema}")
+  endforeach()
+
+  set(blob_dir "${CMAKE_CURRENT_BINARY_DIR}/xerces-grammar-blobs")
+  set(blob_header "${blob_dir}/${blob_NAME}.hpp")
+  set(blob_source "${blob_dir}/${blob_NAME}.cpp")
+
+  add_custom_command(
+    OUTPUT "${blob_header}" "${blob_source}"
+    COMMAND ${CMAKE_COMMAND} -E make_directory "${blob_dir}"
+    COMMAND xerces-grammar-compiler ${blob_NAME} "${blob_header}" "${blob_source}" ${schemas}
+    DEPENDS xerces-grammar-compiler ${schemas} ${blob_DEPENDS}
+    COMMENT "Compiling the grammar blob ${blob_NAME}"
+    VERBATIM)
+
+  target_sources(${target} PRIVATE "${blob_header}" "${blob_source}")
+  target_include_directories(${target} PRIVATE "${blob_dir}")
+endfunction()
@@ -94,6 +94,38 @@ public:
      */
     virtual XMLSize_t getMemoryAllocationBlockSize() const = 0;
 
+    /**
+     * Returns the size up to which the chunks grow: every new chunk is
+     * twice as big as the previous one until it reaches this size
+     *
+     * @return the maximum dimension of the chunks of memory
+     */
+    virtual XMLSize_t getMaxMemoryAllocationBlockSize() const = 0;
+
+    /**
+     * Returns the size above which a request is not carved out of a chunk
+     * but gets a block of its own
+     *
+     * @return the maximum size of the requests served from the chunks
+     */
+    virtual XMLSize_t getMaxSubAllocationSize() const = 0;
+
+    /**
+     * Returns the number of bytes handed out by allocate(), including the
+     * alignment padding
+     *
+     * @return the number of bytes allocated from this memory manager
+     */
+    virtual XMLSize_t getAllocatedMemory() const = 0;
+
+    /**
+     * Returns the number of chunks and individual blocks currently obtained
+     * from the underlying memory manager
+     *
+     * @return the number of blocks
+     */
+    virtual XMLSize_t getMemoryAllocationBlockCount() const = 0;
+
     //@}
 
     //@{
@@ -106,6 +138,22 @@ public:
      * @param size the new size of the chunks; it must be greater than 4KB
      */
     virtual void setMemoryAllocationBlockSize(XMLSize_t size) = 0;
+
+    /**
+     * Set the size up to which the chunks grow; a value smaller than the
+     * current chunk size stops the growth
+     *
+     * @param size the maximum dimension of the chunks
+     */
+    virtual void setMaxMemoryAllocationBlockSize(XMLSize_t size) = 0;
+
+    /**
+     * Set the size above which a request gets a block of its own instead
+     * of being carved out of a chunk; it must be smaller than the chunk size
+     *
+     * @param size the maximum size of the requests served from the chunks
+     */
+    virtual void setMaxSubAllocationSize(XMLSize_t size) = 0;
     //@}
 
     //@{
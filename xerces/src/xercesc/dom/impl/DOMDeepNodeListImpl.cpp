@@ -22,6 +22,7 @@
 #include "DOMDeepNodeListImpl.hpp"
 #include "DOMElementImpl.hpp"
 #include "DOMDocumentImpl.hpp"
+#include "DOMElementIndex.hpp"
 #include "DOMCasts.hpp"
 #include "DOMNodeImpl.hpp"
 #include <xercesc/util/XMLUniDefs.hpp>
@@ -41,6 +42,12 @@ DOMDeepNodeListImpl::DOMDeepNodeListImpl(const DOMNode *rootNode,
     , fNamespaceURI(0)
     , fMatchAllURI(false)
     , fMatchURIandTagname(false)
+    , fMatches(0)
+    , fMatchCount(0)
+    , fMatchCapacity(0)
+    , fMatchChanges(0)
+    , fMatchesValid(false)
+    , fIndexKey(0)
 {
     fTagName = ((DOMDocumentImpl *)(castToNodeImpl(rootNode)->getOwnerDocument()))->getPooledString(tagName);
     fMatchAll = XMLString::equals(fTagName, kAstr);
@@ -57,6 +64,12 @@ DOMDeepNodeListImpl::DOMDeepNodeListImpl(const DOMNode *rootNode,
     , fCurrentIndexPlus1(0)
     , fMatchAllURI(false)
     , fMatchURIandTagname(true)
+    , fMatches(0)
+    , fMatchCount(0)
+    , fMatchCapacity(0)
+    , fMatchChanges(0)
+    , fMatchesValid(false)
+    , fIndexKey(0)
 {
     DOMDocumentImpl* doc = (DOMDocumentImpl *)castToNodeImpl(rootNode)->getOwnerDocument();
 
@@ -73,6 +86,9 @@ DOMDeepNodeListImpl::~DOMDeepNodeListImpl()
 
 XMLSize_t DOMDeepNodeListImpl::getLength() const
 {
+    if (const_cast<DOMDeepNodeListImpl*>(this)->indexMatches())
+        return fMatchCount;
+
     // Reset cache to beginning of list
     item(0);
 
@@ -99,6 +115,9 @@ DOMNode *DOMDeepNodeListImpl::item(XMLSize_t index) const
 // in a parallel tree.
 DOMNode *DOMDeepNodeListImpl::cacheItem(XMLSize_t index)
 {
+    if (indexMatches())
+        return (index < fMatchCount) ? fMatches[index] : 0;
+
     XMLSize_t currentIndexPlus1 = fCurrentIndexPlus1;
     DOMNode *currentNode = fCurrentNode;
 
@@ -152,6 +171,76 @@ DOMNode *DOMDeepNodeListImpl::cacheItem(XMLSize_t index)
 
 
 
+// Collect the matches through the element index of the document, if it
+// has one and the list is not for "*". The index finds the elements with
+// the local part of fTagName below fRootNode in document order; they only
+// need the full name or the namespace checked. Returns false if the tree
+// has to be walked instead.
+bool DOMDeepNodeListImpl::indexMatches()
+{
+    if (fMatchAll)
+        return false;
+
+    DOMDocumentImpl *doc = (DOMDocumentImpl *)castToNodeImpl(fRootNode)->getOwnerDocument();
+    DOMElementIndex *elementIndex = doc->getElementIndex();
+    if (elementIndex == 0)
+    {
+        fMatchesValid = false;
+        return false;
+    }
+
+    int changes = castToParentImpl(fRootNode)->changes();
+    if (fMatchesValid && fMatchChanges == changes)
+        return true;
+
+    if (fIndexKey == 0)
+        fIndexKey = doc->getPooledString(DOMElementIndex::localPart(fTagName));
+
+    DOMElementIndex::Entry* const* entries;
+    XMLSize_t count;
+    if (!elementIndex->find(fRootNode, fIndexKey, entries, count))
+    {
+        fMatchesValid = false;
+        return false;
+    }
+
+    // The document heap does not free, so grow geometrically
+    if (count > fMatchCapacity)
+    {
+        XMLSize_t capacity = fMatchCapacity * 2;
+        if (capacity < count)
+            capacity = count;
+        fMatches = (DOMNode **)doc->allocate(capacity * sizeof(DOMNode *));
+        fMatchCapacity = capacity;
+    }
+
+    fMatchCount = 0;
+    for (XMLSize_t i = 0; i < count; i++)
+    {
+        DOMElement *elem = entries[i]->fElement;
+        if (!fMatchURIandTagname)
+        {
+            if (!XMLString::equals(elem->getTagName(), fTagName))
+                continue;
+        }
+        else
+        {
+            if (!fMatchAllURI &&
+                !XMLString::equals(elem->getNamespaceURI(), fNamespaceURI))
+                continue;
+            if (!XMLString::equals(elem->getLocalName(), fTagName))
+                continue;
+        }
+        fMatches[fMatchCount++] = elem;
+    }
+
+    fMatchChanges = changes;
+    fMatchesValid = true;
+    return true;
+}
+
+
+
 /* Iterative tree-walker. When you have a Parent link, there's often no
 need to resort to recursion. NOTE THAT only Element nodes are matched
 since we're specifically supporting getElementsByTagName().
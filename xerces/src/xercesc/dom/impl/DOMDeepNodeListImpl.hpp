@@ -54,6 +54,15 @@ protected:
     bool	     fMatchAllURI;
     bool             fMatchURIandTagname; //match both namespaceURI and tagName
 
+    // Matches found through the element index of the document, valid while
+    // the document has fMatchChanges changes
+    DOMNode**        fMatches;
+    XMLSize_t        fMatchCount;
+    XMLSize_t        fMatchCapacity;
+    int              fMatchChanges;
+    bool             fMatchesValid;
+    const XMLCh*     fIndexKey;
+
 public:
     DOMDeepNodeListImpl(const DOMNode *rootNode, const XMLCh *tagName);
     DOMDeepNodeListImpl(const DOMNode *rootNode,	//DOM Level 2
@@ -66,6 +75,7 @@ public:
 
 protected:
     DOMNode*          nextMatchingElementAfter(DOMNode *current);
+    bool              indexMatches();
 
 private:
     // -----------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include "DOMDeepNodeListImpl.hpp"
 #include "DOMDocumentFragmentImpl.hpp"
 #include "DOMElementImpl.hpp"
+#include "DOMElementIndex.hpp"
 #include "XSDElementNSImpl.hpp"
 #include "DOMEntityImpl.hpp"
 #include "DOMEntityReferenceImpl.hpp"
@@ -95,9 +96,14 @@ DOMDocumentImpl::DOMDocumentImpl(DOMImplementation* domImpl, MemoryManager* cons
       fFreePtr(0),
       fFreeBytesRemaining(0),
       fHeapAllocSize(kInitialHeapAllocSize),
+      fMaxHeapAllocSize(kMaxHeapAllocSize),
+      fMaxSubAllocationSize(kMaxSubAllocationSize),
+      fAllocatedMemory(0),
+      fBlockCount(0),
       fRecycleNodePtr(0),
       fRecycleBufferPtr(0),
       fNodeListPool(0),
+      fElementIndex(0),
       fDocType(0),
       fDocElement(0),
       fNameTableSize(257),
@@ -138,9 +144,14 @@ DOMDocumentImpl::DOMDocumentImpl(const XMLCh *fNamespaceURI,
       fFreePtr(0),
       fFreeBytesRemaining(0),
       fHeapAllocSize(kInitialHeapAllocSize),
+      fMaxHeapAllocSize(kMaxHeapAllocSize),
+      fMaxSubAllocationSize(kMaxSubAllocationSize),
+      fAllocatedMemory(0),
+      fBlockCount(0),
       fRecycleNodePtr(0),
       fRecycleBufferPtr(0),
       fNodeListPool(0),
+      fElementIndex(0),
       fDocType(0),
       fDocElement(0),
       fNameTableSize(257),
@@ -213,6 +224,8 @@ DOMDocumentImpl::~DOMDocumentImpl()
     if (fNodeListPool)
         fNodeListPool->cleanup();
 
+    delete fElementIndex;
+
     if (fRanges)
         delete fRanges; //fRanges->cleanup();
 
@@ -830,10 +843,42 @@ XMLSize_t DOMDocumentImpl::getMemoryAllocationBlockSize() const
 void DOMDocumentImpl::setMemoryAllocationBlockSize(XMLSize_t size)
 {
     // the new size must be bigger than the maximum amount of each allocation
-    if(size>kMaxSubAllocationSize)
+    if(size>fMaxSubAllocationSize+XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *)))
         fHeapAllocSize=size;
 }
 
+XMLSize_t DOMDocumentImpl::getMaxMemoryAllocationBlockSize() const
+{
+    return fMaxHeapAllocSize;
+}
+
+void DOMDocumentImpl::setMaxMemoryAllocationBlockSize(XMLSize_t size)
+{
+    fMaxHeapAllocSize=size;
+}
+
+XMLSize_t DOMDocumentImpl::getMaxSubAllocationSize() const
+{
+    return fMaxSubAllocationSize;
+}
+
+void DOMDocumentImpl::setMaxSubAllocationSize(XMLSize_t size)
+{
+    // the chunks must be able to hold the largest sub-allocation
+    if(size+XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *))<fHeapAllocSize)
+        fMaxSubAllocationSize=size;
+}
+
+XMLSize_t DOMDocumentImpl::getAllocatedMemory() const
+{
+    return fAllocatedMemory;
+}
+
+XMLSize_t DOMDocumentImpl::getMemoryAllocationBlockCount() const
+{
+    return fBlockCount;
+}
+
 void DOMDocumentImpl::release(void* oldBuffer)
 {
     // only release blocks that are stored in a block by itself
@@ -848,6 +893,7 @@ void DOMDocumentImpl::release(void* oldBuffer)
             void* current = *cursor;
             *cursor = *nextBlock;
             fMemoryManager->deallocate(current);
+            fBlockCount--;
             break;
         }
         cursor = nextBlock;
@@ -859,17 +905,19 @@ void* DOMDocumentImpl::allocate(XMLSize_t amount)
   //	Align the request size so that suballocated blocks
   //	beyond this one will be maintained at the same alignment.
   amount = XMLPlatformUtils::alignPointerForNewBlockAllocation(amount);
+  fAllocatedMemory += amount;
 
   // If the request is for a largish block, hand it off to the system
   //   allocator.  The block still must be linked into a special list of
   //   allocated big blocks so that it will be deleted when the time comes.
-  if (amount > kMaxSubAllocationSize)
+  if (amount > fMaxSubAllocationSize)
   {
     //	The size of the header we add to our raw blocks
     XMLSize_t sizeOfHeader = XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *));
 
     //	Try to allocate the block
     void* newBlock = fMemoryManager->allocate(sizeOfHeader + amount);
+    fBlockCount++;
 
     //	Link it into the list beyond current block, as current block
     //	is still being subdivided. If there is no current block
@@ -900,13 +948,14 @@ void* DOMDocumentImpl::allocate(XMLSize_t amount)
     // Get a new block from the system allocator.
     void* newBlock;
     newBlock = fMemoryManager->allocate(fHeapAllocSize);
+    fBlockCount++;
 
     *(void **)newBlock = fCurrentBlock;
     fCurrentBlock = newBlock;
     fFreePtr = (char *)newBlock + sizeOfHeader;
     fFreeBytesRemaining = fHeapAllocSize - sizeOfHeader;
 
-    if(fHeapAllocSize<kMaxHeapAllocSize)
+    if(fHeapAllocSize<fMaxHeapAllocSize)
       fHeapAllocSize*=2;
   }
 
@@ -933,8 +982,24 @@ void DOMDocumentImpl::deleteHeap()
         fMemoryManager->deallocate(fCurrentSingletonBlock);
         fCurrentSingletonBlock = nextBlock;
     }
+    fBlockCount = 0;
+}
+
+
+void DOMDocumentImpl::setElementIndexEnabled(bool enabled)
+{
+    if (enabled && !fElementIndex)
+        fElementIndex = new (fMemoryManager) DOMElementIndex(this);
+    else if (!enabled && fElementIndex) {
+        delete fElementIndex;
+        fElementIndex = 0;
+    }
 }
 
+bool DOMDocumentImpl::getElementIndexEnabled() const
+{
+    return fElementIndex != 0;
+}
 
 DOMNodeList *DOMDocumentImpl::getDeepNodeList(const DOMNode *rootNode, const XMLCh *tagName)
 {
@@ -1415,7 +1480,13 @@ DOMNode* DOMDocumentImpl::renameNode(DOMNode* n, const XMLCh* namespaceURI, cons
 
     switch (n->getNodeType()) {
         case ELEMENT_NODE:
-            return ((DOMElementImpl*)n)->rename(namespaceURI, name);
+        {
+            DOMNode* renamed = ((DOMElementImpl*)n)->rename(namespaceURI, name);
+            // a renamed element that was not replaced keeps its place
+            if (fElementIndex && renamed == n)
+                fElementIndex->nodeRenamed((DOMElement*)n);
+            return renamed;
+        }
         case ATTRIBUTE_NODE:
             return ((DOMAttrImpl*)n)->rename(namespaceURI, name);
         default:
@@ -57,6 +57,7 @@ class DOMDeepNodeListImpl;
 class DOMDocumentFragmentImpl;
 class DOMDocumentTypeImpl;
 class DOMElementImpl;
+class DOMElementIndex;
 class DOMEntityImpl;
 class DOMEntityReferenceImpl;
 class DOMNotationImpl;
@@ -163,6 +164,12 @@ public:
     // Add all functions that are pure virtual in DOMMemoryManager
     virtual XMLSize_t getMemoryAllocationBlockSize() const;
     virtual void setMemoryAllocationBlockSize(XMLSize_t size);
+    virtual XMLSize_t getMaxMemoryAllocationBlockSize() const;
+    virtual void setMaxMemoryAllocationBlockSize(XMLSize_t size);
+    virtual XMLSize_t getMaxSubAllocationSize() const;
+    virtual void setMaxSubAllocationSize(XMLSize_t size);
+    virtual XMLSize_t getAllocatedMemory() const;
+    virtual XMLSize_t getMemoryAllocationBlockCount() const;
     virtual void* allocate(XMLSize_t amount);
     virtual void* allocate(XMLSize_t amount, DOMMemoryManager::NodeObjectType type);
     // try to remove the block from the list of allocated memory
@@ -261,6 +268,11 @@ public:
 
     inline DOMNodeIDMap*         getNodeIDMap() {return fNodeIDMap;};
 
+    // The tag name index used by getElementsByTagName(NS), 0 unless enabled.
+    void                         setElementIndexEnabled(bool enabled);
+    bool                         getElementIndexEnabled() const;
+    inline DOMElementIndex*      getElementIndex() const {return fElementIndex;};
+
 
     //
     // Memory Management Functions.  All memory is allocated by and owned by
@@ -331,7 +343,13 @@ protected:
     void*                 fCurrentSingletonBlock;
     char*                 fFreePtr;
     XMLSize_t             fFreeBytesRemaining,
-                          fHeapAllocSize;
+                          fHeapAllocSize,
+                          fMaxHeapAllocSize,
+                          fMaxSubAllocationSize;
+
+    // Heap statistics: the bytes handed out and the blocks currently held
+    XMLSize_t             fAllocatedMemory,
+                          fBlockCount;
 
     // To recycle the DOMNode pointer
     RefArrayOf<DOMNodePtr>* fRecycleNodePtr;
@@ -342,6 +360,9 @@ protected:
     // Pool of DOMNodeList for getElementsByTagName
     DOMDeepNodeListPool<DOMDeepNodeListImpl>* fNodeListPool;
 
+    // Index of the elements by tag name, for the node lists above
+    DOMElementIndex*      fElementIndex;
+
     // Other data
     DOMDocumentType*      fDocType;
     DOMElement*           fDocElement;
@@ -0,0 +1,546 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#include "DOMDocumentImpl.hpp"
+#include "DOMElementIndex.hpp"
+
+#include <xercesc/dom/DOMElement.hpp>
+#include <xercesc/util/XMLUniDefs.hpp>
+
+#include <string.h>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+
+static const XMLUInt64 kMaxKey = ((XMLUInt64)1) << 62;     // Keys lie in (0, kMaxKey)
+static const XMLUInt64 kInsertGap = ((XMLUInt64)1) << 20;  // Largest key spacing of inserted
+                                                           //   subtrees, so that repeated appends
+                                                           //   at one place leave room for more.
+static const XMLSize_t kNameBuckets = 509;
+static const XMLSize_t kEntriesPerChunk = 256;
+
+
+struct DOMElementIndex::NameList {
+    const XMLCh*  fKey;
+    Entry**       fEntries;                 // Sorted by fStart
+    XMLSize_t     fCount;
+    XMLSize_t     fCapacity;
+    NameList*     fNext;
+};
+
+struct DOMElementIndex::EntryChunk {
+    EntryChunk*   fNext;
+    Entry         fEntries[kEntriesPerChunk];
+};
+
+
+static inline XMLSize_t hashPointer(const void *p, XMLSize_t size)
+{
+    XMLSize_t h = (XMLSize_t)p;
+    h ^= h >> 4;
+    h *= 0x9E3779B1;
+    return (h ^ (h >> 16)) & (size - 1);
+}
+
+//  Index of the first entry of list whose start key is greater than key.
+static XMLSize_t upperBound(DOMElementIndex::Entry* const* entries, XMLSize_t count, XMLUInt64 key)
+{
+    XMLSize_t lo = 0;
+    XMLSize_t hi = count;
+    while (lo < hi) {
+        XMLSize_t mid = lo + (hi - lo) / 2;
+        if (entries[mid]->fStart <= key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+DOMElementIndex::DOMElementIndex(DOMDocumentImpl *doc)
+: fDoc(doc)
+, fBuilt(false)
+, fTable(0)
+, fTableSize(0)
+, fNumEntries(0)
+, fNames(0)
+, fChunks(0)
+, fFreeEntries(0)
+{
+}
+
+
+DOMElementIndex::~DOMElementIndex()
+{
+    invalidate();
+}
+
+
+void DOMElementIndex::invalidate()
+{
+    MemoryManager* manager = fDoc->getMemoryManager();
+
+    if (fNames) {
+        for (XMLSize_t i = 0; i < kNameBuckets; i++) {
+            NameList* list = fNames[i];
+            while (list) {
+                NameList* next = list->fNext;
+                manager->deallocate(list->fEntries);
+                manager->deallocate(list);
+                list = next;
+            }
+        }
+        manager->deallocate(fNames);
+        fNames = 0;
+    }
+
+    while (fChunks) {
+        EntryChunk* next = fChunks->fNext;
+        manager->deallocate(fChunks);
+        fChunks = next;
+    }
+    fFreeEntries = 0;
+
+    manager->deallocate(fTable);
+    fTable = 0;
+    fTableSize = 0;
+    fNumEntries = 0;
+    fBuilt = false;
+}
+
+
+const XMLCh* DOMElementIndex::localPart(const XMLCh *tagName)
+{
+    const XMLCh* local = tagName;
+    for (const XMLCh* p = tagName; *p; p++) {
+        if (*p == chColon)
+            local = p + 1;
+    }
+    return local;
+}
+
+
+// ---------------------------------------------------------------------------
+//  Lookup
+// ---------------------------------------------------------------------------
+bool DOMElementIndex::find(const DOMNode *root, const XMLCh *key, Entry* const*& first, XMLSize_t& count)
+{
+    if (!fBuilt)
+        build();
+
+    XMLUInt64 start = 0;
+    XMLUInt64 end = kMaxKey;
+    if (root->getNodeType() == DOMNode::ELEMENT_NODE) {
+        Entry* rootEntry = lookup(root);
+        if (!rootEntry)
+            return false;
+        start = rootEntry->fStart;
+        end = rootEntry->fEnd;
+    }
+    else if (root != (const DOMNode*)fDoc)
+        return false;
+
+    NameList* list = findList(key, false);
+    if (!list) {
+        first = 0;
+        count = 0;
+        return true;
+    }
+
+    XMLSize_t lo = upperBound(list->fEntries, list->fCount, start);
+    XMLSize_t hi = upperBound(list->fEntries, list->fCount, end);
+    first = list->fEntries + lo;
+    count = hi - lo;
+    return true;
+}
+
+
+void DOMElementIndex::build()
+{
+    XMLSize_t count = 0;
+    DOMNode* node = fDoc->getFirstChild();
+    while (node) {
+        if (node->getNodeType() == DOMNode::ELEMENT_NODE)
+            count++;
+        DOMNode* next = node->getFirstChild();
+        while (!next && node) {
+            next = node->getNextSibling();
+            if (!next) {
+                node = node->getParentNode();
+                if (node == (DOMNode*)fDoc)
+                    node = 0;
+            }
+        }
+        node = next;
+    }
+
+    fTableSize = 64;
+    while (fTableSize < count + count / 4)
+        fTableSize *= 2;
+    MemoryManager* manager = fDoc->getMemoryManager();
+    fTable = (Entry**) manager->allocate(fTableSize * sizeof(Entry*));
+    memset(fTable, 0, fTableSize * sizeof(Entry*));
+    fNames = (NameList**) manager->allocate(kNameBuckets * sizeof(NameList*));
+    memset(fNames, 0, kNameBuckets * sizeof(NameList*));
+    fBuilt = true;
+
+    XMLUInt64 gap = kMaxKey / (2 * (XMLUInt64)count + 2);
+    XMLUInt64 key = 0;
+    for (DOMNode* child = fDoc->getFirstChild(); child; child = child->getNextSibling())
+        key = indexSubtree(child, key, gap);
+}
+
+
+// ---------------------------------------------------------------------------
+//  Updates
+// ---------------------------------------------------------------------------
+void DOMElementIndex::nodeInserted(DOMNode *node)
+{
+    if (!fBuilt || !isInDocument(node))
+        return;
+
+    XMLSize_t count = 0;
+    DOMNode* n = node;
+    while (n) {
+        if (n->getNodeType() == DOMNode::ELEMENT_NODE)
+            count++;
+        DOMNode* next = n->getFirstChild();
+        while (!next && n != node) {
+            next = n->getNextSibling();
+            if (!next)
+                n = n->getParentNode();
+        }
+        n = next;
+    }
+    if (count == 0)
+        return;
+
+    XMLUInt64 lo;
+    XMLUInt64 hi;
+    if (!precedingKey(node, lo) || !followingKey(node, hi) || hi <= lo) {
+        invalidate();
+        return;
+    }
+
+    XMLUInt64 gap = (hi - lo) / (2 * (XMLUInt64)count + 1);
+    if (gap > kInsertGap)
+        gap = kInsertGap;
+    if (gap == 0) {
+        invalidate();
+        return;
+    }
+
+    indexSubtree(node, lo, gap);
+}
+
+
+void DOMElementIndex::nodeRemoved(DOMNode *node)
+{
+    if (!fBuilt || !isInDocument(node))
+        return;
+
+    DOMNode* n = node;
+    while (n) {
+        if (n->getNodeType() == DOMNode::ELEMENT_NODE) {
+            Entry* entry = lookup(n);
+            if (entry)
+                removeEntry(entry);
+        }
+        DOMNode* next = n->getFirstChild();
+        while (!next && n != node) {
+            next = n->getNextSibling();
+            if (!next)
+                n = n->getParentNode();
+        }
+        n = next;
+    }
+}
+
+
+void DOMElementIndex::nodeRenamed(DOMElement *elem)
+{
+    if (!fBuilt)
+        return;
+
+    Entry* entry = lookup(elem);
+    if (!entry)
+        return;
+
+    XMLUInt64 start = entry->fStart;
+    XMLUInt64 end = entry->fEnd;
+    removeEntry(entry);
+    addEntry(elem, start)->fEnd = end;
+}
+
+
+//  Give the elements of the subtree of top keys in document order, spaced by
+//   gap and starting after key. Returns the last key given.
+XMLUInt64 DOMElementIndex::indexSubtree(DOMNode *top, XMLUInt64 key, XMLUInt64 gap)
+{
+    DOMNode* node = top;
+    while (node) {
+        if (node->getNodeType() == DOMNode::ELEMENT_NODE) {
+            key += gap;
+            addEntry((DOMElement*)node, key);
+        }
+
+        DOMNode* next = node->getFirstChild();
+        while (!next && node) {
+            if (node->getNodeType() == DOMNode::ELEMENT_NODE) {
+                key += gap;
+                lookup(node)->fEnd = key;
+            }
+            if (node == top)
+                node = 0;
+            else {
+                next = node->getNextSibling();
+                if (!next)
+                    node = node->getParentNode();
+            }
+        }
+        node = next;
+    }
+    return key;
+}
+
+
+//  The last key before node in document order: the end of an element before
+//   it or the start of the element containing it, or 0.
+bool DOMElementIndex::precedingKey(const DOMNode *node, XMLUInt64& key) const
+{
+    for (const DOMNode* n = node; n != (const DOMNode*)fDoc; n = n->getParentNode()) {
+        for (const DOMNode* sib = n->getPreviousSibling(); sib; sib = sib->getPreviousSibling()) {
+            if (lastKeyIn(sib, key))
+                return true;
+        }
+        const DOMNode* parent = n->getParentNode();
+        if (parent->getNodeType() == DOMNode::ELEMENT_NODE) {
+            Entry* entry = lookup(parent);
+            if (!entry)
+                return false;
+            key = entry->fStart;
+            return true;
+        }
+    }
+    key = 0;
+    return true;
+}
+
+
+//  The first key after node in document order: the start of an element after
+//   it or the end of the element containing it, or kMaxKey.
+bool DOMElementIndex::followingKey(const DOMNode *node, XMLUInt64& key) const
+{
+    for (const DOMNode* n = node; n != (const DOMNode*)fDoc; n = n->getParentNode()) {
+        for (const DOMNode* sib = n->getNextSibling(); sib; sib = sib->getNextSibling()) {
+            if (firstKeyIn(sib, key))
+                return true;
+        }
+        const DOMNode* parent = n->getParentNode();
+        if (parent->getNodeType() == DOMNode::ELEMENT_NODE) {
+            Entry* entry = lookup(parent);
+            if (!entry)
+                return false;
+            key = entry->fEnd;
+            return true;
+        }
+    }
+    key = kMaxKey;
+    return true;
+}
+
+
+bool DOMElementIndex::lastKeyIn(const DOMNode *node, XMLUInt64& key) const
+{
+    if (node->getNodeType() == DOMNode::ELEMENT_NODE) {
+        Entry* entry = lookup(node);
+        if (!entry)
+            return false;
+        key = entry->fEnd;
+        return true;
+    }
+    for (const DOMNode* child = node->getLastChild(); child; child = child->getPreviousSibling()) {
+        if (lastKeyIn(child, key))
+            return true;
+    }
+    return false;
+}
+
+
+bool DOMElementIndex::firstKeyIn(const DOMNode *node, XMLUInt64& key) const
+{
+    if (node->getNodeType() == DOMNode::ELEMENT_NODE) {
+        Entry* entry = lookup(node);
+        if (!entry)
+            return false;
+        key = entry->fStart;
+        return true;
+    }
+    for (const DOMNode* child = node->getFirstChild(); child; child = child->getNextSibling()) {
+        if (firstKeyIn(child, key))
+            return true;
+    }
+    return false;
+}
+
+
+bool DOMElementIndex::isInDocument(const DOMNode *node) const
+{
+    for (const DOMNode* n = node; n; n = n->getParentNode()) {
+        if (n == (const DOMNode*)fDoc)
+            return true;
+    }
+    return false;
+}
+
+
+// ---------------------------------------------------------------------------
+//  Tables
+// ---------------------------------------------------------------------------
+DOMElementIndex::Entry* DOMElementIndex::lookup(const DOMNode *elem) const
+{
+    Entry* entry = fTable[hashPointer(elem, fTableSize)];
+    while (entry && entry->fElement != (const DOMElement*)elem)
+        entry = entry->fNext;
+    return entry;
+}
+
+
+DOMElementIndex::Entry* DOMElementIndex::addEntry(DOMElement *elem, XMLUInt64 start)
+{
+    MemoryManager* manager = fDoc->getMemoryManager();
+
+    if (!fFreeEntries) {
+        EntryChunk* chunk = (EntryChunk*) manager->allocate(sizeof(EntryChunk));
+        chunk->fNext = fChunks;
+        fChunks = chunk;
+        for (XMLSize_t i = 0; i < kEntriesPerChunk; i++) {
+            chunk->fEntries[i].fNext = fFreeEntries;
+            fFreeEntries = &chunk->fEntries[i];
+        }
+    }
+    if (fNumEntries >= fTableSize - fTableSize / 4)
+        growTable();
+
+    Entry* entry = fFreeEntries;
+    fFreeEntries = entry->fNext;
+    entry->fElement = elem;
+    entry->fStart = start;
+    entry->fEnd = start;
+    entry->fKey = fDoc->getPooledString(localPart(elem->getTagName()));
+
+    XMLSize_t slot = hashPointer(elem, fTableSize);
+    entry->fNext = fTable[slot];
+    fTable[slot] = entry;
+    fNumEntries++;
+
+    // Elements mostly arrive in document order, so this is usually an append
+    NameList* list = findList(entry->fKey, true);
+    if (list->fCount == list->fCapacity) {
+        XMLSize_t capacity = list->fCapacity ? list->fCapacity * 2 : 8;
+        Entry** entries = (Entry**) manager->allocate(capacity * sizeof(Entry*));
+        if (list->fCount)
+            memcpy(entries, list->fEntries, list->fCount * sizeof(Entry*));
+        manager->deallocate(list->fEntries);
+        list->fEntries = entries;
+        list->fCapacity = capacity;
+    }
+    XMLSize_t at = list->fCount;
+    if (at && list->fEntries[at - 1]->fStart > start) {
+        at = upperBound(list->fEntries, list->fCount, start);
+        memmove(list->fEntries + at + 1, list->fEntries + at, (list->fCount - at) * sizeof(Entry*));
+    }
+    list->fEntries[at] = entry;
+    list->fCount++;
+
+    return entry;
+}
+
+
+void DOMElementIndex::removeEntry(Entry *entry)
+{
+    NameList* list = findList(entry->fKey, false);
+    if (list) {
+        XMLSize_t at = upperBound(list->fEntries, list->fCount, entry->fStart);
+        if (at && list->fEntries[at - 1] == entry) {
+            at--;
+            memmove(list->fEntries + at, list->fEntries + at + 1, (list->fCount - at - 1) * sizeof(Entry*));
+            list->fCount--;
+        }
+    }
+
+    Entry** link = &fTable[hashPointer(entry->fElement, fTableSize)];
+    while (*link != entry)
+        link = &(*link)->fNext;
+    *link = entry->fNext;
+    fNumEntries--;
+
+    entry->fNext = fFreeEntries;
+    fFreeEntries = entry;
+}
+
+
+//  Local parts are pooled strings of the document, so they compare by address.
+DOMElementIndex::NameList* DOMElementIndex::findList(const XMLCh *key, bool create)
+{
+    XMLSize_t slot = hashPointer(key, 512) % kNameBuckets;
+    NameList* list = fNames[slot];
+    while (list && list->fKey != key)
+        list = list->fNext;
+
+    if (!list && create) {
+        list = (NameList*) fDoc->getMemoryManager()->allocate(sizeof(NameList));
+        list->fKey = key;
+        list->fEntries = 0;
+        list->fCount = 0;
+        list->fCapacity = 0;
+        list->fNext = fNames[slot];
+        fNames[slot] = list;
+    }
+    return list;
+}
+
+
+void DOMElementIndex::growTable()
+{
+    XMLSize_t newSize = fTableSize * 2;
+    MemoryManager* manager = fDoc->getMemoryManager();
+    Entry** newTable = (Entry**) manager->allocate(newSize * sizeof(Entry*));
+    memset(newTable, 0, newSize * sizeof(Entry*));
+
+    for (XMLSize_t i = 0; i < fTableSize; i++) {
+        Entry* entry = fTable[i];
+        while (entry) {
+            Entry* next = entry->fNext;
+            XMLSize_t slot = hashPointer(entry->fElement, newSize);
+            entry->fNext = newTable[slot];
+            newTable[slot] = entry;
+            entry = next;
+        }
+    }
+
+    manager->deallocate(fTable);
+    fTable = newTable;
+    fTableSize = newSize;
+}
+
+XERCES_CPP_NAMESPACE_END
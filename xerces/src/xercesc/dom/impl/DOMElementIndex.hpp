@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_DOMELEMENTINDEX_HPP)
+#define XERCESC_INCLUDE_GUARD_DOMELEMENTINDEX_HPP
+
+//
+//  This file is part of the internal implementation of the C++ XML DOM.
+//  It should NOT be included or used directly by application programs.
+//
+//  Applications should include the file <xercesc/dom/DOM.hpp> for the entire
+//  DOM API, or xercesc/dom/DOM*.hpp for individual DOM classes, where the class
+//  name is substituded for the *.
+//
+
+#include <xercesc/util/XMemory.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+
+//
+//  Class DOMElementIndex finds the elements of a document by tag name, for
+//   DOMDeepNodeListImpl, without walking the tree.
+//
+//  Every element of the document tree gets two keys, at its start and at its
+//   end in document order, so that the elements below an element are those
+//   whose start key lies between its keys. The keys are spread out when the
+//   index is built; an inserted subtree takes keys from the gap between its
+//   neighbours, and if there is no room left the index is dropped and built
+//   again on the next lookup. For each local part of a tag name the index
+//   keeps the elements sorted by start key, so a lookup below any element is
+//   two binary searches.
+//
+//  The index is built by the first lookup and then kept up to date by the
+//   insertions, removals and renames of the document.
+//
+class DOMDocumentImpl;
+class DOMElement;
+class DOMNode;
+
+
+class DOMElementIndex : public XMemory {
+public:
+    struct Entry {
+        DOMElement*   fElement;
+        XMLUInt64     fStart;               // Key of the start of the element
+        XMLUInt64     fEnd;                 // Key of the end of the element
+        const XMLCh*  fKey;                 // Pooled local part of the tag name
+        Entry*        fNext;                // Next entry of the bucket or of the free list
+    };
+
+    DOMElementIndex(DOMDocumentImpl *doc);
+    ~DOMElementIndex();
+
+private:
+    DOMElementIndex(const DOMElementIndex &other);   // No copy, assignement.
+    DOMElementIndex &operator = (const DOMElementIndex &other);
+
+public:
+    void  nodeInserted(DOMNode *node);      // Called after node was linked into its parent.
+    void  nodeRemoved(DOMNode *node);       // Called before node is unlinked from its parent.
+    void  nodeRenamed(DOMElement *elem);    // Called after the tag name of elem changed in place.
+    void  invalidate();                     // Drop the index, to be built by the next lookup.
+
+    // Find the elements below root, a document or an element of its tree, whose
+    //  tag name has the pooled local part key. Returns false if root is not indexed.
+    bool  find(const DOMNode *root, const XMLCh *key, Entry* const*& first, XMLSize_t& count);
+
+    static const XMLCh* localPart(const XMLCh *tagName);
+
+private:
+    struct NameList;
+    struct EntryChunk;
+
+    void       build();
+    XMLUInt64  indexSubtree(DOMNode *top, XMLUInt64 key, XMLUInt64 gap);
+    bool       precedingKey(const DOMNode *node, XMLUInt64& key) const;
+    bool       followingKey(const DOMNode *node, XMLUInt64& key) const;
+    bool       lastKeyIn(const DOMNode *node, XMLUInt64& key) const;
+    bool       firstKeyIn(const DOMNode *node, XMLUInt64& key) const;
+    bool       isInDocument(const DOMNode *node) const;
+
+    Entry*     lookup(const DOMNode *elem) const;
+    Entry*     addEntry(DOMElement *elem, XMLUInt64 start);
+    void       removeEntry(Entry *entry);
+    NameList*  findList(const XMLCh *key, bool create);
+    void       growTable();
+
+private:
+    DOMDocumentImpl *fDoc;                  // The owning document.
+    bool           fBuilt;                  // False until the first lookup and after invalidate().
+    Entry        **fTable;                  // Entries by element, chained.
+    XMLSize_t      fTableSize;              // Number of slots, a power of two.
+    XMLSize_t      fNumEntries;             // Number of elements indexed.
+    NameList     **fNames;                  // Sorted entries by local part, chained.
+    EntryChunk    *fChunks;                 // Storage of the entries.
+    Entry         *fFreeEntries;            // Entries of removed elements.
+};
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
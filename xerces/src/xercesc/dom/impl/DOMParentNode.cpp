@@ -24,6 +24,7 @@
 #include <xercesc/dom/DOMNode.hpp>
 
 #include "DOMDocumentImpl.hpp"
+#include "DOMElementIndex.hpp"
 #include "DOMRangeImpl.hpp"
 #include "DOMNodeIteratorImpl.hpp"
 #include "DOMParentNode.hpp"
@@ -275,6 +276,12 @@ DOMNode *DOMParentNode::insertBefore(DOMNode *newChild, DOMNode *refChild) {
                 }
             }
         }
+
+        if (fOwnerDocument != 0) {
+            DOMElementIndex* index = ((DOMDocumentImpl*)fOwnerDocument)->getElementIndex();
+            if (index != 0)
+                index->nodeInserted(newChild);
+        }
     }
 
     changed();
@@ -329,6 +336,10 @@ DOMNode *DOMParentNode::removeChild(DOMNode *oldChild)
                 }
             }
         }
+
+        DOMElementIndex* index = ((DOMDocumentImpl*)fOwnerDocument)->getElementIndex();
+        if (index != 0)
+            index->nodeRemoved(oldChild);
     }
 
 
@@ -413,6 +424,12 @@ DOMNode * DOMParentNode::appendChildFast(DOMNode *newChild)
         newChild_ci->previousSibling = newChild;
     }
 
+    if (fOwnerDocument != 0) {
+        DOMElementIndex* index = ((DOMDocumentImpl*)fOwnerDocument)->getElementIndex();
+        if (index != 0)
+            index->nodeInserted(newChild);
+    }
+
     return newChild;
 }
 
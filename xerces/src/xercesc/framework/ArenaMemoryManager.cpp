@@ -0,0 +1,158 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/framework/ArenaMemoryManager.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Local helpers
+// ---------------------------------------------------------------------------
+//  Each block starts with the pointer to the next block, padded so that the
+//  memory handed out after it is aligned.
+static inline XMLSize_t blockHeaderSize()
+{
+    return XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void*));
+}
+
+static inline void* nextBlock(void* const block)
+{
+    return *(void**) block;
+}
+
+
+// ---------------------------------------------------------------------------
+//  ArenaMemoryManager: Constructors and Destructor
+// ---------------------------------------------------------------------------
+ArenaMemoryManager::ArenaMemoryManager(const XMLSize_t        blockSize
+                                       , MemoryManager* const parent) :
+
+    fBlockSize(XMLPlatformUtils::alignPointerForNewBlockAllocation(blockSize < kMinBlockSize ? (XMLSize_t)kMinBlockSize : blockSize))
+  , fBlocks(0)
+  , fFirstBlock(0)
+  , fCurrent(0)
+  , fEnd(0)
+  , fBytesAllocated(0)
+  , fBlockCount(0)
+  , fParent(parent)
+{
+}
+
+ArenaMemoryManager::~ArenaMemoryManager()
+{
+    while (fBlocks)
+    {
+        void* const next = nextBlock(fBlocks);
+        fParent->deallocate(fBlocks);
+        fBlocks = next;
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+//  ArenaMemoryManager: The virtual methods in MemoryManager
+// ---------------------------------------------------------------------------
+MemoryManager* ArenaMemoryManager::getExceptionMemoryManager()
+{
+    return fParent->getExceptionMemoryManager();
+}
+
+void* ArenaMemoryManager::allocate(XMLSize_t size)
+{
+    // keep every allocation aligned, and distinct for zero sized requests
+    size = XMLPlatformUtils::alignPointerForNewBlockAllocation(size ? size : 1);
+
+    if (size > (XMLSize_t) (fEnd - fCurrent))
+    {
+        // large requests get their own block, the current one stays in use
+        if (size > fBlockSize / 4)
+        {
+            fBytesAllocated += size;
+            return allocateBlock(size);
+        }
+
+        fCurrent = (char*) allocateBlock(fBlockSize);
+        fEnd = fCurrent + fBlockSize;
+        if (!fFirstBlock)
+            fFirstBlock = fBlocks;
+    }
+
+    void* const retPtr = fCurrent;
+    fCurrent += size;
+    fBytesAllocated += size;
+    return retPtr;
+}
+
+void ArenaMemoryManager::deallocate(void* /*p*/)
+{
+}
+
+
+// ---------------------------------------------------------------------------
+//  ArenaMemoryManager: Arena methods
+// ---------------------------------------------------------------------------
+void ArenaMemoryManager::release()
+{
+    while (fBlocks)
+    {
+        void* const next = nextBlock(fBlocks);
+        if (fBlocks != fFirstBlock)
+            fParent->deallocate(fBlocks);
+        fBlocks = next;
+    }
+
+    fBytesAllocated = 0;
+    if (fFirstBlock)
+    {
+        *(void**) fFirstBlock = 0;
+        fBlocks = fFirstBlock;
+        fBlockCount = 1;
+        fCurrent = (char*) fFirstBlock + blockHeaderSize();
+        fEnd = fCurrent + fBlockSize;
+    }
+    else
+    {
+        fBlockCount = 0;
+        fCurrent = fEnd = 0;
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+//  ArenaMemoryManager: Private helper methods
+// ---------------------------------------------------------------------------
+void* ArenaMemoryManager::allocateBlock(const XMLSize_t size)
+{
+    const XMLSize_t headerSize = blockHeaderSize();
+    void* const block = fParent->allocate(headerSize + size);
+
+    *(void**) block = fBlocks;
+    fBlocks = block;
+    fBlockCount++;
+
+    return (char*) block + headerSize;
+}
+
+XERCES_CPP_NAMESPACE_END
@@ -0,0 +1,213 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_ARENAMEMORYMANAGER_HPP)
+#define XERCESC_INCLUDE_GUARD_ARENAMEMORYMANAGER_HPP
+
+#include <xercesc/framework/MemoryManager.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+/**
+  * Arena memory manager
+  *
+  * <p>A memory manager for the lifetime of one parse. Allocations are
+  *    carved out of large blocks obtained from the parent memory manager
+  *    by bumping a pointer, deallocate() does nothing and all the memory
+  *    is given back at once by release() or by the destructor. This
+  *    removes the cost of the many small allocations the scanner, the
+  *    buffer manager, the attribute lists and the element stack make
+  *    during a parse.
+  * </p>
+  *
+  * <p>Memory freed during the parse is not reused, so the arena suits a
+  *    parser (and the DOM documents it produced) that is created, used for
+  *    one or a few documents and then destroyed. Every object allocated
+  *    from the arena must be gone before release() is called, and the
+  *    arena is not thread safe: use one arena per parser and thread.
+  * </p>
+  *
+  * <p>Requests larger than a quarter of the block size get a block of
+  *    their own so that they do not waste the rest of the current block.
+  * </p>
+  */
+class XMLUTIL_EXPORT ArenaMemoryManager : public MemoryManager
+{
+public:
+    enum Constants
+    {
+        kDefaultBlockSize = 64 * 1024
+        , kMinBlockSize   = 1024
+    };
+
+    /** @name Constructor */
+    //@{
+
+    /**
+      * Constructor
+      *
+      * @param blockSize The size of the blocks requested from the parent
+      *                  memory manager, at least kMinBlockSize
+      * @param parent    The memory manager providing the blocks
+      */
+    ArenaMemoryManager
+    (
+        const XMLSize_t         blockSize = kDefaultBlockSize
+        , MemoryManager* const  parent = XMLPlatformUtils::fgMemoryManager
+    );
+    //@}
+
+    /** @name Destructor */
+    //@{
+
+    /**
+      * Destructor, gives all the blocks back to the parent
+      */
+    virtual ~ArenaMemoryManager();
+    //@}
+
+
+    /**
+      * Exceptions may outlive the arena, so they are allocated with the
+      * exception memory manager of the parent.
+      *
+      * @return A pointer to the memory manager
+      */
+    virtual MemoryManager* getExceptionMemoryManager();
+
+
+    /** @name The virtual methods in MemoryManager */
+    //@{
+
+    /**
+      * This method allocates requested memory from the current block.
+      *
+      * @param size The requested memory size
+      *
+      * @return A pointer to the allocated memory
+      */
+    virtual void* allocate(XMLSize_t size);
+
+    /**
+      * This method does nothing, the memory is given back by release()
+      *
+      * @param p The pointer to the allocated memory
+      */
+    virtual void deallocate(void* p);
+
+    //@}
+
+    /** @name Arena methods */
+    //@{
+
+    /**
+      * Gives all the memory allocated from the arena back at once. The
+      * first block is kept for the next parse.
+      */
+    void release();
+
+    /**
+      * @return The number of bytes handed out since construction or the
+      *         last release(), including alignment padding
+      */
+    XMLSize_t getBytesAllocated() const;
+
+    /**
+      * @return The number of blocks currently obtained from the parent
+      */
+    XMLSize_t getBlockCount() const;
+
+    /**
+      * @return The block size
+      */
+    XMLSize_t getBlockSize() const;
+
+    //@}
+
+private:
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    ArenaMemoryManager(const ArenaMemoryManager&);
+    ArenaMemoryManager& operator=(const ArenaMemoryManager&);
+
+    // -----------------------------------------------------------------------
+    //  Private helper methods
+    // -----------------------------------------------------------------------
+    void* allocateBlock(const XMLSize_t size);
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fBlockSize
+    //      The usable size of the regular blocks.
+    //
+    //  fBlocks
+    //      The blocks obtained from the parent, most recent first. Each
+    //      block starts with the pointer to the next one.
+    //
+    //  fFirstBlock
+    //      The first regular block, kept by release().
+    //
+    //  fCurrent
+    //  fEnd
+    //      The free part of the current regular block.
+    //
+    //  fBytesAllocated
+    //  fBlockCount
+    //      Statistics.
+    //
+    //  fParent
+    //      The memory manager providing the blocks.
+    // -----------------------------------------------------------------------
+    XMLSize_t               fBlockSize;
+    void*                   fBlocks;
+    void*                   fFirstBlock;
+    char*                   fCurrent;
+    char*                   fEnd;
+    XMLSize_t               fBytesAllocated;
+    XMLSize_t               fBlockCount;
+    MemoryManager* const    fParent;
+};
+
+
+// ---------------------------------------------------------------------------
+//  ArenaMemoryManager: Arena methods
+// ---------------------------------------------------------------------------
+inline XMLSize_t ArenaMemoryManager::getBytesAllocated() const
+{
+    return fBytesAllocated;
+}
+
+inline XMLSize_t ArenaMemoryManager::getBlockCount() const
+{
+    return fBlockCount;
+}
+
+inline XMLSize_t ArenaMemoryManager::getBlockSize() const
+{
+    return fBlockSize;
+}
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
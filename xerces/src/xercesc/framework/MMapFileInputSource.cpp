@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ * 
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/framework/MMapFileInputSource.hpp>
+#include <xercesc/util/BinMMapInputStream.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  MMapFileInputSource: Constructors and Destructor
+// ---------------------------------------------------------------------------
+MMapFileInputSource::MMapFileInputSource( const XMLCh* const basePath
+                                        , const XMLCh* const relativePath
+                                        , MemoryManager* const manager)
+    : LocalFileInputSource(basePath, relativePath, manager)
+{
+}
+
+MMapFileInputSource::MMapFileInputSource(const XMLCh* const filePath,
+                                         MemoryManager* const manager)
+    : LocalFileInputSource(filePath, manager)
+{
+}
+
+MMapFileInputSource::~MMapFileInputSource()
+{
+}
+
+
+// ---------------------------------------------------------------------------
+//  MMapFileInputSource: InputSource interface implementation
+// ---------------------------------------------------------------------------
+BinInputStream* MMapFileInputSource::makeStream() const
+{
+    BinMMapInputStream* retStrm = new (getMemoryManager()) BinMMapInputStream(getSystemId(), getMemoryManager());
+    if (!retStrm->getIsOpen())
+    {
+        delete retStrm;
+        return LocalFileInputSource::makeStream();
+    }
+    return retStrm;
+}
+
+XERCES_CPP_NAMESPACE_END
@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ * 
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+#if !defined(XERCESC_INCLUDE_GUARD_MMAPFILEINPUTSOURCE_HPP)
+#define XERCESC_INCLUDE_GUARD_MMAPFILEINPUTSOURCE_HPP
+
+#include <xercesc/framework/LocalFileInputSource.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+/**
+ *  A local file input source reading through a memory mapping of the file
+ *  (BinMMapInputStream) instead of buffered reads. The path is resolved like
+ *  for LocalFileInputSource, and if the file cannot be mapped the stream of
+ *  LocalFileInputSource is used. Together with larger reader buffers (see
+ *  setReaderBufferSizes() of the parsers) this reduces the system calls and
+ *  copies for large documents.
+ */
+class XMLPARSER_EXPORT MMapFileInputSource : public LocalFileInputSource
+{
+public :
+    // -----------------------------------------------------------------------
+    //  Constructors and Destructor
+    // -----------------------------------------------------------------------
+
+    /** @name Constructors */
+    //@{
+
+    /**
+      * @see LocalFileInputSource::LocalFileInputSource(basePath, relativePath, manager)
+      */
+    MMapFileInputSource
+    (
+        const   XMLCh* const   basePath
+        , const XMLCh* const   relativePath
+        , MemoryManager* const manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    /**
+      * @see LocalFileInputSource::LocalFileInputSource(filePath, manager)
+      */
+    MMapFileInputSource
+    (
+        const   XMLCh* const   filePath
+        , MemoryManager* const manager = XMLPlatformUtils::fgMemoryManager
+    );
+    //@}
+
+    /** @name Destructor */
+    //@{
+    ~MMapFileInputSource();
+    //@}
+
+
+    // -----------------------------------------------------------------------
+    //  Virtual input source interface
+    // -----------------------------------------------------------------------
+
+    /** @name Virtual methods */
+    //@{
+
+    /**
+      * This method will return a memory mapped input stream for the file,
+      * or the stream of LocalFileInputSource if the file cannot be mapped.
+      *
+      * @return A dynamically allocated binary input stream derivative that
+      *         can parse from the file indicated by the system id.
+      */
+    virtual BinInputStream* makeStream() const;
+
+    //@}
+
+private:
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    MMapFileInputSource(const MMapFileInputSource&);
+    MMapFileInputSource& operator=(const MMapFileInputSource&);
+};
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
@@ -0,0 +1,458 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ * 
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xercesc/framework/XMLCachingEntityResolver.hpp>
+#include <xercesc/framework/MemBufInputSource.hpp>
+#include <xercesc/framework/XMLBuffer.hpp>
+#include <xercesc/util/BinInputStream.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/TransService.hpp>
+#include <xercesc/util/XMLNetAccessor.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLURL.hpp>
+#include <xercesc/util/XMLUniDefs.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Local data
+//
+//  An entry file holds five header lines (magic, URL, ETag, encoding and the
+//  time of the last fetch or revalidation in seconds) followed by the data.
+// ---------------------------------------------------------------------------
+static const char gEntryMagic[] = "XERCES-ENTITY-CACHE 1";
+static const char gEntrySuffix[] = ".entity";
+
+static const unsigned long gDefaultMaxAge = 24 * 60 * 60;
+
+
+// ---------------------------------------------------------------------------
+//  A cached or fetched resource
+// ---------------------------------------------------------------------------
+struct XMLCachingEntityResolver::Entry
+{
+    Entry(MemoryManager* const manager)
+        : data(0), size(0), etag(0), encoding(0), fetched(0), memoryManager(manager)
+    {
+    }
+
+    ~Entry()
+    {
+        // data is allocated with new[] since MemBufInputSource adopts it
+        delete [] data;
+        memoryManager->deallocate(etag);
+        memoryManager->deallocate(encoding);
+    }
+
+    XMLByte*        data;
+    XMLSize_t       size;
+    char*           etag;
+    char*           encoding;
+    unsigned long   fetched;
+    MemoryManager*  memoryManager;
+};
+
+
+// ---------------------------------------------------------------------------
+//  Local functions
+// ---------------------------------------------------------------------------
+
+// Returns the next line and null terminates it, or 0 if there is no newline
+static char* nextLine(char*& cursor, char* const end)
+{
+    char* line = cursor;
+    while (cursor < end && *cursor != '\n')
+        ++cursor;
+    if (cursor == end)
+        return 0;
+    *cursor++ = 0;
+    return line;
+}
+
+// Transcodes to UTF-8, or returns 0 for a null or empty string
+static char* transcodeToUTF8(const XMLCh* const str, MemoryManager* const manager)
+{
+    if (str == 0 || *str == 0)
+        return 0;
+    return (char*)TranscodeToStr(str, "UTF-8", manager).adopt();
+}
+
+
+// ---------------------------------------------------------------------------
+//  XMLCachingEntityResolver: Constructor and Destructor
+// ---------------------------------------------------------------------------
+XMLCachingEntityResolver::XMLCachingEntityResolver( const XMLCh* const    cacheDir
+                                                  , XMLEntityResolver*    next
+                                                  , MemoryManager* const  manager)
+    : fCacheDir(0)
+    , fNext(next)
+    , fOffline(false)
+    , fMaxAge(gDefaultMaxAge)
+    , fCacheHits(0)
+    , fRevalidations(0)
+    , fFetches(0)
+    , fMutex(manager)
+    , fMemoryManager(manager)
+{
+    XMLBuffer dir(1023, fMemoryManager);
+    dir.set(cacheDir);
+    const XMLSize_t len = dir.getLen();
+    if (len > 0 && dir.getRawBuffer()[len - 1] != chForwardSlash && dir.getRawBuffer()[len - 1] != chBackSlash)
+        dir.append(chForwardSlash);
+    fCacheDir = XMLString::replicate(dir.getRawBuffer(), fMemoryManager);
+}
+
+XMLCachingEntityResolver::~XMLCachingEntityResolver()
+{
+    fMemoryManager->deallocate(fCacheDir);
+}
+
+
+// ---------------------------------------------------------------------------
+//  XMLCachingEntityResolver: Settings
+// ---------------------------------------------------------------------------
+void XMLCachingEntityResolver::setOffline(const bool offline)
+{
+    fOffline = offline;
+}
+
+void XMLCachingEntityResolver::setMaxAge(const unsigned long maxAge)
+{
+    fMaxAge = maxAge;
+}
+
+
+// ---------------------------------------------------------------------------
+//  XMLCachingEntityResolver: Implementation of the XMLEntityResolver interface
+// ---------------------------------------------------------------------------
+InputSource* XMLCachingEntityResolver::resolveEntity(XMLResourceIdentifier* resourceIdentifier)
+{
+    if (fNext)
+    {
+        InputSource* src = fNext->resolveEntity(resourceIdentifier);
+        if (src)
+            return src;
+    }
+
+    const XMLCh* systemId = resourceIdentifier->getSystemId();
+    if (systemId == 0 || *systemId == 0)
+        return 0;
+
+    // Only remote resources are cached
+    XMLURL url(fMemoryManager);
+    if (!url.setURL(resourceIdentifier->getBaseURI(), systemId, url) || url.isRelative())
+        return 0;
+
+    const XMLURL::Protocols protocol = url.getProtocol();
+    if (protocol != XMLURL::HTTP && protocol != XMLURL::HTTPS && protocol != XMLURL::FTP)
+        return 0;
+
+    TranscodeToStr urlText(url.getURLText(), "UTF-8", fMemoryManager);
+    const char* key = (const char*)urlText.str();
+
+    XMLCh* path = makeEntryPath(key, gEntrySuffix);
+    ArrayJanitor<XMLCh> janPath(path, fMemoryManager);
+
+    Entry cached(fMemoryManager);
+    const bool haveCached = readEntry(path, key, cached);
+
+    const unsigned long now = (unsigned long)time(0);
+    const bool online = !fOffline && XMLPlatformUtils::fgNetAccessor != 0;
+
+    if (haveCached && (!online || (now >= cached.fetched && now - cached.fetched < fMaxAge)))
+    {
+        count(fCacheHits);
+        return makeInputSource(url, cached);
+    }
+
+    if (!online)
+        return 0;
+
+    // Fetch the resource, only if it has changed if there is an ETag
+    Entry fetched(fMemoryManager);
+    try
+    {
+        XMLNetHTTPInfo httpInfo;
+        char* condition = 0;
+        if (haveCached && cached.etag)
+        {
+            const XMLSize_t etagLen = XMLString::stringLen(cached.etag);
+            condition = (char*)fMemoryManager->allocate((etagLen + 18) * sizeof(char));
+            strcpy(condition, "If-None-Match: ");
+            strcat(condition, cached.etag);
+            strcat(condition, "\r\n");
+            httpInfo.fHeaders = condition;
+            httpInfo.fHeadersLen = strlen(condition);
+        }
+        ArrayJanitor<char> janCondition(condition, fMemoryManager);
+
+        BinInputStream* stream = XMLPlatformUtils::fgNetAccessor->makeNew(url, condition ? &httpInfo : 0);
+        Janitor<BinInputStream> janStream(stream);
+
+        if (haveCached && stream->isNotModified())
+        {
+            cached.fetched = now;
+            writeEntry(path, key, cached);
+            count(fRevalidations);
+            return makeInputSource(url, cached);
+        }
+
+        XMLSize_t capacity = 16 * 1024;
+        fetched.data = new XMLByte[capacity];
+        while (true)
+        {
+            if (fetched.size == capacity)
+            {
+                XMLByte* grown = new XMLByte[capacity * 2];
+                memcpy(grown, fetched.data, fetched.size);
+                delete [] fetched.data;
+                fetched.data = grown;
+                capacity *= 2;
+            }
+
+            const XMLSize_t read = stream->readBytes(fetched.data + fetched.size, capacity - fetched.size);
+            if (read == 0)
+                break;
+            fetched.size += read;
+        }
+
+        fetched.etag = transcodeToUTF8(stream->getETag(), fMemoryManager);
+        fetched.encoding = transcodeToUTF8(stream->getEncoding(), fMemoryManager);
+    }
+    catch (const XMLException&)
+    {
+        // Without the network, the cached entry is used whatever its age
+        if (!haveCached)
+            throw;
+
+        count(fCacheHits);
+        return makeInputSource(url, cached);
+    }
+
+    fetched.fetched = now;
+    writeEntry(path, key, fetched);
+    count(fFetches);
+    return makeInputSource(url, fetched);
+}
+
+
+// ---------------------------------------------------------------------------
+//  XMLCachingEntityResolver: Private helper methods
+// ---------------------------------------------------------------------------
+
+// The entry file name is a 64 bit FNV-1a hash of the URL; the URL itself is
+// stored in the entry and checked on reading
+XMLCh* XMLCachingEntityResolver::makeEntryPath(const char* const url, const char* const suffix) const
+{
+    XMLUInt64 hash = 14695981039346656037ULL;
+    for (const unsigned char* p = (const unsigned char*)url; *p; ++p)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+
+    static const XMLCh digits[] =
+    {
+        chDigit_0, chDigit_1, chDigit_2, chDigit_3, chDigit_4, chDigit_5, chDigit_6, chDigit_7,
+        chDigit_8, chDigit_9, chLatin_a, chLatin_b, chLatin_c, chLatin_d, chLatin_e, chLatin_f
+    };
+
+    XMLBuffer path(1023, fMemoryManager);
+    path.set(fCacheDir);
+    for (int shift = 60; shift >= 0; shift -= 4)
+        path.append(digits[(hash >> shift) & 0xF]);
+    for (const char* p = suffix; *p; ++p)
+        path.append(XMLCh(*p));
+
+    return XMLString::replicate(path.getRawBuffer(), fMemoryManager);
+}
+
+bool XMLCachingEntityResolver::readEntry(const XMLCh* const path, const char* const url, Entry& entry) const
+{
+    FileHandle file = XMLPlatformUtils::openFile(path, fMemoryManager);
+    if (file == 0)
+        return false;
+
+    XMLByte* buffer = 0;
+    XMLSize_t size = 0;
+    try
+    {
+        size = (XMLSize_t)XMLPlatformUtils::fileSize(file, fMemoryManager);
+        buffer = new XMLByte[size + 1];
+
+        XMLSize_t read = 0;
+        while (read < size)
+        {
+            const XMLSize_t count = XMLPlatformUtils::readFileBuffer(file, size - read, buffer + read, fMemoryManager);
+            if (count == 0)
+                break;
+            read += count;
+        }
+        size = read;
+
+        XMLPlatformUtils::closeFile(file, fMemoryManager);
+    }
+    catch (const XMLException&)
+    {
+        delete [] buffer;
+        return false;
+    }
+
+    char* cursor = (char*)buffer;
+    char* const end = cursor + size;
+    char* magic = nextLine(cursor, end);
+    char* entryURL = nextLine(cursor, end);
+    char* etag = nextLine(cursor, end);
+    char* encoding = nextLine(cursor, end);
+    char* fetched = nextLine(cursor, end);
+
+    if (fetched == 0 || strcmp(magic, gEntryMagic) != 0 || strcmp(entryURL, url) != 0)
+    {
+        delete [] buffer;
+        return false;
+    }
+
+    entry.etag = *etag ? XMLString::replicate(etag, fMemoryManager) : 0;
+    entry.encoding = *encoding ? XMLString::replicate(encoding, fMemoryManager) : 0;
+    entry.fetched = strtoul(fetched, 0, 10);
+
+    // Move the data to the start of the buffer, which the input source adopts
+    entry.size = end - cursor;
+    memmove(buffer, cursor, entry.size);
+    entry.data = buffer;
+
+    return true;
+}
+
+// Writes to a temporary file that is renamed, so that readers never see a
+// partial entry; failures only mean that the entry is not cached
+void XMLCachingEntityResolver::writeEntry(const XMLCh* const path, const char* const url, const Entry& entry) const
+{
+    char suffix[64];
+    char number[32];
+    strcpy(suffix, ".");
+    XMLString::binToText((unsigned long)XMLPlatformUtils::getCurrentMillis(), number, 31, 16, fMemoryManager);
+    strcat(suffix, number);
+    strcat(suffix, ".");
+    XMLString::binToText((unsigned long)(XMLSize_t)&entry, number, 31, 16, fMemoryManager);
+    strcat(suffix, number);
+    strcat(suffix, ".tmp");
+
+    XMLBuffer tmpPath(1023, fMemoryManager);
+    tmpPath.set(path);
+    for (const char* p = suffix; *p; ++p)
+        tmpPath.append(XMLCh(*p));
+
+    char* nativePath = XMLString::transcode(path, fMemoryManager);
+    ArrayJanitor<char> janNativePath(nativePath, fMemoryManager);
+    char* nativeTmpPath = XMLString::transcode(tmpPath.getRawBuffer(), fMemoryManager);
+    ArrayJanitor<char> janNativeTmpPath(nativeTmpPath, fMemoryManager);
+
+    FileHandle file = 0;
+    try
+    {
+        file = XMLPlatformUtils::openFileToWrite(tmpPath.getRawBuffer(), fMemoryManager);
+    }
+    catch (const XMLException&)
+    {
+    }
+    if (file == 0)
+        return;
+
+    bool written = false;
+    try
+    {
+        XMLString::binToText(entry.fetched, number, 31, 10, fMemoryManager);
+
+        const char* lines[] = { gEntryMagic, url, entry.etag ? entry.etag : "", entry.encoding ? entry.encoding : "", number };
+        for (unsigned int i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i)
+        {
+            XMLPlatformUtils::writeBufferToFile(file, strlen(lines[i]), (const XMLByte*)lines[i], fMemoryManager);
+            XMLPlatformUtils::writeBufferToFile(file, 1, (const XMLByte*)"\n", fMemoryManager);
+        }
+        if (entry.size > 0)
+            XMLPlatformUtils::writeBufferToFile(file, entry.size, entry.data, fMemoryManager);
+
+        XMLPlatformUtils::closeFile(file, fMemoryManager);
+        written = true;
+    }
+    catch (const XMLException&)
+    {
+        try
+        {
+            XMLPlatformUtils::closeFile(file, fMemoryManager);
+        }
+        catch (const XMLException&)
+        {
+        }
+    }
+
+    // rename() does not replace an existing file on all platforms
+    if (written && rename(nativeTmpPath, nativePath) != 0)
+    {
+        remove(nativePath);
+        written = (rename(nativeTmpPath, nativePath) == 0);
+    }
+
+    if (!written)
+        remove(nativeTmpPath);
+}
+
+InputSource* XMLCachingEntityResolver::makeInputSource(const XMLURL& url, Entry& entry) const
+{
+    MemBufInputSource* src = new (fMemoryManager) MemBufInputSource
+    (
+        entry.data
+        , entry.size
+        , url.getURLText()
+        , true
+        , fMemoryManager
+    );
+    entry.data = 0;
+
+    // The buffer lives as long as the input source, no need for a copy
+    src->setCopyBufToStream(false);
+
+    if (entry.encoding)
+    {
+        TranscodeFromStr encoding((const XMLByte*)entry.encoding, XMLString::stringLen(entry.encoding), "UTF-8", fMemoryManager);
+        src->setEncoding(encoding.str());
+    }
+
+    return src;
+}
+
+void XMLCachingEntityResolver::count(XMLSize_t& counter)
+{
+    XMLMutexLock lock(&fMutex);
+    ++counter;
+}
+
+XERCES_CPP_NAMESPACE_END
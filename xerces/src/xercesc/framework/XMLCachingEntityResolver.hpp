@@ -0,0 +1,199 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ * 
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+#if !defined(XERCESC_INCLUDE_GUARD_XMLCACHINGENTITYRESOLVER_HPP)
+#define XERCESC_INCLUDE_GUARD_XMLCACHINGENTITYRESOLVER_HPP
+
+#include <xercesc/util/XMLEntityResolver.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/Mutexes.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+class XMLURL;
+class BinInputStream;
+
+/**
+ *  An entity resolver that keeps remote (HTTP, HTTPS and FTP) schemas,
+ *  DTDs and entities in an on-disk cache, keyed by URL. Each entry stores
+ *  the ETag of the response. Once an entry is older than the maximum age,
+ *  it is revalidated with a conditional request ("If-None-Match"), so a
+ *  server that has no change answers without sending the data again.
+ *
+ *  If the resource cannot be fetched, a cached entry is used regardless
+ *  of its age. In offline mode the network is never used. Together, these
+ *  rules let validation start without a network connection once the
+ *  schemas have been cached.
+ *
+ *  Other system ids (local files, relative ids that cannot be resolved)
+ *  are left to the parser. A chained resolver, for example one for an XML
+ *  catalog, is asked first. Set the resolver with setXMLEntityResolver()
+ *  of the parser. Resolving is thread safe, so one resolver can serve
+ *  several parsers.
+ */
+class XMLPARSER_EXPORT XMLCachingEntityResolver : public XMemory, public XMLEntityResolver
+{
+public :
+    // -----------------------------------------------------------------------
+    /** @name Constructor and Destructor */
+    // -----------------------------------------------------------------------
+    //@{
+
+    /**
+      * @param cacheDir  The directory of the cache, which must exist.
+      * @param next      A resolver that is asked first, or 0. It is not
+      *                  adopted.
+      * @param manager   The memory manager used for the returned input
+      *                  sources and for fetching.
+      */
+    XMLCachingEntityResolver
+    (
+        const   XMLCh* const        cacheDir
+        ,       XMLEntityResolver*  next = 0
+        ,       MemoryManager* const manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    ~XMLCachingEntityResolver();
+    //@}
+
+    // -----------------------------------------------------------------------
+    /** @name Implementation of the XMLEntityResolver interface */
+    // -----------------------------------------------------------------------
+    //@{
+
+    /**
+      * Return an input source with the cached or fetched contents of a
+      * remote resource. The system id of the input source is the URL, so
+      * relative references in the resource resolve as usual.
+      *
+      * @return The input source, or 0 to let the parser open the resource.
+      * @exception NetAccessorException If the resource cannot be fetched
+      *            and is not in the cache.
+      */
+    virtual InputSource* resolveEntity(XMLResourceIdentifier* resourceIdentifier);
+    //@}
+
+    // -----------------------------------------------------------------------
+    /** @name Settings */
+    // -----------------------------------------------------------------------
+    //@{
+
+    /**
+      * In offline mode, only cached resources are resolved. Others are left
+      * to the parser. Off by default.
+      */
+    void setOffline(const bool offline);
+    bool getOffline() const;
+
+    /**
+      * Cached entries younger than maxAge seconds are used without asking
+      * the server. 0 revalidates every entry on each use. The default is
+      * one day.
+      */
+    void setMaxAge(const unsigned long maxAge);
+    unsigned long getMaxAge() const;
+    //@}
+
+    // -----------------------------------------------------------------------
+    /** @name Statistics */
+    // -----------------------------------------------------------------------
+    //@{
+
+    /** Number of resources resolved from the cache without a request */
+    XMLSize_t getCacheHits() const;
+
+    /** Number of cached resources the server confirmed as unchanged */
+    XMLSize_t getRevalidations() const;
+
+    /** Number of resources fetched (new or changed) */
+    XMLSize_t getFetches() const;
+    //@}
+
+private :
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    XMLCachingEntityResolver(const XMLCachingEntityResolver&);
+    XMLCachingEntityResolver& operator=(const XMLCachingEntityResolver&);
+
+    // -----------------------------------------------------------------------
+    //  Private helper methods
+    // -----------------------------------------------------------------------
+    struct Entry;
+
+    XMLCh* makeEntryPath(const char* const url, const char* const suffix) const;
+    bool readEntry(const XMLCh* const path, const char* const url, Entry& entry) const;
+    void writeEntry(const XMLCh* const path, const char* const url, const Entry& entry) const;
+    InputSource* makeInputSource(const XMLURL& url, Entry& entry) const;
+    void count(XMLSize_t& counter);
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fCacheDir
+    //      The cache directory, with a trailing path separator
+    //  fNext
+    //      The chained resolver, or 0
+    //  fOffline, fMaxAge
+    //      The settings
+    //  fCacheHits, fRevalidations, fFetches
+    //      The statistics, guarded by fMutex
+    // -----------------------------------------------------------------------
+    XMLCh*              fCacheDir;
+    XMLEntityResolver*  fNext;
+    bool                fOffline;
+    unsigned long       fMaxAge;
+    XMLSize_t           fCacheHits;
+    XMLSize_t           fRevalidations;
+    XMLSize_t           fFetches;
+    XMLMutex            fMutex;
+    MemoryManager*      fMemoryManager;
+};
+
+inline bool XMLCachingEntityResolver::getOffline() const
+{
+    return fOffline;
+}
+
+inline unsigned long XMLCachingEntityResolver::getMaxAge() const
+{
+    return fMaxAge;
+}
+
+inline XMLSize_t XMLCachingEntityResolver::getCacheHits() const
+{
+    return fCacheHits;
+}
+
+inline XMLSize_t XMLCachingEntityResolver::getRevalidations() const
+{
+    return fRevalidations;
+}
+
+inline XMLSize_t XMLCachingEntityResolver::getFetches() const
+{
+    return fFetches;
+}
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
@@ -160,6 +160,7 @@ XMLFormatter::XMLFormatter( const   char* const             outEncoding
     , fQuoteRef(0)
     , fQuoteLen(0)
     , fIsXML11(false)
+    , fIsUTF8(false)
     , fMemoryManager(manager)
 {
     // Transcode the encoding string
@@ -190,6 +191,8 @@ XMLFormatter::XMLFormatter( const   char* const             outEncoding
     XMLCh* const tmpDocVer = XMLString::transcode(docVersion, fMemoryManager);
     ArrayJanitor<XMLCh> jname(tmpDocVer, fMemoryManager);
     fIsXML11 = XMLString::equals(tmpDocVer, XMLUni::fgVersion1_1);
+
+    initUTF8Format();
 }
 
 
@@ -215,6 +218,7 @@ XMLFormatter::XMLFormatter( const   XMLCh* const            outEncoding
     , fQuoteRef(0)
     , fQuoteLen(0)
     , fIsXML11(false)
+    , fIsUTF8(false)
     , fMemoryManager(manager)
 {
     // Try to create a transcoder for this encoding
@@ -242,6 +246,8 @@ XMLFormatter::XMLFormatter( const   XMLCh* const            outEncoding
     fOutEncoding = XMLString::replicate(outEncoding, fMemoryManager);
 
     fIsXML11 = XMLString::equals(docVersion, XMLUni::fgVersion1_1);
+
+    initUTF8Format();
 }
 
 XMLFormatter::XMLFormatter( const   char* const             outEncoding
@@ -265,6 +271,7 @@ XMLFormatter::XMLFormatter( const   char* const             outEncoding
     , fQuoteRef(0)
     , fQuoteLen(0)
     , fIsXML11(false)
+    , fIsUTF8(false)
     , fMemoryManager(manager)
 {
     // this constructor uses "1.0" for the docVersion
@@ -298,6 +305,8 @@ XMLFormatter::XMLFormatter( const   char* const             outEncoding
     //ArrayJanitor<XMLCh> jname(tmpDocVer, fMemoryManager);
     //fIsXML11 = XMLString::equals(tmpDocVer, XMLUni::fgVersion1_1);
     fIsXML11 = false;  // docVersion 1.0 is not 1.1!
+
+    initUTF8Format();
 }
 
 
@@ -322,6 +331,7 @@ XMLFormatter::XMLFormatter( const   XMLCh* const            outEncoding
     , fQuoteRef(0)
     , fQuoteLen(0)
     , fIsXML11(false)
+    , fIsUTF8(false)
     , fMemoryManager(manager)
 {
     // this constructor uses XMLUni::fgVersion1_0 for the docVersion
@@ -352,6 +362,8 @@ XMLFormatter::XMLFormatter( const   XMLCh* const            outEncoding
 
     //fIsXML11 = XMLString::equals(docVersion, XMLUni::fgVersion1_1);
     fIsXML11 = false;  // docVersion 1.0 is not 1.1!
+
+    initUTF8Format();
 }
 
 XMLFormatter::~XMLFormatter()
@@ -388,6 +400,23 @@ XMLFormatter::formatBuf(const   XMLCh* const    toFormat
     const UnRepFlags  actualUnRep = (unrepFlags == DefaultUnRep)
                                     ? fUnRepFlags : unrepFlags;
 
+    //
+    //  UTF-8 can represent every char, so the unrep flags do not matter and
+    //  the chars are escaped and encoded right here. Only a lone surrogate
+    //  sends the rest of the buffer down the general path below.
+    //
+    const XMLCh*    startPtr = toFormat;
+    XMLSize_t       srcCount = count;
+    if (fIsUTF8)
+    {
+        const XMLSize_t done = formatUTF8(startPtr, srcCount, actualEsc);
+        if (done == srcCount)
+            return;
+
+        startPtr += done;
+        srcCount -= done;
+    }
+
     //
     //  If the actual unrep action is that they want to provide char refs
     //  for unrepresentable chars, then this one is a much more difficult
@@ -395,7 +424,7 @@ XMLFormatter::formatBuf(const   XMLCh* const    toFormat
     //
     if (actualUnRep == UnRep_CharRef)
     {
-        specialFormat(toFormat, count, actualEsc);
+        specialFormat(startPtr, srcCount, actualEsc);
         return;
     }
 
@@ -403,8 +432,8 @@ XMLFormatter::formatBuf(const   XMLCh* const    toFormat
     //  If we don't have any escape flags set, then we can do the most
     //  efficient loop, else we have to do it the hard way.
     //
-    const XMLCh*    srcPtr = toFormat;
-    const XMLCh*    endPtr = toFormat + count;
+    const XMLCh*    srcPtr = startPtr;
+    const XMLCh*    endPtr = startPtr + srcCount;
     if (actualEsc == NoEscapes)
     {
         //
@@ -630,6 +659,158 @@ const XMLByte* XMLFormatter::getCharRef(XMLSize_t     &count,
    return ref;
 }
 
+void XMLFormatter::initUTF8Format()
+{
+    // the intrinsic UTF-8 transcoder is made under either name
+    const XMLCh* const encodingName = fXCoder->getEncodingName();
+    fIsUTF8 = XMLString::equals(encodingName, XMLUni::fgUTF8EncodingString)
+           || XMLString::equals(encodingName, XMLUni::fgUTF8EncodingString2);
+
+    //  Every char in the escape lists is below 0x40; the XML 1.1 control
+    //  chars above it are checked one by one in formatUTF8()
+    for (unsigned int escStyle = 0; escStyle < EscapeFlags_Count; escStyle++)
+    {
+        fEscapeMasks[escStyle] = 0;
+        if (escStyle == NoEscapes)
+            continue;
+
+        for (XMLCh toCheck = 0; toCheck < 0x40; toCheck++)
+        {
+            if (inEscapeList((EscapeFlags) escStyle, toCheck))
+                fEscapeMasks[escStyle] |= ((XMLUInt64) 1) << toCheck;
+        }
+    }
+}
+
+XMLSize_t XMLFormatter::formatUTF8(const  XMLCh* const    toFormat
+                                  , const XMLSize_t       count
+                                  , const EscapeFlags     escapeFlags)
+{
+    const XMLUInt64 escMask = fEscapeMasks[escapeFlags];
+    const bool escControls = fIsXML11 && escapeFlags != NoEscapes;
+
+    const XMLCh*    srcPtr = toFormat;
+    const XMLCh*    endPtr = toFormat + count;
+    XMLByte*        outPtr = fTmpBuf;
+
+    // at least 6 bytes, the longest char ref, are always free
+    XMLByte* const  outEnd = fTmpBuf + kTmpBufSize - 6;
+
+    while (srcPtr < endPtr)
+    {
+        if (outPtr >= outEnd)
+        {
+            writeUTF8(outPtr - fTmpBuf);
+            outPtr = fTmpBuf;
+        }
+
+        const XMLCh curCh = *srcPtr;
+        if (curCh < 0x80)
+        {
+            if (curCh < 0x40 && (escMask >> curCh) & 1)
+            {
+                switch (curCh)
+                {
+                    case chAmpersand :
+                        memcpy(outPtr, "&amp;", 5);
+                        outPtr += 5;
+                        break;
+
+                    case chSingleQuote :
+                        memcpy(outPtr, "&apos;", 6);
+                        outPtr += 6;
+                        break;
+
+                    case chDoubleQuote :
+                        memcpy(outPtr, "&quot;", 6);
+                        outPtr += 6;
+                        break;
+
+                    case chCloseAngle :
+                        memcpy(outPtr, "&gt;", 4);
+                        outPtr += 4;
+                        break;
+
+                    case chOpenAngle :
+                        memcpy(outPtr, "&lt;", 4);
+                        outPtr += 4;
+                        break;
+
+                    default:
+                        // control characters
+                        writeUTF8(outPtr - fTmpBuf);
+                        writeCharRef(curCh);
+                        outPtr = fTmpBuf;
+                        break;
+                }
+            }
+            else if (curCh == 0x7F && escControls && inEscapeList(escapeFlags, curCh))
+            {
+                writeUTF8(outPtr - fTmpBuf);
+                writeCharRef(curCh);
+                outPtr = fTmpBuf;
+            }
+            else
+            {
+                *outPtr++ = (XMLByte) curCh;
+            }
+            srcPtr++;
+        }
+        else if (curCh < 0x800)
+        {
+            if (curCh <= 0x9F && escControls && inEscapeList(escapeFlags, curCh))
+            {
+                writeUTF8(outPtr - fTmpBuf);
+                writeCharRef(curCh);
+                outPtr = fTmpBuf;
+            }
+            else
+            {
+                *outPtr++ = (XMLByte) (0xC0 | (curCh >> 6));
+                *outPtr++ = (XMLByte) (0x80 | (curCh & 0x3F));
+            }
+            srcPtr++;
+        }
+        else if ((curCh & 0xF800) != 0xD800)
+        {
+            *outPtr++ = (XMLByte) (0xE0 | (curCh >> 12));
+            *outPtr++ = (XMLByte) (0x80 | ((curCh >> 6) & 0x3F));
+            *outPtr++ = (XMLByte) (0x80 | (curCh & 0x3F));
+            srcPtr++;
+        }
+        else if (curCh <= 0xDBFF && srcPtr + 1 < endPtr
+                 && (*(srcPtr + 1) & 0xFC00) == 0xDC00)
+        {
+            const XMLUInt32 curVal = ((XMLUInt32) (curCh - 0xD800) << 10)
+                                   + (*(srcPtr + 1) - 0xDC00) + 0x10000;
+            *outPtr++ = (XMLByte) (0xF0 | (curVal >> 18));
+            *outPtr++ = (XMLByte) (0x80 | ((curVal >> 12) & 0x3F));
+            *outPtr++ = (XMLByte) (0x80 | ((curVal >> 6) & 0x3F));
+            *outPtr++ = (XMLByte) (0x80 | (curVal & 0x3F));
+            srcPtr += 2;
+        }
+        else
+        {
+            // a lone surrogate, left to the transcoder
+            break;
+        }
+    }
+
+    writeUTF8(outPtr - fTmpBuf);
+    return srcPtr - toFormat;
+}
+
+void XMLFormatter::writeUTF8(const XMLSize_t count)
+{
+    if (count)
+    {
+        // terminated like the output of handleUnEscapedChars()
+        fTmpBuf[count]     = 0; fTmpBuf[count + 1] = 0;
+        fTmpBuf[count + 2] = 0; fTmpBuf[count + 3] = 0;
+        fTarget->writeChars(fTmpBuf, count, this);
+    }
+}
+
 void XMLFormatter::specialFormat(const  XMLCh* const    toFormat
                                 , const XMLSize_t       count
                                 , const EscapeFlags     escapeFlags)
@@ -376,6 +376,17 @@ private :
         , const EscapeFlags     escapeFlags
     );
 
+    void initUTF8Format();
+
+    XMLSize_t formatUTF8
+    (
+        const   XMLCh* const    toFormat
+        , const XMLSize_t       count
+        , const EscapeFlags     escapeFlags
+    );
+
+    void writeUTF8(const XMLSize_t count);
+
 
     // -----------------------------------------------------------------------
     //  Private, non-virtual methods
@@ -417,6 +428,15 @@ private :
     //      for performance reason, we do not store the actual version string
     //      and do the string comparison again and again.
     //
+    //  fIsUTF8
+    //      The output encoding is UTF-8 with the intrinsic transcoder, so
+    //      formatBuf() escapes and encodes into fTmpBuf itself and writes
+    //      each call to the target in one piece.
+    //
+    //  fEscapeMasks
+    //      For each escape style, bit c is set if char c (below 0x40) is
+    //      escaped. Used by the UTF-8 path.
+    //
     // -----------------------------------------------------------------------
     EscapeFlags                 fEscapeFlags;
     XMLCh*                      fOutEncoding;
@@ -435,6 +455,8 @@ private :
     XMLByte*                    fQuoteRef;
     XMLSize_t                   fQuoteLen;
     bool                        fIsXML11;
+    bool                        fIsUTF8;
+    XMLUInt64                   fEscapeMasks[EscapeFlags_Count];
     MemoryManager*              fMemoryManager;
 };
 
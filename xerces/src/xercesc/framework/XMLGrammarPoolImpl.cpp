@@ -24,6 +24,9 @@
 //  Includes
 // ---------------------------------------------------------------------------
 #include <xercesc/framework/XMLGrammarPoolImpl.hpp>
+#include <xercesc/parsers/SAX2XMLReaderImpl.hpp>
+#include <xercesc/util/BinMemInputStream.hpp>
+#include <xercesc/sax/ErrorHandler.hpp>
 #include <xercesc/internal/XSerializeEngine.hpp>
 #include <xercesc/internal/XTemplateSerializer.hpp>
 #include <xercesc/validators/DTD/DTDGrammar.hpp>
@@ -181,6 +184,130 @@ void XMLGrammarPoolImpl::unlockPool()
     }
 }
 
+bool XMLGrammarPoolImpl::isLocked() const
+{
+    return fLocked;
+}
+
+// -----------------------------------------------------------------------
+// Preloading of grammars
+// -----------------------------------------------------------------------
+// Counts the errors of a preload and forwards them to the handler of the
+// application. The errors of the schemas are reported by TraverseSchema
+// directly to the parser, they are not in the error count of the scanner.
+class PreloadErrorHandler : public ErrorHandler
+{
+public:
+    PreloadErrorHandler(ErrorHandler* const userHandler)
+    : fUserHandler(userHandler)
+    , fErrorCount(0)
+    {
+    }
+
+    virtual void warning(const SAXParseException& exc)
+    {
+        if (fUserHandler)
+            fUserHandler->warning(exc);
+    }
+
+    virtual void error(const SAXParseException& exc)
+    {
+        fErrorCount++;
+        if (fUserHandler)
+            fUserHandler->error(exc);
+    }
+
+    virtual void fatalError(const SAXParseException& exc)
+    {
+        fErrorCount++;
+        if (fUserHandler)
+            fUserHandler->fatalError(exc);
+    }
+
+    virtual void resetErrors()
+    {
+        fErrorCount = 0;
+        if (fUserHandler)
+            fUserHandler->resetErrors();
+    }
+
+    XMLSize_t getErrorCount() const
+    {
+        return fErrorCount;
+    }
+
+private:
+    PreloadErrorHandler(const PreloadErrorHandler&);
+    PreloadErrorHandler& operator=(const PreloadErrorHandler&);
+
+    ErrorHandler* fUserHandler;
+    XMLSize_t     fErrorCount;
+};
+
+static void setUpPreloadParser(SAX2XMLReaderImpl& parser, PreloadErrorHandler& errorHandler)
+{
+    // reuse the grammars already in the pool for imports and includes
+    parser.setFeature(XMLUni::fgXercesUseCachedGrammarInParse, true);
+    parser.setFeature(XMLUni::fgXercesHandleMultipleImports, true);
+    parser.setErrorHandler(&errorHandler);
+}
+
+Grammar* XMLGrammarPoolImpl::loadGrammar(const InputSource&          source
+                                         , const Grammar::GrammarType grammarType
+                                         , ErrorHandler* const       errorHandler)
+{
+    // a locked pool does not adopt the grammar, it would be deleted
+    // together with the parser
+    if (fLocked)
+        return 0;
+
+    PreloadErrorHandler handler(errorHandler);
+    SAX2XMLReaderImpl parser(getMemoryManager(), this);
+    setUpPreloadParser(parser, handler);
+
+    Grammar* grammar = parser.loadGrammar(source, grammarType, true);
+    if (handler.getErrorCount())
+        return 0;
+
+    return grammar;
+}
+
+Grammar* XMLGrammarPoolImpl::loadGrammar(const XMLCh* const          systemId
+                                         , const Grammar::GrammarType grammarType
+                                         , ErrorHandler* const       errorHandler)
+{
+    if (fLocked)
+        return 0;
+
+    PreloadErrorHandler handler(errorHandler);
+    SAX2XMLReaderImpl parser(getMemoryManager(), this);
+    setUpPreloadParser(parser, handler);
+
+    Grammar* grammar = parser.loadGrammar(systemId, grammarType, true);
+    if (handler.getErrorCount())
+        return 0;
+
+    return grammar;
+}
+
+XMLSize_t XMLGrammarPoolImpl::loadGrammars(const XMLCh* const* const systemIds
+                                           , const XMLSize_t         count
+                                           , ErrorHandler* const     errorHandler
+                                           , const bool              lock)
+{
+    XMLSize_t loaded = 0;
+    for (XMLSize_t i = 0; i < count; i++)
+    {
+        if (loadGrammar(systemIds[i], Grammar::SchemaGrammarType, errorHandler))
+            loaded++;
+    }
+
+    if (lock && loaded == count)
+        lockPool();
+
+    return loaded;
+}
+
 // -----------------------------------------------------------------------
 // Implementation of Factory Interface
 // -----------------------------------------------------------------------
@@ -351,6 +478,17 @@ void XMLGrammarPoolImpl::deserializeGrammars(BinInputStream* const binIn)
     }
 }
 
+void XMLGrammarPoolImpl::loadSerializedGrammars(const XMLByte* const data
+                                                , const XMLSize_t    size
+                                                , const bool         lock)
+{
+    BinMemInputStream binIn(data, size, BinMemInputStream::BufOpt_Reference, getMemoryManager());
+    deserializeGrammars(&binIn);
+
+    if (lock)
+        lockPool();
+}
+
 
 void
 XMLGrammarPoolImpl::cleanUp()
@@ -23,10 +23,13 @@
 #define XERCESC_INCLUDE_GUARD_XMLGRAMMARPOOLIMPL_HPP
 
 #include <xercesc/framework/XMLGrammarPool.hpp>
+#include <xercesc/validators/common/Grammar.hpp>
 
 XERCES_CPP_NAMESPACE_BEGIN
 
 class XMLSynchronizedStringPool;
+class ErrorHandler;
+class InputSource;
 
 class XMLUTIL_EXPORT XMLGrammarPoolImpl : public XMLGrammarPool
 {
@@ -118,6 +121,81 @@ public :
 
     //@}
 
+    // -----------------------------------------------------------------------
+    /** @name  Preloading of grammars */
+    // -----------------------------------------------------------------------
+    //@{
+
+    /**
+      * loadGrammar
+      *
+      * Parse a grammar with a parser using this pool and cache it, together
+      * with the grammars it imports or includes. Grammars already in the pool
+      * are reused, so schemas importing a common one only traverse it once.
+      *
+      * This is the first half of the pattern for validating many documents
+      * against the same schemas, possibly on many threads:
+      *
+      *   1. load all the schemas with loadGrammar() or loadGrammars(),
+      *   2. call lockPool(),
+      *   3. pass the pool to the constructor of every XercesDOMParser,
+      *      SAX2XMLReader or DOMLSParser and enable the
+      *      XMLUni::fgXercesUseCachedGrammarInParse feature.
+      *
+      * A locked pool is only read by the parsers: retrieveGrammar() takes no
+      * lock and the URI string pool only synchronizes URIs that are not part
+      * of the cached grammars, so the parsers do not contend with each other.
+      * Each parser itself must still be used by one thread at a time.
+      *
+      * @param source: the input source of the grammar
+      * @param grammarType: the type of the grammar
+      * @param errorHandler: receives the errors of the grammar, can be null
+      * @return the grammar, or 0 if the pool is locked, the grammar could not
+      *         be loaded or it has errors. The grammars cached before an error
+      *         stay in the pool, clear() discards them.
+      */
+    Grammar*               loadGrammar(const InputSource&        source
+                                       , const Grammar::GrammarType grammarType = Grammar::SchemaGrammarType
+                                       , ErrorHandler* const     errorHandler = 0);
+
+    /**
+      * loadGrammar
+      *
+      * @param systemId: the system id (file name or URL) of the grammar
+      * @param grammarType: the type of the grammar
+      * @param errorHandler: receives the errors of the grammar, can be null
+      * @return the grammar, or 0 like loadGrammar(const InputSource&, ...)
+      */
+    Grammar*               loadGrammar(const XMLCh* const        systemId
+                                       , const Grammar::GrammarType grammarType = Grammar::SchemaGrammarType
+                                       , ErrorHandler* const     errorHandler = 0);
+
+    /**
+      * loadGrammars
+      *
+      * Load the schemas of the system ids with loadGrammar() and lock the pool
+      * if all of them were loaded.
+      *
+      * @param systemIds: the system ids (file names or URLs) of the schemas
+      * @param count: the number of system ids
+      * @param errorHandler: receives the errors of the schemas, can be null
+      * @param lock: lock the pool when all the schemas were loaded
+      * @return the number of schemas loaded
+      */
+    XMLSize_t              loadGrammars(const XMLCh* const* const systemIds
+                                        , const XMLSize_t        count
+                                        , ErrorHandler* const    errorHandler = 0
+                                        , const bool             lock = true);
+
+    /**
+      * isLocked
+      *
+      * @return true if lockPool() was called (or a locked pool was deserialized)
+      */
+    bool                   isLocked() const;
+
+    //@}
+
     // -----------------------------------------------------------------------
     /** @name  Implementation of Factory interface */
     // -----------------------------------------------------------------------
@@ -237,6 +315,25 @@ public :
     virtual void     serializeGrammars(BinOutputStream* const);
     virtual void     deserializeGrammars(BinInputStream* const);
 
+    /***
+      * Deserialize the grammars from a memory buffer, for instance a blob
+      * compiled into the application with xerces-grammar-compiler (see
+      * cmake/XercesGrammarBlob.cmake), and lock the pool. This replaces
+      * parsing and traversing the schemas at startup.
+      *
+      * The buffer is not copied and only needs to be valid during the call.
+      * The requirements and the exceptions are the ones of
+      * deserializeGrammars(), the blob must come from the same Xerces-C
+      * version and serialization level.
+      *
+      * @param data: the serialized grammars
+      * @param size: the size of the data in bytes
+      * @param lock: lock the pool after the grammars were deserialized
+      */
+    void             loadSerializedGrammars(const XMLByte* const data
+                                            , const XMLSize_t    size
+                                            , const bool         lock = true);
+
 private:
 
     virtual void    createXSModel();
@@ -45,6 +45,13 @@
 #include <xercesc/validators/schema/identity/IC_Selector.hpp>
 #include <xercesc/util/OutOfMemoryException.hpp>
 
+//  Chrome trace events of the enclosing build, recorded with OMS_TRACE
+#ifdef OMS_TRACE
+#include <omstrace.h>
+#else
+#define OMS_TRACE_SCOPE(category, name)
+#endif
+
 XERCES_CPP_NAMESPACE_BEGIN
 
 
@@ -184,6 +191,8 @@ const NameIdPool<DTDEntityDecl>* IGXMLScanner::getEntityDeclPool() const
 // ---------------------------------------------------------------------------
 void IGXMLScanner::scanDocument(const InputSource& src)
 {
+    OMS_TRACE_SCOPE("xerces", "IGXMLScanner::scanDocument");
+
     //  Bump up the sequence id for this parser instance. This will invalidate
     //  any previous progressive scan tokens.
     fSequenceId++;
@@ -59,6 +59,8 @@ ReaderMgr::ReaderMgr(MemoryManager* const manager) :
     , fThrowEOE(false)
     , fXMLVersion(XMLReader::XMLV1_0)
     , fStandardUriConformant(false)
+    , fCharBufSize(XMLReader::kCharBufSize)
+    , fRawBufSize(XMLReader::kRawBufSize)
     , fMemoryManager(manager)
 {
 }
@@ -416,6 +418,8 @@ XMLReader* ReaderMgr::createReader( const   InputSource&        src
                 , lowWaterMark
                 , fXMLVersion
                 , fMemoryManager
+                , fCharBufSize
+                , fRawBufSize
                 );
         }
         else
@@ -433,6 +437,8 @@ XMLReader* ReaderMgr::createReader( const   InputSource&        src
                 , lowWaterMark
                 , fXMLVersion
                 , fMemoryManager
+                , fCharBufSize
+                , fRawBufSize
                 );
         }
     }
@@ -770,6 +776,8 @@ ReaderMgr::createIntEntReader(  const   XMLCh* const        sysId
         , lowWaterMark
         , fXMLVersion
         , fMemoryManager
+        , fCharBufSize
+        , fRawBufSize
     );
 
     // If it failed for any reason, then return zero.
@@ -176,6 +176,8 @@ public :
     void getLastExtEntityInfo(LastExtEntityInfo& lastInfo) const;
     XMLFilePos getSrcOffset() const;
     bool getThrowEOE() const;
+    XMLSize_t getReaderCharBufSize() const;
+    XMLSize_t getReaderRawBufSize() const;
 
 
     // -----------------------------------------------------------------------
@@ -185,6 +187,7 @@ public :
     void setThrowEOE(const bool newValue);
     void setXMLVersion(const XMLReader::XMLVersion version);
     void setStandardUriConformant(const bool newValue);
+    void setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize);
 
     // -----------------------------------------------------------------------
     //  Implement the SAX Locator interface
@@ -251,6 +254,11 @@ private :
     //
     //  fStandardUriConformant
     //      This flag controls whether we force conformant URI
+    //
+    //  fCharBufSize
+    //  fRawBufSize
+    //      The character and raw byte buffer sizes of the readers created
+    //      from now on, see XMLReader.
     // -----------------------------------------------------------------------
     XMLEntityDecl*              fCurEntity;
     XMLReader*                  fCurReader;
@@ -261,6 +269,8 @@ private :
     bool                        fThrowEOE;
     XMLReader::XMLVersion       fXMLVersion;
     bool                        fStandardUriConformant;
+    XMLSize_t                   fCharBufSize;
+    XMLSize_t                   fRawBufSize;
     MemoryManager*              fMemoryManager;
 };
 
@@ -390,6 +400,22 @@ inline void ReaderMgr::setEntityHandler(XMLEntityHandler* const newHandler)
     fEntityHandler = newHandler;
 }
 
+inline XMLSize_t ReaderMgr::getReaderCharBufSize() const
+{
+    return fCharBufSize;
+}
+
+inline XMLSize_t ReaderMgr::getReaderRawBufSize() const
+{
+    return fRawBufSize;
+}
+
+inline void ReaderMgr::setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize)
+{
+    fCharBufSize = charBufSize;
+    fRawBufSize = rawBufSize;
+}
+
 inline void ReaderMgr::setXMLVersion(const XMLReader::XMLVersion version)
 {
     fXMLVersion = version;
@@ -95,9 +95,15 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
                     , const bool                  calculateSrcOfs
                     ,       XMLSize_t             lowWaterMark
                     , const XMLVersion            version
-                    ,       MemoryManager* const  manager) :
+                    ,       MemoryManager* const  manager
+                    , const XMLSize_t             charBufSize
+                    , const XMLSize_t             rawBufSize) :
     fCharIndex(0)
+    , fCharBuf(0)
+    , fCharBufSize(0)
     , fCharsAvail(0)
+    , fCharSizeBuf(0)
+    , fCharOfsBuf(0)
     , fCurCol(1)
     , fCurLine(1)
     , fEncodingStr(0)
@@ -105,6 +111,8 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
     , fNoMore(false)
     , fPublicId(XMLString::replicate(pubId, manager))
     , fRawBufIndex(0)
+    , fRawByteBuf(0)
+    , fRawBufSize(0)
     , fRawBytesAvail(0)
     , fLowWaterMark (lowWaterMark)
     , fReaderNum(0xFFFFFFFF)
@@ -121,7 +129,9 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
     , fTranscoder(0)
     , fType(type)
     , fMemoryManager(manager)
+    , fBuffers(0, manager)
 {
+    allocateBuffers(charBufSize, rawBufSize);
     setXMLVersion(version);
 
     // Do an initial load of raw bytes
@@ -177,9 +187,15 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
                     , const bool                  calculateSrcOfs
                     ,       XMLSize_t             lowWaterMark
                     , const XMLVersion            version
-                    ,       MemoryManager* const  manager) :
+                    ,       MemoryManager* const  manager
+                    , const XMLSize_t             charBufSize
+                    , const XMLSize_t             rawBufSize) :
     fCharIndex(0)
+    , fCharBuf(0)
+    , fCharBufSize(0)
     , fCharsAvail(0)
+    , fCharSizeBuf(0)
+    , fCharOfsBuf(0)
     , fCurCol(1)
     , fCurLine(1)
     , fEncoding(XMLRecognizer::UTF_8)
@@ -188,6 +204,8 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
     , fNoMore(false)
     , fPublicId(XMLString::replicate(pubId, manager))
     , fRawBufIndex(0)
+    , fRawByteBuf(0)
+    , fRawBufSize(0)
     , fRawBytesAvail(0)
     , fLowWaterMark (lowWaterMark)
     , fReaderNum(0xFFFFFFFF)
@@ -204,7 +222,9 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
     , fTranscoder(0)
     , fType(type)
     , fMemoryManager(manager)
+    , fBuffers(0, manager)
 {
+    allocateBuffers(charBufSize, rawBufSize);
     setXMLVersion(version);
 
     // Do an initial load of raw bytes
@@ -294,7 +314,7 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
         (
             fEncodingStr
             , failReason
-            , kCharBufSize
+            , fCharBufSize
             , fMemoryManager
         );
     }
@@ -307,7 +327,7 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
         (
             fEncoding
             , failReason
-            , kCharBufSize
+            , fCharBufSize
             , fMemoryManager
         );
 
@@ -360,9 +380,15 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
                     , const bool                  calculateSrcOfs
                     ,       XMLSize_t             lowWaterMark
                     , const XMLVersion            version
-                    ,       MemoryManager* const  manager) :
+                    ,       MemoryManager* const  manager
+                    , const XMLSize_t             charBufSize
+                    , const XMLSize_t             rawBufSize) :
     fCharIndex(0)
+    , fCharBuf(0)
+    , fCharBufSize(0)
     , fCharsAvail(0)
+    , fCharSizeBuf(0)
+    , fCharOfsBuf(0)
     , fCurCol(1)
     , fCurLine(1)
     , fEncoding(XMLRecognizer::UTF_8)
@@ -371,6 +397,8 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
     , fNoMore(false)
     , fPublicId(XMLString::replicate(pubId, manager))
     , fRawBufIndex(0)
+    , fRawByteBuf(0)
+    , fRawBufSize(0)
     , fRawBytesAvail(0)
     , fLowWaterMark (lowWaterMark)
     , fReaderNum(0xFFFFFFFF)
@@ -387,7 +415,9 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
     , fTranscoder(0)
     , fType(type)
     , fMemoryManager(manager)
+    , fBuffers(0, manager)
 {
+    allocateBuffers(charBufSize, rawBufSize);
     setXMLVersion(version);
 
     // Do an initial load of raw bytes
@@ -414,7 +444,7 @@ XMLReader::XMLReader(const  XMLCh* const          pubId
     (
         fEncoding
         , failReason
-        , kCharBufSize
+        , fCharBufSize
         , fMemoryManager
     );
 
@@ -501,7 +531,7 @@ bool XMLReader::refreshCharBuffer()
     const XMLSize_t spareChars = fCharsAvail - fCharIndex;
 
     // If we are full, then don't do anything.
-    if (spareChars == kCharBufSize)
+    if (spareChars == fCharBufSize)
         return true;
 
     //
@@ -524,7 +554,7 @@ bool XMLReader::refreshCharBuffer()
         (
             fEncodingStr
             , failReason
-            , kCharBufSize
+            , fCharBufSize
             , fMemoryManager
         );
 
@@ -572,7 +602,7 @@ bool XMLReader::refreshCharBuffer()
     (
         &fCharBuf[startInd]
         , &fCharSizeBuf[startInd]
-        , kCharBufSize - spareChars
+        , fCharBufSize - spareChars
     );
 
     // Add back in the spare chars
@@ -1130,7 +1160,7 @@ bool XMLReader::skippedSpace()
 
 bool XMLReader::skippedString(const XMLCh* const toSkip)
 {
-    // This function works on strings that are smaller than kCharBufSize.
+    // This function works on strings that are smaller than fCharBufSize.
     // This function guarantees that in case the comparison is unsuccessful
     // the fCharIndex will point to the original data.
     //
@@ -1183,7 +1213,7 @@ bool XMLReader::skippedString(const XMLCh* const toSkip)
 bool XMLReader::skippedStringLong(const XMLCh* toSkip)
 {
     // This function works on strings that are potentially longer than
-    // kCharBufSize (e.g., end tag). This function does not guarantee
+    // fCharBufSize (e.g., end tag). This function does not guarantee
     // that in case the comparison is unsuccessful the fCharIndex will
     // point to the original data.
     //
@@ -1195,7 +1225,7 @@ bool XMLReader::skippedStringLong(const XMLCh* toSkip)
     {
       // Fill up the buffer with as much data as possible.
       //
-      while (charsLeft < srcLen && charsLeft != kCharBufSize)
+      while (charsLeft < srcLen && charsLeft != fCharBufSize)
       {
         if (!refreshCharBuffer())
           return false;
@@ -1389,7 +1419,7 @@ bool XMLReader::setEncoding(const XMLCh* const newEncoding)
             (
                 fEncodingStr
                 , failReason
-                , kCharBufSize
+                , fCharBufSize
                 , fMemoryManager
             );
 
@@ -1415,7 +1445,7 @@ bool XMLReader::setEncoding(const XMLCh* const newEncoding)
         (
             newBaseEncoding
             , failReason
-            , kCharBufSize
+            , fCharBufSize
             , fMemoryManager
         );
 
@@ -1435,6 +1465,42 @@ bool XMLReader::setEncoding(const XMLCh* const newEncoding)
 //  XMLReader: Private helper methods
 // ---------------------------------------------------------------------------
 
+//
+//  This is called first by the constructors. The raw byte buffer and the
+//  character buffers are carved out of one allocation, the raw bytes and the
+//  offsets first so that they stay aligned for the UTF-16 and UCS-4 casts.
+//
+void XMLReader::allocateBuffers(XMLSize_t charBufSize, XMLSize_t rawBufSize)
+{
+    if (charBufSize < kMinBufSize)
+        charBufSize = kMinBufSize;
+    if (rawBufSize < kMinBufSize)
+        rawBufSize = kMinBufSize;
+
+    // Keep the arrays following the raw bytes aligned
+    rawBufSize = (rawBufSize + 7) & ~(XMLSize_t)7;
+
+    XMLByte* block = (XMLByte*) fMemoryManager->allocate
+    (
+        rawBufSize
+        + charBufSize * (sizeof(unsigned int) + sizeof(XMLCh) + sizeof(unsigned char))
+    );
+    fBuffers.reset(block, fMemoryManager);
+
+    fRawByteBuf = block;
+    fRawBufSize = rawBufSize;
+    block += rawBufSize;
+
+    fCharOfsBuf = (unsigned int*) block;
+    block += charBufSize * sizeof(unsigned int);
+
+    fCharBuf = (XMLCh*) block;
+    block += charBufSize * sizeof(XMLCh);
+
+    fCharSizeBuf = (unsigned char*) block;
+    fCharBufSize = charBufSize;
+}
+
 //
 //  This is called when the encoding flag is set and just sets the fSwapped
 //  flag appropriately.
@@ -1512,7 +1578,7 @@ void XMLReader::doInitDecode()
 
                 // Make sure we don't exhaust the limited prolog buffer size.
                 // Leave room for a space added at the end of this function.
-                if (fCharsAvail == kCharBufSize - 1) {
+                if (fCharsAvail == fCharBufSize - 1) {
                     fCharsAvail = 0;
                     fRawBufIndex = 0;
                     fMemoryManager->deallocate(fPublicId);
@@ -1605,7 +1671,7 @@ void XMLReader::doInitDecode()
 
                 // Make sure we don't exhaust the limited prolog buffer size.
                 // Leave room for a space added at the end of this function.
-                if (fCharsAvail == kCharBufSize - 1) {
+                if (fCharsAvail == fCharBufSize - 1) {
                     fCharsAvail = 0;
                     fRawBufIndex = 0;
                     fMemoryManager->deallocate(fPublicId);
@@ -1721,7 +1787,7 @@ void XMLReader::doInitDecode()
 
                 // Make sure we don't exhaust the limited prolog buffer size.
                 // Leave room for a space added at the end of this function.
-                if (fCharsAvail == kCharBufSize - 1) {
+                if (fCharsAvail == fCharBufSize - 1) {
                     fCharsAvail = 0;
                     fRawBufIndex = 0;
                     fMemoryManager->deallocate(fPublicId);
@@ -1773,7 +1839,7 @@ void XMLReader::doInitDecode()
 
                 // Make sure we don't exhaust the limited prolog buffer size.
                 // Leave room for a space added at the end of this function.
-                if (fCharsAvail == kCharBufSize - 1) {
+                if (fCharsAvail == fCharBufSize - 1) {
                     fCharsAvail = 0;
                     fRawBufIndex = 0;
                     fMemoryManager->deallocate(fPublicId);
@@ -1871,7 +1937,7 @@ void XMLReader::refreshRawBuffer()
     //
     fRawBytesAvail = fStream->readBytes
     (
-        &fRawByteBuf[bytesLeft], kRawBufSize - bytesLeft
+        &fRawByteBuf[bytesLeft], fRawBufSize - bytesLeft
     ) + bytesLeft;
 
     //
@@ -26,6 +26,7 @@
 #include <xercesc/framework/XMLRecognizer.hpp>
 #include <xercesc/framework/XMLBuffer.hpp>
 #include <xercesc/util/TranscodingException.hpp>
+#include <xercesc/util/Janitor.hpp>
 
 XERCES_CPP_NAMESPACE_BEGIN
 
@@ -110,6 +111,33 @@ public:
     bool isFirstNCNameChar(const XMLCh toCheck) const;
     bool isNCNameChar(const XMLCh toCheck) const;
 
+    // ---------------------------------------------------------------------------
+    //  Class Constants
+    //
+    //  kCharBufSize
+    //      The default size of the character spool buffer that we use. Its not
+    //      terribly large because its just getting filled with data from a raw
+    //      byte buffer as we go along. We don't want to decode all the text at
+    //      once before we find out that there is an error.
+    //
+    //      NOTE: This is a size in characters, not bytes.
+    //
+    //  kRawBufSize
+    //      The default size of the raw buffer from which raw bytes are spooled
+    //      out as we transcode chunks of data. As it is emptied, it is filled
+    //      back in again from the source stream, so its size is the size of
+    //      the reads from the stream.
+    //
+    //  kMinBufSize
+    //      Smaller buffer sizes passed to the constructors are raised to it.
+    // ---------------------------------------------------------------------------
+    enum Constants
+    {
+        kCharBufSize        = 16 * 1024
+        , kRawBufSize       = 48 * 1024
+        , kMinBufSize       = 1024
+    };
+
     // -----------------------------------------------------------------------
     //  Constructors and Destructor
     // -----------------------------------------------------------------------
@@ -126,6 +154,8 @@ public:
         ,       XMLSize_t             lowWaterMark = 100
         , const XMLVersion            xmlVersion = XMLV1_0
         ,       MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+        , const XMLSize_t             charBufSize = kCharBufSize
+        , const XMLSize_t             rawBufSize = kRawBufSize
     );
 
     XMLReader
@@ -142,6 +172,8 @@ public:
         ,       XMLSize_t             lowWaterMark = 100
         , const XMLVersion            xmlVersion = XMLV1_0
         ,       MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+        , const XMLSize_t             charBufSize = kCharBufSize
+        , const XMLSize_t             rawBufSize = kRawBufSize
     );
 
     XMLReader
@@ -158,6 +190,8 @@ public:
         ,       XMLSize_t             lowWaterMark = 100
         , const XMLVersion            xmlVersion = XMLV1_0
         ,       MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+        , const XMLSize_t             charBufSize = kCharBufSize
+        , const XMLSize_t             rawBufSize = kRawBufSize
     );
 
     ~XMLReader();
@@ -227,32 +261,13 @@ private:
     XMLReader(const XMLReader&);
     XMLReader& operator=(const XMLReader&);
 
-    // ---------------------------------------------------------------------------
-    //  Class Constants
-    //
-    //  kCharBufSize
-    //      The size of the character spool buffer that we use. Its not terribly
-    //      large because its just getting filled with data from a raw byte
-    //      buffer as we go along. We don't want to decode all the text at
-    //      once before we find out that there is an error.
-    //
-    //      NOTE: This is a size in characters, not bytes.
-    //
-    //  kRawBufSize
-    //      The size of the raw buffer from which raw bytes are spooled out
-    //      as we transcode chunks of data. As it is emptied, it is filled back
-    //      in again from the source stream.
-    // ---------------------------------------------------------------------------
-    enum Constants
-    {
-        kCharBufSize        = 16 * 1024
-        , kRawBufSize       = 48 * 1024
-    };
 
 
     // -----------------------------------------------------------------------
     //  Private helper methods
     // -----------------------------------------------------------------------
+    void allocateBuffers(XMLSize_t charBufSize, XMLSize_t rawBufSize);
+
     void checkForSwapped();
 
     void doInitCharSizeChecks();
@@ -295,6 +310,9 @@ private:
     //      A buffer that the reader manager fills up with transcoded
     //      characters a small amount at a time.
     //
+    //  fCharBufSize
+    //      The size in characters of fCharBuf, fCharSizeBuf and fCharOfsBuf.
+    //
     //  fCharsAvail
     //      The characters currently available in the character buffer.
     //
@@ -344,6 +362,9 @@ private:
     //      This is the raw byte buffer that is used to spool out bytes
     //      from into the fCharBuf buffer, as we transcode in blocks.
     //
+    //  fRawBufSize
+    //      The size of fRawByteBuf.
+    //
     //  fRawBytesAvail
     //      The number of bytes currently available in the raw buffer. This
     //      helps deal with the last buffer's worth, which will usually not
@@ -433,12 +454,18 @@ private:
     //
     //  fXMLVersion
     //      Enum to indicate if this Reader is conforming to XML 1.0 or XML 1.1
+    //
+    //  fBuffers
+    //      Owns the single allocation holding the raw byte buffer and the
+    //      character buffers, so that it is released when a constructor
+    //      throws as well.
     // -----------------------------------------------------------------------
     XMLSize_t                   fCharIndex;
-    XMLCh                       fCharBuf[kCharBufSize];
+    XMLCh*                      fCharBuf;
+    XMLSize_t                   fCharBufSize;
     XMLSize_t                   fCharsAvail;
-    unsigned char               fCharSizeBuf[kCharBufSize];
-    unsigned int                fCharOfsBuf[kCharBufSize];
+    unsigned char*              fCharSizeBuf;
+    unsigned int*               fCharOfsBuf;
     XMLFileLoc                  fCurCol;
     XMLFileLoc                  fCurLine;
     XMLRecognizer::Encodings    fEncoding;
@@ -447,7 +474,8 @@ private:
     bool                        fNoMore;
     XMLCh*                      fPublicId;
     XMLSize_t                   fRawBufIndex;
-    XMLByte                     fRawByteBuf[kRawBufSize];
+    XMLByte*                    fRawByteBuf;
+    XMLSize_t                   fRawBufSize;
     XMLSize_t                   fRawBytesAvail;
     XMLSize_t                   fLowWaterMark;
     XMLSize_t                   fReaderNum;
@@ -467,6 +495,7 @@ private:
     bool                        fNEL;
     XMLVersion                  fXMLVersion;
     MemoryManager*              fMemoryManager;
+    ArrayJanitor<XMLByte>       fBuffers;
 };
 
 
@@ -674,6 +674,7 @@ void XMLScanner::setParseSettings(XMLScanner* const refScanner)
     setValidationScheme(refScanner->getValidationScheme());
     setSecurityManager(refScanner->getSecurityManager());
     setPSVIHandler(refScanner->getPSVIHandler());
+    setReaderBufferSizes(refScanner->getReaderCharBufSize(), refScanner->getReaderRawBufSize());
 }
 
 // ---------------------------------------------------------------------------
@@ -279,6 +279,8 @@ public :
     // getProperty.
     //
     const XMLSize_t& getLowWaterMark() const;
+    XMLSize_t getReaderCharBufSize() const;
+    XMLSize_t getReaderRawBufSize() const;
 
     bool getGenerateSyntheticAnnotations() const;
     bool getValidateAnnotations() const;
@@ -385,6 +387,7 @@ public :
     void setStandardUriConformant(const bool newValue);
     void setInputBufferSize(const XMLSize_t bufferSize);
     void setLowWaterMark(XMLSize_t newValue);
+    void setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize);
 
     void setGenerateSyntheticAnnotations(const bool newValue);
     void setValidateAnnotations(const bool newValue);
@@ -1161,6 +1164,16 @@ inline const XMLSize_t& XMLScanner::getLowWaterMark() const
     return fLowWaterMark;
 }
 
+inline XMLSize_t XMLScanner::getReaderCharBufSize() const
+{
+    return fReaderMgr.getReaderCharBufSize();
+}
+
+inline XMLSize_t XMLScanner::getReaderRawBufSize() const
+{
+    return fReaderMgr.getReaderRawBufSize();
+}
+
 inline bool XMLScanner::getIgnoreCachedDTD() const
 {
     return fIgnoreCachedDTD;
@@ -1375,6 +1388,11 @@ inline void XMLScanner::setLowWaterMark(XMLSize_t newValue)
     fLowWaterMark = newValue;
 }
 
+inline void XMLScanner::setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize)
+{
+    fReaderMgr.setReaderBufferSizes(charBufSize, rawBufSize);
+}
+
 inline void XMLScanner::setIgnoredCachedDTD(const bool newValue)
 {
     fIgnoreCachedDTD = newValue;
@@ -105,6 +105,10 @@ AbstractDOMParser::AbstractDOMParser( XMLValidator* const   valToAdopt
 , fBufMgr(manager)
 , fInternalSubset(fBufMgr.bidOnBuffer())
 , fPSVIHandler(0)
+, fDocHeapBlockSize(0)
+, fDocHeapMaxBlockSize(0)
+, fDocMaxSubAllocationSize(0)
+, fCreateElementIndex(false)
 {
     CleanupType cleanup(this, &AbstractDOMParser::cleanUp);
 
@@ -455,6 +459,33 @@ void AbstractDOMParser::setLowWaterMark(XMLSize_t lwm)
     fScanner->setLowWaterMark(lwm);
 }
 
+void AbstractDOMParser::setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize)
+{
+    fScanner->setReaderBufferSizes(charBufSize, rawBufSize);
+}
+
+void AbstractDOMParser::useFastTrustedProfile(const bool doNamespaces)
+{
+    useScanner(XMLUni::fgWFXMLScanner);
+
+    setValidationScheme(Val_Never);
+    setDoSchema(false);
+    setValidationSchemaFullChecking(false);
+    setIdentityConstraintChecking(false);
+    setLoadExternalDTD(false);
+    setLoadSchema(false);
+    setDoNamespaces(doNamespaces);
+}
+
+void AbstractDOMParser::setDocumentHeapSizes(const XMLSize_t blockSize
+                                             , const XMLSize_t maxBlockSize
+                                             , const XMLSize_t maxSubAllocationSize)
+{
+    fDocHeapBlockSize = blockSize;
+    fDocHeapMaxBlockSize = maxBlockSize;
+    fDocMaxSubAllocationSize = maxSubAllocationSize;
+}
+
 void AbstractDOMParser::setLoadExternalDTD(const bool newState)
 {
     fScanner->setLoadExternalDTD(newState);
@@ -503,6 +534,11 @@ void AbstractDOMParser::setCreateSchemaInfo(const bool create)
         fScanner->setPSVIHandler(0);
 }
 
+void AbstractDOMParser::setCreateElementIndex(const bool create)
+{
+    fCreateElementIndex = create;
+}
+
 void AbstractDOMParser::setIgnoreAnnotations(const bool newValue)
 {
     fScanner->setIgnoreAnnotations(newValue);
@@ -941,6 +977,16 @@ void AbstractDOMParser::startDocument()
     else
         fDocument = (DOMDocumentImpl *)DOMImplementationRegistry::getDOMImplementation(fImplementationFeatures)->createDocument(fMemoryManager);
 
+    // the block size first, the sub-allocation size is checked against it
+    if (fDocHeapMaxBlockSize)
+        fDocument->setMaxMemoryAllocationBlockSize(fDocHeapMaxBlockSize);
+    if (fDocHeapBlockSize)
+        fDocument->setMemoryAllocationBlockSize(fDocHeapBlockSize);
+    if (fDocMaxSubAllocationSize)
+        fDocument->setMaxSubAllocationSize(fDocMaxSubAllocationSize);
+    if (fCreateElementIndex)
+        fDocument->setElementIndexEnabled(true);
+
     // Just set the document as the current parent and current node
     fCurrentParent = fDocument;
     fCurrentNode   = fDocument;
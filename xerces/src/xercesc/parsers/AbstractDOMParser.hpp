@@ -438,6 +438,16 @@ public :
       */
     bool getCreateSchemaInfo() const;
 
+    /** Get the 'create element index' flag
+      *
+      * This method returns the flag that specifies whether the documents
+      * produced by the parser keep an index of their elements by tag name.
+      *
+      * @return  The state of the create element index flag.
+      * @see #setCreateElementIndex
+      */
+    bool getCreateElementIndex() const;
+
     /** Get the 'do XInclude' flag
       *
       * This method returns the flag that specifies whether
@@ -793,6 +803,61 @@ public :
       */
     void setLowWaterMark(XMLSize_t lwm);
 
+    /** Set the sizes of the reader buffers
+      *
+      * This method sets the sizes of the buffers of the readers created for
+      * the documents and external entities parsed from now on. The raw
+      * buffer size is the size of the reads from the input stream, larger
+      * buffers mean fewer reads and transcoder calls for large documents.
+      * Sizes below 1 kilobyte are raised to it.
+      *
+      * The parser's default sizes are 16K characters and 48K bytes.
+      *
+      * @param charBufSize The size in characters of the transcoded character buffer
+      * @param rawBufSize The size in bytes of the raw byte buffer
+      */
+    void setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize);
+
+    /** Use the fast trusted parser profile
+      *
+      * This method configures the parser for fast well-formedness checking
+      * of trusted documents. It selects the WFXMLScanner, which creates no
+      * validators, skips the DOCTYPE declaration and only knows the
+      * predefined entities, and it turns off validation, schema processing
+      * and the loading of external DTDs and schemas. Without namespace
+      * processing the names are not split and no namespace URIs are
+      * looked up or interned.
+      *
+      * Documents that rely on their DTD for default attributes or entity
+      * declarations are not reported correctly in this profile. The other
+      * settings of the parser are kept.
+      *
+      * @param doNamespaces Whether namespace processing is done
+      * @see #useScanner
+      */
+    void useFastTrustedProfile(const bool doNamespaces = true);
+
+    /** Set the heap sizes of the documents created by this parser
+      *
+      * The nodes and strings of a DOM document are carved out of chunks of
+      * memory that start at the block size and double up to the maximum
+      * block size; requests larger than the maximum sub-allocation size get
+      * a block of their own. Large documents are built with fewer calls to
+      * the memory manager with larger chunks. The sizes apply to the
+      * documents created from the next parse on, a value of zero keeps the
+      * default given to XMLPlatformUtils::Initialize().
+      *
+      * @param blockSize The size of the first chunk
+      * @param maxBlockSize The size up to which the chunks grow
+      * @param maxSubAllocationSize The size above which a request gets a
+      *                             block of its own
+      *
+      * @see DOMMemoryManager
+      */
+    void setDocumentHeapSizes(const XMLSize_t blockSize
+                              , const XMLSize_t maxBlockSize
+                              , const XMLSize_t maxSubAllocationSize);
+
     /** Set the 'Loading External DTD' flag
       *
       * This method allows users to enable or disable the loading of external DTD.
@@ -905,6 +970,26 @@ public :
       */
     void  setCreateSchemaInfo(const bool newState);
 
+    /** Set the 'create element index' flag
+      *
+      * When set, each document produced by the parser keeps an index of its
+      * elements by tag name. The node lists of getElementsByTagName and
+      * getElementsByTagNameNS then find their elements through the index
+      * instead of walking the tree, in time proportional to the number of
+      * elements with the same local name, also after the tree has changed.
+      * The index is built by the first such lookup and updated on every
+      * insertion and removal of nodes afterwards. Lists for "*" still walk
+      * the tree.
+      *
+      * The parser's default state is: false.
+      *
+      * @param newState The value specifying whether the documents keep an
+      *                 element index.
+      *
+      * @see #getCreateElementIndex
+      */
+    void  setCreateElementIndex(const bool newState);
+
     /** Set the 'do XInclude' flag
       *
       * This method allows users to specify whether
@@ -1759,6 +1844,14 @@ protected:
 	//   fDoXinclude
 	//      A bool used to request that XInlcude processing occur on the
 	//      Document the parser parses.
+    //
+    //  fDocHeapBlockSize
+    //  fDocHeapMaxBlockSize
+    //  fDocMaxSubAllocationSize
+    //      The heap sizes given to each new fDocument, zero for the default.
+    //
+    //  fCreateElementIndex
+    //      Indicates whether each new fDocument keeps an element index.
     // -----------------------------------------------------------------------
     bool                          fCreateEntityReferenceNodes;
     bool                          fIncludeIgnorableWhitespace;
@@ -1784,6 +1877,10 @@ protected:
     XMLBufferMgr                  fBufMgr;
     XMLBuffer&                    fInternalSubset;
     PSVIHandler*                  fPSVIHandler;
+    XMLSize_t                     fDocHeapBlockSize;
+    XMLSize_t                     fDocHeapMaxBlockSize;
+    XMLSize_t                     fDocMaxSubAllocationSize;
+    bool                          fCreateElementIndex;
 };
 
 
@@ -1836,6 +1933,11 @@ inline bool AbstractDOMParser::getCreateSchemaInfo() const
     return fCreateSchemaInfo;
 }
 
+inline bool AbstractDOMParser::getCreateElementIndex() const
+{
+    return fCreateElementIndex;
+}
+
 inline bool AbstractDOMParser::getDoXInclude() const
 {
     return fDoXInclude;
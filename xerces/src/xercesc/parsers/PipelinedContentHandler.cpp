@@ -0,0 +1,639 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/parsers/PipelinedContentHandler.hpp>
+#include <xercesc/sax2/Attributes.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUniDefs.hpp>
+
+#include <string.h>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Local data
+//
+//  The event types of a batch, and the amount of text after which a batch
+//  is handed over even if it has room for more events.
+// ---------------------------------------------------------------------------
+namespace
+{
+    enum EventTypes
+    {
+        Event_Characters
+        , Event_EndDocument
+        , Event_EndElement
+        , Event_IgnorableWhitespace
+        , Event_ProcessingInstruction
+        , Event_StartDocument
+        , Event_StartElement
+        , Event_StartPrefixMapping
+        , Event_EndPrefixMapping
+        , Event_SkippedEntity
+    };
+
+    const XMLSize_t kMaxBatchText = 64 * 1024;
+
+    template <class T>
+    void growArray(T*& array, XMLSize_t& capacity, const XMLSize_t needed,
+                   const XMLSize_t used, MemoryManager* const manager)
+    {
+        if (needed <= capacity)
+            return;
+
+        XMLSize_t newCapacity = capacity ? capacity * 2 : 64;
+        while (newCapacity < needed)
+            newCapacity *= 2;
+
+        T* newArray = (T*) manager->allocate(newCapacity * sizeof(T));
+        if (used)
+            memcpy(newArray, array, used * sizeof(T));
+        manager->deallocate(array);
+        array = newArray;
+        capacity = newCapacity;
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+//  PipelinedContentHandler: Private data types
+//
+//  A batch holds its strings in one text buffer, null terminated, and the
+//  events and attributes refer to them by offset, so the buffer may grow
+//  while the batch is filled.
+// ---------------------------------------------------------------------------
+struct PipelinedContentHandler::Batch
+{
+    struct Event
+    {
+        int         fType;
+        XMLSize_t   fText[3];
+        XMLSize_t   fLength;
+        XMLSize_t   fFirstAttr;
+        XMLSize_t   fAttrCount;
+    };
+
+    struct Attr
+    {
+        XMLSize_t   fURI;
+        XMLSize_t   fLocalName;
+        XMLSize_t   fQName;
+        XMLSize_t   fType;
+        XMLSize_t   fValue;
+    };
+
+    const XMLCh* text(const XMLSize_t offset) const
+    {
+        return fText + offset;
+    }
+
+    Event*      fEvents;
+    XMLSize_t   fEventCount;
+    Attr*       fAttrs;
+    XMLSize_t   fAttrCount;
+    XMLSize_t   fAttrCapacity;
+    XMLCh*      fText;
+    XMLSize_t   fTextLength;
+    XMLSize_t   fTextCapacity;
+    Batch*      fNext;
+};
+
+class PipelinedContentHandler::BatchAttributes : public Attributes
+{
+public :
+    BatchAttributes(const Batch* const batch, const XMLSize_t first, const XMLSize_t count) :
+        fBatch(batch)
+        , fAttrs(batch->fAttrs + first)
+        , fCount(count)
+    {
+    }
+
+    virtual XMLSize_t getLength() const
+    {
+        return fCount;
+    }
+
+    virtual const XMLCh* getURI(const XMLSize_t index) const
+    {
+        return (index < fCount) ? fBatch->text(fAttrs[index].fURI) : 0;
+    }
+
+    virtual const XMLCh* getLocalName(const XMLSize_t index) const
+    {
+        return (index < fCount) ? fBatch->text(fAttrs[index].fLocalName) : 0;
+    }
+
+    virtual const XMLCh* getQName(const XMLSize_t index) const
+    {
+        return (index < fCount) ? fBatch->text(fAttrs[index].fQName) : 0;
+    }
+
+    virtual const XMLCh* getType(const XMLSize_t index) const
+    {
+        return (index < fCount) ? fBatch->text(fAttrs[index].fType) : 0;
+    }
+
+    virtual const XMLCh* getValue(const XMLSize_t index) const
+    {
+        return (index < fCount) ? fBatch->text(fAttrs[index].fValue) : 0;
+    }
+
+    virtual bool getIndex(const XMLCh* const uri, const XMLCh* const localPart,
+                          XMLSize_t& index) const
+    {
+        for (XMLSize_t i = 0; i < fCount; i++)
+        {
+            if (XMLString::equals(fBatch->text(fAttrs[i].fLocalName), localPart)
+            &&  XMLString::equals(fBatch->text(fAttrs[i].fURI), uri))
+            {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    virtual int getIndex(const XMLCh* const uri, const XMLCh* const localPart) const
+    {
+        XMLSize_t index;
+        return getIndex(uri, localPart, index) ? (int) index : -1;
+    }
+
+    virtual bool getIndex(const XMLCh* const qName, XMLSize_t& index) const
+    {
+        for (XMLSize_t i = 0; i < fCount; i++)
+        {
+            if (XMLString::equals(fBatch->text(fAttrs[i].fQName), qName))
+            {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    virtual int getIndex(const XMLCh* const qName) const
+    {
+        XMLSize_t index;
+        return getIndex(qName, index) ? (int) index : -1;
+    }
+
+    virtual const XMLCh* getType(const XMLCh* const uri, const XMLCh* const localPart) const
+    {
+        XMLSize_t index;
+        return getIndex(uri, localPart, index) ? getType(index) : 0;
+    }
+
+    virtual const XMLCh* getType(const XMLCh* const qName) const
+    {
+        XMLSize_t index;
+        return getIndex(qName, index) ? getType(index) : 0;
+    }
+
+    virtual const XMLCh* getValue(const XMLCh* const uri, const XMLCh* const localPart) const
+    {
+        XMLSize_t index;
+        return getIndex(uri, localPart, index) ? getValue(index) : 0;
+    }
+
+    virtual const XMLCh* getValue(const XMLCh* const qName) const
+    {
+        XMLSize_t index;
+        return getIndex(qName, index) ? getValue(index) : 0;
+    }
+
+private :
+    const Batch*        fBatch;
+    const Batch::Attr*  fAttrs;
+    XMLSize_t           fCount;
+};
+
+
+// ---------------------------------------------------------------------------
+//  PipelinedContentHandler: Constructors and Destructor
+// ---------------------------------------------------------------------------
+PipelinedContentHandler::PipelinedContentHandler(ContentHandler* const handler
+                                                 , const XMLSize_t     batchEvents
+                                                 , const XMLSize_t     queueLength
+                                                 , MemoryManager* const manager) :
+
+    fHandler(handler)
+    , fBatchEvents(batchEvents ? batchEvents : 1)
+    , fCurrent(0)
+    , fQueue(0)
+    , fQueueLength(queueLength ? queueLength : 1)
+    , fQueueHead(0)
+    , fQueueCount(0)
+    , fFree(0)
+    , fPending(0)
+    , fBatchCount(0)
+    , fStop(false)
+    , fMemoryManager(manager)
+{
+    fQueue = (Batch**) fMemoryManager->allocate(fQueueLength * sizeof(Batch*));
+    fCurrent = createBatch();
+}
+
+PipelinedContentHandler::~PipelinedContentHandler()
+{
+    if (fThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fStop = true;
+        }
+        fNotEmpty.notify_one();
+        fThread.join();
+    }
+
+    for (; fQueueCount; fQueueCount--)
+    {
+        destroyBatch(fQueue[fQueueHead]);
+        fQueueHead = (fQueueHead + 1) % fQueueLength;
+    }
+    while (fFree)
+    {
+        Batch* next = fFree->fNext;
+        destroyBatch(fFree);
+        fFree = next;
+    }
+    destroyBatch(fCurrent);
+    fMemoryManager->deallocate(fQueue);
+}
+
+
+// ---------------------------------------------------------------------------
+//  PipelinedContentHandler: Pipeline interface
+// ---------------------------------------------------------------------------
+void PipelinedContentHandler::drain()
+{
+    flush();
+
+    std::unique_lock<std::mutex> lock(fMutex);
+    fDrained.wait(lock, [this] { return fPending == 0; });
+    if (fError)
+    {
+        std::exception_ptr error = fError;
+        fError = nullptr;
+        lock.unlock();
+        std::rethrow_exception(error);
+    }
+}
+
+XMLSize_t PipelinedContentHandler::getBatchCount() const
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fBatchCount;
+}
+
+
+// ---------------------------------------------------------------------------
+//  PipelinedContentHandler: Implementation of the ContentHandler interface
+// ---------------------------------------------------------------------------
+void PipelinedContentHandler::characters(const XMLCh* const chars, const XMLSize_t length)
+{
+    const XMLSize_t index = addEvent(Event_Characters);
+    const XMLSize_t offset = addText(chars, length);
+    fCurrent->fEvents[index].fText[0] = offset;
+    fCurrent->fEvents[index].fLength = length;
+}
+
+void PipelinedContentHandler::endDocument()
+{
+    addEvent(Event_EndDocument);
+    drain();
+}
+
+void PipelinedContentHandler::endElement(const XMLCh* const uri
+                                         , const XMLCh* const localname
+                                         , const XMLCh* const qname)
+{
+    const XMLSize_t index = addEvent(Event_EndElement);
+    const XMLSize_t uriOffset = addText(uri);
+    const XMLSize_t localOffset = addText(localname);
+    const XMLSize_t qnameOffset = addText(qname);
+    Batch::Event& event = fCurrent->fEvents[index];
+    event.fText[0] = uriOffset;
+    event.fText[1] = localOffset;
+    event.fText[2] = qnameOffset;
+}
+
+void PipelinedContentHandler::ignorableWhitespace(const XMLCh* const chars, const XMLSize_t length)
+{
+    const XMLSize_t index = addEvent(Event_IgnorableWhitespace);
+    const XMLSize_t offset = addText(chars, length);
+    fCurrent->fEvents[index].fText[0] = offset;
+    fCurrent->fEvents[index].fLength = length;
+}
+
+void PipelinedContentHandler::processingInstruction(const XMLCh* const target
+                                                    , const XMLCh* const data)
+{
+    const XMLSize_t index = addEvent(Event_ProcessingInstruction);
+    const XMLSize_t targetOffset = addText(target);
+    const XMLSize_t dataOffset = addText(data);
+    fCurrent->fEvents[index].fText[0] = targetOffset;
+    fCurrent->fEvents[index].fText[1] = dataOffset;
+}
+
+void PipelinedContentHandler::setDocumentLocator(const Locator* const)
+{
+    // The locator follows the scanner, which is ahead of the handler
+}
+
+void PipelinedContentHandler::startDocument()
+{
+    addEvent(Event_StartDocument);
+}
+
+void PipelinedContentHandler::startElement(const XMLCh* const uri
+                                           , const XMLCh* const localname
+                                           , const XMLCh* const qname
+                                           , const Attributes& attrs)
+{
+    const XMLSize_t index = addEvent(Event_StartElement);
+    const XMLSize_t uriOffset = addText(uri);
+    const XMLSize_t localOffset = addText(localname);
+    const XMLSize_t qnameOffset = addText(qname);
+
+    Batch* batch = fCurrent;
+    const XMLSize_t attrCount = attrs.getLength();
+    const XMLSize_t firstAttr = batch->fAttrCount;
+    growArray(batch->fAttrs, batch->fAttrCapacity, firstAttr + attrCount, firstAttr, fMemoryManager);
+    for (XMLSize_t i = 0; i < attrCount; i++)
+    {
+        Batch::Attr& attr = batch->fAttrs[firstAttr + i];
+        attr.fURI = addText(attrs.getURI(i));
+        attr.fLocalName = addText(attrs.getLocalName(i));
+        attr.fQName = addText(attrs.getQName(i));
+        attr.fType = addText(attrs.getType(i));
+        attr.fValue = addText(attrs.getValue(i));
+    }
+    batch->fAttrCount += attrCount;
+
+    Batch::Event& event = batch->fEvents[index];
+    event.fText[0] = uriOffset;
+    event.fText[1] = localOffset;
+    event.fText[2] = qnameOffset;
+    event.fFirstAttr = firstAttr;
+    event.fAttrCount = attrCount;
+}
+
+void PipelinedContentHandler::startPrefixMapping(const XMLCh* const prefix
+                                                 , const XMLCh* const uri)
+{
+    const XMLSize_t index = addEvent(Event_StartPrefixMapping);
+    const XMLSize_t prefixOffset = addText(prefix);
+    const XMLSize_t uriOffset = addText(uri);
+    fCurrent->fEvents[index].fText[0] = prefixOffset;
+    fCurrent->fEvents[index].fText[1] = uriOffset;
+}
+
+void PipelinedContentHandler::endPrefixMapping(const XMLCh* const prefix)
+{
+    const XMLSize_t index = addEvent(Event_EndPrefixMapping);
+    const XMLSize_t offset = addText(prefix);
+    fCurrent->fEvents[index].fText[0] = offset;
+}
+
+void PipelinedContentHandler::skippedEntity(const XMLCh* const name)
+{
+    const XMLSize_t index = addEvent(Event_SkippedEntity);
+    const XMLSize_t offset = addText(name);
+    fCurrent->fEvents[index].fText[0] = offset;
+}
+
+
+// ---------------------------------------------------------------------------
+//  PipelinedContentHandler: Private helper methods
+// ---------------------------------------------------------------------------
+PipelinedContentHandler::Batch* PipelinedContentHandler::createBatch()
+{
+    Batch* batch = (Batch*) fMemoryManager->allocate(sizeof(Batch));
+    memset(batch, 0, sizeof(Batch));
+    try
+    {
+        batch->fEvents = (Batch::Event*) fMemoryManager->allocate(fBatchEvents * sizeof(Batch::Event));
+    }
+    catch(...)
+    {
+        fMemoryManager->deallocate(batch);
+        throw;
+    }
+    return batch;
+}
+
+void PipelinedContentHandler::destroyBatch(Batch* const batch)
+{
+    fMemoryManager->deallocate(batch->fEvents);
+    fMemoryManager->deallocate(batch->fAttrs);
+    fMemoryManager->deallocate(batch->fText);
+    fMemoryManager->deallocate(batch);
+}
+
+//  Starts an event in the current batch, handing the batch over first if it
+//  is full, and returns the index of the event.
+XMLSize_t PipelinedContentHandler::addEvent(const int type)
+{
+    if (fCurrent->fEventCount >= fBatchEvents || fCurrent->fTextLength >= kMaxBatchText)
+        flush();
+
+    const XMLSize_t index = fCurrent->fEventCount++;
+    Batch::Event& event = fCurrent->fEvents[index];
+    event.fType = type;
+    event.fLength = 0;
+    event.fAttrCount = 0;
+    return index;
+}
+
+XMLSize_t PipelinedContentHandler::addText(const XMLCh* const text, const XMLSize_t length)
+{
+    Batch* batch = fCurrent;
+    const XMLSize_t offset = batch->fTextLength;
+    growArray(batch->fText, batch->fTextCapacity, offset + length + 1, offset, fMemoryManager);
+    if (length)
+        memcpy(batch->fText + offset, text, length * sizeof(XMLCh));
+    batch->fText[offset + length] = chNull;
+    batch->fTextLength = offset + length + 1;
+    return offset;
+}
+
+XMLSize_t PipelinedContentHandler::addText(const XMLCh* const text)
+{
+    return addText(text, text ? XMLString::stringLen(text) : 0);
+}
+
+//  Hands the current batch to the handler thread, waiting while the queue is
+//  full. If the handler has failed, the batch is dropped instead and the
+//  exception of the handler is rethrown.
+void PipelinedContentHandler::flush()
+{
+    if (fCurrent->fEventCount == 0)
+        return;
+
+    startThread();
+
+    Batch* next;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        next = fFree;
+        if (next)
+            fFree = next->fNext;
+    }
+    if (!next)
+        next = createBatch();
+
+    std::unique_lock<std::mutex> lock(fMutex);
+    fNotFull.wait(lock, [this] { return fQueueCount < fQueueLength || fError; });
+    if (fError)
+    {
+        fCurrent->fEventCount = 0;
+        fCurrent->fAttrCount = 0;
+        fCurrent->fTextLength = 0;
+        next->fNext = fFree;
+        fFree = next;
+
+        fDrained.wait(lock, [this] { return fPending == 0; });
+        std::exception_ptr error = fError;
+        fError = nullptr;
+        lock.unlock();
+        std::rethrow_exception(error);
+    }
+
+    fQueue[(fQueueHead + fQueueCount) % fQueueLength] = fCurrent;
+    fQueueCount++;
+    fPending++;
+    fBatchCount++;
+    fCurrent = next;
+    lock.unlock();
+    fNotEmpty.notify_one();
+}
+
+void PipelinedContentHandler::replay(const Batch* const batch)
+{
+    for (XMLSize_t i = 0; i < batch->fEventCount; i++)
+    {
+        const Batch::Event& event = batch->fEvents[i];
+        switch (event.fType)
+        {
+            case Event_Characters :
+                fHandler->characters(batch->text(event.fText[0]), event.fLength);
+                break;
+            case Event_EndDocument :
+                fHandler->endDocument();
+                break;
+            case Event_EndElement :
+                fHandler->endElement(batch->text(event.fText[0]), batch->text(event.fText[1]),
+                                     batch->text(event.fText[2]));
+                break;
+            case Event_IgnorableWhitespace :
+                fHandler->ignorableWhitespace(batch->text(event.fText[0]), event.fLength);
+                break;
+            case Event_ProcessingInstruction :
+                fHandler->processingInstruction(batch->text(event.fText[0]), batch->text(event.fText[1]));
+                break;
+            case Event_StartDocument :
+                fHandler->startDocument();
+                break;
+            case Event_StartElement :
+            {
+                BatchAttributes attrs(batch, event.fFirstAttr, event.fAttrCount);
+                fHandler->startElement(batch->text(event.fText[0]), batch->text(event.fText[1]),
+                                       batch->text(event.fText[2]), attrs);
+                break;
+            }
+            case Event_StartPrefixMapping :
+                fHandler->startPrefixMapping(batch->text(event.fText[0]), batch->text(event.fText[1]));
+                break;
+            case Event_EndPrefixMapping :
+                fHandler->endPrefixMapping(batch->text(event.fText[0]));
+                break;
+            case Event_SkippedEntity :
+                fHandler->skippedEntity(batch->text(event.fText[0]));
+                break;
+            default :
+                break;
+        }
+    }
+}
+
+//  The handler thread. Batches queued after a handler exception are only
+//  recycled, until the scanner thread has picked up the exception.
+void PipelinedContentHandler::run()
+{
+    for (;;)
+    {
+        Batch* batch;
+        bool skip;
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            fNotEmpty.wait(lock, [this] { return fQueueCount != 0 || fStop; });
+            if (fStop)
+                return;
+
+            batch = fQueue[fQueueHead];
+            fQueueHead = (fQueueHead + 1) % fQueueLength;
+            fQueueCount--;
+            skip = (fError != nullptr);
+        }
+        fNotFull.notify_one();
+
+        std::exception_ptr error;
+        if (!skip)
+        {
+            try
+            {
+                replay(batch);
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+        }
+        batch->fEventCount = 0;
+        batch->fAttrCount = 0;
+        batch->fTextLength = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            if (error && !fError)
+                fError = error;
+            batch->fNext = fFree;
+            fFree = batch;
+            fPending--;
+        }
+        fDrained.notify_all();
+        if (error)
+            fNotFull.notify_one();
+    }
+}
+
+void PipelinedContentHandler::startThread()
+{
+    if (!fThread.joinable())
+        fThread = std::thread(&PipelinedContentHandler::run, this);
+}
+
+XERCES_CPP_NAMESPACE_END
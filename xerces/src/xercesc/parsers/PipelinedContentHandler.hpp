@@ -0,0 +1,238 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ *
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_PIPELINEDCONTENTHANDLER_HPP)
+#define XERCESC_INCLUDE_GUARD_PIPELINEDCONTENTHANDLER_HPP
+
+#include <xercesc/sax2/ContentHandler.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMemory.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+/**
+  * A content handler that runs another content handler on its own thread.
+  *
+  * <p>Install it as the content handler of a SAX2XMLReader in place of
+  * the real handler. The scanner thread copies the element names,
+  * attribute lists and character data of each event into a batch; full
+  * batches go through a bounded queue to a handler thread, which replays
+  * them on the real handler. Tokenizing the document thus overlaps with
+  * handling it, which pays off when the handler does much work for each
+  * element.</p>
+  *
+  * <p>The handler sees the events in document order, and parse() returns
+  * only after the handler thread has handled endDocument. An exception
+  * thrown by the handler is rethrown on the scanner thread, at the next
+  * batch boundary, so that it propagates out of parse() and stops the
+  * scan; the events after it are dropped.</p>
+  *
+  * <p>Only the content events are moved to the handler thread. Error,
+  * lexical and DTD handlers still run on the scanner thread, without
+  * ordering against the content events, and the document locator is not
+  * passed on, since it describes the scanner position rather than the
+  * position of the event being handled. If parse() ends with an
+  * exception before endDocument, call drain() to let the handler finish
+  * the events already scanned.</p>
+  */
+class PARSERS_EXPORT PipelinedContentHandler : public XMemory, public ContentHandler
+{
+public :
+    // -----------------------------------------------------------------------
+    //  Constructors and Destructor
+    // -----------------------------------------------------------------------
+
+    /** @name Constructors and Destructor */
+    //@{
+    /** Construct a pipelined handler
+      *
+      * @param handler      The handler run on the handler thread. It is not
+      *                     adopted.
+      * @param batchEvents  Number of events per batch. Larger batches take
+      *                     fewer thread hand-offs but more memory.
+      * @param queueLength  Number of full batches that may wait for the
+      *                     handler thread before the scanner blocks.
+      * @param manager      Pointer to the memory manager used for the
+      *                     batches.
+      */
+    PipelinedContentHandler
+    (
+          ContentHandler* const handler
+        , const XMLSize_t       batchEvents = 512
+        , const XMLSize_t       queueLength = 4
+        , MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    /**
+      * Destructor. Stops the handler thread; events not yet handled are
+      * dropped.
+      */
+    virtual ~PipelinedContentHandler();
+    //@}
+
+
+    // -----------------------------------------------------------------------
+    //  Pipeline interface
+    // -----------------------------------------------------------------------
+
+    /** @name Pipeline interface */
+    //@{
+    /** Wait until the handler thread has handled all events
+      *
+      * Hands the partly filled batch to the handler thread and waits for
+      * the queue to run empty. If the handler threw an exception that has
+      * not been rethrown yet, it is rethrown here. Called by endDocument.
+      */
+    void drain();
+
+    /** Get the number of batches handed to the handler thread */
+    XMLSize_t getBatchCount() const;
+    //@}
+
+
+    // -----------------------------------------------------------------------
+    //  Implementation of the ContentHandler interface
+    // -----------------------------------------------------------------------
+
+    /** @name Implementation of the ContentHandler interface */
+    //@{
+    virtual void characters(const XMLCh* const chars, const XMLSize_t length);
+    virtual void endDocument();
+    virtual void endElement
+    (
+        const XMLCh* const uri
+        , const XMLCh* const localname
+        , const XMLCh* const qname
+    );
+    virtual void ignorableWhitespace(const XMLCh* const chars, const XMLSize_t length);
+    virtual void processingInstruction(const XMLCh* const target, const XMLCh* const data);
+    virtual void setDocumentLocator(const Locator* const locator);
+    virtual void startDocument();
+    virtual void startElement
+    (
+        const XMLCh* const uri
+        , const XMLCh* const localname
+        , const XMLCh* const qname
+        , const Attributes& attrs
+    );
+    virtual void startPrefixMapping(const XMLCh* const prefix, const XMLCh* const uri);
+    virtual void endPrefixMapping(const XMLCh* const prefix);
+    virtual void skippedEntity(const XMLCh* const name);
+    //@}
+
+private :
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    PipelinedContentHandler(const PipelinedContentHandler&);
+    PipelinedContentHandler& operator=(const PipelinedContentHandler&);
+
+
+    // -----------------------------------------------------------------------
+    //  Private data types
+    // -----------------------------------------------------------------------
+    struct Batch;
+    class BatchAttributes;
+
+
+    // -----------------------------------------------------------------------
+    //  Private helper methods
+    // -----------------------------------------------------------------------
+    Batch* createBatch();
+    void destroyBatch(Batch* const batch);
+    XMLSize_t addEvent(const int type);
+    XMLSize_t addText(const XMLCh* const text, const XMLSize_t length);
+    XMLSize_t addText(const XMLCh* const text);
+    void flush();
+    void replay(const Batch* const batch);
+    void run();
+    void startThread();
+
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fHandler
+    //      The handler run on the handler thread, not owned.
+    //
+    //  fBatchEvents
+    //      The number of events after which a batch is handed over. A
+    //      batch is also handed over when its text gets large.
+    //
+    //  fCurrent
+    //      The batch filled by the scanner thread.
+    //
+    //  fQueue, fQueueLength, fQueueHead, fQueueCount
+    //      The ring of full batches waiting for the handler thread. There
+    //      is one producer and one consumer, and a batch changes hands
+    //      under fMutex, which is cheap at batch granularity.
+    //
+    //  fFree
+    //      Handled batches kept for reuse, so that their buffers are
+    //      allocated once. At most fQueueLength + 2 batches exist.
+    //
+    //  fPending
+    //      The number of batches queued or being handled.
+    //
+    //  fBatchCount
+    //      The number of batches handed over so far.
+    //
+    //  fError
+    //      The exception thrown by the handler, until it is rethrown.
+    //
+    //  fStop
+    //      Set by the destructor to end the handler thread.
+    //
+    //  fMutex, fNotEmpty, fNotFull, fDrained
+    //      Guard and signal the fields shared by the two threads.
+    //
+    //  fThread
+    //      The handler thread, started by the first event.
+    // -----------------------------------------------------------------------
+    ContentHandler*         fHandler;
+    XMLSize_t               fBatchEvents;
+    Batch*                  fCurrent;
+    Batch**                 fQueue;
+    XMLSize_t               fQueueLength;
+    XMLSize_t               fQueueHead;
+    XMLSize_t               fQueueCount;
+    Batch*                  fFree;
+    XMLSize_t               fPending;
+    XMLSize_t               fBatchCount;
+    std::exception_ptr      fError;
+    bool                    fStop;
+    mutable std::mutex      fMutex;
+    std::condition_variable fNotEmpty;
+    std::condition_variable fNotFull;
+    std::condition_variable fDrained;
+    std::thread             fThread;
+    MemoryManager*          fMemoryManager;
+};
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
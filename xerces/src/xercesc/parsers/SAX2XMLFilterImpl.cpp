@@ -262,6 +262,18 @@ void SAX2XMLFilterImpl::setInputBufferSize(const XMLSize_t bufferSize)
         fParentReader->setInputBufferSize(bufferSize);
 }
 
+void SAX2XMLFilterImpl::setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize)
+{
+    if(fParentReader)
+        fParentReader->setReaderBufferSizes(charBufSize, rawBufSize);
+}
+
+void SAX2XMLFilterImpl::useFastTrustedProfile(const bool doNamespaces)
+{
+    if(fParentReader)
+        fParentReader->useFastTrustedProfile(doNamespaces);
+}
+
 Grammar* SAX2XMLFilterImpl::getGrammar(const XMLCh* const nameSpaceKey)
 {
     if(fParentReader)
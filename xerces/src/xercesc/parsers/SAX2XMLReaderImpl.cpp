@@ -1616,6 +1616,26 @@ void SAX2XMLReaderImpl::setInputBufferSize(const XMLSize_t bufferSize)
     fScanner->setInputBufferSize(bufferSize);
 }
 
+void SAX2XMLReaderImpl::setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize)
+{
+    fScanner->setReaderBufferSizes(charBufSize, rawBufSize);
+}
+
+void SAX2XMLReaderImpl::useFastTrustedProfile(const bool doNamespaces)
+{
+    // through the features, so that the SAX2 flags stay consistent
+    setProperty(XMLUni::fgXercesScannerName, const_cast<XMLCh*>(XMLUni::fgWFXMLScanner));
+
+    setFeature(XMLUni::fgSAX2CoreValidation, false);
+    setFeature(XMLUni::fgXercesDynamic, false);
+    setFeature(XMLUni::fgXercesSchema, false);
+    setFeature(XMLUni::fgXercesSchemaFullChecking, false);
+    setFeature(XMLUni::fgXercesIdentityConstraintChecking, false);
+    setFeature(XMLUni::fgXercesLoadExternalDTD, false);
+    setFeature(XMLUni::fgXercesLoadSchema, false);
+    setFeature(XMLUni::fgSAX2CoreNameSpaces, doNamespaces);
+}
+
 Grammar* SAX2XMLReaderImpl::getGrammar(const XMLCh* const nameSpaceKey)
 {
     return fGrammarResolver->getGrammar(nameSpaceKey);
@@ -873,6 +873,39 @@ public :
       */
     virtual void setInputBufferSize(const XMLSize_t bufferSize);
 
+    /** Set the sizes of the reader buffers
+      *
+      * This method sets the sizes of the buffers of the readers created for
+      * the documents and external entities parsed from now on. The raw
+      * buffer size is the size of the reads from the input stream, larger
+      * buffers mean fewer reads and transcoder calls for large documents.
+      * Sizes below 1 kilobyte are raised to it.
+      *
+      * The parser's default sizes are 16K characters and 48K bytes.
+      *
+      * @param charBufSize The size in characters of the transcoded character buffer
+      * @param rawBufSize The size in bytes of the raw byte buffer
+      */
+    virtual void setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize);
+
+    /** Use the fast trusted parser profile
+      *
+      * This method configures the parser for fast well-formedness checking
+      * of trusted documents. It selects the WFXMLScanner, which creates no
+      * validators, skips the DOCTYPE declaration and only knows the
+      * predefined entities, and it turns off validation, schema processing
+      * and the loading of external DTDs and schemas. Without namespace
+      * processing the names are not split and no namespace URIs are
+      * looked up or interned.
+      *
+      * Documents that rely on their DTD for default attributes or entity
+      * declarations are not reported correctly in this profile. The other
+      * settings of the parser are kept.
+      *
+      * @param doNamespaces Whether namespace processing is done
+      */
+    virtual void useFastTrustedProfile(const bool doNamespaces = true);
+
     //@}
 
 
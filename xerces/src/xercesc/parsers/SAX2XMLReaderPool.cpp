@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/parsers/SAX2XMLReaderPool.hpp>
+#include <xercesc/util/Janitor.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  SAX2XMLReaderPool: Constructors and Destructor
+// ---------------------------------------------------------------------------
+SAX2XMLReaderPool::SAX2XMLReaderPool(XMLGrammarPool* const gramPool
+                                         , const XMLSize_t     maxIdle
+                                         , MemoryManager* const manager) :
+
+    fGrammarPool(gramPool)
+    , fMaxIdle(maxIdle)
+    , fCreated(0)
+    , fIdle(0)
+    , fMutex(manager)
+    , fMemoryManager(manager)
+{
+    fIdle = new (fMemoryManager) ValueStackOf<SAX2XMLReaderImpl*>(maxIdle ? maxIdle : 1, fMemoryManager);
+}
+
+SAX2XMLReaderPool::~SAX2XMLReaderPool()
+{
+    while (!fIdle->empty())
+        delete fIdle->pop();
+    delete fIdle;
+}
+
+
+// ---------------------------------------------------------------------------
+//  SAX2XMLReaderPool: Pool interface
+// ---------------------------------------------------------------------------
+SAX2XMLReaderImpl* SAX2XMLReaderPool::acquire()
+{
+    {
+        XMLMutexLock lock(&fMutex);
+        if (!fIdle->empty())
+            return fIdle->pop();
+        fCreated++;
+    }
+
+    SAX2XMLReaderImpl* parser = new (fMemoryManager) SAX2XMLReaderImpl(fMemoryManager, fGrammarPool);
+    Janitor<SAX2XMLReaderImpl> janParser(parser);
+    configureParser(parser);
+    return janParser.release();
+}
+
+void SAX2XMLReaderPool::release(SAX2XMLReaderImpl* const parser)
+{
+    if (!parser)
+        return;
+
+    // Drop the handlers of the previous user. The scanner, its buffers and
+    // the grammars are kept; the next parse resets the document state.
+    parser->setContentHandler(0);
+    parser->setDTDHandler(0);
+    parser->setEntityResolver(0);
+    parser->setXMLEntityResolver(0);
+    parser->setErrorHandler(0);
+    parser->setDeclarationHandler(0);
+    parser->setLexicalHandler(0);
+    parser->setPSVIHandler(0);
+
+    {
+        XMLMutexLock lock(&fMutex);
+        if (fIdle->size() < fMaxIdle)
+        {
+            fIdle->push(parser);
+            return;
+        }
+    }
+    delete parser;
+}
+
+XMLSize_t SAX2XMLReaderPool::getIdleCount() const
+{
+    XMLMutexLock lock(&fMutex);
+    return fIdle->size();
+}
+
+XMLSize_t SAX2XMLReaderPool::getCreatedCount() const
+{
+    XMLMutexLock lock(&fMutex);
+    return fCreated;
+}
+
+
+// ---------------------------------------------------------------------------
+//  SAX2XMLReaderPool: Protected virtual methods
+// ---------------------------------------------------------------------------
+void SAX2XMLReaderPool::configureParser(SAX2XMLReaderImpl* const)
+{
+}
+
+XERCES_CPP_NAMESPACE_END
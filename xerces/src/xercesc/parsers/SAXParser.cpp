@@ -533,6 +533,24 @@ void SAXParser::setInputBufferSize(const XMLSize_t bufferSize)
     fScanner->setInputBufferSize(bufferSize);
 }
 
+void SAXParser::setReaderBufferSizes(const XMLSize_t charBufSize, const XMLSize_t rawBufSize)
+{
+    fScanner->setReaderBufferSizes(charBufSize, rawBufSize);
+}
+
+void SAXParser::useFastTrustedProfile(const bool doNamespaces)
+{
+    useScanner(XMLUni::fgWFXMLScanner);
+
+    setValidationScheme(Val_Never);
+    setDoSchema(false);
+    setValidationSchemaFullChecking(false);
+    setIdentityConstraintChecking(false);
+    setLoadExternalDTD(false);
+    setLoadSchema(false);
+    setDoNamespaces(doNamespaces);
+}
+
 void SAXParser::setIgnoreCachedDTD(const bool newValue)
 {
     fScanner->setIgnoredCachedDTD(newValue);
@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/parsers/XercesDOMParserPool.hpp>
+#include <xercesc/util/Janitor.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  XercesDOMParserPool: Constructors and Destructor
+// ---------------------------------------------------------------------------
+XercesDOMParserPool::XercesDOMParserPool(XMLGrammarPool* const gramPool
+                                         , const XMLSize_t     maxIdle
+                                         , MemoryManager* const manager) :
+
+    fGrammarPool(gramPool)
+    , fMaxIdle(maxIdle)
+    , fCreated(0)
+    , fIdle(0)
+    , fMutex(manager)
+    , fMemoryManager(manager)
+{
+    fIdle = new (fMemoryManager) ValueStackOf<XercesDOMParser*>(maxIdle ? maxIdle : 1, fMemoryManager);
+}
+
+XercesDOMParserPool::~XercesDOMParserPool()
+{
+    while (!fIdle->empty())
+        delete fIdle->pop();
+    delete fIdle;
+}
+
+
+// ---------------------------------------------------------------------------
+//  XercesDOMParserPool: Pool interface
+// ---------------------------------------------------------------------------
+XercesDOMParser* XercesDOMParserPool::acquire()
+{
+    {
+        XMLMutexLock lock(&fMutex);
+        if (!fIdle->empty())
+            return fIdle->pop();
+        fCreated++;
+    }
+
+    XercesDOMParser* parser = new (fMemoryManager) XercesDOMParser(0, fMemoryManager, fGrammarPool);
+    Janitor<XercesDOMParser> janParser(parser);
+    configureParser(parser);
+    return janParser.release();
+}
+
+void XercesDOMParserPool::release(XercesDOMParser* const parser)
+{
+    if (!parser)
+        return;
+
+    // Delete the documents still owned by the parser and drop the handlers
+    // of the previous user. The scanner, its buffers and the grammars are
+    // kept; the next parse resets the rest of the document state.
+    parser->resetDocumentPool();
+    parser->setErrorHandler(0);
+    parser->setEntityResolver(0);
+    parser->setXMLEntityResolver(0);
+    parser->setPSVIHandler(0);
+
+    {
+        XMLMutexLock lock(&fMutex);
+        if (fIdle->size() < fMaxIdle)
+        {
+            fIdle->push(parser);
+            return;
+        }
+    }
+    delete parser;
+}
+
+XMLSize_t XercesDOMParserPool::getIdleCount() const
+{
+    XMLMutexLock lock(&fMutex);
+    return fIdle->size();
+}
+
+XMLSize_t XercesDOMParserPool::getCreatedCount() const
+{
+    XMLMutexLock lock(&fMutex);
+    return fCreated;
+}
+
+
+// ---------------------------------------------------------------------------
+//  XercesDOMParserPool: Protected virtual methods
+// ---------------------------------------------------------------------------
+void XercesDOMParserPool::configureParser(XercesDOMParser* const)
+{
+}
+
+XERCES_CPP_NAMESPACE_END
@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ *
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_XERCESDOMPARSERPOOL_HPP)
+#define XERCESC_INCLUDE_GUARD_XERCESDOMPARSERPOOL_HPP
+
+#include <xercesc/parsers/XercesDOMParser.hpp>
+#include <xercesc/util/Mutexes.hpp>
+#include <xercesc/util/ValueStackOf.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+class XMLGrammarPool;
+
+/**
+  * A thread safe pool of XercesDOMParser instances.
+  *
+  * <p>Creating a parser allocates its scanner, validators, element stack,
+  * buffer manager and reader manager. For small documents this costs more
+  * than the parse itself. A pool keeps released parsers and hands them out
+  * again, so these buffers are allocated once per parser instead of once per
+  * document.</p>
+  *
+  * <p>All parsers of a pool share the grammar pool passed to the
+  * constructor, so grammars cached by one parser are used by all of them.
+  * Features set on a parser stay set when it is released; to configure new
+  * parsers in one place, override configureParser.</p>
+  *
+  * <p>When a parser is released, the documents it still owns are deleted
+  * and its error handler, entity resolvers and PSVI handler are cleared.
+  * Documents adopted with adoptDocument are not affected.</p>
+  */
+class PARSERS_EXPORT XercesDOMParserPool : public XMemory
+{
+public :
+    // -----------------------------------------------------------------------
+    //  Constructors and Destructor
+    // -----------------------------------------------------------------------
+
+    /** @name Constructors and Destructor */
+    //@{
+    /** Construct a parser pool
+      *
+      * @param gramPool   Grammar pool shared by the parsers of the pool.
+      *                   The pool does NOT own it.
+      * @param maxIdle    Maximum number of released parsers kept for reuse.
+      *                   Parsers released beyond it are deleted.
+      * @param manager    Pointer to the memory manager used to allocate the
+      *                   pool and its parsers.
+      */
+    XercesDOMParserPool
+    (
+          XMLGrammarPool* const gramPool = 0
+        , const XMLSize_t       maxIdle = 16
+        , MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    /**
+      * Destructor. Deletes the idle parsers. Parsers that have not been
+      * released must be released before the pool is destroyed.
+      */
+    virtual ~XercesDOMParserPool();
+    //@}
+
+
+    // -----------------------------------------------------------------------
+    //  Pool interface
+    // -----------------------------------------------------------------------
+
+    /** @name Pool interface */
+    //@{
+    /** Get a parser from the pool
+      *
+      * Returns an idle parser or, if there is none, a new one configured
+      * by configureParser.
+      *
+      * @return A parser, to be given back with release.
+      */
+    XercesDOMParser* acquire();
+
+    /** Give a parser back to the pool
+      *
+      * Resets the document state of the parser and keeps it for reuse,
+      * or deletes it if the pool already holds maxIdle parsers. The
+      * parser must not be in the middle of a progressive parse.
+      *
+      * @param parser A parser returned by acquire of this pool.
+      */
+    void release(XercesDOMParser* const parser);
+
+    /** Get the number of parsers held for reuse */
+    XMLSize_t getIdleCount() const;
+
+    /** Get the number of parsers created by the pool */
+    XMLSize_t getCreatedCount() const;
+    //@}
+
+protected :
+    // -----------------------------------------------------------------------
+    //  Protected virtual methods
+    // -----------------------------------------------------------------------
+
+    /** Called once for each parser created by the pool.
+      *
+      * Override to set features, such as the validation scheme or
+      * namespace processing, of all the parsers of the pool. The default
+      * implementation does nothing.
+      */
+    virtual void configureParser(XercesDOMParser* const parser);
+
+private :
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    XercesDOMParserPool(const XercesDOMParserPool&);
+    XercesDOMParserPool& operator=(const XercesDOMParserPool&);
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fGrammarPool
+    //      The grammar pool passed to the parsers, not owned.
+    //
+    //  fMaxIdle
+    //      The maximum size of fIdle.
+    //
+    //  fCreated
+    //      The number of parsers created so far.
+    //
+    //  fIdle
+    //      The released parsers, reused last in first out so that the most
+    //      recently used buffers are handed out first.
+    //
+    //  fMutex
+    //      Guards fIdle and fCreated.
+    // -----------------------------------------------------------------------
+    XMLGrammarPool*                 fGrammarPool;
+    XMLSize_t                       fMaxIdle;
+    XMLSize_t                       fCreated;
+    ValueStackOf<XercesDOMParser*>* fIdle;
+    mutable XMLMutex                fMutex;
+    MemoryManager*                  fMemoryManager;
+};
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
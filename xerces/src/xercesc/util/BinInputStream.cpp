@@ -50,4 +50,14 @@ const XMLCh* BinInputStream::getEncoding() const
     return 0;
 }
 
+const XMLCh* BinInputStream::getETag() const
+{
+    return 0;
+}
+
+bool BinInputStream::isNotModified() const
+{
+    return false;
+}
+
 XERCES_CPP_NAMESPACE_END
@@ -84,6 +84,23 @@ public :
      */
     virtual const XMLCh *getEncoding() const;
 
+    /**
+     * Return the entity tag of the data supplied by this input stream, for
+     * example the value of the "ETag" header of an HTTP response. It can be
+     * sent back in an "If-None-Match" header (see XMLNetHTTPInfo) to ask
+     * the server for the data only if it has changed since.
+     *
+     * @return The entity tag, or 0 if one is not available.
+     */
+    virtual const XMLCh *getETag() const;
+
+    /**
+     * Return true if the stream was opened with a conditional request and
+     * the server answered that the data has not been modified (HTTP status
+     * 304). The stream has no data in this case.
+     */
+    virtual bool isNotModified() const;
+
 protected :
     // -----------------------------------------------------------------------
     //  Hidden Constructors
@@ -0,0 +1,210 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/util/BinMMapInputStream.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include <string.h>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <sys/types.h>
+#   include <sys/stat.h>
+#   include <sys/mman.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Local helpers
+// ---------------------------------------------------------------------------
+#if defined(_WIN32)
+static const XMLByte* mapHandle(HANDLE file, XMLSize_t& size, bool& isOpen)
+{
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    const XMLByte* data = 0;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && (unsigned long long) fileSize.QuadPart <= (XMLSize_t) -1)
+    {
+        size = (XMLSize_t) fileSize.QuadPart;
+        if (size == 0)
+            isOpen = true;
+        else
+        {
+            HANDLE mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+            if (mapping)
+            {
+                // the view keeps the mapping and the file alive
+                data = (const XMLByte*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                isOpen = (data != 0);
+                CloseHandle(mapping);
+            }
+        }
+    }
+    CloseHandle(file);
+    return data;
+}
+#endif
+
+
+// ---------------------------------------------------------------------------
+//  BinMMapInputStream: Constructors and Destructor
+// ---------------------------------------------------------------------------
+BinMMapInputStream::BinMMapInputStream(const XMLCh* const fileName
+                                       , MemoryManager* const manager) :
+
+    fData(0)
+  , fSize(0)
+  , fCurIndex(0)
+  , fIsOpen(false)
+  , fMemoryManager(manager)
+{
+    mapFile(fileName);
+}
+
+BinMMapInputStream::BinMMapInputStream(const char* const fileName
+                                       , MemoryManager* const manager) :
+
+    fData(0)
+  , fSize(0)
+  , fCurIndex(0)
+  , fIsOpen(false)
+  , fMemoryManager(manager)
+{
+    mapFile(fileName);
+}
+
+BinMMapInputStream::~BinMMapInputStream()
+{
+    if (fData)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(fData);
+#else
+        munmap(const_cast<XMLByte*>(fData), fSize);
+#endif
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+//  BinMMapInputStream: Implementation of the input stream interface
+// ---------------------------------------------------------------------------
+XMLFilePos BinMMapInputStream::curPos() const
+{
+    return fCurIndex;
+}
+
+XMLSize_t
+BinMMapInputStream::readBytes(          XMLByte* const  toFill
+                              , const   XMLSize_t       maxToRead)
+{
+    XMLSize_t toCopy = fSize - fCurIndex;
+    if (toCopy > maxToRead)
+        toCopy = maxToRead;
+
+    if (toCopy)
+    {
+        memcpy(toFill, fData + fCurIndex, toCopy);
+        fCurIndex += toCopy;
+    }
+    return toCopy;
+}
+
+const XMLCh* BinMMapInputStream::getContentType() const
+{
+    return 0;
+}
+
+
+// ---------------------------------------------------------------------------
+//  BinMMapInputStream: Private helper methods
+// ---------------------------------------------------------------------------
+#if defined(_WIN32)
+
+void BinMMapInputStream::mapFile(const XMLCh* const fileName)
+{
+    HANDLE file = CreateFileW(reinterpret_cast<LPCWSTR>(fileName), GENERIC_READ, FILE_SHARE_READ
+                              , 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    fData = mapHandle(file, fSize, fIsOpen);
+}
+
+void BinMMapInputStream::mapFile(const char* const fileName)
+{
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ
+                              , 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    fData = mapHandle(file, fSize, fIsOpen);
+}
+
+#else
+
+void BinMMapInputStream::mapFile(const XMLCh* const fileName)
+{
+    // same conversion of the name as the POSIX file manager
+    char* tmpFileName = XMLString::transcode(fileName, fMemoryManager);
+    ArrayJanitor<char> janText(tmpFileName, fMemoryManager);
+    mapFile(tmpFileName);
+}
+
+void BinMMapInputStream::mapFile(const char* const fileName)
+{
+    const int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+        && (unsigned long long) st.st_size <= (XMLSize_t) -1)
+    {
+        fSize = (XMLSize_t) st.st_size;
+        if (fSize == 0)
+            fIsOpen = true;
+        else
+        {
+            void* data = mmap(0, fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+#if defined(MADV_SEQUENTIAL)
+                madvise(data, fSize, MADV_SEQUENTIAL);
+#endif
+                fData = (const XMLByte*) data;
+                fIsOpen = true;
+            }
+        }
+    }
+
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+}
+
+#endif
+
+XERCES_CPP_NAMESPACE_END
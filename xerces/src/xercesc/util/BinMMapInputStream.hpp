@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_BINMMAPINPUTSTREAM_HPP)
+#define XERCESC_INCLUDE_GUARD_BINMMAPINPUTSTREAM_HPP
+
+#include <xercesc/util/BinInputStream.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+//
+//  An input stream over a memory mapped local file. The whole file is mapped
+//  at construction and readBytes() copies out of the mapping, so reading a
+//  large document takes no read system calls and the kernel reads ahead
+//  sequentially. If the file cannot be mapped (it does not exist, it is not
+//  a regular file or it is too large for the address space), getIsOpen()
+//  returns false; MMapFileInputSource then falls back to BinFileInputStream.
+//
+class XMLUTIL_EXPORT BinMMapInputStream : public BinInputStream
+{
+public :
+    // -----------------------------------------------------------------------
+    //  Constructors and Destructor
+    // -----------------------------------------------------------------------
+    BinMMapInputStream
+    (
+        const   XMLCh* const    fileName
+        , MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    BinMMapInputStream
+    (
+        const   char* const     fileName
+        , MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    virtual ~BinMMapInputStream();
+
+
+    // -----------------------------------------------------------------------
+    //  Getter methods
+    // -----------------------------------------------------------------------
+    bool getIsOpen() const;
+    XMLFilePos getSize() const;
+    const XMLByte* getRawBuffer() const;
+    void reset();
+
+
+    // -----------------------------------------------------------------------
+    //  Implementation of the input stream interface
+    // -----------------------------------------------------------------------
+    virtual XMLFilePos curPos() const;
+
+    virtual XMLSize_t readBytes
+    (
+                XMLByte* const      toFill
+        , const XMLSize_t           maxToRead
+    );
+
+    virtual const XMLCh* getContentType() const;
+
+private :
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    BinMMapInputStream(const BinMMapInputStream&);
+    BinMMapInputStream& operator=(const BinMMapInputStream&);
+
+    // -----------------------------------------------------------------------
+    //  Private helper methods
+    // -----------------------------------------------------------------------
+    void mapFile(const char* const fileName);
+    void mapFile(const XMLCh* const fileName);
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fData
+    //      The start of the mapping, null for an empty file.
+    //
+    //  fSize
+    //      The size of the file.
+    //
+    //  fCurIndex
+    //      The offset of the next byte to read.
+    //
+    //  fIsOpen
+    //      Whether the file could be mapped.
+    // -----------------------------------------------------------------------
+    const XMLByte*          fData;
+    XMLSize_t               fSize;
+    XMLSize_t               fCurIndex;
+    bool                    fIsOpen;
+    MemoryManager* const    fMemoryManager;
+};
+
+
+// ---------------------------------------------------------------------------
+//  BinMMapInputStream: Getter methods
+// ---------------------------------------------------------------------------
+inline bool BinMMapInputStream::getIsOpen() const
+{
+    return fIsOpen;
+}
+
+inline XMLFilePos BinMMapInputStream::getSize() const
+{
+    return fSize;
+}
+
+inline const XMLByte* BinMMapInputStream::getRawBuffer() const
+{
+    return fData;
+}
+
+inline void BinMMapInputStream::reset()
+{
+    fCurIndex = 0;
+}
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
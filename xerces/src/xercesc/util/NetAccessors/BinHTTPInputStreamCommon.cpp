@@ -48,6 +48,8 @@ BinHTTPInputStreamCommon::BinHTTPInputStreamCommon(MemoryManager *manager)
 	  , fBufferPos(0)
       , fContentType(0)
 	  , fEncoding(0)
+      , fETag(0)
+      , fStatus(0)
       , fMemoryManager(manager)
 {
 }
@@ -57,6 +59,7 @@ BinHTTPInputStreamCommon::~BinHTTPInputStreamCommon()
 {
     if(fContentType) fMemoryManager->deallocate(fContentType);
     if(fEncoding) fMemoryManager->deallocate(fEncoding);
+    if(fETag) fMemoryManager->deallocate(fETag);
 }
 
 static const char *CRLF = "\r\n";
@@ -257,7 +260,8 @@ int BinHTTPInputStreamCommon::sendRequest(const XMLURL &url, const XMLNetHTTPInf
         ThrowXMLwithMemMgr1(NetAccessorException, XMLExcepts::NetAcc_ReadSocket, url.getURLText(), fMemoryManager);
     }
 
-    return atoi(p);
+    fStatus = atoi(p);
+    return fStatus;
 }
 
 const XMLCh *BinHTTPInputStreamCommon::getContentType() const
@@ -331,6 +335,21 @@ const XMLCh *BinHTTPInputStreamCommon::getEncoding() const
     return fEncoding;
 }
 
+const XMLCh *BinHTTPInputStreamCommon::getETag() const
+{
+    if(fETag == 0) {
+        // mutable
+        const_cast<BinHTTPInputStreamCommon*>(this)->fETag =
+        const_cast<BinHTTPInputStreamCommon*>(this)->findHeader("ETag");
+    }
+    return fETag;
+}
+
+bool BinHTTPInputStreamCommon::isNotModified() const
+{
+    return fStatus == 304;
+}
+
 XMLSize_t BinHTTPInputStreamCommon::readBytes(XMLByte* const    toFill,
                                               const XMLSize_t    maxToRead)
 {
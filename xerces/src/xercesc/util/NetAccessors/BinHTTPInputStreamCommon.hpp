@@ -170,6 +170,8 @@ public :
 
     virtual const XMLCh *getContentType() const;
     virtual const XMLCh *getEncoding() const;
+    virtual const XMLCh *getETag() const;
+    virtual bool isNotModified() const;
 
 protected :
     BinHTTPInputStreamCommon(MemoryManager *manager);
@@ -213,6 +215,10 @@ private :
 	//      Holds the HTTP header for the Content-Type setting
 	//  fEncoding
 	//      Holds the encoding of this stream, extracted from the Content-Type setting
+    //  fETag
+    //      Holds the HTTP header for the ETag setting
+    //  fStatus
+    //      The HTTP status code of the last response
     // -----------------------------------------------------------------------
 
     XMLSize_t           fBytesProcessed;
@@ -220,6 +226,8 @@ private :
     char *              fBufferPos;
     XMLCh *             fContentType;
     XMLCh *             fEncoding;
+    XMLCh *             fETag;
+    int                 fStatus;
     MemoryManager*      fMemoryManager;
 };
 
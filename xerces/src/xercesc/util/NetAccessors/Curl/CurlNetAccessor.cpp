@@ -37,14 +37,37 @@ const XMLCh CurlNetAccessor::fgMyName[] =
 
 
 CurlNetAccessor::CurlNetAccessor()
+    : fShare(0)
+    , fIdleCount(0)
 {
 	initCurl();
+
+    fShare = curl_share_init();
+    if (fShare)
+    {
+        curl_share_setopt(fShare, CURLSHOPT_LOCKFUNC, lockShare);
+        curl_share_setopt(fShare, CURLSHOPT_UNLOCKFUNC, unlockShare);
+        curl_share_setopt(fShare, CURLSHOPT_USERDATA, this);
+
+        curl_share_setopt(fShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(fShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+        curl_share_setopt(fShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    }
 }
 
 
 CurlNetAccessor::~CurlNetAccessor()
 {
-	cleanupCurl();
+    while (fIdleCount > 0)
+        curl_easy_cleanup(fIdleHandles[--fIdleCount]);
+
+    // Fails (and leaks the caches) only if streams are still open
+    if (fShare)
+        curl_share_cleanup(fShare);
+
+    cleanupCurl();
 }
 
 
@@ -79,13 +102,75 @@ CurlNetAccessor::cleanupCurl()
 }
 
 
+//
+// Easy handle pool
+//
+CURL*
+CurlNetAccessor::acquireEasyHandle()
+{
+    CURL* easy = 0;
+    {
+        XMLMutexLock lock(&fPoolMutex);
+        if (fIdleCount > 0)
+            easy = fIdleHandles[--fIdleCount];
+    }
+
+    if (easy == 0)
+        easy = curl_easy_init();
+
+    if (easy != 0)
+    {
+        if (fShare)
+            curl_easy_setopt(easy, CURLOPT_SHARE, fShare);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, (long)1);
+    }
+
+    return easy;
+}
+
+
+void
+CurlNetAccessor::releaseEasyHandle(CURL* easy)
+{
+    // Reset the options of the last stream; open connections and caches stay
+    curl_easy_reset(easy);
+
+    {
+        XMLMutexLock lock(&fPoolMutex);
+        if (fIdleCount < kMaxIdleHandles)
+        {
+            fIdleHandles[fIdleCount++] = easy;
+            return;
+        }
+    }
+
+    curl_easy_cleanup(easy);
+}
+
+
+void
+CurlNetAccessor::lockShare(CURL* /*easy*/, curl_lock_data data, curl_lock_access /*access*/, void* userptr)
+{
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+        ((CurlNetAccessor*)userptr)->fShareMutexes[data].lock();
+}
+
+
+void
+CurlNetAccessor::unlockShare(CURL* /*easy*/, curl_lock_data data, void* userptr)
+{
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+        ((CurlNetAccessor*)userptr)->fShareMutexes[data].unlock();
+}
+
+
 BinInputStream*
 CurlNetAccessor::makeNew(const XMLURL&  urlSource, const XMLNetHTTPInfo* httpInfo/*=0*/)
 {
 	// Just create a CurlURLInputStream
 	// We defer any checking of the url type for curl in CurlURLInputStream
 	CurlURLInputStream* retStrm =
-		new (urlSource.getMemoryManager()) CurlURLInputStream(urlSource, httpInfo);
+		new (urlSource.getMemoryManager()) CurlURLInputStream(urlSource, httpInfo, this);
 	return retStrm;            
 }
 
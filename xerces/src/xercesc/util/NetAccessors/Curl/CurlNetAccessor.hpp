@@ -23,10 +23,13 @@
 #define XERCESC_INCLUDE_GUARD_CURLNETACCESSOR_HPP
 
 
+#include <curl/curl.h>
+
 #include <xercesc/util/XercesDefs.hpp>
 #include <xercesc/util/XMLURL.hpp>
 #include <xercesc/util/BinInputStream.hpp>
 #include <xercesc/util/XMLNetAccessor.hpp>
+#include <xercesc/util/Mutexes.hpp>
 
 XERCES_CPP_NAMESPACE_BEGIN
 
@@ -35,6 +38,11 @@ XERCES_CPP_NAMESPACE_BEGIN
 // provides the ability to fetch a resource specified using
 // a HTTP or FTP URL.
 //
+// The streams reuse curl easy handles from a small pool. All handles
+// share one connection cache (with curl 7.57 or later), DNS cache and
+// TLS session cache, so that a connection to a server stays open between
+// the fetches of the schemas it serves (HTTP keep-alive).
+//
 
 class XMLUTIL_EXPORT CurlNetAccessor : public XMLNetAccessor
 {
@@ -48,10 +56,40 @@ public :
     virtual void initCurl(void);
     virtual void cleanupCurl(void);
 
+    // Returns an easy handle with default options that uses the shared
+    // caches, or 0 if curl fails to create one
+    CURL* acquireEasyHandle();
+
+    // Returns a handle to the pool; its connection is kept open
+    void releaseEasyHandle(CURL* easy);
+
 private :
+    static void lockShare(CURL* easy, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockShare(CURL* easy, curl_lock_data data, void* userptr);
+
 	static int fgCurlInitCount;
     static const XMLCh fgMyName[];
 
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fShare
+    //      The caches shared by all easy handles, 0 if curl fails to
+    //      create the share handle
+    //  fShareMutexes
+    //      One mutex per kind of shared data
+    //  fIdleHandles, fIdleCount
+    //      Easy handles released by finished streams, guarded by
+    //      fPoolMutex
+    // -----------------------------------------------------------------------
+    enum { kMaxIdleHandles = 8 };
+
+    CURLSH*             fShare;
+    XMLMutex            fShareMutexes[CURL_LOCK_DATA_LAST];
+    XMLMutex            fPoolMutex;
+    CURL*               fIdleHandles[kMaxIdleHandles];
+    unsigned int        fIdleCount;
+
     CurlNetAccessor(const CurlNetAccessor&);
     CurlNetAccessor& operator=(const CurlNetAccessor&);
 
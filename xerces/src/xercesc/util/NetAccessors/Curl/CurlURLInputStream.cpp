@@ -42,6 +42,7 @@
 #include <xercesc/util/XercesDefs.hpp>
 #include <xercesc/util/XMLNetAccessor.hpp>
 #include <xercesc/util/NetAccessors/Curl/CurlURLInputStream.hpp>
+#include <xercesc/util/NetAccessors/Curl/CurlNetAccessor.hpp>
 #include <xercesc/util/XMLString.hpp>
 #include <xercesc/util/XMLExceptMsgs.hpp>
 #include <xercesc/util/Janitor.hpp>
@@ -53,8 +54,9 @@
 XERCES_CPP_NAMESPACE_BEGIN
 
 
-CurlURLInputStream::CurlURLInputStream(const XMLURL& urlSource, const XMLNetHTTPInfo* httpInfo/*=0*/)
-      : fMulti(0)
+CurlURLInputStream::CurlURLInputStream(const XMLURL& urlSource, const XMLNetHTTPInfo* httpInfo/*=0*/, CurlNetAccessor* accessor/*=0*/)
+      : fAccessor(accessor)
+      , fMulti(0)
       , fEasy(0)
       , fHeadersList(0)
       , fMemoryManager(urlSource.getMemoryManager())
@@ -69,12 +71,14 @@ CurlURLInputStream::CurlURLInputStream(const XMLURL& urlSource, const XMLNetHTTP
       , fPayload(0)
       , fPayloadLen(0)
       , fContentType(0)
+      , fETag(0)
+      , fNotModified(false)
 {
     // Allocate the curl multi handle
     fMulti = curl_multi_init();
 
-    // Allocate the curl easy handle
-    fEasy = curl_easy_init();
+    // Allocate the curl easy handle, or reuse one with its open connection
+    fEasy = fAccessor ? fAccessor->acquireEasyHandle() : curl_easy_init();
 
     // Set URL option
     TranscodeToStr url(fURLSource.getURLText(), "ISO8859-1", fMemoryManager);
@@ -84,6 +88,10 @@ CurlURLInputStream::CurlURLInputStream(const XMLURL& urlSource, const XMLNetHTTP
     curl_easy_setopt(fEasy, CURLOPT_WRITEDATA, this);						// Pass this pointer to write function
     curl_easy_setopt(fEasy, CURLOPT_WRITEFUNCTION, staticWriteCallback);	// Our static write function
 
+    // Look for the ETag header
+    curl_easy_setopt(fEasy, CURLOPT_HEADERDATA, this);
+    curl_easy_setopt(fEasy, CURLOPT_HEADERFUNCTION, staticHeaderCallback);
+
     // Do redirects
     curl_easy_setopt(fEasy, CURLOPT_FOLLOWLOCATION, (long)1);
     curl_easy_setopt(fEasy, CURLOPT_MAXREDIRS, (long)6);
@@ -169,6 +177,11 @@ CurlURLInputStream::CurlURLInputStream(const XMLURL& urlSource, const XMLNetHTTP
     curl_easy_getinfo(fEasy, CURLINFO_CONTENT_TYPE, &contentType8);
     if(contentType8)
         fContentType = TranscodeFromStr((XMLByte*)contentType8, XMLString::stringLen(contentType8), "ISO8859-1", fMemoryManager).adopt();
+
+    // A conditional request is answered without data if nothing changed
+    long responseCode = 0;
+    curl_easy_getinfo(fEasy, CURLINFO_RESPONSE_CODE, &responseCode);
+    fNotModified = (responseCode == 304);
 }
 
 
@@ -177,13 +190,17 @@ CurlURLInputStream::~CurlURLInputStream()
     // Remove the easy handle from the multi stack
     curl_multi_remove_handle(fMulti, fEasy);
 
-    // Cleanup the easy handle
-    curl_easy_cleanup(fEasy);
+    // Cleanup the easy handle, or return it to the pool
+    if(fAccessor)
+        fAccessor->releaseEasyHandle(fEasy);
+    else
+        curl_easy_cleanup(fEasy);
 
     // Cleanup the multi handle
     curl_multi_cleanup(fMulti);
 
     if(fContentType) fMemoryManager->deallocate(fContentType);
+    if(fETag) fMemoryManager->deallocate(fETag);
 
     if(fHeadersList) curl_slist_free_all(fHeadersList);
 }
@@ -207,6 +224,57 @@ CurlURLInputStream::staticReadCallback(char *buffer,
     return ((CurlURLInputStream*)stream)->readCallback(buffer, size, nitems);
 }
 
+size_t
+CurlURLInputStream::staticHeaderCallback(char *buffer,
+                                         size_t size,
+                                         size_t nitems,
+                                         void *stream)
+{
+    return ((CurlURLInputStream*)stream)->headerCallback(buffer, size, nitems);
+}
+
+size_t
+CurlURLInputStream::headerCallback(char *buffer,
+                                   size_t size,
+                                   size_t nitems)
+{
+    XMLSize_t cnt = size * nitems;
+
+    // Each response of a redirect chain starts with a status line
+    if (cnt >= 5 && memcmp(buffer, "HTTP/", 5) == 0)
+    {
+        if(fETag) fMemoryManager->deallocate(fETag);
+        fETag = 0;
+        return cnt;
+    }
+
+    // The header name is case insensitive
+    static const char etag[] = "etag:";
+    XMLSize_t i = 0;
+    for (; i < 5 && i < cnt; ++i)
+    {
+        char ch = buffer[i];
+        if (ch >= 'A' && ch <= 'Z')
+            ch = ch - 'A' + 'a';
+        if (ch != etag[i])
+            return cnt;
+    }
+    if (i < 5)
+        return cnt;
+
+    XMLSize_t start = 5;
+    XMLSize_t end = cnt;
+    while (start < end && (buffer[start] == ' ' || buffer[start] == '\t'))
+        ++start;
+    while (end > start && (buffer[end - 1] == '\r' || buffer[end - 1] == '\n' || buffer[end - 1] == ' '))
+        --end;
+
+    if(fETag) fMemoryManager->deallocate(fETag);
+    fETag = TranscodeFromStr((XMLByte*)buffer + start, end - start, "ISO8859-1", fMemoryManager).adopt();
+
+    return cnt;
+}
+
 size_t
 CurlURLInputStream::writeCallback(char *buffer,
                                   size_t size,
@@ -34,6 +34,8 @@
 
 XERCES_CPP_NAMESPACE_BEGIN
 
+class CurlNetAccessor;
+
 //
 // This class implements the BinInputStream interface specified by the XML
 // parser.
@@ -42,7 +44,9 @@ XERCES_CPP_NAMESPACE_BEGIN
 class XMLUTIL_EXPORT CurlURLInputStream : public BinInputStream
 {
 public :
-    CurlURLInputStream(const XMLURL&  urlSource, const XMLNetHTTPInfo* httpInfo=0);
+    // The easy handle is taken from and returned to the pool of accessor,
+    // if one is given
+    CurlURLInputStream(const XMLURL&  urlSource, const XMLNetHTTPInfo* httpInfo=0, CurlNetAccessor* accessor=0);
     ~CurlURLInputStream();
 
     virtual XMLFilePos curPos() const;
@@ -53,6 +57,8 @@ public :
     );
 
     virtual const XMLCh *getContentType() const;
+    virtual const XMLCh *getETag() const;
+    virtual bool isNotModified() const;
 
 private :
     // -----------------------------------------------------------------------
@@ -77,6 +83,14 @@ private :
                                      size_t size,
                                      size_t nitems);
 
+    static size_t staticHeaderCallback(char *buffer,
+                                       size_t size,
+                                       size_t nitems,
+                                       void *stream);
+    size_t headerCallback(           char *buffer,
+                                     size_t size,
+                                     size_t nitems);
+
     bool readMore(int *runningHandles);
 
     // -----------------------------------------------------------------------
@@ -94,8 +108,15 @@ private :
     //  fBufferPos, fBufferEnd
     //      Pointers into fBuffer, showing start and end+1 of content
     //      that readBytes must return.
+    //  fAccessor
+    //      The accessor owning the pool of easy handles, or 0
+    //  fETag
+    //      The ETag header of the last response
+    //  fNotModified
+    //      True if the response status is 304 Not Modified
     // -----------------------------------------------------------------------
 	
+    CurlNetAccessor*    fAccessor;
     CURLM*              fMulti;
     CURL*               fEasy;
     curl_slist*         fHeadersList;
@@ -121,6 +142,8 @@ private :
     XMLSize_t           fPayloadLen;
 
     XMLCh *             fContentType;
+    XMLCh *             fETag;
+    bool                fNotModified;
     
 }; // CurlURLInputStream
 
@@ -131,6 +154,18 @@ CurlURLInputStream::curPos() const
     return fTotalBytesRead;
 }
 
+inline const XMLCh*
+CurlURLInputStream::getETag() const
+{
+    return fETag;
+}
+
+inline bool
+CurlURLInputStream::isNotModified() const
+{
+    return fNotModified;
+}
+
 XERCES_CPP_NAMESPACE_END
 
 #endif // CURLURLINPUTSTREAM_HPP
@@ -206,6 +206,10 @@ UnixHTTPURLInputStream::UnixHTTPURLInputStream(const XMLURL& urlSource, const XM
             // HTTP 200 OK response means we're done.
             break;
         }
+        // HTTP 304 Not Modified answers a conditional request, the stream has no data
+        else if(status == 304) {
+            break;
+        }
         // a 3xx response means there was an HTTP redirect
         else if(status >= 300 && status <= 307) {
             redirectCount++;
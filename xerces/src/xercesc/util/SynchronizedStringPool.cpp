@@ -24,10 +24,29 @@
 //  Includes
 // ---------------------------------------------------------------------------
 #include <xercesc/util/SynchronizedStringPool.hpp>
+#include <xercesc/util/IllegalArgumentException.hpp>
+#include <xercesc/util/XMLString.hpp>
 
 
 XERCES_CPP_NAMESPACE_BEGIN
 
+// ---------------------------------------------------------------------------
+//  Local helpers
+// ---------------------------------------------------------------------------
+
+//  Maps the zero based index of a local string to its chunk and the offset
+//  in the chunk. Chunk i starts at index (kFirstChunkSize << i) - kFirstChunkSize.
+static inline unsigned int chunkOf(const XMLSize_t index, const XMLSize_t firstChunkSize, XMLSize_t& offset)
+{
+    const XMLSize_t biased = index + firstChunkSize;
+    unsigned int chunk = 0;
+    while ((firstChunkSize << (chunk + 1)) <= biased)
+        chunk++;
+    offset = biased - (firstChunkSize << chunk);
+    return chunk;
+}
+
+
 // ---------------------------------------------------------------------------
 //  XMLSynchronizedStringPool: Constructors and Destructor
 // ---------------------------------------------------------------------------
@@ -35,14 +54,27 @@ XMLSynchronizedStringPool::XMLSynchronizedStringPool(const XMLStringPool *constP
                 , const  unsigned int  modulus
                 , MemoryManager* const manager) :
 
-    XMLStringPool(modulus, manager)
+    // the tables of the base pool are not used, keep them minimal
+    XMLStringPool(1, manager)
     , fConstPool(constPool)
     , fMutex(manager)
+    , fMemoryManager(manager)
+    , fModulus(modulus ? modulus : 1)
+    , fTable(0)
+    , fLocalCount(0)
 {
+    for (unsigned int index = 0; index < kChunkCount; index++)
+        fChunks[index].store(0, std::memory_order_relaxed);
+
+    fTable.store(createTable(fModulus, 0), std::memory_order_relaxed);
 }
 
 XMLSynchronizedStringPool::~XMLSynchronizedStringPool()
 {
+    removeAllLocal(0);
+
+    for (unsigned int index = 0; index < kChunkCount; index++)
+        fMemoryManager->deallocate(fChunks[index].load(std::memory_order_relaxed));
 }
 
 
@@ -54,12 +86,62 @@ unsigned int XMLSynchronizedStringPool::addOrFind(const XMLCh* const newString)
     unsigned int id = fConstPool->getId(newString);
     if(id)
         return id;
+
+    const XMLSize_t hashVal = XMLString::hash(newString, (XMLSize_t) -1);
+    const unsigned int constCount = fConstPool->getStringCount();
+    const PoolElem* elem = findLocal(newString, hashVal);
+    if (elem)
+        return elem->fId + constCount;
+
     // might have to add it to our own table.
-    // synchronize this bit
-    unsigned int constCount = fConstPool->getStringCount();
+    // synchronize this bit, and look again as another thread may just
+    // have added it
     XMLMutexLock lockInit(&fMutex);
-    id = XMLStringPool::addOrFind(newString);
-    return id+constCount;
+    elem = findLocal(newString, hashVal);
+    if (elem)
+        return elem->fId + constCount;
+
+    const unsigned int localId = fLocalCount.load(std::memory_order_relaxed) + 1;
+    if (!localId)
+        ThrowXMLwithMemMgr(IllegalArgumentException, XMLExcepts::StrPool_IllegalId, fMemoryManager);
+
+    PoolElem* newElem = (PoolElem*) fMemoryManager->allocate(sizeof(PoolElem));
+    newElem->fString = 0;
+    newElem->fHashVal = hashVal;
+    newElem->fId = localId;
+
+    HashTable* table = fTable.load(std::memory_order_relaxed);
+    try
+    {
+        newElem->fString = XMLString::replicate(newString, fMemoryManager);
+        setLocal(localId, newElem);
+        link(table, newElem);
+    }
+    catch(...)
+    {
+        fMemoryManager->deallocate(newElem->fString);
+        fMemoryManager->deallocate(newElem);
+        throw;
+    }
+
+    // now that it can be found by name, publish it by id
+    fLocalCount.store(localId, std::memory_order_release);
+
+    // a failure to grow the table only costs longer chains
+    if (localId > 2 * table->fModulus)
+    {
+        try
+        {
+            HashTable* newTable = createTable(2 * table->fModulus + 1, localId);
+            newTable->fRetired = table;
+            fTable.store(newTable, std::memory_order_release);
+        }
+        catch(...)
+        {
+        }
+    }
+
+    return localId + constCount;
 }
 
 bool XMLSynchronizedStringPool::exists(const XMLCh* const newString) const
@@ -67,8 +149,7 @@ bool XMLSynchronizedStringPool::exists(const XMLCh* const newString) const
     if(fConstPool->exists(newString))
         return true;
 
-    XMLMutexLock lockInit(&const_cast<XMLSynchronizedStringPool*>(this)->fMutex);
-    return XMLStringPool::exists(newString);
+    return findLocal(newString, XMLString::hash(newString, (XMLSize_t) -1)) != 0;
 }
 
 bool XMLSynchronizedStringPool::exists(const unsigned int id) const
@@ -83,16 +164,13 @@ bool XMLSynchronizedStringPool::exists(const unsigned int id) const
     if (id <= constCount)
       return true;
 
-    // The rest needs to be synchronized.
-    //
-    XMLMutexLock lockInit(&const_cast<XMLSynchronizedStringPool*>(this)->fMutex);
-    return id < fCurId + constCount;
+    return id - constCount <= fLocalCount.load(std::memory_order_acquire);
 }
 
 void XMLSynchronizedStringPool::flushAll()
 {
     // don't touch const pool!
-    XMLStringPool::flushAll();
+    removeAllLocal(fModulus);
 }
 
 
@@ -103,27 +181,153 @@ unsigned int XMLSynchronizedStringPool::getId(const XMLCh* const toFind) const
         return retVal;
 
     // make sure we return a truly unique id
-    unsigned int constCount = fConstPool->getStringCount();
-    XMLMutexLock lockInit(&const_cast<XMLSynchronizedStringPool*>(this)->fMutex);
-    return XMLStringPool::getId(toFind)+constCount;
+    const PoolElem* elem = findLocal(toFind, XMLString::hash(toFind, (XMLSize_t) -1));
+    if (!elem)
+        return 0;
+    return elem->fId + fConstPool->getStringCount();
 }
 
 
 const XMLCh* XMLSynchronizedStringPool::getValueForId(const unsigned int id) const
 {
-    if (id <= fConstPool->getStringCount())
+    const unsigned int constCount = fConstPool->getStringCount();
+    if (id <= constCount)
         return fConstPool->getValueForId(id);
 
-    unsigned int constCount = fConstPool->getStringCount();
-    XMLMutexLock lockInit(&const_cast<XMLSynchronizedStringPool*>(this)->fMutex);
-    return XMLStringPool::getValueForId(id-constCount);
+    const unsigned int localId = id - constCount;
+    if (localId > fLocalCount.load(std::memory_order_acquire))
+        ThrowXMLwithMemMgr(IllegalArgumentException, XMLExcepts::StrPool_IllegalId, fMemoryManager);
+
+    return getLocal(localId)->fString;
 }
 
 unsigned int XMLSynchronizedStringPool::getStringCount() const
 {
-    unsigned int constCount = fConstPool->getStringCount();
-    XMLMutexLock lockInit(&const_cast<XMLSynchronizedStringPool*>(this)->fMutex);
-    return fCurId+constCount-1;
+    return fConstPool->getStringCount() + fLocalCount.load(std::memory_order_acquire);
+}
+
+
+// ---------------------------------------------------------------------------
+//  XMLSynchronizedStringPool: Private helper methods
+// ---------------------------------------------------------------------------
+const XMLSynchronizedStringPool::PoolElem*
+XMLSynchronizedStringPool::findLocal(const XMLCh* const toFind, const XMLSize_t hashVal) const
+{
+    // a link is never changed once it is reachable from its bucket
+    const HashTable* table = fTable.load(std::memory_order_acquire);
+    for (const HashLink* curLink = table->fBuckets[hashVal % table->fModulus].load(std::memory_order_acquire);
+         curLink; curLink = curLink->fNext)
+    {
+        if (curLink->fElem->fHashVal == hashVal && XMLString::equals(curLink->fElem->fString, toFind))
+            return curLink->fElem;
+    }
+    return 0;
+}
+
+const XMLSynchronizedStringPool::PoolElem*
+XMLSynchronizedStringPool::getLocal(const unsigned int localId) const
+{
+    XMLSize_t offset;
+    const unsigned int chunk = chunkOf(localId - 1, kFirstChunkSize, offset);
+    return fChunks[chunk].load(std::memory_order_acquire)[offset];
+}
+
+void XMLSynchronizedStringPool::setLocal(const unsigned int localId, PoolElem* const elem)
+{
+    XMLSize_t offset;
+    const unsigned int chunk = chunkOf(localId - 1, kFirstChunkSize, offset);
+
+    PoolElem** entries = fChunks[chunk].load(std::memory_order_relaxed);
+    if (!entries)
+    {
+        entries = (PoolElem**) fMemoryManager->allocate
+        (
+            ((XMLSize_t) kFirstChunkSize << chunk) * sizeof(PoolElem*)
+        );
+        fChunks[chunk].store(entries, std::memory_order_release);
+    }
+    entries[offset] = elem;
+}
+
+XMLSynchronizedStringPool::HashTable*
+XMLSynchronizedStringPool::createTable(const XMLSize_t modulus, const unsigned int count)
+{
+    HashTable* table = (HashTable*) fMemoryManager->allocate(sizeof(HashTable));
+    table->fModulus = 0;
+    table->fBuckets = 0;
+    table->fRetired = 0;
+
+    try
+    {
+        table->fBuckets = (std::atomic<HashLink*>*) fMemoryManager->allocate
+        (
+            modulus * sizeof(std::atomic<HashLink*>)
+        );
+        for (XMLSize_t index = 0; index < modulus; index++)
+            new (&table->fBuckets[index]) std::atomic<HashLink*>(0);
+        table->fModulus = modulus;
+
+        for (unsigned int localId = 1; localId <= count; localId++)
+            link(table, const_cast<PoolElem*>(getLocal(localId)));
+    }
+    catch(...)
+    {
+        destroyTable(table);
+        throw;
+    }
+    return table;
+}
+
+void XMLSynchronizedStringPool::link(HashTable* const table, PoolElem* const elem)
+{
+    std::atomic<HashLink*>& bucket = table->fBuckets[elem->fHashVal % table->fModulus];
+
+    HashLink* newLink = (HashLink*) fMemoryManager->allocate(sizeof(HashLink));
+    newLink->fElem = elem;
+    newLink->fNext = bucket.load(std::memory_order_relaxed);
+    bucket.store(newLink, std::memory_order_release);
+}
+
+void XMLSynchronizedStringPool::destroyTable(HashTable* const table)
+{
+    for (XMLSize_t index = 0; index < table->fModulus; index++)
+    {
+        HashLink* curLink = table->fBuckets[index].load(std::memory_order_relaxed);
+        while (curLink)
+        {
+            HashLink* nextLink = curLink->fNext;
+            fMemoryManager->deallocate(curLink);
+            curLink = nextLink;
+        }
+    }
+    fMemoryManager->deallocate(table->fBuckets);
+    fMemoryManager->deallocate(table);
+}
+
+void XMLSynchronizedStringPool::removeAllLocal(const XMLSize_t modulus)
+{
+    const unsigned int count = fLocalCount.load(std::memory_order_relaxed);
+    for (unsigned int localId = 1; localId <= count; localId++)
+    {
+        PoolElem* elem = const_cast<PoolElem*>(getLocal(localId));
+        fMemoryManager->deallocate(elem->fString);
+        fMemoryManager->deallocate(elem);
+    }
+    fLocalCount.store(0, std::memory_order_relaxed);
+
+    // the current and the retired tables, the chunks are kept for the next
+    // strings
+    HashTable* table = fTable.load(std::memory_order_relaxed);
+    fTable.store(0, std::memory_order_relaxed);
+    while (table)
+    {
+        HashTable* retired = table->fRetired;
+        destroyTable(table);
+        table = retired;
+    }
+
+    if (modulus)
+        fTable.store(createTable(modulus, 0), std::memory_order_relaxed);
 }
 
 XERCES_CPP_NAMESPACE_END
@@ -26,6 +26,8 @@
 #include <xercesc/util/StringPool.hpp>
 #include <xercesc/util/Mutexes.hpp>
 
+#include <atomic>
+
 XERCES_CPP_NAMESPACE_BEGIN
 
 //
@@ -36,6 +38,17 @@ XERCES_CPP_NAMESPACE_BEGIN
 //  all queries that don't involve mutation will first be directed at
 //  the XMLStringPool implementation with which this object is
 //  constructed.
+//
+//  Parsers sharing a locked grammar pool look up strings here all the time,
+//  so the lookups do not take the mutex. The local strings are kept in an id
+//  map made of chunks that never move and in a hash table whose chains are
+//  only ever prepended to. A new string is fully built before it is
+//  published, so a reader sees either nothing or the complete entry. When
+//  the table gets crowded it is rebuilt at twice the size and the old one is
+//  kept, since readers may still be walking it, until flushAll() or the
+//  destructor. Only addOrFind() of a string that is not in the pool yet
+//  takes the mutex. flushAll() must not run concurrently with any other
+//  method.
 class XMLUTIL_EXPORT XMLSynchronizedStringPool : public XMLStringPool
 {
 public :
@@ -71,14 +84,75 @@ private :
     XMLSynchronizedStringPool& operator=(const XMLSynchronizedStringPool&);
 
 
+    // -----------------------------------------------------------------------
+    //  Private data types
+    // -----------------------------------------------------------------------
+    struct PoolElem
+    {
+        XMLCh*        fString;
+        XMLSize_t     fHashVal;
+        unsigned int  fId;
+    };
+
+    struct HashLink
+    {
+        PoolElem*     fElem;
+        HashLink*     fNext;
+    };
+
+    struct HashTable
+    {
+        XMLSize_t                   fModulus;
+        std::atomic<HashLink*>*     fBuckets;
+        HashTable*                  fRetired;
+    };
+
+    enum Constants
+    {
+        kFirstChunkSize = 64
+        , kChunkCount = 27      // enough chunks for any unsigned int id
+    };
+
+
+    // -----------------------------------------------------------------------
+    //  Private helper methods
+    // -----------------------------------------------------------------------
+    const PoolElem* findLocal(const XMLCh* const toFind, const XMLSize_t hashVal) const;
+    const PoolElem* getLocal(const unsigned int localId) const;
+    void setLocal(const unsigned int localId, PoolElem* const elem);
+    HashTable* createTable(const XMLSize_t modulus, const unsigned int count);
+    void link(HashTable* const table, PoolElem* const elem);
+    void destroyTable(HashTable* const table);
+    void removeAllLocal(const XMLSize_t modulus);
+
+
     // -----------------------------------------------------------------------
     // private data members
     //  fConstPool
     //      the pool whose immutability we're protecting
     // fMutex
     //      mutex to permit synchronous updates of our StringPool
-    const XMLStringPool* fConstPool;
-    XMLMutex             fMutex;
+    // fMemoryManager
+    //      the manager of the local strings and of their tables
+    // fModulus
+    //      the initial size of the hash table
+    // fTable
+    //      the current hash table of the local strings, it is replaced by a
+    //      bigger one when it holds twice as many strings as buckets, the
+    //      old tables are chained through fRetired
+    // fChunks
+    //      the id map of the local strings, chunk i has kFirstChunkSize << i
+    //      entries and is allocated when the first of them is added
+    // fLocalCount
+    //      the number of local strings, stored after the new string is in
+    //      both tables so that readers never see a partial entry
+    const XMLStringPool*        fConstPool;
+    XMLMutex                    fMutex;
+    MemoryManager*              fMemoryManager;
+    XMLSize_t                   fModulus;
+    std::atomic<HashTable*>     fTable;
+    std::atomic<PoolElem**>     fChunks[kChunkCount];
+    std::atomic<unsigned int>   fLocalCount;
 };
 
 XERCES_CPP_NAMESPACE_END
@@ -50,6 +50,7 @@ void XMLInitializer::initializeStaticData()
         //
         initializeRangeTokenMap();
         initializeRegularExpression();
+        initializeRegularExpressionCache();
 
         // DTD
         //
@@ -115,6 +116,7 @@ void XMLInitializer::terminateStaticData()
 
     // Regex
     //
+    terminateRegularExpressionCache();
     terminateRegularExpression();
     terminateRangeTokenMap();
 
@@ -85,6 +85,7 @@ private:
     //
     static void initializeRangeTokenMap();
     static void initializeRegularExpression();
+    static void initializeRegularExpressionCache();
 
     // DTD
     //
@@ -125,6 +126,7 @@ private:
     //
     static void terminateRangeTokenMap();
     static void terminateRegularExpression();
+    static void terminateRegularExpressionCache();
 
     // DTD
     //
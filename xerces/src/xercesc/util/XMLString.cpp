@@ -58,6 +58,10 @@
 #include <xercesc/util/XMLURL.hpp>
 #include <xercesc/internal/XMLReader.hpp>
 
+#if XERCES_HAVE_EMMINTRIN_H
+#   include <emmintrin.h>
+#endif
+
 XERCES_CPP_NAMESPACE_BEGIN
 
 // ---------------------------------------------------------------------------
@@ -1157,6 +1161,11 @@ int XMLString::compareString(   const   XMLCh* const    str1
         }
     }
 
+#if defined(XERCES_HAVE_SSE2_INTRINSIC) && !defined(XERCES_STRING_NO_SSE2)
+    if (XMLPlatformUtils::fgSSE2ok)
+        return compareStringSSE2(psz1, psz2);
+#endif
+
     for (;;)
     {
         // If an inequality, then return the difference
@@ -2045,4 +2054,155 @@ void XMLString::termString()
     fgMemoryManager = 0;
 }
 
+
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+// ---------------------------------------------------------------------------
+//  XMLString: Private SSE2 implementations
+//
+//  Each step looks at 8 chars. stringLen only does aligned loads, which
+//  cannot cross into the next page; the two strings of equals and
+//  compareString are rarely aligned alike, so they use unaligned loads and
+//  go char by char over the last 16 bytes of a page. Strings that are not
+//  XMLCh aligned take the scalar loops.
+//
+//  Sanitized builds do not call them, but they are still exported for code
+//  built without the sanitizer, so the reads are not instrumented either.
+// ---------------------------------------------------------------------------
+#if defined(__GNUC__) || defined(__clang__)
+#  define XERCES_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(_MSC_VER) && defined(__SANITIZE_ADDRESS__)
+#  define XERCES_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#else
+#  define XERCES_NO_SANITIZE_ADDRESS
+#endif
+
+static inline bool isNearPageEnd(const XMLCh* const ptr)
+{
+    return ((XMLSize_t) ptr & 4095) > 4096 - sizeof(__m128i);
+}
+
+static inline unsigned int firstBit(unsigned int mask)
+{
+#if defined(__GNUC__)
+    return (unsigned int) __builtin_ctz(mask);
+#else
+    unsigned int index = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+//  The index of the first char that ends str1 or differs from str2, if
+//  there is one in the next 8 chars, else 8
+XERCES_NO_SANITIZE_ADDRESS static inline unsigned int firstStop(const XMLCh* const str1, const XMLCh* const str2)
+{
+    const __m128i chars1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str1));
+    const __m128i chars2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str2));
+    const __m128i same = _mm_cmpeq_epi16(chars1, chars2);
+    const __m128i ended = _mm_cmpeq_epi16(chars1, _mm_setzero_si128());
+
+    const unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_andnot_si128(same, _mm_set1_epi8(-1)))
+                            | (unsigned int) _mm_movemask_epi8(ended);
+    return mask ? firstBit(mask) / sizeof(XMLCh) : 8;
+}
+
+XERCES_NO_SANITIZE_ADDRESS XMLSize_t XMLString::stringLenSSE2(const XMLCh* const src)
+{
+    if ((XMLSize_t) src & (sizeof(XMLCh) - 1))
+    {
+        const XMLCh* pszTmp = src;
+        while (*pszTmp++) ;
+        return (pszTmp - src - 1);
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const XMLSize_t offset = (XMLSize_t) src & (sizeof(__m128i) - 1);
+    const __m128i* block = reinterpret_cast<const __m128i*>((const char*) src - offset);
+
+    // the bytes of the first block before src are masked out
+    unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(block), zero));
+    mask &= ~0U << offset;
+    while (!mask)
+    {
+        block++;
+        mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(block), zero));
+    }
+
+    return ((const char*) block + firstBit(mask) - (const char*) src) / sizeof(XMLCh);
+}
+
+XERCES_NO_SANITIZE_ADDRESS bool XMLString::equalsSSE2(const XMLCh* str1, const XMLCh* str2)
+{
+    if (((XMLSize_t) str1 | (XMLSize_t) str2) & (sizeof(XMLCh) - 1))
+    {
+        while (*str1)
+            if(*str1++ != *str2++)
+                return false;
+        return (*str2==0);
+    }
+
+    for (;;)
+    {
+        if (isNearPageEnd(str1) || isNearPageEnd(str2))
+        {
+            for (unsigned int index = 0; index < 8; index++, str1++, str2++)
+            {
+                if (*str1 != *str2)
+                    return false;
+                if (!*str1)
+                    return true;
+            }
+            continue;
+        }
+
+        const unsigned int index = firstStop(str1, str2);
+        if (index < 8)
+            return str1[index] == str2[index];
+
+        str1 += 8;
+        str2 += 8;
+    }
+}
+
+XERCES_NO_SANITIZE_ADDRESS int XMLString::compareStringSSE2(const XMLCh* str1, const XMLCh* str2)
+{
+    if (((XMLSize_t) str1 | (XMLSize_t) str2) & (sizeof(XMLCh) - 1))
+    {
+        for (;; str1++, str2++)
+        {
+            if (*str1 != *str2)
+                return int(*str1) - int(*str2);
+            if (!*str1)
+                return 0;
+        }
+    }
+
+    for (;;)
+    {
+        if (isNearPageEnd(str1) || isNearPageEnd(str2))
+        {
+            for (unsigned int index = 0; index < 8; index++, str1++, str2++)
+            {
+                if (*str1 != *str2)
+                    return int(*str1) - int(*str2);
+                if (!*str1)
+                    return 0;
+            }
+            continue;
+        }
+
+        const unsigned int index = firstStop(str1, str2);
+        if (index < 8)
+            return int(str1[index]) - int(str2[index]);
+
+        str1 += 8;
+        str2 += 8;
+    }
+}
+#endif
+
 XERCES_CPP_NAMESPACE_END
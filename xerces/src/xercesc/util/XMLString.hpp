@@ -28,6 +28,19 @@
 #include <string.h>
 #include <assert.h>
 
+// The SSE2 string functions read past the terminator within a block, which
+// address sanitizer reports as an overflow, so sanitized builds keep to the
+// scalar loops
+#if defined(XERCES_HAVE_SSE2_INTRINSIC)
+#  if defined(__SANITIZE_ADDRESS__)
+#    define XERCES_STRING_NO_SSE2
+#  elif defined(__has_feature)
+#    if __has_feature(address_sanitizer)
+#      define XERCES_STRING_NO_SSE2
+#    endif
+#  endif
+#endif
+
 XERCES_CPP_NAMESPACE_BEGIN
 
 class XMLLCPTranscoder;
@@ -1440,6 +1453,22 @@ private :
 						const XMLCh* const str2, const int offset2,
 						const XMLSize_t charCount);
 
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+    /** @name SSE2 implementations */
+    //@{
+    /**
+      * Used by stringLen, equals and compareString when
+      * XMLPlatformUtils::fgSSE2ok is set, except in builds with address
+      * sanitizer. The strings must not be null.
+      * They read whole aligned blocks, or stop short of the end of a
+      * page, so they may read past the terminator but never fault.
+      */
+    static XMLSize_t stringLenSSE2(const XMLCh* const src);
+    static bool equalsSSE2(const XMLCh* str1, const XMLCh* str2);
+    static int compareStringSSE2(const XMLCh* str1, const XMLCh* str2);
+    //@}
+#endif
+
     static MemoryManager* fgMemoryManager;
 
     friend class XMLPlatformUtils;
@@ -1462,6 +1491,11 @@ inline XMLSize_t XMLString::stringLen(const XMLCh* const src)
     if (src == 0)
         return 0;
 
+#if defined(XERCES_HAVE_SSE2_INTRINSIC) && !defined(XERCES_STRING_NO_SSE2)
+    if (XMLPlatformUtils::fgSSE2ok)
+        return stringLenSSE2(src);
+#endif
+
     const XMLCh* pszTmp = src;
 
     while (*pszTmp++) ;
@@ -1529,6 +1563,11 @@ inline bool XMLString::equals(   const XMLCh* str1
     if (str1 == 0 || str2 == 0)
         return ((!str1 || !*str1) && (!str2 || !*str2));
 
+#if defined(XERCES_HAVE_SSE2_INTRINSIC) && !defined(XERCES_STRING_NO_SSE2)
+    if (XMLPlatformUtils::fgSSE2ok)
+        return equalsSSE2(str1, str2);
+#endif
+
     while (*str1)
         if(*str1++ != *str2++)  // they are different (or str2 is shorter and we hit the NULL)
             return false;
@@ -26,6 +26,11 @@
 #include <xercesc/util/XMLString.hpp>
 #include <xercesc/util/XMLUniDefs.hpp>
 #include <xercesc/util/XMLUTF8Transcoder.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+
+#if XERCES_HAVE_EMMINTRIN_H
+#   include <emmintrin.h>
+#endif
 
 XERCES_CPP_NAMESPACE_BEGIN
 
@@ -148,7 +153,25 @@ XMLUTF8Transcoder::transcodeFrom(const  XMLByte* const          srcData
             // Handle ASCII in groups instead of single character at a time.
             const XMLByte* srcPtr_save = srcPtr;
             const XMLSize_t chunkSize = (srcEnd-srcPtr)<(outEnd-outPtr)?(srcEnd-srcPtr):(outEnd-outPtr);
-            for(XMLSize_t i=0;i<chunkSize && *srcPtr <= 127;++i)
+            XMLSize_t i=0;
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+            // Widen blocks of 16 ASCII bytes at once
+            if(XMLPlatformUtils::fgSSE2ok && sizeof(XMLCh) == 2)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                for(;i+16<=chunkSize;i+=16)
+                {
+                    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPtr));
+                    if(_mm_movemask_epi8(bytes))
+                        break;
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(outPtr), _mm_unpacklo_epi8(bytes, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(outPtr+8), _mm_unpackhi_epi8(bytes, zero));
+                    srcPtr+=16;
+                    outPtr+=16;
+                }
+            }
+#endif
+            for(;i<chunkSize && *srcPtr <= 127;++i)
                 *outPtr++ = XMLCh(*srcPtr++);
             memset(sizePtr,1,srcPtr - srcPtr_save);
             sizePtr += srcPtr - srcPtr_save;
@@ -445,6 +468,28 @@ XMLUTF8Transcoder::transcodeTo( const   XMLCh* const    srcData
 
     while (srcPtr < srcEnd)
     {
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+        // Narrow blocks of 16 ASCII chars at once
+        if (*srcPtr < 0x80 && XMLPlatformUtils::fgSSE2ok && sizeof(XMLCh) == 2)
+        {
+            const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+            while ((srcEnd - srcPtr) >= 16 && (outEnd - outPtr) >= 16)
+            {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPtr));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPtr + 8));
+                __m128i test = _mm_and_si128(_mm_or_si128(lo, hi), nonAscii);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(test, _mm_setzero_si128())) != 0xFFFF)
+                    break;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(outPtr), _mm_packus_epi16(lo, hi));
+                srcPtr += 16;
+                outPtr += 16;
+            }
+
+            if (srcPtr == srcEnd)
+                break;
+        }
+#endif
+
         //
         //  Tentatively get the next char out. We have to get it into a
         //  32 bit value, because it could be a surrogate pair.
@@ -37,6 +37,7 @@ class TokenFactory;
 
 
 class XMLUTIL_EXPORT RangeToken : public Token {
+    friend class RegxDFABuilder;
 public:
     // -----------------------------------------------------------------------
     //  Public Constructors and Destructor
@@ -275,6 +275,7 @@ RegularExpression::RegularExpression(const char* const pattern,
      fOperations(0),
      fTokenTree(0),
      fFirstChar(0),
+     fDFA(0),
      fOpFactory(manager),
      fTokenFactory(0),
      fMemoryManager(manager)
@@ -312,6 +313,7 @@ RegularExpression::RegularExpression(const char* const pattern,
      fOperations(0),
      fTokenTree(0),
      fFirstChar(0),
+     fDFA(0),
      fOpFactory(manager),
      fTokenFactory(0),
      fMemoryManager(manager)
@@ -351,6 +353,7 @@ RegularExpression::RegularExpression(const XMLCh* const pattern,
      fOperations(0),
      fTokenTree(0),
      fFirstChar(0),
+     fDFA(0),
      fOpFactory(manager),
      fTokenFactory(0),
      fMemoryManager(manager)
@@ -386,6 +389,7 @@ RegularExpression::RegularExpression(const XMLCh* const pattern,
      fOperations(0),
      fTokenTree(0),
      fFirstChar(0),
+     fDFA(0),
      fOpFactory(manager),
      fTokenFactory(0),
      fMemoryManager(manager)
@@ -519,6 +523,10 @@ bool RegularExpression::matches(const XMLCh* const expression, const XMLSize_t s
                                 , MemoryManager* const manager) const
 {
 
+    // without groups to report, the automaton has the answer on its own
+    if (fDFA != 0 && pMatch == 0)
+        return fDFA->matches(expression, start, end);
+
     Context context(manager);
     XMLSize_t strLength = XMLString::stringLen(expression);
 
@@ -1459,6 +1467,8 @@ Op* RegularExpression::compile(const Token* const token, Op* const next,
         break;
     case Token::T_RANGE:
     case Token::T_NRANGE:
+        // made now, so that matching never changes the token
+        const_cast<RangeToken*>((const RangeToken*) token)->createMap();
         ret = fOpFactory.createRangeOp(token);
         ret->setNextOp(next);
         break;
@@ -1501,6 +1511,11 @@ void RegularExpression::prepare() {
 
     compile(fTokenTree);
 
+    //  In XML Schema mode the whole string has to match, which the automaton
+    //  answers in one pass; the Op list stays for matches that report groups
+    if (isSet(fOptions, XMLSCHEMA_MODE) && !fHasBackReferences)
+        fDFA = RegxDFA::build(fTokenTree, fOptions, fMemoryManager);
+
     fMinLength = fTokenTree->getMinLength();
     fFirstChar = 0;
 
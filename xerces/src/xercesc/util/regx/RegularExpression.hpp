@@ -33,6 +33,7 @@
 #include <xercesc/util/regx/BMPattern.hpp>
 #include <xercesc/util/regx/OpFactory.hpp>
 #include <xercesc/util/regx/RegxUtil.hpp>
+#include <xercesc/util/regx/RegxDFA.hpp>
 
 XERCES_CPP_NAMESPACE_BEGIN
 
@@ -591,6 +592,7 @@ protected:
     const Op*          fOperations;
     Token*             fTokenTree;
     RangeToken*        fFirstChar;
+    RegxDFA*           fDFA;
     static RangeToken* fWordRange;
     OpFactory          fOpFactory;
     TokenFactory*      fTokenFactory;
@@ -615,6 +617,7 @@ protected:
       fMemoryManager->deallocate(fPattern);//delete [] fPattern;
       fMemoryManager->deallocate(fFixedString);//delete [] fFixedString;
       delete fBMPattern;
+      delete fDFA;
       delete fTokenFactory;
   }
 
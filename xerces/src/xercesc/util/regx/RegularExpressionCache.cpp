@@ -0,0 +1,240 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/util/regx/RegularExpressionCache.hpp>
+#include <xercesc/util/regx/RegularExpression.hpp>
+#include <xercesc/util/Mutexes.hpp>
+#include <xercesc/util/XMLInitializer.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Local data
+//
+//  RegexCacheEntry
+//      One compiled expression and its key. fNextByKey and fNextByRegex
+//      chain the entries of a bucket of gKeyBuckets and of gRegexBuckets.
+//
+//  gIdleCount
+//      The entries that no validator uses, all in the global memory
+//      manager, at most kMaxIdle of them.
+// ---------------------------------------------------------------------------
+struct RegexCacheEntry
+{
+    XMLCh*              fPattern;
+    XMLCh*              fOptions;
+    MemoryManager*      fManager;
+    RegularExpression*  fRegex;
+    unsigned int        fRefCount;
+    XMLSize_t           fHashVal;
+    RegexCacheEntry*    fNextByKey;
+    RegexCacheEntry*    fNextByRegex;
+};
+
+static const XMLSize_t      kBucketCount = 211;
+static const unsigned int   kMaxIdle = 256;
+
+static XMLMutex*            gCacheMutex = 0;
+static RegexCacheEntry*          gKeyBuckets[kBucketCount];
+static RegexCacheEntry*          gRegexBuckets[kBucketCount];
+static unsigned int         gIdleCount = 0;
+
+
+// ---------------------------------------------------------------------------
+//  Local methods
+// ---------------------------------------------------------------------------
+static XMLSize_t hashKey(const XMLCh* const pattern
+                         , const XMLCh* const options
+                         , MemoryManager* const manager)
+{
+    XMLSize_t hashVal = XMLString::hash(pattern, kBucketCount);
+    if (options)
+        hashVal = hashVal * 31 + XMLString::hash(options, kBucketCount);
+    return (hashVal * 31 + (XMLSize_t) manager / sizeof(void*)) % kBucketCount;
+}
+
+static XMLSize_t hashRegex(const RegularExpression* const regex)
+{
+    return ((XMLSize_t) regex / sizeof(void*)) % kBucketCount;
+}
+
+static RegexCacheEntry* findEntry(const XMLCh* const pattern
+                             , const XMLCh* const options
+                             , MemoryManager* const manager
+                             , const XMLSize_t hashVal)
+{
+    for (RegexCacheEntry* entry = gKeyBuckets[hashVal]; entry; entry = entry->fNextByKey)
+    {
+        if (entry->fManager == manager
+            && XMLString::equals(entry->fPattern, pattern)
+            && XMLString::equals(entry->fOptions, options))
+            return entry;
+    }
+    return 0;
+}
+
+static void deleteEntry(RegexCacheEntry* const entry)
+{
+    delete entry->fRegex;
+    XMLPlatformUtils::fgMemoryManager->deallocate(entry->fPattern);
+    XMLPlatformUtils::fgMemoryManager->deallocate(entry->fOptions);
+    XMLPlatformUtils::fgMemoryManager->deallocate(entry);
+}
+
+// ---------------------------------------------------------------------------
+//  RegularExpressionCache: Public methods
+// ---------------------------------------------------------------------------
+RegularExpression*
+RegularExpressionCache::acquire(const XMLCh* const      pattern
+                                , const XMLCh* const    options
+                                , MemoryManager* const  manager)
+{
+    if (gCacheMutex == 0)
+        return new (manager) RegularExpression(pattern, options, manager);
+
+    const XMLSize_t hashVal = hashKey(pattern, options, manager);
+    {
+        XMLMutexLock lock(gCacheMutex);
+
+        RegexCacheEntry* const entry = findEntry(pattern, options, manager, hashVal);
+        if (entry)
+        {
+            if (entry->fRefCount++ == 0)
+                gIdleCount--;
+            return entry->fRegex;
+        }
+    }
+
+    //  Compiled without the lock, so the other threads are not held up by
+    //  it, and it throws without an entry made
+    RegularExpression* regex = new (manager) RegularExpression(pattern, options, manager);
+
+    XMLMutexLock lock(gCacheMutex);
+
+    // another thread may have compiled it meanwhile
+    RegexCacheEntry* entry = findEntry(pattern, options, manager, hashVal);
+    if (entry)
+    {
+        delete regex;
+        if (entry->fRefCount++ == 0)
+            gIdleCount--;
+        return entry->fRegex;
+    }
+
+    entry = (RegexCacheEntry*) XMLPlatformUtils::fgMemoryManager->allocate(sizeof(RegexCacheEntry));
+    entry->fPattern = XMLString::replicate(pattern, XMLPlatformUtils::fgMemoryManager);
+    entry->fOptions = XMLString::replicate(options, XMLPlatformUtils::fgMemoryManager);
+    entry->fManager = manager;
+    entry->fRegex = regex;
+    entry->fRefCount = 1;
+    entry->fHashVal = hashVal;
+
+    entry->fNextByKey = gKeyBuckets[hashVal];
+    gKeyBuckets[hashVal] = entry;
+
+    const XMLSize_t regexHash = hashRegex(regex);
+    entry->fNextByRegex = gRegexBuckets[regexHash];
+    gRegexBuckets[regexHash] = entry;
+
+    return regex;
+}
+
+bool RegularExpressionCache::release(RegularExpression* const regex)
+{
+    if (gCacheMutex == 0 || regex == 0)
+        return false;
+
+    XMLMutexLock lock(gCacheMutex);
+
+    const XMLSize_t regexHash = hashRegex(regex);
+    RegexCacheEntry** link = &gRegexBuckets[regexHash];
+    while (*link && (*link)->fRegex != regex)
+        link = &(*link)->fNextByRegex;
+
+    RegexCacheEntry* const entry = *link;
+    if (entry == 0)
+        return false;
+
+    if (--entry->fRefCount != 0)
+        return true;
+
+    //  The ones of the other memory managers go right away, as the manager
+    //  may not live much longer than the grammar
+    if (entry->fManager == XMLPlatformUtils::fgMemoryManager && gIdleCount < kMaxIdle)
+    {
+        gIdleCount++;
+        return true;
+    }
+
+    *link = entry->fNextByRegex;
+
+    RegexCacheEntry** keyLink = &gKeyBuckets[entry->fHashVal];
+    while (*keyLink != entry)
+        keyLink = &(*keyLink)->fNextByKey;
+    *keyLink = entry->fNextByKey;
+
+    deleteEntry(entry);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+//  Static initialize and cleanup methods
+// ---------------------------------------------------------------------------
+void XMLInitializer::initializeRegularExpressionCache()
+{
+    for (XMLSize_t index = 0; index < kBucketCount; index++)
+    {
+        gKeyBuckets[index] = 0;
+        gRegexBuckets[index] = 0;
+    }
+    gIdleCount = 0;
+    gCacheMutex = new XMLMutex(XMLPlatformUtils::fgMemoryManager);
+}
+
+void XMLInitializer::terminateRegularExpressionCache()
+{
+    for (XMLSize_t index = 0; index < kBucketCount; index++)
+    {
+        RegexCacheEntry* entry = gKeyBuckets[index];
+        while (entry)
+        {
+            RegexCacheEntry* const next = entry->fNextByKey;
+            deleteEntry(entry);
+            entry = next;
+        }
+        gKeyBuckets[index] = 0;
+        gRegexBuckets[index] = 0;
+    }
+    gIdleCount = 0;
+
+    delete gCacheMutex;
+    gCacheMutex = 0;
+}
+
+XERCES_CPP_NAMESPACE_END
+
+/**
+  * End of file RegularExpressionCache.cpp
+  */
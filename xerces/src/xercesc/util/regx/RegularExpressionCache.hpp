@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_REGULAREXPRESSIONCACHE_HPP)
+#define XERCESC_INCLUDE_GUARD_REGULAREXPRESSIONCACHE_HPP
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/util/PlatformUtils.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Forward Declaration
+// ---------------------------------------------------------------------------
+class RegularExpression;
+
+//
+//  The compiled expressions of the pattern facets, shared by all the
+//  datatype validators of the process that have the same pattern, options
+//  and memory manager. Schemas tend to repeat the same few patterns over
+//  many types, and over the grammars of the documents that use them.
+//
+//  The expressions are reference counted. One that no validator uses any
+//  longer is kept for the next grammar when it lives in the global memory
+//  manager, up to a limit, and deleted otherwise. Matching does not change
+//  a RegularExpression, so the threads can share them.
+//
+class XMLUTIL_EXPORT RegularExpressionCache
+{
+public:
+    // -----------------------------------------------------------------------
+    //  Public methods
+    // -----------------------------------------------------------------------
+
+    //  Returns the compiled expression, which the caller gives back with
+    //  release(). Throws a ParseException if the pattern is not valid.
+    static RegularExpression* acquire
+    (
+        const XMLCh* const      pattern
+        , const XMLCh* const    options
+        , MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    //  Returns false if the expression is not from acquire(), the caller
+    //  deletes it then
+    static bool release(RegularExpression* const regex);
+
+private:
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    RegularExpressionCache();
+    ~RegularExpressionCache();
+    RegularExpressionCache(const RegularExpressionCache&);
+    RegularExpressionCache& operator=(const RegularExpressionCache&);
+};
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
+
+/**
+  * End of file RegularExpressionCache.hpp
+  */
@@ -0,0 +1,769 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/util/regx/RegxDFA.hpp>
+#include <xercesc/util/regx/RegularExpression.hpp>
+#include <xercesc/util/regx/RangeToken.hpp>
+#include <xercesc/util/regx/RegxUtil.hpp>
+#include <xercesc/util/ValueVectorOf.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include <stdlib.h>
+#include <string.h>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Local data
+//
+//  Limits beyond which build() gives up, the expression is then matched by
+//  backtracking as before. The cell limit bounds the transition table to
+//  128K and the subset construction to as many steps.
+// ---------------------------------------------------------------------------
+static const unsigned int   kMaxNodes       = 2048;
+static const unsigned int   kMaxSets        = 256;
+static const unsigned int   kMaxIntervals   = 8192;
+static const unsigned int   kMaxCells       = 65536;
+static const unsigned int   kHashModulus    = 1021;
+
+static const unsigned int   kNoNode         = 0xFFFFFFFF;
+static const int            kEpsilonNode    = -1;
+static const int            kFinalNode      = -2;
+static const XMLInt32       kCodePointEnd   = 0x110000;
+
+enum SetKinds
+{
+    Set_Char
+    , Set_Dot
+    , Set_Range
+};
+
+static int compareCodePoints(const void* p1, const void* p2)
+{
+    const XMLInt32 ch1 = *(const XMLInt32*) p1;
+    const XMLInt32 ch2 = *(const XMLInt32*) p2;
+    return (ch1 < ch2) ? -1 : ((ch1 > ch2) ? 1 : 0);
+}
+
+static unsigned int hashWords(const XMLUInt32* const words, const unsigned int count)
+{
+    XMLUInt32 hashVal = 2166136261U;
+    for (unsigned int index = 0; index < count; index++)
+        hashVal = (hashVal ^ words[index]) * 16777619U;
+    return hashVal % kHashModulus;
+}
+
+// ---------------------------------------------------------------------------
+//  RegxDFABuilder: What RegxDFA::build() works with
+//
+//  The token tree is first compiled into a nondeterministic automaton the
+//  way RegularExpression::compile() builds its Op list. A node either
+//  consumes a char of one of the character sets or leads to up to two
+//  other nodes without consuming anything; node 0 is the final node. The
+//  code point space is then cut where any of the sets starts or ends and
+//  the pieces that belong to the same sets form one class. Last, the
+//  subset construction turns the automaton into the transition table.
+// ---------------------------------------------------------------------------
+class RegxDFABuilder
+{
+public:
+    RegxDFABuilder(const unsigned int options, MemoryManager* const manager);
+    ~RegxDFABuilder();
+
+    bool compile(const Token* const tokenTree);
+    bool makeClasses();
+    bool makeStates();
+
+    // -----------------------------------------------------------------------
+    //  The results, owned by the builder
+    // -----------------------------------------------------------------------
+    unsigned int        fIntervalCount;
+    XMLInt32*           fIntervalStarts;
+    unsigned short*     fIntervalClasses;
+    unsigned int        fClassCount;
+    unsigned int        fStateCount;
+    unsigned short*     fTransitions;
+    bool*               fAccepting;
+
+private:
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    RegxDFABuilder(const RegxDFABuilder&);
+    RegxDFABuilder& operator=(const RegxDFABuilder&);
+
+    // -----------------------------------------------------------------------
+    //  Private helper methods
+    // -----------------------------------------------------------------------
+    unsigned int addNode(const int set, const unsigned int out1, const unsigned int out2);
+    unsigned int addLeaf(const int kind, const XMLInt32 ch, RangeToken* const range
+                         , const unsigned int next);
+    unsigned int compile(const Token* const token, const unsigned int next);
+    unsigned int compileClosure(const Token* const token, const unsigned int next);
+    bool isMember(const unsigned int set, const XMLInt32 ch) const;
+    void addClosure(const unsigned int node, XMLUInt32* const words);
+    unsigned int findState(const XMLUInt32* const words);
+    void addState(const XMLUInt32* const words, const bool hashed);
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fNodeSets, fNodeOuts1, fNodeOuts2
+    //      Per node, the set of chars it consumes or kEpsilonNode or
+    //      kFinalNode, and the nodes it leads to.
+    //
+    //  fSetKinds, fSetChars, fSetRanges
+    //      The distinct character sets of the expression.
+    //
+    //  fClassSets
+    //      Per class, the sets that contain it, as fSetWords words.
+    //
+    //  fPositions
+    //      Per node, its bit in a state, or kNoNode for the nodes that do
+    //      not consume chars.
+    //
+    //  fFollows
+    //      Per position, the positions reached after it consumed a char.
+    //
+    //  fStateSets, fStateNext, fBuckets
+    //      The positions of each state, fPosWords words each, and the hash
+    //      table that finds the state of a set of positions.
+    // -----------------------------------------------------------------------
+    unsigned int        fOptions;
+    bool                fFailed;
+    unsigned int        fNodeCount;
+    int*                fNodeSets;
+    unsigned int*       fNodeOuts1;
+    unsigned int*       fNodeOuts2;
+    unsigned int        fSetCount;
+    int                 fSetKinds[kMaxSets];
+    XMLInt32            fSetChars[kMaxSets];
+    RangeToken*         fSetRanges[kMaxSets];
+    unsigned int        fSetWords;
+    XMLUInt32*          fClassSets;
+    unsigned int        fPosCount;
+    unsigned int        fPosWords;
+    unsigned int*       fPositions;
+    unsigned int*       fPosNodes;
+    XMLUInt32*          fFollows;
+    unsigned int*       fVisits;
+    unsigned int        fVisitStamp;
+    unsigned int*       fStack;
+    unsigned int        fMaxStates;
+    XMLUInt32*          fStateSets;
+    unsigned int*       fStateNext;
+    unsigned int        fBuckets[kHashModulus];
+    MemoryManager*      fMemoryManager;
+};
+
+RegxDFABuilder::RegxDFABuilder(const unsigned int options, MemoryManager* const manager)
+    : fIntervalCount(0)
+    , fIntervalStarts(0)
+    , fIntervalClasses(0)
+    , fClassCount(0)
+    , fStateCount(0)
+    , fTransitions(0)
+    , fAccepting(0)
+    , fOptions(options)
+    , fFailed(false)
+    , fNodeCount(0)
+    , fNodeSets(0)
+    , fNodeOuts1(0)
+    , fNodeOuts2(0)
+    , fSetCount(0)
+    , fSetWords(0)
+    , fClassSets(0)
+    , fPosCount(0)
+    , fPosWords(0)
+    , fPositions(0)
+    , fPosNodes(0)
+    , fFollows(0)
+    , fVisits(0)
+    , fVisitStamp(0)
+    , fStack(0)
+    , fMaxStates(0)
+    , fStateSets(0)
+    , fStateNext(0)
+    , fMemoryManager(manager)
+{
+}
+
+RegxDFABuilder::~RegxDFABuilder()
+{
+    fMemoryManager->deallocate(fIntervalStarts);
+    fMemoryManager->deallocate(fIntervalClasses);
+    fMemoryManager->deallocate(fTransitions);
+    fMemoryManager->deallocate(fAccepting);
+    fMemoryManager->deallocate(fNodeSets);
+    fMemoryManager->deallocate(fNodeOuts1);
+    fMemoryManager->deallocate(fNodeOuts2);
+    fMemoryManager->deallocate(fClassSets);
+    fMemoryManager->deallocate(fPositions);
+    fMemoryManager->deallocate(fPosNodes);
+    fMemoryManager->deallocate(fFollows);
+    fMemoryManager->deallocate(fVisits);
+    fMemoryManager->deallocate(fStack);
+    fMemoryManager->deallocate(fStateSets);
+    fMemoryManager->deallocate(fStateNext);
+}
+
+// ---------------------------------------------------------------------------
+//  RegxDFABuilder: The nondeterministic automaton
+// ---------------------------------------------------------------------------
+bool RegxDFABuilder::compile(const Token* const tokenTree)
+{
+    fNodeSets = (int*) fMemoryManager->allocate(kMaxNodes * sizeof(int));
+    fNodeOuts1 = (unsigned int*) fMemoryManager->allocate(kMaxNodes * sizeof(unsigned int));
+    fNodeOuts2 = (unsigned int*) fMemoryManager->allocate(kMaxNodes * sizeof(unsigned int));
+
+    const unsigned int finalNode = addNode(kFinalNode, kNoNode, kNoNode);
+    const unsigned int startNode = compile(tokenTree, finalNode);
+
+    // the start is the first node of the subset construction
+    if (!fFailed)
+        fNodeOuts1[finalNode] = startNode;
+
+    return !fFailed;
+}
+
+unsigned int RegxDFABuilder::addNode(const int set
+                                     , const unsigned int out1
+                                     , const unsigned int out2)
+{
+    if (fNodeCount == kMaxNodes)
+    {
+        fFailed = true;
+        return 0;
+    }
+
+    fNodeSets[fNodeCount] = set;
+    fNodeOuts1[fNodeCount] = out1;
+    fNodeOuts2[fNodeCount] = out2;
+    return fNodeCount++;
+}
+
+unsigned int RegxDFABuilder::addLeaf(const int kind
+                                     , const XMLInt32 ch
+                                     , RangeToken* const range
+                                     , const unsigned int next)
+{
+    unsigned int set = 0;
+    while (set < fSetCount
+           && (fSetKinds[set] != kind || fSetChars[set] != ch || fSetRanges[set] != range))
+        set++;
+
+    if (set == fSetCount)
+    {
+        if (fSetCount == kMaxSets)
+        {
+            fFailed = true;
+            return next;
+        }
+        fSetKinds[set] = kind;
+        fSetChars[set] = ch;
+        fSetRanges[set] = range;
+        fSetCount++;
+    }
+
+    return addNode((int) set, next, kNoNode);
+}
+
+unsigned int RegxDFABuilder::compile(const Token* const token, const unsigned int next)
+{
+    if (fFailed)
+        return next;
+
+    unsigned int ret = next;
+    switch (token->getTokenType())
+    {
+    case Token::T_EMPTY:
+        break;
+    case Token::T_CHAR:
+        ret = addLeaf(Set_Char, token->getChar(), 0, next);
+        break;
+    case Token::T_DOT:
+        ret = addLeaf(Set_Dot, 0, 0, next);
+        break;
+    case Token::T_RANGE:
+    case Token::T_NRANGE:
+        ret = addLeaf(Set_Range, 0, const_cast<RangeToken*>((const RangeToken*) token), next);
+        break;
+    case Token::T_STRING:
+        {
+            // matched char by char, so a surrogate in it would match half
+            // of a pair
+            const XMLCh* const literal = token->getString();
+            for (XMLSize_t index = XMLString::stringLen(literal); index > 0; index--)
+            {
+                if ((literal[index - 1] & 0xF800) == 0xD800)
+                {
+                    fFailed = true;
+                    break;
+                }
+                ret = addLeaf(Set_Char, literal[index - 1], 0, ret);
+            }
+        }
+        break;
+    case Token::T_CONCAT:
+        for (XMLSize_t index = token->size(); index > 0; index--)
+            ret = compile(token->getChild(index - 1), ret);
+        break;
+    case Token::T_UNION:
+        {
+            const XMLSize_t tokSize = token->size();
+            if (tokSize == 0)
+            {
+                fFailed = true;
+                break;
+            }
+
+            ret = compile(token->getChild(tokSize - 1), next);
+            for (XMLSize_t index = tokSize - 1; index > 0; index--)
+                ret = addNode(kEpsilonNode, compile(token->getChild(index - 1), next), ret);
+        }
+        break;
+    case Token::T_PAREN:
+        ret = compile(token->getChild(0), next);
+        break;
+    case Token::T_CLOSURE:
+    case Token::T_NONGREEDYCLOSURE:
+        // the same strings match whether the closure is greedy or not
+        ret = compileClosure(token, next);
+        break;
+    default:
+        // anchors and back references
+        fFailed = true;
+        break;
+    }
+
+    return ret;
+}
+
+unsigned int RegxDFABuilder::compileClosure(const Token* const token, const unsigned int next)
+{
+    // the same repetitions as RegularExpression::compileClosure()
+    const Token* const childTok = token->getChild(0);
+    const int min = token->getMin();
+    int max = token->getMax();
+
+    unsigned int ret = next;
+    if (min >= 0 && min == max)
+    {
+        for (int i = 0; i < min; i++)
+            ret = compile(childTok, ret);
+        return ret;
+    }
+
+    if (min > 0 && max > 0)
+        max -= min;
+
+    if (max > 0)
+    {
+        for (int i = 0; i < max; i++)
+            ret = addNode(kEpsilonNode, compile(childTok, ret), next);
+    }
+    else
+    {
+        const unsigned int loop = addNode(kEpsilonNode, kNoNode, next);
+        const unsigned int child = compile(childTok, loop);
+        if (fFailed)
+            return next;
+
+        fNodeOuts1[loop] = child;
+        ret = loop;
+    }
+
+    for (int i = 0; i < min; i++)
+        ret = compile(childTok, ret);
+
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+//  RegxDFABuilder: The character classes
+// ---------------------------------------------------------------------------
+bool RegxDFABuilder::isMember(const unsigned int set, const XMLInt32 ch) const
+{
+    switch (fSetKinds[set])
+    {
+    case Set_Char:
+        return ch == fSetChars[set];
+    case Set_Dot:
+        // the same test as RegularExpression::matchDot()
+        return RegularExpression::isSet(fOptions, RegularExpression::SINGLE_LINE)
+               || !RegxUtil::isEOLChar((XMLCh) ch);
+    default:
+        break;
+    }
+
+    RangeToken* const range = fSetRanges[set];
+    if (!range->fSorted || !range->fCompacted)
+        return range->match(ch);
+
+    // disjoint and in order, so the answer of match() without its scan
+    unsigned int low = 0;
+    unsigned int high = range->fElemCount / 2;
+    while (low < high)
+    {
+        const unsigned int mid = (low + high) / 2;
+        if (range->fRanges[mid * 2 + 1] < ch)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    const bool inRanges = low < range->fElemCount / 2 && range->fRanges[low * 2] <= ch;
+    return (range->getTokenType() == Token::T_RANGE) == inRanges;
+}
+
+bool RegxDFABuilder::makeClasses()
+{
+    ValueVectorOf<XMLInt32> bounds(64, fMemoryManager);
+    bounds.addElement(0);
+    bounds.addElement(RangeToken::MAPSIZE);
+
+    for (unsigned int set = 0; set < fSetCount; set++)
+    {
+        switch (fSetKinds[set])
+        {
+        case Set_Char:
+            bounds.addElement(fSetChars[set]);
+            bounds.addElement(fSetChars[set] + 1);
+            break;
+        case Set_Dot:
+            // the end of line chars, in every plane because matchDot()
+            // tests the low 16 bits
+            for (XMLInt32 plane = 0; plane < kCodePointEnd; plane += 0x10000)
+            {
+                bounds.addElement(plane + chLF);
+                bounds.addElement(plane + chLF + 1);
+                bounds.addElement(plane + chCR);
+                bounds.addElement(plane + chCR + 1);
+                bounds.addElement(plane + chLineSeparator);
+                bounds.addElement(plane + chParagraphSeparator + 1);
+            }
+            break;
+        default:
+            {
+                const RangeToken* const range = fSetRanges[set];
+                for (unsigned int index = 0; index + 1 < range->fElemCount; index += 2)
+                {
+                    bounds.addElement(range->fRanges[index]);
+                    bounds.addElement(range->fRanges[index + 1] + 1);
+                }
+            }
+            break;
+        }
+
+        if (bounds.size() > 2 * kMaxIntervals)
+            return false;
+    }
+
+    // sorted and unique, within the code point space
+    XMLInt32* const starts = (XMLInt32*) fMemoryManager->allocate(bounds.size() * sizeof(XMLInt32));
+    ArrayJanitor<XMLInt32> janStarts(starts, fMemoryManager);
+    memcpy(starts, bounds.rawData(), bounds.size() * sizeof(XMLInt32));
+    qsort(starts, bounds.size(), sizeof(XMLInt32), compareCodePoints);
+
+    XMLSize_t boundCount = 0;
+    for (XMLSize_t index = 0; index < bounds.size(); index++)
+    {
+        if (starts[index] < 0 || starts[index] >= kCodePointEnd)
+            continue;
+        if (boundCount == 0 || starts[boundCount - 1] != starts[index])
+            starts[boundCount++] = starts[index];
+    }
+    if (boundCount > kMaxIntervals)
+        return false;
+
+    //  Every set either holds a whole interval or nothing of it, so the
+    //  sets that hold its first code point make its signature, and the
+    //  intervals with the same signature are one class
+    fSetWords = (fSetCount + 31) / 32;
+    fClassSets = (XMLUInt32*) fMemoryManager->allocate(boundCount * fSetWords * sizeof(XMLUInt32));
+    fIntervalStarts = (XMLInt32*) fMemoryManager->allocate(boundCount * sizeof(XMLInt32));
+    fIntervalClasses = (unsigned short*) fMemoryManager->allocate(boundCount * sizeof(unsigned short));
+
+    unsigned int* const classNext = (unsigned int*) fMemoryManager->allocate(boundCount * sizeof(unsigned int));
+    ArrayJanitor<unsigned int> janNext(classNext, fMemoryManager);
+    for (unsigned int index = 0; index < kHashModulus; index++)
+        fBuckets[index] = kNoNode;
+
+    for (XMLSize_t index = 0; index < boundCount; index++)
+    {
+        XMLUInt32* const signature = fClassSets + fClassCount * fSetWords;
+        memset(signature, 0, fSetWords * sizeof(XMLUInt32));
+        for (unsigned int set = 0; set < fSetCount; set++)
+        {
+            if (isMember(set, starts[index]))
+                signature[set / 32] |= ((XMLUInt32) 1) << (set % 32);
+        }
+
+        const unsigned int hashVal = hashWords(signature, fSetWords);
+        unsigned int curClass = fBuckets[hashVal];
+        while (curClass != kNoNode
+               && memcmp(fClassSets + curClass * fSetWords, signature, fSetWords * sizeof(XMLUInt32)) != 0)
+            curClass = classNext[curClass];
+
+        if (curClass == kNoNode)
+        {
+            curClass = fClassCount++;
+            classNext[curClass] = fBuckets[hashVal];
+            fBuckets[hashVal] = curClass;
+        }
+
+        // adjacent intervals of the same class are merged
+        if (fIntervalCount == 0 || fIntervalClasses[fIntervalCount - 1] != curClass)
+        {
+            fIntervalStarts[fIntervalCount] = starts[index];
+            fIntervalClasses[fIntervalCount] = (unsigned short) curClass;
+            fIntervalCount++;
+        }
+    }
+
+    return fClassCount <= kMaxCells / 2;
+}
+
+// ---------------------------------------------------------------------------
+//  RegxDFABuilder: The subset construction
+// ---------------------------------------------------------------------------
+void RegxDFABuilder::addClosure(const unsigned int node, XMLUInt32* const words)
+{
+    fVisitStamp++;
+
+    unsigned int depth = 0;
+    fStack[depth++] = node;
+    while (depth)
+    {
+        const unsigned int curNode = fStack[--depth];
+        if (curNode == kNoNode || fVisits[curNode] == fVisitStamp)
+            continue;
+
+        fVisits[curNode] = fVisitStamp;
+        if (fNodeSets[curNode] == kEpsilonNode)
+        {
+            fStack[depth++] = fNodeOuts1[curNode];
+            fStack[depth++] = fNodeOuts2[curNode];
+        }
+        else
+        {
+            const unsigned int pos = fPositions[curNode];
+            words[pos / 32] |= ((XMLUInt32) 1) << (pos % 32);
+        }
+    }
+}
+
+unsigned int RegxDFABuilder::findState(const XMLUInt32* const words)
+{
+    for (unsigned int state = fBuckets[hashWords(words, fPosWords)];
+         state != kNoNode;
+         state = fStateNext[state])
+    {
+        if (memcmp(fStateSets + state * fPosWords, words, fPosWords * sizeof(XMLUInt32)) == 0)
+            return state;
+    }
+    return kNoNode;
+}
+
+void RegxDFABuilder::addState(const XMLUInt32* const words, const bool hashed)
+{
+    memcpy(fStateSets + fStateCount * fPosWords, words, fPosWords * sizeof(XMLUInt32));
+
+    const unsigned int hashVal = hashWords(words, fPosWords);
+    fStateNext[fStateCount] = hashed ? fBuckets[hashVal] : kNoNode;
+    if (hashed)
+        fBuckets[hashVal] = fStateCount;
+
+    fStateCount++;
+}
+
+bool RegxDFABuilder::makeStates()
+{
+    // the final node and the nodes that consume chars are the positions
+    fPositions = (unsigned int*) fMemoryManager->allocate(fNodeCount * sizeof(unsigned int));
+    fPosNodes = (unsigned int*) fMemoryManager->allocate(fNodeCount * sizeof(unsigned int));
+    for (unsigned int node = 0; node < fNodeCount; node++)
+    {
+        fPositions[node] = kNoNode;
+        if (fNodeSets[node] != kEpsilonNode)
+        {
+            fPosNodes[fPosCount] = node;
+            fPositions[node] = fPosCount++;
+        }
+    }
+    fPosWords = (fPosCount + 31) / 32;
+
+    fVisits = (unsigned int*) fMemoryManager->allocate(fNodeCount * sizeof(unsigned int));
+    memset(fVisits, 0, fNodeCount * sizeof(unsigned int));
+    fStack = (unsigned int*) fMemoryManager->allocate((2 * fNodeCount + 1) * sizeof(unsigned int));
+
+    //  The final node's out is the start; it never consumes a char, so its
+    //  follow set is the start state
+    fFollows = (XMLUInt32*) fMemoryManager->allocate(fPosCount * fPosWords * sizeof(XMLUInt32));
+    memset(fFollows, 0, fPosCount * fPosWords * sizeof(XMLUInt32));
+    for (unsigned int pos = 0; pos < fPosCount; pos++)
+        addClosure(fNodeOuts1[fPosNodes[pos]], fFollows + pos * fPosWords);
+
+    fMaxStates = kMaxCells / fClassCount;
+    if (fMaxStates > 0xFFFF)
+        fMaxStates = 0xFFFF;
+    if (fMaxStates < 2)
+        return false;
+
+    fStateSets = (XMLUInt32*) fMemoryManager->allocate(fMaxStates * fPosWords * sizeof(XMLUInt32));
+    fStateNext = (unsigned int*) fMemoryManager->allocate(fMaxStates * sizeof(unsigned int));
+    fTransitions = (unsigned short*) fMemoryManager->allocate(fMaxStates * fClassCount * sizeof(unsigned short));
+    for (unsigned int index = 0; index < kHashModulus; index++)
+        fBuckets[index] = kNoNode;
+
+    XMLUInt32* const newSet = (XMLUInt32*) fMemoryManager->allocate((fPosWords + 1) * sizeof(XMLUInt32));
+    ArrayJanitor<XMLUInt32> janSet(newSet, fMemoryManager);
+    unsigned int* const leaves = (unsigned int*) fMemoryManager->allocate((fPosCount + 1) * sizeof(unsigned int));
+    ArrayJanitor<unsigned int> janLeaves(leaves, fMemoryManager);
+
+    // the dead state, then the start state
+    memset(newSet, 0, fPosWords * sizeof(XMLUInt32));
+    addState(newSet, true);
+    const unsigned int finalPos = fPositions[0];
+    addState(fFollows + finalPos * fPosWords, false);
+
+    for (unsigned int state = 0; state < fStateCount; state++)
+    {
+        //  The positions of the state that consume chars
+        unsigned int leafCount = 0;
+        const XMLUInt32* const stateSet = fStateSets + state * fPosWords;
+        for (unsigned int pos = 0; pos < fPosCount; pos++)
+        {
+            if (pos != finalPos && (stateSet[pos / 32] >> (pos % 32)) & 1)
+                leaves[leafCount++] = pos;
+        }
+
+        unsigned short* const row = fTransitions + state * fClassCount;
+        for (unsigned int curClass = 0; curClass < fClassCount; curClass++)
+        {
+            const XMLUInt32* const classSets = fClassSets + curClass * fSetWords;
+
+            memset(newSet, 0, fPosWords * sizeof(XMLUInt32));
+            for (unsigned int leaf = 0; leaf < leafCount; leaf++)
+            {
+                const unsigned int pos = leaves[leaf];
+                const unsigned int set = (unsigned int) fNodeSets[fPosNodes[pos]];
+                if ((classSets[set / 32] >> (set % 32)) & 1)
+                {
+                    const XMLUInt32* const follow = fFollows + pos * fPosWords;
+                    for (unsigned int word = 0; word < fPosWords; word++)
+                        newSet[word] |= follow[word];
+                }
+            }
+
+            unsigned int next = findState(newSet);
+            if (next == kNoNode)
+            {
+                if (fStateCount == fMaxStates)
+                    return false;
+
+                next = fStateCount;
+                addState(newSet, true);
+            }
+            row[curClass] = (unsigned short) next;
+        }
+    }
+
+    fAccepting = (bool*) fMemoryManager->allocate(fStateCount * sizeof(bool));
+    for (unsigned int state = 0; state < fStateCount; state++)
+        fAccepting[state] = ((fStateSets[state * fPosWords + finalPos / 32] >> (finalPos % 32)) & 1) != 0;
+
+    return true;
+}
+
+
+// ---------------------------------------------------------------------------
+//  RegxDFA: Constructors and Destructor
+// ---------------------------------------------------------------------------
+RegxDFA::RegxDFA(MemoryManager* const manager)
+    : fIntervalCount(0)
+    , fIntervalStarts(0)
+    , fIntervalClasses(0)
+    , fClassCount(0)
+    , fStateCount(0)
+    , fTransitions(0)
+    , fAccepting(0)
+    , fMemoryManager(manager)
+{
+}
+
+RegxDFA::~RegxDFA()
+{
+    fMemoryManager->deallocate(fIntervalStarts);
+    fMemoryManager->deallocate(fIntervalClasses);
+    fMemoryManager->deallocate(fTransitions);
+    fMemoryManager->deallocate(fAccepting);
+}
+
+RegxDFA* RegxDFA::build(const Token* const      tokenTree
+                        , const unsigned int    options
+                        , MemoryManager* const  manager)
+{
+    if (RegularExpression::isSet(options, RegularExpression::IGNORE_CASE))
+        return 0;
+
+    RegxDFABuilder builder(options, manager);
+    if (!builder.compile(tokenTree) || !builder.makeClasses() || !builder.makeStates())
+        return 0;
+
+    RegxDFA* const dfa = new (manager) RegxDFA(manager);
+
+    //  The tables are taken over from the builder, the transitions shrunk
+    //  to the states that were made
+    dfa->fIntervalCount = builder.fIntervalCount;
+    dfa->fIntervalStarts = builder.fIntervalStarts;
+    dfa->fIntervalClasses = builder.fIntervalClasses;
+    builder.fIntervalStarts = 0;
+    builder.fIntervalClasses = 0;
+
+    dfa->fClassCount = builder.fClassCount;
+    dfa->fStateCount = builder.fStateCount;
+    dfa->fAccepting = builder.fAccepting;
+    builder.fAccepting = 0;
+
+    const XMLSize_t cellCount = (XMLSize_t) dfa->fStateCount * dfa->fClassCount;
+    dfa->fTransitions = (unsigned short*) manager->allocate(cellCount * sizeof(unsigned short));
+    memcpy(dfa->fTransitions, builder.fTransitions, cellCount * sizeof(unsigned short));
+
+    for (XMLInt32 ch = 0; ch < kLowCount; ch++)
+    {
+        unsigned int index = 0;
+        while (index + 1 < dfa->fIntervalCount && dfa->fIntervalStarts[index + 1] <= ch)
+            index++;
+        dfa->fLowClasses[ch] = dfa->fIntervalClasses[index];
+    }
+
+    return dfa;
+}
+
+XERCES_CPP_NAMESPACE_END
+
+/**
+  * End of file RegxDFA.cpp
+  */
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_REGXDFA_HPP)
+#define XERCESC_INCLUDE_GUARD_REGXDFA_HPP
+
+// ---------------------------------------------------------------------------
+//  Includes
+// ---------------------------------------------------------------------------
+#include <xercesc/util/PlatformUtils.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+
+// ---------------------------------------------------------------------------
+//  Forward Declaration
+// ---------------------------------------------------------------------------
+class Token;
+
+//
+//  A deterministic automaton for a regular expression that uses only
+//  characters, strings, character classes, '.', grouping, alternation and
+//  quantifiers, which covers the XML Schema regular expression syntax. It
+//  tells whether a whole string is in the language of the expression
+//  without backtracking, in one table lookup per character.
+//
+//  The code points are divided into classes that no character set of the
+//  expression tells apart, and the transition table is indexed by state
+//  and class. A lone surrogate never matches, like in RegularExpression.
+//
+class XMLUTIL_EXPORT RegxDFA : public XMemory
+{
+public:
+    // -----------------------------------------------------------------------
+    //  Public Constructors and Destructor
+    // -----------------------------------------------------------------------
+    ~RegxDFA();
+
+    //  Returns 0 if the token tree is outside of the supported subset (back
+    //  references, anchors, ignore case) or the automaton would be too large
+    static RegxDFA* build
+    (
+        const Token* const      tokenTree
+        , const unsigned int    options
+        , MemoryManager* const  manager = XMLPlatformUtils::fgMemoryManager
+    );
+
+    // -----------------------------------------------------------------------
+    //  Matching methods
+    // -----------------------------------------------------------------------
+    bool matches
+    (
+        const XMLCh* const      matchString
+        , const XMLSize_t       start
+        , const XMLSize_t       end
+    ) const;
+
+private:
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    RegxDFA(MemoryManager* const manager);
+    RegxDFA(const RegxDFA&);
+    RegxDFA& operator=(const RegxDFA&);
+
+    // -----------------------------------------------------------------------
+    //  Private Helper methods
+    // -----------------------------------------------------------------------
+    unsigned int getClass(const XMLInt32 ch) const;
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fLowClasses
+    //      The class of each code point below kLowCount.
+    //
+    //  fIntervalStarts
+    //  fIntervalClasses
+    //      The code point space cut into fIntervalCount intervals, sorted by
+    //      their first code point, and the class of each one.
+    //
+    //  fClassCount
+    //  fStateCount
+    //      Number of classes and of states. State 0 is the dead state, the
+    //      automaton starts in state 1.
+    //
+    //  fTransitions
+    //      The next state for each state and class, at
+    //      [state * fClassCount + class].
+    //
+    //  fAccepting
+    //      Whether the string matches when it ends in the state.
+    // -----------------------------------------------------------------------
+    enum { kLowCount = 128 };
+
+    unsigned short      fLowClasses[kLowCount];
+    unsigned int        fIntervalCount;
+    XMLInt32*           fIntervalStarts;
+    unsigned short*     fIntervalClasses;
+    unsigned int        fClassCount;
+    unsigned int        fStateCount;
+    unsigned short*     fTransitions;
+    bool*               fAccepting;
+    MemoryManager*      fMemoryManager;
+};
+
+
+// ---------------------------------------------------------------------------
+//  RegxDFA: Matching methods
+// ---------------------------------------------------------------------------
+inline unsigned int RegxDFA::getClass(const XMLInt32 ch) const
+{
+    if (ch < kLowCount)
+        return fLowClasses[ch];
+
+    // the last interval that starts at or before ch
+    unsigned int low = 0;
+    unsigned int high = fIntervalCount;
+    while (high - low > 1)
+    {
+        const unsigned int mid = (low + high) / 2;
+        if (fIntervalStarts[mid] <= ch)
+            low = mid;
+        else
+            high = mid;
+    }
+    return fIntervalClasses[low];
+}
+
+inline bool RegxDFA::matches(const XMLCh* const    matchString
+                             , const XMLSize_t     start
+                             , const XMLSize_t     end) const
+{
+    if (start > end)
+        return false;
+
+    unsigned int state = 1;
+    for (XMLSize_t index = start; index < end; index++)
+    {
+        XMLInt32 ch = matchString[index];
+        if ((ch & 0xF800) == 0xD800)
+        {
+            if (ch > 0xDBFF || index + 1 >= end
+                || (matchString[index + 1] & 0xFC00) != 0xDC00)
+                return false;
+
+            ch = ((ch - 0xD800) << 10) + (matchString[++index] - 0xDC00) + 0x10000;
+        }
+
+        state = fTransitions[state * fClassCount + getClass(ch)];
+        if (state == 0)
+            return false;
+    }
+    return fAccepting[state];
+}
+
+XERCES_CPP_NAMESPACE_END
+
+#endif
+
+/**
+  * End of file RegxDFA.hpp
+  */
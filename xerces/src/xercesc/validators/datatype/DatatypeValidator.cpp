@@ -197,7 +197,8 @@ void DatatypeValidator::setTypeName(const XMLCh* const typeName)
 void DatatypeValidator::cleanUp() {
 
 	delete fFacets;
-    delete fRegex;
+    if (!RegularExpressionCache::release(fRegex))
+        delete fRegex;
     if (fPattern)
         fMemoryManager->deallocate(fPattern);//delete [] fPattern;
     if (fTypeName)
@@ -324,7 +325,7 @@ void DatatypeValidator::serialize(XSerializeEngine& serEng)
         /***
          * don't serialize fRegex
          ***/
-        fRegex = new (fMemoryManager) RegularExpression(fPattern, SchemaSymbols::fgRegEx_XOption, fMemoryManager);
+        fRegex = RegularExpressionCache::acquire(fPattern, SchemaSymbols::fgRegEx_XOption, fMemoryManager);
 
     }
 
@@ -27,6 +27,7 @@
 #include <xercesc/util/KVStringPair.hpp>
 #include <xercesc/util/XMLUniDefs.hpp>
 #include <xercesc/util/regx/RegularExpression.hpp>
+#include <xercesc/util/regx/RegularExpressionCache.hpp>
 #include <xercesc/validators/schema/SchemaSymbols.hpp>
 #include <xercesc/internal/XSerializable.hpp>
 #include <xercesc/framework/psvi/XSSimpleTypeDefinition.hpp>
@@ -670,10 +671,12 @@ inline void DatatypeValidator::setPattern(const XMLCh* pattern)
 {
     if (fPattern) {
         fMemoryManager->deallocate(fPattern);//delete [] fPattern;
-        delete fRegex;
+        if (!RegularExpressionCache::release(fRegex))
+            delete fRegex;
+        fRegex = 0;
     }
     fPattern = XMLString::replicate(pattern, fMemoryManager);
-    fRegex = new (fMemoryManager) RegularExpression(fPattern, SchemaSymbols::fgRegEx_XOption, fMemoryManager);
+    fRegex = RegularExpressionCache::acquire(fPattern, SchemaSymbols::fgRegEx_XOption, fMemoryManager);
 }
 
 inline void DatatypeValidator::setRegex(RegularExpression* const regex)
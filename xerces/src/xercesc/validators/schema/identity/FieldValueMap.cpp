@@ -38,6 +38,8 @@ FieldValueMap::FieldValueMap(MemoryManager* const manager)
     , fValidators(0)
     , fValues(0)
     , fMemoryManager(manager)
+    , fHashVal(0)
+    , fHashValValid(false)
 {
 }
 
@@ -47,6 +49,8 @@ FieldValueMap::FieldValueMap(const FieldValueMap& other)
     , fValidators(0)
     , fValues(0)
     , fMemoryManager(other.fMemoryManager)
+    , fHashVal(other.fHashVal)
+    , fHashValValid(other.fHashValValid)
 {
     if (other.fFields) {
         CleanupType cleanup(this, &FieldValueMap::cleanUp);
@@ -111,6 +115,7 @@ bool FieldValueMap::indexOf(const IC_Field* const key, XMLSize_t& location) cons
 
 void FieldValueMap::clear()
 {
+    fHashValValid = false;
     if(fFields)
         fFields->removeAllElements();
     if(fValidators)
@@ -75,6 +75,13 @@ public:
     bool indexOf(const IC_Field* const key, XMLSize_t& location) const;
     void clear();
 
+    // -----------------------------------------------------------------------
+    //  Hash value cache, used by ICValueHasher. The value is dropped by put()
+    //  and clear() and kept by the copy constructor.
+    // -----------------------------------------------------------------------
+    bool getCachedHashVal(XMLSize_t& hashVal) const;
+    void setCachedHashVal(const XMLSize_t hashVal) const;
+
 private:
     // -----------------------------------------------------------------------
     //  Private helper methods
@@ -93,6 +100,8 @@ private:
     ValueVectorOf<DatatypeValidator*>* fValidators;
     RefArrayVectorOf<XMLCh>*           fValues;
     MemoryManager*                     fMemoryManager;
+    mutable XMLSize_t                  fHashVal;
+    mutable bool                       fHashValValid;
 };
 
 
@@ -160,6 +169,18 @@ inline XMLSize_t FieldValueMap::size() const {
     return 0;
 }
 
+inline bool FieldValueMap::getCachedHashVal(XMLSize_t& hashVal) const {
+
+    hashVal = fHashVal;
+    return fHashValValid;
+}
+
+inline void FieldValueMap::setCachedHashVal(const XMLSize_t hashVal) const {
+
+    fHashVal = hashVal;
+    fHashValValid = true;
+}
+
 // ---------------------------------------------------------------------------
 //  FieldValueMap: Setter methods
 // ---------------------------------------------------------------------------
@@ -167,6 +188,8 @@ inline void FieldValueMap::put(IC_Field* const key,
                                DatatypeValidator* const dv,
                                const XMLCh* const value) {
 
+    fHashValValid = false;
+
     if (!fFields) {
         fFields = new (fMemoryManager) ValueVectorOf<IC_Field*>(4, fMemoryManager);
         fValidators = new (fMemoryManager) ValueVectorOf<DatatypeValidator*>(4, fMemoryManager);
@@ -40,6 +40,20 @@ XERCES_CPP_NAMESPACE_BEGIN
 XMLSize_t ICValueHasher::getHashVal(const void* key, XMLSize_t mod) const
 {
     const FieldValueMap* valueMap=(const FieldValueMap*)key;
+    XMLSize_t hashVal;
+
+    // the full width hash is computed once per tuple, it needs the canonical
+    // representation of every value and is reused when the table grows
+    if (!valueMap->getCachedHashVal(hashVal)) {
+        hashVal = computeHashVal(valueMap);
+        valueMap->setCachedHashVal(hashVal);
+    }
+
+    return hashVal % mod;
+}
+
+XMLSize_t ICValueHasher::computeHashVal(const FieldValueMap* const valueMap) const
+{
     XMLSize_t hashVal = 0;
 
     XMLSize_t size = valueMap->size();
@@ -52,14 +66,14 @@ XMLSize_t ICValueHasher::getHashVal(const void* key, XMLSize_t mod) const
         const XMLCh* canonVal = (dv && val)?dv->getCanonicalRepresentation(val, fMemoryManager):0;
         if(canonVal)
         {
-            hashVal += XMLString::hash(canonVal, mod);
+            hashVal += XMLString::hash(canonVal, (XMLSize_t) -1);
             fMemoryManager->deallocate((void*)canonVal);
         }
         else if(val)
-            hashVal += XMLString::hash(val, mod);
+            hashVal += XMLString::hash(val, (XMLSize_t) -1);
     }
 
-    return hashVal % mod;
+    return hashVal;
 }
 
 bool ICValueHasher::equals(const void *const key1, const void *const key2) const
@@ -67,6 +81,12 @@ bool ICValueHasher::equals(const void *const key1, const void *const key2) const
     const FieldValueMap* left=(const FieldValueMap*)key1;
     const FieldValueMap* right=(const FieldValueMap*)key2;
 
+    // tuples with different hashes cannot be equal, this skips the value
+    // space comparisons for the tuples sharing a bucket
+    XMLSize_t lHash, rHash;
+    if (left->getCachedHashVal(lHash) && right->getCachedHashVal(rHash) && lHash != rHash)
+        return false;
+
     XMLSize_t lSize = left->size();
     XMLSize_t rSize = right->size();
     if (lSize == rSize) 
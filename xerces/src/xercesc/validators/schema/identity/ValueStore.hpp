@@ -65,6 +65,12 @@ struct ICValueHasher
     bool isDuplicateOf(DatatypeValidator* const dv1, const XMLCh* const val1,
                        DatatypeValidator* const dv2, const XMLCh* const val2) const;
 
+    /**
+      * Returns the full width hash of a tuple, the sum of the hashes of the
+      * canonical representations of its values.
+      */
+    XMLSize_t computeHashVal(const FieldValueMap* const valueMap) const;
+
 
     MemoryManager* fMemoryManager;
 };
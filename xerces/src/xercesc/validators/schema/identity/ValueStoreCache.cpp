@@ -69,7 +69,8 @@ ValueStoreCache::~ValueStoreCache()
 void ValueStoreCache::startDocument() {
 
     fIC2ValueStoreMap->removeAll();
-    fGlobalICMap->removeAll();
+    if (fGlobalICMap)
+        fGlobalICMap->removeAll();
     fValueStores->removeAllElements();
     fGlobalMapStack->removeAllElements();
 }
@@ -77,12 +78,7 @@ void ValueStoreCache::startDocument() {
 void ValueStoreCache::startElement() {
 
     fGlobalMapStack->push(fGlobalICMap);
-    fGlobalICMap = new (fMemoryManager) RefHashTableOf<ValueStore, PtrHasher>
-    (
-        13
-        , false
-        , fMemoryManager
-    );
+    fGlobalICMap = 0;
 }
 
 void ValueStoreCache::endElement() {
@@ -92,6 +88,17 @@ void ValueStoreCache::endElement() {
     }
 
     RefHashTableOf<ValueStore, PtrHasher>* oldMap = fGlobalMapStack->pop();
+
+    // nothing to merge if either side has no constraint in scope
+    if (!oldMap) {
+        return;
+    }
+
+    if (!fGlobalICMap) {
+        fGlobalICMap = oldMap;
+        return;
+    }
+
     RefHashTableOfEnumerator<ValueStore, PtrHasher> mapEnum(oldMap, false, fMemoryManager);
 //    Janitor<RefHashTableOf<ValueStore> > janMap(oldMap);
 
@@ -168,6 +175,16 @@ void ValueStoreCache::transplant(IdentityConstraint* const ic, const int initial
     }
 
     ValueStore* newVals = fIC2ValueStoreMap->get(ic, initialDepth);
+
+    if (!fGlobalICMap) {
+        fGlobalICMap = new (fMemoryManager) RefHashTableOf<ValueStore, PtrHasher>
+        (
+            13
+            , false
+            , fMemoryManager
+        );
+    }
+
     ValueStore* currVals = fGlobalICMap->get(ic);
 
     if (currVals) {
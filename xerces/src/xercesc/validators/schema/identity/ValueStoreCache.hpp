@@ -34,7 +34,9 @@
   *  - Validation always occurs against the fGlobalIDConstraintMap (which
   *    comprises all the "eligible" id constraints). When an endelement is
   *    found, this Hashtable is merged with the one below in the stack. When a
-  *    start tag is encountered, we create a new fGlobalICMap.
+  *    start tag is encountered, we start a new fGlobalICMap; it is created
+  *    when the first constraint below the element goes out of scope, so
+  *    most elements neither allocate nor merge a table.
   *    i.e., the top of the fGlobalIDMapStack always contains the preceding
   *    siblings' eligible id constraints; the fGlobalICMap contains
   *    descendants+self. Keyrefs can only match descendants+self.
@@ -154,7 +156,7 @@ ValueStoreCache::getValueStoreFor(const IdentityConstraint* const ic, const int
 inline ValueStore*
 ValueStoreCache::getGlobalValueStoreFor(const IdentityConstraint* const ic) {
 
-    return fGlobalICMap->get(ic);
+    return fGlobalICMap ? fGlobalICMap->get(ic) : 0;
 }
 
 // ---------------------------------------------------------------------------
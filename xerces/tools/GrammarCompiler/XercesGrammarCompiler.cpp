@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+// ---------------------------------------------------------------------------
+//  xerces-grammar-compiler <symbol> <header> <source> <schema>...
+//
+//  Loads the schemas into a grammar pool, serializes the pool and writes it
+//  as a byte array to a C++ source file, together with a header declaring
+//
+//      extern const XMLByte   <symbol>[];
+//      extern const XMLSize_t <symbol>Size;
+//
+//  The application loads the grammars with
+//  XMLGrammarPoolImpl::loadSerializedGrammars(<symbol>, <symbol>Size).
+//  Used by xerces_add_grammar_blob() in cmake/XercesGrammarBlob.cmake.
+// ---------------------------------------------------------------------------
+
+#include <xercesc/framework/XMLGrammarPoolImpl.hpp>
+#include <xercesc/internal/BinMemOutputStream.hpp>
+#include <xercesc/sax/HandlerBase.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include <cstdio>
+
+XERCES_CPP_NAMESPACE_USE
+
+// ---------------------------------------------------------------------------
+//  Local helpers
+// ---------------------------------------------------------------------------
+static void printMessage(const char* const kind, const XMLCh* const msg)
+{
+    char* text = XMLString::transcode(msg);
+    fprintf(stderr, "xerces-grammar-compiler: %s: %s\n", kind, text);
+    XMLString::release(&text);
+}
+
+class CompilerErrorHandler : public HandlerBase
+{
+public:
+    void warning(const SAXParseException& exc)
+    {
+        report("warning", exc);
+    }
+
+    void error(const SAXParseException& exc)
+    {
+        report("error", exc);
+    }
+
+    void fatalError(const SAXParseException& exc)
+    {
+        report("fatal error", exc);
+    }
+
+private:
+    void report(const char* const kind, const SAXParseException& exc)
+    {
+        char* systemId = XMLString::transcode(exc.getSystemId());
+        char* text = XMLString::transcode(exc.getMessage());
+        fprintf(stderr, "%s:%llu:%llu: %s: %s\n", systemId ? systemId : "",
+                (unsigned long long) exc.getLineNumber(),
+                (unsigned long long) exc.getColumnNumber(), kind, text);
+        XMLString::release(&systemId);
+        XMLString::release(&text);
+    }
+};
+
+static bool writeHeader(const char* const path, const char* const symbol)
+{
+    FILE* out = fopen(path, "w");
+    if (!out)
+        return false;
+
+    fprintf(out,
+        "// Generated by xerces-grammar-compiler, do not edit.\n"
+        "#ifndef XERCES_GRAMMAR_BLOB_%s\n"
+        "#define XERCES_GRAMMAR_BLOB_%s\n"
+        "\n"
+        "#include <xercesc/util/XercesDefs.hpp>\n"
+        "\n"
+        "// Serialized grammars, load them with\n"
+        "// XMLGrammarPoolImpl::loadSerializedGrammars(%s, %sSize)\n"
+        "extern const XMLByte   %s[];\n"
+        "extern const XMLSize_t %sSize;\n"
+        "\n"
+        "#endif\n",
+        symbol, symbol, symbol, symbol, symbol, symbol);
+
+    return fclose(out) == 0;
+}
+
+static bool writeSource(const char* const path, const char* const header,
+                        const char* const symbol,
+                        const XMLByte* const data, const XMLSize_t size)
+{
+    FILE* out = fopen(path, "w");
+    if (!out)
+        return false;
+
+    fprintf(out,
+        "// Generated by xerces-grammar-compiler, do not edit.\n"
+        "#include \"%s\"\n"
+        "\n"
+        "extern const XMLSize_t %sSize = %llu;\n"
+        "\n"
+        "extern const XMLByte %s[] =\n"
+        "{",
+        header, symbol, (unsigned long long) size, symbol);
+
+    for (XMLSize_t i = 0; i < size; i++)
+        fprintf(out, "%s0x%02x,", (i % 16) ? " " : "\n  ", (unsigned int) data[i]);
+
+    fprintf(out, "\n};\n");
+
+    return fclose(out) == 0;
+}
+
+// ---------------------------------------------------------------------------
+//  Program entry point
+// ---------------------------------------------------------------------------
+int main(int argC, char* argV[])
+{
+    if (argC < 5)
+    {
+        fprintf(stderr, "usage: xerces-grammar-compiler <symbol> <header> <source> <schema>...\n");
+        return 2;
+    }
+
+    const char* const symbol = argV[1];
+    const char* const header = argV[2];
+    const char* const source = argV[3];
+
+    // the header is included by its file name, both are generated into the
+    // same directory
+    const char* headerName = header;
+    for (const char* p = header; *p; p++)
+    {
+        if (*p == '/' || *p == '\\')
+            headerName = p + 1;
+    }
+
+    try
+    {
+        XMLPlatformUtils::Initialize();
+    }
+    catch (const XMLException& toCatch)
+    {
+        printMessage("initialization failed", toCatch.getMessage());
+        return 1;
+    }
+
+    int retval = 0;
+    {
+        XMLGrammarPoolImpl pool;
+        CompilerErrorHandler errorHandler;
+
+        try
+        {
+            for (int i = 4; i < argC && !retval; i++)
+            {
+                XMLCh* systemId = XMLString::transcode(argV[i]);
+                Grammar* grammar = pool.loadGrammar(systemId, Grammar::SchemaGrammarType, &errorHandler);
+                XMLString::release(&systemId);
+
+                if (!grammar)
+                {
+                    fprintf(stderr, "xerces-grammar-compiler: cannot load %s\n", argV[i]);
+                    retval = 1;
+                }
+            }
+
+            if (!retval)
+            {
+                // the pool is serialized unlocked, the application decides
+                // whether to lock it after loading
+                BinMemOutputStream binOut;
+                pool.serializeGrammars(&binOut);
+
+                if (!writeHeader(header, symbol))
+                {
+                    fprintf(stderr, "xerces-grammar-compiler: cannot write %s\n", header);
+                    retval = 1;
+                }
+                else if (!writeSource(source, headerName, symbol, binOut.getRawBuffer(), (XMLSize_t) binOut.getSize()))
+                {
+                    fprintf(stderr, "xerces-grammar-compiler: cannot write %s\n", source);
+                    retval = 1;
+                }
+            }
+        }
+        catch (const XMLException& toCatch)
+        {
+            printMessage("error", toCatch.getMessage());
+            retval = 1;
+        }
+        catch (const SAXParseException& toCatch)
+        {
+            printMessage("error", toCatch.getMessage());
+            retval = 1;
+        }
+    }
+
+    XMLPlatformUtils::Terminate();
+    return retval;
+}
@@ -0,0 +1,391 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+// ---------------------------------------------------------------------------
+//  xerces-parser-benchmark [--time <seconds>] [file...]
+//
+//  Parses a generated document of the shape of an FMI modelDescription.xml
+//  and the files given on the command line with SAX2 and DOM, once with the
+//  default configuration (IGXMLScanner) and once with the fast trusted
+//  profile (WFXMLScanner), with and without namespace processing. Reports
+//  the throughput in MB/s of input (best of the runs) and the number of
+//  allocations and allocated bytes per parse. The SAX2 runs also print a
+//  hash of the reported events, which is the same for all configurations
+//  as long as the document does not depend on its DTD.
+// ---------------------------------------------------------------------------
+
+#include <xercesc/framework/MemBufInputSource.hpp>
+#include <xercesc/framework/MemoryManager.hpp>
+#include <xercesc/parsers/XercesDOMParser.hpp>
+#include <xercesc/sax2/Attributes.hpp>
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/util/OutOfMemoryException.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+XERCES_CPP_NAMESPACE_USE
+
+// ---------------------------------------------------------------------------
+//  Local helpers
+// ---------------------------------------------------------------------------
+class CountingMemoryManager : public MemoryManager
+{
+public:
+    CountingMemoryManager() : fCount(0), fBytes(0) {}
+
+    MemoryManager* getExceptionMemoryManager()
+    {
+        return this;
+    }
+
+    void* allocate(XMLSize_t size)
+    {
+        void* p = malloc(size);
+        if (!p)
+            throw OutOfMemoryException();
+
+        fCount++;
+        fBytes += size;
+        return p;
+    }
+
+    void deallocate(void* p)
+    {
+        free(p);
+    }
+
+    void reset()
+    {
+        fCount = 0;
+        fBytes = 0;
+    }
+
+    XMLSize_t fCount;
+    XMLSize_t fBytes;
+};
+
+class HashingHandler : public DefaultHandler
+{
+public:
+    HashingHandler() : fHash(0) {}
+
+    void startElement(const XMLCh* const uri, const XMLCh* const localname,
+                      const XMLCh* const qname, const Attributes& attrs)
+    {
+        mix(uri);
+        mix(localname);
+        mix(qname);
+        for (XMLSize_t i = 0; i < attrs.getLength(); i++)
+        {
+            mix(attrs.getQName(i));
+            mix(attrs.getValue(i));
+        }
+    }
+
+    void endElement(const XMLCh* const, const XMLCh* const, const XMLCh* const qname)
+    {
+        mix(qname);
+    }
+
+    void characters(const XMLCh* const chars, const XMLSize_t length)
+    {
+        for (XMLSize_t i = 0; i < length; i++)
+            fHash = fHash * 31 + chars[i];
+    }
+
+    void fatalError(const SAXParseException& exc)
+    {
+        throw exc;
+    }
+
+    unsigned long long fHash;
+
+private:
+    void mix(const XMLCh* s)
+    {
+        if (s)
+        {
+            while (*s)
+                fHash = fHash * 31 + *s++;
+        }
+        fHash = fHash * 31 + 1;
+    }
+};
+
+struct Document
+{
+    std::string name;
+    std::string contents;
+};
+
+static Document generateModelDescription(const unsigned int variables)
+{
+    Document doc;
+    doc.name = "generated modelDescription.xml";
+
+    std::string& s = doc.contents;
+    s += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         "<fmiModelDescription xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+         " fmiVersion=\"2.0\" modelName=\"Benchmark\" guid=\"{8c4e810f-3df3-4a00-8276-176fa3c9f000}\""
+         " generationTool=\"xerces-parser-benchmark\" numberOfEventIndicators=\"0\">\n"
+         "  <CoSimulation modelIdentifier=\"Benchmark\" canHandleVariableCommunicationStepSize=\"true\"/>\n"
+         "  <DefaultExperiment startTime=\"0.0\" stopTime=\"10.0\" tolerance=\"1e-06\"/>\n"
+         "  <ModelVariables>\n";
+
+    char buffer[512];
+    for (unsigned int i = 0; i < variables; i++)
+    {
+        snprintf(buffer, sizeof(buffer),
+                 "    <!-- Index %u -->\n"
+                 "    <ScalarVariable name=\"system.component%u.x[%u]\" valueReference=\"%u\""
+                 " description=\"state &amp; derivative %u\" causality=\"%s\" variability=\"continuous\">\n"
+                 "      <Real start=\"%u.25\" unit=\"m/s\"/>\n"
+                 "    </ScalarVariable>\n",
+                 i + 1, i / 10, i % 10, i, i, (i % 3) ? "local" : "output", i);
+        s += buffer;
+    }
+
+    s += "  </ModelVariables>\n"
+         "  <ModelStructure>\n"
+         "    <Outputs>\n";
+    for (unsigned int i = 0; i < variables; i += 3)
+    {
+        snprintf(buffer, sizeof(buffer), "      <Unknown index=\"%u\" dependencies=\"%u %u\"/>\n",
+                 i + 1, i + 2, i + 3);
+        s += buffer;
+    }
+    s += "    </Outputs>\n"
+         "  </ModelStructure>\n"
+         "</fmiModelDescription>\n";
+
+    return doc;
+}
+
+static bool readFile(const char* const path, Document& doc)
+{
+    FILE* in = fopen(path, "rb");
+    if (!in)
+        return false;
+
+    doc.name = path;
+    doc.contents.clear();
+
+    char buffer[65536];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        doc.contents.append(buffer, read);
+
+    fclose(in);
+    return true;
+}
+
+enum Profile
+{
+    Profile_Default
+    , Profile_Fast
+    , Profile_FastNoNamespaces
+};
+
+static const char* const gProfileNames[] =
+{
+    "default"
+    , "fast"
+    , "fast, no namespaces"
+};
+
+struct Measurement
+{
+    double seconds;
+    XMLSize_t allocations;
+    XMLSize_t bytes;
+    unsigned long long hash;
+};
+
+// Parses the document repeatedly for at least the given time and keeps the
+// best run. The parser is created once, as an application reusing it would.
+static Measurement measureSAX2(const Document& doc, const Profile profile, const double minTime)
+{
+    CountingMemoryManager memMgr;
+    HashingHandler handler;
+    SAX2XMLReader* reader = XMLReaderFactory::createXMLReader(&memMgr);
+    reader->setFeature(XMLUni::fgSAX2CoreNameSpaces, true);
+    if (profile != Profile_Default)
+        reader->useFastTrustedProfile(profile == Profile_Fast);
+    reader->setContentHandler(&handler);
+    reader->setErrorHandler(&handler);
+
+    Measurement result = { 1e30, 0, 0, 0 };
+    double total = 0;
+    for (unsigned int runs = 0; total < minTime || runs < 3; runs++)
+    {
+        MemBufInputSource source((const XMLByte*) doc.contents.data(), doc.contents.size(),
+                                 "benchmark", false, &memMgr);
+        source.setCopyBufToStream(false);
+        handler.fHash = 0;
+        memMgr.reset();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        reader->parse(source);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        total += seconds;
+        if (seconds < result.seconds)
+            result.seconds = seconds;
+        result.allocations = memMgr.fCount;
+        result.bytes = memMgr.fBytes;
+        result.hash = handler.fHash;
+    }
+
+    delete reader;
+    return result;
+}
+
+static Measurement measureDOM(const Document& doc, const Profile profile, const double minTime)
+{
+    CountingMemoryManager memMgr;
+    HashingHandler handler;
+    XercesDOMParser* parser = new XercesDOMParser(0, &memMgr);
+    parser->setDoNamespaces(true);
+    if (profile != Profile_Default)
+        parser->useFastTrustedProfile(profile == Profile_Fast);
+    parser->setErrorHandler(&handler);
+
+    Measurement result = { 1e30, 0, 0, 0 };
+    double total = 0;
+    for (unsigned int runs = 0; total < minTime || runs < 3; runs++)
+    {
+        MemBufInputSource source((const XMLByte*) doc.contents.data(), doc.contents.size(),
+                                 "benchmark", false, &memMgr);
+        source.setCopyBufToStream(false);
+        memMgr.reset();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        parser->parse(source);
+        // the document is part of the work, its release is not
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.allocations = memMgr.fCount;
+        result.bytes = memMgr.fBytes;
+        parser->resetDocumentPool();
+
+        total += seconds;
+        if (seconds < result.seconds)
+            result.seconds = seconds;
+    }
+
+    delete parser;
+    return result;
+}
+
+static void report(const Document& doc, const char* const api, const Profile profile,
+                   const Measurement& m, const bool withHash)
+{
+    printf("  %-4s %-20s %9.1f MB/s %10llu allocs %12llu bytes",
+           api, gProfileNames[profile], doc.contents.size() / m.seconds / 1e6,
+           (unsigned long long) m.allocations, (unsigned long long) m.bytes);
+    if (withHash)
+        printf("  hash %016llx", m.hash);
+    printf("\n");
+}
+
+// ---------------------------------------------------------------------------
+//  Program entry point
+// ---------------------------------------------------------------------------
+int main(int argC, char* argV[])
+{
+    double minTime = 0.5;
+    std::vector<Document> corpus;
+    corpus.push_back(generateModelDescription(20000));
+
+    for (int i = 1; i < argC; i++)
+    {
+        if (strcmp(argV[i], "--time") == 0 && i + 1 < argC)
+        {
+            minTime = atof(argV[++i]);
+        }
+        else
+        {
+            Document doc;
+            if (!readFile(argV[i], doc))
+            {
+                fprintf(stderr, "xerces-parser-benchmark: cannot read %s\n", argV[i]);
+                return 2;
+            }
+            corpus.push_back(doc);
+        }
+    }
+
+    try
+    {
+        XMLPlatformUtils::Initialize();
+    }
+    catch (const XMLException& toCatch)
+    {
+        char* text = XMLString::transcode(toCatch.getMessage());
+        fprintf(stderr, "xerces-parser-benchmark: initialization failed: %s\n", text);
+        XMLString::release(&text);
+        return 1;
+    }
+
+    int retval = 0;
+    for (size_t d = 0; d < corpus.size(); d++)
+    {
+        const Document& doc = corpus[d];
+        printf("%s (%llu bytes)\n", doc.name.c_str(), (unsigned long long) doc.contents.size());
+
+        try
+        {
+            for (int p = Profile_Default; p <= Profile_FastNoNamespaces; p++)
+                report(doc, "SAX2", (Profile) p, measureSAX2(doc, (Profile) p, minTime), true);
+            for (int p = Profile_Default; p <= Profile_FastNoNamespaces; p++)
+                report(doc, "DOM", (Profile) p, measureDOM(doc, (Profile) p, minTime), false);
+        }
+        catch (const XMLException& toCatch)
+        {
+            char* text = XMLString::transcode(toCatch.getMessage());
+            fprintf(stderr, "xerces-parser-benchmark: %s: %s\n", doc.name.c_str(), text);
+            XMLString::release(&text);
+            retval = 1;
+        }
+        catch (const SAXParseException& toCatch)
+        {
+            char* text = XMLString::transcode(toCatch.getMessage());
+            fprintf(stderr, "xerces-parser-benchmark: %s:%llu:%llu: %s\n", doc.name.c_str(),
+                    (unsigned long long) toCatch.getLineNumber(),
+                    (unsigned long long) toCatch.getColumnNumber(), text);
+            XMLString::release(&text);
+            retval = 1;
+        }
+    }
+
+    XMLPlatformUtils::Terminate();
+    return retval;
+}
@@ -0,0 +1,215 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+// ---------------------------------------------------------------------------
+//  xerces-string-benchmark [--time <seconds>]
+//
+//  Measures XMLString::stringLen, equals, compareString and hash on strings
+//  of typical name, URI and text lengths, once with the scalar loops and
+//  once with the SSE2 implementations, by switching XMLPlatformUtils::fgSSE2ok.
+//  Reports the best time per call in nanoseconds. The strings start at
+//  varying offsets so that every alignment is measured.
+// ---------------------------------------------------------------------------
+
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+XERCES_CPP_NAMESPACE_USE
+
+// ---------------------------------------------------------------------------
+//  Local helpers
+// ---------------------------------------------------------------------------
+static const unsigned int gStringCount = 1024;
+
+struct Strings
+{
+    std::vector<XMLCh> storage1;
+    std::vector<XMLCh> storage2;
+    std::vector<const XMLCh*> str1;
+    std::vector<const XMLCh*> str2;
+};
+
+//  Pairs of equal strings of the given length, the second one of each pair
+//  differs in its last char when different is set
+static void makeStrings(Strings& strings, const XMLSize_t length, const bool different)
+{
+    const XMLSize_t stride = length + 16;
+    strings.storage1.assign(gStringCount * stride, 0);
+    strings.storage2.assign(gStringCount * stride, 0);
+    strings.str1.resize(gStringCount);
+    strings.str2.resize(gStringCount);
+
+    for (unsigned int i = 0; i < gStringCount; i++)
+    {
+        XMLCh* s1 = &strings.storage1[i * stride + i % 8];
+        XMLCh* s2 = &strings.storage2[i * stride + (i * 3) % 8];
+        for (XMLSize_t k = 0; k < length; k++)
+            s1[k] = s2[k] = (XMLCh) ('a' + (i + k) % 26);
+        if (different && length)
+            s2[length - 1] = (XMLCh) '_';
+
+        strings.str1[i] = s1;
+        strings.str2[i] = s2;
+    }
+}
+
+enum Operation
+{
+    Op_StringLen
+    , Op_Equals
+    , Op_NotEquals
+    , Op_CompareString
+    , Op_Hash
+    , Op_Count
+};
+
+static const char* const gOperationNames[Op_Count] =
+{
+    "stringLen"
+    , "equals"
+    , "equals (differ)"
+    , "compareString"
+    , "hash"
+};
+
+static XMLSize_t runOnce(const Operation op, const Strings& strings)
+{
+    XMLSize_t sum = 0;
+    for (unsigned int i = 0; i < gStringCount; i++)
+    {
+        switch (op)
+        {
+        case Op_StringLen:
+            sum += XMLString::stringLen(strings.str1[i]);
+            break;
+        case Op_Equals:
+        case Op_NotEquals:
+            sum += XMLString::equals(strings.str1[i], strings.str2[i]);
+            break;
+        case Op_CompareString:
+            sum += (XMLSize_t) XMLString::compareString(strings.str1[i], strings.str2[i]);
+            break;
+        default:
+            sum += XMLString::hash(strings.str1[i], 109);
+            break;
+        }
+    }
+    return sum;
+}
+
+// Best time of one call, in nanoseconds, over runs of at least minTime
+static double measure(const Operation op, const Strings& strings, const double minTime, XMLSize_t& sink)
+{
+    double best = 1e30;
+    double total = 0;
+    unsigned int batches = 1;
+    for (unsigned int runs = 0; total < minTime || runs < 3; runs++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned int b = 0; b < batches; b++)
+            sink += runOnce(op, strings);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        total += seconds;
+        const double perCall = seconds * 1e9 / ((double) batches * gStringCount);
+        if (perCall < best)
+            best = perCall;
+
+        // aim for runs of about a millisecond
+        if (seconds < 1e-3 && batches < (1U << 20))
+            batches *= 2;
+    }
+    return best;
+}
+
+// ---------------------------------------------------------------------------
+//  Program entry point
+// ---------------------------------------------------------------------------
+int main(int argC, char* argV[])
+{
+    double minTime = 0.1;
+    for (int i = 1; i < argC; i++)
+    {
+        if (strcmp(argV[i], "--time") == 0 && i + 1 < argC)
+        {
+            minTime = atof(argV[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: xerces-string-benchmark [--time <seconds>]\n");
+            return 2;
+        }
+    }
+
+    try
+    {
+        XMLPlatformUtils::Initialize();
+    }
+    catch (const XMLException& toCatch)
+    {
+        char* text = XMLString::transcode(toCatch.getMessage());
+        fprintf(stderr, "xerces-string-benchmark: initialization failed: %s\n", text);
+        XMLString::release(&text);
+        return 1;
+    }
+
+    const bool haveSSE2 = XMLPlatformUtils::fgSSE2ok;
+    if (!haveSSE2)
+        printf("SSE2 is not available, only the scalar loops are measured\n");
+
+    static const XMLSize_t lengths[] = { 4, 8, 16, 32, 64, 256, 4096 };
+    printf("%-16s %6s %12s %12s\n", "ns per call", "length", "scalar", "sse2");
+
+    XMLSize_t sink = 0;
+    Strings strings;
+    for (int op = Op_StringLen; op < Op_Count; op++)
+    {
+        for (unsigned int l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        {
+            makeStrings(strings, lengths[l], op == Op_NotEquals);
+
+            XMLPlatformUtils::fgSSE2ok = false;
+            const double scalar = measure((Operation) op, strings, minTime, sink);
+            printf("%-16s %6llu %12.2f", gOperationNames[op], (unsigned long long) lengths[l], scalar);
+
+            if (haveSSE2)
+            {
+                XMLPlatformUtils::fgSSE2ok = true;
+                printf(" %12.2f", measure((Operation) op, strings, minTime, sink));
+            }
+            printf("\n");
+        }
+    }
+    XMLPlatformUtils::fgSSE2ok = haveSSE2;
+
+    // keeps the calls from being optimized away
+    if (sink == 1)
+        printf("\n");
+
+    XMLPlatformUtils::Terminate();
+    return 0;
+}
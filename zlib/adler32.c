@@ -59,6 +59,134 @@ local uLong adler32_combine_ OF((uLong adler1, uLong adler2, z_off64_t len2));
 #  define MOD63(a) a %= BASE
 #endif
 
+/* =========================================================================
+ * x86 SIMD versions, for the processors which have SSSE3 or AVX2. Over a
+ * block of n bytes, adler grows by their sum and sum2 by n times adler plus
+ * the sum of each byte times n, n-1, ..., 1. The byte sums come from
+ * psadbw and the weighted sums from pmaddubsw. The blocks of a run are at
+ * most NMAX bytes, as for the scalar code, then both sums are reduced.
+ * Return the sums of the whole blocks, leaving the last bytes to the caller.
+ */
+#ifdef X86_SIMD
+
+#include <immintrin.h>
+
+#define SIMD_BLOCK 32
+
+Z_TARGET("ssse3")
+local uLong adler32_ssse3 OF((uLong adler, const Bytef *buf, z_size_t len));
+Z_TARGET("ssse3")
+local uLong adler32_ssse3(adler, buf, len)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+{
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    unsigned long sum2 = (adler >> 16) & 0xffff;
+    z_size_t blocks = len / SIMD_BLOCK;
+
+    adler &= 0xffff;
+    while (blocks) {
+        unsigned n = NMAX / SIMD_BLOCK;
+        __m128i v_ps, v_s1, v_s2;
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        /* v_ps is the sum of the adler values before each block */
+        v_ps = _mm_cvtsi32_si128((int)(adler * n));
+        v_s2 = _mm_cvtsi32_si128((int)sum2);
+        v_s1 = zero;
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                       _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                       _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            buf += SIMD_BLOCK;
+        } while (--n);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        /* add up the four lanes */
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        adler += (unsigned)_mm_cvtsi128_si32(v_s1);
+        sum2 = (unsigned)_mm_cvtsi128_si32(v_s2);
+        MOD(adler);
+        MOD(sum2);
+    }
+    return adler | (sum2 << 16);
+}
+
+Z_TARGET("avx2")
+local uLong adler32_avx2 OF((uLong adler, const Bytef *buf, z_size_t len));
+Z_TARGET("avx2")
+local uLong adler32_avx2(adler, buf, len)
+    uLong adler;
+    const Bytef *buf;
+    z_size_t len;
+{
+    const __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                         24, 23, 22, 21, 20, 19, 18, 17,
+                                         16, 15, 14, 13, 12, 11, 10, 9,
+                                         8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    unsigned long sum2 = (adler >> 16) & 0xffff;
+    z_size_t blocks = len / SIMD_BLOCK;
+
+    adler &= 0xffff;
+    while (blocks) {
+        unsigned n = NMAX / SIMD_BLOCK;
+        __m256i v_ps, v_s1, v_s2;
+        __m128i s1, s2;
+        if (n > blocks)
+            n = (unsigned)blocks;
+        blocks -= n;
+
+        v_ps = _mm256_setr_epi32((int)(adler * n), 0, 0, 0, 0, 0, 0, 0);
+        v_s2 = _mm256_setr_epi32((int)sum2, 0, 0, 0, 0, 0, 0, 0);
+        v_s1 = zero;
+        do {
+            const __m256i bytes = _mm256_loadu_si256((const __m256i *)buf);
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+            v_s2 = _mm256_add_epi32(v_s2,
+                       _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, tap), ones));
+            buf += SIMD_BLOCK;
+        } while (--n);
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+
+        /* add up the eight lanes */
+        s1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                           _mm256_extracti128_si256(v_s1, 1));
+        s2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                           _mm256_extracti128_si256(v_s2, 1));
+        s1 = _mm_add_epi32(s1, _mm_shuffle_epi32(s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        s1 = _mm_add_epi32(s1, _mm_shuffle_epi32(s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = _mm_add_epi32(s2, _mm_shuffle_epi32(s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        s2 = _mm_add_epi32(s2, _mm_shuffle_epi32(s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        adler += (unsigned)_mm_cvtsi128_si32(s1);
+        sum2 = (unsigned)_mm_cvtsi128_si32(s2);
+        MOD(adler);
+        MOD(sum2);
+    }
+    return adler | (sum2 << 16);
+}
+
+#endif /* X86_SIMD */
+
 /* ========================================================================= */
 uLong ZEXPORT adler32_z(adler, buf, len)
     uLong adler;
@@ -99,6 +227,24 @@ uLong ZEXPORT adler32_z(adler, buf, len)
         return adler | (sum2 << 16);
     }
 
+#ifdef X86_SIMD
+    /* do the SIMD_BLOCK blocks, if the processor allows */
+    if (len >= SIMD_BLOCK) {
+        int features = x86_cpu_features();
+        if (features & (Z_X86_AVX2 | Z_X86_SSSE3)) {
+            adler |= sum2 << 16;
+            if (features & Z_X86_AVX2)
+                adler = adler32_avx2(adler, buf, len);
+            else
+                adler = adler32_ssse3(adler, buf, len);
+            sum2 = (adler >> 16) & 0xffff;
+            adler &= 0xffff;
+            buf += len & ~(z_size_t)(SIMD_BLOCK - 1);
+            len &= SIMD_BLOCK - 1;
+        }
+    }
+#endif
+
     /* do length NMAX blocks -- requires just one modulo operation */
     while (len >= NMAX) {
         len -= NMAX;
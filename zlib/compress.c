@@ -59,7 +59,7 @@ int ZEXPORT compress2(dest, destLen, source, sourceLen, level)
     } while (err == Z_OK);
 
     *destLen = stream.total_out;
-    deflateEnd(&stream);
+    deflateRelease(&stream);
     return err == Z_STREAM_END ? Z_OK : err;
 }
 
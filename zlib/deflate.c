@@ -83,6 +83,7 @@ local block_state deflate_slow   OF((deflate_state *s, int flush));
 #endif
 local block_state deflate_rle    OF((deflate_state *s, int flush));
 local block_state deflate_huff   OF((deflate_state *s, int flush));
+local block_state deflate_quick  OF((deflate_state *s, int flush));
 local void lm_init        OF((deflate_state *s));
 local void putShortMSB    OF((deflate_state *s, uInt b));
 local void flush_pending  OF((z_streamp strm));
@@ -195,6 +196,28 @@ local const config configuration_table[10] = {
  * bit values at the expense of memory usage). We slide even when level == 0 to
  * keep the hash table consistent if we switch back to level > 0 later.
  */
+#if defined(X86_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define SLIDE_SSE2
+#  include <emmintrin.h>
+
+/* The subtraction saturates at zero, which is NIL. n is a multiple of 8. */
+local void slide_hash_sse2 OF((Posf *p, unsigned n, uInt wsize));
+local void slide_hash_sse2(p, n, wsize)
+    Posf *p;
+    unsigned n;
+    uInt wsize;
+{
+    const __m128i w = _mm_set1_epi16((short)wsize);
+    do {
+        _mm_storeu_si128((__m128i *)p,
+                         _mm_subs_epu16(_mm_loadu_si128((__m128i *)p), w));
+        p += 8;
+        n -= 8;
+    } while (n);
+}
+#endif
+
 local void slide_hash(s)
     deflate_state *s;
 {
@@ -202,6 +225,16 @@ local void slide_hash(s)
     Posf *p;
     uInt wsize = s->w_size;
 
+#ifdef SLIDE_SSE2
+    if (sizeof(Pos) == 2 && wsize <= 0xffff && (s->hash_size & 7) == 0 &&
+        (wsize & 7) == 0) {
+        slide_hash_sse2(s->head, s->hash_size, wsize);
+#ifndef FASTEST
+        slide_hash_sse2(s->prev, wsize, wsize);
+#endif
+        return;
+    }
+#endif
     n = s->hash_size;
     p = &s->head[n];
     do {
@@ -291,10 +324,27 @@ int ZEXPORT deflateInit2_(strm, level, method, windowBits, memLevel, strategy,
 #endif
     if (memLevel < 1 || memLevel > MAX_MEM_LEVEL || method != Z_DEFLATED ||
         windowBits < 8 || windowBits > 15 || level < 0 || level > 9 ||
-        strategy < 0 || strategy > Z_FIXED || (windowBits == 8 && wrap != 1)) {
+        strategy < 0 || strategy > Z_QUICK || (windowBits == 8 && wrap != 1)) {
         return Z_STREAM_ERROR;
     }
     if (windowBits == 8) windowBits = 9;  /* until 256-byte window bug fixed */
+#ifdef ZPOOL
+    /* reuse the buffers of a released state with the same sizes */
+    if (strm->zalloc == zcalloc && strm->zfree == zcfree &&
+        (s = (deflate_state *)zpool_take(ZPOOL_DEFLATE(windowBits, memLevel)))
+            != Z_NULL) {
+        strm->state = (struct internal_state FAR *)s;
+        s->strm = strm;
+        s->status = INIT_STATE;
+        s->wrap = wrap;
+        s->gzhead = Z_NULL;
+        s->high_water = 0;
+        s->level = level;
+        s->strategy = strategy;
+        s->method = (Byte)method;
+        return deflateReset(strm);
+    }
+#endif
     s = (deflate_state *) ZALLOC(strm, 1, sizeof(deflate_state));
     if (s == Z_NULL) return Z_MEM_ERROR;
     strm->state = (struct internal_state FAR *)s;
@@ -618,7 +668,7 @@ int ZEXPORT deflateParams(strm, level, strategy)
 #else
     if (level == Z_DEFAULT_COMPRESSION) level = 6;
 #endif
-    if (level < 0 || level > 9 || strategy < 0 || strategy > Z_FIXED) {
+    if (level < 0 || level > 9 || strategy < 0 || strategy > Z_QUICK) {
         return Z_STREAM_ERROR;
     }
     func = configuration_table[s->level].func;
@@ -1054,6 +1104,7 @@ int ZEXPORT deflate(strm, flush)
         bstate = s->level == 0 ? deflate_stored(s, flush) :
                  s->strategy == Z_HUFFMAN_ONLY ? deflate_huff(s, flush) :
                  s->strategy == Z_RLE ? deflate_rle(s, flush) :
+                 s->strategy == Z_QUICK ? deflate_quick(s, flush) :
                  (*(configuration_table[s->level].func))(s, flush);
 
         if (bstate == finish_started || bstate == finish_done) {
@@ -1148,6 +1199,42 @@ int ZEXPORT deflateEnd(strm)
     return status == BUSY_STATE ? Z_DATA_ERROR : Z_OK;
 }
 
+#ifdef ZPOOL
+/* Free a pooled state that was allocated with zcalloc(). */
+local void deflate_pool_free(state)
+    voidpf state;
+{
+    deflate_state *s = (deflate_state *)state;
+
+    zcfree(Z_NULL, s->pending_buf);
+    zcfree(Z_NULL, s->head);
+    zcfree(Z_NULL, s->prev);
+    zcfree(Z_NULL, s->window);
+    zcfree(Z_NULL, s);
+}
+#endif
+
+/* ========================================================================= */
+int ZEXPORT deflateRelease(strm)
+    z_streamp strm;
+{
+#ifdef ZPOOL
+    deflate_state *s;
+    int status;
+
+    if (deflateStateCheck(strm)) return Z_STREAM_ERROR;
+    s = strm->state;
+    status = s->status;
+    if (strm->zalloc == zcalloc && strm->zfree == zcfree &&
+        zpool_put(ZPOOL_DEFLATE(s->w_bits, s->hash_bits - 7), s,
+                  deflate_pool_free) == 0) {
+        strm->state = Z_NULL;
+        return status == BUSY_STATE ? Z_DATA_ERROR : Z_OK;
+    }
+#endif
+    return deflateEnd(strm);
+}
+
 /* =========================================================================
  * Copy the source state to the destination state.
  * To simplify the source, this is not supported for 16-bit MSDOS (which
@@ -1266,6 +1353,38 @@ local void lm_init(s)
 }
 
 #ifndef FASTEST
+/* ===========================================================================
+ * Compare the bytes past the first two of a match eight at a time on 64-bit
+ * little-endian processors: the first differing byte is found from the
+ * trailing zero bits of the xor of the two words. Define NO_WORD_MATCH to use
+ * the byte loop.
+ */
+#if !defined(UNALIGNED_OK) && !defined(NO_WORD_MATCH) && MAX_MATCH == 258 && \
+    (defined(__x86_64__) || defined(_M_X64) || \
+     (defined(__aarch64__) && !defined(__AARCH64EB__)) || defined(_M_ARM64)) && \
+    (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#  define WORD_MATCH
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    pragma intrinsic(_BitScanForward64)
+#  endif
+
+typedef unsigned long long z_word_match;
+
+local unsigned first_diff OF((z_word_match diff));
+local unsigned first_diff(diff)
+    z_word_match diff;
+{
+#  ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanForward64(&bit, diff);
+    return (unsigned)bit >> 3;
+#  else
+    return (unsigned)__builtin_ctzll(diff) >> 3;
+#  endif
+}
+#endif
+
 /* ===========================================================================
  * Set match_start to the longest match starting at the given string and
  * return its length. Matches shorter or equal to prev_length are discarded,
@@ -1385,6 +1504,21 @@ local uInt longest_match(s, cur_match)
         scan += 2, match++;
         Assert(*scan == *match, "match[2]?");
 
+#ifdef WORD_MATCH
+        /* The 256 bytes from strstart + 2 to strstart + 258 are 32 words,
+         * the last one ends at strend.
+         */
+        do {
+            z_word_match scan_word, match_word;
+            zmemcpy((Bytef *)&scan_word, scan, 8);
+            zmemcpy((Bytef *)&match_word, match, 8);
+            if (scan_word != match_word) {
+                scan += first_diff(scan_word ^ match_word);
+                break;
+            }
+            scan += 8, match += 8;
+        } while (scan < strend);
+#else
         /* We check for insufficient lookahead only every 8th comparison;
          * the 256th check will be made at strstart + 258.
          */
@@ -1394,6 +1528,7 @@ local uInt longest_match(s, cur_match)
                  *++scan == *++match && *++scan == *++match &&
                  *++scan == *++match && *++scan == *++match &&
                  scan < strend);
+#endif
 
         Assert(scan <= s->window + (unsigned)(s->window_size - 1),
                "wild scan");
@@ -2215,3 +2350,91 @@ local block_state deflate_huff(s, flush)
         FLUSH_BLOCK(s, 0);
     return block_done;
 }
+
+/* ===========================================================================
+ * For Z_QUICK, as deflate_fast() but faster, after the deflate_quick() of
+ * Intel's zlib: the string at strstart is compared only to the most recent
+ * one with the same hash, without following the hash chain, and the strings
+ * within a match are not inserted. The blocks are sent with the fixed codes,
+ * or stored, so _tr_flush_block() does not build the dynamic trees.
+ */
+local block_state deflate_quick(s, flush)
+    deflate_state *s;
+    int flush;
+{
+    IPos hash_head;         /* head of the hash chain */
+    int bflush;             /* set if current block must be flushed */
+    Bytef *scan, *match;    /* strings compared */
+    Bytef *strend;          /* end of the longest possible match */
+    uInt match_len;         /* length of the match */
+
+    for (;;) {
+        /* Make sure that we always have enough lookahead, except
+         * at the end of the input file. We need MAX_MATCH bytes
+         * for the next match, plus MIN_MATCH bytes to insert the
+         * string following the next match.
+         */
+        if (s->lookahead < MIN_LOOKAHEAD) {
+            fill_window(s);
+            if (s->lookahead < MIN_LOOKAHEAD && flush == Z_NO_FLUSH) {
+                return need_more;
+            }
+            if (s->lookahead == 0) break; /* flush the current block */
+        }
+
+        /* Insert the string window[strstart .. strstart + 2] in the
+         * dictionary, and compare it with the previous one there.
+         */
+        hash_head = NIL;
+        if (s->lookahead >= MIN_MATCH) {
+            INSERT_STRING(s, s->strstart, hash_head);
+        }
+        match_len = 0;
+        if (hash_head != NIL && s->strstart - hash_head <= MAX_DIST(s)) {
+            scan = s->window + s->strstart;
+            match = s->window + hash_head;
+            if (scan[0] == match[0] && scan[1] == match[1] &&
+                scan[2] == match[2]) {
+                strend = scan + (s->lookahead < MAX_MATCH ? s->lookahead :
+                                 MAX_MATCH);
+                scan += MIN_MATCH;
+                match += MIN_MATCH;
+                while (scan < strend && *scan == *match) {
+                    scan++;
+                    match++;
+                }
+                match_len = (uInt)(scan - (s->window + s->strstart));
+            }
+        }
+
+        if (match_len >= MIN_MATCH) {
+            check_match(s, s->strstart, hash_head, match_len);
+
+            _tr_tally_dist(s, s->strstart - hash_head, match_len - MIN_MATCH,
+                           bflush);
+
+            s->lookahead -= match_len;
+            s->strstart += match_len;
+            s->ins_h = s->window[s->strstart];
+            UPDATE_HASH(s, s->ins_h, s->window[s->strstart + 1]);
+#if MIN_MATCH != 3
+            Call UPDATE_HASH() MIN_MATCH-3 more times
+#endif
+        } else {
+            /* No match, output a literal byte */
+            Tracevv((stderr,"%c", s->window[s->strstart]));
+            _tr_tally_lit(s, s->window[s->strstart], bflush);
+            s->lookahead--;
+            s->strstart++;
+        }
+        if (bflush) FLUSH_BLOCK(s, 0);
+    }
+    s->insert = s->strstart < MIN_MATCH-1 ? s->strstart : MIN_MATCH-1;
+    if (flush == Z_FINISH) {
+        FLUSH_BLOCK(s, 1);
+        return finish_done;
+    }
+    if (s->sym_next)
+        FLUSH_BLOCK(s, 0);
+    return block_done;
+}
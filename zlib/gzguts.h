@@ -144,6 +144,17 @@
     ZEXTERN z_off64_t ZEXPORT gzoffset64 OF((gzFile));
 #endif
 
+/* 64-bit lseek() where available */
+#if defined(_WIN32) && !defined(__BORLANDC__)
+#  define LSEEK _lseeki64
+#else
+#if defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
+#  define LSEEK lseek64
+#else
+#  define LSEEK lseek
+#endif
+#endif
+
 /* default memLevel */
 #if MAX_MEM_LEVEL >= 8
 #  define DEF_MEM_LEVEL 8
@@ -155,6 +166,39 @@
    twice this must be able to fit in an unsigned type) */
 #define GZBUFSIZE 8192
 
+/* compression threads for writing and the decompression thread for reading,
+   see gzthreads() -- default block size, the amount of preceding input each
+   block is primed with when writing, and the number of blocks of output
+   decompressed ahead when reading */
+#if !defined(NO_GZTHREADS) && (defined(_WIN32) || defined(HAVE_PTHREAD))
+#  define GZ_THREADS
+#  ifdef _WIN32
+#    include <windows.h>
+#  else
+#    include <pthread.h>
+#  endif
+#endif
+#define GZBLOCK 131072U
+#define GZDICT 32768U
+#define GZAHEAD 4
+
+#ifdef GZ_THREADS
+#  ifdef _WIN32
+#    define PAR_LOCK(p) EnterCriticalSection(&(p)->lock)
+#    define PAR_UNLOCK(p) LeaveCriticalSection(&(p)->lock)
+#    define PAR_WAIT(p, c) SleepConditionVariableCS(&(p)->c, &(p)->lock, \
+                                                    INFINITE)
+#    define PAR_SIGNAL(p, c) WakeConditionVariable(&(p)->c)
+#    define PAR_BROADCAST(p, c) WakeAllConditionVariable(&(p)->c)
+#  else
+#    define PAR_LOCK(p) pthread_mutex_lock(&(p)->lock)
+#    define PAR_UNLOCK(p) pthread_mutex_unlock(&(p)->lock)
+#    define PAR_WAIT(p, c) pthread_cond_wait(&(p)->c, &(p)->lock)
+#    define PAR_SIGNAL(p, c) pthread_cond_signal(&(p)->c)
+#    define PAR_BROADCAST(p, c) pthread_cond_broadcast(&(p)->c)
+#  endif
+#endif
+
 /* gzip modes, also provide a little integrity check on the passed structure */
 #define GZ_NONE 0
 #define GZ_READ 7247
@@ -166,6 +210,25 @@
 #define COPY 1      /* copy input directly */
 #define GZIP 2      /* decompress a gzip stream */
 
+/* access point of a gzIndex, see gzindex.c */
+typedef struct {
+    z_off64_t out;          /* offset in the uncompressed data */
+    z_off64_t in;           /* offset in the file of the first full byte */
+    int bits;               /* number of bits (1-7) from byte at in-1, or 0 */
+    unsigned dict;          /* length of the preceding window, up to 32K */
+    unsigned size;          /* length of the deflated window */
+    unsigned char *window;  /* deflated window, NULL if dict is zero */
+} gz_point;
+
+struct gz_index_s {
+    int have;               /* number of access points */
+    int size;               /* allocated number of access points */
+    gz_point *list;         /* access points in increasing order */
+    z_off64_t inlen;        /* length of the gzip file */
+    z_off64_t length;       /* length of the uncompressed data */
+    z_off64_t span;         /* requested distance between access points */
+};
+
 /* internal gzip file state data structure */
 typedef struct {
         /* exposed contents for gzgetc() macro */
@@ -182,15 +245,21 @@ typedef struct {
     unsigned char *in;      /* input buffer (double-sized when writing) */
     unsigned char *out;     /* output buffer (double-sized when reading) */
     int direct;             /* 0 if processing gzip, 1 if transparent */
+    int threads;            /* number of threads, 0 for none, see gzthreads() */
+    unsigned block;         /* block size for threads */
         /* just for reading */
     int how;                /* 0: get header, 1: copy, 2: decompress */
     z_off64_t start;        /* where the gzip data started, for rewinding */
     int eof;                /* true if end of input file reached */
     int past;               /* true if read requested past end */
+    gzIndex index;          /* access points for seeking, or NULL */
+    int raw;                /* true if inflating raw after a jump to one */
+    struct gz_ahead_s *ahead;   /* decompression thread state, or NULL */
         /* just for writing */
     int level;              /* compression level */
     int strategy;           /* compression strategy */
     int reset;              /* true if a reset is pending after a Z_FINISH */
+    struct gz_par_s *par;   /* compression threads state, NULL if none */
         /* seek request */
     z_off64_t skip;         /* amount to skip (already rewound if backwards) */
     int seek;               /* true if seek request pending */
@@ -204,6 +273,11 @@ typedef gz_state FAR *gz_statep;
 
 /* shared functions */
 void ZLIB_INTERNAL gz_error OF((gz_statep, int, const char *));
+gz_point ZLIB_INTERNAL *gz_findpoint OF((gzIndex, z_off64_t));
+int ZLIB_INTERNAL gz_jump OF((gz_statep, gz_point *));
+#ifdef GZ_THREADS
+void ZLIB_INTERNAL gz_ahead_free OF((gz_statep));
+#endif
 #if defined UNDER_CE
 char ZLIB_INTERNAL *gz_strwinerror OF((DWORD error));
 #endif
@@ -0,0 +1,487 @@
+/* gzindex.c -- access point index for random access reading of gzip files
+ * Copyright (C) 2005, 2012, 2018 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* This generalizes examples/zran.c into the library: the index is built with
+   one pass through a gzip file, can be saved to and loaded from an index file,
+   and is used by gzseek() on a file opened for reading after gzsetindex(). An
+   access point is a block boundary in the deflate data, with the bits of the
+   byte it starts in and the preceding 32K of uncompressed data, which is kept
+   deflated. */
+
+#include "gzguts.h"
+
+#define WINSIZE 32768U      /* sliding window size */
+#define CHUNK 16384         /* file input buffer size */
+
+/* index file format, all integers little-endian:
+     magic "GZIX", version (4 bytes), gzip file length (8), uncompressed length
+     (8), span (8), number of access points (4), then for each access point:
+     uncompressed offset (8), file offset (8), bits (1), window length (4),
+     deflated window length (4), deflated window */
+#define GZIX_VERSION 1
+
+/* Free the access point list of index and index itself. */
+void ZEXPORT gzfreeindex(index)
+    gzIndex index;
+{
+    int n;
+
+    if (index == NULL)
+        return;
+    for (n = 0; n < index->have; n++)
+        free(index->list[n].window);
+    free(index->list);
+    free(index);
+}
+
+/* Allocate an empty index. Return NULL if out of memory. */
+local gzIndex gz_newindex OF((void));
+local gzIndex gz_newindex()
+{
+    gzIndex index;
+
+    index = (gzIndex)malloc(sizeof(struct gz_index_s));
+    if (index == NULL)
+        return NULL;
+    index->have = 0;
+    index->size = 0;
+    index->list = NULL;
+    index->inlen = 0;
+    index->length = 0;
+    index->span = 0;
+    return index;
+}
+
+/* Make room for another access point in index. Return NULL if out of memory,
+   otherwise the new, zeroed, access point. */
+local gz_point *gz_newpoint OF((gzIndex));
+local gz_point *gz_newpoint(index)
+    gzIndex index;
+{
+    gz_point *list;
+    int size;
+
+    if (index->have == index->size) {
+        size = index->size ? index->size << 1 : 8;
+        if (size < 0 || (z_size_t)size > (z_size_t)-1 / sizeof(gz_point))
+            return NULL;
+        list = (gz_point *)realloc(index->list, size * sizeof(gz_point));
+        if (list == NULL)
+            return NULL;
+        index->list = list;
+        index->size = size;
+    }
+    list = index->list + index->have;
+    memset(list, 0, sizeof(gz_point));
+    return list;
+}
+
+/* Add an access point to index, with the last dict bytes of the circular
+   window, of which left bytes at the end are not yet written. Return -1 if out
+   of memory, otherwise 0. */
+local int gz_addpoint OF((gzIndex, int, z_off64_t, z_off64_t, unsigned,
+                          unsigned char *, unsigned));
+local int gz_addpoint(index, bits, in, out, left, window, dict)
+    gzIndex index;
+    int bits;
+    z_off64_t in;
+    z_off64_t out;
+    unsigned left;
+    unsigned char *window;
+    unsigned dict;
+{
+    gz_point *next;
+    unsigned char *lin;
+    uLongf size;
+
+    next = gz_newpoint(index);
+    if (next == NULL)
+        return -1;
+    next->out = out;
+    next->in = in;
+    next->bits = bits;
+    next->dict = dict;
+    if (dict) {
+        /* put the window in order, then keep it deflated */
+        lin = (unsigned char *)malloc(WINSIZE);
+        if (lin == NULL)
+            return -1;
+        if (left)
+            memcpy(lin, window + WINSIZE - left, left);
+        if (left < WINSIZE)
+            memcpy(lin + left, window, WINSIZE - left);
+        size = compressBound(dict);
+        next->window = (unsigned char *)malloc(size);
+        if (next->window == NULL ||
+            compress2(next->window, &size, lin + WINSIZE - dict, dict,
+                      Z_BEST_COMPRESSION) != Z_OK) {
+            free(next->window);
+            free(lin);
+            return -1;
+        }
+        free(lin);
+        next->size = (unsigned)size;
+    }
+    index->have++;
+    return 0;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzbuildindex(path, span, built)
+    const char *path;
+    z_off_t span;
+    gzIndex *built;
+{
+    int ret, fd, len, got;
+    unsigned dict;              /* window bytes in the current member */
+    z_off64_t totin, totout;    /* own counters to avoid the 4GB limit */
+    z_off64_t last;             /* totout value of the last access point */
+    z_off64_t start;            /* totout value at the member start */
+    gzIndex index;
+    z_stream strm;
+    unsigned char *input, *window;
+
+    if (path == NULL || built == NULL || span < 0)
+        return Z_STREAM_ERROR;
+    *built = NULL;
+
+    /* allocate buffers, index, and inflate for gzip decoding */
+    input = (unsigned char *)malloc(CHUNK);
+    window = (unsigned char *)malloc(WINSIZE);
+    index = gz_newindex();
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_in = Z_NULL;
+    if (input == NULL || window == NULL || index == NULL ||
+        inflateInit2(&strm, 15 + 16) != Z_OK) {
+        gzfreeindex(index);
+        free(window);
+        free(input);
+        return Z_MEM_ERROR;
+    }
+    index->span = span;
+
+    /* open the file */
+    fd = open(path,
+#ifdef O_LARGEFILE
+              O_LARGEFILE |
+#endif
+#ifdef O_BINARY
+              O_BINARY |
+#endif
+              O_RDONLY);
+    if (fd == -1) {
+        ret = Z_ERRNO;
+        goto gzbuildindex_error;
+    }
+
+    /* inflate the input, maintain a sliding window, and build an index --
+       this also validates the compressed data with the gzip trailers */
+    totin = totout = last = start = 0;
+    strm.avail_out = 0;
+    ret = Z_OK;
+    do {
+        /* get some compressed data from the file */
+        len = read(fd, input, CHUNK);
+        if (len < 0) {
+            ret = Z_ERRNO;
+            goto gzbuildindex_error;
+        }
+        if (len == 0) {
+            ret = Z_DATA_ERROR;
+            goto gzbuildindex_error;
+        }
+        strm.avail_in = (unsigned)len;
+        strm.next_in = input;
+
+        /* process all of that, or until end of stream */
+        do {
+            /* reset sliding window if necessary */
+            if (strm.avail_out == 0) {
+                strm.avail_out = WINSIZE;
+                strm.next_out = window;
+            }
+
+            /* inflate until out of input, output, or at end of block --
+               update the total input and output counters */
+            totin += strm.avail_in;
+            totout += strm.avail_out;
+            ret = inflate(&strm, Z_BLOCK);      /* return at end of block */
+            totin -= strm.avail_in;
+            totout -= strm.avail_out;
+            if (ret == Z_NEED_DICT)
+                ret = Z_DATA_ERROR;
+            if (ret == Z_MEM_ERROR || ret == Z_DATA_ERROR)
+                goto gzbuildindex_error;
+            if (ret == Z_STREAM_END) {
+                /* another member may follow, get its magic bytes */
+                if (strm.avail_in < 2) {
+                    if (strm.avail_in)
+                        input[0] = strm.next_in[0];
+                    got = read(fd, input + strm.avail_in,
+                               CHUNK - strm.avail_in);
+                    if (got < 0) {
+                        ret = Z_ERRNO;
+                        goto gzbuildindex_error;
+                    }
+                    strm.avail_in += (unsigned)got;
+                    strm.next_in = input;
+                }
+                if (strm.avail_in < 2 || strm.next_in[0] != 31 ||
+                    strm.next_in[1] != 139)
+                    break;              /* end, or trailing garbage */
+                ret = inflateReset(&strm);
+                if (ret != Z_OK)
+                    goto gzbuildindex_error;
+                start = totout;
+                continue;
+            }
+
+            /* if at the end of a block, consider adding an access point
+               (see zran.c) -- totout == 0 assures at least one access point,
+               and bit 6 of data_type avoids one after the last block */
+            if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+                (totout == 0 || totout - last > span)) {
+                dict = totout - start > WINSIZE ? WINSIZE :
+                       (unsigned)(totout - start);
+                if (gz_addpoint(index, strm.data_type & 7, totin, totout,
+                                strm.avail_out, window, dict) == -1) {
+                    ret = Z_MEM_ERROR;
+                    goto gzbuildindex_error;
+                }
+                last = totout;
+            }
+        } while (strm.avail_in != 0);
+    } while (ret != Z_STREAM_END);
+
+    /* the file length is kept to check that the index matches the file */
+    index->inlen = totin;
+    while ((got = read(fd, input, CHUNK)) > 0)
+        index->inlen += got;
+    index->inlen += strm.avail_in;
+    close(fd);
+    (void)inflateRelease(&strm);
+    free(window);
+    free(input);
+    index->length = totout;
+    *built = index;
+    return index->have;
+
+  gzbuildindex_error:
+    if (fd != -1)
+        close(fd);
+    (void)inflateRelease(&strm);
+    gzfreeindex(index);
+    free(window);
+    free(input);
+    return ret;
+}
+
+/* Write the low len bytes of val to out, little-endian. */
+local void gz_putle OF((FILE *, z_off64_t, int));
+local void gz_putle(out, val, len)
+    FILE *out;
+    z_off64_t val;
+    int len;
+{
+    while (len--) {
+        putc((int)(val & 0xff), out);
+        val >>= 8;
+    }
+}
+
+/* Read a len byte little-endian unsigned value from in to *val. Return -1 at
+   the end of the file, on a read error, or if the value does not fit in a
+   z_off64_t, otherwise 0. */
+local int gz_getle OF((FILE *, z_off64_t *, int));
+local int gz_getle(in, val, len)
+    FILE *in;
+    z_off64_t *val;
+    int len;
+{
+    int ch, n;
+
+    *val = 0;
+    for (n = 0; n < len; n++) {
+        ch = getc(in);
+        if (ch == EOF)
+            return -1;
+        if (n < (int)sizeof(z_off64_t))
+            *val += (z_off64_t)ch << (n << 3);
+        else if (ch)
+            return -1;
+    }
+    return *val < 0 ? -1 : 0;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzsaveindex(index, path)
+    gzIndex index;
+    const char *path;
+{
+    FILE *out;
+    gz_point *here;
+    int n;
+
+    if (index == NULL || path == NULL)
+        return Z_STREAM_ERROR;
+    out = fopen(path, "wb");
+    if (out == NULL)
+        return Z_ERRNO;
+    fwrite("GZIX", 1, 4, out);
+    gz_putle(out, GZIX_VERSION, 4);
+    gz_putle(out, index->inlen, 8);
+    gz_putle(out, index->length, 8);
+    gz_putle(out, index->span, 8);
+    gz_putle(out, index->have, 4);
+    for (n = 0; n < index->have; n++) {
+        here = index->list + n;
+        gz_putle(out, here->out, 8);
+        gz_putle(out, here->in, 8);
+        gz_putle(out, here->bits, 1);
+        gz_putle(out, here->dict, 4);
+        gz_putle(out, here->size, 4);
+        if (here->size)
+            fwrite(here->window, 1, here->size, out);
+    }
+    if (ferror(out)) {
+        fclose(out);
+        return Z_ERRNO;
+    }
+    return fclose(out) == EOF ? Z_ERRNO : Z_OK;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzloadindex(path, loaded)
+    const char *path;
+    gzIndex *loaded;
+{
+    FILE *in;
+    gzIndex index;
+    gz_point *here;
+    z_off64_t val, count;
+    char magic[4];
+    int ret;
+
+    if (path == NULL || loaded == NULL)
+        return Z_STREAM_ERROR;
+    *loaded = NULL;
+    in = fopen(path, "rb");
+    if (in == NULL)
+        return Z_ERRNO;
+    index = gz_newindex();
+    if (index == NULL) {
+        fclose(in);
+        return Z_MEM_ERROR;
+    }
+
+    /* read and check the header */
+    ret = Z_DATA_ERROR;
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, "GZIX", 4) ||
+        gz_getle(in, &val, 4) || val != GZIX_VERSION ||
+        gz_getle(in, &index->inlen, 8) || gz_getle(in, &index->length, 8) ||
+        gz_getle(in, &index->span, 8) ||
+        gz_getle(in, &count, 4) || count < 1 || count > INT_MAX)
+        goto gzloadindex_error;
+
+    /* read and check the access points, in increasing order */
+    while (index->have < count) {
+        here = gz_newpoint(index);
+        if (here == NULL) {
+            ret = Z_MEM_ERROR;
+            goto gzloadindex_error;
+        }
+        index->have++;              /* so the window is freed on error */
+        if (gz_getle(in, &here->out, 8) || here->out > index->length ||
+            (index->have > 1 && here->out <= here[-1].out) ||
+            gz_getle(in, &here->in, 8) || here->in > index->inlen)
+            goto gzloadindex_error;
+        if (gz_getle(in, &val, 1) || val > 7)
+            goto gzloadindex_error;
+        here->bits = (int)val;
+        if (gz_getle(in, &val, 4) || val > WINSIZE)
+            goto gzloadindex_error;
+        here->dict = (unsigned)val;
+        if (gz_getle(in, &val, 4) || (val == 0) != (here->dict == 0))
+            goto gzloadindex_error;
+        here->size = (unsigned)val;
+        if (here->size) {
+            here->window = (unsigned char *)malloc(here->size);
+            if (here->window == NULL) {
+                ret = Z_MEM_ERROR;
+                goto gzloadindex_error;
+            }
+            if (fread(here->window, 1, here->size, in) != here->size)
+                goto gzloadindex_error;
+        }
+    }
+    fclose(in);
+    *loaded = index;
+    return index->have;
+
+  gzloadindex_error:
+    if (ferror(in))
+        ret = Z_ERRNO;
+    fclose(in);
+    gzfreeindex(index);
+    return ret;
+}
+
+/* Return the last access point at or before offset in the uncompressed data,
+   or NULL if there is none. */
+gz_point ZLIB_INTERNAL *gz_findpoint(index, offset)
+    gzIndex index;
+    z_off64_t offset;
+{
+    int lo, hi, mid;
+
+    if (index->have == 0 || offset < index->list[0].out)
+        return NULL;
+    lo = 0;
+    hi = index->have - 1;
+    while (lo < hi) {
+        mid = lo + ((hi - lo + 1) >> 1);
+        if (index->list[mid].out <= offset)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return index->list + lo;
+}
+
+/* -- see zlib.h -- */
+int ZEXPORT gzsetindex(file, index)
+    gzFile file;
+    gzIndex index;
+{
+    gz_statep state;
+    z_off64_t here, end;
+
+    /* get internal structure and check integrity */
+    if (file == NULL)
+        return -1;
+    state = (gz_statep)file;
+    if (state->mode != GZ_READ)
+        return -1;
+#ifdef GZ_THREADS
+    if (state->ahead != NULL)       /* the file is being read by a thread */
+        return -1;
+#endif
+
+    /* check that the index is for a file of this length */
+    if (index != NULL) {
+        here = LSEEK(state->fd, 0, SEEK_CUR);
+        end = LSEEK(state->fd, 0, SEEK_END);
+        if (here == -1 || end == -1 ||
+            LSEEK(state->fd, here, SEEK_SET) == -1)
+            return -1;
+        if (end - state->start != index->inlen)
+            return -1;
+    }
+    state->index = index;
+    return 0;
+}
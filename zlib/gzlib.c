@@ -5,16 +5,6 @@
 
 #include "gzguts.h"
 
-#if defined(_WIN32) && !defined(__BORLANDC__)
-#  define LSEEK _lseeki64
-#else
-#if defined(_LARGEFILE64_SOURCE) && _LFS64_LARGEFILE-0
-#  define LSEEK lseek64
-#else
-#  define LSEEK lseek
-#endif
-#endif
-
 /* Local functions */
 local void gz_reset OF((gz_statep));
 local gzFile gz_open OF((const void *, int, const char *));
@@ -80,6 +70,10 @@ local void gz_reset(state)
         state->eof = 0;             /* not at end of file */
         state->past = 0;            /* have not read past end yet */
         state->how = LOOK;          /* look for gzip header */
+        if (state->raw) {           /* back to gzip after gz_jump() */
+            inflateReset2(&(state->strm), 15 + 16);
+            state->raw = 0;
+        }
     }
     else                            /* for writing ... */
         state->reset = 0;           /* no deflateReset pending */
@@ -122,6 +116,12 @@ local gzFile gz_open(path, fd, mode)
     state->level = Z_DEFAULT_COMPRESSION;
     state->strategy = Z_DEFAULT_STRATEGY;
     state->direct = 0;
+    state->threads = 0;
+    state->block = 0;
+    state->par = NULL;
+    state->index = NULL;
+    state->raw = 0;
+    state->ahead = NULL;
     while (*mode) {
         if (*mode >= '0' && *mode <= '9')
             state->level = *mode - '0';
@@ -165,6 +165,9 @@ local gzFile gz_open(path, fd, mode)
             case 'F':
                 state->strategy = Z_FIXED;
                 break;
+            case 'Q':
+                state->strategy = Z_QUICK;
+                break;
             case 'T':
                 state->direct = 1;
                 break;
@@ -357,7 +360,11 @@ int ZEXPORT gzrewind(file)
             (state->err != Z_OK && state->err != Z_BUF_ERROR))
         return -1;
 
-    /* back up and start over */
+    /* back up and start over, stopping the decompression thread first */
+#ifdef GZ_THREADS
+    if (state->ahead != NULL)
+        gz_ahead_free(state);
+#endif
     if (LSEEK(state->fd, state->start, SEEK_SET) == -1)
         return -1;
     gz_reset(state);
@@ -373,6 +380,7 @@ z_off64_t ZEXPORT gzseek64(file, offset, whence)
     unsigned n;
     z_off64_t ret;
     gz_statep state;
+    gz_point *here;
 
     /* get internal structure and check integrity */
     if (file == NULL)
@@ -412,6 +420,18 @@ z_off64_t ZEXPORT gzseek64(file, offset, whence)
         return state->x.pos;
     }
 
+    /* if reading with an index, jump to the access point before the target if
+       that is back or is ahead of the current position */
+    if (state->mode == GZ_READ && state->index != NULL &&
+            state->x.pos + offset >= 0) {
+        here = gz_findpoint(state->index, state->x.pos + offset);
+        if (here != NULL && (offset < 0 || here->out > state->x.pos)) {
+            offset += state->x.pos - here->out;
+            if (gz_jump(state, here) == -1)
+                return -1;
+        }
+    }
+
     /* calculate skip amount, rewinding if needed for back seek when reading */
     if (offset < 0) {
         if (state->mode != GZ_READ)         /* writing -- can't go backwards */
@@ -8,11 +8,48 @@
 /* Local functions */
 local int gz_load OF((gz_statep, unsigned char *, unsigned, unsigned *));
 local int gz_avail OF((gz_statep));
+local int gz_alloc OF((gz_statep));
 local int gz_look OF((gz_statep));
 local int gz_decomp OF((gz_statep));
 local int gz_fetch OF((gz_statep));
 local int gz_skip OF((gz_statep, z_off64_t));
 local z_size_t gz_read OF((gz_statep, voidp, z_size_t));
+#ifdef GZ_THREADS
+local int gz_ahead_init OF((gz_statep));
+local int gz_ahead_fetch OF((gz_statep));
+local void gz_ahead_error OF((gz_statep));
+
+/* Decompression thread: a thread reads and decompresses the file with its own
+   gz_state, into a ring of GZAHEAD output buffers. The reader takes the full
+   buffers in order, holding the one its x.next points into until it is used
+   up. The state of the reader keeps only its position and an output buffer
+   for gzungetc(). */
+struct gz_ahead_s {
+    gz_state st;                    /* state of the decompression thread */
+    unsigned char *buf[GZAHEAD];    /* output buffers of st.size << 1 bytes */
+    unsigned char *next[GZAHEAD];   /* decompressed data in each buffer */
+    unsigned have[GZAHEAD];         /* amount of data at next */
+    int direct[GZAHEAD];            /* st.direct when the data was made */
+    int head;                       /* first full buffer */
+    int full;                       /* number of full buffers from head */
+    int hold;                       /* true if the reader has the head buffer */
+    int end;                        /* true if the thread reached the end */
+    int seen;                       /* true if the reader reached the end */
+    int quit;                       /* true to have the thread exit */
+    int running;                    /* true if the thread was started */
+#ifdef _WIN32
+    HANDLE tid;                     /* thread handle */
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE room;        /* signalled when a buffer is free */
+    CONDITION_VARIABLE data;        /* signalled when a buffer is full */
+#else
+    pthread_t tid;                  /* thread id */
+    pthread_mutex_t lock;
+    pthread_cond_t room;            /* signalled when a buffer is free */
+    pthread_cond_t data;            /* signalled when a buffer is full */
+#endif
+};
+#endif
 
 /* Use read() to load a buffer -- return -1 on error, otherwise 0.  Read from
    state->fd, and update state->eof, state->err, and state->msg as appropriate.
@@ -79,6 +116,39 @@ local int gz_avail(state)
     return 0;
 }
 
+/* Allocate the input and output buffers and the inflate memory, and mark
+   this by setting state->size to non-zero.  Return -1 on failure, otherwise
+   0. */
+local int gz_alloc(state)
+    gz_statep state;
+{
+    /* allocate buffers */
+    state->in = (unsigned char *)malloc(state->want);
+    state->out = (unsigned char *)malloc(state->want << 1);
+    if (state->in == NULL || state->out == NULL) {
+        free(state->out);
+        free(state->in);
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    state->size = state->want;
+
+    /* allocate inflate memory */
+    state->strm.zalloc = Z_NULL;
+    state->strm.zfree = Z_NULL;
+    state->strm.opaque = Z_NULL;
+    state->strm.avail_in = 0;
+    state->strm.next_in = Z_NULL;
+    if (inflateInit2(&(state->strm), 15 + 16) != Z_OK) {    /* gunzip */
+        free(state->out);
+        free(state->in);
+        state->size = 0;
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    return 0;
+}
+
 /* Look for gzip header, set up for inflate or copy.  state->x.have must be 0.
    If this is the first time in, allocate required memory.  state->how will be
    left unchanged if there is no more input data available, will be set to COPY
@@ -94,32 +164,8 @@ local int gz_look(state)
     z_streamp strm = &(state->strm);
 
     /* allocate read buffers and inflate memory */
-    if (state->size == 0) {
-        /* allocate buffers */
-        state->in = (unsigned char *)malloc(state->want);
-        state->out = (unsigned char *)malloc(state->want << 1);
-        if (state->in == NULL || state->out == NULL) {
-            free(state->out);
-            free(state->in);
-            gz_error(state, Z_MEM_ERROR, "out of memory");
-            return -1;
-        }
-        state->size = state->want;
-
-        /* allocate inflate memory */
-        state->strm.zalloc = Z_NULL;
-        state->strm.zfree = Z_NULL;
-        state->strm.opaque = Z_NULL;
-        state->strm.avail_in = 0;
-        state->strm.next_in = Z_NULL;
-        if (inflateInit2(&(state->strm), 15 + 16) != Z_OK) {    /* gunzip */
-            free(state->out);
-            free(state->in);
-            state->size = 0;
-            gz_error(state, Z_MEM_ERROR, "out of memory");
-            return -1;
-        }
-    }
+    if (state->size == 0 && gz_alloc(state) == -1)
+        return -1;
 
     /* get at least the magic bytes in the input buffer */
     if (strm->avail_in < 2) {
@@ -174,7 +220,7 @@ local int gz_decomp(state)
     gz_statep state;
 {
     int ret = Z_OK;
-    unsigned had;
+    unsigned had, trail;
     z_streamp strm = &(state->strm);
 
     /* fill output buffer up to end of deflate stream */
@@ -211,13 +257,118 @@ local int gz_decomp(state)
     state->x.next = strm->next_out - state->x.have;
 
     /* if the gzip stream completed successfully, look for another */
-    if (ret == Z_STREAM_END)
+    if (ret == Z_STREAM_END) {
         state->how = LOOK;
 
+        /* after a jump to an access point, inflate did not see the gzip
+           header and will not see the trailer -- skip the trailer and go
+           back to gzip decoding */
+        if (state->raw) {
+            trail = 8;
+            while (trail) {
+                if (strm->avail_in == 0 && gz_avail(state) == -1)
+                    return -1;
+                if (strm->avail_in == 0)
+                    break;
+                had = strm->avail_in < trail ? strm->avail_in : trail;
+                strm->avail_in -= had;
+                strm->next_in += had;
+                trail -= had;
+            }
+            inflateReset2(strm, 15 + 16);
+            state->raw = 0;
+        }
+    }
+
     /* good decompression */
     return 0;
 }
 
+/* Continue decompression from the access point here of state->index, with
+   state->x.pos set to its offset. Return -1 on error, otherwise 0. */
+int ZLIB_INTERNAL gz_jump(state, here)
+    gz_statep state;
+    gz_point *here;
+{
+    unsigned got;
+    uLongf len;
+    unsigned char *dict;
+    z_streamp strm = &(state->strm);
+
+#ifdef GZ_THREADS
+    /* with a decompression thread, start a new one from the access point */
+    if (state->threads) {
+        if (state->ahead != NULL)
+            gz_ahead_free(state);
+        if (gz_ahead_init(state) == -1)
+            return -1;
+        if (gz_jump(&(state->ahead->st), here) == -1) {
+            gz_ahead_error(state);
+            gz_ahead_free(state);
+            return -1;
+        }
+        state->x.have = 0;
+        state->eof = 0;
+        state->past = 0;
+        gz_error(state, Z_OK, NULL);
+        state->x.pos = here->out;
+        return 0;
+    }
+#endif
+
+    /* allocate buffers and inflate memory if not done yet */
+    if (state->size == 0 && gz_look(state) == -1)
+        return -1;
+    if (state->size == 0 || state->how == COPY) {
+        gz_error(state, Z_DATA_ERROR, "index does not match file");
+        return -1;
+    }
+
+    /* go to the first byte of the access point */
+    if (LSEEK(state->fd, state->start + here->in - (here->bits ? 1 : 0),
+              SEEK_SET) == -1) {
+        gz_error(state, Z_ERRNO, zstrerror());
+        return -1;
+    }
+    state->x.have = 0;
+    state->eof = 0;
+    state->past = 0;
+    strm->avail_in = 0;
+    gz_error(state, Z_OK, NULL);
+
+    /* set up raw inflate with the bits and window of the access point */
+    inflateReset2(strm, -15);
+    state->raw = 1;
+    state->how = GZIP;
+    state->x.pos = here->out;
+    if (here->bits) {
+        if (gz_load(state, state->in, 1, &got) == -1)
+            return -1;
+        if (got != 1) {
+            gz_error(state, Z_DATA_ERROR, "index does not match file");
+            return -1;
+        }
+        inflatePrime(strm, here->bits, state->in[0] >> (8 - here->bits));
+    }
+    if (here->dict) {
+        dict = (unsigned char *)malloc(here->dict);
+        if (dict == NULL) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        len = here->dict;
+        if (uncompress(dict, &len, here->window, here->size) != Z_OK ||
+            len != here->dict) {
+            free(dict);
+            gz_error(state, Z_DATA_ERROR, "index is corrupt");
+            return -1;
+        }
+        inflateSetDictionary(strm, dict, here->dict);
+        free(dict);
+    }
+    return 0;
+}
+
 /* Fetch data and put it in the output buffer.  Assumes state->x.have is 0.
    Data is either copied from the input file or decompressed from the input
    file depending on state->how.  If state->how is LOOK, then a gzip header is
@@ -229,6 +380,10 @@ local int gz_fetch(state)
 {
     z_streamp strm = &(state->strm);
 
+#ifdef GZ_THREADS
+    if (state->threads)
+        return gz_ahead_fetch(state);
+#endif
     do {
         switch(state->how) {
         case LOOK:      /* -> LOOK, COPY (only if never GZIP), or GZIP */
@@ -513,6 +668,21 @@ int ZEXPORT gzungetc(c, file)
         return c;
     }
 
+#ifdef GZ_THREADS
+    /* if at the start of a buffer of the decompression thread, move the data
+       to the output buffer if it fits */
+    if (state->ahead != NULL && state->ahead->hold &&
+        state->x.next == state->ahead->buf[state->ahead->head]) {
+        if (state->x.have >= (state->size << 1)) {
+            gz_error(state, Z_DATA_ERROR, "out of room to push characters");
+            return -1;
+        }
+        state->x.next = state->out + (state->size << 1) - state->x.have;
+        memcpy(state->x.next, state->ahead->buf[state->ahead->head],
+               state->x.have);
+    }
+#endif
+
     /* if no room, give up (must have already done a gzungetc()) */
     if (state->x.have == (state->size << 1)) {
         gz_error(state, Z_DATA_ERROR, "out of room to push characters");
@@ -612,13 +782,287 @@ int ZEXPORT gzdirect(file)
 
     /* if the state is not known, but we can find out, then do so (this is
        mainly for right after a gzopen() or gzdopen()) */
-    if (state->mode == GZ_READ && state->how == LOOK && state->x.have == 0)
+    if (state->mode == GZ_READ && state->how == LOOK && state->x.have == 0) {
+#ifdef GZ_THREADS
+        if (state->threads) {
+            if (state->ahead == NULL)
+                (void)gz_fetch(state);
+        }
+        else
+#endif
         (void)gz_look(state);
+    }
 
     /* return 1 if transparent, 0 if processing a gzip stream */
     return state->direct;
 }
 
+#ifdef GZ_THREADS
+
+/* Decompress into the free buffers until the end of the input, an error, or
+   told to quit. */
+#ifdef _WIN32
+local DWORD WINAPI gz_ahead_thread(void *arg)
+#else
+local void *gz_ahead_thread(void *arg)
+#endif
+{
+    struct gz_ahead_s *ahead = (struct gz_ahead_s *)arg;
+    gz_statep st = &(ahead->st);
+    int slot, ret;
+
+    do {
+        /* get a free buffer */
+        PAR_LOCK(ahead);
+        while (ahead->full == GZAHEAD && !ahead->quit)
+            PAR_WAIT(ahead, room);
+        if (ahead->quit) {
+            PAR_UNLOCK(ahead);
+            break;
+        }
+        slot = (ahead->head + ahead->full) % GZAHEAD;
+        PAR_UNLOCK(ahead);
+
+        /* fill it as gzread() would its own output buffer */
+        st->out = ahead->buf[slot];
+        st->x.have = 0;
+        ret = gz_fetch(st);
+
+        /* hand it over, or report the end */
+        PAR_LOCK(ahead);
+        if (ret == 0 && st->x.have) {
+            ahead->next[slot] = st->x.next;
+            ahead->have[slot] = st->x.have;
+            ahead->direct[slot] = st->direct;
+            ahead->full++;
+            ret = 1;
+        }
+        else
+            ahead->end = 1;
+        PAR_SIGNAL(ahead, data);
+        PAR_UNLOCK(ahead);
+    } while (ret == 1);
+    return 0;
+}
+
+/* Wait for the thread to exit. */
+local void gz_ahead_join OF((struct gz_ahead_s *));
+local void gz_ahead_join(ahead)
+    struct gz_ahead_s *ahead;
+{
+#ifdef _WIN32
+    WaitForSingleObject(ahead->tid, INFINITE);
+    CloseHandle(ahead->tid);
+#else
+    pthread_join(ahead->tid, NULL);
+#endif
+    ahead->running = 0;
+}
+
+/* Allocate the decompression thread state, to continue from the current
+   position of the file, without starting the thread. Return -1 on failure,
+   otherwise 0. */
+local int gz_ahead_init(state)
+    gz_statep state;
+{
+    struct gz_ahead_s *ahead;
+    gz_statep st;
+    int n;
+
+    /* the reader only needs an output buffer for gzungetc() */
+    if (state->size == 0) {
+        state->out = (unsigned char *)malloc(state->want << 1);
+        if (state->out == NULL) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        state->in = NULL;
+        state->size = state->want;
+        state->strm.avail_in = 0;
+    }
+
+    /* set up a state to read the file from here, with buffers of at least
+       state->block bytes of output */
+    ahead = (struct gz_ahead_s *)malloc(sizeof(struct gz_ahead_s));
+    if (ahead == NULL) {
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    st = &(ahead->st);
+    st->mode = GZ_READ;
+    st->fd = state->fd;
+    st->path = state->path;
+    st->size = 0;
+    st->want = state->want > (state->block >> 1) ? state->want :
+               state->block >> 1;
+    st->direct = state->direct;
+    st->threads = 0;
+    st->how = LOOK;
+    st->start = state->start;
+    st->eof = 0;
+    st->past = 0;
+    st->index = NULL;
+    st->raw = 0;
+    st->ahead = NULL;
+    st->par = NULL;
+    st->seek = 0;
+    st->err = Z_OK;
+    st->msg = NULL;
+    st->x.have = 0;
+    st->x.pos = 0;
+    if (gz_alloc(st) == -1) {
+        free(ahead);
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    ahead->buf[0] = st->out;
+    for (n = 1; n < GZAHEAD; n++) {
+        ahead->buf[n] = (unsigned char *)malloc(st->size << 1);
+        if (ahead->buf[n] == NULL) {
+            while (--n)
+                free(ahead->buf[n]);
+            inflateRelease(&(st->strm));
+            free(st->out);
+            free(st->in);
+            free(ahead);
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+    }
+    ahead->head = 0;
+    ahead->full = 0;
+    ahead->hold = 0;
+    ahead->end = 0;
+    ahead->seen = 0;
+    ahead->quit = 0;
+    ahead->running = 0;
+#ifdef _WIN32
+    InitializeCriticalSection(&ahead->lock);
+    InitializeConditionVariable(&ahead->room);
+    InitializeConditionVariable(&ahead->data);
+#else
+    pthread_mutex_init(&ahead->lock, NULL);
+    pthread_cond_init(&ahead->room, NULL);
+    pthread_cond_init(&ahead->data, NULL);
+#endif
+    state->ahead = ahead;
+    return 0;
+}
+
+/* Set the error of the reader to that of the decompression thread. */
+local void gz_ahead_error(state)
+    gz_statep state;
+{
+    gz_statep st = &(state->ahead->st);
+
+    gz_error(state, st->err, NULL);
+    state->msg = st->msg;
+    st->msg = NULL;
+}
+
+/* gz_fetch() with a decompression thread: take the next full buffer from the
+   thread, starting it if needed. Return -1 on error, otherwise 0. */
+local int gz_ahead_fetch(state)
+    gz_statep state;
+{
+    struct gz_ahead_s *ahead = state->ahead;
+
+    /* set up the thread, or after the end, continue reading the file if
+       gzclearerr() was called, as gzread() does */
+    if (ahead == NULL) {
+        if (gz_ahead_init(state) == -1)
+            return -1;
+        ahead = state->ahead;
+    }
+    else if (ahead->seen) {
+        if (state->eof)
+            return 0;
+        gz_ahead_join(ahead);
+        ahead->st.eof = 0;
+        ahead->st.past = 0;
+        gz_error(&(ahead->st), Z_OK, NULL);
+        ahead->end = 0;
+        ahead->seen = 0;
+    }
+    if (!ahead->running) {
+#ifdef _WIN32
+        ahead->tid = CreateThread(NULL, 0, gz_ahead_thread, ahead, 0, NULL);
+        ahead->running = ahead->tid != NULL;
+#else
+        ahead->running = pthread_create(&ahead->tid, NULL, gz_ahead_thread,
+                                        ahead) == 0;
+#endif
+        if (!ahead->running) {
+            gz_error(state, Z_ERRNO, "could not start decompression thread");
+            return -1;
+        }
+    }
+
+    /* give back the buffer used up, and wait for the next one */
+    PAR_LOCK(ahead);
+    if (ahead->hold) {
+        ahead->head = (ahead->head + 1) % GZAHEAD;
+        ahead->full--;
+        ahead->hold = 0;
+        PAR_SIGNAL(ahead, room);
+    }
+    while (ahead->full == 0 && !ahead->end)
+        PAR_WAIT(ahead, data);
+    if (ahead->full) {
+        state->x.next = ahead->next[ahead->head];
+        state->x.have = ahead->have[ahead->head];
+        state->direct = ahead->direct[ahead->head];
+        ahead->hold = 1;
+        PAR_UNLOCK(ahead);
+        return 0;
+    }
+    PAR_UNLOCK(ahead);
+
+    /* the thread is done -- pass on its end of file and error, if any */
+    ahead->seen = 1;
+    state->eof = 1;
+    if (ahead->st.err != Z_OK) {
+        gz_ahead_error(state);
+        if (state->err != Z_BUF_ERROR)
+            return -1;
+    }
+    return 0;
+}
+
+/* Stop the decompression thread and free its state, dropping the data it
+   decompressed ahead. */
+void ZLIB_INTERNAL gz_ahead_free(state)
+    gz_statep state;
+{
+    struct gz_ahead_s *ahead = state->ahead;
+    int n;
+
+    if (ahead->running) {
+        PAR_LOCK(ahead);
+        ahead->quit = 1;
+        PAR_SIGNAL(ahead, room);
+        PAR_UNLOCK(ahead);
+        gz_ahead_join(ahead);
+    }
+    for (n = 0; n < GZAHEAD; n++)
+        free(ahead->buf[n]);
+    inflateRelease(&(ahead->st.strm));
+    free(ahead->st.in);
+    gz_error(&(ahead->st), Z_OK, NULL);
+#ifdef _WIN32
+    DeleteCriticalSection(&ahead->lock);
+#else
+    pthread_cond_destroy(&ahead->data);
+    pthread_cond_destroy(&ahead->room);
+    pthread_mutex_destroy(&ahead->lock);
+#endif
+    free(ahead);
+    state->ahead = NULL;
+    state->x.have = 0;
+}
+
+#endif /* GZ_THREADS */
+
 /* -- see zlib.h -- */
 int ZEXPORT gzclose_r(file)
     gzFile file;
@@ -636,8 +1080,13 @@ int ZEXPORT gzclose_r(file)
         return Z_STREAM_ERROR;
 
     /* free memory and close file */
+#ifdef GZ_THREADS
+    if (state->ahead != NULL)
+        gz_ahead_free(state);
+#endif
     if (state->size) {
-        inflateEnd(&(state->strm));
+        if (state->in != NULL)          /* NULL if read by a thread */
+            inflateRelease(&(state->strm));
         free(state->out);
         free(state->in);
     }
@@ -10,6 +10,11 @@ local int gz_init OF((gz_statep));
 local int gz_comp OF((gz_statep, int));
 local int gz_zero OF((gz_statep, z_off64_t));
 local z_size_t gz_write OF((gz_statep, voidpc, z_size_t));
+#ifdef GZ_THREADS
+local int gz_par_init OF((gz_statep));
+local int gz_par_comp OF((gz_statep, int));
+local void gz_par_free OF((gz_statep));
+#endif
 
 /* Initialize state for writing a gzip file.  Mark initialization by setting
    state->size to non-zero.  Return -1 on a memory allocation failure, or 0 on
@@ -27,6 +32,17 @@ local int gz_init(state)
         return -1;
     }
 
+    /* compress in background threads if requested, see gzthreads() */
+#ifdef GZ_THREADS
+    if (!state->direct && state->threads) {
+        state->out = NULL;
+        if (gz_par_init(state) == -1) {
+            free(state->in);
+            return -1;
+        }
+    }
+    else
+#endif
     /* only need output buffer and deflate state if compressing */
     if (!state->direct) {
         /* allocate output buffer */
@@ -97,6 +113,11 @@ local int gz_comp(state, flush)
         return 0;
     }
 
+#ifdef GZ_THREADS
+    if (state->par != NULL)
+        return gz_par_comp(state, flush);
+#endif
+
     /* check for a pending reset */
     if (state->reset) {
         /* don't start a new gzip member unless there is data to write */
@@ -628,6 +649,9 @@ int ZEXPORT gzsetparams(file, level, strategy)
         /* flush previous input with previous parameters before changing */
         if (strm->avail_in && gz_comp(state, Z_BLOCK) == -1)
             return state->err;
+#ifdef GZ_THREADS
+        if (state->par == NULL)
+#endif
         deflateParams(strm, level, strategy);
     }
     state->level = level;
@@ -635,6 +659,517 @@ int ZEXPORT gzsetparams(file, level, strategy)
     return Z_OK;
 }
 
+/* -- see zlib.h -- */
+int ZEXPORT gzthreads(file, threads, block)
+    gzFile file;
+    int threads;
+    unsigned block;
+{
+    gz_statep state;
+
+    /* get internal structure and check integrity */
+    if (file == NULL)
+        return -1;
+    state = (gz_statep)file;
+    if (state->mode != GZ_WRITE && state->mode != GZ_READ)
+        return -1;
+
+    /* make sure we haven't already allocated memory */
+    if (state->size != 0 || threads < 0)
+        return -1;
+#ifndef GZ_THREADS
+    if (threads)
+        return -1;
+#endif
+
+    /* set number of threads and block size */
+    if (block == 0)
+        block = GZBLOCK;
+    if (block < GZDICT)
+        block = GZDICT;
+    state->threads = threads;
+    state->block = block;
+    return 0;
+}
+
+#ifdef GZ_THREADS
+
+/* Parallel compression: input is cut into blocks that are each compressed on
+   their own by a pool of threads, primed with the GZDICT bytes of input that
+   precede them. Each block but the last of a gzip member ends with a sync
+   flush, so the blocks are byte-aligned and written one after the other as a
+   single deflate stream. The gzip header and trailer are written here, with
+   the check value combined from those of the blocks. */
+
+/* one block of input and its compressed data */
+typedef struct gz_job_s {
+    struct gz_job_s *next;      /* next job to write, or next free job */
+    struct gz_job_s *work;      /* next job waiting for a thread */
+    unsigned char *in;          /* dictionary followed by input */
+    unsigned dict;              /* length of the dictionary at in */
+    unsigned len;               /* length of the input after the dictionary */
+    unsigned char *out;         /* compressed data */
+    unsigned have;              /* length of the compressed data */
+    unsigned size;              /* allocated size of out */
+    int level;                  /* compression level */
+    int strategy;               /* compression strategy */
+    int flush;                  /* Z_SYNC_FLUSH or Z_FINISH */
+    uLong check;                /* crc32 of the input */
+    int ret;                    /* 0 pending, 1 done, -1 out of memory */
+} gz_job;
+
+struct gz_par_s {
+    gz_job *cur;                /* job being filled, or NULL */
+    gz_job *head, *tail;        /* jobs not yet written, in order */
+    gz_job *work, *last;        /* jobs waiting for a thread, in order */
+    gz_job *free;               /* jobs for reuse */
+    int pending;                /* number of jobs from head to tail */
+    int quit;                   /* true to have the threads exit */
+    int threads;                /* number of threads running */
+    unsigned char dict[GZDICT]; /* dictionary for the next job */
+    unsigned dictlen;           /* length of dict */
+    int header;                 /* true if the member's header is written */
+    uLong check;                /* crc32 of the member so far */
+    uLong len;                  /* length of the member mod 2^32 */
+#ifdef _WIN32
+    HANDLE *tid;                /* thread handles */
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE ready;   /* signalled when there is work */
+    CONDITION_VARIABLE done;    /* signalled when a job is done */
+#else
+    pthread_t *tid;             /* thread ids */
+    pthread_mutex_t lock;
+    pthread_cond_t ready;       /* signalled when there is work */
+    pthread_cond_t done;        /* signalled when a job is done */
+#endif
+};
+
+/* Compress one job with strm, which is set up for raw deflate or has
+   strm->state == Z_NULL if not yet. Return 1 on success, or -1 if memory could
+   not be allocated. */
+local int gz_par_job(strm, job)
+    z_streamp strm;
+    gz_job *job;
+{
+    uLong bound;
+
+    /* set up the stream for this job's parameters */
+    if (strm->state == Z_NULL) {
+        if (deflateInit2(strm, job->level, Z_DEFLATED, -MAX_WBITS,
+                         DEF_MEM_LEVEL, job->strategy) != Z_OK)
+            return -1;
+    }
+    else {
+        deflateReset(strm);
+        deflateParams(strm, job->level, job->strategy);
+    }
+    if (job->dict)
+        deflateSetDictionary(strm, job->in, job->dict);
+
+    /* make room for all of the compressed data and the flush marker */
+    bound = deflateBound(strm, job->len) + 16;
+    if (job->size < bound) {
+        free(job->out);
+        job->out = (unsigned char *)malloc(bound);
+        job->size = job->out == NULL ? 0 : (unsigned)bound;
+        if (job->out == NULL)
+            return -1;
+    }
+
+    /* compress and check the input */
+    strm->next_in = job->in + job->dict;
+    strm->avail_in = job->len;
+    strm->next_out = job->out;
+    strm->avail_out = job->size;
+    (void)deflate(strm, job->flush);
+    job->have = job->size - strm->avail_out;
+    job->check = crc32_z(0L, job->in + job->dict, job->len);
+    return 1;
+}
+
+/* Compress jobs until told to quit. */
+#ifdef _WIN32
+local DWORD WINAPI gz_par_thread(void *arg)
+#else
+local void *gz_par_thread(void *arg)
+#endif
+{
+    struct gz_par_s *par = (struct gz_par_s *)arg;
+    z_stream strm;
+    gz_job *job;
+    int ret;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.state = Z_NULL;
+    for (;;) {
+        /* get the next job */
+        PAR_LOCK(par);
+        while (par->work == NULL && !par->quit)
+            PAR_WAIT(par, ready);
+        job = par->work;
+        if (job == NULL) {
+            PAR_UNLOCK(par);
+            break;
+        }
+        par->work = job->work;
+        PAR_UNLOCK(par);
+
+        /* compress it and report back */
+        ret = gz_par_job(&strm, job);
+        PAR_LOCK(par);
+        job->ret = ret;
+        PAR_BROADCAST(par, done);
+        PAR_UNLOCK(par);
+    }
+    if (strm.state != Z_NULL)
+        (void)deflateRelease(&strm);
+    return 0;
+}
+
+/* Write len bytes from buf to the output file. Return -1 on a write error,
+   otherwise 0. */
+local int gz_par_put(state, buf, len)
+    gz_statep state;
+    const unsigned char *buf;
+    unsigned len;
+{
+    int writ;
+    unsigned put, max = ((unsigned)-1 >> 2) + 1;
+
+    while (len) {
+        put = len > max ? max : len;
+        writ = write(state->fd, buf, put);
+        if (writ < 0) {
+            gz_error(state, Z_ERRNO, zstrerror());
+            return -1;
+        }
+        buf += writ;
+        len -= (unsigned)writ;
+    }
+    return 0;
+}
+
+/* Write the jobs that are done, in order. If all is true, wait for and write
+   all of the jobs, otherwise wait only while there are more jobs pending than
+   twice the number of threads. Return -1 on a write or memory error,
+   otherwise 0. */
+local int gz_par_write(state, all)
+    gz_statep state;
+    int all;
+{
+    struct gz_par_s *par = state->par;
+    unsigned char buf[10];
+    gz_job *job;
+    uLong len;
+    int ret;
+
+    for (;;) {
+        /* get the next job in order when it is done */
+        PAR_LOCK(par);
+        while ((job = par->head) != NULL && job->ret == 0 &&
+               (all || par->pending > (par->threads << 1)))
+            PAR_WAIT(par, done);
+        if (job == NULL || job->ret == 0) {
+            PAR_UNLOCK(par);
+            return 0;
+        }
+        par->head = job->next;
+        par->pending--;
+        PAR_UNLOCK(par);
+        ret = job->ret;
+
+        /* write the header, the compressed data, and the trailer */
+        if (ret == 1 && !par->header) {
+            buf[0] = 31;
+            buf[1] = 139;
+            buf[2] = 8;
+            buf[3] = buf[4] = buf[5] = buf[6] = buf[7] = 0;
+            buf[8] = state->level == 9 ? 2 :
+                     (state->strategy >= Z_HUFFMAN_ONLY ||
+                      (state->level >= 0 && state->level < 2) ? 4 : 0);
+#ifdef _WIN32
+            buf[9] = 10;                /* as OS_CODE in zutil.h */
+#else
+            buf[9] = 3;
+#endif
+            if (gz_par_put(state, buf, 10) == -1)
+                ret = -1;
+            par->header = 1;
+        }
+        if (ret == 1 && gz_par_put(state, job->out, job->have) == -1)
+            ret = -1;
+        par->check = crc32_combine(par->check, job->check, job->len);
+        par->len += job->len;
+        if (ret == 1 && job->flush == Z_FINISH) {
+            len = par->check;
+            for (ret = 0; ret < 4; ret++, len >>= 8)
+                buf[ret] = (unsigned char)len;
+            len = par->len;
+            for (; ret < 8; ret++, len >>= 8)
+                buf[ret] = (unsigned char)len;
+            ret = gz_par_put(state, buf, 8) == -1 ? -1 : 1;
+            par->header = 0;
+            par->check = crc32(0L, Z_NULL, 0);
+            par->len = 0;
+        }
+
+        /* keep the job for reuse */
+        job->next = par->free;
+        par->free = job;
+        if (ret == -1) {
+            if (state->err == Z_OK)
+                gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+    }
+}
+
+/* Hand the current job to the threads with flush, starting an empty one if
+   there is none. Return -1 on a memory allocation failure, otherwise 0. */
+local int gz_par_submit(state, flush)
+    gz_statep state;
+    int flush;
+{
+    struct gz_par_s *par = state->par;
+    gz_job *job = par->cur;
+    unsigned keep;
+
+    if (job == NULL) {
+        job = par->free;
+        if (job != NULL)
+            par->free = job->next;
+        else {
+            job = (gz_job *)malloc(sizeof(gz_job));
+            if (job == NULL)
+                return -1;
+            job->in = (unsigned char *)malloc(GZDICT + state->block);
+            if (job->in == NULL) {
+                free(job);
+                return -1;
+            }
+            job->out = NULL;
+            job->size = 0;
+        }
+        job->dict = par->dictlen;
+        memcpy(job->in, par->dict, par->dictlen);
+        job->len = 0;
+        par->cur = job;
+        if (flush == Z_NO_FLUSH)
+            return 0;
+    }
+
+    /* save the end of the input as the next dictionary, unless it is not
+       to be used */
+    if (flush == Z_FULL_FLUSH || flush == Z_FINISH)
+        par->dictlen = 0;
+    else {
+        keep = job->dict + job->len;
+        if (keep > GZDICT)
+            keep = GZDICT;
+        memcpy(par->dict, job->in + job->dict + job->len - keep, keep);
+        par->dictlen = keep;
+    }
+
+    /* queue the job */
+    job->level = state->level;
+    job->strategy = state->strategy;
+    job->flush = flush == Z_FINISH ? Z_FINISH : Z_SYNC_FLUSH;
+    job->ret = 0;
+    job->next = NULL;
+    job->work = NULL;
+    PAR_LOCK(par);
+    if (par->head == NULL)
+        par->head = job;
+    else
+        par->tail->next = job;
+    par->tail = job;
+    par->pending++;
+    if (par->work == NULL)
+        par->work = job;
+    else
+        par->last->work = job;
+    par->last = job;
+    PAR_SIGNAL(par, ready);
+    PAR_UNLOCK(par);
+    par->cur = NULL;
+    return 0;
+}
+
+/* Allocate the parallel compression state and start the threads. Return -1
+   on failure, otherwise 0. */
+local int gz_par_init(state)
+    gz_statep state;
+{
+    struct gz_par_s *par;
+    int n;
+
+    par = (struct gz_par_s *)malloc(sizeof(struct gz_par_s));
+    if (par != NULL) {
+#ifdef _WIN32
+        par->tid = (HANDLE *)malloc(state->threads * sizeof(HANDLE));
+#else
+        par->tid = (pthread_t *)malloc(state->threads * sizeof(pthread_t));
+#endif
+        if (par->tid == NULL) {
+            free(par);
+            par = NULL;
+        }
+    }
+    if (par == NULL) {
+        gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+    par->cur = par->head = par->tail = par->work = par->last = NULL;
+    par->free = NULL;
+    par->pending = 0;
+    par->quit = 0;
+    par->threads = 0;
+    par->dictlen = 0;
+    par->header = 0;
+    par->check = crc32(0L, Z_NULL, 0);
+    par->len = 0;
+#ifdef _WIN32
+    InitializeCriticalSection(&par->lock);
+    InitializeConditionVariable(&par->ready);
+    InitializeConditionVariable(&par->done);
+#else
+    pthread_mutex_init(&par->lock, NULL);
+    pthread_cond_init(&par->ready, NULL);
+    pthread_cond_init(&par->done, NULL);
+#endif
+    state->par = par;
+
+    /* start the threads */
+    for (n = 0; n < state->threads; n++) {
+#ifdef _WIN32
+        par->tid[n] = CreateThread(NULL, 0, gz_par_thread, par, 0, NULL);
+        if (par->tid[n] == NULL)
+            break;
+#else
+        if (pthread_create(par->tid + n, NULL, gz_par_thread, par) != 0)
+            break;
+#endif
+        par->threads++;
+    }
+    if (par->threads == 0) {
+        gz_par_free(state);
+        gz_error(state, Z_ERRNO, "could not start compression threads");
+        return -1;
+    }
+    return 0;
+}
+
+/* Compress the input at avail_in and next_in in parallel, as gz_comp() does.
+   A flush other than Z_BLOCK or Z_PARTIAL_FLUSH also waits for everything
+   before it to be written. */
+local int gz_par_comp(state, flush)
+    gz_statep state;
+    int flush;
+{
+    struct gz_par_s *par = state->par;
+    z_streamp strm = &(state->strm);
+    unsigned copy;
+
+    /* don't start a new gzip member unless there is data to write */
+    if (state->reset) {
+        if (strm->avail_in == 0)
+            return 0;
+        state->reset = 0;
+    }
+
+    /* copy the input into blocks, handing over each that is full */
+    while (strm->avail_in) {
+        if (par->cur == NULL && gz_par_submit(state, Z_NO_FLUSH) == -1)
+            break;
+        copy = state->block - par->cur->len;
+        if (copy > strm->avail_in)
+            copy = strm->avail_in;
+        memcpy(par->cur->in + par->cur->dict + par->cur->len, strm->next_in,
+               copy);
+        par->cur->len += copy;
+        strm->next_in += copy;
+        strm->avail_in -= copy;
+        if (par->cur->len == state->block) {
+            if (gz_par_submit(state, Z_SYNC_FLUSH) == -1 ||
+                gz_par_write(state, 0) == -1)
+                break;
+        }
+    }
+    if (strm->avail_in) {
+        if (state->err == Z_OK)
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+        return -1;
+    }
+
+    /* end the current block if flushing, a finished member even if empty */
+    if (flush != Z_NO_FLUSH) {
+        if ((flush == Z_FINISH || (par->cur != NULL && par->cur->len)) &&
+            gz_par_submit(state, flush) == -1) {
+            gz_error(state, Z_MEM_ERROR, "out of memory");
+            return -1;
+        }
+        if (flush == Z_FULL_FLUSH)
+            par->dictlen = 0;
+        if (flush == Z_FINISH)
+            state->reset = 1;
+    }
+    return gz_par_write(state, flush != Z_NO_FLUSH && flush != Z_BLOCK &&
+                               flush != Z_PARTIAL_FLUSH);
+}
+
+/* Stop the threads and free the parallel compression state. */
+local void gz_par_free(state)
+    gz_statep state;
+{
+    struct gz_par_s *par = state->par;
+    gz_job *job;
+    int n;
+
+    /* have the threads finish the jobs and exit */
+    PAR_LOCK(par);
+    par->quit = 1;
+    PAR_BROADCAST(par, ready);
+    PAR_UNLOCK(par);
+    for (n = 0; n < par->threads; n++) {
+#ifdef _WIN32
+        WaitForSingleObject(par->tid[n], INFINITE);
+        CloseHandle(par->tid[n]);
+#else
+        pthread_join(par->tid[n], NULL);
+#endif
+    }
+
+    /* free the jobs, any unwritten are discarded after an error */
+    if (par->cur != NULL) {
+        par->cur->next = par->free;
+        par->free = par->cur;
+    }
+    if (par->head != NULL) {
+        par->tail->next = par->free;
+        par->free = par->head;
+    }
+    while ((job = par->free) != NULL) {
+        par->free = job->next;
+        free(job->out);
+        free(job->in);
+        free(job);
+    }
+#ifdef _WIN32
+    DeleteCriticalSection(&par->lock);
+#else
+    pthread_cond_destroy(&par->done);
+    pthread_cond_destroy(&par->ready);
+    pthread_mutex_destroy(&par->lock);
+#endif
+    free(par->tid);
+    free(par);
+    state->par = NULL;
+}
+
+#endif /* GZ_THREADS */
+
 /* -- see zlib.h -- */
 int ZEXPORT gzclose_w(file)
     gzFile file;
@@ -662,8 +1197,13 @@ int ZEXPORT gzclose_w(file)
     if (gz_comp(state, Z_FINISH) == -1)
         ret = state->err;
     if (state->size) {
+#ifdef GZ_THREADS
+        if (state->par != NULL)
+            gz_par_free(state);
+        else
+#endif
         if (!state->direct) {
-            (void)deflateEnd(&(state->strm));
+            (void)deflateRelease(&(state->strm));
             free(state->out);
         }
         free(state->in);
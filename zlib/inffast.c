@@ -12,6 +12,269 @@
 #  pragma message("Assembler code may have bugs -- use at your own risk")
 #else
 
+/*
+   On 64-bit little-endian processors with unaligned loads, inflate_fast()
+   hands over to inflate_fast_wide() when there are at least WIDE_IN bytes of
+   input and WIDE_OUT bytes of output space. It differs from inflate_fast() in
+   two ways:
+
+    - The bit buffer is 64 bits and is refilled once per code, with one
+      eight-byte load: it then holds at least 56 bits, more than the 48 bits of
+      a length/distance pair. The bits of a partially used byte are loaded
+      again at the next refill, which is why they are or'ed in. There are
+      eight bytes to load while in < last.
+
+    - Matches in the output at a distance of at least eight are copied eight
+      bytes at a time, and may write up to seven bytes past the match, which
+      the next bytes overwrite. Bytes from the window are copied with memcpy.
+      There is room for that while out < end.
+
+   Define NO_INFLATE_FAST_WIDE to always use the byte-wise loop.
+ */
+#if !defined(NO_INFLATE_FAST_WIDE) && \
+    (defined(__x86_64__) || defined(_M_X64) || \
+     (defined(__aarch64__) && !defined(__AARCH64EB__)) || defined(_M_ARM64))
+#  define INFLATE_FAST_WIDE
+#  define WIDE_IN 8
+#  define WIDE_OUT (258 + 8)
+
+typedef unsigned long long z_hold64;
+
+local void inflate_fast_wide OF((z_streamp strm, unsigned start));
+
+/* copy len > 0 bytes from dist >= 1 bytes back in the output */
+local unsigned char FAR *copy_match OF((unsigned char FAR *out,
+                                        unsigned dist, unsigned len));
+local unsigned char FAR *copy_match(out, dist, len)
+unsigned char FAR *out;
+unsigned dist;
+unsigned len;
+{
+    unsigned char FAR *from = out - dist;
+    unsigned char FAR *stop = out + len;
+
+    if (dist >= 8) {
+        do {
+            zmemcpy(out, from, 8);
+            out += 8;
+            from += 8;
+        } while (out < stop);
+    }
+    else if (dist == 1)
+        memset(out, *from, len);
+    else {
+        do {
+            *out++ = *from++;
+        } while (out < stop);
+    }
+    return stop;
+}
+
+local void inflate_fast_wide(strm, start)
+z_streamp strm;
+unsigned start;         /* inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    z_const unsigned char FAR *in;      /* local strm->next_in */
+    z_const unsigned char FAR *last;    /* have enough input while in < last */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned wnext;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    z_hold64 hold;              /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code const *here;           /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+    z_hold64 next;              /* next eight input bytes */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (WIDE_IN - 1));
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (WIDE_OUT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    wnext = state->wnext;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        zmemcpy((Bytef *)&next, in, 8);
+        hold |= next << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+        here = lcode + (hold & lmask);
+      dolen:
+        op = (unsigned)(here->bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(here->op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, here->val >= 0x20 && here->val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", here->val));
+            *out++ = (unsigned char)(here->val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(here->val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            here = dcode + (hold & dmask);
+          dodist:
+            op = (unsigned)(here->bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(here->op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(here->val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        if (state->sane) {
+                            strm->msg =
+                                (char *)"invalid distance too far back";
+                            state->mode = BAD;
+                            break;
+                        }
+#ifdef INFLATE_ALLOW_INVALID_DISTANCE_TOOFAR_ARRR
+                        if (len <= op - whave) {
+                            do {
+                                *out++ = 0;
+                            } while (--len);
+                            continue;
+                        }
+                        len -= op - whave;
+                        do {
+                            *out++ = 0;
+                        } while (--op > whave);
+                        if (op == 0) {
+                            out = copy_match(out, dist, len);
+                            continue;
+                        }
+#endif
+                    }
+                    from = window;
+                    if (wnext == 0) {           /* very common case */
+                        from += wsize - op;
+                    }
+                    else if (wnext < op) {      /* wrap around window */
+                        from += wsize + wnext - op;
+                        op -= wnext;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            zmemcpy(out, from, op);
+                            out += op;
+                            from = window;
+                            op = wnext;
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += wnext - op;
+                    }
+                    if (op < len) {             /* some from window */
+                        len -= op;
+                        zmemcpy(out, from, op);
+                        out += op;
+                        out = copy_match(out, dist, len);   /* rest from output */
+                    }
+                    else {
+                        zmemcpy(out, from, len);
+                        out += len;
+                    }
+                }
+                else                            /* copy direct from output */
+                    out = copy_match(out, dist, len);
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                here = dcode + here->val + (hold & ((1U << op) - 1));
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            here = lcode + here->val + (hold & ((1U << op) - 1));
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes, and clear the bits of them left in hold */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= ((z_hold64)1 << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ? (WIDE_IN - 1) + (last - in) :
+                                            (WIDE_IN - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+                                 (WIDE_OUT - 1) + (end - out) :
+                                 (WIDE_OUT - 1) - (out - end));
+    state->hold = (unsigned long)hold;
+    state->bits = bits;
+    return;
+}
+#endif /* INFLATE_FAST_WIDE */
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -77,6 +340,13 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     unsigned dist;              /* match distance */
     unsigned char FAR *from;    /* where to copy match from */
 
+#ifdef INFLATE_FAST_WIDE
+    if (strm->avail_in >= WIDE_IN && strm->avail_out >= WIDE_OUT) {
+        inflate_fast_wide(strm, start);
+        return;
+    }
+#endif
+
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
     in = strm->next_in;
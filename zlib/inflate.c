@@ -223,16 +223,27 @@ int stream_size;
 #else
         strm->zfree = zcfree;
 #endif
-    state = (struct inflate_state FAR *)
-            ZALLOC(strm, 1, sizeof(struct inflate_state));
-    if (state == Z_NULL) return Z_MEM_ERROR;
-    Tracev((stderr, "inflate: allocated\n"));
+#ifdef ZPOOL
+    /* reuse a released state, keeping its window if the size is the same */
+    if (strm->zalloc == zcalloc && strm->zfree == zcfree &&
+        (state = (struct inflate_state FAR *)zpool_take(ZPOOL_INFLATE))
+            != Z_NULL)
+        Tracev((stderr, "inflate: reused\n"));
+    else
+#endif
+    {
+        state = (struct inflate_state FAR *)
+                ZALLOC(strm, 1, sizeof(struct inflate_state));
+        if (state == Z_NULL) return Z_MEM_ERROR;
+        Tracev((stderr, "inflate: allocated\n"));
+        state->window = Z_NULL;
+    }
     strm->state = (struct internal_state FAR *)state;
     state->strm = strm;
-    state->window = Z_NULL;
     state->mode = HEAD;     /* to pass state test in inflateReset2() */
     ret = inflateReset2(strm, windowBits);
     if (ret != Z_OK) {
+        if (state->window != Z_NULL) ZFREE(strm, state->window);
         ZFREE(strm, state);
         strm->state = Z_NULL;
     }
@@ -1315,6 +1326,34 @@ z_streamp strm;
     return Z_OK;
 }
 
+#ifdef ZPOOL
+/* Free a pooled state that was allocated with zcalloc(). */
+local void inflate_pool_free(state)
+    voidpf state;
+{
+    struct inflate_state FAR *s = (struct inflate_state FAR *)state;
+
+    if (s->window != Z_NULL) zcfree(Z_NULL, s->window);
+    zcfree(Z_NULL, s);
+}
+#endif
+
+int ZEXPORT inflateRelease(strm)
+z_streamp strm;
+{
+#ifdef ZPOOL
+    if (inflateStateCheck(strm))
+        return Z_STREAM_ERROR;
+    if (strm->zalloc == zcalloc && strm->zfree == zcfree &&
+        zpool_put(ZPOOL_INFLATE, strm->state, inflate_pool_free) == 0) {
+        strm->state = Z_NULL;
+        Tracev((stderr, "inflate: released\n"));
+        return Z_OK;
+    }
+#endif
+    return inflateEnd(strm);
+}
+
 int ZEXPORT inflateGetDictionary(strm, dictionary, dictLength)
 z_streamp strm;
 Bytef *dictionary;
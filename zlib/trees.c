@@ -149,6 +149,7 @@ local void send_all_trees OF((deflate_state *s, int lcodes, int dcodes,
 local void compress_block OF((deflate_state *s, const ct_data *ltree,
                               const ct_data *dtree));
 local int  detect_data_type OF((deflate_state *s));
+local ulg  static_bits    OF((deflate_state *s));
 local unsigned bi_reverse OF((unsigned code, int len));
 local void bi_windup      OF((deflate_state *s));
 local void bi_flush       OF((deflate_state *s));
@@ -918,8 +919,18 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
     ulg opt_lenb, static_lenb; /* opt_len and static_len in bytes */
     int max_blindex = 0;  /* index of last bit length code of non zero freq */
 
+    /* For Z_QUICK, only consider the fixed codes, see deflate_quick() */
+    if (s->level > 0 && s->strategy == Z_QUICK) {
+        if (s->strm->data_type == Z_UNKNOWN)
+            s->strm->data_type = detect_data_type(s);
+        s->static_len = static_bits(s);
+        opt_lenb = static_lenb = (s->static_len + 3 + 7) >> 3;
+        Tracev((stderr, "\nquick stat %lu(%lu) stored %lu lit %u ",
+                static_lenb, s->static_len, stored_len, s->sym_next / 3));
+    }
+
     /* Build the Huffman trees unless a stored block is forced */
-    if (s->level > 0) {
+    else if (s->level > 0) {
 
         /* Check if the file is binary or text */
         if (s->strm->data_type == Z_UNKNOWN)
@@ -1007,6 +1018,26 @@ void ZLIB_INTERNAL _tr_flush_block(s, buf, stored_len, last)
            s->compressed_len - 7*last));
 }
 
+/* ===========================================================================
+ * Return the length in bits of the current block with the fixed codes,
+ * without the block header, from the symbol frequencies.
+ */
+local ulg static_bits(s)
+    deflate_state *s;
+{
+    ulg bits = 0;
+    int n;
+
+    for (n = 0; n < L_CODES; n++)
+        bits += (ulg)s->dyn_ltree[n].Freq * static_ltree[n].Len;
+    for (n = 0; n < LENGTH_CODES; n++)
+        bits += (ulg)s->dyn_ltree[LITERALS + 1 + n].Freq * extra_lbits[n];
+    for (n = 0; n < D_CODES; n++)
+        bits += (ulg)s->dyn_dtree[n].Freq *
+                (static_dtree[n].Len + extra_dbits[n]);
+    return bits;
+}
+
 /* ===========================================================================
  * Save the match info and tally the frequency counts. Return true if
  * the current block must be flushed.
@@ -0,0 +1,201 @@
+/* zdict.c -- train a preset dictionary on a set of sample inputs
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* zlibTrainDictionary() picks the segments of the samples with the most
+   content in common with other samples, in the manner of the COVER algorithm
+   of Liao, Petri, Moffat and Wirth, "Effective Construction of Relative
+   Lempel-Ziv Dictionaries". The content of a segment is measured by the
+   distinct k-mers (strings of KMER bytes) in it, each scored by the number of
+   samples it appears in. The samples are split into epochs, one segment is
+   taken from each epoch, and the k-mers of a segment taken stop counting, so
+   that later segments add new strings. The segments are then written with the
+   best ones last, nearest to the data, where their matches are cheapest. */
+
+#include "zutil.h"
+
+#define KMER 8              /* bytes in a k-mer, the unit of content */
+#define SEGMENT 128         /* bytes in a segment of the dictionary */
+#define HBITS 18            /* bits of a k-mer hash */
+#define HSIZE (1U << HBITS) /* k-mer hash table size */
+#define NONE HSIZE          /* hash of a k-mer that spans two samples */
+#define PASSES 4            /* passes over the epochs to fill the dictionary */
+
+typedef struct {
+    uLong pos;              /* offset of the segment in the corpus */
+    uLong score;            /* sum of the k-mer scores of the segment */
+} segment;
+
+/* Return the hash of the KMER bytes at buf. */
+local unsigned kmer_hash OF((const Bytef *));
+local unsigned kmer_hash(buf)
+    const Bytef *buf;
+{
+    unsigned long h = 0;
+    int n;
+
+    for (n = 0; n < KMER; n++)
+        h = ((h + buf[n]) * 2654435761UL) & 0xffffffffUL;
+    return (unsigned)(h >> (32 - HBITS));
+}
+
+/* Sort the segments in list by ascending score, insertion sort being enough
+   for the few hundred segments of a dictionary. */
+local void sort_segments OF((segment *, unsigned));
+local void sort_segments(list, n)
+    segment *list;
+    unsigned n;
+{
+    unsigned i, j;
+    segment s;
+
+    for (i = 1; i < n; i++) {
+        s = list[i];
+        for (j = i; j > 0 && list[j - 1].score > s.score; j--)
+            list[j] = list[j - 1];
+        list[j] = s;
+    }
+}
+
+/* ========================================================================= */
+int ZEXPORT zlibTrainDictionary(dict, dictLen, samples, sampleLens, count)
+    Bytef *dict;
+    uInt *dictLen;
+    const Bytef * const *samples;
+    const uLong *sampleLens;
+    unsigned count;
+{
+    Bytef *corpus;
+    unsigned *hash, *score, *seen;
+    segment *list;
+    uLong total, pos, epoch, start, end, sum, have, left;
+    unsigned max, got, n, h, pass, picked;
+    segment best;
+
+    if (dict == Z_NULL || dictLen == Z_NULL || samples == Z_NULL ||
+        sampleLens == Z_NULL || count == 0)
+        return Z_STREAM_ERROR;
+
+    /* get the size of the corpus, and the most segments that fit */
+    total = 0;
+    for (n = 0; n < count; n++) {
+        if (samples[n] == Z_NULL && sampleLens[n] != 0)
+            return Z_STREAM_ERROR;
+        if (total + sampleLens[n] < total)
+            return Z_MEM_ERROR;
+        total += sampleLens[n];
+    }
+    max = (*dictLen < 32768U ? *dictLen : 32768U) / SEGMENT;
+    *dictLen = 0;
+    if (max == 0 || total < SEGMENT)
+        return Z_OK;
+    if (total > (uLong)(((size_t)0 - 1) / sizeof(unsigned)))
+        return Z_MEM_ERROR;
+
+    /* join the samples, and hash the k-mers of each position */
+    corpus = (Bytef *)malloc((size_t)total);
+    hash = (unsigned *)malloc((size_t)total * sizeof(unsigned));
+    score = (unsigned *)malloc((HSIZE + 1) * sizeof(unsigned));
+    seen = (unsigned *)malloc((HSIZE + 1) * sizeof(unsigned));
+    list = (segment *)malloc(max * sizeof(segment));
+    if (corpus == NULL || hash == NULL || score == NULL || seen == NULL ||
+        list == NULL) {
+        free(list);
+        free(seen);
+        free(score);
+        free(hash);
+        free(corpus);
+        return Z_MEM_ERROR;
+    }
+    zmemzero((Bytef *)score, (HSIZE + 1) * sizeof(unsigned));
+    zmemzero((Bytef *)seen, (HSIZE + 1) * sizeof(unsigned));
+    pos = 0;
+    for (n = 0; n < count; n++) {
+        end = pos + sampleLens[n];
+        if (sampleLens[n])
+            zmemcpy(corpus + pos, samples[n], (uInt)sampleLens[n]);
+        for (; pos < end; pos++) {
+            if (end - pos < KMER) {
+                hash[pos] = NONE;
+                continue;
+            }
+            h = kmer_hash(corpus + pos);
+            hash[pos] = h;
+
+            /* score a k-mer by the number of samples it appears in */
+            if (seen[h] != n + 1) {
+                seen[h] = n + 1;
+                score[h]++;
+            }
+        }
+    }
+
+    /* strings in only one sample do not help compress the others */
+    for (h = 0; h < HSIZE; h++) {
+        if (score[h] < 2)
+            score[h] = 0;
+        seen[h] = 0;
+    }
+    score[NONE] = 0;
+
+    /* take the best segment of each epoch, seen[] now counting the k-mers in
+       the window of the segment being scored so that each is counted once */
+    got = 0;
+    for (pass = 0; pass < PASSES && got < max; pass++) {
+        epoch = total / (max - got);
+        if (epoch < SEGMENT)
+            epoch = SEGMENT;
+        picked = 0;
+        for (start = 0; start + SEGMENT <= total && got < max;
+             start += epoch) {
+            end = start + epoch < total ? start + epoch : total;
+            best.pos = 0;
+            best.score = 0;
+            sum = 0;
+            for (pos = start; pos < end; pos++) {
+                h = hash[pos];
+                if (seen[h]++ == 0)
+                    sum += score[h];
+                if (pos - start >= SEGMENT - KMER + 1) {
+                    h = hash[pos - (SEGMENT - KMER + 1)];
+                    if (--seen[h] == 0)
+                        sum -= score[h];
+                }
+                if (sum > best.score && pos - start >= SEGMENT - KMER) {
+                    best.pos = pos + KMER - SEGMENT;
+                    best.score = sum;
+                }
+            }
+            left = end - start < SEGMENT - KMER + 1 ? end - start :
+                   SEGMENT - KMER + 1;
+            for (pos = end - left; pos < end; pos++)
+                seen[hash[pos]] = 0;
+            if (best.score == 0)
+                continue;
+
+            /* the strings of the segment taken no longer add content */
+            for (pos = best.pos; pos < best.pos + SEGMENT - KMER + 1; pos++)
+                score[hash[pos]] = 0;
+            list[got++] = best;
+            picked++;
+        }
+        if (picked == 0)
+            break;
+    }
+
+    /* write the segments with the best last */
+    sort_segments(list, got);
+    have = 0;
+    for (n = 0; n < got; n++) {
+        zmemcpy(dict + have, corpus + list[n].pos, SEGMENT);
+        have += SEGMENT;
+    }
+    *dictLen = (uInt)have;
+
+    free(list);
+    free(seen);
+    free(score);
+    free(hash);
+    free(corpus);
+    return Z_OK;
+}
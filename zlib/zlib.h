@@ -197,6 +197,7 @@ typedef gz_header FAR *gz_headerp;
 #define Z_HUFFMAN_ONLY        2
 #define Z_RLE                 3
 #define Z_FIXED               4
+#define Z_QUICK               5
 #define Z_DEFAULT_STRATEGY    0
 /* compression strategy; see deflateInit2() below for details */
 
@@ -597,7 +598,12 @@ ZEXTERN int ZEXPORT deflateInit2 OF((z_streamp strm,
    strategy parameter only affects the compression ratio but not the
    correctness of the compressed output even if it is not set appropriately.
    Z_FIXED prevents the use of dynamic Huffman codes, allowing for a simpler
-   decoder for special applications.
+   decoder for special applications.  Z_QUICK is faster than level 1, at some
+   cost in compression: it takes the most recent match candidate without
+   comparing it to others or to the match at the next byte, and uses fixed
+   Huffman codes.  It suits data that is compressed for speed rather than
+   size, such as temporary files and caches, and does the same at any level
+   other than zero.
 
      deflateInit2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
    memory, Z_STREAM_ERROR if any parameter is invalid (such as an invalid
@@ -702,6 +708,21 @@ ZEXTERN int ZEXPORT deflateReset OF((z_streamp strm));
    stream state was inconsistent (such as zalloc or state being Z_NULL).
 */
 
+ZEXTERN int ZEXPORT deflateRelease OF((z_streamp strm));
+/*
+     This function is the same as deflateEnd, except that the internal
+   compression state and its buffers are kept in a pool instead of being
+   freed, when the stream uses the default zalloc and zfree.  A later
+   deflateInit2() with the same windowBits and memLevel (the wrapper and level
+   may differ) takes the state from the pool, avoiding the allocation of the
+   window, hash, and pending buffers.  This saves time when many small streams
+   are compressed one after another, as for the entries of a zip file.  The
+   pool is shared by all threads, holds a small number of states, and falls
+   back to deflateEnd when full.  zlibPoolFree() frees the pooled states.
+
+     deflateRelease returns the same values as deflateEnd.
+*/
+
 ZEXTERN int ZEXPORT deflateParams OF((z_streamp strm,
                                       int level,
                                       int strategy));
@@ -980,6 +1001,16 @@ ZEXTERN int ZEXPORT inflateReset2 OF((z_streamp strm,
    the windowBits parameter is invalid.
 */
 
+ZEXTERN int ZEXPORT inflateRelease OF((z_streamp strm));
+/*
+     This function is the same as inflateEnd, except that the internal
+   decompression state and its window are kept in a pool for a later
+   inflateInit2(), when the stream uses the default zalloc and zfree.  See
+   deflateRelease() for the pool.
+
+     inflateRelease returns the same values as inflateEnd.
+*/
+
 ZEXTERN int ZEXPORT inflatePrime OF((z_streamp strm,
                                      int bits,
                                      int value));
@@ -1173,6 +1204,15 @@ ZEXTERN int ZEXPORT inflateBackEnd OF((z_streamp strm));
    state was inconsistent.
 */
 
+ZEXTERN void ZEXPORT zlibPoolFree OF((void));
+/*
+     Free all of the states kept by deflateRelease() and inflateRelease().  This
+   can be called at any time, for example at the end of a batch of streams or
+   before the application exits, and is safe to call while other threads use
+   zlib.  Without thread support in the build, the Release functions do not
+   pool and zlibPoolFree() does nothing.
+*/
+
 ZEXTERN uLong ZEXPORT zlibCompileFlags OF((void));
 /* Return flags indicating compile-time options.
 
@@ -1290,6 +1330,34 @@ ZEXTERN int ZEXPORT uncompress2 OF((Bytef *dest,   uLongf *destLen,
    source bytes consumed.
 */
 
+ZEXTERN int ZEXPORT zlibTrainDictionary OF((Bytef *dict, uInt *dictLen,
+                                            const Bytef * const *samples,
+                                            const uLong *sampleLens,
+                                            unsigned count));
+/*
+     Builds a preset dictionary for deflateSetDictionary() and
+   inflateSetDictionary() from count sample inputs, samples[i] being
+   sampleLens[i] bytes long.  This is for compressing many small inputs that
+   are alike, such as the XML files of a model archive, which have little to
+   match within themselves.  The samples should be typical of the data to be
+   compressed, and should total at least some ten times the dictionary size.
+   Upon entry, dictLen is the size of the dict buffer.  Upon exit, dictLen is
+   the length of the dictionary, which is at most 32768 and may be less than
+   the buffer, or even zero, when the samples have little in common.  Strings
+   that appear in only one sample are not used.  As deflate uses at most the
+   window size minus 262 bytes of a dictionary, a buffer of 32506 bytes gets
+   the most out of the default window.
+
+     The dictionary is made of segments of the samples, with the strings that
+   appear in the most samples at its end.  The same dictionary must be given
+   to inflateSetDictionary(), so it has to be stored or shipped with the
+   compressed data, and its Adler-32 value, which deflate writes in the zlib
+   header, identifies it.
+
+     zlibTrainDictionary returns Z_OK if success, Z_MEM_ERROR if there was not
+   enough memory, or Z_STREAM_ERROR if a parameter is invalid.
+*/
+
                         /* gzip file access functions */
 
 /*
@@ -1308,10 +1376,11 @@ ZEXTERN gzFile ZEXPORT gzopen OF((const char *path, const char *mode));
    compressing and writing.  The mode parameter is as in fopen ("rb" or "wb")
    but can also include a compression level ("wb9") or a strategy: 'f' for
    filtered data as in "wb6f", 'h' for Huffman-only compression as in "wb1h",
-   'R' for run-length encoding as in "wb1R", or 'F' for fixed code compression
-   as in "wb9F".  (See the description of deflateInit2 for more information
-   about the strategy parameter.)  'T' will request transparent writing or
-   appending with no compression and not using the gzip format.
+   'R' for run-length encoding as in "wb1R", 'F' for fixed code compression
+   as in "wb9F", or 'Q' for quick compression as in "wbQ".  (See the
+   description of deflateInit2 for more information about the strategy
+   parameter.)  'T' will request transparent writing or appending with no
+   compression and not using the gzip format.
 
      "a" can be used instead of "w" to request that the gzip stream that will
    be written be appended to the file.  "+" will result in an error, since
@@ -1389,6 +1458,87 @@ ZEXTERN int ZEXPORT gzsetparams OF((gzFile file, int level, int strategy));
    or Z_MEM_ERROR if there is a memory allocation error.
 */
 
+ZEXTERN int ZEXPORT gzthreads OF((gzFile file, int threads, unsigned block));
+/*
+     Compress the data written to file in threads background threads, instead
+   of in the calling thread.  The input is cut into blocks of block bytes
+   (128K if block is zero, at least 32K) that are compressed independently,
+   each primed with the 32K of input before it, and written in order as one
+   standard gzip stream.  The output is a little larger than, and not the same
+   as, what a single thread produces.  threads zero is the default of
+   compressing in the calling thread.  This function must be called after
+   gzopen() or gzdopen() for writing, and before any other calls that write
+   the file.
+
+     gzwrite() and the other write functions return once the input is copied,
+   unless 2 * threads blocks are already waiting to be written, so errors may
+   only be reported by a later call.  gzflush() with Z_SYNC_FLUSH, Z_FULL_FLUSH
+   or Z_FINISH, and gzclose(), wait for all of the data to be written.
+
+     For a file opened for reading, any non-zero threads has the file read and
+   decompressed by one background thread, which keeps up to four buffers of
+   block bytes of output ahead of the calling thread, so that decompressing
+   overlaps with the use of the data.  The input buffer is then at least half
+   of block, or the size set with gzbuffer().  This function must be called
+   before the first read, and gzsetindex() too if used.  Seeking backwards, or
+   with gzsetindex(), restarts the thread at the new position, dropping the data
+   decompressed ahead.  gzoffset() tells how far the thread has read.  Errors
+   are reported when the data before them has been read.
+
+     gzthreads() returns 0 on success, or -1 on failure, such as being called
+   too late, or if zlib was built without thread support.
+*/
+
+typedef struct gz_index_s FAR *gzIndex;   /* access points of a gzip file */
+
+ZEXTERN int ZEXPORT gzbuildindex OF((const char *path, z_off_t span,
+                                     gzIndex *index));
+/*
+     Read the gzip file path once and build an index of access points to its
+   uncompressed data, about every span bytes, for fast seeking with
+   gzsetindex().  Each access point takes the preceding 32K of uncompressed
+   data, deflated, in memory, so span should balance seek speed against the
+   size of the index -- a span of some megabytes suits large files.  gzip files
+   with several members are indexed in their entirety.  The file is checked
+   while reading it.
+
+     gzbuildindex() returns the number of access points (at least one) and sets
+   *index on success, or Z_MEM_ERROR if out of memory, Z_DATA_ERROR if the file
+   is not a valid gzip file, Z_ERRNO on a file error, or Z_STREAM_ERROR for
+   invalid parameters.
+*/
+
+ZEXTERN int ZEXPORT gzsaveindex OF((gzIndex index, const char *path));
+ZEXTERN int ZEXPORT gzloadindex OF((const char *path, gzIndex *index));
+/*
+     Write index to the index file path, or read one from path into *index,
+   so that the index need not be built again for later opens.  An index file is
+   conventionally kept next to the gzip file, with ".gzi" appended to its name.
+   The index file holds the length of the gzip file, which gzsetindex() checks.
+
+     gzsaveindex() returns Z_OK on success or Z_ERRNO on a file error.
+   gzloadindex() returns the number of access points and sets *index on
+   success, or Z_ERRNO on a file error, Z_DATA_ERROR if path is not a valid
+   index file, or Z_MEM_ERROR if out of memory.
+*/
+
+ZEXTERN int ZEXPORT gzsetindex OF((gzFile file, gzIndex index));
+/*
+     Use index for seeking in file, opened for reading.  gzseek() then starts
+   decompressing at the last access point before the requested offset, when it
+   is before the current position or after it, instead of from the start of
+   the file or the current position.  index must stay allocated until file is
+   closed or gzsetindex() is called with NULL to stop using it.
+
+     gzsetindex() returns 0 on success, or -1 if file is not open for reading
+   or its length is not the one the index was built for.
+*/
+
+ZEXTERN void ZEXPORT gzfreeindex OF((gzIndex index));
+/*
+     Free index, built by gzbuildindex() or read by gzloadindex().
+*/
+
 ZEXTERN int ZEXPORT gzread OF((gzFile file, voidp buf, unsigned len));
 /*
      Read and decompress up to len uncompressed bytes from file into buf.  If
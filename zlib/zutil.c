@@ -9,6 +9,20 @@
 #ifndef Z_SOLO
 #  include "gzguts.h"
 #endif
+#ifdef X86_SIMD
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+#ifdef ZPOOL
+#  ifdef _WIN32
+#    include <windows.h>
+#  else
+#    include <pthread.h>
+#  endif
+#endif
 
 z_const char * const z_errmsg[10] = {
     (z_const char *)"need dictionary",     /* Z_NEED_DICT       2  */
@@ -325,3 +339,156 @@ void ZLIB_INTERNAL zcfree(opaque, ptr)
 #endif /* MY_ZCALLOC */
 
 #endif /* !Z_SOLO */
+
+#ifdef ZPOOL
+
+#ifdef _WIN32
+local SRWLOCK zpool_lock = SRWLOCK_INIT;
+#  define ZPOOL_LOCK() AcquireSRWLockExclusive(&zpool_lock)
+#  define ZPOOL_UNLOCK() ReleaseSRWLockExclusive(&zpool_lock)
+#else
+local pthread_mutex_t zpool_lock = PTHREAD_MUTEX_INITIALIZER;
+#  define ZPOOL_LOCK() pthread_mutex_lock(&zpool_lock)
+#  define ZPOOL_UNLOCK() pthread_mutex_unlock(&zpool_lock)
+#endif
+
+/* released states, the most recent last */
+local struct {
+    unsigned key;               /* kind and parameters of the state */
+    voidpf state;               /* the state with its buffers */
+    void (*release) OF((voidpf));   /* frees the state and its buffers */
+} zpool[ZPOOL_MAX];
+local int zpool_have = 0;
+
+/* Return a released state with the given key, or Z_NULL if there is none. */
+voidpf ZLIB_INTERNAL zpool_take(key)
+    unsigned key;
+{
+    int n;
+    voidpf state = Z_NULL;
+
+    ZPOOL_LOCK();
+    for (n = zpool_have - 1; n >= 0; n--)
+        if (zpool[n].key == key) {
+            state = zpool[n].state;
+            zpool[n] = zpool[--zpool_have];
+            break;
+        }
+    ZPOOL_UNLOCK();
+    return state;
+}
+
+/* Keep state for a later zpool_take() of key. Return 0 on success, or -1 if
+   the pool is full, in which case the caller still owns state. */
+int ZLIB_INTERNAL zpool_put(key, state, release)
+    unsigned key;
+    voidpf state;
+    void (*release) OF((voidpf));
+{
+    int ret = -1;
+
+    ZPOOL_LOCK();
+    if (zpool_have < ZPOOL_MAX) {
+        zpool[zpool_have].key = key;
+        zpool[zpool_have].state = state;
+        zpool[zpool_have].release = release;
+        zpool_have++;
+        ret = 0;
+    }
+    ZPOOL_UNLOCK();
+    return ret;
+}
+
+#endif /* ZPOOL */
+
+/* ========================================================================= */
+void ZEXPORT zlibPoolFree()
+{
+#ifdef ZPOOL
+    voidpf state;
+    void (*release) OF((voidpf));
+
+    ZPOOL_LOCK();
+    while (zpool_have) {
+        zpool_have--;
+        state = zpool[zpool_have].state;
+        release = zpool[zpool_have].release;
+        ZPOOL_UNLOCK();
+        release(state);
+        ZPOOL_LOCK();
+    }
+    ZPOOL_UNLOCK();
+#endif
+}
+
+#ifdef X86_SIMD
+
+local void x86_cpuid OF((unsigned leaf, unsigned subleaf, unsigned regs[4]));
+local void x86_cpuid(leaf, subleaf, regs)
+    unsigned leaf;
+    unsigned subleaf;
+    unsigned regs[4];
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    regs[0] = (unsigned)info[0];
+    regs[1] = (unsigned)info[1];
+    regs[2] = (unsigned)info[2];
+    regs[3] = (unsigned)info[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/* the ymm registers must also be saved by the operating system for AVX2 */
+local int x86_os_saves_ymm OF((void));
+local int x86_os_saves_ymm()
+{
+#ifdef _MSC_VER
+    return (_xgetbv(0) & 6) == 6;
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    (void)edx;
+    return (eax & 6) == 6;
+#endif
+}
+
+/* -1 until the features are known. Threads may find them at the same time,
+   they find the same value. */
+local int volatile x86_features = -1;
+
+int ZLIB_INTERNAL x86_cpu_features()
+{
+    unsigned regs[4];
+    unsigned max_leaf;
+    int features;
+
+    if (x86_features != -1)
+        return x86_features;
+
+    features = 0;
+    x86_cpuid(0, 0, regs);
+    max_leaf = regs[0];
+    if (max_leaf >= 1) {
+        x86_cpuid(1, 0, regs);
+        if (regs[2] & (1U << 9))
+            features |= Z_X86_SSSE3;
+        if (regs[2] & (1U << 20))
+            features |= Z_X86_SSE42;
+        if (regs[2] & (1U << 1))
+            features |= Z_X86_PCLMUL;
+        /* osxsave and avx, then avx2 in leaf 7 */
+        if ((regs[2] & (1U << 27)) && (regs[2] & (1U << 28)) &&
+            max_leaf >= 7 && x86_os_saves_ymm()) {
+            x86_cpuid(7, 0, regs);
+            if (regs[1] & (1U << 5))
+                features |= Z_X86_AVX2;
+        }
+    }
+    x86_features = features;
+    return features;
+}
+
+#endif /* X86_SIMD */
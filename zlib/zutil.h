@@ -268,6 +268,41 @@ extern z_const char * const z_errmsg[10]; /* indexed by 2-zlib_error */
 #define ZFREE(strm, addr)  (*((strm)->zfree))((strm)->opaque, (voidpf)(addr))
 #define TRY_FREE(s, p) {if (p) ZFREE(s, p);}
 
+/* x86 SIMD checksums, chosen at run time from the processor features. Define
+   NO_X86_SIMD to build without them. */
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+     defined(_M_IX86)) && !defined(NO_X86_SIMD) && \
+    ((defined(__GNUC__) && __GNUC__ >= 5) || defined(__clang__) || \
+     (defined(_MSC_VER) && _MSC_VER >= 1900))
+#  define X86_SIMD
+#  if defined(__GNUC__) || defined(__clang__)
+#    define Z_TARGET(x) __attribute__((target(x)))
+#  else
+#    define Z_TARGET(x)
+#  endif
+#  define Z_X86_SSSE3   1
+#  define Z_X86_SSE42   2
+#  define Z_X86_PCLMUL  4
+#  define Z_X86_AVX2    8
+   int ZLIB_INTERNAL x86_cpu_features OF((void));
+#endif
+
+/* Pool of released deflate and inflate states for reuse by later
+   initializations, see deflateRelease() and inflateRelease(). Only states
+   from the default allocators are pooled. Define NO_ZPOOL to build without
+   it, which makes the Release functions the same as the End functions. */
+#if !defined(NO_ZPOOL) && !defined(Z_SOLO) && \
+    (defined(_WIN32) || defined(HAVE_PTHREAD))
+#  define ZPOOL
+#  define ZPOOL_MAX 16          /* most states kept, of any kind */
+#  define ZPOOL_INFLATE 0x10000U
+#  define ZPOOL_DEFLATE(wbits, memlevel) \
+      (0x20000U | ((unsigned)(wbits) << 8) | (unsigned)(memlevel))
+   voidpf ZLIB_INTERNAL zpool_take OF((unsigned key));
+   int ZLIB_INTERNAL zpool_put OF((unsigned key, voidpf state,
+                                   void (*release)(voidpf)));
+#endif
+
 /* Reverse the bytes in a 32-bit value */
 #define ZSWAP32(q) ((((q) >> 24) & 0xff) + (((q) >> 8) & 0xff00) + \
                     (((q) & 0xff00) << 8) + (((q) & 0xff) << 24))